@@ -80,16 +80,24 @@ void Clock::WakeupWithDeadline(absl::Time deadline,
   // their order within the bucket is preserved.
   {
     absl::MutexLock lock(mutex());
-    WaiterMap::iterator it;
-    if ((it = pending_waiters_.find(deadline)) != pending_waiters_.end()) {
-      it->second.push_back(waiter);
-    } else {
-      pending_waiters_.insert(std::make_pair(deadline, WaiterList{waiter}));
+    // The new waiter only needs a new wake-up if it becomes the soonest one.
+    bool is_soonest = pending_waiters_.empty() ||
+                      deadline < pending_waiters_.begin()->first;
+    pending_waiters_[deadline].push_back(waiter);
+
+    // Most waiters are scheduled in the future, and a dispatch loop is only
+    // needed for those that are already due. Otherwise the wake-up is either
+    // already scheduled for a sooner waiter, or scheduled right here, or
+    // scheduled at the end of an ongoing dispatch loop.
+    if (deadline > NowLocked()) {
+      if (is_soonest && dispatch_level_ == 0) {
+        ScheduleWakeup(deadline);
+      }
+      return;
     }
   }
 
-  // Inserting a new waiter may trigger an immediate wake-up if the deadline
-  // is due. Otherwise a new wake-up is scheduled at the end on the dispatch.
+  // The deadline is due, which triggers an immediate wake-up.
   DispatchWakeups();
 }
 
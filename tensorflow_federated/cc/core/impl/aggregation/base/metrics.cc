@@ -0,0 +1,209 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+std::atomic<bool> metrics_enabled = false;
+
+// Escapes a label value as required by the Prometheus text format.
+std::string EscapeLabelValue(absl::string_view value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    switch (c) {
+      case '\\':
+        escaped.append("\\\\");
+        break;
+      case '"':
+        escaped.append("\\\"");
+        break;
+      case '\n':
+        escaped.append("\\n");
+        break;
+      default:
+        escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+}  // namespace
+
+bool MetricsEnabled() {
+  return metrics_enabled.load(std::memory_order_relaxed);
+}
+
+void SetMetricsEnabled(bool enabled) {
+  metrics_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Record(absl::Duration latency) {
+  int64_t nanos = std::max<int64_t>(absl::ToInt64Nanoseconds(latency), 0);
+  // Bucket i holds latencies in (2^(i-1), 2^i] microseconds.
+  int bucket = nanos == 0 ? 0
+                          : absl::bit_width(static_cast<uint64_t>(nanos - 1) /
+                                            1000);
+  buckets_[std::min(bucket, kNumBuckets - 1)].fetch_add(
+      1, std::memory_order_relaxed);
+  sum_nanos_.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+std::array<int64_t, LatencyHistogram::kNumBuckets>
+LatencyHistogram::bucket_counts() const {
+  std::array<int64_t, kNumBuckets> counts;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+int64_t LatencyHistogram::count() const {
+  int64_t count = 0;
+  for (const auto& bucket : buckets_) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+absl::Duration LatencyHistogram::sum() const {
+  return absl::Nanoseconds(sum_nanos_.load(std::memory_order_relaxed));
+}
+
+absl::Duration LatencyHistogram::BucketUpperBound(int i) {
+  if (i >= kNumBuckets - 1) {
+    return absl::InfiniteDuration();
+  }
+  return absl::Microseconds(int64_t{1} << i);
+}
+
+MetricsRegistry& MetricsRegistry::Default() {
+  static MetricsRegistry* registry = new MetricsRegistry();
+  return *registry;
+}
+
+LatencyHistogram* MetricsRegistry::GetLatencyHistogram(absl::string_view name) {
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = histograms_.find(name);
+    if (it != histograms_.end()) {
+      return it->second.get();
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  auto& histogram = histograms_[std::string(name)];
+  if (histogram == nullptr) {
+    histogram = std::make_unique<LatencyHistogram>();
+  }
+  return histogram.get();
+}
+
+Counter* MetricsRegistry::GetCounter(absl::string_view name) {
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = counters_.find(name);
+    if (it != counters_.end()) {
+      return it->second.get();
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  auto& counter = counters_[std::string(name)];
+  if (counter == nullptr) {
+    counter = std::make_unique<Counter>();
+  }
+  return counter.get();
+}
+
+Gauge* MetricsRegistry::GetGauge(absl::string_view name) {
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = gauges_.find(name);
+    if (it != gauges_.end()) {
+      return it->second.get();
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  auto& gauge = gauges_[std::string(name)];
+  if (gauge == nullptr) {
+    gauge = std::make_unique<Gauge>();
+  }
+  return gauge.get();
+}
+
+std::string MetricsRegistry::ExportPrometheusText() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  std::string text;
+  if (!histograms_.empty()) {
+    absl::StrAppend(&text, "# TYPE tff_latency_seconds histogram\n");
+  }
+  for (const auto& [name, histogram] : histograms_) {
+    std::string label = EscapeLabelValue(name);
+    // Prometheus buckets are cumulative, and the +Inf bucket is the count.
+    // The count is derived from the buckets so that it is consistent with
+    // them even while latencies are being recorded.
+    std::array<int64_t, LatencyHistogram::kNumBuckets> counts =
+        histogram->bucket_counts();
+    int64_t cumulative = 0;
+    for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+      cumulative += counts[i];
+      absl::Duration bound = LatencyHistogram::BucketUpperBound(i);
+      std::string le =
+          bound == absl::InfiniteDuration()
+              ? "+Inf"
+              : absl::StrFormat("%g", absl::ToDoubleSeconds(bound));
+      absl::StrAppend(&text, "tff_latency_seconds_bucket{name=\"", label,
+                      "\",le=\"", le, "\"} ", cumulative, "\n");
+    }
+    absl::StrAppendFormat(&text, "tff_latency_seconds_sum{name=\"%s\"} %.9g\n",
+                          label, absl::ToDoubleSeconds(histogram->sum()));
+    absl::StrAppend(&text, "tff_latency_seconds_count{name=\"", label, "\"} ",
+                    cumulative, "\n");
+  }
+  if (!counters_.empty()) {
+    absl::StrAppend(&text, "# TYPE tff_counter_total counter\n");
+  }
+  for (const auto& [name, counter] : counters_) {
+    absl::StrAppend(&text, "tff_counter_total{name=\"", EscapeLabelValue(name),
+                    "\"} ", counter->value(), "\n");
+  }
+  if (!gauges_.empty()) {
+    absl::StrAppend(&text, "# TYPE tff_gauge gauge\n");
+  }
+  for (const auto& [name, gauge] : gauges_) {
+    absl::StrAppend(&text, "tff_gauge{name=\"", EscapeLabelValue(name), "\"} ",
+                    gauge->value(), "\n");
+  }
+  return text;
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+class MetricsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { SetMetricsEnabled(true); }
+  void TearDown() override { SetMetricsEnabled(false); }
+};
+
+TEST_F(MetricsTest, HistogramBuckets) {
+  LatencyHistogram histogram;
+  histogram.Record(absl::ZeroDuration());
+  histogram.Record(absl::Microseconds(1));
+  histogram.Record(absl::Nanoseconds(1001));
+  histogram.Record(absl::Microseconds(4));
+  histogram.Record(absl::Microseconds(5));
+  histogram.Record(absl::Hours(1));
+
+  auto counts = histogram.bucket_counts();
+  EXPECT_THAT(counts[0], Eq(2));
+  EXPECT_THAT(counts[1], Eq(1));
+  EXPECT_THAT(counts[2], Eq(1));
+  EXPECT_THAT(counts[3], Eq(1));
+  EXPECT_THAT(counts[LatencyHistogram::kNumBuckets - 1], Eq(1));
+  EXPECT_THAT(histogram.count(), Eq(6));
+  EXPECT_THAT(histogram.sum(),
+              Eq(absl::Hours(1) + absl::Nanoseconds(11001)));
+  EXPECT_THAT(LatencyHistogram::BucketUpperBound(3),
+              Eq(absl::Microseconds(8)));
+  EXPECT_THAT(
+      LatencyHistogram::BucketUpperBound(LatencyHistogram::kNumBuckets - 1),
+      Eq(absl::InfiniteDuration()));
+}
+
+TEST_F(MetricsTest, RegistryReturnsSameMetricForName) {
+  MetricsRegistry registry;
+  EXPECT_THAT(registry.GetLatencyHistogram("a"),
+              Eq(registry.GetLatencyHistogram("a")));
+  EXPECT_NE(registry.GetLatencyHistogram("a"),
+            registry.GetLatencyHistogram("b"));
+  EXPECT_THAT(registry.GetCounter("a"), Eq(registry.GetCounter("a")));
+  EXPECT_THAT(registry.GetGauge("a"), Eq(registry.GetGauge("a")));
+}
+
+TEST_F(MetricsTest, Gauge) {
+  Gauge gauge;
+  EXPECT_THAT(gauge.Add(5), Eq(5));
+  EXPECT_THAT(gauge.Add(-2), Eq(3));
+  gauge.SetToMax(2);
+  EXPECT_THAT(gauge.value(), Eq(3));
+  gauge.SetToMax(7);
+  EXPECT_THAT(gauge.value(), Eq(7));
+  gauge.Set(1);
+  EXPECT_THAT(gauge.value(), Eq(1));
+}
+
+TEST_F(MetricsTest, ScopedLatencyTimerRecordsOnlyWhenEnabled) {
+  LatencyHistogram histogram;
+  { ScopedLatencyTimer timer(&histogram); }
+  SetMetricsEnabled(false);
+  { ScopedLatencyTimer timer(&histogram); }
+  { ScopedLatencyTimer timer(nullptr); }
+  EXPECT_THAT(histogram.count(), Eq(1));
+}
+
+TEST_F(MetricsTest, ConcurrentRecording) {
+  LatencyHistogram histogram;
+  Counter counter;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 1000; ++j) {
+        histogram.Record(absl::Microseconds(j));
+        counter.Increment(2);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_THAT(histogram.count(), Eq(4000));
+  EXPECT_THAT(counter.value(), Eq(8000));
+}
+
+TEST_F(MetricsTest, ExportPrometheusText) {
+  MetricsRegistry registry;
+  LatencyHistogram* histogram = registry.GetLatencyHistogram("Executor::Call");
+  histogram->Record(absl::Microseconds(3));
+  histogram->Record(absl::Milliseconds(2));
+  registry.GetCounter("bytes \"serialized\"")->Increment(42);
+  registry.GetGauge("Pool/QueueDepth")->Add(3);
+  registry.GetGauge("Pool/QueueDepth")->Add(-1);
+
+  std::string text = registry.ExportPrometheusText();
+  EXPECT_THAT(text, HasSubstr("# TYPE tff_latency_seconds histogram\n"));
+  EXPECT_THAT(text, HasSubstr("tff_latency_seconds_bucket{name=\"Executor::"
+                              "Call\",le=\"2e-06\"} 0\n"));
+  EXPECT_THAT(text, HasSubstr("tff_latency_seconds_bucket{name=\"Executor::"
+                              "Call\",le=\"4e-06\"} 1\n"));
+  EXPECT_THAT(text, HasSubstr("tff_latency_seconds_bucket{name=\"Executor::"
+                              "Call\",le=\"+Inf\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("tff_latency_seconds_sum{name=\"Executor::"
+                              "Call\"} 0.002003\n"));
+  EXPECT_THAT(text, HasSubstr("tff_latency_seconds_count{name=\"Executor::"
+                              "Call\"} 2\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE tff_counter_total counter\n"
+                              "tff_counter_total{name=\"bytes "
+                              "\\\"serialized\\\"\"} 42\n"));
+  EXPECT_THAT(text, HasSubstr("# TYPE tff_gauge gauge\n"
+                              "tff_gauge{name=\"Pool/QueueDepth\"} 2\n"));
+}
+
+TEST_F(MetricsTest, DefaultRegistryHelpers) {
+  {
+    auto timer = RecordLatency("MetricsTest::DefaultRegistryHelpers");
+  }
+  IncrementCounter("MetricsTest::DefaultRegistryHelpers", 3);
+  SetMetricsEnabled(false);
+  {
+    auto timer = RecordLatency("MetricsTest::DefaultRegistryHelpers");
+  }
+  IncrementCounter("MetricsTest::DefaultRegistryHelpers", 3);
+  EXPECT_THAT(MetricsRegistry::Default()
+                  .GetLatencyHistogram("MetricsTest::DefaultRegistryHelpers")
+                  ->count(),
+              Eq(1));
+  EXPECT_THAT(MetricsRegistry::Default()
+                  .GetCounter("MetricsTest::DefaultRegistryHelpers")
+                  ->value(),
+              Eq(3));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/numa.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// Upper bound on the number of NUMA nodes looked up in sysfs.
+constexpr int kMaxNumaNodes = 64;
+
+// The CPUs of each NUMA node of the host, read once.
+struct NumaTopology {
+  std::vector<std::vector<int>> node_cpus;
+};
+
+NumaTopology ReadNumaTopology() {
+  NumaTopology topology;
+#ifdef __linux__
+  for (int node = 0; node < kMaxNumaNodes; ++node) {
+    std::ifstream is(absl::StrCat("/sys/devices/system/node/node", node,
+                                  "/cpulist"));
+    if (!is) {
+      break;
+    }
+    std::ostringstream buffer;
+    buffer << is.rdbuf();
+    topology.node_cpus.push_back(internal::ParseCpuList(buffer.str()));
+  }
+#endif
+  return topology;
+}
+
+const NumaTopology& GetNumaTopology() {
+  static const NumaTopology* topology = new NumaTopology(ReadNumaTopology());
+  return *topology;
+}
+
+}  // namespace
+
+int GetNumNumaNodes() {
+  const int num_nodes = GetNumaTopology().node_cpus.size();
+  return num_nodes > 0 ? num_nodes : 1;
+}
+
+const std::vector<int>& GetNumaNodeCpus(int node) {
+  static const std::vector<int>* no_cpus = new std::vector<int>();
+  const NumaTopology& topology = GetNumaTopology();
+  if (node < 0 || node >= topology.node_cpus.size()) {
+    return *no_cpus;
+  }
+  return topology.node_cpus[node];
+}
+
+ScopedNumaNodeAffinity::ScopedNumaNodeAffinity(int node) {
+#ifdef __linux__
+  const std::vector<int>& cpus = GetNumaNodeCpus(node);
+  if (cpus.empty()) {
+    return;
+  }
+  cpu_set_t cpu_set;
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    return;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpu_set)) {
+      previous_cpus_.push_back(cpu);
+    }
+  }
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  pinned_ = sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0;
+#endif
+}
+
+ScopedNumaNodeAffinity::~ScopedNumaNodeAffinity() {
+#ifdef __linux__
+  if (!pinned_) {
+    return;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : previous_cpus_) {
+    CPU_SET(cpu, &cpu_set);
+  }
+  sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+#endif
+}
+
+namespace internal {
+
+std::vector<int> ParseCpuList(absl::string_view cpu_list) {
+  std::vector<int> cpus;
+  cpu_list = absl::StripAsciiWhitespace(cpu_list);
+  if (cpu_list.empty()) {
+    return cpus;
+  }
+  for (absl::string_view range : absl::StrSplit(cpu_list, ',')) {
+    std::vector<absl::string_view> bounds = absl::StrSplit(range, '-');
+    int first;
+    int last;
+    if (bounds.size() > 2 || !absl::SimpleAtoi(bounds[0], &first) ||
+        !absl::SimpleAtoi(bounds.back(), &last) || first < 0 ||
+        last < first) {
+      return {};
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+}  // namespace internal
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_BASE_NUMA_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_BASE_NUMA_H_
+
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+// This file defines utilities for placing work and memory on the NUMA nodes
+// of multi-socket hosts. The topology is read from sysfs on Linux; on other
+// platforms the host is treated as a single node and pinning is a no-op.
+
+namespace tensorflow_federated {
+
+/**
+ * Returns the number of NUMA nodes of the host, or 1 if the topology can't be
+ * determined.
+ */
+int GetNumNumaNodes();
+
+/**
+ * Returns the CPUs of the NUMA node, or an empty vector if the node doesn't
+ * exist or its CPUs can't be determined.
+ */
+const std::vector<int>& GetNumaNodeCpus(int node);
+
+/**
+ * Restricts the calling thread to the CPUs of a NUMA node for the lifetime of
+ * the object, and then restores the CPUs the thread was allowed to run on.
+ *
+ * The kernel allocates the pages a thread touches first on the node the thread
+ * runs on, so memory allocated and initialized while the thread is pinned,
+ * such as the state of an aggregator, ends up local to the node.
+ *
+ * Does nothing if the CPUs of the node are unknown.
+ */
+class ScopedNumaNodeAffinity {
+ public:
+  explicit ScopedNumaNodeAffinity(int node);
+  ~ScopedNumaNodeAffinity();
+
+  ScopedNumaNodeAffinity(const ScopedNumaNodeAffinity&) = delete;
+  ScopedNumaNodeAffinity& operator=(const ScopedNumaNodeAffinity&) = delete;
+
+  // Returns true if the thread has been pinned to the node.
+  bool pinned() const { return pinned_; }
+
+ private:
+  std::vector<int> previous_cpus_;
+  bool pinned_ = false;
+};
+
+namespace internal {
+
+/**
+ * Parses a list of CPUs in the sysfs format, e.g. "0-3,8,10-11". Returns an
+ * empty vector if the list is malformed.
+ */
+std::vector<int> ParseCpuList(absl::string_view cpu_list);
+
+}  // namespace internal
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_BASE_NUMA_H_
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/numa.h"
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(NumaTest, ParseCpuList) {
+  EXPECT_THAT(internal::ParseCpuList("0-3,8,10-11\n"),
+              ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  EXPECT_THAT(internal::ParseCpuList("5"), ElementsAre(5));
+  EXPECT_THAT(internal::ParseCpuList(""), IsEmpty());
+  EXPECT_THAT(internal::ParseCpuList("3-1"), IsEmpty());
+  EXPECT_THAT(internal::ParseCpuList("1-2-3"), IsEmpty());
+  EXPECT_THAT(internal::ParseCpuList("a,1"), IsEmpty());
+}
+
+TEST(NumaTest, HostHasAtLeastOneNode) {
+  EXPECT_GE(GetNumNumaNodes(), 1);
+  EXPECT_THAT(GetNumaNodeCpus(-1), IsEmpty());
+  EXPECT_THAT(GetNumaNodeCpus(GetNumNumaNodes()), IsEmpty());
+}
+
+TEST(NumaTest, UnknownNodeIsNotPinned) {
+  ScopedNumaNodeAffinity affinity(GetNumNumaNodes());
+  EXPECT_FALSE(affinity.pinned());
+}
+
+#ifdef __linux__
+TEST(NumaTest, RestoresAffinity) {
+  cpu_set_t before;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(before), &before), 0);
+  {
+    ScopedNumaNodeAffinity affinity(0);
+    if (affinity.pinned()) {
+      cpu_set_t pinned;
+      ASSERT_EQ(sched_getaffinity(0, sizeof(pinned), &pinned), 0);
+      for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &pinned)) {
+          EXPECT_THAT(GetNumaNodeCpus(0), ::testing::Contains(cpu));
+        }
+      }
+    }
+  }
+  cpu_set_t after;
+  ASSERT_EQ(sched_getaffinity(0, sizeof(after), &after), 0);
+  EXPECT_TRUE(CPU_EQUAL(&before, &after));
+}
+#endif
+
+}  // namespace
+}  // namespace tensorflow_federated
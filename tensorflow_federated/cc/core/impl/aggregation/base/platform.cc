@@ -19,6 +19,14 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cstddef>
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -85,6 +93,35 @@ absl::StatusOr<absl::Cord> ReadFileToCord(absl::string_view file_name) {
   return internal::ReadFile<absl::Cord>(file_name);
 }
 
+absl::StatusOr<absl::Cord> MapFileToCord(absl::string_view file_name) {
+#ifdef _WIN32
+  return ReadFileToCord(file_name);
+#else
+  auto file_name_str = std::string(file_name);
+  int fd = open(file_name_str.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return absl::InternalError(
+        absl::StrCat("cannot read file ", file_name_str));
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+    // Empty files can't be mapped, and the size of other files isn't known.
+    close(fd);
+    return ReadFileToCord(file_name);
+  }
+  const size_t size = static_cast<size_t>(info.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping remains valid after the file is closed.
+  close(fd);
+  if (data == MAP_FAILED) {
+    return ReadFileToCord(file_name);
+  }
+  return absl::MakeCordFromExternal(
+      absl::string_view(static_cast<const char*>(data), size),
+      [data, size]() { munmap(data, size); });
+#endif
+}
+
 absl::Status WriteStringToFile(absl::string_view file_name,
                                absl::string_view content) {
   auto file_name_str = std::string(file_name);
@@ -119,6 +156,15 @@ absl::Status WriteCordToFile(absl::string_view file_name,
   return absl::OkStatus();
 }
 
+absl::Status RemoveFile(absl::string_view file_name) {
+  auto file_name_str = std::string(file_name);
+  if (std::remove(file_name_str.c_str()) != 0) {
+    return absl::InternalError(
+        absl::StrCat("cannot delete file ", file_name_str));
+  }
+  return absl::OkStatus();
+}
+
 bool FileExists(absl::string_view file_name) {
   struct stat info;
   return stat(std::string(file_name).c_str(), &info) == 0;
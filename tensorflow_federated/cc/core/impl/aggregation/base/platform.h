@@ -49,6 +49,16 @@ absl::StatusOr<std::string> ReadFileToString(absl::string_view file_name);
  */
 absl::StatusOr<absl::Cord> ReadFileToCord(absl::string_view file_name);
 
+/**
+ * Maps file content into memory and returns it as an absl::Cord made of a
+ * single external chunk, which unmaps the file when it is released. The
+ * content is neither read nor copied upfront, and the chunk is page aligned,
+ * so parsers can alias it. The file may be removed while it is mapped but must
+ * not be truncated. Falls back to ReadFileToCord on platforms without mmap and
+ * for files which can't be mapped, such as pipes.
+ */
+absl::StatusOr<absl::Cord> MapFileToCord(absl::string_view file_name);
+
 /**
  * Writes string content into file.
  */
@@ -61,6 +71,11 @@ absl::Status WriteStringToFile(absl::string_view file_name,
 absl::Status WriteCordToFile(absl::string_view file_name,
                              const absl::Cord& content);
 
+/**
+ * Removes the file.
+ */
+absl::Status RemoveFile(absl::string_view file_name);
+
 /**
  * Returns true if the file exists.
  */
@@ -64,6 +64,29 @@ TEST(PlatformTest, ReadWriteCord) {
   ASSERT_EQ(status_or_cord.value(), "Ein Text");
 }
 
+TEST(PlatformTest, MapFileToCord) {
+  auto file = aggregation::TemporaryTestFile(".dat");
+  ASSERT_EQ(WriteStringToFile(file, "Ein Text").code(), OK);
+  auto status_or_cord = MapFileToCord(file);
+  ASSERT_TRUE(status_or_cord.ok()) << status_or_cord.status();
+  // The mapping outlives the file.
+  ASSERT_EQ(RemoveFile(file).code(), OK);
+  ASSERT_EQ(status_or_cord.value(), "Ein Text");
+  ASSERT_TRUE(status_or_cord->TryFlat().has_value());
+}
+
+TEST(PlatformTest, MapEmptyFileToCord) {
+  auto file = aggregation::TemporaryTestFile(".dat");
+  ASSERT_EQ(WriteStringToFile(file, "").code(), OK);
+  auto status_or_cord = MapFileToCord(file);
+  ASSERT_TRUE(status_or_cord.ok()) << status_or_cord.status();
+  ASSERT_TRUE(status_or_cord->empty());
+}
+
+TEST(PlatformTest, MapCordFails) {
+  ASSERT_FALSE(MapFileToCord("foobarbaz").ok());
+}
+
 TEST(PlatformTest, ReadStringFails) {
   ASSERT_FALSE(ReadFileToString("foobarbaz").ok());
 }
@@ -84,6 +107,17 @@ TEST(PlatformTest, FileExists) {
 
 TEST(PlatformTest, FileExistsNot) { ASSERT_FALSE(FileExists("foobarbaz")); }
 
+TEST(PlatformTest, RemoveFile) {
+  auto file = aggregation::TemporaryTestFile(".dat");
+  ASSERT_EQ(WriteStringToFile(file, "Ein Text").code(), OK);
+  ASSERT_EQ(RemoveFile(file).code(), OK);
+  ASSERT_FALSE(FileExists(file));
+}
+
+TEST(PlatformTest, RemoveFileFails) {
+  ASSERT_FALSE(RemoveFile("foobarbaz").ok());
+}
+
 }  // namespace
 
 }  // namespace tensorflow_federated
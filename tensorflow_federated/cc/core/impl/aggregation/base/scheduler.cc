@@ -16,7 +16,9 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <memory>
@@ -26,9 +28,11 @@
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/move_to_lambda.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/task_metrics.h"
 
 namespace tensorflow_federated {
 
@@ -96,11 +100,19 @@ class WorkerImpl : public Worker, public LifetimeTracker {
   std::deque<std::function<void()>> steps_ ABSL_GUARDED_BY(busy_);
 };
 
+// A task in the queue of a thread pool, with the time it was queued at for
+// TaskMetrics.
+struct QueuedTask {
+  std::function<void()> task;
+  int64_t queued_nanos = TaskMetrics::kNotRecorded;
+};
+
 // Implementation of thread pools.
 class ThreadPoolScheduler : public Scheduler {
  public:
-  explicit ThreadPoolScheduler(std::size_t thread_count)
-      : idle_condition_(absl::Condition(IdleCondition, this)),
+  ThreadPoolScheduler(std::size_t thread_count, absl::string_view name)
+      : metrics_(name),
+        idle_condition_(absl::Condition(IdleCondition, this)),
         active_count_(thread_count) {
     TFF_CHECK(thread_count > 0) << "invalid thread_count";
 
@@ -128,8 +140,9 @@ class ThreadPoolScheduler : public Scheduler {
   }
 
   void Schedule(std::function<void()> task) override {
+    const int64_t queued_nanos = metrics_.TaskQueued();
     absl::MutexLock lock(&busy_);
-    todo_.push(std::move(task));
+    todo_.push({std::move(task), queued_nanos});
     // Wake up a *single* thread to handle this task.
     work_available_cond_var_.Signal();
   }
@@ -146,7 +159,7 @@ class ThreadPoolScheduler : public Scheduler {
 
   void PerThreadActivity() {
     for (;;) {
-      std::function<void()> task;
+      QueuedTask task;
       {
         absl::MutexLock lock(&busy_);
         --active_count_;
@@ -165,10 +178,14 @@ class ThreadPoolScheduler : public Scheduler {
         ++active_count_;
       }
 
-      task();
+      const int64_t started_nanos = metrics_.TaskStarted(task.queued_nanos);
+      task.task();
+      metrics_.TaskFinished(task.queued_nanos, started_nanos);
     }
   }
 
+  TaskMetrics metrics_;
+
   // A vector of threads allocated for execution.
   std::vector<std::thread> threads_;
 
@@ -189,20 +206,170 @@ class ThreadPoolScheduler : public Scheduler {
   bool threads_should_join_ ABSL_GUARDED_BY(busy_) = false;
 
   // Queue of tasks with work to do.
-  std::queue<std::function<void()>> todo_ ABSL_GUARDED_BY(busy_);
+  std::queue<QueuedTask> todo_ ABSL_GUARDED_BY(busy_);
 
   // The number of threads currently doing work in this pool.
   std::size_t active_count_ ABSL_GUARDED_BY(busy_);
 };
 
+// Implementation of work-stealing thread pools.
+//
+// Each thread has its own queue of tasks. Tasks scheduled from a thread of the
+// pool go to the queue of that thread, which keeps the steps of a Worker on
+// the thread that ran the previous step; tasks scheduled from other threads
+// are spread across the queues. A thread takes tasks from its own queue
+// first, then steals from the queues of the other threads. Scheduling a task
+// only locks the queue it is added to, unless there are sleeping threads to
+// wake up.
+class WorkStealingScheduler : public Scheduler {
+ public:
+  WorkStealingScheduler(std::size_t thread_count, absl::string_view name)
+      : metrics_(name), queues_(thread_count) {
+    TFF_CHECK(thread_count > 0) << "invalid thread_count";
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      queues_[i] = std::make_unique<TaskQueue>();
+    }
+    for (std::size_t i = 0; i < thread_count; ++i) {
+      threads_.emplace_back([this, i] { this->PerThreadActivity(i); });
+    }
+  }
+
+  ~WorkStealingScheduler() override {
+    {
+      absl::MutexLock lock(&sleep_mu_);
+      TFF_CHECK(num_outstanding_tasks_ == 0)
+          << "Thread pool must be idle at destruction time";
+      threads_should_join_ = true;
+      work_available_cond_var_.SignalAll();
+    }
+    for (auto& thread : threads_) {
+      TFF_CHECK(thread.joinable()) << "Attempted to destroy a threadpool from "
+                                      "one of its running threads";
+      thread.join();
+    }
+  }
+
+  void Schedule(std::function<void()> task) override {
+    ++num_outstanding_tasks_;
+    const int64_t queued_nanos = metrics_.TaskQueued();
+    std::size_t index =
+        current_scheduler_ == this
+            ? current_queue_index_
+            : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                  queues_.size();
+    {
+      TaskQueue& queue = *queues_[index];
+      absl::MutexLock lock(&queue.mu);
+      queue.tasks.push_back({std::move(task), queued_nanos});
+    }
+    // Incremented after the task is queued, so that a thread which finds the
+    // count non-zero also finds the task.
+    ++num_queued_tasks_;
+    if (num_sleeping_threads_ > 0) {
+      absl::MutexLock lock(&sleep_mu_);
+      work_available_cond_var_.Signal();
+    }
+  }
+
+  void WaitUntilIdle() override {
+    absl::MutexLock lock(&sleep_mu_);
+    while (num_outstanding_tasks_ > 0) {
+      idle_cond_var_.Wait(&sleep_mu_);
+    }
+  }
+
+ private:
+  struct TaskQueue {
+    absl::Mutex mu;
+    std::deque<QueuedTask> tasks ABSL_GUARDED_BY(mu);
+  };
+
+  // Takes a task from the queue at `index`, or from another queue if that
+  // one is empty. Returns false if all queues are empty.
+  bool TakeTask(std::size_t index, QueuedTask& task) {
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+      TaskQueue& queue = *queues_[(index + i) % queues_.size()];
+      absl::MutexLock lock(&queue.mu);
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        --num_queued_tasks_;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void PerThreadActivity(std::size_t index) {
+    current_scheduler_ = this;
+    current_queue_index_ = index;
+    for (;;) {
+      QueuedTask task;
+      if (!TakeTask(index, task)) {
+        absl::MutexLock lock(&sleep_mu_);
+        ++num_sleeping_threads_;
+        // A task queued after TakeTask looked at its queue is counted by
+        // the time its Schedule call checks for sleeping threads.
+        while (num_queued_tasks_ == 0 && !threads_should_join_) {
+          work_available_cond_var_.Wait(&sleep_mu_);
+        }
+        --num_sleeping_threads_;
+        if (num_queued_tasks_ == 0 && threads_should_join_) {
+          return;
+        }
+        continue;
+      }
+      const int64_t started_nanos = metrics_.TaskStarted(task.queued_nanos);
+      task.task();
+      metrics_.TaskFinished(task.queued_nanos, started_nanos);
+      if (--num_outstanding_tasks_ == 0) {
+        absl::MutexLock lock(&sleep_mu_);
+        idle_cond_var_.SignalAll();
+      }
+    }
+  }
+
+  // The pool and queue of the calling thread, if it belongs to a pool.
+  static thread_local WorkStealingScheduler* current_scheduler_;
+  static thread_local std::size_t current_queue_index_;
+
+  TaskMetrics metrics_;
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  std::vector<std::thread> threads_;
+  // The queue to which the next task scheduled from outside of the pool is
+  // added.
+  std::atomic<std::size_t> next_queue_ = 0;
+  // The number of tasks in the queues.
+  std::atomic<std::size_t> num_queued_tasks_ = 0;
+  // The number of tasks scheduled but not yet finished.
+  std::atomic<std::size_t> num_outstanding_tasks_ = 0;
+  std::atomic<std::size_t> num_sleeping_threads_ = 0;
+
+  // Protects sleeping and waking up of threads, and waiting for idleness.
+  absl::Mutex sleep_mu_;
+  absl::CondVar work_available_cond_var_;
+  absl::CondVar idle_cond_var_;
+  bool threads_should_join_ ABSL_GUARDED_BY(sleep_mu_) = false;
+};
+
+thread_local WorkStealingScheduler* WorkStealingScheduler::current_scheduler_ =
+    nullptr;
+thread_local std::size_t WorkStealingScheduler::current_queue_index_ = 0;
+
 }  // namespace
 
 std::unique_ptr<Worker> Scheduler::CreateWorker() {
   return std::make_unique<WorkerImpl>(this);
 }
 
-std::unique_ptr<Scheduler> CreateThreadPoolScheduler(std::size_t thread_count) {
-  return std::make_unique<ThreadPoolScheduler>(thread_count);
+std::unique_ptr<Scheduler> CreateThreadPoolScheduler(std::size_t thread_count,
+                                                     absl::string_view name) {
+  return std::make_unique<ThreadPoolScheduler>(thread_count, name);
+}
+
+std::unique_ptr<Scheduler> CreateWorkStealingScheduler(
+    std::size_t thread_count, absl::string_view name) {
+  return std::make_unique<WorkStealingScheduler>(thread_count, name);
 }
 
 }  // namespace tensorflow_federated
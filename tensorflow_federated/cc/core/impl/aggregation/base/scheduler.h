@@ -29,6 +29,8 @@
 #include <functional>
 #include <memory>
 
+#include "absl/strings/string_view.h"
+
 namespace tensorflow_federated {
 
 /**
@@ -100,8 +102,28 @@ class Scheduler {
 
 /**
  * Creates a scheduler using a fixed-size pool of threads to run tasks.
+ *
+ * While metrics are enabled, the tasks of the pool are recorded in the
+ * "<name>/..." metrics of TaskMetrics.
+ */
+std::unique_ptr<Scheduler> CreateThreadPoolScheduler(
+    std::size_t thread_count, absl::string_view name = "ThreadPoolScheduler");
+
+/**
+ * Creates a scheduler using a fixed-size pool of threads, each with its own
+ * queue of tasks, which steal tasks from each other when out of work.
+ *
+ * Tasks scheduled from a thread of the pool, such as the steps of a Worker
+ * after the first one, are queued on that thread, and scheduling mostly
+ * avoids the single lock shared by all threads of CreateThreadPoolScheduler.
+ * Tasks aren't guaranteed to start in the order in which they are scheduled.
+ *
+ * While metrics are enabled, the tasks of the pool are recorded in the
+ * "<name>/..." metrics of TaskMetrics.
  */
-std::unique_ptr<Scheduler> CreateThreadPoolScheduler(std::size_t thread_count);
+std::unique_ptr<Scheduler> CreateWorkStealingScheduler(
+    std::size_t thread_count,
+    absl::string_view name = "WorkStealingScheduler");
 
 }  // namespace tensorflow_federated
 
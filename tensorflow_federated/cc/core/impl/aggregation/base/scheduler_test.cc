@@ -26,6 +26,7 @@
 #include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
 
 namespace tensorflow_federated {
 namespace base {
@@ -50,6 +51,27 @@ TEST(ThreadPool, TasksAreExecuted) {
   EXPECT_TRUE(b2);
 }
 
+// Tests whether the tasks of the pool are recorded in its metrics.
+TEST(ThreadPool, RecordsTaskMetrics) {
+  SetMetricsEnabled(true);
+  auto pool = CreateThreadPoolScheduler(2, "ThreadPoolMetricsTest");
+  for (int i = 0; i < 100; ++i) {
+    pool->Schedule([]() {});
+  }
+  pool->WaitUntilIdle();
+  SetMetricsEnabled(false);
+
+  MetricsRegistry& registry = MetricsRegistry::Default();
+  EXPECT_EQ(
+      registry.GetLatencyHistogram("ThreadPoolMetricsTest/Run")->count(), 100);
+  EXPECT_EQ(
+      registry.GetLatencyHistogram("ThreadPoolMetricsTest/QueueWait")->count(),
+      100);
+  EXPECT_EQ(registry.GetGauge("ThreadPoolMetricsTest/QueueDepth")->value(), 0);
+  EXPECT_EQ(registry.GetGauge("ThreadPoolMetricsTest/ActiveThreads")->value(),
+            0);
+}
+
 // Tests whether the pool uses actually multiple threads to execute tasks.
 // The test goal is achieved by blocking in one task until another task
 // unblocks, which can only work if multiple threads are used.
@@ -124,6 +146,117 @@ TEST(Worker, TasksAreExecutedSequentially) {
   }
 }
 
+TEST(WorkStealing, TasksAreExecuted) {
+  auto pool = CreateWorkStealingScheduler(2);
+
+  bool b1 = false;
+  bool b2 = false;
+  pool->Schedule([&b1]() { b1 = true; });
+  pool->Schedule([&b2]() { b2 = true; });
+
+  pool->WaitUntilIdle();
+
+  EXPECT_TRUE(b1);
+  EXPECT_TRUE(b2);
+}
+
+// Both tasks are scheduled from a task running on the pool, so they are
+// queued on the same thread, and the second one only runs if it is stolen
+// by the other thread.
+TEST(WorkStealing, TasksAreStolen) {
+  auto pool = CreateWorkStealingScheduler(2);
+
+  absl::BlockingCounter counter(1);
+  bool b1 = false;
+  bool b2 = false;
+
+  pool->Schedule([&pool, &b1, &b2, &counter] {
+    pool->Schedule([&b1, &counter] {
+      counter.Wait();
+      b1 = true;
+    });
+    pool->Schedule([&b2, &counter] {
+      counter.DecrementCount();
+      b2 = true;
+    });
+  });
+
+  pool->WaitUntilIdle();
+
+  EXPECT_TRUE(b1);
+  EXPECT_TRUE(b2);
+}
+
+TEST(WorkStealing, StressTest) {
+  // Each task schedules further tasks from the pool, so that tasks are
+  // queued both from within and from outside of the pool.
+  static constexpr int kThreads = 32;
+  static constexpr int kIterations = 16;
+  auto pool = CreateWorkStealingScheduler(kThreads);
+  std::atomic<int64_t> atomic_counter{0};
+
+  for (auto i = 0; i < kThreads; ++i) {
+    pool->Schedule([&pool, &atomic_counter] {
+      for (auto j = 0; j < kIterations; ++j) {
+        pool->Schedule([&atomic_counter] {
+          absl::SleepFor(absl::Microseconds(std::rand() % 500));
+          atomic_counter.fetch_add(1);
+        });
+      }
+    });
+  }
+
+  pool->WaitUntilIdle();
+  ASSERT_EQ(atomic_counter, kThreads * kIterations);
+}
+
+TEST(WorkStealing, RecordsTaskMetrics) {
+  SetMetricsEnabled(true);
+  auto pool = CreateWorkStealingScheduler(3, "WorkStealingMetricsTest");
+  auto worker = pool->CreateWorker();
+  for (int i = 0; i < 100; ++i) {
+    pool->Schedule([]() {});
+    worker->Schedule([]() {});
+  }
+  pool->WaitUntilIdle();
+  SetMetricsEnabled(false);
+
+  MetricsRegistry& registry = MetricsRegistry::Default();
+  EXPECT_EQ(
+      registry.GetLatencyHistogram("WorkStealingMetricsTest/Run")->count(),
+      200);
+  EXPECT_EQ(
+      registry.GetGauge("WorkStealingMetricsTest/QueueDepth")->value(), 0);
+  EXPECT_EQ(
+      registry.GetGauge("WorkStealingMetricsTest/ActiveThreads")->value(), 0);
+}
+
+TEST(WorkStealing, WorkerTasksAreExecutedSequentially) {
+  auto pool = CreateWorkStealingScheduler(3);
+  auto worker = pool->CreateWorker();
+  absl::Mutex mutex{};
+  std::vector<int> recorded{};
+  for (int i = 0; i < 128; i++) {
+    worker->Schedule([&mutex, &recorded, i] {
+      // Expect that no one is holding the mutex (tests for non-overlap).
+      if (mutex.TryLock()) {
+        // Add i to the recorded values (tests for execution in order).
+        recorded.push_back(i);
+        mutex.Unlock();
+      } else {
+        FAIL() << "mutex was unexpectedly hold";
+      }
+    });
+  }
+  pool->WaitUntilIdle();
+
+  // Verify recorded values.
+  ASSERT_EQ(recorded.size(), 128);
+  for (int i = 0; i < 128; i++) {
+    ASSERT_EQ(recorded[i], i);
+  }
+}
+
 }  // namespace
 
 }  // namespace base
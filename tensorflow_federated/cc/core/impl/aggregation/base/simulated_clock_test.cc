@@ -128,6 +128,25 @@ TEST(SimulatedClockTest, PastAndCurrentDeadlines) {
   EXPECT_THAT(output, ElementsAre(1, 2));
 }
 
+// Verifies that waiters scheduled in the future, each sooner than the
+// previous one, are triggered in the order of their deadlines.
+TEST(SimulatedClockTest, DecreasingDeadlines) {
+  std::vector<int> output;
+  absl::Time t = GetTestInitialTime();
+  SimulatedClock clock(t);
+
+  for (int i = 1; i <= 3; ++i) {
+    clock.WakeupWithDeadline(t + absl::Seconds(10 - i),
+                             std::make_shared<TestWaiter>(i, &output));
+  }
+  EXPECT_THAT(output, ElementsAre());
+
+  clock.AdvanceTime(absl::Seconds(8));
+  EXPECT_THAT(output, ElementsAre(3, 2));
+  clock.AdvanceTime(absl::Seconds(1));
+  EXPECT_THAT(output, ElementsAre(3, 2, 1));
+}
+
 // Verifies that only expired waiters are triggered.
 TEST(SimulatedClockTest, MultipleWaiters) {
   std::vector<int> output;
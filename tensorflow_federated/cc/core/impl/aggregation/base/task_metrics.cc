@@ -0,0 +1,198 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/task_metrics.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// The live TaskMetrics, for ExportTaskTraceJson.
+struct LiveTaskMetrics {
+  absl::Mutex mutex;
+  std::set<const TaskMetrics*> metrics ABSL_GUARDED_BY(mutex);
+};
+
+LiveTaskMetrics& GetLiveTaskMetrics() {
+  static LiveTaskMetrics* live = new LiveTaskMetrics();
+  return *live;
+}
+
+// Returns a small number identifying the calling thread.
+int32_t CurrentThreadNumber() {
+  static std::atomic<int32_t> next_thread_number = 1;
+  thread_local const int32_t thread_number = next_thread_number.fetch_add(1);
+  return thread_number;
+}
+
+// Escapes a string for a JSON string literal.
+std::string EscapeJson(absl::string_view value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      absl::StrAppendFormat(&escaped, "\\u%04x", c);
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+}  // namespace
+
+TaskMetrics::TaskMetrics(absl::string_view name, MetricsRegistry& registry)
+    : name_(name),
+      queue_wait_(
+          registry.GetLatencyHistogram(absl::StrCat(name, "/QueueWait"))),
+      run_(registry.GetLatencyHistogram(absl::StrCat(name, "/Run"))),
+      queue_depth_(registry.GetGauge(absl::StrCat(name, "/QueueDepth"))),
+      active_threads_(registry.GetGauge(absl::StrCat(name, "/ActiveThreads"))),
+      trace_(std::make_unique<std::array<TraceSlot, kTraceCapacity>>()) {
+  LiveTaskMetrics& live = GetLiveTaskMetrics();
+  absl::MutexLock lock(&live.mutex);
+  live.metrics.insert(this);
+}
+
+TaskMetrics::~TaskMetrics() {
+  LiveTaskMetrics& live = GetLiveTaskMetrics();
+  absl::MutexLock lock(&live.mutex);
+  live.metrics.erase(this);
+}
+
+int64_t TaskMetrics::TaskQueued() {
+  if (!MetricsEnabled()) {
+    return kNotRecorded;
+  }
+  queue_depth_->Add(1);
+  return absl::GetCurrentTimeNanos();
+}
+
+int64_t TaskMetrics::TaskStarted(int64_t queued_nanos) {
+  if (queued_nanos != kNotRecorded) {
+    // The task was counted when it was queued, even if metrics have been
+    // disabled since.
+    queue_depth_->Add(-1);
+  }
+  if (!MetricsEnabled()) {
+    return kNotRecorded;
+  }
+  const int64_t started_nanos = absl::GetCurrentTimeNanos();
+  if (queued_nanos != kNotRecorded) {
+    queue_wait_->Record(absl::Nanoseconds(started_nanos - queued_nanos));
+  }
+  active_threads_->Add(1);
+  return started_nanos;
+}
+
+void TaskMetrics::TaskFinished(int64_t queued_nanos, int64_t started_nanos) {
+  if (started_nanos == kNotRecorded) {
+    return;
+  }
+  const int64_t finished_nanos = absl::GetCurrentTimeNanos();
+  active_threads_->Add(-1);
+  run_->Record(absl::Nanoseconds(finished_nanos - started_nanos));
+
+  const uint64_t index =
+      next_trace_slot_.fetch_add(1, std::memory_order_relaxed);
+  TraceSlot& slot = (*trace_)[index % kTraceCapacity];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.queued_nanos.store(
+      queued_nanos == kNotRecorded ? started_nanos : queued_nanos,
+      std::memory_order_relaxed);
+  slot.started_nanos.store(started_nanos, std::memory_order_relaxed);
+  slot.finished_nanos.store(finished_nanos, std::memory_order_relaxed);
+  slot.thread.store(CurrentThreadNumber(), std::memory_order_relaxed);
+  slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+std::vector<TaskMetrics::TaskSpan> TaskMetrics::RecentTasks() const {
+  std::vector<TaskSpan> spans;
+  spans.reserve(kTraceCapacity);
+  for (const TraceSlot& slot : *trace_) {
+    const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    TaskSpan span;
+    span.queued_nanos = slot.queued_nanos.load(std::memory_order_relaxed);
+    span.started_nanos = slot.started_nanos.load(std::memory_order_relaxed);
+    span.finished_nanos = slot.finished_nanos.load(std::memory_order_relaxed);
+    span.thread = slot.thread.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence != 0 &&
+        slot.sequence.load(std::memory_order_relaxed) == sequence) {
+      spans.push_back(span);
+    }
+  }
+  return spans;
+}
+
+std::string ExportTaskTraceJson() {
+  LiveTaskMetrics& live = GetLiveTaskMetrics();
+  absl::MutexLock lock(&live.mutex);
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto append_event = [&](const std::string& event) {
+    absl::StrAppend(&json, first ? "\n" : ",\n", event);
+    first = false;
+  };
+  int pid = 0;
+  for (const TaskMetrics* metrics : live.metrics) {
+    ++pid;
+    append_event(absl::StrFormat(
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+        "\"args\":{\"name\":\"%s\"}}",
+        pid, EscapeJson(metrics->name())));
+    std::vector<TaskMetrics::TaskSpan> spans = metrics->RecentTasks();
+    std::sort(spans.begin(), spans.end(),
+              [](const TaskMetrics::TaskSpan& a,
+                 const TaskMetrics::TaskSpan& b) {
+                return a.started_nanos < b.started_nanos;
+              });
+    for (const TaskMetrics::TaskSpan& span : spans) {
+      append_event(absl::StrFormat(
+          "{\"name\":\"task\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+          "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"queue_wait_us\":%.3f}}",
+          pid, span.thread, span.started_nanos / 1e3,
+          (span.finished_nanos - span.started_nanos) / 1e3,
+          (span.started_nanos - span.queued_nanos) / 1e3));
+    }
+  }
+  absl::StrAppend(&json, "\n]}\n");
+  return json;
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_BASE_TASK_METRICS_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_BASE_TASK_METRICS_H_
+
+/**
+ * Overview
+ * ========
+ *
+ * Metrics of the tasks run by a pool of threads, which tell whether the
+ * latency of the work scheduled on the pool comes from waiting in its queues
+ * or from running. Like the other metrics, they are only recorded while
+ * metrics are enabled (see SetMetricsEnabled); a recorded task then costs
+ * three clock reads and a few relaxed atomic operations, and never takes a
+ * lock.
+ *
+ * Besides the histograms and gauges, the most recent tasks of each pool are
+ * kept in a ring buffer, which ExportTaskTraceJson dumps on demand in a
+ * format that trace viewers open.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+
+namespace tensorflow_federated {
+
+/**
+ * Records the tasks of a pool named `name` into metrics of a registry:
+ *
+ *   - "<name>/QueueWait": histogram of the time from queuing to start.
+ *   - "<name>/Run": histogram of the time from start to finish.
+ *   - "<name>/QueueDepth": gauge of the number of tasks queued, not started.
+ *   - "<name>/ActiveThreads": gauge of the number of tasks running.
+ *
+ * Pools with the same name share the metrics. A task queued while metrics
+ * are disabled is not counted in the queue depth, nor its wait recorded.
+ */
+class TaskMetrics final {
+ public:
+  /** The time of a task which isn't recorded. */
+  static constexpr int64_t kNotRecorded = 0;
+  /** The number of recent tasks kept for ExportTaskTraceJson. */
+  static constexpr size_t kTraceCapacity = 1024;
+
+  explicit TaskMetrics(absl::string_view name,
+                       MetricsRegistry& registry = MetricsRegistry::Default());
+  ~TaskMetrics();
+
+  TaskMetrics(const TaskMetrics&) = delete;
+  TaskMetrics& operator=(const TaskMetrics&) = delete;
+
+  const std::string& name() const { return name_; }
+
+  /**
+   * Records that a task has been queued. Returns the time to pass to
+   * TaskStarted, or kNotRecorded if metrics are disabled.
+   */
+  int64_t TaskQueued();
+
+  /**
+   * Records that the calling thread starts running a task which was queued at
+   * `queued_nanos`. Returns the time to pass to TaskFinished, or kNotRecorded
+   * if metrics are disabled.
+   */
+  int64_t TaskStarted(int64_t queued_nanos);
+
+  /**
+   * Records that the calling thread has finished running a task which was
+   * queued at `queued_nanos` and started at `started_nanos`.
+   */
+  void TaskFinished(int64_t queued_nanos, int64_t started_nanos);
+
+  /** A task which has finished, with its times in nanoseconds since epoch. */
+  struct TaskSpan {
+    int64_t queued_nanos;
+    int64_t started_nanos;
+    int64_t finished_nanos;
+    // A small number identifying the thread which ran the task.
+    int32_t thread;
+  };
+
+  /**
+   * Returns the recorded tasks which finished most recently, at most
+   * kTraceCapacity of them, in no particular order. Tasks finishing
+   * concurrently may be missing.
+   */
+  std::vector<TaskSpan> RecentTasks() const;
+
+ private:
+  // A slot of the ring buffer of recent tasks. `sequence` is zero while the
+  // slot is written, and otherwise one more than the index of the task in it,
+  // so that readers can skip slots changing under them.
+  struct TraceSlot {
+    std::atomic<uint64_t> sequence = 0;
+    std::atomic<int64_t> queued_nanos = 0;
+    std::atomic<int64_t> started_nanos = 0;
+    std::atomic<int64_t> finished_nanos = 0;
+    std::atomic<int32_t> thread = 0;
+  };
+
+  const std::string name_;
+  LatencyHistogram* const queue_wait_;
+  LatencyHistogram* const run_;
+  Gauge* const queue_depth_;
+  Gauge* const active_threads_;
+  std::atomic<uint64_t> next_trace_slot_ = 0;
+  const std::unique_ptr<std::array<TraceSlot, kTraceCapacity>> trace_;
+};
+
+/**
+ * Returns the recent tasks of all live TaskMetrics in the Chrome trace event
+ * JSON format, which chrome://tracing and https://ui.perfetto.dev open. Each
+ * pool is shown as a process, and each of its threads as a thread of it,
+ * with a span per task; the wait of a task in the queue is an argument of
+ * its span.
+ */
+std::string ExportTaskTraceJson();
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_BASE_TASK_METRICS_H_
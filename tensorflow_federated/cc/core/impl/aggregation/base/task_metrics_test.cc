@@ -0,0 +1,142 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/task_metrics.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::Not;
+using ::testing::SizeIs;
+
+class TaskMetricsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { SetMetricsEnabled(true); }
+  void TearDown() override { SetMetricsEnabled(false); }
+
+  MetricsRegistry registry_;
+};
+
+TEST_F(TaskMetricsTest, RecordsQueueWaitRunAndGauges) {
+  TaskMetrics metrics("pool", registry_);
+  int64_t queued = metrics.TaskQueued();
+  int64_t other_queued = metrics.TaskQueued();
+  EXPECT_THAT(registry_.GetGauge("pool/QueueDepth")->value(), Eq(2));
+
+  int64_t started = metrics.TaskStarted(queued);
+  EXPECT_THAT(started, Ge(queued));
+  EXPECT_THAT(registry_.GetGauge("pool/QueueDepth")->value(), Eq(1));
+  EXPECT_THAT(registry_.GetGauge("pool/ActiveThreads")->value(), Eq(1));
+  EXPECT_THAT(registry_.GetLatencyHistogram("pool/QueueWait")->count(), Eq(1));
+
+  metrics.TaskFinished(queued, started);
+  EXPECT_THAT(registry_.GetGauge("pool/ActiveThreads")->value(), Eq(0));
+  EXPECT_THAT(registry_.GetLatencyHistogram("pool/Run")->count(), Eq(1));
+
+  metrics.TaskFinished(other_queued, metrics.TaskStarted(other_queued));
+  EXPECT_THAT(registry_.GetGauge("pool/QueueDepth")->value(), Eq(0));
+  EXPECT_THAT(registry_.GetLatencyHistogram("pool/Run")->count(), Eq(2));
+}
+
+TEST_F(TaskMetricsTest, GaugesStayConsistentWhenMetricsAreToggled) {
+  TaskMetrics metrics("pool", registry_);
+  // Queued while enabled, started while disabled.
+  int64_t queued = metrics.TaskQueued();
+  SetMetricsEnabled(false);
+  int64_t started = metrics.TaskStarted(queued);
+  EXPECT_THAT(started, Eq(TaskMetrics::kNotRecorded));
+  metrics.TaskFinished(queued, started);
+  EXPECT_THAT(registry_.GetGauge("pool/QueueDepth")->value(), Eq(0));
+
+  // Queued while disabled, started and finished while enabled.
+  queued = metrics.TaskQueued();
+  EXPECT_THAT(queued, Eq(TaskMetrics::kNotRecorded));
+  SetMetricsEnabled(true);
+  started = metrics.TaskStarted(queued);
+  EXPECT_THAT(registry_.GetGauge("pool/QueueDepth")->value(), Eq(0));
+  EXPECT_THAT(registry_.GetGauge("pool/ActiveThreads")->value(), Eq(1));
+  metrics.TaskFinished(queued, started);
+  EXPECT_THAT(registry_.GetGauge("pool/ActiveThreads")->value(), Eq(0));
+  EXPECT_THAT(registry_.GetLatencyHistogram("pool/QueueWait")->count(), Eq(0));
+  EXPECT_THAT(registry_.GetLatencyHistogram("pool/Run")->count(), Eq(1));
+}
+
+TEST_F(TaskMetricsTest, KeepsMostRecentTasks) {
+  TaskMetrics metrics("pool", registry_);
+  EXPECT_THAT(metrics.RecentTasks(), SizeIs(0));
+  for (int i = 0; i < TaskMetrics::kTraceCapacity + 10; ++i) {
+    int64_t queued = metrics.TaskQueued();
+    metrics.TaskFinished(queued, metrics.TaskStarted(queued));
+  }
+  std::vector<TaskMetrics::TaskSpan> spans = metrics.RecentTasks();
+  EXPECT_THAT(spans, SizeIs(TaskMetrics::kTraceCapacity));
+  for (const TaskMetrics::TaskSpan& span : spans) {
+    EXPECT_THAT(span.started_nanos, Ge(span.queued_nanos));
+    EXPECT_THAT(span.finished_nanos, Ge(span.started_nanos));
+  }
+}
+
+TEST_F(TaskMetricsTest, ConcurrentTasks) {
+  TaskMetrics metrics("pool", registry_);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 1000; ++j) {
+        int64_t queued = metrics.TaskQueued();
+        metrics.TaskFinished(queued, metrics.TaskStarted(queued));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_THAT(registry_.GetLatencyHistogram("pool/Run")->count(), Eq(4000));
+  EXPECT_THAT(registry_.GetGauge("pool/QueueDepth")->value(), Eq(0));
+  EXPECT_THAT(registry_.GetGauge("pool/ActiveThreads")->value(), Eq(0));
+  EXPECT_THAT(metrics.RecentTasks(), SizeIs(TaskMetrics::kTraceCapacity));
+}
+
+TEST_F(TaskMetricsTest, ExportTaskTraceJson) {
+  std::string json;
+  {
+    TaskMetrics metrics("pool \"a\"", registry_);
+    int64_t queued = metrics.TaskQueued();
+    metrics.TaskFinished(queued, metrics.TaskStarted(queued));
+    json = ExportTaskTraceJson();
+  }
+  EXPECT_THAT(json, HasSubstr("\"traceEvents\":["));
+  EXPECT_THAT(json, HasSubstr("{\"name\":\"process_name\",\"ph\":\"M\","));
+  EXPECT_THAT(json, HasSubstr("\"args\":{\"name\":\"pool \\\"a\\\"\"}}"));
+  EXPECT_THAT(json, HasSubstr("{\"name\":\"task\",\"ph\":\"X\","));
+  EXPECT_THAT(json, HasSubstr("\"queue_wait_us\":"));
+  // Destroyed metrics are no longer exported.
+  EXPECT_THAT(ExportTaskTraceJson(), Not(HasSubstr("pool \\\"a\\\"")));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -0,0 +1,316 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/buffer_pool.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dense_accumulator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/federated_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_factory.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+namespace {
+
+// Returns the sum divided by `divisor`, copied into a new MutableVectorData.
+template <typename T>
+std::unique_ptr<TensorData> Divide(const TensorData& sum, int divisor) {
+  const T* values = static_cast<const T*>(sum.data());
+  const size_t size = sum.byte_size() / sizeof(T);
+  std::unique_ptr<MutableVectorData<T>> mean = CreateVectorData<T>(size);
+  std::vector<T>& mean_values = *mean;
+  for (size_t i = 0; i < size; ++i) {
+    mean_values[i] = values[i] / divisor;
+  }
+  return mean;
+}
+
+}  // namespace
+
+// Dense federated_sum or, if `is_mean`, the unweighted federated_mean, whose
+// sum is held by a DenseAccumulator. Each Accumulate or AccumulateBatch call
+// hands its inputs to the accumulator at once, and the sum is only taken from
+// the accumulator, e.g. copied back from a device, when the aggregator is
+// reported, serialized or merged into another one.
+class AcceleratedFederatedSum final : public TensorAggregator {
+ public:
+  AcceleratedFederatedSum(DataType dtype, TensorShape shape, bool is_mean,
+                          std::unique_ptr<DenseAccumulator> accumulator,
+                          int num_inputs)
+      : dtype_(dtype),
+        shape_(std::move(shape)),
+        is_mean_(is_mean),
+        accumulator_(std::move(accumulator)),
+        num_inputs_(num_inputs) {}
+
+  int GetNumInputs() const override { return num_inputs_; }
+
+  size_t GetMemoryUsage() const override {
+    return accumulator_ == nullptr ? 0 : accumulator_->GetMemoryUsage();
+  }
+
+  Status MergeWith(TensorAggregator&& other) override {
+    TFF_RETURN_IF_ERROR(CheckValid());
+    auto* other_ptr = dynamic_cast<AcceleratedFederatedSum*>(&other);
+    if (other_ptr == nullptr || other_ptr->dtype_ != dtype_ ||
+        other_ptr->shape_ != shape_ || other_ptr->is_mean_ != is_mean_) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AcceleratedFederatedSum::MergeWith: Can only merge with "
+                "another AcceleratedFederatedSum of the same intrinsic, dtype "
+                "and shape.";
+    }
+    TFF_RETURN_IF_ERROR(other_ptr->CheckValid());
+    TFF_ASSIGN_OR_RETURN(Tensor other_sum, std::move(*other_ptr).TakeSum());
+    const Tensor* inputs[] = {&other_sum};
+    TFF_RETURN_IF_ERROR(accumulator_->AddBatch(inputs));
+    num_inputs_ += other_ptr->num_inputs_;
+    return TFF_STATUS(OK);
+  }
+
+  StatusOr<std::string> Serialize() && override {
+    TFF_RETURN_IF_ERROR(CheckValid());
+    const int num_inputs = num_inputs_;
+    TFF_ASSIGN_OR_RETURN(Tensor sum, std::move(*this).TakeSum());
+    std::string encoded_sum(static_cast<const char*>(sum.data().data()),
+                            sum.data().byte_size());
+    // The states are those of FederatedSum and FederatedMean, so that the
+    // intrinsics can be switched between rounds of an aggregation.
+    if (is_mean_) {
+      FederatedMeanAggregatorState aggregator_state;
+      aggregator_state.set_num_inputs(num_inputs);
+      *aggregator_state.mutable_weighted_values_sum() = std::move(encoded_sum);
+      const int32_t weights_sum = 0;
+      aggregator_state.set_weights_sum(std::string(
+          reinterpret_cast<const char*>(&weights_sum), sizeof(weights_sum)));
+      return aggregator_state.SerializeAsString();
+    }
+    AggVectorAggregatorState aggregator_state;
+    aggregator_state.set_num_inputs(num_inputs);
+    *aggregator_state.mutable_vector_data() = std::move(encoded_sum);
+    return aggregator_state.SerializeAsString();
+  }
+
+ protected:
+  Status AggregateTensors(InputTensorList tensors) override {
+    return AggregateTensorBatch(absl::MakeConstSpan(&tensors, 1));
+  }
+
+  // Validates all inputs of the batch before passing all of them to the
+  // accumulator at once.
+  Status AggregateTensorBatch(
+      absl::Span<const InputTensorList> batch) override {
+    std::vector<const Tensor*> inputs;
+    inputs.reserve(batch.size());
+    for (const InputTensorList& tensors : batch) {
+      TFF_CHECK(tensors.size() == 1)
+          << "AcceleratedFederatedSum should operate on a single input tensor";
+      const Tensor* tensor = tensors[0];
+      if (tensor->dtype() != dtype_ || tensor->shape() != shape_) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "AcceleratedFederatedSum::AggregateTensors: Input tensor "
+                  "doesn't match the intrinsic spec.";
+      }
+      if (!tensor->is_dense()) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "AcceleratedFederatedSum::AggregateTensors: Only dense "
+                  "input tensors are supported.";
+      }
+      inputs.push_back(tensor);
+    }
+    TFF_RETURN_IF_ERROR(accumulator_->AddBatch(inputs));
+    num_inputs_ += batch.size();
+    return TFF_STATUS(OK);
+  }
+
+  Status CheckValid() const override {
+    if (accumulator_ == nullptr) {
+      return TFF_STATUS(FAILED_PRECONDITION)
+             << "AcceleratedFederatedSum::CheckValid: Output has already been "
+                "consumed.";
+    }
+    return TFF_STATUS(OK);
+  }
+
+  OutputTensorList TakeOutputs() && override {
+    StatusOr<Tensor> sum = std::move(*this).TakeSum();
+    TFF_CHECK(sum.ok()) << "AcceleratedFederatedSum: Failed to take the sum: "
+                        << sum.status();
+    OutputTensorList outputs;
+    if (!is_mean_) {
+      outputs.push_back(std::move(sum).value());
+      return outputs;
+    }
+    std::unique_ptr<TensorData> mean;
+    FLOATING_ONLY_DTYPE_CASES(dtype_, T,
+                              mean = Divide<T>(sum->data(), num_inputs_));
+    outputs.push_back(Tensor::Create(dtype_, shape_, std::move(mean)).value());
+    return outputs;
+  }
+
+ private:
+  // Takes the sum out of the accumulator, consuming it.
+  StatusOr<Tensor> TakeSum() && {
+    std::unique_ptr<DenseAccumulator> accumulator = std::move(accumulator_);
+    TFF_ASSIGN_OR_RETURN(std::unique_ptr<TensorData> sum,
+                         std::move(*accumulator).TakeSum());
+    return Tensor::Create(dtype_, shape_, std::move(sum));
+  }
+
+  const DataType dtype_;
+  const TensorShape shape_;
+  const bool is_mean_;
+  std::unique_ptr<DenseAccumulator> accumulator_;
+  int num_inputs_;
+};
+
+// Factory of the accelerated_federated_sum intrinsic, or of the
+// accelerated_federated_mean one if `kIsMean`. The aggregators get their
+// accumulators from the backend set with SetDenseAccumulatorFactory.
+template <bool kIsMean>
+class AcceleratedFederatedSumFactory final : public TensorAggregatorFactory {
+ public:
+  AcceleratedFederatedSumFactory() = default;
+
+  // AcceleratedFederatedSumFactory isn't copyable or moveable.
+  AcceleratedFederatedSumFactory(const AcceleratedFederatedSumFactory&) =
+      delete;
+  AcceleratedFederatedSumFactory& operator=(
+      const AcceleratedFederatedSumFactory&) = delete;
+
+  StatusOr<std::unique_ptr<TensorAggregator>> Create(
+      const Intrinsic& intrinsic) const override {
+    return CreateInternal(intrinsic, nullptr, 0);
+  }
+
+  StatusOr<std::unique_ptr<TensorAggregator>> Deserialize(
+      const Intrinsic& intrinsic, std::string serialized_state) const override {
+    std::string encoded_sum;
+    int num_inputs;
+    if constexpr (kIsMean) {
+      FederatedMeanAggregatorState aggregator_state;
+      if (!aggregator_state.ParseFromString(serialized_state)) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "AcceleratedFederatedSumFactory: Failed to parse "
+                  "FederatedMeanAggregatorState.";
+      }
+      encoded_sum = std::move(*aggregator_state.mutable_weighted_values_sum());
+      num_inputs = aggregator_state.num_inputs();
+    } else {
+      AggVectorAggregatorState aggregator_state;
+      if (!aggregator_state.ParseFromString(serialized_state)) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "AcceleratedFederatedSumFactory: Failed to parse "
+                  "AggVectorAggregatorState.";
+      }
+      encoded_sum = std::move(*aggregator_state.mutable_vector_data());
+      num_inputs = aggregator_state.num_inputs();
+    }
+    return CreateInternal(intrinsic, &encoded_sum, num_inputs);
+  }
+
+ private:
+  static constexpr const char* kUri =
+      kIsMean ? kAcceleratedFederatedMeanUri : kAcceleratedFederatedSumUri;
+
+  StatusOr<std::unique_ptr<TensorAggregator>> CreateInternal(
+      const Intrinsic& intrinsic, const std::string* encoded_sum,
+      int num_inputs) const {
+    if (intrinsic.uri != kUri) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AcceleratedFederatedSumFactory: Expected intrinsic URI "
+             << kUri << " but got uri " << intrinsic.uri;
+    }
+    if (intrinsic.inputs.size() != 1 || intrinsic.outputs.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AcceleratedFederatedSumFactory: Exactly one input and one "
+                "output tensor are expected.";
+    }
+    if (!intrinsic.nested_intrinsics.empty() ||
+        !intrinsic.parameters.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AcceleratedFederatedSumFactory: Expected no nested "
+                "intrinsics or parameters.";
+    }
+    const TensorSpec& input_spec = intrinsic.inputs[0];
+    const TensorSpec& output_spec = intrinsic.outputs[0];
+    if (input_spec.dtype() != output_spec.dtype() ||
+        input_spec.shape() != output_spec.shape()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AcceleratedFederatedSumFactory: Input and output tensors "
+                "have mismatched specs.";
+    }
+    const DataType dtype = input_spec.dtype();
+    if (dtype == DT_STRING ||
+        (kIsMean && dtype != DT_FLOAT && dtype != DT_DOUBLE)) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AcceleratedFederatedSumFactory: Unsupported input dtype "
+             << dtype << ".";
+    }
+    StatusOr<size_t> num_elements = input_spec.shape().NumElements();
+    if (!num_elements.ok()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AcceleratedFederatedSumFactory: All dimensions of the tensor "
+                "shape must be known in advance.";
+    }
+
+    TFF_ASSIGN_OR_RETURN(
+        std::unique_ptr<DenseAccumulator> accumulator,
+        GetDenseAccumulatorFactory().Create(dtype, *num_elements));
+    if (encoded_sum != nullptr) {
+      std::unique_ptr<TensorData> data;
+      NUMERICAL_ONLY_DTYPE_CASES(
+          dtype, T,
+          data = MutableVectorData<T>::CreateFromEncodedContent(*encoded_sum));
+      TFF_ASSIGN_OR_RETURN(Tensor sum, Tensor::Create(dtype, input_spec.shape(),
+                                                      std::move(data)));
+      const Tensor* inputs[] = {&sum};
+      TFF_RETURN_IF_ERROR(accumulator->AddBatch(inputs));
+    }
+    return std::make_unique<AcceleratedFederatedSum>(
+        dtype, input_spec.shape(), kIsMean, std::move(accumulator), num_inputs);
+  }
+};
+
+static auto unused_sum =
+    ::tensorflow_federated::aggregation::internal::Registrar<
+        AcceleratedFederatedSumFactory<false>>(kAcceleratedFederatedSumUri);
+static auto unused_mean =
+    ::tensorflow_federated::aggregation::internal::Registrar<
+        AcceleratedFederatedSumFactory<true>>(kAcceleratedFederatedMeanUri);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
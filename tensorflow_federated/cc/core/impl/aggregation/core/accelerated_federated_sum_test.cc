@@ -0,0 +1,227 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dense_accumulator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/federated_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+Intrinsic CreateIntrinsic(std::string uri, DataType dtype, TensorShape shape) {
+  return Intrinsic{std::move(uri),
+                   {TensorSpec{"foo", dtype, shape}},
+                   {TensorSpec{"foo_out", dtype, shape}},
+                   {},
+                   {}};
+}
+
+TEST(AcceleratedFederatedSumTest, Sum_Succeeds) {
+  auto aggregator = CreateTensorAggregator(
+                        CreateIntrinsic(kAcceleratedFederatedSumUri, DT_INT32,
+                                        {3}))
+                        .value();
+  Tensor t1 = Tensor::Create(DT_INT32, {3}, CreateTestData({1, 2, 3})).value();
+  Tensor t2 = Tensor::Create(DT_INT32, {3}, CreateTestData({4, 5, 6})).value();
+  Tensor t3 = Tensor::Create(DT_INT32, {3}, CreateTestData({7, 8, 9})).value();
+  EXPECT_THAT(aggregator->Accumulate({&t1}), IsOk());
+  InputTensorList batch[] = {InputTensorList({&t2}), InputTensorList({&t3})};
+  EXPECT_THAT(aggregator->AccumulateBatch(batch), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(3));
+  EXPECT_THAT(aggregator->GetMemoryUsage(), Eq(3 * sizeof(int32_t)));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  ASSERT_THAT(result.value().size(), Eq(1));
+  EXPECT_THAT(result.value()[0], IsTensor<int32_t>({3}, {12, 15, 18}));
+}
+
+TEST(AcceleratedFederatedSumTest, Mean_Succeeds) {
+  auto aggregator = CreateTensorAggregator(
+                        CreateIntrinsic(kAcceleratedFederatedMeanUri,
+                                        DT_FLOAT, {2}))
+                        .value();
+  Tensor t1 = Tensor::Create(DT_FLOAT, {2}, CreateTestData({1.f, 2.f})).value();
+  Tensor t2 = Tensor::Create(DT_FLOAT, {2}, CreateTestData({3.f, 6.f})).value();
+  EXPECT_THAT(aggregator->Accumulate({&t1}), IsOk());
+  EXPECT_THAT(aggregator->Accumulate({&t2}), IsOk());
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<float>({2}, {2.f, 4.f}));
+}
+
+TEST(AcceleratedFederatedSumTest, MergeWith_Succeeds) {
+  Intrinsic intrinsic =
+      CreateIntrinsic(kAcceleratedFederatedSumUri, DT_DOUBLE, {2});
+  auto aggregator1 = CreateTensorAggregator(intrinsic).value();
+  auto aggregator2 = CreateTensorAggregator(intrinsic).value();
+  Tensor t1 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData({1.0, 2.0})).value();
+  Tensor t2 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData({3.0, 4.0})).value();
+  EXPECT_THAT(aggregator1->Accumulate({&t1}), IsOk());
+  EXPECT_THAT(aggregator2->Accumulate({&t2}), IsOk());
+  EXPECT_THAT(aggregator2->Accumulate({&t2}), IsOk());
+  EXPECT_THAT(aggregator1->MergeWith(std::move(*aggregator2)), IsOk());
+  EXPECT_THAT(aggregator1->GetNumInputs(), Eq(3));
+
+  auto result = std::move(*aggregator1).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<double>({2}, {7.0, 10.0}));
+}
+
+TEST(AcceleratedFederatedSumTest, SerializeDeserialize_Succeeds) {
+  Intrinsic intrinsic =
+      CreateIntrinsic(kAcceleratedFederatedMeanUri, DT_DOUBLE, {2});
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  Tensor t1 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData({1.0, 2.0})).value();
+  Tensor t2 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData({5.0, 4.0})).value();
+  EXPECT_THAT(aggregator->Accumulate({&t1}), IsOk());
+
+  auto serialized_state = std::move(*aggregator).Serialize();
+  ASSERT_THAT(serialized_state, IsOk());
+  auto deserialized_aggregator =
+      DeserializeTensorAggregator(intrinsic, serialized_state.value()).value();
+  EXPECT_THAT(deserialized_aggregator->Accumulate({&t2}), IsOk());
+  EXPECT_THAT(deserialized_aggregator->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*deserialized_aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<double>({2}, {3.0, 3.0}));
+}
+
+TEST(AcceleratedFederatedSumTest, SparseInput_Fails) {
+  auto aggregator = CreateTensorAggregator(
+                        CreateIntrinsic(kAcceleratedFederatedSumUri, DT_FLOAT,
+                                        {4}))
+                        .value();
+  Tensor t = Tensor::CreateSparse(DT_FLOAT, {4}, CreateTestData({1.f}),
+                                  CreateTestData<int64_t>({2}))
+                 .value();
+  EXPECT_THAT(aggregator->Accumulate({&t}),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("dense")));
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(0));
+}
+
+TEST(AcceleratedFederatedSumTest, CreateWithInvalidSpec_Fails) {
+  EXPECT_THAT(CreateTensorAggregator(CreateIntrinsic(
+                  kAcceleratedFederatedMeanUri, DT_INT32, {2})),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("dtype")));
+  EXPECT_THAT(CreateTensorAggregator(CreateIntrinsic(
+                  kAcceleratedFederatedSumUri, DT_STRING, {2})),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("dtype")));
+  EXPECT_THAT(CreateTensorAggregator(CreateIntrinsic(
+                  kAcceleratedFederatedSumUri, DT_FLOAT, {-1})),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("known in advance")));
+}
+
+// Backend that delegates to the host one and counts the calls it gets.
+class CountingAccumulatorFactory final : public DenseAccumulatorFactory {
+ public:
+  StatusOr<std::unique_ptr<DenseAccumulator>> Create(
+      DataType dtype, size_t num_elements) const override {
+    TFF_ASSIGN_OR_RETURN(
+        std::unique_ptr<DenseAccumulator> accumulator,
+        GetHostDenseAccumulatorFactory().Create(dtype, num_elements));
+    return std::make_unique<CountingAccumulator>(
+        std::move(accumulator), const_cast<CountingAccumulatorFactory*>(this));
+  }
+
+  int num_batches = 0;
+  int num_sums_taken = 0;
+
+ private:
+  class CountingAccumulator final : public DenseAccumulator {
+   public:
+    CountingAccumulator(std::unique_ptr<DenseAccumulator> accumulator,
+                        CountingAccumulatorFactory* factory)
+        : accumulator_(std::move(accumulator)), factory_(factory) {}
+
+    Status AddBatch(absl::Span<const Tensor* const> inputs) override {
+      factory_->num_batches++;
+      return accumulator_->AddBatch(inputs);
+    }
+
+    StatusOr<std::unique_ptr<TensorData>> TakeSum() && override {
+      factory_->num_sums_taken++;
+      return std::move(*accumulator_).TakeSum();
+    }
+
+    size_t GetMemoryUsage() const override {
+      return accumulator_->GetMemoryUsage();
+    }
+
+   private:
+    std::unique_ptr<DenseAccumulator> accumulator_;
+    CountingAccumulatorFactory* factory_;
+  };
+};
+
+TEST(AcceleratedFederatedSumTest, UsesDenseAccumulatorFactory) {
+  CountingAccumulatorFactory factory;
+  SetDenseAccumulatorFactory(&factory);
+  auto aggregator = CreateTensorAggregator(
+                        CreateIntrinsic(kAcceleratedFederatedSumUri, DT_INT64,
+                                        {2}))
+                        .value();
+  SetDenseAccumulatorFactory(nullptr);
+
+  Tensor t = Tensor::Create(DT_INT64, {2}, CreateTestData<int64_t>({1, 2}))
+                 .value();
+  InputTensorList batch[] = {InputTensorList({&t}), InputTensorList({&t}),
+                             InputTensorList({&t})};
+  EXPECT_THAT(aggregator->AccumulateBatch(batch), IsOk());
+  EXPECT_THAT(aggregator->Accumulate({&t}), IsOk());
+  EXPECT_THAT(factory.num_batches, Eq(2));
+  EXPECT_THAT(factory.num_sums_taken, Eq(0));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<int64_t>({2}, {4, 8}));
+  EXPECT_THAT(factory.num_sums_taken, Eq(1));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -18,7 +18,10 @@
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_AGG_VECTOR_H_
 
 #include <cstddef>
+#include <cstdint>
 
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_iterator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
 
@@ -28,7 +31,7 @@ namespace aggregation {
 // AggVector is flattened one-dimensional strongly typed view of tensor that
 // provides immutable access to the values.
 //
-// AggVector hides the actual data organization of the tensor. The only
+// AggVector hides the actual data organization of the tensor. The generic
 // way to access the tensor values is through the iterator that returns
 // {index, value} pairs where each index is the dense index corresponding to
 // the value.
@@ -42,6 +45,12 @@ namespace aggregation {
 //   }
 // }
 //
+// When the values are stored densely, they can also be accessed as a
+// contiguous span with dense_values(), which lets aggregation loops run over
+// plain arrays that the compiler can vectorize. Sparse AggVectors only iterate
+// over the values that are stored, which are the non-zero ones, and
+// ForEachRun() gives access to their ranges of consecutive indices as spans.
+//
 template <typename T>
 class AggVector final {
  public:
@@ -49,24 +58,68 @@ class AggVector final {
   using const_iterator = AggVectorIterator<T>;
 
   // Iterator begin() function.
-  const_iterator begin() const { return AggVectorIterator<T>(data_); }
+  const_iterator begin() const {
+    return AggVectorIterator<T>(data_, indices_);
+  }
 
   // Iterator end() function.
   const_iterator end() const { return AggVectorIterator<T>::end(); }
 
-  // Entire AggVector length.
+  // Entire AggVector length, including the values that aren't stored in a
+  // sparse AggVector.
   size_t size() const { return size_; }
 
+  // Returns true if the values are stored contiguously, with the value at dense
+  // index i at position i.
+  bool is_dense() const { return indices_ == nullptr; }
+
+  // Provides access to the values of a dense AggVector as a span, in dense
+  // index order. Must only be called when is_dense() is true.
+  absl::Span<const T> dense_values() const {
+    TFF_CHECK(is_dense()) << "dense_values() called on a sparse AggVector";
+    return absl::Span<const T>(static_cast<const T*>(data_->data()), size_);
+  }
+
+  // Calls `fn(start_index, values)` for each run of values stored at
+  // consecutive dense indices, where `values` holds the values at dense indices
+  // [start_index, start_index + values.size()). A dense AggVector is a single
+  // run, and the runs of a sparse AggVector are its maximal ranges of
+  // consecutive indices. The values of a run are contiguous, so `fn` can
+  // process them with a plain loop instead of going through the iterator.
+  template <typename F>
+  void ForEachRun(F fn) const {
+    const T* values = static_cast<const T*>(data_->data());
+    if (is_dense()) {
+      if (size_ > 0) {
+        fn(size_t{0}, absl::Span<const T>(values, size_));
+      }
+      return;
+    }
+    const int64_t* indices = static_cast<const int64_t*>(indices_->data());
+    const size_t num_values = indices_->byte_size() / sizeof(int64_t);
+    size_t run_start = 0;
+    for (size_t i = 1; i <= num_values; ++i) {
+      if (i == num_values || indices[i] != indices[i - 1] + 1) {
+        fn(static_cast<size_t>(indices[run_start]),
+           absl::Span<const T>(values + run_start, i - run_start));
+        run_start = i;
+      }
+    }
+  }
+
  private:
   // AggVector can be created only by Tensor::AsAggVector() method.
   friend class Tensor;
-  explicit AggVector(const TensorData* data)
-      : size_(data->byte_size() / sizeof(T)), data_(data) {}
+  AggVector(const TensorData* data, size_t size, const TensorData* indices)
+      : size_(size), data_(data), indices_(indices) {}
 
   // The total length of the vector (in elements).
   size_t size_;
   // Tensor data, owned by the tensor object.
   const TensorData* data_;
+  // Dense indices of the values of a sparse tensor, owned by the tensor
+  // object, or null if the tensor is dense.
+  const TensorData* indices_;
 };
 
 }  // namespace aggregation
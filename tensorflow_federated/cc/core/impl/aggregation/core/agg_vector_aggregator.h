@@ -17,16 +17,24 @@
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_AGG_VECTOR_AGGREGATOR_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_AGG_VECTOR_AGGREGATOR_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/buffer_pool.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
@@ -34,6 +42,7 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_data_delta.h"
 
 namespace tensorflow_federated {
 namespace aggregation {
@@ -62,25 +71,96 @@ class AggVectorAggregator : public TensorAggregator {
 
   int GetNumInputs() const override { return num_inputs_; }
 
+  size_t GetMemoryUsage() const override {
+    return data_vector_ == nullptr ? 0 : data_vector_->byte_size();
+  }
+
+  // Default number of elements in each chunk of a parallel aggregation. The
+  // chunk of input and the matching part of the aggregated data take a few
+  // hundred KB, which stays within a per-core cache.
+  static constexpr size_t kDefaultParallelChunkSize = 1 << 15;
+
+  // Enables parallel aggregation of large dense inputs by the derived classes
+  // that aggregate through ForEachDenseChunk. Inputs with more than
+  // `chunk_size` elements are split into chunks of `chunk_size` elements that
+  // are aggregated by up to `num_tasks` tasks, including the calling thread,
+  // with all tasks but one scheduled on `scheduler`. Accumulate and MergeWith
+  // still return only once the whole input has been aggregated.
+  //
+  // Each element of the aggregated data is updated by exactly one chunk, in
+  // the same order as without parallelism, so the results are identical.
+  // `scheduler` must outlive this aggregator. Passing a null scheduler or
+  // `num_tasks` <= 1 disables parallel aggregation.
+  void SetParallelAggregation(Scheduler* scheduler, int num_tasks,
+                              size_t chunk_size = kDefaultParallelChunkSize) {
+    TFF_CHECK(chunk_size > 0) << "chunk_size must be positive";
+    scheduler_ = num_tasks > 1 ? scheduler : nullptr;
+    num_parallel_tasks_ = num_tasks;
+    parallel_chunk_size_ = chunk_size;
+  }
+
   Status MergeWith(TensorAggregator&& other) override {
+    TensorAggregator* others[] = {&other};
+    return MergeWithAll(others);
+  }
+
+  // Merges all `others` with a single AggregateVectors call, so derived
+  // classes can combine them in one pass over the data. Nothing is merged if
+  // any of them isn't an AggVectorAggregator of the same dtype and shape.
+  //
+  // If the initial data is an identity of the aggregation, see
+  // InitialDataIsIdentity, aggregators without inputs are skipped, and if this
+  // aggregator has no inputs yet it takes over the data of the first other
+  // aggregator with inputs instead of aggregating it.
+  Status MergeWithAll(absl::Span<TensorAggregator* const> others) override {
     TFF_RETURN_IF_ERROR(CheckValid());
-    TFF_ASSIGN_OR_RETURN(AggVectorAggregator<T> * other_ptr, CastOther(other));
-    TFF_RETURN_IF_ERROR((*other_ptr).CheckValid());
-    int64_t other_num_inputs = other.GetNumInputs();
-    OutputTensorList output_tensors = std::move(*other_ptr).TakeOutputs();
-    TFF_CHECK(output_tensors.size() == 1)
-        << "AggVectorAggregator::MergeOutputTensors: AggVectorAggregator "
-           "should produce a single output tensor";
-    const Tensor& output = output_tensors[0];
-    if (output.shape() != shape_) {
-      return TFF_STATUS(INVALID_ARGUMENT)
-             << "AggVectorAggregator::MergeOutputTensors: tensor shape "
-                "mismatch";
+    std::vector<AggVectorAggregator<T>*> other_ptrs;
+    other_ptrs.reserve(others.size());
+    for (TensorAggregator* other : others) {
+      TFF_ASSIGN_OR_RETURN(AggVectorAggregator<T> * other_ptr,
+                           CastOther(*other));
+      TFF_RETURN_IF_ERROR(other_ptr->CheckValid());
+      if (other_ptr->shape_ != shape_) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "AggVectorAggregator::MergeOutputTensors: tensor shape "
+                  "mismatch";
+      }
+      other_ptrs.push_back(other_ptr);
+    }
+
+    const bool initial_data_is_identity = InitialDataIsIdentity();
+    std::vector<Tensor> tensors;
+    tensors.reserve(other_ptrs.size());
+    bool changed = false;
+    for (AggVectorAggregator<T>* other_ptr : other_ptrs) {
+      const int other_num_inputs = other_ptr->GetNumInputs();
+      std::unique_ptr<MutableVectorData<T>> other_data =
+          std::move(other_ptr->data_vector_);
+      if (initial_data_is_identity && other_num_inputs == 0) {
+        continue;
+      }
+      if (initial_data_is_identity && num_inputs_ == 0 && !changed) {
+        data_vector_ = std::move(other_data);
+      } else {
+        tensors.push_back(
+            Tensor::Create(dtype_, shape_, std::move(other_data)).value());
+      }
+      num_inputs_ += other_num_inputs;
+      changed = true;
+    }
+    if (!tensors.empty()) {
+      std::vector<AggVector<T>> agg_vectors;
+      agg_vectors.reserve(tensors.size());
+      for (const Tensor& tensor : tensors) {
+        agg_vectors.push_back(tensor.AsAggVector<T>());
+      }
+      // Delegate the actual aggregation to the specific aggregation
+      // intrinsic implementation.
+      AggregateVectors(agg_vectors);
+    }
+    if (changed) {
+      MarkAllChanged();
     }
-    // Delegate the actual aggregation to the specific aggregation
-    // intrinsic implementation.
-    AggregateVector(output.AsAggVector<T>());
-    num_inputs_ += other_num_inputs;
     return TFF_STATUS(OK);
   }
 
@@ -91,24 +171,84 @@ class AggVectorAggregator : public TensorAggregator {
     return aggregator_state.SerializeAsString();
   }
 
+  // Returns a serialized AggVectorAggregatorDelta with the changes to the state
+  // of this aggregator since the previous call, without consuming it. The
+  // first call returns the whole state. The serialized state at the time of
+  // any call can be recovered by compacting the preceding deltas with
+  // CompactAggVectorAggregatorState, and then restored with the Deserialize
+  // method of the aggregator factory.
+  //
+  // Changes are tracked at the granularity of `chunk_size` elements from the
+  // first call on, which must use the same `chunk_size` as the following ones.
+  // Dense inputs and merged aggregators change all the elements, while sparse
+  // inputs only change the chunks that contain their indices.
+  StatusOr<std::string> SerializeDelta(
+      size_t chunk_size = VectorDataChangeTracker::kDefaultChunkSize) {
+    TFF_RETURN_IF_ERROR(CheckValid());
+    if (!change_tracker_.has_value()) {
+      change_tracker_.emplace(chunk_size);
+    }
+    AggVectorAggregatorDelta delta;
+    delta.set_num_inputs(num_inputs_);
+    *delta.mutable_vector_data() = change_tracker_->TakeDelta(*data_vector_);
+    return delta.SerializeAsString();
+  }
+
  protected:
   // Implementation of the tensor aggregation.
   Status AggregateTensors(InputTensorList tensors) override {
-    TFF_CHECK(tensors.size() == 1)
-        << "AggVectorAggregator should operate on a single input tensor";
+    // Delegate the actual aggregation to the specific aggregation
+    // intrinsic implementation.
+    return AggregateTensorsOf<T>(std::move(tensors),
+                                 [this](const AggVector<T>& agg_vector) {
+                                   AggregateVector(agg_vector);
+                                 });
+  }
 
-    const Tensor* tensor = tensors[0];
-    if (tensor->dtype() != internal::TypeTraits<T>::kDataType) {
-      return TFF_STATUS(INVALID_ARGUMENT)
-             << "AggVectorAggregator::AggregateTensors: dtype mismatch";
+  // Validates all inputs of `batch` before aggregating any of them, so that
+  // nothing is aggregated if any input is invalid. Consecutive dense inputs
+  // are passed to a single AggregateVectors call, so derived classes can add
+  // them in one pass over the data, and sparse inputs to AggregateVector in
+  // turn. The inputs are aggregated in order either way.
+  Status AggregateTensorBatch(
+      absl::Span<const InputTensorList> batch) override {
+    for (const InputTensorList& tensors : batch) {
+      TFF_RETURN_IF_ERROR(CheckInput<T>(tensors));
     }
-    if (tensor->shape() != shape_) {
-      return TFF_STATUS(INVALID_ARGUMENT)
-             << "AggVectorAggregator::AggregateTensors: tensor shape mismatch";
+    std::vector<AggVector<T>> dense_vectors;
+    auto aggregate_dense_vectors = [this, &dense_vectors]() {
+      if (dense_vectors.size() == 1) {
+        AggregateVector(dense_vectors[0]);
+      } else if (!dense_vectors.empty()) {
+        AggregateVectors(dense_vectors);
+      }
+      dense_vectors.clear();
+    };
+    for (const InputTensorList& tensors : batch) {
+      AggVector<T> agg_vector = tensors[0]->AsAggVector<T>();
+      MarkChanged(agg_vector);
+      if (agg_vector.is_dense()) {
+        dense_vectors.push_back(std::move(agg_vector));
+        continue;
+      }
+      aggregate_dense_vectors();
+      AggregateVector(agg_vector);
     }
-    // Delegate the actual aggregation to the specific aggregation
-    // intrinsic implementation.
-    AggregateVector(tensor->AsAggVector<T>());
+    aggregate_dense_vectors();
+    num_inputs_ += batch.size();
+    return TFF_STATUS(OK);
+  }
+
+  // Validates and counts the single input tensor of `tensors` as
+  // AggregateTensors does, but for inputs of type `InputT`, which derived
+  // classes may accept instead of `T`, e.g. narrow integers accumulated in a
+  // wider type. `aggregate` is called with the AggVector<InputT> of the input.
+  template <typename InputT, typename F>
+  Status AggregateTensorsOf(InputTensorList tensors, F aggregate) {
+    TFF_RETURN_IF_ERROR(CheckInput<InputT>(tensors));
+    AggVector<InputT> agg_vector = tensors[0]->AsAggVector<InputT>();
+    aggregate(agg_vector);
+    MarkChanged(agg_vector);
     num_inputs_++;
     return TFF_STATUS(OK);
   }
@@ -132,13 +272,114 @@ class AggVectorAggregator : public TensorAggregator {
   // Delegates AggVector aggregation to a derived class.
   virtual void AggregateVector(const AggVector<T>& agg_vector) = 0;
 
+  // Aggregates all `agg_vectors`, which are dense and either merged from other
+  // aggregators or accumulated as a batch, in order. Derived classes may
+  // override this to aggregate them in a single pass over the data; by default
+  // each one is passed to AggregateVector in turn.
+  virtual void AggregateVectors(absl::Span<const AggVector<T>> agg_vectors) {
+    for (const AggVector<T>& agg_vector : agg_vectors) {
+      AggregateVector(agg_vector);
+    }
+  }
+
+  // Derived classes return true if the initial data is an identity of their
+  // aggregation, e.g. zeros for a sum: aggregating a vector into the initial
+  // data then produces that vector, and aggregating the initial data changes
+  // nothing. MergeWithAll uses this to skip work, see its comment.
+  virtual bool InitialDataIsIdentity() const { return false; }
+
+  // Calls `fn(values, offset)` for consecutive chunks of the values of the
+  // dense `agg_vector`, where `values` holds the values at dense indices
+  // [offset, offset + values.size()). When parallel aggregation is enabled
+  // with SetParallelAggregation, chunks are processed concurrently, so `fn`
+  // must only update the elements of data() at the indices of its chunk.
+  // Otherwise `fn` is called once for the whole vector.
+  template <typename F>
+  void ForEachDenseChunk(const AggVector<T>& agg_vector, F fn) {
+    TFF_CHECK(agg_vector.is_dense());
+    absl::Span<const T> values = agg_vector.dense_values();
+    if (scheduler_ == nullptr || values.size() <= parallel_chunk_size_) {
+      fn(values, 0);
+      return;
+    }
+    const size_t chunk_size = parallel_chunk_size_;
+    auto state = std::make_shared<ParallelChunksState>(
+        (values.size() + chunk_size - 1) / chunk_size);
+    // Each task claims chunks until none are left. Tasks that start after all
+    // chunks have been claimed return without accessing `values` or `fn`, so
+    // the calling thread only has to wait for the chunks to be done.
+    auto run_chunks = [state, values, chunk_size, fn]() {
+      for (size_t chunk = state->next_chunk++; chunk < state->num_chunks;
+           chunk = state->next_chunk++) {
+        const size_t offset = chunk * chunk_size;
+        fn(values.subspan(offset, chunk_size), offset);
+        absl::MutexLock lock(&state->mu);
+        state->num_pending--;
+      }
+    };
+    const size_t num_scheduled = std::min<size_t>(num_parallel_tasks_ - 1,
+                                                  state->num_chunks - 1);
+    for (size_t i = 0; i < num_scheduled; ++i) {
+      scheduler_->Schedule(run_chunks);
+    }
+    // The calling thread works on chunks too, which guarantees progress even
+    // if all scheduler threads are busy.
+    run_chunks();
+    absl::MutexLock lock(&state->mu);
+    state->mu.Await(absl::Condition(
+        +[](size_t* num_pending) { return *num_pending == 0; },
+        &state->num_pending));
+  }
+
  private:
   static std::unique_ptr<MutableVectorData<T>> CreateData(
       const TensorShape& shape) {
     StatusOr<size_t> num_elements = shape.NumElements();
     TFF_CHECK(num_elements.ok()) << "AggVectorAggregator: All dimensions of "
                                     "tensor shape must be known in advance.";
-    return std::make_unique<MutableVectorData<T>>(num_elements.value());
+    // Drawn from the default buffer pool, if any, so that the data of the
+    // aggregators of successive rounds reuses the same memory.
+    return CreateVectorData<T>(num_elements.value());
+  }
+
+  // Checks that `tensors` holds a single tensor of type `InputT` and of the
+  // shape of the aggregated data.
+  template <typename InputT>
+  Status CheckInput(const InputTensorList& tensors) const {
+    TFF_CHECK(tensors.size() == 1)
+        << "AggVectorAggregator should operate on a single input tensor";
+
+    const Tensor* tensor = tensors[0];
+    if (tensor->dtype() != internal::TypeTraits<InputT>::kDataType) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AggVectorAggregator::AggregateTensors: dtype mismatch";
+    }
+    if (tensor->shape() != shape_) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "AggVectorAggregator::AggregateTensors: tensor shape mismatch";
+    }
+    return TFF_STATUS(OK);
+  }
+
+  void MarkAllChanged() {
+    if (change_tracker_.has_value()) {
+      change_tracker_->MarkAllChanged();
+    }
+  }
+
+  // Marks the elements at the indices of `agg_vector` as changed.
+  template <typename InputT>
+  void MarkChanged(const AggVector<InputT>& agg_vector) {
+    if (!change_tracker_.has_value()) {
+      return;
+    }
+    if (agg_vector.is_dense()) {
+      change_tracker_->MarkAllChanged();
+      return;
+    }
+    for (auto [index, value] : agg_vector) {
+      change_tracker_->MarkChanged(index);
+    }
   }
 
   StatusOr<AggVectorAggregator<T>*> CastOther(TensorAggregator& other) {
@@ -153,10 +394,27 @@ class AggVectorAggregator : public TensorAggregator {
     return other_ptr;
   }
 
+  // State shared by the tasks of a parallel ForEachDenseChunk call.
+  struct ParallelChunksState {
+    explicit ParallelChunksState(size_t num_chunks)
+        : num_chunks(num_chunks), num_pending(num_chunks) {}
+
+    const size_t num_chunks;
+    std::atomic<size_t> next_chunk = 0;
+    absl::Mutex mu;
+    size_t num_pending ABSL_GUARDED_BY(mu);
+  };
+
   const DataType dtype_;
   const TensorShape shape_;
   std::unique_ptr<MutableVectorData<T>> data_vector_;
   int num_inputs_;
+  // Parallel aggregation settings, see SetParallelAggregation.
+  Scheduler* scheduler_ = nullptr;
+  int num_parallel_tasks_ = 1;
+  size_t parallel_chunk_size_ = kDefaultParallelChunkSize;
+  // Tracks the changes since the last SerializeDelta call, if any.
+  std::optional<VectorDataChangeTracker> change_tracker_;
 };
 
 }  // namespace aggregation
@@ -16,20 +16,26 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_aggregator.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_data_delta.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
@@ -38,6 +44,7 @@ namespace tensorflow_federated {
 namespace aggregation {
 namespace {
 
+using ::testing::ElementsAreArray;
 using ::testing::Eq;
 using testing::IsFalse;
 using testing::IsTrue;
@@ -57,6 +64,33 @@ class SumAggregator final : public AggVectorAggregator<T> {
   }
 };
 
+// A Sum Aggregator that aggregates dense values in chunks.
+template <typename T>
+class ChunkedSumAggregator final : public AggVectorAggregator<T> {
+ public:
+  using AggVectorAggregator<T>::AggVectorAggregator;
+  using AggVectorAggregator<T>::data;
+
+ private:
+  void AggregateVector(const AggVector<T>& agg_vector) override {
+    T* sum = data().data();
+    this->ForEachDenseChunk(
+        agg_vector, [sum](absl::Span<const T> values, size_t offset) {
+          for (size_t i = 0; i < values.size(); ++i) {
+            sum[offset + i] += values[i];
+          }
+        });
+  }
+};
+
+Tensor CreateSequenceTensor(int64_t size, int64_t start) {
+  auto data = std::make_unique<MutableVectorData<int64_t>>(size);
+  for (int64_t i = 0; i < size; ++i) {
+    (*data)[i] = start + i;
+  }
+  return Tensor::Create(DT_INT64, {size}, std::move(data)).value();
+}
+
 TEST(AggVectorAggregatorTest, ScalarAggregation_Succeeds) {
   SumAggregator<int32_t> aggregator(DT_INT32, {});
   Tensor t1 = Tensor::Create(DT_INT32, {}, CreateTestData({1})).value();
@@ -198,6 +232,80 @@ TEST(AggVectorAggregatorTest, Serialization_Succeeds) {
   EXPECT_EQ(data, std::vector<int32_t>({14, 19, 23, 49}));
 }
 
+TEST(AggVectorAggregatorTest, SerializeDelta_Succeeds) {
+  const TensorShape shape = {4};
+  SumAggregator<int32_t> aggregator(DT_INT32, shape);
+  Tensor t1 =
+      Tensor::Create(DT_INT32, shape, CreateTestData({1, 3, 15, 27})).value();
+  Tensor t2 =
+      Tensor::Create(DT_INT32, shape, CreateTestData({10, 5, 1, 2})).value();
+  std::vector<std::string> deltas;
+  EXPECT_THAT(aggregator.Accumulate(t1), IsOk());
+  deltas.push_back(aggregator.SerializeDelta().value());
+  EXPECT_THAT(aggregator.Accumulate(t2), IsOk());
+  deltas.push_back(aggregator.SerializeDelta().value());
+  // Nothing has changed since the previous delta.
+  std::string empty_delta = aggregator.SerializeDelta().value();
+  AggVectorAggregatorDelta delta;
+  ASSERT_TRUE(delta.ParseFromString(empty_delta));
+  EXPECT_THAT(delta.vector_data().chunks_size(), Eq(0));
+  deltas.push_back(empty_delta);
+
+  // The aggregator can still be used after serializing deltas.
+  EXPECT_THAT(aggregator.GetNumInputs(), Eq(2));
+  auto serialized_state = CompactAggVectorAggregatorState("", deltas);
+  ASSERT_THAT(serialized_state, IsOk());
+  EXPECT_EQ(*serialized_state, std::move(aggregator).Serialize().value());
+}
+
+TEST(AggVectorAggregatorTest, SerializeDelta_FailsAfterBeingConsumed) {
+  SumAggregator<int32_t> aggregator(DT_INT32, {});
+  EXPECT_THAT(std::move(aggregator).Report(), IsOk());
+  EXPECT_THAT(aggregator.SerializeDelta(),  // NOLINT
+              StatusIs(FAILED_PRECONDITION));
+}
+
+TEST(AggVectorAggregatorTest, ParallelAggregation_Succeeds) {
+  constexpr int64_t kSize = 1001;
+  std::unique_ptr<Scheduler> scheduler = CreateThreadPoolScheduler(4);
+  ChunkedSumAggregator<int64_t> aggregator(DT_INT64, {kSize});
+  // The last chunk is shorter than the others.
+  aggregator.SetParallelAggregation(scheduler.get(), /*num_tasks=*/4,
+                                    /*chunk_size=*/10);
+  Tensor t1 = CreateSequenceTensor(kSize, 0);
+  Tensor t2 = CreateSequenceTensor(kSize, 7);
+  EXPECT_THAT(aggregator.Accumulate(t1), IsOk());
+  EXPECT_THAT(aggregator.Accumulate(t2), IsOk());
+
+  ChunkedSumAggregator<int64_t> other(DT_INT64, {kSize});
+  Tensor t3 = CreateSequenceTensor(kSize, -3);
+  EXPECT_THAT(other.Accumulate(t3), IsOk());
+  EXPECT_THAT(aggregator.MergeWith(std::move(other)), IsOk());
+  EXPECT_THAT(aggregator.GetNumInputs(), Eq(3));
+
+  auto result = std::move(aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value().size(), Eq(1));
+  std::vector<int64_t> expected(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    expected[i] = 3 * i + 4;
+  }
+  EXPECT_THAT(result.value()[0].AsSpan<int64_t>(), ElementsAreArray(expected));
+  scheduler->WaitUntilIdle();
+}
+
+TEST(AggVectorAggregatorTest, ParallelAggregation_SmallInputNotSplit) {
+  std::unique_ptr<Scheduler> scheduler = CreateThreadPoolScheduler(2);
+  ChunkedSumAggregator<int64_t> aggregator(DT_INT64, {4});
+  aggregator.SetParallelAggregation(scheduler.get(), /*num_tasks=*/2);
+  Tensor t1 = CreateSequenceTensor(4, 1);
+  EXPECT_THAT(aggregator.Accumulate(t1), IsOk());
+  auto result = std::move(aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<int64_t>({4}, {1, 2, 3, 4}));
+  scheduler->WaitUntilIdle();
+}
+
 }  // namespace
 }  // namespace aggregation
 }  // namespace tensorflow_federated
@@ -18,6 +18,7 @@
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_AGG_VECTOR_ITERATOR_H_
 
 #include <cstddef>
+#include <cstdint>
 
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
@@ -51,8 +52,13 @@ struct AggVectorIterator {
   using pointer = value_type*;
   using reference = value_type&;
 
-  explicit AggVectorIterator(const TensorData* data)
-      : AggVectorIterator(get_start_ptr(data), get_end_ptr(data), 0) {}
+  // Creates an iterator over the values of `data`. For sparse data, `indices`
+  // holds the int64 dense index of each value; otherwise it must be null and
+  // the dense index of each value is its position in `data`.
+  explicit AggVectorIterator(const TensorData* data,
+                             const TensorData* indices = nullptr)
+      : AggVectorIterator(get_start_ptr(data), get_end_ptr(data),
+                          get_index_ptr(indices)) {}
 
   // Current dense index corresponding to the current value.
   size_t index() const { return dense_index; }
@@ -66,6 +72,8 @@ struct AggVectorIterator {
     TFF_CHECK(ptr != end_ptr);
     if (++ptr == end_ptr) {
       *this = end();
+    } else if (index_ptr != nullptr) {
+      dense_index = static_cast<size_t>(*++index_ptr);
     } else {
       dense_index++;
     }
@@ -89,12 +97,21 @@ struct AggVectorIterator {
   }
 
   static AggVectorIterator end() {
-    return AggVectorIterator(nullptr, nullptr, 0);
+    return AggVectorIterator(nullptr, nullptr, nullptr);
   }
 
  private:
-  AggVectorIterator(const T* ptr, const T* end_ptr, size_t dense_index)
-      : ptr(ptr), end_ptr(end_ptr), dense_index(dense_index) {}
+  AggVectorIterator(const T* ptr, const T* end_ptr, const int64_t* index_ptr)
+      : ptr(ptr), end_ptr(end_ptr), index_ptr(index_ptr), dense_index(0) {
+    if (ptr == end_ptr) {
+      // There are no values, so this iterator is already at the end.
+      this->ptr = nullptr;
+      this->end_ptr = nullptr;
+      this->index_ptr = nullptr;
+    } else if (index_ptr != nullptr) {
+      dense_index = static_cast<size_t>(*index_ptr);
+    }
+  }
 
   static const T* get_start_ptr(const TensorData* data) {
     return static_cast<const T*>(data->data());
@@ -104,8 +121,16 @@ struct AggVectorIterator {
     return get_start_ptr(data) + data->byte_size() / sizeof(T);
   }
 
+  static const int64_t* get_index_ptr(const TensorData* indices) {
+    return indices == nullptr ? nullptr
+                              : static_cast<const int64_t*>(indices->data());
+  }
+
   const T* ptr;
   const T* end_ptr;
+  // Pointer to the dense index of the current value for sparse data, or null
+  // for dense data.
+  const int64_t* index_ptr;
   size_t dense_index;
 };
 
@@ -17,9 +17,13 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 
 #include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_iterator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
@@ -76,6 +80,54 @@ TEST(AggVectorTest, PreIncrementIterator) {
   EXPECT_THAT(sum, Eq(14));
 }
 
+TEST(AggVectorTest, DenseValues) {
+  auto t = Tensor::Create(DT_FLOAT, {4}, CreateTestData<float>({2, 3, 4, 5}));
+  auto agg_vector = t->AsAggVector<float>();
+  ASSERT_TRUE(agg_vector.is_dense());
+  EXPECT_THAT(agg_vector.dense_values(), ElementsAre(2, 3, 4, 5));
+}
+
+TEST(AggVectorTest, SparseTensor) {
+  auto t = Tensor::CreateSparse(DT_INT32, {6}, CreateTestData({3, 14}),
+                                CreateTestData<int64_t>({1, 4}));
+  auto agg_vector = t->AsAggVector<int>();
+  EXPECT_FALSE(agg_vector.is_dense());
+  EXPECT_EQ(agg_vector.size(), 6);
+  EXPECT_THAT(agg_vector, ElementsAre(Pair<int>{1, 3}, Pair<int>{4, 14}));
+}
+
+TEST(AggVectorTest, SparseTensor_NoValues) {
+  auto t = Tensor::CreateSparse(DT_INT32, {6}, CreateTestData<int>({}),
+                                CreateTestData<int64_t>({}));
+  auto agg_vector = t->AsAggVector<int>();
+  EXPECT_TRUE(agg_vector.begin() == agg_vector.end());
+}
+
+TEST(AggVectorTest, ForEachRun_DenseTensor) {
+  auto t = Tensor::Create(DT_INT32, {3}, CreateTestData({3, 14, 15}));
+  std::vector<std::pair<size_t, std::vector<int>>> runs;
+  t->AsAggVector<int>().ForEachRun(
+      [&runs](size_t start_index, absl::Span<const int> values) {
+        runs.emplace_back(start_index,
+                          std::vector<int>(values.begin(), values.end()));
+      });
+  EXPECT_THAT(runs, ElementsAre(::testing::Pair(0, ElementsAre(3, 14, 15))));
+}
+
+TEST(AggVectorTest, ForEachRun_SparseTensor) {
+  auto t = Tensor::CreateSparse(DT_INT32, {8}, CreateTestData({1, 2, 3, 4}),
+                                CreateTestData<int64_t>({1, 2, 5, 7}));
+  std::vector<std::pair<size_t, std::vector<int>>> runs;
+  t->AsAggVector<int>().ForEachRun(
+      [&runs](size_t start_index, absl::Span<const int> values) {
+        runs.emplace_back(start_index,
+                          std::vector<int>(values.begin(), values.end()));
+      });
+  EXPECT_THAT(runs, ElementsAre(::testing::Pair(1, ElementsAre(1, 2)),
+                                ::testing::Pair(5, ElementsAre(3)),
+                                ::testing::Pair(7, ElementsAre(4))));
+}
+
 }  // namespace
 }  // namespace aggregation
 }  // namespace tensorflow_federated
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_BINARY_ENCODING_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_BINARY_ENCODING_H_
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+#include "absl/strings/string_view.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace internal {
+
+// Helpers for binary snapshots of aggregation state, which hold the bytes of
+// trivially copyable values and arrays in native byte order, so that they are
+// written and restored with a memcpy.
+
+template <typename T>
+void AppendValue(std::string& output, T value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  output.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void AppendArray(std::string& output, const T* values, size_t size) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  output.append(reinterpret_cast<const char*>(values), size * sizeof(T));
+}
+
+// Reads a value of type T from the front of `input`, and advances `input`.
+template <typename T>
+bool ReadValue(absl::string_view& input, T& value) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  if (input.size() < sizeof(T)) return false;
+  std::memcpy(&value, input.data(), sizeof(T));
+  input.remove_prefix(sizeof(T));
+  return true;
+}
+
+// Reads `size` values of type T from the front of `input` into `values`, and
+// advances `input`.
+template <typename T>
+bool ReadArray(absl::string_view& input, T* values, size_t size) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  if (input.size() / sizeof(T) < size) return false;
+  if (size > 0) std::memcpy(values, input.data(), size * sizeof(T));
+  input.remove_prefix(size * sizeof(T));
+  return true;
+}
+
+}  // namespace internal
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_BINARY_ENCODING_H_
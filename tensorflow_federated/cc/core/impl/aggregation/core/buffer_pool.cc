@@ -0,0 +1,139 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/buffer_pool.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <typeindex>
+#include <utility>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+namespace {
+
+// The size of a transparent huge page.
+constexpr uintptr_t kHugePageSize = uintptr_t{1} << 21;
+
+// The default pool, which is never destroyed so that data outliving static
+// destruction can still return its storage.
+struct DefaultPool {
+  absl::Mutex mutex;
+  std::shared_ptr<BufferPool> pool ABSL_GUARDED_BY(mutex);
+};
+
+DefaultPool* GetDefaultPool() {
+  static DefaultPool* default_pool = new DefaultPool();
+  return default_pool;
+}
+
+}  // namespace
+
+std::shared_ptr<BufferPool> BufferPool::Create(Options options) {
+  // The constructor is private, so the pool can't be created by make_shared.
+  return std::shared_ptr<BufferPool>(new BufferPool(options));
+}
+
+void BufferPool::SetDefault(std::shared_ptr<BufferPool> pool) {
+  DefaultPool* default_pool = GetDefaultPool();
+  absl::MutexLock lock(&default_pool->mutex);
+  default_pool->pool.swap(pool);
+}
+
+std::shared_ptr<BufferPool> BufferPool::GetDefault() {
+  DefaultPool* default_pool = GetDefaultPool();
+  absl::ReaderMutexLock lock(&default_pool->mutex);
+  return default_pool->pool;
+}
+
+size_t BufferPool::cached_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return cached_bytes_;
+}
+
+void BufferPool::Clear() {
+  decltype(cached_) cached;
+  {
+    absl::MutexLock lock(&mutex_);
+    cached.swap(cached_);
+    cached_bytes_ = 0;
+  }
+  // The buffers are freed outside of the lock.
+}
+
+void BufferPool::ReturnStorage(std::type_index type, size_t capacity_bytes,
+                               std::unique_ptr<TensorData> storage) {
+  if (capacity_bytes < options_.min_buffer_bytes) return;
+  const size_t size_class = RoundDownToSizeClass(capacity_bytes);
+  absl::MutexLock lock(&mutex_);
+  if (capacity_bytes > options_.max_cached_bytes - cached_bytes_) return;
+  cached_[{type, size_class}].push_back(
+      CachedBuffer{capacity_bytes, std::move(storage)});
+  cached_bytes_ += capacity_bytes;
+}
+
+std::unique_ptr<TensorData> BufferPool::TakeCached(std::type_index type,
+                                                   size_t size_class) {
+  absl::MutexLock lock(&mutex_);
+  auto it = cached_.find({type, size_class});
+  if (it == cached_.end() || it->second.empty()) return nullptr;
+  CachedBuffer buffer = std::move(it->second.back());
+  it->second.pop_back();
+  cached_bytes_ -= buffer.capacity_bytes;
+  return std::move(buffer.storage);
+}
+
+size_t BufferPool::RoundUpToSizeClass(size_t bytes) {
+  if (bytes <= 4) return bytes;
+  const size_t step = size_t{1} << (absl::bit_width(bytes - 1) - 3);
+  return (bytes + step - 1) & ~(step - 1);
+}
+
+size_t BufferPool::RoundDownToSizeClass(size_t bytes) {
+  if (bytes <= 4) return bytes;
+  const size_t step = size_t{1} << (absl::bit_width(bytes) - 3);
+  return bytes & ~(step - 1);
+}
+
+void BufferPool::AdviseHugePages(void* data, size_t bytes) const {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (!options_.use_huge_pages) return;
+  // Only the huge pages entirely within the buffer can be advised.
+  const uintptr_t begin =
+      (reinterpret_cast<uintptr_t>(data) + kHugePageSize - 1) &
+      ~(kHugePageSize - 1);
+  const uintptr_t end =
+      (reinterpret_cast<uintptr_t>(data) + bytes) & ~(kHugePageSize - 1);
+  if (begin < end) {
+    // This is only a hint, so failures are ignored.
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+  }
+#endif
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_BUFFER_POOL_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// Pool of the storage of large MutableVectorData, so that buffers of the sizes
+// needed every round, such as the aggregated values of a model, are allocated
+// and page-faulted once rather than every round.
+//
+// Buffers are grouped by value type and size class, where the classes are a
+// quarter of a power of two apart, so that a buffer is at most a quarter larger
+// than requested. The storage of a MutableVectorData returned by Acquire goes
+// back to the pool when the data is destroyed, for example with the Tensor
+// holding it, unless the pool already caches `max_cached_bytes`.
+//
+// This class is thread safe.
+class BufferPool final : public internal::VectorStorageSink,
+                         public std::enable_shared_from_this<BufferPool> {
+ public:
+  struct Options {
+    // Smaller buffers aren't pooled, since allocating them is cheap.
+    size_t min_buffer_bytes = size_t{1} << 20;
+    // The most bytes of unused buffers the pool holds on to.
+    size_t max_cached_bytes = std::numeric_limits<size_t>::max();
+    // Whether new buffers are backed by transparent huge pages, where
+    // supported, which reduces the page faults and TLB misses of the large
+    // buffers.
+    bool use_huge_pages = false;
+  };
+
+  static std::shared_ptr<BufferPool> Create(Options options);
+  static std::shared_ptr<BufferPool> Create() { return Create(Options()); }
+
+  // Sets the pool that CreateVectorData and the aggregators draw buffers
+  // from, or disables pooling if `pool` is null, as it is by default.
+  static void SetDefault(std::shared_ptr<BufferPool> pool);
+
+  // Returns the pool set by SetDefault, or null if there is none.
+  static std::shared_ptr<BufferPool> GetDefault();
+
+  // Returns a MutableVectorData of `size` zero-initialized values of type T.
+  // The storage comes from the pool if it is large enough to be pooled.
+  template <typename T>
+  std::unique_ptr<MutableVectorData<T>> Acquire(size_t size);
+
+  // Returns the number of bytes of unused buffers held by the pool.
+  size_t cached_bytes() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Frees all unused buffers held by the pool.
+  void Clear() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  void ReturnStorage(std::type_index type, size_t capacity_bytes,
+                     std::unique_ptr<TensorData> storage) override
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  explicit BufferPool(Options options) : options_(options) {}
+
+  // Returns the size class of buffers of `bytes`, i.e. `bytes` rounded up to
+  // a multiple of a quarter of the power of two below it.
+  static size_t RoundUpToSizeClass(size_t bytes);
+
+  // Returns the largest size class of at most `bytes`.
+  static size_t RoundDownToSizeClass(size_t bytes);
+
+  // Removes and returns an unused buffer of values of `type` and of the given
+  // size class, or null if there is none.
+  std::unique_ptr<TensorData> TakeCached(std::type_index type,
+                                         size_t size_class)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Asks the system to back the `bytes` starting at `data` with huge pages.
+  void AdviseHugePages(void* data, size_t bytes) const;
+
+  struct CachedBuffer {
+    size_t capacity_bytes;
+    std::unique_ptr<TensorData> storage;
+  };
+
+  const Options options_;
+  mutable absl::Mutex mutex_;
+  // Unused buffers by value type and size class.
+  std::map<std::pair<std::type_index, size_t>, std::vector<CachedBuffer>>
+      cached_ ABSL_GUARDED_BY(mutex_);
+  size_t cached_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Returns a MutableVectorData of `size` zero-initialized values of type T,
+// drawn from the default BufferPool if one is set.
+template <typename T>
+std::unique_ptr<MutableVectorData<T>> CreateVectorData(size_t size) {
+  std::shared_ptr<BufferPool> pool = BufferPool::GetDefault();
+  if (pool == nullptr) {
+    return std::make_unique<MutableVectorData<T>>(size);
+  }
+  return pool->Acquire<T>(size);
+}
+
+template <typename T>
+std::unique_ptr<MutableVectorData<T>> BufferPool::Acquire(size_t size) {
+  const size_t bytes = size * sizeof(T);
+  if (bytes < options_.min_buffer_bytes) {
+    return std::make_unique<MutableVectorData<T>>(size);
+  }
+  const size_t size_class = RoundUpToSizeClass(bytes);
+  std::unique_ptr<MutableVectorData<T>> data;
+  std::unique_ptr<TensorData> cached = TakeCached(typeid(T), size_class);
+  if (cached != nullptr) {
+    data.reset(static_cast<MutableVectorData<T>*>(cached.release()));
+  } else {
+    data = std::make_unique<MutableVectorData<T>>();
+    // The pages are advised before the values are first written.
+    data->reserve((size_class + sizeof(T) - 1) / sizeof(T));
+    AdviseHugePages(data->std::vector<T>::data(), data->capacity() * sizeof(T));
+  }
+  data->resize(size);
+  data->set_storage_sink(shared_from_this());
+  return data;
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_BUFFER_POOL_H_
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/buffer_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Each;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Gt;
+using ::testing::Le;
+
+BufferPool::Options SmallBufferOptions() {
+  BufferPool::Options options;
+  options.min_buffer_bytes = 1024;
+  return options;
+}
+
+TEST(BufferPoolTest, ReusesStorageOfDestroyedData) {
+  auto pool = BufferPool::Create(SmallBufferOptions());
+  auto data = pool->Acquire<int64_t>(1000);
+  EXPECT_THAT(data->size(), Eq(1000));
+  (*data)[0] = 7;
+  const int64_t* storage = data->std::vector<int64_t>::data();
+  data.reset();
+  EXPECT_THAT(pool->cached_bytes(), Ge(1000 * sizeof(int64_t)));
+
+  // A slightly smaller buffer of the same size class reuses the storage, and
+  // is zero-initialized again.
+  auto reused = pool->Acquire<int64_t>(990);
+  EXPECT_THAT(reused->std::vector<int64_t>::data(), Eq(storage));
+  EXPECT_THAT(reused->size(), Eq(990));
+  EXPECT_THAT(*reused, Each(0));
+  EXPECT_THAT(pool->cached_bytes(), Eq(0));
+}
+
+TEST(BufferPoolTest, DoesNotShareStorageAcrossTypes) {
+  auto pool = BufferPool::Create(SmallBufferOptions());
+  pool->Acquire<int64_t>(1000).reset();
+  auto data = pool->Acquire<double>(1000);
+  EXPECT_THAT(pool->cached_bytes(), Gt(0));
+  data.reset();
+  pool->Clear();
+  EXPECT_THAT(pool->cached_bytes(), Eq(0));
+}
+
+TEST(BufferPoolTest, DoesNotPoolSmallBuffers) {
+  auto pool = BufferPool::Create(SmallBufferOptions());
+  pool->Acquire<int32_t>(10).reset();
+  EXPECT_THAT(pool->cached_bytes(), Eq(0));
+}
+
+TEST(BufferPoolTest, BoundsCachedBytes) {
+  BufferPool::Options options = SmallBufferOptions();
+  options.max_cached_bytes = 10000;
+  auto pool = BufferPool::Create(options);
+  auto first = pool->Acquire<int64_t>(1000);
+  auto second = pool->Acquire<int64_t>(1000);
+  first.reset();
+  second.reset();
+  EXPECT_THAT(pool->cached_bytes(), Le(10000));
+  EXPECT_THAT(pool->cached_bytes(), Gt(0));
+}
+
+TEST(BufferPoolTest, DataOutlivesPool) {
+  auto pool = BufferPool::Create(SmallBufferOptions());
+  auto data = pool->Acquire<float>(1000);
+  pool.reset();
+  (*data)[999] = 1;
+  data.reset();
+}
+
+TEST(BufferPoolTest, CreateVectorDataUsesDefaultPool) {
+  EXPECT_THAT(BufferPool::GetDefault(), Eq(nullptr));
+  EXPECT_THAT(CreateVectorData<int32_t>(1000)->size(), Eq(1000));
+
+  auto pool = BufferPool::Create(SmallBufferOptions());
+  BufferPool::SetDefault(pool);
+  CreateVectorData<int32_t>(1000).reset();
+  EXPECT_THAT(pool->cached_bytes(), Ge(1000 * sizeof(int32_t)));
+  BufferPool::SetDefault(nullptr);
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -16,31 +16,50 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
 
+#include <algorithm>
 #include <climits>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
-#include "absl/container/node_hash_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/binary_encoding.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_map.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dictionary_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/group_by_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
-#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_string_data.h"
 
 namespace tensorflow_federated {
 namespace aggregation {
 
 namespace {
 
+// Number of rows whose composite keys are created and hashed together.
+constexpr size_t kOrdinalsBlockSize = 256;
+// Number of rows ahead of the current one whose map slots are prefetched.
+constexpr size_t kPrefetchDistance = 8;
+// Number of consecutive keys of a column copied by each shard of
+// GetOutputKeys.
+constexpr size_t kOutputRangeSize = 1 << 16;
+// Version of the binary snapshot format written by AppendSnapshot.
+constexpr uint32_t kSnapshotVersion = 1;
+
 template <typename T>
 bool CheckDataTypeSupported() {
   return sizeof(T) <= sizeof(uint64_t);
@@ -108,6 +127,17 @@ void CopyToDest<string_view>(const void*& source_ptr, uint64_t* dest_ptr,
   source_ptr = static_cast<const void*>(++string_view_ptr);
 }
 
+// Copies `num_keys` consecutive elements of type T starting at source_ptr into
+// the composite keys starting at dest_ptr, which are `key_width` elements
+// apart, and advances source_ptr past the copied elements.
+template <typename T>
+void CopyToKeys(const void*& source_ptr, uint64_t* dest_ptr, size_t key_width,
+                size_t num_keys, std::unordered_set<std::string>& intern_pool) {
+  for (size_t i = 0; i < num_keys; ++i) {
+    CopyToDest<T>(source_ptr, dest_ptr + i * key_width, intern_pool);
+  }
+}
+
 TensorShape GetTensorShapeForSize(size_t size) {
   TFF_CHECK(size <= LONG_MAX)
       << "TensorShape: Dimension size too large to be represented as a "
@@ -115,53 +145,31 @@ TensorShape GetTensorShapeForSize(size_t size) {
   return TensorShape({static_cast<int64_t>(size)});
 }
 
-// Given a vector of uint64_t pointers, where the data pointed to can be safely
-// interpreted as type T, returns a Tensor of underlying data type
-// corresponding to T and the same length as the input vector. Each element of
-// the tensor is created by interpreting the data pointed to by the uint64_t
-// pointer at that index as type T.
+// Copies the elements at position `index` of the composite keys with ordinals
+// in [begin, end), interpreted as type T, to the same positions of `column`.
 template <typename T>
-StatusOr<Tensor> GetTensorForType(const CompositeKeyOrderedVector& key_iters) {
-  auto output_tensor_data = std::make_unique<MutableVectorData<T>>();
-  output_tensor_data->reserve(key_iters.size());
-  for (const uint64_t* key_it : key_iters) {
-    const T* ptr = reinterpret_cast<const T*>(key_it);
-    output_tensor_data->push_back(*ptr);
+void CopyKeyColumn(const CompositeKeyMap& composite_keys, size_t index,
+                   size_t begin, size_t end, MutableVectorData<T>& column) {
+  for (size_t i = begin; i < end; ++i) {
+    column[i] = *reinterpret_cast<const T*>(composite_keys.GetKey(i) + index);
   }
-  return Tensor::Create(internal::TypeTraits<T>::kDataType,
-                        GetTensorShapeForSize(key_iters.size()),
-                        std::move(output_tensor_data));
 }
 
-// Specialization of GetTensorForType for DT_STRING data type.
-// Given a vector of char pointers, where the data pointed to can be safely
-// interpreted as a pointer to a string, returns a tensor of type DT_STRING
-// and the same length as the input vector containing these strings.
-// The returned tensor will own all strings it refers to and is thus safe to
-// use after this class is destroyed.
-template <>
-StatusOr<Tensor> GetTensorForType<string_view>(
-    const CompositeKeyOrderedVector& key_iters) {
-  std::vector<std::string> strings_for_output;
-  for (auto key_it = key_iters.begin(); key_it != key_iters.end(); ++key_it) {
-    const intptr_t* ptr_to_string_address =
-        reinterpret_cast<const intptr_t*>(*key_it);
-    // The integer stored to represent a string is the address of the string
-    // stored in the intern_pool_. Thus this integer can be safely cast to a
-    // pointer and dereferenced to obtain the string.
-    const std::string* ptr =
-        reinterpret_cast<const std::string*>(*ptr_to_string_address);
-    strings_for_output.push_back(*ptr);
-  }
-  return Tensor::Create(
-      DT_STRING, GetTensorShapeForSize(key_iters.size()),
-      std::make_unique<VectorStringData>(std::move(strings_for_output)));
+// Returns the string at position `index` of the composite key with the given
+// ordinal. The integer stored to represent a string is the address of the
+// string stored in the intern pool, so it can be safely cast to a pointer and
+// dereferenced to obtain the string.
+const std::string& GetInternedString(const CompositeKeyMap& composite_keys,
+                                     int64_t ordinal, size_t index) {
+  const intptr_t* ptr_to_string_address = reinterpret_cast<const intptr_t*>(
+      composite_keys.GetKey(ordinal) + index);
+  return *reinterpret_cast<const std::string*>(*ptr_to_string_address);
 }
 
 }  // namespace
 
 CompositeKeyCombiner::CompositeKeyCombiner(std::vector<DataType> dtypes)
-    : dtypes_(dtypes) {
+    : dtypes_(dtypes), composite_keys_(dtypes.size()) {
   for (DataType dtype : dtypes) {
     // Initialize to false to satisfy compiler that all cases in the DTYPE_CASES
     // switch statement are covered, even though the cases that don't result in
@@ -181,18 +189,22 @@ StatusOr<Tensor> CompositeKeyCombiner::Accumulate(
   TFF_ASSIGN_OR_RETURN(size_t num_elements, shape.NumElements());
 
   return Tensor::Create(internal::TypeTraits<int64_t>::kDataType, shape,
-                        CreateOrdinals(tensors, num_elements, composite_keys_,
-                                       composite_key_next_, ordered_keys_));
+                        AccumulateKeys(tensors, num_elements));
+}
+
+std::unique_ptr<MutableVectorData<int64_t>>
+CompositeKeyCombiner::AccumulateKeys(const InputTensorList& tensors,
+                                     size_t num_elements) {
+  return CreateOrdinals(tensors, num_elements, composite_keys_);
 }
 
 // Creates ordinals for composite keys spread across input tensors: in a nested
-// for loop, transfer the bytes into a CompositeKey, then
-// call SaveCompositeKeyAndGetOrdinal on each.
+// for loop, transfer the bytes into a composite key, then
+// look up each in the composite_key_map.
 std::unique_ptr<MutableVectorData<int64_t>>
-CompositeKeyCombiner::CreateOrdinals(
-    const InputTensorList& tensors, size_t num_elements,
-    absl::node_hash_map<CompositeKey, int64_t>& composite_key_map,
-    int64_t& current_ordinal, CompositeKeyOrderedVector& ordered_keys) {
+CompositeKeyCombiner::CreateOrdinals(const InputTensorList& tensors,
+                                     size_t num_elements,
+                                     CompositeKeyMap& composite_key_map) {
   // Initialize the ordinals vector
   auto ordinals = std::make_unique<MutableVectorData<int64_t>>();
   ordinals->reserve(num_elements);
@@ -205,52 +217,324 @@ CompositeKeyCombiner::CreateOrdinals(
     iterators.push_back(t->data().data());
   }
 
-  for (int i = 0; i < num_elements; ++i) {
-    // Iterate over all the TensorDataIterators at once to get the value for the
-    // composite key.
-    CompositeKey composite_key(tensors.size(), 0);
-    // Construct a composite key by iterating through tensors and copying the
-    // 64-bit representation of data elements.
-    uint64_t* key_ptr = composite_key.data();
-    for (int j = 0; j < tensors.size(); ++j) {
-      // Copy the 64-bit representation of the element into the position in the
-      // composite key data corresponding to this tensor.
+  // The strings of dictionary encoded tensors are interned once per dictionary
+  // string, and the key elements of each row are then picked by its code.
+  std::vector<const int32_t*> codes(tensors.size(), nullptr);
+  std::vector<std::vector<uint64_t>> dictionary_keys(tensors.size());
+  for (int j = 0; j < tensors.size(); ++j) {
+    const auto* dictionary_data =
+        dynamic_cast<const DictionaryStringData*>(&tensors[j]->data());
+    if (dictionary_data == nullptr) continue;
+    absl::Span<const string_view> dictionary = dictionary_data->dictionary();
+    dictionary_keys[j].resize(dictionary.size());
+    const void* dictionary_ptr = dictionary.data();
+    CopyToKeys<string_view>(dictionary_ptr, dictionary_keys[j].data(),
+                            /*key_width=*/1, dictionary.size(), intern_pool_);
+    codes[j] = dictionary_data->codes().data();
+  }
+
+  // Composite keys are created, hashed and looked up a block of rows at a
+  // time. Scratch space for the composite keys of the current block; the map
+  // copies a key into its own storage only if the key is new.
+  const size_t key_width = tensors.size();
+  std::vector<uint64_t> block_keys(kOrdinalsBlockSize * key_width);
+  std::vector<size_t> block_hashes(kOrdinalsBlockSize);
+  for (size_t block_start = 0; block_start < num_elements;
+       block_start += kOrdinalsBlockSize) {
+    const size_t block_size =
+        std::min(kOrdinalsBlockSize, num_elements - block_start);
+    std::fill(block_keys.begin(), block_keys.begin() + block_size * key_width,
+              0);
+    // Construct the composite keys one tensor at a time by copying the 64-bit
+    // representation of the data elements, so that the data type only needs
+    // to be dispatched on once per tensor and block.
+    for (int j = 0; j < key_width; ++j) {
+      if (codes[j] != nullptr) {
+        const int32_t* block_codes = codes[j] + block_start;
+        for (size_t i = 0; i < block_size; ++i) {
+          block_keys[i * key_width + j] = dictionary_keys[j][block_codes[i]];
+        }
+        continue;
+      }
       DTYPE_CASES(dtypes()[j], T,
-                  CopyToDest<T>(iterators[j], key_ptr++, intern_pool_));
+                  CopyToKeys<T>(iterators[j], block_keys.data() + j, key_width,
+                                block_size, intern_pool_));
     }
+    composite_key_map.HashBatch(block_keys.data(), block_size,
+                                block_hashes.data());
 
-    // Get the ordinal associated with the composite key
-    // (or make new mapping if none exists)
-    auto ordinal = SaveCompositeKeyAndGetOrdinal(std::move(composite_key),
-                                                 composite_key_map,
-                                                 current_ordinal, ordered_keys);
-
-    // Insert the ordinal representing the composite key into the
-    // correct position in the output tensor.
-    ordinals->push_back(ordinal);
+    // Get the ordinal associated with each composite key (or make new mapping
+    // if none exists), prefetching the slots of the keys a few rows ahead so
+    // that their cache misses overlap with the lookups of earlier rows.
+    for (size_t i = 0; i < std::min(kPrefetchDistance, block_size); ++i) {
+      composite_key_map.Prefetch(block_hashes[i]);
+    }
+    for (size_t i = 0; i < block_size; ++i) {
+      if (i + kPrefetchDistance < block_size) {
+        composite_key_map.Prefetch(block_hashes[i + kPrefetchDistance]);
+      }
+      // Insert the ordinal representing the composite key into the
+      // correct position in the output tensor.
+      ordinals->push_back(composite_key_map.FindOrInsertWithHash(
+          block_keys.data() + i * key_width, block_hashes[i]));
+    }
   }
   return ordinals;
 }
 
 OutputTensorList CompositeKeyCombiner::GetOutputKeys() const {
+  const size_t num_keys = composite_keys_.size();
+  const size_t num_columns = dtypes_.size();
+  const size_t num_ranges =
+      (num_keys + kOutputRangeSize - 1) / kOutputRangeSize;
+  auto range_begin = [](size_t range) { return range * kOutputRangeSize; };
+  auto range_end = [num_keys](size_t range) {
+    return std::min(num_keys, (range + 1) * kOutputRangeSize);
+  };
+
+  // Numeric columns are copied straight into their preallocated output data.
+  // For string columns, the first pass only adds up the sizes of the strings
+  // of each range, which gives the offset of each range in the single buffer
+  // of the column.
+  std::vector<std::unique_ptr<TensorData>> columns(num_columns);
+  std::vector<std::vector<size_t>> range_offsets(num_columns);
+  for (size_t j = 0; j < num_columns; ++j) {
+    if (dtypes_[j] == DT_STRING) {
+      range_offsets[j].resize(num_ranges + 1);
+    } else {
+      NUMERICAL_ONLY_DTYPE_CASES(
+          dtypes_[j], T,
+          columns[j] = std::make_unique<MutableVectorData<T>>(num_keys));
+    }
+  }
+  internal::ForEachShard(
+      output_scheduler_, num_output_tasks_, num_columns * num_ranges,
+      [&](size_t shard) {
+        const size_t j = shard / num_ranges;
+        const size_t range = shard % num_ranges;
+        if (dtypes_[j] == DT_STRING) {
+          size_t size = 0;
+          for (size_t i = range_begin(range); i < range_end(range); ++i) {
+            size += GetInternedString(composite_keys_, i, j).size();
+          }
+          range_offsets[j][range + 1] = size;
+          return;
+        }
+        NUMERICAL_ONLY_DTYPE_CASES(
+            dtypes_[j], T,
+            CopyKeyColumn<T>(
+                composite_keys_, j, range_begin(range), range_end(range),
+                static_cast<MutableVectorData<T>&>(*columns[j])));
+      });
+
+  // The output tensors own copies of the strings, stored in a single buffer
+  // per column, so that they remain valid after this class is destroyed.
+  std::vector<size_t> string_columns;
+  for (size_t j = 0; j < num_columns; ++j) {
+    if (dtypes_[j] != DT_STRING) continue;
+    std::partial_sum(range_offsets[j].begin(), range_offsets[j].end(),
+                     range_offsets[j].begin());
+    columns[j] = std::make_unique<ContiguousStringData>(
+        num_keys, range_offsets[j].back());
+    string_columns.push_back(j);
+  }
+  internal::ForEachShard(
+      output_scheduler_, num_output_tasks_, string_columns.size() * num_ranges,
+      [&](size_t shard) {
+        const size_t j = string_columns[shard / num_ranges];
+        const size_t range = shard % num_ranges;
+        auto& column = static_cast<ContiguousStringData&>(*columns[j]);
+        size_t offset = range_offsets[j][range];
+        for (size_t i = range_begin(range); i < range_end(range); ++i) {
+          const std::string& s = GetInternedString(composite_keys_, i, j);
+          column.Set(i, offset, s);
+          offset += s.size();
+        }
+      });
+
+  // Even if no data has been accumulated, there will always be one tensor
+  // output for each data type that this CompositeKeyCombiner was configured to
+  // accept.
   OutputTensorList output_keys;
-  // Reserve space for a tensor for each data type. Even if no data has been
-  // accumulated, there will always be one tensor output for each data type that
-  // this CompositeKeyCombiner was configured to accept.
-  output_keys.reserve(dtypes_.size());
-  std::vector<const uint64_t*> key_iters = ordered_keys_;
-  for (DataType dtype : dtypes_) {
-    StatusOr<Tensor> t;
-    DTYPE_CASES(dtype, T, t = GetTensorForType<T>(key_iters));
+  output_keys.reserve(num_columns);
+  for (size_t j = 0; j < num_columns; ++j) {
+    StatusOr<Tensor> t = Tensor::Create(
+        dtypes_[j], GetTensorShapeForSize(num_keys), std::move(columns[j]));
     TFF_CHECK(t.status().ok()) << t.status().message();
     output_keys.push_back(std::move(t.value()));
-    for (auto key_it = key_iters.begin(); key_it != key_iters.end(); ++key_it) {
-      ++*key_it;
-    }
   }
   return output_keys;
 }
 
+size_t CompositeKeyCombiner::GetMemoryUsage() const {
+  size_t memory_usage = composite_keys_.memory_usage();
+  // Each interned string is held by a node of the set, which is referenced
+  // by a bucket.
+  memory_usage += intern_pool_.bucket_count() * sizeof(void*);
+  for (const std::string& value : intern_pool_) {
+    memory_usage += sizeof(void*) + sizeof(std::string) + value.capacity();
+  }
+  return memory_usage;
+}
+
+void CompositeKeyCombiner::AppendSnapshot(std::string& output) const {
+  AppendSnapshotHeader(SnapshotKind::kComposite, output);
+  std::vector<size_t> string_columns;
+  for (size_t j = 0; j < dtypes_.size(); ++j) {
+    if (dtypes_[j] == DT_STRING) string_columns.push_back(j);
+  }
+  if (string_columns.empty()) {
+    // The keys are plain values, so the map can be restored as is.
+    composite_keys_.AppendSnapshot(output);
+    return;
+  }
+  // String elements are addresses in the intern pool, so the strings are
+  // written once each, in the order they first occur, and the elements are
+  // replaced with their index in that order.
+  const size_t key_width = dtypes_.size();
+  const size_t num_keys = composite_keys_.size();
+  std::vector<uint64_t> keys(composite_keys_.GetKey(0),
+                             composite_keys_.GetKey(0) + num_keys * key_width);
+  absl::flat_hash_map<uint64_t, uint64_t> string_indices;
+  std::vector<const std::string*> strings;
+  for (size_t i = 0; i < num_keys; ++i) {
+    for (size_t j : string_columns) {
+      uint64_t& element = keys[i * key_width + j];
+      auto [it, inserted] = string_indices.try_emplace(element, strings.size());
+      if (inserted) {
+        strings.push_back(reinterpret_cast<const std::string*>(element));
+      }
+      element = it->second;
+    }
+  }
+  internal::AppendValue<uint64_t>(output, strings.size());
+  for (const std::string* value : strings) {
+    internal::AppendValue<uint64_t>(output, value->size());
+  }
+  for (const std::string* value : strings) {
+    output.append(*value);
+  }
+  internal::AppendValue<uint64_t>(output, num_keys);
+  internal::AppendArray(output, keys.data(), keys.size());
+}
+
+Status CompositeKeyCombiner::RestoreSnapshot(absl::string_view snapshot) {
+  TFF_RETURN_IF_ERROR(ReadSnapshotHeader(SnapshotKind::kComposite, snapshot));
+  std::vector<size_t> string_columns;
+  for (size_t j = 0; j < dtypes_.size(); ++j) {
+    if (dtypes_[j] == DT_STRING) string_columns.push_back(j);
+  }
+  if (string_columns.empty()) {
+    if (!composite_keys_.RestoreSnapshot(snapshot) || !snapshot.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "CompositeKeyCombiner::RestoreSnapshot: malformed keys.";
+    }
+    return TFF_STATUS(OK);
+  }
+
+  uint64_t num_strings;
+  if (!internal::ReadValue(snapshot, num_strings) ||
+      num_strings > snapshot.size() / sizeof(uint64_t)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "CompositeKeyCombiner::RestoreSnapshot: malformed strings.";
+  }
+  std::vector<uint64_t> sizes(num_strings);
+  internal::ReadArray(snapshot, sizes.data(), sizes.size());
+  std::vector<uint64_t> addresses;
+  addresses.reserve(num_strings);
+  intern_pool_.reserve(num_strings);
+  for (uint64_t size : sizes) {
+    if (size > snapshot.size()) {
+      intern_pool_.clear();
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "CompositeKeyCombiner::RestoreSnapshot: malformed strings.";
+    }
+    const std::string& value =
+        *intern_pool_.emplace(snapshot.substr(0, size)).first;
+    snapshot.remove_prefix(size);
+    addresses.push_back(
+        static_cast<uint64_t>(reinterpret_cast<intptr_t>(&value)));
+  }
+
+  const size_t key_width = dtypes_.size();
+  uint64_t num_keys;
+  std::vector<uint64_t> keys;
+  bool valid = internal::ReadValue(snapshot, num_keys) &&
+               num_keys <= snapshot.size() / (key_width * sizeof(uint64_t));
+  if (valid) {
+    keys.resize(num_keys * key_width);
+    internal::ReadArray(snapshot, keys.data(), keys.size());
+    valid = snapshot.empty();
+  }
+  for (size_t i = 0; valid && i < num_keys; ++i) {
+    for (size_t j : string_columns) {
+      uint64_t& element = keys[i * key_width + j];
+      if (element >= addresses.size()) {
+        valid = false;
+        break;
+      }
+      element = addresses[element];
+    }
+  }
+  if (!valid) {
+    intern_pool_.clear();
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "CompositeKeyCombiner::RestoreSnapshot: malformed keys.";
+  }
+  // The keys were distinct when written, so they are placed in the map without
+  // being compared, and the strings are never interned again row by row.
+  composite_keys_.AssignDistinct(keys.data(), num_keys);
+  return TFF_STATUS(OK);
+}
+
+void CompositeKeyCombiner::AppendSnapshotHeader(SnapshotKind kind,
+                                                std::string& output) const {
+  internal::AppendValue(output, kSnapshotVersion);
+  internal::AppendValue(output, kind);
+  internal::AppendValue<uint64_t>(output, dtypes_.size());
+  for (DataType dtype : dtypes_) {
+    internal::AppendValue<int32_t>(output, dtype);
+  }
+}
+
+Status CompositeKeyCombiner::ReadSnapshotHeader(
+    SnapshotKind kind, absl::string_view& input) const {
+  if (num_keys() != 0) {
+    return TFF_STATUS(FAILED_PRECONDITION)
+           << "CompositeKeyCombiner::RestoreSnapshot: keys were already "
+              "accumulated.";
+  }
+  uint32_t version;
+  SnapshotKind snapshot_kind;
+  uint64_t num_dtypes;
+  if (!internal::ReadValue(input, version) ||
+      !internal::ReadValue(input, snapshot_kind) ||
+      !internal::ReadValue(input, num_dtypes)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "CompositeKeyCombiner::RestoreSnapshot: truncated snapshot.";
+  }
+  if (version != kSnapshotVersion) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "CompositeKeyCombiner::RestoreSnapshot: unsupported version "
+           << version;
+  }
+  if (snapshot_kind != kind || num_dtypes != dtypes_.size()) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "CompositeKeyCombiner::RestoreSnapshot: the snapshot was "
+              "written by a different kind of key combiner.";
+  }
+  for (DataType dtype : dtypes_) {
+    int32_t snapshot_dtype;
+    if (!internal::ReadValue(input, snapshot_dtype) ||
+        snapshot_dtype != dtype) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "CompositeKeyCombiner::RestoreSnapshot: the snapshot has "
+                "different dtypes.";
+    }
+  }
+  return TFF_STATUS(OK);
+}
+
 StatusOr<TensorShape> CompositeKeyCombiner::CheckValidAndGetShape(
     const InputTensorList& tensors) {
   if (tensors.size() == 0) {
@@ -22,12 +22,12 @@
 #include <memory>
 #include <string>
 #include <unordered_set>
-#include <utility>
 #include <vector>
 
-#include "absl/container/fixed_array.h"
-#include "absl/container/node_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_map.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
@@ -38,24 +38,16 @@
 namespace tensorflow_federated {
 namespace aggregation {
 
-// CompositeKey holds a representation of items of potentially different data
-// types, which when combined form a key that should be used for grouping.
+// A composite key holds a representation of items of potentially different
+// data types, which when combined form a key that should be used for grouping.
 //
-// Composite keys are stored in a FixedArray of uint64_t. Each element in the
-// array is a single element of the composite key. These elements can be of
-// different types, but the CompositeKeyCombiner will only produce composite
-// keys including types that it can represent as a uint64_t.
-//
-// Using a FixedArray rather than a string for allocating the data buffer used
-// to store the composite key ensures that the pointers to elements in the
+// Composite keys are stored as sequences of uint64_t in a CompositeKeyMap. Each
+// element in the sequence is a single element of the composite key. These
+// elements can be of different types, but the CompositeKeyCombiner will only
+// produce composite keys including types that it can represent as a uint64_t.
+// Storing the elements as uint64_t ensures that the pointers to elements in the
 // composite key are properly aligned for storing items of `sizeof(uint64_t)`
 // bytes.
-using CompositeKey = absl::FixedArray<uint64_t>;
-
-// CompositeKeyOrderedVector is a vector of pointers to the data in the unique
-// CompositeKeys that are created by the CompositeKeyCombiner. The pointers are
-// ordered by the ordinal assigned to the composite key.
-using CompositeKeyOrderedVector = std::vector<const uint64_t*>;
 
 // Class operating on sets of tensors of the same shape to combine indices for
 // which the same combination of elements occurs, or in other words, indices
@@ -118,50 +110,94 @@ class CompositeKeyCombiner {
   // position 8 when it encountered this combination of elements in the input
   // tensor list at position 8, then the elements in the composite key will
   // appear at position 5 in the output tensors returned by this method.
-  OutputTensorList GetOutputKeys() const;
+  virtual OutputTensorList GetOutputKeys() const;
+
+  // Enables materializing the output keys in parallel in GetOutputKeys. Each
+  // column of the keys is copied in ranges of consecutive keys, which are
+  // processed by up to `num_tasks` tasks, including the calling thread, all
+  // but one of which are scheduled on `scheduler`. `scheduler` must outlive
+  // this combiner. A null `scheduler` or `num_tasks` <= 1 disables
+  // parallelism.
+  void SetParallelOutput(Scheduler* scheduler, int num_tasks) {
+    output_scheduler_ = num_tasks > 1 ? scheduler : nullptr;
+    num_output_tasks_ = num_tasks;
+  }
 
   // Gets a reference to the expected types for this CompositeKeyCombiner.
   const std::vector<DataType>& dtypes() const { return dtypes_; }
 
+  // Returns the number of unique composite keys accumulated so far.
+  virtual size_t num_keys() const { return composite_keys_.size(); }
+
+  // Returns an estimate of the memory held by the keys accumulated so far, in
+  // bytes, including the interned strings.
+  virtual size_t GetMemoryUsage() const;
+
+  // Appends a binary snapshot of the keys accumulated so far to `output`. The
+  // snapshot recreates the same keys and ordinals in RestoreSnapshot without
+  // accumulating the output keys again, and without hashing any key when all
+  // the keys are numeric.
+  //
+  // The snapshot is in the native byte order, so it is only meant for state
+  // restored by the same binary, such as spilled partitions.
+  virtual void AppendSnapshot(std::string& output) const;
+
+  // Restores the keys from a snapshot written by AppendSnapshot of a combiner
+  // of the same class and dtypes. No key may have been accumulated yet.
+  virtual Status RestoreSnapshot(absl::string_view snapshot);
+
  protected:
+  // Identifies the class which wrote a snapshot.
+  enum class SnapshotKind : uint8_t {
+    kComposite = 1,
+    kSingleNumeric = 2,
+    kSingleString = 3,
+    kDirectIndex = 4,
+  };
+
+  // Appends the version, kind and dtypes that each snapshot starts with.
+  void AppendSnapshotHeader(SnapshotKind kind, std::string& output) const;
+
+  // Reads the header of a snapshot from the front of `input`, and checks that
+  // it was written by a combiner of the given kind and the same dtypes, and
+  // that this combiner has no keys yet.
+  Status ReadSnapshotHeader(SnapshotKind kind, absl::string_view& input) const;
+
+  // Creates ordinals for the composite keys spread across the input tensors,
+  // assigning new ordinals to the composite keys not seen by previous calls.
+  // Called by Accumulate once the inputs have been validated.
+  //
+  // Subclasses which store the keys in a more efficient representation
+  // override this together with GetOutputKeys.
+  virtual std::unique_ptr<MutableVectorData<int64_t>> AccumulateKeys(
+      const InputTensorList& tensors, size_t num_elements);
+
   // Creates ordinals for composite keys spread across input tensors.
   // Specifically, the i-th entry of the output is the ordinal for the composite
   // key made by combining the i-th entry of the first tensor, the i-th entry of
   // the second tensor, ...
   //
-  // In a nested for loop, transfer the bytes into a CompositeKey.
-  // For each composite_key, call SaveCompositeKeyAndGetOrdinal
-  // to update data structures with the composite_key and obtain a possibly new
-  // ordinal. (refer to the end of this file for the definition of that
-  // function)
+  // In a nested for loop, transfer the bytes into a composite key, then look it
+  // up in `composite_key_map` to obtain a possibly new ordinal.
   //
-  // The data structures for SaveCompositeKeyAndGetOrdinal are explicitly given
-  // to this function. Allows for the use of temporary data structures in
-  // DPCompositeKeyCombiner::AccumulateWithBound.
+  // The map is explicitly given to this function. Allows for the use of a
+  // temporary map in DPCompositeKeyCombiner::AccumulateWithBound.
   std::unique_ptr<MutableVectorData<int64_t>> CreateOrdinals(
       const InputTensorList& tensors, size_t num_elements,
-      absl::node_hash_map<CompositeKey, int64_t>& composite_key_map,
-      int64_t& current_ordinal, CompositeKeyOrderedVector& ordered_keys);
+      CompositeKeyMap& composite_key_map);
 
   // Checks that the provided InputTensorList can be accumulated into this
   // CompositeKeyCombiner.
   StatusOr<TensorShape> CheckValidAndGetShape(const InputTensorList& tensors);
 
   // Functions to grant access to members
-  inline absl::node_hash_map<CompositeKey, int64_t>& GetCompositeKeys() {
-    return composite_keys_;
-  }
-  inline int64_t& GetCompositeKeyNext() { return composite_key_next_; }
-  inline CompositeKeyOrderedVector& GetKeyVec() { return ordered_keys_; }
+  inline CompositeKeyMap& GetCompositeKeys() { return composite_keys_; }
 
  private:
   // The data types of the tensors in valid inputs to Accumulate, in this exact
   // order.
   // TODO: b/277982238 - Use inlined vector to store the DataTypes instead.
   std::vector<DataType> dtypes_;
-  // Pointers to the byte representations of the composite keys in the order
-  // they will appear in the output tensors returned by GetOutputKeys.
-  std::vector<const uint64_t*> ordered_keys_;
   // Set of unique strings encountered in tensors of type DT_STRING on calls to
   // Accumulate.
   // Used as an optimization to avoid storing the same string multiple
@@ -171,35 +207,14 @@ class CompositeKeyCombiner {
   std::unordered_set<std::string> intern_pool_;
   // Mapping of byte representations of the composite keys seen so far to
   // their ordinal position in the output tensors returned by GetOutputKeys.
-  absl::node_hash_map<CompositeKey, int64_t> composite_keys_;
-  // Number of unique composite keys encountered so far across all calls to
-  // Accumulate.
-  int64_t composite_key_next_ = 0;
+  // The keys are stored in ordinal order, so the number of unique composite
+  // keys encountered so far is also the next ordinal to be assigned.
+  CompositeKeyMap composite_keys_;
+  // Parallel GetOutputKeys settings, see SetParallelOutput.
+  Scheduler* output_scheduler_ = nullptr;
+  int num_output_tasks_ = 1;
 };
 
-// If composite_key is not in a mapping from composite keys to ordinals, the
-// following function maps it to a new ordinal and adds a view of composite_key
-// to a dedicated vector. Otherwise, the function retrieves the ordinal assigned
-// to it. In either case, returns the ordinal that the composite_key has been
-// mapped to.
-inline int64_t SaveCompositeKeyAndGetOrdinal(
-    CompositeKey&& composite_key,
-    absl::node_hash_map<CompositeKey, int64_t>& composite_key_map,
-    int64_t& current_ordinal, CompositeKeyOrderedVector& ordered_keys) {
-  auto [it, inserted] =
-      composite_key_map.insert({std::move(composite_key), current_ordinal});
-  if (inserted) {
-    // This is the first time this CompositeKeyCombiner has encountered this
-    // particular composite key.
-    current_ordinal++;
-    // Save the pointer to the composite key data in the dedicated vector so we
-    // can recover it when GetOutputKeys is called.
-    ordered_keys.push_back(it->first.data());
-  }
-  // return the ordinal associated with the composite key
-  return it->second;
-}
-
 }  // namespace aggregation
 }  // namespace tensorflow_federated
 
@@ -16,15 +16,23 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dictionary_string_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
@@ -37,7 +45,10 @@ namespace tensorflow_federated {
 namespace aggregation {
 namespace {
 
+using ::testing::ElementsAreArray;
 using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::HasSubstr;
 
 TEST(CompositeKeyCombinerTest, EmptyInput_Invalid) {
   CompositeKeyCombiner combiner(std::vector<DataType>{DT_FLOAT});
@@ -200,6 +211,102 @@ TEST(CompositeKeyCombinerTest, AccumulateAndOutput_StringTypes) {
   EXPECT_THAT(output[2], IsTensor<string_view>({3}, {"fghi", "jklmn", "o"}));
 }
 
+TEST(CompositeKeyCombinerTest, AccumulateAndOutput_DictionaryEncodedStrings) {
+  CompositeKeyCombiner combiner(std::vector<DataType>{DT_INT32, DT_STRING});
+  // Enough rows to span several blocks of composite keys.
+  constexpr int kNumRows = 1000;
+  std::vector<int32_t> ints;
+  std::vector<string_view> strings;
+  std::vector<int64_t> expected_ordinals;
+  for (int i = 0; i < kNumRows; ++i) {
+    ints.push_back(i % 2);
+    strings.push_back(i % 3 == 0 ? "foo" : "bar");
+    expected_ordinals.push_back(i % 6 < 4 ? i % 6 : 6 - i % 6);
+  }
+  Tensor t1 =
+      Tensor::Create(DT_INT32, {kNumRows},
+                     std::make_unique<MutableVectorData<int32_t>>(
+                         ints.begin(), ints.end()))
+          .value();
+  Tensor t2 = Tensor::Create(DT_STRING, {kNumRows},
+                             DictionaryStringData::Encode(strings))
+                  .value();
+  StatusOr<Tensor> result = combiner.Accumulate(InputTensorList({&t1, &t2}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result->AsSpan<int64_t>(), ElementsAreArray(expected_ordinals));
+
+  // Plain strings are interned into the same pool as dictionary strings.
+  Tensor t3 =
+      Tensor::Create(DT_INT32, {2}, CreateTestData<int32_t>({1, 0})).value();
+  Tensor t4 = Tensor::Create(DT_STRING, {2},
+                             CreateTestData<string_view>({"foo", "baz"}))
+                  .value();
+  result = combiner.Accumulate(InputTensorList({&t3, &t4}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({2}, {3, 4}));
+
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(2));
+  EXPECT_THAT(output[0], IsTensor<int32_t>({5}, {0, 1, 0, 1, 0}));
+  EXPECT_THAT(output[1], IsTensor<string_view>(
+                             {5}, {"foo", "bar", "bar", "foo", "baz"}));
+}
+
+TEST(CompositeKeyCombinerTest, GetOutputKeys_Parallel) {
+  // Enough keys to span several ranges of each output column.
+  constexpr int kNumKeys = 200000;
+  std::vector<int64_t> ints;
+  std::vector<std::string> strings;
+  for (int i = 0; i < kNumKeys; ++i) {
+    ints.push_back(i / 2);
+    strings.push_back(absl::StrCat(i % 2 == 0 ? "" : "key", i % 5));
+  }
+  Tensor t1 =
+      Tensor::Create(DT_INT64, {kNumKeys},
+                     std::make_unique<MutableVectorData<int64_t>>(
+                         ints.begin(), ints.end()))
+          .value();
+  Tensor t2 = Tensor::Create(DT_STRING, {kNumKeys},
+                             DictionaryStringData::Encode(
+                                 std::vector<string_view>(strings.begin(),
+                                                          strings.end())))
+                  .value();
+  std::unique_ptr<Scheduler> scheduler = CreateThreadPoolScheduler(4);
+  CompositeKeyCombiner serial_combiner(
+      std::vector<DataType>{DT_INT64, DT_STRING});
+  CompositeKeyCombiner parallel_combiner(
+      std::vector<DataType>{DT_INT64, DT_STRING});
+  parallel_combiner.SetParallelOutput(scheduler.get(), 4);
+  for (auto* combiner : {&serial_combiner, &parallel_combiner}) {
+    ASSERT_OK(combiner->Accumulate(InputTensorList({&t1, &t2})));
+  }
+
+  OutputTensorList serial_output = serial_combiner.GetOutputKeys();
+  OutputTensorList parallel_output = parallel_combiner.GetOutputKeys();
+  ASSERT_THAT(parallel_output.size(), Eq(2));
+  EXPECT_THAT(parallel_output[0].AsSpan<int64_t>(),
+              ElementsAreArray(ints));
+  EXPECT_THAT(parallel_output[1].AsSpan<string_view>(),
+              ElementsAreArray(serial_output[1].AsSpan<string_view>()));
+  EXPECT_THAT(parallel_output[1].AsSpan<string_view>(),
+              ElementsAreArray(strings));
+}
+
+TEST(CompositeKeyCombinerTest, GetMemoryUsage_IncludesInternedStrings) {
+  CompositeKeyCombiner combiner(std::vector<DataType>{DT_STRING});
+  std::string long_key(100, 'a');
+  Tensor t1 = Tensor::Create(DT_STRING, {1},
+                             CreateTestData<string_view>({long_key}))
+                  .value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1})));
+  size_t memory_usage = combiner.GetMemoryUsage();
+  EXPECT_THAT(memory_usage, Ge(long_key.size()));
+
+  // Strings seen before are only stored once.
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1})));
+  EXPECT_THAT(combiner.GetMemoryUsage(), Eq(memory_usage));
+}
+
 TEST(CompositeKeyCombinerTest,
      StringTypes_SameCompositeKeysResultInSameOrdinalsAcrossAccumulateCalls) {
   CompositeKeyCombiner combiner(
@@ -246,6 +353,79 @@ TEST(CompositeKeyCombinerTest,
               IsTensor<string_view>({4}, {"fghi", "jklmn", "o", "pqrs"}));
 }
 
+TEST(CompositeKeyCombinerTest, RestoreSnapshot_NumericTypes) {
+  CompositeKeyCombiner combiner(std::vector<DataType>{DT_FLOAT, DT_INT32});
+  Tensor t1 =
+      Tensor::Create(DT_FLOAT, {3}, CreateTestData<float>({1.1, 1.2, 1.1}))
+          .value();
+  Tensor t2 =
+      Tensor::Create(DT_INT32, {3}, CreateTestData<int32_t>({1, 2, 1}))
+          .value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1, &t2})));
+  std::string snapshot;
+  combiner.AppendSnapshot(snapshot);
+
+  CompositeKeyCombiner restored(std::vector<DataType>{DT_FLOAT, DT_INT32});
+  ASSERT_OK(restored.RestoreSnapshot(snapshot));
+  EXPECT_THAT(restored.num_keys(), Eq(2));
+  Tensor t3 =
+      Tensor::Create(DT_FLOAT, {2}, CreateTestData<float>({1.2, 1.3})).value();
+  Tensor t4 =
+      Tensor::Create(DT_INT32, {2}, CreateTestData<int32_t>({2, 3})).value();
+  StatusOr<Tensor> result = restored.Accumulate(InputTensorList({&t3, &t4}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({2}, {1, 2}));
+  OutputTensorList output = restored.GetOutputKeys();
+  EXPECT_THAT(output[0], IsTensor<float>({3}, {1.1, 1.2, 1.3}));
+  EXPECT_THAT(output[1], IsTensor<int32_t>({3}, {1, 2, 3}));
+}
+
+TEST(CompositeKeyCombinerTest, RestoreSnapshot_StringTypes) {
+  CompositeKeyCombiner combiner(std::vector<DataType>{DT_STRING, DT_STRING});
+  Tensor t1 = Tensor::Create(DT_STRING, {3},
+                             CreateTestData<string_view>({"a", "b", "a"}))
+                  .value();
+  Tensor t2 = Tensor::Create(DT_STRING, {3},
+                             CreateTestData<string_view>({"b", "", "b"}))
+                  .value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1, &t2})));
+  std::string snapshot;
+  combiner.AppendSnapshot(snapshot);
+
+  CompositeKeyCombiner restored(std::vector<DataType>{DT_STRING, DT_STRING});
+  ASSERT_OK(restored.RestoreSnapshot(snapshot));
+  StatusOr<Tensor> result = restored.Accumulate(InputTensorList({&t2, &t1}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({3}, {2, 3, 2}));
+  OutputTensorList output = restored.GetOutputKeys();
+  EXPECT_THAT(output[0], IsTensor<string_view>({4}, {"a", "b", "b", ""}));
+  EXPECT_THAT(output[1], IsTensor<string_view>({4}, {"b", "", "a", "b"}));
+}
+
+TEST(CompositeKeyCombinerTest, RestoreSnapshot_Invalid) {
+  CompositeKeyCombiner combiner(std::vector<DataType>{DT_INT64, DT_STRING});
+  Tensor t1 =
+      Tensor::Create(DT_INT64, {1}, CreateTestData<int64_t>({1})).value();
+  Tensor t2 =
+      Tensor::Create(DT_STRING, {1}, CreateTestData<string_view>({"a"}))
+          .value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1, &t2})));
+  std::string snapshot;
+  combiner.AppendSnapshot(snapshot);
+
+  // Keys can't be restored into a combiner which already has keys.
+  EXPECT_THAT(combiner.RestoreSnapshot(snapshot),
+              StatusIs(FAILED_PRECONDITION));
+  CompositeKeyCombiner other_types(std::vector<DataType>{DT_INT32, DT_STRING});
+  EXPECT_THAT(other_types.RestoreSnapshot(snapshot),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("dtypes")));
+  CompositeKeyCombiner truncated(std::vector<DataType>{DT_INT64, DT_STRING});
+  EXPECT_THAT(truncated.RestoreSnapshot(
+                  absl::string_view(snapshot).substr(0, snapshot.size() - 1)),
+              StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(truncated.num_keys(), Eq(0));
+}
+
 }  // namespace
 }  // namespace aggregation
 }  // namespace tensorflow_federated
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_map.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/binary_encoding.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+void CompositeKeyMap::reserve(size_t num_keys) {
+  keys_.reserve(num_keys * key_width_);
+  size_t capacity = slots_.empty() ? kMinCapacity : slots_.size();
+  while (num_keys * kMaxLoadDenominator > capacity * kMaxLoadNumerator) {
+    capacity *= 2;
+  }
+  if (capacity != slots_.size()) {
+    Rehash(capacity);
+  }
+}
+
+void CompositeKeyMap::clear() {
+  size_t capacity = kMinCapacity;
+  while (num_keys_ * kMaxLoadDenominator > capacity * kMaxLoadNumerator) {
+    capacity *= 2;
+  }
+  if (capacity * 4 < slots_.size()) {
+    std::vector<Slot>(capacity, Slot{0, kEmpty}).swap(slots_);
+  } else {
+    std::fill(slots_.begin(), slots_.end(), Slot{0, kEmpty});
+  }
+  keys_.clear();
+  num_keys_ = 0;
+}
+
+void CompositeKeyMap::AppendSnapshot(std::string& output) const {
+  internal::AppendValue<uint64_t>(output, key_width_);
+  internal::AppendValue<uint64_t>(output, num_keys_);
+  internal::AppendArray(output, keys_.data(), num_keys_ * key_width_);
+  internal::AppendValue<uint64_t>(output, slots_.size());
+  internal::AppendArray(output, slots_.data(), slots_.size());
+}
+
+bool CompositeKeyMap::RestoreSnapshot(absl::string_view& input) {
+  keys_.clear();
+  slots_.clear();
+  num_keys_ = 0;
+  uint64_t key_width;
+  uint64_t num_keys;
+  if (!internal::ReadValue(input, key_width) || key_width != key_width_ ||
+      !internal::ReadValue(input, num_keys) ||
+      (key_width_ > 0 && num_keys > input.size() / key_width_)) {
+    return false;
+  }
+  keys_.resize(num_keys * key_width_);
+  uint64_t capacity;
+  if (!internal::ReadArray(input, keys_.data(), keys_.size()) ||
+      !internal::ReadValue(input, capacity) ||
+      capacity > input.size() / sizeof(Slot)) {
+    keys_.clear();
+    return false;
+  }
+  // A map which never held a key has no slots yet.
+  const bool valid_capacity =
+      (capacity == 0 && num_keys == 0) ||
+      (capacity >= kMinCapacity && (capacity & (capacity - 1)) == 0 &&
+       num_keys * kMaxLoadDenominator <= capacity * kMaxLoadNumerator);
+  if (!valid_capacity) {
+    keys_.clear();
+    return false;
+  }
+  slots_.resize(capacity);
+  internal::ReadArray(input, slots_.data(), slots_.size());
+  // Each ordinal must be in exactly one slot, so that every key can be found.
+  std::vector<bool> seen(num_keys, false);
+  size_t num_filled = 0;
+  for (const Slot& slot : slots_) {
+    if (slot.ordinal == kEmpty) continue;
+    if (slot.ordinal < 0 || static_cast<uint64_t>(slot.ordinal) >= num_keys ||
+        seen[slot.ordinal]) {
+      keys_.clear();
+      slots_.clear();
+      return false;
+    }
+    seen[slot.ordinal] = true;
+    ++num_filled;
+  }
+  if (num_filled != num_keys) {
+    keys_.clear();
+    slots_.clear();
+    return false;
+  }
+  num_keys_ = num_keys;
+  return true;
+}
+
+void CompositeKeyMap::AssignDistinct(const uint64_t* keys, size_t num_keys) {
+  clear();
+  reserve(num_keys);
+  keys_.assign(keys, keys + num_keys * key_width_);
+  std::vector<size_t> hashes(num_keys);
+  HashBatch(keys, num_keys, hashes.data());
+  for (size_t i = 0; i < num_keys; ++i) {
+    InsertSlot(static_cast<int64_t>(i), hashes[i]);
+  }
+  num_keys_ = num_keys;
+}
+
+void CompositeKeyMap::InsertSlot(int64_t ordinal, size_t hash) {
+  const size_t mask = slots_.size() - 1;
+  size_t i = hash & mask;
+  while (slots_[i].ordinal != kEmpty) {
+    i = (i + 1) & mask;
+  }
+  slots_[i] = Slot{hash, ordinal};
+}
+
+void CompositeKeyMap::Rehash(size_t capacity) {
+  std::vector<Slot> slots(capacity, Slot{0, kEmpty});
+  const size_t mask = capacity - 1;
+  // The stored hashes are reused, so keys don't need to be hashed again.
+  for (const Slot& slot : slots_) {
+    if (slot.ordinal == kEmpty) {
+      continue;
+    }
+    size_t i = slot.hash & mask;
+    while (slots[i].ordinal != kEmpty) {
+      i = (i + 1) & mask;
+    }
+    slots[i] = slot;
+  }
+  slots_ = std::move(slots);
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
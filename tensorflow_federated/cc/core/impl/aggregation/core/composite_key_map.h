@@ -0,0 +1,211 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_COMPOSITE_KEY_MAP_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_COMPOSITE_KEY_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// Open-addressing hash table mapping composite keys to ordinals.
+//
+// A composite key is a fixed-width sequence of `key_width` uint64_t elements.
+// Each distinct key is assigned the next ordinal, starting from zero, the first
+// time it is looked up. The elements of all keys are stored inline in a single
+// contiguous arena in ordinal order, so the key with ordinal i starts at
+// element `i * key_width` of the arena. The table slots only hold a hash and an
+// ordinal, and are probed linearly.
+//
+// Unlike a node-based map, inserting a key does not allocate except to grow the
+// arena or the slot array, and a lookup touches at most a few adjacent slots
+// and the arena.
+//
+// For bulk lookups, the hashes of a block of keys can be computed with
+// HashBatch, and the slots they map to prefetched before the keys are looked
+// up with FindOrInsertWithHash.
+//
+// This class is not thread safe.
+class CompositeKeyMap {
+ public:
+  // Creates an empty map for keys made of `key_width` elements.
+  explicit CompositeKeyMap(size_t key_width) : key_width_(key_width) {}
+
+  // Returns the ordinal of the key made of the `key_width()` elements starting
+  // at `key`. If the key is not yet in the map, `key` is copied into the map
+  // and assigned the ordinal `size()`.
+  int64_t FindOrInsert(const uint64_t* key) {
+    return FindOrInsertWithHash(key, Hash(key));
+  }
+
+  // Same as FindOrInsert, with `hash` the result of `Hash(key)`.
+  int64_t FindOrInsertWithHash(const uint64_t* key, size_t hash) {
+    if ((num_keys_ + 1) * kMaxLoadDenominator >
+        slots_.size() * kMaxLoadNumerator) {
+      Rehash(slots_.empty() ? kMinCapacity : slots_.size() * 2);
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+      Slot& slot = slots_[i];
+      if (slot.ordinal == kEmpty) {
+        slot.hash = hash;
+        slot.ordinal = static_cast<int64_t>(num_keys_++);
+        keys_.insert(keys_.end(), key, key + key_width_);
+        return slot.ordinal;
+      }
+      if (slot.hash == hash &&
+          std::memcmp(GetKey(slot.ordinal), key,
+                      key_width_ * sizeof(uint64_t)) == 0) {
+        return slot.ordinal;
+      }
+    }
+  }
+
+  // Returns the hash of the key made of the `key_width()` elements starting at
+  // `key`.
+  size_t Hash(const uint64_t* key) const {
+    uint64_t hash = kHashSeed;
+    for (size_t j = 0; j < key_width_; ++j) {
+      hash = MixHash(hash, key[j]);
+    }
+    return FinalizeHash(hash);
+  }
+
+  // Writes `Hash(keys + i * key_width())` to `hashes[i]` for each of the
+  // `num_keys` keys stored contiguously at `keys`. The keys are hashed one
+  // element position at a time, so the inner loop has no dependencies across
+  // keys and can be vectorized by the compiler.
+  void HashBatch(const uint64_t* keys, size_t num_keys, size_t* hashes) const {
+    for (size_t i = 0; i < num_keys; ++i) {
+      hashes[i] = kHashSeed;
+    }
+    for (size_t j = 0; j < key_width_; ++j) {
+      for (size_t i = 0; i < num_keys; ++i) {
+        hashes[i] = MixHash(hashes[i], keys[i * key_width_ + j]);
+      }
+    }
+    for (size_t i = 0; i < num_keys; ++i) {
+      hashes[i] = FinalizeHash(hashes[i]);
+    }
+  }
+
+  // Hints that the slot for a key with the given hash will soon be probed.
+  void Prefetch(size_t hash) const {
+#if defined(__GNUC__) || defined(__clang__)
+    if (!slots_.empty()) {
+      __builtin_prefetch(&slots_[hash & (slots_.size() - 1)]);
+    }
+#endif
+  }
+
+  // Returns a pointer to the `key_width()` elements of the key with the given
+  // ordinal. The pointer is invalidated by the insertion of new keys.
+  const uint64_t* GetKey(int64_t ordinal) const {
+    return keys_.data() + ordinal * key_width_;
+  }
+
+  // Prepares the map to hold at least `num_keys` keys without rehashing.
+  void reserve(size_t num_keys);
+
+  // Removes all keys from the map. The memory used by the keys is kept so that
+  // a map reused for batches of similar size doesn't allocate, but a slot array
+  // much larger than the cleared keys needed is released, so that clearing the
+  // map after a small batch never costs as much as after the largest one.
+  void clear();
+
+  // Appends the keys and the slot array of this map to `output`, from which
+  // RestoreSnapshot recreates the same map without hashing or comparing any
+  // key. Only meaningful for keys whose elements are values rather than
+  // addresses, since the slots hold the hashes of the elements.
+  void AppendSnapshot(std::string& output) const;
+
+  // Replaces the contents of this map with a snapshot written by
+  // AppendSnapshot at the front of `input`, and advances `input` past it.
+  // Returns false if the snapshot is malformed, in which case the map is left
+  // empty.
+  bool RestoreSnapshot(absl::string_view& input);
+
+  // Replaces the contents of this map with the `num_keys` keys stored
+  // contiguously at `keys`, which are assigned ordinals in order. The keys are
+  // hashed but never compared, so they must be distinct.
+  void AssignDistinct(const uint64_t* keys, size_t num_keys);
+
+  // Returns the number of distinct keys in the map.
+  size_t size() const { return num_keys_; }
+
+  // Returns the number of elements in each key.
+  size_t key_width() const { return key_width_; }
+
+  // Returns the number of bytes allocated for the keys and the slot array.
+  size_t memory_usage() const {
+    return keys_.capacity() * sizeof(uint64_t) +
+           slots_.capacity() * sizeof(Slot);
+  }
+
+ private:
+  struct Slot {
+    size_t hash;
+    int64_t ordinal;
+  };
+
+  static constexpr int64_t kEmpty = -1;
+  static constexpr size_t kMinCapacity = 16;
+  // The table is grown once more than 3/4 of its slots are in use.
+  static constexpr size_t kMaxLoadNumerator = 3;
+  static constexpr size_t kMaxLoadDenominator = 4;
+  static constexpr uint64_t kHashSeed = 0x9e3779b97f4a7c15;
+
+  static uint64_t MixHash(uint64_t hash, uint64_t element) {
+    hash = (hash ^ element) * 0xff51afd7ed558ccd;
+    return hash ^ (hash >> 32);
+  }
+
+  // Spreads the entropy of all bits of `hash` into its low bits, which are the
+  // ones used to select a slot.
+  static size_t FinalizeHash(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111eb;
+    return static_cast<size_t>(hash ^ (hash >> 31));
+  }
+
+  // Reinserts all keys into a slot array with `capacity` slots, which must be a
+  // power of two.
+  void Rehash(size_t capacity);
+
+  // Inserts the key with the given ordinal and hash, which isn't in the slot
+  // array yet, into the first free slot of its probe sequence.
+  void InsertSlot(int64_t ordinal, size_t hash);
+
+  size_t key_width_;
+  size_t num_keys_ = 0;
+  // Elements of all keys, in ordinal order.
+  std::vector<uint64_t> keys_;
+  std::vector<Slot> slots_;
+};
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_COMPOSITE_KEY_MAP_H_
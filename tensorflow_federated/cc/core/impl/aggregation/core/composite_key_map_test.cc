@@ -0,0 +1,200 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_map.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/strings/string_view.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::ElementsAre;
+
+std::vector<uint64_t> GetKeyVector(const CompositeKeyMap& map,
+                                   int64_t ordinal) {
+  const uint64_t* key = map.GetKey(ordinal);
+  return std::vector<uint64_t>(key, key + map.key_width());
+}
+
+TEST(CompositeKeyMapTest, EmptyMap) {
+  CompositeKeyMap map(/*key_width=*/2);
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_EQ(map.key_width(), 2);
+}
+
+TEST(CompositeKeyMapTest, AssignsOrdinalsInInsertionOrder) {
+  CompositeKeyMap map(/*key_width=*/2);
+  uint64_t key1[] = {1, 2};
+  uint64_t key2[] = {2, 1};
+  uint64_t key3[] = {1, 3};
+  EXPECT_EQ(map.FindOrInsert(key1), 0);
+  EXPECT_EQ(map.FindOrInsert(key2), 1);
+  EXPECT_EQ(map.FindOrInsert(key1), 0);
+  EXPECT_EQ(map.FindOrInsert(key3), 2);
+  EXPECT_EQ(map.FindOrInsert(key2), 1);
+  EXPECT_EQ(map.size(), 3);
+  EXPECT_THAT(GetKeyVector(map, 0), ElementsAre(1, 2));
+  EXPECT_THAT(GetKeyVector(map, 1), ElementsAre(2, 1));
+  EXPECT_THAT(GetKeyVector(map, 2), ElementsAre(1, 3));
+}
+
+TEST(CompositeKeyMapTest, CopiesInsertedKeys) {
+  CompositeKeyMap map(/*key_width=*/1);
+  uint64_t key[] = {7};
+  EXPECT_EQ(map.FindOrInsert(key), 0);
+  key[0] = 8;
+  EXPECT_EQ(map.FindOrInsert(key), 1);
+  EXPECT_THAT(GetKeyVector(map, 0), ElementsAre(7));
+  EXPECT_THAT(GetKeyVector(map, 1), ElementsAre(8));
+}
+
+TEST(CompositeKeyMapTest, ManyKeysSurviveRehashing) {
+  constexpr int64_t kNumKeys = 100000;
+  CompositeKeyMap map(/*key_width=*/3);
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    uint64_t key[] = {static_cast<uint64_t>(i % 7), static_cast<uint64_t>(i),
+                      static_cast<uint64_t>(i / 7)};
+    ASSERT_EQ(map.FindOrInsert(key), i);
+  }
+  EXPECT_EQ(map.size(), kNumKeys);
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    uint64_t key[] = {static_cast<uint64_t>(i % 7), static_cast<uint64_t>(i),
+                      static_cast<uint64_t>(i / 7)};
+    ASSERT_EQ(map.FindOrInsert(key), i);
+  }
+  EXPECT_EQ(map.size(), kNumKeys);
+  EXPECT_THAT(GetKeyVector(map, 12345), ElementsAre(12345 % 7, 12345, 1763));
+}
+
+TEST(CompositeKeyMapTest, ReserveKeepsExistingKeys) {
+  CompositeKeyMap map(/*key_width=*/1);
+  uint64_t key1[] = {1};
+  uint64_t key2[] = {2};
+  EXPECT_EQ(map.FindOrInsert(key1), 0);
+  map.reserve(1000);
+  EXPECT_EQ(map.FindOrInsert(key2), 1);
+  EXPECT_EQ(map.FindOrInsert(key1), 0);
+  EXPECT_EQ(map.size(), 2);
+}
+
+TEST(CompositeKeyMapTest, ClearRemovesAllKeys) {
+  CompositeKeyMap map(/*key_width=*/2);
+  uint64_t key1[] = {1, 2};
+  uint64_t key2[] = {3, 4};
+  EXPECT_EQ(map.FindOrInsert(key1), 0);
+  EXPECT_EQ(map.FindOrInsert(key2), 1);
+  map.clear();
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_EQ(map.FindOrInsert(key2), 0);
+  EXPECT_EQ(map.FindOrInsert(key1), 1);
+  EXPECT_THAT(GetKeyVector(map, 0), ElementsAre(3, 4));
+}
+
+TEST(CompositeKeyMapTest, RestoreSnapshotRecreatesKeysAndOrdinals) {
+  CompositeKeyMap map(/*key_width=*/2);
+  for (uint64_t i = 0; i < 100; ++i) {
+    uint64_t key[] = {i % 7, i};
+    ASSERT_EQ(map.FindOrInsert(key), i);
+  }
+  std::string snapshot;
+  map.AppendSnapshot(snapshot);
+
+  CompositeKeyMap restored(/*key_width=*/2);
+  absl::string_view input = snapshot;
+  ASSERT_TRUE(restored.RestoreSnapshot(input));
+  EXPECT_TRUE(input.empty());
+  EXPECT_EQ(restored.size(), 100);
+  EXPECT_THAT(GetKeyVector(restored, 42), ElementsAre(0, 42));
+  for (uint64_t i = 0; i < 100; ++i) {
+    uint64_t key[] = {i % 7, i};
+    ASSERT_EQ(restored.FindOrInsert(key), i);
+  }
+  uint64_t new_key[] = {7, 7};
+  EXPECT_EQ(restored.FindOrInsert(new_key), 100);
+}
+
+TEST(CompositeKeyMapTest, RestoreSnapshotOfEmptyMap) {
+  CompositeKeyMap map(/*key_width=*/1);
+  std::string snapshot;
+  map.AppendSnapshot(snapshot);
+  CompositeKeyMap restored(/*key_width=*/1);
+  absl::string_view input = snapshot;
+  ASSERT_TRUE(restored.RestoreSnapshot(input));
+  EXPECT_EQ(restored.size(), 0);
+  uint64_t key = 5;
+  EXPECT_EQ(restored.FindOrInsert(&key), 0);
+}
+
+TEST(CompositeKeyMapTest, RestoreSnapshotRejectsMalformedInput) {
+  CompositeKeyMap map(/*key_width=*/2);
+  uint64_t key[] = {1, 2};
+  map.FindOrInsert(key);
+  std::string snapshot;
+  map.AppendSnapshot(snapshot);
+
+  CompositeKeyMap other_width(/*key_width=*/1);
+  absl::string_view input = snapshot;
+  EXPECT_FALSE(other_width.RestoreSnapshot(input));
+  CompositeKeyMap truncated(/*key_width=*/2);
+  input = absl::string_view(snapshot).substr(0, snapshot.size() - 1);
+  EXPECT_FALSE(truncated.RestoreSnapshot(input));
+  EXPECT_EQ(truncated.size(), 0);
+}
+
+TEST(CompositeKeyMapTest, AssignDistinctAssignsOrdinalsInOrder) {
+  CompositeKeyMap map(/*key_width=*/2);
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 50; ++i) {
+    keys.push_back(i);
+    keys.push_back(i * i);
+  }
+  map.AssignDistinct(keys.data(), 50);
+  EXPECT_EQ(map.size(), 50);
+  EXPECT_THAT(GetKeyVector(map, 3), ElementsAre(3, 9));
+  for (uint64_t i = 0; i < 50; ++i) {
+    ASSERT_EQ(map.FindOrInsert(keys.data() + 2 * i), i);
+  }
+}
+
+TEST(CompositeKeyMapTest, ReusableAfterClearingManyKeys) {
+  CompositeKeyMap map(/*key_width=*/1);
+  for (uint64_t i = 0; i < 10000; ++i) {
+    ASSERT_EQ(map.FindOrInsert(&i), i);
+  }
+  map.clear();
+  // Clearing a few keys after many shrinks the slots, which must still hold
+  // more keys afterwards.
+  for (uint64_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(map.FindOrInsert(&i), i);
+  }
+  map.clear();
+  for (uint64_t i = 0; i < 100; ++i) {
+    uint64_t key = 100 - i;
+    ASSERT_EQ(map.FindOrInsert(&key), i);
+  }
+  EXPECT_EQ(map.size(), 100);
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_CONTIGUOUS_STRING_DATA_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_CONTIGUOUS_STRING_DATA_H_
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// ContiguousStringData owns copies of string values, which are stored back to
+// back in a single buffer rather than in a separate allocation per string.
+class ContiguousStringData : public TensorData {
+ public:
+  // Copies the given strings, which only need to remain valid for the duration
+  // of the constructor.
+  explicit ContiguousStringData(absl::Span<const string_view> strings) {
+    size_t total_size = 0;
+    for (string_view s : strings) total_size += s.size();
+    buffer_ = std::make_unique<char[]>(total_size);
+    string_views_.reserve(strings.size());
+    char* dest = buffer_.get();
+    for (string_view s : strings) {
+      if (!s.empty()) std::memcpy(dest, s.data(), s.size());
+      string_views_.emplace_back(dest, s.size());
+      dest += s.size();
+    }
+  }
+  // Allocates the buffer for `num_strings` strings of `total_size` bytes in
+  // total, which are then copied in with Set. Strings that aren't set are
+  // empty.
+  ContiguousStringData(size_t num_strings, size_t total_size)
+      : buffer_(std::make_unique<char[]>(total_size)),
+        string_views_(num_strings) {}
+  ~ContiguousStringData() override = default;
+
+  // Copies `s` to the buffer at `offset` and makes it the string at `index`.
+  // Strings whose bytes don't overlap can be set concurrently.
+  void Set(size_t index, size_t offset, string_view s) {
+    char* dest = buffer_.get() + offset;
+    if (!s.empty()) std::memcpy(dest, s.data(), s.size());
+    string_views_[index] = string_view(dest, s.size());
+  }
+
+  // ContiguousStringData isn't copyable, since the views point into its own
+  // buffer.
+  ContiguousStringData(const ContiguousStringData&) = delete;
+  ContiguousStringData& operator=(const ContiguousStringData&) = delete;
+
+  // Implementation of TensorData methods.
+  size_t byte_size() const override {
+    return string_views_.size() * sizeof(string_view);
+  }
+  const void* data() const override { return string_views_.data(); }
+
+ private:
+  std::unique_ptr<char[]> buffer_;
+  std::vector<string_view> string_views_;
+};
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_CONTIGUOUS_STRING_DATA_H_
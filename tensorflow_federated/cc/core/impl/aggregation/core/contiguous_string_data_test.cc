@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
+
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(ContiguousStringDataTest, ContiguousStringDataValid) {
+  ContiguousStringData string_data(std::vector<string_view>(
+      {"string1", "another-string", "one_more_string"}));
+  EXPECT_THAT(string_data.CheckValid<string_view>(), IsOk());
+}
+
+TEST(ContiguousStringDataTest, OwnsCopiesOfStrings) {
+  std::vector<std::string> strings({"foo", "", "barbaz"});
+  ContiguousStringData string_data(
+      std::vector<string_view>(strings.begin(), strings.end()));
+  strings.clear();
+
+  const string_view* views =
+      static_cast<const string_view*>(string_data.data());
+  EXPECT_THAT(std::vector<string_view>(views, views + 3),
+              ElementsAre("foo", "", "barbaz"));
+  // The strings are stored back to back.
+  EXPECT_EQ(views[2].data(), views[0].data() + views[0].size());
+}
+
+TEST(ContiguousStringDataTest, SetCopiesStringsToBuffer) {
+  ContiguousStringData string_data(/*num_strings=*/3, /*total_size=*/9);
+  std::string strings[] = {"bar", "baz"};
+  // The strings can be set in any order.
+  string_data.Set(2, 6, strings[1]);
+  string_data.Set(0, 0, strings[0]);
+  strings[0].clear();
+  strings[1].clear();
+
+  const string_view* views =
+      static_cast<const string_view*>(string_data.data());
+  EXPECT_THAT(std::vector<string_view>(views, views + 3),
+              ElementsAre("bar", "", "baz"));
+  EXPECT_EQ(views[2].data(), views[0].data() + 6);
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_CORD_TENSOR_DATA_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_CORD_TENSOR_DATA_H_
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/buffer_pool.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// CordTensorData implements TensorData on top of an absl::Cord holding the
+// in-memory representation of numeric tensor values, such as a slice of a
+// received message.
+//
+// When the Cord is made of a single chunk whose address satisfies the
+// alignment of the values, the data aliases the Cord memory, which is kept
+// alive by the reference the Cord holds on it. Otherwise the Cord is copied
+// once into an owned buffer when the CordTensorData is constructed, which is
+// drawn from the default BufferPool if one is set.
+//
+// Like the data decoded from a serialized TensorProto content, this assumes the
+// values are encoded with the byte layout of the system running this code.
+class CordTensorData final : public TensorData {
+ public:
+  // Creates CordTensorData for values requiring the given alignment, for
+  // example alignof(T) for values of type T.
+  CordTensorData(absl::Cord cord, size_t alignment_size)
+      : cord_(std::move(cord)) {
+    auto flat = cord_.TryFlat();
+    if (flat.has_value() && IsAligned(flat->data(), alignment_size)) {
+      data_ = *flat;
+      return;
+    }
+    // The fresh allocation is suitably aligned for any numeric value type.
+    char* dest;
+    if (std::shared_ptr<BufferPool> pool = BufferPool::GetDefault()) {
+      pooled_copy_ = pool->Acquire<char>(cord_.size());
+      dest = pooled_copy_->std::vector<char>::data();
+    } else {
+      copy_ = std::unique_ptr<char[]>(new char[cord_.size()]);
+      dest = copy_.get();
+    }
+    char* const copy = dest;
+    for (absl::string_view chunk : cord_.Chunks()) {
+      std::memcpy(dest, chunk.data(), chunk.size());
+      dest += chunk.size();
+    }
+    data_ = absl::string_view(copy, cord_.size());
+    cord_.Clear();
+  }
+  ~CordTensorData() override = default;
+
+  // The data may point inside this object, so it can be neither copied nor
+  // moved.
+  CordTensorData(const CordTensorData&) = delete;
+  CordTensorData& operator=(const CordTensorData&) = delete;
+
+  // Implementation of TensorData methods.
+  size_t byte_size() const override { return data_.size(); }
+  const void* data() const override { return data_.data(); }
+
+  // Returns true if the data aliases the memory of the Cord rather than a
+  // copy of it.
+  bool is_aliased() const {
+    return copy_ == nullptr && pooled_copy_ == nullptr;
+  }
+
+ private:
+  absl::Cord cord_;
+  std::unique_ptr<char[]> copy_;
+  std::unique_ptr<MutableVectorData<char>> pooled_copy_;
+  absl::string_view data_;
+};
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_CORD_TENSOR_DATA_H_
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/cord_tensor_data.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/buffer_pool.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+std::string ToBytes(const std::vector<int64_t>& values) {
+  return std::string(reinterpret_cast<const char*>(values.data()),
+                     values.size() * sizeof(int64_t));
+}
+
+// Returns a Cord that references the external `bytes` without copying them.
+absl::Cord MakeExternalCord(absl::string_view bytes) {
+  return absl::MakeCordFromExternal(bytes, [] {});
+}
+
+TEST(CordTensorDataTest, AliasesAlignedFlatCord) {
+  std::vector<int64_t> values = {1, 2, 3, 4};
+  std::string bytes = ToBytes(values);
+  CordTensorData data(MakeExternalCord(bytes), alignof(int64_t));
+  EXPECT_TRUE(data.is_aliased());
+  EXPECT_EQ(data.data(), bytes.data());
+  EXPECT_EQ(data.byte_size(), bytes.size());
+  EXPECT_THAT(data.CheckValid<int64_t>(), IsOk());
+}
+
+TEST(CordTensorDataTest, CopiesUnalignedCord) {
+  std::vector<int64_t> values = {1, 2, 3, 4};
+  // Place the values at an odd offset of the buffer.
+  std::string bytes = "x" + ToBytes(values);
+  CordTensorData data(MakeExternalCord(absl::string_view(bytes).substr(1)),
+                      alignof(int64_t));
+  EXPECT_FALSE(data.is_aliased());
+  EXPECT_THAT(data.CheckValid<int64_t>(), IsOk());
+  ASSERT_EQ(data.byte_size(), values.size() * sizeof(int64_t));
+  EXPECT_EQ(std::memcmp(data.data(), values.data(), data.byte_size()), 0);
+}
+
+TEST(CordTensorDataTest, CopiesFragmentedCord) {
+  std::vector<int64_t> values = {1, 2, 3, 4};
+  std::string bytes = ToBytes(values);
+  absl::Cord cord = MakeExternalCord(absl::string_view(bytes).substr(0, 12));
+  cord.Append(MakeExternalCord(absl::string_view(bytes).substr(12)));
+  CordTensorData data(cord, alignof(int64_t));
+  EXPECT_FALSE(data.is_aliased());
+  EXPECT_THAT(data.CheckValid<int64_t>(), IsOk());
+  ASSERT_EQ(data.byte_size(), bytes.size());
+  EXPECT_EQ(std::memcmp(data.data(), values.data(), data.byte_size()), 0);
+}
+
+TEST(CordTensorDataTest, CopiesIntoDefaultBufferPool) {
+  BufferPool::Options options;
+  options.min_buffer_bytes = 16;
+  std::shared_ptr<BufferPool> pool = BufferPool::Create(options);
+  BufferPool::SetDefault(pool);
+  std::vector<int64_t> values = {1, 2, 3, 4};
+  std::string bytes = ToBytes(values);
+  absl::Cord cord = MakeExternalCord(absl::string_view(bytes).substr(0, 12));
+  cord.Append(MakeExternalCord(absl::string_view(bytes).substr(12)));
+  {
+    CordTensorData data(cord, alignof(int64_t));
+    EXPECT_FALSE(data.is_aliased());
+    EXPECT_THAT(data.CheckValid<int64_t>(), IsOk());
+    EXPECT_EQ(std::memcmp(data.data(), values.data(), data.byte_size()), 0);
+  }
+  // The copy returned to the pool with the data.
+  EXPECT_GE(pool->cached_bytes(), bytes.size());
+  BufferPool::SetDefault(nullptr);
+}
+
+TEST(CordTensorDataTest, EmptyCord) {
+  CordTensorData data(absl::Cord(), alignof(float));
+  EXPECT_EQ(data.byte_size(), 0);
+  EXPECT_THAT(data.CheckValid<float>(), IsOk());
+}
+
+TEST(CordTensorDataTest, BacksTensor) {
+  std::vector<int64_t> values = {5, 6, 7};
+  auto tensor = Tensor::Create(
+      DT_INT64, {3},
+      std::make_unique<CordTensorData>(absl::Cord(ToBytes(values)),
+                                       alignof(int64_t)));
+  ASSERT_THAT(tensor, IsOk());
+  EXPECT_THAT(*tensor, IsTensor<int64_t>({3}, {5, 6, 7}));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -59,6 +59,8 @@ struct TypeTraits {
 // TODO: b/222605809 - Add other types.
 MATCH_TYPE_AND_DTYPE(float, DT_FLOAT, TypeKind::kNumeric);
 MATCH_TYPE_AND_DTYPE(double, DT_DOUBLE, TypeKind::kNumeric);
+MATCH_TYPE_AND_DTYPE(int8_t, DT_INT8, TypeKind::kNumeric);
+MATCH_TYPE_AND_DTYPE(uint8_t, DT_UINT8, TypeKind::kNumeric);
 MATCH_TYPE_AND_DTYPE(int32_t, DT_INT32, TypeKind::kNumeric);
 MATCH_TYPE_AND_DTYPE(int64_t, DT_INT64, TypeKind::kNumeric);
 MATCH_TYPE_AND_DTYPE(uint64_t, DT_UINT64, TypeKind::kNumeric);
@@ -100,6 +102,8 @@ MATCH_TYPE_AND_DTYPE(string_view, DT_STRING, TypeKind::kString);
   DTYPE_CASE(double, TYPE_ARG, STMTS)
 
 #define DTYPE_INTEGER_CASES(TYPE_ARG, STMTS) \
+DTYPE_CASE(int8_t, TYPE_ARG, STMTS)          \
+DTYPE_CASE(uint8_t, TYPE_ARG, STMTS)         \
 DTYPE_CASE(int32_t, TYPE_ARG, STMTS)         \
 DTYPE_CASE(int64_t, TYPE_ARG, STMTS)         \
 DTYPE_CASE(uint64_t, TYPE_ARG, STMTS)
@@ -128,6 +132,11 @@ DTYPE_CASE(uint64_t, TYPE_ARG, STMTS)
   DTYPE_FLOATING_CASES(TYPE_ARG, SINGLE_ARG(STMTS))           \
   DTYPE_CASES_END(TYPE_ENUM)
 
+#define INTEGER_ONLY_DTYPE_CASES(TYPE_ENUM, TYPE_ARG, STMTS) \
+  DTYPE_CASES_BEGIN(TYPE_ENUM)                               \
+  DTYPE_INTEGER_CASES(TYPE_ARG, SINGLE_ARG(STMTS))           \
+  DTYPE_CASES_END(TYPE_ENUM)
+
 }  // namespace internal
 
 }  // namespace aggregation
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dense_accumulator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/buffer_pool.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+namespace {
+
+// Accumulator of the host backend.
+template <typename T>
+class HostDenseAccumulator final : public DenseAccumulator {
+ public:
+  explicit HostDenseAccumulator(size_t num_elements)
+      : sum_(CreateVectorData<T>(num_elements)) {}
+
+  Status AddBatch(absl::Span<const Tensor* const> inputs) override {
+    std::vector<const T*> values;
+    values.reserve(inputs.size());
+    for (const Tensor* input : inputs) {
+      values.push_back(input->AsSpan<T>().data());
+    }
+    std::vector<T>& sum_values = *sum_;
+    T* sum = sum_values.data();
+    const size_t size = sum_values.size();
+    for (size_t begin = 0; begin < size; begin += kBlockSize) {
+      const size_t end = std::min(size, begin + kBlockSize);
+      for (const T* input : values) {
+        for (size_t i = begin; i < end; ++i) {
+          sum[i] += input[i];
+        }
+      }
+    }
+    return TFF_STATUS(OK);
+  }
+
+  StatusOr<std::unique_ptr<TensorData>> TakeSum() && override {
+    return std::unique_ptr<TensorData>(std::move(sum_));
+  }
+
+  size_t GetMemoryUsage() const override {
+    return sum_ == nullptr ? 0 : sum_->byte_size();
+  }
+
+ private:
+  // Number of elements of the sum in each block, which keeps the block within
+  // a per-core L1 cache.
+  static constexpr size_t kBlockSize = 1 << 11;
+
+  std::unique_ptr<MutableVectorData<T>> sum_;
+};
+
+class HostDenseAccumulatorFactory final : public DenseAccumulatorFactory {
+ public:
+  StatusOr<std::unique_ptr<DenseAccumulator>> Create(
+      DataType dtype, size_t num_elements) const override {
+    if (dtype == DT_STRING || dtype == DT_INVALID) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "HostDenseAccumulatorFactory: Only numeric dtypes are "
+                "supported.";
+    }
+    std::unique_ptr<DenseAccumulator> accumulator;
+    NUMERICAL_ONLY_DTYPE_CASES(
+        dtype, T,
+        accumulator = std::make_unique<HostDenseAccumulator<T>>(num_elements));
+    return accumulator;
+  }
+};
+
+std::atomic<const DenseAccumulatorFactory*>& DefaultFactory() {
+  static auto* factory = new std::atomic<const DenseAccumulatorFactory*>(
+      &GetHostDenseAccumulatorFactory());
+  return *factory;
+}
+
+}  // namespace
+
+const DenseAccumulatorFactory& GetHostDenseAccumulatorFactory() {
+  static const DenseAccumulatorFactory* factory =
+      new HostDenseAccumulatorFactory();
+  return *factory;
+}
+
+void SetDenseAccumulatorFactory(const DenseAccumulatorFactory* factory) {
+  DefaultFactory().store(
+      factory != nullptr ? factory : &GetHostDenseAccumulatorFactory(),
+      std::memory_order_release);
+}
+
+const DenseAccumulatorFactory& GetDenseAccumulatorFactory() {
+  return *DefaultFactory().load(std::memory_order_acquire);
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DENSE_ACCUMULATOR_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DENSE_ACCUMULATOR_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// Backend that holds the sum of dense tensors of a single dtype and number of
+// elements, used by the accelerated_federated_sum and
+// accelerated_federated_mean intrinsics. A backend may keep the sum outside
+// of host memory, e.g. on an accelerator, so that accumulating the inputs of
+// large models isn't bound by the memory bandwidth of the host.
+//
+// Accumulators are used by one thread at a time.
+class DenseAccumulator {
+ public:
+  virtual ~DenseAccumulator() = default;
+
+  // Adds the `inputs` to the sum. The inputs are dense, of the dtype and
+  // number of elements of the sum, and only valid for the duration of the
+  // call, so backends that add them asynchronously, e.g. on a device, copy
+  // them into staging memory first, such as pinned host memory from which
+  // they are transferred to the device.
+  virtual Status AddBatch(absl::Span<const Tensor* const> inputs) = 0;
+
+  // Waits for all inputs to be added and returns the sum in host memory,
+  // consuming the accumulator. This is the only point at which a device
+  // backend copies the sum back to the host.
+  virtual StatusOr<std::unique_ptr<TensorData>> TakeSum() && = 0;
+
+  // Returns an estimate of the host memory held by the accumulator, in bytes.
+  virtual size_t GetMemoryUsage() const = 0;
+};
+
+// Creates the DenseAccumulator instances of a backend.
+class DenseAccumulatorFactory {
+ public:
+  virtual ~DenseAccumulatorFactory() = default;
+
+  // Creates an accumulator of a sum of `num_elements` values of type `dtype`,
+  // initialized to zeros. Returns INVALID_ARGUMENT if the backend doesn't
+  // support the dtype.
+  virtual StatusOr<std::unique_ptr<DenseAccumulator>> Create(
+      DataType dtype, size_t num_elements) const = 0;
+};
+
+// Returns the factory of the built-in backend, which adds the inputs of a
+// batch in host memory one block of the sum at a time, so that each block
+// stays in cache while all inputs are added to it.
+const DenseAccumulatorFactory& GetHostDenseAccumulatorFactory();
+
+// Sets the backend that the accelerated intrinsics created from then on use,
+// or restores the built-in host backend if `factory` is null. Doesn't take
+// ownership, and `factory` must outlive the aggregators created with it.
+void SetDenseAccumulatorFactory(const DenseAccumulatorFactory* factory);
+
+// Returns the backend set by SetDenseAccumulatorFactory, or the host backend.
+const DenseAccumulatorFactory& GetDenseAccumulatorFactory();
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DENSE_ACCUMULATOR_H_
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DICTIONARY_STRING_DATA_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DICTIONARY_STRING_DATA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// DictionaryStringData holds string values encoded as a dictionary of strings
+// and an int32 code per value, which is the index of the value in the
+// dictionary.
+//
+// The data still exposes one string_view per value, so it can be read like any
+// other string data, but consumers that check for this class can process the
+// codes as integers and only look at each dictionary string once.
+class DictionaryStringData : public TensorData {
+ public:
+  // Creates the data from the string `dictionary` data, which it takes
+  // ownership of, and the codes of the values. Fails if a code doesn't index
+  // the dictionary.
+  static StatusOr<std::unique_ptr<DictionaryStringData>> Create(
+      std::unique_ptr<TensorData> dictionary, std::vector<int32_t> codes) {
+    const size_t dictionary_size =
+        dictionary->byte_size() / sizeof(string_view);
+    for (int32_t code : codes) {
+      if (code < 0 || static_cast<size_t>(code) >= dictionary_size) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "DictionaryStringData: code " << code
+               << " is out of range for a dictionary of size "
+               << dictionary_size;
+      }
+    }
+    return std::unique_ptr<DictionaryStringData>(
+        new DictionaryStringData(std::move(dictionary), std::move(codes)));
+  }
+
+  // Encodes the given strings, which only need to remain valid for the duration
+  // of the call, with a dictionary of the distinct strings in order of first
+  // occurrence.
+  static std::unique_ptr<DictionaryStringData> Encode(
+      absl::Span<const string_view> values) {
+    absl::flat_hash_map<string_view, int32_t> codes_by_value;
+    std::vector<string_view> dictionary;
+    std::vector<int32_t> codes;
+    codes.reserve(values.size());
+    for (string_view value : values) {
+      auto [it, inserted] = codes_by_value.try_emplace(
+          value, static_cast<int32_t>(dictionary.size()));
+      if (inserted) dictionary.push_back(value);
+      codes.push_back(it->second);
+    }
+    return std::unique_ptr<DictionaryStringData>(new DictionaryStringData(
+        std::make_unique<ContiguousStringData>(dictionary), std::move(codes)));
+  }
+
+  ~DictionaryStringData() override = default;
+
+  // DictionaryStringData isn't copyable, since the views point into its own
+  // dictionary.
+  DictionaryStringData(const DictionaryStringData&) = delete;
+  DictionaryStringData& operator=(const DictionaryStringData&) = delete;
+
+  // The dictionary strings, which may not all be distinct.
+  absl::Span<const string_view> dictionary() const {
+    return absl::MakeConstSpan(
+        static_cast<const string_view*>(dictionary_->data()),
+        dictionary_->byte_size() / sizeof(string_view));
+  }
+  // The index in the dictionary of each value.
+  absl::Span<const int32_t> codes() const { return codes_; }
+
+  // Implementation of TensorData methods.
+  size_t byte_size() const override {
+    return string_views_.size() * sizeof(string_view);
+  }
+  const void* data() const override { return string_views_.data(); }
+
+ private:
+  DictionaryStringData(std::unique_ptr<TensorData> dictionary,
+                       std::vector<int32_t> codes)
+      : dictionary_(std::move(dictionary)), codes_(std::move(codes)) {
+    absl::Span<const string_view> strings = this->dictionary();
+    string_views_.reserve(codes_.size());
+    for (int32_t code : codes_) {
+      string_views_.push_back(strings[code]);
+    }
+  }
+
+  std::unique_ptr<TensorData> dictionary_;
+  std::vector<int32_t> codes_;
+  std::vector<string_view> string_views_;
+};
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DICTIONARY_STRING_DATA_H_
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dictionary_string_data.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+std::vector<string_view> Values(const DictionaryStringData& data) {
+  const string_view* views = static_cast<const string_view*>(data.data());
+  return std::vector<string_view>(
+      views, views + data.byte_size() / sizeof(string_view));
+}
+
+TEST(DictionaryStringDataTest, CreateExposesValuesOfCodes) {
+  auto data = DictionaryStringData::Create(
+                  std::make_unique<ContiguousStringData>(
+                      std::vector<string_view>({"foo", "bar"})),
+                  {1, 0, 1, 1})
+                  .value();
+  EXPECT_THAT(data->CheckValid<string_view>(), IsOk());
+  EXPECT_THAT(data->dictionary(), ElementsAre("foo", "bar"));
+  EXPECT_THAT(data->codes(), ElementsAre(1, 0, 1, 1));
+  EXPECT_THAT(Values(*data), ElementsAre("bar", "foo", "bar", "bar"));
+}
+
+TEST(DictionaryStringDataTest, CreateWithCodeOutOfRange_Fails) {
+  EXPECT_THAT(DictionaryStringData::Create(
+                  std::make_unique<ContiguousStringData>(
+                      std::vector<string_view>({"foo"})),
+                  {0, 1}),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("out of range")));
+  EXPECT_THAT(DictionaryStringData::Create(
+                  std::make_unique<ContiguousStringData>(
+                      std::vector<string_view>({"foo"})),
+                  {-1}),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("out of range")));
+}
+
+TEST(DictionaryStringDataTest, EncodeUsesOrderOfFirstOccurrence) {
+  std::vector<std::string> strings({"b", "a", "b", "", "a"});
+  auto data = DictionaryStringData::Encode(
+      std::vector<string_view>(strings.begin(), strings.end()));
+  strings.clear();
+  EXPECT_THAT(data->dictionary(), ElementsAre("b", "a", ""));
+  EXPECT_THAT(data->codes(), ElementsAre(0, 1, 0, 2, 1));
+  EXPECT_THAT(Values(*data), ElementsAre("b", "a", "b", "", "a"));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,394 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/direct_index_key_combiner.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/binary_encoding.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/single_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+namespace {
+
+constexpr uint64_t kSignBit = uint64_t{1} << 63;
+
+// Maps integers of type T to uint64_t while preserving their order, so that
+// the ranges of keys of all integer types are handled the same way.
+template <typename T>
+uint64_t ToOffset(T value) {
+  if constexpr (std::is_signed_v<T>) {
+    return static_cast<uint64_t>(static_cast<int64_t>(value)) ^ kSignBit;
+  } else {
+    return static_cast<uint64_t>(value);
+  }
+}
+
+template <typename T>
+T FromOffset(uint64_t value) {
+  if constexpr (std::is_signed_v<T>) {
+    return static_cast<T>(static_cast<int64_t>(value ^ kSignBit));
+  } else {
+    return static_cast<T>(value);
+  }
+}
+
+template <typename T>
+void GetOffsetRange(const Tensor& tensor, uint64_t& min, uint64_t& max) {
+  absl::Span<const T> values = tensor.AsSpan<T>();
+  auto [min_it, max_it] = std::minmax_element(values.begin(), values.end());
+  min = ToOffset(*min_it);
+  max = ToOffset(*max_it);
+}
+
+// Adds the position of each value of `tensor` in the range starting at `min`,
+// multiplied by `stride`, to the corresponding index.
+template <typename T>
+void AddToIndices(const Tensor& tensor, uint64_t min, uint64_t stride,
+                  std::vector<uint64_t>& indices) {
+  const T* values = static_cast<const T*>(tensor.data().data());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    indices[i] += (ToOffset(values[i]) - min) * stride;
+  }
+}
+
+template <typename T>
+Tensor CreateKeyTensor(DataType dtype, const std::vector<uint64_t>& keys) {
+  auto values = std::make_unique<MutableVectorData<T>>();
+  values->reserve(keys.size());
+  for (uint64_t key : keys) {
+    values->push_back(FromOffset<T>(key));
+  }
+  StatusOr<Tensor> t =
+      Tensor::Create(dtype, TensorShape({static_cast<int64_t>(keys.size())}),
+                     std::move(values));
+  TFF_CHECK(t.status().ok()) << t.status().message();
+  return std::move(t.value());
+}
+
+}  // namespace
+
+bool DirectIndexKeyCombiner::SupportsTypes(
+    const std::vector<DataType>& dtypes) {
+  if (dtypes.empty()) {
+    return false;
+  }
+  for (DataType dtype : dtypes) {
+    switch (dtype) {
+      case DT_INT8:
+      case DT_UINT8:
+      case DT_INT32:
+      case DT_INT64:
+      case DT_UINT64:
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+DirectIndexKeyCombiner::DirectIndexKeyCombiner(std::vector<DataType> dtypes)
+    : CompositeKeyCombiner(dtypes), keys_(dtypes.size()) {
+  TFF_CHECK(SupportsTypes(dtypes))
+      << "DirectIndexKeyCombiner: keys must be made of integer tensors.";
+}
+
+StatusOr<Tensor> DirectIndexKeyCombiner::Accumulate(
+    const InputTensorList& tensors) {
+  if (fallback_ != nullptr) {
+    return fallback_->Accumulate(tensors);
+  }
+  return CompositeKeyCombiner::Accumulate(tensors);
+}
+
+std::unique_ptr<MutableVectorData<int64_t>>
+DirectIndexKeyCombiner::AccumulateKeys(const InputTensorList& tensors,
+                                       size_t num_elements) {
+  if (fallback_ == nullptr) {
+    if (num_elements == 0) {
+      return std::make_unique<MutableVectorData<int64_t>>();
+    }
+    if (GrowRanges(GetRanges(tensors, num_elements))) {
+      return LookUpOrdinals(tensors, num_elements);
+    }
+    SwitchToHashing();
+  }
+  // Only reached when switching to hashing, or when called through
+  // CompositeKeyCombiner::Accumulate rather than Accumulate.
+  StatusOr<Tensor> ordinals = fallback_->Accumulate(tensors);
+  TFF_CHECK(ordinals.ok()) << ordinals.status().message();
+  absl::Span<const int64_t> values = ordinals->AsSpan<int64_t>();
+  return std::make_unique<MutableVectorData<int64_t>>(values.begin(),
+                                                      values.end());
+}
+
+std::vector<DirectIndexKeyCombiner::Range> DirectIndexKeyCombiner::GetRanges(
+    const InputTensorList& tensors, size_t num_elements) const {
+  std::vector<Range> ranges(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    INTEGER_ONLY_DTYPE_CASES(
+        tensors[i]->dtype(), T,
+        GetOffsetRange<T>(*tensors[i], ranges[i].min, ranges[i].max));
+  }
+  return ranges;
+}
+
+uint64_t DirectIndexKeyCombiner::GetTableSize(
+    const std::vector<Range>& ranges) {
+  uint64_t table_size = 1;
+  for (const Range& range : ranges) {
+    if (range.max - range.min >= kMaxTableSize) {
+      return kMaxTableSize + 1;
+    }
+    table_size *= range.max - range.min + 1;
+    if (table_size > kMaxTableSize) {
+      return kMaxTableSize + 1;
+    }
+  }
+  return table_size;
+}
+
+bool DirectIndexKeyCombiner::GrowRanges(const std::vector<Range>& ranges) {
+  std::vector<Range> grown = ranges;
+  if (!ranges_.empty()) {
+    bool changed = false;
+    for (size_t i = 0; i < grown.size(); ++i) {
+      grown[i].min = std::min(grown[i].min, ranges_[i].min);
+      grown[i].max = std::max(grown[i].max, ranges_[i].max);
+      changed |=
+          grown[i].min != ranges_[i].min || grown[i].max != ranges_[i].max;
+    }
+    if (!changed) {
+      return true;
+    }
+  }
+  if (GetTableSize(grown) > kMaxTableSize) {
+    return false;
+  }
+  if (!ranges_.empty()) {
+    // Grow the ranges that changed to at least twice their previous size, in
+    // the direction in which they grew, if the table still fits.
+    std::vector<Range> doubled = grown;
+    for (size_t i = 0; i < doubled.size(); ++i) {
+      Range& range = doubled[i];
+      const uint64_t size = range.max - range.min + 1;
+      const uint64_t min_size = 2 * (ranges_[i].max - ranges_[i].min + 1);
+      if ((range.min == ranges_[i].min && range.max == ranges_[i].max) ||
+          size >= min_size) {
+        continue;
+      }
+      const uint64_t extra = min_size - size;
+      if (range.max > ranges_[i].max) {
+        range.max = range.max > std::numeric_limits<uint64_t>::max() - extra
+                        ? std::numeric_limits<uint64_t>::max()
+                        : range.max + extra;
+      } else {
+        range.min = range.min < extra ? 0 : range.min - extra;
+      }
+    }
+    if (GetTableSize(doubled) <= kMaxTableSize) {
+      grown = std::move(doubled);
+    }
+  }
+  ranges_ = std::move(grown);
+  TFF_CHECK(RebuildTable()) << "DirectIndexKeyCombiner: duplicate key.";
+  return true;
+}
+
+bool DirectIndexKeyCombiner::RebuildTable() {
+  strides_.resize(ranges_.size());
+  uint64_t table_size = 1;
+  for (size_t i = 0; i < ranges_.size(); ++i) {
+    strides_[i] = table_size;
+    table_size *= ranges_[i].max - ranges_[i].min + 1;
+  }
+  table_.assign(table_size, -1);
+  const size_t num_keys = keys_[0].size();
+  for (size_t key = 0; key < num_keys; ++key) {
+    uint64_t index = 0;
+    for (size_t i = 0; i < ranges_.size(); ++i) {
+      index += (keys_[i][key] - ranges_[i].min) * strides_[i];
+    }
+    if (table_[index] >= 0) {
+      return false;
+    }
+    table_[index] = static_cast<int32_t>(key);
+  }
+  return true;
+}
+
+std::unique_ptr<MutableVectorData<int64_t>>
+DirectIndexKeyCombiner::LookUpOrdinals(const InputTensorList& tensors,
+                                       size_t num_elements) {
+  // Compute the index of each composite key one key tensor at a time, which
+  // keeps the loops over the values of each tensor simple.
+  std::vector<uint64_t> indices(num_elements, 0);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    INTEGER_ONLY_DTYPE_CASES(
+        tensors[i]->dtype(), T,
+        AddToIndices<T>(*tensors[i], ranges_[i].min, strides_[i], indices));
+  }
+  auto ordinals = std::make_unique<MutableVectorData<int64_t>>(num_elements);
+  std::vector<int64_t>& output = *ordinals;
+  for (size_t j = 0; j < num_elements; ++j) {
+    int32_t& ordinal = table_[indices[j]];
+    if (ordinal < 0) {
+      // The values of a new key are recovered from the digits of its index.
+      ordinal = static_cast<int32_t>(keys_[0].size());
+      for (size_t i = 0; i < keys_.size(); ++i) {
+        keys_[i].push_back(ranges_[i].min +
+                           indices[j] / strides_[i] %
+                               (ranges_[i].max - ranges_[i].min + 1));
+      }
+    }
+    output[j] = ordinal;
+  }
+  return ordinals;
+}
+
+void DirectIndexKeyCombiner::SwitchToHashing() {
+  std::unique_ptr<CompositeKeyCombiner> fallback =
+      CreateKeyCombinerForTypes(dtypes());
+  if (!keys_[0].empty()) {
+    // The keys are accumulated in ordinal order, so they keep their ordinals.
+    OutputTensorList keys = GetOutputKeys();
+    InputTensorList inputs(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      inputs[i] = &keys[i];
+    }
+    StatusOr<Tensor> ordinals = fallback->Accumulate(inputs);
+    TFF_CHECK(ordinals.ok()) << ordinals.status().message();
+  }
+  fallback_ = std::move(fallback);
+  ranges_ = std::vector<Range>();
+  strides_ = std::vector<uint64_t>();
+  table_ = std::vector<int32_t>();
+  keys_ = std::vector<std::vector<uint64_t>>();
+}
+
+OutputTensorList DirectIndexKeyCombiner::GetOutputKeys() const {
+  if (fallback_ != nullptr) {
+    return fallback_->GetOutputKeys();
+  }
+  OutputTensorList output_keys;
+  output_keys.reserve(keys_.size());
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    const DataType dtype = dtypes()[i];
+    INTEGER_ONLY_DTYPE_CASES(
+        dtype, T, output_keys.push_back(CreateKeyTensor<T>(dtype, keys_[i])));
+  }
+  return output_keys;
+}
+
+size_t DirectIndexKeyCombiner::num_keys() const {
+  if (fallback_ != nullptr) {
+    return fallback_->num_keys();
+  }
+  return keys_[0].size();
+}
+
+size_t DirectIndexKeyCombiner::GetMemoryUsage() const {
+  if (fallback_ != nullptr) {
+    return fallback_->GetMemoryUsage();
+  }
+  size_t memory_usage = table_.capacity() * sizeof(int32_t);
+  for (const std::vector<uint64_t>& keys : keys_) {
+    memory_usage += keys.capacity() * sizeof(uint64_t);
+  }
+  return memory_usage;
+}
+
+void DirectIndexKeyCombiner::AppendSnapshot(std::string& output) const {
+  if (fallback_ != nullptr) {
+    fallback_->AppendSnapshot(output);
+    return;
+  }
+  AppendSnapshotHeader(SnapshotKind::kDirectIndex, output);
+  internal::AppendValue<uint64_t>(output, keys_[0].size());
+  for (const std::vector<uint64_t>& keys : keys_) {
+    internal::AppendArray(output, keys.data(), keys.size());
+  }
+}
+
+Status DirectIndexKeyCombiner::RestoreSnapshot(absl::string_view snapshot) {
+  absl::string_view input = snapshot;
+  if (!ReadSnapshotHeader(SnapshotKind::kDirectIndex, input).ok()) {
+    // The snapshot may have been written once the keys were handed over.
+    std::unique_ptr<CompositeKeyCombiner> fallback =
+        CreateKeyCombinerForTypes(dtypes());
+    TFF_RETURN_IF_ERROR(fallback->RestoreSnapshot(snapshot));
+    fallback_ = std::move(fallback);
+    return TFF_STATUS(OK);
+  }
+  uint64_t num_keys;
+  if (!internal::ReadValue(input, num_keys) || num_keys > input.size() ||
+      input.size() != num_keys * keys_.size() * sizeof(uint64_t)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "DirectIndexKeyCombiner::RestoreSnapshot: malformed keys.";
+  }
+  if (num_keys == 0) {
+    return TFF_STATUS(OK);
+  }
+  std::vector<Range> ranges(keys_.size());
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    keys_[i].resize(num_keys);
+    internal::ReadArray(input, keys_[i].data(), num_keys);
+    auto [min_it, max_it] =
+        std::minmax_element(keys_[i].begin(), keys_[i].end());
+    ranges[i] = {*min_it, *max_it};
+  }
+  // The snapshot is only written while the keys fit in a table, so keys too
+  // spread out for one mean that the snapshot is malformed.
+  if (GetTableSize(ranges) > kMaxTableSize) {
+    keys_.assign(dtypes().size(), {});
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "DirectIndexKeyCombiner::RestoreSnapshot: malformed keys.";
+  }
+  ranges_ = std::move(ranges);
+  if (!RebuildTable()) {
+    ranges_.clear();
+    strides_.clear();
+    table_.clear();
+    keys_.assign(dtypes().size(), {});
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "DirectIndexKeyCombiner::RestoreSnapshot: duplicate key.";
+  }
+  return TFF_STATUS(OK);
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
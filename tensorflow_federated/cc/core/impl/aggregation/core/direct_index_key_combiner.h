@@ -0,0 +1,141 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DIRECT_INDEX_KEY_COMBINER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DIRECT_INDEX_KEY_COMBINER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// CompositeKeyCombiner for keys made of integer tensors whose values fall in
+// small ranges, such as bucket or vocabulary ids.
+//
+// The range of the values of each key tensor is tracked as keys are
+// accumulated, and each composite key is numbered by its position in the
+// product of the ranges, with the key tensors as the digits of a mixed-radix
+// number. The ordinals are then looked up in a table indexed by that number,
+// without hashing or comparing any key.
+//
+// The ranges grow as needed, to at least twice their size so that keys
+// arriving in increasing order don't rebuild the table on every call. Once
+// the table would exceed kMaxTableSize entries, the keys are handed over to
+// the combiner created by CreateKeyCombinerForTypes, to which all later calls
+// are forwarded.
+//
+// The ordinals and output keys are the same as those of a CompositeKeyCombiner
+// with the same dtypes.
+//
+// This class is not thread safe.
+class DirectIndexKeyCombiner final : public CompositeKeyCombiner {
+ public:
+  // Maximum number of entries of the table of ordinals.
+  static constexpr size_t kMaxTableSize = 1 << 20;
+
+  // Returns true if keys of the given dtypes can be combined by this class,
+  // i.e. if they are all integers.
+  static bool SupportsTypes(const std::vector<DataType>& dtypes);
+
+  // Creates a DirectIndexKeyCombiner for dtypes supported by SupportsTypes,
+  // or crashes otherwise.
+  explicit DirectIndexKeyCombiner(std::vector<DataType> dtypes);
+
+  StatusOr<Tensor> Accumulate(const InputTensorList& tensors) override;
+  OutputTensorList GetOutputKeys() const override;
+  size_t num_keys() const override;
+  size_t GetMemoryUsage() const override;
+
+  // The snapshot holds the keys in ordinal order, from which the table is
+  // rebuilt on restore. Once the keys have been handed over, the snapshot is
+  // that of the combiner they were handed over to.
+  void AppendSnapshot(std::string& output) const override;
+  Status RestoreSnapshot(absl::string_view snapshot) override;
+
+  // Returns true if the keys have been handed over to a hashing combiner
+  // because their ranges grew too large.
+  bool is_hashing() const { return fallback_ != nullptr; }
+
+ protected:
+  std::unique_ptr<MutableVectorData<int64_t>> AccumulateKeys(
+      const InputTensorList& tensors, size_t num_elements) override;
+
+ private:
+  // Inclusive range of the values of a key tensor, which are mapped to
+  // uint64_t preserving their order so that all integer types are handled
+  // the same way.
+  struct Range {
+    uint64_t min = 0;
+    uint64_t max = 0;
+  };
+
+  // Returns the number of entries of a table for the ranges, or
+  // kMaxTableSize + 1 if there would be more than kMaxTableSize.
+  static uint64_t GetTableSize(const std::vector<Range>& ranges);
+
+  // Returns the ranges of the values of the key tensors.
+  std::vector<Range> GetRanges(const InputTensorList& tensors,
+                               size_t num_elements) const;
+
+  // Grows the ranges of the keys to include `ranges`, and rebuilds the table
+  // if they changed. Returns false, leaving the ranges unchanged, if the table
+  // would exceed kMaxTableSize entries.
+  bool GrowRanges(const std::vector<Range>& ranges);
+
+  // Recomputes the strides and the table of ordinals from the keys, which must
+  // be within the ranges. Returns false if the same key occurs twice.
+  bool RebuildTable();
+
+  // Looks up the ordinals of the keys, which must be within the ranges,
+  // assigning new ordinals to the keys not seen before.
+  std::unique_ptr<MutableVectorData<int64_t>> LookUpOrdinals(
+      const InputTensorList& tensors, size_t num_elements);
+
+  // Hands the keys over to a combiner created by CreateKeyCombinerForTypes.
+  void SwitchToHashing();
+
+  // Range of the values of each key tensor.
+  std::vector<Range> ranges_;
+  // Weight of each key tensor in the index of a composite key in `table_`.
+  std::vector<uint64_t> strides_;
+  // Ordinal of each composite key in the product of the ranges, or -1 for
+  // the keys not seen yet.
+  std::vector<int32_t> table_;
+  // The values of each key tensor, mapped to uint64_t, in ordinal order.
+  std::vector<std::vector<uint64_t>> keys_;
+  // The combiner to which the calls are forwarded once the keys have been
+  // handed over, or null.
+  std::unique_ptr<CompositeKeyCombiner> fallback_;
+};
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DIRECT_INDEX_KEY_COMBINER_H_
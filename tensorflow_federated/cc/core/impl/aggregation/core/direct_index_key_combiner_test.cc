@@ -0,0 +1,235 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/direct_index_key_combiner.h"
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/random/random.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Eq;
+using ::testing::IsFalse;
+using ::testing::IsTrue;
+
+TEST(DirectIndexKeyCombinerTest, SupportsIntegerTypesOnly) {
+  EXPECT_THAT(DirectIndexKeyCombiner::SupportsTypes({DT_INT32, DT_INT64}),
+              IsTrue());
+  EXPECT_THAT(DirectIndexKeyCombiner::SupportsTypes({DT_INT8, DT_UINT64}),
+              IsTrue());
+  EXPECT_THAT(DirectIndexKeyCombiner::SupportsTypes({DT_INT32, DT_STRING}),
+              IsFalse());
+  EXPECT_THAT(DirectIndexKeyCombiner::SupportsTypes({DT_FLOAT}), IsFalse());
+  EXPECT_THAT(DirectIndexKeyCombiner::SupportsTypes({}), IsFalse());
+}
+
+TEST(DirectIndexKeyCombinerTest, InputWithWrongType_Invalid) {
+  DirectIndexKeyCombiner combiner({DT_INT64});
+  Tensor t =
+      Tensor::Create(DT_INT32, {3}, CreateTestData<int32_t>({1, 2, 3})).value();
+  EXPECT_THAT(combiner.Accumulate(InputTensorList({&t})),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(DirectIndexKeyCombinerTest, OutputBeforeAccumulateOutputsEmptyTensors) {
+  DirectIndexKeyCombiner combiner({DT_INT32, DT_INT64});
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(2));
+  EXPECT_THAT(output[0], IsTensor<int32_t>({0}, {}));
+  EXPECT_THAT(output[1], IsTensor<int64_t>({0}, {}));
+}
+
+TEST(DirectIndexKeyCombinerTest, SameKeysResultInSameOrdinals) {
+  DirectIndexKeyCombiner combiner({DT_INT32, DT_INT64});
+  Tensor t1 =
+      Tensor::Create(DT_INT32, {4}, CreateTestData<int32_t>({1, 2, 1, 1}))
+          .value();
+  Tensor t2 =
+      Tensor::Create(DT_INT64, {4}, CreateTestData<int64_t>({-3, 5, -3, 5}))
+          .value();
+  StatusOr<Tensor> result1 = combiner.Accumulate(InputTensorList({&t1, &t2}));
+  ASSERT_OK(result1);
+  EXPECT_THAT(result1.value(), IsTensor<int64_t>({4}, {0, 1, 0, 2}));
+
+  // The ranges of both key tensors grow to include the new keys.
+  Tensor t3 =
+      Tensor::Create(DT_INT32, {3}, CreateTestData<int32_t>({2, 0, 1}))
+          .value();
+  Tensor t4 =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({5, 9, -3}))
+          .value();
+  StatusOr<Tensor> result2 = combiner.Accumulate(InputTensorList({&t3, &t4}));
+  ASSERT_OK(result2);
+  EXPECT_THAT(result2.value(), IsTensor<int64_t>({3}, {1, 3, 0}));
+  EXPECT_THAT(combiner.is_hashing(), IsFalse());
+  EXPECT_THAT(combiner.num_keys(), Eq(4));
+
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(2));
+  EXPECT_THAT(output[0], IsTensor<int32_t>({4}, {1, 2, 1, 0}));
+  EXPECT_THAT(output[1], IsTensor<int64_t>({4}, {-3, 5, 5, 9}));
+}
+
+TEST(DirectIndexKeyCombinerTest, ExtremeValues) {
+  DirectIndexKeyCombiner combiner({DT_INT8, DT_UINT8});
+  Tensor t1 =
+      Tensor::Create(DT_INT8, {3}, CreateTestData<int8_t>({127, -128, 0}))
+          .value();
+  Tensor t2 =
+      Tensor::Create(DT_UINT8, {3}, CreateTestData<uint8_t>({255, 0, 255}))
+          .value();
+  StatusOr<Tensor> result = combiner.Accumulate(InputTensorList({&t1, &t2}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({3}, {0, 1, 2}));
+  EXPECT_THAT(combiner.is_hashing(), IsFalse());
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output[0], IsTensor<int8_t>({3}, {127, -128, 0}));
+  EXPECT_THAT(output[1], IsTensor<uint8_t>({3}, {255, 0, 255}));
+}
+
+TEST(DirectIndexKeyCombinerTest, WideRangesSwitchToHashing) {
+  DirectIndexKeyCombiner combiner({DT_UINT64});
+  Tensor t1 =
+      Tensor::Create(DT_UINT64, {3}, CreateTestData<uint64_t>({3, 1, 3}))
+          .value();
+  StatusOr<Tensor> result1 = combiner.Accumulate(InputTensorList({&t1}));
+  ASSERT_OK(result1);
+  EXPECT_THAT(result1.value(), IsTensor<int64_t>({3}, {0, 1, 0}));
+  EXPECT_THAT(combiner.is_hashing(), IsFalse());
+
+  const uint64_t kMax = std::numeric_limits<uint64_t>::max();
+  Tensor t2 =
+      Tensor::Create(DT_UINT64, {3}, CreateTestData<uint64_t>({kMax, 1, 0}))
+          .value();
+  StatusOr<Tensor> result2 = combiner.Accumulate(InputTensorList({&t2}));
+  ASSERT_OK(result2);
+  EXPECT_THAT(result2.value(), IsTensor<int64_t>({3}, {2, 1, 3}));
+  EXPECT_THAT(combiner.is_hashing(), IsTrue());
+  EXPECT_THAT(combiner.GetOutputKeys()[0],
+              IsTensor<uint64_t>({4}, {3, 1, kMax, 0}));
+
+  Tensor t3 =
+      Tensor::Create(DT_UINT64, {2}, CreateTestData<uint64_t>({0, 7})).value();
+  StatusOr<Tensor> result3 = combiner.Accumulate(InputTensorList({&t3}));
+  ASSERT_OK(result3);
+  EXPECT_THAT(result3.value(), IsTensor<int64_t>({2}, {3, 4}));
+}
+
+TEST(DirectIndexKeyCombinerTest, MatchesCompositeKeyCombiner) {
+  DirectIndexKeyCombiner combiner({DT_INT32, DT_INT64});
+  CompositeKeyCombiner expected({DT_INT32, DT_INT64});
+  absl::BitGen bitgen;
+  // The keys start in small ranges which keep growing, until the second key
+  // tensor spans too many values for a table.
+  for (int64_t max_value = 4; max_value < (1 << 22); max_value *= 4) {
+    std::vector<int32_t> keys1;
+    std::vector<int64_t> keys2;
+    for (int i = 0; i < 100; ++i) {
+      keys1.push_back(absl::Uniform<int32_t>(bitgen, -10, 10));
+      keys2.push_back(absl::Uniform<int64_t>(bitgen, -max_value, max_value));
+    }
+    Tensor t1 = Tensor::Create(DT_INT32, {100},
+                               std::make_unique<MutableVectorData<int32_t>>(
+                                   keys1.begin(), keys1.end()))
+                    .value();
+    Tensor t2 = Tensor::Create(DT_INT64, {100},
+                               std::make_unique<MutableVectorData<int64_t>>(
+                                   keys2.begin(), keys2.end()))
+                    .value();
+    StatusOr<Tensor> result = combiner.Accumulate(InputTensorList({&t1, &t2}));
+    StatusOr<Tensor> expected_result =
+        expected.Accumulate(InputTensorList({&t1, &t2}));
+    ASSERT_OK(result);
+    ASSERT_OK(expected_result);
+    EXPECT_THAT(result->AsSpan<int64_t>(),
+                testing::ElementsAreArray(expected_result->AsSpan<int64_t>()));
+  }
+  EXPECT_THAT(combiner.is_hashing(), IsTrue());
+  OutputTensorList output = combiner.GetOutputKeys();
+  OutputTensorList expected_output = expected.GetOutputKeys();
+  EXPECT_THAT(output[0].AsSpan<int32_t>(),
+              testing::ElementsAreArray(expected_output[0].AsSpan<int32_t>()));
+  EXPECT_THAT(output[1].AsSpan<int64_t>(),
+              testing::ElementsAreArray(expected_output[1].AsSpan<int64_t>()));
+}
+
+TEST(DirectIndexKeyCombinerTest, RestoreSnapshot) {
+  DirectIndexKeyCombiner combiner({DT_INT32, DT_INT64});
+  Tensor t1 =
+      Tensor::Create(DT_INT32, {3}, CreateTestData<int32_t>({7, 3, 7})).value();
+  Tensor t2 =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({1, 1, 1})).value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1, &t2})));
+  std::string snapshot;
+  combiner.AppendSnapshot(snapshot);
+
+  DirectIndexKeyCombiner restored({DT_INT32, DT_INT64});
+  ASSERT_OK(restored.RestoreSnapshot(snapshot));
+  EXPECT_THAT(restored.is_hashing(), IsFalse());
+  Tensor t3 =
+      Tensor::Create(DT_INT32, {3}, CreateTestData<int32_t>({3, 5, 7})).value();
+  StatusOr<Tensor> result = restored.Accumulate(InputTensorList({&t3, &t2}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({3}, {1, 2, 0}));
+  EXPECT_THAT(restored.GetOutputKeys()[0], IsTensor<int32_t>({3}, {7, 3, 5}));
+
+  // The snapshot is only restored by a combiner of the same dtypes.
+  DirectIndexKeyCombiner other_types({DT_INT64, DT_INT64});
+  EXPECT_THAT(other_types.RestoreSnapshot(snapshot),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(DirectIndexKeyCombinerTest, RestoreSnapshotAfterSwitchingToHashing) {
+  DirectIndexKeyCombiner combiner({DT_INT64});
+  Tensor t1 =
+      Tensor::Create(DT_INT64, {2}, CreateTestData<int64_t>({0, 1LL << 40}))
+          .value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1})));
+  ASSERT_THAT(combiner.is_hashing(), IsTrue());
+  std::string snapshot;
+  combiner.AppendSnapshot(snapshot);
+
+  DirectIndexKeyCombiner restored({DT_INT64});
+  ASSERT_OK(restored.RestoreSnapshot(snapshot));
+  EXPECT_THAT(restored.is_hashing(), IsTrue());
+  EXPECT_THAT(restored.GetOutputKeys()[0],
+              IsTensor<int64_t>({2}, {0, 1LL << 40}));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -19,15 +19,14 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <iterator>
 #include <memory>
 #include <utility>
 #include <vector>
 
-#include "absl/container/node_hash_map.h"
 #include "absl/random/random.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_map.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
@@ -38,55 +37,12 @@
 namespace tensorflow_federated {
 namespace aggregation {
 
-// Class that supports DPCompositeKeyCombiner::AccumulateWithBound. Each call to
-// AccumulateWithBound creates a temporary mapping from composite keys to
-// integers; we call them "local ordinals" to disambiguate from the ordinals
-// maintained by CompositeKeyCombiner.
-// LocalToGlobalInserter helps create a vector such that the integer at index i
-// is the ordinal for the composite key whose local ordinal is i.
-class LocalToGlobalInserter
-    : public std::insert_iterator<std::vector<int64_t>> {
- public:
-  // Constructor that takes the same input as insert_iterator's, along with a
-  // pointer to a DPCompositeKeyCombiner. The pointer will be used to update its
-  // member data structures.
-  LocalToGlobalInserter(std::vector<int64_t>& c,
-                        std::vector<int64_t>::iterator i,
-                        DPCompositeKeyCombiner* key_combiner)
-      : std::insert_iterator<std::vector<int64_t>>(c, i),
-        key_combiner_(key_combiner) {}
-
-  // These operators are no-ops, just like in insert_iterator (see
-  // https://en.cppreference.com/w/cpp/iterator/insert_iterator), but are still
-  // needed for compilation to succeed.
-  constexpr LocalToGlobalInserter& operator*() { return *this; }
-  constexpr LocalToGlobalInserter& operator++() { return *this; }
-  constexpr LocalToGlobalInserter& operator++(int v) { return *this; }
-
-  // An r-value assignment operator suffices for our purposes: the input will
-  // provided by std::sample, which iterates through an
-  // absl::node_hash_map<CompositeKey, int64_t>. The
-  // FixedArray<uint64_t> is a composite key and the int is its local ordinal
-  LocalToGlobalInserter& operator=(std::pair<CompositeKey, int64_t>&& p) {
-    // Map the local ordinal to the ordinal produced by
-    // SaveCompositeKeyAndGetOrdinal. Give that function access to the members
-    // of key_combiner_ so that novel composite keys will be assigned ordinals
-    // that have not yet been assigned.
-    (*(this->container))[p.second] = SaveCompositeKeyAndGetOrdinal(
-        std::move(p.first), key_combiner_->GetCompositeKeys(),
-        key_combiner_->GetCompositeKeyNext(), key_combiner_->GetKeyVec());
-    return *this;
-  }
-
- private:
-  DPCompositeKeyCombiner* key_combiner_;
-};
-
 DPCompositeKeyCombiner::DPCompositeKeyCombiner(
     const std::vector<DataType>& dtypes, int64_t l0_bound)
     : CompositeKeyCombiner(dtypes),
       l0_bound_(l0_bound),
-      bitgen_(absl::BitGen()) {
+      bitgen_(absl::BitGen()),
+      local_composite_keys_(dtypes.size()) {
   TFF_CHECK(l0_bound_ > 0) << "l0_bound must be positive";
 }
 
@@ -105,43 +61,57 @@ StatusOr<Tensor> DPCompositeKeyCombiner::Accumulate(
 
 StatusOr<Tensor> DPCompositeKeyCombiner::AccumulateWithBound(
     const InputTensorList& tensors, TensorShape& shape, size_t num_elements) {
-  // The following contains unique composite keys in the order they were first
-  // created. We call the index of a composite key in this vector its "local
-  // ordinal," as it is only meaningful within one Accumulate call.
-  std::vector<const uint64_t*> local_key_vec;
-  local_key_vec.reserve(num_elements);
-
-  // The following maps a view of a composite key to its local ordinal.
-  absl::node_hash_map<CompositeKey, int64_t> composite_keys_to_local_ordinal;
-  composite_keys_to_local_ordinal.reserve(num_elements);
-
-  int64_t local_ordinal = 0;
+  // The following maps the composite keys in the input to their "local
+  // ordinal," which is only meaningful within one Accumulate call. Keys are
+  // assigned local ordinals in the order they were first created.
+  local_composite_keys_.clear();
+  local_composite_keys_.reserve(num_elements);
 
   // The i-th element of the following is the local ordinal associated with the
   // i-th composite key. Created the same way CompositeKeyCombiner::Accumulate
-  // creates ordinals but datastructures for lookup & storage are local to this
-  // function call, instead of being class members.
+  // creates ordinals but the map for lookup & storage only holds the keys of
+  // this function call, instead of the keys of all calls.
   std::unique_ptr<MutableVectorData<int64_t>> local_ordinals =
-      CreateOrdinals(tensors, num_elements, composite_keys_to_local_ordinal,
-                     local_ordinal, local_key_vec);
+      CreateOrdinals(tensors, num_elements, local_composite_keys_);
+
+  // Sample l0_bound_ of the local ordinals uniformly without replacement, with
+  // a reservoir that is filled in a single pass over the local ordinals.
+  const int64_t num_local_keys = local_composite_keys_.size();
+  const int64_t num_sampled = std::min(num_local_keys, l0_bound_);
+  sampled_local_ordinals_.clear();
+  for (int64_t local_ordinal = 0; local_ordinal < num_local_keys;
+       ++local_ordinal) {
+    if (local_ordinal < num_sampled) {
+      sampled_local_ordinals_.push_back(local_ordinal);
+      continue;
+    }
+    int64_t slot = absl::Uniform<int64_t>(bitgen_, 0, local_ordinal + 1);
+    if (slot < num_sampled) {
+      sampled_local_ordinals_[slot] = local_ordinal;
+    }
+  }
 
   // Create a mapping from local ordinals to global ordinals. Default to -1.
-  std::vector<int64_t> local_to_global(num_elements, -1);
-  local_to_global.reserve(l0_bound_);
-
-  // Sample l0_bound_ of the composite keys. For each composite_key that is
-  // sampled, update the local_to_global map.
-  // The process involves std::move of
-  // strings so composite_keys_to_local_ordinal will be invalidated.
-  LocalToGlobalInserter inserter(local_to_global, local_to_global.begin(),
-                                 this);
-  std::sample(composite_keys_to_local_ordinal.begin(),
-              composite_keys_to_local_ordinal.end(), inserter, l0_bound_,
-              bitgen_);
+  // For each composite key that is sampled, look up its ordinal in the map
+  // maintained across calls so that novel composite keys will be assigned
+  // ordinals that have not yet been assigned. The sampled keys are looked up
+  // in the order of their local ordinals, so novel keys are assigned ordinals
+  // in the order they appear in the input.
+  local_to_global_.assign(num_local_keys, -1);
+  for (int64_t local_ordinal : sampled_local_ordinals_) {
+    local_to_global_[local_ordinal] = 0;
+  }
+  CompositeKeyMap& composite_keys = GetCompositeKeys();
+  for (int64_t local_ordinal = 0; local_ordinal < num_local_keys;
+       ++local_ordinal) {
+    if (local_to_global_[local_ordinal] < 0) continue;
+    local_to_global_[local_ordinal] = composite_keys.FindOrInsert(
+        local_composite_keys_.GetKey(local_ordinal));
+  }
 
   // Finally, transform the local ordinals into global ordinals
   for (int64_t& ordinal : *local_ordinals) {
-    ordinal = local_to_global[ordinal];
+    ordinal = local_to_global_[ordinal];
   }
   return Tensor::Create(internal::TypeTraits<int64_t>::kDataType, shape,
                         std::move(local_ordinals));
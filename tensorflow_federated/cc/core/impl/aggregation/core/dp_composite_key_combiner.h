@@ -25,6 +25,7 @@
 #include "absl/random/random.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_map.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
@@ -57,25 +58,35 @@ class DPCompositeKeyCombiner : public CompositeKeyCombiner {
   StatusOr<Tensor> Accumulate(const InputTensorList& tensors) override;
 
   // AccumulateWithBound will first create the set of unique composite keys in
-  // the input, in parallel with a vector of composite keys. Then it samples a
-  // subset of l0_bound_ composite keys ("survivors") from the whole set.
-  // Finally, it loops through the input again to map composite keys (stored in
-  // its vector) to ordinals. Composite keys that are not survivors map to -1.
+  // the input, each with a local ordinal. Then it samples a subset of l0_bound_
+  // composite keys ("survivors") from the whole set in a single pass over the
+  // local ordinals. Finally, it loops through the input again to map local
+  // ordinals to ordinals. Composite keys that are not survivors map to -1.
   // It is the responsibility of the calling code to not use them as indices;
   // -1 simply indicates that a row of data should be skipped in an inner
   // aggregation
   StatusOr<Tensor> AccumulateWithBound(const InputTensorList& tensors,
                                        TensorShape& shape, size_t num_elements);
 
+  // Includes the scratch state of AccumulateWithBound, which is kept between
+  // calls.
+  size_t GetMemoryUsage() const override {
+    return CompositeKeyCombiner::GetMemoryUsage() +
+           local_composite_keys_.memory_usage() +
+           (sampled_local_ordinals_.capacity() + local_to_global_.capacity()) *
+               sizeof(int64_t);
+  }
+
  private:
   const int64_t l0_bound_;
   absl::BitGen bitgen_;
 
-  // Friend class that supports the operations done in
-  // DPCompositeKeyCombiner::AccumulateWithBound.
-  // Populates a map associating ordinals that are only meaningful in one call
-  // of Accumulate with ordinals that are meaningful across calls to Accumulate.
-  friend class LocalToGlobalInserter;
+  // Scratch state of AccumulateWithBound, which is cleared rather than
+  // reallocated on each call, so that bounding the contribution of an input
+  // doesn't allocate once the buffers have grown to fit the inputs.
+  CompositeKeyMap local_composite_keys_;
+  std::vector<int64_t> sampled_local_ordinals_;
+  std::vector<int64_t> local_to_global_;
 };
 
 }  // namespace aggregation
@@ -18,6 +18,8 @@
 
 #include <cstdint>
 #include <initializer_list>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
@@ -27,6 +29,7 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
@@ -245,6 +248,35 @@ TEST(DPCompositeKeyCombinerTest, AccumulateAndOutput_L0BoundIs2) {
   }
 }
 
+// The scratch state used to bound contributions is reused across inputs of
+// different sizes; each input must still contribute to exactly l0_bound keys,
+// which are assigned ordinals in the order they appear in the input.
+TEST(DPCompositeKeyCombinerTest, AccumulateManyInputsOfDifferentSizes) {
+  constexpr int64_t kL0Bound = 3;
+  DPCompositeKeyCombiner combiner(std::vector<DataType>{DT_INT64}, kL0Bound);
+  int64_t num_keys = 0;
+  for (int64_t size : {10, 4, 100, 5, 1000, 4}) {
+    auto keys = std::make_unique<MutableVectorData<int64_t>>(size);
+    for (int64_t i = 0; i < size; ++i) {
+      // Each input only holds keys that no previous input holds.
+      (*keys)[i] = num_keys * 10000 + i;
+    }
+    Tensor t = Tensor::Create(DT_INT64, {size}, std::move(keys)).value();
+    StatusOr<Tensor> result = combiner.Accumulate(InputTensorList({&t}));
+    ASSERT_OK(result);
+    std::vector<int64_t> ordinals;
+    for (int64_t ordinal : result->AsSpan<int64_t>()) {
+      if (ordinal >= 0) ordinals.push_back(ordinal);
+    }
+    EXPECT_THAT(ordinals, testing::ElementsAre(num_keys, num_keys + 1,
+                                               num_keys + 2));
+    num_keys += kL0Bound;
+  }
+  OutputTensorList output = combiner.GetOutputKeys();
+  ASSERT_THAT(output.size(), Eq(1));
+  EXPECT_THAT(output[0].num_elements(), Eq(num_keys));
+}
+
 // When an l0_bound is not provided, DPCompositeKeyCombiner's behavior should be
 // exactly the same as CompositeKeyCombiner's behavior.
 // Hence, the tests below are duplicated from CompositeKeyCombiner.
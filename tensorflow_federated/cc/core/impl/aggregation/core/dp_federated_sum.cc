@@ -0,0 +1,326 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "algorithms/numerical-mechanisms.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dp_fedsql_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_factory.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+using ::differential_privacy::GaussianMechanism;
+using ::differential_privacy::NumericalMechanism;
+
+// Below is an implementation of a DP sum of dense tensors, e.g. of model
+// updates, which does not need the keys of a DPGroupByAggregator. Each client
+// input is scaled down to an L2 norm of at most l2_bound_ before it is added,
+// and Gaussian noise with standard deviation noise_stddev_ is added to every
+// element of the sum when it is reported. If mean_ is true, the noisy sum is
+// divided by the number of inputs.
+//
+// Merged aggregators hold sums of inputs that were already clipped, so they
+// are added without clipping. Noise is only added once, to the reported sum.
+template <typename T>
+class DPFederatedSum final : public AggVectorAggregator<T> {
+ public:
+  DPFederatedSum(DataType dtype, TensorShape shape, double l2_bound,
+                 double noise_stddev, bool mean)
+      : AggVectorAggregator<T>(dtype, std::move(shape)),
+        l2_bound_(l2_bound),
+        noise_stddev_(noise_stddev),
+        mean_(mean) {}
+
+  DPFederatedSum(DataType dtype, TensorShape shape, double l2_bound,
+                 double noise_stddev, bool mean,
+                 std::unique_ptr<MutableVectorData<T>> data, int num_inputs)
+      : AggVectorAggregator<T>(dtype, std::move(shape), std::move(data),
+                               num_inputs),
+        l2_bound_(l2_bound),
+        noise_stddev_(noise_stddev),
+        mean_(mean) {}
+
+  using AggVectorAggregator<T>::data;
+
+ protected:
+  // Client inputs are clipped one at a time, since each of them is scaled by
+  // its own factor.
+  Status AggregateTensorBatch(
+      absl::Span<const InputTensorList> batch) override {
+    return TensorAggregator::AggregateTensorBatch(batch);
+  }
+
+  OutputTensorList TakeOutputs() && override {
+    std::vector<T>& sum = data();
+    if (noise_stddev_ > 0) {
+      GaussianMechanism::Builder gaussian_builder;
+      gaussian_builder.SetStandardDeviation(noise_stddev_);
+      // The standard deviation was validated by the factory.
+      StatusOr<std::unique_ptr<NumericalMechanism>> mechanism =
+          gaussian_builder.Build();
+      TFF_CHECK(mechanism.ok()) << mechanism.status();
+      // The DP library only samples one value per call, so every element is
+      // noised by its own call. The mechanism also rounds the element to the
+      // granularity of its noise, which a batch of samples from a generic
+      // Gaussian generator added to the sum would not.
+      for (T& value : sum) {
+        value = static_cast<T>((*mechanism)->AddNoise(value));
+      }
+    }
+    if (mean_ && this->GetNumInputs() > 0) {
+      const T divisor = static_cast<T>(this->GetNumInputs());
+      for (T& value : sum) {
+        value /= divisor;
+      }
+    }
+    return std::move(*this).AggVectorAggregator<T>::TakeOutputs();
+  }
+
+ private:
+  // Adds the client input `agg_vector` scaled by the factor that bounds its
+  // L2 norm. The norm is accumulated in kNumNormLanes independent partial
+  // sums and then added in a plain elementwise loop, so that compilers can
+  // vectorize both passes.
+  void AggregateVector(const AggVector<T>& agg_vector) override {
+    constexpr size_t kNumNormLanes = 4;
+    double squared_l2_lanes[kNumNormLanes] = {};
+    auto add_squares = [&squared_l2_lanes](absl::Span<const T> values) {
+      size_t i = 0;
+      for (; i + kNumNormLanes <= values.size(); i += kNumNormLanes) {
+        for (size_t lane = 0; lane < kNumNormLanes; ++lane) {
+          const double value = static_cast<double>(values[i + lane]);
+          squared_l2_lanes[lane] += value * value;
+        }
+      }
+      for (; i < values.size(); ++i) {
+        const double value = static_cast<double>(values[i]);
+        squared_l2_lanes[0] += value * value;
+      }
+    };
+    if (agg_vector.is_dense()) {
+      add_squares(agg_vector.dense_values());
+    } else {
+      agg_vector.ForEachRun(
+          [&add_squares](size_t start_index, absl::Span<const T> values) {
+            add_squares(values);
+          });
+    }
+    const double l2 = std::sqrt((squared_l2_lanes[0] + squared_l2_lanes[1]) +
+                                (squared_l2_lanes[2] + squared_l2_lanes[3]));
+    const T scale =
+        l2 > l2_bound_ ? static_cast<T>(l2_bound_ / l2) : static_cast<T>(1);
+
+    T* sum = data().data();
+    auto add_values = [sum, scale](absl::Span<const T> values, size_t offset) {
+      for (size_t i = 0; i < values.size(); ++i) {
+        sum[offset + i] += values[i] * scale;
+      }
+    };
+    if (agg_vector.is_dense()) {
+      this->ForEachDenseChunk(agg_vector, add_values);
+      return;
+    }
+    agg_vector.ForEachRun(
+        [&add_values](size_t start_index, absl::Span<const T> values) {
+          add_values(values, start_index);
+        });
+  }
+
+  // Adds the sums of merged aggregators, which were clipped when they were
+  // accumulated.
+  void AggregateVectors(absl::Span<const AggVector<T>> agg_vectors) override {
+    T* sum = data().data();
+    for (const AggVector<T>& agg_vector : agg_vectors) {
+      this->ForEachDenseChunk(
+          agg_vector, [sum](absl::Span<const T> values, size_t offset) {
+            for (size_t i = 0; i < values.size(); ++i) {
+              sum[offset + i] += values[i];
+            }
+          });
+    }
+  }
+
+  // The initial data is all zeros.
+  bool InitialDataIsIdentity() const override { return true; }
+
+  const double l2_bound_;
+  const double noise_stddev_;
+  const bool mean_;
+};
+
+// Factory class for the DPFederatedSum, which expects the parameters
+// epsilon, delta and the L2 bound of each client input, in this order.
+class DPFederatedSumFactory final : public TensorAggregatorFactory {
+ public:
+  DPFederatedSumFactory() = default;
+
+  // DPFederatedSumFactory isn't copyable or moveable.
+  DPFederatedSumFactory(const DPFederatedSumFactory&) = delete;
+  DPFederatedSumFactory& operator=(const DPFederatedSumFactory&) = delete;
+
+  StatusOr<std::unique_ptr<TensorAggregator>> Create(
+      const Intrinsic& intrinsic) const override {
+    return CreateInternal(intrinsic, nullptr);
+  }
+
+  StatusOr<std::unique_ptr<TensorAggregator>> Deserialize(
+      const Intrinsic& intrinsic, std::string serialized_state) const override {
+    AggVectorAggregatorState aggregator_state;
+    if (!aggregator_state.ParseFromString(serialized_state)) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Failed to deserialize the "
+                "AggVectorAggregatorState.";
+    }
+    return CreateInternal(intrinsic, &aggregator_state);
+  }
+
+ private:
+  StatusOr<std::unique_ptr<TensorAggregator>> CreateInternal(
+      const Intrinsic& intrinsic,
+      const AggVectorAggregatorState* aggregator_state) const {
+    if (intrinsic.uri != kDPFederatedSumUri &&
+        intrinsic.uri != kDPFederatedMeanUri) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Expected intrinsic URI "
+             << kDPFederatedSumUri << " or " << kDPFederatedMeanUri
+             << " but got uri " << intrinsic.uri;
+    }
+    const bool mean = intrinsic.uri == kDPFederatedMeanUri;
+    if (intrinsic.inputs.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Exactly one input is expected.";
+    }
+    if (intrinsic.outputs.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Exactly one output tensor is expected.";
+    }
+    if (!intrinsic.nested_intrinsics.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Expected no nested intrinsics.";
+    }
+
+    constexpr int64_t kEpsilonIndex = 0;
+    constexpr int64_t kDeltaIndex = 1;
+    constexpr int64_t kL2BoundIndex = 2;
+    constexpr int kNumParameters = 3;
+    if (intrinsic.parameters.size() != kNumParameters) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Expected " << kNumParameters
+             << " parameters but got " << intrinsic.parameters.size()
+             << " of them.";
+    }
+    for (const Tensor& parameter : intrinsic.parameters) {
+      if (internal::GetTypeKind(parameter.dtype()) !=
+          internal::TypeKind::kNumeric) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "DPFederatedSumFactory: Epsilon, delta and the L2 bound "
+                  "must be numerical.";
+      }
+    }
+    double epsilon = intrinsic.parameters[kEpsilonIndex].CastToScalar<double>();
+    if (epsilon <= 0) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Epsilon must be positive.";
+    }
+    double delta = intrinsic.parameters[kDeltaIndex].CastToScalar<double>();
+    if (delta <= 0 || delta >= 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Delta must lie between 0 and 1.";
+    }
+    double l2_bound =
+        intrinsic.parameters[kL2BoundIndex].CastToScalar<double>();
+    if (l2_bound <= 0) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: L2 bound must be positive.";
+    }
+
+    // We target replacement DP, so the L2 sensitivity of the sum is twice the
+    // L2 bound of a client input. We skip noise addition if epsilon is too
+    // large to be meaningful.
+    double noise_stddev = 0;
+    if (epsilon <= kEpsilonThreshold) {
+      noise_stddev =
+          GaussianMechanism::CalculateStddev(epsilon, delta, 2.0 * l2_bound);
+      GaussianMechanism::Builder gaussian_builder;
+      gaussian_builder.SetStandardDeviation(noise_stddev);
+      TFF_RETURN_IF_ERROR(gaussian_builder.Build().status());
+    }
+
+    const TensorSpec& input_spec = intrinsic.inputs[0];
+    const TensorSpec& output_spec = intrinsic.outputs[0];
+    if (input_spec.dtype() != output_spec.dtype() ||
+        input_spec.shape() != output_spec.shape()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Input and output tensors have "
+                "mismatched specs.";
+    }
+    if (input_spec.dtype() != DT_FLOAT && input_spec.dtype() != DT_DOUBLE) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "DPFederatedSumFactory: Only floating point tensors are "
+                "supported.";
+    }
+
+    std::unique_ptr<TensorAggregator> aggregator;
+    if (aggregator_state == nullptr) {
+      FLOATING_ONLY_DTYPE_CASES(
+          input_spec.dtype(), T,
+          aggregator = std::make_unique<DPFederatedSum<T>>(
+              input_spec.dtype(), input_spec.shape(), l2_bound, noise_stddev,
+              mean));
+      return aggregator;
+    }
+
+    FLOATING_ONLY_DTYPE_CASES(
+        input_spec.dtype(), T,
+        aggregator = std::make_unique<DPFederatedSum<T>>(
+            input_spec.dtype(), input_spec.shape(), l2_bound, noise_stddev,
+            mean,
+            MutableVectorData<T>::CreateFromEncodedContent(
+                aggregator_state->vector_data()),
+            aggregator_state->num_inputs()));
+    return aggregator;
+  }
+};
+
+static auto unused = ::tensorflow_federated::aggregation::internal::Registrar<
+    DPFederatedSumFactory>(kDPFederatedSumUri);
+static auto unused_mean =
+    ::tensorflow_federated::aggregation::internal::Registrar<
+        DPFederatedSumFactory>(kDPFederatedMeanUri);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "algorithms/numerical-mechanisms.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dp_fedsql_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+// An epsilon large enough that no noise is added.
+constexpr double kNoNoiseEpsilon = 100;
+
+std::vector<Tensor> CreateParameters(double epsilon, double delta,
+                                     double l2_bound) {
+  std::vector<Tensor> parameters;
+  parameters.push_back(
+      Tensor::Create(DT_DOUBLE, {}, CreateTestData<double>({epsilon})).value());
+  parameters.push_back(
+      Tensor::Create(DT_DOUBLE, {}, CreateTestData<double>({delta})).value());
+  parameters.push_back(
+      Tensor::Create(DT_DOUBLE, {}, CreateTestData<double>({l2_bound}))
+          .value());
+  return parameters;
+}
+
+Intrinsic CreateIntrinsic(std::string uri, double epsilon, double delta,
+                          double l2_bound, DataType dtype = DT_DOUBLE,
+                          TensorShape shape = {2}) {
+  return Intrinsic{std::move(uri),
+                   {TensorSpec{"foo", dtype, shape}},
+                   {TensorSpec{"foo_out", dtype, shape}},
+                   CreateParameters(epsilon, delta, l2_bound),
+                   {}};
+}
+
+TEST(DPFederatedSumTest, ClipsInputsToL2Bound) {
+  auto aggregator =
+      CreateTensorAggregator(CreateIntrinsic(kDPFederatedSumUri,
+                                             kNoNoiseEpsilon, 1e-5, 2.5))
+          .value();
+  // (3, 4) has L2 norm 5 and gets scaled by 2.5 / 5, while (1, 0) is within
+  // the bound.
+  Tensor t1 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({3, 4})).value();
+  Tensor t2 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({1, 0})).value();
+  EXPECT_THAT(aggregator->Accumulate(t1), IsOk());
+  EXPECT_THAT(aggregator->Accumulate(t2), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value().size(), Eq(1));
+  EXPECT_THAT(result.value()[0], IsTensor<double>({2}, {2.5, 2}));
+}
+
+TEST(DPFederatedSumTest, ClipsSparseInputsToL2Bound) {
+  auto aggregator =
+      CreateTensorAggregator(CreateIntrinsic(kDPFederatedSumUri,
+                                             kNoNoiseEpsilon, 1e-5, 2.5,
+                                             DT_FLOAT, {4}))
+          .value();
+  Tensor t = Tensor::CreateSparse(DT_FLOAT, {4}, CreateTestData<float>({3, 4}),
+                                  CreateTestData<int64_t>({1, 3}))
+                 .value();
+  EXPECT_THAT(aggregator->Accumulate(t), IsOk());
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<float>({4}, {0, 1.5, 0, 2}));
+}
+
+TEST(DPFederatedSumTest, ClipsEachInputOfBatch) {
+  auto aggregator =
+      CreateTensorAggregator(CreateIntrinsic(kDPFederatedSumUri,
+                                             kNoNoiseEpsilon, 1e-5, 2.5))
+          .value();
+  Tensor t1 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({3, 4})).value();
+  Tensor t2 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({0, 10})).value();
+  InputTensorList batch[] = {InputTensorList({&t1}), InputTensorList({&t2})};
+  EXPECT_THAT(aggregator->AccumulateBatch(batch), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<double>({2}, {1.5, 4.5}));
+}
+
+TEST(DPFederatedSumTest, MeanDividesByNumInputs) {
+  auto aggregator =
+      CreateTensorAggregator(CreateIntrinsic(kDPFederatedMeanUri,
+                                             kNoNoiseEpsilon, 1e-5, 2.5))
+          .value();
+  Tensor t1 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({3, 4})).value();
+  Tensor t2 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({1, 0})).value();
+  EXPECT_THAT(aggregator->Accumulate(t1), IsOk());
+  EXPECT_THAT(aggregator->Accumulate(t2), IsOk());
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<double>({2}, {1.25, 1}));
+}
+
+TEST(DPFederatedSumTest, MergeDoesNotClipAgain) {
+  Intrinsic intrinsic =
+      CreateIntrinsic(kDPFederatedSumUri, kNoNoiseEpsilon, 1e-5, 2.5);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  auto other = CreateTensorAggregator(intrinsic).value();
+  Tensor t =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({3, 4})).value();
+  EXPECT_THAT(aggregator->Accumulate(t), IsOk());
+  EXPECT_THAT(other->Accumulate(t), IsOk());
+  EXPECT_THAT(aggregator->MergeWith(std::move(*other)), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(2));
+
+  // The merged sum (3, 4) exceeds the L2 bound but is not clipped.
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<double>({2}, {3, 4}));
+}
+
+TEST(DPFederatedSumTest, SerializeDeserialize_Succeeds) {
+  Intrinsic intrinsic =
+      CreateIntrinsic(kDPFederatedSumUri, kNoNoiseEpsilon, 1e-5, 2.5);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  Tensor t1 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({3, 4})).value();
+  Tensor t2 =
+      Tensor::Create(DT_DOUBLE, {2}, CreateTestData<double>({1, 0})).value();
+  EXPECT_THAT(aggregator->Accumulate(t1), IsOk());
+
+  auto serialized_state = std::move(*aggregator).Serialize();
+  auto deserialized_aggregator =
+      DeserializeTensorAggregator(intrinsic, serialized_state.value()).value();
+  EXPECT_THAT(deserialized_aggregator->Accumulate(t2), IsOk());
+  EXPECT_THAT(deserialized_aggregator->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*deserialized_aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<double>({2}, {2.5, 2}));
+}
+
+TEST(DPFederatedSumTest, AddsGaussianNoiseOnReport) {
+  constexpr int64_t kNumElements = 10000;
+  constexpr double kEpsilon = 1.0;
+  constexpr double kDelta = 1e-5;
+  constexpr double kL2Bound = 1.0;
+  auto aggregator =
+      CreateTensorAggregator(CreateIntrinsic(kDPFederatedSumUri, kEpsilon,
+                                             kDelta, kL2Bound, DT_DOUBLE,
+                                             {kNumElements}))
+          .value();
+  Tensor zeros =
+      Tensor::Create(DT_DOUBLE, {kNumElements},
+                     std::make_unique<MutableVectorData<double>>(kNumElements))
+          .value();
+  EXPECT_THAT(aggregator->Accumulate(zeros), IsOk());
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  double sum_of_squares = 0;
+  for (double value : result.value()[0].AsSpan<double>()) {
+    sum_of_squares += value * value;
+  }
+  // The sensitivity of the sum is twice the L2 bound of each input.
+  const double expected_stddev =
+      differential_privacy::GaussianMechanism::CalculateStddev(
+          kEpsilon, kDelta, 2 * kL2Bound);
+  const double stddev = std::sqrt(sum_of_squares / kNumElements);
+  EXPECT_GT(stddev, 0.9 * expected_stddev);
+  EXPECT_LT(stddev, 1.1 * expected_stddev);
+}
+
+TEST(DPFederatedSumTest, CreateWithInvalidParameters_Fails) {
+  EXPECT_THAT(CreateTensorAggregator(
+                  CreateIntrinsic(kDPFederatedSumUri, 0, 1e-5, 2.5)),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("Epsilon")));
+  EXPECT_THAT(
+      CreateTensorAggregator(CreateIntrinsic(kDPFederatedSumUri, 1, 1, 2.5)),
+      StatusIs(INVALID_ARGUMENT, HasSubstr("Delta")));
+  EXPECT_THAT(
+      CreateTensorAggregator(CreateIntrinsic(kDPFederatedSumUri, 1, 1e-5, 0)),
+      StatusIs(INVALID_ARGUMENT, HasSubstr("L2 bound")));
+
+  Intrinsic missing_parameter =
+      CreateIntrinsic(kDPFederatedSumUri, 1, 1e-5, 2.5);
+  missing_parameter.parameters.pop_back();
+  EXPECT_THAT(CreateTensorAggregator(missing_parameter),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("parameters")));
+}
+
+TEST(DPFederatedSumTest, CreateWithIntegerTensors_Fails) {
+  EXPECT_THAT(CreateTensorAggregator(CreateIntrinsic(
+                  kDPFederatedSumUri, 1, 1e-5, 2.5, DT_INT32)),
+              StatusIs(INVALID_ARGUMENT, HasSubstr("floating point")));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
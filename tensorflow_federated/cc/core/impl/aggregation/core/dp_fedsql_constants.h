@@ -36,6 +36,14 @@ constexpr int kLinfinityIndex = 0;
 constexpr int kL1Index = 1;
 constexpr int kL2Index = 2;
 
+// URIs of DPFederatedSum and its mean variant, which aggregate dense tensors
+// with per-client L2 clipping and Gaussian noise.
+constexpr char kDPFederatedSumUri[] = "dp_federated_sum";
+constexpr char kDPFederatedMeanUri[] = "dp_federated_mean";
+
+// The epsilon beyond which we will not use DP noise
+constexpr double kEpsilonThreshold = 20.0;
+
 }  // namespace aggregation
 }  // namespace tensorflow_federated
 
@@ -16,6 +16,7 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/core/dp_group_by_aggregator.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
@@ -25,14 +26,15 @@
 #include <utility>
 #include <vector>
 
-#include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/types/span.h"
 #include "algorithms/numerical-mechanisms.h"
 #include "algorithms/partition-selection.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/dp_composite_key_combiner.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/dp_fedsql_constants.h"
@@ -46,7 +48,6 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
-#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_string_data.h"
 
 namespace tensorflow_federated {
 namespace aggregation {
@@ -55,27 +56,50 @@ using ::differential_privacy::NumericalMechanism;
 using ::differential_privacy::sign;
 
 namespace internal {
-// The epsilon beyond which we will not use DP noise
-constexpr double kEpsilonThreshold = 20.0;
 using ::differential_privacy::GaussianMechanism;
 using ::differential_privacy::GaussianPartitionSelection;
 using ::differential_privacy::LaplaceMechanism;
 using ::differential_privacy::SafeAdd;
 
 // Struct to contain the components of the noise and threshold algorithm:
-// - A pointer to a NumericalMechanism object which introduces DP noise for one
+// - The parameters of a NumericalMechanism which introduces DP noise for one
 //   summation that satisfies replacement DP. The distribution will either be
 //   Laplace or Gaussian, whichever has less variance for the same DP parameters
+//   and is indicated by use_laplace. Mechanisms are created with
+//   CreateMechanism.
 // - A threshold below which noisy sums will be erased. The thresholding step
 //   consumes some or all of the delta that a customer provides.
-// - Also holds a boolean to indicate which noise is used.
 template <typename OutputType>
 struct NoiseAndThresholdBundle {
-  std::unique_ptr<NumericalMechanism> mechanism;
   OutputType threshold;
   bool use_laplace;
+  // Parameters of the Laplace mechanism.
+  double epsilon;
+  double l1_sensitivity;
+  // Parameter of the Gaussian mechanism.
+  double gaussian_stdev;
 };
 
+// Creates a mechanism that adds the noise described by `bundle`. Each call
+// returns an independent mechanism with its own source of randomness, so that
+// different groups can be noised concurrently by different mechanisms.
+template <typename OutputType>
+StatusOr<std::unique_ptr<NumericalMechanism>> CreateMechanism(
+    const NoiseAndThresholdBundle<OutputType>& bundle) {
+  std::unique_ptr<NumericalMechanism> mechanism;
+  if (bundle.use_laplace) {
+    LaplaceMechanism::Builder laplace_builder;
+    laplace_builder.SetL1Sensitivity(bundle.l1_sensitivity)
+        .SetEpsilon(bundle.epsilon);
+    TFF_ASSIGN_OR_RETURN(mechanism, laplace_builder.Build());
+  } else {
+    GaussianMechanism::Builder gaussian_builder;
+    gaussian_builder.SetStandardDeviation(bundle.gaussian_stdev);
+    TFF_ASSIGN_OR_RETURN(mechanism, gaussian_builder.Build());
+  }
+  return mechanism;
+}
+
 // Derive NoiseAndThresholdBundle from privacy parameters and clipping norms.
 template <typename OutputType>
 StatusOr<NoiseAndThresholdBundle<OutputType>> SetupNoiseAndThreshold(
@@ -115,6 +139,8 @@ StatusOr<NoiseAndThresholdBundle<OutputType>> SetupNoiseAndThreshold(
   }
 
   NoiseAndThresholdBundle<OutputType> output;
+  output.epsilon = epsilon;
+  output.l1_sensitivity = l1_sensitivity;
 
   // Pick the mechanism that will add noise with smaller standard deviation.
   TFF_CHECK(epsilon > 0) << "epsilon must be greater than 0";
@@ -123,15 +149,16 @@ StatusOr<NoiseAndThresholdBundle<OutputType>> SetupNoiseAndThreshold(
   double gaussian_stdev = GaussianMechanism::CalculateStddev(
       epsilon, delta_for_noising, l2_sensitivity);
 
+  output.gaussian_stdev = gaussian_stdev;
+
   if (laplace_stdev < gaussian_stdev) {
     // If we are going to use Laplace noise,
     // 1. record that fact
     output.use_laplace = true;
 
-    // 2. use our parameters to create an object that will add that noise.
-    LaplaceMechanism::Builder laplace_builder;
-    laplace_builder.SetL1Sensitivity(l1_sensitivity).SetEpsilon(epsilon);
-    TFF_ASSIGN_OR_RETURN(output.mechanism, laplace_builder.Build());
+    // 2. make sure that our parameters can create an object that will add
+    // that noise.
+    TFF_RETURN_IF_ERROR(CreateMechanism(output).status());
 
     // 3. Calculate the threshold which we will impose on noisy sums.
     // Note that l0_sensitivity = 2 * l0_bound because we target replacement DP.
@@ -154,10 +181,9 @@ StatusOr<NoiseAndThresholdBundle<OutputType>> SetupNoiseAndThreshold(
   // 1. record that fact
   output.use_laplace = false;
 
-  // 2. use our parameters to create an object that will add that noise.
-  GaussianMechanism::Builder gaussian_builder;
-  gaussian_builder.SetStandardDeviation(gaussian_stdev);
-  TFF_ASSIGN_OR_RETURN(output.mechanism, gaussian_builder.Build());
+  // 2. make sure that our parameters can create an object that will add that
+  // noise.
+  TFF_RETURN_IF_ERROR(CreateMechanism(output).status());
 
   // 3. Calculate the threshold which we will impose on noisy sums. We use
   // GaussianPartitionSelection::CalculateThresholdFromStddev. It assumes that
@@ -183,96 +209,192 @@ StatusOr<NoiseAndThresholdBundle<OutputType>> SetupNoiseAndThreshold(
   return output;
 }
 
+// Writes each of `values` plus noise drawn from `mechanism` to the same index
+// of `noisy_values`, which must be as large as `values`.
+// Every value still gets its own draw from the mechanism's sampler, which is
+// what provides the DP guarantee. Batching lets callers resolve the mechanism
+// once per slice of values, and keeps this loop free of any other per-value
+// work such as thresholding.
+template <typename OutputType>
+void AddNoiseToValues(NumericalMechanism& mechanism,
+                      absl::Span<const OutputType> values,
+                      absl::Span<OutputType> noisy_values) {
+  TFF_CHECK(noisy_values.size() == values.size())
+      << "AddNoiseToValues: noisy_values must be as large as values";
+  const OutputType* input = values.data();
+  OutputType* output = noisy_values.data();
+  for (size_t i = 0; i < values.size(); ++i) {
+    output[i] = mechanism.AddNoise(input[i]);
+  }
+}
+
 // Noise is added to each value stored in a column tensor. If the noised value
-// falls below a given threshold, then the index of that value is removed from a
-// set of survivors.
-// NoiseAndThreshold will be called by DPGroupByAggregator::Report on multiple
-// tensors. Upon completion, Report will copy a value at index i in an output
-// tensor of NoiseAndThreshold if i is in the set of survivors.
-// NB: It is possible to write NoiseAndThreshold to cull values that lie below
-// a threshold, but the i-th item of column 1 might not correspond to the i-th
-// item of column 2. So we defer the culling step until we know all indices of
-// the survivors.
+// falls below a given threshold, then the survivor flag of that value's group
+// is cleared.
+// A ColumnNoiser is created by DPGroupByAggregator::Report for each
+// aggregation. Upon completion, Report will copy the values of a group to the
+// output tensors if its survivor flag is still set.
+// NB: It is possible to cull values that lie below a threshold column by
+// column, but the i-th item of column 1 might not correspond to the i-th item
+// of column 2. So we defer the culling step until we know all the survivors.
+//
+// The groups are noised shard by shard, and each shard has its own mechanism
+// so that shards can be noised concurrently.
+class ColumnNoiser {
+ public:
+  virtual ~ColumnNoiser() = default;
+
+  // Noises the values of the groups in [begin, end) with the mechanism of
+  // `shard`, and clears the flags in `survivors` of the groups whose noisy
+  // value is below the threshold.
+  virtual void NoiseShard(size_t shard, size_t begin, size_t end,
+                          uint8_t* survivors) = 0;
+
+  // Returns the noisy values of all groups, once all shards are noised.
+  virtual StatusOr<Tensor> TakeNoisyValues() = 0;
+};
+
 // References: The document Delta_For_Thresholding.pdf found in
 // https://github.com/google/differential-privacy/blob/main/common_docs/ has a
 // proof for the case where inputs are positive; our use of sign() generalizes
 // the analysis to the non-positive case.
 template <typename OutputType>
-StatusOr<Tensor> NoiseAndThreshold(
-    double epsilon, double delta, int64_t l0_bound, OutputType linfinity_bound,
-    double l1_bound, double l2_bound, const Tensor& column_tensor,
-    absl::flat_hash_set<size_t>& survivor_indices,
-    std::vector<bool>& laplace_was_used) {
-  TFF_ASSIGN_OR_RETURN(
-      auto bundle, SetupNoiseAndThreshold(epsilon, delta, l0_bound,
-                                          linfinity_bound, l1_bound, l2_bound));
-  laplace_was_used.push_back(bundle.use_laplace);
+class TypedColumnNoiser final : public ColumnNoiser {
+ public:
+  // Creates a ColumnNoiser for the values of `column_tensor` with `num_shards`
+  // independent mechanisms, and records which noise is used.
+  static StatusOr<std::unique_ptr<ColumnNoiser>> Create(
+      double epsilon, double delta, int64_t l0_bound,
+      OutputType linfinity_bound, double l1_bound, double l2_bound,
+      const Tensor& column_tensor, size_t num_shards,
+      std::vector<bool>& laplace_was_used) {
+    TFF_ASSIGN_OR_RETURN(
+        auto bundle,
+        SetupNoiseAndThreshold(epsilon, delta, l0_bound, linfinity_bound,
+                               l1_bound, l2_bound));
+    laplace_was_used.push_back(bundle.use_laplace);
+    std::vector<std::unique_ptr<NumericalMechanism>> mechanisms;
+    mechanisms.reserve(num_shards);
+    for (size_t shard = 0; shard < num_shards; ++shard) {
+      TFF_ASSIGN_OR_RETURN(std::unique_ptr<NumericalMechanism> mechanism,
+                           CreateMechanism(bundle));
+      mechanisms.push_back(std::move(mechanism));
+    }
+    return std::unique_ptr<ColumnNoiser>(
+        new TypedColumnNoiser(column_tensor.AsSpan<OutputType>(),
+                              bundle.threshold, std::move(mechanisms)));
+  }
 
-  OutputType threshold = bundle.threshold;
+  void NoiseShard(size_t shard, size_t begin, size_t end,
+                  uint8_t* survivors) override {
+    // Add noise to the whole shard and store the noisy values
+    std::vector<OutputType>& noisy_values = *noisy_values_;
+    AddNoiseToValues<OutputType>(
+        *mechanisms_[shard], column_.subspan(begin, end - begin),
+        absl::MakeSpan(noisy_values).subspan(begin, end - begin));
+
+    // If threshold is not crossed, the group doesn't survive
+    for (size_t i = begin; i < end; ++i) {
+      OutputType sign_of_value = sign<OutputType>(column_[i]);
+      if (sign_of_value * noisy_values[i] < threshold_) {
+        survivors[i] = 0;
+      }
+    }
+  }
 
-  auto column_span = column_tensor.AsSpan<OutputType>();
-  auto noisy_values = std::make_unique<MutableVectorData<OutputType>>();
-  noisy_values->reserve(column_span.size());
+  StatusOr<Tensor> TakeNoisyValues() override {
+    return Tensor::Create(internal::TypeTraits<OutputType>::kDataType,
+                          {static_cast<int64_t>(column_.size())},
+                          std::move(noisy_values_));
+  }
 
-  // For every value in the column,
-  for (size_t i = 0; i < column_span.size(); i++) {
-    OutputType value = column_span[i];
+ private:
+  TypedColumnNoiser(absl::Span<const OutputType> column, OutputType threshold,
+                    std::vector<std::unique_ptr<NumericalMechanism>> mechanisms)
+      : column_(column),
+        threshold_(threshold),
+        mechanisms_(std::move(mechanisms)),
+        noisy_values_(
+            std::make_unique<MutableVectorData<OutputType>>(column.size())) {}
+
+  const absl::Span<const OutputType> column_;
+  const OutputType threshold_;
+  std::vector<std::unique_ptr<NumericalMechanism>> mechanisms_;
+  std::unique_ptr<MutableVectorData<OutputType>> noisy_values_;
+};
 
-    // Add noise and store noisy value
-    OutputType noisy_value = (bundle.mechanism)->AddNoise(value);
-    noisy_values->push_back(noisy_value);
+// Copies the values of a column tensor whose groups survived to a new tensor,
+// shard by shard, so that shards can be copied concurrently.
+class ColumnCompactor {
+ public:
+  virtual ~ColumnCompactor() = default;
 
-    // If threshold is not crossed, index does not belong in survivor_indices
-    OutputType sign_of_value = sign<OutputType>(value);
-    if (sign_of_value * noisy_value < threshold) {
-      survivor_indices.erase(i);
-    }
-  }
-  return Tensor::Create(internal::TypeTraits<OutputType>::kDataType,
-                        {static_cast<int64_t>(column_span.size())},
-                        std::move(noisy_values));
-}
+  // Copies the values of the surviving groups in [begin, end) to the output,
+  // starting at `output_index`.
+  virtual void CompactShard(const uint8_t* survivors, size_t begin, size_t end,
+                            size_t output_index) = 0;
+
+  // Returns the output, once all shards are copied.
+  virtual StatusOr<Tensor> TakeOutput() = 0;
+};
 
-// Given a column tensor, copy elements whose indices belong to a set of
-// survivors to a new tensor.
 template <typename OutputType>
-StatusOr<Tensor> CopyOnlySurvivors(
-    const Tensor& column_tensor,
-    const absl::flat_hash_set<size_t>& survivor_indices) {
-  auto column_span = column_tensor.AsSpan<OutputType>();
-  auto dest = std::make_unique<MutableVectorData<OutputType>>();
-  dest->reserve(survivor_indices.size());
-  for (size_t i = 0; i < column_span.size(); i++) {
-    if (!survivor_indices.contains(i)) {
-      continue;
+class TypedColumnCompactor final : public ColumnCompactor {
+ public:
+  TypedColumnCompactor(const Tensor& column_tensor, size_t num_survivors)
+      : column_(column_tensor.AsSpan<OutputType>()),
+        output_(
+            std::make_unique<MutableVectorData<OutputType>>(num_survivors)) {}
+
+  void CompactShard(const uint8_t* survivors, size_t begin, size_t end,
+                    size_t output_index) override {
+    std::vector<OutputType>& output = *output_;
+    for (size_t i = begin; i < end; ++i) {
+      if (survivors[i]) {
+        output[output_index++] = column_[i];
+      }
     }
-    dest->push_back(column_span[i]);
   }
-  return Tensor::Create(internal::TypeTraits<OutputType>::kDataType,
-                        {static_cast<int64_t>(survivor_indices.size())},
-                        std::move(dest));
-}
-// Specialization for string_view. First make a vector of surviving std::strings
-// from the string_views and survivor_indices, then create a Tensor by moving
-// the contents to an intermediate VectorStringData object.
+
+  StatusOr<Tensor> TakeOutput() override {
+    const int64_t num_survivors = static_cast<int64_t>(output_->size());
+    return Tensor::Create(internal::TypeTraits<OutputType>::kDataType,
+                          {num_survivors}, std::move(output_));
+  }
+
+ private:
+  const absl::Span<const OutputType> column_;
+  std::unique_ptr<MutableVectorData<OutputType>> output_;
+};
+
+// Specialization for string_view. The views of the surviving strings are
+// collected, and the strings are then copied to a single buffer owned by the
+// output.
 template <>
-StatusOr<Tensor> CopyOnlySurvivors<string_view>(
-    const Tensor& column_tensor,
-    const absl::flat_hash_set<size_t>& survivor_indices) {
-  auto column_span = column_tensor.AsSpan<string_view>();
-  std::vector<std::string> strings_for_output;
-  strings_for_output.reserve(survivor_indices.size());
-  for (size_t i = 0; i < column_span.size(); i++) {
-    if (!survivor_indices.contains(i)) {
-      continue;
+class TypedColumnCompactor<string_view> final : public ColumnCompactor {
+ public:
+  TypedColumnCompactor(const Tensor& column_tensor, size_t num_survivors)
+      : column_(column_tensor.AsSpan<string_view>()), output_(num_survivors) {}
+
+  void CompactShard(const uint8_t* survivors, size_t begin, size_t end,
+                    size_t output_index) override {
+    for (size_t i = begin; i < end; ++i) {
+      if (survivors[i]) {
+        output_[output_index++] = column_[i];
+      }
     }
-    strings_for_output.push_back(std::string(column_span[i]));
   }
 
-  return Tensor::Create(
-      DT_STRING, {static_cast<int64_t>(survivor_indices.size())},
-      std::make_unique<VectorStringData>(std::move(strings_for_output)));
-}
+  StatusOr<Tensor> TakeOutput() override {
+    const int64_t num_survivors = static_cast<int64_t>(output_.size());
+    return Tensor::Create(DT_STRING, {num_survivors},
+                          std::make_unique<ContiguousStringData>(output_));
+  }
+
+ private:
+  const absl::Span<const string_view> column_;
+  std::vector<string_view> output_;
+};
 }  // namespace internal
 
 DPGroupByAggregator::DPGroupByAggregator(
@@ -309,6 +431,12 @@ DPGroupByAggregator::CreateDPKeyCombiner(
       l0_bound);
 }
 
+std::unique_ptr<CompositeKeyCombiner>
+DPGroupByAggregator::CreateEmptyKeyCombiner() const {
+  return CreateDPKeyCombiner(output_key_specs(), &output_key_specs(),
+                             l0_bound_);
+}
+
 StatusOr<Tensor> DPGroupByAggregator::CreateOrdinalsByGroupingKeysForMerge(
     const InputTensorList& inputs) {
   if (num_keys_per_input() > 0) {
@@ -338,7 +466,7 @@ StatusOr<OutputTensorList> DPGroupByAggregator::Report() && {
   OutputTensorList noiseless_aggregate = std::move(*this).TakeOutputs();
 
   // We skip noise addition if epsilon is too large to be meaningful
-  if (epsilon_per_agg_ > internal::kEpsilonThreshold) {
+  if (epsilon_per_agg_ > kEpsilonThreshold) {
     return noiseless_aggregate;
   }
 
@@ -351,59 +479,117 @@ StatusOr<OutputTensorList> DPGroupByAggregator::Report() && {
     num_output_keys++;
   }
 
-  // Create a set of indices, one for each composite key in the histogram.
-  absl::flat_hash_set<size_t> survivor_indices;
-  for (size_t i = 0; i < noiseless_aggregate[0].num_elements(); i++) {
-    survivor_indices.insert(i);
-  }
-
-  // For each aggregation, run NoiseAndThreshold to populate a list of Tensors
-  OutputTensorList noisy_values;
-  noisy_values.reserve(num_aggregations);
+  // Split the groups into shards of consecutive groups, which are noised and
+  // compacted independently. The shards only depend on the number of groups,
+  // not on the number of tasks.
+  const size_t num_groups = noiseless_aggregate[0].num_elements();
+  const size_t shard_size = report_scheduler_ == nullptr
+                                ? std::max<size_t>(num_groups, 1)
+                                : report_shard_size_;
+  const size_t num_shards = (num_groups + shard_size - 1) / shard_size;
+
+  // For each aggregation, create a ColumnNoiser with a mechanism per shard.
+  std::vector<std::unique_ptr<internal::ColumnNoiser>> noisers;
+  noisers.reserve(num_aggregations);
   for (int j = 0; j < num_aggregations; ++j) {
     const auto& inner_parameters = intrinsics()[j].parameters;
     const Tensor& linfinity_tensor = inner_parameters[kLinfinityIndex];
     double l1_bound = inner_parameters[kL1Index].CastToScalar<double>();
     double l2_bound = inner_parameters[kL2Index].CastToScalar<double>();
     size_t column = num_output_keys + j;
-    StatusOr<Tensor> tensor;
+    StatusOr<std::unique_ptr<internal::ColumnNoiser>> noiser;
     NUMERICAL_ONLY_DTYPE_CASES(
         noiseless_aggregate[column].dtype(), OutputType,
-        TFF_ASSIGN_OR_RETURN(
-            tensor, internal::NoiseAndThreshold<OutputType>(
-                        epsilon_per_agg_, delta_per_agg_, l0_bound_,
-                        linfinity_tensor.CastToScalar<OutputType>(), l1_bound,
-                        l2_bound, noiseless_aggregate[column], survivor_indices,
-                        laplace_was_used_)));
-    noisy_values.push_back(std::move(tensor.value()));
+        noiser = internal::TypedColumnNoiser<OutputType>::Create(
+            epsilon_per_agg_, delta_per_agg_, l0_bound_,
+            linfinity_tensor.CastToScalar<OutputType>(), l1_bound, l2_bound,
+            noiseless_aggregate[column], num_shards, laplace_was_used_));
+    TFF_RETURN_IF_ERROR(noiser.status());
+    noisers.push_back(std::move(noiser.value()));
   }
 
-  // When there are no grouping keys, aggregation will be scalar. Hence, the
-  // sole "group" does not need to be dropped for DP (because it exists whether
-  // or not a given client contributed data)
-  if (num_keys_per_input() == 0) {
-    survivor_indices.insert(0);
+  // Noise all aggregations shard by shard. A group survives if all its noisy
+  // values cross their threshold.
+  std::vector<uint8_t> survivors(num_groups, 1);
+  std::vector<size_t> num_shard_survivors(num_shards);
+  const bool has_keys = num_keys_per_input() > 0;
+  internal::ForEachShard(
+      report_scheduler_, num_report_tasks_, num_shards, [&](size_t shard) {
+        const size_t begin = shard * shard_size;
+        const size_t end = std::min(begin + shard_size, num_groups);
+        for (const auto& noiser : noisers) {
+          noiser->NoiseShard(shard, begin, end, survivors.data());
+        }
+        // When there are no grouping keys, aggregation will be scalar. Hence,
+        // the sole "group" does not need to be dropped for DP (because it
+        // exists whether or not a given client contributed data)
+        if (!has_keys && begin == 0) {
+          survivors[0] = 1;
+        }
+        num_shard_survivors[shard] = std::count(
+            survivors.begin() + begin, survivors.begin() + end, uint8_t{1});
+      });
+
+  // The survivors of each shard are copied to the output tensors after those
+  // of the preceding shards, which preserves the order of the groups.
+  std::vector<size_t> shard_output_index(num_shards);
+  size_t num_survivors = 0;
+  for (size_t shard = 0; shard < num_shards; ++shard) {
+    shard_output_index[shard] = num_survivors;
+    num_survivors += num_shard_survivors[shard];
   }
 
+  OutputTensorList noisy_values;
+  noisy_values.reserve(num_aggregations);
+  for (const auto& noiser : noisers) {
+    TFF_ASSIGN_OR_RETURN(Tensor tensor, noiser->TakeNoisyValues());
+    noisy_values.push_back(std::move(tensor));
+  }
+  // The noiseless values aren't needed anymore, so they are released before
+  // the output is built. The noisers reference them, so they go first.
+  noisers.clear();
+  noiseless_aggregate.erase(noiseless_aggregate.begin() + num_output_keys,
+                            noiseless_aggregate.end());
+
   // Produce a new list of tensors containing only the survivors of
-  // thresholding
+  // thresholding. The columns are compacted one at a time, and each column is
+  // released once compacted, so that the report holds at most one column more
+  // than the output itself.
+  const size_t num_columns = num_output_keys + num_aggregations;
   OutputTensorList final_histogram;
-  final_histogram.reserve(noiseless_aggregate.size());
-  for (size_t j = 0; j < noiseless_aggregate.size(); j++) {
+  final_histogram.reserve(num_columns);
+  for (size_t j = 0; j < num_columns; j++) {
     // First batch of Tensors are for keys, second are for the values
-    const Tensor& column_tensor = (j < num_output_keys)
-                                      ? noiseless_aggregate[j]
-                                      : noisy_values[j - num_output_keys];
-    StatusOr<Tensor> tensor;
-    DTYPE_CASES(
-        column_tensor.dtype(), OutputType,
-        TFF_ASSIGN_OR_RETURN(tensor, internal::CopyOnlySurvivors<OutputType>(
-                                         column_tensor, survivor_indices)));
-    final_histogram.push_back(std::move(tensor.value()));
+    Tensor column_tensor = (j < num_output_keys)
+                               ? std::move(noiseless_aggregate[j])
+                               : std::move(noisy_values[j - num_output_keys]);
+    std::unique_ptr<internal::ColumnCompactor> compactor;
+    DTYPE_CASES(column_tensor.dtype(), OutputType,
+                compactor =
+                    std::make_unique<internal::TypedColumnCompactor<OutputType>>(
+                        column_tensor, num_survivors));
+    internal::ForEachShard(
+        report_scheduler_, num_report_tasks_, num_shards, [&](size_t shard) {
+          const size_t begin = shard * shard_size;
+          const size_t end = std::min(begin + shard_size, num_groups);
+          compactor->CompactShard(survivors.data(), begin, end,
+                                  shard_output_index[shard]);
+        });
+    TFF_ASSIGN_OR_RETURN(Tensor tensor, compactor->TakeOutput());
+    final_histogram.push_back(std::move(tensor));
   }
   return final_histogram;
 }
 
+void DPGroupByAggregator::SetParallelReport(Scheduler* scheduler,
+                                            int num_tasks, size_t shard_size) {
+  TFF_CHECK(shard_size > 0) << "shard_size must be positive";
+  report_scheduler_ = num_tasks > 1 ? scheduler : nullptr;
+  num_report_tasks_ = num_tasks;
+  report_shard_size_ = shard_size;
+  SetParallelOutputKeys(scheduler, num_tasks);
+}
+
 StatusOr<std::unique_ptr<TensorAggregator>> DPGroupByFactory::Create(
     const Intrinsic& intrinsic) const {
   return CreateInternal(intrinsic, nullptr);
@@ -18,6 +18,7 @@
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_DP_GROUP_BY_AGGREGATOR_H_
 
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -25,6 +26,7 @@
 
 #include "absl/status/statusor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/dp_composite_key_combiner.h"
@@ -96,6 +98,23 @@ class DPGroupByAggregator : public GroupByAggregator {
   // If called before Report(), the vector will be empty.
   std::vector<bool> laplace_was_used() const { return laplace_was_used_; }
 
+  // Default number of groups in each shard of a parallel Report.
+  static constexpr size_t kDefaultReportShardSize = 1 << 16;
+
+  // Enables parallel noising and thresholding in Report. The groups are split
+  // into shards of `shard_size` consecutive groups, each noised by its own
+  // independently seeded mechanism. The shards are processed by up to
+  // `num_tasks` tasks, including the calling thread, all but one of which are
+  // scheduled on `scheduler`; the surviving groups are then copied to the
+  // output tensors in parallel in the same order as in a serial Report.
+  // The shards only depend on `shard_size`, not on `num_tasks` or the number of
+  // threads of `scheduler`, which must outlive this aggregator. A null
+  // `scheduler` or `num_tasks` <= 1 disables parallelism, in which case all
+  // groups are noised by a single mechanism. The output keys are materialized
+  // in parallel as well, see SetParallelOutputKeys.
+  void SetParallelReport(Scheduler* scheduler, int num_tasks,
+                         size_t shard_size = kDefaultReportShardSize);
+
  protected:
   friend class DPGroupByFactory;
 
@@ -133,6 +152,14 @@ class DPGroupByAggregator : public GroupByAggregator {
   StatusOr<Tensor> CreateOrdinalsByGroupingKeysForMerge(
       const InputTensorList& inputs) override;
 
+  // Creates an empty DP key combiner with the same L0 bound, so that the
+  // inputs accumulated after the groups are spilled are bounded as well.
+  std::unique_ptr<CompositeKeyCombiner> CreateEmptyKeyCombiner() const override;
+
+  // The number of composite keys an input contributes to is bounded over all
+  // of its rows, so the rows of an input can't be accumulated by partition.
+  bool CanPartitionInputs() const override { return false; }
+
   double epsilon_per_agg_;
   double delta_per_agg_;
   int64_t l0_bound_;
@@ -141,6 +168,11 @@ class DPGroupByAggregator : public GroupByAggregator {
   // used to ensure DP for the i-th aggregation. The vector is empty before
   // Report() is called.
   std::vector<bool> laplace_was_used_;
+
+  // Parallel Report settings, see SetParallelReport.
+  Scheduler* report_scheduler_ = nullptr;
+  int num_report_tasks_ = 1;
+  size_t report_shard_size_ = kDefaultReportShardSize;
 };
 
 // Factory class for the DPGroupByAggregator.
@@ -26,7 +26,9 @@
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
@@ -47,6 +49,7 @@ namespace tensorflow_federated {
 namespace aggregation {
 namespace {
 
+using ::testing::ElementsAreArray;
 using ::testing::Eq;
 using testing::Gt;
 using ::testing::HasSubstr;
@@ -698,6 +701,57 @@ TEST_P(DPGroupByAggregatorTest, NoiseAddedForSmallEpsilons) {
   EXPECT_TRUE(values[0] != num_inputs || values[1] != num_inputs);
 }
 
+// Check that a parallel Report drops the same groups as a serial one would and
+// keeps the surviving groups in order. Each input holds a group that survives
+// thresholding (its sum is 200) and a group that doesn't (its sum is 0), so the
+// chance that a group lands on the wrong side of the threshold is negligible.
+TEST_P(DPGroupByAggregatorTest, ParallelReportKeepsOrderOfSurvivors) {
+  Intrinsic intrinsic = CreateIntrinsic<int32_t, int64_t>(1.0, 1e-8, 2, 1);
+  auto dpgba = CreateTensorAggregator(intrinsic).value();
+  constexpr int kNumPairs = 64;
+  std::vector<std::string> keep_keys;
+  std::vector<std::string> drop_keys;
+  for (int i = 0; i < kNumPairs; ++i) {
+    keep_keys.push_back(absl::StrCat("keep", i));
+    drop_keys.push_back(absl::StrCat("drop", i));
+  }
+  for (int i = 0; i < kNumPairs; ++i) {
+    for (int j = 0; j < 200; ++j) {
+      Tensor keys =
+          Tensor::Create(DT_STRING, {2},
+                         CreateTestData<string_view>(
+                             {keep_keys[i], drop_keys[i]}))
+              .value();
+      Tensor values = Tensor::Create(DT_INT32, {2},
+                                     CreateTestData<int32_t>({1, 0}))
+                          .value();
+      ASSERT_THAT(dpgba->Accumulate({&keys, &values}), IsOk());
+    }
+  }
+
+  if (GetParam()) {
+    auto serialized_state = std::move(*dpgba).Serialize();
+    dpgba = DeserializeTensorAggregator(intrinsic, serialized_state.value())
+                .value();
+  }
+
+  // Use shards that are much smaller than the number of groups so that every
+  // task processes several of them.
+  auto scheduler = CreateThreadPoolScheduler(3);
+  dynamic_cast<DPGroupByAggregator&>(*dpgba).SetParallelReport(
+      scheduler.get(), 4, /*shard_size=*/5);
+  auto report = std::move(*dpgba).Report();
+  scheduler->WaitUntilIdle();
+  ASSERT_THAT(report, IsOk());
+  ASSERT_EQ(report->size(), 2);
+  EXPECT_THAT(report.value()[0].AsSpan<string_view>(),
+              ElementsAreArray(keep_keys));
+  EXPECT_THAT(report.value()[1].num_elements(), Eq(kNumPairs));
+  EXPECT_THAT(
+      dynamic_cast<DPGroupByAggregator&>(*dpgba).laplace_was_used().size(),
+      Eq(1));
+}
+
 // Check that SetupNoiseAndThreshold is capable of switching between
 // distributions
 TEST_P(DPGroupByAggregatorTest, SetupNoiseAndThreshold_CorrectDistribution) {
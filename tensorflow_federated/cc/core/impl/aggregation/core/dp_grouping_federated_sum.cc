@@ -14,14 +14,17 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
@@ -69,31 +72,56 @@ class DPGroupingFederatedSum final
 
  private:
   // The following method clamps the input value to the linfinity bound.
-  inline InputT Clamp(const InputT& input_value) {
-    return std::min(std::max(input_value, -linfinity_bound_), linfinity_bound_);
+  inline InputT Clamp(const InputT& input_value) const {
+    if constexpr (std::is_unsigned_v<InputT>) {
+      // Unsigned values are only bounded above; negating the bound would wrap.
+      return std::min(input_value, linfinity_bound_);
+    } else {
+      return std::min(
+          std::max(input_value, static_cast<InputT>(-linfinity_bound_)),
+          linfinity_bound_);
+    }
   }
 
-  // The following method returns a scalar such that, when it is applied to
-  // the clamped version of local histogram, the l1 and l2 norms are at most
-  // l1_bound_ and l2_bound_.
-  inline double ComputeRescalingFactor(
-      const absl::flat_hash_map<int64_t, InputT>& local_histogram) {
+  // The following method clamps the local histogram in place and returns a
+  // scalar such that, when it is applied to the clamped histogram, the l1 and
+  // l2 norms are at most l1_bound_ and l2_bound_.
+  //
+  // Both loops are free of branches over the values, and the norms are
+  // accumulated in kNumNormLanes independent partial sums, so that compilers
+  // can vectorize them without reordering floating point additions.
+  double ClampAndComputeRescalingFactor(
+      absl::Span<InputT> local_values) const {
+    for (InputT& value : local_values) {
+      value = Clamp(value);
+    }
+
     // no re-scaling if norm bounds were not provided
     if (l1_bound_ <= 0 && l2_bound_ <= 0) {
       return 1.0;
     }
 
     // Compute norms after clamping magnitudes.
-    double l1 = 0;
-    double squared_l2 = 0;
-    for (const auto& [unused, raw_value] : local_histogram) {
-      // To do: optimize the number of Clamp calls. Currently called once in
-      // this function and again in the final loop of AggregateVectorByOrdinals.
-      InputT value = Clamp(raw_value);
-      l1 += (value < 0) ? -value : value;
-      squared_l2 += static_cast<double>(value) * static_cast<double>(value);
+    constexpr size_t kNumNormLanes = 4;
+    double l1_lanes[kNumNormLanes] = {};
+    double squared_l2_lanes[kNumNormLanes] = {};
+    const size_t num_values = local_values.size();
+    size_t i = 0;
+    for (; i + kNumNormLanes <= num_values; i += kNumNormLanes) {
+      for (size_t lane = 0; lane < kNumNormLanes; ++lane) {
+        const double value = static_cast<double>(local_values[i + lane]);
+        l1_lanes[lane] += std::abs(value);
+        squared_l2_lanes[lane] += value * value;
+      }
     }
-    double l2 = sqrt(squared_l2);
+    for (; i < num_values; ++i) {
+      const double value = static_cast<double>(local_values[i]);
+      l1_lanes[0] += std::abs(value);
+      squared_l2_lanes[0] += value * value;
+    }
+    double l1 = (l1_lanes[0] + l1_lanes[1]) + (l1_lanes[2] + l1_lanes[3]);
+    double l2 = sqrt((squared_l2_lanes[0] + squared_l2_lanes[1]) +
+                     (squared_l2_lanes[2] + squared_l2_lanes[3]));
 
     // Compute rescaling factor based on the norms.
     double rescaling_factor = 1.0;
@@ -111,34 +139,49 @@ class DPGroupingFederatedSum final
   void AggregateVectorByOrdinals(
       const AggVector<int64_t>& ordinals_vector,
       const AggVector<InputT>& value_vector) override {
-    auto value_it = value_vector.begin();
+    // The ordinals and the values are dense tensors of the same shape, which
+    // OneDimGroupingAggregator validates.
+    absl::Span<const int64_t> ordinals = ordinals_vector.dense_values();
+    absl::Span<const InputT> values = value_vector.dense_values();
 
     // Create a local histogram from ordinals & values, aggregating when there
-    // are multiple values for the same ordinal.
-    absl::flat_hash_map<int64_t, InputT> local_histogram;
-    local_histogram.reserve(ordinals_vector.size());
-    for (const auto& [index, ordinal] : ordinals_vector) {
-      TFF_CHECK(value_it.index() == index)
-          << "Indices in AggVector of ordinals and AggVector of values "
-             "are mismatched.";
-
+    // are multiple values for the same ordinal. The histogram is stored
+    // contiguously in the order in which ordinals first appear, so it can be
+    // bounded with a few passes over plain arrays. All ordinals are smaller
+    // than data().size(), since the base class resizes the data beforehand.
+    local_positions_.resize(data().size(), 0);
+    local_ordinals_.clear();
+    local_values_.clear();
+    for (size_t i = 0; i < ordinals.size(); ++i) {
+      const int64_t ordinal = ordinals[i];
       // Only aggregate values of valid ordinals.
-      if (ordinal >= 0) {
-        local_histogram[ordinal] += value_it.value();
+      if (ordinal < 0) {
+        continue;
       }
-
-      value_it++;
+      DCHECK(ordinal < data().size())
+          << "Ordinal too big: " << ordinal << " vs. " << data().size();
+      uint32_t& position = local_positions_[ordinal];
+      if (position == 0) {
+        local_ordinals_.push_back(ordinal);
+        local_values_.push_back(values[i]);
+        position = static_cast<uint32_t>(local_values_.size());
+      } else {
+        local_values_[position - 1] += values[i];
+      }
+    }
+    // Only reset the positions of this input's ordinals for the next one.
+    for (int64_t ordinal : local_ordinals_) {
+      local_positions_[ordinal] = 0;
     }
 
-    double rescaling_factor = ComputeRescalingFactor(local_histogram);
+    double rescaling_factor =
+        ClampAndComputeRescalingFactor(absl::MakeSpan(local_values_));
 
     // Propagate to the actual state
-    for (const auto& [ordinal, value] : local_histogram) {
+    for (size_t i = 0; i < local_ordinals_.size(); ++i) {
       // Compute the scaled value to satisfy the L1 and L2 constraints.
-      double scaled_value = Clamp(value) * rescaling_factor;
-      DCHECK(ordinal < data().size())
-          << "Ordinal too big: " << ordinal << " vs. " << data().size();
-      AggregateValue(ordinal, static_cast<OutputT>(scaled_value));
+      double scaled_value = local_values_[i] * rescaling_factor;
+      AggregateValue(local_ordinals_[i], static_cast<OutputT>(scaled_value));
     }
   }
 
@@ -147,13 +190,10 @@ class DPGroupingFederatedSum final
   // multiple clients.
   void MergeVectorByOrdinals(const AggVector<int64_t>& ordinals_vector,
                              const AggVector<OutputT>& value_vector) override {
-    auto value_it = value_vector.begin();
-    for (auto o : ordinals_vector) {
-      int64_t output_index = o.value;
-      TFF_CHECK(value_it.index() == o.index)
-          << "Indices in AggVector of ordinals and AggVector of values "
-             "are mismatched.";
-      AggregateValue(output_index, value_it++.value());
+    absl::Span<const int64_t> ordinals = ordinals_vector.dense_values();
+    absl::Span<const OutputT> values = value_vector.dense_values();
+    for (size_t i = 0; i < ordinals.size(); ++i) {
+      AggregateValue(ordinals[i], values[i]);
     }
   }
 
@@ -163,6 +203,14 @@ class DPGroupingFederatedSum final
   const InputT linfinity_bound_;
   const double l1_bound_;
   const double l2_bound_;
+
+  // Scratch space for the local histogram of each input, which is reused
+  // across inputs. local_positions_ has an entry per ordinal, holding one
+  // plus the position of its local sum in local_values_, or zero if the
+  // ordinal is not part of the current input.
+  std::vector<uint32_t> local_positions_;
+  std::vector<int64_t> local_ordinals_;
+  std::vector<InputT> local_values_;
 };
 
 // Make a DPGFS object out of norm bounds and aggregator state, if provided.
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dp_fedsql_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+constexpr static int64_t kTensorLength = 1000000;
+
+template <typename T>
+Tensor CreateScalar(DataType dtype, T value) {
+  return Tensor::Create(dtype, {},
+                        std::make_unique<MutableVectorData<T>>(1, value))
+      .value();
+}
+
+// Creates a DP grouping sum of doubles with the given norm bounds, where
+// non-positive L1 and L2 bounds are not enforced.
+std::unique_ptr<TensorAggregator> CreateDPSum(double linfinity_bound,
+                                              double l1_bound,
+                                              double l2_bound) {
+  std::vector<Tensor> parameters;
+  parameters.push_back(CreateScalar(DT_DOUBLE, linfinity_bound));
+  parameters.push_back(CreateScalar(DT_DOUBLE, l1_bound));
+  parameters.push_back(CreateScalar(DT_DOUBLE, l2_bound));
+  Intrinsic intrinsic{kDPSumUri,
+                      {TensorSpec("value", DT_DOUBLE, {-1})},
+                      {TensorSpec("value", DT_DOUBLE, {-1})},
+                      std::move(parameters),
+                      {}};
+  return CreateTensorAggregator(intrinsic).value();
+}
+
+// Benchmarks accumulating a client input whose `state.range(0)` distinct
+// ordinals are bounded by the norms `state.range(1)` selects: none, L1, L2,
+// or both.
+static void BM_DPGroupingSumAccumulate(benchmark::State& state) {
+  const int64_t num_distinct_ordinals = state.range(0);
+  const int64_t norms = state.range(1);
+  std::unique_ptr<TensorAggregator> aggregator =
+      CreateDPSum(/*linfinity_bound=*/100, (norms & 1) ? 1000 : -1,
+                  (norms & 2) ? 100 : -1);
+
+  auto ordinals = std::make_unique<MutableVectorData<int64_t>>(kTensorLength);
+  auto values = std::make_unique<MutableVectorData<double>>(kTensorLength);
+  for (int64_t i = 0; i < kTensorLength; ++i) {
+    // Spread the ordinals so that consecutive elements belong to different
+    // groups.
+    (*ordinals)[i] = (i * 7919) % num_distinct_ordinals;
+    (*values)[i] = (i % 123) - 61.5;
+  }
+  auto ordinals_tensor =
+      Tensor::Create(DT_INT64, {kTensorLength}, std::move(ordinals)).value();
+  auto values_tensor =
+      Tensor::Create(DT_DOUBLE, {kTensorLength}, std::move(values)).value();
+  int64_t items_processed = 0;
+
+  // Benchmark time is only measured in the loop body.
+  for (auto s : state) {
+    benchmark::DoNotOptimize(
+        aggregator->Accumulate({&ordinals_tensor, &values_tensor}));
+    items_processed += kTensorLength;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK(BM_DPGroupingSumAccumulate)
+    ->ArgsProduct({{1000, 100000, kTensorLength}, {0, 1, 2, 3}});
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -516,6 +516,30 @@ TEST_F(ContributionBoundingTester, AllBoundingSucceeds) {
                            cindy_expected_double);
 }
 
+// Norms of local histograms with more groups than fit in a vector register are
+// computed correctly, and each input's histogram starts out empty.
+TEST(DPGroupingFederatedSumTest, BoundsWideLocalHistograms) {
+  // The first local histogram is (2, 1, 1, 1, 1, 1) w/ L1 norm 7, which gets
+  // scaled by 3.5 / 7.
+  Tensor first_ordinals =
+      Tensor::Create(DT_INT64, {7},
+                     CreateTestData<int64_t>({5, 0, 1, 2, 3, 4, 0}))
+          .value();
+  Tensor first_values =
+      Tensor::Create(DT_DOUBLE, {7},
+                     CreateTestData<double>({1, 1, 1, 1, 1, 1, 1}))
+          .value();
+  // The second local histogram is (4) which gets clamped to (3).
+  Tensor second_ordinals =
+      Tensor::Create(DT_INT64, {1}, CreateTestData<int64_t>({0})).value();
+  Tensor second_values =
+      Tensor::Create(DT_DOUBLE, {1}, CreateTestData<double>({4})).value();
+  MatchSum<double, double>(
+      3, 3.5, -1,
+      {{&first_ordinals, &first_values}, {&second_ordinals, &second_values}},
+      {4, .5, .5, .5, .5, .5});
+}
+
 // Test merge w/ scalar input (duplicated from grouping_federated_sum_test.cc).
 TEST_P(DPGroupingFederatedSumTest, ScalarMergeSucceeds) {
   auto aggregator1 = CreateTensorAggregator(CreateDefaultIntrinsic()).value();
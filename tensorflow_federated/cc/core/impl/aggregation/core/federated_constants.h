@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_FEDERATED_CONSTANTS_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_FEDERATED_CONSTANTS_H_
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// Constants related to intrinsic definitions that are used in multiple files.
+// Ideally these would be marked inline to ensure a single copy of each variable
+// but this requires c++17 which is not available when building for bare metal.
+
+// URI of FederatedSum
+constexpr char kFederatedSumUri[] = "federated_sum";
+
+// URI of FusedFederatedSum, which aggregates the federated_sum intrinsics
+// nested in it together.
+constexpr char kFusedFederatedSumUri[] = "fused_federated_sum";
+
+// URIs of the dense sum and mean whose state is held by the DenseAccumulator
+// backend set with SetDenseAccumulatorFactory, e.g. on an accelerator.
+constexpr char kAcceleratedFederatedSumUri[] = "accelerated_federated_sum";
+constexpr char kAcceleratedFederatedMeanUri[] = "accelerated_federated_mean";
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_FEDERATED_CONSTANTS_H_
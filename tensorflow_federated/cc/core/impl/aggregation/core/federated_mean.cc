@@ -20,6 +20,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
@@ -68,6 +69,11 @@ class FederatedMean final : public TensorAggregator {
     return aggregator_state.SerializeAsString();
   }
 
+  size_t GetMemoryUsage() const override {
+    return weighted_values_sum_ == nullptr ? 0
+                                           : weighted_values_sum_->byte_size();
+  }
+
  private:
   Status MergeWith(TensorAggregator&& other) override {
     TFF_RETURN_IF_ERROR(CheckValid());
@@ -87,50 +93,71 @@ class FederatedMean final : public TensorAggregator {
                 "tensors of equal length.";
     }
 
-    for (int i = 0; i < weighted_values_sum_->size(); ++i) {
-      (*weighted_values_sum_)[i] += (*other_internal_state.first)[i];
-    }
+    const std::vector<V>& other_values = *other_internal_state.first;
+    AddValues(other_values);
     weights_sum_ += other_internal_state.second;
     num_inputs_ += other_ptr->GetNumInputs();
     return TFF_STATUS(OK);
   }
 
   Status AggregateTensors(InputTensorList tensors) override {
-    for (const Tensor* tensor : tensors) {
-      if (!tensor->is_dense()) {
-        return TFF_STATUS(INVALID_ARGUMENT)
-               << "FederatedMean::AggregateTensorsInternal: Only dense "
-                  "tensors are supported.";
-      }
-    }
-
-    AggVector<V> values = tensors[0]->AsAggVector<V>();
     // If the intrinsic is federated_weighted_mean, the second input tensor
     // will contain a scalar weight.
+    if (tensors.size() > 1 && !tensors[1]->is_dense()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FederatedMean::AggregateTensorsInternal: Only dense weight "
+                "tensors are supported.";
+    }
+    W weight = 1;
     if (tensors.size() > 1) {
       TFF_CHECK(tensors[1]->num_elements() == 1)
           << "FederatedMean::AggregateTensorsInternal: The weight must be a "
              "scalar.";
       AggVector<W> weights = tensors[1]->AsAggVector<W>();
-      W weight = weights.begin().value();
+      weight = weights.begin().value();
       if (weight <= 0) {
         return TFF_STATUS(INVALID_ARGUMENT)
                << "FederatedMean::AggregateTensorsInternal: Only positive "
                   "weights are allowed.";
       }
-      for (auto value : values) {
-        (*weighted_values_sum_)[value.index] += value.value * weight;
+    }
+
+    AggVector<V> values = tensors[0]->AsAggVector<V>();
+    std::vector<V>& sum = *weighted_values_sum_;
+    if (!values.is_dense()) {
+      // Only the values stored in a sparse tensor are non-zero, so the other
+      // elements of the sum are left as they are.
+      values.ForEachRun([&sum, weight](size_t start_index,
+                                       absl::Span<const V> run) {
+        V* run_sum = sum.data() + start_index;
+        for (size_t i = 0; i < run.size(); ++i) {
+          run_sum[i] += run[i] * weight;
+        }
+      });
+    } else if (tensors.size() > 1) {
+      absl::Span<const V> dense_values = values.dense_values();
+      for (size_t i = 0; i < dense_values.size(); ++i) {
+        sum[i] += dense_values[i] * weight;
       }
-      weights_sum_ += weight;
     } else {
-      for (auto value : values) {
-        (*weighted_values_sum_)[value.index] += value.value;
-      }
+      AddValues(values.dense_values());
+    }
+    if (tensors.size() > 1) {
+      weights_sum_ += weight;
     }
     num_inputs_++;
     return TFF_STATUS(OK);
   }
 
+  // Adds `values` elementwise to the weighted values sum, which must have the
+  // same length. Both are contiguous arrays, so the loop can be vectorized.
+  void AddValues(absl::Span<const V> values) {
+    std::vector<V>& sum = *weighted_values_sum_;
+    for (size_t i = 0; i < values.size(); ++i) {
+      sum[i] += values[i];
+    }
+  }
+
   Status CheckValid() const override {
     if (output_consumed_) {
       return TFF_STATUS(FAILED_PRECONDITION)
@@ -144,9 +171,10 @@ class FederatedMean final : public TensorAggregator {
     // Produce the final weighted mean values by dividing the weighted values
     // sum by the weights sum (tracked by weights_sum_ in the weighted case and
     // num_inputs_ in the non-weighted case).
-    for (int i = 0; i < weighted_values_sum_->size(); ++i) {
-      (*weighted_values_sum_)[i] /=
-          (weights_sum_ > 0 ? weights_sum_ : num_inputs_);
+    std::vector<V>& sum = *weighted_values_sum_;
+    const auto divisor = weights_sum_ > 0 ? weights_sum_ : num_inputs_;
+    for (size_t i = 0; i < sum.size(); ++i) {
+      sum[i] /= divisor;
     }
     OutputTensorList outputs = std::vector<Tensor>();
     outputs.push_back(
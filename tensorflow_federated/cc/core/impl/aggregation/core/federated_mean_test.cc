@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <cstdint>
 #include <string>
 #include <utility>
 
@@ -203,6 +204,60 @@ TEST_P(FederatedMeanTest, WeightedDenseAggregation_Succeeds) {
   EXPECT_TRUE(result.value()[0].is_dense());
 }
 
+TEST_P(FederatedMeanTest, WeightedSparseAggregation_Succeeds) {
+  Intrinsic federated_mean_intrinsic{
+      "federated_weighted_mean",
+      {TensorSpec{"foo", DT_FLOAT, {4}}, TensorSpec{"bar", DT_FLOAT, {}}},
+      {TensorSpec{"foo_out", DT_FLOAT, {4}}},
+      {},
+      {}};
+  auto aggregator = CreateTensorAggregator(federated_mean_intrinsic).value();
+  Tensor v1 = Tensor::CreateSparse(DT_FLOAT, {4}, CreateTestData<float>({2, 4}),
+                                   CreateTestData<int64_t>({1, 3}))
+                  .value();
+  Tensor w1 = Tensor::Create(DT_FLOAT, {}, CreateTestData<float>({1})).value();
+  Tensor v2 =
+      Tensor::Create(DT_FLOAT, {4}, CreateTestData<float>({1, 2, 3, 4}))
+          .value();
+  Tensor w2 = Tensor::Create(DT_FLOAT, {}, CreateTestData<float>({3})).value();
+  EXPECT_THAT(aggregator->Accumulate({&v1, &w1}), IsOk());
+
+  if (GetParam()) {
+    auto serialized_state = std::move(*aggregator).Serialize();
+    aggregator = DeserializeTensorAggregator(federated_mean_intrinsic,
+                                             serialized_state.value())
+                     .value();
+  }
+
+  EXPECT_THAT(aggregator->Accumulate({&v2, &w2}), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value().size(), Eq(1));
+  float e1 = static_cast<float>(1 * 3) / (1 + 3);
+  float e2 = static_cast<float>(2 * 1 + 2 * 3) / (1 + 3);
+  float e3 = static_cast<float>(3 * 3) / (1 + 3);
+  float e4 = static_cast<float>(4 * 1 + 4 * 3) / (1 + 3);
+  EXPECT_THAT(result.value()[0], IsTensor<float>({4}, {e1, e2, e3, e4}));
+}
+
+TEST(FederatedMeanTest, SparseWeight_Fails) {
+  Intrinsic federated_mean_intrinsic{
+      "federated_weighted_mean",
+      {TensorSpec{"foo", DT_FLOAT, {2}}, TensorSpec{"bar", DT_FLOAT, {}}},
+      {TensorSpec{"foo_out", DT_FLOAT, {2}}},
+      {},
+      {}};
+  auto aggregator = CreateTensorAggregator(federated_mean_intrinsic).value();
+  Tensor v = Tensor::Create(DT_FLOAT, {2}, CreateTestData<float>({1, 2}))
+                 .value();
+  Tensor w = Tensor::CreateSparse(DT_FLOAT, {}, CreateTestData<float>({1}),
+                                  CreateTestData<int64_t>({0}))
+                 .value();
+  EXPECT_THAT(aggregator->Accumulate({&v, &w}), StatusIs(INVALID_ARGUMENT));
+}
+
 TEST_P(FederatedMeanTest, Merge_Succeeds) {
   Intrinsic federated_mean_intrinsic{"federated_mean",
                                      {TensorSpec{"foo", DT_FLOAT, {}}},
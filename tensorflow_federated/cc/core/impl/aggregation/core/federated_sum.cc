@@ -14,17 +14,25 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/federated_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_factory.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
@@ -34,21 +42,108 @@
 namespace tensorflow_federated {
 namespace aggregation {
 
-constexpr char kFederatedSumUri[] = "federated_sum";
-
-// Implementation of a generic sum aggregator.
-template <typename T>
+// Implementation of a generic sum aggregator. Inputs of type `InputT` are
+// summed into the type `T`, which may be wider, e.g. quantized updates as int8
+// into int32, so that narrow inputs can be uploaded without overflowing the
+// sum. Merged aggregators and outputs are of type `T`.
+template <typename InputT, typename T = InputT>
 class FederatedSum final : public AggVectorAggregator<T> {
  public:
   using AggVectorAggregator<T>::AggVectorAggregator;
   using AggVectorAggregator<T>::data;
 
+ protected:
+  Status AggregateTensors(InputTensorList tensors) override {
+    if constexpr (std::is_same_v<InputT, T>) {
+      return AggVectorAggregator<T>::AggregateTensors(std::move(tensors));
+    } else {
+      return this->template AggregateTensorsOf<InputT>(
+          std::move(tensors), [this](const AggVector<InputT>& agg_vector) {
+            AggregateWidenedVector(agg_vector);
+          });
+    }
+  }
+
+  Status AggregateTensorBatch(
+      absl::Span<const InputTensorList> batch) override {
+    if constexpr (std::is_same_v<InputT, T>) {
+      return AggVectorAggregator<T>::AggregateTensorBatch(batch);
+    } else {
+      // Narrow inputs are widened one at a time.
+      return TensorAggregator::AggregateTensorBatch(batch);
+    }
+  }
+
  private:
+  // Adds the narrow `agg_vector` converted to `T`. The loops convert and add
+  // in one pass, which compilers vectorize, instead of widening the input
+  // into a temporary first.
+  void AggregateWidenedVector(const AggVector<InputT>& agg_vector) {
+    T* sum = data().data();
+    auto add_values = [sum](absl::Span<const InputT> values, size_t offset) {
+      for (size_t i = 0; i < values.size(); ++i) {
+        sum[offset + i] += static_cast<T>(values[i]);
+      }
+    };
+    if (agg_vector.is_dense()) {
+      add_values(agg_vector.dense_values(), 0);
+      return;
+    }
+    agg_vector.ForEachRun(
+        [&add_values](size_t start_index, absl::Span<const InputT> values) {
+          add_values(values, start_index);
+        });
+  }
+
   void AggregateVector(const AggVector<T>& agg_vector) override {
-    for (auto v : agg_vector) {
-      data()[v.index] += v.value;
+    // Each run of values lines up with a range of the aggregated data, so a
+    // plain elementwise loop over the two arrays is enough and can be
+    // vectorized.
+    T* sum = data().data();
+    auto add_values = [sum](absl::Span<const T> values, size_t offset) {
+      for (size_t i = 0; i < values.size(); ++i) {
+        sum[offset + i] += values[i];
+      }
+    };
+    if (agg_vector.is_dense()) {
+      this->ForEachDenseChunk(agg_vector, add_values);
+      return;
     }
+    agg_vector.ForEachRun(
+        [&add_values](size_t start_index, absl::Span<const T> values) {
+          add_values(values, start_index);
+        });
   }
+
+  void AggregateVectors(absl::Span<const AggVector<T>> agg_vectors) override {
+    std::vector<const T*> inputs;
+    inputs.reserve(agg_vectors.size());
+    for (const AggVector<T>& agg_vector : agg_vectors) {
+      inputs.push_back(agg_vector.dense_values().data());
+    }
+    // Adds all inputs one block at a time, so that each block of the sum stays
+    // in cache while the inputs are added to it, instead of going over the
+    // whole sum once per input.
+    T* sum = data().data();
+    auto add_inputs = [sum, inputs](absl::Span<const T> chunk, size_t offset) {
+      for (size_t begin = 0; begin < chunk.size(); begin += kMergeBlockSize) {
+        const size_t end = std::min(chunk.size(), begin + kMergeBlockSize);
+        for (const T* input : inputs) {
+          for (size_t i = offset + begin; i < offset + end; ++i) {
+            sum[i] += input[i];
+          }
+        }
+      }
+    };
+    this->ForEachDenseChunk(agg_vectors[0], add_inputs);
+  }
+
+  // The initial data is all zeros.
+  bool InitialDataIsIdentity() const override { return true; }
+
+  // Number of elements of the sum in each block when merging several
+  // aggregators, which keeps the block within a per-core L1 cache.
+  static constexpr size_t kMergeBlockSize = 1 << 11;
 };
 
 // Factory class for the FederatedSum.
@@ -106,8 +201,19 @@ class FederatedSumFactory final : public TensorAggregatorFactory {
     const TensorSpec& input_spec = intrinsic.inputs[0];
     const TensorSpec& output_spec = intrinsic.outputs[0];
 
-    if (input_spec.dtype() != output_spec.dtype() ||
-        input_spec.shape() != output_spec.shape()) {
+    if (input_spec.shape() != output_spec.shape()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FederatedSumFactory: Input and output tensors have mismatched "
+                "specs.";
+    }
+    if (input_spec.dtype() != output_spec.dtype()) {
+      // Narrow integer inputs may be summed into int32.
+      if (output_spec.dtype() == DT_INT32 && input_spec.dtype() == DT_INT8) {
+        return CreateWidening<int8_t, int32_t>(input_spec, aggregator_state);
+      }
+      if (output_spec.dtype() == DT_INT32 && input_spec.dtype() == DT_UINT8) {
+        return CreateWidening<uint8_t, int32_t>(input_spec, aggregator_state);
+      }
       return TFF_STATUS(INVALID_ARGUMENT)
              << "FederatedSumFactory: Input and output tensors have mismatched "
                 "specs.";
@@ -130,6 +236,22 @@ class FederatedSumFactory final : public TensorAggregatorFactory {
             aggregator_state->num_inputs()));
     return aggregator;
   }
+
+  template <typename InputT, typename T>
+  static std::unique_ptr<TensorAggregator> CreateWidening(
+      const TensorSpec& input_spec,
+      const AggVectorAggregatorState* aggregator_state) {
+    const DataType dtype = internal::TypeTraits<T>::kDataType;
+    if (aggregator_state == nullptr) {
+      return std::make_unique<FederatedSum<InputT, T>>(dtype,
+                                                       input_spec.shape());
+    }
+    return std::make_unique<FederatedSum<InputT, T>>(
+        dtype, input_spec.shape(),
+        MutableVectorData<T>::CreateFromEncodedContent(
+            aggregator_state->vector_data()),
+        aggregator_state->num_inputs());
+  }
 };
 
 REGISTER_AGGREGATOR_FACTORY(kFederatedSumUri, FederatedSumFactory);
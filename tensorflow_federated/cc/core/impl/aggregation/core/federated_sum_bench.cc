@@ -20,6 +20,9 @@
 #include <vector>
 
 #include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
@@ -34,23 +37,33 @@ namespace {
 
 constexpr static int64_t kLength = 1000000;
 
+std::unique_ptr<TensorAggregator> CreateSumAggregator(DataType dtype,
+                                                      int64_t length) {
+  return CreateTensorAggregator(Intrinsic{"federated_sum",
+                                          {TensorSpec{"foo", dtype, {length}}},
+                                          {TensorSpec{"foo", dtype, {length}}},
+                                          {},
+                                          {}})
+      .value();
+}
+
+template <typename T>
+Tensor CreateInputTensor(DataType dtype, int64_t length) {
+  auto test_data = std::make_unique<MutableVectorData<T>>(length);
+  std::vector<T>& input = *test_data;
+  for (int64_t i = 0; i < length; ++i) {
+    input[i] = static_cast<T>(i % 123);
+  }
+  return Tensor::Create(dtype, {length}, std::move(test_data)).value();
+}
+
 static void BM_FederatedSumAccumulate(benchmark::State& state) {
   std::unique_ptr<TensorAggregator> aggregator =
-      CreateTensorAggregator(Intrinsic{"federated_sum",
-                                       {TensorSpec{"foo", DT_INT64, {kLength}}},
-                                       {TensorSpec{"foo", DT_INT64, {kLength}}},
-                                       {},
-                                       {}})
-          .value();
-  auto test_data = std::make_unique<MutableVectorData<int64_t>>(kLength);
-  std::vector<int64_t>& input = *test_data;
-  for (int64_t i = 0; i < kLength; ++i) {
-    input[i] = i % 123;
-  }
-  auto tensor = Tensor::Create(DT_INT64, {kLength}, std::move(test_data));
+      CreateSumAggregator(DT_INT64, kLength);
+  Tensor tensor = CreateInputTensor<int64_t>(DT_INT64, kLength);
   auto items_processed = 0;
   for (auto s : state) {
-    benchmark::DoNotOptimize(aggregator->Accumulate(*tensor));
+    benchmark::DoNotOptimize(aggregator->Accumulate(tensor));
     items_processed += kLength;
   }
   state.SetItemsProcessed(items_processed);
@@ -58,6 +71,104 @@ static void BM_FederatedSumAccumulate(benchmark::State& state) {
 
 BENCHMARK(BM_FederatedSumAccumulate);
 
+// Accumulates a large int64 tensor split into chunks aggregated by
+// state.range(0) tasks.
+static void BM_FederatedSumAccumulateParallel(benchmark::State& state) {
+  constexpr int64_t kLargeLength = 16 * kLength;
+  const int num_tasks = state.range(0);
+  std::unique_ptr<Scheduler> scheduler = CreateThreadPoolScheduler(num_tasks);
+  std::unique_ptr<TensorAggregator> aggregator =
+      CreateSumAggregator(DT_INT64, kLargeLength);
+  dynamic_cast<AggVectorAggregator<int64_t>&>(*aggregator)
+      .SetParallelAggregation(scheduler.get(), num_tasks);
+  Tensor tensor = CreateInputTensor<int64_t>(DT_INT64, kLargeLength);
+  int64_t items_processed = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(aggregator->Accumulate(tensor));
+    items_processed += kLargeLength;
+  }
+  state.SetItemsProcessed(items_processed);
+  scheduler->WaitUntilIdle();
+}
+
+BENCHMARK(BM_FederatedSumAccumulateParallel)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime();
+
+// Accumulates a tensor of the dtype of T and of length state.range(0).
+template <typename T>
+static void BM_FederatedSumAccumulateDtype(benchmark::State& state) {
+  constexpr DataType kDtype = internal::TypeTraits<T>::kDataType;
+  const int64_t length = state.range(0);
+  std::unique_ptr<TensorAggregator> aggregator =
+      CreateSumAggregator(kDtype, length);
+  Tensor tensor = CreateInputTensor<T>(kDtype, length);
+  int64_t items_processed = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(aggregator->Accumulate(tensor));
+    items_processed += length;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+// Merges an aggregator holding a tensor of the dtype of T and of length
+// state.range(0) into another one.
+template <typename T>
+static void BM_FederatedSumMergeDtype(benchmark::State& state) {
+  constexpr DataType kDtype = internal::TypeTraits<T>::kDataType;
+  const int64_t length = state.range(0);
+  std::unique_ptr<TensorAggregator> aggregator =
+      CreateSumAggregator(kDtype, length);
+  Tensor tensor = CreateInputTensor<T>(kDtype, length);
+  int64_t items_processed = 0;
+  for (auto s : state) {
+    state.PauseTiming();
+    std::unique_ptr<TensorAggregator> other =
+        CreateSumAggregator(kDtype, length);
+    benchmark::DoNotOptimize(other->Accumulate(tensor));
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(aggregator->MergeWith(std::move(*other)));
+    items_processed += length;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK_TEMPLATE(BM_FederatedSumAccumulateDtype, int32_t)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kLength);
+BENCHMARK_TEMPLATE(BM_FederatedSumAccumulateDtype, int64_t)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kLength);
+BENCHMARK_TEMPLATE(BM_FederatedSumAccumulateDtype, float)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kLength);
+BENCHMARK_TEMPLATE(BM_FederatedSumAccumulateDtype, double)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kLength);
+BENCHMARK_TEMPLATE(BM_FederatedSumMergeDtype, int32_t)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kLength);
+BENCHMARK_TEMPLATE(BM_FederatedSumMergeDtype, int64_t)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kLength);
+BENCHMARK_TEMPLATE(BM_FederatedSumMergeDtype, float)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kLength);
+BENCHMARK_TEMPLATE(BM_FederatedSumMergeDtype, double)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kLength);
+
 }  // namespace
 }  // namespace aggregation
 }  // namespace tensorflow_federated
@@ -14,12 +14,16 @@
  * limitations under the License.
  */
 
+#include <cstdint>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_factory.h"
@@ -36,6 +40,7 @@ namespace {
 
 using ::testing::Eq;
 using ::testing::HasSubstr;
+using testing::IsFalse;
 using testing::IsTrue;
 
 Intrinsic GetDefaultIntrinsic() {
@@ -94,6 +99,78 @@ TEST(FederatedSumTest, DenseAggregation_Succeeds) {
   EXPECT_TRUE(result.value()[0].is_dense());
 }
 
+TEST(FederatedSumTest, SparseAggregation_Succeeds) {
+  Intrinsic federated_sum_intrinsic{"federated_sum",
+                                    {TensorSpec{"foo", DT_INT32, {4}}},
+                                    {TensorSpec{"foo_out", DT_INT32, {4}}},
+                                    {},
+                                    {}};
+  auto aggregator = CreateTensorAggregator(federated_sum_intrinsic).value();
+  Tensor t1 = Tensor::CreateSparse(DT_INT32, {4}, CreateTestData({1, 3}),
+                                   CreateTestData<int64_t>({0, 2}))
+                  .value();
+  Tensor t2 =
+      Tensor::Create(DT_INT32, {4}, CreateTestData({10, 5, 1, 2})).value();
+  Tensor t3 = Tensor::CreateSparse(DT_INT32, {4}, CreateTestData({7}),
+                                   CreateTestData<int64_t>({3}))
+                  .value();
+  EXPECT_THAT(aggregator->Accumulate(t1), IsOk());
+  EXPECT_THAT(aggregator->Accumulate(t2), IsOk());
+  EXPECT_THAT(aggregator->Accumulate(t3), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(3));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value().size(), Eq(1));
+  EXPECT_THAT(result.value()[0], IsTensor({4}, {11, 5, 4, 9}));
+  EXPECT_TRUE(result.value()[0].is_dense());
+}
+
+TEST(FederatedSumTest, AccumulateBatch_Succeeds) {
+  Intrinsic federated_sum_intrinsic{"federated_sum",
+                                    {TensorSpec{"foo", DT_INT32, {4}}},
+                                    {TensorSpec{"foo_out", DT_INT32, {4}}},
+                                    {},
+                                    {}};
+  auto aggregator = CreateTensorAggregator(federated_sum_intrinsic).value();
+  Tensor t1 =
+      Tensor::Create(DT_INT32, {4}, CreateTestData({1, 3, 15, 27})).value();
+  Tensor t2 =
+      Tensor::Create(DT_INT32, {4}, CreateTestData({10, 5, 1, 2})).value();
+  Tensor t3 = Tensor::CreateSparse(DT_INT32, {4}, CreateTestData({7}),
+                                   CreateTestData<int64_t>({3}))
+                  .value();
+  Tensor t4 =
+      Tensor::Create(DT_INT32, {4}, CreateTestData({3, 11, 7, 20})).value();
+  std::vector<InputTensorList> batch;
+  batch.emplace_back(t1);
+  batch.emplace_back(t2);
+  batch.emplace_back(t3);
+  batch.emplace_back(t4);
+  EXPECT_THAT(aggregator->AccumulateBatch(batch), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(4));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value().size(), Eq(1));
+  EXPECT_THAT(result.value()[0], IsTensor({4}, {14, 19, 23, 56}));
+}
+
+TEST(FederatedSumTest, AccumulateBatch_InvalidInputAccumulatesNothing) {
+  auto aggregator = CreateTensorAggregator(GetDefaultIntrinsic()).value();
+  Tensor t1 = Tensor::Create(DT_INT32, {}, CreateTestData({1})).value();
+  Tensor t2 = Tensor::Create(DT_FLOAT, {}, CreateTestData({2.f})).value();
+  std::vector<InputTensorList> batch;
+  batch.emplace_back(t1);
+  batch.emplace_back(t2);
+  EXPECT_THAT(aggregator->AccumulateBatch(batch),
+              StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(0));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result.value()[0], IsTensor({}, {0}));
+}
+
 TEST(FederatedSumTest, Merge_Succeeds) {
   auto aggregator1 = CreateTensorAggregator(GetDefaultIntrinsic()).value();
   auto aggregator2 = CreateTensorAggregator(GetDefaultIntrinsic()).value();
@@ -114,6 +191,73 @@ TEST(FederatedSumTest, Merge_Succeeds) {
   EXPECT_THAT(result.value()[0], IsTensor({}, {6}));
 }
 
+TEST(FederatedSumTest, Merge_IntoEmptyAggregator_Succeeds) {
+  auto aggregator1 = CreateTensorAggregator(GetDefaultIntrinsic()).value();
+  auto aggregator2 = CreateTensorAggregator(GetDefaultIntrinsic()).value();
+  Tensor t = Tensor::Create(DT_INT32, {}, CreateTestData({5})).value();
+  EXPECT_THAT(aggregator2->Accumulate(t), IsOk());
+
+  EXPECT_THAT(aggregator1->MergeWith(std::move(*aggregator2)), IsOk());
+  EXPECT_THAT(aggregator2->CanReport(), IsFalse());
+  EXPECT_THAT(aggregator1->GetNumInputs(), Eq(1));
+  EXPECT_THAT(aggregator1->Accumulate(t), IsOk());
+
+  auto result = std::move(*aggregator1).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor({}, {10}));
+}
+
+TEST(FederatedSumTest, MergeWithAll_Succeeds) {
+  Intrinsic federated_sum_intrinsic{"federated_sum",
+                                    {TensorSpec{"foo", DT_INT32, {3}}},
+                                    {TensorSpec{"foo_out", DT_INT32, {3}}},
+                                    {},
+                                    {}};
+  auto aggregator = CreateTensorAggregator(federated_sum_intrinsic).value();
+  std::vector<std::unique_ptr<TensorAggregator>> others;
+  for (int i = 1; i <= 3; ++i) {
+    others.push_back(CreateTensorAggregator(federated_sum_intrinsic).value());
+    Tensor t =
+        Tensor::Create(DT_INT32, {3}, CreateTestData({i, 10 * i, 100 * i}))
+            .value();
+    EXPECT_THAT(others.back()->Accumulate(t), IsOk());
+  }
+  // An aggregator without inputs doesn't change the sum.
+  others.push_back(CreateTensorAggregator(federated_sum_intrinsic).value());
+  Tensor t = Tensor::Create(DT_INT32, {3}, CreateTestData({1, 1, 1})).value();
+  EXPECT_THAT(aggregator->Accumulate(t), IsOk());
+
+  std::vector<TensorAggregator*> other_ptrs;
+  for (const auto& other : others) {
+    other_ptrs.push_back(other.get());
+  }
+  EXPECT_THAT(aggregator->MergeWithAll(other_ptrs), IsOk());
+  for (const auto& other : others) {
+    EXPECT_THAT(other->CanReport(), IsFalse());
+  }
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(4));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor({3}, {7, 61, 601}));
+}
+
+TEST(FederatedSumTest, MergeWithAll_ShapeMismatch) {
+  Intrinsic federated_sum_intrinsic{"federated_sum",
+                                    {TensorSpec{"foo", DT_INT32, {3}}},
+                                    {TensorSpec{"foo_out", DT_INT32, {3}}},
+                                    {},
+                                    {}};
+  auto aggregator = CreateTensorAggregator(federated_sum_intrinsic).value();
+  auto other1 = CreateTensorAggregator(federated_sum_intrinsic).value();
+  auto other2 = CreateTensorAggregator(GetDefaultIntrinsic()).value();
+  std::vector<TensorAggregator*> others = {other1.get(), other2.get()};
+  EXPECT_THAT(aggregator->MergeWithAll(others), StatusIs(INVALID_ARGUMENT));
+  // Nothing has been merged.
+  EXPECT_THAT(other1->CanReport(), IsTrue());
+  EXPECT_THAT(other2->CanReport(), IsTrue());
+}
+
 TEST(FederatedSumTest, SerializeDeserialize_Succeeds) {
   auto aggregator = CreateTensorAggregator(GetDefaultIntrinsic()).value();
   Tensor t1 = Tensor::Create(DT_INT32, {}, CreateTestData({1})).value();
@@ -139,6 +283,64 @@ TEST(FederatedSumTest, SerializeDeserialize_Succeeds) {
   EXPECT_THAT(result.value()[0], IsTensor({}, {6}));
 }
 
+TEST(FederatedSumTest, NarrowInputsWidenedAggregation_Succeeds) {
+  Intrinsic federated_sum_intrinsic{"federated_sum",
+                                    {TensorSpec{"foo", DT_INT8, {3}}},
+                                    {TensorSpec{"foo_out", DT_INT32, {3}}},
+                                    {},
+                                    {}};
+  auto aggregator = CreateTensorAggregator(federated_sum_intrinsic).value();
+  Tensor dense = Tensor::Create(DT_INT8, {3},
+                                CreateTestData<int8_t>({127, -128, 100}))
+                     .value();
+  Tensor sparse =
+      Tensor::CreateSparse(DT_INT8, {3}, CreateTestData<int8_t>({100, 1}),
+                           CreateTestData<int64_t>({0, 2}))
+          .value();
+  EXPECT_THAT(aggregator->Accumulate(dense), IsOk());
+  std::vector<InputTensorList> batch;
+  batch.emplace_back(dense);
+  batch.emplace_back(sparse);
+  EXPECT_THAT(aggregator->AccumulateBatch(batch), IsOk());
+  // Inputs of the output type are not accepted.
+  Tensor wide =
+      Tensor::Create(DT_INT32, {3}, CreateTestData({1, 2, 3})).value();
+  EXPECT_THAT(aggregator->Accumulate(wide), StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(3));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value().size(), Eq(1));
+  // The sums overflow int8 but not int32.
+  EXPECT_THAT(result.value()[0], IsTensor<int32_t>({3}, {354, -256, 201}));
+}
+
+TEST(FederatedSumTest, NarrowInputsWidenedMergeAndDeserialize_Succeeds) {
+  Intrinsic federated_sum_intrinsic{"federated_sum",
+                                    {TensorSpec{"foo", DT_UINT8, {}}},
+                                    {TensorSpec{"foo_out", DT_INT32, {}}},
+                                    {},
+                                    {}};
+  auto aggregator1 = CreateTensorAggregator(federated_sum_intrinsic).value();
+  auto aggregator2 = CreateTensorAggregator(federated_sum_intrinsic).value();
+  Tensor t = Tensor::Create(DT_UINT8, {}, CreateTestData<uint8_t>({200}))
+                 .value();
+  EXPECT_THAT(aggregator1->Accumulate(t), IsOk());
+  EXPECT_THAT(aggregator2->Accumulate(t), IsOk());
+  EXPECT_THAT(aggregator1->MergeWith(std::move(*aggregator2)), IsOk());
+
+  auto serialized_state = std::move(*aggregator1).Serialize();
+  auto deserialized_aggregator =
+      DeserializeTensorAggregator(federated_sum_intrinsic,
+                                  serialized_state.value())
+          .value();
+  EXPECT_THAT(deserialized_aggregator->Accumulate(t), IsOk());
+  EXPECT_THAT(deserialized_aggregator->GetNumInputs(), Eq(3));
+
+  auto result = std::move(*deserialized_aggregator).Report();
+  EXPECT_THAT(result.value()[0], IsTensor<int32_t>({}, {600}));
+}
+
 TEST(FederatedSumTest, Create_WrongUri) {
   Intrinsic intrinsic{"wrong_uri",
                       {TensorSpec{"foo", DT_INT32, {}}},
@@ -27,6 +27,9 @@ namespace aggregation {
 // URI of GroupByAggregator
 constexpr char kGroupByUri[] = "fedsql_group_by";
 
+// URI of TopKAggregator
+constexpr char kTopKUri[] = "fedsql_top_k";
+
 // URI prefix of inner intrinsics
 constexpr char kFedSqlPrefix[] = "GoogleSQL:";
 
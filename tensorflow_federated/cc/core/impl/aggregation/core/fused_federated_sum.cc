@@ -0,0 +1,346 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/federated_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_factory.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+namespace {
+
+// Adds the values of `tensor` to `sum`, a MutableVectorData<T> with as many
+// elements as the tensor.
+template <typename T>
+void AddTensor(const Tensor& tensor, TensorData& sum) {
+  T* sum_data =
+      static_cast<std::vector<T>&>(static_cast<MutableVectorData<T>&>(sum))
+          .data();
+  tensor.AsAggVector<T>().ForEachRun(
+      [sum_data](size_t start_index, absl::Span<const T> values) {
+        T* run_sum = sum_data + start_index;
+        for (size_t i = 0; i < values.size(); ++i) {
+          run_sum[i] += values[i];
+        }
+      });
+}
+
+template <typename T>
+void AddData(const TensorData& other, TensorData& sum) {
+  std::vector<T>& sum_values = static_cast<MutableVectorData<T>&>(sum);
+  const std::vector<T>& other_values =
+      static_cast<const MutableVectorData<T>&>(other);
+  T* sum_data = sum_values.data();
+  const T* other_data = other_values.data();
+  for (size_t i = 0; i < sum_values.size(); ++i) {
+    sum_data[i] += other_data[i];
+  }
+}
+
+template <typename T>
+std::string EncodeData(TensorData& data) {
+  return static_cast<MutableVectorData<T>&>(data).EncodeContent();
+}
+
+}  // namespace
+
+// Aggregator of several federated_sum intrinsics, which are nested in the
+// fused_federated_sum intrinsic, in a single TensorAggregator.
+//
+// Each nested intrinsic has a single input tensor, in order, and a single
+// output tensor. Its sum is stored and aggregated like FederatedSum does, but
+// the typed aggregation loop of each sum is selected once on creation, so that
+// accumulating an input only dispatches once per sum rather than through the
+// TensorAggregator, AggVectorAggregator and FederatedSum virtual methods. This
+// matters for configurations with many small tensors.
+class FusedFederatedSum final : public TensorAggregator {
+ public:
+  // The sum of a nested federated_sum intrinsic.
+  struct Sum {
+    DataType dtype;
+    TensorShape shape;
+    std::unique_ptr<TensorData> data;
+    // Aggregation functions for the dtype of the sum.
+    void (*add_tensor)(const Tensor& tensor, TensorData& sum);
+    void (*add_data)(const TensorData& other, TensorData& sum);
+    std::string (*encode_data)(TensorData& data);
+  };
+
+  FusedFederatedSum(std::vector<Sum> sums, int num_inputs)
+      : sums_(std::move(sums)), num_inputs_(num_inputs) {}
+
+  Status MergeWith(TensorAggregator&& other) override {
+    TFF_RETURN_IF_ERROR(CheckValid());
+    auto* other_ptr = dynamic_cast<FusedFederatedSum*>(&other);
+    if (other_ptr == nullptr) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSum::MergeWith: Can only merge with another "
+                "FusedFederatedSum.";
+    }
+    TFF_RETURN_IF_ERROR(other_ptr->CheckValid());
+    if (other_ptr->sums_.size() != sums_.size()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSum::MergeWith: Expected " << sums_.size()
+             << " sums but got " << other_ptr->sums_.size();
+    }
+    for (size_t i = 0; i < sums_.size(); ++i) {
+      if (other_ptr->sums_[i].dtype != sums_[i].dtype ||
+          other_ptr->sums_[i].shape != sums_[i].shape) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "FusedFederatedSum::MergeWith: Mismatched spec of sum " << i;
+      }
+    }
+    // The other aggregator is consumed by the merge.
+    other_ptr->output_consumed_ = true;
+    const int other_num_inputs = other_ptr->num_inputs_;
+    if (other_num_inputs == 0) {
+      return TFF_STATUS(OK);
+    }
+    for (size_t i = 0; i < sums_.size(); ++i) {
+      if (num_inputs_ == 0) {
+        // The initial sums are zeros, so take over the other sums instead of
+        // adding them.
+        sums_[i].data = std::move(other_ptr->sums_[i].data);
+      } else {
+        sums_[i].add_data(*other_ptr->sums_[i].data, *sums_[i].data);
+      }
+    }
+    num_inputs_ += other_num_inputs;
+    return TFF_STATUS(OK);
+  }
+
+  StatusOr<std::string> Serialize() && override {
+    TFF_RETURN_IF_ERROR(CheckValid());
+    FusedFederatedSumState aggregator_state;
+    aggregator_state.set_num_inputs(num_inputs_);
+    for (Sum& sum : sums_) {
+      aggregator_state.add_vector_data(sum.encode_data(*sum.data));
+    }
+    return aggregator_state.SerializeAsString();
+  }
+
+  int GetNumInputs() const override { return num_inputs_; }
+
+  size_t GetMemoryUsage() const override {
+    size_t memory_usage = 0;
+    for (const Sum& sum : sums_) {
+      if (sum.data != nullptr) {
+        memory_usage += sum.data->byte_size();
+      }
+    }
+    return memory_usage;
+  }
+
+ protected:
+  Status AggregateTensors(InputTensorList tensors) override {
+    if (tensors.size() != sums_.size()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSum::AggregateTensors: Expected "
+             << sums_.size() << " tensors but got " << tensors.size();
+    }
+    // Check all tensors before adding any, so that an invalid input leaves
+    // the aggregator as it was.
+    for (size_t i = 0; i < sums_.size(); ++i) {
+      if (tensors[i]->dtype() != sums_[i].dtype ||
+          tensors[i]->shape() != sums_[i].shape) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "FusedFederatedSum::AggregateTensors: Tensor " << i
+               << " doesn't match the spec of its sum.";
+      }
+    }
+    for (size_t i = 0; i < sums_.size(); ++i) {
+      sums_[i].add_tensor(*tensors[i], *sums_[i].data);
+    }
+    num_inputs_++;
+    return TFF_STATUS(OK);
+  }
+
+  Status CheckValid() const override {
+    if (output_consumed_) {
+      return TFF_STATUS(FAILED_PRECONDITION)
+             << "FusedFederatedSum::CheckValid: Output has already been "
+                "consumed.";
+    }
+    return TFF_STATUS(OK);
+  }
+
+  OutputTensorList TakeOutputs() && override {
+    output_consumed_ = true;
+    OutputTensorList outputs = std::vector<Tensor>();
+    outputs.reserve(sums_.size());
+    for (Sum& sum : sums_) {
+      outputs.push_back(
+          Tensor::Create(sum.dtype, sum.shape, std::move(sum.data)).value());
+    }
+    return outputs;
+  }
+
+ private:
+  bool output_consumed_ = false;
+  std::vector<Sum> sums_;
+  int num_inputs_;
+};
+
+// Factory class for the FusedFederatedSum.
+class FusedFederatedSumFactory final : public TensorAggregatorFactory {
+ public:
+  FusedFederatedSumFactory() = default;
+
+  // FusedFederatedSumFactory isn't copyable or moveable.
+  FusedFederatedSumFactory(const FusedFederatedSumFactory&) = delete;
+  FusedFederatedSumFactory& operator=(const FusedFederatedSumFactory&) =
+      delete;
+
+  StatusOr<std::unique_ptr<TensorAggregator>> Create(
+      const Intrinsic& intrinsic) const override {
+    return CreateInternal(intrinsic, nullptr);
+  }
+
+  StatusOr<std::unique_ptr<TensorAggregator>> Deserialize(
+      const Intrinsic& intrinsic, std::string serialized_state) const override {
+    FusedFederatedSumState aggregator_state;
+    if (!aggregator_state.ParseFromString(serialized_state)) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: Failed to deserialize the "
+                "FusedFederatedSumState.";
+    }
+    return CreateInternal(intrinsic, &aggregator_state);
+  }
+
+ private:
+  StatusOr<std::unique_ptr<TensorAggregator>> CreateInternal(
+      const Intrinsic& intrinsic,
+      const FusedFederatedSumState* aggregator_state) const {
+    if (kFusedFederatedSumUri != intrinsic.uri) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: Expected intrinsic URI "
+             << kFusedFederatedSumUri << " but got uri " << intrinsic.uri;
+    }
+    // The inputs and outputs are those of the nested intrinsics.
+    if (!intrinsic.inputs.empty() || !intrinsic.outputs.empty() ||
+        !intrinsic.parameters.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: Expected no inputs, outputs or "
+                "parameters besides those of the nested intrinsics.";
+    }
+    if (intrinsic.nested_intrinsics.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: Expected at least one nested "
+                "intrinsic.";
+    }
+    if (aggregator_state != nullptr &&
+        aggregator_state->vector_data_size() !=
+            intrinsic.nested_intrinsics.size()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: The serialized state doesn't match "
+                "the number of nested intrinsics.";
+    }
+
+    std::vector<FusedFederatedSum::Sum> sums;
+    sums.reserve(intrinsic.nested_intrinsics.size());
+    for (size_t i = 0; i < intrinsic.nested_intrinsics.size(); ++i) {
+      const Intrinsic& nested = intrinsic.nested_intrinsics[i];
+      TFF_RETURN_IF_ERROR(CheckNestedIntrinsic(nested));
+      const TensorSpec& spec = nested.inputs[0];
+      FusedFederatedSum::Sum sum{spec.dtype(), spec.shape()};
+      const size_t num_elements = spec.shape().NumElements().value();
+      NUMERICAL_ONLY_DTYPE_CASES(spec.dtype(), T, {
+        if (aggregator_state == nullptr) {
+          sum.data = std::make_unique<MutableVectorData<T>>(num_elements);
+        } else {
+          const std::string& vector_data = aggregator_state->vector_data(i);
+          if (vector_data.size() != num_elements * sizeof(T)) {
+            return TFF_STATUS(INVALID_ARGUMENT)
+                   << "FusedFederatedSumFactory: The serialized sum " << i
+                   << " doesn't match the shape of its intrinsic.";
+          }
+          sum.data = MutableVectorData<T>::CreateFromEncodedContent(
+              vector_data);
+        }
+        sum.add_tensor = &AddTensor<T>;
+        sum.add_data = &AddData<T>;
+        sum.encode_data = &EncodeData<T>;
+      });
+      sums.push_back(std::move(sum));
+    }
+    return std::make_unique<FusedFederatedSum>(
+        std::move(sums),
+        aggregator_state == nullptr ? 0 : aggregator_state->num_inputs());
+  }
+
+  // Checks that `nested` is a valid federated_sum intrinsic over a numeric
+  // tensor whose shape is known, like FederatedSumFactory does.
+  static Status CheckNestedIntrinsic(const Intrinsic& nested) {
+    if (nested.uri != kFederatedSumUri) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: Expected nested intrinsics with "
+                "URI "
+             << kFederatedSumUri << " but got uri " << nested.uri;
+    }
+    if (nested.inputs.size() != 1 || nested.outputs.size() != 1 ||
+        !nested.parameters.empty() || !nested.nested_intrinsics.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: Each nested intrinsic must have "
+                "exactly one input and one output, and no parameters or "
+                "nested intrinsics.";
+    }
+    const TensorSpec& input_spec = nested.inputs[0];
+    const TensorSpec& output_spec = nested.outputs[0];
+    if (input_spec.dtype() != output_spec.dtype() ||
+        input_spec.shape() != output_spec.shape()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: Input and output tensors have "
+                "mismatched specs.";
+    }
+    if (internal::GetTypeKind(input_spec.dtype()) !=
+        internal::TypeKind::kNumeric) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: Only numeric tensors can be "
+                "summed.";
+    }
+    if (!input_spec.shape().NumElements().ok()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "FusedFederatedSumFactory: All dimensions of the tensor "
+                "shapes must be known in advance.";
+    }
+    return TFF_STATUS(OK);
+  }
+};
+
+REGISTER_AGGREGATOR_FACTORY(kFusedFederatedSumUri, FusedFederatedSumFactory);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
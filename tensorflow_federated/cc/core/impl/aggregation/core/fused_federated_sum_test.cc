@@ -0,0 +1,194 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+Intrinsic CreateSumIntrinsic(std::string name, DataType dtype,
+                             TensorShape shape) {
+  return Intrinsic{"federated_sum",
+                   {TensorSpec{name, dtype, shape}},
+                   {TensorSpec{name + "_out", dtype, shape}},
+                   {},
+                   {}};
+}
+
+// Fuses a scalar int32 sum and a float sum of shape {2, 2}.
+Intrinsic CreateFusedIntrinsic() {
+  Intrinsic intrinsic{"fused_federated_sum", {}, {}, {}, {}};
+  intrinsic.nested_intrinsics.push_back(
+      CreateSumIntrinsic("foo", DT_INT32, {}));
+  intrinsic.nested_intrinsics.push_back(
+      CreateSumIntrinsic("bar", DT_FLOAT, {2, 2}));
+  return intrinsic;
+}
+
+TEST(FusedFederatedSumTest, Aggregation_Succeeds) {
+  auto aggregator = CreateTensorAggregator(CreateFusedIntrinsic()).value();
+  Tensor foo1 = Tensor::Create(DT_INT32, {}, CreateTestData({1})).value();
+  Tensor bar1 = Tensor::Create(DT_FLOAT, {2, 2},
+                               CreateTestData({1.f, 2.f, 3.f, 4.f}))
+                    .value();
+  Tensor foo2 = Tensor::Create(DT_INT32, {}, CreateTestData({2})).value();
+  Tensor bar2 = Tensor::CreateSparse(DT_FLOAT, {2, 2}, CreateTestData({10.f}),
+                                     CreateTestData<int64_t>({3}))
+                    .value();
+  EXPECT_THAT(aggregator->Accumulate({&foo1, &bar1}), IsOk());
+  EXPECT_THAT(aggregator->Accumulate({&foo2, &bar2}), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  ASSERT_THAT(result.value().size(), Eq(2));
+  EXPECT_THAT(result.value()[0], IsTensor<int32_t>({}, {3}));
+  EXPECT_THAT(result.value()[1],
+              IsTensor<float>({2, 2}, {1.f, 2.f, 3.f, 14.f}));
+}
+
+TEST(FusedFederatedSumTest, MergeWith_Succeeds) {
+  Intrinsic intrinsic = CreateFusedIntrinsic();
+  auto aggregator1 = CreateTensorAggregator(intrinsic).value();
+  auto aggregator2 = CreateTensorAggregator(intrinsic).value();
+  auto aggregator3 = CreateTensorAggregator(intrinsic).value();
+  Tensor foo = Tensor::Create(DT_INT32, {}, CreateTestData({5})).value();
+  Tensor bar = Tensor::Create(DT_FLOAT, {2, 2},
+                              CreateTestData({1.f, 1.f, 2.f, 2.f}))
+                   .value();
+  EXPECT_THAT(aggregator2->Accumulate({&foo, &bar}), IsOk());
+  EXPECT_THAT(aggregator3->Accumulate({&foo, &bar}), IsOk());
+
+  // The first merge takes over the sums of aggregator2, since aggregator1
+  // has no inputs yet, and the second one adds the sums of aggregator3.
+  EXPECT_THAT(aggregator1->MergeWith(std::move(*aggregator2)), IsOk());
+  EXPECT_THAT(aggregator1->MergeWith(std::move(*aggregator3)), IsOk());
+  EXPECT_THAT(aggregator1->GetNumInputs(), Eq(2));
+  EXPECT_THAT(aggregator2->CanReport(), Eq(false));
+
+  auto result = std::move(*aggregator1).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<int32_t>({}, {10}));
+  EXPECT_THAT(result.value()[1],
+              IsTensor<float>({2, 2}, {2.f, 2.f, 4.f, 4.f}));
+}
+
+TEST(FusedFederatedSumTest, SerializeDeserialize_Succeeds) {
+  Intrinsic intrinsic = CreateFusedIntrinsic();
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  Tensor foo = Tensor::Create(DT_INT32, {}, CreateTestData({7})).value();
+  Tensor bar = Tensor::Create(DT_FLOAT, {2, 2},
+                              CreateTestData({1.f, 2.f, 3.f, 4.f}))
+                   .value();
+  EXPECT_THAT(aggregator->Accumulate({&foo, &bar}), IsOk());
+  std::string serialized_state = std::move(*aggregator).Serialize().value();
+  aggregator = DeserializeTensorAggregator(intrinsic, serialized_state).value();
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(1));
+  EXPECT_THAT(aggregator->Accumulate({&foo, &bar}), IsOk());
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<int32_t>({}, {14}));
+  EXPECT_THAT(result.value()[1],
+              IsTensor<float>({2, 2}, {2.f, 4.f, 6.f, 8.f}));
+}
+
+TEST(FusedFederatedSumTest, Deserialize_MismatchedState_Fails) {
+  Intrinsic intrinsic = CreateFusedIntrinsic();
+  std::string serialized_state =
+      std::move(*CreateTensorAggregator(intrinsic).value()).Serialize().value();
+  Intrinsic other_intrinsic = CreateFusedIntrinsic();
+  other_intrinsic.nested_intrinsics[1] =
+      CreateSumIntrinsic("bar", DT_FLOAT, {3});
+  EXPECT_THAT(DeserializeTensorAggregator(other_intrinsic, serialized_state),
+              StatusIs(INVALID_ARGUMENT));
+  other_intrinsic.nested_intrinsics.pop_back();
+  EXPECT_THAT(DeserializeTensorAggregator(other_intrinsic, serialized_state),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(FusedFederatedSumTest, Accumulate_MismatchedInput_Fails) {
+  auto aggregator = CreateTensorAggregator(CreateFusedIntrinsic()).value();
+  Tensor foo = Tensor::Create(DT_INT32, {}, CreateTestData({1})).value();
+  Tensor bar =
+      Tensor::Create(DT_FLOAT, {2}, CreateTestData({1.f, 2.f})).value();
+  EXPECT_THAT(aggregator->Accumulate({&foo}), StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(aggregator->Accumulate({&foo, &bar}),
+              StatusIs(INVALID_ARGUMENT));
+  // The valid first tensor wasn't added.
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(0));
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<int32_t>({}, {0}));
+}
+
+TEST(FusedFederatedSumTest, MergeWith_DifferentIntrinsic_Fails) {
+  auto aggregator = CreateTensorAggregator(CreateFusedIntrinsic()).value();
+  Intrinsic other_intrinsic = CreateFusedIntrinsic();
+  other_intrinsic.nested_intrinsics.pop_back();
+  auto other = CreateTensorAggregator(other_intrinsic).value();
+  EXPECT_THAT(aggregator->MergeWith(std::move(*other)),
+              StatusIs(INVALID_ARGUMENT));
+  auto sum =
+      CreateTensorAggregator(CreateSumIntrinsic("foo", DT_INT32, {})).value();
+  EXPECT_THAT(aggregator->MergeWith(std::move(*sum)),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(FusedFederatedSumTest, Create_InvalidNestedIntrinsic_Fails) {
+  Intrinsic intrinsic = CreateFusedIntrinsic();
+  intrinsic.nested_intrinsics[0].uri = "federated_mean";
+  Status s = CreateTensorAggregator(intrinsic).status();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("Expected nested intrinsics with URI"));
+
+  intrinsic = CreateFusedIntrinsic();
+  intrinsic.nested_intrinsics[0] =
+      CreateSumIntrinsic("foo", DT_STRING, {});
+  EXPECT_THAT(CreateTensorAggregator(intrinsic), StatusIs(INVALID_ARGUMENT));
+
+  intrinsic = CreateFusedIntrinsic();
+  intrinsic.nested_intrinsics[0] = CreateSumIntrinsic("foo", DT_INT32, {-1});
+  EXPECT_THAT(CreateTensorAggregator(intrinsic), StatusIs(INVALID_ARGUMENT));
+
+  intrinsic = CreateFusedIntrinsic();
+  intrinsic.nested_intrinsics.clear();
+  EXPECT_THAT(CreateTensorAggregator(intrinsic), StatusIs(INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -16,24 +16,36 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/core/group_by_aggregator.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/platform.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/direct_index_key_combiner.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/fedsql_constants.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/one_dim_grouping_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/single_key_combiner.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
@@ -45,6 +57,128 @@
 namespace tensorflow_federated {
 namespace aggregation {
 
+namespace internal {
+
+void ForEachShard(Scheduler* scheduler, int num_tasks, size_t num_shards,
+                  std::function<void(size_t)> fn) {
+  if (scheduler == nullptr || num_shards <= 1) {
+    for (size_t shard = 0; shard < num_shards; ++shard) {
+      fn(shard);
+    }
+    return;
+  }
+  struct State {
+    State(size_t num_shards, std::function<void(size_t)> fn)
+        : num_shards(num_shards), fn(std::move(fn)), num_pending(num_shards) {}
+
+    const size_t num_shards;
+    const std::function<void(size_t)> fn;
+    std::atomic<size_t> next_shard = 0;
+    absl::Mutex mu;
+    size_t num_pending ABSL_GUARDED_BY(mu);
+  };
+  auto state = std::make_shared<State>(num_shards, std::move(fn));
+  // Each task claims shards until none are left. Tasks that start after all
+  // shards have been claimed return without calling `fn`, and only touch the
+  // state they share, so the calling thread only has to wait for the shards
+  // to be done. It never waits for a task which hasn't started, so calls
+  // nested in tasks of `scheduler` can't deadlock.
+  auto run_shards = [state]() {
+    for (size_t shard = state->next_shard++; shard < state->num_shards;
+         shard = state->next_shard++) {
+      state->fn(shard);
+      absl::MutexLock lock(&state->mu);
+      state->num_pending--;
+    }
+  };
+  const size_t num_scheduled =
+      std::min<size_t>(num_tasks - 1, state->num_shards - 1);
+  for (size_t i = 0; i < num_scheduled; ++i) {
+    scheduler->Schedule(run_shards);
+  }
+  // The calling thread works on shards too, which guarantees progress even if
+  // all scheduler threads are busy.
+  run_shards();
+  absl::MutexLock lock(&state->mu);
+  state->mu.Await(absl::Condition(
+      +[](size_t* num_pending) { return *num_pending == 0; },
+      &state->num_pending));
+}
+
+}  // namespace internal
+
+namespace {
+
+// Mixes the values of the key `column` at the rows starting at `begin` into
+// the hash of each of these rows in `hashes`.
+template <typename T>
+void HashKeyColumn(const Tensor& column, size_t begin,
+                   std::vector<size_t>& hashes) {
+  absl::Span<const T> values = column.AsSpan<T>();
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    hashes[i] = absl::HashOf(hashes[i], values[begin + i]);
+  }
+}
+
+template <typename T>
+StatusOr<Tensor> GatherTypedRows(const Tensor& column,
+                                 absl::Span<const int64_t> rows) {
+  absl::Span<const T> values = column.AsSpan<T>();
+  auto data = std::make_unique<MutableVectorData<T>>();
+  data->reserve(rows.size());
+  for (int64_t row : rows) {
+    data->push_back(values[row]);
+  }
+  return Tensor::Create(column.dtype(), {static_cast<int64_t>(rows.size())},
+                        std::move(data));
+}
+
+// Returns a one-dimensional tensor with the elements of `column` at `rows`.
+// String elements refer to the data of `column`, which must outlive the
+// result.
+StatusOr<Tensor> GatherRows(const Tensor& column,
+                            absl::Span<const int64_t> rows) {
+  StatusOr<Tensor> result;
+  DTYPE_CASES(column.dtype(), T, result = GatherTypedRows<T>(column, rows));
+  return result;
+}
+
+InputTensorList AsInputTensorList(const OutputTensorList& outputs) {
+  InputTensorList tensors(outputs.size());
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    tensors[i] = &outputs[i];
+  }
+  return tensors;
+}
+
+// Splits the rows in [begin, end) of `tensors`, whose first `num_keys` tensors
+// are the keys, into `num_partitions` partitions by the hash of their keys.
+// Returns the rows of each partition in increasing order.
+std::vector<std::vector<int64_t>> PartitionRowRange(
+    const InputTensorList& tensors, size_t num_keys, size_t begin, size_t end,
+    size_t num_partitions) {
+  std::vector<size_t> hashes(end - begin);
+  for (size_t k = 0; k < num_keys; ++k) {
+    DTYPE_CASES(tensors[k]->dtype(), T,
+                HashKeyColumn<T>(*tensors[k], begin, hashes));
+  }
+  std::vector<std::vector<int64_t>> partition_rows(num_partitions);
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    partition_rows[hashes[i] % num_partitions].push_back(begin + i);
+  }
+  return partition_rows;
+}
+
+// Same as PartitionRowRange, for all the rows of the groups in `groups`.
+std::vector<std::vector<int64_t>> PartitionRows(const OutputTensorList& groups,
+                                                size_t num_keys,
+                                                size_t num_partitions) {
+  return PartitionRowRange(AsInputTensorList(groups), num_keys, 0,
+                           groups[0].num_elements(), num_partitions);
+}
+
+}  // namespace
+
 GroupByAggregator::GroupByAggregator(
     const std::vector<TensorSpec>& input_key_specs,
     const std::vector<TensorSpec>* output_key_specs,
@@ -75,6 +209,14 @@ GroupByAggregator::GroupByAggregator(
          "output_key_specs.";
 }
 
+GroupByAggregator::~GroupByAggregator() {
+  for (const std::vector<std::string>& files : spill_files_) {
+    for (const std::string& file : files) {
+      RemoveFile(file).IgnoreError();
+    }
+  }
+}
+
 std::unique_ptr<CompositeKeyCombiner> GroupByAggregator::CreateKeyCombiner(
     const std::vector<TensorSpec>& input_key_specs,
     const std::vector<TensorSpec>* output_key_specs) {
@@ -86,8 +228,15 @@ std::unique_ptr<CompositeKeyCombiner> GroupByAggregator::CreateKeyCombiner(
     return nullptr;
   }
 
-  return std::make_unique<CompositeKeyCombiner>(CreateKeyTypes(
-      input_key_specs.size(), input_key_specs, *output_key_specs));
+  // Integer keys are looked up in a table while their values fall in small
+  // ranges, and keys made of a single integer or string tensor are otherwise
+  // handled by a faster specialized key combiner.
+  std::vector<DataType> key_types = CreateKeyTypes(
+      input_key_specs.size(), input_key_specs, *output_key_specs);
+  if (DirectIndexKeyCombiner::SupportsTypes(key_types)) {
+    return std::make_unique<DirectIndexKeyCombiner>(std::move(key_types));
+  }
+  return CreateKeyCombinerForTypes(std::move(key_types));
 }
 
 std::vector<DataType> GroupByAggregator::CreateKeyTypes(
@@ -136,15 +285,246 @@ Status GroupByAggregator::MergeWith(TensorAggregator&& other) {
   TFF_RETURN_IF_ERROR(
       MergeTensorsInternal(std::move(tensors), other_num_inputs));
   num_inputs_ += other_num_inputs;
+  return SpillIfNeeded();
+}
+
+Status GroupByAggregator::MergeWithAll(
+    absl::Span<TensorAggregator* const> others) {
+  TFF_RETURN_IF_ERROR(CheckValid());
+  std::vector<GroupByAggregator*> other_ptrs;
+  other_ptrs.reserve(others.size());
+  for (TensorAggregator* other : others) {
+    GroupByAggregator* other_ptr = dynamic_cast<GroupByAggregator*>(other);
+    if (other_ptr == nullptr) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupByAggregator::MergeWithAll: Can only merge with other "
+                "GroupByAggregators";
+    }
+    TFF_RETURN_IF_ERROR(other_ptr->CheckValid());
+    TFF_RETURN_IF_ERROR(other_ptr->IsCompatible(*this));
+    other_ptrs.push_back(other_ptr);
+  }
+  // Without keys, every aggregator holds a single group, so there is nothing
+  // to partition.
+  if (merge_scheduler_ != nullptr && key_combiner_ != nullptr &&
+      other_ptrs.size() > 1) {
+    return ParallelMergeWithAll(other_ptrs);
+  }
+  for (GroupByAggregator* other_ptr : other_ptrs) {
+    TFF_RETURN_IF_ERROR(MergeWith(std::move(*other_ptr)));
+  }
+  return TFF_STATUS(OK);
+}
+
+Status GroupByAggregator::ParallelMergeWithAll(
+    absl::Span<GroupByAggregator* const> others) {
+  const size_t num_others = others.size();
+  const size_t num_partitions = num_merge_partitions_;
+  int num_other_inputs = 0;
+  for (const GroupByAggregator* other : others) {
+    num_other_inputs += other->GetNumInputs();
+  }
+
+  // Take the groups of the other aggregators and assign each of them to a
+  // partition by the hash of its composite key. The rows of the groups of
+  // others[i] in partition p are at partition_rows[i][p].
+  std::vector<OutputTensorList> other_outputs(num_others);
+  std::vector<std::vector<std::vector<int64_t>>> partition_rows(num_others);
+  internal::ForEachShard(
+      merge_scheduler_, num_merge_tasks_, num_others, [&](size_t i) {
+        other_outputs[i] = std::move(*others[i]).TakeOutputsInternal();
+        partition_rows[i] = PartitionRows(other_outputs[i],
+                                          num_keys_per_input_, num_partitions);
+      });
+
+  // Combine the groups of each partition, which are disjoint from the groups
+  // of the other partitions, into unique groups.
+  std::vector<OutputTensorList> partition_outputs(num_partitions);
+  std::vector<Status> partition_status(num_partitions);
+  auto combine_partition = [&](size_t p) -> Status {
+    TFF_ASSIGN_OR_RETURN(std::unique_ptr<GroupByAggregator> partition,
+                         CreateMergePartition());
+    for (size_t i = 0; i < num_others; ++i) {
+      if (partition_rows[i][p].empty()) continue;
+      TFF_RETURN_IF_ERROR(
+          partition->MergeRows(other_outputs[i], partition_rows[i][p]));
+    }
+    partition_outputs[p] = std::move(*partition).TakeOutputsInternal();
+    return TFF_STATUS(OK);
+  };
+  internal::ForEachShard(
+      merge_scheduler_, num_merge_tasks_, num_partitions,
+      [&](size_t p) { partition_status[p] = combine_partition(p); });
+  for (const Status& status : partition_status) {
+    TFF_RETURN_IF_ERROR(status);
+  }
+  // The partition outputs own their data, so the groups of the other
+  // aggregators can be released before they are merged.
+  other_outputs.clear();
+  partition_rows.clear();
+
+  // Merge the unique groups of each partition into this aggregator. All the
+  // inputs of the other aggregators are counted with the first partition.
+  for (size_t p = 0; p < num_partitions; ++p) {
+    OutputTensorList outputs = std::move(partition_outputs[p]);
+    TFF_RETURN_IF_ERROR(MergeTensorsInternal(
+        AsInputTensorList(outputs), p == 0 ? num_other_inputs : 0));
+  }
+  num_inputs_ += num_other_inputs;
+  return SpillIfNeeded();
+}
+
+Status GroupByAggregator::MergeRows(const OutputTensorList& groups,
+                                    absl::Span<const int64_t> rows) {
+  OutputTensorList columns;
+  columns.reserve(groups.size());
+  for (const Tensor& group_column : groups) {
+    TFF_ASSIGN_OR_RETURN(Tensor column, GatherRows(group_column, rows));
+    columns.push_back(std::move(column));
+  }
+  return MergeTensorsInternal(AsInputTensorList(columns),
+                              /*num_merged_inputs=*/0);
+}
+
+void GroupByAggregator::SetParallelMerge(Scheduler* scheduler, int num_tasks,
+                                         size_t num_partitions) {
+  TFF_CHECK(num_partitions > 0) << "num_partitions must be positive";
+  merge_scheduler_ = num_tasks > 1 ? scheduler : nullptr;
+  num_merge_tasks_ = num_tasks;
+  num_merge_partitions_ = num_partitions;
+}
+
+void GroupByAggregator::SetParallelAccumulate(Scheduler* scheduler,
+                                              int num_tasks,
+                                              size_t num_partitions,
+                                              size_t min_rows) {
+  TFF_CHECK(num_partitions > 0) << "num_partitions must be positive";
+  accumulate_scheduler_ = num_tasks > 1 ? scheduler : nullptr;
+  num_accumulate_tasks_ = num_tasks;
+  num_accumulate_partitions_ = num_partitions;
+  min_parallel_accumulate_rows_ = min_rows;
+}
+
+void GroupByAggregator::SetParallelOutputKeys(Scheduler* scheduler,
+                                              int num_tasks) {
+  output_keys_scheduler_ = num_tasks > 1 ? scheduler : nullptr;
+  num_output_keys_tasks_ = num_tasks;
+}
+
+void GroupByAggregator::EnableSpilling(std::string path_prefix,
+                                       size_t max_groups_in_memory,
+                                       size_t num_partitions) {
+  TFF_CHECK(max_groups_in_memory > 0)
+      << "max_groups_in_memory must be positive";
+  TFF_CHECK(num_partitions > 0) << "num_partitions must be positive";
+  TFF_CHECK(spill_files_.empty())
+      << "The spilling settings can't change once groups have been spilled";
+  spill_path_prefix_ = std::move(path_prefix);
+  max_groups_in_memory_ = max_groups_in_memory;
+  num_spill_partitions_ = num_partitions;
+}
+
+Status GroupByAggregator::SpillIfNeeded() {
+  if (max_groups_in_memory_ == 0 || key_combiner_ == nullptr ||
+      key_combiner_->num_keys() <= max_groups_in_memory_) {
+    return TFF_STATUS(OK);
+  }
+  Status status = Spill();
+  if (!status.ok()) {
+    // Some of the groups taken from memory may not have been written.
+    output_consumed_ = true;
+  }
+  return status;
+}
+
+Status GroupByAggregator::Spill() {
+  const int num_inner_inputs =
+      aggregators_.empty() ? 0 : aggregators_[0]->GetNumInputs();
+  OutputTensorList groups = TakeGroupsInMemory();
+  output_consumed_ = false;
+  key_combiner_ = CreateEmptyKeyCombiner();
+  TFF_ASSIGN_OR_RETURN(aggregators_, CreateInnerAggregators(nullptr));
+
+  spill_files_.resize(num_spill_partitions_);
+  std::vector<std::vector<int64_t>> partition_rows =
+      PartitionRows(groups, num_keys_per_input_, num_spill_partitions_);
+  for (size_t p = 0; p < num_spill_partitions_; ++p) {
+    if (partition_rows[p].empty()) continue;
+    TFF_ASSIGN_OR_RETURN(std::unique_ptr<GroupByAggregator> partition,
+                         CreateMergePartition());
+    TFF_RETURN_IF_ERROR(partition->MergeRows(groups, partition_rows[p]));
+    TFF_ASSIGN_OR_RETURN(std::string state,
+                         std::move(*partition).SerializeSnapshot());
+    std::string path =
+        absl::StrCat(spill_path_prefix_, ".", num_spills_, ".", p);
+    TFF_RETURN_IF_ERROR(WriteStringToFile(path, state));
+    spill_files_[p].push_back(std::move(path));
+  }
+  num_spills_++;
+  num_spilled_inner_inputs_ += num_inner_inputs;
+  return TFF_STATUS(OK);
+}
+
+Status GroupByAggregator::MergeSpilledGroups() {
+  bool merged_inner_inputs = false;
+  for (std::vector<std::string>& files : spill_files_) {
+    // The spilled groups of a partition are combined before being merged into
+    // the groups in memory, so that each key is only looked up once here.
+    std::unique_ptr<GroupByAggregator> partition;
+    for (const std::string& file : files) {
+      TFF_ASSIGN_OR_RETURN(std::string serialized_state,
+                           ReadFileToString(file));
+      TFF_RETURN_IF_ERROR(RemoveFile(file));
+      GroupByAggregatorState state;
+      if (!state.ParseFromString(serialized_state)) {
+        return TFF_STATUS(INTERNAL)
+               << "GroupByAggregator: Failed to parse the spilled groups in "
+               << file;
+      }
+      TFF_ASSIGN_OR_RETURN(std::unique_ptr<GroupByAggregator> run,
+                           CreateMergePartition(&state));
+      if (partition == nullptr) {
+        partition = std::move(run);
+        continue;
+      }
+      OutputTensorList run_groups = std::move(*run).TakeOutputsInternal();
+      TFF_RETURN_IF_ERROR(partition->MergeTensorsInternal(
+          AsInputTensorList(run_groups), /*num_merged_inputs=*/0));
+    }
+    files.clear();
+    if (partition == nullptr) continue;
+    OutputTensorList groups = std::move(*partition).TakeOutputsInternal();
+    // The spilled inputs of the inner aggregators are counted with the first
+    // merged partition.
+    TFF_RETURN_IF_ERROR(MergeTensorsInternal(
+        AsInputTensorList(groups),
+        merged_inner_inputs ? 0 : num_spilled_inner_inputs_));
+    merged_inner_inputs = true;
+  }
+  spill_files_.clear();
+  num_spilled_inner_inputs_ = 0;
   return TFF_STATUS(OK);
 }
 
 bool GroupByAggregator::CanReport() const { return CheckValid().ok(); }
 
+size_t GroupByAggregator::GetMemoryUsage() const {
+  size_t memory_usage = 0;
+  if (key_combiner_ != nullptr) {
+    memory_usage += key_combiner_->GetMemoryUsage();
+  }
+  for (const auto& aggregator : aggregators_) {
+    if (aggregator != nullptr) {
+      memory_usage += aggregator->GetMemoryUsage();
+    }
+  }
+  return memory_usage;
+}
+
 Status GroupByAggregator::AggregateTensors(InputTensorList tensors) {
   TFF_RETURN_IF_ERROR(AggregateTensorsInternal(std::move(tensors)));
   num_inputs_++;
-  return TFF_STATUS(OK);
+  return SpillIfNeeded();
 }
 
 Status GroupByAggregator::CheckValid() const {
@@ -198,10 +578,26 @@ inline Status GroupByAggregator::ValidateInputTensor(
 }
 
 StatusOr<std::string> GroupByAggregator::Serialize() && {
+  return SerializeInternal(/*snapshot_keys=*/false);
+}
+
+StatusOr<std::string> GroupByAggregator::SerializeSnapshot() && {
+  return SerializeInternal(/*snapshot_keys=*/true);
+}
+
+StatusOr<std::string> GroupByAggregator::SerializeInternal(
+    bool snapshot_keys) {
+  if (!spill_files_.empty()) {
+    TFF_RETURN_IF_ERROR(MergeSpilledGroups());
+  }
   GroupByAggregatorState state;
   state.set_num_inputs(num_inputs_);
   // If keys are being used, store the current list of output keys into state.
-  if (key_combiner_ != nullptr) {
+  if (key_combiner_ != nullptr && snapshot_keys) {
+    key_combiner_->AppendSnapshot(*state.mutable_key_snapshot());
+  } else if (key_combiner_ != nullptr) {
+    key_combiner_->SetParallelOutput(output_keys_scheduler_,
+                                     num_output_keys_tasks_);
     OutputTensorList keys = key_combiner_->GetOutputKeys();
     google::protobuf::RepeatedPtrField<TensorProto>* keys_proto = state.mutable_keys();
     keys_proto->Reserve(keys.size());
@@ -248,6 +644,21 @@ Status GroupByAggregator::AggregateTensorsInternal(InputTensorList tensors) {
     }
   }
 
+  if (accumulate_scheduler_ != nullptr && key_combiner_ != nullptr &&
+      CanPartitionInputs() &&
+      tensors[0]->num_elements() >=
+          std::max<size_t>(min_parallel_accumulate_rows_, 1)) {
+    // The key tensors are validated by the key combiner, which only sees the
+    // rows of each partition, so they must be checked before partitioning.
+    bool keys_match = true;
+    for (size_t k = 0; k < num_keys_per_input_; ++k) {
+      keys_match &= tensors[k]->shape() == key_shape && tensors[k]->is_dense();
+    }
+    if (keys_match) {
+      return ParallelAggregateTensors(tensors);
+    }
+  }
+
   TFF_ASSIGN_OR_RETURN(Tensor ordinals, CreateOrdinalsByGroupingKeys(tensors));
 
   input_index = num_keys_per_input_;
@@ -271,6 +682,67 @@ Status GroupByAggregator::AggregateTensorsInternal(InputTensorList tensors) {
   return TFF_STATUS(OK);
 }
 
+Status GroupByAggregator::ParallelAggregateTensors(
+    const InputTensorList& tensors) {
+  const size_t num_rows = tensors[0]->num_elements();
+  const size_t num_partitions = num_accumulate_partitions_;
+  const size_t num_ranges = num_accumulate_tasks_;
+
+  // Hash the keys of each range of rows and assign the rows to partitions.
+  // The rows of range r in partition p are at range_rows[r][p].
+  std::vector<std::vector<std::vector<int64_t>>> range_rows(num_ranges);
+  internal::ForEachShard(
+      accumulate_scheduler_, num_accumulate_tasks_, num_ranges, [&](size_t r) {
+        range_rows[r] = PartitionRowRange(
+            tensors, num_keys_per_input_, num_rows * r / num_ranges,
+            num_rows * (r + 1) / num_ranges, num_partitions);
+      });
+
+  // Accumulate the rows of each partition, whose keys are disjoint from the
+  // keys of the other partitions, into groups of their own.
+  std::vector<OutputTensorList> partition_outputs(num_partitions);
+  std::vector<Status> partition_status(num_partitions);
+  auto accumulate_partition = [&](size_t p) -> Status {
+    std::vector<int64_t> rows;
+    for (const std::vector<std::vector<int64_t>>& ranges : range_rows) {
+      rows.insert(rows.end(), ranges[p].begin(), ranges[p].end());
+    }
+    if (rows.empty()) return TFF_STATUS(OK);
+    OutputTensorList columns;
+    columns.reserve(tensors.size());
+    for (const Tensor* column : tensors) {
+      TFF_ASSIGN_OR_RETURN(Tensor partition_column, GatherRows(*column, rows));
+      columns.push_back(std::move(partition_column));
+    }
+    TFF_ASSIGN_OR_RETURN(std::unique_ptr<GroupByAggregator> partition,
+                         CreateMergePartition());
+    TFF_RETURN_IF_ERROR(
+        partition->AggregateTensorsInternal(AsInputTensorList(columns)));
+    partition_outputs[p] = std::move(*partition).TakeOutputsInternal();
+    return TFF_STATUS(OK);
+  };
+  internal::ForEachShard(
+      accumulate_scheduler_, num_accumulate_tasks_, num_partitions,
+      [&](size_t p) { partition_status[p] = accumulate_partition(p); });
+  for (const Status& status : partition_status) {
+    TFF_RETURN_IF_ERROR(status);
+  }
+  range_rows.clear();
+
+  // Stitch the groups of the partitions into the ordinals of this aggregator.
+  // The input is counted by the nested aggregators with the first partition
+  // that has any rows.
+  bool counted_input = false;
+  for (size_t p = 0; p < num_partitions; ++p) {
+    if (partition_outputs[p].empty()) continue;
+    OutputTensorList outputs = std::move(partition_outputs[p]);
+    TFF_RETURN_IF_ERROR(MergeTensorsInternal(AsInputTensorList(outputs),
+                                             counted_input ? 0 : 1));
+    counted_input = true;
+  }
+  return TFF_STATUS(OK);
+}
+
 Status GroupByAggregator::MergeTensorsInternal(InputTensorList tensors,
                                                int num_merged_inputs) {
   if (tensors.size() != num_tensors_per_input_) {
@@ -326,10 +798,23 @@ Status GroupByAggregator::MergeTensorsInternal(InputTensorList tensors,
 }
 
 OutputTensorList GroupByAggregator::TakeOutputsInternal() {
+  if (!spill_files_.empty()) {
+    Status status = MergeSpilledGroups();
+    TFF_CHECK(status.ok()) << status.message();
+  }
+  return TakeGroupsInMemory();
+}
+
+OutputTensorList GroupByAggregator::TakeGroupsInMemory() {
   output_consumed_ = true;
   OutputTensorList outputs;
   if (key_combiner_ != nullptr) {
+    key_combiner_->SetParallelOutput(output_keys_scheduler_,
+                                     num_output_keys_tasks_);
     outputs = key_combiner_->GetOutputKeys();
+    // The output keys own their data, so the composite keys and the interned
+    // strings can be released before the values are reported.
+    key_combiner_.reset();
   }
   outputs.reserve(outputs.size() + intrinsics_.size());
   for (int i = 0; i < intrinsics_.size(); ++i) {
@@ -368,6 +853,11 @@ StatusOr<Tensor> GroupByAggregator::CreateOrdinalsByGroupingKeysForMerge(
   return CreateOrdinalsByGroupingKeys(inputs);
 }
 
+std::unique_ptr<CompositeKeyCombiner>
+GroupByAggregator::CreateEmptyKeyCombiner() const {
+  return CreateKeyCombiner(output_key_specs_, &output_key_specs_);
+}
+
 Status GroupByAggregator::IsCompatible(const GroupByAggregator& other) const {
   bool other_has_no_combiner = (other.key_combiner_ == nullptr);
   bool this_has_no_combiner = (key_combiner_ == nullptr);
@@ -412,6 +902,58 @@ Status GroupByAggregator::IsCompatible(const GroupByAggregator& other) const {
   return TFF_STATUS(OK);
 }
 
+StatusOr<std::vector<std::unique_ptr<OneDimBaseGroupingAggregator>>>
+GroupByAggregator::CreateInnerAggregators(
+    const GroupByAggregatorState* state) const {
+  std::vector<std::unique_ptr<OneDimBaseGroupingAggregator>> aggregators;
+  aggregators.reserve(intrinsics_.size());
+  for (int i = 0; i < intrinsics_.size(); ++i) {
+    TFF_ASSIGN_OR_RETURN(const TensorAggregatorFactory* factory,
+                         GetAggregatorFactory(intrinsics_[i].uri));
+    std::unique_ptr<TensorAggregator> aggregator;
+    if (state == nullptr) {
+      TFF_ASSIGN_OR_RETURN(aggregator, factory->Create(intrinsics_[i]));
+    } else {
+      auto one_dim_base_factory =
+          dynamic_cast<const OneDimBaseGroupingAggregatorFactory*>(factory);
+      TFF_CHECK(one_dim_base_factory != nullptr);
+      TFF_ASSIGN_OR_RETURN(aggregator,
+                           one_dim_base_factory->FromProto(
+                               intrinsics_[i], state->nested_aggregators(i)));
+    }
+    aggregators.push_back(std::unique_ptr<OneDimBaseGroupingAggregator>(
+        dynamic_cast<OneDimBaseGroupingAggregator*>(aggregator.release())));
+  }
+  return aggregators;
+}
+
+StatusOr<std::unique_ptr<GroupByAggregator>>
+GroupByAggregator::CreateMergePartition(
+    const GroupByAggregatorState* state) const {
+  TFF_ASSIGN_OR_RETURN(
+      std::vector<std::unique_ptr<OneDimBaseGroupingAggregator>> aggregators,
+      CreateInnerAggregators(state));
+  // The output key specs have the same dtypes and shapes as the input ones.
+  std::unique_ptr<CompositeKeyCombiner> key_combiner =
+      CreateKeyCombiner(output_key_specs_, &output_key_specs_);
+  if (state != nullptr && key_combiner != nullptr &&
+      !state->key_snapshot().empty()) {
+    TFF_RETURN_IF_ERROR(key_combiner->RestoreSnapshot(state->key_snapshot()));
+  } else if (state != nullptr && key_combiner != nullptr) {
+    std::vector<Tensor> key_tensors(state->keys().size());
+    InputTensorList keys(state->keys().size());
+    for (int i = 0; i < state->keys().size(); ++i) {
+      TFF_ASSIGN_OR_RETURN(key_tensors[i], Tensor::FromProto(state->keys(i)));
+      keys[i] = &key_tensors[i];
+    }
+    TFF_RETURN_IF_ERROR(key_combiner->Accumulate(keys).status());
+  }
+  return std::unique_ptr<GroupByAggregator>(new GroupByAggregator(
+      output_key_specs_, &output_key_specs_, &intrinsics_,
+      std::move(key_combiner), std::move(aggregators),
+      state == nullptr ? 0 : state->num_inputs()));
+}
+
 // Check that the configuration is valid for SQL grouping aggregators.
 Status GroupByFactory::CheckIntrinsic(const Intrinsic& intrinsic,
                                       const char* uri) {
@@ -492,6 +1034,9 @@ Status GroupByFactory::PopulateKeyCombinerFromState(
   if (aggregator_state.num_inputs() == 0) {
     return TFF_STATUS(OK);
   }
+  if (!aggregator_state.key_snapshot().empty()) {
+    return key_combiner.RestoreSnapshot(aggregator_state.key_snapshot());
+  }
   std::vector<Tensor> key_tensors(aggregator_state.keys().size());
   InputTensorList keys(aggregator_state.keys().size());
   for (int i = 0; i < aggregator_state.keys().size(); ++i) {
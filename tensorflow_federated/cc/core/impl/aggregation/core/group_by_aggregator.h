@@ -18,11 +18,15 @@
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_GROUP_BY_AGGREGATOR_H_
 
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
@@ -38,6 +42,18 @@
 namespace tensorflow_federated {
 namespace aggregation {
 
+namespace internal {
+// Calls `fn(shard)` for each shard in [0, num_shards). When `scheduler` isn't
+// null, the shards are processed by up to `num_tasks` tasks, including the
+// calling thread, with all tasks but one scheduled on `scheduler`. Returns
+// once all shards have been processed, without waiting for the scheduled
+// tasks which found no shard left, so it may be called from tasks of
+// `scheduler`. Those tasks may still be queued on `scheduler`, which must be
+// idle, e.g. after WaitUntilIdle, before it is destroyed.
+void ForEachShard(Scheduler* scheduler, int num_tasks, size_t num_shards,
+                  std::function<void(size_t)> fn);
+}  // namespace internal
+
 // GroupByAggregator class is a specialization of TensorAggregator which
 // takes in a predefined number of tensors to be used as keys and and predefined
 // number of tensors to be used as values. It computes the unique combined keys
@@ -57,14 +73,98 @@ namespace aggregation {
 // This class is not thread safe.
 class GroupByAggregator : public TensorAggregator {
  public:
+  // Removes the files of the groups spilled to disk, if any.
+  ~GroupByAggregator() override;
+
   // Merge this GroupByAggregator with another GroupByAggregator that operates
   // on compatible types using compatible inner intrinsics.
   Status MergeWith(TensorAggregator&& other) override;
 
+  // Merges all `others`, which must be compatible GroupByAggregators, into
+  // this GroupByAggregator. Nothing is merged if any of them is invalid or
+  // incompatible.
+  //
+  // Without a scheduler set by SetParallelMerge, this is the same as calling
+  // MergeWith with each of them in order. Otherwise the groups of all `others`
+  // are hash-partitioned by key, the groups of each partition are combined in
+  // parallel, and the unique groups of each partition are then merged into
+  // this GroupByAggregator in a single pass. The result holds the same groups
+  // as a serial merge, but the groups new to this aggregator may be reported
+  // in a different order.
+  Status MergeWithAll(absl::Span<TensorAggregator* const> others) override;
+
+  // Default number of key partitions of a parallel MergeWithAll.
+  static constexpr size_t kDefaultMergePartitions = 64;
+
+  // Enables parallel MergeWithAll. The groups of the merged aggregators are
+  // split into `num_partitions` partitions by the hash of their keys, which
+  // are processed by up to `num_tasks` tasks, including the calling thread,
+  // all but one of which are scheduled on `scheduler`. `scheduler` must
+  // outlive this aggregator. A null `scheduler` or `num_tasks` <= 1 disables
+  // parallelism.
+  void SetParallelMerge(Scheduler* scheduler, int num_tasks,
+                        size_t num_partitions = kDefaultMergePartitions);
+
+  // Default minimum number of rows of an input accumulated in parallel.
+  static constexpr size_t kDefaultMinParallelAccumulateRows = size_t{1} << 20;
+
+  // Enables accumulating large inputs in parallel. The rows of an input with
+  // at least `min_rows` rows are hashed in row ranges and split into
+  // `num_partitions` partitions by the hash of their keys. Each partition is
+  // accumulated into groups of its own, with a key combiner and nested
+  // aggregators of its own, by up to `num_tasks` tasks, including the calling
+  // thread, all but one of which are scheduled on `scheduler`. The unique
+  // groups of each partition are then merged into this GroupByAggregator. The
+  // result holds the same groups as a serial Accumulate, but the groups new to
+  // this aggregator may be reported in a different order. `scheduler` must
+  // outlive this aggregator. A null `scheduler` or `num_tasks` <= 1 disables
+  // parallelism.
+  void SetParallelAccumulate(
+      Scheduler* scheduler, int num_tasks,
+      size_t num_partitions = kDefaultMergePartitions,
+      size_t min_rows = kDefaultMinParallelAccumulateRows);
+
+  // Enables materializing the output keys in parallel when the groups are
+  // taken by Report or Serialize, see CompositeKeyCombiner::SetParallelOutput.
+  // `scheduler` must outlive this aggregator. A null `scheduler` or
+  // `num_tasks` <= 1 disables parallelism.
+  void SetParallelOutputKeys(Scheduler* scheduler, int num_tasks);
+
+  // Default number of key partitions of the groups spilled to disk.
+  static constexpr size_t kDefaultSpillPartitions = 16;
+
+  // Bounds the number of groups held in memory by spilling them to disk.
+  // Whenever an Accumulate or a merge leaves more than `max_groups_in_memory`
+  // groups in memory, the groups are split into `num_partitions` partitions
+  // by the hash of their keys, each partition is written to a file in the
+  // format of SerializeSnapshot, and the groups are removed from memory. The
+  // spilled groups are read back and merged one partition at a time when the
+  // outputs of this aggregator are taken, i.e. by Report, Serialize or a merge
+  // into another aggregator.
+  //
+  // The files are named `<path_prefix>.<n>.<partition>`, so `path_prefix`
+  // must be unique to this aggregator. If spilling fails, the groups may have
+  // been lost and CheckValid fails. Spilling doesn't apply to aggregations
+  // without keys, which only have one group.
+  void EnableSpilling(std::string path_prefix, size_t max_groups_in_memory,
+                      size_t num_partitions = kDefaultSpillPartitions);
+
+  // Same as Serialize, but the keys are stored as a binary snapshot of the key
+  // combiner rather than as tensors, which the key combiner of the
+  // deserialized aggregator restores without accumulating the keys again.
+  // The snapshot is in the native byte order, so the state must only be
+  // deserialized by the same binary. Used for the groups spilled to disk.
+  StatusOr<std::string> SerializeSnapshot() &&;
+
   // Returns the number of inputs that have been accumulated or merged into this
   // GroupByAggregator.
   int GetNumInputs() const override { return num_inputs_; }
 
+  // Estimates the memory of the keys held by the key combiner, including its
+  // interned strings, plus the memory of the nested aggregators. Spilled
+  // groups aren't included.
+  size_t GetMemoryUsage() const override;
+
   // Override CanReport to ensure that outputs of Report will contain all
   // expected output tensors. It is not valid to create empty tensors, so in
   // order to produce a report containing the expected number of output tensors,
@@ -165,6 +265,15 @@ class GroupByAggregator : public TensorAggregator {
   virtual StatusOr<Tensor> CreateOrdinalsByGroupingKeysForMerge(
       const InputTensorList& inputs);
 
+  // Creates a key combiner with no keys, of the same kind as the one this
+  // GroupByAggregator was constructed with. Used to start over once the groups
+  // have been spilled to disk.
+  virtual std::unique_ptr<CompositeKeyCombiner> CreateEmptyKeyCombiner() const;
+
+  // Whether the rows of a single input may be partitioned by key and
+  // accumulated separately, see SetParallelAccumulate.
+  virtual bool CanPartitionInputs() const { return true; }
+
   StatusOr<std::string> Serialize() && override;
 
   inline size_t num_keys_per_input() const { return num_keys_per_input_; }
@@ -196,6 +305,11 @@ class GroupByAggregator : public TensorAggregator {
   // this GroupByAggregator.
   Status AggregateTensorsInternal(InputTensorList tensors);
 
+  // Implementation of AggregateTensorsInternal for the validated `tensors`,
+  // whose rows are accumulated by partition when a scheduler is set by
+  // SetParallelAccumulate.
+  Status ParallelAggregateTensors(const InputTensorList& tensors);
+
   // Internal implementation to merge the input tensors into the state of this
   // GroupByAggregator. The num_merged_inputs arg contains the number of inputs
   // that were pre-accumulated into the tensors input param.
@@ -206,6 +320,19 @@ class GroupByAggregator : public TensorAggregator {
   // Once this function is called, CheckValid will return false.
   OutputTensorList TakeOutputsInternal();
 
+  // Implementation of Serialize and SerializeSnapshot, which stores the keys as
+  // a snapshot of the key combiner if `snapshot_keys` is true.
+  StatusOr<std::string> SerializeInternal(bool snapshot_keys);
+
+  // Same as TakeOutputsInternal, but ignores the groups spilled to disk.
+  OutputTensorList TakeGroupsInMemory();
+
+  // Merges the groups in `groups`, laid out as the outputs of
+  // TakeOutputsInternal, at the given `rows` into this GroupByAggregator
+  // without counting any input.
+  Status MergeRows(const OutputTensorList& groups,
+                   absl::Span<const int64_t> rows);
+
   // If there are key tensors for this GroupByAggregator, then group key inputs
   // into unique composite keys, and produce an ordinal for each element of the
   // input corresponding to the index of the unique composite key in the output.
@@ -222,6 +349,32 @@ class GroupByAggregator : public TensorAggregator {
   // TODO: b/280653641 - Also validate that intrinsic URIs match.
   Status IsCompatible(const GroupByAggregator& other) const;
 
+  // Creates the inner aggregators of this GroupByAggregator, either empty or
+  // holding the nested state in `state`.
+  StatusOr<std::vector<std::unique_ptr<OneDimBaseGroupingAggregator>>>
+  CreateInnerAggregators(const GroupByAggregatorState* state) const;
+
+  // Creates a GroupByAggregator with the same keys and inner intrinsics as
+  // this one, but with a plain key combiner, into which the groups of one
+  // partition are combined. The aggregator is either empty or holds `state`.
+  StatusOr<std::unique_ptr<GroupByAggregator>> CreateMergePartition(
+      const GroupByAggregatorState* state = nullptr) const;
+
+  // Implementation of MergeWithAll for the validated `others` when a merge
+  // scheduler is set.
+  Status ParallelMergeWithAll(absl::Span<GroupByAggregator* const> others);
+
+  // Spills the groups in memory to disk if there are more of them than
+  // allowed by EnableSpilling.
+  Status SpillIfNeeded();
+
+  // Writes the groups in memory to the files of their partitions, and starts
+  // over with no groups in memory.
+  Status Spill();
+
+  // Reads the spilled groups back and merges them into the groups in memory.
+  Status MergeSpilledGroups();
+
   bool output_consumed_ = false;
   int num_inputs_;
   const size_t num_keys_per_input_;
@@ -230,6 +383,34 @@ class GroupByAggregator : public TensorAggregator {
   const std::vector<Intrinsic>& intrinsics_;
   const std::vector<TensorSpec>& output_key_specs_;
   std::vector<std::unique_ptr<OneDimBaseGroupingAggregator>> aggregators_;
+
+  // Parallel MergeWithAll settings, see SetParallelMerge.
+  Scheduler* merge_scheduler_ = nullptr;
+  int num_merge_tasks_ = 1;
+  size_t num_merge_partitions_ = kDefaultMergePartitions;
+
+  // Parallel Accumulate settings, see SetParallelAccumulate.
+  Scheduler* accumulate_scheduler_ = nullptr;
+  int num_accumulate_tasks_ = 1;
+  size_t num_accumulate_partitions_ = kDefaultMergePartitions;
+  size_t min_parallel_accumulate_rows_ = kDefaultMinParallelAccumulateRows;
+
+  // Parallel output key settings, see SetParallelOutputKeys.
+  Scheduler* output_keys_scheduler_ = nullptr;
+  int num_output_keys_tasks_ = 1;
+
+  // Spilling settings, see EnableSpilling. Spilling is disabled when
+  // `max_groups_in_memory_` is zero.
+  std::string spill_path_prefix_;
+  size_t max_groups_in_memory_ = 0;
+  size_t num_spill_partitions_ = kDefaultSpillPartitions;
+  // The number of times the groups have been spilled.
+  int num_spills_ = 0;
+  // The inputs that had been counted by the inner aggregators when their
+  // groups were spilled.
+  int num_spilled_inner_inputs_ = 0;
+  // The files holding the spilled groups of each partition.
+  std::vector<std::vector<std::string>> spill_files_;
 };
 
 // Factory class for the GroupByAggregator.
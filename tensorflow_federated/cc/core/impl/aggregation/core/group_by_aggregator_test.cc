@@ -15,16 +15,27 @@
  */
 
 #include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/platform.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/group_by_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
@@ -1377,6 +1388,311 @@ TEST(GroupByAggregatorTest, Accumulate_MultidimensionalTensorsNotSupported) {
                   "Only scalar or one-dimensional tensors are supported."));
 }
 
+Intrinsic CreateInt64KeyIntrinsic() {
+  Intrinsic intrinsic{"fedsql_group_by",
+                      {CreateTensorSpec("key", DT_INT64)},
+                      {CreateTensorSpec("key_out", DT_INT64)},
+                      {},
+                      {}};
+  intrinsic.nested_intrinsics.push_back(
+      CreateDefaultInnerIntrinsic(DT_INT32, DT_INT64));
+  return intrinsic;
+}
+
+// Creates an aggregator that has accumulated a value of 1 for each of `keys`.
+std::unique_ptr<TensorAggregator> CreateCountingAggregator(
+    const Intrinsic& intrinsic, const std::vector<int64_t>& keys) {
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  const TensorShape shape = {static_cast<int64_t>(keys.size())};
+  Tensor key_tensor =
+      Tensor::Create(DT_INT64, shape,
+                     std::make_unique<MutableVectorData<int64_t>>(keys.begin(),
+                                                                  keys.end()))
+          .value();
+  Tensor value_tensor =
+      Tensor::Create(
+          DT_INT32, shape,
+          std::make_unique<MutableVectorData<int32_t>>(keys.size(), 1))
+          .value();
+  EXPECT_THAT(aggregator->Accumulate({&key_tensor, &value_tensor}), IsOk());
+  return aggregator;
+}
+
+// Reports the aggregator and returns the count of each key.
+std::map<int64_t, int64_t> ReportCounts(TensorAggregator& aggregator) {
+  OutputTensorList outputs = std::move(aggregator).Report().value();
+  absl::Span<const int64_t> keys = outputs[0].AsSpan<int64_t>();
+  absl::Span<const int64_t> counts = outputs[1].AsSpan<int64_t>();
+  std::map<int64_t, int64_t> result;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_TRUE(result.emplace(keys[i], counts[i]).second);
+  }
+  return result;
+}
+
+TEST(GroupByAggregatorTest, MergeWithAll_Parallel_MatchesSerialMerge) {
+  Intrinsic intrinsic = CreateInt64KeyIntrinsic();
+  // The keys of the aggregators overlap with each other and with the keys of
+  // the aggregator they are merged into.
+  std::vector<std::vector<int64_t>> keys;
+  for (int64_t i = 0; i < 8; ++i) {
+    keys.push_back({i, i + 1, i + 1, i * 3, 100 - i});
+  }
+  const std::vector<int64_t> initial_keys = {1, 2, 3, 50};
+
+  auto serial = CreateCountingAggregator(intrinsic, initial_keys);
+  for (const std::vector<int64_t>& other_keys : keys) {
+    EXPECT_THAT(
+        serial->MergeWith(std::move(
+            *CreateCountingAggregator(intrinsic, other_keys))),
+        IsOk());
+  }
+
+  auto scheduler = CreateThreadPoolScheduler(3);
+  auto parallel = CreateCountingAggregator(intrinsic, initial_keys);
+  dynamic_cast<GroupByAggregator&>(*parallel).SetParallelMerge(
+      scheduler.get(), 4, /*num_partitions=*/5);
+  std::vector<std::unique_ptr<TensorAggregator>> others;
+  std::vector<TensorAggregator*> other_ptrs;
+  for (const std::vector<int64_t>& other_keys : keys) {
+    others.push_back(CreateCountingAggregator(intrinsic, other_keys));
+    other_ptrs.push_back(others.back().get());
+  }
+  EXPECT_THAT(parallel->MergeWithAll(other_ptrs), IsOk());
+  scheduler->WaitUntilIdle();
+  for (const auto& other : others) {
+    EXPECT_THAT(other->CanReport(), IsFalse());
+  }
+
+  EXPECT_THAT(parallel->GetNumInputs(), Eq(9));
+  EXPECT_THAT(parallel->GetNumInputs(), Eq(serial->GetNumInputs()));
+  EXPECT_THAT(ReportCounts(*parallel), Eq(ReportCounts(*serial)));
+}
+
+TEST(GroupByAggregatorTest, Accumulate_Parallel_MatchesSerialAccumulate) {
+  Intrinsic intrinsic = CreateInt64KeyIntrinsic();
+  std::vector<int64_t> keys;
+  for (int64_t i = 0; i < 1000; ++i) {
+    keys.push_back(i % 37);
+    keys.push_back(i * 7);
+  }
+  auto serial = CreateCountingAggregator(intrinsic, {1, 2, 3, 500});
+  EXPECT_THAT(serial->MergeWith(std::move(
+                  *CreateCountingAggregator(intrinsic, keys))),
+              IsOk());
+
+  auto scheduler = CreateThreadPoolScheduler(3);
+  auto parallel = CreateCountingAggregator(intrinsic, {1, 2, 3, 500});
+  dynamic_cast<GroupByAggregator&>(*parallel).SetParallelAccumulate(
+      scheduler.get(), 4, /*num_partitions=*/5, /*min_rows=*/100);
+  const TensorShape shape = {static_cast<int64_t>(keys.size())};
+  Tensor key_tensor =
+      Tensor::Create(DT_INT64, shape,
+                     std::make_unique<MutableVectorData<int64_t>>(keys.begin(),
+                                                                  keys.end()))
+          .value();
+  Tensor value_tensor =
+      Tensor::Create(
+          DT_INT32, shape,
+          std::make_unique<MutableVectorData<int32_t>>(keys.size(), 1))
+          .value();
+  EXPECT_THAT(parallel->Accumulate({&key_tensor, &value_tensor}), IsOk());
+  scheduler->WaitUntilIdle();
+
+  EXPECT_THAT(parallel->GetNumInputs(), Eq(2));
+  EXPECT_THAT(ReportCounts(*parallel), Eq(ReportCounts(*serial)));
+}
+
+TEST(GroupByAggregatorTest, MergeWithAll_IncompatibleAggregator_MergesNothing) {
+  Intrinsic intrinsic = CreateInt64KeyIntrinsic();
+  Intrinsic other_intrinsic = CreateDefaultIntrinsic();
+  auto scheduler = CreateThreadPoolScheduler(2);
+  auto aggregator = CreateCountingAggregator(intrinsic, {1, 2});
+  dynamic_cast<GroupByAggregator&>(*aggregator)
+      .SetParallelMerge(scheduler.get(), 2);
+  auto compatible = CreateCountingAggregator(intrinsic, {2, 3});
+  auto incompatible = CreateTensorAggregator(other_intrinsic).value();
+  std::vector<TensorAggregator*> others = {compatible.get(),
+                                           incompatible.get()};
+
+  Status s = aggregator->MergeWithAll(others);
+  scheduler->WaitUntilIdle();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(compatible->CanReport(), IsTrue());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(1));
+  EXPECT_THAT(ReportCounts(*aggregator),
+              Eq(std::map<int64_t, int64_t>{{1, 1}, {2, 1}}));
+}
+
+// Queues the tasks it is given, and only runs them in WaitUntilIdle.
+class DeferringScheduler : public Scheduler {
+ public:
+  void Schedule(std::function<void()> task) override {
+    tasks_.push_back(std::move(task));
+  }
+
+  void WaitUntilIdle() override {
+    std::vector<std::function<void()>> tasks = std::move(tasks_);
+    tasks_.clear();
+    for (auto& task : tasks) {
+      task();
+    }
+  }
+
+  size_t num_queued() const { return tasks_.size(); }
+
+ private:
+  std::vector<std::function<void()>> tasks_;
+};
+
+TEST(ForEachShardTest, DoesNotWaitForTasksWhichFoundNoShard) {
+  DeferringScheduler scheduler;
+  std::vector<int> num_calls(3);
+  internal::ForEachShard(&scheduler, /*num_tasks=*/4, /*num_shards=*/3,
+                         [&num_calls](size_t shard) { num_calls[shard]++; });
+  // The calling thread processed all shards, the scheduled tasks haven't run.
+  EXPECT_THAT(num_calls, ::testing::ElementsAre(1, 1, 1));
+  EXPECT_THAT(scheduler.num_queued(), Eq(size_t{2}));
+  // The late tasks find no shard left.
+  scheduler.WaitUntilIdle();
+  EXPECT_THAT(num_calls, ::testing::ElementsAre(1, 1, 1));
+}
+
+TEST(ForEachShardTest, NestedCallsOnSingleThreadDoNotDeadlock) {
+  auto scheduler = CreateThreadPoolScheduler(1);
+  std::vector<std::vector<int>> num_calls(2, std::vector<int>(4));
+  internal::ForEachShard(
+      scheduler.get(), /*num_tasks=*/2, /*num_shards=*/2,
+      [&scheduler, &num_calls](size_t outer) {
+        internal::ForEachShard(
+            scheduler.get(), /*num_tasks=*/2, /*num_shards=*/4,
+            [&num_calls, outer](size_t inner) { num_calls[outer][inner]++; });
+      });
+  scheduler->WaitUntilIdle();
+  EXPECT_THAT(num_calls, ::testing::Each(::testing::ElementsAre(1, 1, 1, 1)));
+}
+
+TEST_P(GroupByAggregatorTest, Spill_MatchesInMemoryAggregation) {
+  Intrinsic intrinsic = CreateInt64KeyIntrinsic();
+  const std::string path_prefix = TemporaryTestFile(".spill");
+  auto in_memory = CreateCountingAggregator(intrinsic, {});
+  auto spilling = CreateTensorAggregator(intrinsic).value();
+  dynamic_cast<GroupByAggregator&>(*spilling).EnableSpilling(
+      path_prefix, /*max_groups_in_memory=*/3, /*num_partitions=*/2);
+  for (int64_t i = 0; i < 5; ++i) {
+    const std::vector<int64_t> keys = {i, i + 1, 2 * i, 7};
+    EXPECT_THAT(in_memory->MergeWith(
+                    std::move(*CreateCountingAggregator(intrinsic, keys))),
+                IsOk());
+    // Accumulate the keys directly into the spilling aggregator.
+    Tensor key_tensor =
+        Tensor::Create(DT_INT64, {4},
+                       CreateTestData<int64_t>({i, i + 1, 2 * i, 7}))
+            .value();
+    Tensor value_tensor =
+        Tensor::Create(DT_INT32, {4}, CreateTestData({1, 1, 1, 1})).value();
+    EXPECT_THAT(spilling->Accumulate({&key_tensor, &value_tensor}), IsOk());
+  }
+  // The first Accumulate already left 4 groups in memory.
+  EXPECT_THAT(FileExists(absl::StrCat(path_prefix, ".0.0")) ||
+                  FileExists(absl::StrCat(path_prefix, ".0.1")),
+              IsTrue());
+
+  if (GetParam()) {
+    auto serialized_state = std::move(*spilling).Serialize();
+    spilling =
+        DeserializeTensorAggregator(intrinsic, serialized_state.value())
+            .value();
+  }
+
+  EXPECT_THAT(spilling->GetNumInputs(), Eq(5));
+  EXPECT_THAT(ReportCounts(*spilling), Eq(ReportCounts(*in_memory)));
+  for (int spill = 0; spill < 5; ++spill) {
+    for (int partition = 0; partition < 2; ++partition) {
+      EXPECT_THAT(FileExists(absl::StrCat(path_prefix, ".", spill, ".",
+                                          partition)),
+                  IsFalse());
+    }
+  }
+}
+
+TEST(GroupByAggregatorTest, Spill_MergeIntoOtherAggregator) {
+  Intrinsic intrinsic = CreateInt64KeyIntrinsic();
+  auto spilling = CreateCountingAggregator(intrinsic, {});
+  dynamic_cast<GroupByAggregator&>(*spilling).EnableSpilling(
+      TemporaryTestFile(".spill"), /*max_groups_in_memory=*/2);
+  EXPECT_THAT(spilling->MergeWith(
+                  std::move(*CreateCountingAggregator(intrinsic, {1, 2, 3}))),
+              IsOk());
+  EXPECT_THAT(spilling->MergeWith(
+                  std::move(*CreateCountingAggregator(intrinsic, {3, 4}))),
+              IsOk());
+
+  auto aggregator = CreateCountingAggregator(intrinsic, {4, 5});
+  EXPECT_THAT(aggregator->MergeWith(std::move(*spilling)), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(4));
+  EXPECT_THAT(ReportCounts(*aggregator),
+              Eq(std::map<int64_t, int64_t>{
+                  {1, 1}, {2, 1}, {3, 2}, {4, 2}, {5, 1}}));
+}
+
+TEST(GroupByAggregatorTest, SerializeSnapshot_RoundTrips) {
+  Intrinsic intrinsic = CreateInt64KeyIntrinsic();
+  auto aggregator = CreateCountingAggregator(intrinsic, {3, 1, 3, 2});
+  auto snapshot = std::move(dynamic_cast<GroupByAggregator&>(*aggregator))
+                      .SerializeSnapshot();
+  ASSERT_THAT(snapshot, IsOk());
+  GroupByAggregatorState state;
+  ASSERT_TRUE(state.ParseFromString(snapshot.value()));
+  EXPECT_TRUE(state.keys().empty());
+  EXPECT_FALSE(state.key_snapshot().empty());
+
+  auto deserialized =
+      DeserializeTensorAggregator(intrinsic, snapshot.value()).value();
+  EXPECT_THAT(deserialized->MergeWith(
+                  std::move(*CreateCountingAggregator(intrinsic, {2, 4}))),
+              IsOk());
+  EXPECT_THAT(deserialized->GetNumInputs(), Eq(2));
+  EXPECT_THAT(ReportCounts(*deserialized),
+              Eq(std::map<int64_t, int64_t>{{1, 1}, {2, 2}, {3, 2}, {4, 1}}));
+}
+
+TEST(GroupByAggregatorTest, SerializeSnapshot_CompositeStringKeys) {
+  Intrinsic intrinsic = {"fedsql_group_by",
+                         {CreateTensorSpec("key1", DT_STRING),
+                          CreateTensorSpec("key2", DT_INT64)},
+                         {CreateTensorSpec("key1_out", DT_STRING),
+                          CreateTensorSpec("key2_out", DT_INT64)},
+                         {},
+                         {}};
+  intrinsic.nested_intrinsics.push_back(
+      CreateDefaultInnerIntrinsic(DT_INT32, DT_INT64));
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  Tensor key1 = Tensor::Create(DT_STRING, {3},
+                               CreateTestData<string_view>({"a", "b", "a"}))
+                    .value();
+  Tensor key2 =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({1, 1, 2}))
+          .value();
+  Tensor value =
+      Tensor::Create(DT_INT32, {3}, CreateTestData<int32_t>({1, 2, 3}))
+          .value();
+  EXPECT_THAT(aggregator->Accumulate({&key1, &key2, &value}), IsOk());
+  auto snapshot =
+      std::move(dynamic_cast<GroupByAggregator&>(*aggregator))
+          .SerializeSnapshot();
+  ASSERT_THAT(snapshot, IsOk());
+
+  auto deserialized =
+      DeserializeTensorAggregator(intrinsic, snapshot.value()).value();
+  EXPECT_THAT(deserialized->Accumulate({&key1, &key2, &value}), IsOk());
+  auto result = std::move(*deserialized).Report();
+  ASSERT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<string_view>({3}, {"a", "b", "a"}));
+  EXPECT_THAT(result.value()[1], IsTensor<int64_t>({3}, {1, 1, 2}));
+  EXPECT_THAT(result.value()[2], IsTensor<int64_t>({3}, {2, 4, 6}));
+}
+
 TEST(GroupByAggregatorTest, Merge_IncompatibleKeyType) {
   Intrinsic intrinsic = CreateDefaultIntrinsic();
   auto aggregator1 = CreateTensorAggregator(intrinsic).value();
@@ -1706,6 +2022,29 @@ TEST(GroupByAggregatorTest, Deserialize_FailToParseProto) {
   EXPECT_THAT(s.message(), HasSubstr("Failed to parse"));
 }
 
+TEST(GroupByAggregatorTest, GetMemoryUsage_GrowsWithKeys) {
+  Intrinsic intrinsic = CreateDefaultIntrinsic();
+  auto group_by_aggregator = CreateTensorAggregator(intrinsic).value();
+  size_t empty_memory_usage = group_by_aggregator->GetMemoryUsage();
+  Tensor key = Tensor::Create(DT_STRING, {2},
+                              CreateTestData<string_view>({"a", "b"}))
+                   .value();
+  Tensor t1 = Tensor::Create(DT_INT32, {2}, CreateTestData({1, 2})).value();
+  EXPECT_THAT(group_by_aggregator->Accumulate({&key, &t1}), IsOk());
+  size_t memory_usage = group_by_aggregator->GetMemoryUsage();
+  EXPECT_GT(memory_usage, empty_memory_usage);
+
+  // The keys are long enough to be allocated outside of the std::string.
+  std::string long_key_c(100, 'c');
+  std::string long_key_d(100, 'd');
+  Tensor long_keys =
+      Tensor::Create(DT_STRING, {2},
+                     CreateTestData<string_view>({long_key_c, long_key_d}))
+          .value();
+  EXPECT_THAT(group_by_aggregator->Accumulate({&long_keys, &t1}), IsOk());
+  EXPECT_GE(group_by_aggregator->GetMemoryUsage(), memory_usage + 200);
+}
+
 INSTANTIATE_TEST_SUITE_P(
     GroupByAggregatorTestInstantiation, GroupByAggregatorTest,
     testing::ValuesIn<bool>({false, true}),
@@ -86,6 +86,102 @@ static void BM_GroupBySumAccumulate(benchmark::State& state) {
 
 BENCHMARK(BM_GroupBySumAccumulate);
 
+// Benchmarks grouping by a composite key with `state.range(0)` distinct values,
+// which stresses the lookup and insertion of keys in the CompositeKeyCombiner.
+static void BM_GroupBySumAccumulateDistinctKeys(benchmark::State& state) {
+  const int64_t num_distinct_keys = state.range(0);
+  Intrinsic inner_intrinsic = Intrinsic{"GoogleSQL:sum",
+                                        {TensorSpec("value", DT_INT64, {-1})},
+                                        {TensorSpec("value", DT_INT64, {-1})},
+                                        {},
+                                        {}};
+  Intrinsic intrinsic{
+      "fedsql_group_by",
+      {TensorSpec("key1", DT_INT64, {-1}), TensorSpec("key2", DT_INT32, {-1})},
+      {TensorSpec("key1_out", DT_INT64, {-1}),
+       TensorSpec("key2_out", DT_INT32, {-1})},
+      {},
+      {}};
+  intrinsic.nested_intrinsics.push_back(std::move(inner_intrinsic));
+  std::unique_ptr<TensorAggregator> aggregator =
+      CreateTensorAggregator(intrinsic).value();
+
+  auto keys1 = std::make_unique<MutableVectorData<int64_t>>(kTensorLength);
+  auto keys2 = std::make_unique<MutableVectorData<int32_t>>(kTensorLength);
+  auto values = std::make_unique<MutableVectorData<int64_t>>(kTensorLength);
+  for (int64_t i = 0; i < kTensorLength; ++i) {
+    // Spread the keys so that consecutive elements belong to different groups.
+    int64_t key = (i * 7919) % num_distinct_keys;
+    (*keys1)[i] = key * 31;
+    (*keys2)[i] = static_cast<int32_t>(key % 3);
+    (*values)[i] = i % 123;
+  }
+  auto keys1_tensor =
+      Tensor::Create(DT_INT64, {kTensorLength}, std::move(keys1)).value();
+  auto keys2_tensor =
+      Tensor::Create(DT_INT32, {kTensorLength}, std::move(keys2)).value();
+  auto values_tensor =
+      Tensor::Create(DT_INT64, {kTensorLength}, std::move(values)).value();
+  int64_t items_processed = 0;
+
+  // Benchmark time is only measured in the loop body.
+  for (auto s : state) {
+    benchmark::DoNotOptimize(
+        aggregator->Accumulate({&keys1_tensor, &keys2_tensor, &values_tensor}));
+    items_processed += kTensorLength;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK(BM_GroupBySumAccumulateDistinctKeys)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kTensorLength);
+
+// Benchmarks grouping by a single int64 key with `state.range(0)` distinct
+// values, which is handled by a specialized key combiner.
+static void BM_GroupBySumAccumulateSingleKey(benchmark::State& state) {
+  const int64_t num_distinct_keys = state.range(0);
+  Intrinsic inner_intrinsic = Intrinsic{"GoogleSQL:sum",
+                                        {TensorSpec("value", DT_INT64, {-1})},
+                                        {TensorSpec("value", DT_INT64, {-1})},
+                                        {},
+                                        {}};
+  Intrinsic intrinsic{"fedsql_group_by",
+                      {TensorSpec("key", DT_INT64, {-1})},
+                      {TensorSpec("key_out", DT_INT64, {-1})},
+                      {},
+                      {}};
+  intrinsic.nested_intrinsics.push_back(std::move(inner_intrinsic));
+  std::unique_ptr<TensorAggregator> aggregator =
+      CreateTensorAggregator(intrinsic).value();
+
+  auto keys = std::make_unique<MutableVectorData<int64_t>>(kTensorLength);
+  auto values = std::make_unique<MutableVectorData<int64_t>>(kTensorLength);
+  for (int64_t i = 0; i < kTensorLength; ++i) {
+    (*keys)[i] = (i * 7919) % num_distinct_keys;
+    (*values)[i] = i % 123;
+  }
+  auto keys_tensor =
+      Tensor::Create(DT_INT64, {kTensorLength}, std::move(keys)).value();
+  auto values_tensor =
+      Tensor::Create(DT_INT64, {kTensorLength}, std::move(values)).value();
+  int64_t items_processed = 0;
+
+  // Benchmark time is only measured in the loop body.
+  for (auto s : state) {
+    benchmark::DoNotOptimize(
+        aggregator->Accumulate({&keys_tensor, &values_tensor}));
+    items_processed += kTensorLength;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK(BM_GroupBySumAccumulateSingleKey)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->Arg(kTensorLength);
+
 }  // namespace
 }  // namespace aggregation
 }  // namespace tensorflow_federated
@@ -14,9 +14,11 @@
  * limitations under the License.
  */
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
@@ -47,24 +49,15 @@ class GroupingFederatedSum final
   void AggregateVectorByOrdinals(
       const AggVector<int64_t>& ordinals_vector,
       const AggVector<InputT>& value_vector) override {
-    auto value_it = value_vector.begin();
-    for (auto o : ordinals_vector) {
-      int64_t output_index = o.value;
-      // If this function returned a failed Status at this point, the
-      // data_vector_ may have already been partially modified, leaving the
-      // GroupingAggregator in a bad state. Thus, check that the indices of the
-      // ordinals tensor and the data tensor match with TFF_CHECK instead.
-      //
-      // TODO: b/266974165 - Revisit the constraint that the indices of the
-      // values must match the indices of the ordinals when sparse tensors are
-      // implemented. It may be possible for the value to be omitted for a given
-      // ordinal in which case the default value should be used.
-      TFF_CHECK(value_it.index() == o.index)
-          << "Indices in AggVector of ordinals and AggVector of values "
-             "are mismatched.";
+    // The ordinals and the values are dense tensors of the same shape, which
+    // OneDimGroupingAggregator validates, so the value at position i belongs
+    // to the ordinal at position i.
+    absl::Span<const int64_t> ordinals = ordinals_vector.dense_values();
+    absl::Span<const InputT> values = value_vector.dense_values();
+    for (size_t i = 0; i < ordinals.size(); ++i) {
       // Delegate the actual aggregation to the specific aggregation
       // intrinsic implementation.
-      AggregateValue(output_index, OutputT{value_it++.value()});
+      AggregateValue(ordinals[i], OutputT{values[i]});
     }
   }
 
@@ -73,13 +66,10 @@ class GroupingFederatedSum final
   // the Merge case matches OutputT rather than InputT.
   void MergeVectorByOrdinals(const AggVector<int64_t>& ordinals_vector,
                              const AggVector<OutputT>& value_vector) override {
-    auto value_it = value_vector.begin();
-    for (auto o : ordinals_vector) {
-      int64_t output_index = o.value;
-      TFF_CHECK(value_it.index() == o.index)
-          << "Indices in AggVector of ordinals and AggVector of values "
-             "are mismatched.";
-      AggregateValue(output_index, value_it++.value());
+    absl::Span<const int64_t> ordinals = ordinals_vector.dense_values();
+    absl::Span<const OutputT> values = value_vector.dense_values();
+    for (size_t i = 0; i < ordinals.size(); ++i) {
+      AggregateValue(ordinals[i], values[i]);
     }
   }
 
@@ -0,0 +1,312 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/hyperloglog.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/one_dim_grouping_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_data_delta.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+constexpr char kGoogleSqlHllCountUri[] = "GoogleSQL:hll_count";
+
+// Grouping aggregator that keeps a HyperLogLog sketch of the values of each
+// group, like GoogleSQL's HLL_COUNT.INIT.
+//
+// The registers of all groups are stored back to back in a single vector, so
+// that the sketch of the group with ordinal i is the `num_registers` bytes
+// starting at i * num_registers. The output of each group is the string of
+// its registers, so that the outputs of one GroupByAggregator can be merged
+// into another like those of the other grouping aggregators. The distinct
+// counts are extracted from the reported sketches with ExtractHllCounts.
+template <typename InputT>
+class GroupingHllCount final : public OneDimBaseGroupingAggregator {
+ public:
+  GroupingHllCount(size_t num_registers, std::vector<uint8_t> registers,
+                   int num_inputs)
+      : num_registers_(num_registers),
+        registers_(std::move(registers)),
+        num_inputs_(num_inputs) {}
+
+  Status MergeTensors(InputTensorList tensors, int num_inputs) override {
+    TFF_RETURN_IF_ERROR(CheckValid());
+    TFF_RETURN_IF_ERROR(ValidateTensorInputs(tensors));
+    if (tensors[1]->dtype() != DT_STRING) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCount::MergeTensors: dtype mismatch for tensor 1. "
+                "Expected DT_STRING.";
+    }
+    // Check all sketches before changing any state, so that an invalid
+    // sketch leaves the aggregator as it was.
+    absl::Span<const int64_t> ordinals = tensors[0]->AsSpan<int64_t>();
+    absl::Span<const string_view> sketches = tensors[1]->AsSpan<string_view>();
+    for (string_view sketch : sketches) {
+      if (sketch.size() != num_registers_) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "GroupingHllCount::MergeTensors: Expected sketches with "
+               << num_registers_ << " registers but got " << sketch.size();
+      }
+    }
+    ResizeRegisters(ordinals);
+    for (size_t i = 0; i < ordinals.size(); ++i) {
+      if (ordinals[i] < 0) continue;
+      HllMerge(absl::Span<const uint8_t>(
+                   reinterpret_cast<const uint8_t*>(sketches[i].data()),
+                   num_registers_),
+               GroupRegisters(ordinals[i]));
+      MarkChanged(ordinals[i]);
+    }
+    num_inputs_ += num_inputs;
+    return TFF_STATUS(OK);
+  }
+
+  OneDimGroupingAggregatorState ToProto() override {
+    OneDimGroupingAggregatorState aggregator_state;
+    aggregator_state.set_num_inputs(num_inputs_);
+    aggregator_state.mutable_vector_data()->assign(
+        reinterpret_cast<const char*>(registers_.data()), registers_.size());
+    return aggregator_state;
+  }
+
+  // Changes are tracked from the first call on. A chunk of the tracker is
+  // never smaller than a sketch, and both sizes are powers of 2, so each
+  // sketch lies in a single chunk.
+  OneDimGroupingAggregatorDelta ToDeltaProto() override {
+    if (!change_tracker_.has_value()) {
+      change_tracker_.emplace(std::max(
+          num_registers_, VectorDataChangeTracker::kDefaultChunkSize));
+    }
+    OneDimGroupingAggregatorDelta delta;
+    delta.set_num_inputs(num_inputs_);
+    *delta.mutable_vector_data() = change_tracker_->TakeDelta(registers_);
+    return delta;
+  }
+
+  int GetNumInputs() const override { return num_inputs_; }
+
+  size_t GetMemoryUsage() const override {
+    return registers_.capacity() * sizeof(uint8_t);
+  }
+
+  Status CheckValid() const override {
+    if (output_consumed_) {
+      return TFF_STATUS(FAILED_PRECONDITION)
+             << "GroupingHllCount::CheckValid: Output has already been "
+                "consumed.";
+    }
+    return TFF_STATUS(OK);
+  }
+
+ private:
+  Status AggregateTensors(InputTensorList tensors) override {
+    TFF_RETURN_IF_ERROR(ValidateTensorInputs(tensors));
+    if (tensors[1]->dtype() != internal::TypeTraits<InputT>::kDataType) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCount::AggregateTensors: dtype mismatch for "
+                "tensor 1";
+    }
+    absl::Span<const int64_t> ordinals = tensors[0]->AsSpan<int64_t>();
+    absl::Span<const InputT> values = tensors[1]->AsSpan<InputT>();
+    ResizeRegisters(ordinals);
+    for (size_t i = 0; i < ordinals.size(); ++i) {
+      if (ordinals[i] < 0) continue;
+      HllAdd(HllHash(values[i]), GroupRegisters(ordinals[i]));
+      MarkChanged(ordinals[i]);
+    }
+    num_inputs_++;
+    return TFF_STATUS(OK);
+  }
+
+  OutputTensorList TakeOutputs() && override {
+    output_consumed_ = true;
+    const size_t num_groups = registers_.size() / num_registers_;
+    std::vector<string_view> sketches;
+    sketches.reserve(num_groups);
+    for (size_t i = 0; i < num_groups; ++i) {
+      sketches.emplace_back(
+          reinterpret_cast<const char*>(registers_.data()) + i * num_registers_,
+          num_registers_);
+    }
+    // ContiguousStringData copies the sketches, so the registers can be
+    // released afterwards.
+    OutputTensorList outputs = std::vector<Tensor>();
+    outputs.push_back(
+        Tensor::Create(DT_STRING, TensorShape{static_cast<int64_t>(num_groups)},
+                       std::make_unique<ContiguousStringData>(sketches))
+            .value());
+    registers_.clear();
+    return outputs;
+  }
+
+  absl::Span<uint8_t> GroupRegisters(int64_t ordinal) {
+    return absl::Span<uint8_t>(registers_.data() + ordinal * num_registers_,
+                               num_registers_);
+  }
+
+  void ResizeRegisters(absl::Span<const int64_t> ordinals) {
+    size_t num_groups = registers_.size() / num_registers_;
+    for (int64_t ordinal : ordinals) {
+      if (ordinal >= static_cast<int64_t>(num_groups)) {
+        num_groups = ordinal + 1;
+      }
+    }
+    // Resize once outside the loop to avoid quadratic behavior.
+    registers_.resize(num_groups * num_registers_, 0);
+  }
+
+  void MarkChanged(int64_t ordinal) {
+    if (change_tracker_.has_value()) {
+      change_tracker_->MarkChanged(ordinal * num_registers_);
+    }
+  }
+
+  bool output_consumed_ = false;
+  const size_t num_registers_;
+  std::vector<uint8_t> registers_;
+  int num_inputs_;
+  // Tracks the changes since the last ToDeltaProto call, if any.
+  std::optional<VectorDataChangeTracker> change_tracker_;
+};
+
+template <typename InputT>
+StatusOr<std::unique_ptr<TensorAggregator>> CreateGroupingHllCount(
+    size_t num_registers,
+    const OneDimGroupingAggregatorState* aggregator_state) {
+  if (aggregator_state == nullptr) {
+    return std::make_unique<GroupingHllCount<InputT>>(
+        num_registers, std::vector<uint8_t>(), 0);
+  }
+  const std::string& vector_data = aggregator_state->vector_data();
+  if (vector_data.size() % num_registers != 0) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "GroupingHllCount: The size of the serialized registers isn't "
+              "a multiple of the number of registers of a sketch.";
+  }
+  return std::make_unique<GroupingHllCount<InputT>>(
+      num_registers, std::vector<uint8_t>(vector_data.begin(),
+                                          vector_data.end()),
+      aggregator_state->num_inputs());
+}
+
+// Factory class for the GroupingHllCount.
+class GroupingHllCountFactory final
+    : public OneDimBaseGroupingAggregatorFactory {
+ public:
+  GroupingHllCountFactory() = default;
+
+  // GroupingHllCountFactory isn't copyable or moveable.
+  GroupingHllCountFactory(const GroupingHllCountFactory&) = delete;
+  GroupingHllCountFactory& operator=(const GroupingHllCountFactory&) = delete;
+
+ private:
+  StatusOr<std::unique_ptr<TensorAggregator>> CreateInternal(
+      const Intrinsic& intrinsic,
+      const OneDimGroupingAggregatorState* aggregator_state) const override {
+    if (kGoogleSqlHllCountUri != intrinsic.uri) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCountFactory: Expected intrinsic URI "
+             << kGoogleSqlHllCountUri << " but got uri " << intrinsic.uri;
+    }
+    if (intrinsic.inputs.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCountFactory: Exactly one input is expected but "
+                "got "
+             << intrinsic.inputs.size();
+    }
+    if (intrinsic.outputs.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCountFactory: Exactly one output tensor is "
+                "expected but got "
+             << intrinsic.outputs.size();
+    }
+    if (!intrinsic.nested_intrinsics.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCountFactory: Not expected to have inner "
+                "aggregations.";
+    }
+
+    // The optional parameter is the precision of the sketches.
+    int64_t precision = kDefaultHllPrecision;
+    if (intrinsic.parameters.size() > 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCountFactory: At most one parameter, the "
+                "precision, is expected but got "
+             << intrinsic.parameters.size();
+    }
+    if (!intrinsic.parameters.empty()) {
+      const Tensor& precision_tensor = intrinsic.parameters[0];
+      if (internal::GetTypeKind(precision_tensor.dtype()) !=
+              internal::TypeKind::kNumeric ||
+          precision_tensor.num_elements() != 1) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "GroupingHllCountFactory: The precision must be a "
+                  "numerical scalar.";
+      }
+      precision = precision_tensor.CastToScalar<int64_t>();
+      if (precision < kMinHllPrecision || precision > kMaxHllPrecision) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "GroupingHllCountFactory: The precision must be between "
+               << kMinHllPrecision << " and " << kMaxHllPrecision;
+      }
+    }
+
+    const TensorSpec& input_spec = intrinsic.inputs[0];
+    const TensorSpec& output_spec = intrinsic.outputs[0];
+    if (input_spec.shape() != output_spec.shape()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCountFactory: Input and output tensors have "
+                "mismatched shapes.";
+    }
+    if (output_spec.dtype() != DT_STRING) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingHllCountFactory: The output tensor must have dtype "
+                "DT_STRING to hold the sketches.";
+    }
+
+    const size_t num_registers = size_t{1} << precision;
+    StatusOr<std::unique_ptr<TensorAggregator>> aggregator;
+    DTYPE_CASES(input_spec.dtype(), InputT,
+                aggregator = (CreateGroupingHllCount<InputT>(
+                    num_registers, aggregator_state)));
+    return aggregator;
+  }
+};
+
+REGISTER_AGGREGATOR_FACTORY(kGoogleSqlHllCountUri, GroupingHllCountFactory);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
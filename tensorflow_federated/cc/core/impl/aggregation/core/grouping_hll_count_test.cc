@@ -0,0 +1,272 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/hyperloglog.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/one_dim_grouping_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_data_delta.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::IsTrue;
+using ::testing::Lt;
+using testing::TestWithParam;
+
+using GroupingHllCountTest = TestWithParam<bool>;
+
+Intrinsic CreateHllCountIntrinsic(DataType input_dtype) {
+  return Intrinsic{"GoogleSQL:hll_count",
+                   {TensorSpec{"user_id", input_dtype, {-1}}},
+                   {TensorSpec{"user_id_sketch", DT_STRING, {-1}}},
+                   {},
+                   {}};
+}
+
+Intrinsic CreateGroupByIntrinsic() {
+  Intrinsic intrinsic{"fedsql_group_by",
+                      {TensorSpec{"key", DT_STRING, {-1}}},
+                      {TensorSpec{"key_out", DT_STRING, {-1}}},
+                      {},
+                      {}};
+  intrinsic.nested_intrinsics.push_back(CreateHllCountIntrinsic(DT_STRING));
+  return intrinsic;
+}
+
+// Round trips the aggregator through its intermediate state.
+std::unique_ptr<TensorAggregator> RoundTrip(
+    const Intrinsic& intrinsic, std::unique_ptr<TensorAggregator> aggregator) {
+  auto factory = dynamic_cast<const OneDimBaseGroupingAggregatorFactory*>(
+      GetAggregatorFactory(intrinsic.uri).value());
+  auto one_dim_base_aggregator = std::unique_ptr<OneDimBaseGroupingAggregator>(
+      dynamic_cast<OneDimBaseGroupingAggregator*>(aggregator.release()));
+  OneDimGroupingAggregatorState state = one_dim_base_aggregator->ToProto();
+  return factory->FromProto(intrinsic, state).value();
+}
+
+TEST_P(GroupingHllCountTest, Aggregate_Succeeds) {
+  Intrinsic intrinsic = CreateHllCountIntrinsic(DT_INT64);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  Tensor ordinals =
+      Tensor::Create(DT_INT64, {4}, CreateTestData<int64_t>({0, 1, 0, 1}))
+          .value();
+  Tensor t1 = Tensor::Create(DT_INT64, {4},
+                             CreateTestData<int64_t>({1, 10, 2, 10}))
+                  .value();
+  Tensor t2 = Tensor::Create(DT_INT64, {4},
+                             CreateTestData<int64_t>({3, 10, 1, 20}))
+                  .value();
+  EXPECT_THAT(aggregator->Accumulate({&ordinals, &t1}), IsOk());
+  if (GetParam()) {
+    aggregator = RoundTrip(intrinsic, std::move(aggregator));
+  }
+  EXPECT_THAT(aggregator->Accumulate({&ordinals, &t2}), IsOk());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(2));
+  EXPECT_THAT(aggregator->CanReport(), IsTrue());
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  ASSERT_THAT(result->size(), Eq(1));
+  EXPECT_THAT(result.value()[0].dtype(), Eq(DT_STRING));
+  EXPECT_THAT(result.value()[0].AsSpan<string_view>()[0].size(),
+              Eq(size_t{1} << kDefaultHllPrecision));
+  EXPECT_THAT(ExtractHllCounts(result.value()[0]),
+              IsOkAndHolds(IsTensor<int64_t>({2}, {3, 2})));
+}
+
+TEST_P(GroupingHllCountTest, MergeTensors_Succeeds) {
+  Intrinsic intrinsic = CreateHllCountIntrinsic(DT_STRING);
+  auto aggregator1 = CreateTensorAggregator(intrinsic).value();
+  auto aggregator2 = CreateTensorAggregator(intrinsic).value();
+  Tensor ordinals =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({0, 1, 1}))
+          .value();
+  Tensor t1 = Tensor::Create(DT_STRING, {3},
+                             CreateTestData<string_view>({"a", "b", "c"}))
+                  .value();
+  Tensor t2 = Tensor::Create(DT_STRING, {3},
+                             CreateTestData<string_view>({"a", "d", "e"}))
+                  .value();
+  EXPECT_THAT(aggregator1->Accumulate({&ordinals, &t1}), IsOk());
+  EXPECT_THAT(aggregator2->Accumulate({&ordinals, &t2}), IsOk());
+  if (GetParam()) {
+    aggregator1 = RoundTrip(intrinsic, std::move(aggregator1));
+    aggregator2 = RoundTrip(intrinsic, std::move(aggregator2));
+  }
+
+  // The groups of the second aggregator are merged in reverse order.
+  OutputTensorList sketches = std::move(*aggregator2).Report().value();
+  Tensor merge_ordinals =
+      Tensor::Create(DT_INT64, {2}, CreateTestData<int64_t>({1, 0})).value();
+  auto one_dim_aggregator =
+      dynamic_cast<OneDimBaseGroupingAggregator*>(aggregator1.get());
+  EXPECT_THAT(one_dim_aggregator->MergeTensors({&merge_ordinals, &sketches[0]},
+                                               /*num_inputs=*/1),
+              IsOk());
+  EXPECT_THAT(aggregator1->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*aggregator1).Report();
+  EXPECT_THAT(result, IsOk());
+  // Group 0 has "a", "d" and "e", and group 1 has "a", "b" and "c".
+  EXPECT_THAT(ExtractHllCounts(result.value()[0]),
+              IsOkAndHolds(IsTensor<int64_t>({2}, {3, 3})));
+}
+
+TEST_P(GroupingHllCountTest, GroupBy_MergeAndSerialize_Succeeds) {
+  Intrinsic intrinsic = CreateGroupByIntrinsic();
+  auto aggregator1 = CreateTensorAggregator(intrinsic).value();
+  auto aggregator2 = CreateTensorAggregator(intrinsic).value();
+  Tensor keys1 = Tensor::Create(DT_STRING, {3},
+                                CreateTestData<string_view>({"a", "b", "a"}))
+                     .value();
+  Tensor values1 = Tensor::Create(DT_STRING, {3},
+                                  CreateTestData<string_view>({"x", "y", "z"}))
+                       .value();
+  Tensor keys2 =
+      Tensor::Create(DT_STRING, {2}, CreateTestData<string_view>({"b", "a"}))
+          .value();
+  Tensor values2 =
+      Tensor::Create(DT_STRING, {2}, CreateTestData<string_view>({"y", "w"}))
+          .value();
+  EXPECT_THAT(aggregator1->Accumulate({&keys1, &values1}), IsOk());
+  EXPECT_THAT(aggregator2->Accumulate({&keys2, &values2}), IsOk());
+  if (GetParam()) {
+    auto serialized_state = std::move(*aggregator1).Serialize();
+    aggregator1 =
+        DeserializeTensorAggregator(intrinsic, serialized_state.value())
+            .value();
+  }
+
+  EXPECT_THAT(aggregator1->MergeWith(std::move(*aggregator2)), IsOk());
+  auto result = std::move(*aggregator1).Report();
+  EXPECT_THAT(result, IsOk());
+  ASSERT_THAT(result->size(), Eq(2));
+  EXPECT_THAT(result.value()[0], IsTensor<string_view>({2}, {"a", "b"}));
+  EXPECT_THAT(ExtractHllCounts(result.value()[1]),
+              IsOkAndHolds(IsTensor<int64_t>({2}, {3, 1})));
+}
+
+TEST(GroupingHllCountErrorTest, ToDeltaProto_HoldsChangedGroups) {
+  Intrinsic intrinsic = CreateHllCountIntrinsic(DT_INT32);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  auto one_dim_aggregator =
+      dynamic_cast<OneDimBaseGroupingAggregator*>(aggregator.get());
+  Tensor ordinals =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({0, 1, 2}))
+          .value();
+  Tensor t = Tensor::Create(DT_INT32, {3}, CreateTestData({1, 2, 3})).value();
+  EXPECT_THAT(aggregator->Accumulate({&ordinals, &t}), IsOk());
+  OneDimGroupingAggregatorState state;
+  EXPECT_THAT(ApplyOneDimGroupingAggregatorDelta(
+                  one_dim_aggregator->ToDeltaProto(), state),
+              IsOk());
+
+  // Only the sketch of group 1 changes.
+  Tensor ordinal =
+      Tensor::Create(DT_INT64, {1}, CreateTestData<int64_t>({1})).value();
+  Tensor value = Tensor::Create(DT_INT32, {1}, CreateTestData({4})).value();
+  EXPECT_THAT(aggregator->Accumulate({&ordinal, &value}), IsOk());
+  OneDimGroupingAggregatorDelta delta = one_dim_aggregator->ToDeltaProto();
+  ASSERT_THAT(delta.vector_data().chunks_size(), Eq(1));
+  EXPECT_THAT(delta.vector_data().chunks(0).offset(),
+              Eq(size_t{1} << kDefaultHllPrecision));
+  EXPECT_THAT(delta.vector_data().chunks(0).data().size(),
+              Lt(delta.vector_data().byte_size()));
+  EXPECT_THAT(ApplyOneDimGroupingAggregatorDelta(delta, state), IsOk());
+  EXPECT_THAT(state.SerializeAsString(),
+              Eq(one_dim_aggregator->ToProto().SerializeAsString()));
+}
+
+TEST(GroupingHllCountErrorTest, MergeTensors_DifferentPrecision_Fails) {
+  Intrinsic intrinsic = CreateHllCountIntrinsic(DT_INT32);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  std::string sketch(16, 0);
+  Tensor ordinals =
+      Tensor::Create(DT_INT64, {1}, CreateTestData<int64_t>({0})).value();
+  Tensor sketches =
+      Tensor::Create(DT_STRING, {1}, CreateTestData<string_view>({sketch}))
+          .value();
+  Status s = dynamic_cast<OneDimBaseGroupingAggregator*>(aggregator.get())
+                 ->MergeTensors({&ordinals, &sketches}, 1);
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("Expected sketches with 4096 registers"));
+}
+
+TEST(GroupingHllCountErrorTest, Create_CustomPrecision_Succeeds) {
+  Intrinsic intrinsic = CreateHllCountIntrinsic(DT_FLOAT);
+  intrinsic.parameters.push_back(
+      Tensor::Create(DT_INT32, {}, CreateTestData({4})).value());
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  Tensor ordinals =
+      Tensor::Create(DT_INT64, {1}, CreateTestData<int64_t>({0})).value();
+  Tensor t = Tensor::Create(DT_FLOAT, {1}, CreateTestData({1.5f})).value();
+  EXPECT_THAT(aggregator->Accumulate({&ordinals, &t}), IsOk());
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0].AsSpan<string_view>()[0].size(), Eq(16));
+  EXPECT_THAT(ExtractHllCounts(result.value()[0]),
+              IsOkAndHolds(IsTensor<int64_t>({1}, {1})));
+}
+
+TEST(GroupingHllCountErrorTest, Create_InvalidPrecision_Fails) {
+  Intrinsic intrinsic = CreateHllCountIntrinsic(DT_FLOAT);
+  intrinsic.parameters.push_back(
+      Tensor::Create(DT_INT32, {}, CreateTestData({17})).value());
+  Status s = CreateTensorAggregator(intrinsic).status();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("precision must be between 4 and 16"));
+}
+
+TEST(GroupingHllCountErrorTest, Create_NonStringOutput_Fails) {
+  Intrinsic intrinsic = CreateHllCountIntrinsic(DT_FLOAT);
+  intrinsic.outputs[0] = TensorSpec{"user_id_sketch", DT_INT64, {-1}};
+  Status s = CreateTensorAggregator(intrinsic).status();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("must have dtype DT_STRING"));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    GroupingHllCountTestInstantiation, GroupingHllCountTest,
+    testing::ValuesIn<bool>({false, true}),
+    [](const testing::TestParamInfo<GroupingHllCountTest::ParamType>& info) {
+      return info.param ? "SerializeDeserialize" : "None";
+    });
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,343 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/kll_quantile_sketch.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/one_dim_grouping_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+constexpr char kGoogleSqlKllQuantilesUri[] = "GoogleSQL:kll_quantiles";
+
+namespace {
+
+// Encodes the sketches of all groups as the vector data of a
+// OneDimGroupingAggregatorState: each encoded sketch is preceded by its size.
+std::string EncodeSketches(const std::vector<KllQuantileSketch>& sketches) {
+  std::string vector_data;
+  for (const KllQuantileSketch& sketch : sketches) {
+    std::string encoded = sketch.Encode();
+    uint32_t size = encoded.size();
+    vector_data.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    vector_data.append(encoded);
+  }
+  return vector_data;
+}
+
+StatusOr<std::vector<KllQuantileSketch>> DecodeSketches(
+    absl::string_view vector_data, int k) {
+  std::vector<KllQuantileSketch> sketches;
+  while (!vector_data.empty()) {
+    uint32_t size;
+    if (vector_data.size() < sizeof(size)) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantiles: The encoded sketches are truncated.";
+    }
+    std::memcpy(&size, vector_data.data(), sizeof(size));
+    vector_data.remove_prefix(sizeof(size));
+    if (vector_data.size() < size) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantiles: The encoded sketches are truncated.";
+    }
+    TFF_ASSIGN_OR_RETURN(
+        KllQuantileSketch sketch,
+        KllQuantileSketch::Decode(vector_data.substr(0, size)));
+    if (sketch.k() != k) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantiles: Expected sketches with k = " << k
+             << " but got k = " << sketch.k();
+    }
+    sketches.push_back(std::move(sketch));
+    vector_data.remove_prefix(size);
+  }
+  return sketches;
+}
+
+}  // namespace
+
+// Grouping aggregator that keeps a KllQuantileSketch of the values of each
+// group.
+//
+// The output of each group is its encoded sketch rather than a quantile, so
+// that the outputs of one GroupByAggregator can be merged into another like
+// those of the other grouping aggregators. The quantiles are extracted from
+// the reported sketches with ExtractKllQuantiles.
+template <typename InputT>
+class GroupingKllQuantiles final : public OneDimBaseGroupingAggregator {
+ public:
+  GroupingKllQuantiles(int k, std::vector<KllQuantileSketch> sketches,
+                       int num_inputs)
+      : k_(k), sketches_(std::move(sketches)), num_inputs_(num_inputs) {}
+
+  Status MergeTensors(InputTensorList tensors, int num_inputs) override {
+    TFF_RETURN_IF_ERROR(CheckValid());
+    TFF_RETURN_IF_ERROR(ValidateTensorInputs(tensors));
+    if (tensors[1]->dtype() != DT_STRING) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantiles::MergeTensors: dtype mismatch for "
+                "tensor 1. Expected DT_STRING.";
+    }
+    // Decode all sketches before changing any state, so that an invalid
+    // sketch leaves the aggregator as it was.
+    absl::Span<const int64_t> ordinals = tensors[0]->AsSpan<int64_t>();
+    absl::Span<const string_view> encoded = tensors[1]->AsSpan<string_view>();
+    std::vector<KllQuantileSketch> others;
+    others.reserve(encoded.size());
+    for (string_view encoded_sketch : encoded) {
+      TFF_ASSIGN_OR_RETURN(KllQuantileSketch other,
+                           KllQuantileSketch::Decode(encoded_sketch));
+      if (other.k() != k_) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "GroupingKllQuantiles::MergeTensors: Expected sketches "
+                  "with k = "
+               << k_ << " but got k = " << other.k();
+      }
+      others.push_back(std::move(other));
+    }
+    ResizeSketches(ordinals);
+    for (size_t i = 0; i < ordinals.size(); ++i) {
+      if (ordinals[i] < 0) continue;
+      TFF_CHECK(sketches_[ordinals[i]].Merge(others[i]).ok());
+    }
+    num_inputs_ += num_inputs;
+    return TFF_STATUS(OK);
+  }
+
+  OneDimGroupingAggregatorState ToProto() override {
+    OneDimGroupingAggregatorState aggregator_state;
+    aggregator_state.set_num_inputs(num_inputs_);
+    *aggregator_state.mutable_vector_data() = EncodeSketches(sketches_);
+    return aggregator_state;
+  }
+
+  // The sketches don't have a fixed size, so every delta holds the whole
+  // state.
+  OneDimGroupingAggregatorDelta ToDeltaProto() override {
+    OneDimGroupingAggregatorDelta delta;
+    delta.set_num_inputs(num_inputs_);
+    std::string vector_data = EncodeSketches(sketches_);
+    delta.mutable_vector_data()->set_byte_size(vector_data.size());
+    delta.mutable_vector_data()->add_chunks()->set_data(std::move(vector_data));
+    return delta;
+  }
+
+  int GetNumInputs() const override { return num_inputs_; }
+
+  size_t GetMemoryUsage() const override {
+    size_t memory_usage = sketches_.capacity() * sizeof(KllQuantileSketch);
+    for (const KllQuantileSketch& sketch : sketches_) {
+      memory_usage += sketch.memory_usage();
+    }
+    return memory_usage;
+  }
+
+  Status CheckValid() const override {
+    if (output_consumed_) {
+      return TFF_STATUS(FAILED_PRECONDITION)
+             << "GroupingKllQuantiles::CheckValid: Output has already been "
+                "consumed.";
+    }
+    return TFF_STATUS(OK);
+  }
+
+ private:
+  Status AggregateTensors(InputTensorList tensors) override {
+    TFF_RETURN_IF_ERROR(ValidateTensorInputs(tensors));
+    if (tensors[1]->dtype() != internal::TypeTraits<InputT>::kDataType) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantiles::AggregateTensors: dtype mismatch for "
+                "tensor 1";
+    }
+    absl::Span<const int64_t> ordinals = tensors[0]->AsSpan<int64_t>();
+    absl::Span<const InputT> values = tensors[1]->AsSpan<InputT>();
+    ResizeSketches(ordinals);
+    for (size_t i = 0; i < ordinals.size(); ++i) {
+      if (ordinals[i] < 0) continue;
+      sketches_[ordinals[i]].Add(static_cast<double>(values[i]));
+    }
+    num_inputs_++;
+    return TFF_STATUS(OK);
+  }
+
+  OutputTensorList TakeOutputs() && override {
+    output_consumed_ = true;
+    std::vector<std::string> encoded;
+    encoded.reserve(sketches_.size());
+    for (const KllQuantileSketch& sketch : sketches_) {
+      encoded.push_back(sketch.Encode());
+    }
+    sketches_.clear();
+    std::vector<string_view> views(encoded.begin(), encoded.end());
+    OutputTensorList outputs = std::vector<Tensor>();
+    outputs.push_back(
+        Tensor::Create(DT_STRING,
+                       TensorShape{static_cast<int64_t>(views.size())},
+                       std::make_unique<ContiguousStringData>(views))
+            .value());
+    return outputs;
+  }
+
+  void ResizeSketches(absl::Span<const int64_t> ordinals) {
+    size_t final_size = sketches_.size();
+    for (int64_t ordinal : ordinals) {
+      if (ordinal >= static_cast<int64_t>(final_size)) {
+        final_size = ordinal + 1;
+      }
+    }
+    sketches_.resize(final_size, KllQuantileSketch(k_));
+  }
+
+  bool output_consumed_ = false;
+  const int k_;
+  std::vector<KllQuantileSketch> sketches_;
+  int num_inputs_;
+};
+
+template <typename InputT>
+StatusOr<std::unique_ptr<TensorAggregator>> CreateGroupingKllQuantiles(
+    int k, const OneDimGroupingAggregatorState* aggregator_state) {
+  if (internal::TypeTraits<InputT>::type_kind !=
+      internal::TypeKind::kNumeric) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "GroupingKllQuantiles is only supported for numeric datatypes.";
+  }
+  if (aggregator_state == nullptr) {
+    return std::make_unique<GroupingKllQuantiles<InputT>>(
+        k, std::vector<KllQuantileSketch>(), 0);
+  }
+  TFF_ASSIGN_OR_RETURN(std::vector<KllQuantileSketch> sketches,
+                       DecodeSketches(aggregator_state->vector_data(), k));
+  return std::make_unique<GroupingKllQuantiles<InputT>>(
+      k, std::move(sketches), aggregator_state->num_inputs());
+}
+
+template <>
+StatusOr<std::unique_ptr<TensorAggregator>>
+CreateGroupingKllQuantiles<string_view>(
+    int k, const OneDimGroupingAggregatorState* aggregator_state) {
+  return TFF_STATUS(INVALID_ARGUMENT)
+         << "GroupingKllQuantiles isn't supported for DT_STRING datatype.";
+}
+
+// Factory class for the GroupingKllQuantiles.
+class GroupingKllQuantilesFactory final
+    : public OneDimBaseGroupingAggregatorFactory {
+ public:
+  GroupingKllQuantilesFactory() = default;
+
+  // GroupingKllQuantilesFactory isn't copyable or moveable.
+  GroupingKllQuantilesFactory(const GroupingKllQuantilesFactory&) = delete;
+  GroupingKllQuantilesFactory& operator=(const GroupingKllQuantilesFactory&) =
+      delete;
+
+ private:
+  StatusOr<std::unique_ptr<TensorAggregator>> CreateInternal(
+      const Intrinsic& intrinsic,
+      const OneDimGroupingAggregatorState* aggregator_state) const override {
+    if (kGoogleSqlKllQuantilesUri != intrinsic.uri) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantilesFactory: Expected intrinsic URI "
+             << kGoogleSqlKllQuantilesUri << " but got uri " << intrinsic.uri;
+    }
+    if (intrinsic.inputs.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantilesFactory: Exactly one input is expected "
+                "but got "
+             << intrinsic.inputs.size();
+    }
+    if (intrinsic.outputs.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantilesFactory: Exactly one output tensor is "
+                "expected but got "
+             << intrinsic.outputs.size();
+    }
+    if (!intrinsic.nested_intrinsics.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantilesFactory: Not expected to have inner "
+                "aggregations.";
+    }
+
+    // The optional parameter is the capacity k of the sketches.
+    int64_t k = KllQuantileSketch::kDefaultK;
+    if (intrinsic.parameters.size() > 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantilesFactory: At most one parameter, k, is "
+                "expected but got "
+             << intrinsic.parameters.size();
+    }
+    if (!intrinsic.parameters.empty()) {
+      const Tensor& k_tensor = intrinsic.parameters[0];
+      if (internal::GetTypeKind(k_tensor.dtype()) !=
+              internal::TypeKind::kNumeric ||
+          k_tensor.num_elements() != 1) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "GroupingKllQuantilesFactory: k must be a numerical scalar.";
+      }
+      k = k_tensor.CastToScalar<int64_t>();
+      if (k < 2 || k > INT32_MAX) {
+        return TFF_STATUS(INVALID_ARGUMENT)
+               << "GroupingKllQuantilesFactory: k must be at least 2 and fit "
+                  "in an int32.";
+      }
+    }
+
+    const TensorSpec& input_spec = intrinsic.inputs[0];
+    const TensorSpec& output_spec = intrinsic.outputs[0];
+    if (input_spec.shape() != output_spec.shape()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantilesFactory: Input and output tensors have "
+                "mismatched shapes.";
+    }
+    if (output_spec.dtype() != DT_STRING) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "GroupingKllQuantilesFactory: The output tensor must have "
+                "dtype DT_STRING to hold the encoded sketches.";
+    }
+
+    StatusOr<std::unique_ptr<TensorAggregator>> aggregator;
+    DTYPE_CASES(input_spec.dtype(), InputT,
+                aggregator = (CreateGroupingKllQuantiles<InputT>(
+                    static_cast<int>(k), aggregator_state)));
+    return aggregator;
+  }
+};
+
+REGISTER_AGGREGATOR_FACTORY(kGoogleSqlKllQuantilesUri,
+                            GroupingKllQuantilesFactory);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/hyperloglog.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+namespace {
+
+// The 64-bit finalizer of MurmurHash3, which mixes all bits of `k`.
+uint64_t Mix(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+}  // namespace
+
+uint64_t HllHash(uint64_t value) { return Mix(value); }
+
+uint64_t HllHash(absl::string_view value) {
+  constexpr uint64_t kMultiplier = 0x9e3779b97f4a7c15ULL;
+  uint64_t hash = (value.size() + 1) * kMultiplier;
+  while (value.size() >= sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, value.data(), sizeof(word));
+    hash = (hash ^ Mix(word)) * kMultiplier;
+    value.remove_prefix(sizeof(word));
+  }
+  if (!value.empty()) {
+    uint64_t word = 0;
+    std::memcpy(&word, value.data(), value.size());
+    hash = (hash ^ Mix(word)) * kMultiplier;
+  }
+  return Mix(hash);
+}
+
+double HllEstimate(absl::Span<const uint8_t> registers) {
+  const double m = registers.size();
+  double sum = 0;
+  size_t num_zeros = 0;
+  for (uint8_t rank : registers) {
+    sum += std::ldexp(1.0, -rank);
+    num_zeros += rank == 0;
+  }
+  double alpha;
+  switch (registers.size()) {
+    case 16:
+      alpha = 0.673;
+      break;
+    case 32:
+      alpha = 0.697;
+      break;
+    case 64:
+      alpha = 0.709;
+      break;
+    default:
+      alpha = 0.7213 / (1 + 1.079 / m);
+  }
+  const double estimate = alpha * m * m / sum;
+  // Small cardinalities are estimated more precisely by linear counting. The
+  // hashes have 64 bits, so large cardinalities need no correction.
+  if (estimate <= 2.5 * m && num_zeros > 0) {
+    return m * std::log(m / num_zeros);
+  }
+  return estimate;
+}
+
+Status CheckHllRegistersSize(size_t size) {
+  if (size < (size_t{1} << kMinHllPrecision) ||
+      size > (size_t{1} << kMaxHllPrecision) || !absl::has_single_bit(size)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "HyperLogLog: " << size
+           << " isn't a valid number of registers for a sketch.";
+  }
+  return TFF_STATUS(OK);
+}
+
+StatusOr<Tensor> ExtractHllCounts(const Tensor& sketches) {
+  if (sketches.dtype() != DT_STRING || !sketches.is_dense()) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "ExtractHllCounts: Expected a dense DT_STRING tensor.";
+  }
+  auto counts = std::make_unique<MutableVectorData<int64_t>>();
+  counts->reserve(sketches.num_elements());
+  for (string_view sketch : sketches.AsSpan<string_view>()) {
+    TFF_RETURN_IF_ERROR(CheckHllRegistersSize(sketch.size()));
+    absl::Span<const uint8_t> registers(
+        reinterpret_cast<const uint8_t*>(sketch.data()), sketch.size());
+    counts->push_back(std::llround(HllEstimate(registers)));
+  }
+  return Tensor::Create(DT_INT64, sketches.shape(), std::move(counts));
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_HYPERLOGLOG_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_HYPERLOGLOG_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// Functions operating on HyperLogLog sketches (Flajolet et al.,
+// "HyperLogLog: the analysis of a near-optimal cardinality estimation
+// algorithm"), which estimate the number of distinct values added to them.
+//
+// A sketch of precision p is an array of 2^p one-byte registers, and has a
+// relative standard error of about 1.04 / sqrt(2^p). The registers of a sketch
+// are a fixed-size contiguous array, so the sketches of many groups can be
+// stored back to back, and sketches are merged by taking the elementwise
+// maximum of their registers, which the compiler vectorizes.
+
+// Bounds and default value of the precision of a sketch.
+constexpr int kMinHllPrecision = 4;
+constexpr int kMaxHllPrecision = 16;
+// 4096 registers, for a relative standard error of about 1.6%.
+constexpr int kDefaultHllPrecision = 12;
+
+// Returns a hash of `value` for adding it to a sketch. Unlike absl::Hash, the
+// hash is the same in every process, so that the sketches built by different
+// processes can be merged.
+uint64_t HllHash(absl::string_view value);
+uint64_t HllHash(uint64_t value);
+
+template <typename T>
+uint64_t HllHash(T value) {
+  static_assert(std::is_arithmetic_v<T>);
+  if constexpr (std::is_floating_point_v<T>) {
+    // Hash the bits of the value as a double, with 0 and -0 hashed alike.
+    double d = value == 0 ? 0.0 : static_cast<double>(value);
+    uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return HllHash(bits);
+  } else {
+    return HllHash(static_cast<uint64_t>(value));
+  }
+}
+
+// Adds the value with the given hash to the `registers` of a sketch.
+inline void HllAdd(uint64_t hash, absl::Span<uint8_t> registers) {
+  const int precision = absl::countr_zero(registers.size());
+  const size_t index = hash >> (64 - precision);
+  // The rank is the position of the first 1 bit in the remaining bits.
+  const uint64_t remaining_bits = hash << precision;
+  const uint8_t rank = remaining_bits == 0
+                           ? 64 - precision + 1
+                           : absl::countl_zero(remaining_bits) + 1;
+  registers[index] = std::max(registers[index], rank);
+}
+
+// Merges the `other` registers into the `registers` of a sketch of the same
+// precision.
+inline void HllMerge(absl::Span<const uint8_t> other,
+                     absl::Span<uint8_t> registers) {
+  TFF_CHECK(other.size() == registers.size())
+      << "HllMerge: The sketches must have the same precision.";
+  for (size_t i = 0; i < registers.size(); ++i) {
+    registers[i] = std::max(registers[i], other[i]);
+  }
+}
+
+// Returns the estimated number of distinct values added to the sketch with
+// the given registers.
+double HllEstimate(absl::Span<const uint8_t> registers);
+
+// Returns OK if `size` is the number of registers of a sketch whose precision
+// is between kMinHllPrecision and kMaxHllPrecision.
+Status CheckHllRegistersSize(size_t size);
+
+// Estimates the number of distinct values of each of the sketches in
+// `sketches`, a DT_STRING tensor holding the registers of a sketch in each
+// element, such as the one reported for a GoogleSQL:hll_count aggregation.
+// Returns a DT_INT64 tensor of the same shape.
+StatusOr<Tensor> ExtractHllCounts(const Tensor& sketches);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_HYPERLOGLOG_H_
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/hyperloglog.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::DoubleNear;
+using ::testing::Eq;
+using ::testing::Ne;
+
+constexpr size_t kNumRegisters = size_t{1} << kDefaultHllPrecision;
+
+TEST(HyperLogLogTest, HllHash_IsStable) {
+  // The hashes must not change, since sketches built with different versions
+  // of the code may be merged.
+  EXPECT_THAT(HllHash(uint64_t{0}), Eq(0u));
+  EXPECT_THAT(HllHash(uint64_t{1}), Eq(0xb456bcfc34c2cb2cULL));
+  EXPECT_THAT(HllHash(int32_t{1}), Eq(HllHash(uint64_t{1})));
+  EXPECT_THAT(HllHash(0.0), Eq(HllHash(-0.0)));
+  EXPECT_THAT(HllHash(1.5f), Eq(HllHash(1.5)));
+  EXPECT_THAT(HllHash(absl::string_view("")), Ne(HllHash(uint64_t{0})));
+  EXPECT_THAT(HllHash(absl::string_view("abc")),
+              Ne(HllHash(absl::string_view("abd"))));
+  EXPECT_THAT(HllHash(absl::string_view("a")),
+              Ne(HllHash(absl::string_view(std::string("a\0", 2)))));
+}
+
+TEST(HyperLogLogTest, EmptySketch_EstimatesZero) {
+  std::vector<uint8_t> registers(kNumRegisters);
+  EXPECT_THAT(HllEstimate(registers), Eq(0));
+}
+
+TEST(HyperLogLogTest, DuplicateValues_CountedOnce) {
+  std::vector<uint8_t> registers(kNumRegisters);
+  for (int i = 0; i < 1000; ++i) {
+    HllAdd(HllHash(absl::string_view("value")), absl::MakeSpan(registers));
+  }
+  EXPECT_THAT(HllEstimate(registers), DoubleNear(1, 0.01));
+}
+
+TEST(HyperLogLogTest, Estimate_RelativeErrorIsSmall) {
+  for (int64_t num_values : {100, 10000, 1000000}) {
+    std::vector<uint8_t> registers(kNumRegisters);
+    for (int64_t i = 0; i < num_values; ++i) {
+      HllAdd(HllHash(i), absl::MakeSpan(registers));
+    }
+    // The relative standard error is about 1.6%.
+    EXPECT_THAT(HllEstimate(registers),
+                DoubleNear(num_values, 0.05 * num_values))
+        << num_values << " values";
+  }
+}
+
+TEST(HyperLogLogTest, Merge_MatchesSingleSketch) {
+  std::vector<uint8_t> merged(kNumRegisters);
+  std::vector<uint8_t> single(kNumRegisters);
+  for (int shard = 0; shard < 10; ++shard) {
+    std::vector<uint8_t> registers(kNumRegisters);
+    // The shards have overlapping values.
+    for (int i = shard * 1000; i < shard * 1000 + 2000; ++i) {
+      std::string value = absl::StrCat("value", i);
+      HllAdd(HllHash(absl::string_view(value)), absl::MakeSpan(registers));
+      HllAdd(HllHash(absl::string_view(value)), absl::MakeSpan(single));
+    }
+    HllMerge(registers, absl::MakeSpan(merged));
+  }
+  EXPECT_THAT(merged, Eq(single));
+  EXPECT_THAT(HllEstimate(merged), DoubleNear(11000, 0.05 * 11000));
+}
+
+TEST(HyperLogLogTest, CheckHllRegistersSize) {
+  EXPECT_THAT(CheckHllRegistersSize(16), IsOk());
+  EXPECT_THAT(CheckHllRegistersSize(65536), IsOk());
+  EXPECT_THAT(CheckHllRegistersSize(8), StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(CheckHllRegistersSize(100), StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(CheckHllRegistersSize(131072), StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(HyperLogLogTest, ExtractHllCounts_Succeeds) {
+  std::vector<uint8_t> registers1(16);
+  std::vector<uint8_t> registers2(16);
+  for (uint64_t i = 0; i < 3; ++i) {
+    HllAdd(HllHash(i), absl::MakeSpan(registers1));
+  }
+  std::string sketch1(registers1.begin(), registers1.end());
+  std::string sketch2(registers2.begin(), registers2.end());
+  Tensor sketches =
+      Tensor::Create(DT_STRING, {2},
+                     CreateTestData<string_view>({sketch1, sketch2}))
+          .value();
+  EXPECT_THAT(ExtractHllCounts(sketches),
+              IsOkAndHolds(IsTensor<int64_t>({2}, {3, 0})));
+}
+
+TEST(HyperLogLogTest, ExtractHllCounts_InvalidArguments_Fail) {
+  Tensor values = Tensor::Create(DT_INT64, {1}, CreateTestData<int64_t>({1}))
+                      .value();
+  EXPECT_THAT(ExtractHllCounts(values), StatusIs(INVALID_ARGUMENT));
+  Tensor sketches =
+      Tensor::Create(DT_STRING, {1}, CreateTestData<string_view>({"abc"}))
+          .value();
+  EXPECT_THAT(ExtractHllCounts(sketches), StatusIs(INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_INLINE_TENSOR_DATA_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_INLINE_TENSOR_DATA_H_
+
+#include <cstddef>
+#include <cstring>
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// InlineTensorData implements TensorData by storing up to kMaxByteSize bytes
+// of numeric tensor values inside the object itself. It is meant for scalars
+// and other tiny tensors, which would otherwise take a separate heap buffer on
+// top of the TensorData object, e.g. with MutableVectorData.
+//
+// The storage is aligned for any numeric value type.
+class InlineTensorData final : public TensorData {
+ public:
+  static constexpr size_t kMaxByteSize = 64;
+
+  // Returns true if values of `byte_size` bytes can be stored inline.
+  static constexpr bool Fits(size_t byte_size) {
+    return byte_size <= kMaxByteSize;
+  }
+
+  // Creates zero initialized InlineTensorData of `byte_size` bytes, which
+  // must fit, to be filled through mutable_data().
+  explicit InlineTensorData(size_t byte_size) : byte_size_(byte_size) {
+    TFF_CHECK(Fits(byte_size))
+        << "InlineTensorData can't hold " << byte_size << " bytes";
+  }
+
+  // Creates InlineTensorData holding a copy of the `byte_size` bytes at
+  // `data`, which must fit.
+  InlineTensorData(const void* data, size_t byte_size)
+      : InlineTensorData(byte_size) {
+    if (byte_size > 0) {
+      std::memcpy(storage_, data, byte_size);
+    }
+  }
+  ~InlineTensorData() override = default;
+
+  // Implementation of TensorData methods.
+  size_t byte_size() const override { return byte_size_; }
+  const void* data() const override { return storage_; }
+
+  // Provides mutable access to the values.
+  void* mutable_data() { return storage_; }
+
+ private:
+  alignas(alignof(std::max_align_t)) char storage_[kMaxByteSize] = {};
+  size_t byte_size_;
+};
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_INLINE_TENSOR_DATA_H_
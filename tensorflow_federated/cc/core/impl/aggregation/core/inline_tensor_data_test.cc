@@ -0,0 +1,104 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/inline_tensor_data.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(InlineTensorDataTest, CopiesValuesInline) {
+  const int64_t values[] = {1, 2, 3};
+  InlineTensorData data(values, sizeof(values));
+  EXPECT_EQ(data.byte_size(), sizeof(values));
+  EXPECT_NE(data.data(), values);
+  EXPECT_EQ(std::memcmp(data.data(), values, sizeof(values)), 0);
+  EXPECT_THAT(data.CheckValid<int64_t>(), IsOk());
+}
+
+TEST(InlineTensorDataTest, FillsValuesThroughMutableData) {
+  InlineTensorData data(sizeof(double));
+  *static_cast<double*>(data.mutable_data()) = 0.5;
+  EXPECT_EQ(*static_cast<const double*>(data.data()), 0.5);
+  EXPECT_THAT(data.CheckValid<double>(), IsOk());
+}
+
+TEST(InlineTensorDataTest, FitsUpToMaxByteSize) {
+  EXPECT_TRUE(InlineTensorData::Fits(0));
+  EXPECT_TRUE(InlineTensorData::Fits(InlineTensorData::kMaxByteSize));
+  EXPECT_FALSE(InlineTensorData::Fits(InlineTensorData::kMaxByteSize + 1));
+}
+
+TEST(InlineTensorDataTest, BacksScalarTensor) {
+  const float value = 2.5f;
+  auto tensor = Tensor::Create(
+      DT_FLOAT, {}, std::make_unique<InlineTensorData>(&value, sizeof(value)));
+  EXPECT_THAT(tensor, IsOk());
+  EXPECT_EQ(tensor->CastToScalar<double>(), 2.5);
+}
+
+TEST(InlineTensorDataTest, SmallTensorFromProtoRoundTrips) {
+  TensorProto tensor_proto;
+  tensor_proto.set_dtype(DT_INT32);
+  *tensor_proto.mutable_shape() = TensorShape{2}.ToProto();
+  tensor_proto.add_int_val(7);
+  tensor_proto.add_int_val(8);
+  auto tensor = Tensor::FromProto(tensor_proto);
+  EXPECT_THAT(tensor, IsOk());
+  EXPECT_NE(dynamic_cast<const InlineTensorData*>(&tensor->data()), nullptr);
+  EXPECT_THAT(tensor->AsSpan<int32_t>(), ElementsAre(7, 8));
+
+  const TensorProto round_trip_proto = tensor->ToProto();
+  auto round_tripped = Tensor::FromProto(round_trip_proto);
+  EXPECT_THAT(round_tripped, IsOk());
+  EXPECT_NE(dynamic_cast<const InlineTensorData*>(&round_tripped->data()),
+            nullptr);
+  EXPECT_THAT(round_tripped->AsSpan<int32_t>(), ElementsAre(7, 8));
+}
+
+TEST(InlineTensorDataTest, LargeTensorFromProtoIsNotInlined) {
+  std::vector<int64_t> values(InlineTensorData::kMaxByteSize);
+  TensorProto tensor_proto;
+  tensor_proto.set_dtype(DT_INT64);
+  *tensor_proto.mutable_shape() =
+      TensorShape{static_cast<int64_t>(values.size())}.ToProto();
+  tensor_proto.set_content(std::string(
+      reinterpret_cast<const char*>(values.data()),
+      values.size() * sizeof(int64_t)));
+  auto tensor = Tensor::FromProto(tensor_proto);
+  EXPECT_THAT(tensor, IsOk());
+  EXPECT_EQ(dynamic_cast<const InlineTensorData*>(&tensor->data()), nullptr);
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
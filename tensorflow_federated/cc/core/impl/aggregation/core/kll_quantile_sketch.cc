@@ -0,0 +1,273 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/kll_quantile_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+namespace {
+
+// Smallest capacity of a level, so that a level can always be compacted.
+constexpr size_t kMinLevelCapacity = 2;
+
+template <typename T>
+void AppendValue(std::string& output, T value) {
+  output.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads a value of type T from the front of `input`, and advances `input`.
+template <typename T>
+bool ReadValue(absl::string_view& input, T& value) {
+  if (input.size() < sizeof(T)) return false;
+  std::memcpy(&value, input.data(), sizeof(T));
+  input.remove_prefix(sizeof(T));
+  return true;
+}
+
+}  // namespace
+
+KllQuantileSketch::KllQuantileSketch(int k) : k_(k), levels_(1) {
+  TFF_CHECK(k >= static_cast<int>(kMinLevelCapacity))
+      << "KllQuantileSketch: k must be at least " << kMinLevelCapacity;
+}
+
+void KllQuantileSketch::Add(double value) {
+  if (count_ == 0) {
+    min_ = value;
+    max_ = value;
+  } else {
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+  }
+  ++count_;
+  levels_[0].push_back(value);
+  if (levels_[0].size() >= LevelCapacity(0)) {
+    Compress();
+  }
+}
+
+Status KllQuantileSketch::Merge(const KllQuantileSketch& other) {
+  if (other.k_ != k_) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "KllQuantileSketch::Merge: Can only merge sketches with the "
+              "same k, but got "
+           << k_ << " and " << other.k_;
+  }
+  if (other.count_ == 0) {
+    return TFF_STATUS(OK);
+  }
+  if (count_ == 0) {
+    min_ = other.min_;
+    max_ = other.max_;
+  } else {
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+  count_ += other.count_;
+  if (levels_.size() < other.levels_.size()) {
+    levels_.resize(other.levels_.size());
+  }
+  for (size_t h = 0; h < other.levels_.size(); ++h) {
+    levels_[h].insert(levels_[h].end(), other.levels_[h].begin(),
+                      other.levels_[h].end());
+  }
+  Compress();
+  return TFF_STATUS(OK);
+}
+
+double KllQuantileSketch::Quantile(double rank) const {
+  TFF_CHECK(count_ > 0) << "KllQuantileSketch::Quantile: The sketch is empty.";
+  TFF_CHECK(rank >= 0 && rank <= 1)
+      << "KllQuantileSketch::Quantile: The rank must be between 0 and 1.";
+  if (rank == 0) return min_;
+  if (rank == 1) return max_;
+  std::vector<std::pair<double, int64_t>> weighted_values;
+  weighted_values.reserve(num_retained());
+  for (size_t h = 0; h < levels_.size(); ++h) {
+    for (double value : levels_[h]) {
+      weighted_values.emplace_back(value, int64_t{1} << h);
+    }
+  }
+  std::sort(weighted_values.begin(), weighted_values.end());
+  const double target = rank * count_;
+  int64_t cumulative_weight = 0;
+  for (const auto& [value, weight] : weighted_values) {
+    cumulative_weight += weight;
+    if (cumulative_weight >= target) {
+      return value;
+    }
+  }
+  return max_;
+}
+
+size_t KllQuantileSketch::num_retained() const {
+  size_t num_retained = 0;
+  for (const std::vector<double>& level : levels_) {
+    num_retained += level.size();
+  }
+  return num_retained;
+}
+
+size_t KllQuantileSketch::memory_usage() const {
+  size_t memory_usage = levels_.capacity() * sizeof(std::vector<double>);
+  for (const std::vector<double>& level : levels_) {
+    memory_usage += level.capacity() * sizeof(double);
+  }
+  return memory_usage;
+}
+
+size_t KllQuantileSketch::LevelCapacity(size_t level) const {
+  const size_t depth = levels_.size() - 1 - level;
+  const double capacity = std::ceil(k_ * std::pow(2.0 / 3, depth));
+  return std::max(kMinLevelCapacity, static_cast<size_t>(capacity));
+}
+
+void KllQuantileSketch::Compress() {
+  while (true) {
+    size_t total_capacity = 0;
+    for (size_t h = 0; h < levels_.size(); ++h) {
+      total_capacity += LevelCapacity(h);
+    }
+    if (num_retained() < total_capacity) {
+      return;
+    }
+    // Compact the lowest level that is at its capacity. There is one, since
+    // the levels together are at their total capacity.
+    size_t h = 0;
+    while (levels_[h].size() < LevelCapacity(h)) ++h;
+    if (h + 1 == levels_.size()) {
+      levels_.emplace_back();
+    }
+    std::vector<double>& level = levels_[h];
+    std::vector<double>& next_level = levels_[h + 1];
+    std::sort(level.begin(), level.end());
+    // With an odd number of values, the smallest one stays at this level so
+    // that the values are promoted in pairs.
+    const size_t num_kept = level.size() % 2;
+    for (size_t i = num_kept + (num_compactions_ & 1); i < level.size();
+         i += 2) {
+      next_level.push_back(level[i]);
+    }
+    level.resize(num_kept);
+    ++num_compactions_;
+  }
+}
+
+std::string KllQuantileSketch::Encode() const {
+  std::string encoded;
+  encoded.reserve(sizeof(int32_t) + sizeof(int64_t) + 2 * sizeof(double) +
+                  sizeof(uint64_t) + sizeof(uint32_t) * (levels_.size() + 1) +
+                  sizeof(double) * num_retained());
+  AppendValue<int32_t>(encoded, k_);
+  AppendValue<int64_t>(encoded, count_);
+  AppendValue<double>(encoded, min_);
+  AppendValue<double>(encoded, max_);
+  AppendValue<uint64_t>(encoded, num_compactions_);
+  AppendValue<uint32_t>(encoded, levels_.size());
+  for (const std::vector<double>& level : levels_) {
+    AppendValue<uint32_t>(encoded, level.size());
+  }
+  for (const std::vector<double>& level : levels_) {
+    encoded.append(reinterpret_cast<const char*>(level.data()),
+                   level.size() * sizeof(double));
+  }
+  return encoded;
+}
+
+StatusOr<KllQuantileSketch> KllQuantileSketch::Decode(
+    absl::string_view encoded) {
+  int32_t k;
+  int64_t count;
+  double min, max;
+  uint64_t num_compactions;
+  uint32_t num_levels;
+  if (!ReadValue(encoded, k) || !ReadValue(encoded, count) ||
+      !ReadValue(encoded, min) || !ReadValue(encoded, max) ||
+      !ReadValue(encoded, num_compactions) || !ReadValue(encoded, num_levels) ||
+      k < static_cast<int32_t>(kMinLevelCapacity) || num_levels == 0 ||
+      num_levels > 64 || encoded.size() < num_levels * sizeof(uint32_t)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "KllQuantileSketch::Decode: Invalid sketch header.";
+  }
+  KllQuantileSketch sketch(k);
+  sketch.count_ = count;
+  sketch.min_ = min;
+  sketch.max_ = max;
+  sketch.num_compactions_ = num_compactions;
+  sketch.levels_.resize(num_levels);
+  std::vector<uint32_t> level_sizes(num_levels);
+  for (uint32_t& level_size : level_sizes) {
+    ReadValue(encoded, level_size);
+  }
+  // The weights of the retained values must add up to the count.
+  uint64_t total_weight = 0;
+  for (size_t h = 0; h < num_levels; ++h) {
+    if (encoded.size() / sizeof(double) < level_sizes[h]) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "KllQuantileSketch::Decode: The sketch is truncated.";
+    }
+    std::vector<double>& level = sketch.levels_[h];
+    level.resize(level_sizes[h]);
+    std::memcpy(level.data(), encoded.data(), level.size() * sizeof(double));
+    encoded.remove_prefix(level.size() * sizeof(double));
+    total_weight += uint64_t{level.size()} << h;
+  }
+  if (!encoded.empty() || count < 0 ||
+      total_weight != static_cast<uint64_t>(count)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "KllQuantileSketch::Decode: The sketch is inconsistent.";
+  }
+  return sketch;
+}
+
+StatusOr<Tensor> ExtractKllQuantiles(const Tensor& sketches, double rank) {
+  if (sketches.dtype() != DT_STRING || !sketches.is_dense()) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "ExtractKllQuantiles: Expected a dense DT_STRING tensor.";
+  }
+  if (!(rank >= 0 && rank <= 1)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "ExtractKllQuantiles: The rank must be between 0 and 1.";
+  }
+  auto quantiles = std::make_unique<MutableVectorData<double>>();
+  quantiles->reserve(sketches.num_elements());
+  for (string_view encoded : sketches.AsSpan<string_view>()) {
+    TFF_ASSIGN_OR_RETURN(KllQuantileSketch sketch,
+                         KllQuantileSketch::Decode(encoded));
+    quantiles->push_back(sketch.count() > 0 ? sketch.Quantile(rank) : 0);
+  }
+  return Tensor::Create(DT_DOUBLE, sketches.shape(), std::move(quantiles));
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
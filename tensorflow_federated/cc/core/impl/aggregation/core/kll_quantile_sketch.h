@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_KLL_QUANTILE_SKETCH_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_KLL_QUANTILE_SKETCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// A mergeable quantile sketch following Karnin, Lang and Liberty, "Optimal
+// Quantile Approximation in Streams".
+//
+// The sketch keeps the values in levels, where each value at level h stands
+// for 2^h of the added values. When the sketch exceeds its capacity, the
+// lowest full level is sorted and every other value of it is promoted to the
+// next level. The capacity of the top level is k and the capacity of each lower
+// level is 2/3 of the one above it, so the sketch retains O(k) values however
+// many values are added, and the rank error of a quantile is O(1/k) with high
+// probability.
+//
+// The values to promote are alternately the even and the odd ones, rather than
+// chosen at random, so that the sketch is deterministic.
+//
+// This class is not thread safe.
+class KllQuantileSketch {
+ public:
+  // Default capacity of the top level, which gives a rank error of about 1%.
+  static constexpr int kDefaultK = 200;
+
+  explicit KllQuantileSketch(int k = kDefaultK);
+
+  // Adds a value to the sketch.
+  void Add(double value);
+
+  // Adds the values summarized by `other` to this sketch. Both sketches must
+  // have the same k.
+  Status Merge(const KllQuantileSketch& other);
+
+  // Returns the approximate value of the given rank, which must be between 0
+  // and 1, e.g. 0.5 for the median. The sketch must not be empty.
+  double Quantile(double rank) const;
+
+  // Number of values added to the sketch.
+  int64_t count() const { return count_; }
+
+  int k() const { return k_; }
+
+  // Number of values retained by the sketch.
+  size_t num_retained() const;
+
+  // Number of bytes allocated for the values retained by the sketch.
+  size_t memory_usage() const;
+
+  // Encodes the sketch into a compact string.
+  std::string Encode() const;
+
+  // Creates a sketch from a string returned by Encode.
+  static StatusOr<KllQuantileSketch> Decode(absl::string_view encoded);
+
+ private:
+  size_t LevelCapacity(size_t level) const;
+  // Compacts levels until the retained values fit the capacity of the sketch.
+  void Compress();
+
+  int k_;
+  int64_t count_ = 0;
+  double min_ = 0;
+  double max_ = 0;
+  // Number of compactions so far, whose parity selects the values to promote.
+  uint64_t num_compactions_ = 0;
+  std::vector<std::vector<double>> levels_;
+};
+
+// Extracts the approximate value of the given rank from each of the encoded
+// sketches in `sketches`, a DT_STRING tensor such as the one reported for a
+// GoogleSQL:kll_quantiles aggregation. Returns a DT_DOUBLE tensor of the same
+// shape, holding 0 for the empty sketches.
+StatusOr<Tensor> ExtractKllQuantiles(const Tensor& sketches, double rank);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_KLL_QUANTILE_SKETCH_H_
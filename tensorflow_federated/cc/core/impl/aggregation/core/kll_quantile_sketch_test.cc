@@ -0,0 +1,179 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/kll_quantile_sketch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::DoubleNear;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::HasSubstr;
+using ::testing::Le;
+
+// Returns the values 0, ..., n - 1 in a deterministic scrambled order.
+std::vector<double> ScrambledValues(int64_t n) {
+  std::vector<double> values;
+  values.reserve(n);
+  // 7919 is a prime that doesn't divide n, so i * 7919 % n is a permutation.
+  for (int64_t i = 0; i < n; ++i) {
+    values.push_back(static_cast<double>((i * 7919) % n));
+  }
+  return values;
+}
+
+TEST(KllQuantileSketchTest, FewValues_QuantilesAreExact) {
+  KllQuantileSketch sketch;
+  for (double value : {5.0, 1.0, 4.0, 2.0, 3.0}) {
+    sketch.Add(value);
+  }
+  EXPECT_THAT(sketch.count(), Eq(5));
+  EXPECT_THAT(sketch.num_retained(), Eq(5));
+  EXPECT_THAT(sketch.Quantile(0), Eq(1.0));
+  EXPECT_THAT(sketch.Quantile(0.5), Eq(3.0));
+  EXPECT_THAT(sketch.Quantile(0.8), Eq(4.0));
+  EXPECT_THAT(sketch.Quantile(1), Eq(5.0));
+}
+
+TEST(KllQuantileSketchTest, ManyValues_MemoryIsBoundedAndRankErrorIsSmall) {
+  constexpr int64_t kNumValues = 100000;
+  KllQuantileSketch sketch;
+  for (double value : ScrambledValues(kNumValues)) {
+    sketch.Add(value);
+  }
+  EXPECT_THAT(sketch.count(), Eq(kNumValues));
+  EXPECT_THAT(sketch.num_retained(), Le(3 * KllQuantileSketch::kDefaultK));
+  for (double rank : {0.01, 0.25, 0.5, 0.9, 0.99}) {
+    EXPECT_THAT(sketch.Quantile(rank),
+                DoubleNear(rank * kNumValues, 0.02 * kNumValues))
+        << "rank " << rank;
+  }
+}
+
+TEST(KllQuantileSketchTest, MemoryUsage_CoversRetainedValues) {
+  KllQuantileSketch sketch;
+  for (double value : ScrambledValues(10000)) {
+    sketch.Add(value);
+  }
+  EXPECT_THAT(sketch.memory_usage(),
+              Ge(sketch.num_retained() * sizeof(double)));
+}
+
+TEST(KllQuantileSketchTest, Merge_MatchesSingleSketch) {
+  constexpr int64_t kNumValues = 50000;
+  std::vector<double> values = ScrambledValues(kNumValues);
+  KllQuantileSketch merged;
+  for (int shard = 0; shard < 10; ++shard) {
+    KllQuantileSketch sketch;
+    for (int64_t i = shard; i < kNumValues; i += 10) {
+      sketch.Add(values[i]);
+    }
+    EXPECT_THAT(merged.Merge(sketch), IsOk());
+  }
+  EXPECT_THAT(merged.count(), Eq(kNumValues));
+  EXPECT_THAT(merged.num_retained(), Le(3 * KllQuantileSketch::kDefaultK));
+  EXPECT_THAT(merged.Quantile(0), Eq(0.0));
+  EXPECT_THAT(merged.Quantile(1), Eq(kNumValues - 1.0));
+  for (double rank : {0.1, 0.5, 0.95}) {
+    EXPECT_THAT(merged.Quantile(rank),
+                DoubleNear(rank * kNumValues, 0.02 * kNumValues))
+        << "rank " << rank;
+  }
+}
+
+TEST(KllQuantileSketchTest, Merge_DifferentK_Fails) {
+  KllQuantileSketch sketch(100);
+  KllQuantileSketch other(200);
+  Status s = sketch.Merge(other);
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("same k"));
+}
+
+TEST(KllQuantileSketchTest, EncodeDecode_RoundTrips) {
+  KllQuantileSketch sketch(50);
+  for (double value : ScrambledValues(1000)) {
+    sketch.Add(value);
+  }
+  std::string encoded = sketch.Encode();
+  KllQuantileSketch decoded = KllQuantileSketch::Decode(encoded).value();
+  EXPECT_THAT(decoded.k(), Eq(50));
+  EXPECT_THAT(decoded.count(), Eq(sketch.count()));
+  EXPECT_THAT(decoded.num_retained(), Eq(sketch.num_retained()));
+  EXPECT_THAT(decoded.Encode(), Eq(encoded));
+  for (double rank : {0.0, 0.3, 0.7, 1.0}) {
+    EXPECT_THAT(decoded.Quantile(rank), Eq(sketch.Quantile(rank)));
+  }
+}
+
+TEST(KllQuantileSketchTest, Decode_InvalidSketch_Fails) {
+  KllQuantileSketch sketch;
+  sketch.Add(1);
+  std::string encoded = sketch.Encode();
+  EXPECT_THAT(KllQuantileSketch::Decode("invalid"), StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(KllQuantileSketch::Decode(encoded.substr(0, encoded.size() - 1)),
+              StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(KllQuantileSketch::Decode(encoded + "x"),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(KllQuantileSketchTest, ExtractKllQuantiles_Succeeds) {
+  KllQuantileSketch sketch1;
+  KllQuantileSketch sketch2;
+  for (double value : {1.0, 2.0, 3.0}) sketch1.Add(value);
+  for (double value : {10.0, 20.0}) sketch2.Add(value);
+  KllQuantileSketch empty_sketch;
+  std::string encoded1 = sketch1.Encode();
+  std::string encoded2 = sketch2.Encode();
+  std::string encoded3 = empty_sketch.Encode();
+  Tensor sketches = Tensor::Create(DT_STRING, {3},
+                                   CreateTestData<string_view>(
+                                       {encoded1, encoded2, encoded3}))
+                        .value();
+  EXPECT_THAT(ExtractKllQuantiles(sketches, 0.5),
+              IsOkAndHolds(IsTensor<double>({3}, {2, 10, 0})));
+  EXPECT_THAT(ExtractKllQuantiles(sketches, 1),
+              IsOkAndHolds(IsTensor<double>({3}, {3, 20, 0})));
+}
+
+TEST(KllQuantileSketchTest, ExtractKllQuantiles_InvalidArguments_Fail) {
+  Tensor values = Tensor::Create(DT_DOUBLE, {1}, CreateTestData({1.0})).value();
+  EXPECT_THAT(ExtractKllQuantiles(values, 0.5), StatusIs(INVALID_ARGUMENT));
+  std::string encoded = KllQuantileSketch().Encode();
+  Tensor sketches =
+      Tensor::Create(DT_STRING, {1}, CreateTestData<string_view>({encoded}))
+          .value();
+  EXPECT_THAT(ExtractKllQuantiles(sketches, 1.5), StatusIs(INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -20,6 +20,9 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
 #include <vector>
 
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
@@ -27,6 +30,22 @@
 namespace tensorflow_federated {
 namespace aggregation {
 
+namespace internal {
+
+// Takes back the storage of a MutableVectorData drawn from a buffer pool when
+// the data is destroyed. Implemented by BufferPool.
+class VectorStorageSink {
+ public:
+  virtual ~VectorStorageSink() = default;
+
+  // Receives `storage`, an empty MutableVectorData of values of `type` holding
+  // `capacity_bytes` of allocated storage.
+  virtual void ReturnStorage(std::type_index type, size_t capacity_bytes,
+                             std::unique_ptr<TensorData> storage) = 0;
+};
+
+}  // namespace internal
+
 // MutableVectorData implements TensorData by wrapping std::vector and using it
 // as a backing storage. MutableVectorData can be mutated using std::vector
 // methods.
@@ -36,7 +55,16 @@ class MutableVectorData : public std::vector<T>, public TensorData {
   // Derive constructors from the base vector class.
   using std::vector<T>::vector;
 
-  ~MutableVectorData() override = default;
+  // Returns the storage to the pool it was drawn from, if any.
+  ~MutableVectorData() override {
+    if (storage_sink_ == nullptr || this->capacity() == 0) return;
+    auto storage = std::make_unique<MutableVectorData<T>>();
+    storage->swap(*this);
+    storage->clear();
+    const size_t capacity_bytes = storage->capacity() * sizeof(T);
+    storage_sink_->ReturnStorage(typeid(T), capacity_bytes,
+                                 std::move(storage));
+  }
 
   // Implementation of the base class methods.
   size_t byte_size() const override { return this->size() * sizeof(T); }
@@ -56,6 +84,15 @@ class MutableVectorData : public std::vector<T>, public TensorData {
     return std::make_unique<MutableVectorData<T>>(
         data, data + content.size() / sizeof(T));
   }
+
+  // Makes the storage of this data return to `sink` when the data is
+  // destroyed rather than being freed.
+  void set_storage_sink(std::shared_ptr<internal::VectorStorageSink> sink) {
+    storage_sink_ = std::move(sink);
+  }
+
+ private:
+  std::shared_ptr<internal::VectorStorageSink> storage_sink_;
 };
 
 }  // namespace aggregation
@@ -21,6 +21,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -35,6 +36,7 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_factory.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_data_delta.h"
 
 namespace tensorflow_federated {
 namespace aggregation {
@@ -83,6 +85,13 @@ class OneDimBaseGroupingAggregator : public TensorAggregator {
   // proto.
   virtual OneDimGroupingAggregatorState ToProto() = 0;
 
+  // Returns the changes to the intermediate state of the
+  // OneDimBaseGroupingAggregator since the previous call, without consuming
+  // it. The first call returns the whole state. The state at the time of any
+  // call can be recovered by applying the preceding deltas in order with
+  // ApplyOneDimGroupingAggregatorDelta.
+  virtual OneDimGroupingAggregatorDelta ToDeltaProto() = 0;
+
  protected:
   // Checks that the input tensors param is valid.
   Status ValidateTensorInputs(const InputTensorList& tensors);
@@ -159,12 +168,17 @@ class OneDimGroupingAggregator : public OneDimBaseGroupingAggregator {
     AggVector<int64_t> ordinals_vector = tensors[0]->AsAggVector<int64_t>();
 
     ResizeDataVector(ordinals_vector);
+    MarkChanged(ordinals_vector);
     MergeVectorByOrdinals(ordinals_vector, value_vector);
     return TFF_STATUS(OK);
   }
 
   int GetNumInputs() const override { return num_inputs_; }
 
+  size_t GetMemoryUsage() const override {
+    return data_vector_ == nullptr ? 0 : data_vector_->byte_size();
+  }
+
   Status CheckValid() const override {
     if (data_vector_ == nullptr) {
       return TFF_STATUS(FAILED_PRECONDITION)
@@ -181,6 +195,19 @@ class OneDimGroupingAggregator : public OneDimBaseGroupingAggregator {
     return aggregator_state;
   }
 
+  // Changes are tracked from the first call on, at the granularity of
+  // VectorDataChangeTracker::kDefaultChunkSize groups. Only the groups whose
+  // ordinals appear in the accumulated or merged inputs are changed.
+  OneDimGroupingAggregatorDelta ToDeltaProto() override {
+    if (!change_tracker_.has_value()) {
+      change_tracker_.emplace();
+    }
+    OneDimGroupingAggregatorDelta delta;
+    delta.set_num_inputs(num_inputs_);
+    *delta.mutable_vector_data() = change_tracker_->TakeDelta(*data_vector_);
+    return delta;
+  }
+
  protected:
   // Provides mutable access to the aggregator data as a vector<T>
   inline std::vector<OutputT>& data() { return *data_vector_; }
@@ -205,6 +232,7 @@ class OneDimGroupingAggregator : public OneDimBaseGroupingAggregator {
     AggVector<int64_t> ordinals_vector = tensors[0]->AsAggVector<int64_t>();
 
     ResizeDataVector(ordinals_vector);
+    MarkChanged(ordinals_vector);
     AggregateVectorByOrdinals(ordinals_vector, value_vector);
     return TFF_STATUS(OK);
   }
@@ -226,6 +254,8 @@ class OneDimGroupingAggregator : public OneDimBaseGroupingAggregator {
 
   // Delegates AggVector accumulation by ordinal to a derived class.
   //
+  // Both vectors are dense and have the same size, so the value at position i
+  // can be accessed through dense_values() alongside the ordinal at position i.
   // The size of the vector returned by data() must be greater than the largest
   // ordinal in this vector.
   //
@@ -287,17 +317,30 @@ class OneDimGroupingAggregator : public OneDimBaseGroupingAggregator {
 
   void ResizeDataVector(const AggVector<int64_t>& ordinals_vector) {
     size_t final_size = data_vector_->size();
-    for (auto o : ordinals_vector) {
-      if (o.value >= static_cast<int64_t>(final_size)) {
-        final_size = o.value + 1;
+    for (int64_t ordinal : ordinals_vector.dense_values()) {
+      if (ordinal >= static_cast<int64_t>(final_size)) {
+        final_size = ordinal + 1;
       }
     }
     // Resize once outside the loop to avoid quadratic behavior.
     data_vector_->resize(final_size, GetDefaultValue());
   }
 
+  void MarkChanged(const AggVector<int64_t>& ordinals_vector) {
+    if (!change_tracker_.has_value()) {
+      return;
+    }
+    for (int64_t ordinal : ordinals_vector.dense_values()) {
+      if (ordinal >= 0) {
+        change_tracker_->MarkChanged(ordinal);
+      }
+    }
+  }
+
   std::unique_ptr<MutableVectorData<OutputT>> data_vector_;
   int num_inputs_;
+  // Tracks the changes since the last ToDeltaProto call, if any.
+  std::optional<VectorDataChangeTracker> change_tracker_;
 };
 
 }  // namespace aggregation
@@ -28,6 +28,7 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_data_delta.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
@@ -770,6 +771,58 @@ TEST(OneDimGroupingAggregatorTest, FailsAfterBeingConsumed) {
               StatusIs(FAILED_PRECONDITION));
 }
 
+TEST(OneDimGroupingAggregatorTest, ToDeltaProto_OnlyChangedGroups) {
+  const int64_t num_groups = 3 * VectorDataChangeTracker::kDefaultChunkSize;
+  SumGroupingAggregator<int32_t> aggregator;
+  Tensor all_ordinals =
+      Tensor::Create(DT_INT64, {1},
+                     CreateTestData<int64_t>({num_groups - 1}))
+          .value();
+  Tensor t1 = Tensor::Create(DT_INT32, {1}, CreateTestData({5})).value();
+  EXPECT_THAT(aggregator.Accumulate({&all_ordinals, &t1}), IsOk());
+  OneDimGroupingAggregatorState state;
+  OneDimGroupingAggregatorDelta delta1 = aggregator.ToDeltaProto();
+  EXPECT_THAT(ApplyOneDimGroupingAggregatorDelta(delta1, state), IsOk());
+
+  // Only update groups in the first tracked chunk.
+  Tensor ordinals =
+      Tensor::Create(DT_INT64, {2}, CreateTestData<int64_t>({0, 1})).value();
+  Tensor t2 = Tensor::Create(DT_INT32, {2}, CreateTestData({7, 8})).value();
+  EXPECT_THAT(aggregator.Accumulate({&ordinals, &t2}), IsOk());
+  OneDimGroupingAggregatorDelta delta2 = aggregator.ToDeltaProto();
+  ASSERT_THAT(delta2.vector_data().chunks_size(), Eq(1));
+  EXPECT_THAT(delta2.vector_data().chunks(0).offset(), Eq(0));
+  EXPECT_THAT(delta2.vector_data().chunks(0).data().size(),
+              Eq(VectorDataChangeTracker::kDefaultChunkSize * sizeof(int32_t)));
+  EXPECT_THAT(ApplyOneDimGroupingAggregatorDelta(delta2, state), IsOk());
+
+  OneDimGroupingAggregatorState expected_state = aggregator.ToProto();
+  EXPECT_THAT(state.num_inputs(), Eq(2));
+  EXPECT_EQ(state.vector_data(), expected_state.vector_data());
+}
+
+TEST(OneDimGroupingAggregatorTest, ToDeltaProto_IncludesNewGroups) {
+  SumGroupingAggregator<int32_t> aggregator;
+  OneDimGroupingAggregatorState state;
+  EXPECT_THAT(
+      ApplyOneDimGroupingAggregatorDelta(aggregator.ToDeltaProto(), state),
+      IsOk());
+  Tensor ordinals =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({0, 2, 0}))
+          .value();
+  Tensor t = Tensor::Create(DT_INT32, {3}, CreateTestData({1, 2, 3})).value();
+  EXPECT_THAT(aggregator.Accumulate({&ordinals, &t}), IsOk());
+  EXPECT_THAT(
+      ApplyOneDimGroupingAggregatorDelta(aggregator.ToDeltaProto(), state),
+      IsOk());
+
+  auto restored = SumGroupingAggregator<int32_t>::FromProto(state);
+  EXPECT_THAT(restored.GetNumInputs(), Eq(1));
+  auto result = std::move(restored).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor({3}, {4, 0, 2}));
+}
+
 TEST(OneDimGroupingAggregatorTest, Serialize_Unimplmeneted) {
   SumGroupingAggregator<int32_t> aggregator;
   Status s = std::move(aggregator).Serialize().status();
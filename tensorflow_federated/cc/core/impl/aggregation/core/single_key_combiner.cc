@@ -0,0 +1,180 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/single_key_combiner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/binary_encoding.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dictionary_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+OutputTensorList SingleKeyCombiner<string_view>::GetOutputKeys() const {
+  OutputTensorList output_keys;
+  // The output tensor owns copies of the strings so that it remains valid after
+  // this class is destroyed.
+  std::vector<string_view> strings_for_output(keys_.begin(), keys_.end());
+  StatusOr<Tensor> t = Tensor::Create(
+      DT_STRING, TensorShape({static_cast<int64_t>(keys_.size())}),
+      std::make_unique<ContiguousStringData>(strings_for_output));
+  TFF_CHECK(t.status().ok()) << t.status().message();
+  output_keys.push_back(std::move(t.value()));
+  return output_keys;
+}
+
+size_t SingleKeyCombiner<string_view>::GetMemoryUsage() const {
+  size_t memory_usage =
+      ordinals_.capacity() *
+      (sizeof(std::pair<string_view, int64_t>) + sizeof(uint8_t));
+  for (const std::string& key : keys_) {
+    memory_usage += sizeof(std::string) + key.capacity();
+  }
+  return memory_usage;
+}
+
+std::unique_ptr<MutableVectorData<int64_t>>
+SingleKeyCombiner<string_view>::AccumulateKeys(const InputTensorList& tensors,
+                                               size_t num_elements) {
+  auto ordinals = std::make_unique<MutableVectorData<int64_t>>();
+  ordinals->reserve(num_elements);
+  const auto* dictionary_data =
+      dynamic_cast<const DictionaryStringData*>(&tensors[0]->data());
+  if (dictionary_data != nullptr) {
+    // Each dictionary string is looked up once, after which the ordinal of
+    // each value only depends on its code.
+    absl::Span<const string_view> dictionary = dictionary_data->dictionary();
+    std::vector<int64_t> dictionary_ordinals;
+    dictionary_ordinals.reserve(dictionary.size());
+    for (string_view key : dictionary) {
+      dictionary_ordinals.push_back(FindOrInsert(key));
+    }
+    absl::Span<const int32_t> codes = dictionary_data->codes();
+    for (size_t i = 0; i < num_elements; ++i) {
+      ordinals->push_back(dictionary_ordinals[codes[i]]);
+    }
+    return ordinals;
+  }
+  const string_view* keys =
+      static_cast<const string_view*>(tensors[0]->data().data());
+  for (size_t i = 0; i < num_elements; ++i) {
+    ordinals->push_back(FindOrInsert(keys[i]));
+  }
+  return ordinals;
+}
+
+int64_t SingleKeyCombiner<string_view>::FindOrInsert(string_view key) {
+  auto it = ordinals_.find(key);
+  if (it == ordinals_.end()) {
+    // This is the first time this string has been encountered, so copy it
+    // into storage owned by this class and key the map by a view of the copy.
+    const std::string& copy = keys_.emplace_back(key);
+    it = ordinals_.emplace(copy, static_cast<int64_t>(keys_.size() - 1)).first;
+  }
+  return it->second;
+}
+
+void SingleKeyCombiner<string_view>::AppendSnapshot(
+    std::string& output) const {
+  AppendSnapshotHeader(SnapshotKind::kSingleString, output);
+  internal::AppendValue<uint64_t>(output, keys_.size());
+  for (const std::string& key : keys_) {
+    internal::AppendValue<uint64_t>(output, key.size());
+  }
+  for (const std::string& key : keys_) {
+    output.append(key);
+  }
+}
+
+Status SingleKeyCombiner<string_view>::RestoreSnapshot(
+    absl::string_view snapshot) {
+  TFF_RETURN_IF_ERROR(
+      ReadSnapshotHeader(SnapshotKind::kSingleString, snapshot));
+  uint64_t num_keys;
+  if (!internal::ReadValue(snapshot, num_keys) ||
+      num_keys > snapshot.size() / sizeof(uint64_t)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "SingleKeyCombiner::RestoreSnapshot: malformed keys.";
+  }
+  std::vector<uint64_t> sizes(num_keys);
+  internal::ReadArray(snapshot, sizes.data(), sizes.size());
+  ordinals_.reserve(num_keys);
+  for (uint64_t size : sizes) {
+    if (size > snapshot.size()) {
+      ordinals_.clear();
+      keys_.clear();
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "SingleKeyCombiner::RestoreSnapshot: malformed keys.";
+    }
+    const std::string& key = keys_.emplace_back(snapshot.substr(0, size));
+    snapshot.remove_prefix(size);
+    if (!ordinals_.emplace(key, static_cast<int64_t>(keys_.size() - 1))
+             .second) {
+      ordinals_.clear();
+      keys_.clear();
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "SingleKeyCombiner::RestoreSnapshot: duplicate key.";
+    }
+  }
+  if (!snapshot.empty()) {
+    ordinals_.clear();
+    keys_.clear();
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "SingleKeyCombiner::RestoreSnapshot: malformed keys.";
+  }
+  return TFF_STATUS(OK);
+}
+
+std::unique_ptr<CompositeKeyCombiner> CreateKeyCombinerForTypes(
+    std::vector<DataType> dtypes) {
+  if (dtypes.size() == 1) {
+    switch (dtypes[0]) {
+      case DT_INT32:
+        return std::make_unique<SingleKeyCombiner<int32_t>>();
+      case DT_INT64:
+        return std::make_unique<SingleKeyCombiner<int64_t>>();
+      case DT_UINT64:
+        return std::make_unique<SingleKeyCombiner<uint64_t>>();
+      case DT_STRING:
+        return std::make_unique<SingleKeyCombiner<string_view>>();
+      default:
+        // Floating point keys are compared by their bit representation, which
+        // the general CompositeKeyCombiner already does.
+        break;
+    }
+  }
+  return std::make_unique<CompositeKeyCombiner>(std::move(dtypes));
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_SINGLE_KEY_COMBINER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_SINGLE_KEY_COMBINER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/binary_encoding.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// CompositeKeyCombiner specialized for keys made of a single integer tensor.
+//
+// Rather than copying each element into a generic composite key, the elements
+// are hashed and stored directly as values of type T. The ordinals and output
+// keys are the same as those of a CompositeKeyCombiner with a single dtype.
+//
+// This class is not thread safe.
+template <typename T>
+class SingleKeyCombiner final : public CompositeKeyCombiner {
+  static_assert(std::is_integral_v<T>,
+                "SingleKeyCombiner only supports integral and string keys.");
+
+ public:
+  SingleKeyCombiner()
+      : CompositeKeyCombiner({internal::TypeTraits<T>::kDataType}) {}
+
+  OutputTensorList GetOutputKeys() const override;
+  size_t num_keys() const override { return keys_.size(); }
+
+  size_t GetMemoryUsage() const override {
+    // A flat_hash_map slot holds a key and its ordinal, plus a control byte.
+    return ordinals_.capacity() *
+               (sizeof(std::pair<T, int64_t>) + sizeof(uint8_t)) +
+           keys_.capacity() * sizeof(T);
+  }
+
+  // The snapshot holds the keys in ordinal order, from which the map of
+  // ordinals is rebuilt on restore.
+  void AppendSnapshot(std::string& output) const override;
+  Status RestoreSnapshot(absl::string_view snapshot) override;
+
+ protected:
+  std::unique_ptr<MutableVectorData<int64_t>> AccumulateKeys(
+      const InputTensorList& tensors, size_t num_elements) override;
+
+ private:
+  // Mapping of the keys seen so far to their ordinal.
+  absl::flat_hash_map<T, int64_t> ordinals_;
+  // The keys seen so far, ordered by their ordinal.
+  std::vector<T> keys_;
+};
+
+// SingleKeyCombiner specialization for keys made of a single string tensor.
+//
+// Each distinct string is stored exactly once, in ordinal order, in the
+// storage from which the output keys are created. This avoids the intern pool
+// and pointer indirection used for strings by CompositeKeyCombiner. Keys held
+// in DictionaryStringData are looked up once per dictionary string rather than
+// once per element.
+template <>
+class SingleKeyCombiner<string_view> final : public CompositeKeyCombiner {
+ public:
+  SingleKeyCombiner() : CompositeKeyCombiner({DT_STRING}) {}
+
+  OutputTensorList GetOutputKeys() const override;
+  size_t num_keys() const override { return keys_.size(); }
+  size_t GetMemoryUsage() const override;
+  void AppendSnapshot(std::string& output) const override;
+  Status RestoreSnapshot(absl::string_view snapshot) override;
+
+ protected:
+  std::unique_ptr<MutableVectorData<int64_t>> AccumulateKeys(
+      const InputTensorList& tensors, size_t num_elements) override;
+
+ private:
+  // Returns the ordinal of `key`, assigning it the next ordinal if it hasn't
+  // been seen before.
+  int64_t FindOrInsert(string_view key);
+
+  // Mapping of views of the strings in `keys_` to their ordinal.
+  absl::flat_hash_map<string_view, int64_t> ordinals_;
+  // The keys seen so far, ordered by their ordinal. A deque never moves its
+  // elements when growing, so views of the strings remain valid.
+  std::deque<std::string> keys_;
+};
+
+// Creates the CompositeKeyCombiner best suited for keys of the given dtypes:
+// a SingleKeyCombiner for a single integer or string key, and a general
+// CompositeKeyCombiner otherwise.
+std::unique_ptr<CompositeKeyCombiner> CreateKeyCombinerForTypes(
+    std::vector<DataType> dtypes);
+
+template <typename T>
+OutputTensorList SingleKeyCombiner<T>::GetOutputKeys() const {
+  OutputTensorList output_keys;
+  StatusOr<Tensor> t = Tensor::Create(
+      internal::TypeTraits<T>::kDataType,
+      TensorShape({static_cast<int64_t>(keys_.size())}),
+      std::make_unique<MutableVectorData<T>>(keys_.begin(), keys_.end()));
+  TFF_CHECK(t.status().ok()) << t.status().message();
+  output_keys.push_back(std::move(t.value()));
+  return output_keys;
+}
+
+template <typename T>
+std::unique_ptr<MutableVectorData<int64_t>>
+SingleKeyCombiner<T>::AccumulateKeys(const InputTensorList& tensors,
+                                     size_t num_elements) {
+  auto ordinals = std::make_unique<MutableVectorData<int64_t>>();
+  ordinals->reserve(num_elements);
+  const T* keys = static_cast<const T*>(tensors[0]->data().data());
+  for (size_t i = 0; i < num_elements; ++i) {
+    auto [it, inserted] =
+        ordinals_.try_emplace(keys[i], static_cast<int64_t>(keys_.size()));
+    if (inserted) {
+      keys_.push_back(keys[i]);
+    }
+    ordinals->push_back(it->second);
+  }
+  return ordinals;
+}
+
+template <typename T>
+void SingleKeyCombiner<T>::AppendSnapshot(std::string& output) const {
+  AppendSnapshotHeader(SnapshotKind::kSingleNumeric, output);
+  internal::AppendValue<uint64_t>(output, keys_.size());
+  internal::AppendArray(output, keys_.data(), keys_.size());
+}
+
+template <typename T>
+Status SingleKeyCombiner<T>::RestoreSnapshot(absl::string_view snapshot) {
+  TFF_RETURN_IF_ERROR(
+      ReadSnapshotHeader(SnapshotKind::kSingleNumeric, snapshot));
+  uint64_t num_keys;
+  if (!internal::ReadValue(snapshot, num_keys) ||
+      num_keys != snapshot.size() / sizeof(T) ||
+      snapshot.size() % sizeof(T) != 0) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "SingleKeyCombiner::RestoreSnapshot: malformed keys.";
+  }
+  keys_.resize(num_keys);
+  internal::ReadArray(snapshot, keys_.data(), keys_.size());
+  ordinals_.reserve(keys_.size());
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    if (!ordinals_.try_emplace(keys_[i], static_cast<int64_t>(i)).second) {
+      ordinals_.clear();
+      keys_.clear();
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "SingleKeyCombiner::RestoreSnapshot: duplicate key.";
+    }
+  }
+  return TFF_STATUS(OK);
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_SINGLE_KEY_COMBINER_H_
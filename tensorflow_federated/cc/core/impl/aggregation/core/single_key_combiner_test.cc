@@ -0,0 +1,239 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/single_key_combiner.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/composite_key_combiner.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dictionary_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Eq;
+using ::testing::IsNull;
+using ::testing::NotNull;
+
+TEST(SingleKeyCombinerTest, InputWithWrongType_Invalid) {
+  SingleKeyCombiner<int64_t> combiner;
+  Tensor t =
+      Tensor::Create(DT_INT32, {3}, CreateTestData<int32_t>({1, 2, 3})).value();
+  StatusOr<Tensor> result = combiner.Accumulate(InputTensorList({&t}));
+  ASSERT_THAT(result, StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(SingleKeyCombinerTest, InputWithTooManyTensors_Invalid) {
+  SingleKeyCombiner<int64_t> combiner;
+  Tensor t1 =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({1, 2, 3})).value();
+  Tensor t2 =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({4, 5, 6})).value();
+  StatusOr<Tensor> result = combiner.Accumulate(InputTensorList({&t1, &t2}));
+  ASSERT_THAT(result, StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(SingleKeyCombinerTest, OutputBeforeAccumulateOutputsEmptyTensor) {
+  SingleKeyCombiner<int64_t> combiner;
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(1));
+  EXPECT_THAT(output[0], IsTensor<int64_t>({0}, {}));
+}
+
+TEST(SingleKeyCombinerTest, Int64_SameKeysResultInSameOrdinals) {
+  SingleKeyCombiner<int64_t> combiner;
+  Tensor t1 =
+      Tensor::Create(DT_INT64, {4}, CreateTestData<int64_t>({4, -5, 4, 7}))
+          .value();
+  StatusOr<Tensor> result1 = combiner.Accumulate(InputTensorList({&t1}));
+  ASSERT_OK(result1);
+  EXPECT_THAT(result1.value(), IsTensor<int64_t>({4}, {0, 1, 0, 2}));
+
+  // Across different calls to Accumulate, tensors can have different shape.
+  Tensor t2 =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({7, 8, -5}))
+          .value();
+  StatusOr<Tensor> result2 = combiner.Accumulate(InputTensorList({&t2}));
+  ASSERT_OK(result2);
+  EXPECT_THAT(result2.value(), IsTensor<int64_t>({3}, {2, 3, 1}));
+
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(1));
+  EXPECT_THAT(output[0], IsTensor<int64_t>({4}, {4, -5, 7, 8}));
+}
+
+TEST(SingleKeyCombinerTest, Int32_SameKeysResultInSameOrdinals) {
+  SingleKeyCombiner<int32_t> combiner;
+  Tensor t =
+      Tensor::Create(DT_INT32, {5}, CreateTestData<int32_t>({3, 3, 1, 2, 1}))
+          .value();
+  StatusOr<Tensor> result = combiner.Accumulate(InputTensorList({&t}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({5}, {0, 0, 1, 2, 1}));
+
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(1));
+  EXPECT_THAT(output[0], IsTensor<int32_t>({3}, {3, 1, 2}));
+}
+
+TEST(SingleKeyCombinerTest, String_SameKeysResultInSameOrdinals) {
+  SingleKeyCombiner<string_view> combiner;
+  Tensor t1 = Tensor::Create(DT_STRING, {4},
+                             CreateTestData<string_view>(
+                                 {"abc", "", "abc", "a long string key"}))
+                  .value();
+  StatusOr<Tensor> result1 = combiner.Accumulate(InputTensorList({&t1}));
+  ASSERT_OK(result1);
+  EXPECT_THAT(result1.value(), IsTensor<int64_t>({4}, {0, 1, 0, 2}));
+
+  Tensor t2 = Tensor::Create(DT_STRING, {3},
+                             CreateTestData<string_view>(
+                                 {"a long string key", "de", ""}))
+                  .value();
+  StatusOr<Tensor> result2 = combiner.Accumulate(InputTensorList({&t2}));
+  ASSERT_OK(result2);
+  EXPECT_THAT(result2.value(), IsTensor<int64_t>({3}, {2, 3, 1}));
+
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(1));
+  EXPECT_THAT(output[0], IsTensor<string_view>(
+                             {4}, {"abc", "", "a long string key", "de"}));
+}
+
+TEST(SingleKeyCombinerTest, String_DictionaryEncodedKeys) {
+  SingleKeyCombiner<string_view> combiner;
+  Tensor t1 = Tensor::Create(DT_STRING, {2},
+                             CreateTestData<string_view>({"de", "abc"}))
+                  .value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1})));
+
+  // The dictionary holds a string that was already seen, a new one, and an
+  // unused one which doesn't get an ordinal.
+  Tensor t2 =
+      Tensor::Create(DT_STRING, {5},
+                     DictionaryStringData::Encode(std::vector<string_view>(
+                         {"xyz", "abc", "xyz", "xyz", "abc"})))
+          .value();
+  StatusOr<Tensor> result = combiner.Accumulate(InputTensorList({&t2}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({5}, {2, 1, 2, 2, 1}));
+
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(1));
+  EXPECT_THAT(output[0], IsTensor<string_view>({3}, {"de", "abc", "xyz"}));
+}
+
+TEST(SingleKeyCombinerTest, String_OutputKeysOutliveInputs) {
+  SingleKeyCombiner<string_view> combiner;
+  {
+    Tensor t = Tensor::Create(DT_STRING, {2},
+                              CreateTestData<string_view>({"cat", "dog"}))
+                   .value();
+    ASSERT_OK(combiner.Accumulate(InputTensorList({&t})));
+  }
+  OutputTensorList output = combiner.GetOutputKeys();
+  EXPECT_THAT(output.size(), Eq(1));
+  EXPECT_THAT(output[0], IsTensor<string_view>({2}, {"cat", "dog"}));
+}
+
+TEST(SingleKeyCombinerTest, Int64_RestoreSnapshot) {
+  SingleKeyCombiner<int64_t> combiner;
+  Tensor t1 =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({7, 3, 7})).value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1})));
+  std::string snapshot;
+  combiner.AppendSnapshot(snapshot);
+
+  SingleKeyCombiner<int64_t> restored;
+  ASSERT_OK(restored.RestoreSnapshot(snapshot));
+  Tensor t2 =
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({3, 5, 7})).value();
+  StatusOr<Tensor> result = restored.Accumulate(InputTensorList({&t2}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({3}, {1, 2, 0}));
+  EXPECT_THAT(restored.GetOutputKeys()[0], IsTensor<int64_t>({3}, {7, 3, 5}));
+
+  // The snapshot is only restored by a combiner of the same kind.
+  SingleKeyCombiner<int32_t> other_type;
+  EXPECT_THAT(other_type.RestoreSnapshot(snapshot),
+              StatusIs(INVALID_ARGUMENT));
+  SingleKeyCombiner<string_view> strings;
+  EXPECT_THAT(strings.RestoreSnapshot(snapshot), StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(SingleKeyCombinerTest, String_RestoreSnapshot) {
+  SingleKeyCombiner<string_view> combiner;
+  Tensor t1 = Tensor::Create(DT_STRING, {3},
+                             CreateTestData<string_view>({"b", "", "b"}))
+                  .value();
+  ASSERT_OK(combiner.Accumulate(InputTensorList({&t1})));
+  std::string snapshot;
+  combiner.AppendSnapshot(snapshot);
+
+  SingleKeyCombiner<string_view> restored;
+  ASSERT_OK(restored.RestoreSnapshot(snapshot));
+  EXPECT_THAT(restored.RestoreSnapshot(snapshot),
+              StatusIs(FAILED_PRECONDITION));
+  Tensor t2 = Tensor::Create(DT_STRING, {2},
+                             CreateTestData<string_view>({"", "a"}))
+                  .value();
+  StatusOr<Tensor> result = restored.Accumulate(InputTensorList({&t2}));
+  ASSERT_OK(result);
+  EXPECT_THAT(result.value(), IsTensor<int64_t>({2}, {1, 2}));
+  EXPECT_THAT(restored.GetOutputKeys()[0],
+              IsTensor<string_view>({3}, {"b", "", "a"}));
+}
+
+TEST(CreateKeyCombinerForTypesTest, SelectsSingleKeyCombiner) {
+  EXPECT_THAT(dynamic_cast<SingleKeyCombiner<int64_t>*>(
+                  CreateKeyCombinerForTypes({DT_INT64}).get()),
+              NotNull());
+  EXPECT_THAT(dynamic_cast<SingleKeyCombiner<string_view>*>(
+                  CreateKeyCombinerForTypes({DT_STRING}).get()),
+              NotNull());
+}
+
+TEST(CreateKeyCombinerForTypesTest, SelectsCompositeKeyCombiner) {
+  std::unique_ptr<CompositeKeyCombiner> float_combiner =
+      CreateKeyCombinerForTypes({DT_FLOAT});
+  EXPECT_THAT(float_combiner, NotNull());
+  EXPECT_THAT(
+      dynamic_cast<SingleKeyCombiner<int64_t>*>(float_combiner.get()),
+      IsNull());
+  std::unique_ptr<CompositeKeyCombiner> composite_combiner =
+      CreateKeyCombinerForTypes({DT_INT64, DT_STRING});
+  EXPECT_THAT(composite_combiner, NotNull());
+  EXPECT_THAT(composite_combiner->dtypes().size(), Eq(2));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
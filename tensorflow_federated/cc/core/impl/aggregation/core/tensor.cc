@@ -28,6 +28,7 @@
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/inline_tensor_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
@@ -48,9 +49,12 @@ Status Tensor::CheckValid() const {
   // size and alignment.
   TFF_RETURN_IF_ERROR(data_->CheckValid(value_size, alignment_size));
 
+  if (indices_ != nullptr) {
+    return CheckSparseIndices(data_->byte_size() / value_size);
+  }
+
   // Verify that the total size of the data is consistent with the value type
   // and the shape.
-  // TODO: b/266974165 - Implement sparse tensors.
   if (data_->byte_size() != shape_.NumElements().value() * value_size) {
     return TFF_STATUS(FAILED_PRECONDITION)
            << "TensorData byte_size is inconsistent with the Tensor dtype and "
@@ -60,6 +64,31 @@ Status Tensor::CheckValid() const {
   return TFF_STATUS(OK);
 }
 
+Status Tensor::CheckSparseIndices(size_t num_values) const {
+  if (dtype_ == DT_STRING) {
+    return TFF_STATUS(FAILED_PRECONDITION)
+           << "Sparse tensors must have numeric values.";
+  }
+  TFF_RETURN_IF_ERROR(indices_->CheckValid<int64_t>());
+  if (indices_->byte_size() / sizeof(int64_t) != num_values) {
+    return TFF_STATUS(FAILED_PRECONDITION)
+           << "The number of sparse tensor indices is inconsistent with the "
+              "number of values.";
+  }
+  const int64_t num_elements =
+      static_cast<int64_t>(shape_.NumElements().value());
+  int64_t previous_index = -1;
+  for (int64_t index : sparse_indices()) {
+    if (index <= previous_index || index >= num_elements) {
+      return TFF_STATUS(FAILED_PRECONDITION)
+             << "Sparse tensor indices must be strictly increasing and within "
+                "the tensor shape.";
+    }
+    previous_index = index;
+  }
+  return TFF_STATUS(OK);
+}
+
 StatusOr<Tensor> Tensor::Create(DataType dtype, TensorShape shape,
                                 std::unique_ptr<TensorData> data) {
   TFF_ASSIGN_OR_RETURN(size_t num_elements, shape.NumElements());
@@ -68,6 +97,20 @@ StatusOr<Tensor> Tensor::Create(DataType dtype, TensorShape shape,
   return std::move(tensor);
 }
 
+StatusOr<Tensor> Tensor::CreateSparse(DataType dtype, TensorShape shape,
+                                      std::unique_ptr<TensorData> data,
+                                      std::unique_ptr<TensorData> indices) {
+  if (indices == nullptr) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "Sparse tensors require the dense indices of their values.";
+  }
+  TFF_ASSIGN_OR_RETURN(size_t num_elements, shape.NumElements());
+  Tensor tensor(dtype, std::move(shape), num_elements, std::move(data),
+                std::move(indices));
+  TFF_RETURN_IF_ERROR(tensor.CheckValid());
+  return std::move(tensor);
+}
+
 // SerializedContentNumericData implements TensorData by wrapping the serialized
 // content string and using it directly as a backing storage. This relies on the
 // fact that the serialized content uses the same layout as in memory
@@ -155,6 +198,19 @@ StatusOr<std::unique_ptr<TensorData>> DecodeContent(std::string content,
   return std::make_unique<SerializedContentNumericData>(std::move(content));
 }
 
+// Decodes a copy of the serialized TensorData `content`. Since the content is
+// copied anyway, small numeric values, e.g. scalars, are copied inline rather
+// than into an aligned copy of the content. The content moved out of a proto
+// is adopted by DecodeContent instead.
+template <typename T>
+StatusOr<std::unique_ptr<TensorData>> DecodeContentCopy(
+    const std::string& content, size_t num) {
+  if (InlineTensorData::Fits(content.size())) {
+    return std::make_unique<InlineTensorData>(content.data(), content.size());
+  }
+  return DecodeContent<T>(AlignedCopyOf(content), num);
+}
+
 // Wraps the serialized TensorData content stored and surfaces it as pointer
 // string_view values pointing back into the wrapped content. This class is
 // be created and initialized from within the DecodeContent<string_view>().
@@ -239,6 +295,12 @@ StatusOr<std::unique_ptr<TensorData>> DecodeContent<string_view>(
   return tensor_data;
 }
 
+template <>
+StatusOr<std::unique_ptr<TensorData>> DecodeContentCopy<string_view>(
+    const std::string& content, size_t num) {
+  return DecodeContent<string_view>(AlignedCopyOf(content), num);
+}
+
 class ZeroTensorData : public TensorData {
  public:
   const void* data() const override { return this; }
@@ -260,8 +322,10 @@ class VectorNumericData : public TensorData {
   std::vector<T> values_;
 };
 
-template <typename T>
-Status CreateDataFromVector(DataType datatype_from_proto, std::vector<T> values,
+// Creates the tensor data from the repeated `values` field of a TensorProto.
+template <typename T, typename RepeatedValues>
+Status CreateDataFromValues(DataType datatype_from_proto,
+                            const RepeatedValues& values,
                             std::unique_ptr<TensorData>& data) {
   if (data != nullptr) {
     return TFF_STATUS(INVALID_ARGUMENT)
@@ -271,89 +335,115 @@ Status CreateDataFromVector(DataType datatype_from_proto, std::vector<T> values,
     return TFF_STATUS(INVALID_ARGUMENT)
            << "Tensor proto contains data of unexpected data type.";
   }
-  data = std::make_unique<VectorNumericData<T>>(std::move(values));
+  const size_t byte_size = values.size() * sizeof(T);
+  if (InlineTensorData::Fits(byte_size)) {
+    data = std::make_unique<InlineTensorData>(values.data(), byte_size);
+  } else {
+    data = std::make_unique<VectorNumericData<T>>(
+        std::vector<T>(values.begin(), values.end()));
+  }
   return TFF_STATUS(OK);
 }
 
+// Creates a tensor from its shape and data, which is sparse if `indices` isn't
+// null.
+StatusOr<Tensor> CreateDenseOrSparse(DataType dtype, TensorShape shape,
+                                     std::unique_ptr<TensorData> data,
+                                     std::unique_ptr<TensorData> indices) {
+  if (indices == nullptr) {
+    return Tensor::Create(dtype, std::move(shape), std::move(data));
+  }
+  return Tensor::CreateSparse(dtype, std::move(shape), std::move(data),
+                              std::move(indices));
+}
+
 StatusOr<Tensor> Tensor::FromProto(const TensorProto& tensor_proto) {
   if (tensor_proto.dtype() == DT_INVALID) {
     return TFF_STATUS(INVALID_ARGUMENT) << "Invalid Tensor dtype.";
   }
   TFF_ASSIGN_OR_RETURN(TensorShape shape,
                        TensorShape::FromProto(tensor_proto.shape()));
-  // TODO: b/266974165 - The num_values is valid only for dense tensors.
   TFF_ASSIGN_OR_RETURN(size_t num_values, shape.NumElements());
+  // The content of a sparse tensor only holds the values at its indices.
+  std::unique_ptr<TensorData> indices;
+  if (tensor_proto.has_sparsity_encoding()) {
+    TFF_ASSIGN_OR_RETURN(
+        indices,
+        DecodeContentCopy<int64_t>(
+            tensor_proto.sparsity_encoding().index_content(), 0));
+    num_values = indices->byte_size() / sizeof(int64_t);
+  }
   std::unique_ptr<TensorData> data;
   if (!tensor_proto.content().empty()) {
-    std::string content = AlignedCopyOf(tensor_proto.content());
     DTYPE_CASES(tensor_proto.dtype(), T,
-                TFF_ASSIGN_OR_RETURN(
-                    data, DecodeContent<T>(std::move(content), num_values)));
+                TFF_ASSIGN_OR_RETURN(data, DecodeContentCopy<T>(
+                                               tensor_proto.content(),
+                                               num_values)));
   }
   if (tensor_proto.float_val_size() > 0) {
-    TFF_RETURN_IF_ERROR(CreateDataFromVector(
-        tensor_proto.dtype(),
-        std::vector<float>(tensor_proto.float_val().begin(),
-                           tensor_proto.float_val().end()),
-        data));
+    TFF_RETURN_IF_ERROR(CreateDataFromValues<float>(
+        tensor_proto.dtype(), tensor_proto.float_val(), data));
   }
   if (tensor_proto.double_val_size() > 0) {
-    TFF_RETURN_IF_ERROR(CreateDataFromVector(
-        tensor_proto.dtype(),
-        std::vector<double>(tensor_proto.double_val().begin(),
-                            tensor_proto.double_val().end()),
-        data));
+    TFF_RETURN_IF_ERROR(CreateDataFromValues<double>(
+        tensor_proto.dtype(), tensor_proto.double_val(), data));
   }
   if (tensor_proto.int_val_size() > 0) {
-    TFF_RETURN_IF_ERROR(
-        CreateDataFromVector(tensor_proto.dtype(),
-                             std::vector<int>(tensor_proto.int_val().begin(),
-                                              tensor_proto.int_val().end()),
-                             data));
+    TFF_RETURN_IF_ERROR(CreateDataFromValues<int>(
+        tensor_proto.dtype(), tensor_proto.int_val(), data));
   }
   if (tensor_proto.int64_val_size() > 0) {
-    TFF_RETURN_IF_ERROR(CreateDataFromVector(
-        tensor_proto.dtype(),
-        std::vector<int64_t>(tensor_proto.int64_val().begin(),
-                             tensor_proto.int64_val().end()),
-        data));
+    TFF_RETURN_IF_ERROR(CreateDataFromValues<int64_t>(
+        tensor_proto.dtype(), tensor_proto.int64_val(), data));
   }
   if (data == nullptr) {
-    if (shape.NumElements().value() != 0) {
+    if (num_values != 0) {
       return TFF_STATUS(INVALID_ARGUMENT)
              << "Tensor proto contains no data but the shape indicates it is "
                 "non-empty.";
     }
     data = std::make_unique<ZeroTensorData>();
   }
-  return Create(tensor_proto.dtype(), std::move(shape), std::move(data));
+  return CreateDenseOrSparse(tensor_proto.dtype(), std::move(shape),
+                             std::move(data), std::move(indices));
 }
 
 StatusOr<Tensor> Tensor::FromProto(TensorProto&& tensor_proto) {
   TFF_ASSIGN_OR_RETURN(TensorShape shape,
                        TensorShape::FromProto(tensor_proto.shape()));
-  // TODO: b/266974165 - The num_values is valid only for dense tensors.
   TFF_ASSIGN_OR_RETURN(size_t num_values, shape.NumElements());
+  // The content of a sparse tensor only holds the values at its indices.
+  std::unique_ptr<TensorData> indices;
+  if (tensor_proto.has_sparsity_encoding()) {
+    std::string index_content = std::move(
+        *tensor_proto.mutable_sparsity_encoding()->mutable_index_content());
+    indices = std::make_unique<SerializedContentNumericData>(
+        MakeAligned<int64_t>(std::move(index_content)));
+    num_values = indices->byte_size() / sizeof(int64_t);
+  }
   std::string content = std::move(*tensor_proto.mutable_content());
   StatusOr<std::unique_ptr<TensorData>> data;
   DTYPE_CASES(
       tensor_proto.dtype(), T,
       data = DecodeContent<T>(MakeAligned<T>(std::move(content)), num_values));
   TFF_RETURN_IF_ERROR(data);
-  return Create(tensor_proto.dtype(), std::move(shape),
-                std::move(data).value());
+  return CreateDenseOrSparse(tensor_proto.dtype(), std::move(shape),
+                             std::move(data).value(), std::move(indices));
 }
 
 TensorProto Tensor::ToProto() const {
   TensorProto tensor_proto;
   tensor_proto.set_dtype(dtype_);
   *(tensor_proto.mutable_shape()) = shape_.ToProto();
-  // TODO: b/266974165 - The num_values is valid only for dense tensors.
+  const size_t num_values =
+      is_dense() ? shape_.NumElements().value() : sparse_indices().size();
   std::string content;
-  DTYPE_CASES(
-      dtype_, T,
-      content = EncodeContent<T>(data_.get(), shape_.NumElements().value()));
+  DTYPE_CASES(dtype_, T, content = EncodeContent<T>(data_.get(), num_values));
   *(tensor_proto.mutable_content()) = std::move(content);
+  if (!is_dense()) {
+    *(tensor_proto.mutable_sparsity_encoding()->mutable_index_content()) =
+        EncodeContent<int64_t>(indices_.get(), num_values);
+  }
   return tensor_proto;
 }
 
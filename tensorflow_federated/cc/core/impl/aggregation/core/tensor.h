@@ -19,6 +19,7 @@
 
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <type_traits>
 #include <utility>
@@ -40,6 +41,10 @@ namespace aggregation {
 // For the most part, the aggregation code won't be consuming tensors directly.
 // Instead the aggregation code will be working with AggVector instances that
 // represent the tensor data in a flattened way.
+//
+// A tensor is either dense, with all its values stored in the tensor data, or
+// sparse, with only the non-zero values stored in the tensor data together with
+// their dense indices. Sparse tensors have numeric values.
 class Tensor final {
  public:
   // Tensor class isn't copyable.
@@ -49,7 +54,8 @@ class Tensor final {
   Tensor(Tensor&& other)
       : dtype_(other.dtype_),
         shape_(std::move(other.shape_)),
-        data_(std::move(other.data_)) {
+        data_(std::move(other.data_)),
+        indices_(std::move(other.indices_)) {
     other.dtype_ = DT_INVALID;
   }
 
@@ -58,6 +64,7 @@ class Tensor final {
     dtype_ = other.dtype_;
     shape_ = std::move(other.shape_);
     data_ = std::move(other.data_);
+    indices_ = std::move(other.indices_);
     other.dtype_ = DT_INVALID;
     return *this;
   }
@@ -72,6 +79,14 @@ class Tensor final {
   static StatusOr<Tensor> Create(DataType dtype, TensorShape shape,
                                  std::unique_ptr<TensorData> data);
 
+  // Validates parameters and creates a sparse Tensor instance. `data` holds the
+  // non-zero values, and `indices` holds the int64 dense index of each value,
+  // i.e. its position in the tensor flattened in row-major order. The indices
+  // must be strictly increasing.
+  static StatusOr<Tensor> CreateSparse(DataType dtype, TensorShape shape,
+                                       std::unique_ptr<TensorData> data,
+                                       std::unique_ptr<TensorData> indices);
+
   // Creates a Tensor instance from a TensorProto.
   static StatusOr<Tensor> FromProto(const TensorProto& tensor_proto);
 
@@ -90,22 +105,31 @@ class Tensor final {
   // Gets the tensor shape.
   const TensorShape& shape() const { return shape_; }
 
-  // Gets the number of elements in the tensor.
+  // Gets the number of elements in the tensor, including the elements that
+  // aren't stored in a sparse tensor.
   size_t num_elements() const { return shape_.NumElements().value(); }
 
-  // Readonly access to the tensor data.
+  // Readonly access to the tensor data. The data of a sparse tensor only holds
+  // its non-zero values.
   const TensorData& data() const { return *data_; }
 
   // Returns true is the current tensor data is dense.
-  // TODO: b/266974165 - Implement sparse tensors.
-  bool is_dense() const { return true; }
+  bool is_dense() const { return indices_ == nullptr; }
+
+  // Provides access to the dense indices of the values of a sparse tensor.
+  absl::Span<const int64_t> sparse_indices() const {
+    TFF_CHECK(!is_dense()) << "sparse_indices() called on a dense tensor";
+    return absl::Span<const int64_t>(
+        static_cast<const int64_t*>(indices_->data()),
+        indices_->byte_size() / sizeof(int64_t));
+  }
 
   // Provides access to the tensor data via a strongly typed AggVector.
   template <typename T>
   AggVector<T> AsAggVector() const {
     TFF_CHECK(internal::TypeTraits<T>::kDataType == dtype_)
         << "Incompatible tensor dtype()";
-    return AggVector<T>(data_.get());
+    return AggVector<T>(data_.get(), num_elements(), indices_.get());
   }
 
   // Provides access to the (numerical) tensor data as an integral scalar.
@@ -151,7 +175,8 @@ class Tensor final {
     return *GetData<T>();
   }
 
-  // Provides access to the tensor data as a span.
+  // Provides access to the tensor data as a span. Must only be called on dense
+  // tensors.
   template <typename T>
   absl::Span<const T> AsSpan() const {
     TFF_CHECK(internal::TypeTraits<T>::kDataType == dtype_)
@@ -163,14 +188,23 @@ class Tensor final {
 
  private:
   Tensor(DataType dtype, TensorShape shape, size_t num_elements,
-         std::unique_ptr<TensorData> data)
-      : dtype_(dtype), shape_(std::move(shape)), data_(std::move(data)) {}
+         std::unique_ptr<TensorData> data,
+         std::unique_ptr<TensorData> indices = nullptr)
+      : dtype_(dtype),
+        shape_(std::move(shape)),
+        data_(std::move(data)),
+        indices_(std::move(indices)) {}
+
+  // Validates the dense indices of a sparse tensor.
+  Status CheckSparseIndices(size_t num_values) const;
 
-  // Returns a pointer to the tensor data.
+  // Returns a pointer to the data of a dense tensor.
   template <typename T>
   const T* GetData() const {
     TFF_CHECK(internal::TypeTraits<T>::kDataType == dtype_)
         << "Incompatible tensor dtype()";
+    TFF_CHECK(is_dense()) << "Sparse tensor values can only be accessed "
+                             "through AsAggVector()";
     return reinterpret_cast<const T*>(data_->data());
   }
 
@@ -180,6 +214,9 @@ class Tensor final {
   TensorShape shape_;
   // The underlying tensor data.
   std::unique_ptr<TensorData> data_;
+  // The dense indices of the values of a sparse tensor, or null if the tensor
+  // is dense.
+  std::unique_ptr<TensorData> indices_;
 };
 
 }  // namespace aggregation
@@ -16,8 +16,10 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
 
+#include <cstddef>
 #include <utility>
 
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 
@@ -31,6 +33,34 @@ Status TensorAggregator::Accumulate(InputTensorList tensors) {
   return AggregateTensors(std::move(tensors));
 }
 
+Status TensorAggregator::AccumulateBatch(
+    absl::Span<const InputTensorList> batch) {
+  TFF_RETURN_IF_ERROR(CheckValid());
+  return AggregateTensorBatch(batch);
+}
+
+Status TensorAggregator::AggregateTensorBatch(
+    absl::Span<const InputTensorList> batch) {
+  for (const InputTensorList& tensors : batch) {
+    // InputTensorList isn't copyable, so the tensor pointers are copied into
+    // a new list for each input.
+    InputTensorList copy(tensors.size());
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      copy[i] = tensors[i];
+    }
+    TFF_RETURN_IF_ERROR(AggregateTensors(std::move(copy)));
+  }
+  return TFF_STATUS(OK);
+}
+
+Status TensorAggregator::MergeWithAll(
+    absl::Span<TensorAggregator* const> others) {
+  for (TensorAggregator* other : others) {
+    TFF_RETURN_IF_ERROR(MergeWith(std::move(*other)));
+  }
+  return TFF_STATUS(OK);
+}
+
 bool TensorAggregator::CanReport() const { return CheckValid().ok(); }
 
 StatusOr<OutputTensorList> TensorAggregator::Report() && {
@@ -17,9 +17,11 @@
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_TENSOR_AGGREGATOR_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_TENSOR_AGGREGATOR_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
@@ -39,15 +41,37 @@ class TensorAggregator
 
   // Implementation of the base Aggregator class methods.
   Status Accumulate(InputTensorList tensors) override;
+
+  // Accumulates the inputs of several clients, with the same result as
+  // calling Accumulate with each of them in order when all of them are valid.
+  // The validity of the aggregator is only checked once, and derived classes
+  // may aggregate the whole batch in a single pass over the data, see
+  // AggregateTensorBatch. If an input is invalid, whether the inputs before
+  // it are aggregated depends on the derived class: by default they are, as
+  // if Accumulate were called in order until the first failure, while e.g.
+  // AggVectorAggregator aggregates none of the batch.
+  Status AccumulateBatch(absl::Span<const InputTensorList> batch);
   bool CanReport() const override;
   StatusOr<OutputTensorList> Report() && override;
 
   // Returns the number of aggregated inputs.
   virtual int GetNumInputs() const = 0;
 
+  // Returns an estimate of the memory held by the aggregation state, in bytes.
+  // The default implementation returns 0 for aggregators that don't estimate
+  // their memory usage.
+  virtual size_t GetMemoryUsage() const { return 0; }
+
   // Serialize the internal state of the TensorAggregator as a string.
   virtual StatusOr<std::string> Serialize() && = 0;
 
+  // Merges the intermediate aggregates of all `others` into this aggregator,
+  // consuming them, with the same result as calling MergeWith with each of
+  // them in order. Derived classes may override this to combine all of them
+  // in a single pass over the data. The default implementation stops at the
+  // first failing MergeWith, leaving the following aggregators unmerged.
+  virtual Status MergeWithAll(absl::Span<TensorAggregator* const> others);
+
  protected:
   // Construct TensorAggregator
   explicit TensorAggregator() {}
@@ -56,6 +80,13 @@ class TensorAggregator
   // a derived class.
   virtual Status AggregateTensors(InputTensorList tensors) = 0;
 
+  // Aggregates all inputs of `batch` in order. Derived classes may override
+  // this to validate the whole batch up front and aggregate it in a single
+  // pass. The default implementation passes each input to AggregateTensors
+  // and stops at the first failure, leaving the preceding inputs aggregated
+  // and the following ones unaggregated.
+  virtual Status AggregateTensorBatch(absl::Span<const InputTensorList> batch);
+
   // Checks if the current TensorAggregator is valid e.g. the resulting output
   // hasn't been consumed.
   virtual Status CheckValid() const = 0;
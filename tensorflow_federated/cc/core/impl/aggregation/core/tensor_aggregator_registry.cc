@@ -14,8 +14,11 @@
  * limitations under the License.
  */
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
@@ -30,26 +33,39 @@ namespace aggregation {
 
 namespace internal {
 
+// Factories are registered during static initialization, and rarely later,
+// e.g. by tests, while they are looked up whenever an aggregator is created.
+// Lookups therefore read an immutable snapshot of the registered factories
+// without locking, and each registration publishes a new snapshot.
 class Registry final {
  public:
+  Registry() {
+    snapshots_.push_back(std::make_unique<const FactoryMap>());
+    snapshot_.store(snapshots_.back().get(), std::memory_order_release);
+  }
+
   void RegisterAggregatorFactory(const std::string& intrinsic_uri,
                                  const TensorAggregatorFactory* factory) {
     TFF_CHECK(factory != nullptr);
 
     absl::MutexLock lock(&mutex_);
-    TFF_CHECK(map_.find(intrinsic_uri) == map_.end())
+    const FactoryMap& current = *snapshot_.load(std::memory_order_relaxed);
+    TFF_CHECK(current.find(intrinsic_uri) == current.end())
         << "A factory for intrinsic_uri '" << intrinsic_uri
         << "' is already registered.";
-    map_[intrinsic_uri] = factory;
+    auto next = std::make_unique<FactoryMap>(current);
+    next->emplace(intrinsic_uri, factory);
+    snapshot_.store(next.get(), std::memory_order_release);
+    snapshots_.push_back(std::move(next));
     TFF_LOG(INFO) << "TensorAggregatorFactory for intrinsic_uri '"
                   << intrinsic_uri << "' is registered.";
   }
 
   StatusOr<const TensorAggregatorFactory*> GetAggregatorFactory(
-      const std::string& intrinsic_uri) {
-    absl::MutexLock lock(&mutex_);
-    auto it = map_.find(intrinsic_uri);
-    if (it == map_.end()) {
+      const std::string& intrinsic_uri) const {
+    const FactoryMap& snapshot = *snapshot_.load(std::memory_order_acquire);
+    auto it = snapshot.find(intrinsic_uri);
+    if (it == snapshot.end()) {
       return TFF_STATUS(NOT_FOUND)
              << "Unknown factory for intrinsic_uri '" << intrinsic_uri << "'.";
     }
@@ -57,9 +73,18 @@ class Registry final {
   }
 
  private:
+  using FactoryMap =
+      absl::flat_hash_map<std::string, const TensorAggregatorFactory*>;
+
+  // Serializes registrations.
   absl::Mutex mutex_;
-  absl::flat_hash_map<std::string, const TensorAggregatorFactory*> map_
+  // Every snapshot published so far, since a concurrent lookup may still read
+  // any of them. There are a few dozen registrations, so keeping the old
+  // snapshots costs little.
+  std::vector<std::unique_ptr<const FactoryMap>> snapshots_
       ABSL_GUARDED_BY(mutex_);
+  // The latest snapshot, which lookups read.
+  std::atomic<const FactoryMap*> snapshot_ = nullptr;
 };
 
 Registry* GetRegistry() {
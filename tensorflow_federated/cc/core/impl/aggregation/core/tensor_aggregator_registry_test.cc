@@ -45,6 +45,13 @@ TEST(TensorAggregatorRegistryTest, FactoryRegistrationSuccessful) {
   EXPECT_THAT(GetAggregatorFactory("xyz"), StatusIs(NOT_FOUND));
 }
 
+TEST(TensorAggregatorRegistryTest, LaterRegistrationIsVisible) {
+  static MockFactory* factory = new MockFactory();
+  RegisterAggregatorFactory("later_foobar", factory);
+  EXPECT_THAT(GetAggregatorFactory("later_foobar"), IsOkAndHolds(factory));
+  EXPECT_THAT(GetAggregatorFactory("foobar"), IsOk());
+}
+
 TEST(TensorAggregatorRegistryTest, RepeatedRegistrationUnsuccessful) {
   MockFactory factory2;
   EXPECT_DEATH(RegisterAggregatorFactory("foobar", &factory2),
@@ -21,8 +21,8 @@
 #include <cstdint>
 #include <initializer_list>
 #include <utility>
-#include <vector>
 
+#include "absl/container/inlined_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 
@@ -33,7 +33,10 @@ namespace aggregation {
 // dimension sizes.
 class TensorShape final {
  public:
-  using DimSizesVector = std::vector<int64_t>;
+  // Dimension sizes are stored inline for shapes of up to this many
+  // dimensions, so that creating a tensor of such a shape doesn't allocate.
+  static constexpr size_t kInlinedNumDims = 4;
+  using DimSizesVector = absl::InlinedVector<int64_t, kInlinedNumDims>;
 
   template <typename ForwardIterator>
   TensorShape(ForwardIterator first, ForwardIterator last)
@@ -89,8 +92,6 @@ class TensorShape final {
     return TFF_STATUS(OK);
   }
 
-  // TODO: b/222605809 - Consider optimizing the storage for better inlining
-  // of small number of dimensions.
   DimSizesVector dim_sizes_;
 };
 
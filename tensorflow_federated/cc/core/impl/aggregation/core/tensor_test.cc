@@ -36,6 +36,7 @@ namespace tensorflow_federated {
 namespace aggregation {
 namespace {
 
+using ::testing::ElementsAre;
 using ::testing::Eq;
 using ::testing::HasSubstr;
 
@@ -98,6 +99,59 @@ TEST(TensorTest, Create_DataSizeError) {
 
 struct FooBar {};
 
+TEST(TensorTest, CreateSparse_Success) {
+  auto t = Tensor::CreateSparse(DT_FLOAT, {2, 3},
+                                CreateTestData<float>({1, 2}),
+                                CreateTestData<int64_t>({1, 5}));
+  EXPECT_THAT(t, IsOk());
+  EXPECT_THAT(t->num_elements(), Eq(6));
+  EXPECT_FALSE(t->is_dense());
+  EXPECT_THAT(t->sparse_indices(), ElementsAre(1, 5));
+  EXPECT_THAT(*t, IsTensor<float>({2, 3}, {0, 1, 0, 0, 0, 2}));
+}
+
+TEST(TensorTest, CreateSparse_NoValues) {
+  auto t = Tensor::CreateSparse(DT_INT32, {4}, CreateTestData<int32_t>({}),
+                                CreateTestData<int64_t>({}));
+  EXPECT_THAT(t, IsOk());
+  EXPECT_FALSE(t->is_dense());
+  EXPECT_THAT(*t, IsTensor<int32_t>({4}, {0, 0, 0, 0}));
+}
+
+TEST(TensorTest, CreateSparse_MissingIndices) {
+  EXPECT_THAT(Tensor::CreateSparse(DT_INT32, {4}, CreateTestData<int32_t>({1}),
+                                   nullptr),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(TensorTest, CreateSparse_IndicesCountMismatch) {
+  EXPECT_THAT(Tensor::CreateSparse(DT_INT32, {4},
+                                   CreateTestData<int32_t>({1, 2}),
+                                   CreateTestData<int64_t>({1})),
+              StatusIs(FAILED_PRECONDITION));
+}
+
+TEST(TensorTest, CreateSparse_IndicesNotIncreasing) {
+  EXPECT_THAT(Tensor::CreateSparse(DT_INT32, {4},
+                                   CreateTestData<int32_t>({1, 2}),
+                                   CreateTestData<int64_t>({2, 2})),
+              StatusIs(FAILED_PRECONDITION));
+}
+
+TEST(TensorTest, CreateSparse_IndexOutOfRange) {
+  EXPECT_THAT(Tensor::CreateSparse(DT_INT32, {4},
+                                   CreateTestData<int32_t>({1, 2}),
+                                   CreateTestData<int64_t>({1, 4})),
+              StatusIs(FAILED_PRECONDITION));
+}
+
+TEST(TensorTest, CreateSparse_StringTensor) {
+  EXPECT_THAT(Tensor::CreateSparse(DT_STRING, {4},
+                                   CreateTestData<string_view>({"a"}),
+                                   CreateTestData<int64_t>({1})),
+              StatusIs(FAILED_PRECONDITION));
+}
+
 TEST(TensorTest, AsAggVector_TypeCheckFailure) {
   auto t = Tensor::Create(DT_FLOAT, {1}, CreateTestData<float>({1}));
   EXPECT_DEATH(t->AsAggVector<FooBar>(), "Incompatible tensor dtype()");
@@ -275,6 +329,19 @@ TEST(TensorTest, FromProto_Uint64_Success) {
   EXPECT_THAT(*t, IsTensor({2, 3}, values));
 }
 
+TEST(TensorTest, FromProto_Int8_Success) {
+  std::initializer_list<int8_t> values{-128, -1, 0, 1, 126, 127};
+  TensorProto tensor_proto;
+  tensor_proto.set_dtype(DT_INT8);
+  tensor_proto.mutable_shape()->add_dim_sizes(2);
+  tensor_proto.mutable_shape()->add_dim_sizes(3);
+  tensor_proto.set_content(ToProtoContent(values));
+  auto t = Tensor::FromProto(tensor_proto);
+  EXPECT_THAT(t, IsOk());
+  EXPECT_THAT(*t, IsTensor({2, 3}, values));
+  EXPECT_THAT(t->ToProto(), testing::EqualsProto(tensor_proto));
+}
+
 TEST(TensorTest, FromProto_String_Success) {
   std::initializer_list<string_view> values{"aaaaaaaa", "b", "cccc", "ddddddd"};
   TensorProto tensor_proto;
@@ -468,6 +535,39 @@ TEST(TensorTest, RoundTrip_NoData_String) {
   EXPECT_THAT(*result, IsTensor({0}, values));
 }
 
+TEST(TensorTest, RoundTrip_Sparse) {
+  auto t = Tensor::CreateSparse(DT_INT64, {2, 4},
+                                CreateTestData<int64_t>({7, 8, 9}),
+                                CreateTestData<int64_t>({0, 3, 6}));
+
+  auto p = t->ToProto();
+  EXPECT_THAT(p.content(), Eq(ToProtoContent<int64_t>({7, 8, 9})));
+  EXPECT_TRUE(p.has_sparsity_encoding());
+  EXPECT_THAT(p.sparsity_encoding().index_content(),
+              Eq(ToProtoContent<int64_t>({0, 3, 6})));
+
+  auto result = Tensor::FromProto(p);
+  EXPECT_THAT(result, IsOk());
+  EXPECT_FALSE(result->is_dense());
+  EXPECT_THAT(*result, IsTensor<int64_t>({2, 4}, {7, 0, 0, 8, 0, 0, 9, 0}));
+
+  auto moved_result = Tensor::FromProto(std::move(p));
+  EXPECT_THAT(moved_result, IsOk());
+  EXPECT_FALSE(moved_result->is_dense());
+  EXPECT_THAT(*moved_result,
+              IsTensor<int64_t>({2, 4}, {7, 0, 0, 8, 0, 0, 9, 0}));
+}
+
+TEST(TensorTest, FromProto_SparseIndicesCountMismatch) {
+  TensorProto tensor_proto;
+  tensor_proto.set_dtype(DT_INT32);
+  tensor_proto.mutable_shape()->add_dim_sizes(4);
+  tensor_proto.set_content(ToProtoContent<int32_t>({1, 2}));
+  tensor_proto.mutable_sparsity_encoding()->set_index_content(
+      ToProtoContent<int64_t>({3}));
+  EXPECT_THAT(Tensor::FromProto(tensor_proto), StatusIs(FAILED_PRECONDITION));
+}
+
 }  // namespace
 }  // namespace aggregation
 }  // namespace tensorflow_federated
@@ -0,0 +1,436 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/contiguous_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/fedsql_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_factory.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// Approximates the k most frequent keys of a single key column with the
+// Space-Saving algorithm (Metwally et al., "Efficient Computation of Frequent
+// and Top-k Elements in Data Streams"), so that the state of the aggregation
+// is O(k) regardless of the number of distinct keys.
+//
+// The sketch tracks at most k keys with an estimated count each. A tracked key
+// is counted exactly; an untracked key replaces the tracked key with the
+// smallest count and inherits that count. The estimated counts therefore never
+// underestimate the true counts, and every key whose true count is larger
+// than the smallest estimated count is guaranteed to be tracked. When there
+// are at most k distinct keys, the counts are exact.
+//
+// The outputs are the tracked keys and their estimated counts, in order of
+// decreasing count.
+template <typename T>
+class TopKAggregator final : public TensorAggregator {
+ public:
+  // The strings of a DT_STRING key column are owned by the sketch, since the
+  // input tensors don't outlive AggregateTensors.
+  using Key =
+      std::conditional_t<std::is_same_v<T, string_view>, std::string, T>;
+
+  TopKAggregator(DataType dtype, size_t k, int num_inputs = 0)
+      : dtype_(dtype), k_(k), num_inputs_(num_inputs) {
+    keys_.reserve(k_);
+    counts_.reserve(k_);
+    heap_.reserve(k_);
+    positions_.reserve(k_);
+  }
+
+  // Adds `count` occurrences of `key` to the sketch.
+  void Add(const T& key, int64_t count) {
+    auto it = slots_.find(key);
+    if (it != slots_.end()) {
+      counts_[it->second] += count;
+      SiftDown(positions_[it->second]);
+      return;
+    }
+    if (keys_.size() < k_) {
+      size_t slot = keys_.size();
+      keys_.push_back(Key(key));
+      counts_.push_back(count);
+      heap_.push_back(slot);
+      positions_.push_back(slot);
+      slots_.emplace(keys_[slot], slot);
+      SiftUp(slot);
+      return;
+    }
+    // Replace the key with the smallest count.
+    size_t slot = heap_[0];
+    slots_.erase(keys_[slot]);
+    keys_[slot] = Key(key);
+    counts_[slot] += count;
+    slots_.emplace(keys_[slot], slot);
+    SiftDown(0);
+  }
+
+  StatusOr<std::string> Serialize() && override {
+    TopKAggregatorState aggregator_state;
+    aggregator_state.set_num_inputs(num_inputs_);
+    TFF_ASSIGN_OR_RETURN(Tensor keys, CreateKeysTensor(keys_));
+    *aggregator_state.mutable_keys() = keys.ToProto();
+    MutableVectorData<int64_t> counts(counts_.begin(), counts_.end());
+    *aggregator_state.mutable_counts() = counts.EncodeContent();
+    return aggregator_state.SerializeAsString();
+  }
+
+ private:
+  Status MergeWith(TensorAggregator&& other) override {
+    TFF_RETURN_IF_ERROR(CheckValid());
+    TopKAggregator* other_ptr = dynamic_cast<TopKAggregator*>(&other);
+    if (other_ptr == nullptr) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKAggregator::MergeWith: Can only merge with another "
+                "TopKAggregator of the same key type.";
+    }
+    TFF_RETURN_IF_ERROR(other_ptr->CheckValid());
+    if (other_ptr->k_ != k_) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKAggregator::MergeWith: Can only merge sketches of the "
+                "same size.";
+    }
+
+    // A key that isn't tracked by a full sketch may have occurred up to the
+    // smallest count of that sketch, so that count is added for it to keep
+    // the estimates from underestimating the true counts.
+    const int64_t min_count = MinCountIfFull();
+    const int64_t other_min_count = other_ptr->MinCountIfFull();
+    std::vector<std::pair<Key, int64_t>> merged;
+    merged.reserve(keys_.size() + other_ptr->keys_.size());
+    for (size_t slot = 0; slot < keys_.size(); ++slot) {
+      auto it = other_ptr->slots_.find(keys_[slot]);
+      int64_t other_count = it != other_ptr->slots_.end()
+                                ? other_ptr->counts_[it->second]
+                                : other_min_count;
+      merged.emplace_back(std::move(keys_[slot]), counts_[slot] + other_count);
+    }
+    for (size_t slot = 0; slot < other_ptr->keys_.size(); ++slot) {
+      if (!slots_.contains(other_ptr->keys_[slot])) {
+        merged.emplace_back(std::move(other_ptr->keys_[slot]),
+                            other_ptr->counts_[slot] + min_count);
+      }
+    }
+    num_inputs_ += other_ptr->GetNumInputs();
+    other_ptr->output_consumed_ = true;
+
+    // Keep the k keys with the largest counts.
+    if (merged.size() > k_) {
+      std::nth_element(merged.begin(), merged.begin() + k_, merged.end(),
+                       [](const auto& a, const auto& b) {
+                         return a.second > b.second;
+                       });
+      merged.resize(k_);
+    }
+    Clear();
+    for (auto& [key, count] : merged) {
+      Add(key, count);
+    }
+    return TFF_STATUS(OK);
+  }
+
+  Status AggregateTensors(InputTensorList tensors) override {
+    TFF_CHECK(tensors.size() == 1)
+        << "TopKAggregator should operate on a single key tensor.";
+    const Tensor* keys = tensors[0];
+    if (keys->dtype() != dtype_) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKAggregator::AggregateTensors: dtype mismatch for the key "
+                "tensor.";
+    }
+    if (!keys->is_dense()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKAggregator::AggregateTensors: Only dense key tensors are "
+                "supported.";
+    }
+    for (const T& key : keys->AsSpan<T>()) {
+      Add(key, 1);
+    }
+    num_inputs_++;
+    return TFF_STATUS(OK);
+  }
+
+  Status CheckValid() const override {
+    if (output_consumed_) {
+      return TFF_STATUS(FAILED_PRECONDITION)
+             << "TopKAggregator::CheckValid: Output has already been "
+                "consumed.";
+    }
+    return TFF_STATUS(OK);
+  }
+
+  OutputTensorList TakeOutputs() && override {
+    output_consumed_ = true;
+    std::vector<size_t> order(keys_.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      if (counts_[a] != counts_[b]) return counts_[a] > counts_[b];
+      return keys_[a] < keys_[b];
+    });
+    std::vector<Key> keys;
+    keys.reserve(order.size());
+    auto counts = std::make_unique<MutableVectorData<int64_t>>();
+    counts->reserve(order.size());
+    for (size_t slot : order) {
+      keys.push_back(std::move(keys_[slot]));
+      counts->push_back(counts_[slot]);
+    }
+    TensorShape shape{static_cast<int64_t>(order.size())};
+    OutputTensorList outputs = std::vector<Tensor>();
+    outputs.push_back(CreateKeysTensor(keys).value());
+    outputs.push_back(
+        Tensor::Create(DT_INT64, shape, std::move(counts)).value());
+    return outputs;
+  }
+
+  int GetNumInputs() const override { return num_inputs_; }
+
+  size_t GetMemoryUsage() const override {
+    size_t memory_usage =
+        slots_.capacity() * (sizeof(std::pair<Key, size_t>) + sizeof(uint8_t)) +
+        keys_.capacity() * sizeof(Key) + counts_.capacity() * sizeof(int64_t) +
+        (heap_.capacity() + positions_.capacity()) * sizeof(size_t);
+    if constexpr (std::is_same_v<T, string_view>) {
+      // Both the keys and the map hold a copy of each string.
+      for (const Key& key : keys_) {
+        memory_usage += 2 * key.capacity();
+      }
+    }
+    return memory_usage;
+  }
+
+  StatusOr<Tensor> CreateKeysTensor(const std::vector<Key>& keys) const {
+    TensorShape shape{static_cast<int64_t>(keys.size())};
+    if constexpr (std::is_same_v<T, string_view>) {
+      std::vector<string_view> views(keys.begin(), keys.end());
+      return Tensor::Create(dtype_, shape,
+                            std::make_unique<ContiguousStringData>(views));
+    } else {
+      return Tensor::Create(
+          dtype_, shape,
+          std::make_unique<MutableVectorData<T>>(keys.begin(), keys.end()));
+    }
+  }
+
+  // Returns the smallest tracked count if the sketch is full, and 0 otherwise.
+  int64_t MinCountIfFull() const {
+    return keys_.size() < k_ ? 0 : counts_[heap_[0]];
+  }
+
+  void Clear() {
+    slots_.clear();
+    keys_.clear();
+    counts_.clear();
+    heap_.clear();
+    positions_.clear();
+  }
+
+  // The slots are kept in a binary min-heap by count, so that the key to
+  // replace is found in O(1) and a count is updated in O(log k).
+  bool Less(size_t i, size_t j) const {
+    return counts_[heap_[i]] < counts_[heap_[j]];
+  }
+
+  void Swap(size_t i, size_t j) {
+    std::swap(heap_[i], heap_[j]);
+    positions_[heap_[i]] = i;
+    positions_[heap_[j]] = j;
+  }
+
+  void SiftUp(size_t i) {
+    while (i > 0) {
+      size_t parent = (i - 1) / 2;
+      if (!Less(i, parent)) break;
+      Swap(i, parent);
+      i = parent;
+    }
+  }
+
+  void SiftDown(size_t i) {
+    while (true) {
+      size_t smallest = i;
+      size_t left = 2 * i + 1;
+      size_t right = left + 1;
+      if (left < heap_.size() && Less(left, smallest)) smallest = left;
+      if (right < heap_.size() && Less(right, smallest)) smallest = right;
+      if (smallest == i) break;
+      Swap(i, smallest);
+      i = smallest;
+    }
+  }
+
+  bool output_consumed_ = false;
+  const DataType dtype_;
+  const size_t k_;
+  int num_inputs_;
+  // Maps each tracked key to its slot in `keys_` and `counts_`.
+  absl::flat_hash_map<Key, size_t> slots_;
+  std::vector<Key> keys_;
+  std::vector<int64_t> counts_;
+  // The slots ordered as a min-heap by count, and the position of each slot
+  // in the heap.
+  std::vector<size_t> heap_;
+  std::vector<size_t> positions_;
+};
+
+// Factory class for the TopKAggregator.
+class TopKFactory final : public TensorAggregatorFactory {
+ public:
+  TopKFactory() = default;
+
+  // TopKFactory isn't copyable or moveable.
+  TopKFactory(const TopKFactory&) = delete;
+  TopKFactory& operator=(const TopKFactory&) = delete;
+
+  StatusOr<std::unique_ptr<TensorAggregator>> Create(
+      const Intrinsic& intrinsic) const override {
+    return CreateInternal(intrinsic, nullptr);
+  }
+
+  StatusOr<std::unique_ptr<TensorAggregator>> Deserialize(
+      const Intrinsic& intrinsic, std::string serialized_state) const override {
+    TopKAggregatorState aggregator_state;
+    if (!aggregator_state.ParseFromString(serialized_state)) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory::Deserialize: Failed to parse "
+                "TopKAggregatorState.";
+    }
+    return CreateInternal(intrinsic, &aggregator_state);
+  }
+
+ private:
+  template <typename T>
+  static StatusOr<std::unique_ptr<TensorAggregator>> CreateTopK(
+      DataType dtype, size_t k, const TopKAggregatorState* aggregator_state) {
+    if (aggregator_state == nullptr) {
+      return std::make_unique<TopKAggregator<T>>(dtype, k);
+    }
+    TFF_ASSIGN_OR_RETURN(Tensor keys,
+                         Tensor::FromProto(aggregator_state->keys()));
+    std::unique_ptr<MutableVectorData<int64_t>> counts =
+        MutableVectorData<int64_t>::CreateFromEncodedContent(
+            aggregator_state->counts());
+    if (keys.dtype() != dtype || keys.num_elements() != counts->size() ||
+        counts->size() > k) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory::Deserialize: The serialized keys and counts "
+                "don't match the intrinsic.";
+    }
+    auto aggregator = std::make_unique<TopKAggregator<T>>(
+        dtype, k, aggregator_state->num_inputs());
+    absl::Span<const T> key_values = keys.AsSpan<T>();
+    for (size_t i = 0; i < key_values.size(); ++i) {
+      aggregator->Add(key_values[i], (*counts)[i]);
+    }
+    return aggregator;
+  }
+
+  StatusOr<std::unique_ptr<TensorAggregator>> CreateInternal(
+      const Intrinsic& intrinsic,
+      const TopKAggregatorState* aggregator_state) const {
+    // Check that the configuration is valid.
+    if (kTopKUri != intrinsic.uri) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: Expected intrinsic URI " << kTopKUri
+             << " but got uri " << intrinsic.uri;
+    }
+    if (intrinsic.inputs.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: Exactly one key input is expected.";
+    }
+    if (intrinsic.outputs.size() != 2) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: Exactly two outputs, the keys and their counts, "
+                "are expected.";
+    }
+    if (!intrinsic.nested_intrinsics.empty()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: Expected no nested intrinsics.";
+    }
+    if (intrinsic.parameters.size() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: Expected exactly one parameter, k.";
+    }
+
+    const TensorSpec& input_spec = intrinsic.inputs[0];
+    const TensorSpec& key_output_spec = intrinsic.outputs[0];
+    const TensorSpec& count_output_spec = intrinsic.outputs[1];
+    if (input_spec.shape() != TensorShape{-1}) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: The key input must be one-dimensional and of "
+                "unknown size.";
+    }
+    if (key_output_spec.dtype() != input_spec.dtype() ||
+        key_output_spec.shape() != input_spec.shape()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: Key input tensor and key output tensor have "
+                "mismatched specs.";
+    }
+    if (count_output_spec.dtype() != DT_INT64 ||
+        count_output_spec.shape() != input_spec.shape()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: The count output must be a DT_INT64 tensor of "
+                "the same shape as the key input.";
+    }
+
+    const Tensor& k_tensor = intrinsic.parameters[0];
+    if (internal::GetTypeKind(k_tensor.dtype()) !=
+            internal::TypeKind::kNumeric ||
+        k_tensor.num_elements() != 1) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: k must be a numerical scalar.";
+    }
+    int64_t k = k_tensor.CastToScalar<int64_t>();
+    if (k <= 0) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "TopKFactory: k must be positive.";
+    }
+
+    StatusOr<std::unique_ptr<TensorAggregator>> aggregator;
+    DTYPE_CASES(input_spec.dtype(), T,
+                aggregator = (CreateTopK<T>(input_spec.dtype(), k,
+                                            aggregator_state)));
+    return aggregator;
+  }
+};
+
+REGISTER_AGGREGATOR_FACTORY(std::string(kTopKUri), TopKFactory);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
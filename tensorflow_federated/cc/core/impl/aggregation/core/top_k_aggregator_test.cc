@@ -0,0 +1,258 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/fedsql_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator_registry.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Eq;
+using ::testing::HasSubstr;
+using testing::IsFalse;
+using testing::IsTrue;
+using testing::TestWithParam;
+
+using TopKAggregatorTest = TestWithParam<bool>;
+
+Intrinsic CreateTopKIntrinsic(DataType dtype, int64_t k) {
+  Intrinsic intrinsic{kTopKUri,
+                      {TensorSpec{"key", dtype, {-1}}},
+                      {TensorSpec{"key_out", dtype, {-1}},
+                       TensorSpec{"count_out", DT_INT64, {-1}}},
+                      {},
+                      {}};
+  intrinsic.parameters.push_back(
+      Tensor::Create(DT_INT64, {}, CreateTestData<int64_t>({k})).value());
+  return intrinsic;
+}
+
+Tensor CreateInt64Keys(std::vector<int64_t> keys) {
+  TensorShape shape{static_cast<int64_t>(keys.size())};
+  return Tensor::Create(DT_INT64, shape,
+                        std::make_unique<MutableVectorData<int64_t>>(
+                            keys.begin(), keys.end()))
+      .value();
+}
+
+// Serializes and deserializes the aggregator if `serialize` is true.
+void MaybeSerialize(bool serialize, const Intrinsic& intrinsic,
+                    std::unique_ptr<TensorAggregator>& aggregator) {
+  if (serialize) {
+    auto serialized_state = std::move(*aggregator).Serialize();
+    aggregator =
+        DeserializeTensorAggregator(intrinsic, serialized_state.value())
+            .value();
+  }
+}
+
+TEST_P(TopKAggregatorTest, FewerKeysThanK_CountsAreExact) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_INT64, 5);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  EXPECT_THAT(aggregator->Accumulate(CreateInt64Keys({1, 2, 1})), IsOk());
+  MaybeSerialize(GetParam(), intrinsic, aggregator);
+  EXPECT_THAT(aggregator->Accumulate(CreateInt64Keys({3, 1, 2})), IsOk());
+  EXPECT_THAT(aggregator->CanReport(), IsTrue());
+  EXPECT_THAT(aggregator->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(aggregator->CanReport(), IsFalse());
+  ASSERT_THAT(result->size(), Eq(2));
+  EXPECT_THAT(result.value()[0], IsTensor<int64_t>({3}, {1, 2, 3}));
+  EXPECT_THAT(result.value()[1], IsTensor<int64_t>({3}, {3, 2, 1}));
+}
+
+TEST_P(TopKAggregatorTest, MoreKeysThanK_KeepsHeavyHitters) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_INT64, 3);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  std::vector<int64_t> keys(20, 7);
+  keys.insert(keys.end(), 15, 8);
+  EXPECT_THAT(aggregator->Accumulate(CreateInt64Keys(keys)), IsOk());
+  MaybeSerialize(GetParam(), intrinsic, aggregator);
+  // The remaining slot is taken by each rare key in turn, and the last of
+  // them inherits the counts of the others.
+  std::vector<int64_t> rare_keys;
+  for (int64_t key = 100; key < 110; ++key) rare_keys.push_back(key);
+  EXPECT_THAT(aggregator->Accumulate(CreateInt64Keys(rare_keys)), IsOk());
+
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<int64_t>({3}, {7, 8, 109}));
+  EXPECT_THAT(result.value()[1], IsTensor<int64_t>({3}, {20, 15, 10}));
+}
+
+TEST_P(TopKAggregatorTest, StringKeys_Succeeds) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_STRING, 2);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  Tensor t1 =
+      Tensor::Create(DT_STRING, {4},
+                     CreateTestData<string_view>({"a", "b", "a", "c"}))
+          .value();
+  Tensor t2 =
+      Tensor::Create(DT_STRING, {2}, CreateTestData<string_view>({"a", "b"}))
+          .value();
+  EXPECT_THAT(aggregator->Accumulate(t1), IsOk());
+  MaybeSerialize(GetParam(), intrinsic, aggregator);
+  EXPECT_THAT(aggregator->Accumulate(t2), IsOk());
+
+  // "c" replaces "b" with a count of 2, and "b" then replaces "c" with a
+  // count of 3.
+  auto result = std::move(*aggregator).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<string_view>({2}, {"a", "b"}));
+  EXPECT_THAT(result.value()[1], IsTensor<int64_t>({2}, {3, 3}));
+}
+
+TEST_P(TopKAggregatorTest, Merge_Succeeds) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_INT64, 5);
+  auto aggregator1 = CreateTensorAggregator(intrinsic).value();
+  auto aggregator2 = CreateTensorAggregator(intrinsic).value();
+  EXPECT_THAT(aggregator1->Accumulate(CreateInt64Keys({1, 1, 2})), IsOk());
+  EXPECT_THAT(aggregator2->Accumulate(CreateInt64Keys({2, 3, 3, 3})), IsOk());
+  MaybeSerialize(GetParam(), intrinsic, aggregator1);
+  MaybeSerialize(GetParam(), intrinsic, aggregator2);
+
+  EXPECT_THAT(aggregator1->MergeWith(std::move(*aggregator2)), IsOk());
+  EXPECT_THAT(aggregator2->CanReport(), IsFalse());
+  EXPECT_THAT(aggregator1->GetNumInputs(), Eq(2));
+
+  auto result = std::move(*aggregator1).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<int64_t>({3}, {3, 1, 2}));
+  EXPECT_THAT(result.value()[1], IsTensor<int64_t>({3}, {3, 2, 2}));
+}
+
+TEST_P(TopKAggregatorTest, MergeFullSketches_AddsSmallestCounts) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_INT64, 2);
+  auto aggregator1 = CreateTensorAggregator(intrinsic).value();
+  auto aggregator2 = CreateTensorAggregator(intrinsic).value();
+  EXPECT_THAT(aggregator1->Accumulate(CreateInt64Keys({1, 1, 1, 2})), IsOk());
+  EXPECT_THAT(aggregator2->Accumulate(CreateInt64Keys({3, 3, 4})), IsOk());
+  MaybeSerialize(GetParam(), intrinsic, aggregator1);
+  MaybeSerialize(GetParam(), intrinsic, aggregator2);
+
+  // Each key missing from the other sketch may have occurred there up to the
+  // smallest count of that sketch, which is 1 for both.
+  EXPECT_THAT(aggregator1->MergeWith(std::move(*aggregator2)), IsOk());
+  auto result = std::move(*aggregator1).Report();
+  EXPECT_THAT(result, IsOk());
+  EXPECT_THAT(result.value()[0], IsTensor<int64_t>({2}, {1, 3}));
+  EXPECT_THAT(result.value()[1], IsTensor<int64_t>({2}, {4, 3}));
+}
+
+TEST(TopKAggregatorErrorTest, Merge_IncompatibleAggregator_Fails) {
+  auto aggregator1 =
+      CreateTensorAggregator(CreateTopKIntrinsic(DT_INT64, 2)).value();
+  auto aggregator2 =
+      CreateTensorAggregator(CreateTopKIntrinsic(DT_INT32, 2)).value();
+  auto aggregator3 =
+      CreateTensorAggregator(CreateTopKIntrinsic(DT_INT64, 3)).value();
+  Status s = aggregator1->MergeWith(std::move(*aggregator2));
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("same key type"));
+  s = aggregator1->MergeWith(std::move(*aggregator3));
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("same size"));
+}
+
+TEST(TopKAggregatorErrorTest, Accumulate_WrongDtype_Fails) {
+  auto aggregator =
+      CreateTensorAggregator(CreateTopKIntrinsic(DT_INT32, 2)).value();
+  Status s = aggregator->Accumulate(CreateInt64Keys({1}));
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("dtype mismatch"));
+}
+
+TEST(TopKAggregatorErrorTest, Create_NonPositiveK_Fails) {
+  Status s = CreateTensorAggregator(CreateTopKIntrinsic(DT_INT64, 0)).status();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("k must be positive"));
+}
+
+TEST(TopKAggregatorErrorTest, Create_MissingK_Fails) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_INT64, 2);
+  intrinsic.parameters.clear();
+  Status s = CreateTensorAggregator(intrinsic).status();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("Expected exactly one parameter"));
+}
+
+TEST(TopKAggregatorErrorTest, Create_WrongCountOutputType_Fails) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_INT64, 2);
+  intrinsic.outputs[1] = TensorSpec{"count_out", DT_INT32, {-1}};
+  Status s = CreateTensorAggregator(intrinsic).status();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("count output must be a DT_INT64"));
+}
+
+TEST(TopKAggregatorErrorTest, Create_MismatchedKeyOutput_Fails) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_INT64, 2);
+  intrinsic.outputs[0] = TensorSpec{"key_out", DT_STRING, {-1}};
+  Status s = CreateTensorAggregator(intrinsic).status();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("mismatched specs"));
+}
+
+TEST(TopKAggregatorMemoryTest, MemoryUsageIsBoundedByK) {
+  Intrinsic intrinsic = CreateTopKIntrinsic(DT_INT64, 2);
+  auto aggregator = CreateTensorAggregator(intrinsic).value();
+  EXPECT_THAT(aggregator->Accumulate(CreateInt64Keys({1, 2})), IsOk());
+  size_t memory_usage = aggregator->GetMemoryUsage();
+  EXPECT_GT(memory_usage, 0);
+  // Keys beyond the k tracked ones replace existing keys.
+  EXPECT_THAT(aggregator->Accumulate(CreateInt64Keys({3, 4, 5, 6})), IsOk());
+  EXPECT_THAT(aggregator->GetMemoryUsage(), Eq(memory_usage));
+}
+
+TEST(TopKAggregatorErrorTest, Deserialize_FailToParseProto) {
+  Status s = DeserializeTensorAggregator(CreateTopKIntrinsic(DT_INT64, 2),
+                                         "invalid_state")
+                 .status();
+  EXPECT_THAT(s, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(s.message(), HasSubstr("Failed to parse"));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    TopKAggregatorTestInstantiation, TopKAggregatorTest,
+    testing::ValuesIn<bool>({false, true}),
+    [](const testing::TestParamInfo<TopKAggregatorTest::ParamType>& info) {
+      return info.param ? "SerializeDeserialize" : "None";
+    });
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
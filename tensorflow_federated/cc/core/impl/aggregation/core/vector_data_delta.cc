@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_data_delta.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+Status ApplyVectorDataDelta(const VectorDataDelta& delta,
+                            std::string& vector_data) {
+  for (const VectorDataDelta::Chunk& chunk : delta.chunks()) {
+    if (chunk.offset() > delta.byte_size() ||
+        chunk.data().size() > delta.byte_size() - chunk.offset()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "ApplyVectorDataDelta: chunk at offset " << chunk.offset()
+             << " is out of the bounds of the vector data.";
+    }
+  }
+  vector_data.resize(delta.byte_size());
+  for (const VectorDataDelta::Chunk& chunk : delta.chunks()) {
+    vector_data.replace(chunk.offset(), chunk.data().size(), chunk.data());
+  }
+  return TFF_STATUS(OK);
+}
+
+StatusOr<std::string> CompactAggVectorAggregatorState(
+    std::string serialized_state,
+    const std::vector<std::string>& serialized_deltas) {
+  AggVectorAggregatorState aggregator_state;
+  if (!aggregator_state.ParseFromString(serialized_state)) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "CompactAggVectorAggregatorState: Failed to parse the "
+              "AggVectorAggregatorState.";
+  }
+  for (const std::string& serialized_delta : serialized_deltas) {
+    AggVectorAggregatorDelta delta;
+    if (!delta.ParseFromString(serialized_delta)) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "CompactAggVectorAggregatorState: Failed to parse the "
+                "AggVectorAggregatorDelta.";
+    }
+    TFF_RETURN_IF_ERROR(ApplyVectorDataDelta(
+        delta.vector_data(), *aggregator_state.mutable_vector_data()));
+    aggregator_state.set_num_inputs(delta.num_inputs());
+  }
+  return aggregator_state.SerializeAsString();
+}
+
+Status ApplyOneDimGroupingAggregatorDelta(
+    const OneDimGroupingAggregatorDelta& delta,
+    OneDimGroupingAggregatorState& aggregator_state) {
+  TFF_RETURN_IF_ERROR(ApplyVectorDataDelta(
+      delta.vector_data(), *aggregator_state.mutable_vector_data()));
+  aggregator_state.set_num_inputs(delta.num_inputs());
+  return TFF_STATUS(OK);
+}
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
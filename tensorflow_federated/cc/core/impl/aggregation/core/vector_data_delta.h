@@ -0,0 +1,132 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_VECTOR_DATA_DELTA_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_VECTOR_DATA_DELTA_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+
+// Tracks the chunks of the vector data of an aggregator that have changed
+// since the last snapshot of its state, so that only these chunks have to be
+// encoded in the next VectorDataDelta.
+//
+// The vector data is split into chunks of `chunk_size` elements. Elements
+// appended to the vector data after the last snapshot are always part of the
+// next delta, so the first delta holds the whole vector data.
+//
+// This class is not thread safe.
+class VectorDataChangeTracker {
+ public:
+  // Default number of elements in each tracked chunk.
+  static constexpr size_t kDefaultChunkSize = 1 << 12;
+
+  explicit VectorDataChangeTracker(size_t chunk_size = kDefaultChunkSize)
+      : chunk_size_(chunk_size) {
+    TFF_CHECK(chunk_size > 0) << "chunk_size must be positive";
+  }
+
+  // Marks the element at `index` as changed.
+  void MarkChanged(size_t index) {
+    const size_t chunk = index / chunk_size_;
+    if (chunk >= changed_chunks_.size()) {
+      changed_chunks_.resize(chunk + 1, false);
+    }
+    changed_chunks_[chunk] = true;
+  }
+
+  // Marks all elements as changed.
+  void MarkAllChanged() { all_changed_ = true; }
+
+  // Encodes the chunks of `data` that have changed since the previous call,
+  // and starts tracking changes from the current content of `data`.
+  // Consecutive changed chunks are encoded as a single VectorDataDelta chunk.
+  template <typename T>
+  VectorDataDelta TakeDelta(const std::vector<T>& data) {
+    VectorDataDelta delta;
+    delta.set_byte_size(data.size() * sizeof(T));
+    const char* bytes = reinterpret_cast<const char*>(data.data());
+    const size_t num_chunks = (data.size() + chunk_size_ - 1) / chunk_size_;
+    size_t chunk = 0;
+    while (chunk < num_chunks) {
+      if (!IsChanged(chunk, data.size())) {
+        ++chunk;
+        continue;
+      }
+      const size_t begin = chunk * chunk_size_;
+      while (chunk < num_chunks && IsChanged(chunk, data.size())) {
+        ++chunk;
+      }
+      const size_t end = std::min(chunk * chunk_size_, data.size());
+      VectorDataDelta::Chunk* delta_chunk = delta.add_chunks();
+      delta_chunk->set_offset(begin * sizeof(T));
+      delta_chunk->set_data(bytes + begin * sizeof(T),
+                            (end - begin) * sizeof(T));
+    }
+    snapshot_size_ = data.size();
+    all_changed_ = false;
+    changed_chunks_.clear();
+    return delta;
+  }
+
+ private:
+  // Returns true if the given chunk of a vector data of `size` elements has
+  // changed, or has new elements since the last snapshot.
+  bool IsChanged(size_t chunk, size_t size) const {
+    const size_t end = std::min((chunk + 1) * chunk_size_, size);
+    return all_changed_ || end > snapshot_size_ ||
+           (chunk < changed_chunks_.size() && changed_chunks_[chunk]);
+  }
+
+  size_t chunk_size_;
+  // Number of elements of the vector data at the last snapshot.
+  size_t snapshot_size_ = 0;
+  bool all_changed_ = false;
+  std::vector<bool> changed_chunks_;
+};
+
+// Applies `delta` to `vector_data`, the encoded vector data at the time of the
+// snapshot preceding the delta.
+Status ApplyVectorDataDelta(const VectorDataDelta& delta,
+                            std::string& vector_data);
+
+// Compacts a serialized AggVectorAggregatorState and the serialized
+// AggVectorAggregatorDelta that followed it, in order, into the serialized
+// AggVectorAggregatorState at the time of the last delta. `serialized_state`
+// may be empty if the first delta is the first one taken from the aggregator,
+// since that delta holds the whole state.
+StatusOr<std::string> CompactAggVectorAggregatorState(
+    std::string serialized_state,
+    const std::vector<std::string>& serialized_deltas);
+
+// Applies `delta` to the state of a OneDimGroupingAggregator at the time of the
+// snapshot preceding the delta.
+Status ApplyOneDimGroupingAggregatorDelta(
+    const OneDimGroupingAggregatorDelta& delta,
+    OneDimGroupingAggregatorState& aggregator_state);
+
+}  // namespace aggregation
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_CORE_VECTOR_DATA_DELTA_H_
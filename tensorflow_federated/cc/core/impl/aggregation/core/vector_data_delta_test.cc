@@ -0,0 +1,159 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/core/vector_data_delta.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/agg_core.pb.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace aggregation {
+namespace {
+
+using ::testing::Eq;
+
+std::string Encode(const std::vector<int32_t>& values) {
+  return std::string(reinterpret_cast<const char*>(values.data()),
+                     values.size() * sizeof(int32_t));
+}
+
+TEST(VectorDataChangeTrackerTest, FirstDeltaHoldsAllData) {
+  VectorDataChangeTracker tracker(2);
+  std::vector<int32_t> data = {1, 2, 3, 4, 5};
+  VectorDataDelta delta = tracker.TakeDelta(data);
+  EXPECT_THAT(delta.byte_size(), Eq(5 * sizeof(int32_t)));
+  ASSERT_THAT(delta.chunks_size(), Eq(1));
+  EXPECT_THAT(delta.chunks(0).offset(), Eq(0));
+  EXPECT_THAT(delta.chunks(0).data(), Eq(Encode(data)));
+}
+
+TEST(VectorDataChangeTrackerTest, UnchangedDataHasNoChunks) {
+  VectorDataChangeTracker tracker(2);
+  std::vector<int32_t> data = {1, 2, 3, 4};
+  tracker.TakeDelta(data);
+  VectorDataDelta delta = tracker.TakeDelta(data);
+  EXPECT_THAT(delta.byte_size(), Eq(4 * sizeof(int32_t)));
+  EXPECT_THAT(delta.chunks_size(), Eq(0));
+}
+
+TEST(VectorDataChangeTrackerTest, OnlyChangedChunks) {
+  VectorDataChangeTracker tracker(2);
+  std::vector<int32_t> data = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  tracker.TakeDelta(data);
+  data[1] = 10;
+  data[4] = 14;
+  data[5] = 15;
+  data[6] = 16;
+  tracker.MarkChanged(1);
+  tracker.MarkChanged(4);
+  tracker.MarkChanged(5);
+  tracker.MarkChanged(6);
+  VectorDataDelta delta = tracker.TakeDelta(data);
+  // Chunks [0, 2) and [4, 8), the latter made of two adjacent chunks.
+  ASSERT_THAT(delta.chunks_size(), Eq(2));
+  EXPECT_THAT(delta.chunks(0).offset(), Eq(0));
+  EXPECT_THAT(delta.chunks(0).data(), Eq(Encode({0, 10})));
+  EXPECT_THAT(delta.chunks(1).offset(), Eq(4 * sizeof(int32_t)));
+  EXPECT_THAT(delta.chunks(1).data(), Eq(Encode({14, 15, 16, 7})));
+}
+
+TEST(VectorDataChangeTrackerTest, IncludesAppendedElements) {
+  VectorDataChangeTracker tracker(2);
+  std::vector<int32_t> data = {0, 1, 2, 3};
+  tracker.TakeDelta(data);
+  data.push_back(4);
+  data.push_back(5);
+  data.push_back(6);
+  VectorDataDelta delta = tracker.TakeDelta(data);
+  ASSERT_THAT(delta.chunks_size(), Eq(1));
+  EXPECT_THAT(delta.chunks(0).offset(), Eq(4 * sizeof(int32_t)));
+  EXPECT_THAT(delta.chunks(0).data(), Eq(Encode({4, 5, 6})));
+}
+
+TEST(VectorDataChangeTrackerTest, MarkAllChanged) {
+  VectorDataChangeTracker tracker(2);
+  std::vector<int32_t> data = {0, 1, 2};
+  tracker.TakeDelta(data);
+  tracker.MarkAllChanged();
+  VectorDataDelta delta = tracker.TakeDelta(data);
+  ASSERT_THAT(delta.chunks_size(), Eq(1));
+  EXPECT_THAT(delta.chunks(0).data(), Eq(Encode(data)));
+}
+
+TEST(ApplyVectorDataDeltaTest, AppliesDeltas) {
+  VectorDataChangeTracker tracker(2);
+  std::vector<int32_t> data = {0, 1, 2, 3, 4};
+  std::string vector_data;
+  EXPECT_THAT(ApplyVectorDataDelta(tracker.TakeDelta(data), vector_data),
+              IsOk());
+  EXPECT_THAT(vector_data, Eq(Encode(data)));
+
+  data[3] = 13;
+  tracker.MarkChanged(3);
+  data.push_back(5);
+  EXPECT_THAT(ApplyVectorDataDelta(tracker.TakeDelta(data), vector_data),
+              IsOk());
+  EXPECT_THAT(vector_data, Eq(Encode(data)));
+}
+
+TEST(ApplyVectorDataDeltaTest, ChunkOutOfBounds) {
+  VectorDataDelta delta;
+  delta.set_byte_size(8);
+  VectorDataDelta::Chunk* chunk = delta.add_chunks();
+  chunk->set_offset(4);
+  chunk->set_data(std::string(8, 'x'));
+  std::string vector_data(8, 'a');
+  EXPECT_THAT(ApplyVectorDataDelta(delta, vector_data),
+              StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(vector_data, Eq(std::string(8, 'a')));
+}
+
+TEST(CompactAggVectorAggregatorStateTest, CompactsDeltas) {
+  VectorDataChangeTracker tracker(2);
+  std::vector<int32_t> data = {1, 2, 3, 4};
+  AggVectorAggregatorDelta delta1;
+  delta1.set_num_inputs(1);
+  *delta1.mutable_vector_data() = tracker.TakeDelta(data);
+  data[0] = 11;
+  tracker.MarkChanged(0);
+  AggVectorAggregatorDelta delta2;
+  delta2.set_num_inputs(2);
+  *delta2.mutable_vector_data() = tracker.TakeDelta(data);
+
+  StatusOr<std::string> serialized_state = CompactAggVectorAggregatorState(
+      "", {delta1.SerializeAsString(), delta2.SerializeAsString()});
+  ASSERT_THAT(serialized_state, IsOk());
+  AggVectorAggregatorState aggregator_state;
+  ASSERT_TRUE(aggregator_state.ParseFromString(*serialized_state));
+  EXPECT_THAT(aggregator_state.num_inputs(), Eq(2));
+  EXPECT_THAT(aggregator_state.vector_data(), Eq(Encode(data)));
+}
+
+TEST(CompactAggVectorAggregatorStateTest, InvalidDelta) {
+  EXPECT_THAT(CompactAggVectorAggregatorState("", {"invalid"}),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace aggregation
+}  // namespace tensorflow_federated
@@ -86,6 +86,15 @@ class AggregationProtocol {
   virtual absl::Status ReceiveClientMessage(int64_t client_id,
                                             const ClientMessage& message) = 0;
 
+  // Same as above, but allows the implementation to take over the content of
+  // the message, e.g. to aggregate a large inline input without copying it.
+  // The default implementation handles the message as a const reference.
+  virtual absl::Status ReceiveClientMessage(int64_t client_id,
+                                            ClientMessage&& message) {
+    return ReceiveClientMessage(client_id,
+                                static_cast<const ClientMessage&>(message));
+  }
+
   // Checks for outgoing messages to a given client.
   //
   // Returns a non-ok status if there is an error requiring the protocol to
@@ -16,7 +16,11 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_aggregator.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <utility>
@@ -26,9 +30,20 @@
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/numa.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/group_by_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/input_tensor_list.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
@@ -41,24 +56,34 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/config_converter.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/configuration.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/cord_reader.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/tensor_binding_plan.h"
 
 namespace tensorflow_federated {
 namespace aggregation {
 
 // Forward declaration of implementation utilities.
 namespace {
-using TensorMap = absl::flat_hash_map<std::string, Tensor>;
-absl::Status AddInputsToMap(const Intrinsic& intrinsic,
-                            CheckpointParser& parser, TensorMap& tensor_map);
-size_t CountInputs(const Intrinsic& intrinsic);
-absl::StatusOr<size_t> PopulateInputs(const Intrinsic& intrinsic,
-                                      const TensorMap& tensor_map, size_t index,
-                                      InputTensorList& inputs);
+void AddInputsToLayout(
+    const Intrinsic& intrinsic,
+    absl::flat_hash_map<std::string, size_t>& tensor_indices,
+    std::vector<const TensorSpec*>& tensor_specs,
+    std::vector<std::pair<size_t, const TensorSpec*>>& aliased_specs,
+    std::vector<size_t>& inputs);
+bool MatchesSpec(const Tensor& tensor, const TensorSpec& spec);
+InputTensorList GatherInputs(absl::Span<const Tensor> tensors,
+                             const std::vector<size_t>& input_indices);
 absl::StatusOr<int> AddOutputsToCheckpoint(
-    const Intrinsic& intrinsic, const OutputTensorList& outputs,
-    int output_index, CheckpointBuilder& checkpoint_builder);
+    const Intrinsic& intrinsic, OutputTensorList& outputs, int output_index,
+    CheckpointBuilder& checkpoint_builder);
 absl::Status CheckCompatible(const std::vector<Intrinsic>& intrinsics,
                              const std::vector<Intrinsic>& other);
+absl::StatusOr<CheckpointAggregatorState> ParseAggregatorState(
+    const absl::Cord& serialized_state);
+
+// Tag of the length delimited CheckpointAggregatorState aggregators field
+// (field number 1).
+constexpr uint32_t kAggregatorsTag = (1 << 3) | 2;
 }  // namespace
 
 absl::Status CheckpointAggregator::ValidateConfig(
@@ -67,92 +92,186 @@ absl::Status CheckpointAggregator::ValidateConfig(
 }
 
 absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
-CheckpointAggregator::Create(const Configuration& configuration) {
-  return CreateInternal(configuration, nullptr);
+CheckpointAggregator::Create(const Configuration& configuration,
+                             int num_shards, int num_numa_nodes) {
+  return CreateInternal(configuration, nullptr, num_shards, num_numa_nodes);
 }
 
 absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
-CheckpointAggregator::Create(const std::vector<Intrinsic>* intrinsics) {
-  return CreateInternal(intrinsics, nullptr);
+CheckpointAggregator::Create(const std::vector<Intrinsic>* intrinsics,
+                             int num_shards, int num_numa_nodes) {
+  return CreateInternal(intrinsics, nullptr, num_shards, num_numa_nodes);
 }
 
 absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
 CheckpointAggregator::Deserialize(const Configuration& configuration,
-                                  std::string serialized_state) {
+                                  std::string serialized_state,
+                                  int num_shards) {
   CheckpointAggregatorState aggregator_state;
   if (!aggregator_state.ParseFromString(serialized_state)) {
     return absl::InvalidArgumentError("Failed to parse serialized state.");
   }
-  return CreateInternal(configuration, &aggregator_state);
+  return CreateInternal(configuration, &aggregator_state, num_shards);
 }
 
 absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
 CheckpointAggregator::Deserialize(const std::vector<Intrinsic>* intrinsics,
-                                  std::string serialized_state) {
+                                  std::string serialized_state,
+                                  int num_shards) {
   CheckpointAggregatorState aggregator_state;
   if (!aggregator_state.ParseFromString(serialized_state)) {
     return absl::InvalidArgumentError("Failed to parse serialized state.");
   }
-  return CreateInternal(intrinsics, &aggregator_state);
+  return CreateInternal(intrinsics, &aggregator_state, num_shards);
 }
 
 absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
-CheckpointAggregator::CreateInternal(
-    const Configuration& configuration,
-    const CheckpointAggregatorState* aggregator_state) {
-  TFF_ASSIGN_OR_RETURN(std::vector<Intrinsic> intrinsics,
-                       ParseFromConfig(configuration));
+CheckpointAggregator::Deserialize(const Configuration& configuration,
+                                  const absl::Cord& serialized_state,
+                                  int num_shards) {
+  TFF_ASSIGN_OR_RETURN(CheckpointAggregatorState aggregator_state,
+                       ParseAggregatorState(serialized_state));
+  return CreateInternal(configuration, &aggregator_state, num_shards);
+}
+
+absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
+CheckpointAggregator::Deserialize(const std::vector<Intrinsic>* intrinsics,
+                                  const absl::Cord& serialized_state,
+                                  int num_shards) {
+  TFF_ASSIGN_OR_RETURN(CheckpointAggregatorState aggregator_state,
+                       ParseAggregatorState(serialized_state));
+  return CreateInternal(intrinsics, &aggregator_state, num_shards);
+}
 
+absl::StatusOr<std::vector<std::unique_ptr<TensorAggregator>>>
+CheckpointAggregator::CreateAggregators(
+    const std::vector<Intrinsic>& intrinsics,
+    CheckpointAggregatorState* aggregator_state) {
+  if (aggregator_state != nullptr &&
+      aggregator_state->aggregators_size() != intrinsics.size()) {
+    return absl::InvalidArgumentError(
+        "The serialized state doesn't match the number of intrinsics.");
+  }
   std::vector<std::unique_ptr<TensorAggregator>> aggregators;
   for (int i = 0; i < intrinsics.size(); ++i) {
     const Intrinsic& intrinsic = intrinsics[i];
-    const std::string* serialized_aggregator = nullptr;
+    std::string* serialized_aggregator = nullptr;
     if (aggregator_state != nullptr) {
-      serialized_aggregator = &aggregator_state->aggregators(i);
+      serialized_aggregator = aggregator_state->mutable_aggregators(i);
     }
     TFF_ASSIGN_OR_RETURN(std::unique_ptr<TensorAggregator> aggregator,
                          CreateAggregator(intrinsic, serialized_aggregator));
     aggregators.push_back(std::move(aggregator));
   }
+  return aggregators;
+}
 
-  return absl::WrapUnique(
-      new CheckpointAggregator(std::move(intrinsics), std::move(aggregators)));
+absl::StatusOr<std::vector<std::unique_ptr<TensorAggregator>>>
+CheckpointAggregator::CreateShardAggregators(
+    const std::vector<Intrinsic>& intrinsics,
+    CheckpointAggregatorState* aggregator_state, int numa_node,
+    int num_numa_nodes) {
+  if (num_numa_nodes == 1) {
+    return CreateAggregators(intrinsics, aggregator_state);
+  }
+  // The aggregators allocate and initialize their state as they are created,
+  // which places it on the node the thread runs on.
+  ScopedNumaNodeAffinity affinity(numa_node);
+  return CreateAggregators(intrinsics, aggregator_state);
 }
 
-absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
-CheckpointAggregator::CreateInternal(
-    const std::vector<Intrinsic>* intrinsics,
-    const CheckpointAggregatorState* aggregator_state) {
-  std::vector<std::unique_ptr<TensorAggregator>> aggregators;
-  for (int i = 0; i < intrinsics->size(); ++i) {
-    const Intrinsic& intrinsic = (*intrinsics)[i];
-    const std::string* serialized_aggregator = nullptr;
-    if (aggregator_state != nullptr) {
-      serialized_aggregator = &aggregator_state->aggregators(i);
+absl::StatusOr<std::vector<std::unique_ptr<CheckpointAggregator::Shard>>>
+CheckpointAggregator::CreateShards(
+    const std::vector<Intrinsic>& intrinsics,
+    CheckpointAggregatorState* aggregator_state, int num_shards,
+    int num_numa_nodes) {
+  if (num_shards < 1) {
+    return absl::InvalidArgumentError("The number of shards must be positive.");
+  }
+  if (num_numa_nodes < 1 || num_numa_nodes > num_shards) {
+    return absl::InvalidArgumentError(
+        "The number of NUMA nodes must be between 1 and the number of "
+        "shards.");
+  }
+  std::vector<std::unique_ptr<Shard>> shards;
+  for (int i = 0; i < num_shards; ++i) {
+    const int numa_node = i % num_numa_nodes;
+    TFF_ASSIGN_OR_RETURN(
+        std::vector<std::unique_ptr<TensorAggregator>> aggregators,
+        CreateShardAggregators(intrinsics,
+                               i == 0 ? aggregator_state : nullptr, numa_node,
+                               num_numa_nodes));
+    auto shard = std::make_unique<Shard>();
+    shard->numa_node = numa_node;
+    {
+      absl::MutexLock lock(&shard->mu);
+      shard->aggregators = std::move(aggregators);
     }
-    TFF_ASSIGN_OR_RETURN(std::unique_ptr<TensorAggregator> aggregator,
-                         CreateAggregator(intrinsic, serialized_aggregator));
-    aggregators.push_back(std::move(aggregator));
+    shards.push_back(std::move(shard));
   }
+  return shards;
+}
+
+absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
+CheckpointAggregator::CreateInternal(
+    const Configuration& configuration,
+    CheckpointAggregatorState* aggregator_state, int num_shards,
+    int num_numa_nodes) {
+  // Aggregations created from the same configuration share its intrinsics.
+  TFF_ASSIGN_OR_RETURN(std::shared_ptr<const std::vector<Intrinsic>> intrinsics,
+                       ParseFromConfigCached(configuration));
+  TFF_ASSIGN_OR_RETURN(std::vector<std::unique_ptr<Shard>> shards,
+                       CreateShards(*intrinsics, aggregator_state, num_shards,
+                                    num_numa_nodes));
+  return absl::WrapUnique(new CheckpointAggregator(
+      std::move(intrinsics), std::move(shards), num_numa_nodes));
+}
 
-  return absl::WrapUnique(
-      new CheckpointAggregator(intrinsics, std::move(aggregators)));
+absl::StatusOr<std::unique_ptr<CheckpointAggregator>>
+CheckpointAggregator::CreateInternal(
+    const std::vector<Intrinsic>* intrinsics,
+    CheckpointAggregatorState* aggregator_state, int num_shards,
+    int num_numa_nodes) {
+  TFF_ASSIGN_OR_RETURN(std::vector<std::unique_ptr<Shard>> shards,
+                       CreateShards(*intrinsics, aggregator_state, num_shards,
+                                    num_numa_nodes));
+  return absl::WrapUnique(new CheckpointAggregator(
+      intrinsics, std::move(shards), num_numa_nodes));
 }
 
 CheckpointAggregator::CheckpointAggregator(
     const std::vector<Intrinsic>* intrinsics,
-    std::vector<std::unique_ptr<TensorAggregator>> aggregators)
-    : intrinsics_(*intrinsics), aggregators_(std::move(aggregators)) {}
+    std::vector<std::unique_ptr<Shard>> shards, int num_numa_nodes)
+    : intrinsics_(*intrinsics),
+      input_layout_(CreateInputLayout(intrinsics_)),
+      binding_plan_(CreateBindingPlan(input_layout_)),
+      accumulate_latency_(GetLatencyHistograms(intrinsics_, "Accumulate")),
+      report_latency_(GetLatencyHistograms(intrinsics_, "Report")),
+      shards_(std::move(shards)),
+      num_numa_nodes_(num_numa_nodes) {}
 
 CheckpointAggregator::CheckpointAggregator(
-    std::vector<Intrinsic> intrinsics,
-    std::vector<std::unique_ptr<TensorAggregator>> aggregators)
+    std::shared_ptr<const std::vector<Intrinsic>> intrinsics,
+    std::vector<std::unique_ptr<Shard>> shards, int num_numa_nodes)
     : owned_intrinsics_(std::move(intrinsics)),
       intrinsics_(*owned_intrinsics_),
-      aggregators_(std::move(aggregators)) {}
+      input_layout_(CreateInputLayout(intrinsics_)),
+      binding_plan_(CreateBindingPlan(input_layout_)),
+      accumulate_latency_(GetLatencyHistograms(intrinsics_, "Accumulate")),
+      report_latency_(GetLatencyHistograms(intrinsics_, "Report")),
+      shards_(std::move(shards)),
+      num_numa_nodes_(num_numa_nodes) {}
 
 CheckpointAggregator::~CheckpointAggregator() {
   aggregation_finished_ = true;
+  {
+    // Wait for the checkpoints queued by AccumulateAsync, which are now
+    // rejected quickly, to have their callbacks called.
+    absl::MutexLock lock(&async_mu_);
+    async_mu_.Await(absl::Condition(
+        +[](bool* drain_scheduled) { return !*drain_scheduled; },
+        &async_drain_scheduled_));
+  }
   // Enter the lock to ensure that the destructor waits for any ongoing
   // operations that require *this* instance.
   absl::MutexLock lock(&aggregation_mu_);
@@ -160,36 +279,346 @@ CheckpointAggregator::~CheckpointAggregator() {
 
 absl::Status CheckpointAggregator::Accumulate(
     CheckpointParser& checkpoint_parser) {
-  TensorMap tensor_map;
-  for (const auto& intrinsic : intrinsics_) {
-    TFF_RETURN_IF_ERROR(
-        AddInputsToMap(intrinsic, checkpoint_parser, tensor_map));
+  // The tensors only live for the duration of this call, and are kept inline
+  // for typical intrinsics so that gathering them doesn't allocate.
+  InputTensors tensors;
+  TFF_RETURN_IF_ERROR(ParseInputs(checkpoint_parser, tensors));
+  return AccumulateInputs(absl::MakeConstSpan(&tensors, 1));
+}
+
+absl::Status CheckpointAggregator::AccumulateOnNumaNode(
+    CheckpointParser& checkpoint_parser, int numa_node) {
+  if (numa_node < 0 || numa_node >= num_numa_nodes_) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The NUMA node ", numa_node, " is out of range."));
   }
+  InputTensors tensors;
+  TFF_RETURN_IF_ERROR(ParseInputs(checkpoint_parser, tensors));
+  return AccumulateInputs(absl::MakeConstSpan(&tensors, 1), numa_node);
+}
 
-  absl::MutexLock lock(&aggregation_mu_);
+absl::Status CheckpointAggregator::AccumulateBatch(
+    absl::Span<CheckpointParser* const> checkpoint_parsers) {
+  std::vector<InputTensors> inputs(checkpoint_parsers.size());
+  for (size_t i = 0; i < checkpoint_parsers.size(); ++i) {
+    TFF_RETURN_IF_ERROR(ParseInputs(*checkpoint_parsers[i], inputs[i]));
+  }
+  if (inputs.empty()) {
+    return absl::OkStatus();
+  }
+  return AccumulateInputs(inputs);
+}
+
+void CheckpointAggregator::AccumulateAsync(
+    std::unique_ptr<CheckpointParser> checkpoint_parser,
+    std::function<void(absl::Status)> done) {
+  Scheduler* scheduler;
+  {
+    absl::MutexLock lock(&async_mu_);
+    scheduler = async_scheduler_;
+    if (scheduler != nullptr) {
+      async_queue_.push_back({std::move(checkpoint_parser), std::move(done)});
+      if (async_drain_scheduled_) {
+        return;
+      }
+      async_drain_scheduled_ = true;
+    }
+  }
+  if (scheduler == nullptr) {
+    done(Accumulate(*checkpoint_parser));
+    return;
+  }
+  scheduler->Schedule([this] { DrainAsyncAccumulations(); });
+}
+
+void CheckpointAggregator::SetAsyncAccumulation(Scheduler* scheduler) {
+  absl::MutexLock lock(&async_mu_);
+  async_scheduler_ = scheduler;
+}
+
+void CheckpointAggregator::DrainAsyncAccumulations() {
+  while (true) {
+    std::vector<PendingAccumulation> batch;
+    {
+      absl::MutexLock lock(&async_mu_);
+      if (async_queue_.empty()) {
+        // Nothing may access this instance after this point, since the
+        // destructor only waits for the flag to be cleared.
+        async_drain_scheduled_ = false;
+        return;
+      }
+      const size_t batch_size =
+          std::min(async_queue_.size(), kMaxAsyncAccumulationBatchSize);
+      batch.reserve(batch_size);
+      for (size_t i = 0; i < batch_size; ++i) {
+        batch.push_back(std::move(async_queue_.front()));
+        async_queue_.pop_front();
+      }
+    }
+    AccumulatePending(std::move(batch));
+  }
+}
+
+void CheckpointAggregator::AccumulatePending(
+    std::vector<PendingAccumulation> batch) {
+  // Unlike AccumulateBatch, an invalid checkpoint only fails its own
+  // callback, and the other checkpoints of the batch are still accumulated.
+  std::vector<absl::Status> statuses(batch.size());
+  std::vector<InputTensors> inputs(batch.size());
+  // Index in `batch` of each checkpoint in `inputs`.
+  std::vector<size_t> parsed;
+  parsed.reserve(batch.size());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    if (aggregation_finished_) {
+      // Don't bother parsing checkpoints which can't be accumulated anymore.
+      statuses[i] =
+          absl::AbortedError("Aggregation has already been finished.");
+      continue;
+    }
+    statuses[i] =
+        ParseInputs(*batch[i].checkpoint_parser, inputs[parsed.size()]);
+    if (statuses[i].ok()) {
+      parsed.push_back(i);
+    } else {
+      inputs[parsed.size()].clear();
+    }
+  }
+  bool accumulate_one_at_a_time = parsed.size() == 1;
+  if (parsed.size() > 1) {
+    // A tensor aggregator may still reject a checkpoint which matches the
+    // input specs, after having accumulated part of the batch, so the batch
+    // is accumulated into new aggregators which are only merged into a shard
+    // once all of them have accepted it. Otherwise the checkpoints are
+    // accumulated one at a time, so that only the rejected ones fail.
+    absl::StatusOr<std::vector<std::unique_ptr<TensorAggregator>>>
+        aggregators = AccumulateIntoNewAggregators(
+            absl::MakeConstSpan(inputs.data(), parsed.size()));
+    if (aggregators.ok()) {
+      absl::Status status = MergeIntoShard(*aggregators);
+      for (size_t i : parsed) {
+        statuses[i] = status;
+      }
+    } else {
+      accumulate_one_at_a_time = true;
+    }
+  }
+  if (accumulate_one_at_a_time) {
+    for (size_t j = 0; j < parsed.size(); ++j) {
+      statuses[parsed[j]] =
+          AccumulateInputs(absl::MakeConstSpan(&inputs[j], 1));
+    }
+  }
+  // The tensors may reference the memory of the parsers, which are only
+  // released afterwards along with the batch.
+  inputs.clear();
+  for (size_t i = 0; i < batch.size(); ++i) {
+    batch[i].done(std::move(statuses[i]));
+  }
+}
+
+absl::StatusOr<std::vector<std::unique_ptr<TensorAggregator>>>
+CheckpointAggregator::AccumulateIntoNewAggregators(
+    absl::Span<const InputTensors> inputs) const {
+  TFF_ASSIGN_OR_RETURN(
+      std::vector<std::unique_ptr<TensorAggregator>> aggregators,
+      CreateAggregators(intrinsics_, nullptr));
+  for (size_t i = 0; i < intrinsics_.size(); ++i) {
+    const std::vector<size_t>& input_indices =
+        input_layout_.intrinsic_inputs[i];
+    std::vector<InputTensorList> batch;
+    batch.reserve(inputs.size());
+    for (const InputTensors& tensors : inputs) {
+      batch.push_back(GatherInputs(tensors, input_indices));
+    }
+    ScopedLatencyTimer timer(accumulate_latency_[i]);
+    TFF_RETURN_IF_ERROR(aggregators[i]->AccumulateBatch(batch));
+  }
+  return aggregators;
+}
+
+absl::Status CheckpointAggregator::MergeIntoShard(
+    std::vector<std::unique_ptr<TensorAggregator>>& aggregators) {
+  absl::ReaderMutexLock lock(&aggregation_mu_);
+  TFF_RETURN_IF_ERROR(CheckCanAccumulate());
+  Shard& shard = AcquireShard(/*numa_node=*/-1);
+  shard.mu.AssertHeld();
+  absl::Status status = absl::OkStatus();
+  for (size_t i = 0; i < intrinsics_.size() && status.ok(); ++i) {
+    TFF_CHECK(shard.aggregators[i] != nullptr)
+        << "Report() has already been called.";
+    status = shard.aggregators[i]->MergeWith(std::move(*aggregators[i]));
+  }
+  UpdateMemoryUsage(shard);
+  shard.mu.Unlock();
+  return status;
+}
+
+absl::Status CheckpointAggregator::ParseInputs(
+    CheckpointParser& checkpoint_parser, InputTensors& tensors) const {
+  tensors.resize(input_layout_.tensor_specs.size());
+  TFF_RETURN_IF_ERROR(
+      checkpoint_parser.GetTensors(*binding_plan_, absl::MakeSpan(tensors)));
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const TensorSpec& input_spec = *input_layout_.tensor_specs[i];
+    if (!MatchesSpec(tensors[i], input_spec)) {
+      // TODO: b/253099587 - Detailed diagnostics including the expected vs
+      // actual data types and shapes.
+      return absl::InvalidArgumentError("Input tensor spec mismatch.");
+    }
+  }
+  for (const auto& [index, input_spec] : input_layout_.aliased_specs) {
+    if (!MatchesSpec(tensors[index], *input_spec)) {
+      return absl::InvalidArgumentError(
+          "Tensor with same name but unmatching spec already exists.");
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CheckpointAggregator::AccumulateInputs(
+    absl::Span<const InputTensors> inputs, int numa_node) {
+  absl::Time wait_start = absl::Now();
+  absl::ReaderMutexLock lock(&aggregation_mu_);
+  TFF_RETURN_IF_ERROR(CheckCanAccumulate());
+  Shard& shard = AcquireShard(numa_node);
+  shard.mu.AssertHeld();
+  accumulate_lock_wait_nanos_.fetch_add(
+      absl::ToInt64Nanoseconds(absl::Now() - wait_start),
+      std::memory_order_relaxed);
+  absl::Status status = absl::OkStatus();
+  for (size_t i = 0; i < intrinsics_.size() && status.ok(); ++i) {
+    const std::vector<size_t>& input_indices =
+        input_layout_.intrinsic_inputs[i];
+    TFF_CHECK(shard.aggregators[i] != nullptr)
+        << "Report() has already been called.";
+    ScopedLatencyTimer timer(accumulate_latency_[i]);
+    if (inputs.size() == 1) {
+      status = shard.aggregators[i]->Accumulate(
+          GatherInputs(inputs[0], input_indices));
+      continue;
+    }
+    std::vector<InputTensorList> batch;
+    batch.reserve(inputs.size());
+    for (const InputTensors& tensors : inputs) {
+      batch.push_back(GatherInputs(tensors, input_indices));
+    }
+    status = shard.aggregators[i]->AccumulateBatch(batch);
+  }
+  UpdateMemoryUsage(shard);
+  shard.mu.Unlock();
+  return status;
+}
+
+absl::Status CheckpointAggregator::CheckCanAccumulate() const {
   if (aggregation_finished_) {
     return absl::AbortedError("Aggregation has already been finished.");
   }
-  for (int i = 0; i < intrinsics_.size(); ++i) {
-    const Intrinsic& intrinsic = intrinsics_[i];
-    InputTensorList inputs(CountInputs(intrinsic));
-    TFF_RETURN_IF_ERROR(PopulateInputs(intrinsic, tensor_map, 0, inputs));
-    TFF_CHECK(aggregators_[i] != nullptr)
-        << "Report() has already been called.";
-    TFF_RETURN_IF_ERROR(aggregators_[i]->Accumulate(std::move(inputs)));
+  const size_t memory_budget = memory_budget_.load(std::memory_order_relaxed);
+  if (memory_budget > 0 && GetMemoryUsage() > memory_budget) {
+    return absl::ResourceExhaustedError(absl::StrCat(
+        "The aggregation state uses ", GetMemoryUsage(),
+        " bytes, which exceeds the memory budget of ", memory_budget,
+        " bytes."));
   }
   return absl::OkStatus();
 }
 
+CheckpointAggregator::InputLayout CheckpointAggregator::CreateInputLayout(
+    const std::vector<Intrinsic>& intrinsics) {
+  InputLayout layout;
+  absl::flat_hash_map<std::string, size_t> tensor_indices;
+  for (const Intrinsic& intrinsic : intrinsics) {
+    std::vector<size_t>& inputs = layout.intrinsic_inputs.emplace_back();
+    AddInputsToLayout(intrinsic, tensor_indices, layout.tensor_specs,
+                      layout.aliased_specs, inputs);
+  }
+  return layout;
+}
+
+std::shared_ptr<const TensorBindingPlan>
+CheckpointAggregator::CreateBindingPlan(const InputLayout& layout) {
+  std::vector<std::string> names;
+  names.reserve(layout.tensor_specs.size());
+  for (const TensorSpec* spec : layout.tensor_specs) {
+    names.push_back(spec->name());
+  }
+  return std::make_shared<const TensorBindingPlan>(std::move(names));
+}
+
+std::vector<LatencyHistogram*> CheckpointAggregator::GetLatencyHistograms(
+    const std::vector<Intrinsic>& intrinsics, absl::string_view operation) {
+  std::vector<LatencyHistogram*> histograms;
+  histograms.reserve(intrinsics.size());
+  for (const Intrinsic& intrinsic : intrinsics) {
+    histograms.push_back(MetricsRegistry::Default().GetLatencyHistogram(
+        absl::StrCat("CheckpointAggregator::", operation, "/", intrinsic.uri)));
+  }
+  return histograms;
+}
+
+void CheckpointAggregator::UpdateMemoryUsage(Shard& shard) {
+  size_t memory_usage = 0;
+  for (const auto& aggregator : shard.aggregators) {
+    if (aggregator != nullptr) {
+      memory_usage += aggregator->GetMemoryUsage();
+    }
+  }
+  shard.memory_usage.store(memory_usage, std::memory_order_relaxed);
+}
+
+size_t CheckpointAggregator::GetMemoryUsage() const {
+  size_t memory_usage = 0;
+  for (const auto& shard : shards_) {
+    memory_usage += shard->memory_usage.load(std::memory_order_relaxed);
+  }
+  return memory_usage;
+}
+
+void CheckpointAggregator::SetMemoryBudget(size_t max_memory_bytes) {
+  memory_budget_.store(max_memory_bytes, std::memory_order_relaxed);
+}
+
+absl::Duration CheckpointAggregator::GetAccumulateLockWaitTime() const {
+  return absl::Nanoseconds(
+      accumulate_lock_wait_nanos_.load(std::memory_order_relaxed));
+}
+
+CheckpointAggregator::Shard& CheckpointAggregator::AcquireShard(int numa_node)
+    ABSL_NO_THREAD_SAFETY_ANALYSIS {
+  // The shards of the NUMA node are the ones at `first + k * stride`.
+  size_t first = 0;
+  size_t stride = 1;
+  if (numa_node >= 0) {
+    first = numa_node;
+    stride = num_numa_nodes_;
+  }
+  const size_t num_candidates = (shards_.size() - first + stride - 1) / stride;
+  const size_t start =
+      next_shard_.fetch_add(1, std::memory_order_relaxed) % num_candidates;
+  for (size_t i = 0; i < num_candidates; ++i) {
+    Shard& shard = *shards_[first + (start + i) % num_candidates * stride];
+    if (shard.mu.TryLock()) {
+      return shard;
+    }
+  }
+  // All shards are busy, so wait on the one this call was assigned to.
+  Shard& shard = *shards_[first + start * stride];
+  shard.mu.Lock();
+  return shard;
+}
+
 absl::Status CheckpointAggregator::MergeWith(CheckpointAggregator&& other) {
   TFF_RETURN_IF_ERROR(CheckCompatible(intrinsics_, other.intrinsics_));
   absl::MutexLock lock(&aggregation_mu_);
   if (!aggregation_finished_) {
     auto other_aggregators = std::move(other).TakeAggregators();
+    Shard& shard = *shards_[0];
+    absl::MutexLock shard_lock(&shard.mu);
     for (int i = 0; i < intrinsics_.size(); ++i) {
       TFF_RETURN_IF_ERROR(
-          aggregators_[i]->MergeWith(std::move(*other_aggregators[i])));
+          shard.aggregators[i]->MergeWith(std::move(*other_aggregators[i])));
     }
+    UpdateMemoryUsage(shard);
   }
   return absl::OkStatus();
 }
@@ -199,7 +628,14 @@ bool CheckpointAggregator::CanReport() const {
   if (aggregation_finished_) {
     return false;
   }
-  for (const auto& aggregator : aggregators_) {
+  // Aggregators may only be able to report once they have seen enough inputs,
+  // so the inputs spread across shards must first be merged.
+  if (!MergeShards(/*reset_merged_shards=*/true).ok()) {
+    return false;
+  }
+  Shard& shard = *shards_[0];
+  absl::MutexLock shard_lock(&shard.mu);
+  for (const auto& aggregator : shard.aggregators) {
     TFF_CHECK(aggregator != nullptr)
         << "CreateReport() has already been called.";
     if (!aggregator->CanReport()) {
@@ -218,7 +654,57 @@ absl::Status CheckpointAggregator::Report(
 
   aggregation_finished_ = true;
 
-  for (const auto& aggregator : aggregators_) {
+  TFF_RETURN_IF_ERROR(MergeShards(/*reset_merged_shards=*/false));
+  Shard& shard = *shards_[0];
+  absl::MutexLock shard_lock(&shard.mu);
+  absl::Status status =
+      ReportAggregators(shard.aggregators, checkpoint_builder);
+  UpdateMemoryUsage(shard);
+  return status;
+}
+
+absl::Status CheckpointAggregator::ReportSnapshot(
+    CheckpointBuilder& checkpoint_builder) {
+  std::vector<std::unique_ptr<TensorAggregator>> snapshot(intrinsics_.size());
+  {
+    absl::MutexLock lock(&aggregation_mu_);
+    if (aggregation_finished_) {
+      return absl::AbortedError("Aggregation has already been finished.");
+    }
+    TFF_RETURN_IF_ERROR(MergeShards(/*reset_merged_shards=*/true));
+    Shard& shard = *shards_[0];
+    absl::MutexLock shard_lock(&shard.mu);
+    for (int i = 0; i < intrinsics_.size(); ++i) {
+      TFF_CHECK(shard.aggregators[i] != nullptr)
+          << "CreateReport() has already been called.";
+      // Serialize consumes the state of the aggregator, so the aggregation
+      // can't continue if the state can't be restored.
+      absl::StatusOr<std::string> state =
+          std::move(*shard.aggregators[i]).Serialize();
+      if (!state.ok()) {
+        aggregation_finished_ = true;
+        return state.status();
+      }
+      std::string snapshot_state = *state;
+      absl::StatusOr<std::unique_ptr<TensorAggregator>> restored =
+          CreateAggregator(intrinsics_[i], &*state);
+      if (!restored.ok()) {
+        aggregation_finished_ = true;
+        return restored.status();
+      }
+      shard.aggregators[i] = *std::move(restored);
+      TFF_ASSIGN_OR_RETURN(snapshot[i],
+                           CreateAggregator(intrinsics_[i], &snapshot_state));
+    }
+    UpdateMemoryUsage(shard);
+  }
+  return ReportAggregators(snapshot, checkpoint_builder);
+}
+
+absl::Status CheckpointAggregator::ReportAggregators(
+    std::vector<std::unique_ptr<TensorAggregator>>& aggregators,
+    CheckpointBuilder& checkpoint_builder) const {
+  for (const auto& aggregator : aggregators) {
     TFF_CHECK(aggregator != nullptr)
         << "CreateReport() has already been called.";
     if (!aggregator->CanReport()) {
@@ -227,10 +713,21 @@ absl::Status CheckpointAggregator::Report(
     }
   }
 
+  // The aggregators are independent of each other, so they can report
+  // concurrently. Their outputs are then added to the checkpoint in the order
+  // of the intrinsics, which doesn't depend on the parallelism.
+  std::vector<absl::StatusOr<OutputTensorList>> outputs(intrinsics_.size());
+  internal::ForEachShard(
+      report_scheduler_, num_report_tasks_, intrinsics_.size(),
+      [this, &aggregators, &outputs](size_t i) {
+        ScopedLatencyTimer timer(report_latency_[i]);
+        auto tensor_aggregator = std::move(aggregators[i]);
+        outputs[i] = std::move(*tensor_aggregator).Report();
+      });
+
   for (int i = 0; i < intrinsics_.size(); ++i) {
-    auto tensor_aggregator = std::move(aggregators_[i]);
     TFF_ASSIGN_OR_RETURN(OutputTensorList output_tensors,
-                         std::move(*tensor_aggregator).Report());
+                         std::move(outputs[i]));
     const Intrinsic& intrinsic = intrinsics_[i];
     TFF_ASSIGN_OR_RETURN(int num_outputs,
                          AddOutputsToCheckpoint(intrinsic, output_tensors, 0,
@@ -244,26 +741,128 @@ absl::Status CheckpointAggregator::Report(
   return absl::OkStatus();
 }
 
+void CheckpointAggregator::SetParallelReport(Scheduler* scheduler,
+                                             int num_tasks) {
+  report_scheduler_ = num_tasks > 1 ? scheduler : nullptr;
+  num_report_tasks_ = num_tasks;
+}
+
 void CheckpointAggregator::Abort() { aggregation_finished_ = true; }
 
 absl::StatusOr<std::string> CheckpointAggregator::Serialize() && {
+  TFF_ASSIGN_OR_RETURN(absl::Cord state, std::move(*this).SerializeToCord());
+  return std::string(state);
+}
+
+absl::StatusOr<absl::Cord> CheckpointAggregator::SerializeToCord() && {
   absl::MutexLock lock(&aggregation_mu_);
   if (aggregation_finished_) {
     return absl::AbortedError("Aggregation has already been finished.");
   }
-  CheckpointAggregatorState state;
-  google::protobuf::RepeatedPtrField<std::string>* aggregators_proto =
-      state.mutable_aggregators();
-  aggregators_proto->Reserve(aggregators_.size());
-  for (const auto& aggregator : aggregators_) {
-    aggregators_proto->Add(std::move(*aggregator).Serialize().value());
+  TFF_RETURN_IF_ERROR(MergeShards(/*reset_merged_shards=*/false));
+  Shard& shard = *shards_[0];
+  absl::MutexLock shard_lock(&shard.mu);
+  return SerializeAggregators(shard.aggregators);
+}
+
+absl::StatusOr<absl::Cord> CheckpointAggregator::SerializeDelta() {
+  std::vector<std::unique_ptr<TensorAggregator>> delta;
+  {
+    absl::MutexLock lock(&aggregation_mu_);
+    if (aggregation_finished_) {
+      return absl::AbortedError("Aggregation has already been finished.");
+    }
+    TFF_RETURN_IF_ERROR(MergeShards(/*reset_merged_shards=*/true));
+    Shard& shard = *shards_[0];
+    absl::MutexLock shard_lock(&shard.mu);
+    TFF_ASSIGN_OR_RETURN(
+        std::vector<std::unique_ptr<TensorAggregator>> empty_aggregators,
+        CreateShardAggregators(intrinsics_, nullptr, shard.numa_node,
+                               num_numa_nodes_));
+    delta = std::exchange(shard.aggregators, std::move(empty_aggregators));
+    UpdateMemoryUsage(shard);
+  }
+  // The delta is serialized without holding any lock, so that accumulation
+  // continues meanwhile.
+  absl::StatusOr<absl::Cord> state = SerializeAggregators(delta);
+  if (!state.ok()) {
+    // The inputs of the delta are lost, so the aggregation can't continue.
+    aggregation_finished_ = true;
   }
-  return state.SerializeAsString();
+  return state;
+}
+
+absl::Status CheckpointAggregator::MergeSerialized(
+    const absl::Cord& serialized_state) {
+  TFF_ASSIGN_OR_RETURN(std::unique_ptr<CheckpointAggregator> other,
+                       Deserialize(&intrinsics_, serialized_state));
+  return MergeWith(std::move(*other));
+}
+
+absl::StatusOr<absl::Cord> CheckpointAggregator::SerializeAggregators(
+    std::vector<std::unique_ptr<TensorAggregator>>& aggregators) {
+  // Encode the CheckpointAggregatorState one aggregator at a time. The state
+  // of each aggregator is moved into the Cord rather than copied.
+  absl::Cord state;
+  for (const auto& aggregator : aggregators) {
+    TFF_ASSIGN_OR_RETURN(std::string aggregator_state,
+                         std::move(*aggregator).Serialize());
+    std::string field_header;
+    google::protobuf::io::StringOutputStream out(&field_header);
+    google::protobuf::io::CodedOutputStream coded_out(&out);
+    coded_out.WriteTag(kAggregatorsTag);
+    coded_out.WriteVarint64(aggregator_state.size());
+    coded_out.Trim();
+    state.Append(field_header);
+    state.Append(std::move(aggregator_state));
+  }
+  return state;
+}
+
+absl::Status CheckpointAggregator::MergeShards(bool reset_merged_shards) const {
+  Shard& target = *shards_[0];
+  absl::MutexLock target_lock(&target.mu);
+  // Take the aggregators of all other shards first, so that each intrinsic
+  // can merge all of them in one MergeWithAll call.
+  std::vector<std::vector<std::unique_ptr<TensorAggregator>>> merged_shards;
+  for (size_t i = 1; i < shards_.size(); ++i) {
+    Shard& shard = *shards_[i];
+    absl::MutexLock shard_lock(&shard.mu);
+    if (shard.aggregators.empty()) {
+      // Already merged and not reset.
+      continue;
+    }
+    merged_shards.push_back(std::move(shard.aggregators));
+    shard.aggregators.clear();
+    if (reset_merged_shards) {
+      TFF_ASSIGN_OR_RETURN(
+          shard.aggregators,
+          CreateShardAggregators(intrinsics_, nullptr, shard.numa_node,
+                                 num_numa_nodes_));
+    }
+    UpdateMemoryUsage(shard);
+  }
+  if (merged_shards.empty()) {
+    return absl::OkStatus();
+  }
+  std::vector<TensorAggregator*> others(merged_shards.size());
+  for (int j = 0; j < intrinsics_.size(); ++j) {
+    TFF_CHECK(target.aggregators[j] != nullptr)
+        << "CreateReport() has already been called.";
+    for (size_t i = 0; i < merged_shards.size(); ++i) {
+      TFF_CHECK(merged_shards[i][j] != nullptr)
+          << "CreateReport() has already been called.";
+      others[i] = merged_shards[i][j].get();
+    }
+    TFF_RETURN_IF_ERROR(target.aggregators[j]->MergeWithAll(others));
+  }
+  UpdateMemoryUsage(target);
+  return absl::OkStatus();
 }
 
 absl::StatusOr<std::unique_ptr<TensorAggregator>>
-CheckpointAggregator::CreateAggregator(
-    const Intrinsic& intrinsic, const std::string* serialized_aggregator) {
+CheckpointAggregator::CreateAggregator(const Intrinsic& intrinsic,
+                                       std::string* serialized_aggregator) {
   // Resolve the intrinsic_uri to the registered TensorAggregatorFactory.
   TFF_ASSIGN_OR_RETURN(const TensorAggregatorFactory* factory,
                        GetAggregatorFactory(intrinsic.uri));
@@ -272,78 +871,61 @@ CheckpointAggregator::CreateAggregator(
   if (serialized_aggregator == nullptr) {
     return factory->Create(intrinsic);
   }
-  return factory->Deserialize(intrinsic, *serialized_aggregator);
+  return factory->Deserialize(intrinsic, std::move(*serialized_aggregator));
 }
 
 std::vector<std::unique_ptr<TensorAggregator>>
 CheckpointAggregator::TakeAggregators() && {
   absl::MutexLock lock(&aggregation_mu_);
-  return std::move(aggregators_);
+  TFF_CHECK(MergeShards(/*reset_merged_shards=*/false).ok())
+      << "Failed to merge the shards of the aggregator.";
+  Shard& shard = *shards_[0];
+  absl::MutexLock shard_lock(&shard.mu);
+  return std::move(shard.aggregators);
 }
 
 namespace {
 
-absl::Status AddInputsToMap(const Intrinsic& intrinsic,
-                            CheckpointParser& parser, TensorMap& tensor_map) {
+void AddInputsToLayout(
+    const Intrinsic& intrinsic,
+    absl::flat_hash_map<std::string, size_t>& tensor_indices,
+    std::vector<const TensorSpec*>& tensor_specs,
+    std::vector<std::pair<size_t, const TensorSpec*>>& aliased_specs,
+    std::vector<size_t>& inputs) {
   for (const TensorSpec& input_spec : intrinsic.inputs) {
-    auto existing_tensor_it = tensor_map.find(input_spec.name());
-    if (existing_tensor_it != tensor_map.end()) {
-      // Tensor with a matching name is already in the map.
-      const Tensor& existing_tensor = existing_tensor_it->second;
-      if (input_spec.dtype() == existing_tensor.dtype() &&
-          input_spec.shape().MatchesKnownDimensions(existing_tensor.shape())) {
-        continue;
-      } else {
-        return absl::InvalidArgumentError(
-            "Tensor with same name but unmatching spec already exists.");
-      }
+    auto [it, inserted] =
+        tensor_indices.try_emplace(input_spec.name(), tensor_specs.size());
+    if (inserted) {
+      tensor_specs.push_back(&input_spec);
+    } else {
+      // Tensor with a matching name is already an input.
+      aliased_specs.emplace_back(it->second, &input_spec);
     }
-
-    TFF_ASSIGN_OR_RETURN(Tensor tensor, parser.GetTensor(input_spec.name()));
-    if (tensor.dtype() != input_spec.dtype() ||
-        !input_spec.shape().MatchesKnownDimensions(tensor.shape())) {
-      // TODO: b/253099587 - Detailed diagnostics including the expected vs
-      // actual data types and shapes.
-      return absl::InvalidArgumentError("Input tensor spec mismatch.");
-    }
-    tensor_map.emplace(input_spec.name(), std::move(tensor));
+    inputs.push_back(it->second);
   }
   for (const Intrinsic& nested_intrinsic : intrinsic.nested_intrinsics) {
-    TFF_RETURN_IF_ERROR(AddInputsToMap(nested_intrinsic, parser, tensor_map));
+    AddInputsToLayout(nested_intrinsic, tensor_indices, tensor_specs,
+                      aliased_specs, inputs);
   }
-  return absl::OkStatus();
 }
 
-size_t CountInputs(const Intrinsic& intrinsic) {
-  size_t count = intrinsic.inputs.size();
-  for (const Intrinsic& nested_intrinsic : intrinsic.nested_intrinsics) {
-    count += CountInputs(nested_intrinsic);
-  }
-  return count;
+bool MatchesSpec(const Tensor& tensor, const TensorSpec& spec) {
+  return tensor.dtype() == spec.dtype() &&
+         spec.shape().MatchesKnownDimensions(tensor.shape());
 }
 
-absl::StatusOr<size_t> PopulateInputs(const Intrinsic& intrinsic,
-                                      const TensorMap& tensor_map, size_t index,
-                                      InputTensorList& inputs) {
-  size_t num_inputs = intrinsic.inputs.size();
-  for (const TensorSpec& input_spec : intrinsic.inputs) {
-    const auto& it = tensor_map.find(input_spec.name());
-    TFF_CHECK(it != tensor_map.end());
-    inputs[index++] = &it->second;
+InputTensorList GatherInputs(absl::Span<const Tensor> tensors,
+                             const std::vector<size_t>& input_indices) {
+  InputTensorList inputs(input_indices.size());
+  for (size_t i = 0; i < input_indices.size(); ++i) {
+    inputs[i] = &tensors[input_indices[i]];
   }
-  for (const Intrinsic& nested_intrinsic : intrinsic.nested_intrinsics) {
-    TFF_ASSIGN_OR_RETURN(
-        size_t nested_num_inputs,
-        PopulateInputs(nested_intrinsic, tensor_map, index, inputs));
-    index += nested_num_inputs;
-    num_inputs += nested_num_inputs;
-  }
-  return num_inputs;
+  return inputs;
 }
 
 absl::StatusOr<int> AddOutputsToCheckpoint(
-    const Intrinsic& intrinsic, const OutputTensorList& outputs,
-    int output_index, CheckpointBuilder& checkpoint_builder) {
+    const Intrinsic& intrinsic, OutputTensorList& outputs, int output_index,
+    CheckpointBuilder& checkpoint_builder) {
   int num_outputs = 0;
   for (const TensorSpec& output_spec : intrinsic.outputs) {
     if (output_spec.name().empty()) {
@@ -351,7 +933,7 @@ absl::StatusOr<int> AddOutputsToCheckpoint(
       continue;
     }
     num_outputs++;
-    const Tensor& tensor = outputs[output_index++];
+    Tensor& tensor = outputs[output_index++];
     if (tensor.dtype() != output_spec.dtype()) {
       return absl::InternalError(absl::StrCat(
           "Output tensor spec mismatch for output tensor ", output_spec.name(),
@@ -365,7 +947,10 @@ absl::StatusOr<int> AddOutputsToCheckpoint(
           tensor.shape().ToProto().DebugString(), " and output spec has shape ",
           output_spec.shape().ToProto().DebugString()));
     }
-    TFF_RETURN_IF_ERROR(checkpoint_builder.Add(output_spec.name(), tensor));
+    // The output tensors aren't used after being added, so the builder can take
+    // over their data instead of copying it.
+    TFF_RETURN_IF_ERROR(
+        checkpoint_builder.Add(output_spec.name(), std::move(tensor)));
   }
   for (const Intrinsic& nested_intrinsic : intrinsic.nested_intrinsics) {
     TFF_ASSIGN_OR_RETURN(
@@ -385,6 +970,30 @@ absl::Status CheckCompatible(const std::vector<Intrinsic>& intrinsics,
   return absl::OkStatus();
 }
 
+absl::StatusOr<CheckpointAggregatorState> ParseAggregatorState(
+    const absl::Cord& serialized_state) {
+  CheckpointAggregatorState aggregator_state;
+  CordReader reader(serialized_state);
+  while (!reader.AtEnd()) {
+    uint32_t tag;
+    uint64_t size;
+    absl::Cord serialized_aggregator;
+    if (!reader.ReadVarint32(&tag) || tag != kAggregatorsTag ||
+        !reader.ReadVarint64(&size) ||
+        !reader.ReadCord(size, &serialized_aggregator)) {
+      // Fall back to the generated parser for anything that wasn't produced
+      // by SerializeToCord, such as unknown fields.
+      aggregator_state.Clear();
+      if (!aggregator_state.ParseFromString(std::string(serialized_state))) {
+        return absl::InvalidArgumentError("Failed to parse serialized state.");
+      }
+      return aggregator_state;
+    }
+    aggregator_state.add_aggregators(std::string(serialized_aggregator));
+  }
+  return aggregator_state;
+}
+
 }  // namespace
 
 }  // namespace aggregation
@@ -20,22 +20,36 @@
 #include <stdbool.h>
 
 #include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
-#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/base/attributes.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_aggregator.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/configuration.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/tensor_binding_plan.h"
 
 namespace tensorflow_federated {
 namespace aggregation {
@@ -54,20 +68,38 @@ class CheckpointAggregator {
   static absl::Status ValidateConfig(const Configuration& configuration);
 
   // Creates an instance of CheckpointAggregator.
+  //
+  // The aggregation state is split into `num_shards` independent replicas of
+  // the tensor aggregators. Concurrent Accumulate calls are spread across the
+  // shards so that they don't contend on a single lock, and the shards are
+  // merged with TensorAggregator::MergeWith before reporting or serializing.
+  // Sharding only pays off when Accumulate is called from several threads and
+  // multiplies the memory used by the aggregation state by `num_shards`.
+  //
+  // On multi-socket hosts, the shards can be spread across `num_numa_nodes`
+  // NUMA nodes, which must be between 1 and `num_shards`: shard `i` is placed
+  // on node `i % num_numa_nodes`, by creating its aggregators on a thread
+  // pinned to the CPUs of the node. AccumulateOnNumaNode then only
+  // accumulates into the shards of the given node, so that the state is only
+  // accessed across nodes when the shards are merged. See GetNumNumaNodes.
   static absl::StatusOr<std::unique_ptr<CheckpointAggregator>> Create(
-      const Configuration& configuration);
+      const Configuration& configuration, int num_shards = 1,
+      int num_numa_nodes = 1);
 
   // Creates an instance of CheckpointAggregator.
   // The `intrinsics` are expected to be created using `ParseFromConfig` which
   // validates the configuration. CheckpointAggregator does not take any
   // ownership, and `intrinsics` must outlive it.
   static absl::StatusOr<std::unique_ptr<CheckpointAggregator>> Create(
-      const std::vector<Intrinsic>* intrinsics ABSL_ATTRIBUTE_LIFETIME_BOUND);
+      const std::vector<Intrinsic>* intrinsics ABSL_ATTRIBUTE_LIFETIME_BOUND,
+      int num_shards = 1, int num_numa_nodes = 1);
 
   // Creates an instance of CheckpointAggregator based on the given
-  // configuration and serialized state.
+  // configuration and serialized state. The serialized state is restored into
+  // the first of the `num_shards` shards.
   static absl::StatusOr<std::unique_ptr<CheckpointAggregator>> Deserialize(
-      const Configuration& configuration, std::string serialized_state);
+      const Configuration& configuration, std::string serialized_state,
+      int num_shards = 1);
 
   // Creates an instance of CheckpointAggregator based on the given intrinsics
   // and serialized state.
@@ -76,11 +108,70 @@ class CheckpointAggregator {
   // ownership, and `intrinsics` must outlive it.
   static absl::StatusOr<std::unique_ptr<CheckpointAggregator>> Deserialize(
       const std::vector<Intrinsic>* intrinsics ABSL_ATTRIBUTE_LIFETIME_BOUND,
-      std::string serialized_state);
+      std::string serialized_state, int num_shards = 1);
+
+  // Same as the above, but restores the state from a Cord, such as the one
+  // returned by SerializeToCord. The Cord is read chunk by chunk, so it can
+  // reference external memory, for example a memory-mapped file created with
+  // absl::MakeCordFromExternal, which is then only copied once to restore the
+  // state of each tensor aggregator.
+  static absl::StatusOr<std::unique_ptr<CheckpointAggregator>> Deserialize(
+      const Configuration& configuration, const absl::Cord& serialized_state,
+      int num_shards = 1);
+
+  static absl::StatusOr<std::unique_ptr<CheckpointAggregator>> Deserialize(
+      const std::vector<Intrinsic>* intrinsics ABSL_ATTRIBUTE_LIFETIME_BOUND,
+      const absl::Cord& serialized_state, int num_shards = 1);
 
   // Accumulates a checkpoint via nested tensor aggregators. The tensors are
-  // provided by the CheckpointParser instance.
+  // provided by the CheckpointParser instance. Concurrent calls run in
+  // parallel when there is more than one shard.
   absl::Status Accumulate(CheckpointParser& checkpoint_parser);
+  // Same as Accumulate, but only accumulates into the shards placed on the
+  // NUMA node, which must be less than num_numa_nodes(). The caller should
+  // run on the CPUs of the node, e.g. within a ScopedNumaNodeAffinity, so
+  // that the state of these shards stays local to the node.
+  absl::Status AccumulateOnNumaNode(CheckpointParser& checkpoint_parser,
+                                    int numa_node);
+  // Accumulates several checkpoints at once, e.g. when the ingestion pipeline
+  // has the checkpoints of several clients parsed and ready, with the same
+  // result as calling Accumulate with each of them in order when all of them
+  // are valid. The tensors of all checkpoints are checked against the input
+  // specs before any is accumulated, and each tensor aggregator then
+  // accumulates all of them with a single TensorAggregator::AccumulateBatch
+  // call while a single shard is locked. A checkpoint which matches the
+  // specs may still be rejected by a tensor aggregator, e.g. a GroupBy value
+  // whose shape differs from its keys. The intrinsics before the rejecting
+  // one have then accumulated the whole batch, the rejecting one possibly
+  // part of it, and the following ones none of it, so the state no longer
+  // matches any sequence of Accumulate calls. Callers which can't rule this
+  // out should use AccumulateAsync, which only fails the rejected
+  // checkpoints.
+  absl::Status AccumulateBatch(
+      absl::Span<CheckpointParser* const> checkpoint_parsers);
+  // Queues a checkpoint to be accumulated in the background and returns
+  // immediately. `done` is called with the status that Accumulate would have
+  // returned for the checkpoint once it has been accumulated, or with ABORTED
+  // if the aggregation finishes first. The queued checkpoints are accumulated
+  // one batch at a time, in the order in which they are queued, by a single
+  // task scheduled on the scheduler set by SetAsyncAccumulation, which runs
+  // until the queue is empty. Each batch is parsed and checked against the
+  // input specs one checkpoint at a time, and the valid ones are then
+  // accumulated together as in AccumulateBatch, into new tensor aggregators
+  // which are merged into a shard once all of them have accepted the batch.
+  // If one of them rejects it, the checkpoints are accumulated one at a time
+  // instead, so only the rejected checkpoints fail. Without a scheduler, the
+  // checkpoint is accumulated before returning. `done` is called on the
+  // thread accumulating the batch, and must not destroy this instance.
+  void AccumulateAsync(std::unique_ptr<CheckpointParser> checkpoint_parser,
+                       std::function<void(absl::Status)> done);
+  // Sets the scheduler on which AccumulateAsync accumulates the queued
+  // checkpoints. The `scheduler` must outlive this instance. Checkpoints
+  // queued before it is set are unaffected. The `scheduler` may also be set
+  // for the parallel settings of the tensor aggregators, e.g.
+  // GroupByAggregator::SetParallelAccumulate: their shards are then processed
+  // by the accumulating task itself while the other threads are busy.
+  void SetAsyncAccumulation(Scheduler* scheduler);
   // Merges with another compatible instance of CheckpointAggregator consuming
   // it in the process.
   absl::Status MergeWith(CheckpointAggregator&& other);
@@ -88,50 +179,289 @@ class CheckpointAggregator {
   bool CanReport() const;
   // Builds the report using the supplied CheckpointBuilder instance.
   absl::Status Report(CheckpointBuilder& checkpoint_builder);
+  // Builds a report of the inputs accumulated so far, without finishing the
+  // aggregation. The aggregation state is copied by a serialization round
+  // trip, during which Accumulate calls wait; the report is then built from
+  // the copy while accumulation continues. Each snapshot releases the
+  // aggregate once more, which aggregations with a privacy budget, such as
+  // the DP ones, must account for.
+  absl::Status ReportSnapshot(CheckpointBuilder& checkpoint_builder);
+  // Enables parallel reporting: Report and ReportSnapshot run the Report of
+  // the tensor aggregators of the intrinsics concurrently, on up to
+  // `num_tasks` tasks including the calling thread, all but one of which are
+  // scheduled on `scheduler`. The outputs are still added to the checkpoint
+  // in the order of the intrinsics, so the report is the same as a serial
+  // one, and is built in about the time of the slowest intrinsic. The
+  // `scheduler` may also be set for the parallel settings of the tensor
+  // aggregators, e.g. GroupByAggregator::SetParallelOutputKeys, since the
+  // nested shards are processed by the reporting task itself while the other
+  // threads are busy. Tasks which found no intrinsic left to report may still
+  // be queued when Report returns, so the `scheduler` must be idle, e.g.
+  // after WaitUntilIdle, before it is destroyed, and must outlive this
+  // instance. A null `scheduler` or `num_tasks` <= 1 disables parallelism,
+  // which is the default. Must not be called concurrently with Report or
+  // ReportSnapshot.
+  void SetParallelReport(Scheduler* scheduler, int num_tasks);
   // Signal that the aggregation must be aborted and the report can't be
   // produced.
   void Abort();
   // Serialize the internal state of the checkpoint aggregator as a string.
   absl::StatusOr<std::string> Serialize() &&;
+  // Same as Serialize, but returns the state as a Cord holding the serialized
+  // state of each tensor aggregator as a separate chunk, which avoids copying
+  // them into a single string. The Cord can be written to a file chunk by
+  // chunk, and contains the same bytes as the result of Serialize.
+  absl::StatusOr<absl::Cord> SerializeToCord() &&;
+  // Serializes the inputs accumulated since the previous call, or since the
+  // creation of this instance, and resets the aggregation state so that
+  // accumulation continues from scratch. The result has the format of
+  // SerializeToCord, so it can be restored with Deserialize or merged into
+  // another instance with MergeSerialized. Accumulate calls wait while the
+  // state is taken, but not while it is serialized.
+  //
+  // This lets an aggregation be spread across processes: leaf instances each
+  // accumulate a subset of the inputs and periodically send their deltas to a
+  // root instance, which merges them and produces the report. Since the
+  // deltas of an instance don't overlap, the root reports the same aggregate
+  // as a single instance accumulating all the inputs.
+  absl::StatusOr<absl::Cord> SerializeDelta();
+  // Merges a serialized state of a compatible instance, such as one returned
+  // by SerializeToCord or SerializeDelta, into this instance.
+  absl::Status MergeSerialized(const absl::Cord& serialized_state);
+
+  // Returns an estimate of the memory held by the aggregation state, in bytes,
+  // as of the last change to each shard. Doesn't take any lock, so it can be
+  // polled while inputs are being accumulated.
+  size_t GetMemoryUsage() const;
+  // Sets the number of bytes the aggregation state may use, or 0 for no
+  // limit, which is the default. Once GetMemoryUsage exceeds the budget,
+  // Accumulate rejects inputs with RESOURCE_EXHAUSTED, leaving the state
+  // unchanged, so that the caller can report, serialize or merge the state
+  // elsewhere before accepting more inputs. The input that takes the usage
+  // over the budget is still accumulated, since its cost is only known once
+  // it has been aggregated.
+  void SetMemoryBudget(size_t max_memory_bytes);
+  // Returns the total time Accumulate calls have waited to lock a shard of
+  // the aggregation state.
+  absl::Duration GetAccumulateLockWaitTime() const;
+  // Returns the plan of the tensors that Accumulate gets from each checkpoint,
+  // computed once for the intrinsics. Parsers created for it with
+  // CheckpointParserFactory::CreateWithBindingPlan hand the tensors over
+  // from fixed slots rather than looking each of them up by name.
+  std::shared_ptr<const TensorBindingPlan> GetTensorBindingPlan() const {
+    return binding_plan_;
+  }
+  // Returns the number of NUMA nodes the shards are spread across.
+  int num_numa_nodes() const { return num_numa_nodes_; }
 
  private:
+  // One replica of the tensor aggregators, one per intrinsic.
+  struct Shard {
+    absl::Mutex mu;
+    std::vector<std::unique_ptr<TensorAggregator>> aggregators
+        ABSL_GUARDED_BY(mu);
+    // Estimated memory usage of the aggregators, updated under `mu` whenever
+    // they change and read without it by GetMemoryUsage.
+    std::atomic<size_t> memory_usage = 0;
+    // NUMA node on which the aggregators are created.
+    int numa_node = 0;
+  };
+
+  // Updates the estimated memory usage of the shard.
+  static void UpdateMemoryUsage(Shard& shard)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.mu);
+
   CheckpointAggregator(
       const std::vector<Intrinsic>* intrinsics ABSL_ATTRIBUTE_LIFETIME_BOUND,
-      std::vector<std::unique_ptr<TensorAggregator>> aggregators);
+      std::vector<std::unique_ptr<Shard>> shards, int num_numa_nodes);
 
-  CheckpointAggregator(
-      std::vector<Intrinsic> intrinsics,
-      std::vector<std::unique_ptr<TensorAggregator>> aggregators);
+  CheckpointAggregator(std::shared_ptr<const std::vector<Intrinsic>> intrinsics,
+                       std::vector<std::unique_ptr<Shard>> shards,
+                       int num_numa_nodes);
+
+  // Describes where the inputs of each intrinsic come from, so that Accumulate
+  // can gather the input tensors of a checkpoint into a flat list rather than
+  // into a map keyed by tensor name.
+  struct InputLayout {
+    // Specs of the distinct input tensors, by order of first use by the
+    // intrinsics. Each tensor is parsed according to the first spec that uses
+    // its name.
+    std::vector<const TensorSpec*> tensor_specs;
+    // Specs of the inputs that share their name with an earlier input, each
+    // with the index of the earlier input in `tensor_specs`. The tensor must
+    // match these specs too.
+    std::vector<std::pair<size_t, const TensorSpec*>> aliased_specs;
+    // For each intrinsic, the index in `tensor_specs` of each of its inputs
+    // and those of its nested intrinsics, in the order its aggregator expects.
+    std::vector<std::vector<size_t>> intrinsic_inputs;
+  };
+
+  static InputLayout CreateInputLayout(const std::vector<Intrinsic>& intrinsics);
+
+  // Binds the names of the distinct input tensors of `layout` to their
+  // indices in `layout.tensor_specs`.
+  static std::shared_ptr<const TensorBindingPlan> CreateBindingPlan(
+      const InputLayout& layout);
+
+  // Maximum number of distinct input tensors for which Accumulate keeps the
+  // parsed tensors inline rather than in allocated storage.
+  static constexpr size_t kInlinedNumInputTensors = 8;
+  // The input tensors of a checkpoint, in the order of
+  // `input_layout_.tensor_specs`.
+  using InputTensors = absl::InlinedVector<Tensor, kInlinedNumInputTensors>;
+
+  // Gets the input tensors from the checkpoint and checks them against their
+  // specs.
+  absl::Status ParseInputs(CheckpointParser& checkpoint_parser,
+                           InputTensors& tensors) const;
+
+  // Accumulates the input tensors of one or more checkpoints in a shard, of
+  // the NUMA node if `numa_node` isn't negative.
+  absl::Status AccumulateInputs(absl::Span<const InputTensors> inputs,
+                                int numa_node = -1);
+
+  // Returns the error with which Accumulate rejects inputs once the
+  // aggregation has finished or the memory budget is exceeded, if any.
+  absl::Status CheckCanAccumulate() const
+      ABSL_SHARED_LOCKS_REQUIRED(aggregation_mu_);
+
+  // Accumulates the input tensors of several checkpoints into new aggregators
+  // for all intrinsics, without locking any shard.
+  absl::StatusOr<std::vector<std::unique_ptr<TensorAggregator>>>
+  AccumulateIntoNewAggregators(absl::Span<const InputTensors> inputs) const;
+
+  // Merges aggregators returned by AccumulateIntoNewAggregators into a shard,
+  // consuming them.
+  absl::Status MergeIntoShard(
+      std::vector<std::unique_ptr<TensorAggregator>>& aggregators);
+
+  // Returns the histograms of the default MetricsRegistry that record the
+  // latency of `operation` for each intrinsic, e.g.
+  // "CheckpointAggregator::Accumulate/federated_sum".
+  static std::vector<LatencyHistogram*> GetLatencyHistograms(
+      const std::vector<Intrinsic>& intrinsics, absl::string_view operation);
 
   // Creates an aggregation intrinsic based on the intrinsic configuration and
   // optional serialized state.
   static absl::StatusOr<std::unique_ptr<TensorAggregator>> CreateAggregator(
-      const Intrinsic& intrinsic, const std::string* serialized_aggregator);
+      const Intrinsic& intrinsic, std::string* serialized_aggregator);
+
+  // Creates the aggregators for all intrinsics. The serialized aggregators are
+  // moved out of the optional `aggregator_state`.
+  static absl::StatusOr<std::vector<std::unique_ptr<TensorAggregator>>>
+  CreateAggregators(const std::vector<Intrinsic>& intrinsics,
+                    CheckpointAggregatorState* aggregator_state);
+
+  // Creates the aggregators of a shard, on the CPUs of its NUMA node if the
+  // shards are spread across several nodes.
+  static absl::StatusOr<std::vector<std::unique_ptr<TensorAggregator>>>
+  CreateShardAggregators(const std::vector<Intrinsic>& intrinsics,
+                         CheckpointAggregatorState* aggregator_state,
+                         int numa_node, int num_numa_nodes);
+
+  // Creates `num_shards` shards spread across `num_numa_nodes` NUMA nodes,
+  // the first of which is restored from the optional `aggregator_state`.
+  static absl::StatusOr<std::vector<std::unique_ptr<Shard>>> CreateShards(
+      const std::vector<Intrinsic>& intrinsics,
+      CheckpointAggregatorState* aggregator_state, int num_shards,
+      int num_numa_nodes);
 
   static absl::StatusOr<std::unique_ptr<CheckpointAggregator>> CreateInternal(
       const Configuration& configuration,
-      const CheckpointAggregatorState* aggregator_state);
+      CheckpointAggregatorState* aggregator_state, int num_shards,
+      int num_numa_nodes = 1);
 
   static absl::StatusOr<std::unique_ptr<CheckpointAggregator>> CreateInternal(
       const std::vector<Intrinsic>* intrinsics,
-      const CheckpointAggregatorState* aggregator_state);
+      CheckpointAggregatorState* aggregator_state, int num_shards,
+      int num_numa_nodes = 1);
+
+  // Merges the aggregators of all shards into the first shard. If
+  // `reset_merged_shards` is true, the other shards get new empty aggregators
+  // so that accumulation can continue; otherwise they are left empty.
+  absl::Status MergeShards(bool reset_merged_shards) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(aggregation_mu_);
+
+  // Locks and returns a shard for Accumulate, preferring one that isn't
+  // locked by another Accumulate call. Only the shards of the NUMA node are
+  // considered unless `numa_node` is negative. The caller must unlock the
+  // shard.
+  Shard& AcquireShard(int numa_node)
+      ABSL_SHARED_LOCKS_REQUIRED(aggregation_mu_);
+
+  // Checks that the `aggregators` can report, then consumes them and adds
+  // their outputs to the checkpoint.
+  absl::Status ReportAggregators(
+      std::vector<std::unique_ptr<TensorAggregator>>& aggregators,
+      CheckpointBuilder& checkpoint_builder) const;
+
+  // A checkpoint queued by AccumulateAsync.
+  struct PendingAccumulation {
+    std::unique_ptr<CheckpointParser> checkpoint_parser;
+    std::function<void(absl::Status)> done;
+  };
+
+  // Maximum number of queued checkpoints accumulated together by
+  // AccumulateAsync.
+  static constexpr size_t kMaxAsyncAccumulationBatchSize = 64;
+
+  // Accumulates the checkpoints queued by AccumulateAsync, one batch at a
+  // time, until the queue is empty. At most one call runs at a time.
+  void DrainAsyncAccumulations() ABSL_LOCKS_EXCLUDED(async_mu_);
+
+  // Accumulates a batch of queued checkpoints and calls their callbacks.
+  void AccumulatePending(std::vector<PendingAccumulation> batch);
+
+  // Consumes the `aggregators` and encodes their states as a
+  // CheckpointAggregatorState.
+  static absl::StatusOr<absl::Cord> SerializeAggregators(
+      std::vector<std::unique_ptr<TensorAggregator>>& aggregators);
 
   // Used by the implementation of Merge.
   std::vector<std::unique_ptr<TensorAggregator>> TakeAggregators() &&;
 
-  // Protects calls into the aggregators.
+  // Held in shared mode by Accumulate, which then locks a single shard, and in
+  // exclusive mode by all operations that access every shard.
   mutable absl::Mutex aggregation_mu_;
 
-  // Intrinsics owned by the CheckpointAggregator. These should not be used
+  // Intrinsics owned by the CheckpointAggregator, possibly shared with other
+  // instances created from the same Configuration. These should not be used
   // directly, and instead should be accessed through `intrinsics_` which will
   // point to `owned_intrinsics_` if it is present.
-  std::optional<std::vector<Intrinsic>> const owned_intrinsics_;
+  const std::shared_ptr<const std::vector<Intrinsic>> owned_intrinsics_;
   // The intrinsics vector need not be guarded by the mutex, as accessing
   // immutable state can happen concurrently.
   const std::vector<Intrinsic>& intrinsics_;
-  // TensorAggregators are not thread safe and must be protected by a mutex.
-  std::vector<std::unique_ptr<TensorAggregator>> aggregators_
-      ABSL_GUARDED_BY(aggregation_mu_);
+  const InputLayout input_layout_;
+  const std::shared_ptr<const TensorBindingPlan> binding_plan_;
+  // Latency histograms of the Accumulate and Report calls of each intrinsic.
+  const std::vector<LatencyHistogram*> accumulate_latency_;
+  const std::vector<LatencyHistogram*> report_latency_;
+  // TensorAggregators are not thread safe and must be protected by the mutex
+  // of their shard. The shards are never added or removed after construction.
+  // Merging shards doesn't change the aggregation result, so const methods
+  // may merge them.
+  const std::vector<std::unique_ptr<Shard>> shards_;
+  // Number of NUMA nodes the shards are spread across. Shard `i` is on node
+  // `i % num_numa_nodes_`.
+  const int num_numa_nodes_;
+  // Index of the shard on which the next Accumulate call starts looking for
+  // an unlocked shard.
+  std::atomic<size_t> next_shard_ = 0;
+  // Total time Accumulate calls have waited to lock a shard, in nanoseconds.
+  std::atomic<int64_t> accumulate_lock_wait_nanos_ = 0;
+  // Parallel Report settings, see SetParallelReport.
+  Scheduler* report_scheduler_ = nullptr;
+  int num_report_tasks_ = 1;
+  // State of AccumulateAsync. Only one DrainAsyncAccumulations task is
+  // scheduled at a time, so that the queued checkpoints are accumulated in
+  // order and in batches.
+  absl::Mutex async_mu_;
+  Scheduler* async_scheduler_ ABSL_GUARDED_BY(async_mu_) = nullptr;
+  std::deque<PendingAccumulation> async_queue_ ABSL_GUARDED_BY(async_mu_);
+  bool async_drain_scheduled_ ABSL_GUARDED_BY(async_mu_) = false;
+  // Memory budget set by SetMemoryBudget, or 0 for no limit.
+  std::atomic<size_t> memory_budget_ = 0;
   // This indicates that the aggregation has finished either by producing the
   // report or by destroying this instance.
   // This field is atomic is to allow the Abort() method to work promptly
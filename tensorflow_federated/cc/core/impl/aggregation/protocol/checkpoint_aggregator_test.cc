@@ -17,6 +17,7 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_aggregator.h"
 
 #include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -31,13 +32,20 @@
 #include "googletest/include/gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/agg_vector_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
@@ -57,6 +65,7 @@ namespace {
 
 using ::testing::AnyOf;
 using ::testing::ByMove;
+using ::testing::InSequence;
 using ::testing::Invoke;
 using ::testing::Return;
 using ::testing::StrEq;
@@ -452,6 +461,292 @@ TEST(CheckpointAggregatorTest, AccumulateSuccess) {
   EXPECT_OK(aggregator->Accumulate(parser));
 }
 
+TEST(CheckpointAggregatorTest, AccumulateBatchSuccess) {
+  auto aggregator = CreateWithDefaultConfig();
+  MockCheckpointParser parser1;
+  EXPECT_CALL(parser1, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  MockCheckpointParser parser2;
+  EXPECT_CALL(parser2, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({3}));
+  }));
+  CheckpointParser* parsers[] = {&parser1, &parser2};
+  EXPECT_OK(aggregator->AccumulateBatch(parsers));
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {5})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+}
+
+TEST(CheckpointAggregatorTest, AccumulateBatchMismatchingTensor) {
+  auto aggregator = CreateWithDefaultConfig();
+  MockCheckpointParser parser1;
+  EXPECT_CALL(parser1, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  MockCheckpointParser parser2;
+  EXPECT_CALL(parser2, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_FLOAT, {}, CreateTestData({3.f}));
+  }));
+  CheckpointParser* parsers[] = {&parser1, &parser2};
+  EXPECT_THAT(aggregator->AccumulateBatch(parsers),
+              StatusIs(INVALID_ARGUMENT));
+
+  // None of the checkpoints of the batch is accumulated.
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {0})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+}
+
+std::unique_ptr<MockCheckpointParser> CreateInt32Parser(int value) {
+  auto parser = std::make_unique<MockCheckpointParser>();
+  EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([value] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({value}));
+  }));
+  return parser;
+}
+
+TEST(CheckpointAggregatorTest, AccumulateAsyncSuccess) {
+  const int kNumInputs = 100;
+  auto aggregator = CreateWithDefaultConfig();
+  auto scheduler = CreateThreadPoolScheduler(4);
+  aggregator->SetAsyncAccumulation(scheduler.get());
+
+  absl::BlockingCounter num_pending(kNumInputs);
+  for (int i = 1; i <= kNumInputs; ++i) {
+    aggregator->AccumulateAsync(CreateInt32Parser(i),
+                                [&num_pending](absl::Status status) {
+                                  EXPECT_OK(status);
+                                  num_pending.DecrementCount();
+                                });
+  }
+  num_pending.Wait();
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {5050})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+  scheduler->WaitUntilIdle();
+}
+
+TEST(CheckpointAggregatorTest, AccumulateAsyncMismatchingTensor) {
+  auto aggregator = CreateWithDefaultConfig();
+  auto scheduler = CreateThreadPoolScheduler(1);
+  aggregator->SetAsyncAccumulation(scheduler.get());
+
+  auto mismatching_parser = std::make_unique<MockCheckpointParser>();
+  EXPECT_CALL(*mismatching_parser, GetTensor(StrEq("foo")))
+      .WillOnce(Invoke(
+          [] { return Tensor::Create(DT_FLOAT, {}, CreateTestData({3.f})); }));
+  absl::BlockingCounter num_pending(3);
+  auto expect_ok = [&num_pending](absl::Status status) {
+    EXPECT_OK(status);
+    num_pending.DecrementCount();
+  };
+  aggregator->AccumulateAsync(CreateInt32Parser(2), expect_ok);
+  aggregator->AccumulateAsync(std::move(mismatching_parser),
+                              [&num_pending](absl::Status status) {
+                                EXPECT_THAT(status,
+                                            StatusIs(INVALID_ARGUMENT));
+                                num_pending.DecrementCount();
+                              });
+  aggregator->AccumulateAsync(CreateInt32Parser(4), expect_ok);
+  num_pending.Wait();
+
+  // Only the mismatching checkpoint is rejected.
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {6})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+  scheduler->WaitUntilIdle();
+}
+
+std::unique_ptr<MockCheckpointParser> CreateFedSqlParser(
+    std::vector<float> keys, std::vector<float> values) {
+  auto parser = std::make_unique<MockCheckpointParser>();
+  EXPECT_CALL(*parser, GetTensor(StrEq("key1"))).WillOnce(Invoke([keys] {
+    return Tensor::Create(DT_FLOAT, {static_cast<int64_t>(keys.size())},
+                          std::make_unique<MutableVectorData<float>>(keys));
+  }));
+  EXPECT_CALL(*parser, GetTensor(StrEq("val1"))).WillOnce(Invoke([values] {
+    return Tensor::Create(DT_FLOAT, {static_cast<int64_t>(values.size())},
+                          std::make_unique<MutableVectorData<float>>(values));
+  }));
+  return parser;
+}
+
+TEST(CheckpointAggregatorTest, AccumulateAsyncRejectedByTensorAggregator) {
+  auto aggregator = CreateWithDefaultFedSqlConfig();
+  auto scheduler = CreateThreadPoolScheduler(1);
+  aggregator->SetAsyncAccumulation(scheduler.get());
+
+  // Block the scheduler so that all checkpoints are accumulated in one batch.
+  absl::Notification unblock;
+  scheduler->Schedule([&unblock] { unblock.WaitForNotification(); });
+  absl::BlockingCounter num_pending(3);
+  auto expect_ok = [&num_pending](absl::Status status) {
+    EXPECT_OK(status);
+    num_pending.DecrementCount();
+  };
+  aggregator->AccumulateAsync(CreateFedSqlParser({1.f}, {1.f}), expect_ok);
+  // Matches the input specs, but the group by aggregator rejects the values
+  // whose shape differs from the keys.
+  aggregator->AccumulateAsync(CreateFedSqlParser({1.f, 2.f}, {5.f}),
+                              [&num_pending](absl::Status status) {
+                                EXPECT_THAT(status,
+                                            StatusIs(INVALID_ARGUMENT));
+                                num_pending.DecrementCount();
+                              });
+  aggregator->AccumulateAsync(CreateFedSqlParser({1.f}, {2.f}), expect_ok);
+  unblock.Notify();
+  num_pending.Wait();
+
+  // Only the rejected checkpoint is left out of the aggregate.
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("key1_out"), IsTensor<float>({1}, {1.f})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(builder, Add(StrEq("val1_out"), IsTensor<float>({1}, {3.f})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+  scheduler->WaitUntilIdle();
+}
+
+TEST(CheckpointAggregatorTest, AccumulateAsyncWithoutScheduler) {
+  auto aggregator = CreateWithDefaultConfig();
+  bool done = false;
+  aggregator->AccumulateAsync(CreateInt32Parser(2), [&done](absl::Status s) {
+    EXPECT_OK(s);
+    done = true;
+  });
+  EXPECT_TRUE(done);
+}
+
+TEST(CheckpointAggregatorTest, AccumulateAsyncAfterAbort) {
+  auto aggregator = CreateWithDefaultConfig();
+  auto scheduler = CreateThreadPoolScheduler(1);
+  aggregator->SetAsyncAccumulation(scheduler.get());
+  aggregator->Abort();
+  absl::Notification done;
+  auto parser = std::make_unique<MockCheckpointParser>();
+  EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillRepeatedly(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  aggregator->AccumulateAsync(std::move(parser), [&done](absl::Status status) {
+    EXPECT_THAT(status, StatusIs(ABORTED));
+    done.Notify();
+  });
+  done.WaitForNotification();
+  scheduler->WaitUntilIdle();
+}
+
+TEST(CheckpointAggregatorTest, GetMemoryUsage) {
+  auto aggregator = CreateWithDefaultConfig();
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  EXPECT_OK(aggregator->Accumulate(parser));
+  // The state of a scalar int32 sum.
+  EXPECT_EQ(aggregator->GetMemoryUsage(), 4);
+  EXPECT_GE(aggregator->GetAccumulateLockWaitTime(), absl::ZeroDuration());
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {2})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+  EXPECT_EQ(aggregator->GetMemoryUsage(), 0);
+}
+
+TEST(CheckpointAggregatorTest, AccumulateRejectsInputsOverMemoryBudget) {
+  auto aggregator = CreateWithDefaultConfig();
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillRepeatedly(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  aggregator->SetMemoryBudget(3);
+  // The first input takes the state over the budget.
+  EXPECT_OK(aggregator->Accumulate(parser));
+  EXPECT_THAT(aggregator->Accumulate(parser), StatusIs(RESOURCE_EXHAUSTED));
+  aggregator->SetMemoryBudget(4);
+  EXPECT_OK(aggregator->Accumulate(parser));
+  aggregator->SetMemoryBudget(0);
+  EXPECT_OK(aggregator->Accumulate(parser));
+
+  // The rejected input isn't included in the report.
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {6})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+}
+
+TEST(CheckpointAggregatorTest, AccumulateAndReportRecordLatencies) {
+  LatencyHistogram* accumulate_latency =
+      MetricsRegistry::Default().GetLatencyHistogram(
+          "CheckpointAggregator::Accumulate/federated_sum");
+  LatencyHistogram* report_latency =
+      MetricsRegistry::Default().GetLatencyHistogram(
+          "CheckpointAggregator::Report/federated_sum");
+  int64_t accumulate_count = accumulate_latency->count();
+  int64_t report_count = report_latency->count();
+  auto aggregator = CreateWithDefaultConfig();
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillRepeatedly(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  // Nothing is recorded while metrics are disabled.
+  EXPECT_OK(aggregator->Accumulate(parser));
+  SetMetricsEnabled(true);
+  EXPECT_OK(aggregator->Accumulate(parser));
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {4})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+  SetMetricsEnabled(false);
+  EXPECT_EQ(accumulate_latency->count(), accumulate_count + 1);
+  EXPECT_EQ(report_latency->count(), report_count + 1);
+}
+
+// Two intrinsics that take the same input tensor, which must only be parsed
+// once per checkpoint.
+Configuration shared_input_configuration(DataType second_input_dtype) {
+  Configuration config = default_configuration();
+  Configuration::IntrinsicConfig* intrinsic = config.add_intrinsic_configs();
+  *intrinsic = config.intrinsic_configs(0);
+  intrinsic->mutable_intrinsic_args(0)->mutable_input_tensor()->set_dtype(
+      second_input_dtype);
+  intrinsic->mutable_output_tensors(0)->set_name("foo_out2");
+  intrinsic->mutable_output_tensors(0)->set_dtype(second_input_dtype);
+  return config;
+}
+
+TEST(CheckpointAggregatorTest, AccumulateSharedInputTensor) {
+  auto aggregator = Create(shared_input_configuration(DT_INT32));
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  EXPECT_OK(aggregator->Accumulate(parser));
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {2})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(builder, Add(StrEq("foo_out2"), IsTensor<int32_t>({}, {2})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+}
+
+TEST(CheckpointAggregatorTest, AccumulateSharedInputTensorMismatchingSpec) {
+  auto aggregator = Create(shared_input_configuration(DT_FLOAT));
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  EXPECT_THAT(aggregator->Accumulate(parser), StatusIs(INVALID_ARGUMENT));
+}
+
 TEST(CheckpointAggregatorTest, AccumulateAfterReport) {
   auto aggregator = CreateWithDefaultConfig();
 
@@ -598,6 +893,111 @@ TEST_P(CheckpointAggregatorTest, ReportMultipleTensors) {
   EXPECT_OK(aggregator->Report(builder));
 }
 
+TEST(CheckpointAggregatorTest, ParallelReportAddsOutputsInOrder) {
+  // The intrinsics are created directly rather than from a Configuration,
+  // which would fuse the sums into a single intrinsic.
+  const int kNumIntrinsics = 8;
+  std::vector<Intrinsic> intrinsics;
+  for (int i = 0; i < kNumIntrinsics; ++i) {
+    intrinsics.push_back(
+        {"federated_sum",
+         {TensorSpec(absl::StrCat("foo", i), DT_INT32, {})},
+         {TensorSpec(absl::StrCat("foo", i, "_out"), DT_INT32, {})},
+         {},
+         {}});
+  }
+  auto aggregator = CheckpointAggregator::Create(&intrinsics).value();
+  auto scheduler = CreateThreadPoolScheduler(4);
+  aggregator->SetParallelReport(scheduler.get(), /*num_tasks=*/4);
+
+  MockCheckpointParser parser;
+  for (int i = 0; i < kNumIntrinsics; ++i) {
+    EXPECT_CALL(parser, GetTensor(StrEq(absl::StrCat("foo", i))))
+        .WillOnce(Invoke([i] {
+          return Tensor::Create(DT_INT32, {}, CreateTestData({i}));
+        }));
+  }
+  EXPECT_OK(aggregator->Accumulate(parser));
+
+  MockCheckpointBuilder builder;
+  {
+    InSequence sequence;
+    for (int i = 0; i < kNumIntrinsics; ++i) {
+      EXPECT_CALL(builder, Add(StrEq(absl::StrCat("foo", i, "_out")),
+                               IsTensor<int32_t>({}, {i})))
+          .WillOnce(Return(absl::OkStatus()));
+    }
+  }
+  EXPECT_OK(aggregator->Report(builder));
+  // The scheduler must be idle when it is destroyed.
+  scheduler->WaitUntilIdle();
+}
+
+TEST(CheckpointAggregatorTest, ReportSnapshotThenContinueAccumulating) {
+  auto aggregator = CreateWithDefaultConfig();
+  MockCheckpointParser parser1;
+  EXPECT_CALL(parser1, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({2}));
+  }));
+  EXPECT_OK(aggregator->Accumulate(parser1));
+
+  MockCheckpointBuilder snapshot_builder;
+  EXPECT_CALL(snapshot_builder,
+              Add(StrEq("foo_out"), IsTensor<int32_t>({}, {2})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->ReportSnapshot(snapshot_builder));
+
+  MockCheckpointParser parser2;
+  EXPECT_CALL(parser2, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({3}));
+  }));
+  EXPECT_OK(aggregator->Accumulate(parser2));
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {5})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+}
+
+TEST(CheckpointAggregatorTest, SerializeDeltaThenMergeIntoRoot) {
+  auto root = CreateWithDefaultConfig();
+  auto leaf = CheckpointAggregator::Create(default_configuration(),
+                                          /*num_shards=*/2)
+                  .value();
+  for (int value : {1, 2, 4}) {
+    MockCheckpointParser parser;
+    EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([value] {
+      return Tensor::Create(DT_INT32, {}, CreateTestData({value}));
+    }));
+    EXPECT_OK(leaf->Accumulate(parser));
+    // Each delta only holds the inputs accumulated since the previous one.
+    absl::StatusOr<absl::Cord> delta = leaf->SerializeDelta();
+    ASSERT_OK(delta);
+    EXPECT_OK(root->MergeSerialized(*delta));
+  }
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {7})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(root->Report(builder));
+  EXPECT_THAT(root->SerializeDelta(), StatusIs(ABORTED));
+}
+
+TEST(CheckpointAggregatorTest, MergeSerializedMissingAggregatorState) {
+  auto aggregator = CreateWithDefaultConfig();
+  EXPECT_THAT(aggregator->MergeSerialized(absl::Cord()),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(CheckpointAggregatorTest, ReportSnapshotAfterReport) {
+  auto aggregator = CreateWithDefaultConfig();
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {0})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+  EXPECT_THAT(aggregator->ReportSnapshot(builder), StatusIs(ABORTED));
+}
+
 TEST(CheckpointAggregatorTest, ReportAfterReport) {
   auto aggregator = CreateWithDefaultConfig();
 
@@ -916,6 +1316,114 @@ TEST(CheckpointAggregatorTest, ConcurrentAccumulationSuccess) {
   EXPECT_OK(aggregator->Report(builder));
 }
 
+TEST(CheckpointAggregatorTest, CreateWithInvalidNumShards) {
+  EXPECT_THAT(CheckpointAggregator::Create(default_configuration(),
+                                           /*num_shards=*/0),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(CheckpointAggregatorTest, ShardedConcurrentAccumulationSuccess) {
+  const int64_t kNumInputs = 100;
+  auto aggregator =
+      CheckpointAggregator::Create(default_configuration(), /*num_shards=*/4)
+          .value();
+
+  std::atomic<int> tensor_value = 0;
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillRepeatedly(Invoke([&] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({++tensor_value}));
+  }));
+
+  auto scheduler = CreateThreadPoolScheduler(4);
+  for (int64_t i = 0; i < kNumInputs; ++i) {
+    scheduler->Schedule([&]() { EXPECT_OK(aggregator->Accumulate(parser)); });
+  }
+  scheduler->WaitUntilIdle();
+
+  // Checking whether the aggregation can report merges the shards, after which
+  // accumulation can continue.
+  EXPECT_TRUE(aggregator->CanReport());
+  EXPECT_OK(aggregator->Accumulate(parser));
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {5151})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+}
+
+TEST(CheckpointAggregatorTest, ShardedSerializeAndMergeSuccess) {
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillRepeatedly(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({3}));
+  }));
+
+  // Sequential inputs are assigned to the shards in turn.
+  auto aggregator1 =
+      CheckpointAggregator::Create(default_configuration(), /*num_shards=*/3)
+          .value();
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_OK(aggregator1->Accumulate(parser));
+  }
+  auto serialized_state = std::move(*aggregator1).Serialize().value();
+  aggregator1 = CheckpointAggregator::Deserialize(default_configuration(),
+                                                  serialized_state,
+                                                  /*num_shards=*/2)
+                    .value();
+  EXPECT_OK(aggregator1->Accumulate(parser));
+
+  auto aggregator2 =
+      CheckpointAggregator::Create(default_configuration(), /*num_shards=*/2)
+          .value();
+  EXPECT_OK(aggregator2->Accumulate(parser));
+  EXPECT_OK(aggregator2->Accumulate(parser));
+  EXPECT_OK(aggregator1->MergeWith(std::move(*aggregator2)));
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {24})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator1->Report(builder));
+}
+
+TEST(CheckpointAggregatorTest, CreateWithInvalidNumNumaNodes) {
+  EXPECT_THAT(CheckpointAggregator::Create(default_configuration(),
+                                           /*num_shards=*/2,
+                                           /*num_numa_nodes=*/0),
+              StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(CheckpointAggregator::Create(default_configuration(),
+                                           /*num_shards=*/2,
+                                           /*num_numa_nodes=*/3),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(CheckpointAggregatorTest, AccumulateOnNumaNodeSuccess) {
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillRepeatedly(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({3}));
+  }));
+
+  // The shards are placed on the nodes even when the host has fewer nodes.
+  auto aggregator =
+      CheckpointAggregator::Create(default_configuration(), /*num_shards=*/3,
+                                   /*num_numa_nodes=*/2)
+          .value();
+  EXPECT_EQ(aggregator->num_numa_nodes(), 2);
+  EXPECT_OK(aggregator->AccumulateOnNumaNode(parser, 0));
+  EXPECT_OK(aggregator->AccumulateOnNumaNode(parser, 0));
+  EXPECT_OK(aggregator->AccumulateOnNumaNode(parser, 1));
+  EXPECT_OK(aggregator->Accumulate(parser));
+  EXPECT_THAT(aggregator->AccumulateOnNumaNode(parser, 2),
+              StatusIs(INVALID_ARGUMENT));
+
+  // Merging the shards resets them on their nodes.
+  EXPECT_TRUE(aggregator->CanReport());
+  EXPECT_OK(aggregator->AccumulateOnNumaNode(parser, 1));
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {15})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK(aggregator->Report(builder));
+}
+
 // A trivial test aggregator that delegates aggregation to a function.
 class FunctionAggregator final : public AggVectorAggregator<int> {
  public:
@@ -1038,6 +1546,66 @@ TEST(CheckpointAggregatorTest, DeserializeInvalidState) {
               StatusIs(INVALID_ARGUMENT));
 }
 
+TEST(CheckpointAggregatorTest, DeserializeMissingAggregatorState) {
+  // A valid state without any aggregator doesn't match the configuration.
+  EXPECT_THAT(CheckpointAggregator::Deserialize(default_configuration(), ""),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(CheckpointAggregatorTest, SerializeToCordMatchesSerialize) {
+  auto aggregator1 = CreateWithDefaultFedSqlConfig();
+  auto aggregator2 = CreateWithDefaultFedSqlConfig();
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("key1"))).WillRepeatedly(Invoke([] {
+    return Tensor::Create(DT_FLOAT, {3}, CreateTestData<float>({1, 2, 1}));
+  }));
+  EXPECT_CALL(parser, GetTensor(StrEq("val1"))).WillRepeatedly(Invoke([] {
+    return Tensor::Create(DT_FLOAT, {3}, CreateTestData<float>({4, 5, 6}));
+  }));
+  EXPECT_OK(aggregator1->Accumulate(parser));
+  EXPECT_OK(aggregator2->Accumulate(parser));
+
+  absl::StatusOr<absl::Cord> cord_state =
+      std::move(*aggregator1).SerializeToCord();
+  absl::StatusOr<std::string> string_state =
+      std::move(*aggregator2).Serialize();
+  ASSERT_OK(cord_state);
+  ASSERT_OK(string_state);
+  EXPECT_EQ(*cord_state, *string_state);
+}
+
+TEST(CheckpointAggregatorTest, DeserializeFromExternalCordSuccess) {
+  auto aggregator = CreateWithDefaultConfig();
+  MockCheckpointParser parser;
+  EXPECT_CALL(parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({7}));
+  }));
+  EXPECT_OK(aggregator->Accumulate(parser));
+  std::string buffer(std::move(*aggregator).SerializeToCord().value());
+
+  // Simulate a state read from external memory, e.g. a memory-mapped file, in
+  // two chunks.
+  const size_t split = buffer.size() / 2;
+  absl::Cord serialized_state = absl::MakeCordFromExternal(
+      absl::string_view(buffer).substr(0, split), [] {});
+  serialized_state.Append(absl::MakeCordFromExternal(
+      absl::string_view(buffer).substr(split), [] {}));
+  auto restored = CheckpointAggregator::Deserialize(default_configuration(),
+                                                    serialized_state);
+  ASSERT_OK(restored);
+
+  MockCheckpointBuilder builder;
+  EXPECT_CALL(builder, Add(StrEq("foo_out"), IsTensor<int32_t>({}, {7})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_OK((*restored)->Report(builder));
+}
+
+TEST(CheckpointAggregatorTest, DeserializeInvalidCordState) {
+  EXPECT_THAT(CheckpointAggregator::Deserialize(default_configuration(),
+                                                absl::Cord("invalid")),
+              StatusIs(INVALID_ARGUMENT));
+}
+
 INSTANTIATE_TEST_SUITE_P(
     CheckpointAggregatorTestInstantiation, CheckpointAggregatorTest,
     testing::ValuesIn<bool>({false, true}),
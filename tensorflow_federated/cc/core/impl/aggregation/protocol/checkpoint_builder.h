@@ -19,6 +19,8 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
@@ -35,6 +37,14 @@ class CheckpointBuilder {
   // Adds a tensor to the checkpoint.
   virtual absl::Status Add(const std::string& name, const Tensor& tensor) = 0;
 
+  // Adds a tensor to the checkpoint, transferring its ownership to the
+  // builder. Implementations may then reference the tensor data from the
+  // checkpoint rather than copy it. By default the tensor is added as a const
+  // reference.
+  virtual absl::Status Add(const std::string& name, Tensor&& tensor) {
+    return Add(name, std::as_const(tensor));
+  }
+
   // Builds and formats the checkpoint.
   virtual absl::StatusOr<absl::Cord> Build() = 0;
 };
@@ -17,9 +17,50 @@
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CHECKPOINT_HEADER_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CHECKPOINT_HEADER_H_
 
+#include <cstddef>
+#include <cstdint>
+
 namespace tensorflow_federated::aggregation {
 inline constexpr const char kFederatedComputeCheckpointHeader[] = "FCv1";
 
+// Header of the aligned columnar version of the federated compute wire format.
+// The header is followed by the tensor directory:
+//
+//   varint num_tensors
+//   for each tensor:
+//     varint name_size, name
+//     varint dtype, varint rank, rank x varint dim_size
+//     varint values_offset, varint values_size
+//     varint flags
+//     if flags & kSparseTensorFlag: varint indices_offset, varint indices_size
+//     if flags & kDictionaryTensorFlag:
+//       varint dictionary_size, varint codes_offset, varint codes_size
+//
+// The directory is followed by zero padding up to the data section, which
+// starts at the first multiple of kFederatedComputeCheckpointV2Alignment bytes
+// from the start of the checkpoint. Offsets are relative to the data section
+// and are multiples of the alignment as well.
+//
+// Numeric values and the int64 dense indices of sparse tensors are stored as
+// raw little-endian arrays. The values of a string tensor with N elements are
+// stored as an offset table of N + 1 little-endian uint64 followed by the bytes
+// of the strings, where the i-th string spans [offset[i], offset[i + 1]) from
+// the end of the table.
+//
+// The values of a dictionary encoded string tensor are instead the strings of
+// its dictionary, stored like the values of a string tensor with
+// dictionary_size elements, and each element is given by a little-endian
+// int32 code indexing the dictionary.
+inline constexpr const char kFederatedComputeCheckpointV2Header[] = "FCv2";
+inline constexpr size_t kFederatedComputeCheckpointV2Alignment = 64;
+inline constexpr uint64_t kSparseTensorFlag = 1;
+inline constexpr uint64_t kDictionaryTensorFlag = 2;
+
+// Header of a compression envelope around a checkpoint of any format. The
+// header is followed by a varint CheckpointCompression algorithm, the varint
+// size of the uncompressed checkpoint and the compressed stream.
+inline constexpr const char kCompressedCheckpointHeader[] = "FCz1";
+
 }  // namespace tensorflow_federated::aggregation
 
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CHECKPOINT_HEADER_H_
@@ -17,12 +17,18 @@
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CHECKPOINT_PARSER_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CHECKPOINT_PARSER_H_
 
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <utility>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/tensor_binding_plan.h"
 
 namespace tensorflow_federated::aggregation {
 
@@ -34,6 +40,19 @@ class CheckpointParser {
 
   // Gets a tensor by name.
   virtual absl::StatusOr<Tensor> GetTensor(const std::string& name) = 0;
+
+  // Gets the tensors bound by `plan` into their slots of `tensors`, which has
+  // a slot per tensor of the plan. Parsers created for `plan` with
+  // CheckpointParserFactory::CreateWithBindingPlan may move the tensors out of
+  // the slots they were parsed into; the default implementation calls
+  // GetTensor with the name of each slot.
+  virtual absl::Status GetTensors(const TensorBindingPlan& plan,
+                                  absl::Span<Tensor> tensors) {
+    for (size_t slot = 0; slot < plan.size(); ++slot) {
+      TFF_ASSIGN_OR_RETURN(tensors[slot], GetTensor(plan.name(slot)));
+    }
+    return absl::OkStatus();
+  }
 };
 
 // Describes an abstract factory for creating instances of CheckpointParser.
@@ -45,6 +64,16 @@ class CheckpointParserFactory {
   // checkpoint content.
   virtual absl::StatusOr<std::unique_ptr<CheckpointParser>> Create(
       const absl::Cord& serialized_checkpoint) const = 0;
+
+  // Creates an instance of CheckpointParser that only needs to provide the
+  // tensors bound by `plan`, which it may put into fixed slots while parsing
+  // the checkpoint and skip the other tensors. The default implementation
+  // ignores the plan.
+  virtual absl::StatusOr<std::unique_ptr<CheckpointParser>>
+  CreateWithBindingPlan(const absl::Cord& serialized_checkpoint,
+                        std::shared_ptr<const TensorBindingPlan> plan) const {
+    return Create(serialized_checkpoint);
+  }
 };
 
 }  // namespace tensorflow_federated::aggregation
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/compressed_checkpoint.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_header.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/cord_reader.h"
+#include "zlib.h"
+
+namespace tensorflow_federated::aggregation {
+
+namespace {
+
+// Size of the blocks the compressed stream is written in.
+constexpr size_t kCompressedBlockSize = 64 << 10;
+
+// The decompressed checkpoint is aligned like the data section of an aligned
+// checkpoint, so that its tensors can alias it.
+constexpr std::align_val_t kDecompressedAlignment{
+    kFederatedComputeCheckpointV2Alignment};
+
+// zlib counts the bytes of each input and output range with a uInt.
+constexpr size_t kMaxZlibRangeSize = std::numeric_limits<uInt>::max();
+
+absl::Status ZlibError(const char* operation, int code) {
+  return absl::InternalError(
+      absl::StrFormat("Failed to %s checkpoint: zlib error %d", operation,
+                      code));
+}
+
+// Builds the checkpoint of the wrapped builder and compresses it.
+class CompressingCheckpointBuilder final : public CheckpointBuilder {
+ public:
+  CompressingCheckpointBuilder(std::unique_ptr<CheckpointBuilder> builder,
+                               CheckpointCompression compression)
+      : builder_(std::move(builder)), compression_(compression) {}
+
+  absl::Status Add(const std::string& name, const Tensor& tensor) override {
+    return builder_->Add(name, tensor);
+  }
+
+  absl::Status Add(const std::string& name, Tensor&& tensor) override {
+    return builder_->Add(name, std::move(tensor));
+  }
+
+  absl::StatusOr<absl::Cord> Build() override {
+    TFF_ASSIGN_OR_RETURN(absl::Cord checkpoint, builder_->Build());
+    return CompressCheckpoint(checkpoint, compression_);
+  }
+
+ private:
+  std::unique_ptr<CheckpointBuilder> builder_;
+  const CheckpointCompression compression_;
+};
+
+}  // namespace
+
+bool IsCompressedCheckpoint(const absl::Cord& checkpoint) {
+  return checkpoint.StartsWith(kCompressedCheckpointHeader);
+}
+
+absl::StatusOr<absl::Cord> CompressCheckpoint(
+    const absl::Cord& checkpoint, CheckpointCompression compression) {
+  if (compression != CheckpointCompression::kDeflate) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported checkpoint compression %d",
+                        static_cast<uint64_t>(compression)));
+  }
+  std::string envelope;
+  {
+    google::protobuf::io::StringOutputStream out(&envelope);
+    google::protobuf::io::CodedOutputStream coded_out(&out);
+    coded_out.WriteRaw(kCompressedCheckpointHeader, 4);
+    coded_out.WriteVarint64(static_cast<uint64_t>(compression));
+    coded_out.WriteVarint64(checkpoint.size());
+    coded_out.Trim();
+  }
+  absl::Cord result(std::move(envelope));
+
+  z_stream stream = {};
+  int code = deflateInit(&stream, Z_DEFAULT_COMPRESSION);
+  if (code != Z_OK) {
+    return ZlibError("compress", code);
+  }
+  std::string block(kCompressedBlockSize, '\0');
+  stream.next_out = reinterpret_cast<Bytef*>(block.data());
+  stream.avail_out = static_cast<uInt>(block.size());
+  // Flushes the output block to the result once it is full, or at the end of
+  // the stream.
+  auto flush_block = [&stream, &block, &result](bool finished) {
+    if (stream.avail_out > 0 && !finished) {
+      return;
+    }
+    block.resize(block.size() - stream.avail_out);
+    if (!block.empty()) {
+      result.Append(std::move(block));
+    }
+    block = std::string(kCompressedBlockSize, '\0');
+    stream.next_out = reinterpret_cast<Bytef*>(block.data());
+    stream.avail_out = static_cast<uInt>(block.size());
+  };
+
+  for (absl::string_view chunk : checkpoint.Chunks()) {
+    while (!chunk.empty()) {
+      const size_t size = std::min(chunk.size(), kMaxZlibRangeSize);
+      stream.next_in =
+          reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+      stream.avail_in = static_cast<uInt>(size);
+      while (stream.avail_in > 0) {
+        code = deflate(&stream, Z_NO_FLUSH);
+        if (code != Z_OK) {
+          deflateEnd(&stream);
+          return ZlibError("compress", code);
+        }
+        flush_block(/*finished=*/false);
+      }
+      chunk.remove_prefix(size);
+    }
+  }
+  do {
+    code = deflate(&stream, Z_FINISH);
+    if (code != Z_OK && code != Z_STREAM_END) {
+      deflateEnd(&stream);
+      return ZlibError("compress", code);
+    }
+    flush_block(/*finished=*/code == Z_STREAM_END);
+  } while (code != Z_STREAM_END);
+  deflateEnd(&stream);
+  return result;
+}
+
+absl::StatusOr<absl::Cord> DecompressCheckpoint(
+    const absl::Cord& compressed_checkpoint, size_t max_size) {
+  CordReader reader(compressed_checkpoint);
+  std::string header;
+  uint64_t compression;
+  uint64_t size;
+  if (!reader.ReadString(4, &header) || !reader.ReadVarint64(&compression) ||
+      !reader.ReadVarint64(&size)) {
+    return absl::InternalError(
+        "Unable to read the envelope of the compressed checkpoint.");
+  }
+  if (header != kCompressedCheckpointHeader) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported checkpoint format: %s", header));
+  }
+  if (compression != static_cast<uint64_t>(CheckpointCompression::kDeflate)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unsupported checkpoint compression %d", compression));
+  }
+  if (size > max_size) {
+    return absl::ResourceExhaustedError(absl::StrFormat(
+        "The decompressed checkpoint size %d exceeds the limit of %d bytes",
+        size, max_size));
+  }
+  absl::Cord compressed;
+  reader.ReadCord(reader.remaining(), &compressed);
+
+  z_stream stream = {};
+  int code = inflateInit(&stream);
+  if (code != Z_OK) {
+    return ZlibError("decompress", code);
+  }
+  // The buffer is owned by the resulting Cord.
+  char* const buffer = static_cast<char*>(
+      ::operator new(std::max<size_t>(size, 1), kDecompressedAlignment));
+  absl::Cord result = absl::MakeCordFromExternal(
+      absl::string_view(buffer, size),
+      [buffer]() { ::operator delete(buffer, kDecompressedAlignment); });
+  size_t written = 0;
+  // Receives the data beyond the recorded size, if any.
+  char overflow;
+  code = Z_OK;
+  for (absl::string_view chunk : compressed.Chunks()) {
+    while (!chunk.empty() && code == Z_OK) {
+      const size_t in_size = std::min(chunk.size(), kMaxZlibRangeSize);
+      stream.next_in =
+          reinterpret_cast<Bytef*>(const_cast<char*>(chunk.data()));
+      stream.avail_in = static_cast<uInt>(in_size);
+      while (stream.avail_in > 0 && code == Z_OK) {
+        const bool full = written >= size;
+        stream.next_out =
+            reinterpret_cast<Bytef*>(full ? &overflow : buffer + written);
+        stream.avail_out = static_cast<uInt>(
+            full ? 1 : std::min(size - written, kMaxZlibRangeSize));
+        const uInt avail_out = stream.avail_out;
+        code = inflate(&stream, Z_NO_FLUSH);
+        written += avail_out - stream.avail_out;
+      }
+      chunk.remove_prefix(in_size - stream.avail_in);
+    }
+    if (code != Z_OK) {
+      break;
+    }
+  }
+  inflateEnd(&stream);
+  if (code != Z_STREAM_END || written != size) {
+    return absl::InternalError(
+        "Unable to decompress the checkpoint: the compressed stream is "
+        "corrupted or doesn't match the recorded size.");
+  }
+  if (IsCompressedCheckpoint(result)) {
+    return absl::InvalidArgumentError(
+        "Nested compressed checkpoints are not supported.");
+  }
+  return result;
+}
+
+std::unique_ptr<CheckpointBuilder> CompressingCheckpointBuilderFactory::Create()
+    const {
+  return std::make_unique<CompressingCheckpointBuilder>(factory_->Create(),
+                                                        compression_);
+}
+
+}  // namespace tensorflow_federated::aggregation
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_COMPRESSED_CHECKPOINT_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_COMPRESSED_CHECKPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+
+namespace tensorflow_federated::aggregation {
+
+// Compression algorithms of the checkpoint envelope, see checkpoint_header.h.
+enum class CheckpointCompression : uint64_t {
+  // A zlib stream of the DEFLATE algorithm.
+  kDeflate = 1,
+};
+
+// The default maximum size of a decompressed checkpoint, which bounds the
+// memory a single compressed upload can claim.
+inline constexpr size_t kDefaultMaxDecompressedCheckpointSize = size_t{1}
+                                                                << 30;
+
+// Returns true if `checkpoint` starts with the compression envelope header.
+bool IsCompressedCheckpoint(const absl::Cord& checkpoint);
+
+// Wraps `checkpoint` in a compression envelope. The checkpoint is compressed
+// chunk by chunk without flattening it.
+absl::StatusOr<absl::Cord> CompressCheckpoint(
+    const absl::Cord& checkpoint,
+    CheckpointCompression compression = CheckpointCompression::kDeflate);
+
+// Decompresses a checkpoint wrapped in a compression envelope. The compressed
+// stream is read chunk by chunk and inflated straight into a single aligned
+// buffer of the size recorded in the envelope, so the result is contiguous
+// and the compressed data is never flattened. Returns RESOURCE_EXHAUSTED
+// without allocating if the recorded size exceeds `max_size`.
+absl::StatusOr<absl::Cord> DecompressCheckpoint(
+    const absl::Cord& compressed_checkpoint,
+    size_t max_size = kDefaultMaxDecompressedCheckpointSize);
+
+// A CheckpointBuilderFactory that wraps the checkpoints built by another
+// factory in a compression envelope. The `factory` must outlive this object
+// and build the whole checkpoint in Build() rather than write it to a sink.
+class CompressingCheckpointBuilderFactory : public CheckpointBuilderFactory {
+ public:
+  explicit CompressingCheckpointBuilderFactory(
+      const CheckpointBuilderFactory* factory,
+      CheckpointCompression compression = CheckpointCompression::kDeflate)
+      : factory_(factory), compression_(compression) {}
+
+  std::unique_ptr<CheckpointBuilder> Create() const override;
+
+ private:
+  const CheckpointBuilderFactory* const factory_;
+  const CheckpointCompression compression_;
+};
+
+}  // namespace tensorflow_federated::aggregation
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_COMPRESSED_CHECKPOINT_H_
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/compressed_checkpoint.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_header.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated::aggregation {
+namespace {
+
+// Returns a Cord of `size` compressible bytes made of chunks of at most
+// `chunk_size` bytes.
+absl::Cord CreateFragmentedCord(size_t size, size_t chunk_size) {
+  absl::Cord cord;
+  for (size_t pos = 0; pos < size; pos += chunk_size) {
+    std::string chunk;
+    for (size_t i = pos; i < std::min(size, pos + chunk_size); ++i) {
+      chunk.push_back(static_cast<char>('a' + (i * i) % 7));
+    }
+    cord.Append(std::move(chunk));
+  }
+  return cord;
+}
+
+TEST(CompressedCheckpointTest, RoundTrip) {
+  for (size_t size : {0, 1, 1000, 300000}) {
+    absl::Cord checkpoint = CreateFragmentedCord(size, 4096);
+    absl::StatusOr<absl::Cord> compressed = CompressCheckpoint(checkpoint);
+    ASSERT_OK(compressed.status());
+    EXPECT_TRUE(IsCompressedCheckpoint(*compressed));
+    if (size == 300000) {
+      EXPECT_LT(compressed->size(), size / 4);
+    }
+    absl::StatusOr<absl::Cord> decompressed = DecompressCheckpoint(*compressed);
+    ASSERT_OK(decompressed.status());
+    EXPECT_EQ(*decompressed, checkpoint) << "size " << size;
+  }
+}
+
+TEST(CompressedCheckpointTest, DecompressesFragmentedInputIntoAlignedBuffer) {
+  absl::Cord checkpoint = CreateFragmentedCord(100000, 4096);
+  std::string compressed(CompressCheckpoint(checkpoint).value());
+  absl::Cord fragmented;
+  for (size_t pos = 0; pos < compressed.size(); pos += 13) {
+    fragmented.Append(compressed.substr(pos, 13));
+  }
+
+  absl::StatusOr<absl::Cord> decompressed = DecompressCheckpoint(fragmented);
+  ASSERT_OK(decompressed.status());
+  EXPECT_EQ(*decompressed, checkpoint);
+  auto flat = decompressed->TryFlat();
+  ASSERT_TRUE(flat.has_value());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(flat->data()) %
+                kFederatedComputeCheckpointV2Alignment,
+            0);
+}
+
+TEST(CompressedCheckpointTest, DecompressBeyondMaxSizeFails) {
+  absl::Cord compressed =
+      CompressCheckpoint(CreateFragmentedCord(1000, 100)).value();
+  EXPECT_THAT(DecompressCheckpoint(compressed, /*max_size=*/999),
+              StatusIs(RESOURCE_EXHAUSTED));
+  EXPECT_OK(DecompressCheckpoint(compressed, /*max_size=*/1000).status());
+}
+
+TEST(CompressedCheckpointTest, DecompressCorruptedCheckpointFails) {
+  std::string compressed(
+      CompressCheckpoint(CreateFragmentedCord(1000, 100)).value());
+  // A truncated stream.
+  EXPECT_THAT(DecompressCheckpoint(
+                  absl::Cord(compressed.substr(0, compressed.size() - 4))),
+              StatusIs(INTERNAL));
+  // A stream whose data doesn't match the recorded size. Both envelopes are
+  // 7 bytes long.
+  absl::Cord other =
+      CompressCheckpoint(CreateFragmentedCord(2000, 100)).value();
+  std::string mismatched =
+      std::string(other).replace(0, 7, compressed.substr(0, 7));
+  EXPECT_THAT(DecompressCheckpoint(absl::Cord(mismatched)),
+              StatusIs(INTERNAL));
+  // An unsupported algorithm.
+  compressed[4] = 7;
+  EXPECT_THAT(DecompressCheckpoint(absl::Cord(compressed)),
+              StatusIs(INVALID_ARGUMENT));
+}
+
+TEST(CompressedCheckpointTest, CompressingBuilderFactory) {
+  FederatedComputeCheckpointBuilderFactory builder_factory;
+  CompressingCheckpointBuilderFactory compressing_factory(&builder_factory);
+  std::unique_ptr<CheckpointBuilder> builder = compressing_factory.Create();
+  ASSERT_OK(builder->Add(
+      "t1",
+      Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({1, 2, 3}))
+          .value()));
+  absl::StatusOr<absl::Cord> checkpoint = builder->Build();
+  ASSERT_OK(checkpoint.status());
+  EXPECT_TRUE(IsCompressedCheckpoint(*checkpoint));
+
+  FederatedComputeCheckpointParserFactory parser_factory;
+  auto parser = parser_factory.Create(*checkpoint);
+  ASSERT_OK(parser.status());
+  auto tensor1 = (*parser)->GetTensor("t1");
+  ASSERT_OK(tensor1.status());
+  EXPECT_THAT(*tensor1, IsTensor<int64_t>({3}, {1, 2, 3}));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated::aggregation
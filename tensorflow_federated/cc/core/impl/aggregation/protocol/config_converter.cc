@@ -16,16 +16,25 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/config_converter.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/dp_fedsql_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/federated_constants.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/fedsql_constants.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
@@ -177,11 +186,142 @@ StatusOr<Intrinsic> ParseFromConfig(
       std::move(output_tensor_specs), std::move(params), std::move(intrinsics)};
 }
 
+// Returns true if `intrinsic` is a federated_sum that FusedFederatedSum can
+// aggregate: a sum of a numeric tensor of known shape.
+bool IsFusableFederatedSum(const Intrinsic& intrinsic) {
+  if (intrinsic.uri != kFederatedSumUri || intrinsic.inputs.size() != 1 ||
+      intrinsic.outputs.size() != 1 || !intrinsic.parameters.empty() ||
+      !intrinsic.nested_intrinsics.empty()) {
+    return false;
+  }
+  const TensorSpec& input_spec = intrinsic.inputs[0];
+  const TensorSpec& output_spec = intrinsic.outputs[0];
+  return input_spec.dtype() == output_spec.dtype() &&
+         input_spec.shape() == output_spec.shape() &&
+         internal::GetTypeKind(input_spec.dtype()) ==
+             internal::TypeKind::kNumeric &&
+         input_spec.shape().NumElements().ok();
+}
+
+// Replaces the top level federated_sum intrinsics with a single
+// fused_federated_sum intrinsic that nests them, so that all of them are
+// aggregated by a single FusedFederatedSum instead of a FederatedSum each.
+// The fused intrinsic has no inputs and outputs of its own, so the inputs and
+// outputs of the nested intrinsics are read from and written to the
+// checkpoints in the same way as before. It takes the place of the first
+// federated_sum.
+void FuseFederatedSums(std::vector<Intrinsic>& intrinsics) {
+  size_t num_fusable = 0;
+  for (const Intrinsic& intrinsic : intrinsics) {
+    num_fusable += IsFusableFederatedSum(intrinsic);
+  }
+  // There is nothing to gain from fusing a single sum.
+  if (num_fusable < 2) {
+    return;
+  }
+  std::vector<Intrinsic> fused_sums;
+  std::vector<Intrinsic> other_intrinsics;
+  size_t fused_index = 0;
+  for (Intrinsic& intrinsic : intrinsics) {
+    if (IsFusableFederatedSum(intrinsic)) {
+      if (fused_sums.empty()) {
+        fused_index = other_intrinsics.size();
+      }
+      fused_sums.push_back(std::move(intrinsic));
+    } else {
+      other_intrinsics.push_back(std::move(intrinsic));
+    }
+  }
+  other_intrinsics.insert(
+      other_intrinsics.begin() + fused_index,
+      Intrinsic{std::string(kFusedFederatedSumUri), {}, {}, {},
+                std::move(fused_sums)});
+  intrinsics = std::move(other_intrinsics);
+}
+
+// The intrinsics parsed from configurations, keyed by their deterministic
+// serialization, for as long as they are in use.
+class IntrinsicsCache {
+ public:
+  static IntrinsicsCache& Default() {
+    static IntrinsicsCache* cache = new IntrinsicsCache();
+    return *cache;
+  }
+
+  StatusOr<std::shared_ptr<const std::vector<Intrinsic>>> LookupOrParse(
+      const Configuration& config) {
+    std::string key;
+    {
+      google::protobuf::io::StringOutputStream stream(&key);
+      google::protobuf::io::CodedOutputStream output(&stream);
+      output.SetSerializationDeterministic(true);
+      config.SerializeToCodedStream(&output);
+    }
+    {
+      absl::MutexLock lock(&mutex_);
+      auto it = entries_.find(key);
+      if (it != entries_.end()) {
+        if (std::shared_ptr<const std::vector<Intrinsic>> intrinsics =
+                it->second.lock()) {
+          return intrinsics;
+        }
+      }
+    }
+    // Parsing happens outside of the lock. Concurrent callers with the same
+    // configuration may both parse it, and the later one then uses the
+    // intrinsics of the earlier one.
+    TFF_ASSIGN_OR_RETURN(std::vector<Intrinsic> parsed,
+                         aggregation::ParseFromConfig(config));
+    auto intrinsics =
+        std::make_shared<const std::vector<Intrinsic>>(std::move(parsed));
+    absl::MutexLock lock(&mutex_);
+    std::weak_ptr<const std::vector<Intrinsic>>& entry = entries_[key];
+    if (std::shared_ptr<const std::vector<Intrinsic>> existing =
+            entry.lock()) {
+      return existing;
+    }
+    entry = intrinsics;
+    MaybeRemoveExpired();
+    return intrinsics;
+  }
+
+ private:
+  // Removes the entries of intrinsics that are no longer in use once the
+  // number of entries has doubled since the last removal, which keeps the cost
+  // amortized constant per entry.
+  void MaybeRemoveExpired() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    if (entries_.size() < 2 * size_after_removal_) {
+      return;
+    }
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.expired()) {
+        entries_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    size_after_removal_ = std::max<size_t>(entries_.size(), 1);
+  }
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::weak_ptr<const std::vector<Intrinsic>>>
+      entries_ ABSL_GUARDED_BY(mutex_);
+  size_t size_after_removal_ ABSL_GUARDED_BY(mutex_) = 1;
+};
+
 }  // namespace
 
 StatusOr<std::vector<Intrinsic>> ParseFromConfig(const Configuration& config) {
   TFF_RETURN_IF_ERROR(ValidateConfiguration(config));
-  return ParseFromConfig("", config.intrinsic_configs());
+  TFF_ASSIGN_OR_RETURN(std::vector<Intrinsic> intrinsics,
+                       ParseFromConfig("", config.intrinsic_configs()));
+  FuseFederatedSums(intrinsics);
+  return intrinsics;
+}
+
+StatusOr<std::shared_ptr<const std::vector<Intrinsic>>> ParseFromConfigCached(
+    const Configuration& config) {
+  return IntrinsicsCache::Default().LookupOrParse(config);
 }
 
 absl::Status ValidateConfiguration(const Configuration& configuration) {
@@ -17,6 +17,7 @@
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CONFIG_CONVERTER_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CONFIG_CONVERTER_H_
 
+#include <memory>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -33,8 +34,19 @@ absl::Status ValidateConfiguration(const Configuration& configuration);
 
 // Parses a Configuration proto into a vector of Intrinsic structs to
 // represent the aggregation intrinsic independently from the proto.
+//
+// When the configuration has several top level federated_sum intrinsics over
+// numeric tensors of known shape, they are nested in a single
+// fused_federated_sum intrinsic so that they are aggregated together.
 StatusOr<std::vector<Intrinsic>> ParseFromConfig(const Configuration& config);
 
+// Like ParseFromConfig, but returns intrinsics shared with the other callers
+// that pass an identical configuration while the intrinsics are alive, so that
+// creating many aggregations from the same configuration only parses it once.
+// Configurations are identical if their deterministic serializations are.
+StatusOr<std::shared_ptr<const std::vector<Intrinsic>>> ParseFromConfigCached(
+    const Configuration& config);
+
 }  // namespace aggregation
 }  // namespace tensorflow_federated
 
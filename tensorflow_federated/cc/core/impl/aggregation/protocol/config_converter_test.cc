@@ -56,6 +56,7 @@ class ConfigConverterTest : public ::testing::Test {
     if (!is_registered_) {
       MockFactory mock_factory;
       RegisterAggregatorFactory("my_intrinsic", &mock_factory);
+      RegisterAggregatorFactory("federated_sum", &mock_factory);
       RegisterAggregatorFactory("inner_intrinsic", &mock_factory);
       RegisterAggregatorFactory("outer_intrinsic", &mock_factory);
       RegisterAggregatorFactory("other_intrinsic", &mock_factory);
@@ -86,6 +87,33 @@ TEST_F(ConfigConverterTest, ConvertEmpty) {
               EqIntrinsic(Intrinsic{"my_intrinsic", {}, {}, {}, {}}));
 }
 
+TEST_F(ConfigConverterTest, ParseFromConfigCachedSharesIdenticalConfigs) {
+  Configuration config = PARSE_TEXT_PROTO(R"pb(
+    intrinsic_configs: { intrinsic_uri: "my_intrinsic" }
+  )pb");
+  Configuration other_config = PARSE_TEXT_PROTO(R"pb(
+    intrinsic_configs: { intrinsic_uri: "other_intrinsic" }
+  )pb");
+  auto intrinsics = ParseFromConfigCached(config);
+  ASSERT_THAT(intrinsics, IsOk());
+  ASSERT_THAT(**intrinsics, SizeIs(1));
+  EXPECT_THAT((**intrinsics)[0],
+              EqIntrinsic(Intrinsic{"my_intrinsic", {}, {}, {}, {}}));
+  auto same_intrinsics = ParseFromConfigCached(config);
+  ASSERT_THAT(same_intrinsics, IsOk());
+  EXPECT_EQ(*same_intrinsics, *intrinsics);
+  auto other_intrinsics = ParseFromConfigCached(other_config);
+  ASSERT_THAT(other_intrinsics, IsOk());
+  EXPECT_NE(*other_intrinsics, *intrinsics);
+}
+
+TEST_F(ConfigConverterTest, ParseFromConfigCachedInvalidConfig) {
+  Configuration config = PARSE_TEXT_PROTO(R"pb(
+    intrinsic_configs: { intrinsic_uri: "unknown_intrinsic" }
+  )pb");
+  EXPECT_THAT(ParseFromConfigCached(config), StatusIs(INVALID_ARGUMENT));
+}
+
 TEST_F(ConfigConverterTest, ConvertInputs) {
   Configuration config = PARSE_TEXT_PROTO(R"pb(
     intrinsic_configs: {
@@ -538,6 +566,132 @@ TEST_F(ConfigConverterTest, ConvertFedSqlDp_GroupByNotPresent) {
                                    "wrapped with an outer DP SQL intrinsic"));
 }
 
+TEST_F(ConfigConverterTest, ConvertFederatedSums_Fused) {
+  Configuration config = PARSE_TEXT_PROTO(R"pb(
+    intrinsic_configs: {
+      intrinsic_uri: "my_intrinsic"
+      intrinsic_args {
+        input_tensor {
+          name: "foo"
+          dtype: DT_INT32
+          shape {}
+        }
+      }
+      output_tensors {
+        name: "foo_out"
+        dtype: DT_INT32
+        shape {}
+      }
+    }
+    intrinsic_configs: {
+      intrinsic_uri: "federated_sum"
+      intrinsic_args {
+        input_tensor {
+          name: "bar"
+          dtype: DT_INT32
+          shape {}
+        }
+      }
+      output_tensors {
+        name: "bar_out"
+        dtype: DT_INT32
+        shape {}
+      }
+    }
+    intrinsic_configs: {
+      intrinsic_uri: "federated_sum"
+      intrinsic_args {
+        input_tensor {
+          name: "baz"
+          dtype: DT_STRING
+          shape {}
+        }
+      }
+      output_tensors {
+        name: "baz_out"
+        dtype: DT_STRING
+        shape {}
+      }
+    }
+    intrinsic_configs: {
+      intrinsic_uri: "federated_sum"
+      intrinsic_args {
+        input_tensor {
+          name: "qux"
+          dtype: DT_FLOAT
+          shape { dim_sizes: 2 }
+        }
+      }
+      output_tensors {
+        name: "qux_out"
+        dtype: DT_FLOAT
+        shape { dim_sizes: 2 }
+      }
+    }
+  )pb");
+  StatusOr<std::vector<Intrinsic>> parsed_intrinsics = ParseFromConfig(config);
+  ASSERT_THAT(parsed_intrinsics, IsOk());
+  // The numeric sums are nested in a fused_federated_sum at the position of
+  // the first one, and the sum of strings is left as it is.
+  ASSERT_THAT(parsed_intrinsics.value(), SizeIs(3));
+  Intrinsic expected_fused{"fused_federated_sum", {}, {}, {}, {}};
+  expected_fused.nested_intrinsics.push_back(
+      Intrinsic{"federated_sum",
+                {TensorSpec{"bar", DT_INT32, {}}},
+                {TensorSpec{"bar_out", DT_INT32, {}}},
+                {},
+                {}});
+  expected_fused.nested_intrinsics.push_back(
+      Intrinsic{"federated_sum",
+                {TensorSpec{"qux", DT_FLOAT, {2}}},
+                {TensorSpec{"qux_out", DT_FLOAT, {2}}},
+                {},
+                {}});
+  EXPECT_THAT(parsed_intrinsics.value()[0],
+              EqIntrinsic(Intrinsic{"my_intrinsic",
+                                    {TensorSpec{"foo", DT_INT32, {}}},
+                                    {TensorSpec{"foo_out", DT_INT32, {}}},
+                                    {},
+                                    {}}));
+  EXPECT_THAT(parsed_intrinsics.value()[1],
+              EqIntrinsic(std::move(expected_fused)));
+  EXPECT_THAT(parsed_intrinsics.value()[2],
+              EqIntrinsic(Intrinsic{"federated_sum",
+                                    {TensorSpec{"baz", DT_STRING, {}}},
+                                    {TensorSpec{"baz_out", DT_STRING, {}}},
+                                    {},
+                                    {}}));
+}
+
+TEST_F(ConfigConverterTest, ConvertFederatedSums_SingleSumNotFused) {
+  Configuration config = PARSE_TEXT_PROTO(R"pb(
+    intrinsic_configs: {
+      intrinsic_uri: "federated_sum"
+      intrinsic_args {
+        input_tensor {
+          name: "bar"
+          dtype: DT_INT32
+          shape {}
+        }
+      }
+      output_tensors {
+        name: "bar_out"
+        dtype: DT_INT32
+        shape {}
+      }
+    }
+  )pb");
+  StatusOr<std::vector<Intrinsic>> parsed_intrinsics = ParseFromConfig(config);
+  ASSERT_THAT(parsed_intrinsics, IsOk());
+  ASSERT_THAT(parsed_intrinsics.value(), SizeIs(1));
+  EXPECT_THAT(parsed_intrinsics.value()[0],
+              EqIntrinsic(Intrinsic{"federated_sum",
+                                    {TensorSpec{"bar", DT_INT32, {}}},
+                                    {TensorSpec{"bar_out", DT_INT32, {}}},
+                                    {},
+                                    {}}));
+}
+
 }  // namespace
 }  // namespace aggregation
 }  // namespace tensorflow_federated
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CORD_READER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CORD_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "absl/strings/cord.h"
+
+namespace tensorflow_federated::aggregation {
+
+// Sequentially reads varints and byte ranges of a serialized message, such as
+// the federated compute wire format, from a Cord chunk by chunk without
+// flattening it. Byte ranges are returned as Cords that share the memory of
+// the source Cord rather than copying it.
+class CordReader {
+ public:
+  // The `cord` must outlive the reader.
+  explicit CordReader(const absl::Cord& cord)
+      : it_(cord.char_begin()), remaining_(cord.size()) {}
+
+  bool AtEnd() const { return remaining_ == 0; }
+
+  // Returns the number of bytes left to read.
+  size_t remaining() const { return remaining_; }
+
+  bool ReadVarint64(uint64_t* value) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (remaining_ == 0) {
+        return false;
+      }
+      const uint8_t byte = static_cast<uint8_t>(*it_);
+      ++it_;
+      --remaining_;
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        *value = result;
+        return true;
+      }
+    }
+    // The varint is longer than 10 bytes.
+    return false;
+  }
+
+  bool ReadVarint32(uint32_t* value) {
+    uint64_t value64;
+    if (!ReadVarint64(&value64) ||
+        value64 > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+    *value = static_cast<uint32_t>(value64);
+    return true;
+  }
+
+  bool ReadCord(size_t size, absl::Cord* cord) {
+    if (size > remaining_) {
+      return false;
+    }
+    *cord = absl::Cord::AdvanceAndRead(&it_, size);
+    remaining_ -= size;
+    return true;
+  }
+
+  bool ReadString(size_t size, std::string* str) {
+    absl::Cord cord;
+    if (!ReadCord(size, &cord)) {
+      return false;
+    }
+    *str = std::string(cord);
+    return true;
+  }
+
+ private:
+  absl::Cord::CharIterator it_;
+  size_t remaining_;
+};
+
+}  // namespace tensorflow_federated::aggregation
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_CORD_READER_H_
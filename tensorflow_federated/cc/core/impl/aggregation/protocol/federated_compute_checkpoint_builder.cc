@@ -14,28 +14,45 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_builder.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/base/config.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dictionary_string_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_header.h"
 
 namespace tensorflow_federated::aggregation {
 
 namespace {
+
+// Tag of the length delimited TensorProto content field (field number 4).
+constexpr uint32_t kTensorProtoContentTag = (4 << 3) | 2;
+
 // Builds and formats a set of aggregation tensors using the new wire format for
 // federated compute.
 class FederatedComputeCheckpointBuilder final : public CheckpointBuilder {
  public:
-  FederatedComputeCheckpointBuilder() {
+  FederatedComputeCheckpointBuilder(CheckpointSink* sink,
+                                    size_t max_buffer_size)
+      : sink_(sink), max_buffer_size_(max_buffer_size) {
     // Indicates that the checkpoint is using the new wire format.
     result_.Append(kFederatedComputeCheckpointHeader);
   }
@@ -46,39 +63,301 @@ class FederatedComputeCheckpointBuilder final : public CheckpointBuilder {
       const FederatedComputeCheckpointBuilder&) = delete;
 
   absl::Status Add(const std::string& name, const Tensor& tensor) override {
-    std::string metadata;
-    google::protobuf::io::StringOutputStream out(&metadata);
-    google::protobuf::io::CodedOutputStream coded_out(&out);
-    coded_out.WriteVarint64(name.size());
-    coded_out.WriteString(name);
-
     absl::Cord content(tensor.ToProto().SerializeAsString());
     if (content.empty()) {
       return absl::InternalError("Failed to add tensor for " + name);
     }
-    coded_out.WriteVarint64(content.size());
-    coded_out.Trim();
-    result_.Append(metadata);
-    result_.Append(content);
-    return absl::OkStatus();
+    result_.Append(EncodeMetadata(name, content.size()));
+    result_.Append(std::move(content));
+    return MaybeFlush();
+  }
+
+  absl::Status Add(const std::string& name, Tensor&& tensor) override {
+    if (tensor.dtype() == DT_STRING || !tensor.is_dense()) {
+      // The content of string tensors differs from their in-memory
+      // representation, so it has to be encoded. Sparse tensors also need
+      // their indices to be encoded.
+      return Add(name, std::as_const(tensor));
+    }
+
+    // Serialize the TensorProto without its content, which is then appended
+    // directly from the tensor data. This produces the same bytes as
+    // tensor.ToProto().SerializeAsString().
+    TensorProto tensor_proto;
+    tensor_proto.set_dtype(tensor.dtype());
+    *tensor_proto.mutable_shape() = tensor.shape().ToProto();
+    std::string serialized_tensor = tensor_proto.SerializeAsString();
+    const size_t content_size = tensor.data().byte_size();
+    if (content_size > 0) {
+      google::protobuf::io::StringOutputStream out(&serialized_tensor);
+      google::protobuf::io::CodedOutputStream coded_out(&out);
+      coded_out.WriteTag(kTensorProtoContentTag);
+      coded_out.WriteVarint64(content_size);
+      coded_out.Trim();
+    }
+    result_.Append(EncodeMetadata(name, serialized_tensor.size() + content_size));
+    result_.Append(std::move(serialized_tensor));
+    if (content_size > 0) {
+      // The tensor is owned by the external Cord chunk and released with it.
+      auto* owned_tensor = new Tensor(std::move(tensor));
+      result_.Append(absl::MakeCordFromExternal(
+          absl::string_view(
+              static_cast<const char*>(owned_tensor->data().data()),
+              content_size),
+          [owned_tensor]() { delete owned_tensor; }));
+    }
+    return MaybeFlush();
   }
 
   absl::StatusOr<absl::Cord> Build() override {
     uint32_t zero = 0;
     result_.Append(
         absl::string_view(reinterpret_cast<const char*>(&zero), sizeof(zero)));
+    if (sink_ != nullptr) {
+      TFF_RETURN_IF_ERROR(sink_->Write(std::move(result_)));
+      result_.Clear();
+    }
     return result_;
   }
 
  private:
+  // Encodes the name of a tensor followed by the size of its serialized
+  // TensorProto.
+  static std::string EncodeMetadata(const std::string& name,
+                                    size_t tensor_size) {
+    std::string metadata;
+    google::protobuf::io::StringOutputStream out(&metadata);
+    google::protobuf::io::CodedOutputStream coded_out(&out);
+    coded_out.WriteVarint64(name.size());
+    coded_out.WriteString(name);
+    coded_out.WriteVarint64(tensor_size);
+    coded_out.Trim();
+    return metadata;
+  }
+
+  // Writes the buffered part of the checkpoint to the sink, if any, once it
+  // reaches the maximum buffer size.
+  absl::Status MaybeFlush() {
+    if (sink_ == nullptr || result_.size() < max_buffer_size_) {
+      return absl::OkStatus();
+    }
+    absl::Status status = sink_->Write(std::move(result_));
+    result_.Clear();
+    return status;
+  }
+
+  CheckpointSink* const sink_;
+  const size_t max_buffer_size_;
   absl::Cord result_;
 };
 
+// Builds a set of aggregation tensors using the aligned columnar version of
+// the federated compute wire format. The directory precedes the buffers, so
+// the checkpoint is only laid out by Build().
+class AlignedFederatedComputeCheckpointBuilder final
+    : public CheckpointBuilder {
+ public:
+  explicit AlignedFederatedComputeCheckpointBuilder(CheckpointSink* sink)
+      : sink_(sink) {}
+  // Disallow copy and move constructors.
+  AlignedFederatedComputeCheckpointBuilder(
+      const AlignedFederatedComputeCheckpointBuilder&) = delete;
+  AlignedFederatedComputeCheckpointBuilder& operator=(
+      const AlignedFederatedComputeCheckpointBuilder&) = delete;
+
+  absl::Status Add(const std::string& name, const Tensor& tensor) override {
+    Entry& entry = AddEntry(name, tensor);
+    if (tensor.dtype() == DT_STRING) {
+      AddStrings(tensor, entry);
+      return absl::OkStatus();
+    }
+    entry.values = absl::Cord(absl::string_view(
+        static_cast<const char*>(tensor.data().data()),
+        tensor.data().byte_size()));
+    if (!tensor.is_dense()) {
+      absl::Span<const int64_t> indices = tensor.sparse_indices();
+      entry.indices = absl::Cord(
+          absl::string_view(reinterpret_cast<const char*>(indices.data()),
+                            indices.size() * sizeof(int64_t)));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Add(const std::string& name, Tensor&& tensor) override {
+    if (tensor.dtype() == DT_STRING || !tensor.is_dense() ||
+        tensor.data().byte_size() == 0) {
+      return Add(name, std::as_const(tensor));
+    }
+    Entry& entry = AddEntry(name, tensor);
+    // The tensor is owned by the external Cord chunk and released with it.
+    auto* owned_tensor = new Tensor(std::move(tensor));
+    entry.values = absl::MakeCordFromExternal(
+        absl::string_view(
+            static_cast<const char*>(owned_tensor->data().data()),
+            owned_tensor->data().byte_size()),
+        [owned_tensor]() { delete owned_tensor; });
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<absl::Cord> Build() override {
+#ifdef ABSL_IS_BIG_ENDIAN
+    return absl::UnimplementedError(
+        "The aligned checkpoint format requires a little-endian host.");
+#endif
+    std::string directory;
+    {
+      google::protobuf::io::StringOutputStream out(&directory);
+      google::protobuf::io::CodedOutputStream coded_out(&out);
+      coded_out.WriteVarint64(entries_.size());
+      size_t offset = 0;
+      for (const Entry& entry : entries_) {
+        coded_out.WriteVarint64(entry.name.size());
+        coded_out.WriteString(entry.name);
+        coded_out.WriteVarint64(entry.dtype);
+        coded_out.WriteVarint64(entry.dim_sizes.size());
+        for (int64_t dim_size : entry.dim_sizes) {
+          coded_out.WriteVarint64(static_cast<uint64_t>(dim_size));
+        }
+        coded_out.WriteVarint64(offset);
+        coded_out.WriteVarint64(entry.values.size());
+        offset = AlignUp(offset + entry.values.size());
+        coded_out.WriteVarint64((entry.is_sparse ? kSparseTensorFlag : 0) |
+                                (entry.is_dictionary ? kDictionaryTensorFlag
+                                                     : 0));
+        if (entry.is_sparse) {
+          coded_out.WriteVarint64(offset);
+          coded_out.WriteVarint64(entry.indices.size());
+          offset = AlignUp(offset + entry.indices.size());
+        }
+        if (entry.is_dictionary) {
+          coded_out.WriteVarint64(entry.dictionary_size);
+          coded_out.WriteVarint64(offset);
+          coded_out.WriteVarint64(entry.codes.size());
+          offset = AlignUp(offset + entry.codes.size());
+        }
+      }
+      coded_out.Trim();
+    }
+
+    absl::Cord result;
+    result.Append(kFederatedComputeCheckpointV2Header);
+    result.Append(std::move(directory));
+    AppendPadding(result);
+    for (Entry& entry : entries_) {
+      result.Append(std::move(entry.values));
+      AppendPadding(result);
+      if (entry.is_sparse) {
+        result.Append(std::move(entry.indices));
+        AppendPadding(result);
+      }
+      if (entry.is_dictionary) {
+        result.Append(std::move(entry.codes));
+        AppendPadding(result);
+      }
+    }
+    entries_.clear();
+    if (sink_ != nullptr) {
+      TFF_RETURN_IF_ERROR(sink_->Write(std::move(result)));
+      return absl::Cord();
+    }
+    return result;
+  }
+
+ private:
+  struct Entry {
+    std::string name;
+    DataType dtype;
+    std::vector<int64_t> dim_sizes;
+    bool is_sparse;
+    absl::Cord values;
+    absl::Cord indices;
+    bool is_dictionary = false;
+    uint64_t dictionary_size = 0;
+    absl::Cord codes;
+  };
+
+  Entry& AddEntry(const std::string& name, const Tensor& tensor) {
+    const TensorShape::DimSizesVector& dim_sizes =
+        tensor.shape().dim_sizes();
+    entries_.push_back(Entry{
+        name,
+        tensor.dtype(),
+        std::vector<int64_t>(dim_sizes.begin(), dim_sizes.end()),
+        !tensor.is_dense(),
+        {},
+        {}});
+    return entries_.back();
+  }
+
+  // Encodes the values of a string tensor, with a dictionary if the tensor
+  // already has one or if fewer than half of its values are distinct.
+  static void AddStrings(const Tensor& tensor, Entry& entry) {
+    const auto* dictionary_data =
+        dynamic_cast<const DictionaryStringData*>(&tensor.data());
+    std::unique_ptr<DictionaryStringData> encoded_data;
+    if (dictionary_data == nullptr) {
+      encoded_data = DictionaryStringData::Encode(tensor.AsSpan<string_view>());
+      if (encoded_data->dictionary().size() * 2 >
+          encoded_data->codes().size()) {
+        entry.values = EncodeStrings(tensor.AsSpan<string_view>());
+        return;
+      }
+      dictionary_data = encoded_data.get();
+    }
+    absl::Span<const int32_t> codes = dictionary_data->codes();
+    entry.is_dictionary = true;
+    entry.dictionary_size = dictionary_data->dictionary().size();
+    entry.values = EncodeStrings(dictionary_data->dictionary());
+    entry.codes = absl::Cord(
+        absl::string_view(reinterpret_cast<const char*>(codes.data()),
+                          codes.size() * sizeof(int32_t)));
+  }
+
+  // Encodes string values as an offset table followed by the bytes of the
+  // strings.
+  static absl::Cord EncodeStrings(absl::Span<const string_view> strings) {
+    std::vector<uint64_t> offsets(strings.size() + 1);
+    for (size_t i = 0; i < strings.size(); ++i) {
+      offsets[i + 1] = offsets[i] + strings[i].size();
+    }
+    const size_t table_size = offsets.size() * sizeof(uint64_t);
+    std::string encoded(table_size + offsets.back(), '\0');
+    std::memcpy(encoded.data(), offsets.data(), table_size);
+    char* dest = encoded.data() + table_size;
+    for (string_view s : strings) {
+      if (!s.empty()) std::memcpy(dest, s.data(), s.size());
+      dest += s.size();
+    }
+    return absl::Cord(std::move(encoded));
+  }
+
+  static size_t AlignUp(size_t offset) {
+    constexpr size_t kAlignment = kFederatedComputeCheckpointV2Alignment;
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  // Pads the checkpoint with zeros up to the next aligned offset.
+  static void AppendPadding(absl::Cord& result) {
+    static constexpr char kZeros[kFederatedComputeCheckpointV2Alignment] = {};
+    const size_t padding = AlignUp(result.size()) - result.size();
+    if (padding > 0) {
+      result.Append(absl::string_view(kZeros, padding));
+    }
+  }
+
+  CheckpointSink* const sink_;
+  std::vector<Entry> entries_;
+};
+
 }  // namespace
 
 std::unique_ptr<CheckpointBuilder>
 FederatedComputeCheckpointBuilderFactory::Create() const {
-  return std::make_unique<FederatedComputeCheckpointBuilder>();
+  if (format_ == FederatedComputeCheckpointFormat::kAlignedV2) {
+    return std::make_unique<AlignedFederatedComputeCheckpointBuilder>(sink_);
+  }
+  return std::make_unique<FederatedComputeCheckpointBuilder>(sink_,
+                                                             max_buffer_size_);
 }
 
 }  // namespace tensorflow_federated::aggregation
@@ -17,18 +17,70 @@
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_FEDERATED_COMPUTE_CHECKPOINT_BUILDER_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_FEDERATED_COMPUTE_CHECKPOINT_BUILDER_H_
 
+#include <cstddef>
 #include <memory>
 
+#include "absl/status/status.h"
+#include "absl/strings/cord.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
 
 namespace tensorflow_federated::aggregation {
 
+// Describes an abstract destination receiving a checkpoint in consecutive
+// parts, for example to write it to a file as it is built.
+class CheckpointSink {
+ public:
+  virtual ~CheckpointSink() = default;
+
+  // Writes the next part of the checkpoint.
+  virtual absl::Status Write(absl::Cord data) = 0;
+};
+
+// Versions of the federated compute wire format, see checkpoint_header.h.
+enum class FederatedComputeCheckpointFormat {
+  // Each tensor is stored as a length delimited TensorProto.
+  kV1,
+  // A tensor directory followed by aligned raw buffers, which parsers can
+  // alias without copying the values.
+  kAlignedV2,
+};
+
 // A CheckpointBuilderFactory implementation that builds checkpoint using new
 // wire format for federated compute.
+//
+// Tensors added by rvalue reference are taken over by the checkpoint, whose
+// Cord references their data as external chunks rather than copying it.
 class FederatedComputeCheckpointBuilderFactory
     : public CheckpointBuilderFactory {
  public:
+  static constexpr size_t kDefaultMaxBufferSize = 1 << 20;
+
+  // Creates builders that return the entire checkpoint from Build().
+  explicit FederatedComputeCheckpointBuilderFactory(
+      FederatedComputeCheckpointFormat format =
+          FederatedComputeCheckpointFormat::kV1)
+      : format_(format) {}
+
+  // Creates builders that write the checkpoint to `sink` as tensors are added.
+  // The checkpoint is buffered until at least `max_buffer_size` bytes are
+  // pending, and Build() writes the remainder and returns an empty Cord. The
+  // `sink` must outlive the builders.
+  //
+  // The directory of the kAlignedV2 format precedes the tensors, so those
+  // checkpoints are only written to the sink by Build().
+  explicit FederatedComputeCheckpointBuilderFactory(
+      CheckpointSink* sink, size_t max_buffer_size = kDefaultMaxBufferSize,
+      FederatedComputeCheckpointFormat format =
+          FederatedComputeCheckpointFormat::kV1)
+      : sink_(sink), max_buffer_size_(max_buffer_size), format_(format) {}
+
   std::unique_ptr<CheckpointBuilder> Create() const override;
+
+ private:
+  CheckpointSink* sink_ = nullptr;
+  size_t max_buffer_size_ = kDefaultMaxBufferSize;
+  FederatedComputeCheckpointFormat format_ =
+      FederatedComputeCheckpointFormat::kV1;
 };
 
 }  // namespace tensorflow_federated::aggregation
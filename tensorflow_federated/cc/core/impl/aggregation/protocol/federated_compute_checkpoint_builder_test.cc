@@ -14,17 +14,24 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_builder.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
@@ -38,6 +45,54 @@
 namespace tensorflow_federated::aggregation {
 namespace {
 
+// A CheckpointSink that records the parts written to it.
+class RecordingCheckpointSink : public CheckpointSink {
+ public:
+  absl::Status Write(absl::Cord data) override {
+    parts_.push_back(std::move(data));
+    return absl::OkStatus();
+  }
+
+  absl::Cord Concatenated() const {
+    absl::Cord result;
+    for (const absl::Cord& part : parts_) {
+      result.Append(part);
+    }
+    return result;
+  }
+
+  const std::vector<absl::Cord>& parts() const { return parts_; }
+
+ private:
+  std::vector<absl::Cord> parts_;
+};
+
+// Adds tensors of several types to `builder`, either by const reference or by
+// moving them into the builder.
+void AddTestTensors(CheckpointBuilder& builder, bool move_tensors) {
+  std::vector<std::pair<std::string, Tensor>> tensors;
+  tensors.emplace_back(
+      "t1", Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({1, 2, 3}))
+                .value());
+  tensors.emplace_back(
+      "t2", Tensor::Create(DT_STRING, {2}, CreateTestData<absl::string_view>(
+                                               {"value1", "value2"}))
+                .value());
+  tensors.emplace_back(
+      "t3", Tensor::Create(DT_FLOAT, {2, 2},
+                           CreateTestData<float>({1.5, 2.5, 3.5, 4.5}))
+                .value());
+  tensors.emplace_back(
+      "t4", Tensor::Create(DT_INT32, {0}, CreateTestData<int32_t>({})).value());
+  for (auto& [name, tensor] : tensors) {
+    if (move_tensors) {
+      TFF_CHECK(builder.Add(name, std::move(tensor)).ok());
+    } else {
+      TFF_CHECK(builder.Add(name, tensor).ok());
+    }
+  }
+}
+
 TEST(FederatedComputeCheckpointBuilderTest, BuildCheckpoint) {
   FederatedComputeCheckpointBuilderFactory factory;
   std::unique_ptr<CheckpointBuilder> builder = factory.Create();
@@ -89,5 +144,111 @@ TEST(FederatedComputeCheckpointBuilderTest, BuildCheckpoint) {
   ASSERT_TRUE(stream.ReadVarint32(&zero));
   ASSERT_EQ(zero, 0);
 }
+
+TEST(FederatedComputeCheckpointBuilderTest, MovedTensorsBuildSameCheckpoint) {
+  FederatedComputeCheckpointBuilderFactory factory;
+  std::unique_ptr<CheckpointBuilder> builder = factory.Create();
+  AddTestTensors(*builder, /*move_tensors=*/false);
+  absl::StatusOr<absl::Cord> checkpoint = builder->Build();
+  ASSERT_OK(checkpoint.status());
+
+  std::unique_ptr<CheckpointBuilder> moving_builder = factory.Create();
+  AddTestTensors(*moving_builder, /*move_tensors=*/true);
+  absl::StatusOr<absl::Cord> moved_checkpoint = moving_builder->Build();
+  ASSERT_OK(moved_checkpoint.status());
+
+  EXPECT_EQ(*moved_checkpoint, *checkpoint);
+}
+
+TEST(FederatedComputeCheckpointBuilderTest, MovedTensorDataIsNotCopied) {
+  FederatedComputeCheckpointBuilderFactory factory;
+  std::unique_ptr<CheckpointBuilder> builder = factory.Create();
+  Tensor tensor =
+      Tensor::Create(DT_INT64, {1000},
+                     std::make_unique<MutableVectorData<int64_t>>(1000, 7))
+          .value();
+  const void* tensor_data = tensor.data().data();
+  EXPECT_OK(builder->Add("t", std::move(tensor)));
+  absl::StatusOr<absl::Cord> checkpoint = builder->Build();
+  ASSERT_OK(checkpoint.status());
+
+  bool found_tensor_data = false;
+  for (absl::string_view chunk : checkpoint->Chunks()) {
+    if (chunk.data() == tensor_data) {
+      found_tensor_data = true;
+      EXPECT_EQ(chunk.size(), 1000 * sizeof(int64_t));
+    }
+  }
+  EXPECT_TRUE(found_tensor_data);
+}
+
+TEST(FederatedComputeCheckpointBuilderTest, WritesCheckpointToSink) {
+  FederatedComputeCheckpointBuilderFactory factory;
+  std::unique_ptr<CheckpointBuilder> builder = factory.Create();
+  AddTestTensors(*builder, /*move_tensors=*/false);
+  absl::StatusOr<absl::Cord> expected_checkpoint = builder->Build();
+  ASSERT_OK(expected_checkpoint.status());
+
+  for (size_t max_buffer_size : {1, 20, 1 << 20}) {
+    RecordingCheckpointSink sink;
+    FederatedComputeCheckpointBuilderFactory streaming_factory(
+        &sink, max_buffer_size);
+    std::unique_ptr<CheckpointBuilder> streaming_builder =
+        streaming_factory.Create();
+    AddTestTensors(*streaming_builder, /*move_tensors=*/true);
+    absl::StatusOr<absl::Cord> checkpoint = streaming_builder->Build();
+    ASSERT_OK(checkpoint.status());
+    EXPECT_TRUE(checkpoint->empty());
+    EXPECT_EQ(sink.Concatenated(), *expected_checkpoint);
+    if (max_buffer_size == 1) {
+      // Each tensor is written as soon as it is added.
+      EXPECT_EQ(sink.parts().size(), 5);
+    }
+  }
+}
+
+TEST(FederatedComputeCheckpointBuilderTest, AlignedV2_BuffersAreAligned) {
+  FederatedComputeCheckpointBuilderFactory factory(
+      FederatedComputeCheckpointFormat::kAlignedV2);
+  std::unique_ptr<CheckpointBuilder> builder = factory.Create();
+  AddTestTensors(*builder, /*move_tensors=*/false);
+  absl::StatusOr<absl::Cord> checkpoint = builder->Build();
+  ASSERT_OK(checkpoint.status());
+
+  std::string str(*checkpoint);
+  EXPECT_EQ(str.substr(0, 4), kFederatedComputeCheckpointV2Header);
+  EXPECT_EQ(str.size() % kFederatedComputeCheckpointV2Alignment, 0);
+  // The raw values of t1 start at an aligned offset.
+  const int64_t t1_values[] = {1, 2, 3};
+  size_t pos = str.find(std::string(reinterpret_cast<const char*>(t1_values),
+                                    sizeof(t1_values)));
+  ASSERT_NE(pos, std::string::npos);
+  EXPECT_EQ(pos % kFederatedComputeCheckpointV2Alignment, 0);
+}
+
+TEST(FederatedComputeCheckpointBuilderTest,
+     AlignedV2_MovedTensorsBuildSameCheckpoint) {
+  FederatedComputeCheckpointBuilderFactory factory(
+      FederatedComputeCheckpointFormat::kAlignedV2);
+  std::unique_ptr<CheckpointBuilder> builder = factory.Create();
+  AddTestTensors(*builder, /*move_tensors=*/false);
+  absl::StatusOr<absl::Cord> checkpoint = builder->Build();
+  ASSERT_OK(checkpoint.status());
+
+  RecordingCheckpointSink sink;
+  FederatedComputeCheckpointBuilderFactory streaming_factory(
+      &sink, /*max_buffer_size=*/1,
+      FederatedComputeCheckpointFormat::kAlignedV2);
+  std::unique_ptr<CheckpointBuilder> streaming_builder =
+      streaming_factory.Create();
+  AddTestTensors(*streaming_builder, /*move_tensors=*/true);
+  absl::StatusOr<absl::Cord> streamed_checkpoint = streaming_builder->Build();
+  ASSERT_OK(streamed_checkpoint.status());
+  EXPECT_TRUE(streamed_checkpoint->empty());
+  // The directory precedes the tensors, so the checkpoint is written at once.
+  EXPECT_EQ(sink.parts().size(), 1);
+  EXPECT_EQ(sink.Concatenated(), *checkpoint);
+}
+
 }  // namespace
 }  // namespace tensorflow_federated::aggregation
@@ -14,28 +14,273 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_parser.h"
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <new>
+#include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/base/config.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
-#include "google/protobuf/io/coded_stream.h"
-#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/cord_tensor_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dictionary_string_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_header.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/compressed_checkpoint.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/cord_reader.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/tensor_binding_plan.h"
 
 namespace tensorflow_federated::aggregation {
 
 namespace {
+
+// Field numbers of TensorProto. Only the fields used by tensors with a
+// content blob are decoded directly.
+constexpr uint64_t kDtypeFieldNumber = 1;
+constexpr uint64_t kShapeFieldNumber = 2;
+constexpr uint64_t kContentFieldNumber = 4;
+constexpr uint64_t kVarintWireType = 0;
+constexpr uint64_t kLengthDelimitedWireType = 2;
+
+// Parses a serialized TensorProto into a Tensor. When the values are stored in
+// the content field of a numeric tensor, the Tensor is backed by a
+// CordTensorData, which aliases the memory of `serialized_tensor` unless the
+// content is fragmented or unaligned. All other tensors are decoded with at
+// most one copy of their values.
+absl::StatusOr<Tensor> ParseTensor(const std::string& name,
+                                   const absl::Cord& serialized_tensor) {
+  CordReader reader(serialized_tensor);
+  uint64_t dtype = DT_INVALID;
+  TensorShapeProto shape_proto;
+  absl::Cord content;
+  bool has_other_fields = false;
+  while (!reader.AtEnd() && !has_other_fields) {
+    uint64_t tag;
+    if (!reader.ReadVarint64(&tag)) {
+      return absl::InternalError(
+          absl::StrFormat("Unable to parse tensor proto for %s", name));
+    }
+    const uint64_t field_number = tag >> 3;
+    const uint64_t wire_type = tag & 7;
+    uint64_t length = 0;
+    bool ok = true;
+    if (field_number == kDtypeFieldNumber && wire_type == kVarintWireType) {
+      ok = reader.ReadVarint64(&dtype);
+    } else if (field_number == kShapeFieldNumber &&
+               wire_type == kLengthDelimitedWireType) {
+      std::string serialized_shape;
+      ok = reader.ReadVarint64(&length) &&
+           reader.ReadString(length, &serialized_shape) &&
+           shape_proto.MergeFromString(serialized_shape);
+    } else if (field_number == kContentFieldNumber &&
+               wire_type == kLengthDelimitedWireType) {
+      ok = reader.ReadVarint64(&length) && reader.ReadCord(length, &content);
+    } else {
+      has_other_fields = true;
+    }
+    if (!ok) {
+      return absl::InternalError(
+          absl::StrFormat("Unable to parse tensor proto for %s", name));
+    }
+  }
+
+  const bool is_numeric = DataType_IsValid(static_cast<int>(dtype)) &&
+                          dtype != DT_INVALID && dtype != DT_STRING;
+  if (!has_other_fields && is_numeric) {
+    size_t alignment = 0;
+    NUMERICAL_ONLY_DTYPE_CASES(static_cast<DataType>(dtype), T,
+                               alignment = alignof(T));
+    TFF_ASSIGN_OR_RETURN(TensorShape shape,
+                         TensorShape::FromProto(shape_proto));
+    return Tensor::Create(
+        static_cast<DataType>(dtype), std::move(shape),
+        std::make_unique<CordTensorData>(std::move(content), alignment));
+  }
+
+  TensorProto tensor_proto;
+  if (has_other_fields) {
+    // Values stored in the repeated fields and sparse tensors are rare, so
+    // they are left to the generated parser.
+    if (!tensor_proto.ParseFromString(std::string(serialized_tensor))) {
+      return absl::InternalError(
+          absl::StrFormat("Unable to parse tensor proto for %s", name));
+    }
+    return Tensor::FromProto(tensor_proto);
+  }
+  // The content of string tensors is copied once into a buffer owned by the
+  // Tensor, which decodes the strings in place.
+  tensor_proto.set_dtype(static_cast<DataType>(dtype));
+  *tensor_proto.mutable_shape() = std::move(shape_proto);
+  *tensor_proto.mutable_content() = std::string(content);
+  return Tensor::FromProto(std::move(tensor_proto));
+}
+
+// A tensor of the checkpoint that hasn't been decoded yet. Its fields share
+// the memory of the checkpoint.
+struct EncodedTensor {
+  // The serialized TensorProto of a tensor of a v1 checkpoint.
+  absl::Cord serialized_tensor;
+  // The directory entry and buffers of a tensor of an aligned v2 checkpoint.
+  bool is_aligned = false;
+  uint64_t dtype = DT_INVALID;
+  TensorShapeProto shape;
+  absl::Cord values;
+  std::optional<absl::Cord> indices;
+  // The dictionary size and codes of a dictionary encoded string tensor, whose
+  // values are the dictionary strings.
+  uint64_t dictionary_size = 0;
+  std::optional<absl::Cord> codes;
+};
+
+// String values of an aligned checkpoint, viewed in place in the encoded
+// buffer, which the data keeps a reference on.
+class AlignedStringData final : public TensorData {
+ public:
+  static absl::StatusOr<std::unique_ptr<AlignedStringData>> Create(
+      const std::string& name, absl::Cord encoded, size_t num_values) {
+    auto data = std::unique_ptr<AlignedStringData>(
+        new AlignedStringData(std::move(encoded)));
+    absl::string_view buffer = data->buffer();
+    const size_t table_size = (num_values + 1) * sizeof(uint64_t);
+    if (buffer.size() < table_size) {
+      return absl::InternalError(
+          absl::StrFormat("Unable to read string offsets for %s", name));
+    }
+    // The offsets may not be aligned, so they are read one by one.
+    const size_t strings_size = buffer.size() - table_size;
+    uint64_t begin = 0;
+    std::memcpy(&begin, buffer.data(), sizeof(uint64_t));
+    data->string_views_.reserve(num_values);
+    for (size_t i = 1; i <= num_values; ++i) {
+      uint64_t end;
+      std::memcpy(&end, buffer.data() + i * sizeof(uint64_t),
+                  sizeof(uint64_t));
+      if (begin > end || end > strings_size) {
+        return absl::InternalError(
+            absl::StrFormat("Invalid string offsets for %s", name));
+      }
+      data->string_views_.emplace_back(buffer.data() + table_size + begin,
+                                       end - begin);
+      begin = end;
+    }
+    return data;
+  }
+
+  // The string views point into this object, so it can be neither copied nor
+  // moved.
+  AlignedStringData(const AlignedStringData&) = delete;
+  AlignedStringData& operator=(const AlignedStringData&) = delete;
+
+  // Implementation of TensorData methods.
+  size_t byte_size() const override {
+    return string_views_.size() * sizeof(string_view);
+  }
+  const void* data() const override { return string_views_.data(); }
+
+ private:
+  explicit AlignedStringData(absl::Cord encoded)
+      : encoded_(std::move(encoded)) {}
+
+  absl::string_view buffer() {
+    auto flat = encoded_.TryFlat();
+    if (flat.has_value()) {
+      return *flat;
+    }
+    copy_ = std::string(encoded_);
+    return copy_;
+  }
+
+  absl::Cord encoded_;
+  std::string copy_;
+  std::vector<string_view> string_views_;
+};
+
+// Creates a Tensor from the buffers of an aligned v2 checkpoint. The values
+// alias the checkpoint memory unless it is fragmented or unaligned.
+absl::StatusOr<Tensor> ParseAlignedTensor(const std::string& name,
+                                          const EncodedTensor& encoded) {
+  if (!DataType_IsValid(static_cast<int>(encoded.dtype)) ||
+      encoded.dtype == DT_INVALID) {
+    return absl::InternalError(
+        absl::StrFormat("Invalid dtype %d for %s", encoded.dtype, name));
+  }
+  const auto dtype = static_cast<DataType>(encoded.dtype);
+  TFF_ASSIGN_OR_RETURN(TensorShape shape,
+                       TensorShape::FromProto(encoded.shape));
+  if (dtype == DT_STRING) {
+    if (encoded.indices.has_value()) {
+      return absl::InternalError(
+          absl::StrFormat("Sparse string tensor %s isn't supported", name));
+    }
+    TFF_ASSIGN_OR_RETURN(size_t num_values, shape.NumElements());
+    if (!encoded.codes.has_value()) {
+      TFF_ASSIGN_OR_RETURN(
+          std::unique_ptr<AlignedStringData> data,
+          AlignedStringData::Create(name, encoded.values, num_values));
+      return Tensor::Create(dtype, std::move(shape), std::move(data));
+    }
+    // The number of values comes from the shape, so it is compared with the
+    // size of the codes by division, which can't overflow.
+    if (encoded.codes->size() % sizeof(int32_t) != 0 ||
+        encoded.codes->size() / sizeof(int32_t) != num_values ||
+        encoded.dictionary_size >= encoded.values.size() / sizeof(uint64_t)) {
+      return absl::InternalError(
+          absl::StrFormat("Invalid dictionary codes for %s", name));
+    }
+    TFF_ASSIGN_OR_RETURN(std::unique_ptr<AlignedStringData> dictionary,
+                         AlignedStringData::Create(name, encoded.values,
+                                                   encoded.dictionary_size));
+    std::vector<int32_t> codes(encoded.codes->size() / sizeof(int32_t));
+    char* dest = reinterpret_cast<char*>(codes.data());
+    for (absl::string_view chunk : encoded.codes->Chunks()) {
+      std::memcpy(dest, chunk.data(), chunk.size());
+      dest += chunk.size();
+    }
+    TFF_ASSIGN_OR_RETURN(
+        std::unique_ptr<DictionaryStringData> data,
+        DictionaryStringData::Create(std::move(dictionary), std::move(codes)));
+    return Tensor::Create(dtype, std::move(shape), std::move(data));
+  }
+  if (encoded.codes.has_value()) {
+    return absl::InternalError(absl::StrFormat(
+        "Dictionary encoded tensor %s must have string values", name));
+  }
+  size_t alignment = 0;
+  NUMERICAL_ONLY_DTYPE_CASES(dtype, T, alignment = alignof(T));
+  auto values = std::make_unique<CordTensorData>(encoded.values, alignment);
+  if (!encoded.indices.has_value()) {
+    return Tensor::Create(dtype, std::move(shape), std::move(values));
+  }
+  return Tensor::CreateSparse(
+      dtype, std::move(shape), std::move(values),
+      std::make_unique<CordTensorData>(*encoded.indices, alignof(int64_t)));
+}
+
+// Decodes a tensor of either version of the checkpoint format.
+absl::StatusOr<Tensor> DecodeTensor(const std::string& name,
+                                    const EncodedTensor& encoded) {
+  if (encoded.is_aligned) {
+    return ParseAlignedTensor(name, encoded);
+  }
+  return ParseTensor(name, encoded.serialized_tensor);
+}
+
 // A CheckpointParser implementation that reads Federated Compute wire format
 // checkpoint.
 class FederatedComputeCheckpointParser final : public CheckpointParser {
@@ -63,31 +308,256 @@ class FederatedComputeCheckpointParser final : public CheckpointParser {
   absl::flat_hash_map<std::string, Tensor> tensors_;
 };
 
-}  // namespace
+// A CheckpointParser implementation that reads Federated Compute wire format
+// checkpoint, and only decodes each tensor when it is first requested.
+class LazyFederatedComputeCheckpointParser final : public CheckpointParser {
+ public:
+  explicit LazyFederatedComputeCheckpointParser(
+      absl::flat_hash_map<std::string, EncodedTensor> encoded_tensors)
+      : encoded_tensors_(std::move(encoded_tensors)) {}
 
-absl::StatusOr<std::unique_ptr<CheckpointParser>>
-FederatedComputeCheckpointParserFactory::Create(
-    const absl::Cord& serialized_checkpoint) const {
-  absl::Cord flattenable_checkpoint(serialized_checkpoint);
-  absl::string_view str = flattenable_checkpoint.Flatten();
-  google::protobuf::io::ArrayInputStream input(str.data(), static_cast<int>(str.size()));
+  // Disallow copy and move constructors.
+  LazyFederatedComputeCheckpointParser(
+      const LazyFederatedComputeCheckpointParser&) = delete;
+  LazyFederatedComputeCheckpointParser& operator=(
+      const LazyFederatedComputeCheckpointParser&) = delete;
+
+  absl::StatusOr<Tensor> GetTensor(const std::string& name) override {
+    auto result = encoded_tensors_.find(name);
+    if (result == encoded_tensors_.end()) {
+      return absl::NotFoundError(
+          absl::StrFormat("No aggregation tensor found for name %s", name));
+    }
+    // The encoded tensor only references the checkpoint memory, so it is kept
+    // and decoded again if the same tensor is requested more than once.
+    return DecodeTensor(name, result->second);
+  }
+
+ private:
+  // Encoded tensors, which share the memory of the checkpoint, keyed by
+  // tensor name.
+  absl::flat_hash_map<std::string, EncodedTensor> encoded_tensors_;
+};
+
+// A CheckpointParser implementation that reads Federated Compute wire format
+// checkpoint into the slots of a TensorBindingPlan, skipping the tensors that
+// the plan doesn't bind.
+class BoundFederatedComputeCheckpointParser final : public CheckpointParser {
+ public:
+  // A tensor of the checkpoint, either decoded or still encoded.
+  struct Slot {
+    bool present = false;
+    EncodedTensor encoded_tensor;
+    std::optional<Tensor> tensor;
+  };
+
+  BoundFederatedComputeCheckpointParser(
+      std::shared_ptr<const TensorBindingPlan> plan, std::vector<Slot> slots)
+      : plan_(std::move(plan)), slots_(std::move(slots)) {}
+
+  // Disallow copy and move constructors.
+  BoundFederatedComputeCheckpointParser(
+      const BoundFederatedComputeCheckpointParser&) = delete;
+  BoundFederatedComputeCheckpointParser& operator=(
+      const BoundFederatedComputeCheckpointParser&) = delete;
+
+  absl::StatusOr<Tensor> GetTensor(const std::string& name) override {
+    std::optional<size_t> slot = plan_->FindSlot(name);
+    if (!slot.has_value()) {
+      return absl::NotFoundError(
+          absl::StrFormat("No aggregation tensor found for name %s", name));
+    }
+    return TakeTensor(*slot);
+  }
+
+  absl::Status GetTensors(const TensorBindingPlan& plan,
+                          absl::Span<Tensor> tensors) override {
+    if (&plan != plan_.get()) {
+      return CheckpointParser::GetTensors(plan, tensors);
+    }
+    for (size_t slot = 0; slot < slots_.size(); ++slot) {
+      TFF_ASSIGN_OR_RETURN(tensors[slot], TakeTensor(slot));
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::StatusOr<Tensor> TakeTensor(size_t slot) {
+    Slot& bound = slots_[slot];
+    if (!bound.present) {
+      return absl::NotFoundError(absl::StrFormat(
+          "No aggregation tensor found for name %s", plan_->name(slot)));
+    }
+    if (bound.tensor.has_value()) {
+      return std::move(*bound.tensor);
+    }
+    return DecodeTensor(plan_->name(slot), bound.encoded_tensor);
+  }
+
+  const std::shared_ptr<const TensorBindingPlan> plan_;
+  std::vector<Slot> slots_;
+};
+
+// Returns `checkpoint` if its memory is contiguous and suitably aligned for
+// the values of any numeric tensor, so that the tensor buffers can alias it.
+// Otherwise returns a copy of it in a single aligned buffer, which is still
+// cheaper than copying each tensor separately.
+absl::Cord AlignCheckpoint(const absl::Cord& checkpoint) {
+  auto flat = checkpoint.TryFlat();
+  if (flat.has_value() && reinterpret_cast<uintptr_t>(flat->data()) %
+                                  alignof(std::max_align_t) ==
+                              0) {
+    return checkpoint;
+  }
+  constexpr std::align_val_t kAlignment{kFederatedComputeCheckpointV2Alignment};
+  char* const copy =
+      static_cast<char*>(::operator new(checkpoint.size(), kAlignment));
+  char* dest = copy;
+  for (absl::string_view chunk : checkpoint.Chunks()) {
+    std::memcpy(dest, chunk.data(), chunk.size());
+    dest += chunk.size();
+  }
+  return absl::MakeCordFromExternal(
+      absl::string_view(copy, checkpoint.size()),
+      [copy]() { ::operator delete(copy, kAlignment); });
+}
+
+// Reads the directory of an aligned v2 checkpoint, whose header has already
+// been checked, and calls `fn(name, encoded_tensor)` with the buffers of each
+// named tensor. Stops at the first error returned by `fn`.
+template <typename F>
+absl::Status ForEachAlignedTensor(const absl::Cord& serialized_checkpoint,
+                                  F fn) {
+#ifdef ABSL_IS_BIG_ENDIAN
+  return absl::UnimplementedError(
+      "The aligned checkpoint format requires a little-endian host.");
+#endif
+  const absl::Cord checkpoint = AlignCheckpoint(serialized_checkpoint);
+  CordReader reader(checkpoint);
+  absl::Cord header;
+  uint64_t num_tensors;
+  if (!reader.ReadCord(4, &header) || !reader.ReadVarint64(&num_tensors)) {
+    return absl::InternalError(
+        "Unable to read the tensor directory of the checkpoint.");
+  }
+
+  // Offsets and sizes of the buffers of a tensor, relative to the data
+  // section.
+  struct Buffers {
+    std::string name;
+    EncodedTensor encoded_tensor;
+    uint64_t values_offset = 0;
+    uint64_t values_size = 0;
+    uint64_t indices_offset = 0;
+    uint64_t indices_size = 0;
+    uint64_t codes_offset = 0;
+    uint64_t codes_size = 0;
+  };
+  std::vector<Buffers> directory;
+  for (uint64_t i = 0; i < num_tensors; ++i) {
+    Buffers& buffers = directory.emplace_back();
+    EncodedTensor& encoded = buffers.encoded_tensor;
+    encoded.is_aligned = true;
+    uint32_t name_size;
+    uint64_t rank;
+    if (!reader.ReadVarint32(&name_size) ||
+        !reader.ReadString(name_size, &buffers.name) ||
+        !reader.ReadVarint64(&encoded.dtype) || !reader.ReadVarint64(&rank) ||
+        rank > reader.remaining()) {
+      return absl::InternalError(
+          "Unable to read the tensor directory of the checkpoint.");
+    }
+    bool ok = true;
+    for (uint64_t d = 0; d < rank && ok; ++d) {
+      uint64_t dim_size = 0;
+      ok = reader.ReadVarint64(&dim_size);
+      if (ok) {
+        encoded.shape.add_dim_sizes(static_cast<int64_t>(dim_size));
+      }
+    }
+    uint64_t flags = 0;
+    ok = ok && reader.ReadVarint64(&buffers.values_offset) &&
+         reader.ReadVarint64(&buffers.values_size) &&
+         reader.ReadVarint64(&flags) &&
+         (flags & ~(kSparseTensorFlag | kDictionaryTensorFlag)) == 0;
+    if (ok && (flags & kSparseTensorFlag) != 0) {
+      ok = reader.ReadVarint64(&buffers.indices_offset) &&
+           reader.ReadVarint64(&buffers.indices_size);
+    }
+    if (ok && (flags & kDictionaryTensorFlag) != 0) {
+      ok = reader.ReadVarint64(&encoded.dictionary_size) &&
+           reader.ReadVarint64(&buffers.codes_offset) &&
+           reader.ReadVarint64(&buffers.codes_size);
+    }
+    if (!ok) {
+      return absl::InternalError(absl::StrFormat(
+          "Unable to read the directory entry for %s", buffers.name));
+    }
+    if ((flags & kSparseTensorFlag) != 0) {
+      encoded.indices.emplace();
+    }
+    if ((flags & kDictionaryTensorFlag) != 0) {
+      encoded.codes.emplace();
+    }
+  }
 
-  google::protobuf::io::CodedInputStream stream(&input);
+  constexpr size_t kAlignment = kFederatedComputeCheckpointV2Alignment;
+  const size_t directory_end = checkpoint.size() - reader.remaining();
+  const size_t data_start =
+      (directory_end + kAlignment - 1) / kAlignment * kAlignment;
+  const size_t data_size =
+      checkpoint.size() > data_start ? checkpoint.size() - data_start : 0;
+  auto read_buffer = [&checkpoint, data_start, data_size](
+                         uint64_t offset, uint64_t size, absl::Cord* buffer) {
+    if (offset > data_size || size > data_size - offset) {
+      return false;
+    }
+    *buffer = checkpoint.Subcord(data_start + offset, size);
+    return true;
+  };
+  for (Buffers& buffers : directory) {
+    EncodedTensor& encoded = buffers.encoded_tensor;
+    if (!read_buffer(buffers.values_offset, buffers.values_size,
+                     &encoded.values) ||
+        (encoded.indices.has_value() &&
+         !read_buffer(buffers.indices_offset, buffers.indices_size,
+                      &*encoded.indices)) ||
+        (encoded.codes.has_value() &&
+         !read_buffer(buffers.codes_offset, buffers.codes_size,
+                      &*encoded.codes))) {
+      return absl::InternalError(absl::StrFormat(
+          "Unable to read tensor buffers for %s", buffers.name));
+    }
+    TFF_RETURN_IF_ERROR(
+        fn(std::move(buffers.name), std::move(buffers.encoded_tensor)));
+  }
+  return absl::OkStatus();
+}
+
+// Reads the framing of a federated compute wire format checkpoint of either
+// version and calls `fn(name, encoded_tensor)` for each named tensor, without
+// decoding it. Stops at the first error returned by `fn`.
+template <typename F>
+absl::Status ForEachEncodedTensor(const absl::Cord& serialized_checkpoint,
+                                  F fn) {
+  CordReader reader(serialized_checkpoint);
 
   std::string header;
-  if (!stream.ReadString(&header, 4)) {
+  if (!reader.ReadString(4, &header)) {
     return absl::InternalError(
         "Unable to read header from federated compute wire format checkpoint.");
   }
+  if (header == kFederatedComputeCheckpointV2Header) {
+    return ForEachAlignedTensor(serialized_checkpoint, std::move(fn));
+  }
   if (header != kFederatedComputeCheckpointHeader) {
     return absl::InvalidArgumentError(
         absl::StrFormat("Unsupported checkpoint format: %s", header));
   }
 
-  absl::flat_hash_map<std::string, Tensor> tensors;
-  while (!stream.ExpectAtEnd()) {
+  while (!reader.AtEnd()) {
     uint32_t name_size;
-    if (!stream.ReadVarint32(&name_size)) {
+    if (!reader.ReadVarint32(&name_size)) {
       return absl::InternalError(
           "Unable to read next tensor name size from federated compute wire "
           "format checkpoint.");
@@ -99,31 +569,106 @@ FederatedComputeCheckpointParserFactory::Create(
     }
 
     std::string name;
-    if (!stream.ReadString(&name, name_size)) {
+    if (!reader.ReadString(name_size, &name)) {
       return absl::InternalError(
           "Unable to read next tensor name from federated compute wire "
           "format checkpoint.");
     }
 
     uint32_t tensor_size;
-    if (!stream.ReadVarint32(&tensor_size)) {
+    if (!reader.ReadVarint32(&tensor_size)) {
       return absl::InternalError(
           absl::StrFormat("Unable to read tensor size for %s", name));
     }
 
-    TensorProto tensor_proto;
-    google::protobuf::io::CodedInputStream::Limit limit = stream.PushLimit(tensor_size);
-    if (!tensor_proto.ParseFromCodedStream(&stream)) {
+    EncodedTensor encoded_tensor;
+    if (!reader.ReadCord(tensor_size, &encoded_tensor.serialized_tensor)) {
       return absl::InternalError(
           absl::StrFormat("Unable to parse tensor proto for %s", name));
     }
-    stream.PopLimit(limit);
 
+    TFF_RETURN_IF_ERROR(fn(std::move(name), std::move(encoded_tensor)));
+  }
+  return absl::OkStatus();
+}
+
+// Returns each named tensor of a federated compute wire format checkpoint,
+// without decoding it.
+absl::StatusOr<absl::flat_hash_map<std::string, EncodedTensor>>
+IndexEncodedTensors(const absl::Cord& serialized_checkpoint) {
+  absl::flat_hash_map<std::string, EncodedTensor> encoded_tensors;
+  TFF_RETURN_IF_ERROR(ForEachEncodedTensor(
+      serialized_checkpoint,
+      [&encoded_tensors](std::string name, EncodedTensor encoded_tensor) {
+        encoded_tensors.emplace(std::move(name), std::move(encoded_tensor));
+        return absl::OkStatus();
+      }));
+  return encoded_tensors;
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<CheckpointParser>>
+FederatedComputeCheckpointParserFactory::Create(
+    const absl::Cord& serialized_checkpoint) const {
+  if (IsCompressedCheckpoint(serialized_checkpoint)) {
+    TFF_ASSIGN_OR_RETURN(absl::Cord checkpoint,
+                         DecompressCheckpoint(serialized_checkpoint));
+    return Create(checkpoint);
+  }
+  TFF_ASSIGN_OR_RETURN(auto encoded_tensors,
+                       IndexEncodedTensors(serialized_checkpoint));
+  if (lazy_decoding_) {
+    return std::make_unique<LazyFederatedComputeCheckpointParser>(
+        std::move(encoded_tensors));
+  }
+
+  absl::flat_hash_map<std::string, Tensor> tensors;
+  for (auto& [name, encoded_tensor] : encoded_tensors) {
     TFF_ASSIGN_OR_RETURN(Tensor aggregation_tensor,
-                         Tensor::FromProto(std::move(tensor_proto)));
+                         DecodeTensor(name, encoded_tensor));
     tensors.emplace(name, std::move(aggregation_tensor));
   }
   return std::make_unique<FederatedComputeCheckpointParser>(std::move(tensors));
 }
 
+absl::StatusOr<std::unique_ptr<CheckpointParser>>
+FederatedComputeCheckpointParserFactory::CreateWithBindingPlan(
+    const absl::Cord& serialized_checkpoint,
+    std::shared_ptr<const TensorBindingPlan> plan) const {
+  if (IsCompressedCheckpoint(serialized_checkpoint)) {
+    TFF_ASSIGN_OR_RETURN(absl::Cord checkpoint,
+                         DecompressCheckpoint(serialized_checkpoint));
+    return CreateWithBindingPlan(checkpoint, std::move(plan));
+  }
+  std::vector<BoundFederatedComputeCheckpointParser::Slot> slots(plan->size());
+  // Checkpoints are usually written in the order of the plan, so each tensor
+  // is first expected in the slot after the previous one.
+  size_t next_slot = 0;
+  TFF_RETURN_IF_ERROR(ForEachEncodedTensor(
+      serialized_checkpoint,
+      [this, &plan, &slots, &next_slot](
+          std::string name, EncodedTensor encoded_tensor) -> absl::Status {
+        std::optional<size_t> slot = plan->FindSlot(name, next_slot);
+        if (!slot.has_value()) {
+          return absl::OkStatus();
+        }
+        next_slot = *slot + 1;
+        BoundFederatedComputeCheckpointParser::Slot& bound = slots[*slot];
+        if (bound.present) {
+          // Like the other parsers, keep the first tensor of a repeated name.
+          return absl::OkStatus();
+        }
+        bound.present = true;
+        if (lazy_decoding_) {
+          bound.encoded_tensor = std::move(encoded_tensor);
+          return absl::OkStatus();
+        }
+        TFF_ASSIGN_OR_RETURN(bound.tensor, DecodeTensor(name, encoded_tensor));
+        return absl::OkStatus();
+      }));
+  return std::make_unique<BoundFederatedComputeCheckpointParser>(
+      std::move(plan), std::move(slots));
+}
+
 }  // namespace tensorflow_federated::aggregation
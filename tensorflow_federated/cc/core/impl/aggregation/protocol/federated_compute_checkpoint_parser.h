@@ -22,15 +22,45 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/tensor_binding_plan.h"
 
 namespace tensorflow_federated::aggregation {
 
 // A CheckpointParserFactory implementation that creates federated compute wire
 // format checkpoint parser.
+//
+// By default all tensors are decoded when the parser is created. With
+// `lazy_decoding`, creating the parser only records where each named tensor is
+// in the checkpoint, and a tensor is decoded when it is requested with
+// GetTensor. Tensors that are never requested then cost little more than
+// their name, and errors in their encoding are reported by GetTensor rather
+// than Create.
+//
+// Parsers created with CreateWithBindingPlan put the tensors bound by the plan
+// into its slots while reading the checkpoint, and skip the other tensors
+// without decoding them.
+//
+// Both versions of the wire format are accepted. The tensors of an aligned v2
+// checkpoint alias its memory, which they keep alive, when it is contiguous
+// and aligned, for example when it is a single received buffer or a mapped
+// file. Other v2 checkpoints are copied once into an aligned buffer.
+//
+// Checkpoints wrapped in a compression envelope are decompressed first, see
+// DecompressCheckpoint.
 class FederatedComputeCheckpointParserFactory : public CheckpointParserFactory {
  public:
+  explicit FederatedComputeCheckpointParserFactory(bool lazy_decoding = false)
+      : lazy_decoding_(lazy_decoding) {}
+
   absl::StatusOr<std::unique_ptr<CheckpointParser>> Create(
       const absl::Cord& serialized_checkpoint) const override;
+
+  absl::StatusOr<std::unique_ptr<CheckpointParser>> CreateWithBindingPlan(
+      const absl::Cord& serialized_checkpoint,
+      std::shared_ptr<const TensorBindingPlan> plan) const override;
+
+ private:
+  const bool lazy_decoding_;
 };
 
 }  // namespace tensorflow_federated::aggregation
@@ -14,25 +14,123 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_parser.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dictionary_string_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_header.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/tensor_binding_plan.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
 
 namespace tensorflow_federated::aggregation {
 namespace {
 
+using ::testing::Each;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::Not;
+
+// Returns a copy of `cord` made of external chunks of at most `chunk_size`
+// bytes, so that parsing it has to cross chunk boundaries.
+absl::Cord FragmentCord(const absl::Cord& cord, size_t chunk_size) {
+  std::string flat(cord);
+  absl::Cord fragmented;
+  for (size_t pos = 0; pos < flat.size(); pos += chunk_size) {
+    auto* chunk = new std::string(
+        flat.substr(pos, std::min(chunk_size, flat.size() - pos)));
+    fragmented.Append(absl::MakeCordFromExternal(
+        *chunk, [chunk](absl::string_view) { delete chunk; }));
+  }
+  return fragmented;
+}
+
+absl::Cord BuildTestCheckpoint() {
+  FederatedComputeCheckpointBuilderFactory builder_factory;
+  std::unique_ptr<CheckpointBuilder> builder = builder_factory.Create();
+  TFF_CHECK(builder
+                ->Add("t1", Tensor::Create(DT_INT64, {3},
+                                           CreateTestData<int64_t>({1, 2, 3}))
+                                .value())
+                .ok());
+  TFF_CHECK(builder
+                ->Add("t2", Tensor::Create(DT_STRING, {2},
+                                           CreateTestData<absl::string_view>(
+                                               {"value1", "value2"}))
+                                .value())
+                .ok());
+  TFF_CHECK(builder
+                ->Add("t3", Tensor::Create(DT_FLOAT, {2},
+                                           CreateTestData<float>({1.5, 2.5}))
+                                .value())
+                .ok());
+  return builder->Build().value();
+}
+
+absl::Cord BuildAlignedTestCheckpoint() {
+  FederatedComputeCheckpointBuilderFactory builder_factory(
+      FederatedComputeCheckpointFormat::kAlignedV2);
+  std::unique_ptr<CheckpointBuilder> builder = builder_factory.Create();
+  TFF_CHECK(builder
+                ->Add("t1", Tensor::Create(DT_INT64, {3},
+                                           CreateTestData<int64_t>({1, 2, 3}))
+                                .value())
+                .ok());
+  TFF_CHECK(builder
+                ->Add("t2", Tensor::Create(DT_STRING, {3},
+                                           CreateTestData<absl::string_view>(
+                                               {"value1", "", "value3"}))
+                                .value())
+                .ok());
+  TFF_CHECK(builder
+                ->Add("t3",
+                      Tensor::CreateSparse(DT_FLOAT, {4},
+                                           CreateTestData<float>({1.5, 2.5}),
+                                           CreateTestData<int64_t>({1, 3}))
+                          .value())
+                .ok());
+  return builder->Build().value();
+}
+
+// Checks the tensors of the checkpoint built by BuildAlignedTestCheckpoint.
+void ExpectAlignedTestTensors(CheckpointParser& parser) {
+  auto tensor1 = parser.GetTensor("t1");
+  ASSERT_OK(tensor1.status());
+  EXPECT_THAT(*tensor1, IsTensor<int64_t>({3}, {1, 2, 3}));
+  auto tensor2 = parser.GetTensor("t2");
+  ASSERT_OK(tensor2.status());
+  EXPECT_THAT(*tensor2,
+              IsTensor<absl::string_view>({3}, {"value1", "", "value3"}));
+  auto tensor3 = parser.GetTensor("t3");
+  ASSERT_OK(tensor3.status());
+  ASSERT_FALSE(tensor3->is_dense());
+  EXPECT_EQ(tensor3->shape(), TensorShape({4}));
+  EXPECT_THAT(tensor3->sparse_indices(), ElementsAre(1, 3));
+  const float* values = static_cast<const float*>(tensor3->data().data());
+  EXPECT_THAT(std::vector<float>(values, values + 2), ElementsAre(1.5, 2.5));
+}
+
 TEST(FederatedComputeCheckpointParserTest, GetTensors) {
   FederatedComputeCheckpointBuilderFactory builder_factory;
   std::unique_ptr<CheckpointBuilder> builder = builder_factory.Create();
@@ -68,5 +166,363 @@ TEST(FederatedComputeCheckpointParserTest, GetTensors) {
   EXPECT_THAT(*tensor3, IsTensor<int32_t>({2}, {1, 2}));
 }
 
+TEST(FederatedComputeCheckpointParserTest, GetTensorsFromFragmentedCord) {
+  absl::Cord checkpoint = BuildTestCheckpoint();
+  FederatedComputeCheckpointParserFactory parser_factory;
+  for (size_t chunk_size : {1, 3, 7, 16}) {
+    auto parser =
+        parser_factory.Create(FragmentCord(checkpoint, chunk_size));
+    ASSERT_OK(parser.status());
+    auto tensor1 = (*parser)->GetTensor("t1");
+    ASSERT_OK(tensor1.status());
+    auto tensor2 = (*parser)->GetTensor("t2");
+    ASSERT_OK(tensor2.status());
+    auto tensor3 = (*parser)->GetTensor("t3");
+    ASSERT_OK(tensor3.status());
+    EXPECT_THAT(*tensor1, IsTensor<int64_t>({3}, {1, 2, 3}));
+    EXPECT_THAT(*tensor2,
+                IsTensor<absl::string_view>({2}, {"value1", "value2"}));
+    EXPECT_THAT(*tensor3, IsTensor<float>({2}, {1.5, 2.5}));
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest, TensorsOutliveCheckpoint) {
+  absl::StatusOr<Tensor> tensor1;
+  absl::StatusOr<Tensor> tensor3;
+  {
+    absl::Cord checkpoint = BuildTestCheckpoint();
+    FederatedComputeCheckpointParserFactory parser_factory;
+    auto parser = parser_factory.Create(checkpoint);
+    ASSERT_OK(parser.status());
+    tensor1 = (*parser)->GetTensor("t1");
+    tensor3 = (*parser)->GetTensor("t3");
+  }
+  ASSERT_OK(tensor1.status());
+  ASSERT_OK(tensor3.status());
+  EXPECT_THAT(*tensor1, IsTensor<int64_t>({3}, {1, 2, 3}));
+  EXPECT_THAT(*tensor3, IsTensor<float>({2}, {1.5, 2.5}));
+}
+
+TEST(FederatedComputeCheckpointParserTest, GetTensorWithRepeatedValues) {
+  TensorProto tensor_proto;
+  tensor_proto.set_dtype(DT_INT32);
+  tensor_proto.mutable_shape()->add_dim_sizes(3);
+  tensor_proto.add_int_val(4);
+  tensor_proto.add_int_val(5);
+  tensor_proto.add_int_val(6);
+  std::string serialized_tensor = tensor_proto.SerializeAsString();
+  ASSERT_LT(serialized_tensor.size(), 128);
+
+  // Single byte varints are enough for the name and tensor sizes.
+  std::string checkpoint = kFederatedComputeCheckpointHeader;
+  checkpoint += '\x01';
+  checkpoint += "t";
+  checkpoint += static_cast<char>(serialized_tensor.size());
+  checkpoint += serialized_tensor;
+  checkpoint += '\x00';
+
+  FederatedComputeCheckpointParserFactory parser_factory;
+  auto parser = parser_factory.Create(absl::Cord(checkpoint));
+  ASSERT_OK(parser.status());
+  auto tensor = (*parser)->GetTensor("t");
+  ASSERT_OK(tensor.status());
+  EXPECT_THAT(*tensor, IsTensor<int32_t>({3}, {4, 5, 6}));
+}
+
+TEST(FederatedComputeCheckpointParserTest, GetMissingTensor) {
+  FederatedComputeCheckpointParserFactory parser_factory;
+  auto parser = parser_factory.Create(BuildTestCheckpoint());
+  ASSERT_OK(parser.status());
+  EXPECT_THAT((*parser)->GetTensor("missing"), StatusIs(NOT_FOUND));
+}
+
+TEST(FederatedComputeCheckpointParserTest, UnsupportedHeader) {
+  FederatedComputeCheckpointParserFactory parser_factory;
+  auto parser = parser_factory.Create(absl::Cord("XXv1"));
+  EXPECT_THAT(parser, StatusIs(INVALID_ARGUMENT));
+  EXPECT_THAT(parser.status().message(),
+              HasSubstr("Unsupported checkpoint format"));
+}
+
+TEST(FederatedComputeCheckpointParserTest, TruncatedCheckpoint) {
+  std::string checkpoint(BuildTestCheckpoint());
+  FederatedComputeCheckpointParserFactory parser_factory;
+  // Checkpoints that end in the middle of the header or of a record fail to
+  // parse.
+  for (size_t size : {2, 6, 10, 20}) {
+    EXPECT_THAT(
+        parser_factory.Create(absl::Cord(checkpoint.substr(0, size))),
+        StatusIs(INTERNAL))
+        << "size " << size;
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest, LazyDecoding_GetTensors) {
+  absl::Cord checkpoint = BuildTestCheckpoint();
+  FederatedComputeCheckpointParserFactory parser_factory(
+      /*lazy_decoding=*/true);
+  for (size_t chunk_size : {3, 1000}) {
+    auto parser =
+        parser_factory.Create(FragmentCord(checkpoint, chunk_size));
+    ASSERT_OK(parser.status());
+    auto tensor3 = (*parser)->GetTensor("t3");
+    ASSERT_OK(tensor3.status());
+    auto tensor1 = (*parser)->GetTensor("t1");
+    ASSERT_OK(tensor1.status());
+    auto tensor2 = (*parser)->GetTensor("t2");
+    ASSERT_OK(tensor2.status());
+    EXPECT_THAT(*tensor1, IsTensor<int64_t>({3}, {1, 2, 3}));
+    EXPECT_THAT(*tensor2,
+                IsTensor<absl::string_view>({2}, {"value1", "value2"}));
+    EXPECT_THAT(*tensor3, IsTensor<float>({2}, {1.5, 2.5}));
+    EXPECT_THAT((*parser)->GetTensor("missing"), StatusIs(NOT_FOUND));
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest,
+     LazyDecoding_TensorsOutliveCheckpoint) {
+  std::unique_ptr<CheckpointParser> parser;
+  {
+    FederatedComputeCheckpointParserFactory parser_factory(
+        /*lazy_decoding=*/true);
+    auto created_parser = parser_factory.Create(BuildTestCheckpoint());
+    ASSERT_OK(created_parser.status());
+    parser = std::move(created_parser).value();
+  }
+  auto tensor1 = parser->GetTensor("t1");
+  parser.reset();
+  ASSERT_OK(tensor1.status());
+  EXPECT_THAT(*tensor1, IsTensor<int64_t>({3}, {1, 2, 3}));
+}
+
+TEST(FederatedComputeCheckpointParserTest,
+     LazyDecoding_InvalidTensorOnlyFailsGetTensor) {
+  TensorProto tensor_proto;
+  tensor_proto.set_dtype(DT_INT32);
+  tensor_proto.mutable_shape()->add_dim_sizes(3);
+  tensor_proto.set_content("12345");
+  std::string serialized_tensor = tensor_proto.SerializeAsString();
+  ASSERT_LT(serialized_tensor.size(), 128);
+
+  std::string checkpoint = kFederatedComputeCheckpointHeader;
+  checkpoint += '\x01';
+  checkpoint += "t";
+  checkpoint += static_cast<char>(serialized_tensor.size());
+  checkpoint += serialized_tensor;
+  checkpoint += '\x00';
+
+  FederatedComputeCheckpointParserFactory eager_parser_factory;
+  EXPECT_THAT(eager_parser_factory.Create(absl::Cord(checkpoint)),
+              Not(IsOk()));
+
+  FederatedComputeCheckpointParserFactory lazy_parser_factory(
+      /*lazy_decoding=*/true);
+  auto parser = lazy_parser_factory.Create(absl::Cord(checkpoint));
+  ASSERT_OK(parser.status());
+  EXPECT_THAT((*parser)->GetTensor("t"), Not(IsOk()));
+}
+
+TEST(FederatedComputeCheckpointParserTest, LazyDecoding_TruncatedCheckpoint) {
+  std::string checkpoint(BuildTestCheckpoint());
+  FederatedComputeCheckpointParserFactory parser_factory(
+      /*lazy_decoding=*/true);
+  for (size_t size : {2, 6, 10, 20}) {
+    EXPECT_THAT(
+        parser_factory.Create(absl::Cord(checkpoint.substr(0, size))),
+        StatusIs(INTERNAL))
+        << "size " << size;
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest, BindingPlan_GetTensors) {
+  // The plan binds the tensors out of the order of the checkpoint and skips
+  // the string tensor.
+  auto plan = std::make_shared<const TensorBindingPlan>(
+      std::vector<std::string>{"t3", "t1"});
+  for (bool lazy_decoding : {false, true}) {
+    FederatedComputeCheckpointParserFactory parser_factory(lazy_decoding);
+    auto parser =
+        parser_factory.CreateWithBindingPlan(BuildTestCheckpoint(), plan);
+    ASSERT_OK(parser.status());
+    std::vector<Tensor> tensors(plan->size());
+    ASSERT_OK((*parser)->GetTensors(*plan, absl::MakeSpan(tensors)));
+    EXPECT_THAT(tensors[0], IsTensor<float>({2}, {1.5, 2.5}));
+    EXPECT_THAT(tensors[1], IsTensor<int64_t>({3}, {1, 2, 3}));
+    EXPECT_THAT((*parser)->GetTensor("t2"), StatusIs(NOT_FOUND));
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest, AlignedV2_GetTensors) {
+  absl::Cord checkpoint = BuildAlignedTestCheckpoint();
+  for (bool lazy_decoding : {false, true}) {
+    FederatedComputeCheckpointParserFactory parser_factory(lazy_decoding);
+    for (size_t chunk_size : {1, 7, 64, 1 << 20}) {
+      auto parser =
+          parser_factory.Create(FragmentCord(checkpoint, chunk_size));
+      ASSERT_OK(parser.status());
+      ExpectAlignedTestTensors(**parser);
+    }
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest,
+     AlignedV2_TensorsAliasCheckpointMemory) {
+  FederatedComputeCheckpointBuilderFactory builder_factory(
+      FederatedComputeCheckpointFormat::kAlignedV2);
+  std::unique_ptr<CheckpointBuilder> builder = builder_factory.Create();
+  ASSERT_OK(builder->Add(
+      "t1",
+      Tensor::Create(DT_INT32, {1000},
+                     std::make_unique<MutableVectorData<int32_t>>(1000, 7))
+          .value()));
+  ASSERT_OK(builder->Add(
+      "t2", Tensor::Create(DT_STRING, {2}, CreateTestData<absl::string_view>(
+                                               {"value1", "value2"}))
+                .value()));
+  // A flat checkpoint, such as a received message or a mapped file.
+  auto* flat = new std::string(builder->Build().value());
+  absl::Cord checkpoint = absl::MakeCordFromExternal(
+      *flat, [flat](absl::string_view) { delete flat; });
+  const char* begin = flat->data();
+  const char* end = begin + flat->size();
+
+  FederatedComputeCheckpointParserFactory parser_factory;
+  auto parser = parser_factory.Create(checkpoint);
+  ASSERT_OK(parser.status());
+  auto tensor1 = (*parser)->GetTensor("t1");
+  ASSERT_OK(tensor1.status());
+  auto tensor2 = (*parser)->GetTensor("t2");
+  ASSERT_OK(tensor2.status());
+  checkpoint.Clear();
+
+  // The tensors keep the checkpoint memory alive.
+  const char* values = static_cast<const char*>(tensor1->data().data());
+  EXPECT_TRUE(values >= begin && values < end);
+  EXPECT_THAT(tensor1->AsSpan<int32_t>(), Each(7));
+  const char* string_value = tensor2->AsSpan<absl::string_view>()[0].data();
+  EXPECT_TRUE(string_value >= begin && string_value < end);
+  EXPECT_THAT(*tensor2, IsTensor<absl::string_view>({2}, {"value1", "value2"}));
+}
+
+TEST(FederatedComputeCheckpointParserTest, AlignedV2_DictionaryEncodedStrings) {
+  FederatedComputeCheckpointBuilderFactory builder_factory(
+      FederatedComputeCheckpointFormat::kAlignedV2);
+  std::unique_ptr<CheckpointBuilder> builder = builder_factory.Create();
+  // Strings with few distinct values are dictionary encoded by the builder,
+  // and strings that already have a dictionary keep it.
+  ASSERT_OK(builder->Add(
+      "t1", Tensor::Create(DT_STRING, {5}, CreateTestData<absl::string_view>(
+                                               {"b", "a", "b", "b", "a"}))
+                .value()));
+  ASSERT_OK(builder->Add(
+      "t2", Tensor::Create(DT_STRING, {2},
+                           DictionaryStringData::Encode(
+                               std::vector<absl::string_view>({"c", "d"})))
+                .value()));
+  ASSERT_OK(builder->Add(
+      "t3", Tensor::Create(DT_STRING, {2}, CreateTestData<absl::string_view>(
+                                               {"e", "f"}))
+                .value()));
+  absl::Cord checkpoint = builder->Build().value();
+
+  FederatedComputeCheckpointParserFactory parser_factory;
+  for (size_t chunk_size : {1, 7, 1 << 20}) {
+    auto parser = parser_factory.Create(FragmentCord(checkpoint, chunk_size));
+    ASSERT_OK(parser.status());
+    auto tensor1 = (*parser)->GetTensor("t1");
+    ASSERT_OK(tensor1.status());
+    EXPECT_THAT(*tensor1, IsTensor<absl::string_view>(
+                              {5}, {"b", "a", "b", "b", "a"}));
+    const auto* data1 =
+        dynamic_cast<const DictionaryStringData*>(&tensor1->data());
+    ASSERT_NE(data1, nullptr);
+    EXPECT_THAT(data1->dictionary(), ElementsAre("b", "a"));
+    EXPECT_THAT(data1->codes(), ElementsAre(0, 1, 0, 0, 1));
+
+    auto tensor2 = (*parser)->GetTensor("t2");
+    ASSERT_OK(tensor2.status());
+    EXPECT_THAT(*tensor2, IsTensor<absl::string_view>({2}, {"c", "d"}));
+    EXPECT_NE(dynamic_cast<const DictionaryStringData*>(&tensor2->data()),
+              nullptr);
+
+    auto tensor3 = (*parser)->GetTensor("t3");
+    ASSERT_OK(tensor3.status());
+    EXPECT_THAT(*tensor3, IsTensor<absl::string_view>({2}, {"e", "f"}));
+    EXPECT_EQ(dynamic_cast<const DictionaryStringData*>(&tensor3->data()),
+              nullptr);
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest,
+     AlignedV2_DictionaryCodesOfOverflowingShape) {
+  // A dictionary encoded string tensor of shape {2^31, 2^31}, whose number of
+  // code bytes wraps around to 0, with no codes and an empty dictionary.
+  std::string checkpoint = kFederatedComputeCheckpointV2Header;
+  checkpoint += '\x01';
+  checkpoint += '\x01';
+  checkpoint += "t";
+  checkpoint += static_cast<char>(DT_STRING);
+  checkpoint += '\x02';
+  for (int i = 0; i < 2; ++i) {
+    checkpoint += absl::string_view("\x80\x80\x80\x80\x08", 5);
+  }
+  // Values offset and size, flags, dictionary size, codes offset and size.
+  checkpoint += '\x00';
+  checkpoint += '\x08';
+  checkpoint += static_cast<char>(kDictionaryTensorFlag);
+  checkpoint += std::string(3, '\x00');
+  checkpoint.resize(kFederatedComputeCheckpointV2Alignment + 8, '\x00');
+
+  FederatedComputeCheckpointParserFactory parser_factory;
+  EXPECT_THAT(parser_factory.Create(absl::Cord(checkpoint)),
+              StatusIs(INTERNAL));
+}
+
+TEST(FederatedComputeCheckpointParserTest, AlignedV2_BindingPlan_GetTensors) {
+  auto plan = std::make_shared<const TensorBindingPlan>(
+      std::vector<std::string>{"t3", "t1"});
+  for (bool lazy_decoding : {false, true}) {
+    FederatedComputeCheckpointParserFactory parser_factory(lazy_decoding);
+    auto parser = parser_factory.CreateWithBindingPlan(
+        BuildAlignedTestCheckpoint(), plan);
+    ASSERT_OK(parser.status());
+    std::vector<Tensor> tensors(plan->size());
+    ASSERT_OK((*parser)->GetTensors(*plan, absl::MakeSpan(tensors)));
+    EXPECT_THAT(tensors[0].sparse_indices(), ElementsAre(1, 3));
+    EXPECT_THAT(tensors[1], IsTensor<int64_t>({3}, {1, 2, 3}));
+    EXPECT_THAT((*parser)->GetTensor("t2"), StatusIs(NOT_FOUND));
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest, AlignedV2_TruncatedCheckpoint) {
+  std::string checkpoint(BuildAlignedTestCheckpoint());
+  FederatedComputeCheckpointParserFactory parser_factory;
+  // Checkpoints that end in the middle of the directory or of a buffer fail to
+  // parse.
+  for (size_t size :
+       {size_t{6}, size_t{10}, size_t{20},
+        checkpoint.size() - kFederatedComputeCheckpointV2Alignment}) {
+    EXPECT_THAT(
+        parser_factory.Create(absl::Cord(checkpoint.substr(0, size))),
+        StatusIs(INTERNAL))
+        << "size " << size;
+  }
+}
+
+TEST(FederatedComputeCheckpointParserTest, BindingPlan_GetMissingTensor) {
+  auto plan = std::make_shared<const TensorBindingPlan>(
+      std::vector<std::string>{"t1", "missing"});
+  FederatedComputeCheckpointParserFactory parser_factory;
+  auto parser =
+      parser_factory.CreateWithBindingPlan(BuildTestCheckpoint(), plan);
+  ASSERT_OK(parser.status());
+  auto tensor1 = (*parser)->GetTensor("t1");
+  ASSERT_OK(tensor1.status());
+  EXPECT_THAT(*tensor1, IsTensor<int64_t>({3}, {1, 2, 3}));
+  std::vector<Tensor> tensors(plan->size());
+  EXPECT_THAT((*parser)->GetTensors(*plan, absl::MakeSpan(tensors)),
+              StatusIs(NOT_FOUND));
+}
+
 }  // namespace
 }  // namespace tensorflow_federated::aggregation
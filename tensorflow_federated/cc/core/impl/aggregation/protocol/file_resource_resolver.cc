@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/file_resource_resolver.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/platform.h"
+
+namespace tensorflow_federated::aggregation {
+
+absl::StatusOr<absl::Cord> FileResourceResolver::RetrieveResource(
+    int64_t client_id, const std::string& uri) {
+  bool escapes_base_dir = uri.empty() || uri[0] == '/' || uri[0] == '\\';
+  for (absl::string_view component :
+       absl::StrSplit(uri, absl::ByAnyChar("/\\"))) {
+    escapes_base_dir |= component == "..";
+  }
+  if (escapes_base_dir) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid resource uri ", uri, " for client ", client_id));
+  }
+  const std::string path = ConcatPath(base_dir_, uri);
+  if (!FileExists(path)) {
+    return absl::NotFoundError(
+        absl::StrCat("No resource ", uri, " for client ", client_id));
+  }
+  TFF_ASSIGN_OR_RETURN(absl::Cord resource, MapFileToCord(path));
+  // Resources are accessed exactly once, and the mapping outlives the file.
+  RemoveFile(path).IgnoreError();
+  return resource;
+}
+
+}  // namespace tensorflow_federated::aggregation
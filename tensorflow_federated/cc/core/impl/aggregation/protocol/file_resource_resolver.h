@@ -0,0 +1,54 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_FILE_RESOURCE_RESOLVER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_FILE_RESOURCE_RESOLVER_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/resource_resolver.h"
+
+namespace tensorflow_federated::aggregation {
+
+// A ResourceResolver which reads the resources uploaded by clients from files,
+// whose paths are the uris relative to a base directory.
+//
+// Files are mapped into memory rather than read, so the returned Cord is a
+// single page aligned chunk that the zero-copy checkpoint parsers alias, and
+// the payload is never copied. Files are removed once they are mapped, and
+// their memory is released when the last tensor referencing it is destroyed.
+class FileResourceResolver final : public ResourceResolver {
+ public:
+  explicit FileResourceResolver(std::string base_dir)
+      : base_dir_(std::move(base_dir)) {}
+
+  // Returns INVALID_ARGUMENT for uris which are absolute or contain ".."
+  // components, and NOT_FOUND for missing files.
+  absl::StatusOr<absl::Cord> RetrieveResource(int64_t client_id,
+                                              const std::string& uri) override;
+
+ private:
+  const std::string base_dir_;
+};
+
+}  // namespace tensorflow_federated::aggregation
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_FILE_RESOURCE_RESOLVER_H_
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/file_resource_resolver.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/platform.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated::aggregation {
+namespace {
+
+std::string TestDir() {
+  return std::string(StripTrailingPathSeparator(testing::TempDir()));
+}
+
+TEST(FileResourceResolverTest, RetrievesAndRemovesFile) {
+  const std::string uri = "retrieves_and_removes_file.dat";
+  ASSERT_OK(WriteStringToFile(ConcatPath(TestDir(), uri), "payload"));
+  FileResourceResolver resolver(TestDir());
+
+  absl::StatusOr<absl::Cord> resource = resolver.RetrieveResource(1, uri);
+  ASSERT_OK(resource.status());
+  EXPECT_EQ(*resource, "payload");
+  EXPECT_FALSE(FileExists(ConcatPath(TestDir(), uri)));
+  EXPECT_THAT(resolver.RetrieveResource(1, uri), StatusIs(NOT_FOUND));
+}
+
+TEST(FileResourceResolverTest, ParsedTensorsAliasMappedFile) {
+  FederatedComputeCheckpointBuilderFactory builder_factory(
+      FederatedComputeCheckpointFormat::kAlignedV2);
+  std::unique_ptr<CheckpointBuilder> builder = builder_factory.Create();
+  ASSERT_OK(builder->Add(
+      "t", Tensor::Create(DT_INT64, {3}, CreateTestData<int64_t>({1, 2, 3}))
+               .value()));
+  const std::string uri = "parsed_tensors_alias_mapped_file.ckpt";
+  ASSERT_OK(WriteCordToFile(ConcatPath(TestDir(), uri),
+                            builder->Build().value()));
+  FileResourceResolver resolver(TestDir());
+
+  absl::StatusOr<absl::Cord> resource = resolver.RetrieveResource(1, uri);
+  ASSERT_OK(resource.status());
+  absl::string_view mapped = resource->Flatten();
+  FederatedComputeCheckpointParserFactory parser_factory;
+  auto parser = parser_factory.Create(*resource);
+  ASSERT_OK(parser.status());
+  resource = absl::Cord();
+  absl::StatusOr<Tensor> tensor = (*parser)->GetTensor("t");
+  ASSERT_OK(tensor.status());
+  EXPECT_THAT(*tensor, IsTensor<int64_t>({3}, {1, 2, 3}));
+  const char* values = static_cast<const char*>(tensor->data().data());
+  EXPECT_TRUE(values >= mapped.data() &&
+              values < mapped.data() + mapped.size());
+}
+
+TEST(FileResourceResolverTest, RejectsUrisOutsideBaseDir) {
+  FileResourceResolver resolver(TestDir());
+  for (const char* uri : {"", "/etc/passwd", "../file", "dir/../../file"}) {
+    EXPECT_THAT(resolver.RetrieveResource(1, uri), StatusIs(INVALID_ARGUMENT))
+        << uri;
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow_federated::aggregation
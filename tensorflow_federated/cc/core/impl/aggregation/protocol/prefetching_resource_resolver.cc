@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/prefetching_resource_resolver.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/resource_resolver.h"
+
+namespace tensorflow_federated::aggregation {
+
+PrefetchingResourceResolver::PrefetchingResourceResolver(
+    ResourceResolver* resolver, size_t num_threads)
+    : resolver_(resolver),
+      scheduler_(CreateThreadPoolScheduler(num_threads,
+                                           "PrefetchingResourceResolver")) {
+  TFF_CHECK(resolver_ != nullptr);
+}
+
+PrefetchingResourceResolver::~PrefetchingResourceResolver() {
+  scheduler_->WaitUntilIdle();
+}
+
+void PrefetchingResourceResolver::PrefetchResources(
+    absl::Span<const ResourceRequest> requests) {
+  absl::MutexLock lock(&mu_);
+  for (const ResourceRequest& request : requests) {
+    auto [it, inserted] = fetches_.try_emplace(
+        std::make_pair(request.client_id, request.uri), nullptr);
+    if (!inserted) {
+      // The resource is already being fetched.
+      continue;
+    }
+    auto fetch = std::make_shared<Fetch>();
+    it->second = fetch;
+    scheduler_->Schedule([this, fetch, request]() {
+      absl::StatusOr<absl::Cord> resource =
+          resolver_->RetrieveResource(request.client_id, request.uri);
+      absl::MutexLock lock(&mu_);
+      fetch->resource = std::move(resource);
+      fetch->done = true;
+    });
+  }
+}
+
+absl::StatusOr<absl::Cord> PrefetchingResourceResolver::RetrieveResource(
+    int64_t client_id, const std::string& uri) {
+  std::shared_ptr<Fetch> fetch;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = fetches_.find(std::make_pair(client_id, uri));
+    if (it != fetches_.end()) {
+      fetch = std::move(it->second);
+      fetches_.erase(it);
+      mu_.Await(absl::Condition(&fetch->done));
+    }
+  }
+  if (fetch == nullptr) {
+    return resolver_->RetrieveResource(client_id, uri);
+  }
+  return std::move(fetch->resource);
+}
+
+}  // namespace tensorflow_federated::aggregation
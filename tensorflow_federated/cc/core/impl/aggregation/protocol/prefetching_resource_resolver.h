@@ -0,0 +1,82 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_PREFETCHING_RESOURCE_RESOLVER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_PREFETCHING_RESOURCE_RESOLVER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/resource_resolver.h"
+
+namespace tensorflow_federated::aggregation {
+
+// A ResourceResolver which fetches prefetched resources from another resolver
+// on a pool of threads, so that the latency of fetching the input of a client
+// overlaps with parsing and aggregating the inputs of other clients.
+//
+// RetrieveResource returns the prefetched resource, waiting for its fetch to
+// finish if needed, or fetches the resource on the calling thread if it
+// hasn't been prefetched. Prefetched resources which are never retrieved are
+// held until the resolver is destroyed.
+class PrefetchingResourceResolver final : public ResourceResolver {
+ public:
+  // Does not take ownership of `resolver`, which must outlive this object and
+  // support concurrent RetrieveResource calls. At most `num_threads`
+  // resources are fetched concurrently.
+  PrefetchingResourceResolver(ResourceResolver* resolver,
+                              size_t num_threads);
+
+  // Waits for the pending fetches to finish.
+  ~PrefetchingResourceResolver() override;
+
+  // PrefetchingResourceResolver is neither copyable nor movable.
+  PrefetchingResourceResolver(const PrefetchingResourceResolver&) = delete;
+  PrefetchingResourceResolver& operator=(const PrefetchingResourceResolver&) =
+      delete;
+
+  void PrefetchResources(absl::Span<const ResourceRequest> requests) override;
+
+  absl::StatusOr<absl::Cord> RetrieveResource(int64_t client_id,
+                                              const std::string& uri) override;
+
+ private:
+  struct Fetch {
+    bool done = false;
+    absl::StatusOr<absl::Cord> resource;
+  };
+
+  ResourceResolver* const resolver_;
+  absl::Mutex mu_;
+  // The prefetched resources, keyed by client id and uri.
+  absl::flat_hash_map<std::pair<int64_t, std::string>, std::shared_ptr<Fetch>>
+      fetches_ ABSL_GUARDED_BY(mu_);
+  std::unique_ptr<Scheduler> scheduler_;
+};
+
+}  // namespace tensorflow_federated::aggregation
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_PREFETCHING_RESOURCE_RESOLVER_H_
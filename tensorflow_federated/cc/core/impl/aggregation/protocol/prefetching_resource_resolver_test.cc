@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/prefetching_resource_resolver.h"
+
+#include <cstdint>
+#include <string>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/synchronization/barrier.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/resource_resolver.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/mocks.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated::aggregation {
+namespace {
+
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::StrEq;
+
+TEST(PrefetchingResourceResolverTest, RetrievesPrefetchedResourceOnce) {
+  MockResourceResolver resolver;
+  EXPECT_CALL(resolver, RetrieveResource(1, StrEq("foo_uri")))
+      .WillOnce(Return(absl::Cord("foo")));
+  PrefetchingResourceResolver prefetching_resolver(&resolver,
+                                                   /*num_threads=*/2);
+  prefetching_resolver.PrefetchResources({{1, "foo_uri"}, {1, "foo_uri"}});
+  EXPECT_THAT(prefetching_resolver.RetrieveResource(1, "foo_uri"),
+              IsOkAndHolds(absl::Cord("foo")));
+}
+
+TEST(PrefetchingResourceResolverTest, RetrievesResourceNotPrefetched) {
+  MockResourceResolver resolver;
+  EXPECT_CALL(resolver, RetrieveResource(2, StrEq("bar_uri")))
+      .WillOnce(Return(absl::Cord("bar")));
+  PrefetchingResourceResolver prefetching_resolver(&resolver,
+                                                   /*num_threads=*/2);
+  EXPECT_THAT(prefetching_resolver.RetrieveResource(2, "bar_uri"),
+              IsOkAndHolds(absl::Cord("bar")));
+}
+
+TEST(PrefetchingResourceResolverTest, ReturnsPrefetchError) {
+  MockResourceResolver resolver;
+  EXPECT_CALL(resolver, RetrieveResource(1, StrEq("foo_uri")))
+      .WillOnce(Return(absl::NotFoundError("missing")));
+  PrefetchingResourceResolver prefetching_resolver(&resolver,
+                                                   /*num_threads=*/2);
+  prefetching_resolver.PrefetchResources({{1, "foo_uri"}});
+  EXPECT_THAT(prefetching_resolver.RetrieveResource(1, "foo_uri"),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(PrefetchingResourceResolverTest, PrefetchesResourcesConcurrently) {
+  constexpr int kNumResources = 4;
+  MockResourceResolver resolver;
+  // Each fetch only finishes once all of them have started.
+  absl::Barrier fetches_started(kNumResources);
+  EXPECT_CALL(resolver, RetrieveResource)
+      .Times(kNumResources)
+      .WillRepeatedly(Invoke([&](int64_t client_id, const std::string& uri) {
+        fetches_started.Block();
+        return absl::Cord(uri);
+      }));
+  PrefetchingResourceResolver prefetching_resolver(&resolver, kNumResources);
+  prefetching_resolver.PrefetchResources(
+      {{0, "uri_0"}, {1, "uri_1"}, {2, "uri_2"}, {3, "uri_3"}});
+  for (int i = 0; i < kNumResources; ++i) {
+    std::string uri = "uri_" + std::to_string(i);
+    EXPECT_THAT(prefetching_resolver.RetrieveResource(i, uri),
+                IsOkAndHolds(absl::Cord(uri)));
+  }
+}
+
+}  // namespace
+}  // namespace tensorflow_federated::aggregation
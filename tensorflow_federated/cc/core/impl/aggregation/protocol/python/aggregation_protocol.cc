@@ -17,13 +17,27 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol.h"
 
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "pybind11_abseil/absl_casters.h"
 #include "pybind11_abseil/status_casters.h"
 #include "pybind11_protobuf/native_proto_caster.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol_messages.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/configuration.pb.h"
 
@@ -32,6 +46,66 @@ namespace {
 namespace py = ::pybind11;
 
 using ::tensorflow_federated::aggregation::AggregationProtocol;
+using ::tensorflow_federated::aggregation::ClientMessage;
+
+// Holds a Cord whose content is exposed to Python through the buffer protocol,
+// so that it can be read, e.g. with `memoryview` or `np.frombuffer`, without
+// being copied into a `bytes` object. Buffers obtained from it keep it alive.
+class CordBuffer {
+ public:
+  explicit CordBuffer(absl::Cord cord) : cord_(std::move(cord)) {}
+
+  // Returns the contiguous content of the Cord, which is only copied if the
+  // Cord consists of more than one chunk.
+  absl::string_view Flatten() { return cord_.Flatten(); }
+
+  size_t size() const { return cord_.size(); }
+
+ private:
+  absl::Cord cord_;
+};
+
+// Passes each (client_id, message) pair to `ReceiveClientMessage`, with up to
+// `num_threads` messages processed concurrently, or one per core if
+// `num_threads` is less than one. Must be called without the GIL. Returns the
+// first error, once all messages have been processed.
+absl::Status ReceiveClientMessages(
+    AggregationProtocol* ap,
+    std::vector<std::pair<int64_t, ClientMessage>> messages,
+    int num_threads) {
+  if (num_threads < 1) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min<size_t>(num_threads, messages.size());
+  if (num_threads <= 1) {
+    absl::Status status = absl::OkStatus();
+    for (auto& [client_id, message] : messages) {
+      status.Update(ap->ReceiveClientMessage(client_id, std::move(message)));
+    }
+    return status;
+  }
+
+  std::atomic<size_t> next = 0;
+  absl::Mutex mu;
+  absl::Status status = absl::OkStatus();
+  std::unique_ptr<tensorflow_federated::Scheduler> scheduler =
+      tensorflow_federated::CreateThreadPoolScheduler(num_threads);
+  for (int i = 0; i < num_threads; ++i) {
+    scheduler->Schedule([&]() {
+      for (size_t index = next++; index < messages.size(); index = next++) {
+        auto& [client_id, message] = messages[index];
+        absl::Status message_status =
+            ap->ReceiveClientMessage(client_id, std::move(message));
+        if (!message_status.ok()) {
+          absl::MutexLock lock(&mu);
+          status.Update(message_status);
+        }
+      }
+    });
+  }
+  scheduler->WaitUntilIdle();
+  return status;
+}
 
 }  // namespace
 
@@ -39,12 +113,42 @@ PYBIND11_MODULE(aggregation_protocol, m) {
   pybind11::google::ImportStatusModule();
   pybind11_protobuf::ImportNativeProtoCasters();
 
+  py::class_<CordBuffer>(m, "CordBuffer", py::buffer_protocol())
+      .def_buffer([](CordBuffer& buffer) {
+        absl::string_view data = buffer.Flatten();
+        return py::buffer_info(const_cast<char*>(data.data()),
+                               sizeof(uint8_t),
+                               py::format_descriptor<uint8_t>::format(),
+                               /*ndim=*/1, {data.size()}, {sizeof(uint8_t)},
+                               /*readonly=*/true);
+      })
+      .def("__len__", &CordBuffer::size);
+
   auto py_aggregation_protocol =
       py::class_<AggregationProtocol>(m, "AggregationProtocol")
           .def("Start", &AggregationProtocol::Start)
           .def("AddClients", &AggregationProtocol::AddClients)
+          // The message is converted from Python into a new object, so its
+          // content can be moved into the protocol.
           .def("ReceiveClientMessage",
-               &AggregationProtocol::ReceiveClientMessage)
+               [](AggregationProtocol* ap, int64_t client_id,
+                  ClientMessage message) {
+                 return ap->ReceiveClientMessage(client_id,
+                                                 std::move(message));
+               })
+          // Receives the messages of many clients with a single call, which
+          // processes them concurrently with the GIL released. The messages
+          // are converted from Python before the GIL is released.
+          .def(
+              "ReceiveClientMessages",
+              [](AggregationProtocol* ap,
+                 std::vector<std::pair<int64_t, ClientMessage>> messages,
+                 int num_threads) {
+                py::gil_scoped_release release;
+                return ReceiveClientMessages(ap, std::move(messages),
+                                             num_threads);
+              },
+              py::arg("messages"), py::arg("num_threads") = 0)
           // TODO: b/319889173 - Re-enable `absl::Status` use here once the TF
           // pybind11_abseil import issue is resolved.
           .def("CloseClient",
@@ -60,5 +164,15 @@ PYBIND11_MODULE(aggregation_protocol, m) {
           .def("Abort", &AggregationProtocol::Abort)
           .def("GetStatus", &AggregationProtocol::GetStatus)
           .def("GetResult", &AggregationProtocol::GetResult)
+          // Like `GetResult`, but returns the result as a `CordBuffer` rather
+          // than copying it into a `bytes` object.
+          .def("GetResultBuffer",
+               [](AggregationProtocol* ap) -> absl::StatusOr<CordBuffer> {
+                 absl::StatusOr<absl::Cord> result = ap->GetResult();
+                 if (!result.ok()) {
+                   return result.status();
+                 }
+                 return CordBuffer(*std::move(result));
+               })
           .def("PollServerMessage", &AggregationProtocol::PollServerMessage);
 }
@@ -22,15 +22,28 @@
 
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
+#include "absl/types/span.h"
 
 namespace tensorflow_federated::aggregation {
 
+// Identifies a resource uploaded by a client.
+struct ResourceRequest {
+  int64_t client_id;
+  std::string uri;
+};
+
 // Describes an abstract interface for resolving a resource from a given client
 // and uri.
 class ResourceResolver {
  public:
   virtual ~ResourceResolver() = default;
 
+  // Hints that the resources for the given `requests` will soon be retrieved,
+  // so that they can be fetched ahead of the RetrieveResource calls, e.g.
+  // while the inputs of other clients are being aggregated. Resolvers which
+  // can't fetch resources asynchronously ignore the hint.
+  virtual void PrefetchResources(absl::Span<const ResourceRequest> requests) {}
+
   // Retrieves a resource for the given `client_id` and `uri` combination.
   // The resource can be accessed exactly once and must be deleted (best-effort)
   // after it is returned.
@@ -16,6 +16,7 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/simple_aggregation/simple_aggregation_protocol.h"
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -25,15 +26,19 @@
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/clock.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/numa.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol_messages.pb.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
@@ -77,19 +82,23 @@ SimpleAggregationProtocol::Create(
     const CheckpointParserFactory* checkpoint_parser_factory,
     const CheckpointBuilderFactory* checkpoint_builder_factory,
     ResourceResolver* resource_resolver, Clock* clock,
-    std::optional<OutlierDetectionParameters> outlier_detection_parameters) {
+    std::optional<OutlierDetectionParameters> outlier_detection_parameters,
+    int num_aggregator_shards,
+    SimpleAggregationIngestionOptions ingestion_options) {
   TFF_CHECK(checkpoint_parser_factory != nullptr);
   TFF_CHECK(checkpoint_builder_factory != nullptr);
   TFF_CHECK(resource_resolver != nullptr);
   TFF_CHECK(clock != nullptr);
 
   TFF_ASSIGN_OR_RETURN(auto checkpoint_aggregator,
-                       CheckpointAggregator::Create(configuration));
+                       CheckpointAggregator::Create(
+                           configuration, num_aggregator_shards,
+                           ingestion_options.num_numa_nodes));
 
   return absl::WrapUnique(new SimpleAggregationProtocol(
       std::move(checkpoint_aggregator), checkpoint_parser_factory,
       checkpoint_builder_factory, resource_resolver, clock,
-      std::move(outlier_detection_parameters)));
+      std::move(outlier_detection_parameters), ingestion_options));
 }
 
 SimpleAggregationProtocol::SimpleAggregationProtocol(
@@ -97,13 +106,25 @@ SimpleAggregationProtocol::SimpleAggregationProtocol(
     const CheckpointParserFactory* checkpoint_parser_factory,
     const CheckpointBuilderFactory* checkpoint_builder_factory,
     ResourceResolver* resource_resolver, Clock* clock,
-    std::optional<OutlierDetectionParameters> outlier_detection_parameters)
+    std::optional<OutlierDetectionParameters> outlier_detection_parameters,
+    SimpleAggregationIngestionOptions ingestion_options)
     : protocol_state_(PROTOCOL_CREATED),
       checkpoint_aggregator_(std::move(checkpoint_aggregator)),
       checkpoint_parser_factory_(checkpoint_parser_factory),
       checkpoint_builder_factory_(checkpoint_builder_factory),
       resource_resolver_(resource_resolver),
       clock_(clock),
+      state_lock_latency_(MetricsRegistry::Default().GetLatencyHistogram(
+          "SimpleAggregationProtocol::StateLock")),
+      outlier_detection_latency_(
+          MetricsRegistry::Default().GetLatencyHistogram(
+              "SimpleAggregationProtocol::PerformOutlierDetection")),
+      get_status_latency_(MetricsRegistry::Default().GetLatencyHistogram(
+          "SimpleAggregationProtocol::GetStatus")),
+      max_inputs_in_flight_(ingestion_options.max_inputs_in_flight),
+      retrieval_limiter_(ingestion_options.max_concurrent_retrievals),
+      parse_limiter_(ingestion_options.max_concurrent_parses),
+      accumulation_limiter_(ingestion_options.max_concurrent_accumulations),
       outlier_detection_parameters_(std::move(outlier_detection_parameters)) {}
 
 SimpleAggregationProtocol::~SimpleAggregationProtocol() {
@@ -111,6 +132,42 @@ SimpleAggregationProtocol::~SimpleAggregationProtocol() {
   StopOutlierDetection();
 }
 
+bool SimpleAggregationProtocol::StageLimiter::HasCapacity() const {
+  return limit_ < 1 || num_running_ < limit_;
+}
+
+void SimpleAggregationProtocol::StageLimiter::Acquire() {
+  absl::MutexLock lock(&mu_);
+  num_waiting_++;
+  mu_.Await(absl::Condition(this, &StageLimiter::HasCapacity));
+  num_waiting_--;
+  num_running_++;
+}
+
+void SimpleAggregationProtocol::StageLimiter::Release() {
+  absl::MutexLock lock(&mu_);
+  num_running_--;
+}
+
+void SimpleAggregationProtocol::StageLimiter::Record(absl::Duration wait_time,
+                                                     absl::Duration run_time) {
+  num_inputs_.fetch_add(1, std::memory_order_relaxed);
+  total_wait_nanos_.fetch_add(absl::ToInt64Nanoseconds(wait_time),
+                              std::memory_order_relaxed);
+  total_run_nanos_.fetch_add(absl::ToInt64Nanoseconds(run_time),
+                             std::memory_order_relaxed);
+}
+
+void SimpleAggregationProtocol::StageLimiter::GetMetrics(
+    StageMetrics& metrics) const {
+  metrics.set_num_inputs(num_inputs_.load(std::memory_order_relaxed));
+  metrics.set_num_waiting(num_waiting_.load(std::memory_order_relaxed));
+  metrics.set_num_running(num_running_.load(std::memory_order_relaxed));
+  metrics.set_total_wait_nanos(
+      total_wait_nanos_.load(std::memory_order_relaxed));
+  metrics.set_total_run_nanos(total_run_nanos_.load(std::memory_order_relaxed));
+}
+
 absl::string_view SimpleAggregationProtocol::ClientStateDebugString(
     ClientState state) {
   switch (state) {
@@ -131,10 +188,10 @@ absl::string_view SimpleAggregationProtocol::ClientStateDebugString(
 
 absl::Status SimpleAggregationProtocol::CheckProtocolState(
     ProtocolState state) const {
-  if (protocol_state_ != state) {
+  if (protocol_state_.load() != state) {
     return absl::FailedPreconditionError(absl::StrFormat(
         "The current protocol state is %s, expected %s.",
-        ProtocolState_Name(protocol_state_), ProtocolState_Name(state)));
+        ProtocolState_Name(protocol_state_.load()), ProtocolState_Name(state)));
   }
   return absl::OkStatus();
 }
@@ -145,9 +202,9 @@ void SimpleAggregationProtocol::SetProtocolState(ProtocolState state) {
       (protocol_state_ == PROTOCOL_STARTED &&
        (state == PROTOCOL_COMPLETED || state == PROTOCOL_ABORTED)))
       << "Invalid protocol state transition from "
-      << ProtocolState_Name(protocol_state_) << " to "
+      << ProtocolState_Name(protocol_state_.load()) << " to "
       << ProtocolState_Name(state) << ".";
-  protocol_state_ = state;
+  protocol_state_.store(state);
 }
 
 absl::StatusOr<SimpleAggregationProtocol::ClientState>
@@ -163,9 +220,11 @@ int64_t SimpleAggregationProtocol::AddPendingClients(size_t num_clients) {
   int64_t start_index = all_clients_.size();
   int64_t end_index = start_index + num_clients;
   all_clients_.resize(end_index, {CLIENT_PENDING, std::nullopt});
+  num_clients_ = end_index;
   absl::Time now = clock_->Now();
   for (int64_t client_id = start_index; client_id < end_index; ++client_id) {
     pending_clients_.emplace(client_id, now);
+    pending_clients_by_start_time_.emplace(now, client_id);
   }
   return start_index;
 }
@@ -187,7 +246,10 @@ void SimpleAggregationProtocol::SetClientState(int64_t client_id,
         << "Client state can't be changed from "
         << ClientStateDebugString(from_state);
     // Remove the client from the pending set.
-    pending_clients_.erase(client_id);
+    auto it = pending_clients_.find(client_id);
+    TFF_CHECK(it != pending_clients_.end());
+    pending_clients_by_start_time_.erase({it->second, client_id});
+    pending_clients_.erase(it);
   }
   all_clients_[client_id].state = to_state;
   switch (to_state) {
@@ -231,7 +293,7 @@ absl::Status SimpleAggregationProtocol::Start(int64_t num_clients) {
     return absl::InvalidArgumentError("Number of clients cannot be negative.");
   }
   {
-    absl::MutexLock lock(&state_mu_);
+    StateLock lock(this);
     TFF_RETURN_IF_ERROR(CheckProtocolState(PROTOCOL_CREATED));
     SetProtocolState(PROTOCOL_STARTED);
     TFF_CHECK(all_clients_.empty());
@@ -245,7 +307,7 @@ absl::StatusOr<int64_t> SimpleAggregationProtocol::AddClients(
     int64_t num_clients) {
   int64_t start_index;
   {
-    absl::MutexLock lock(&state_mu_);
+    StateLock lock(this);
     TFF_RETURN_IF_ERROR(CheckProtocolState(PROTOCOL_STARTED));
     if (num_clients <= 0) {
       return absl::InvalidArgumentError("Non-zero number of clients required");
@@ -257,6 +319,23 @@ absl::StatusOr<int64_t> SimpleAggregationProtocol::AddClients(
 
 absl::Status SimpleAggregationProtocol::ReceiveClientMessage(
     int64_t client_id, const ClientMessage& message) {
+  return ReceiveClientInput(client_id, message, [&] {
+    return absl::Cord(message.simple_aggregation().input().inline_bytes());
+  });
+}
+
+absl::Status SimpleAggregationProtocol::ReceiveClientMessage(
+    int64_t client_id, ClientMessage&& message) {
+  return ReceiveClientInput(client_id, message, [&] {
+    return absl::Cord(std::move(*message.mutable_simple_aggregation()
+                                     ->mutable_input()
+                                     ->mutable_inline_bytes()));
+  });
+}
+
+absl::Status SimpleAggregationProtocol::ReceiveClientInput(
+    int64_t client_id, const ClientMessage& message,
+    absl::FunctionRef<absl::Cord()> take_inline_bytes) {
   if (!message.has_simple_aggregation() ||
       !message.simple_aggregation().has_input()) {
     return absl::InvalidArgumentError("Unexpected message");
@@ -272,7 +351,7 @@ absl::Status SimpleAggregationProtocol::ReceiveClientMessage(
 
   // Verify the state.
   {
-    absl::MutexLock lock(&state_mu_);
+    StateLock lock(this);
     if (protocol_state_ == PROTOCOL_CREATED) {
       return absl::FailedPreconditionError("The protocol hasn't been started");
     }
@@ -286,22 +365,41 @@ absl::Status SimpleAggregationProtocol::ReceiveClientMessage(
                     << ClientStateDebugString(client_state);
       return absl::OkStatus();
     }
+    // Reject the input before changing the client state, so that the client
+    // remains pending and the input can be sent again.
+    uint64_t num_inputs_in_flight = num_clients_received_and_pending_;
+    if (max_inputs_in_flight_ > 0 &&
+        num_inputs_in_flight >= max_inputs_in_flight_) {
+      return absl::UnavailableError(absl::StrFormat(
+          "Too many client inputs are being aggregated (%d), retry later.",
+          num_inputs_in_flight));
+    }
     client_latency = clock_->Now() - pending_clients_[client_id];
     SetClientState(client_id, CLIENT_RECEIVED_INPUT_AND_PENDING);
   }
 
+  // Ingest the input on the NUMA node of the shards it is accumulated into,
+  // so that the report, the parsed tensors and the aggregation state it is
+  // accumulated into are local to the node.
+  const int numa_node = GetClientNumaNode(client_id);
+  std::optional<ScopedNumaNodeAffinity> numa_affinity;
+  if (checkpoint_aggregator_->num_numa_nodes() > 1) {
+    numa_affinity.emplace(numa_node);
+  }
+
   absl::Status client_completion_status = absl::OkStatus();
   ClientState client_completion_state = CLIENT_COMPLETED;
 
   absl::Cord report;
   if (message.simple_aggregation().input().has_inline_bytes()) {
     // Parse the client input concurrently with other protocol calls.
-    report =
-        absl::Cord(message.simple_aggregation().input().inline_bytes());
+    report = take_inline_bytes();
   } else {
     absl::StatusOr<absl::Cord> report_or_status =
-        resource_resolver_->RetrieveResource(
-            client_id, message.simple_aggregation().input().uri());
+        RunStage(retrieval_limiter_, [&] {
+          return resource_resolver_->RetrieveResource(
+              client_id, message.simple_aggregation().input().uri());
+        });
     if (!report_or_status.ok()) {
       client_completion_status = report_or_status.status();
       client_completion_state = CLIENT_FAILED;
@@ -315,16 +413,22 @@ absl::Status SimpleAggregationProtocol::ReceiveClientMessage(
   }
 
   if (client_completion_state != CLIENT_FAILED) {
+    bytes_ingested_.fetch_add(report.size(), std::memory_order_relaxed);
     absl::StatusOr<std::unique_ptr<CheckpointParser>> parser_or_status =
-        checkpoint_parser_factory_->Create(report);
+        RunStage(parse_limiter_, [&] {
+          return checkpoint_parser_factory_->CreateWithBindingPlan(
+              report, checkpoint_aggregator_->GetTensorBindingPlan());
+        });
     if (!parser_or_status.ok()) {
       client_completion_status = parser_or_status.status();
       client_completion_state = CLIENT_FAILED;
       TFF_LOG(WARNING) << "Client " << client_id << " input can't be parsed: "
                        << client_completion_status;
     } else {
-      client_completion_status =
-          checkpoint_aggregator_->Accumulate(*parser_or_status.value());
+      client_completion_status = RunStage(accumulation_limiter_, [&] {
+        return checkpoint_aggregator_->AccumulateOnNumaNode(
+            *parser_or_status.value(), numa_node);
+      });
       if (client_completion_status.code() == StatusCode::kAborted) {
         client_completion_state = CLIENT_DISCARDED;
         TFF_LOG(INFO) << "Client " << client_id
@@ -339,20 +443,23 @@ absl::Status SimpleAggregationProtocol::ReceiveClientMessage(
   }
 
   // Update the state post aggregation.
+  ServerMessage close_message =
+      MakeCloseClientMessage(client_completion_status);
   {
-    absl::MutexLock lock(&state_mu_);
+    StateLock lock(this);
     SetClientState(client_id, client_completion_state);
-    latency_aggregator_.Add(client_latency);
-    ServerMessage close_message =
-        MakeCloseClientMessage(client_completion_status);
     all_clients_[client_id].server_message = std::move(close_message);
   }
+  {
+    absl::MutexLock lock(&latency_mu_);
+    latency_aggregator_.Add(client_latency);
+  }
   return absl::OkStatus();
 }
 
 absl::StatusOr<std::optional<ServerMessage>>
 SimpleAggregationProtocol::PollServerMessage(int64_t client_id) {
-  absl::MutexLock lock(&state_mu_);
+  StateLock lock(this);
   if (protocol_state_ == PROTOCOL_CREATED) {
     return absl::FailedPreconditionError("The protocol hasn't been started");
   }
@@ -368,7 +475,7 @@ SimpleAggregationProtocol::PollServerMessage(int64_t client_id) {
 absl::Status SimpleAggregationProtocol::CloseClient(
     int64_t client_id, absl::Status client_status) {
   {
-    absl::MutexLock lock(&state_mu_);
+    StateLock lock(this);
     if (protocol_state_ == PROTOCOL_CREATED) {
       return absl::FailedPreconditionError("The protocol hasn't been started");
     }
@@ -443,7 +550,7 @@ void SimpleAggregationProtocol::AwaitAggregationQueueEmpty() {
 absl::Status SimpleAggregationProtocol::Complete() {
   StopOutlierDetection();
   absl::Cord result;
-  absl::MutexLock lock(&state_mu_);
+  StateLock lock(this);
   TFF_RETURN_IF_ERROR(CheckProtocolState(PROTOCOL_STARTED));
   auto report = CreateReport();
   if (report.ok()) {
@@ -459,7 +566,7 @@ absl::Status SimpleAggregationProtocol::Complete() {
 
 absl::Status SimpleAggregationProtocol::Abort() {
   StopOutlierDetection();
-  absl::MutexLock lock(&state_mu_);
+  StateLock lock(this);
   TFF_RETURN_IF_ERROR(CheckProtocolState(PROTOCOL_STARTED));
   checkpoint_aggregator_->Abort();
   SetProtocolState(PROTOCOL_ABORTED);
@@ -469,33 +576,87 @@ absl::Status SimpleAggregationProtocol::Abort() {
 }
 
 StatusMessage SimpleAggregationProtocol::GetStatus() {
-  absl::MutexLock lock(&state_mu_);
-  int64_t num_clients_completed = num_clients_received_and_pending_ +
-                                  num_clients_aggregated_ +
-                                  num_clients_discarded_;
+  ScopedLatencyTimer timer(get_status_latency_);
+  // SetClientState decrements the counter of the previous state of a client
+  // before incrementing the counter of the new state. Reading the counters of
+  // later states first therefore never counts a client twice.
+  uint64_t num_clients_discarded = num_clients_discarded_;
+  uint64_t num_clients_failed = num_clients_failed_;
+  uint64_t num_clients_aborted = num_clients_aborted_;
+  uint64_t num_clients_aggregated = num_clients_aggregated_;
+  uint64_t num_clients_received_and_pending = num_clients_received_and_pending_;
+  int64_t num_clients = num_clients_;
+  int64_t num_clients_completed = num_clients_received_and_pending +
+                                  num_clients_aggregated +
+                                  num_clients_discarded;
   StatusMessage message;
-  message.set_protocol_state(protocol_state_);
+  message.set_protocol_state(protocol_state_.load());
   message.set_num_clients_completed(num_clients_completed);
-  message.set_num_clients_failed(num_clients_failed_);
-  message.set_num_clients_pending(all_clients_.size() - num_clients_completed -
-                                  num_clients_failed_ - num_clients_aborted_);
-  message.set_num_inputs_aggregated_and_included(num_clients_aggregated_);
+  message.set_num_clients_failed(num_clients_failed);
+  message.set_num_clients_pending(num_clients - num_clients_completed -
+                                  num_clients_failed - num_clients_aborted);
+  message.set_num_inputs_aggregated_and_included(num_clients_aggregated);
   message.set_num_inputs_aggregated_and_pending(
-      num_clients_received_and_pending_);
-  message.set_num_clients_aborted(num_clients_aborted_);
-  message.set_num_inputs_discarded(num_clients_discarded_);
+      num_clients_received_and_pending);
+  message.set_num_clients_aborted(num_clients_aborted);
+  message.set_num_inputs_discarded(num_clients_discarded);
   return message;
 }
 
+IngestionMetrics SimpleAggregationProtocol::GetIngestionMetrics() const {
+  IngestionMetrics metrics;
+  retrieval_limiter_.GetMetrics(*metrics.mutable_retrieval());
+  parse_limiter_.GetMetrics(*metrics.mutable_parse());
+  accumulation_limiter_.GetMetrics(*metrics.mutable_accumulation());
+  metrics.set_accumulation_lock_wait_nanos(absl::ToInt64Nanoseconds(
+      checkpoint_aggregator_->GetAccumulateLockWaitTime()));
+  metrics.set_bytes_ingested(bytes_ingested_.load(std::memory_order_relaxed));
+  metrics.set_aggregator_memory_bytes(checkpoint_aggregator_->GetMemoryUsage());
+  return metrics;
+}
+
+absl::StatusOr<absl::Cord> SimpleAggregationProtocol::ReportSnapshot() {
+  {
+    StateLock lock(this);
+    TFF_RETURN_IF_ERROR(CheckProtocolState(PROTOCOL_STARTED));
+  }
+  // The snapshot is built without holding the state lock so that clients
+  // can keep changing state meanwhile. If the protocol is completed or
+  // aborted concurrently, the aggregator reports that it has finished.
+  std::unique_ptr<CheckpointBuilder> checkpoint_builder =
+      checkpoint_builder_factory_->Create();
+  TFF_RETURN_IF_ERROR(
+      checkpoint_aggregator_->ReportSnapshot(*checkpoint_builder));
+  return checkpoint_builder->Build();
+}
+
+absl::StatusOr<absl::Cord> SimpleAggregationProtocol::TakeStateDelta() {
+  {
+    StateLock lock(this);
+    TFF_RETURN_IF_ERROR(CheckProtocolState(PROTOCOL_STARTED));
+  }
+  // As in ReportSnapshot, the state lock isn't held while the delta is
+  // serialized.
+  return checkpoint_aggregator_->SerializeDelta();
+}
+
+absl::Status SimpleAggregationProtocol::MergeState(const absl::Cord& state) {
+  {
+    StateLock lock(this);
+    TFF_RETURN_IF_ERROR(CheckProtocolState(PROTOCOL_STARTED));
+  }
+  return checkpoint_aggregator_->MergeSerialized(state);
+}
+
 absl::StatusOr<absl::Cord> SimpleAggregationProtocol::GetResult() {
-  absl::MutexLock lock(&state_mu_);
+  StateLock lock(this);
   TFF_RETURN_IF_ERROR(CheckProtocolState(PROTOCOL_COMPLETED));
   return result_;
 }
 
 absl::StatusOr<bool> SimpleAggregationProtocol::IsClientClosed(
     int64_t client_id) {
-  absl::MutexLock lock(&state_mu_);
+  StateLock lock(this);
   if (client_id < 0 || client_id >= all_clients_.size()) {
     return absl::InvalidArgumentError(
         absl::StrFormat("client_id %ld is outside the valid range", client_id));
@@ -519,6 +680,7 @@ void SimpleAggregationProtocol::ScheduleOutlierDetection() {
 
 void SimpleAggregationProtocol::PerformOutlierDetection() {
   TFF_LOG(INFO) << "Performing outlier detection";
+  ScopedLatencyTimer timer(outlier_detection_latency_);
   absl::Duration grace_period;
   {
     absl::MutexLock lock(&outlier_detection_mu_);
@@ -533,47 +695,58 @@ void SimpleAggregationProtocol::PerformOutlierDetection() {
     grace_period = outlier_detection_parameters_->grace_period;
   }
 
+  // Take a snapshot of the latency stats, so that clients completing during
+  // the analysis aren't blocked on the latency mutex.
+  LatencyAggregator latency_aggregator;
+  {
+    absl::MutexLock lock(&latency_mu_);
+    latency_aggregator = latency_aggregator_;
+  }
+
   std::vector<int64_t> client_ids_to_close;
   // Perform this part of the algorithm under the lock to ensure exclusive
   // access to the all_clients_ and pending_clients_
   {
-    absl::MutexLock lock(&state_mu_);
+    StateLock lock(this);
     TFF_CHECK(CheckProtocolState(PROTOCOL_STARTED).ok())
         << "The protocol is not in PROTOCOL_STARTED state.";
 
     // Cannot perform analysis if there are no pending clients or too few
     // client latency samples.
-    if (pending_clients_.empty() || latency_aggregator_.GetCount() <= 1) return;
+    if (pending_clients_.empty() || latency_aggregator.GetCount() <= 1) return;
 
     absl::StatusOr<absl::Duration> latency_standard_deviation =
-        latency_aggregator_.GetStandardDeviation();
+        latency_aggregator.GetStandardDeviation();
     // GetStandardDeviation can fail only if there are too few samples.
     TFF_CHECK(latency_standard_deviation.ok())
         << "GetStandardDeviation() has unexpectedly failed: "
         << latency_standard_deviation.status();
 
     absl::Duration six_sigma_threshold =
-        latency_aggregator_.GetMean() + 6 * latency_standard_deviation.value();
+        latency_aggregator.GetMean() + 6 * latency_standard_deviation.value();
     // TODO: b/291007187 - Remove this logging once the outlier detection
     // algorithm has been validated.
     TFF_LOG(INFO) << "SimpleAggregationProtocol: num_latency_samples = "
-                  << latency_aggregator_.GetCount()
-                  << ", mean_latency = " << latency_aggregator_.GetMean()
+                  << latency_aggregator.GetCount()
+                  << ", mean_latency = " << latency_aggregator.GetMean()
                   << ", six_sigma_threshold = " << six_sigma_threshold
                   << ", num_pending_clients = " << pending_clients_.size();
 
     absl::Duration outlier_threshold = six_sigma_threshold + grace_period;
     absl::Time now = clock_->Now();
 
-    for (auto [client_id, start_time] : pending_clients_) {
-      if (now - start_time > outlier_threshold) {
-        // TODO: b/291007187 - Remove this logging once the outlier detection
-        // algorithm has been validated.
-        TFF_LOG(INFO) << "SimpleAggregationProtocol: client " << client_id
-                      << " is outlier: elapsed time = " << now - start_time
-                      << ", outlier_threshold = " << outlier_threshold;
-        client_ids_to_close.push_back(client_id);
+    // Only visit the clients which have been pending for longer than the
+    // threshold, which are the first ones in the order of start time.
+    for (auto [start_time, client_id] : pending_clients_by_start_time_) {
+      if (now - start_time <= outlier_threshold) {
+        break;
       }
+      // TODO: b/291007187 - Remove this logging once the outlier detection
+      // algorithm has been validated.
+      TFF_LOG(INFO) << "SimpleAggregationProtocol: client " << client_id
+                    << " is outlier: elapsed time = " << now - start_time
+                    << ", outlier_threshold = " << outlier_threshold;
+      client_ids_to_close.push_back(client_id);
     }
 
     ServerMessage close_message = MakeCloseClientMessage(absl::AbortedError(
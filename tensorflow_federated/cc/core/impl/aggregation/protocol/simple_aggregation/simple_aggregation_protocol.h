@@ -17,21 +17,27 @@
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_SIMPLE_AGGREGATION_SIMPLE_AGGREGATION_PROTOCOL_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_SIMPLE_AGGREGATION_SIMPLE_AGGREGATION_PROTOCOL_H_
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/btree_set.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/clock.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/intrinsic.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_aggregator.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol.h"
@@ -46,6 +52,33 @@
 
 namespace tensorflow_federated::aggregation {
 
+// Limits on the client inputs which SimpleAggregationProtocol ingests
+// concurrently. Each input goes through the retrieval, parsing and
+// accumulation stages on the thread which calls ReceiveClientMessage; the
+// per-stage limits bound how many callers run a stage at once, while the
+// others wait for a turn. Values less than one disable a limit.
+struct SimpleAggregationIngestionOptions {
+  // Maximum number of client inputs received but not yet aggregated. Inputs
+  // beyond this limit are rejected with UNAVAILABLE and leave the client
+  // pending, so that the host can retry sending them later.
+  int64_t max_inputs_in_flight = 0;
+  // Maximum number of inputs concurrently retrieved from the
+  // ResourceResolver.
+  int max_concurrent_retrievals = 0;
+  // Maximum number of inputs concurrently parsed into a CheckpointParser.
+  int max_concurrent_parses = 0;
+  // Maximum number of inputs concurrently accumulated into the aggregation
+  // state.
+  int max_concurrent_accumulations = 0;
+  // Number of NUMA nodes the aggregator shards are spread across, which must
+  // not exceed the number of shards. With more than one node, the input of
+  // each client is retrieved, parsed and accumulated into a shard of the node
+  // GetClientNumaNode returns, by the calling thread pinned to the CPUs of the
+  // node, so that the shards are only accessed across nodes when they are
+  // merged. See GetNumNumaNodes and CheckpointAggregator::Create.
+  int num_numa_nodes = 1;
+};
+
 // Implementation of the simple aggregation protocol.
 //
 // This version of the protocol receives updates in the clear from clients in a
@@ -89,19 +122,32 @@ class SimpleAggregationProtocol final : public AggregationProtocol {
   //    statistical analysis of client response times.  The purpose of the
   //    outlier detection is to close unresonsive clients.
   //    If not provided, the outlier detection is disabled.
+  // - `num_aggregator_shards`: number of independent replicas of the
+  //    aggregation state that client inputs are accumulated into, so that
+  //    inputs received concurrently can also be aggregated concurrently. See
+  //    CheckpointAggregator::Create.
+  // - `ingestion_options`: limits on the client inputs ingested concurrently,
+  //    see SimpleAggregationIngestionOptions.
   static absl::StatusOr<std::unique_ptr<SimpleAggregationProtocol>> Create(
       const Configuration& configuration,
       const CheckpointParserFactory* checkpoint_parser_factory,
       const CheckpointBuilderFactory* checkpoint_builder_factory,
       ResourceResolver* resource_resolver, Clock* clock = Clock::RealClock(),
       std::optional<OutlierDetectionParameters> outlier_detection_parameters =
-          std::nullopt);
+          std::nullopt,
+      int num_aggregator_shards = 1,
+      SimpleAggregationIngestionOptions ingestion_options =
+          SimpleAggregationIngestionOptions());
 
   // Implementation of the overridden Aggregation Protocol methods.
   absl::Status Start(int64_t num_clients) override;
   absl::StatusOr<int64_t> AddClients(int64_t num_clients) override;
   absl::Status ReceiveClientMessage(int64_t client_id,
                                     const ClientMessage& message) override;
+  // Moves inline input bytes of the message into the report passed to the
+  // checkpoint parser instead of copying them.
+  absl::Status ReceiveClientMessage(int64_t client_id,
+                                    ClientMessage&& message) override;
   absl::StatusOr<std::optional<ServerMessage>> PollServerMessage(
       int64_t client_id) override;
   absl::Status CloseClient(int64_t client_id,
@@ -112,6 +158,50 @@ class SimpleAggregationProtocol final : public AggregationProtocol {
   absl::StatusOr<absl::Cord> GetResult() override;
   absl::StatusOr<bool> IsClientClosed(int64_t client_id) override;
 
+  // Returns a report of the client inputs aggregated so far, while the
+  // protocol keeps receiving inputs. Inputs being aggregated concurrently may
+  // or may not be included. The protocol must have been started and not yet
+  // completed or aborted. See CheckpointAggregator::ReportSnapshot.
+  absl::StatusOr<absl::Cord> ReportSnapshot();
+
+  // Distributed aggregation: one logical aggregation can be spread over
+  // several protocol instances, typically on different servers. Each leaf
+  // instance receives the inputs of a subset of the clients, and periodically
+  // calls TakeStateDelta to ship the aggregation state accumulated since its
+  // previous call to a root instance, which merges it with MergeState. The
+  // root is completed once the leaves have shipped their final deltas, and
+  // its result is the same as if a single instance had received every input;
+  // the leaves are then aborted, or completed to release their remaining
+  // state. The instances must be created with the same configuration, and
+  // the thresholds of the configuration are only meaningful at the root.
+
+  // Returns the serialized aggregation state of the client inputs aggregated
+  // since the previous call, and resets the state so that the following
+  // inputs are aggregated from scratch. Inputs being aggregated concurrently
+  // are included in either this delta or the next one. The protocol must
+  // have been started and not yet completed or aborted. See
+  // CheckpointAggregator::SerializeDelta.
+  absl::StatusOr<absl::Cord> TakeStateDelta();
+
+  // Merges an aggregation state returned by TakeStateDelta of another
+  // instance into the aggregation state of this one. The protocol must have
+  // been started and not yet completed or aborted.
+  absl::Status MergeState(const absl::Cord& state);
+
+  // Returns per-stage timings and queue depths of the ingestion of client
+  // inputs, the bytes ingested and the estimated memory of the aggregation
+  // state. The metrics are read from atomic counters without taking any lock,
+  // so they can be polled frequently while inputs are being received.
+  IngestionMetrics GetIngestionMetrics() const;
+
+  // Returns the NUMA node on which the input of the client is aggregated.
+  // Hosts that receive client messages on threads of several NUMA nodes can
+  // pass each message to a thread of this node, which then doesn't need to
+  // be moved to another node while it ingests the input.
+  int GetClientNumaNode(int64_t client_id) const {
+    return client_id % checkpoint_aggregator_->num_numa_nodes();
+  }
+
   ~SimpleAggregationProtocol() override;
 
   // SimpleAggregationProtocol is neither copyable nor movable.
@@ -126,7 +216,75 @@ class SimpleAggregationProtocol final : public AggregationProtocol {
       const CheckpointParserFactory* checkpoint_parser_factory,
       const CheckpointBuilderFactory* checkpoint_builder_factory,
       ResourceResolver* resource_resolver, Clock* clock,
-      std::optional<OutlierDetectionParameters> outlier_detection_parameters);
+      std::optional<OutlierDetectionParameters> outlier_detection_parameters,
+      SimpleAggregationIngestionOptions ingestion_options);
+
+  // Bounds the number of threads concurrently running a stage of the
+  // ingestion of client inputs, and measures the stage.
+  class StageLimiter {
+   public:
+    // A `limit` less than one doesn't bound the number of threads.
+    explicit StageLimiter(int limit) : limit_(limit) {}
+
+    // Blocks until the calling thread may run the stage.
+    void Acquire() ABSL_LOCKS_EXCLUDED(mu_);
+    // Lets another thread run the stage.
+    void Release() ABSL_LOCKS_EXCLUDED(mu_);
+
+    // Records an input that waited `wait_time` for its turn and then ran the
+    // stage for `run_time`.
+    void Record(absl::Duration wait_time, absl::Duration run_time);
+    // Fills `metrics` without taking the lock.
+    void GetMetrics(StageMetrics& metrics) const;
+
+   private:
+    bool HasCapacity() const ABSL_SHARED_LOCKS_REQUIRED(mu_);
+
+    const int limit_;
+    absl::Mutex mu_;
+    // Changed only under `mu_`, but read without it by GetMetrics.
+    std::atomic<int> num_running_ = 0;
+    std::atomic<int64_t> num_waiting_ = 0;
+    std::atomic<int64_t> num_inputs_ = 0;
+    std::atomic<int64_t> total_wait_nanos_ = 0;
+    std::atomic<int64_t> total_run_nanos_ = 0;
+  };
+
+  // Runs `stage` while holding a turn of `limiter`.
+  template <typename Stage>
+  static auto RunStage(StageLimiter& limiter, Stage stage) {
+    absl::Time wait_start = absl::Now();
+    limiter.Acquire();
+    absl::Time run_start = absl::Now();
+    auto result = stage();
+    limiter.Release();
+    limiter.Record(run_start - wait_start, absl::Now() - run_start);
+    return result;
+  }
+
+  // Holds `state_mu_` for its lifetime, and records how long it was held in
+  // the "SimpleAggregationProtocol::StateLock" histogram of the default
+  // MetricsRegistry if metrics are enabled.
+  class ABSL_SCOPED_LOCKABLE StateLock {
+   public:
+    explicit StateLock(SimpleAggregationProtocol* protocol)
+        ABSL_EXCLUSIVE_LOCK_FUNCTION(protocol->state_mu_)
+        : lock_(&protocol->state_mu_),
+          timer_(protocol->state_lock_latency_) {}
+    ~StateLock() ABSL_UNLOCK_FUNCTION() = default;
+
+   private:
+    absl::MutexLock lock_;
+    // Destroyed before `lock_`, so that the lock is held until it records.
+    ScopedLatencyTimer timer_;
+  };
+
+  // Implements both ReceiveClientMessage overloads. `take_inline_bytes`
+  // provides the report of a message with an inline input; it is only called
+  // once the input has been admitted.
+  absl::Status ReceiveClientInput(
+      int64_t client_id, const ClientMessage& message,
+      absl::FunctionRef<absl::Cord()> take_inline_bytes);
 
   // Creates an aggregator based on the intrinsic configuration.
   static absl::StatusOr<std::unique_ptr<TensorAggregator>> CreateAggregator(
@@ -210,8 +368,9 @@ class SimpleAggregationProtocol final : public AggregationProtocol {
 
   // Protects the mutable state.
   absl::Mutex state_mu_;
-  // The overall state of the protocol.
-  ProtocolState protocol_state_ ABSL_GUARDED_BY(state_mu_);
+  // The overall state of the protocol. Changed only under `state_mu_`, but
+  // read without it by GetStatus.
+  std::atomic<ProtocolState> protocol_state_;
 
   // Holds state of all clients. The length of the vector equals
   // to the number of clients accepted into the protocol.
@@ -222,26 +381,51 @@ class SimpleAggregationProtocol final : public AggregationProtocol {
   // state for too long.
   absl::flat_hash_map<int64_t, absl::Time> pending_clients_
       ABSL_GUARDED_BY(state_mu_);
+  // The same pending clients ordered by the time they joined the protocol, so
+  // that outlier detection only visits the clients pending for too long.
+  absl::btree_set<std::pair<absl::Time, int64_t>> pending_clients_by_start_time_
+      ABSL_GUARDED_BY(state_mu_);
 
   // Calculates latency stats for clients that have successfully completed
   // the protocol. This provides data for calculating the threshold for
   // determining the outliers.
-  LatencyAggregator latency_aggregator_ ABSL_GUARDED_BY(state_mu_);
+  // It has its own mutex so that adding samples doesn't extend the critical
+  // sections of `state_mu_`.
+  absl::Mutex latency_mu_;
+  LatencyAggregator latency_aggregator_ ABSL_GUARDED_BY(latency_mu_);
 
   // Counters for various client states other than pending.
   // Note that the number of pending clients can be found by subtracting the
-  // sum of the below counters from `client_states_.size()`.
-  uint64_t num_clients_received_and_pending_ ABSL_GUARDED_BY(state_mu_) = 0;
-  uint64_t num_clients_aggregated_ ABSL_GUARDED_BY(state_mu_) = 0;
-  uint64_t num_clients_failed_ ABSL_GUARDED_BY(state_mu_) = 0;
-  uint64_t num_clients_aborted_ ABSL_GUARDED_BY(state_mu_) = 0;
-  uint64_t num_clients_discarded_ ABSL_GUARDED_BY(state_mu_) = 0;
+  // sum of the below counters from `num_clients_`.
+  //
+  // The counters are changed only under `state_mu_`, but read without it by
+  // GetStatus, so that polling the status doesn't contend with the clients.
+  // A client changing state is counted in neither state for a moment, which
+  // GetStatus reports as pending.
+  std::atomic<int64_t> num_clients_ = 0;
+  std::atomic<uint64_t> num_clients_received_and_pending_ = 0;
+  std::atomic<uint64_t> num_clients_aggregated_ = 0;
+  std::atomic<uint64_t> num_clients_failed_ = 0;
+  std::atomic<uint64_t> num_clients_aborted_ = 0;
+  std::atomic<uint64_t> num_clients_discarded_ = 0;
+  // Total size of the client inputs received, in bytes.
+  std::atomic<int64_t> bytes_ingested_ = 0;
 
   std::unique_ptr<CheckpointAggregator> checkpoint_aggregator_;
   const CheckpointParserFactory* const checkpoint_parser_factory_;
   const CheckpointBuilderFactory* const checkpoint_builder_factory_;
   ResourceResolver* const resource_resolver_;
   Clock* const clock_;
+  // Histograms of the default MetricsRegistry, which record the time the
+  // state lock is held, the time of each outlier detection, and the time of
+  // each GetStatus call.
+  LatencyHistogram* const state_lock_latency_;
+  LatencyHistogram* const outlier_detection_latency_;
+  LatencyHistogram* const get_status_latency_;
+  const int64_t max_inputs_in_flight_;
+  StageLimiter retrieval_limiter_;
+  StageLimiter parse_limiter_;
+  StageLimiter accumulation_limiter_;
   // The result of the aggregation.
   absl::Cord result_ ABSL_GUARDED_BY(state_mu_);
 
@@ -0,0 +1,279 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// End-to-end benchmarks of the ingestion of client inputs by the
+// SimpleAggregationProtocol: each iteration starts a protocol, has
+// `num_threads` concurrent senders deliver federated compute checkpoints for
+// all clients, and completes the protocol. Each checkpoint holds
+// `rows_per_client` rows of an int64 key drawn from `num_distinct_keys`
+// values and an int64 value, which are summed by key with either the plain
+// or the DP group by.
+//
+// Besides the throughput, the benchmarks report the p50 and p99 latency of
+// ReceiveClientMessage and the peak resident set size of the process.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/clock.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/dp_fedsql_constants.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol_messages.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/configuration.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/resource_resolver.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/simple_aggregation/simple_aggregation_protocol.h"
+
+namespace tensorflow_federated::aggregation {
+namespace {
+
+// Number of clients whose inputs each sender delivers per iteration.
+constexpr int64_t kClientsPerThread = 16;
+// Number of distinct checkpoints generated per benchmark, which the clients
+// take turns sending.
+constexpr int kNumCheckpoints = 8;
+
+// All inputs are sent inline, so no resource is ever retrieved.
+class InlineOnlyResourceResolver final : public ResourceResolver {
+ public:
+  absl::StatusOr<absl::Cord> RetrieveResource(
+      int64_t client_id, const std::string& uri) override {
+    return absl::UnimplementedError("Only inline inputs are supported");
+  }
+};
+
+template <typename T>
+TensorProto CreateScalarParameter(T value) {
+  return Tensor::Create(internal::TypeTraits<T>::kDataType, {},
+                        std::make_unique<MutableVectorData<T>>(1, value))
+      .value()
+      .ToProto();
+}
+
+void SetTensorSpec(TensorSpecProto* spec, const std::string& name,
+                   DataType dtype) {
+  spec->set_name(name);
+  spec->set_dtype(dtype);
+  spec->mutable_shape()->add_dim_sizes(-1);
+}
+
+// Returns the configuration summing "value" grouped by "key", optionally with
+// differential privacy.
+Configuration CreateGroupBySumConfiguration(bool dp) {
+  Configuration config;
+  Configuration::IntrinsicConfig* group_by = config.add_intrinsic_configs();
+  group_by->set_intrinsic_uri(dp ? kDPGroupByUri : "fedsql_group_by");
+  SetTensorSpec(group_by->add_intrinsic_args()->mutable_input_tensor(), "key",
+                DT_INT64);
+  SetTensorSpec(group_by->add_output_tensors(), "key_out", DT_INT64);
+  Configuration::IntrinsicConfig* sum = group_by->add_inner_intrinsics();
+  sum->set_intrinsic_uri(dp ? kDPSumUri : "GoogleSQL:sum");
+  SetTensorSpec(sum->add_intrinsic_args()->mutable_input_tensor(), "value",
+                DT_INT64);
+  SetTensorSpec(sum->add_output_tensors(), "value_out", DT_INT64);
+  if (dp) {
+    // Epsilon, delta and the L0 bound of the group by, then the Linfinity,
+    // L1 and L2 bounds of the sum. Negative L1 and L2 bounds are unset.
+    *group_by->add_intrinsic_args()->mutable_parameter() =
+        CreateScalarParameter<double>(1.0);
+    *group_by->add_intrinsic_args()->mutable_parameter() =
+        CreateScalarParameter<double>(1e-6);
+    *group_by->add_intrinsic_args()->mutable_parameter() =
+        CreateScalarParameter<int64_t>(100);
+    *sum->add_intrinsic_args()->mutable_parameter() =
+        CreateScalarParameter<int64_t>(1000);
+    *sum->add_intrinsic_args()->mutable_parameter() =
+        CreateScalarParameter<double>(-1);
+    *sum->add_intrinsic_args()->mutable_parameter() =
+        CreateScalarParameter<double>(-1);
+  }
+  return config;
+}
+
+// Creates a checkpoint of `num_rows` keys and values. Different seeds produce
+// different keys.
+absl::Cord CreateCheckpoint(int64_t num_rows, int64_t num_distinct_keys,
+                            int64_t seed) {
+  auto keys = std::make_unique<MutableVectorData<int64_t>>(num_rows);
+  auto values = std::make_unique<MutableVectorData<int64_t>>(num_rows);
+  for (int64_t i = 0; i < num_rows; ++i) {
+    (*keys)[i] = (seed * 104729 + i * 7919) % num_distinct_keys;
+    (*values)[i] = i % 123;
+  }
+  std::unique_ptr<CheckpointBuilder> builder =
+      FederatedComputeCheckpointBuilderFactory().Create();
+  TFF_CHECK(builder
+                ->Add("key", Tensor::Create(DT_INT64, {num_rows},
+                                            std::move(keys))
+                                 .value())
+                .ok());
+  TFF_CHECK(builder
+                ->Add("value", Tensor::Create(DT_INT64, {num_rows},
+                                              std::move(values))
+                                   .value())
+                .ok());
+  return builder->Build().value();
+}
+
+// Returns the peak resident set size of the process in bytes.
+int64_t GetPeakRssBytes() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  // ru_maxrss is in kilobytes on Linux.
+  return static_cast<int64_t>(usage.ru_maxrss) * 1024;
+}
+
+// Returns the given percentile of the sorted `latencies`.
+absl::Duration Percentile(const std::vector<absl::Duration>& latencies,
+                          double percentile) {
+  if (latencies.empty()) return absl::ZeroDuration();
+  size_t index = static_cast<size_t>(percentile * (latencies.size() - 1));
+  return latencies[index];
+}
+
+// Arguments: rows_per_client, num_distinct_keys, num_threads.
+void RunSimpleAggregationProtocol(benchmark::State& state, bool dp) {
+  const int64_t rows_per_client = state.range(0);
+  const int64_t num_distinct_keys = state.range(1);
+  const int num_threads = static_cast<int>(state.range(2));
+  const int64_t num_clients = num_threads * kClientsPerThread;
+
+  const Configuration config = CreateGroupBySumConfiguration(dp);
+  std::vector<std::string> checkpoints;
+  for (int i = 0; i < kNumCheckpoints; ++i) {
+    checkpoints.push_back(std::string(
+        CreateCheckpoint(rows_per_client, num_distinct_keys, i)));
+  }
+  FederatedComputeCheckpointParserFactory parser_factory;
+  FederatedComputeCheckpointBuilderFactory builder_factory;
+  InlineOnlyResourceResolver resource_resolver;
+
+  std::vector<absl::Duration> latencies;
+  int64_t bytes_processed = 0;
+  for (auto s : state) {
+    state.PauseTiming();
+    std::unique_ptr<SimpleAggregationProtocol> protocol =
+        SimpleAggregationProtocol::Create(
+            config, &parser_factory, &builder_factory, &resource_resolver,
+            Clock::RealClock(), /*outlier_detection_parameters=*/std::nullopt,
+            /*num_aggregator_shards=*/num_threads)
+            .value();
+    TFF_CHECK(protocol->Start(num_clients).ok());
+    // The messages are created up front so that their copies aren't timed.
+    std::vector<ClientMessage> messages(num_clients);
+    for (int64_t client_id = 0; client_id < num_clients; ++client_id) {
+      ClientResource* input =
+          messages[client_id].mutable_simple_aggregation()->mutable_input();
+      input->set_inline_bytes(checkpoints[client_id % kNumCheckpoints]);
+    }
+    std::vector<std::vector<absl::Duration>> thread_latencies(num_threads);
+    state.ResumeTiming();
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t] {
+        for (int64_t client_id = t; client_id < num_clients;
+             client_id += num_threads) {
+          absl::Time start = absl::Now();
+          TFF_CHECK(protocol
+                        ->ReceiveClientMessage(client_id,
+                                               std::move(messages[client_id]))
+                        .ok());
+          thread_latencies[t].push_back(absl::Now() - start);
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    TFF_CHECK(protocol->Complete().ok());
+    benchmark::DoNotOptimize(protocol->GetResult().value());
+
+    state.PauseTiming();
+    for (const auto& thread_latency : thread_latencies) {
+      latencies.insert(latencies.end(), thread_latency.begin(),
+                       thread_latency.end());
+    }
+    for (int64_t client_id = 0; client_id < num_clients; ++client_id) {
+      bytes_processed += checkpoints[client_id % kNumCheckpoints].size();
+    }
+    protocol.reset();
+    state.ResumeTiming();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  state.SetItemsProcessed(state.iterations() * num_clients * rows_per_client);
+  state.SetBytesProcessed(bytes_processed);
+  state.counters["clients_per_second"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * num_clients),
+      benchmark::Counter::kIsRate);
+  state.counters["p50_latency_us"] =
+      absl::ToDoubleMicroseconds(Percentile(latencies, 0.5));
+  state.counters["p99_latency_us"] =
+      absl::ToDoubleMicroseconds(Percentile(latencies, 0.99));
+  state.counters["peak_rss_bytes"] = benchmark::Counter(
+      static_cast<double>(GetPeakRssBytes()), benchmark::Counter::kDefaults,
+      benchmark::Counter::kIs1024);
+}
+
+void BM_SimpleAggregationProtocolGroupBySum(benchmark::State& state) {
+  RunSimpleAggregationProtocol(state, /*dp=*/false);
+}
+
+void BM_SimpleAggregationProtocolDPGroupBySum(benchmark::State& state) {
+  RunSimpleAggregationProtocol(state, /*dp=*/true);
+}
+
+// Small and large checkpoints, few and many keys, and 1 to 8 senders.
+void ProtocolArguments(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"rows_per_client", "num_distinct_keys", "num_threads"});
+  for (int64_t rows_per_client : {100, 10000}) {
+    for (int64_t num_distinct_keys : {100, 100000}) {
+      for (int64_t num_threads : {1, 8}) {
+        benchmark->Args({rows_per_client, num_distinct_keys, num_threads});
+      }
+    }
+  }
+  benchmark->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK(BM_SimpleAggregationProtocolGroupBySum)->Apply(ProtocolArguments);
+BENCHMARK(BM_SimpleAggregationProtocolDPGroupBySum)->Apply(ProtocolArguments);
+
+}  // namespace
+}  // namespace tensorflow_federated::aggregation
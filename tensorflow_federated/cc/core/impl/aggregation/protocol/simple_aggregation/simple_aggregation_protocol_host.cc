@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/simple_aggregation/simple_aggregation_protocol_host.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/clock.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol_messages.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/configuration.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/resource_resolver.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/simple_aggregation/simple_aggregation_protocol.h"
+
+namespace tensorflow_federated::aggregation {
+
+namespace {
+
+absl::Status ProtocolNotFoundError(int64_t protocol_id) {
+  return absl::NotFoundError(
+      absl::StrFormat("There is no protocol with id %d.", protocol_id));
+}
+
+}  // namespace
+
+SimpleAggregationProtocolHost::SimpleAggregationProtocolHost(
+    size_t num_threads,
+    const CheckpointParserFactory* checkpoint_parser_factory,
+    const CheckpointBuilderFactory* checkpoint_builder_factory,
+    ResourceResolver* resource_resolver, Clock* clock)
+    : checkpoint_parser_factory_(checkpoint_parser_factory),
+      checkpoint_builder_factory_(checkpoint_builder_factory),
+      resource_resolver_(resource_resolver),
+      clock_(clock),
+      scheduler_(CreateThreadPoolScheduler(num_threads,
+                                           "SimpleAggregationProtocolHost")) {}
+
+SimpleAggregationProtocolHost::~SimpleAggregationProtocolHost() {
+  std::deque<PendingMessage> cancelled;
+  {
+    absl::MutexLock lock(&mu_);
+    for (auto& [protocol_id, hosted] : protocols_) {
+      for (PendingMessage& pending : hosted.queue) {
+        cancelled.push_back(std::move(pending));
+      }
+    }
+    protocols_.clear();
+    ready_protocols_.clear();
+  }
+  for (PendingMessage& pending : cancelled) {
+    pending.done(absl::CancelledError("The protocol host is shutting down."));
+  }
+  // The scheduled HandleNextMessage calls now find no queued messages.
+  scheduler_->WaitUntilIdle();
+}
+
+absl::StatusOr<int64_t> SimpleAggregationProtocolHost::CreateProtocol(
+    const Configuration& configuration,
+    std::optional<SimpleAggregationProtocol::OutlierDetectionParameters>
+        outlier_detection_parameters,
+    SimpleAggregationIngestionOptions ingestion_options) {
+  TFF_ASSIGN_OR_RETURN(
+      std::unique_ptr<SimpleAggregationProtocol> protocol,
+      SimpleAggregationProtocol::Create(
+          configuration, checkpoint_parser_factory_,
+          checkpoint_builder_factory_, resource_resolver_, clock_,
+          std::move(outlier_detection_parameters),
+          /*num_aggregator_shards=*/1, ingestion_options));
+  absl::MutexLock lock(&mu_);
+  int64_t protocol_id = next_protocol_id_++;
+  protocols_[protocol_id].protocol = std::move(protocol);
+  return protocol_id;
+}
+
+absl::StatusOr<std::shared_ptr<SimpleAggregationProtocol>>
+SimpleAggregationProtocolHost::GetProtocol(int64_t protocol_id) {
+  absl::MutexLock lock(&mu_);
+  auto it = protocols_.find(protocol_id);
+  if (it == protocols_.end()) {
+    return ProtocolNotFoundError(protocol_id);
+  }
+  return it->second.protocol;
+}
+
+void SimpleAggregationProtocolHost::ReceiveClientMessage(
+    int64_t protocol_id, int64_t client_id, ClientMessage message,
+    std::function<void(absl::Status)> done) {
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = protocols_.find(protocol_id);
+    if (it != protocols_.end()) {
+      HostedProtocol& hosted = it->second;
+      hosted.queue.push_back({client_id, std::move(message), std::move(done)});
+      if (!hosted.ready) {
+        hosted.ready = true;
+        ready_protocols_.push_back(protocol_id);
+      }
+      scheduler_->Schedule([this]() { HandleNextMessage(); });
+      return;
+    }
+  }
+  done(ProtocolNotFoundError(protocol_id));
+}
+
+void SimpleAggregationProtocolHost::HandleNextMessage() {
+  std::shared_ptr<SimpleAggregationProtocol> protocol;
+  std::optional<PendingMessage> pending;
+  {
+    absl::MutexLock lock(&mu_);
+    if (ready_protocols_.empty()) {
+      // The message has been cancelled.
+      return;
+    }
+    int64_t protocol_id = ready_protocols_.front();
+    ready_protocols_.pop_front();
+    HostedProtocol& hosted = protocols_.at(protocol_id);
+    pending.emplace(std::move(hosted.queue.front()));
+    hosted.queue.pop_front();
+    // Move the protocol to the back of the line, so that the other protocols
+    // with queued messages go first.
+    if (hosted.queue.empty()) {
+      hosted.ready = false;
+    } else {
+      ready_protocols_.push_back(protocol_id);
+    }
+    protocol = hosted.protocol;
+  }
+  absl::Status status = protocol->ReceiveClientMessage(
+      pending->client_id, std::move(pending->message));
+  pending->done(std::move(status));
+}
+
+absl::Status SimpleAggregationProtocolHost::RemoveProtocol(
+    int64_t protocol_id) {
+  std::deque<PendingMessage> cancelled;
+  {
+    absl::MutexLock lock(&mu_);
+    auto it = protocols_.find(protocol_id);
+    if (it == protocols_.end()) {
+      return ProtocolNotFoundError(protocol_id);
+    }
+    cancelled = std::move(it->second.queue);
+    if (it->second.ready) {
+      ready_protocols_.erase(std::find(ready_protocols_.begin(),
+                                       ready_protocols_.end(), protocol_id));
+    }
+    protocols_.erase(it);
+  }
+  for (PendingMessage& pending : cancelled) {
+    pending.done(absl::CancelledError("The protocol has been removed."));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace tensorflow_federated::aggregation
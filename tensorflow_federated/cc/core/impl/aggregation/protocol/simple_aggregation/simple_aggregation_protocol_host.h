@@ -0,0 +1,133 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_SIMPLE_AGGREGATION_SIMPLE_AGGREGATION_PROTOCOL_HOST_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_SIMPLE_AGGREGATION_SIMPLE_AGGREGATION_PROTOCOL_HOST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/clock.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol_messages.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/configuration.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/resource_resolver.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/simple_aggregation/simple_aggregation_protocol.h"
+
+namespace tensorflow_federated::aggregation {
+
+// Hosts many concurrent SimpleAggregationProtocol instances in one process.
+//
+// The protocols share the parser and builder factories, the resource resolver
+// and the clock of the host, and the client messages of all protocols are
+// aggregated on one pool of threads. Each protocol has its own queue of
+// client messages, and the threads take the messages from the queues of the
+// protocols in round robin order, so that the backlog of a large protocol
+// doesn't delay the messages of small ones.
+class SimpleAggregationProtocolHost final {
+ public:
+  // Does not take ownership of the factories, the resolver or the clock,
+  // which must outlive the host. At most `num_threads` client messages are
+  // aggregated concurrently across all protocols.
+  SimpleAggregationProtocolHost(
+      size_t num_threads,
+      const CheckpointParserFactory* checkpoint_parser_factory,
+      const CheckpointBuilderFactory* checkpoint_builder_factory,
+      ResourceResolver* resource_resolver, Clock* clock = Clock::RealClock());
+
+  // Cancels the queued client messages and waits for the ones being
+  // aggregated.
+  ~SimpleAggregationProtocolHost();
+
+  // SimpleAggregationProtocolHost is neither copyable nor movable.
+  SimpleAggregationProtocolHost(const SimpleAggregationProtocolHost&) = delete;
+  SimpleAggregationProtocolHost& operator=(
+      const SimpleAggregationProtocolHost&) = delete;
+
+  // Creates a protocol hosted by this host and returns its id. See
+  // SimpleAggregationProtocol::Create for the arguments.
+  absl::StatusOr<int64_t> CreateProtocol(
+      const Configuration& configuration,
+      std::optional<SimpleAggregationProtocol::OutlierDetectionParameters>
+          outlier_detection_parameters = std::nullopt,
+      SimpleAggregationIngestionOptions ingestion_options =
+          SimpleAggregationIngestionOptions());
+
+  // Returns the protocol with the given id, on which the other protocol
+  // methods, e.g. Start and Complete, are called directly. Returns NOT_FOUND
+  // if there is no such protocol.
+  absl::StatusOr<std::shared_ptr<SimpleAggregationProtocol>> GetProtocol(
+      int64_t protocol_id);
+
+  // Queues a client message of the protocol with the given id. `done` is
+  // called with the status returned by ReceiveClientMessage once the message
+  // has been handled, with CANCELLED if the protocol is removed first, or
+  // with NOT_FOUND if there is no such protocol.
+  void ReceiveClientMessage(int64_t protocol_id, int64_t client_id,
+                            ClientMessage message,
+                            std::function<void(absl::Status)> done);
+
+  // Stops hosting the protocol with the given id. Its queued client messages
+  // are cancelled; messages being aggregated finish first.
+  absl::Status RemoveProtocol(int64_t protocol_id);
+
+ private:
+  struct PendingMessage {
+    int64_t client_id;
+    ClientMessage message;
+    std::function<void(absl::Status)> done;
+  };
+
+  struct HostedProtocol {
+    std::shared_ptr<SimpleAggregationProtocol> protocol;
+    std::deque<PendingMessage> queue;
+    // Whether the protocol is in `ready_protocols_`.
+    bool ready = false;
+  };
+
+  // Handles the next queued client message of the protocol at the front of
+  // `ready_protocols_`. Runs on the scheduler once per queued message.
+  void HandleNextMessage() ABSL_LOCKS_EXCLUDED(mu_);
+
+  const CheckpointParserFactory* const checkpoint_parser_factory_;
+  const CheckpointBuilderFactory* const checkpoint_builder_factory_;
+  ResourceResolver* const resource_resolver_;
+  Clock* const clock_;
+
+  absl::Mutex mu_;
+  int64_t next_protocol_id_ ABSL_GUARDED_BY(mu_) = 0;
+  absl::flat_hash_map<int64_t, HostedProtocol> protocols_ ABSL_GUARDED_BY(mu_);
+  // The ids of the protocols with queued messages, in the order in which
+  // their next message is handled.
+  std::deque<int64_t> ready_protocols_ ABSL_GUARDED_BY(mu_);
+
+  std::unique_ptr<Scheduler> scheduler_;
+};
+
+}  // namespace tensorflow_federated::aggregation
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_SIMPLE_AGGREGATION_SIMPLE_AGGREGATION_PROTOCOL_HOST_H_
@@ -0,0 +1,230 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/simple_aggregation/simple_aggregation_protocol_host.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// clang-format off
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/parse_text_proto.h"
+// clang-format on
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/cord.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol_messages.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/configuration.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/simple_aggregation/simple_aggregation_protocol.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/mocks.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/test_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated::aggregation {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+using ::testing::Invoke;
+using ::testing::StrEq;
+
+Configuration SumConfiguration() {
+  return PARSE_TEXT_PROTO(R"pb(
+    intrinsic_configs {
+      intrinsic_uri: "federated_sum"
+      intrinsic_args {
+        input_tensor {
+          name: "foo"
+          dtype: DT_INT32
+          shape {}
+        }
+      }
+      output_tensors {
+        name: "foo_out"
+        dtype: DT_INT32
+        shape {}
+      }
+    }
+  )pb");
+}
+
+ClientMessage MakeClientMessage(std::string inline_bytes) {
+  ClientMessage message;
+  message.mutable_simple_aggregation()->mutable_input()->set_inline_bytes(
+      std::move(inline_bytes));
+  return message;
+}
+
+class SimpleAggregationProtocolHostTest : public ::testing::Test {
+ protected:
+  // Expects the parsers to be created for inputs holding a scalar 1.
+  void ExpectParsers(std::function<void(const absl::Cord&)> on_create) {
+    EXPECT_CALL(checkpoint_parser_factory_, Create(_))
+        .WillRepeatedly(Invoke([on_create](const absl::Cord& report) {
+          on_create(report);
+          auto parser = std::make_unique<MockCheckpointParser>();
+          EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+            return Tensor::Create(DT_INT32, {}, CreateTestData({1}));
+          }));
+          return parser;
+        }));
+  }
+
+  MockCheckpointParserFactory checkpoint_parser_factory_;
+  MockCheckpointBuilderFactory checkpoint_builder_factory_;
+  MockResourceResolver resource_resolver_;
+};
+
+TEST_F(SimpleAggregationProtocolHostTest, ReceiveClientMessage_Success) {
+  ExpectParsers([](const absl::Cord&) {});
+  SimpleAggregationProtocolHost host(/*num_threads=*/2,
+                                     &checkpoint_parser_factory_,
+                                     &checkpoint_builder_factory_,
+                                     &resource_resolver_);
+  int64_t protocol_id = TFF_ASSERT_OK(host.CreateProtocol(SumConfiguration()));
+  std::shared_ptr<SimpleAggregationProtocol> protocol =
+      TFF_ASSERT_OK(host.GetProtocol(protocol_id));
+  EXPECT_THAT(protocol->Start(2), IsOk());
+
+  absl::BlockingCounter done(2);
+  for (int64_t client_id = 0; client_id < 2; ++client_id) {
+    host.ReceiveClientMessage(protocol_id, client_id, MakeClientMessage(""),
+                              [&done](absl::Status status) {
+                                EXPECT_THAT(status, IsOk());
+                                done.DecrementCount();
+                              });
+  }
+  done.Wait();
+  EXPECT_EQ(protocol->GetStatus().num_inputs_aggregated_and_included(), 2);
+}
+
+TEST_F(SimpleAggregationProtocolHostTest, ReceiveClientMessage_NoProtocol) {
+  SimpleAggregationProtocolHost host(/*num_threads=*/1,
+                                     &checkpoint_parser_factory_,
+                                     &checkpoint_builder_factory_,
+                                     &resource_resolver_);
+  absl::Status status;
+  host.ReceiveClientMessage(/*protocol_id=*/7, /*client_id=*/0,
+                            MakeClientMessage(""),
+                            [&status](absl::Status s) { status = s; });
+  EXPECT_THAT(status, StatusIs(NOT_FOUND));
+  EXPECT_THAT(host.GetProtocol(7), StatusIs(NOT_FOUND));
+}
+
+TEST_F(SimpleAggregationProtocolHostTest, MessagesOfProtocolsAreInterleaved) {
+  // The first message blocks the only thread until the other messages have
+  // been queued, and the order in which the inputs are parsed is recorded.
+  absl::Mutex mu;
+  std::vector<std::string> parsed;
+  absl::Notification first_parse_started;
+  absl::Notification resume_first_parse;
+  ExpectParsers([&](const absl::Cord& report) {
+    {
+      absl::MutexLock lock(&mu);
+      parsed.push_back(std::string(report));
+    }
+    if (!first_parse_started.HasBeenNotified()) {
+      first_parse_started.Notify();
+      resume_first_parse.WaitForNotification();
+    }
+  });
+  SimpleAggregationProtocolHost host(/*num_threads=*/1,
+                                     &checkpoint_parser_factory_,
+                                     &checkpoint_builder_factory_,
+                                     &resource_resolver_);
+  int64_t large_id = TFF_ASSERT_OK(host.CreateProtocol(SumConfiguration()));
+  int64_t small_id = TFF_ASSERT_OK(host.CreateProtocol(SumConfiguration()));
+  std::shared_ptr<SimpleAggregationProtocol> large_protocol =
+      TFF_ASSERT_OK(host.GetProtocol(large_id));
+  std::shared_ptr<SimpleAggregationProtocol> small_protocol =
+      TFF_ASSERT_OK(host.GetProtocol(small_id));
+  EXPECT_THAT(large_protocol->Start(3), IsOk());
+  EXPECT_THAT(small_protocol->Start(1), IsOk());
+
+  absl::BlockingCounter done(4);
+  auto on_done = [&done](absl::Status status) {
+    EXPECT_THAT(status, IsOk());
+    done.DecrementCount();
+  };
+  host.ReceiveClientMessage(large_id, 0, MakeClientMessage("large_0"),
+                            on_done);
+  first_parse_started.WaitForNotification();
+  host.ReceiveClientMessage(large_id, 1, MakeClientMessage("large_1"),
+                            on_done);
+  host.ReceiveClientMessage(large_id, 2, MakeClientMessage("large_2"),
+                            on_done);
+  host.ReceiveClientMessage(small_id, 0, MakeClientMessage("small_0"),
+                            on_done);
+  resume_first_parse.Notify();
+  done.Wait();
+
+  // The message of the small protocol doesn't wait for the whole backlog of
+  // the large one.
+  absl::MutexLock lock(&mu);
+  EXPECT_THAT(parsed, ElementsAre("large_0", "large_1", "small_0", "large_2"));
+}
+
+TEST_F(SimpleAggregationProtocolHostTest, RemoveProtocolCancelsQueuedMessages) {
+  absl::Notification parse_started;
+  absl::Notification resume_parse;
+  ExpectParsers([&](const absl::Cord&) {
+    parse_started.Notify();
+    resume_parse.WaitForNotification();
+  });
+  SimpleAggregationProtocolHost host(/*num_threads=*/1,
+                                     &checkpoint_parser_factory_,
+                                     &checkpoint_builder_factory_,
+                                     &resource_resolver_);
+  int64_t protocol_id = TFF_ASSERT_OK(host.CreateProtocol(SumConfiguration()));
+  std::shared_ptr<SimpleAggregationProtocol> protocol =
+      TFF_ASSERT_OK(host.GetProtocol(protocol_id));
+  EXPECT_THAT(protocol->Start(2), IsOk());
+
+  absl::BlockingCounter done(2);
+  absl::Status first_status;
+  absl::Status second_status;
+  host.ReceiveClientMessage(protocol_id, 0, MakeClientMessage(""),
+                            [&](absl::Status status) {
+                              first_status = status;
+                              done.DecrementCount();
+                            });
+  parse_started.WaitForNotification();
+  host.ReceiveClientMessage(protocol_id, 1, MakeClientMessage(""),
+                            [&](absl::Status status) {
+                              second_status = status;
+                              done.DecrementCount();
+                            });
+  EXPECT_THAT(host.RemoveProtocol(protocol_id), IsOk());
+  resume_parse.Notify();
+  done.Wait();
+
+  EXPECT_THAT(first_status, IsOk());
+  EXPECT_THAT(second_status, StatusIs(CANCELLED));
+  EXPECT_THAT(host.RemoveProtocol(protocol_id), StatusIs(NOT_FOUND));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated::aggregation
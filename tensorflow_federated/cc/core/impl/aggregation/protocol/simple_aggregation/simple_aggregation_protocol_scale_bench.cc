@@ -0,0 +1,299 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Simulates rounds of the SimpleAggregationProtocol with hundreds of
+// thousands to millions of clients on a SimulatedClock, to measure the cost
+// of the protocol bookkeeping at these client counts without any network
+// traffic or real waiting.
+//
+// Clients join the round in a Poisson process over kArrivalPeriod and send
+// their input after a log-normally distributed latency, except for a fraction
+// of stragglers which never respond and are closed by the outlier detection.
+// Each simulated second, the clients which have joined are added, the inputs
+// which have arrived are received, the status is polled like a host would,
+// and the clock is advanced, which runs the outlier detection when it is due.
+// All inputs are the same scalar, so that parsing and accumulating them costs
+// little next to the bookkeeping.
+//
+// Besides the wall time of a round, the benchmarks report the time the state
+// lock is held, and the time spent in PerformOutlierDetection and GetStatus,
+// as recorded in the histograms of the default MetricsRegistry.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/time/time.h"
+#include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/simulated_clock.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/aggregation_protocol_messages.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/configuration.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_builder.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/federated_compute_checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/resource_resolver.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/simple_aggregation/simple_aggregation_protocol.h"
+
+namespace tensorflow_federated::aggregation {
+namespace {
+
+// The simulated time between two steps of the simulation.
+constexpr absl::Duration kTick = absl::Seconds(1);
+// The period over which the clients join the round.
+constexpr absl::Duration kArrivalPeriod = absl::Minutes(10);
+// The median latency of the clients and the standard deviation of its log.
+constexpr absl::Duration kMedianClientLatency = absl::Minutes(1);
+constexpr double kClientLatencyLogStddev = 0.25;
+// The fraction of clients which never send their input.
+constexpr double kStragglerFraction = 1e-3;
+// Rounds which haven't closed all their clients by then are cut short.
+constexpr absl::Duration kMaxRoundDuration = absl::Hours(1);
+
+constexpr SimpleAggregationProtocol::OutlierDetectionParameters
+    kOutlierDetectionParameters = {absl::Seconds(10), absl::Seconds(30)};
+
+// All inputs are sent inline, so no resource is ever retrieved.
+class InlineOnlyResourceResolver final : public ResourceResolver {
+ public:
+  absl::StatusOr<absl::Cord> RetrieveResource(
+      int64_t client_id, const std::string& uri) override {
+    return absl::UnimplementedError("Only inline inputs are supported");
+  }
+};
+
+// Returns the configuration summing the scalar int32 "value".
+Configuration CreateSumConfiguration() {
+  Configuration config;
+  Configuration::IntrinsicConfig* sum = config.add_intrinsic_configs();
+  sum->set_intrinsic_uri("federated_sum");
+  TensorSpecProto* input = sum->add_intrinsic_args()->mutable_input_tensor();
+  input->set_name("value");
+  input->set_dtype(DT_INT32);
+  input->mutable_shape();
+  TensorSpecProto* output = sum->add_output_tensors();
+  output->set_name("value_out");
+  output->set_dtype(DT_INT32);
+  output->mutable_shape();
+  return config;
+}
+
+ClientMessage CreateClientMessage() {
+  std::unique_ptr<CheckpointBuilder> builder =
+      FederatedComputeCheckpointBuilderFactory().Create();
+  TFF_CHECK(builder
+                ->Add("value",
+                      Tensor::Create(
+                          DT_INT32, {},
+                          std::make_unique<MutableVectorData<int32_t>>(1, 1))
+                          .value())
+                .ok());
+  ClientMessage message;
+  message.mutable_simple_aggregation()->mutable_input()->set_inline_bytes(
+      std::string(builder->Build().value()));
+  return message;
+}
+
+// The times since the start of the round at which the clients join it, in
+// the order of their client IDs, and at which they send their input, ordered
+// by time.
+struct ClientSchedule {
+  std::vector<absl::Duration> arrivals;
+  std::vector<std::pair<absl::Duration, int64_t>> responses;
+};
+
+ClientSchedule CreateClientSchedule(int64_t num_clients) {
+  std::mt19937_64 rng(num_clients);
+  std::exponential_distribution<double> interarrival_seconds(
+      num_clients / absl::ToDoubleSeconds(kArrivalPeriod));
+  std::lognormal_distribution<double> latency_seconds(
+      std::log(absl::ToDoubleSeconds(kMedianClientLatency)),
+      kClientLatencyLogStddev);
+  std::bernoulli_distribution straggler(kStragglerFraction);
+  ClientSchedule schedule;
+  schedule.arrivals.reserve(num_clients);
+  schedule.responses.reserve(num_clients);
+  absl::Duration arrival = absl::ZeroDuration();
+  for (int64_t client_id = 0; client_id < num_clients; ++client_id) {
+    arrival += absl::Seconds(interarrival_seconds(rng));
+    schedule.arrivals.push_back(arrival);
+    if (!straggler(rng)) {
+      schedule.responses.emplace_back(
+          arrival + absl::Seconds(latency_seconds(rng)), client_id);
+    }
+  }
+  std::sort(schedule.responses.begin(), schedule.responses.end());
+  return schedule;
+}
+
+// The latencies recorded in a histogram so far, to report those recorded
+// between two snapshots.
+struct HistogramSnapshot {
+  explicit HistogramSnapshot(const LatencyHistogram& histogram)
+      : buckets(histogram.bucket_counts()),
+        count(histogram.count()),
+        sum(histogram.sum()) {}
+
+  std::array<int64_t, LatencyHistogram::kNumBuckets> buckets;
+  int64_t count;
+  absl::Duration sum;
+};
+
+// Returns the upper bound of the bucket holding the `q`th quantile of the
+// latencies recorded between `start` and `end`.
+absl::Duration Quantile(const HistogramSnapshot& start,
+                        const HistogramSnapshot& end, double q) {
+  const int64_t count = end.count - start.count;
+  int64_t cumulative = 0;
+  for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+    cumulative += end.buckets[i] - start.buckets[i];
+    if (cumulative > 0 && cumulative >= q * count) {
+      return LatencyHistogram::BucketUpperBound(i);
+    }
+  }
+  return absl::ZeroDuration();
+}
+
+// Returns the mean of the latencies recorded between `start` and `end`.
+absl::Duration Mean(const HistogramSnapshot& start,
+                    const HistogramSnapshot& end) {
+  const int64_t count = end.count - start.count;
+  return count > 0 ? (end.sum - start.sum) / count : absl::ZeroDuration();
+}
+
+// Runs a simulated round, and returns the number of clients which were closed
+// as outliers.
+int64_t RunRound(const ClientSchedule& schedule, const ClientMessage& message,
+                 const Configuration& config) {
+  FederatedComputeCheckpointParserFactory parser_factory;
+  FederatedComputeCheckpointBuilderFactory builder_factory;
+  InlineOnlyResourceResolver resource_resolver;
+  // Outlives the protocol, which cancels its outlier detection callback on
+  // destruction.
+  SimulatedClock clock;
+  std::unique_ptr<SimpleAggregationProtocol> protocol =
+      SimpleAggregationProtocol::Create(config, &parser_factory,
+                                        &builder_factory, &resource_resolver,
+                                        &clock, kOutlierDetectionParameters)
+          .value();
+  TFF_CHECK(protocol->Start(0).ok());
+
+  const absl::Time start = clock.Now();
+  const size_t num_clients = schedule.arrivals.size();
+  size_t num_arrived = 0;
+  size_t num_responded = 0;
+  StatusMessage status;
+  while (clock.Now() - start < kMaxRoundDuration) {
+    clock.AdvanceTime(kTick);
+    const absl::Duration elapsed = clock.Now() - start;
+    size_t num_arriving = 0;
+    while (num_arrived + num_arriving < num_clients &&
+           schedule.arrivals[num_arrived + num_arriving] <= elapsed) {
+      ++num_arriving;
+    }
+    if (num_arriving > 0) {
+      TFF_CHECK(protocol->AddClients(num_arriving).ok());
+      num_arrived += num_arriving;
+    }
+    while (num_responded < schedule.responses.size() &&
+           schedule.responses[num_responded].first <= elapsed) {
+      TFF_CHECK(protocol
+                    ->ReceiveClientMessage(
+                        schedule.responses[num_responded].second, message)
+                    .ok());
+      ++num_responded;
+    }
+    status = protocol->GetStatus();
+    if (num_arrived == num_clients && status.num_clients_pending() == 0) {
+      break;
+    }
+  }
+  TFF_CHECK(protocol->Complete().ok());
+  benchmark::DoNotOptimize(protocol->GetResult().value());
+  return status.num_clients_aborted();
+}
+
+// Arguments: num_clients.
+void BM_SimulatedRoundWithOutlierDetection(benchmark::State& state) {
+  const int64_t num_clients = state.range(0);
+  const Configuration config = CreateSumConfiguration();
+  const ClientMessage message = CreateClientMessage();
+  const ClientSchedule schedule = CreateClientSchedule(num_clients);
+
+  SetMetricsEnabled(true);
+  MetricsRegistry& registry = MetricsRegistry::Default();
+  const LatencyHistogram& state_lock =
+      *registry.GetLatencyHistogram("SimpleAggregationProtocol::StateLock");
+  const LatencyHistogram& outlier_detection = *registry.GetLatencyHistogram(
+      "SimpleAggregationProtocol::PerformOutlierDetection");
+  const LatencyHistogram& get_status =
+      *registry.GetLatencyHistogram("SimpleAggregationProtocol::GetStatus");
+  const HistogramSnapshot state_lock_start(state_lock);
+  const HistogramSnapshot outlier_detection_start(outlier_detection);
+  const HistogramSnapshot get_status_start(get_status);
+
+  int64_t num_outliers = 0;
+  for (auto s : state) {
+    num_outliers += RunRound(schedule, message, config);
+  }
+
+  const HistogramSnapshot state_lock_end(state_lock);
+  const HistogramSnapshot outlier_detection_end(outlier_detection);
+  const HistogramSnapshot get_status_end(get_status);
+  SetMetricsEnabled(false);
+
+  const double num_rounds = static_cast<double>(state.iterations());
+  state.SetItemsProcessed(state.iterations() * num_clients);
+  state.counters["outliers_per_round"] = num_outliers / num_rounds;
+  state.counters["state_lock_ms_per_round"] =
+      absl::ToDoubleMilliseconds(state_lock_end.sum - state_lock_start.sum) /
+      num_rounds;
+  state.counters["state_lock_p99_us"] = absl::ToDoubleMicroseconds(
+      Quantile(state_lock_start, state_lock_end, 0.99));
+  state.counters["outlier_detection_calls_per_round"] =
+      (outlier_detection_end.count - outlier_detection_start.count) /
+      num_rounds;
+  state.counters["outlier_detection_mean_us"] = absl::ToDoubleMicroseconds(
+      Mean(outlier_detection_start, outlier_detection_end));
+  state.counters["outlier_detection_p99_us"] = absl::ToDoubleMicroseconds(
+      Quantile(outlier_detection_start, outlier_detection_end, 0.99));
+  state.counters["get_status_mean_ns"] = absl::ToDoubleNanoseconds(
+      Mean(get_status_start, get_status_end));
+}
+
+BENCHMARK(BM_SimulatedRoundWithOutlierDetection)
+    ->ArgName("num_clients")
+    ->Arg(100000)
+    ->Arg(1000000)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace tensorflow_federated::aggregation
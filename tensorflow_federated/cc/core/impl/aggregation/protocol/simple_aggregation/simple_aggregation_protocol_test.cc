@@ -34,6 +34,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
@@ -364,6 +365,28 @@ TEST_F(SimpleAggregationProtocolTest, ReceiveClientMessage_MismatchingTensor) {
                   "protocol_state: PROTOCOL_STARTED num_clients_failed: 1"));
 }
 
+TEST_F(SimpleAggregationProtocolTest,
+       ReceiveClientMessage_MovedInlineBytesArePassedToParser) {
+  auto protocol = CreateProtocolWithDefaultConfig();
+  EXPECT_THAT(protocol->Start(1), IsOk());
+  const std::string inline_bytes(4096, 'x');
+  auto parser = std::make_unique<MockCheckpointParser>();
+  EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({1}));
+  }));
+  EXPECT_CALL(checkpoint_parser_factory_, Create(absl::Cord(inline_bytes)))
+      .WillOnce(Return(ByMove(std::move(parser))));
+
+  ClientMessage message;
+  message.mutable_simple_aggregation()->mutable_input()->set_inline_bytes(
+      inline_bytes);
+  EXPECT_THAT(protocol->ReceiveClientMessage(0, std::move(message)), IsOk());
+  EXPECT_THAT(protocol->GetStatus(),
+              testing::EqualsProto(
+                  "protocol_state: PROTOCOL_STARTED num_clients_completed: 1 "
+                  "num_inputs_aggregated_and_included: 1"));
+}
+
 TEST_F(SimpleAggregationProtocolTest, ReceiveClientMessage_UriType_Success) {
   auto protocol = CreateProtocolWithDefaultConfig();
   EXPECT_THAT(protocol->Start(1), IsOk());
@@ -393,6 +416,41 @@ TEST_F(SimpleAggregationProtocolTest, ReceiveClientMessage_UriType_Success) {
                   "num_inputs_aggregated_and_included: 1"));
 }
 
+TEST_F(SimpleAggregationProtocolTest, GetIngestionMetrics) {
+  auto protocol = CreateProtocolWithDefaultConfig();
+  EXPECT_THAT(protocol->Start(2), IsOk());
+  IngestionMetrics metrics = protocol->GetIngestionMetrics();
+  EXPECT_EQ(metrics.parse().num_inputs(), 0);
+  EXPECT_EQ(metrics.bytes_ingested(), 0);
+
+  auto parser = std::make_unique<MockCheckpointParser>();
+  EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+    return Tensor::Create(DT_INT32, {}, CreateTestData({1}));
+  }));
+  EXPECT_CALL(checkpoint_parser_factory_, Create(_))
+      .WillOnce(Return(ByMove(std::move(parser))));
+  EXPECT_CALL(resource_resolver_, RetrieveResource(0, StrEq("foo_uri")))
+      .WillOnce(Return(absl::Cord("0123456789")));
+  ClientMessage message;
+  message.mutable_simple_aggregation()->mutable_input()->set_uri("foo_uri");
+  EXPECT_THAT(protocol->ReceiveClientMessage(0, message), IsOk());
+
+  metrics = protocol->GetIngestionMetrics();
+  for (const StageMetrics& stage :
+       {metrics.retrieval(), metrics.parse(), metrics.accumulation()}) {
+    EXPECT_EQ(stage.num_inputs(), 1);
+    EXPECT_EQ(stage.num_waiting(), 0);
+    EXPECT_EQ(stage.num_running(), 0);
+    EXPECT_GE(stage.total_wait_nanos(), 0);
+    EXPECT_GE(stage.total_run_nanos(), 0);
+  }
+  EXPECT_GE(metrics.accumulation().total_run_nanos(),
+            metrics.accumulation_lock_wait_nanos());
+  EXPECT_EQ(metrics.bytes_ingested(), 10);
+  // The state of a scalar int32 sum.
+  EXPECT_EQ(metrics.aggregator_memory_bytes(), 4);
+}
+
 TEST_F(SimpleAggregationProtocolTest,
        ReceiveClientMessage_UriType_FailToParse) {
   auto protocol = CreateProtocolWithDefaultConfig();
@@ -1015,6 +1073,85 @@ TEST_F(SimpleAggregationProtocolTest, Complete_TensorUsedInMultipleIntrinsics) {
   EXPECT_TRUE(protocol->IsClientClosed(1).value());
 }
 
+TEST_F(SimpleAggregationProtocolTest, ReportSnapshot_ContinuesAggregation) {
+  auto protocol = CreateProtocolWithDefaultConfig();
+  EXPECT_THAT(protocol->Start(2), IsOk());
+  EXPECT_CALL(checkpoint_parser_factory_, Create(_))
+      .WillRepeatedly(Invoke([](const absl::Cord&) {
+        auto parser = std::make_unique<MockCheckpointParser>();
+        EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+          return Tensor::Create(DT_INT32, {}, CreateTestData({1}));
+        }));
+        return parser;
+      }));
+  auto snapshot_builder = std::make_unique<MockCheckpointBuilder>();
+  EXPECT_CALL(*snapshot_builder, Add(StrEq("foo_out"), IsTensor({}, {1})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(*snapshot_builder, Build()).WillOnce(Return(absl::Cord{}));
+  auto result_builder = std::make_unique<MockCheckpointBuilder>();
+  EXPECT_CALL(*result_builder, Add(StrEq("foo_out"), IsTensor({}, {2})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(*result_builder, Build()).WillOnce(Return(absl::Cord{}));
+  EXPECT_CALL(checkpoint_builder_factory_, Create())
+      .WillOnce(Return(ByMove(std::move(snapshot_builder))))
+      .WillOnce(Return(ByMove(std::move(result_builder))));
+
+  EXPECT_THAT(protocol->ReceiveClientMessage(0, MakeClientMessage()), IsOk());
+  EXPECT_OK(protocol->ReportSnapshot());
+  EXPECT_EQ(protocol->GetStatus().protocol_state(), PROTOCOL_STARTED);
+
+  EXPECT_THAT(protocol->ReceiveClientMessage(1, MakeClientMessage()), IsOk());
+  EXPECT_THAT(protocol->Complete(), IsOk());
+  EXPECT_THAT(protocol->ReportSnapshot(), StatusIs(FAILED_PRECONDITION));
+}
+
+TEST_F(SimpleAggregationProtocolTest, MergeState_FromLeafProtocols) {
+  auto root = CreateProtocolWithDefaultConfig();
+  auto leaf1 = CreateProtocolWithDefaultConfig();
+  auto leaf2 = CreateProtocolWithDefaultConfig();
+  EXPECT_THAT(root->Start(0), IsOk());
+  EXPECT_THAT(leaf1->Start(2), IsOk());
+  EXPECT_THAT(leaf2->Start(1), IsOk());
+  EXPECT_CALL(checkpoint_parser_factory_, Create(_))
+      .WillRepeatedly(Invoke([](const absl::Cord&) {
+        auto parser = std::make_unique<MockCheckpointParser>();
+        EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+          return Tensor::Create(DT_INT32, {}, CreateTestData({1}));
+        }));
+        return parser;
+      }));
+  auto result_builder = std::make_unique<MockCheckpointBuilder>();
+  EXPECT_CALL(*result_builder, Add(StrEq("foo_out"), IsTensor({}, {3})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_CALL(*result_builder, Build()).WillOnce(Return(absl::Cord{}));
+  EXPECT_CALL(checkpoint_builder_factory_, Create())
+      .WillOnce(Return(ByMove(std::move(result_builder))));
+
+  // The first leaf ships a delta after each input, the second one at the end.
+  EXPECT_THAT(leaf1->ReceiveClientMessage(0, MakeClientMessage()), IsOk());
+  absl::StatusOr<absl::Cord> delta = leaf1->TakeStateDelta();
+  ASSERT_THAT(delta, IsOk());
+  EXPECT_THAT(root->MergeState(*delta), IsOk());
+  EXPECT_THAT(leaf1->ReceiveClientMessage(1, MakeClientMessage()), IsOk());
+  delta = leaf1->TakeStateDelta();
+  ASSERT_THAT(delta, IsOk());
+  EXPECT_THAT(root->MergeState(*delta), IsOk());
+  EXPECT_THAT(leaf2->ReceiveClientMessage(0, MakeClientMessage()), IsOk());
+  delta = leaf2->TakeStateDelta();
+  ASSERT_THAT(delta, IsOk());
+  EXPECT_THAT(root->MergeState(*delta), IsOk());
+
+  EXPECT_THAT(leaf1->Abort(), IsOk());
+  EXPECT_THAT(leaf2->Abort(), IsOk());
+  EXPECT_THAT(root->Complete(), IsOk());
+  EXPECT_THAT(root->MergeState(absl::Cord()), StatusIs(FAILED_PRECONDITION));
+}
+
+TEST_F(SimpleAggregationProtocolTest, TakeStateDelta_ProtocolNotStarted) {
+  auto protocol = CreateProtocolWithDefaultConfig();
+  EXPECT_THAT(protocol->TakeStateDelta(), StatusIs(FAILED_PRECONDITION));
+}
+
 TEST_F(SimpleAggregationProtocolTest, Complete_ProtocolNotStarted) {
   auto protocol = CreateProtocolWithDefaultConfig();
   EXPECT_THAT(protocol->Complete(), StatusIs(FAILED_PRECONDITION));
@@ -1124,6 +1261,150 @@ TEST_F(SimpleAggregationProtocolTest, ConcurrentAggregation_Success) {
   EXPECT_OK(protocol->GetResult());
 }
 
+TEST_F(SimpleAggregationProtocolTest,
+       IngestionLimits_InputBeyondMaxInFlightIsRejected) {
+  SimpleAggregationIngestionOptions ingestion_options;
+  ingestion_options.max_inputs_in_flight = 1;
+  auto protocol = SimpleAggregationProtocol::Create(
+      default_configuration(), &checkpoint_parser_factory_,
+      &checkpoint_builder_factory_, &resource_resolver_, &clock_,
+      /*outlier_detection_parameters=*/std::nullopt,
+      /*num_aggregator_shards=*/1, ingestion_options);
+  ASSERT_THAT(protocol, IsOk());
+  EXPECT_THAT((*protocol)->Start(2), IsOk());
+
+  // The first input is held inside the parser until the second input has been
+  // rejected.
+  absl::Notification parsing_started;
+  absl::Notification resume_parsing;
+  EXPECT_CALL(checkpoint_parser_factory_, Create(_)).WillRepeatedly(Invoke([&] {
+    if (!parsing_started.HasBeenNotified()) {
+      parsing_started.Notify();
+      resume_parsing.WaitForNotification();
+    }
+    auto parser = std::make_unique<MockCheckpointParser>();
+    EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+      return Tensor::Create(DT_INT32, {}, CreateTestData({1}));
+    }));
+    return parser;
+  }));
+
+  auto scheduler = CreateThreadPoolScheduler(1);
+  scheduler->Schedule([&]() {
+    EXPECT_THAT((*protocol)->ReceiveClientMessage(0, MakeClientMessage()),
+                IsOk());
+  });
+  parsing_started.WaitForNotification();
+  EXPECT_THAT((*protocol)->ReceiveClientMessage(1, MakeClientMessage()),
+              StatusIs(UNAVAILABLE));
+  EXPECT_FALSE((*protocol)->IsClientClosed(1).value());
+
+  resume_parsing.Notify();
+  scheduler->WaitUntilIdle();
+
+  // Once the first input has been aggregated the second one is admitted.
+  EXPECT_THAT((*protocol)->ReceiveClientMessage(1, MakeClientMessage()),
+              IsOk());
+  EXPECT_THAT((*protocol)->GetStatus(),
+              testing::EqualsProto("protocol_state: PROTOCOL_STARTED "
+                                   "num_clients_completed: 2 "
+                                   "num_inputs_aggregated_and_included: 2"));
+}
+
+TEST_F(SimpleAggregationProtocolTest,
+       IngestionLimits_ConcurrentParsesAreBounded) {
+  const int64_t kNumClients = 10;
+  SimpleAggregationIngestionOptions ingestion_options;
+  ingestion_options.max_concurrent_parses = 2;
+  auto protocol = SimpleAggregationProtocol::Create(
+      default_configuration(), &checkpoint_parser_factory_,
+      &checkpoint_builder_factory_, &resource_resolver_, &clock_,
+      /*outlier_detection_parameters=*/std::nullopt,
+      /*num_aggregator_shards=*/1, ingestion_options);
+  ASSERT_THAT(protocol, IsOk());
+  EXPECT_THAT((*protocol)->Start(kNumClients), IsOk());
+
+  std::atomic<int> num_parsing = 0;
+  std::atomic<int> max_num_parsing = 0;
+  EXPECT_CALL(checkpoint_parser_factory_, Create(_)).WillRepeatedly(Invoke([&] {
+    int n = ++num_parsing;
+    int max_n = max_num_parsing;
+    while (n > max_n && !max_num_parsing.compare_exchange_weak(max_n, n)) {
+    }
+    absl::SleepFor(absl::Milliseconds(5));
+    --num_parsing;
+    auto parser = std::make_unique<MockCheckpointParser>();
+    EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([] {
+      return Tensor::Create(DT_INT32, {}, CreateTestData({1}));
+    }));
+    return parser;
+  }));
+
+  auto scheduler = CreateThreadPoolScheduler(kNumClients);
+  for (int64_t i = 0; i < kNumClients; ++i) {
+    scheduler->Schedule([&, i]() {
+      EXPECT_THAT((*protocol)->ReceiveClientMessage(i, MakeClientMessage()),
+                  IsOk());
+    });
+  }
+  scheduler->WaitUntilIdle();
+
+  EXPECT_LE(max_num_parsing, 2);
+  EXPECT_EQ((*protocol)->GetStatus().num_inputs_aggregated_and_included(),
+            kNumClients);
+}
+
+TEST_F(SimpleAggregationProtocolTest,
+       IngestionLimits_ClientsAreSpreadAcrossNumaNodes) {
+  const int64_t kNumClients = 10;
+  SimpleAggregationIngestionOptions ingestion_options;
+  ingestion_options.num_numa_nodes = 2;
+  auto protocol = SimpleAggregationProtocol::Create(
+      default_configuration(), &checkpoint_parser_factory_,
+      &checkpoint_builder_factory_, &resource_resolver_, &clock_,
+      /*outlier_detection_parameters=*/std::nullopt,
+      /*num_aggregator_shards=*/4, ingestion_options);
+  ASSERT_THAT(protocol, IsOk());
+  EXPECT_THAT((*protocol)->Start(kNumClients), IsOk());
+  EXPECT_EQ((*protocol)->GetClientNumaNode(4), 0);
+  EXPECT_EQ((*protocol)->GetClientNumaNode(7), 1);
+
+  std::atomic<int> tensor_value = 0;
+  EXPECT_CALL(checkpoint_parser_factory_, Create(_)).WillRepeatedly(Invoke([&] {
+    auto parser = std::make_unique<MockCheckpointParser>();
+    EXPECT_CALL(*parser, GetTensor(StrEq("foo"))).WillOnce(Invoke([&] {
+      return Tensor::Create(DT_INT32, {}, CreateTestData({++tensor_value}));
+    }));
+    return parser;
+  }));
+
+  auto scheduler = CreateThreadPoolScheduler(4);
+  for (int64_t i = 0; i < kNumClients; ++i) {
+    scheduler->Schedule([&, i]() {
+      EXPECT_THAT((*protocol)->ReceiveClientMessage(i, MakeClientMessage()),
+                  IsOk());
+    });
+  }
+  scheduler->WaitUntilIdle();
+
+  auto& checkpoint_builder = ExpectCheckpointBuilder();
+  EXPECT_CALL(checkpoint_builder, Add(StrEq("foo_out"), IsTensor({}, {55})))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_THAT((*protocol)->Complete(), IsOk());
+}
+
+TEST_F(SimpleAggregationProtocolTest,
+       IngestionLimits_MoreNumaNodesThanShardsFails) {
+  SimpleAggregationIngestionOptions ingestion_options;
+  ingestion_options.num_numa_nodes = 2;
+  EXPECT_THAT(SimpleAggregationProtocol::Create(
+                  default_configuration(), &checkpoint_parser_factory_,
+                  &checkpoint_builder_factory_, &resource_resolver_, &clock_,
+                  /*outlier_detection_parameters=*/std::nullopt,
+                  /*num_aggregator_shards=*/1, ingestion_options),
+              StatusIs(INVALID_ARGUMENT));
+}
+
 // A trivial test aggregator that delegates aggregation to a function.
 class FunctionAggregator final : public AggVectorAggregator<int> {
  public:
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/tensor_binding_plan.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+
+namespace tensorflow_federated::aggregation {
+
+TensorBindingPlan::TensorBindingPlan(std::vector<std::string> names)
+    : names_(std::move(names)) {
+  slots_.reserve(names_.size());
+  for (size_t slot = 0; slot < names_.size(); ++slot) {
+    TFF_CHECK(slots_.emplace(names_[slot], slot).second)
+        << "TensorBindingPlan: duplicate tensor name " << names_[slot];
+  }
+}
+
+std::optional<size_t> TensorBindingPlan::FindSlot(absl::string_view name,
+                                                  size_t hint) const {
+  if (hint < names_.size() && names_[hint] == name) {
+    return hint;
+  }
+  auto it = slots_.find(name);
+  if (it == slots_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+}  // namespace tensorflow_federated::aggregation
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_TENSOR_BINDING_PLAN_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_TENSOR_BINDING_PLAN_H_
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace tensorflow_federated::aggregation {
+
+// The names of the tensors that a consumer of checkpoints, e.g. the
+// CheckpointAggregator of a Configuration, gets from every checkpoint, each
+// bound to a fixed slot. A plan is computed once and shared by the parsers of
+// all checkpoints, which can then put the tensors into their slots while
+// parsing rather than into a map keyed by tensor name.
+//
+// This class is immutable and thread safe.
+class TensorBindingPlan {
+ public:
+  // Creates a plan binding each of the distinct `names` to the slot of its
+  // index.
+  explicit TensorBindingPlan(std::vector<std::string> names);
+
+  TensorBindingPlan(const TensorBindingPlan&) = delete;
+  TensorBindingPlan& operator=(const TensorBindingPlan&) = delete;
+
+  // Returns the number of slots.
+  size_t size() const { return names_.size(); }
+
+  // Returns the name of the tensor bound to `slot`.
+  const std::string& name(size_t slot) const { return names_[slot]; }
+
+  // Returns the slot of the tensor named `name`, or nullopt if it isn't bound.
+  // `hint` is the slot the caller expects, e.g. the slot after that of the
+  // previous tensor of a checkpoint, which is compared with `name` before
+  // hashing it, so that checkpoints written in the order of the plan are
+  // bound without any hashing.
+  std::optional<size_t> FindSlot(absl::string_view name, size_t hint = 0) const;
+
+ private:
+  const std::vector<std::string> names_;
+  absl::flat_hash_map<std::string, size_t> slots_;
+};
+
+}  // namespace tensorflow_federated::aggregation
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_PROTOCOL_TENSOR_BINDING_PLAN_H_
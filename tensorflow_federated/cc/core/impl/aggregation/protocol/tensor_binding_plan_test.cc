@@ -0,0 +1,52 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/tensor_binding_plan.h"
+
+#include <cstddef>
+#include <optional>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+
+namespace tensorflow_federated::aggregation {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Optional;
+
+TEST(TensorBindingPlanTest, BindsNamesToSlotsInOrder) {
+  TensorBindingPlan plan({"foo", "bar", "baz"});
+  EXPECT_EQ(plan.size(), 3);
+  EXPECT_EQ(plan.name(1), "bar");
+  EXPECT_THAT(plan.FindSlot("foo"), Optional(Eq(size_t{0})));
+  EXPECT_THAT(plan.FindSlot("baz"), Optional(Eq(size_t{2})));
+}
+
+TEST(TensorBindingPlanTest, FindSlotIgnoresWrongHint) {
+  TensorBindingPlan plan({"foo", "bar"});
+  EXPECT_THAT(plan.FindSlot("bar", /*hint=*/1), Optional(Eq(size_t{1})));
+  EXPECT_THAT(plan.FindSlot("foo", /*hint=*/1), Optional(Eq(size_t{0})));
+  EXPECT_THAT(plan.FindSlot("foo", /*hint=*/2), Optional(Eq(size_t{0})));
+}
+
+TEST(TensorBindingPlanTest, FindSlotOfUnboundName) {
+  TensorBindingPlan plan({"foo"});
+  EXPECT_EQ(plan.FindSlot("bar"), std::nullopt);
+}
+
+}  // namespace
+}  // namespace tensorflow_federated::aggregation
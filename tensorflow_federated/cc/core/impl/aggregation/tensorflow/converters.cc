@@ -16,21 +16,28 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/converters.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/framework/allocation_description.pb.h"
+#include "tensorflow/core/framework/allocator.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/platform/mem.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/tsl/platform/refcount.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/cord_tensor_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.pb.h"
@@ -87,31 +94,53 @@ class StringTensorDataAdapter : public TensorData {
 
 // A TensorBuffer that wraps a string Aggregation Tensor and does not delete it.
 // This TensorBuffer also owns the array of tstrings that are views of the
-// data in the wrapped Tensor.
+// data in the wrapped Tensor. The array is allocated with the alignment that
+// tf::Tensor expects, so that the resulting tensor can be accessed with flat()
+// and other aligned accessors.
 class WrappedStringAggregationTensorBuffer : public tf::TensorBuffer {
  public:
-  explicit WrappedStringAggregationTensorBuffer(
-      Tensor tensor, std::unique_ptr<tf::tstring[]> owning_tstring_arr,
-      size_t data_size)
-      : tf::TensorBuffer(owning_tstring_arr.get()),
-        size_(data_size),
-        tensor_(std::move(tensor)),
-        owning_arr_(std::move(owning_tstring_arr)) {}
+  static WrappedStringAggregationTensorBuffer* Create(Tensor tensor) {
+    auto string_data = tensor.AsSpan<string_view>();
+    size_t num_strings = string_data.size();
+    size_t data_size = num_strings * sizeof(tf::tstring);
+    auto* tstring_arr = static_cast<tf::tstring*>(tf::port::AlignedMalloc(
+        std::max(data_size, sizeof(tf::tstring)),
+        tf::Allocator::kAllocatorAlignment));
+    for (size_t i = 0; i < num_strings; ++i) {
+      new (&tstring_arr[i]) tf::tstring(
+          tf::tstring::view(string_data[i].data(), string_data[i].size()));
+    }
+    return new WrappedStringAggregationTensorBuffer(std::move(tensor),
+                                                    tstring_arr, num_strings);
+  }
 
-  size_t size() const override { return size_; }
+  size_t size() const override { return num_strings_ * sizeof(tf::tstring); }
 
   tf::TensorBuffer* root_buffer() override { return this; }
   bool OwnsMemory() const override { return true; }
 
   void FillAllocationDescription(
       tf::AllocationDescription* proto) const override {
-    proto->set_requested_bytes(size_);
+    proto->set_requested_bytes(size());
   }
 
  private:
-  size_t size_;
+  WrappedStringAggregationTensorBuffer(Tensor tensor, tf::tstring* tstring_arr,
+                                       size_t num_strings)
+      : tf::TensorBuffer(tstring_arr),
+        num_strings_(num_strings),
+        tensor_(std::move(tensor)) {}
+
+  ~WrappedStringAggregationTensorBuffer() override {
+    auto* tstring_arr = static_cast<tf::tstring*>(data());
+    for (size_t i = 0; i < num_strings_; ++i) {
+      tstring_arr[i].~tstring();
+    }
+    tf::port::AlignedFree(tstring_arr);
+  }
+
+  size_t num_strings_;
   Tensor tensor_;
-  std::unique_ptr<tf::tstring[]> owning_arr_;
 };
 
 // A TensorBuffer that wraps a numeric Aggregation Tensor and does not delete
@@ -150,6 +179,10 @@ StatusOr<DataType> ToAggDataType(tf::DataType dtype) {
       return DT_FLOAT;
     case tf::DT_DOUBLE:
       return DT_DOUBLE;
+    case tf::DT_INT8:
+      return DT_INT8;
+    case tf::DT_UINT8:
+      return DT_UINT8;
     case tf::DT_INT32:
       return DT_INT32;
     case tf::DT_INT64:
@@ -219,6 +252,28 @@ StatusOr<Tensor> ToAggTensor(const ::tensorflow::TensorProto& tensor_proto) {
   return ToAggTensor(std::make_unique<tf::Tensor>(std::move(tf_tensor)));
 }
 
+StatusOr<Tensor> ToAggTensor(::tensorflow::TensorProto&& tensor_proto) {
+  TFF_ASSIGN_OR_RETURN(DataType dtype, ToAggDataType(tensor_proto.dtype()));
+  if (dtype == DT_STRING || tensor_proto.tensor_content().empty()) {
+    return ToAggTensor(std::as_const(tensor_proto));
+  }
+  // Numeric values packed into tensor_content are taken over by the
+  // Aggregation Tensor rather than copied into a tf::Tensor buffer first.
+  tf::TensorShape tf_shape;
+  if (!tf::TensorShape::BuildTensorShape(tensor_proto.tensor_shape(), &tf_shape)
+           .ok()) {
+    return TFF_STATUS(INVALID_ARGUMENT)
+           << "Unsupported tf::TensorShape: "
+           << tensor_proto.tensor_shape().DebugString();
+  }
+  size_t alignment_size = 0;
+  NUMERICAL_ONLY_DTYPE_CASES(dtype, T, alignment_size = alignof(T));
+  absl::Cord content(std::move(*tensor_proto.mutable_tensor_content()));
+  return Tensor::Create(
+      dtype, ToAggShape(tf_shape),
+      std::make_unique<CordTensorData>(std::move(content), alignment_size));
+}
+
 StatusOr<Tensor> ToAggTensor(std::unique_ptr<tf::Tensor> tensor) {
   TFF_ASSIGN_OR_RETURN(DataType dtype, ToAggDataType(tensor->dtype()));
   TensorShape shape = ToAggShape(tensor->shape());
@@ -233,6 +288,10 @@ absl::StatusOr<tf::DataType> ToTfDataType(DataType dtype) {
       return tf::DT_FLOAT;
     case DT_DOUBLE:
       return tf::DT_DOUBLE;
+    case DT_INT8:
+      return tf::DT_INT8;
+    case DT_UINT8:
+      return tf::DT_UINT8;
     case DT_INT32:
       return tf::DT_INT32;
     case DT_INT64:
@@ -263,25 +322,28 @@ absl::StatusOr<tf::Tensor> ToTfTensor(Tensor tensor) {
   TFF_ASSIGN_OR_RETURN(tf::DataType dtype, ToTfDataType(tensor.dtype()));
   TFF_ASSIGN_OR_RETURN(tf::TensorShape shape, ToTfShape(tensor.shape()));
 
-  tsl::core::RefCountPtr<tf::TensorBuffer> tensor_buffer;
   if (tensor.dtype() == DT_STRING) {
     // Views the string_views in the TFF Tensor to an array of TensorFlow
     // tstrings for the data of the TF Tensor.
-    auto string_data = tensor.AsSpan<string_view>();
-    size_t num_strings = string_data.size();
-    auto tstring_arr = std::make_unique<tf::tstring[]>(num_strings);
-    for (int i = 0; i < num_strings; ++i) {
-      tstring_arr[i] =
-          tf::tstring::view(string_data[i].data(), string_data[i].size());
-    }
-    tensor_buffer.reset(new WrappedStringAggregationTensorBuffer(
-        std::move(tensor), std::move(tstring_arr),
-        num_strings * sizeof(tf::tstring)));
-  } else {
-    tensor_buffer.reset(
+    tsl::core::RefCountPtr<tf::TensorBuffer> tensor_buffer(
+        WrappedStringAggregationTensorBuffer::Create(std::move(tensor)));
+    return tf::Tensor(dtype, std::move(shape), std::move(tensor_buffer));
+  }
+
+  // Numeric data is shared with the TF Tensor when its buffer is suitably
+  // aligned, which is the case for all buffers allocated by TensorFlow and for
+  // most heap allocated vectors. Otherwise the data is copied to an aligned
+  // buffer, since aligned accessors of tf::Tensor would fail on it.
+  if (TensorData::IsAligned(tensor.data().data(), EIGEN_MAX_ALIGN_BYTES)) {
+    tsl::core::RefCountPtr<tf::TensorBuffer> tensor_buffer(
         new WrappedNumericAggregationTensorBuffer(std::move(tensor)));
+    return tf::Tensor(dtype, std::move(shape), std::move(tensor_buffer));
   }
-  return tf::Tensor(dtype, std::move(shape), std::move(tensor_buffer));
+  tf::Tensor tf_tensor(dtype, shape);
+  absl::string_view tf_data = tf_tensor.tensor_data();
+  std::memcpy(const_cast<char*>(tf_data.data()), tensor.data().data(),
+              tf_data.size());
+  return tf_tensor;
 }
 
 }  // namespace tensorflow_federated::aggregation::tensorflow
@@ -53,6 +53,12 @@ StatusOr<TensorSpec> ToAggTensorSpec(const ::tensorflow::TensorSpecProto& spec);
 // Converts Tensorflow TensorProto to Aggregation Tensor.
 StatusOr<Tensor> ToAggTensor(const ::tensorflow::TensorProto& tensor_proto);
 
+// Converts Tensorflow TensorProto to Aggregation Tensor, consuming the proto.
+// Numeric values stored in the tensor_content field are moved into the
+// Aggregation Tensor, and are only copied if their buffer isn't suitably
+// aligned.
+StatusOr<Tensor> ToAggTensor(::tensorflow::TensorProto&& tensor_proto);
+
 // Converts Tensorflow Tensor to Aggregation Tensor.
 // Returns an error status if supplied Tensor data type or shape isn't
 // supported by the Aggregation Core.
@@ -68,12 +74,11 @@ StatusOr<::tensorflow::DataType> ToTfDataType(DataType dtype);
 StatusOr<::tensorflow::TensorShape> ToTfShape(const TensorShape& shape);
 
 // Converts an Aggregation Tensor to a TensorFlow Tensor.
-// Resulting numeric tensors may not be properly aligned, as alignment depends
-// on the size of the buffer of the input tensor and TensorFlow has particular
-// requirements for alignment. The only way to guarantee proper alignment would
-// be to allocate a new buffer and copy data over, which we are not doing for
-// efficiency reasons. Use methods like tensorflow::Tensor->unaligned_flat to
-// retrieve data.
+// The resulting TensorFlow tensor takes ownership of the Aggregation Tensor and
+// shares its data rather than copying it. String values are exposed as tstring
+// views of the original strings. Numeric data is only copied if its buffer
+// isn't aligned as TensorFlow requires, so that the resulting tensor is always
+// properly aligned.
 StatusOr<::tensorflow::Tensor> ToTfTensor(Tensor tensor);
 
 }  // namespace tensorflow_federated::aggregation::tensorflow
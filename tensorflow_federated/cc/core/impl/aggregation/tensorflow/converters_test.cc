@@ -16,6 +16,8 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/converters.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <initializer_list>
 #include <memory>
@@ -38,6 +40,7 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_spec.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/vector_string_data.h"
@@ -153,6 +156,29 @@ TEST(ConvertersTest, ConvertsNumericTfTensorToAggTensor) {
               IsTensor<float>({2, 3}, {1, 2, 3, 4, 5, 6}));
 }
 
+TEST(ConvertersTest, ConvertsTfTensorProtoWithContentToAggTensor) {
+  tf::Tensor tf_tensor(tf::DT_INT64, CreateTfShape({2, 2}));
+  auto flat = tf_tensor.flat<int64_t>();
+  for (int i = 0; i < 4; ++i) {
+    flat(i) = i + 10;
+  }
+  tf::TensorProto tensor_proto;
+  tf_tensor.AsProtoTensorContent(&tensor_proto);
+  EXPECT_THAT(*ToAggTensor(tensor_proto),
+              IsTensor<int64_t>({2, 2}, {10, 11, 12, 13}));
+  EXPECT_THAT(*ToAggTensor(std::move(tensor_proto)),
+              IsTensor<int64_t>({2, 2}, {10, 11, 12, 13}));
+}
+
+TEST(ConvertersTest, CannotConvertTfTensorProtoWithMismatchedContent) {
+  tf::TensorProto tensor_proto = PARSE_TEXT_PROTO(R"pb(
+    dtype: DT_INT32
+    tensor_shape { dim { size: 2 } }
+    tensor_content: "abc"
+  )pb");
+  EXPECT_FALSE(ToAggTensor(std::move(tensor_proto)).ok());
+}
+
 TEST(ConvertersTest, ConvertsTfStringTensorToAggTensor) {
   tf::TensorProto tensor_proto = PARSE_TEXT_PROTO(R"pb(
     dtype: DT_STRING
@@ -232,6 +258,53 @@ TEST(ConvertersTest, ConvertsNumericAggTensorToTfTensor) {
   EXPECT_EQ(flat(5), 6);
 }
 
+// TensorData over floats stored at an offset of one value within a vector,
+// which isn't aligned as TensorFlow requires.
+class UnalignedFloatData : public TensorData {
+ public:
+  explicit UnalignedFloatData(std::vector<float> values)
+      : values_(values.size() + 1) {
+    std::copy(values.begin(), values.end(), values_.begin() + 1);
+  }
+  size_t byte_size() const override {
+    return (values_.size() - 1) * sizeof(float);
+  }
+  const void* data() const override { return values_.data() + 1; }
+
+ private:
+  std::vector<float> values_;
+};
+
+TEST(ConvertersTest, RoundTripsNumericTensorWithoutCopy) {
+  auto tf_tensor = std::make_unique<tf::Tensor>(
+      CreateTfTensor<int64_t>(tf::DT_INT64, {4}, {1, 2, 3, 4}));
+  const char* data = tf_tensor->tensor_data().data();
+  absl::StatusOr<Tensor> tensor = ToAggTensor(std::move(tf_tensor));
+  ASSERT_OK(tensor);
+  EXPECT_EQ(data, tensor->data().data());
+  absl::StatusOr<tf::Tensor> round_trip = ToTfTensor(std::move(*tensor));
+  ASSERT_OK(round_trip);
+  EXPECT_EQ(data, round_trip->tensor_data().data());
+  auto flat = round_trip->flat<int64_t>();
+  EXPECT_EQ(flat(0), 1);
+  EXPECT_EQ(flat(3), 4);
+}
+
+TEST(ConvertersTest, ConvertsUnalignedNumericAggTensorToAlignedTfTensor) {
+  auto tensor =
+      Tensor::Create(DT_FLOAT, {3},
+                     std::make_unique<UnalignedFloatData>(
+                         std::vector<float>({1, 2, 3})));
+  ASSERT_OK(tensor);
+  absl::StatusOr<tf::Tensor> tf_tensor = ToTfTensor(std::move(*tensor));
+  ASSERT_OK(tf_tensor);
+  EXPECT_TRUE(tf_tensor->IsAligned());
+  auto flat = tf_tensor->flat<float>();
+  EXPECT_EQ(flat(0), 1);
+  EXPECT_EQ(flat(1), 2);
+  EXPECT_EQ(flat(2), 3);
+}
+
 TEST(ConvertersTest, ConvertsAggStringTensorToTfTensor) {
   auto tensor = Tensor::Create(
       DT_STRING, {3},
@@ -245,6 +318,7 @@ TEST(ConvertersTest, ConvertsAggStringTensorToTfTensor) {
   EXPECT_EQ(flat(0), "abcd");
   EXPECT_EQ(flat(1), "whimsy");
   EXPECT_EQ(flat(2), "zzzzz");
+  EXPECT_TRUE(tf_tensor->IsAligned());
 }
 
 TEST(ConvertersTest, ConvertsAggScalartStringTensorToTfTensor) {
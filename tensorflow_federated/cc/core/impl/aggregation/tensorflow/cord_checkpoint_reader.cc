@@ -0,0 +1,198 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/cord_checkpoint_reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/framework/versions.h"
+#include "tensorflow/core/lib/io/iterator.h"
+#include "tensorflow/core/lib/io/table.h"
+#include "tensorflow/core/lib/io/table_options.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/saved_tensor_slice.pb.h"
+#include "tensorflow/core/util/saved_tensor_slice_util.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/converters.h"
+
+namespace tensorflow_federated::aggregation::tensorflow {
+
+namespace tf = ::tensorflow;
+
+namespace {
+
+// A read-only file backed by an absl::Cord.
+//
+// Reads that lie within a single chunk of the Cord return a view of that
+// chunk, which the table reader then uses in place. Only reads that span
+// chunks are copied into the scratch buffer.
+class CordRandomAccessFile : public tf::RandomAccessFile {
+ public:
+  explicit CordRandomAccessFile(absl::Cord cord) : cord_(std::move(cord)) {}
+
+  uint64_t size() const { return cord_.size(); }
+
+  absl::Status Read(uint64_t offset, size_t n, absl::string_view* result,
+                    char* scratch) const override {
+    if (offset > cord_.size()) {
+      *result = absl::string_view();
+      return absl::OutOfRangeError("Read past the end of the checkpoint");
+    }
+    size_t available = std::min<uint64_t>(n, cord_.size() - offset);
+    absl::Cord::CharIterator it = cord_.char_begin();
+    absl::Cord::Advance(&it, offset);
+    absl::string_view chunk = absl::Cord::ChunkRemaining(it);
+    if (chunk.size() >= available) {
+      *result = chunk.substr(0, available);
+    } else {
+      size_t copied = 0;
+      while (copied < available) {
+        chunk = absl::Cord::ChunkRemaining(it);
+        size_t length = std::min(chunk.size(), available - copied);
+        std::memcpy(scratch + copied, chunk.data(), length);
+        copied += length;
+        absl::Cord::Advance(&it, length);
+      }
+      *result = absl::string_view(scratch, available);
+    }
+    if (available < n) {
+      return absl::OutOfRangeError("Read less bytes than requested");
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  const absl::Cord cord_;
+};
+
+absl::StatusOr<tf::SavedTensorSlices> ReadSavedTensorSlices(
+    tf::table::Iterator& iterator, absl::string_view key) {
+  iterator.Seek(key);
+  if (!iterator.Valid() || iterator.key() != key) {
+    TFF_RETURN_IF_ERROR(iterator.status());
+    return absl::NotFoundError(
+        absl::StrFormat("Checkpoint doesn't have an entry for key %s", key));
+  }
+  tf::SavedTensorSlices saved_tensor_slices;
+  absl::string_view value = iterator.value();
+  if (!saved_tensor_slices.ParseFromArray(value.data(), value.size())) {
+    return absl::InternalError("Couldn't parse the checkpoint entry");
+  }
+  return saved_tensor_slices;
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<CordCheckpointReader>>
+CordCheckpointReader::Create(absl::Cord checkpoint) {
+  auto file = std::make_unique<CordRandomAccessFile>(std::move(checkpoint));
+  tf::table::Table* table_ptr = nullptr;
+  absl::Status open_status =
+      tf::table::Table::Open(tf::table::Options(), file.get(), file->size(),
+                             &table_ptr);
+  if (!open_status.ok()) {
+    return absl::InternalError(absl::StrFormat(
+        "Couldn't read checkpoint: %s", open_status.message()));
+  }
+  std::unique_ptr<tf::table::Table> table(table_ptr);
+
+  // All tensor metadata is stored under a single entry of the table.
+  std::unique_ptr<tf::table::Iterator> iterator(table->NewIterator());
+  TFF_ASSIGN_OR_RETURN(
+      tf::SavedTensorSlices saved_tensor_slices,
+      ReadSavedTensorSlices(*iterator, tf::checkpoint::kSavedTensorSlicesKey));
+  const tf::SavedTensorSlicesMeta& meta = saved_tensor_slices.meta();
+  TFF_RETURN_IF_ERROR(tf::CheckVersions(
+      meta.versions(), TF_CHECKPOINT_VERSION,
+      TF_CHECKPOINT_VERSION_MIN_PRODUCER, "Checkpoint", "checkpoint"));
+
+  absl::flat_hash_map<std::string, TensorMetadata> metadata;
+  DataTypeMap data_type_map;
+  TensorShapeMap shape_map;
+  for (const tf::SavedSliceMeta& slice_meta : meta.tensor()) {
+    tf::TensorShape tf_shape;
+    TFF_RETURN_IF_ERROR(
+        tf::TensorShape::BuildTensorShape(slice_meta.shape(), &tf_shape));
+    if (slice_meta.slice_size() != 1 ||
+        !tf::TensorSlice(slice_meta.slice(0)).IsFull()) {
+      return absl::UnimplementedError(absl::StrFormat(
+          "Tensor %s is partitioned, which isn't supported when reading "
+          "checkpoints in memory",
+          slice_meta.name()));
+    }
+    TFF_ASSIGN_OR_RETURN(DataType dtype, ToAggDataType(slice_meta.type()));
+    data_type_map.emplace(slice_meta.name(), dtype);
+    shape_map.emplace(slice_meta.name(), ToAggShape(tf_shape));
+    metadata.emplace(
+        slice_meta.name(),
+        TensorMetadata{slice_meta.type(), slice_meta.shape(),
+                       tf::checkpoint::EncodeTensorNameSlice(
+                           slice_meta.name(),
+                           tf::TensorSlice(slice_meta.slice(0)))});
+  }
+
+  return std::unique_ptr<CordCheckpointReader>(new CordCheckpointReader(
+      std::move(file), std::move(table), std::move(metadata),
+      std::move(data_type_map), std::move(shape_map)));
+}
+
+CordCheckpointReader::CordCheckpointReader(
+    std::unique_ptr<tf::RandomAccessFile> file,
+    std::unique_ptr<tf::table::Table> table,
+    absl::flat_hash_map<std::string, TensorMetadata> metadata,
+    DataTypeMap data_type_map, TensorShapeMap shape_map)
+    : file_(std::move(file)),
+      table_(std::move(table)),
+      metadata_(std::move(metadata)),
+      data_type_map_(std::move(data_type_map)),
+      shape_map_(std::move(shape_map)) {}
+
+absl::StatusOr<Tensor> CordCheckpointReader::GetTensor(
+    const std::string& name) const {
+  auto it = metadata_.find(name);
+  if (it == metadata_.end()) {
+    return absl::NotFoundError(
+        absl::StrFormat("Checkpoint doesn't have tensor %s", name));
+  }
+  std::unique_ptr<tf::table::Iterator> iterator(table_->NewIterator());
+  TFF_ASSIGN_OR_RETURN(tf::SavedTensorSlices saved_tensor_slices,
+                       ReadSavedTensorSlices(*iterator, it->second.key));
+  // The values of a slice are stored without their data type and shape,
+  // which are only recorded in the checkpoint metadata.
+  tf::TensorProto* tensor_proto =
+      saved_tensor_slices.mutable_data()->mutable_data();
+  tensor_proto->set_dtype(it->second.dtype);
+  *tensor_proto->mutable_tensor_shape() = it->second.shape;
+  return ToAggTensor(std::move(*tensor_proto));
+}
+
+}  // namespace tensorflow_federated::aggregation::tensorflow
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_TENSORFLOW_CORD_CHECKPOINT_READER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_TENSORFLOW_CORD_CHECKPOINT_READER_H_
+
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/lib/io/table.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
+
+namespace tensorflow_federated::aggregation::tensorflow {
+
+// Reads a TensorFlow checkpoint in the TensorSlice format, as written by
+// tf.raw_ops.Save and CheckpointWriter, directly from an absl::Cord without
+// going through a filesystem.
+//
+// Only the checkpoint metadata is parsed when the reader is created. Each
+// tensor is decoded from the checkpoint when it is requested, and the blocks
+// of the checkpoint that lie within a single chunk of the Cord are read in
+// place rather than copied.
+//
+// Like CheckpointReader, this class only reads dense tensors that consist of
+// a single slice. Create returns an UNIMPLEMENTED error for checkpoints that
+// contain partitioned tensors.
+class CordCheckpointReader final {
+ public:
+  // CordCheckpointReader is neither copyable nor moveable.
+  CordCheckpointReader(const CordCheckpointReader&) = delete;
+  CordCheckpointReader& operator=(const CordCheckpointReader&) = delete;
+
+  using DataTypeMap = absl::flat_hash_map<std::string, DataType>;
+  using TensorShapeMap = absl::flat_hash_map<std::string, TensorShape>;
+
+  static absl::StatusOr<std::unique_ptr<CordCheckpointReader>> Create(
+      absl::Cord checkpoint);
+
+  const DataTypeMap& GetDataTypeMap() const { return data_type_map_; }
+  const TensorShapeMap& GetTensorShapeMap() const { return shape_map_; }
+
+  absl::StatusOr<Tensor> GetTensor(const std::string& name) const;
+
+ private:
+  // The TensorFlow metadata of a tensor, which isn't stored alongside its
+  // values in the checkpoint.
+  struct TensorMetadata {
+    ::tensorflow::DataType dtype;
+    ::tensorflow::TensorShapeProto shape;
+    // The key of the tensor values in the checkpoint table.
+    std::string key;
+  };
+
+  CordCheckpointReader(
+      std::unique_ptr<::tensorflow::RandomAccessFile> file,
+      std::unique_ptr<::tensorflow::table::Table> table,
+      absl::flat_hash_map<std::string, TensorMetadata> metadata,
+      DataTypeMap data_type_map, TensorShapeMap shape_map);
+
+  // The table reads blocks through the file, which must outlive it.
+  std::unique_ptr<::tensorflow::RandomAccessFile> file_;
+  std::unique_ptr<::tensorflow::table::Table> table_;
+  absl::flat_hash_map<std::string, TensorMetadata> metadata_;
+  DataTypeMap data_type_map_;
+  TensorShapeMap shape_map_;
+};
+
+}  // namespace tensorflow_federated::aggregation::tensorflow
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_AGGREGATION_TENSORFLOW_CORD_CHECKPOINT_READER_H_
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/cord_checkpoint_reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/platform.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated::aggregation::tensorflow {
+namespace {
+
+using ::testing::Key;
+using ::testing::UnorderedElementsAre;
+
+absl::Cord CreateTestCheckpoint() {
+  auto temp_filename = aggregation::TemporaryTestFile(".ckpt");
+  auto tensor_a =
+      CreateTfTensor<float>(tf::DT_FLOAT, {4}, {1.0, 2.0, 3.0, 4.0});
+  auto tensor_b =
+      CreateTfTensor<int32_t>(tf::DT_INT32, {2, 3}, {11, 12, 13, 14, 15, 16});
+  auto tensor_c = CreateStringTfTensor({}, {"foobar"});
+  TFF_CHECK(CreateTfCheckpoint(temp_filename, {"a", "b", "c"},
+                               {tensor_a, tensor_b, tensor_c})
+                .ok());
+  return ReadFileToCord(temp_filename).value();
+}
+
+// Splits the checkpoint into chunks of the given size, so that the reader has
+// to handle blocks spanning several chunks.
+absl::Cord Fragment(const absl::Cord& cord, size_t chunk_size) {
+  std::string flat(cord);
+  absl::Cord fragmented;
+  for (size_t offset = 0; offset < flat.size(); offset += chunk_size) {
+    std::string* chunk =
+        new std::string(flat.substr(offset, std::min(chunk_size,
+                                                      flat.size() - offset)));
+    fragmented.Append(absl::MakeCordFromExternal(
+        *chunk, [chunk](absl::string_view) { delete chunk; }));
+  }
+  return fragmented;
+}
+
+void VerifyTestCheckpoint(const CordCheckpointReader& reader) {
+  EXPECT_THAT(reader.GetDataTypeMap(),
+              UnorderedElementsAre(Key("a"), Key("b"), Key("c")));
+  EXPECT_THAT(reader.GetTensorShapeMap(),
+              UnorderedElementsAre(Key("a"), Key("b"), Key("c")));
+  EXPECT_THAT(*reader.GetTensor("a"),
+              IsTensor<float>({4}, {1.0, 2.0, 3.0, 4.0}));
+  EXPECT_THAT(*reader.GetTensor("b"),
+              IsTensor<int32_t>({2, 3}, {11, 12, 13, 14, 15, 16}));
+  EXPECT_THAT(*reader.GetTensor("c"), IsTensor<string_view>({}, {"foobar"}));
+}
+
+TEST(CordCheckpointReaderTest, ReadTensors) {
+  auto reader = CordCheckpointReader::Create(CreateTestCheckpoint());
+  ASSERT_OK(reader.status());
+  VerifyTestCheckpoint(**reader);
+}
+
+TEST(CordCheckpointReaderTest, ReadTensorsFromFragmentedCord) {
+  absl::Cord checkpoint = CreateTestCheckpoint();
+  for (size_t chunk_size : {1, 7, 64}) {
+    auto reader =
+        CordCheckpointReader::Create(Fragment(checkpoint, chunk_size));
+    ASSERT_OK(reader.status());
+    VerifyTestCheckpoint(**reader);
+  }
+}
+
+TEST(CordCheckpointReaderTest, MissingTensor) {
+  auto reader = CordCheckpointReader::Create(CreateTestCheckpoint());
+  ASSERT_OK(reader.status());
+  EXPECT_THAT((*reader)->GetTensor("d"), StatusIs(NOT_FOUND));
+}
+
+TEST(CordCheckpointReaderTest, MalformedCheckpoint) {
+  EXPECT_THAT(CordCheckpointReader::Create(absl::Cord("foobar")),
+              StatusIs(INTERNAL));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated::aggregation::tensorflow
@@ -83,6 +83,55 @@ class AggregationProtocolsTest(absltest.TestCase):
               file_pattern=tmpfile.name,
               tensor_name=output_tensor.name,
               dt=output_tensor.dtype), 8)
+    # The result buffer exposes the same bytes without copying them.
+    self.assertEqual(
+        bytes(memoryview(agg_protocol.GetResultBuffer())),
+        agg_protocol.GetResult(),
+    )
+
+  def test_receive_client_messages(self):
+    input_tensor = tensor_pb2.TensorSpecProto(
+        name='in', dtype=tensor_pb2.DT_INT32, shape={}
+    )
+    output_tensor = tensor_pb2.TensorSpecProto(
+        name='out', dtype=tensor_pb2.DT_INT32, shape={}
+    )
+    config = configuration_pb2.Configuration(
+        intrinsic_configs=[
+            configuration_pb2.Configuration.IntrinsicConfig(
+                intrinsic_uri='federated_sum',
+                intrinsic_args=[
+                    configuration_pb2.Configuration.IntrinsicConfig.IntrinsicArg(
+                        input_tensor=input_tensor
+                    ),
+                ],
+                output_tensors=[output_tensor],
+            ),
+        ]
+    )
+    agg_protocol = aggregation_protocols.create_simple_aggregation_protocol(
+        config
+    )
+
+    num_clients = 10
+    agg_protocol.Start(num_clients)
+    agg_protocol.ReceiveClientMessages(
+        [
+            (client_id, create_client_input({input_tensor.name: client_id}))
+            for client_id in range(num_clients)
+        ],
+        num_threads=4,
+    )
+
+    agg_protocol.Complete()
+    with tempfile.NamedTemporaryFile('wb') as tmpfile:
+      tmpfile.write(agg_protocol.GetResult())
+      tmpfile.flush()
+      self.assertEqual(
+          tf.raw_ops.Restore(
+              file_pattern=tmpfile.name,
+              tensor_name=output_tensor.name,
+              dt=output_tensor.dtype), 45)
 
 
 if __name__ == '__main__':
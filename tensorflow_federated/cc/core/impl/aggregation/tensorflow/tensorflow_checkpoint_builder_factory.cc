@@ -16,85 +16,246 @@
 
 #include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/tensorflow_checkpoint_builder_factory.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
-#include "absl/random/random.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
-#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/tensor_slice.h"
+#include "tensorflow/core/lib/io/table_builder.h"
+#include "tensorflow/core/lib/io/table_options.h"
 #include "tensorflow/core/platform/file_system.h"
-#include "tensorflow/tsl/platform/env.h"
+#include "tensorflow/core/public/version.h"
+#include "tensorflow/core/util/saved_tensor_slice.pb.h"
+#include "tensorflow/core/util/saved_tensor_slice_util.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/core/datatype.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
-#include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/checkpoint_writer.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/converters.h"
 
 namespace tensorflow_federated::aggregation::tensorflow {
 namespace {
 
-using tsl::Env;
+namespace tf = ::tensorflow;
 
-// A CheckpointBuilder implementation that builds TensorFlow checkpoints using a
-// CheckpointWriter.
-class TensorflowCheckpointBuilder : public CheckpointBuilder {
+// A file that appends everything written to it to a Cord.
+class CordWritableFile : public tf::WritableFile {
  public:
-  explicit TensorflowCheckpointBuilder(std::string filename)
-      : filename_(std::move(filename)) {}
+  explicit CordWritableFile(absl::Cord* cord) : cord_(cord) {}
+
+  absl::Status Append(absl::string_view data) override {
+    cord_->Append(data);
+    return absl::OkStatus();
+  }
+  absl::Status Close() override { return absl::OkStatus(); }
+  absl::Status Flush() override { return absl::OkStatus(); }
+  absl::Status Sync() override { return absl::OkStatus(); }
+  absl::Status Tell(int64_t* position) override {
+    *position = cord_->size();
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Cord* cord_;
+};
+
+// Sets the values of a TensorProto the same way TensorSliceWriter does, that
+// is without its data type and shape, which are part of the checkpoint
+// metadata.
+void SetValues(absl::Span<const float> values, tf::TensorProto* proto) {
+  proto->mutable_float_val()->Add(values.begin(), values.end());
+}
+void SetValues(absl::Span<const double> values, tf::TensorProto* proto) {
+  proto->mutable_double_val()->Add(values.begin(), values.end());
+}
+// Narrow integers are stored in `int_val`, as by tf::Tensor::AsProtoField.
+void SetValues(absl::Span<const int8_t> values, tf::TensorProto* proto) {
+  proto->mutable_int_val()->Add(values.begin(), values.end());
+}
+void SetValues(absl::Span<const uint8_t> values, tf::TensorProto* proto) {
+  proto->mutable_int_val()->Add(values.begin(), values.end());
+}
+void SetValues(absl::Span<const int32_t> values, tf::TensorProto* proto) {
+  proto->mutable_int_val()->Add(values.begin(), values.end());
+}
+void SetValues(absl::Span<const int64_t> values, tf::TensorProto* proto) {
+  proto->mutable_int64_val()->Add(values.begin(), values.end());
+}
+void SetValues(absl::Span<const uint64_t> values, tf::TensorProto* proto) {
+  proto->mutable_uint64_val()->Add(values.begin(), values.end());
+}
+void SetValues(absl::Span<const string_view> values, tf::TensorProto* proto) {
+  proto->mutable_string_val()->Reserve(values.size());
+  for (string_view value : values) {
+    proto->add_string_val(value.data(), value.size());
+  }
+}
+
+// Calls `fn(i)` for each i in [0, n). When `scheduler` isn't null, the calls
+// are made by up to `num_tasks` tasks, including the calling thread, all but
+// one of which are scheduled on `scheduler`. Returns once all calls are done.
+void ParallelFor(Scheduler* scheduler, int num_tasks, size_t n,
+                 const std::function<void(size_t)>& fn) {
+  size_t num_scheduled =
+      scheduler == nullptr || n <= 1
+          ? 0
+          : std::min<size_t>(std::max(num_tasks, 1) - 1, n - 1);
+  std::atomic<size_t> next = 0;
+  auto run = [&]() {
+    for (size_t i = next++; i < n; i = next++) {
+      fn(i);
+    }
+  };
+  absl::BlockingCounter done(num_scheduled);
+  for (size_t i = 0; i < num_scheduled; ++i) {
+    scheduler->Schedule([&]() {
+      run();
+      done.DecrementCount();
+    });
+  }
+  run();
+  done.Wait();
+}
 
-  ~TensorflowCheckpointBuilder() override {
-    Env::Default()->DeleteFile(filename_).IgnoreError();
+// A CheckpointBuilder implementation that builds TensorFlow checkpoints in the
+// TensorSlice format written by TensorSliceWriter, directly into a Cord.
+//
+// Tensors added by const reference are encoded right away. Tensors whose
+// ownership is transferred to the builder are encoded by Build, concurrently
+// when a scheduler is provided.
+class TensorflowCheckpointBuilder : public CheckpointBuilder {
+ public:
+  TensorflowCheckpointBuilder(Scheduler* scheduler, int num_tasks)
+      : scheduler_(scheduler), num_tasks_(num_tasks) {
+    tf::VersionDef* versions = metadata_.mutable_meta()->mutable_versions();
+    versions->set_producer(TF_CHECKPOINT_VERSION);
+    versions->set_min_consumer(TF_CHECKPOINT_VERSION_MIN_CONSUMER);
   }
 
   absl::Status Add(const std::string& name, const Tensor& tensor) override {
-    return writer_.Add(name, tensor);
+    TFF_RETURN_IF_ERROR(AddMetadata(name, tensor));
+    entries_.back().value = EncodeTensor(name, tensor);
+    return absl::OkStatus();
   }
 
-  absl::StatusOr<absl::Cord> Build() override {
-    TFF_RETURN_IF_ERROR(writer_.Finish());
+  absl::Status Add(const std::string& name, Tensor&& tensor) override {
+    TFF_RETURN_IF_ERROR(AddMetadata(name, tensor));
+    pending_.push_back({entries_.size() - 1, std::move(tensor)});
+    return absl::OkStatus();
+  }
 
-    // Read the checkpoints contents from the file.
-    std::unique_ptr<::tensorflow::RandomAccessFile> file;
-    TFF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(filename_, &file));
+  absl::StatusOr<absl::Cord> Build() override {
+    ParallelFor(scheduler_, num_tasks_, pending_.size(), [this](size_t i) {
+      Entry& entry = entries_[pending_[i].first];
+      entry.value = EncodeTensor(entry.name, pending_[i].second);
+      // Release the tensor as soon as it is encoded.
+      pending_[i].second = Tensor();
+    });
+    pending_.clear();
+    for (const Entry& entry : entries_) {
+      if (!entry.value.ok()) return entry.value.status();
+    }
 
+    // The table requires its keys in increasing order. The metadata key is
+    // empty and therefore comes first.
+    std::sort(entries_.begin(), entries_.end(),
+              [](const Entry& a, const Entry& b) { return a.key < b.key; });
     absl::Cord output;
-    for (;;) {
-      char scratch[4096];
-      absl::string_view read_result;
-      absl::Status status =
-          file->Read(output.size(), sizeof(scratch), &read_result, scratch);
-      output.Append(read_result);
-      if (status.code() == absl::StatusCode::kOutOfRange) {
-        return output;
-      } else if (!status.ok()) {
-        return status;
-      }
+    CordWritableFile file(&output);
+    tf::table::Options options;
+    options.compression = tf::table::kNoCompression;
+    tf::table::TableBuilder builder(options, &file);
+    builder.Add(tf::checkpoint::kSavedTensorSlicesKey,
+                metadata_.SerializeAsString());
+    for (const Entry& entry : entries_) {
+      builder.Add(entry.key, *entry.value);
     }
+    TFF_RETURN_IF_ERROR(builder.Finish());
+    return output;
   }
 
  private:
-  std::string filename_;
-  CheckpointWriter writer_{filename_};
+  struct Entry {
+    std::string name;
+    // The key of the tensor values in the table.
+    std::string key;
+    // The serialized SavedTensorSlices holding the tensor values.
+    absl::StatusOr<std::string> value;
+  };
+
+  // Records the metadata of a tensor spanning a single slice, and reserves
+  // its entry.
+  absl::Status AddMetadata(const std::string& name, const Tensor& tensor) {
+    if (!tensor.is_dense()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "Only dense tensors with one slice are supported";
+    }
+    if (!names_.insert(name).second) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "Tensor " << name << " was already added to the checkpoint";
+    }
+    TFF_ASSIGN_OR_RETURN(tf::DataType dtype, ToTfDataType(tensor.dtype()));
+    tf::SavedSliceMeta* meta = metadata_.mutable_meta()->add_tensor();
+    meta->set_name(name);
+    meta->set_type(dtype);
+    for (int64_t dim_size : tensor.shape().dim_sizes()) {
+      meta->mutable_shape()->add_dim()->set_size(dim_size);
+    }
+    tf::TensorSlice slice(tensor.shape().dim_sizes().size());
+    slice.AsProto(meta->add_slice());
+    std::string key = tf::checkpoint::EncodeTensorNameSlice(name, slice);
+    entries_.push_back({name, std::move(key), std::string()});
+    return absl::OkStatus();
+  }
+
+  static absl::StatusOr<std::string> EncodeTensor(const std::string& name,
+                                                  const Tensor& tensor) {
+    tf::SavedTensorSlices saved_tensor_slices;
+    tf::SavedSlice* saved_slice = saved_tensor_slices.mutable_data();
+    saved_slice->set_name(name);
+    tf::TensorSlice(tensor.shape().dim_sizes().size())
+        .AsProto(saved_slice->mutable_slice());
+    DTYPE_CASES(tensor.dtype(), T,
+                SetValues(tensor.AsSpan<T>(), saved_slice->mutable_data()));
+    if (saved_tensor_slices.ByteSizeLong() >
+        std::numeric_limits<int32_t>::max()) {
+      return TFF_STATUS(INVALID_ARGUMENT)
+             << "Tensor " << name << " is too large to serialize";
+    }
+    return saved_tensor_slices.SerializeAsString();
+  }
+
+  Scheduler* const scheduler_;
+  const int num_tasks_;
+  tf::SavedTensorSlices metadata_;
+  absl::flat_hash_set<std::string> names_;
+  std::vector<Entry> entries_;
+  // Tensors to be encoded by Build, with the index of their entry.
+  std::vector<std::pair<size_t, Tensor>> pending_;
 };
 
 }  // namespace
 
 std::unique_ptr<CheckpointBuilder> TensorflowCheckpointBuilderFactory::Create()
     const {
-  // Create a (likely) unique filename in Tensorflow's RamFileSystem. This
-  // results in a second in-memory copy of the data but avoids disk I/O.
-  std::string filename =
-      absl::StrCat("ram://",
-                   absl::Hex(absl::Uniform(
-                       absl::BitGen(), 0, std::numeric_limits<int64_t>::max())),
-                   ".ckpt");
-
-  return std::make_unique<TensorflowCheckpointBuilder>(std::move(filename));
+  return std::make_unique<TensorflowCheckpointBuilder>(scheduler_, num_tasks_);
 }
 
 }  // namespace tensorflow_federated::aggregation::tensorflow
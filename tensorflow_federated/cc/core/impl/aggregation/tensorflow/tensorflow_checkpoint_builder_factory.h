@@ -19,16 +19,33 @@
 
 #include <memory>
 
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_builder.h"
 
 namespace tensorflow_federated::aggregation::tensorflow {
 
 // A CheckpointBuilderFactory implementation that writes TensorFlow checkpoints.
+// Checkpoints are encoded directly into the returned Cord, without going
+// through a file.
 class TensorflowCheckpointBuilderFactory
     : public tensorflow_federated::aggregation::CheckpointBuilderFactory {
  public:
+  TensorflowCheckpointBuilderFactory() = default;
+
+  // Creates a factory whose builders encode the tensors added to them by
+  // value concurrently when building the checkpoint, using up to `num_tasks`
+  // tasks, including the thread calling Build, all but one of which are
+  // scheduled on `scheduler`. `scheduler` must outlive the builders. A null
+  // `scheduler` or `num_tasks` <= 1 disables parallelism.
+  TensorflowCheckpointBuilderFactory(Scheduler* scheduler, int num_tasks)
+      : scheduler_(scheduler), num_tasks_(num_tasks) {}
+
   std::unique_ptr<tensorflow_federated::aggregation::CheckpointBuilder> Create()
       const override;
+
+ private:
+  Scheduler* scheduler_ = nullptr;
+  int num_tasks_ = 1;
 };
 
 }  // namespace tensorflow_federated::aggregation::tensorflow
@@ -18,12 +18,14 @@
 
 #include <cstdint>
 #include <memory>
+#include <utility>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/scheduler.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/mutable_vector_data.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor_shape.h"
@@ -35,7 +37,9 @@ namespace tensorflow_federated::aggregation::tensorflow {
 namespace {
 
 using ::testing::AllOf;
+using ::testing::Contains;
 using ::testing::Each;
+using ::testing::Key;
 using ::testing::Pair;
 using ::testing::SizeIs;
 using ::testing::StartsWith;
@@ -112,5 +116,48 @@ TEST(TensorflowCheckpointBuilderFactoryTest, LargeCheckpoint) {
                                           StartsWith("0 0 0 0 0 0 0 0 0")))));
 }
 
+TEST(TensorflowCheckpointBuilderFactoryTest, ParallelBuild) {
+  auto scheduler = CreateThreadPoolScheduler(4);
+  TensorflowCheckpointBuilderFactory factory(scheduler.get(), 4);
+  std::unique_ptr<CheckpointBuilder> builder = factory.Create();
+
+  absl::StatusOr<Tensor> t = Tensor::Create(
+      DT_FLOAT, TensorShape({2}), CreateTestData<float>({1.0, 2.0}));
+  ASSERT_OK(t.status());
+  EXPECT_OK(builder->Add("const", *t));
+  for (int i = 0; i < 20; ++i) {
+    absl::StatusOr<Tensor> moved =
+        Tensor::Create(DT_INT64, TensorShape({2}),
+                       CreateTestData<int64_t>({i, i + 1}));
+    ASSERT_OK(moved.status());
+    EXPECT_OK(builder->Add(absl::StrCat("t", i), std::move(*moved)));
+  }
+  absl::StatusOr<Tensor> s = Tensor::Create(
+      DT_STRING, TensorShape({2}), CreateTestData<string_view>({"a", "bc"}));
+  ASSERT_OK(s.status());
+  EXPECT_OK(builder->Add("s", std::move(*s)));
+
+  absl::StatusOr<absl::Cord> checkpoint = builder->Build();
+  ASSERT_OK(checkpoint.status());
+  scheduler->WaitUntilIdle();
+  auto summary = SummarizeCheckpoint(*checkpoint);
+  ASSERT_OK(summary.status());
+  EXPECT_THAT(*summary, SizeIs(22));
+  EXPECT_THAT(*summary, Contains(Pair("const", "1 2")));
+  EXPECT_THAT(*summary, Contains(Pair("t0", "0 1")));
+  EXPECT_THAT(*summary, Contains(Pair("t19", "19 20")));
+  EXPECT_THAT(*summary, Contains(Key("s")));
+}
+
+TEST(TensorflowCheckpointBuilderFactoryTest, DuplicateTensorName) {
+  TensorflowCheckpointBuilderFactory factory;
+  std::unique_ptr<CheckpointBuilder> builder = factory.Create();
+  absl::StatusOr<Tensor> t = Tensor::Create(
+      DT_FLOAT, TensorShape({2}), CreateTestData<float>({1.0, 2.0}));
+  ASSERT_OK(t.status());
+  EXPECT_OK(builder->Add("t", *t));
+  EXPECT_FALSE(builder->Add("t", *t).ok());
+}
+
 }  // namespace
 }  // namespace tensorflow_federated::aggregation::tensorflow
@@ -24,6 +24,7 @@
 
 #include "absl/cleanup/cleanup.h"
 #include "absl/random/random.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
@@ -33,13 +34,31 @@
 #include "tensorflow_federated/cc/core/impl/aggregation/base/monitoring.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/core/tensor.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/compressed_checkpoint.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/checkpoint_reader.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/tensorflow/cord_checkpoint_reader.h"
 
 namespace tensorflow_federated::aggregation::tensorflow {
 namespace {
 
 using ::tensorflow::Env;
 
+// A CheckpointParser implementation that reads TensorFlow checkpoints directly
+// from memory using a CordCheckpointReader.
+class CordTensorflowCheckpointParser : public CheckpointParser {
+ public:
+  explicit CordTensorflowCheckpointParser(
+      std::unique_ptr<CordCheckpointReader> reader)
+      : reader_(std::move(reader)) {}
+
+  absl::StatusOr<Tensor> GetTensor(const std::string& name) override {
+    return reader_->GetTensor(name);
+  }
+
+ private:
+  std::unique_ptr<CordCheckpointReader> reader_;
+};
+
 // A CheckpointParser implementation that reads TensorFlow checkpoints using a
 // CheckpointReader.
 class TensorflowCheckpointParser : public CheckpointParser {
@@ -66,6 +85,24 @@ class TensorflowCheckpointParser : public CheckpointParser {
 absl::StatusOr<std::unique_ptr<CheckpointParser>>
 TensorflowCheckpointParserFactory::Create(
     const absl::Cord& serialized_checkpoint) const {
+  if (IsCompressedCheckpoint(serialized_checkpoint)) {
+    TFF_ASSIGN_OR_RETURN(absl::Cord checkpoint,
+                         DecompressCheckpoint(serialized_checkpoint));
+    return Create(checkpoint);
+  }
+  // Most checkpoints can be read without copying them to a file first.
+  // Checkpoints with partitioned tensors, which CordCheckpointReader doesn't
+  // support, are read by the TensorFlow checkpoint reader instead.
+  absl::StatusOr<std::unique_ptr<CordCheckpointReader>> cord_reader =
+      CordCheckpointReader::Create(serialized_checkpoint);
+  if (cord_reader.ok()) {
+    return std::make_unique<CordTensorflowCheckpointParser>(
+        *std::move(cord_reader));
+  }
+  if (cord_reader.status().code() != absl::StatusCode::kUnimplemented) {
+    return cord_reader.status();
+  }
+
   // Create a (likely) unique filename in Tensorflow's RamFileSystem. This
   // results in a second in-memory copy of the data but avoids disk I/O.
   std::string filename =
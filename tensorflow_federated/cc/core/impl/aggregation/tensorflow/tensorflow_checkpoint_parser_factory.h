@@ -26,6 +26,8 @@
 namespace tensorflow_federated::aggregation::tensorflow {
 
 // A CheckpointParserFactory implementation that reads TensorFlow checkpoints.
+// Checkpoints wrapped in a compression envelope are decompressed first, see
+// DecompressCheckpoint.
 class TensorflowCheckpointParserFactory
     : public tensorflow_federated::aggregation::CheckpointParserFactory {
  public:
@@ -25,6 +25,7 @@
 #include "absl/strings/cord.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/base/platform.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/protocol/checkpoint_parser.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/protocol/compressed_checkpoint.h"
 #include "tensorflow_federated/cc/core/impl/aggregation/testing/testing.h"
 
 namespace tensorflow_federated::aggregation::tensorflow {
@@ -51,6 +52,23 @@ TEST(TensorflowCheckpointParserFactoryTest, ReadCheckpoint) {
   EXPECT_FALSE((*parser)->GetTensor("t3").ok());
 }
 
+TEST(TensorflowCheckpointParserFactoryTest, ReadCompressedCheckpoint) {
+  std::string filename = aggregation::TemporaryTestFile(".ckpt");
+  ASSERT_OK(CreateTfCheckpoint(filename, {"t1"}, {{1.0f, 2.0f}}));
+  absl::StatusOr<absl::Cord> checkpoint = ReadFileToCord(filename);
+  ASSERT_OK(checkpoint.status());
+  absl::StatusOr<absl::Cord> compressed = CompressCheckpoint(*checkpoint);
+  ASSERT_OK(compressed.status());
+
+  TensorflowCheckpointParserFactory factory;
+  absl::StatusOr<std::unique_ptr<CheckpointParser>> parser =
+      factory.Create(*compressed);
+  ASSERT_OK(parser.status());
+  auto t1 = (*parser)->GetTensor("t1");
+  ASSERT_OK(t1.status());
+  EXPECT_THAT(*t1, IsTensor<float>({2}, {1.0, 2.0}));
+}
+
 TEST(TensorflowCheckpointParserFactoryTest, InvalidCheckpoint) {
   TensorflowCheckpointParserFactory factory;
   EXPECT_FALSE(factory.Create(absl::Cord("invalid")).ok());
@@ -46,6 +46,7 @@ class MockCheckpointParserFactory : public CheckpointParserFactory {
 
 class MockCheckpointBuilder : public CheckpointBuilder {
  public:
+  using CheckpointBuilder::Add;
   MOCK_METHOD(absl::Status, Add,
               (const std::string& name, const Tensor& tensor), (override));
   MOCK_METHOD(absl::StatusOr<absl::Cord>, Build, (), (override));
@@ -22,6 +22,7 @@
 #include <initializer_list>
 #include <ostream>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -124,7 +125,12 @@ void DescribeTensor(::std::ostream* os, DataType dtype, TensorShape shape,
     if (insert_comma) {
       *os << ", ";
     }
-    *os << v;
+    if constexpr (std::is_integral_v<T> && sizeof(T) == 1) {
+      // Print narrow integers as numbers rather than characters.
+      *os << static_cast<int>(v);
+    } else {
+      *os << v;
+    }
     insert_comma = true;
   }
   *os << "}}";
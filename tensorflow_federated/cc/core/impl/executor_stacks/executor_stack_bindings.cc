@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License
 ==============================================================================*/
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -24,6 +25,7 @@ limitations under the License
 #include "pybind11_abseil/status_casters.h"
 #include "tensorflow_federated/cc/core/impl/executor_stacks/remote_stacks.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 
 namespace tensorflow_federated {
 
@@ -31,18 +33,64 @@ namespace py = ::pybind11;
 
 namespace {
 
+// The bulk channels of each worker of a remote stack.
+using BulkChannels =
+    std::vector<std::vector<std::shared_ptr<grpc::ChannelInterface>>>;
+
 PYBIND11_MODULE(executor_stack_bindings, m) {
-  m.def("create_remote_executor_stack",
-        py::overload_cast<
-            const std::vector<std::shared_ptr<grpc::ChannelInterface>>&,
-            const CardinalityMap&>(&CreateRemoteExecutorStack),
-        "Creates a C++ remote execution stack.");
-
-  m.def("create_streaming_remote_executor_stack",
-        py::overload_cast<
-            const std::vector<std::shared_ptr<grpc::ChannelInterface>>&,
-            const CardinalityMap&>(&CreateStreamingRemoteExecutorStack),
-        "Creates a C++ streaming remote execution stack.");
+  m.def(
+      "create_remote_executor_stack",
+      [](const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+         const CardinalityMap& cardinalities, int32_t max_fan_out,
+         bool balance_clients_by_throughput, const BulkChannels& bulk_channels,
+         bool assign_clients_by_locality) {
+        return CreateRemoteExecutorStack(
+            channels, cardinalities, ThreadPoolPolicy::kSingleQueue,
+            max_fan_out, balance_clients_by_throughput, bulk_channels,
+            assign_clients_by_locality);
+      },
+      py::arg("channels"), py::arg("cardinalities"),
+      py::arg("max_fan_out") = 0,
+      py::arg("balance_clients_by_throughput") = false,
+      py::arg("bulk_channels") = BulkChannels(),
+      py::arg("assign_clients_by_locality") = false,
+      "Creates a C++ remote execution stack.");
+
+  m.def(
+      "create_streaming_remote_executor_stack",
+      [](const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+         const CardinalityMap& cardinalities, int32_t max_fan_out,
+         bool balance_clients_by_throughput, bool use_value_cache,
+         bool assign_clients_by_locality) {
+        return CreateStreamingRemoteExecutorStack(
+            channels, cardinalities, ThreadPoolPolicy::kSingleQueue,
+            max_fan_out, balance_clients_by_throughput, use_value_cache,
+            assign_clients_by_locality);
+      },
+      py::arg("channels"), py::arg("cardinalities"),
+      py::arg("max_fan_out") = 0,
+      py::arg("balance_clients_by_throughput") = false,
+      py::arg("use_value_cache") = false,
+      py::arg("assign_clients_by_locality") = false,
+      "Creates a C++ streaming remote execution stack.");
+
+  m.def(
+      "create_dynamic_remote_executor_stack",
+      [](const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+         const CardinalityMap& cardinalities, int32_t max_fan_out,
+         bool balance_clients_by_throughput,
+         int32_t max_rebuilds_per_materialize) {
+        return CreateDynamicRemoteExecutorStack(
+            channels, cardinalities, ThreadPoolPolicy::kSingleQueue,
+            max_fan_out, balance_clients_by_throughput,
+            max_rebuilds_per_materialize);
+      },
+      py::arg("channels"), py::arg("cardinalities"),
+      py::arg("max_fan_out") = 0,
+      py::arg("balance_clients_by_throughput") = false,
+      py::arg("max_rebuilds_per_materialize") = 3,
+      "Creates a C++ remote execution stack which follows the connectivity of "
+      "its workers.");
 }
 
 }  // namespace
@@ -13,36 +13,129 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executor_stacks/local_stacks.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/composing_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/federating_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/memoizing_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/reference_resolving_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/sequence_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/session_provider.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/tensorflow_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 
 namespace tensorflow_federated {
 
+namespace {
+
+using LeafExecutorFn =
+    std::function<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>;
+
+// Returns the leaf executor created by calling `leaf_executor_fn` with
+// `leaf_arg`, wrapped to memoize its calls if `memoization` is set.
+absl::StatusOr<std::shared_ptr<Executor>> CreateLeafExecutor(
+    const LeafExecutorFn& leaf_executor_fn,
+    const std::optional<MemoizingExecutorOptions>& memoization,
+    int32_t leaf_arg = -1) {
+  std::shared_ptr<Executor> leaf = TFF_TRY(leaf_executor_fn(leaf_arg));
+  if (memoization.has_value()) {
+    return CreateMemoizingExecutor(std::move(leaf), *memoization);
+  }
+  return leaf;
+}
+
+// Returns the stack which resolves references and sequences above `leaf`.
+std::shared_ptr<Executor> CreateLeafStack(std::shared_ptr<Executor> leaf) {
+  return CreateReferenceResolvingExecutor(CreateSequenceExecutor(
+      CreateReferenceResolvingExecutor(std::move(leaf))));
+}
+
+}  // namespace
+
 absl::StatusOr<std::shared_ptr<Executor>> CreateLocalExecutor(
     const CardinalityMap& cardinalities,
     std::function<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>
         leaf_executor_fn,
     std::function<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>
-        client_leaf_executor_fn) {
-  std::shared_ptr<Executor> server =
-      CreateReferenceResolvingExecutor(CreateSequenceExecutor(
-          CreateReferenceResolvingExecutor(TFF_TRY(leaf_executor_fn(-1)))));
+        client_leaf_executor_fn,
+    uint32_t aggregate_fan_in, int32_t max_concurrent_client_calls,
+    ThreadPoolPolicy thread_pool_policy,
+    std::optional<MemoizingExecutorOptions> leaf_memoization) {
+  std::shared_ptr<Executor> server = CreateLeafStack(
+      TFF_TRY(CreateLeafExecutor(leaf_executor_fn, leaf_memoization)));
   std::shared_ptr<Executor> client = server;
   if (client_leaf_executor_fn != nullptr) {
-    client = CreateReferenceResolvingExecutor(
-        CreateSequenceExecutor(CreateReferenceResolvingExecutor(
-            TFF_TRY(client_leaf_executor_fn(-1)))));
+    client = CreateLeafStack(
+        TFF_TRY(CreateLeafExecutor(client_leaf_executor_fn, leaf_memoization)));
   }
   return CreateReferenceResolvingExecutor(TFF_TRY(CreateFederatingExecutor(
-      /*server_child=*/server, /*client_child=*/client, cardinalities)));
+      /*server_child=*/server, /*client_child=*/client, cardinalities,
+      aggregate_fan_in, max_concurrent_client_calls, thread_pool_policy)));
+}
+
+absl::StatusOr<std::shared_ptr<Executor>> CreateTensorFlowDeviceExecutor(
+    int32_t device_index) {
+  SessionPoolOptions session_pool_options;
+  session_pool_options.device_index = device_index;
+  return CreateTensorFlowExecutor(
+      /*max_concurrent_computation_calls=*/-1,
+      kDefaultComputationCacheCapacityBytes, session_pool_options);
+}
+
+absl::StatusOr<std::shared_ptr<Executor>> CreateLocalMultiDeviceExecutor(
+    const CardinalityMap& cardinalities, int32_t num_devices,
+    std::function<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>
+        device_leaf_executor_fn,
+    uint32_t aggregate_fan_in, int32_t max_concurrent_client_calls,
+    ThreadPoolPolicy thread_pool_policy,
+    std::optional<MemoizingExecutorOptions> leaf_memoization) {
+  if (num_devices <= 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "A multi-device executor needs a positive number of devices, found ",
+        num_devices));
+  }
+  const int32_t num_clients =
+      TFF_TRY(NumClientsFromCardinalities(cardinalities));
+  const int32_t num_shards = std::max(1, std::min(num_devices, num_clients));
+  if (num_shards == 1) {
+    std::shared_ptr<Executor> device = CreateLeafStack(TFF_TRY(
+        CreateLeafExecutor(device_leaf_executor_fn, leaf_memoization, 0)));
+    return CreateReferenceResolvingExecutor(TFF_TRY(CreateFederatingExecutor(
+        /*server_child=*/device, /*client_child=*/device, cardinalities,
+        aggregate_fan_in, max_concurrent_client_calls, thread_pool_policy)));
+  }
+  std::shared_ptr<Executor> server = CreateLeafStack(TFF_TRY(
+      CreateLeafExecutor(device_leaf_executor_fn, leaf_memoization, 0)));
+  std::vector<ComposingChild> children;
+  children.reserve(num_shards);
+  for (int32_t i = 0; i < num_shards; ++i) {
+    CardinalityMap device_cardinalities = cardinalities;
+    device_cardinalities.insert_or_assign(
+        kClientsUri,
+        num_clients / num_shards + (i < num_clients % num_shards ? 1 : 0));
+    std::shared_ptr<Executor> device = CreateLeafStack(TFF_TRY(
+        CreateLeafExecutor(device_leaf_executor_fn, leaf_memoization, i)));
+    std::shared_ptr<Executor> federating =
+        CreateReferenceResolvingExecutor(TFF_TRY(CreateFederatingExecutor(
+            /*server_child=*/device, /*client_child=*/device,
+            device_cardinalities, aggregate_fan_in,
+            max_concurrent_client_calls, thread_pool_policy)));
+    children.push_back(
+        TFF_TRY(ComposingChild::Make(federating, device_cardinalities)));
+  }
+  return CreateReferenceResolvingExecutor(CreateComposingExecutor(
+      std::move(server), std::move(children), thread_pool_policy));
 }
 }  // namespace tensorflow_federated
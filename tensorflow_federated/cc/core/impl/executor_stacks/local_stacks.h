@@ -19,11 +19,14 @@ limitations under the License
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 
 #include "absl/status/statusor.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/memoizing_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensorflow_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 
 namespace tensorflow_federated {
 
@@ -39,6 +42,18 @@ namespace tensorflow_federated {
 // If client_leaf_executor_fn is unspecified, the executor constructed from
 // leaf_executor_fn will be used for both server side and client side
 // computations.
+//
+// `aggregate_fan_in` is forwarded to the `FederatingExecutor`; values of two or
+// more enable a tree-structured reduction of `federated_aggregate` in which
+// client shards are accumulated in parallel and combined using `merge`.
+//
+// `max_concurrent_client_calls` and `thread_pool_policy` configure the thread
+// pool the `FederatingExecutor` uses to dispatch per-client calls; see
+// `CreateFederatingExecutor`.
+//
+// If `leaf_memoization` is set, each leaf executor is wrapped in a
+// `MemoizingExecutor` with these options, so that calls of the computations it
+// marks deterministic are not repeated on content-identical arguments.
 
 // Returns an absl::Status if construction fails, and a shared_ptr to an
 // instance of Executor if construction succeeds.
@@ -47,6 +62,38 @@ absl::StatusOr<std::shared_ptr<Executor>> CreateLocalExecutor(
     std::function<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>
         leaf_executor_fn = CreateTensorFlowExecutor,
     std::function<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>
-        client_leaf_executor_fn = nullptr);
+        client_leaf_executor_fn = nullptr,
+    uint32_t aggregate_fan_in = 0, int32_t max_concurrent_client_calls = -1,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    std::optional<MemoizingExecutorOptions> leaf_memoization = std::nullopt);
+
+// Returns a `TensorFlowExecutor` whose sessions place their kernels on the
+// accelerator device `device_index`, modulo the number of devices.
+absl::StatusOr<std::shared_ptr<Executor>> CreateTensorFlowDeviceExecutor(
+    int32_t device_index);
+
+// Constructs a local executor stack which shards the clients across
+// `num_devices` devices, e.g. the GPUs of the host.
+//
+// `device_leaf_executor_fn` is called with the index of each device to create
+// the leaf executor for it. Each device executes the client-placed
+// computations of its shard of the clients in a stack of its own, under a
+// `ComposingExecutor` whose server executes unplaced and server-placed
+// computations on a leaf executor of device 0. Clients are split evenly
+// across the devices, and there are at most as many devices as clients.
+//
+// Broadcast and other all-equal client values are created once per device
+// rather than once per client, and are reused by the following rounds while
+// cached by the `ComposingExecutor`.
+//
+// The other arguments configure the stack of each device as for
+// `CreateLocalExecutor`.
+absl::StatusOr<std::shared_ptr<Executor>> CreateLocalMultiDeviceExecutor(
+    const CardinalityMap& cardinalities, int32_t num_devices,
+    std::function<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>
+        device_leaf_executor_fn = CreateTensorFlowDeviceExecutor,
+    uint32_t aggregate_fan_in = 0, int32_t max_concurrent_client_calls = -1,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    std::optional<MemoizingExecutorOptions> leaf_memoization = std::nullopt);
 }  // namespace tensorflow_federated
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTOR_STACKS_LOCAL_STACKS_H_
@@ -15,17 +15,22 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executor_stacks/local_stacks.h"
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/memoizing_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
 
 using testing::MockFunction;
 using testing::Return;
@@ -58,4 +63,55 @@ TEST_F(LocalStacksTest, CustomLeafExecutorForClientIsCalled) {
   TFF_EXPECT_OK(CreateLocalExecutor(cards_, mock_executor_fn.AsStdFunction(),
                                     mock_executor_fn.AsStdFunction()));
 }
+
+TEST_F(LocalStacksTest, CreatesExecutorWithAggregateFanIn) {
+  MockFunction<absl::StatusOr<std::shared_ptr<Executor>>(std::optional<int>)>
+      mock_executor_fn;
+  EXPECT_CALL(mock_executor_fn, Call(::testing::_))
+      .WillOnce(Return(test_executor_));
+  TFF_EXPECT_OK(CreateLocalExecutor(cards_, mock_executor_fn.AsStdFunction(),
+                                    /*client_leaf_executor_fn=*/nullptr,
+                                    /*aggregate_fan_in=*/8));
+}
+
+TEST_F(LocalStacksTest, CreatesExecutorWithLeafMemoization) {
+  MockFunction<absl::StatusOr<std::shared_ptr<Executor>>(std::optional<int>)>
+      mock_executor_fn;
+  EXPECT_CALL(mock_executor_fn, Call(::testing::_))
+      .WillOnce(Return(test_executor_));
+  MemoizingExecutorOptions memoization;
+  memoization.is_deterministic = [](const v0::Computation&) { return true; };
+  TFF_EXPECT_OK(CreateLocalExecutor(
+      cards_, mock_executor_fn.AsStdFunction(),
+      /*client_leaf_executor_fn=*/nullptr, /*aggregate_fan_in=*/0,
+      /*max_concurrent_client_calls=*/-1, ThreadPoolPolicy::kSingleQueue,
+      memoization));
+}
+
+TEST_F(LocalStacksTest, MultiDeviceExecutorCreatesLeafExecutorPerDevice) {
+  MockFunction<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>
+      mock_executor_fn;
+  // The server runs on device 0 as well.
+  EXPECT_CALL(mock_executor_fn, Call(0))
+      .Times(2)
+      .WillRepeatedly(Return(test_executor_));
+  EXPECT_CALL(mock_executor_fn, Call(1)).WillOnce(Return(test_executor_));
+  EXPECT_CALL(mock_executor_fn, Call(2)).WillOnce(Return(test_executor_));
+  TFF_EXPECT_OK(CreateLocalMultiDeviceExecutor(
+      {{std::string(kClientsUri), 10}}, /*num_devices=*/3,
+      mock_executor_fn.AsStdFunction()));
+}
+
+TEST_F(LocalStacksTest, MultiDeviceExecutorUsesAtMostOneDevicePerClient) {
+  MockFunction<absl::StatusOr<std::shared_ptr<Executor>>(int32_t)>
+      mock_executor_fn;
+  EXPECT_CALL(mock_executor_fn, Call(0)).WillOnce(Return(test_executor_));
+  TFF_EXPECT_OK(CreateLocalMultiDeviceExecutor(
+      cards_, /*num_devices=*/8, mock_executor_fn.AsStdFunction()));
+}
+
+TEST_F(LocalStacksTest, MultiDeviceExecutorRequiresDevices) {
+  EXPECT_THAT(CreateLocalMultiDeviceExecutor(cards_, /*num_devices=*/0),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
 }  // namespace tensorflow_federated
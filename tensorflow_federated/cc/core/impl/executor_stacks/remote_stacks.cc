@@ -15,26 +15,40 @@ limitations under the License
 #include "tensorflow_federated/cc/core/impl/executor_stacks/remote_stacks.h"
 
 #include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "include/grpcpp/grpcpp.h"
+#include "tensorflow_federated/cc/core/impl/executor_stacks/worker_throughputs.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/composing_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/federating_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/rebuilding_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/reference_resolving_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/remote_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/streaming_remote_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensorflow_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
 
 namespace tensorflow_federated {
 // This function queries the state of the incoming channels, filtering to those
@@ -81,46 +95,193 @@ std::vector<std::shared_ptr<grpc::ChannelInterface>> FilterToLiveChannels_(
   }
   return live_channels;
 }
-absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStack(
-    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
-    const CardinalityMap& cardinalities) {
-  auto rre_tf_leaf_executor = []() {
-    return CreateReferenceResolvingExecutor(CreateTensorFlowExecutor());
-  };
-  ComposingChildFn composing_child_factory =
-      [](std::shared_ptr<grpc::ChannelInterface> channel,
-         const CardinalityMap& cardinalities)
-      -> absl::StatusOr<ComposingChild> {
-    return TFF_TRY(ComposingChild::Make(
-        CreateRemoteExecutor(channel, cardinalities), cardinalities));
-  };
 
-  return CreateRemoteExecutorStack(
-      channels, cardinalities, rre_tf_leaf_executor, composing_child_factory);
+namespace {
+
+// How long a worker is waited for to return its locality keys.
+constexpr std::chrono::milliseconds kLocalityKeysTimeout(1000);
+
+// Returns the locality keys advertised by the worker of `channel`, or none if
+// the worker does not answer, e.g. since it predates `GetLocalityKeys`.
+std::vector<std::string> FetchLocalityKeys(
+    const std::shared_ptr<grpc::ChannelInterface>& channel) {
+  std::unique_ptr<v0::ExecutorGroup::Stub> stub =
+      v0::ExecutorGroup::NewStub(channel);
+  grpc::ClientContext context;
+  context.set_deadline(std::chrono::system_clock::now() +
+                       kLocalityKeysTimeout);
+  v0::GetLocalityKeysRequest request;
+  v0::GetLocalityKeysResponse response;
+  grpc::Status status = stub->GetLocalityKeys(&context, request, &response);
+  if (!status.ok()) {
+    VLOG(1) << "TFF worker did not return its locality keys: "
+            << status.error_message();
+    return {};
+  }
+  return std::vector<std::string>(response.locality_keys().begin(),
+                                  response.locality_keys().end());
 }
 
-absl::StatusOr<std::shared_ptr<Executor>> CreateStreamingRemoteExecutorStack(
-    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
-    const CardinalityMap& cardinalities) {
-  auto rre_tf_leaf_executor = []() {
-    return CreateReferenceResolvingExecutor(CreateTensorFlowExecutor());
-  };
-  ComposingChildFn composing_child_factory =
-      [](std::shared_ptr<grpc::ChannelInterface> channel,
-         const CardinalityMap& cardinalities)
-      -> absl::StatusOr<ComposingChild> {
-    return TFF_TRY(ComposingChild::Make(
-        CreateStreamingRemoteExecutor(channel, cardinalities), cardinalities));
-  };
+// An executor which forwards to the executor of a remote worker, recording the
+// throughput of the worker in `WorkerThroughputs::Global()`.
+//
+// The work of a round starts with the first call after the previous
+// materialization and ends when a value is materialized, since the worker
+// computes the calls asynchronously until a value is required.
+class ThroughputRecordingExecutor : public Executor {
+ public:
+  ThroughputRecordingExecutor(std::shared_ptr<Executor> executor,
+                              const grpc::ChannelInterface* worker,
+                              int num_clients)
+      : executor_(std::move(executor)),
+        worker_(worker),
+        num_clients_(num_clients) {}
+
+  absl::StatusOr<OwnedValueId> CreateValue(const v0::Value& value_pb) final {
+    return executor_->CreateValue(value_pb);
+  }
 
-  return CreateRemoteExecutorStack(
-      channels, cardinalities, rre_tf_leaf_executor, composing_child_factory);
+  absl::StatusOr<OwnedValueId> CreateCall(
+      const ValueId function,
+      const std::optional<const ValueId> argument) final {
+    {
+      absl::MutexLock lock(&mutex_);
+      if (!round_start_.has_value()) {
+        round_start_ = absl::Now();
+      }
+    }
+    return executor_->CreateCall(function, argument);
+  }
+
+  absl::StatusOr<OwnedValueId> CreateStruct(
+      const absl::Span<const ValueId> members) final {
+    return executor_->CreateStruct(members);
+  }
+
+  absl::StatusOr<OwnedValueId> CreateSelection(const ValueId source,
+                                               const uint32_t index) final {
+    return executor_->CreateSelection(source, index);
+  }
+
+  absl::Status Materialize(const ValueId value, v0::Value* value_pb) final {
+    absl::Time start = absl::Now();
+    TFF_TRY(executor_->Materialize(value, value_pb));
+    {
+      absl::MutexLock lock(&mutex_);
+      if (round_start_.has_value()) {
+        start = *round_start_;
+        round_start_.reset();
+      }
+    }
+    WorkerThroughputs::Global().Record(worker_, num_clients_,
+                                       absl::Now() - start);
+    return absl::OkStatus();
+  }
+
+  absl::Status Dispose(const ValueId value) final {
+    return executor_->Dispose(value);
+  }
+
+  absl::Status DisposeBatch(absl::Span<const ValueId> values) final {
+    return executor_->DisposeBatch(values);
+  }
+
+ private:
+  const std::shared_ptr<Executor> executor_;
+  const grpc::ChannelInterface* const worker_;
+  const int num_clients_;
+  absl::Mutex mutex_;
+  std::optional<absl::Time> round_start_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns a composing executor with `server` over the workers of `channels`,
+// where the worker of `channels[i]` serves `clients_per_channel[i]` clients.
+//
+// If `max_fan_out` is positive and there are more channels than that, the
+// channels are split into `max_fan_out` groups of consecutive channels, each
+// composed by a nested composing executor with a server created by
+// `leaf_executor_fn`. Nesting continues until no composing executor has more
+// than `max_fan_out` children.
+//
+// If `record_throughputs` is true, the throughputs of the workers are recorded
+// in `WorkerThroughputs::Global()`.
+//
+// The locality keys of the children created by `composing_child_fn` are
+// appended to `locality_keys_out`, so that a nested composing executor has
+// the keys of the workers it composes.
+absl::StatusOr<std::shared_ptr<Executor>> CreateComposingTree(
+    std::shared_ptr<Executor> server,
+    absl::Span<const std::shared_ptr<grpc::ChannelInterface>> channels,
+    absl::Span<const int> clients_per_channel,
+    const CardinalityMap& cardinalities, const ExecutorFn& leaf_executor_fn,
+    const ComposingChildFn& composing_child_fn, int32_t max_fan_out,
+    ThreadPoolPolicy thread_pool_policy, bool record_throughputs,
+    std::vector<std::string>& locality_keys_out) {
+  std::vector<ComposingChild> children;
+  if (max_fan_out <= 0 || channels.size() <= static_cast<size_t>(max_fan_out)) {
+    for (size_t i = 0; i < channels.size(); ++i) {
+      CardinalityMap cardinalities_for_executor = cardinalities;
+      cardinalities_for_executor.insert_or_assign(kClientsUri,
+                                                  clients_per_channel[i]);
+      ComposingChild child =
+          TFF_TRY(composing_child_fn(channels[i], cardinalities_for_executor));
+      if (record_throughputs) {
+        child = TFF_TRY(ComposingChild::Make(
+            std::make_shared<ThroughputRecordingExecutor>(
+                child.executor(), channels[i].get(), clients_per_channel[i]),
+            cardinalities_for_executor, child.locality_keys()));
+      }
+      locality_keys_out.insert(locality_keys_out.end(),
+                               child.locality_keys().begin(),
+                               child.locality_keys().end());
+      children.emplace_back(std::move(child));
+    }
+  } else {
+    int remaining_num_channels = channels.size();
+    int remaining_num_groups = max_fan_out;
+    while (remaining_num_groups > 0) {
+      int channels_for_group = remaining_num_channels / remaining_num_groups;
+      size_t group_start = channels.size() - remaining_num_channels;
+      absl::Span<const int> clients_per_channel_for_group =
+          clients_per_channel.subspan(group_start, channels_for_group);
+      int clients_for_group = 0;
+      for (int clients : clients_per_channel_for_group) {
+        clients_for_group += clients;
+      }
+      CardinalityMap cardinalities_for_group = cardinalities;
+      cardinalities_for_group.insert_or_assign(kClientsUri, clients_for_group);
+      std::shared_ptr<Executor> group_server = TFF_TRY(leaf_executor_fn());
+      std::vector<std::string> group_locality_keys;
+      std::shared_ptr<Executor> group = CreateReferenceResolvingExecutor(
+          TFF_TRY(CreateComposingTree(
+              std::move(group_server),
+              channels.subspan(group_start, channels_for_group),
+              clients_per_channel_for_group, cardinalities_for_group,
+              leaf_executor_fn, composing_child_fn, max_fan_out,
+              thread_pool_policy, record_throughputs, group_locality_keys)));
+      locality_keys_out.insert(locality_keys_out.end(),
+                               group_locality_keys.begin(),
+                               group_locality_keys.end());
+      children.emplace_back(TFF_TRY(ComposingChild::Make(
+          group, cardinalities_for_group, std::move(group_locality_keys))));
+      remaining_num_channels -= channels_for_group;
+      remaining_num_groups -= 1;
+    }
+  }
+  return CreateComposingExecutor(std::move(server), std::move(children),
+                                 thread_pool_policy);
 }
 
-absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStack(
+// Implements the `CreateRemoteExecutorStack` overload for testing, and stores
+// the channels of the workers addressed by the stack in `live_channels_out` if
+// it is not null.
+absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStackImpl(
     const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
-    const CardinalityMap& cardinalities, ExecutorFn leaf_executor_fn,
-    ComposingChildFn composing_child_fn) {
+    const CardinalityMap& cardinalities, const ExecutorFn& leaf_executor_fn,
+    const ComposingChildFn& composing_child_fn,
+    ThreadPoolPolicy thread_pool_policy, int32_t max_fan_out,
+    bool balance_clients_by_throughput,
+    std::vector<std::shared_ptr<grpc::ChannelInterface>>* live_channels_out) {
   int num_clients = 0;
   auto cards_iterator = cardinalities.find(kClientsUri);
   if (cards_iterator != cardinalities.end()) {
@@ -138,7 +299,8 @@ absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStack(
     // executor.
     return CreateReferenceResolvingExecutor(TFF_TRY(CreateFederatingExecutor(
         /*server_child=*/server, /*client_child=*/server,
-        federated_cardinalities)));
+        federated_cardinalities, /*aggregate_fan_in=*/0,
+        /*max_concurrent_client_calls=*/-1, thread_pool_policy)));
   } else if (channels.empty()) {
     return absl::InvalidArgumentError(absl::StrCat(
         "A remote executor stack with nonzero number of clients must be "
@@ -148,25 +310,194 @@ absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStack(
 
   const std::vector<std::shared_ptr<grpc::ChannelInterface>> live_channels =
       FilterToLiveChannels_(channels);
-  int remaining_num_executors = live_channels.size();
   if (live_channels.empty()) {
     return absl::UnavailableError(
         "No TFF workers are ready; try again to reconnect");
   }
-  std::vector<ComposingChild> remote_executors;
-  for (const std::shared_ptr<grpc::ChannelInterface>& channel : live_channels) {
-    int clients_for_executor = remaining_clients / remaining_num_executors;
-    CardinalityMap cardinalities_for_executor = cardinalities;
-    cardinalities_for_executor.insert_or_assign(kClientsUri,
-                                                clients_for_executor);
-    remote_executors.emplace_back(
-        TFF_TRY(composing_child_fn(channel, cardinalities_for_executor)));
-    remaining_clients -= clients_for_executor;
-    remaining_num_executors -= 1;
-  }
-  VLOG(2) << "Addressing: " << remote_executors.size() << " Live TFF workers.";
-  return CreateReferenceResolvingExecutor(
-      CreateComposingExecutor(server, remote_executors));
+  VLOG(2) << "Addressing: " << live_channels.size() << " Live TFF workers.";
+  if (live_channels_out != nullptr) {
+    *live_channels_out = live_channels;
+  }
+  std::vector<double> throughputs(live_channels.size(), 1);
+  if (balance_clients_by_throughput) {
+    throughputs = WorkerThroughputs::Global().Throughputs(live_channels);
+  }
+  const std::vector<int> clients_per_channel =
+      SplitClients(num_clients, throughputs);
+  std::vector<std::string> locality_keys;
+  return CreateReferenceResolvingExecutor(TFF_TRY(CreateComposingTree(
+      std::move(server), live_channels, clients_per_channel, cardinalities,
+      leaf_executor_fn, composing_child_fn, max_fan_out, thread_pool_policy,
+      /*record_throughputs=*/balance_clients_by_throughput, locality_keys)));
+}
+
+}  // namespace
+
+absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStack(
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+    const CardinalityMap& cardinalities, ThreadPoolPolicy thread_pool_policy,
+    int32_t max_fan_out, bool balance_clients_by_throughput,
+    const std::vector<std::vector<std::shared_ptr<grpc::ChannelInterface>>>&
+        bulk_channels,
+    bool assign_clients_by_locality) {
+  if (!bulk_channels.empty() && bulk_channels.size() != channels.size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected a list of bulk channels for each of the ", channels.size(),
+        " channels, found ", bulk_channels.size(), " lists."));
+  }
+  auto rre_tf_leaf_executor = []() {
+    return CreateReferenceResolvingExecutor(CreateTensorFlowExecutor());
+  };
+  // The live channels are a subset of `channels`, so the bulk channels of a
+  // worker are looked up by its channel.
+  auto bulk_channels_by_channel = std::make_shared<absl::flat_hash_map<
+      const grpc::ChannelInterface*,
+      std::vector<std::shared_ptr<grpc::ChannelInterface>>>>();
+  for (size_t i = 0; i < bulk_channels.size(); ++i) {
+    bulk_channels_by_channel->emplace(channels[i].get(), bulk_channels[i]);
+  }
+  ComposingChildFn composing_child_factory =
+      [bulk_channels_by_channel, assign_clients_by_locality](
+          std::shared_ptr<grpc::ChannelInterface> channel,
+          const CardinalityMap& cardinalities)
+      -> absl::StatusOr<ComposingChild> {
+    std::vector<std::string> locality_keys;
+    if (assign_clients_by_locality) {
+      locality_keys = FetchLocalityKeys(channel);
+    }
+    auto worker_bulk_channels = bulk_channels_by_channel->find(channel.get());
+    if (worker_bulk_channels == bulk_channels_by_channel->end()) {
+      return TFF_TRY(ComposingChild::Make(
+          CreateRemoteExecutor(channel, cardinalities), cardinalities,
+          std::move(locality_keys)));
+    }
+    return TFF_TRY(ComposingChild::Make(
+        CreateRemoteExecutor(channel, worker_bulk_channels->second,
+                             cardinalities),
+        cardinalities, std::move(locality_keys)));
+  };
+
+  return CreateRemoteExecutorStack(channels, cardinalities,
+                                   rre_tf_leaf_executor,
+                                   composing_child_factory, thread_pool_policy,
+                                   max_fan_out, balance_clients_by_throughput);
+}
+
+absl::StatusOr<std::shared_ptr<Executor>> CreateStreamingRemoteExecutorStack(
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+    const CardinalityMap& cardinalities, ThreadPoolPolicy thread_pool_policy,
+    int32_t max_fan_out, bool balance_clients_by_throughput,
+    bool use_value_cache, bool assign_clients_by_locality) {
+  auto rre_tf_leaf_executor = []() {
+    return CreateReferenceResolvingExecutor(CreateTensorFlowExecutor());
+  };
+  StreamingRemoteExecutorOptions options;
+  options.use_value_cache = use_value_cache;
+  ComposingChildFn composing_child_factory =
+      [options, assign_clients_by_locality](
+          std::shared_ptr<grpc::ChannelInterface> channel,
+          const CardinalityMap& cardinalities)
+      -> absl::StatusOr<ComposingChild> {
+    std::vector<std::string> locality_keys;
+    if (assign_clients_by_locality) {
+      locality_keys = FetchLocalityKeys(channel);
+    }
+    return TFF_TRY(ComposingChild::Make(
+        CreateStreamingRemoteExecutor(channel, cardinalities, options),
+        cardinalities, std::move(locality_keys)));
+  };
+
+  return CreateRemoteExecutorStack(channels, cardinalities,
+                                   rre_tf_leaf_executor,
+                                   composing_child_factory, thread_pool_policy,
+                                   max_fan_out, balance_clients_by_throughput);
+}
+
+absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStack(
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+    const CardinalityMap& cardinalities, ExecutorFn leaf_executor_fn,
+    ComposingChildFn composing_child_fn, ThreadPoolPolicy thread_pool_policy,
+    int32_t max_fan_out, bool balance_clients_by_throughput) {
+  return CreateRemoteExecutorStackImpl(
+      channels, cardinalities, leaf_executor_fn, composing_child_fn,
+      thread_pool_policy, max_fan_out, balance_clients_by_throughput,
+      /*live_channels_out=*/nullptr);
+}
+
+absl::StatusOr<std::shared_ptr<Executor>> CreateDynamicRemoteExecutorStack(
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+    const CardinalityMap& cardinalities, ThreadPoolPolicy thread_pool_policy,
+    int32_t max_fan_out, bool balance_clients_by_throughput,
+    int32_t max_rebuilds_per_materialize) {
+  auto rre_tf_leaf_executor = []() {
+    return CreateReferenceResolvingExecutor(CreateTensorFlowExecutor());
+  };
+  ComposingChildFn composing_child_factory =
+      [](std::shared_ptr<grpc::ChannelInterface> channel,
+         const CardinalityMap& cardinalities)
+      -> absl::StatusOr<ComposingChild> {
+    return TFF_TRY(ComposingChild::Make(
+        CreateRemoteExecutor(channel, cardinalities), cardinalities));
+  };
+
+  return CreateDynamicRemoteExecutorStack(
+      channels, cardinalities, rre_tf_leaf_executor, composing_child_factory,
+      thread_pool_policy, max_fan_out, balance_clients_by_throughput,
+      max_rebuilds_per_materialize);
+}
+
+absl::StatusOr<std::shared_ptr<Executor>> CreateDynamicRemoteExecutorStack(
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+    const CardinalityMap& cardinalities, ExecutorFn leaf_executor_fn,
+    ComposingChildFn composing_child_fn, ThreadPoolPolicy thread_pool_policy,
+    int32_t max_fan_out, bool balance_clients_by_throughput,
+    int32_t max_rebuilds_per_materialize) {
+  // The workers addressed by the current stack. Both functions below are only
+  // called while the rebuilding executor holds its lock.
+  auto members =
+      std::make_shared<absl::flat_hash_set<const grpc::ChannelInterface*>>();
+  auto create_stack = [=]() -> absl::StatusOr<std::shared_ptr<Executor>> {
+    std::vector<std::shared_ptr<grpc::ChannelInterface>> live_channels;
+    std::shared_ptr<Executor> stack = TFF_TRY(CreateRemoteExecutorStackImpl(
+        channels, cardinalities, leaf_executor_fn, composing_child_fn,
+        thread_pool_policy, max_fan_out, balance_clients_by_throughput,
+        &live_channels));
+    members->clear();
+    for (const std::shared_ptr<grpc::ChannelInterface>& channel :
+         live_channels) {
+      members->insert(channel.get());
+    }
+    return stack;
+  };
+  // Stacks without clients address no workers.
+  auto clients = cardinalities.find(kClientsUri);
+  const bool has_clients =
+      clients != cardinalities.end() && clients->second > 0;
+  // Workers which are connecting are not counted as changes, so that idle
+  // channels which reconnect do not rebuild the stack.
+  auto stack_outdated = [channels, members, has_clients]() {
+    if (!has_clients) {
+      return false;
+    }
+    for (const std::shared_ptr<grpc::ChannelInterface>& channel : channels) {
+      grpc_connectivity_state state =
+          channel->GetState(/*try_to_connect=*/true);
+      if (members->contains(channel.get())) {
+        if (state == GRPC_CHANNEL_TRANSIENT_FAILURE ||
+            state == GRPC_CHANNEL_SHUTDOWN) {
+          VLOG(1) << "A TFF worker went down, rebuilding the executor stack.";
+          return true;
+        }
+      } else if (state == GRPC_CHANNEL_READY) {
+        VLOG(1) << "A TFF worker came up, rebuilding the executor stack.";
+        return true;
+      }
+    }
+    return false;
+  };
+  return CreateRebuildingExecutor(std::move(create_stack),
+                                  std::move(stack_outdated),
+                                  max_rebuilds_per_materialize);
 }
 
 }  // namespace tensorflow_federated
@@ -16,6 +16,7 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTOR_STACKS_REMOTE_STACKS_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTOR_STACKS_REMOTE_STACKS_H_
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -25,6 +26,7 @@ limitations under the License
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/composing_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 
 namespace tensorflow_federated {
 
@@ -50,15 +52,60 @@ using ComposingChildFn = std::function<absl::StatusOr<ComposingChild>(
 //
 // This method may block on an RPC call to each channel in order to verify that
 // it is healthy.
+//
+// `thread_pool_policy` selects the scheduling policy of the thread pools owned
+// by the executors in the returned stack.
+//
+// If `max_fan_out` is positive, the stack is a tree of composing executors in
+// which no composing executor has more than `max_fan_out` children, so that
+// the dispatch of calls to the workers and the merge of their results are
+// spread over the executors of the tree. The intermediate composing executors
+// run in this process; to run them in separate processes instead, address
+// workers started with `--peer_workers` (see `simulation/worker_main.cc`),
+// each of which composes its peers.
+//
+// By default the clients are split evenly across the workers. If
+// `balance_clients_by_throughput` is true, they are split in proportion to the
+// throughput of each worker observed by the stacks created before this one
+// (see `WorkerThroughputs`), so that faster workers serve more clients, and
+// the throughputs observed by the returned stack are recorded for the stacks
+// created after it.
+//
+// If `bulk_channels` is not empty, it holds one list per channel of
+// `channels`: `bulk_channels[i]` are further channels to the worker of
+// `channels[i]`, each over a connection of its own, across which the large
+// transfers to and from the worker are striped, while `channels[i]` is kept
+// for the control requests (see `CreateRemoteExecutor`).
+//
+// If `assign_clients_by_locality` is true, the workers are asked for the
+// prefixes of the data URIs which are local to them (see `--locality_keys` in
+// `simulation/worker_main.cc`), and the clients of each value are assigned to
+// the workers which have their data when possible, rather than in order (see
+// `CreateComposingExecutor`). Workers which do not answer are assigned clients
+// in order.
 absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStack(
     const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
-    const CardinalityMap& cardinalities);
+    const CardinalityMap& cardinalities,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    int32_t max_fan_out = 0, bool balance_clients_by_throughput = false,
+    const std::vector<std::vector<std::shared_ptr<grpc::ChannelInterface>>>&
+        bulk_channels = {},
+    bool assign_clients_by_locality = false);
 
 // Creates an executor stack with StreamingRemoteExecutors, otherwise the same
 // as `CreateRemoteExecutorStack` above.
+//
+// If `use_value_cache` is true, large tensors are first sent to the workers as
+// their content hash alone (see `StreamingRemoteExecutorOptions`). Workers
+// started with `--value_cache_peers` then fetch the tensors they do not have
+// from their peers, so that a value broadcast to all workers is only sent to
+// the few workers which have no peers, rather than once per worker.
 absl::StatusOr<std::shared_ptr<Executor>> CreateStreamingRemoteExecutorStack(
     const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
-    const CardinalityMap& cardinalities);
+    const CardinalityMap& cardinalities,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    int32_t max_fan_out = 0, bool balance_clients_by_throughput = false,
+    bool use_value_cache = false, bool assign_clients_by_locality = false);
 
 // Creates an executor stack which proxies for a group of remote workers.
 //
@@ -67,7 +114,45 @@ absl::StatusOr<std::shared_ptr<Executor>> CreateStreamingRemoteExecutorStack(
 absl::StatusOr<std::shared_ptr<Executor>> CreateRemoteExecutorStack(
     const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
     const CardinalityMap& cardinalities, ExecutorFn leaf_executor_fn,
-    ComposingChildFn composing_child_fn);
+    ComposingChildFn composing_child_fn,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    int32_t max_fan_out = 0, bool balance_clients_by_throughput = false);
+
+// Creates an executor stack which proxies for a group of remote workers, like
+// `CreateRemoteExecutorStack`, but whose set of workers follows the
+// connectivity of `channels` rather than being fixed at construction.
+//
+// Before each materialization, the stack checks the state of the channels. If
+// a worker of the stack went down, or a worker outside of the stack came up,
+// the stack is rebuilt over the workers which are now healthy, and the clients
+// are split across them. If materializing a value fails since a worker is
+// unavailable, the stack is rebuilt as well, and the value is materialized
+// again up to `max_rebuilds_per_materialize` times. The clients of a worker
+// which went down are hence re-dispatched to the remaining workers rather than
+// failing the round.
+//
+// Values created in a replaced stack are recreated in the new stack; see
+// `CreateRebuildingExecutor` for the requirements this places on the
+// computations.
+absl::StatusOr<std::shared_ptr<Executor>> CreateDynamicRemoteExecutorStack(
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+    const CardinalityMap& cardinalities,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    int32_t max_fan_out = 0, bool balance_clients_by_throughput = false,
+    int32_t max_rebuilds_per_materialize = 3);
+
+// Creates a dynamic executor stack which proxies for a group of remote
+// workers.
+//
+// This function is an overload for the above, intended to be used for testing.
+// See the documentation above for details.
+absl::StatusOr<std::shared_ptr<Executor>> CreateDynamicRemoteExecutorStack(
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& channels,
+    const CardinalityMap& cardinalities, ExecutorFn leaf_executor_fn,
+    ComposingChildFn composing_child_fn,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    int32_t max_fan_out = 0, bool balance_clients_by_throughput = false,
+    int32_t max_rebuilds_per_materialize = 3);
 
 }  // namespace tensorflow_federated
 
@@ -23,15 +23,21 @@ limitations under the License
 #include "googletest/include/gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "include/grpc/support/time.h"
 #include "include/grpcpp/grpcpp.h"
 #include "include/grpcpp/impl/call.h"
 #include "include/grpcpp/security/credentials.h"
+#include "tensorflow_federated/cc/core/impl/executor_stacks/worker_throughputs.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/composing_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
 
 using absl::StatusCode;
 using ::testing::AnyOfArray;
@@ -39,6 +45,7 @@ using ::testing::HasSubstr;
 using ::testing::MockFunction;
 using ::testing::Return;
 using ::testing::StrictMock;
+using ::tensorflow_federated::testing::TensorV;
 
 namespace tensorflow_federated {
 
@@ -103,6 +110,20 @@ TEST_F(RemoteExecutorStackTest, NoTargetsNonzeroClientsReturnsError) {
                        HasSubstr("Found 0 remote channels")));
 }
 
+TEST_F(RemoteExecutorStackTest, MismatchedBulkChannelsReturnsError) {
+  std::shared_ptr<grpc::ChannelInterface> channel = grpc::CreateChannel(
+      "localhost:8000", grpc::InsecureChannelCredentials());
+  absl::StatusOr<std::shared_ptr<Executor>> status_or_executor =
+      CreateRemoteExecutorStack(
+          {channel, channel}, {{std::string(kClientsUri), 1}},
+          ThreadPoolPolicy::kSingleQueue, /*max_fan_out=*/0,
+          /*balance_clients_by_throughput=*/false,
+          /*bulk_channels=*/{{channel}});
+  EXPECT_THAT(status_or_executor.status(),
+              StatusIs(StatusCode::kInvalidArgument,
+                       HasSubstr("bulk channels for each of the 2 channels")));
+}
+
 // Our implementation of filtering to live workers uses WaitForConnected, which
 // polls the mock methods GetState and WaitForStateChangeImpl.
 void ExpectCallsToFailedChannel(
@@ -245,4 +266,151 @@ TEST_F(RemoteExecutorStackTest, OneClientPassedToOnlyOneChild) {
   TFF_EXPECT_OK(status_or_executor);
 }
 
+TEST_F(RemoteExecutorStackTest, MaxFanOutNestsComposingExecutors) {
+  std::vector<std::shared_ptr<grpc::ChannelInterface>> channel_args;
+  for (int i = 0; i < 4; i++) {
+    auto mock_channel =
+        std::make_shared<StrictMock<MockGrpcChannelInterface>>();
+    EXPECT_CALL(*mock_channel, GetState(::testing::IsTrue()))
+        .Times(2)
+        .WillRepeatedly(Return(grpc_connectivity_state::GRPC_CHANNEL_READY));
+    EXPECT_CALL(*mock_channel, RegisterMethod(::testing::_))
+        .WillRepeatedly(Return(nullptr));
+    channel_args.emplace_back(mock_channel);
+  }
+
+  CardinalityMap one_client_cards = {{std::string(kClientsUri), 1}};
+  ComposingChild child = TFF_ASSERT_OK(
+      ComposingChild::Make(get_mock_executor(), one_client_cards));
+
+  // With a fan out of two, the four workers are split into two groups, each
+  // with their own composing executor. We expect one server for the root of
+  // the tree, and one for each group.
+  EXPECT_CALL(mock_executor_factory_, Call())
+      .Times(3)
+      .WillRepeatedly(Return(get_mock_executor()));
+  EXPECT_CALL(mock_composing_child_factory_,
+              Call(AnyOfArray(channel_args), one_client_cards))
+      .Times(4)
+      .WillRepeatedly(Return(child));
+
+  absl::StatusOr<std::shared_ptr<Executor>> status_or_executor =
+      CreateRemoteExecutorStack(channel_args, {{std::string(kClientsUri), 4}},
+                                mock_executor_factory_.AsStdFunction(),
+                                mock_composing_child_factory_.AsStdFunction(),
+                                ThreadPoolPolicy::kSingleQueue,
+                                /*max_fan_out=*/2);
+  TFF_EXPECT_OK(status_or_executor);
+}
+
+TEST_F(RemoteExecutorStackTest, BalancesClientsByObservedThroughput) {
+  std::vector<std::shared_ptr<grpc::ChannelInterface>> channel_args;
+  for (int i = 0; i < 2; i++) {
+    auto mock_channel =
+        std::make_shared<StrictMock<MockGrpcChannelInterface>>();
+    EXPECT_CALL(*mock_channel, GetState(::testing::IsTrue()))
+        .Times(2)
+        .WillRepeatedly(Return(grpc_connectivity_state::GRPC_CHANNEL_READY));
+    EXPECT_CALL(*mock_channel, RegisterMethod(::testing::_))
+        .WillRepeatedly(Return(nullptr));
+    channel_args.emplace_back(mock_channel);
+  }
+  // The first worker was observed to be three times as fast as the second.
+  WorkerThroughputs::Global().Clear();
+  WorkerThroughputs::Global().Record(channel_args[0].get(), 30,
+                                     absl::Seconds(1));
+  WorkerThroughputs::Global().Record(channel_args[1].get(), 10,
+                                     absl::Seconds(1));
+
+  CardinalityMap three_client_cards = {{std::string(kClientsUri), 3}};
+  CardinalityMap one_client_cards = {{std::string(kClientsUri), 1}};
+  ComposingChild three_client_child = TFF_ASSERT_OK(
+      ComposingChild::Make(get_mock_executor(), three_client_cards));
+  ComposingChild one_client_child = TFF_ASSERT_OK(
+      ComposingChild::Make(get_mock_executor(), one_client_cards));
+
+  // The four clients are split in proportion to the observed throughputs.
+  EXPECT_CALL(mock_executor_factory_, Call())
+      .WillOnce(Return(get_mock_executor()));
+  EXPECT_CALL(mock_composing_child_factory_,
+              Call(channel_args[0], three_client_cards))
+      .WillOnce(Return(three_client_child));
+  EXPECT_CALL(mock_composing_child_factory_,
+              Call(channel_args[1], one_client_cards))
+      .WillOnce(Return(one_client_child));
+
+  absl::StatusOr<std::shared_ptr<Executor>> status_or_executor =
+      CreateRemoteExecutorStack(channel_args, {{std::string(kClientsUri), 4}},
+                                mock_executor_factory_.AsStdFunction(),
+                                mock_composing_child_factory_.AsStdFunction(),
+                                ThreadPoolPolicy::kSingleQueue,
+                                /*max_fan_out=*/0,
+                                /*balance_clients_by_throughput=*/true);
+  TFF_EXPECT_OK(status_or_executor);
+  WorkerThroughputs::Global().Clear();
+}
+
+TEST_F(RemoteExecutorStackTest, DynamicStackAdmitsWorkerWhichComesUp) {
+  auto up_channel = std::make_shared<StrictMock<MockGrpcChannelInterface>>();
+  EXPECT_CALL(*up_channel, GetState(::testing::IsTrue()))
+      .WillRepeatedly(Return(grpc_connectivity_state::GRPC_CHANNEL_READY));
+  EXPECT_CALL(*up_channel, RegisterMethod(::testing::_))
+      .WillRepeatedly(Return(nullptr));
+  bool late_channel_up = false;
+  auto late_channel = std::make_shared<StrictMock<MockGrpcChannelInterface>>();
+  EXPECT_CALL(*late_channel, GetState(::testing::IsTrue()))
+      .WillRepeatedly([&late_channel_up](bool) {
+        return late_channel_up
+                   ? grpc_connectivity_state::GRPC_CHANNEL_READY
+                   : grpc_connectivity_state::GRPC_CHANNEL_TRANSIENT_FAILURE;
+      });
+  EXPECT_CALL(*late_channel, WaitForStateChangeImpl(::testing::_, ::testing::_))
+      .WillRepeatedly(Return(false));
+  EXPECT_CALL(*late_channel, RegisterMethod(::testing::_))
+      .WillRepeatedly(Return(nullptr));
+  std::vector<std::shared_ptr<grpc::ChannelInterface>> channel_args = {
+      up_channel, late_channel};
+
+  CardinalityMap two_client_cards = {{std::string(kClientsUri), 2}};
+  CardinalityMap one_client_cards = {{std::string(kClientsUri), 1}};
+  ComposingChild two_client_child = TFF_ASSERT_OK(
+      ComposingChild::Make(get_mock_executor(), two_client_cards));
+  ComposingChild one_client_child = TFF_ASSERT_OK(
+      ComposingChild::Make(get_mock_executor(), one_client_cards));
+  auto first_server = std::make_shared<StrictMock<MockExecutor>>();
+  auto second_server = std::make_shared<StrictMock<MockExecutor>>();
+
+  // The first stack addresses the only live worker. Once the late worker comes
+  // up, the stack is rebuilt over both workers before the next
+  // materialization, which recreates the value in the new stack.
+  {
+    ::testing::InSequence seq;
+    EXPECT_CALL(mock_executor_factory_, Call()).WillOnce(Return(first_server));
+    EXPECT_CALL(mock_composing_child_factory_,
+                Call(channel_args[0], two_client_cards))
+        .WillOnce(Return(two_client_child));
+    EXPECT_CALL(mock_executor_factory_, Call()).WillOnce(Return(second_server));
+    EXPECT_CALL(mock_composing_child_factory_,
+                Call(channel_args[0], one_client_cards))
+        .WillOnce(Return(one_client_child));
+    EXPECT_CALL(mock_composing_child_factory_,
+                Call(channel_args[1], one_client_cards))
+        .WillOnce(Return(one_client_child));
+  }
+
+  v0::Value value = TensorV(1);
+  first_server->ExpectCreateValue(value);
+  second_server->ExpectCreateMaterialize(value);
+
+  std::shared_ptr<Executor> executor =
+      TFF_ASSERT_OK(CreateDynamicRemoteExecutorStack(
+          channel_args, two_client_cards,
+          mock_executor_factory_.AsStdFunction(),
+          mock_composing_child_factory_.AsStdFunction()));
+  OwnedValueId id = TFF_ASSERT_OK(executor->CreateValue(value));
+  late_channel_up = true;
+  v0::Value materialized = TFF_ASSERT_OK(executor->Materialize(id));
+  EXPECT_THAT(materialized, testing::EqualsProto(value));
+}
+
 }  // namespace tensorflow_federated
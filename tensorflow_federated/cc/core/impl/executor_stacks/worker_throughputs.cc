@@ -0,0 +1,107 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executor_stacks/worker_throughputs.h"
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "include/grpcpp/grpcpp.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// The weight of a new sample in the moving average of a worker's throughput.
+constexpr double kSampleWeight = 0.5;
+
+}  // namespace
+
+WorkerThroughputs& WorkerThroughputs::Global() {
+  static WorkerThroughputs* throughputs = new WorkerThroughputs();
+  return *throughputs;
+}
+
+void WorkerThroughputs::Record(const grpc::ChannelInterface* worker,
+                               int num_clients, absl::Duration elapsed) {
+  double seconds = absl::ToDoubleSeconds(elapsed);
+  if (num_clients <= 0 || seconds <= 0) {
+    return;
+  }
+  double sample = num_clients / seconds;
+  absl::MutexLock lock(&mutex_);
+  auto [it, inserted] = throughputs_.try_emplace(worker, sample);
+  if (!inserted) {
+    it->second = kSampleWeight * sample + (1 - kSampleWeight) * it->second;
+  }
+}
+
+std::vector<double> WorkerThroughputs::Throughputs(
+    absl::Span<const std::shared_ptr<grpc::ChannelInterface>> workers) {
+  std::vector<double> throughputs(workers.size(), 0);
+  double known_sum = 0;
+  int num_known = 0;
+  {
+    absl::MutexLock lock(&mutex_);
+    for (size_t i = 0; i < workers.size(); ++i) {
+      auto it = throughputs_.find(workers[i].get());
+      if (it != throughputs_.end()) {
+        throughputs[i] = it->second;
+        known_sum += it->second;
+        num_known += 1;
+      }
+    }
+  }
+  double unknown_throughput = num_known > 0 ? known_sum / num_known : 1;
+  for (double& throughput : throughputs) {
+    if (throughput == 0) {
+      throughput = unknown_throughput;
+    }
+  }
+  return throughputs;
+}
+
+void WorkerThroughputs::Clear() {
+  absl::MutexLock lock(&mutex_);
+  throughputs_.clear();
+}
+
+std::vector<int> SplitClients(int num_clients,
+                              absl::Span<const double> throughputs) {
+  std::vector<int> clients(throughputs.size(), 0);
+  double remaining_throughput = 0;
+  for (double throughput : throughputs) {
+    remaining_throughput += throughput;
+  }
+  int remaining_clients = num_clients;
+  for (size_t i = 0; i < throughputs.size(); ++i) {
+    if (i + 1 == throughputs.size()) {
+      clients[i] = remaining_clients;
+      break;
+    }
+    clients[i] = static_cast<int>(
+        std::floor(remaining_clients * throughputs[i] / remaining_throughput));
+    remaining_clients -= clients[i];
+    remaining_throughput -= throughputs[i];
+  }
+  return clients;
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,70 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTOR_STACKS_WORKER_THROUGHPUTS_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTOR_STACKS_WORKER_THROUGHPUTS_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "include/grpcpp/grpcpp.h"
+
+namespace tensorflow_federated {
+
+// Tracks the throughput of remote workers, in clients per second, as observed
+// over previous rounds. Each worker is identified by its channel.
+//
+// This class is thread safe.
+class WorkerThroughputs {
+ public:
+  // Returns the throughputs shared by all remote stacks of this process, so
+  // that stacks created for later rounds see the rounds before them.
+  static WorkerThroughputs& Global();
+
+  // Records that `worker` took `elapsed` to produce a value for `num_clients`
+  // clients. The estimated throughput of the worker is an exponential moving
+  // average of these samples, so that it follows changes in its load.
+  void Record(const grpc::ChannelInterface* worker, int num_clients,
+              absl::Duration elapsed);
+
+  // Returns the estimated throughput of each of `workers`. Workers without
+  // samples are assumed to be as fast as the mean of the others, and all
+  // workers have a throughput of 1 if none has samples.
+  std::vector<double> Throughputs(
+      absl::Span<const std::shared_ptr<grpc::ChannelInterface>> workers);
+
+  // Forgets all samples.
+  void Clear();
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<const grpc::ChannelInterface*, double> throughputs_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// Splits `num_clients` clients across workers in proportion to their positive
+// `throughputs`. Equal throughputs split the clients evenly, with the workers
+// later in the list taking the remainder.
+std::vector<int> SplitClients(int num_clients,
+                              absl::Span<const double> throughputs);
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTOR_STACKS_WORKER_THROUGHPUTS_H_
@@ -0,0 +1,108 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executor_stacks/worker_throughputs.h"
+
+#include <memory>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/grpcpp.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Returns channels to `num_workers` workers. The channels never connect,
+// they only identify the workers.
+std::vector<std::shared_ptr<grpc::ChannelInterface>> CreateChannels(
+    int num_workers) {
+  std::vector<std::shared_ptr<grpc::ChannelInterface>> channels;
+  for (int i = 0; i < num_workers; ++i) {
+    channels.push_back(grpc::CreateChannel(
+        "localhost:0", grpc::InsecureChannelCredentials()));
+  }
+  return channels;
+}
+
+TEST(WorkerThroughputsTest, UnknownWorkersHaveUnitThroughput) {
+  WorkerThroughputs throughputs;
+  EXPECT_THAT(throughputs.Throughputs(CreateChannels(2)), ElementsAre(1, 1));
+}
+
+TEST(WorkerThroughputsTest, RecordsClientsPerSecond) {
+  WorkerThroughputs throughputs;
+  auto channels = CreateChannels(2);
+  throughputs.Record(channels[0].get(), 10, absl::Seconds(2));
+  throughputs.Record(channels[1].get(), 10, absl::Seconds(1));
+  EXPECT_THAT(throughputs.Throughputs(channels), ElementsAre(5, 10));
+}
+
+TEST(WorkerThroughputsTest, AveragesSamples) {
+  WorkerThroughputs throughputs;
+  auto channels = CreateChannels(1);
+  throughputs.Record(channels[0].get(), 10, absl::Seconds(1));
+  throughputs.Record(channels[0].get(), 20, absl::Seconds(1));
+  EXPECT_THAT(throughputs.Throughputs(channels), ElementsAre(15));
+}
+
+TEST(WorkerThroughputsTest, UnknownWorkersHaveMeanThroughput) {
+  WorkerThroughputs throughputs;
+  auto channels = CreateChannels(3);
+  throughputs.Record(channels[0].get(), 2, absl::Seconds(1));
+  throughputs.Record(channels[1].get(), 4, absl::Seconds(1));
+  EXPECT_THAT(throughputs.Throughputs(channels), ElementsAre(2, 4, 3));
+}
+
+TEST(WorkerThroughputsTest, IgnoresEmptySamples) {
+  WorkerThroughputs throughputs;
+  auto channels = CreateChannels(2);
+  throughputs.Record(channels[0].get(), 0, absl::Seconds(1));
+  throughputs.Record(channels[1].get(), 4, absl::ZeroDuration());
+  EXPECT_THAT(throughputs.Throughputs(channels), ElementsAre(1, 1));
+}
+
+TEST(WorkerThroughputsTest, ClearForgetsSamples) {
+  WorkerThroughputs throughputs;
+  auto channels = CreateChannels(1);
+  throughputs.Record(channels[0].get(), 10, absl::Seconds(1));
+  throughputs.Clear();
+  EXPECT_THAT(throughputs.Throughputs(channels), ElementsAre(1));
+}
+
+TEST(SplitClientsTest, EqualThroughputsSplitEvenly) {
+  EXPECT_THAT(SplitClients(10, {1, 1, 1}), ElementsAre(3, 3, 4));
+  EXPECT_THAT(SplitClients(1, {1, 1, 1}), ElementsAre(0, 0, 1));
+}
+
+TEST(SplitClientsTest, SplitsInProportionToThroughputs) {
+  EXPECT_THAT(SplitClients(12, {1, 2, 3}), ElementsAre(2, 4, 6));
+  EXPECT_THAT(SplitClients(10, {3, 1}), ElementsAre(7, 3));
+}
+
+TEST(SplitClientsTest, AssignsAllClients) {
+  std::vector<int> clients = SplitClients(101, {0.3, 1.7, 2.9, 0.1});
+  int num_clients = 0;
+  for (int c : clients) {
+    num_clients += c;
+  }
+  EXPECT_EQ(num_clients, 101);
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
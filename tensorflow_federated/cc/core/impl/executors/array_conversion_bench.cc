@@ -0,0 +1,193 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/log/log.h"
+#include "absl/status/statusor.h"
+#include "include/benchmark/benchmark.h"
+#include "tensorflow/compiler/xla/literal.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow_federated/cc/core/impl/executors/tensorflow_utils.h"
+#include "tensorflow_federated/cc/core/impl/executors/xla_utils.h"
+#include "tensorflow_federated/proto/v0/array.pb.h"
+#include "tensorflow_federated/proto/v0/data_type.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+// The size of the elements of each `v0::DataType`, in bytes.
+int64_t ElementSize(v0::DataType dtype) {
+  switch (dtype) {
+    case v0::DataType::DT_BOOL:
+    case v0::DataType::DT_INT8:
+    case v0::DataType::DT_UINT8:
+    case v0::DataType::DT_STRING:
+      return 1;
+    case v0::DataType::DT_INT16:
+    case v0::DataType::DT_UINT16:
+    case v0::DataType::DT_HALF:
+      return 2;
+    case v0::DataType::DT_INT32:
+    case v0::DataType::DT_UINT32:
+    case v0::DataType::DT_FLOAT:
+      return 4;
+    case v0::DataType::DT_INT64:
+    case v0::DataType::DT_UINT64:
+    case v0::DataType::DT_DOUBLE:
+    case v0::DataType::DT_COMPLEX64:
+      return 8;
+    case v0::DataType::DT_COMPLEX128:
+      return 16;
+    default:
+      LOG(FATAL) << "Unexpected DataType found: " << dtype;
+  }
+}
+
+// Returns a one dimensional array of `num_elements` zeros, stored in the
+// repeated field of `dtype`, or in `content` if `use_content` is true.
+v0::Array CreateZerosArray(v0::DataType dtype, int64_t num_elements,
+                           bool use_content) {
+  v0::Array array_pb;
+  array_pb.set_dtype(dtype);
+  array_pb.mutable_shape()->add_dim(num_elements);
+  if (use_content) {
+    array_pb.set_content(std::string(num_elements * ElementSize(dtype), '\0'));
+    return array_pb;
+  }
+  switch (dtype) {
+    case v0::DataType::DT_BOOL:
+      array_pb.mutable_bool_list()->mutable_value()->Resize(num_elements,
+                                                            false);
+      break;
+    case v0::DataType::DT_INT8:
+      array_pb.mutable_int8_list()->mutable_value()->Resize(num_elements, 0);
+      break;
+    case v0::DataType::DT_INT16:
+      array_pb.mutable_int16_list()->mutable_value()->Resize(num_elements, 0);
+      break;
+    case v0::DataType::DT_INT32:
+      array_pb.mutable_int32_list()->mutable_value()->Resize(num_elements, 0);
+      break;
+    case v0::DataType::DT_INT64:
+      array_pb.mutable_int64_list()->mutable_value()->Resize(num_elements, 0);
+      break;
+    case v0::DataType::DT_UINT8:
+      array_pb.mutable_uint8_list()->mutable_value()->Resize(num_elements, 0);
+      break;
+    case v0::DataType::DT_UINT16:
+      array_pb.mutable_uint16_list()->mutable_value()->Resize(num_elements, 0);
+      break;
+    case v0::DataType::DT_UINT32:
+      array_pb.mutable_uint32_list()->mutable_value()->Resize(num_elements, 0);
+      break;
+    case v0::DataType::DT_UINT64:
+      array_pb.mutable_uint64_list()->mutable_value()->Resize(num_elements, 0);
+      break;
+    case v0::DataType::DT_HALF:
+      array_pb.mutable_float16_list()->mutable_value()->Resize(num_elements,
+                                                               0);
+      break;
+    case v0::DataType::DT_FLOAT:
+      array_pb.mutable_float32_list()->mutable_value()->Resize(num_elements,
+                                                               0);
+      break;
+    case v0::DataType::DT_DOUBLE:
+      array_pb.mutable_float64_list()->mutable_value()->Resize(num_elements,
+                                                               0);
+      break;
+    case v0::DataType::DT_COMPLEX64:
+      array_pb.mutable_complex64_list()->mutable_value()->Resize(
+          2 * num_elements, 0);
+      break;
+    case v0::DataType::DT_COMPLEX128:
+      array_pb.mutable_complex128_list()->mutable_value()->Resize(
+          2 * num_elements, 0);
+      break;
+    case v0::DataType::DT_STRING:
+      for (int64_t i = 0; i < num_elements; ++i) {
+        array_pb.mutable_string_list()->add_value("a");
+      }
+      break;
+    default:
+      LOG(FATAL) << "Unexpected DataType found: " << dtype;
+  }
+  return array_pb;
+}
+
+const std::vector<int64_t>& NumericDataTypes() {
+  static const std::vector<int64_t>* const dtypes = new std::vector<int64_t>({
+      v0::DataType::DT_BOOL,       v0::DataType::DT_INT8,
+      v0::DataType::DT_INT16,      v0::DataType::DT_INT32,
+      v0::DataType::DT_INT64,      v0::DataType::DT_UINT8,
+      v0::DataType::DT_UINT16,     v0::DataType::DT_UINT32,
+      v0::DataType::DT_UINT64,     v0::DataType::DT_HALF,
+      v0::DataType::DT_FLOAT,      v0::DataType::DT_DOUBLE,
+      v0::DataType::DT_COMPLEX64,  v0::DataType::DT_COMPLEX128,
+  });
+  return *dtypes;
+}
+
+std::vector<int64_t> AllDataTypes() {
+  std::vector<int64_t> dtypes = NumericDataTypes();
+  dtypes.push_back(v0::DataType::DT_STRING);
+  return dtypes;
+}
+
+// Arguments are the `v0::DataType`, the number of elements, and whether the
+// array stores its values in `content`.
+void BM_TensorFromArray(benchmark::State& state) {
+  const v0::DataType dtype = static_cast<v0::DataType>(state.range(0));
+  const int64_t num_elements = state.range(1);
+  const v0::Array array_pb =
+      CreateZerosArray(dtype, num_elements, /*use_content=*/state.range(2));
+  for (auto s : state) {
+    absl::StatusOr<tensorflow::Tensor> tensor = TensorFromArray(array_pb);
+    CHECK(tensor.ok()) << tensor.status();
+    benchmark::DoNotOptimize(tensor);
+  }
+  state.SetBytesProcessed(state.iterations() * num_elements *
+                          ElementSize(dtype));
+}
+
+BENCHMARK(BM_TensorFromArray)
+    ->ArgsProduct({AllDataTypes(), {1 << 10, 1 << 20}, {false}});
+BENCHMARK(BM_TensorFromArray)
+    ->ArgsProduct({NumericDataTypes(), {1 << 10, 1 << 20}, {true}});
+
+// Arguments are the same as for `BM_TensorFromArray`.
+void BM_LiteralFromArray(benchmark::State& state) {
+  const v0::DataType dtype = static_cast<v0::DataType>(state.range(0));
+  const int64_t num_elements = state.range(1);
+  const v0::Array array_pb =
+      CreateZerosArray(dtype, num_elements, /*use_content=*/state.range(2));
+  for (auto s : state) {
+    absl::StatusOr<xla::Literal> literal = LiteralFromArray(array_pb);
+    CHECK(literal.ok()) << literal.status();
+    benchmark::DoNotOptimize(literal);
+  }
+  state.SetBytesProcessed(state.iterations() * num_elements *
+                          ElementSize(dtype));
+}
+
+// The XLA executor does not support `DT_STRING`.
+BENCHMARK(BM_LiteralFromArray)
+    ->ArgsProduct({NumericDataTypes(), {1 << 10, 1 << 20}, {false, true}});
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -0,0 +1,85 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/async_grpc_call.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+
+CompletionQueuePoller::CompletionQueuePoller(int32_t num_threads) {
+  CHECK_GT(num_threads, 0) << "num_threads must be positive";
+  threads_.reserve(num_threads);
+  for (int32_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this] { Poll(); });
+  }
+}
+
+CompletionQueuePoller::~CompletionQueuePoller() {
+  completion_queue_.Shutdown();
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+CompletionQueuePoller& CompletionQueuePoller::Default() {
+  static CompletionQueuePoller* const poller = new CompletionQueuePoller();
+  return *poller;
+}
+
+void CompletionQueuePoller::Poll() {
+  void* tag;
+  bool ok;
+  // `Next` only returns false once the queue is shut down and drained.
+  while (completion_queue_.Next(&tag, &ok)) {
+    static_cast<AsyncCallTag*>(tag)->OnComplete(ok);
+  }
+}
+
+void CallLatencyTracker::Record(absl::Duration latency) {
+  absl::MutexLock lock(&mutex_);
+  if (samples_.size() < kMaxSamples) {
+    samples_.push_back(latency);
+    return;
+  }
+  samples_[next_sample_] = latency;
+  next_sample_ = (next_sample_ + 1) % kMaxSamples;
+}
+
+absl::Duration CallLatencyTracker::Percentile(double percentile) const {
+  std::vector<absl::Duration> samples;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (samples_.size() < kMinSamples) {
+      return absl::InfiniteDuration();
+    }
+    samples = samples_;
+  }
+  size_t rank = std::min(
+      samples.size() - 1,
+      static_cast<size_t>(std::clamp(percentile, 0.0, 1.0) * samples.size()));
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return samples[rank];
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,349 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_ASYNC_GRPC_CALL_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_ASYNC_GRPC_CALL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/alarm.h"
+#include "include/grpcpp/client_context.h"
+#include "include/grpcpp/completion_queue.h"
+#include "include/grpcpp/support/async_unary_call.h"
+#include "include/grpcpp/support/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
+
+namespace tensorflow_federated {
+
+// A tag of an asynchronous gRPC operation, notified by a
+// `CompletionQueuePoller` thread once the operation completes.
+class AsyncCallTag {
+ public:
+  virtual ~AsyncCallTag() = default;
+
+  // Called once the operation completes. `ok` is the status reported by the
+  // completion queue for it. Implementations may delete themselves.
+  virtual void OnComplete(bool ok) = 0;
+};
+
+// Polls a `grpc::CompletionQueue` from a small, fixed set of threads.
+//
+// Each tag added to the queue must be an `AsyncCallTag`, whose `OnComplete` is
+// run on one of the polling threads. `OnComplete` must therefore not block.
+//
+// The number of asynchronous calls in flight is not bounded by the number of
+// polling threads.
+class CompletionQueuePoller {
+ public:
+  static constexpr int32_t kDefaultNumThreads = 4;
+
+  explicit CompletionQueuePoller(int32_t num_threads = kDefaultNumThreads);
+  // Shuts down the completion queue, and waits for all operations added to it
+  // to complete.
+  ~CompletionQueuePoller();
+
+  // Restrict copying and moving.
+  CompletionQueuePoller(const CompletionQueuePoller&) = delete;
+  CompletionQueuePoller& operator=(const CompletionQueuePoller&) = delete;
+
+  // Returns a process-wide poller with `kDefaultNumThreads` threads, which is
+  // never destroyed.
+  static CompletionQueuePoller& Default();
+
+  grpc::CompletionQueue* completion_queue() { return &completion_queue_; }
+
+ private:
+  void Poll();
+
+  grpc::CompletionQueue completion_queue_;
+  std::vector<std::thread> threads_;
+};
+
+// The `Async<Method>` member functions of a gRPC `Stub` for unary methods.
+template <typename Stub, typename Request, typename Response>
+using AsyncUnaryMethod =
+    std::unique_ptr<grpc::ClientAsyncResponseReaderInterface<Response>> (
+        Stub::*)(grpc::ClientContext*, const Request&, grpc::CompletionQueue*);
+
+namespace internal {
+
+template <typename Stub, typename Response, typename OnDone>
+class AsyncUnaryCall final : public AsyncCallTag {
+ public:
+  AsyncUnaryCall(std::shared_ptr<Stub> stub, OnDone on_done)
+      : stub_(std::move(stub)), on_done_(std::move(on_done)) {}
+
+  template <typename Request>
+  void Start(AsyncUnaryMethod<Stub, Request, Response> method,
+             const Request& request, grpc::CompletionQueue* completion_queue) {
+    reader_ = ((*stub_).*method)(&context_, request, completion_queue);
+    reader_->Finish(&response_, &status_, this);
+  }
+
+  void OnComplete(bool ok) override {
+    // The tag of `Finish` always completes with `ok` set, the outcome of the
+    // call is reported in `status_`.
+    if (status_.ok()) {
+      std::move(on_done_)(absl::StatusOr<Response>(std::move(response_)));
+    } else {
+      std::move(on_done_)(absl::StatusOr<Response>(grpc_to_absl(status_)));
+    }
+    delete this;
+  }
+
+ private:
+  // Keeps the channel of the stub alive until the call completes.
+  std::shared_ptr<Stub> stub_;
+  OnDone on_done_;
+  grpc::ClientContext context_;
+  std::unique_ptr<grpc::ClientAsyncResponseReaderInterface<Response>> reader_;
+  Response response_;
+  grpc::Status status_;
+};
+
+}  // namespace internal
+
+// Keeps the latencies of the most recent calls of a kind, to derive the delay
+// after which a hedged call sends a second attempt. This class is thread safe.
+class CallLatencyTracker {
+ public:
+  // The number of most recent latencies which are kept.
+  static constexpr size_t kMaxSamples = 128;
+  // The number of latencies needed before `Percentile` returns a finite
+  // delay.
+  static constexpr size_t kMinSamples = 16;
+
+  void Record(absl::Duration latency) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the `percentile`, between 0 and 1, of the recent latencies, or an
+  // infinite duration until `kMinSamples` latencies have been recorded.
+  absl::Duration Percentile(double percentile) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  mutable absl::Mutex mutex_;
+  std::vector<absl::Duration> samples_ ABSL_GUARDED_BY(mutex_);
+  size_t next_sample_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Options of a call started by `StartHedgedAsyncUnaryCall`.
+struct HedgedCallOptions {
+  // The deadline of each attempt, relative to its start. An attempt still
+  // running after it fails with DEADLINE_EXCEEDED.
+  absl::Duration deadline = absl::InfiniteDuration();
+  // The delay after which a second attempt is sent if the first one has not
+  // completed yet. An infinite delay disables hedging.
+  absl::Duration hedge_delay = absl::InfiniteDuration();
+  // If not null, records the latency of the attempt which completes the call.
+  std::shared_ptr<CallLatencyTracker> latencies;
+};
+
+namespace internal {
+
+template <typename Stub, typename Request, typename Response, typename OnDone,
+          typename OnDiscard>
+class HedgedUnaryCall final
+    : public std::enable_shared_from_this<
+          HedgedUnaryCall<Stub, Request, Response, OnDone, OnDiscard>> {
+ public:
+  HedgedUnaryCall(CompletionQueuePoller& poller, std::shared_ptr<Stub> stub,
+                  AsyncUnaryMethod<Stub, Request, Response> method,
+                  const Request& request, HedgedCallOptions options,
+                  OnDone on_done, OnDiscard on_discard)
+      : poller_(poller),
+        stub_(std::move(stub)),
+        method_(method),
+        request_(request),
+        options_(std::move(options)),
+        on_done_(std::move(on_done)),
+        on_discard_(std::move(on_discard)) {}
+
+  void Start() ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    StartAttempt();
+    if (options_.hedge_delay < absl::InfiniteDuration()) {
+      timer_ = new Timer(this->shared_from_this());
+      timer_->alarm.Set(poller_.completion_queue(),
+                        absl::ToChronoTime(absl::Now() + options_.hedge_delay),
+                        timer_);
+    }
+  }
+
+ private:
+  // A single sending of the request.
+  class Attempt final : public AsyncCallTag {
+   public:
+    explicit Attempt(std::shared_ptr<HedgedUnaryCall> call)
+        : call(std::move(call)) {}
+
+    void OnComplete(bool ok) override {
+      call->OnAttemptDone(*this);
+      delete this;
+    }
+
+    std::shared_ptr<HedgedUnaryCall> call;
+    const absl::Time start_time = absl::Now();
+    grpc::ClientContext context;
+    std::unique_ptr<grpc::ClientAsyncResponseReaderInterface<Response>> reader;
+    Response response;
+    grpc::Status status;
+  };
+
+  // Fires once the hedging delay has passed, or once it is cancelled.
+  class Timer final : public AsyncCallTag {
+   public:
+    explicit Timer(std::shared_ptr<HedgedUnaryCall> call)
+        : call(std::move(call)) {}
+
+    void OnComplete(bool ok) override {
+      call->OnTimer(ok);
+      delete this;
+    }
+
+    std::shared_ptr<HedgedUnaryCall> call;
+    grpc::Alarm alarm;
+  };
+
+  void StartAttempt() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto* attempt = new Attempt(this->shared_from_this());
+    if (options_.deadline < absl::InfiniteDuration()) {
+      attempt->context.set_deadline(
+          absl::ToChronoTime(attempt->start_time + options_.deadline));
+    }
+    attempts_.push_back(attempt);
+    attempt->reader = ((*stub_).*method_)(&attempt->context, request_,
+                                          poller_.completion_queue());
+    attempt->reader->Finish(&attempt->response, &attempt->status, attempt);
+  }
+
+  void OnTimer(bool fired) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    timer_ = nullptr;
+    if (fired && !done_) {
+      StartAttempt();
+    }
+  }
+
+  void OnAttemptDone(Attempt& attempt) ABSL_LOCKS_EXCLUDED(mutex_) {
+    bool completes_call = false;
+    {
+      absl::MutexLock lock(&mutex_);
+      attempts_.erase(std::find(attempts_.begin(), attempts_.end(), &attempt));
+      // A failed attempt only fails the call if no other attempt is still
+      // running. Failures are not retried, so a pending timer is cancelled.
+      if (!done_ && (attempt.status.ok() || attempts_.empty())) {
+        done_ = true;
+        completes_call = true;
+        for (Attempt* other : attempts_) {
+          other->context.TryCancel();
+        }
+        if (timer_ != nullptr) {
+          timer_->alarm.Cancel();
+        }
+      }
+    }
+    if (!completes_call) {
+      // The response of an attempt which lost the race may still hold
+      // resources created by the call.
+      if (attempt.status.ok()) {
+        on_discard_(std::move(attempt.response));
+      }
+      return;
+    }
+    if (!attempt.status.ok()) {
+      std::move(on_done_)(
+          absl::StatusOr<Response>(grpc_to_absl(attempt.status)));
+      return;
+    }
+    if (options_.latencies != nullptr) {
+      options_.latencies->Record(absl::Now() - attempt.start_time);
+    }
+    std::move(on_done_)(absl::StatusOr<Response>(std::move(attempt.response)));
+  }
+
+  CompletionQueuePoller& poller_;
+  const std::shared_ptr<Stub> stub_;
+  const AsyncUnaryMethod<Stub, Request, Response> method_;
+  // A copy of the request, which the second attempt sends after the first
+  // one was started.
+  const Request request_;
+  const HedgedCallOptions options_;
+  OnDone on_done_;
+  OnDiscard on_discard_;
+
+  absl::Mutex mutex_;
+  bool done_ ABSL_GUARDED_BY(mutex_) = false;
+  // The attempts which have not completed yet.
+  std::vector<Attempt*> attempts_ ABSL_GUARDED_BY(mutex_);
+  // The pending hedging timer, if any.
+  Timer* timer_ ABSL_GUARDED_BY(mutex_) = nullptr;
+};
+
+}  // namespace internal
+
+// Starts an asynchronous unary call of `method` on `stub`, without blocking.
+//
+// `on_done` is called with the response, or the error status of the call, on
+// one of the threads of `poller` once the call completes, so it must not
+// block. `request` is serialized before this function returns.
+template <typename Stub, typename Request, typename Response, typename OnDone>
+void StartAsyncUnaryCall(CompletionQueuePoller& poller,
+                         std::shared_ptr<Stub> stub,
+                         AsyncUnaryMethod<Stub, Request, Response> method,
+                         const Request& request, OnDone on_done) {
+  auto* call = new internal::AsyncUnaryCall<Stub, Response, OnDone>(
+      std::move(stub), std::move(on_done));
+  call->Start(method, request, poller.completion_queue());
+}
+
+// Like `StartAsyncUnaryCall`, but bounds each attempt of the call by
+// `options.deadline`, and hedges the call: if the first attempt has not
+// completed after `options.hedge_delay`, the request is sent a second time,
+// and the first attempt to succeed completes the call while the other one is
+// cancelled. A failed attempt only fails the call if no other attempt is
+// running, and is not retried.
+//
+// The method must be idempotent, since both attempts may reach the server.
+// `on_discard` is called with the response of a successful attempt which
+// did not complete the call, e.g. to release what it created, on one of the
+// threads of `poller`.
+template <typename Stub, typename Request, typename Response, typename OnDone,
+          typename OnDiscard>
+void StartHedgedAsyncUnaryCall(CompletionQueuePoller& poller,
+                               std::shared_ptr<Stub> stub,
+                               AsyncUnaryMethod<Stub, Request, Response> method,
+                               const Request& request,
+                               HedgedCallOptions options, OnDone on_done,
+                               OnDiscard on_discard) {
+  auto call = std::make_shared<
+      internal::HedgedUnaryCall<Stub, Request, Response, OnDone, OnDiscard>>(
+      poller, std::move(stub), method, request, std::move(options),
+      std::move(on_done), std::move(on_discard));
+  call->Start();
+}
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_ASYNC_GRPC_CALL_H_
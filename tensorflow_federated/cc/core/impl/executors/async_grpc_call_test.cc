@@ -0,0 +1,172 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/async_grpc_call.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/support/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_grpc.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using Stub = v0::ExecutorGroup::StubInterface;
+
+auto ReturnValueRef(std::string id) {
+  v0::CreateValueResponse response;
+  response.mutable_value_ref()->set_id(std::move(id));
+  return ::testing::DoAll(::testing::SetArgPointee<2>(response),
+                          ::testing::Return(grpc::Status::OK));
+}
+
+class AsyncGrpcCallTest : public ::testing::Test {
+ protected:
+  AsyncGrpcCallTest()
+      : mock_service_(mock_server_.service()), stub_(mock_server_.NewStub()) {}
+
+  MockGrpcExecutorServer mock_server_;
+  MockGrpcExecutorService* mock_service_;
+  std::shared_ptr<Stub> stub_;
+};
+
+TEST_F(AsyncGrpcCallTest, ReturnsResponse) {
+  EXPECT_CALL(*mock_service_, CreateValue).WillOnce(ReturnValueRef("value"));
+  CompletionQueuePoller poller(1);
+  absl::StatusOr<v0::CreateValueResponse> result;
+  absl::Notification done;
+  StartAsyncUnaryCall(poller, stub_, &Stub::AsyncCreateValue,
+                      v0::CreateValueRequest(),
+                      [&](absl::StatusOr<v0::CreateValueResponse> response) {
+                        result = std::move(response);
+                        done.Notify();
+                      });
+  done.WaitForNotification();
+  ASSERT_THAT(result, IsOk());
+  EXPECT_EQ(result->value_ref().id(), "value");
+}
+
+TEST_F(AsyncGrpcCallTest, ReturnsErrorStatus) {
+  EXPECT_CALL(*mock_service_, CreateValue)
+      .WillOnce(::testing::Return(
+          grpc::Status(grpc::StatusCode::UNAVAILABLE, "Unavailable")));
+  CompletionQueuePoller poller(1);
+  absl::Status status;
+  absl::Notification done;
+  StartAsyncUnaryCall(poller, stub_, &Stub::AsyncCreateValue,
+                      v0::CreateValueRequest(),
+                      [&](absl::StatusOr<v0::CreateValueResponse> response) {
+                        status = response.status();
+                        done.Notify();
+                      });
+  done.WaitForNotification();
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kUnavailable));
+}
+
+TEST_F(AsyncGrpcCallTest, ManyCallsInFlightOnOnePollingThread) {
+  constexpr int kNumCalls = 100;
+  EXPECT_CALL(*mock_service_, CreateValue)
+      .Times(kNumCalls)
+      .WillRepeatedly(ReturnValueRef("value"));
+  CompletionQueuePoller poller(1);
+  absl::BlockingCounter done(kNumCalls);
+  for (int i = 0; i < kNumCalls; ++i) {
+    StartAsyncUnaryCall(poller, stub_, &Stub::AsyncCreateValue,
+                        v0::CreateValueRequest(),
+                        [&](absl::StatusOr<v0::CreateValueResponse> response) {
+                          EXPECT_THAT(response, IsOk());
+                          done.DecrementCount();
+                        });
+  }
+  done.Wait();
+}
+
+TEST_F(AsyncGrpcCallTest, HedgedCallUsesFirstResponse) {
+  absl::Notification release_first;
+  EXPECT_CALL(*mock_service_, CreateValue)
+      .WillOnce(::testing::DoAll(
+          ::testing::InvokeWithoutArgs(
+              [&] { release_first.WaitForNotification(); }),
+          ReturnValueRef("first")))
+      .WillOnce(ReturnValueRef("second"));
+  CompletionQueuePoller poller(1);
+  HedgedCallOptions options;
+  options.hedge_delay = absl::Milliseconds(10);
+  options.latencies = std::make_shared<CallLatencyTracker>();
+  absl::StatusOr<v0::CreateValueResponse> result;
+  absl::Notification done;
+  StartHedgedAsyncUnaryCall(
+      poller, stub_, &Stub::AsyncCreateValue, v0::CreateValueRequest(),
+      options,
+      [&](absl::StatusOr<v0::CreateValueResponse> response) {
+        result = std::move(response);
+        done.Notify();
+      },
+      [](v0::CreateValueResponse) {});
+  done.WaitForNotification();
+  release_first.Notify();
+  ASSERT_THAT(result, IsOk());
+  EXPECT_EQ(result->value_ref().id(), "second");
+}
+
+TEST_F(AsyncGrpcCallTest, HedgedCallFailsAfterDeadline) {
+  absl::Notification release;
+  EXPECT_CALL(*mock_service_, CreateValue)
+      .WillOnce(::testing::DoAll(
+          ::testing::InvokeWithoutArgs([&] { release.WaitForNotification(); }),
+          ReturnValueRef("value")));
+  CompletionQueuePoller poller(1);
+  HedgedCallOptions options;
+  options.deadline = absl::Milliseconds(10);
+  absl::Status status;
+  absl::Notification done;
+  StartHedgedAsyncUnaryCall(
+      poller, stub_, &Stub::AsyncCreateValue, v0::CreateValueRequest(),
+      options,
+      [&](absl::StatusOr<v0::CreateValueResponse> response) {
+        status = response.status();
+        done.Notify();
+      },
+      [](v0::CreateValueResponse) {});
+  done.WaitForNotification();
+  release.Notify();
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+TEST(CallLatencyTrackerTest, ReturnsPercentileOfRecentLatencies) {
+  CallLatencyTracker latencies;
+  EXPECT_EQ(latencies.Percentile(0.95), absl::InfiniteDuration());
+  for (int i = 1; i <= 100; ++i) {
+    latencies.Record(absl::Milliseconds(i));
+  }
+  EXPECT_EQ(latencies.Percentile(0.95), absl::Milliseconds(96));
+  EXPECT_EQ(latencies.Percentile(1.0), absl::Milliseconds(100));
+  EXPECT_EQ(latencies.Percentile(0.0), absl::Milliseconds(1));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
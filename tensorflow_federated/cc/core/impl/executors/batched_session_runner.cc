@@ -0,0 +1,230 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/batched_session_runner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/session_provider.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+constexpr std::string_view kControlInputPrefix = "^";
+constexpr std::string_view kColocationPrefix = "loc:@";
+
+// Returns the name of `name` in replica `replica` of a replicated graph.
+std::string ReplicaName(size_t replica, std::string_view name) {
+  return absl::StrCat("replica_", replica, "/", name);
+}
+
+// Returns a graph holding `num_replicas` independent copies of `graph`.
+tensorflow::GraphDef ReplicateGraph(const tensorflow::GraphDef& graph,
+                                    size_t num_replicas) {
+  tensorflow::GraphDef replicated_graph;
+  *replicated_graph.mutable_versions() = graph.versions();
+  for (size_t replica = 0; replica < num_replicas; ++replica) {
+    for (const tensorflow::NodeDef& node : graph.node()) {
+      tensorflow::NodeDef* replica_node = replicated_graph.add_node();
+      *replica_node = node;
+      replica_node->set_name(ReplicaName(replica, node.name()));
+      for (std::string& input : *replica_node->mutable_input()) {
+        if (absl::StartsWith(input, kControlInputPrefix)) {
+          input = absl::StrCat(
+              kControlInputPrefix,
+              ReplicaName(replica, std::string_view(input).substr(
+                                       kControlInputPrefix.size())));
+        } else {
+          input = ReplicaName(replica, input);
+        }
+      }
+      auto colocation = replica_node->mutable_attr()->find("_class");
+      if (colocation != replica_node->mutable_attr()->end()) {
+        for (std::string& location :
+             *colocation->second.mutable_list()->mutable_s()) {
+          if (absl::StartsWith(location, kColocationPrefix)) {
+            location = absl::StrCat(
+                kColocationPrefix,
+                ReplicaName(replica, std::string_view(location).substr(
+                                         kColocationPrefix.size())));
+          }
+        }
+      }
+    }
+  }
+  return replicated_graph;
+}
+
+}  // namespace
+
+bool BatchedSessionRunner::CanBatch(const tensorflow::GraphDef& graph) {
+  // Functions may hide stateful ops, and are not replicated.
+  if (graph.library().function_size() > 0) {
+    return false;
+  }
+  for (const tensorflow::NodeDef& node : graph.node()) {
+    const tensorflow::OpDef* op_def = nullptr;
+    if (!tensorflow::OpRegistry::Global()
+             ->LookUpOpDef(node.op(), &op_def)
+             .ok() ||
+        op_def->is_stateful()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+BatchedSessionRunner::BatchedSessionRunner(
+    tensorflow::GraphDef graph, std::vector<std::string> output_tensor_names,
+    int32_t max_batch_size)
+    : graph_(std::move(graph)),
+      output_tensor_names_(std::move(output_tensor_names)),
+      max_batch_size_(max_batch_size) {}
+
+absl::StatusOr<std::vector<tensorflow::Tensor>> BatchedSessionRunner::Run(
+    std::vector<std::pair<std::string, tensorflow::Tensor>> inputs) {
+  std::vector<std::vector<std::pair<std::string, tensorflow::Tensor>>> runs;
+  runs.push_back(std::move(inputs));
+  return std::move(RunAll(std::move(runs))[0]);
+}
+
+std::vector<absl::StatusOr<std::vector<tensorflow::Tensor>>>
+BatchedSessionRunner::RunAll(
+    std::vector<std::vector<std::pair<std::string, tensorflow::Tensor>>>
+        inputs) {
+  if (inputs.empty()) {
+    return {};
+  }
+  std::vector<PendingRun> runs(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    runs[i].inputs = std::move(inputs[i]);
+  }
+  // Batches are taken from the front of the queue, so all of `runs` are done
+  // once the last of them is.
+  PendingRun& run = runs.back();
+  mutex_.Lock();
+  for (PendingRun& pending_run : runs) {
+    pending_runs_.push_back(&pending_run);
+  }
+  while (!run.done) {
+    if (running_) {
+      batch_done_.Wait(&mutex_);
+      continue;
+    }
+    // Run the largest batch of the pending runs, which holds this run unless
+    // more than a full batch of runs arrived before it.
+    running_ = true;
+    size_t batch_size = 1;
+    while (batch_size * 2 <= static_cast<size_t>(max_batch_size_) &&
+           batch_size * 2 <= pending_runs_.size()) {
+      batch_size *= 2;
+    }
+    std::vector<PendingRun*> batch(pending_runs_.begin(),
+                                   pending_runs_.begin() + batch_size);
+    pending_runs_.erase(pending_runs_.begin(),
+                        pending_runs_.begin() + batch_size);
+    mutex_.Unlock();
+    RunBatch(batch);
+    mutex_.Lock();
+    for (PendingRun* batch_run : batch) {
+      batch_run->done = true;
+    }
+    running_ = false;
+    batch_done_.SignalAll();
+  }
+  mutex_.Unlock();
+  std::vector<absl::StatusOr<std::vector<tensorflow::Tensor>>> outputs;
+  outputs.reserve(runs.size());
+  for (PendingRun& pending_run : runs) {
+    outputs.push_back(std::move(pending_run.outputs));
+  }
+  return outputs;
+}
+
+void BatchedSessionRunner::RunBatch(const std::vector<PendingRun*>& batch) {
+  std::vector<std::pair<std::string, tensorflow::Tensor>> inputs;
+  std::vector<std::string> output_tensor_names;
+  output_tensor_names.reserve(batch.size() * output_tensor_names_.size());
+  for (size_t replica = 0; replica < batch.size(); ++replica) {
+    for (auto& [name, tensor] : batch[replica]->inputs) {
+      inputs.emplace_back(ReplicaName(replica, name), std::move(tensor));
+    }
+    for (const std::string& name : output_tensor_names_) {
+      output_tensor_names.push_back(ReplicaName(replica, name));
+    }
+  }
+  std::vector<tensorflow::Tensor> outputs;
+  absl::Status status = [&]() -> absl::Status {
+    auto session =
+        TFF_TRY(BatchedSessionProvider(batch.size()).BorrowSession());
+    tensorflow::Status run_status =
+        session.RunCallable(inputs, output_tensor_names,
+                            /*target_tensor_names=*/{}, &outputs);
+    if (!run_status.ok()) {
+      return absl::InternalError(
+          absl::StrCat("Failed to run computation: ", run_status.message()));
+    }
+    return absl::OkStatus();
+  }();
+  // A failure of the session run is reported to all runs of the batch, since
+  // the session does not tell which replica failed.
+  if (!status.ok()) {
+    for (PendingRun* run : batch) {
+      run->outputs = status;
+    }
+    return;
+  }
+  const size_t num_outputs = output_tensor_names_.size();
+  for (size_t replica = 0; replica < batch.size(); ++replica) {
+    auto replica_outputs = outputs.begin() + replica * num_outputs;
+    batch[replica]->outputs = std::vector<tensorflow::Tensor>(
+        std::make_move_iterator(replica_outputs),
+        std::make_move_iterator(replica_outputs + num_outputs));
+  }
+}
+
+SessionProvider& BatchedSessionRunner::BatchedSessionProvider(
+    int32_t batch_size) {
+  absl::MutexLock lock(&providers_mutex_);
+  std::unique_ptr<SessionProvider>& provider = providers_[batch_size];
+  if (provider == nullptr) {
+    provider =
+        std::make_unique<SessionProvider>(ReplicateGraph(graph_, batch_size));
+  }
+  return *provider;
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,105 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_BATCHED_SESSION_RUNNER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_BATCHED_SESSION_RUNNER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow_federated/cc/core/impl/executors/session_provider.h"
+
+namespace tensorflow_federated {
+
+// Runs a stateless graph, coalescing concurrent runs into a single session run.
+//
+// Calls of the same computation, e.g. by `federated_map` in simulation, are
+// often many small session runs whose cost is dominated by the per-run
+// overhead. Runs which arrive while another batch is running are queued, and
+// the next batch runs them all at once on a graph which holds one replica of
+// the original graph per run, with node names prefixed by the replica index.
+//
+// Replicas do not share state, so only graphs for which `CanBatch` returns
+// true may be run this way.
+class BatchedSessionRunner {
+ public:
+  // Returns whether runs of `graph` can be batched: the graph must not
+  // contain stateful ops, nor call functions, whose effects would differ when
+  // replicated.
+  static bool CanBatch(const tensorflow::GraphDef& graph);
+
+  // Batches at most `max_batch_size` runs together. Batched graphs are built
+  // for power of two batch sizes, so that at most log2(max_batch_size) + 1
+  // graphs are created.
+  BatchedSessionRunner(tensorflow::GraphDef graph,
+                       std::vector<std::string> output_tensor_names,
+                       int32_t max_batch_size);
+
+  // Feeds `inputs` into the graph and returns the `output_tensor_names`
+  // tensors. Blocks until the batch holding this run completes.
+  absl::StatusOr<std::vector<tensorflow::Tensor>> Run(
+      std::vector<std::pair<std::string, tensorflow::Tensor>> inputs);
+
+  // Runs each of `inputs` as `Run` does, batched together with each other and
+  // with concurrent runs, and returns the outputs of each run in order. Blocks
+  // until all of the runs complete.
+  std::vector<absl::StatusOr<std::vector<tensorflow::Tensor>>> RunAll(
+      std::vector<std::vector<std::pair<std::string, tensorflow::Tensor>>>
+          inputs);
+
+ private:
+  struct PendingRun {
+    std::vector<std::pair<std::string, tensorflow::Tensor>> inputs;
+    absl::StatusOr<std::vector<tensorflow::Tensor>> outputs;
+    bool done = false;
+  };
+
+  // Runs `batch` in a single session run, setting the outputs of each run.
+  void RunBatch(const std::vector<PendingRun*>& batch);
+
+  // Returns the provider of sessions for the graph replicated `batch_size`
+  // times, creating it if needed.
+  SessionProvider& BatchedSessionProvider(int32_t batch_size);
+
+  const tensorflow::GraphDef graph_;
+  const std::vector<std::string> output_tensor_names_;
+  const int32_t max_batch_size_;
+
+  absl::Mutex mutex_;
+  // Runs waiting to be part of a batch, in arrival order.
+  std::deque<PendingRun*> pending_runs_ ABSL_GUARDED_BY(mutex_);
+  // Whether a batch is running. At most one batch runs at a time, so that
+  // runs arriving meanwhile accumulate into the next batch.
+  bool running_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::CondVar batch_done_;
+
+  absl::Mutex providers_mutex_;
+  absl::flat_hash_map<int32_t, std::unique_ptr<SessionProvider>> providers_
+      ABSL_GUARDED_BY(providers_mutex_);
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_BATCHED_SESSION_RUNNER_H_
@@ -0,0 +1,128 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/batched_session_runner.h"
+
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "googletest/include/gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/cc/ops/resource_variable_ops.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace {
+
+// Returns a graph computing `out = x + 1`.
+tensorflow::GraphDef AddOneGraph() {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root.WithOpName("x"), tensorflow::DT_FLOAT);
+  tensorflow::ops::AddV2 out(root.WithOpName("out"), x,
+                             tensorflow::ops::Const(root, 1.0f));
+  tensorflow::GraphDef graphdef_pb;
+  CHECK(root.ToGraphDef(&graphdef_pb).ok());
+  return graphdef_pb;
+}
+
+TEST(BatchedSessionRunnerTest, CanBatchStatelessGraph) {
+  EXPECT_TRUE(BatchedSessionRunner::CanBatch(AddOneGraph()));
+}
+
+TEST(BatchedSessionRunnerTest, CannotBatchStatefulGraph) {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::VarHandleOp variable(root, tensorflow::DT_FLOAT,
+                                        tensorflow::TensorShape({}));
+  tensorflow::GraphDef graphdef_pb;
+  ASSERT_TRUE(root.ToGraphDef(&graphdef_pb).ok());
+  EXPECT_FALSE(BatchedSessionRunner::CanBatch(graphdef_pb));
+}
+
+TEST(BatchedSessionRunnerTest, CannotBatchGraphWithFunctions) {
+  tensorflow::GraphDef graphdef_pb = AddOneGraph();
+  graphdef_pb.mutable_library()->add_function();
+  EXPECT_FALSE(BatchedSessionRunner::CanBatch(graphdef_pb));
+}
+
+TEST(BatchedSessionRunnerTest, RunsSingleRun) {
+  BatchedSessionRunner runner(AddOneGraph(), {"out:0"},
+                              /*max_batch_size=*/4);
+  std::vector<tensorflow::Tensor> outputs = TFF_ASSERT_OK(
+      runner.Run({{"x:0", tensorflow::test::AsScalar<float>(2.0f)}}));
+  ASSERT_EQ(outputs.size(), 1);
+  tensorflow::test::ExpectTensorEqual<float>(
+      outputs[0], tensorflow::test::AsScalar<float>(3.0f));
+}
+
+TEST(BatchedSessionRunnerTest, RunsConcurrentRuns) {
+  constexpr int kNumRuns = 32;
+  BatchedSessionRunner runner(AddOneGraph(), {"out:0"},
+                              /*max_batch_size=*/8);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumRuns; ++i) {
+    threads.emplace_back([&runner, i] {
+      absl::StatusOr<std::vector<tensorflow::Tensor>> outputs =
+          runner.Run({{"x:0", tensorflow::test::AsScalar<float>(i)}});
+      ASSERT_TRUE(outputs.ok()) << outputs.status();
+      ASSERT_EQ(outputs->size(), 1);
+      tensorflow::test::ExpectTensorEqual<float>(
+          (*outputs)[0], tensorflow::test::AsScalar<float>(i + 1.0f));
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(BatchedSessionRunnerTest, RunsAllRunsInOrder) {
+  constexpr int kNumRuns = 7;
+  BatchedSessionRunner runner(AddOneGraph(), {"out:0"},
+                              /*max_batch_size=*/4);
+  std::vector<std::vector<std::pair<std::string, tensorflow::Tensor>>> inputs;
+  for (int i = 0; i < kNumRuns; ++i) {
+    inputs.push_back({{"x:0", tensorflow::test::AsScalar<float>(i)}});
+  }
+  std::vector<absl::StatusOr<std::vector<tensorflow::Tensor>>> outputs =
+      runner.RunAll(std::move(inputs));
+  ASSERT_EQ(outputs.size(), kNumRuns);
+  for (int i = 0; i < kNumRuns; ++i) {
+    ASSERT_TRUE(outputs[i].ok()) << outputs[i].status();
+    ASSERT_EQ(outputs[i]->size(), 1);
+    tensorflow::test::ExpectTensorEqual<float>(
+        (*outputs[i])[0], tensorflow::test::AsScalar<float>(i + 1.0f));
+  }
+}
+
+TEST(BatchedSessionRunnerTest, RunFailsOnMissingInput) {
+  BatchedSessionRunner runner(AddOneGraph(), {"out:0"},
+                              /*max_batch_size=*/4);
+  EXPECT_THAT(runner.Run({}), StatusIs(absl::StatusCode::kInternal));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -0,0 +1,449 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/batching_remote_executor.h"
+
+#include <cstdint>
+#include <future>  // NOLINT
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "include/grpcpp/grpcpp.h"
+#include "include/grpcpp/support/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/async_grpc_call.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/dispose_queue.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+class ExecutorValue;
+
+using ValueFuture =
+    std::shared_future<absl::StatusOr<std::shared_ptr<ExecutorValue>>>;
+
+// A custom deleter for the `std::shared_ptr<v0::ExecutorGroup::StubInterface>`
+// which will call `DisposeExecutor` for the provided `executor_pb`, if any.
+// This ensures that the remote service knows no more calls will be coming for
+// the given `executor_pb` and that the associated resources can be released.
+//
+// Unfortunately, this cannot be part of the destructor of
+// `BatchingRemoteExecutor`, as batches may still be in flight after the
+// `BatchingRemoteExecutor` has already been destroyed.
+class StubDeleter {
+ public:
+  StubDeleter() = default;
+  void SetExecutorId(v0::ExecutorId executor_pb) {
+    executor_pb_ = std::move(executor_pb);
+  }
+  void operator()(v0::ExecutorGroup::StubInterface* stub) {
+    if (executor_pb_.has_value()) {
+      ThreadRun([stub, executor_pb = std::move(*executor_pb_)]() {
+        v0::DisposeExecutorRequest request;
+        v0::DisposeExecutorResponse response;
+        grpc::ClientContext context;
+        *request.mutable_executor() = std::move(executor_pb);
+        grpc::Status dispose_status =
+            stub->DisposeExecutor(&context, request, &response);
+        if (!dispose_status.ok()) {
+          LOG(ERROR) << "Error disposing of Executor ["
+                     << request.executor().id()
+                     << "]: " << grpc_to_absl(dispose_status);
+        }
+        delete stub;
+      });
+    } else {
+      delete stub;
+    }
+  }
+
+ private:
+  std::optional<v0::ExecutorId> executor_pb_;
+};
+
+// The results of the operations of a single `ExecuteBatch` request.
+//
+// The refs of the results are only known once the response of the request is
+// received. Results released before that are disposed of once it is.
+class OperationBatch {
+ public:
+  explicit OperationBatch(std::shared_ptr<DisposeQueue> dispose_queue)
+      : dispose_queue_(std::move(dispose_queue)) {}
+
+  // Returns the ref of the result of the operation at `index`, waiting for
+  // the response of the batch if needed.
+  absl::StatusOr<v0::ValueRef> WaitForRef(uint32_t index)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    mutex_.Await(absl::Condition(&done_));
+    if (!status_.ok()) {
+      return status_;
+    }
+    return value_refs_[index];
+  }
+
+  // Disposes of the result of the operation at `index`, as soon as its ref is
+  // known.
+  void Release(uint32_t index) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    if (!done_) {
+      released_.push_back(index);
+    } else if (status_.ok()) {
+      dispose_queue_->Add(value_refs_[index]);
+    }
+  }
+
+  // Completes the batch with the refs of the results of its operations, or
+  // the error of the request.
+  void Complete(absl::StatusOr<std::vector<v0::ValueRef>> value_refs)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    if (value_refs.ok()) {
+      value_refs_ = std::move(value_refs).value();
+      for (uint32_t index : released_) {
+        dispose_queue_->Add(value_refs_[index]);
+      }
+    } else {
+      status_ = value_refs.status();
+    }
+    released_.clear();
+    done_ = true;
+  }
+
+ private:
+  const std::shared_ptr<DisposeQueue> dispose_queue_;
+  absl::Mutex mutex_;
+  bool done_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status status_ ABSL_GUARDED_BY(mutex_);
+  std::vector<v0::ValueRef> value_refs_ ABSL_GUARDED_BY(mutex_);
+  // Indices of the results released before the batch was done.
+  std::vector<uint32_t> released_ ABSL_GUARDED_BY(mutex_);
+};
+
+// A value tracked by the BatchingRemoteExecutor: the result of the operation
+// at `index` of `batch`.
+class ExecutorValue {
+ public:
+  ExecutorValue(std::shared_ptr<OperationBatch> batch, uint32_t index)
+      : batch_(std::move(batch)), index_(index) {}
+  // Dispose implemented for now just on destructors.
+  ~ExecutorValue() { batch_->Release(index_); }
+
+  const OperationBatch* batch() const { return batch_.get(); }
+  uint32_t index() const { return index_; }
+
+  // Returns the ref of this value, waiting for the response of its batch if
+  // needed. The batch must have been sent.
+  absl::StatusOr<v0::ValueRef> WaitForRef() const {
+    return batch_->WaitForRef(index_);
+  }
+
+ private:
+  const std::shared_ptr<OperationBatch> batch_;
+  const uint32_t index_;
+};
+
+class BatchingRemoteExecutor : public ExecutorBase<ValueFuture> {
+ public:
+  BatchingRemoteExecutor(std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
+                         const CardinalityMap& cardinalities,
+                         int32_t max_batch_size)
+      : stub_(stub.release(), StubDeleter()),
+        cardinalities_(cardinalities),
+        max_batch_size_(max_batch_size) {}
+
+  ~BatchingRemoteExecutor() override {
+    absl::MutexLock lock(&mutex_);
+    if (pending_batch_ != nullptr) {
+      // None of the buffered operations can be used anymore.
+      pending_batch_->Complete(absl::CancelledError(
+          "The executor was destroyed before the operation was sent."));
+    }
+  }
+
+  std::string_view ExecutorName() final {
+    static constexpr std::string_view kExecutorName = "BatchingRemoteExecutor";
+    return kExecutorName;
+  }
+
+  absl::StatusOr<ValueFuture> CreateExecutorValue(
+      const v0::Value& value_pb) final;
+
+  absl::StatusOr<ValueFuture> CreateCall(
+      ValueFuture function, std::optional<ValueFuture> argument) final;
+
+  absl::StatusOr<ValueFuture> CreateStruct(
+      std::vector<ValueFuture> members) final;
+
+  absl::StatusOr<ValueFuture> CreateSelection(ValueFuture value,
+                                              uint32_t index) final;
+
+  absl::Status Materialize(ValueFuture value, v0::Value* value_pb) final;
+
+ private:
+  // An argument of an operation, and the field of the operation referring to
+  // it.
+  struct OperationInput {
+    std::shared_ptr<ExecutorValue> value;
+    v0::ExecuteBatchRequest::Ref* ref;
+  };
+
+  absl::Status EnsureInitialized();
+
+  // Fills the refs of `inputs`, which point into `operation`, and appends
+  // `operation` to the pending batch. Returns a future to its result.
+  //
+  // Inputs of the pending batch are referred to by their operation index.
+  // Inputs of batches which were already sent are referred to by their value
+  // ref, waiting for the response of their batch if needed.
+  absl::StatusOr<ValueFuture> AddOperation(
+      v0::ExecuteBatchRequest::Operation operation,
+      std::vector<OperationInput> inputs) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Sends `batch` if it is still the pending batch, without waiting for the
+  // response.
+  void Flush(const OperationBatch* batch) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  std::shared_ptr<v0::ExecutorGroup::StubInterface> stub_;
+  CompletionQueuePoller* const poller_ = &CompletionQueuePoller::Default();
+  CardinalityMap cardinalities_;
+  const int32_t max_batch_size_;
+  absl::Mutex mutex_;
+  bool executor_pb_set_ ABSL_GUARDED_BY(mutex_) = false;
+  v0::ExecutorId executor_pb_;
+  std::shared_ptr<DisposeQueue> dispose_queue_;
+  // The batch of the buffered operations, and the request that will send them.
+  std::shared_ptr<OperationBatch> pending_batch_ ABSL_GUARDED_BY(mutex_);
+  v0::ExecuteBatchRequest pending_request_ ABSL_GUARDED_BY(mutex_);
+};
+
+absl::Status BatchingRemoteExecutor::EnsureInitialized() {
+  absl::MutexLock lock(&mutex_);
+  if (executor_pb_set_) {
+    return absl::OkStatus();
+  }
+  v0::GetExecutorRequest request;
+  for (auto iter = cardinalities_.begin(); iter != cardinalities_.end();
+       ++iter) {
+    v0::Placement placement;
+    placement.set_uri(iter->first);
+    v0::Cardinality cardinality;
+    *cardinality.mutable_placement() = placement;
+    cardinality.set_cardinality(iter->second);
+    request.mutable_cardinalities()->Add(std::move(cardinality));
+  }
+  v0::GetExecutorResponse response;
+  grpc::ClientContext client_context;
+  auto result = stub_->GetExecutor(&client_context, request, &response);
+  if (result.ok()) {
+    executor_pb_ = response.executor();
+    executor_pb_set_ = true;
+    // Tell the `StubDeleter` which executor it should delete when the stub is
+    // no longer referenced.
+    std::get_deleter<StubDeleter>(stub_)->SetExecutorId(executor_pb_);
+    // The queue holds a reference to the stub, so the executor is only
+    // disposed of once all of its values have been.
+    dispose_queue_ = std::make_shared<DisposeQueue>(stub_, executor_pb_);
+    pending_batch_ = std::make_shared<OperationBatch>(dispose_queue_);
+    *pending_request_.mutable_executor() = executor_pb_;
+  }
+  return grpc_to_absl(result);
+}
+
+absl::StatusOr<ValueFuture> BatchingRemoteExecutor::AddOperation(
+    v0::ExecuteBatchRequest::Operation operation,
+    std::vector<OperationInput> inputs) {
+  std::vector<bool> resolved(inputs.size(), false);
+  std::shared_ptr<OperationBatch> batch;
+  uint32_t index;
+  bool full;
+  while (true) {
+    std::vector<size_t> sent_inputs;
+    {
+      absl::MutexLock lock(&mutex_);
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        if (resolved[i]) {
+          continue;
+        }
+        if (inputs[i].value->batch() == pending_batch_.get()) {
+          inputs[i].ref->set_operation_index(inputs[i].value->index());
+        } else {
+          sent_inputs.push_back(i);
+        }
+      }
+      if (sent_inputs.empty()) {
+        batch = pending_batch_;
+        index = pending_request_.operation_size();
+        *pending_request_.add_operation() = std::move(operation);
+        full = pending_request_.operation_size() >= max_batch_size_;
+        break;
+      }
+    }
+    // A batch is never pending again once it was sent, so these inputs are
+    // only waited for once. The pending batch may in turn be sent meanwhile,
+    // in which case more inputs have to be waited for on the next iteration.
+    for (size_t i : sent_inputs) {
+      *inputs[i].ref->mutable_value_ref() =
+          TFF_TRY(inputs[i].value->WaitForRef());
+      resolved[i] = true;
+    }
+  }
+  if (full) {
+    Flush(batch.get());
+  }
+  return ReadyFuture(std::make_shared<ExecutorValue>(std::move(batch), index));
+}
+
+void BatchingRemoteExecutor::Flush(const OperationBatch* batch) {
+  std::shared_ptr<OperationBatch> sent_batch;
+  v0::ExecuteBatchRequest request;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (batch != pending_batch_.get() ||
+        pending_request_.operation_size() == 0) {
+      return;
+    }
+    sent_batch = std::exchange(
+        pending_batch_, std::make_shared<OperationBatch>(dispose_queue_));
+    std::swap(request, pending_request_);
+    *pending_request_.mutable_executor() = executor_pb_;
+  }
+  const int num_operations = request.operation_size();
+  StartAsyncUnaryCall(
+      *poller_, stub_, &v0::ExecutorGroup::StubInterface::AsyncExecuteBatch,
+      request,
+      [sent_batch = std::move(sent_batch),
+       num_operations](absl::StatusOr<v0::ExecuteBatchResponse> response) {
+        if (!response.ok()) {
+          sent_batch->Complete(response.status());
+        } else if (response->value_ref_size() != num_operations) {
+          sent_batch->Complete(absl::InternalError(absl::StrCat(
+              "Expected ", num_operations, " value refs in the response to ",
+              "ExecuteBatch, found ", response->value_ref_size())));
+        } else {
+          sent_batch->Complete(std::vector<v0::ValueRef>(
+              std::make_move_iterator(response->mutable_value_ref()->begin()),
+              std::make_move_iterator(response->mutable_value_ref()->end())));
+        }
+      });
+}
+
+absl::StatusOr<ValueFuture> BatchingRemoteExecutor::CreateExecutorValue(
+    const v0::Value& value_pb) {
+  TFF_TRY(EnsureInitialized());
+  v0::ExecuteBatchRequest::Operation operation;
+  *operation.mutable_create_value()->mutable_value() = value_pb;
+  return AddOperation(std::move(operation), {});
+}
+
+absl::StatusOr<ValueFuture> BatchingRemoteExecutor::CreateCall(
+    ValueFuture function, std::optional<ValueFuture> argument) {
+  TFF_TRY(EnsureInitialized());
+  v0::ExecuteBatchRequest::Operation operation;
+  v0::ExecuteBatchRequest::CreateCall* create_call =
+      operation.mutable_create_call();
+  std::vector<OperationInput> inputs;
+  std::shared_ptr<ExecutorValue> fn = TFF_TRY(Wait(function));
+  inputs.push_back({std::move(fn), create_call->mutable_function_ref()});
+  if (argument.has_value()) {
+    std::shared_ptr<ExecutorValue> arg_value = TFF_TRY(Wait(*argument));
+    inputs.push_back(
+        {std::move(arg_value), create_call->mutable_argument_ref()});
+  }
+  return AddOperation(std::move(operation), std::move(inputs));
+}
+
+absl::StatusOr<ValueFuture> BatchingRemoteExecutor::CreateStruct(
+    std::vector<ValueFuture> members) {
+  TFF_TRY(EnsureInitialized());
+  std::vector<std::shared_ptr<ExecutorValue>> values =
+      TFF_TRY(WaitAll(members));
+  v0::ExecuteBatchRequest::Operation operation;
+  v0::ExecuteBatchRequest::CreateStruct* create_struct =
+      operation.mutable_create_struct();
+  std::vector<OperationInput> inputs;
+  inputs.reserve(values.size());
+  for (std::shared_ptr<ExecutorValue>& element : values) {
+    inputs.push_back({std::move(element),
+                      create_struct->add_element()->mutable_value_ref()});
+  }
+  return AddOperation(std::move(operation), std::move(inputs));
+}
+
+absl::StatusOr<ValueFuture> BatchingRemoteExecutor::CreateSelection(
+    ValueFuture value, const uint32_t index) {
+  TFF_TRY(EnsureInitialized());
+  v0::ExecuteBatchRequest::Operation operation;
+  v0::ExecuteBatchRequest::CreateSelection* create_selection =
+      operation.mutable_create_selection();
+  create_selection->set_index(index);
+  std::shared_ptr<ExecutorValue> source_value = TFF_TRY(Wait(value));
+  std::vector<OperationInput> inputs;
+  inputs.push_back(
+      {std::move(source_value), create_selection->mutable_source_ref()});
+  return AddOperation(std::move(operation), std::move(inputs));
+}
+
+absl::Status BatchingRemoteExecutor::Materialize(ValueFuture value,
+                                                 v0::Value* value_pb) {
+  std::shared_ptr<ExecutorValue> executor_value = TFF_TRY(Wait(value));
+  Flush(executor_value->batch());
+  v0::ComputeRequest request;
+  *request.mutable_executor() = executor_pb_;
+  *request.mutable_value_ref() = TFF_TRY(executor_value->WaitForRef());
+
+  v0::ComputeResponse compute_response;
+  grpc::ClientContext client_context;
+  grpc::Status status =
+      stub_->Compute(&client_context, request, &compute_response);
+  *value_pb = std::move(*compute_response.mutable_value());
+  return grpc_to_absl(status);
+}
+
+}  // namespace
+
+std::shared_ptr<Executor> CreateBatchingRemoteExecutor(
+    std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
+    const CardinalityMap& cardinalities, int32_t max_batch_size) {
+  return std::make_shared<BatchingRemoteExecutor>(
+      std::move(stub), cardinalities, max_batch_size);
+}
+
+std::shared_ptr<Executor> CreateBatchingRemoteExecutor(
+    std::shared_ptr<grpc::ChannelInterface> channel,
+    const CardinalityMap& cardinalities, int32_t max_batch_size) {
+  std::unique_ptr<v0::ExecutorGroup::StubInterface> stub(
+      v0::ExecutorGroup::NewStub(channel));
+  return std::make_shared<BatchingRemoteExecutor>(
+      std::move(stub), cardinalities, max_batch_size);
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,53 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_BATCHING_REMOTE_EXECUTOR_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_BATCHING_REMOTE_EXECUTOR_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "include/grpcpp/grpcpp.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+
+namespace tensorflow_federated {
+
+inline constexpr int32_t kDefaultMaxOperationBatchSize = 1000;
+
+// Returns an executor which communicates with a remote executor service.
+//
+// This executor differs from `RemoteExecutor` by buffering the `Create...`
+// operations instead of sending each of them in its own request. Buffered
+// operations are sent in a single `ExecuteBatch` request once a value they
+// produce is materialized, or once `max_batch_size` operations are buffered,
+// so that a chain of operations only pays the network latency once.
+//
+// The remote service must implement `ExecuteBatch`. Errors of the operations
+// are reported when materializing their results, or when using them in
+// operations of later batches.
+std::shared_ptr<Executor> CreateBatchingRemoteExecutor(
+    std::shared_ptr<grpc::ChannelInterface> channel,
+    const CardinalityMap& cardinalities,
+    int32_t max_batch_size = kDefaultMaxOperationBatchSize);
+std::shared_ptr<Executor> CreateBatchingRemoteExecutor(
+    std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
+    const CardinalityMap& cardinalities,
+    int32_t max_batch_size = kDefaultMaxOperationBatchSize);
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_BATCHING_REMOTE_EXECUTOR_H_
@@ -0,0 +1,280 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/batching_remote_executor.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/support/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_grpc.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using testing::EqualsProto;
+using testing::proto::IgnoringRepeatedFieldOrdering;
+
+constexpr char kExecutorId[] = "executor_id";
+
+constexpr char kExpectedGetExecutorRequest[] = R"pb(
+  cardinalities {
+    placement { uri: "clients" }
+    cardinality: 1
+  }
+  cardinalities {
+    placement { uri: "server" }
+    cardinality: 1
+  }
+)pb";
+
+auto ReturnOkWithValueRefs(const std::vector<std::string>& ids) {
+  v0::ExecuteBatchResponse response;
+  for (const std::string& id : ids) {
+    response.add_value_ref()->set_id(id);
+  }
+  return ::testing::DoAll(::testing::SetArgPointee<2>(response),
+                          ::testing::Return(grpc::Status::OK));
+}
+
+auto ReturnOkWithComputeResponse(const v0::Value& value_pb) {
+  v0::ComputeResponse response;
+  *response.mutable_value() = value_pb;
+  return ::testing::DoAll(::testing::SetArgPointee<2>(response),
+                          ::testing::Return(grpc::Status::OK));
+}
+
+v0::ComputeRequest ComputeRequestForId(std::string ref) {
+  v0::ComputeRequest request;
+  request.mutable_executor()->set_id(kExecutorId);
+  request.mutable_value_ref()->set_id(std::move(ref));
+  return request;
+}
+
+void AddCreateValue(const v0::Value& value_pb,
+                    v0::ExecuteBatchRequest& request) {
+  *request.add_operation()->mutable_create_value()->mutable_value() = value_pb;
+}
+
+std::function<grpc::Status()> NotifyAndReturnOk(
+    absl::Notification& done_notification) {
+  return [&done_notification] {
+    done_notification.Notify();
+    return grpc::Status::OK;
+  };
+}
+
+class BatchingRemoteExecutorTest : public ::testing::Test {
+ protected:
+  BatchingRemoteExecutorTest()
+      : mock_executor_service_(mock_executor_.service()) {}
+  ~BatchingRemoteExecutorTest() override { test_executor_ = nullptr; }
+
+  void CreateTestExecutor(
+      int32_t max_batch_size = kDefaultMaxOperationBatchSize) {
+    std::unique_ptr<v0::ExecutorGroup::Stub> stub_ptr(mock_executor_.NewStub());
+    CardinalityMap cardinalities = {{"server", 1}, {"clients", 1}};
+    test_executor_ = CreateBatchingRemoteExecutor(
+        std::move(stub_ptr), cardinalities, max_batch_size);
+  }
+
+  // Adds expectations of calls to `GetExecutor` and `DisposeExecutor`, and
+  // allows any number of `Dispose` calls. `dispose_notification_out` notifies
+  // when `DisposeExecutor` is called.
+  //
+  // Tests which call this method should end with a call to
+  // `WaitForDisposeExecutor`.
+  void ExpectGetAndDisposeExecutor(
+      absl::Notification& dispose_notification_out) {
+    v0::GetExecutorResponse get_response;
+    *get_response.mutable_executor()->mutable_id() = kExecutorId;
+    EXPECT_CALL(*mock_executor_service_,
+                GetExecutor(::testing::_,
+                            IgnoringRepeatedFieldOrdering(
+                                EqualsProto(kExpectedGetExecutorRequest)),
+                            ::testing::_))
+        .WillOnce(::testing::DoAll(::testing::SetArgPointee<2>(get_response),
+                                   ::testing::Return(grpc::Status::OK)));
+    EXPECT_CALL(*mock_executor_service_, Dispose)
+        .WillRepeatedly(::testing::Return(grpc::Status::OK));
+
+    v0::DisposeExecutorRequest dispose_request;
+    *dispose_request.mutable_executor()->mutable_id() = kExecutorId;
+    EXPECT_CALL(*mock_executor_service_,
+                DisposeExecutor(::testing::_, EqualsProto(dispose_request),
+                                ::testing::_))
+        .WillOnce(NotifyAndReturnOk(dispose_notification_out));
+  }
+
+  void WaitForDisposeExecutor(absl::Notification& notification) {
+    test_executor_ = nullptr;
+    while (!notification.WaitForNotificationWithTimeout(absl::Seconds(1))) {
+      LOG(WARNING) << "Waiting for call to `DisposeExecutor`...";
+    }
+  }
+
+  MockGrpcExecutorServer mock_executor_;
+  MockGrpcExecutorService* mock_executor_service_;
+  std::shared_ptr<Executor> test_executor_;
+};
+
+TEST_F(BatchingRemoteExecutorTest, SendsChainOfOperationsInOneBatch) {
+  CreateTestExecutor();
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+  v0::Value fn_value = testing::IntrinsicV("federated_sum");
+  v0::Value arg_value = testing::TensorV(2.0f);
+  v0::Value expected_result = testing::TensorV(4.0f);
+
+  v0::ExecuteBatchRequest expected_request;
+  expected_request.mutable_executor()->set_id(kExecutorId);
+  AddCreateValue(fn_value, expected_request);
+  AddCreateValue(arg_value, expected_request);
+  v0::ExecuteBatchRequest::CreateCall* create_call =
+      expected_request.add_operation()->mutable_create_call();
+  create_call->mutable_function_ref()->set_operation_index(0);
+  create_call->mutable_argument_ref()->set_operation_index(1);
+  EXPECT_CALL(*mock_executor_service_,
+              ExecuteBatch(::testing::_, EqualsProto(expected_request),
+                           ::testing::_))
+      .WillOnce(ReturnOkWithValueRefs({"fn_ref", "arg_ref", "call_ref"}));
+  EXPECT_CALL(*mock_executor_service_,
+              Compute(::testing::_,
+                      EqualsProto(ComputeRequestForId("call_ref")),
+                      ::testing::_))
+      .WillOnce(ReturnOkWithComputeResponse(expected_result));
+
+  {
+    OwnedValueId fn = TFF_ASSERT_OK(test_executor_->CreateValue(fn_value));
+    OwnedValueId arg = TFF_ASSERT_OK(test_executor_->CreateValue(arg_value));
+    OwnedValueId call = TFF_ASSERT_OK(test_executor_->CreateCall(fn, arg));
+    v0::Value materialized_value;
+    TFF_ASSERT_OK(test_executor_->Materialize(call, &materialized_value));
+    EXPECT_THAT(materialized_value, EqualsProto(expected_result));
+  }
+  WaitForDisposeExecutor(dispose_notification);
+}
+
+TEST_F(BatchingRemoteExecutorTest, LaterBatchRefersToValueRefs) {
+  CreateTestExecutor();
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+  v0::Value struct_value =
+      testing::StructV({testing::TensorV(1.0f), testing::TensorV(2.0f)});
+  v0::Value expected_result = testing::TensorV(1.0f);
+
+  v0::ExecuteBatchRequest first_request;
+  first_request.mutable_executor()->set_id(kExecutorId);
+  AddCreateValue(struct_value, first_request);
+  v0::ExecuteBatchRequest second_request;
+  second_request.mutable_executor()->set_id(kExecutorId);
+  v0::ExecuteBatchRequest::CreateSelection* create_selection =
+      second_request.add_operation()->mutable_create_selection();
+  create_selection->mutable_source_ref()->mutable_value_ref()->set_id(
+      "struct_ref");
+  create_selection->set_index(0);
+  {
+    ::testing::InSequence sequence;
+    EXPECT_CALL(*mock_executor_service_,
+                ExecuteBatch(::testing::_, EqualsProto(first_request),
+                             ::testing::_))
+        .WillOnce(ReturnOkWithValueRefs({"struct_ref"}));
+    EXPECT_CALL(*mock_executor_service_,
+                Compute(::testing::_,
+                        EqualsProto(ComputeRequestForId("struct_ref")),
+                        ::testing::_))
+        .WillOnce(ReturnOkWithComputeResponse(struct_value));
+    EXPECT_CALL(*mock_executor_service_,
+                ExecuteBatch(::testing::_, EqualsProto(second_request),
+                             ::testing::_))
+        .WillOnce(ReturnOkWithValueRefs({"selection_ref"}));
+    EXPECT_CALL(*mock_executor_service_,
+                Compute(::testing::_,
+                        EqualsProto(ComputeRequestForId("selection_ref")),
+                        ::testing::_))
+        .WillOnce(ReturnOkWithComputeResponse(expected_result));
+  }
+
+  {
+    OwnedValueId source =
+        TFF_ASSERT_OK(test_executor_->CreateValue(struct_value));
+    v0::Value materialized_value;
+    TFF_ASSERT_OK(test_executor_->Materialize(source, &materialized_value));
+    OwnedValueId selection =
+        TFF_ASSERT_OK(test_executor_->CreateSelection(source, 0));
+    TFF_ASSERT_OK(test_executor_->Materialize(selection, &materialized_value));
+    EXPECT_THAT(materialized_value, EqualsProto(expected_result));
+  }
+  WaitForDisposeExecutor(dispose_notification);
+}
+
+TEST_F(BatchingRemoteExecutorTest, MaterializeReturnsBatchError) {
+  CreateTestExecutor();
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+  EXPECT_CALL(*mock_executor_service_, ExecuteBatch)
+      .WillOnce(::testing::Return(
+          grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "Test")));
+  EXPECT_CALL(*mock_executor_service_, Compute).Times(0);
+
+  {
+    OwnedValueId value =
+        TFF_ASSERT_OK(test_executor_->CreateValue(testing::TensorV(1.0f)));
+    v0::Value materialized_value;
+    EXPECT_THAT(test_executor_->Materialize(value, &materialized_value),
+                StatusIs(absl::StatusCode::kUnimplemented, "Test"));
+  }
+  WaitForDisposeExecutor(dispose_notification);
+}
+
+TEST_F(BatchingRemoteExecutorTest, SendsFullBatchWithoutMaterialize) {
+  CreateTestExecutor(/*max_batch_size=*/2);
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+  absl::Notification batch_sent;
+  EXPECT_CALL(*mock_executor_service_, ExecuteBatch)
+      .WillOnce(::testing::DoAll(
+          ::testing::InvokeWithoutArgs([&batch_sent] { batch_sent.Notify(); }),
+          ReturnOkWithValueRefs({"first_ref", "second_ref"})));
+
+  {
+    OwnedValueId first =
+        TFF_ASSERT_OK(test_executor_->CreateValue(testing::TensorV(1.0f)));
+    OwnedValueId second =
+        TFF_ASSERT_OK(test_executor_->CreateValue(testing::TensorV(2.0f)));
+    EXPECT_TRUE(batch_sent.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  }
+  WaitForDisposeExecutor(dispose_notification);
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -0,0 +1,148 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/caching_data_backend.h"
+
+#include <cstdint>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+#include "tensorflow_federated/cc/core/impl/executors/data_backend.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// Returns the key under which the value of `data_reference` is cached: the
+// content hash of the data computation which references it.
+std::string CacheKey(const v0::Data& data_reference,
+                     const v0::Type& data_type) {
+  v0::Value value_pb;
+  v0::Computation* computation_pb = value_pb.mutable_computation();
+  *computation_pb->mutable_type() = data_type;
+  *computation_pb->mutable_data() = data_reference;
+  return ValueContentHash(value_pb);
+}
+
+// Records a lookup of the cache to the default `MetricsRegistry`.
+void RecordLookup(bool hit) {
+  static Counter* const hits =
+      MetricsRegistry::Default().GetCounter("CachingDataBackend::CacheHits");
+  static Counter* const misses =
+      MetricsRegistry::Default().GetCounter("CachingDataBackend::CacheMisses");
+  if (MetricsEnabled()) {
+    (hit ? hits : misses)->Increment();
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<CachingDataBackend> CachingDataBackend::Create(
+    std::shared_ptr<DataBackend> backend, int64_t capacity_bytes,
+    std::shared_ptr<ExecutorRuntime> runtime) {
+  return std::shared_ptr<CachingDataBackend>(new CachingDataBackend(
+      std::move(backend), capacity_bytes, std::move(runtime)));
+}
+
+absl::Status CachingDataBackend::ResolveToValue(const v0::Data& data_reference,
+                                                const v0::Type& data_type,
+                                                v0::Value& value_out) {
+  std::shared_ptr<const v0::Value> value_pb = TFF_TRY(
+      Wait(Resolve(data_reference, data_type, /*in_background=*/false)));
+  value_out = *value_pb;
+  return absl::OkStatus();
+}
+
+void CachingDataBackend::Prefetch(const v0::Data& data_reference,
+                                  const v0::Type& data_type) {
+  Resolve(data_reference, data_type, /*in_background=*/true);
+}
+
+CachingDataBackend::ValueFuture CachingDataBackend::Resolve(
+    const v0::Data& data_reference, const v0::Type& data_type,
+    bool in_background) {
+  std::string key = CacheKey(data_reference, data_type);
+  std::shared_ptr<const v0::Value> cached = cache_.Lookup(key);
+  std::promise<absl::StatusOr<std::shared_ptr<const v0::Value>>> promise;
+  ValueFuture future = promise.get_future().share();
+  {
+    absl::MutexLock lock(&mutex_);
+    if (cached == nullptr) {
+      auto it = in_flight_.find(key);
+      if (it != in_flight_.end()) {
+        RecordLookup(/*hit=*/true);
+        return it->second;
+      }
+      // A resolution may have completed since the lookup above. Resolutions
+      // are cached before they are removed from `in_flight_`, so looking up the
+      // cache again under `mutex_` can't miss one.
+      cached = cache_.Lookup(key);
+    }
+    RecordLookup(/*hit=*/cached != nullptr);
+    if (cached != nullptr) {
+      return ReadyFuture(std::move(cached));
+    }
+    in_flight_.emplace(key, future);
+  }
+  auto resolve = [this_keepalive = shared_from_this(), key = std::move(key),
+                  data_reference, data_type,
+                  promise = std::move(promise)]() mutable {
+    promise.set_value(
+        this_keepalive->ResolveUncached(key, data_reference, data_type));
+  };
+  if (in_background) {
+    ThreadRun(std::move(resolve),
+              runtime_ != nullptr ? runtime_->pool(ExecutorLane::kIo)
+                                  : nullptr);
+  } else {
+    resolve();
+  }
+  return future;
+}
+
+absl::StatusOr<std::shared_ptr<const v0::Value>>
+CachingDataBackend::ResolveUncached(const std::string& key,
+                                    const v0::Data& data_reference,
+                                    const v0::Type& data_type) {
+  absl::StatusOr<v0::Value> value_pb =
+      backend_->ResolveToValue(data_reference, data_type);
+  std::shared_ptr<const v0::Value> resolved;
+  if (value_pb.ok()) {
+    resolved = std::make_shared<const v0::Value>(std::move(value_pb).value());
+    cache_.Insert(key, resolved);
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    in_flight_.erase(key);
+  }
+  if (!value_pb.ok()) {
+    return value_pb.status();
+  }
+  return resolved;
+}
+
+}  // namespace tensorflow_federated
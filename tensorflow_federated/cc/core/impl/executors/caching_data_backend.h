@@ -0,0 +1,111 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CACHING_DATA_BACKEND_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CACHING_DATA_BACKEND_H_
+
+#include <cstdint>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/executors/data_backend.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+// A `DataBackend` which caches the values resolved by another backend, so that
+// data referenced by many clients, or in many rounds, is only resolved once.
+//
+// Resolved values are cached by their data reference and type in a
+// `ValueCache`, which evicts the least recently used values once their total
+// serialized size exceeds `capacity_bytes`. Concurrent resolutions of the same
+// reference share a single call into the wrapped backend. Failed resolutions
+// are not cached.
+//
+// This class is thread safe.
+class CachingDataBackend
+    : public DataBackend,
+      public std::enable_shared_from_this<CachingDataBackend> {
+ public:
+  // Returns a backend caching the values resolved by `backend`.
+  //
+  // `Prefetch` resolves values on the I/O lane of `runtime` if it is not null,
+  // and on new threads otherwise.
+  static std::shared_ptr<CachingDataBackend> Create(
+      std::shared_ptr<DataBackend> backend, int64_t capacity_bytes,
+      std::shared_ptr<ExecutorRuntime> runtime = nullptr);
+
+  CachingDataBackend(const CachingDataBackend&) = delete;
+  CachingDataBackend& operator=(const CachingDataBackend&) = delete;
+
+  absl::Status ResolveToValue(const v0::Data& data_reference,
+                              const v0::Type& data_type,
+                              v0::Value& value_out) final
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Starts resolving `data_reference` in the background unless it is cached
+  // or already being resolved, e.g. for the data of the next round while the
+  // current one runs. A later `ResolveToValue` of the reference waits for the
+  // resolution instead of starting another one.
+  void Prefetch(const v0::Data& data_reference, const v0::Type& data_type)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  int64_t cache_size_bytes() const { return cache_.size_bytes(); }
+
+ private:
+  using ValueFuture =
+      std::shared_future<absl::StatusOr<std::shared_ptr<const v0::Value>>>;
+
+  CachingDataBackend(std::shared_ptr<DataBackend> backend,
+                     int64_t capacity_bytes,
+                     std::shared_ptr<ExecutorRuntime> runtime)
+      : backend_(std::move(backend)),
+        runtime_(std::move(runtime)),
+        cache_(capacity_bytes) {}
+
+  // Returns the cached value of `data_reference`, or a future to the
+  // resolution in flight. Otherwise starts resolving it, on the calling thread
+  // unless `in_background`.
+  ValueFuture Resolve(const v0::Data& data_reference,
+                      const v0::Type& data_type, bool in_background)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Resolves a value with the wrapped backend and caches it.
+  absl::StatusOr<std::shared_ptr<const v0::Value>> ResolveUncached(
+      const std::string& key, const v0::Data& data_reference,
+      const v0::Type& data_type) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  const std::shared_ptr<DataBackend> backend_;
+  const std::shared_ptr<ExecutorRuntime> runtime_;
+  ValueCache cache_;
+  absl::Mutex mutex_;
+  // The resolutions in flight, by cache key.
+  absl::flat_hash_map<std::string, ValueFuture> in_flight_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CACHING_DATA_BACKEND_H_
@@ -0,0 +1,160 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/caching_data_backend.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/notification.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_data_backend.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/data_type.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgReferee;
+using ::testing::StrictMock;
+using testing::EqualsProto;
+using testing::TensorV;
+
+constexpr int64_t kCapacityBytes = 1 << 20;
+
+v0::Data DataReference(std::string uri) {
+  v0::Data data;
+  data.set_uri(std::move(uri));
+  return data;
+}
+
+v0::Type TensorType(v0::DataType dtype) {
+  v0::Type type;
+  type.mutable_tensor()->set_dtype(dtype);
+  return type;
+}
+
+class CachingDataBackendTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<StrictMock<MockDataBackend>> mock_backend_ =
+      std::make_shared<StrictMock<MockDataBackend>>();
+};
+
+TEST_F(CachingDataBackendTest, ResolvesRepeatedReferenceOnce) {
+  auto backend = CachingDataBackend::Create(mock_backend_, kCapacityBytes);
+  const v0::Type type = TensorType(v0::DataType::DT_INT32);
+  mock_backend_->ExpectResolveToValue("some_uri", type, TensorV(22));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_THAT(backend->ResolveToValue(DataReference("some_uri"), type),
+                IsOkAndHolds(EqualsProto(TensorV(22))));
+  }
+  EXPECT_EQ(backend->cache_size_bytes(), TensorV(22).ByteSizeLong());
+}
+
+TEST_F(CachingDataBackendTest, CachesReferencesByType) {
+  auto backend = CachingDataBackend::Create(mock_backend_, kCapacityBytes);
+  const v0::Type int_type = TensorType(v0::DataType::DT_INT32);
+  const v0::Type float_type = TensorType(v0::DataType::DT_FLOAT);
+  mock_backend_->ExpectResolveToValue("some_uri", int_type, TensorV(22));
+  mock_backend_->ExpectResolveToValue("some_uri", float_type, TensorV(2.0f));
+  EXPECT_THAT(backend->ResolveToValue(DataReference("some_uri"), int_type),
+              IsOkAndHolds(EqualsProto(TensorV(22))));
+  EXPECT_THAT(backend->ResolveToValue(DataReference("some_uri"), float_type),
+              IsOkAndHolds(EqualsProto(TensorV(2.0f))));
+}
+
+TEST_F(CachingDataBackendTest, DoesNotCacheErrors) {
+  auto backend = CachingDataBackend::Create(mock_backend_, kCapacityBytes);
+  const v0::Type type = TensorType(v0::DataType::DT_INT32);
+  EXPECT_CALL(*mock_backend_, ResolveToValue(EqualsProto(DataReference("uri")),
+                                             EqualsProto(type), _))
+      .WillOnce(Return(absl::UnavailableError("storage is down")))
+      .WillOnce(DoAll(SetArgReferee<2>(TensorV(22)), Return(absl::OkStatus())));
+  EXPECT_THAT(backend->ResolveToValue(DataReference("uri"), type),
+              StatusIs(absl::StatusCode::kUnavailable));
+  EXPECT_THAT(backend->ResolveToValue(DataReference("uri"), type),
+              IsOkAndHolds(EqualsProto(TensorV(22))));
+}
+
+TEST_F(CachingDataBackendTest, EvictsLeastRecentlyUsedValue) {
+  auto backend = CachingDataBackend::Create(
+      mock_backend_, /*capacity_bytes=*/TensorV(1).ByteSizeLong());
+  const v0::Type type = TensorType(v0::DataType::DT_INT32);
+  EXPECT_CALL(*mock_backend_,
+              ResolveToValue(EqualsProto(DataReference("first")),
+                             EqualsProto(type), _))
+      .Times(2)
+      .WillRepeatedly(
+          DoAll(SetArgReferee<2>(TensorV(1)), Return(absl::OkStatus())));
+  mock_backend_->ExpectResolveToValue("second", type, TensorV(2));
+  EXPECT_THAT(backend->ResolveToValue(DataReference("first"), type),
+              IsOkAndHolds(EqualsProto(TensorV(1))));
+  EXPECT_THAT(backend->ResolveToValue(DataReference("second"), type),
+              IsOkAndHolds(EqualsProto(TensorV(2))));
+  EXPECT_THAT(backend->ResolveToValue(DataReference("first"), type),
+              IsOkAndHolds(EqualsProto(TensorV(1))));
+}
+
+TEST_F(CachingDataBackendTest, ResolvesPrefetchedReferenceOnce) {
+  auto backend = CachingDataBackend::Create(mock_backend_, kCapacityBytes);
+  const v0::Type type = TensorType(v0::DataType::DT_INT32);
+  mock_backend_->ExpectResolveToValue("some_uri", type, TensorV(22));
+  backend->Prefetch(DataReference("some_uri"), type);
+  EXPECT_THAT(backend->ResolveToValue(DataReference("some_uri"), type),
+              IsOkAndHolds(EqualsProto(TensorV(22))));
+}
+
+TEST_F(CachingDataBackendTest, ConcurrentResolutionsShareOneCall) {
+  auto backend = CachingDataBackend::Create(mock_backend_, kCapacityBytes);
+  const v0::Type type = TensorType(v0::DataType::DT_INT32);
+  absl::Notification resolution_started;
+  absl::Notification resolution_unblocked;
+  EXPECT_CALL(*mock_backend_,
+              ResolveToValue(EqualsProto(DataReference("some_uri")),
+                             EqualsProto(type), _))
+      .WillOnce([&](const v0::Data&, const v0::Type&, v0::Value& value_out) {
+        resolution_started.Notify();
+        resolution_unblocked.WaitForNotification();
+        value_out = TensorV(22);
+        return absl::OkStatus();
+      });
+  std::thread first([&]() {
+    EXPECT_THAT(backend->ResolveToValue(DataReference("some_uri"), type),
+                IsOkAndHolds(EqualsProto(TensorV(22))));
+  });
+  resolution_started.WaitForNotification();
+  std::thread second([&]() {
+    EXPECT_THAT(backend->ResolveToValue(DataReference("some_uri"), type),
+                IsOkAndHolds(EqualsProto(TensorV(22))));
+  });
+  resolution_unblocked.Notify();
+  first.join();
+  second.join();
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
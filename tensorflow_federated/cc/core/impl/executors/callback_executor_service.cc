@@ -0,0 +1,175 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/callback_executor_service.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/grpcpp.h"
+#include "include/grpcpp/support/status.h"
+#include "include/grpcpp/support/sync_stream.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_service.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+CallbackExecutorService::CallbackExecutorService(
+    const ExecutorFactory& executor_factory, int32_t num_threads,
+    ExecutorServiceOptions options)
+    : service_(executor_factory, std::move(options)),
+      pool_(num_threads, "executor-service-callback",
+            ThreadPoolPolicy::kWorkStealing) {
+  SetMessageAllocatorFor_CreateValue(&create_value_allocator_);
+  SetMessageAllocatorFor_GetCachedValue(&get_cached_value_allocator_);
+}
+
+template <typename Handler>
+grpc::ServerUnaryReactor* CallbackExecutorService::Run(
+    grpc::CallbackServerContext* context, Handler handler) {
+  grpc::ServerUnaryReactor* reactor = context->DefaultReactor();
+  absl::Status status =
+      pool_.Schedule([reactor, handler = std::move(handler)]() mutable {
+        // The handlers of `ExecutorService` only use their context for its
+        // deadline, which `GetCachedValue` passes explicitly.
+        grpc::ServerContext unused_context;
+        reactor->Finish(handler(&unused_context));
+      });
+  if (!status.ok()) {
+    reactor->Finish(absl_to_grpc(status));
+  }
+  return reactor;
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::GetExecutor(
+    grpc::CallbackServerContext* context, const v0::GetExecutorRequest* request,
+    v0::GetExecutorResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.GetExecutor(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::CreateValue(
+    grpc::CallbackServerContext* context, const v0::CreateValueRequest* request,
+    v0::CreateValueResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.CreateValue(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::CreateCall(
+    grpc::CallbackServerContext* context, const v0::CreateCallRequest* request,
+    v0::CreateCallResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.CreateCall(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::CreateStruct(
+    grpc::CallbackServerContext* context,
+    const v0::CreateStructRequest* request,
+    v0::CreateStructResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.CreateStruct(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::CreateSelection(
+    grpc::CallbackServerContext* context,
+    const v0::CreateSelectionRequest* request,
+    v0::CreateSelectionResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.CreateSelection(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::Compute(
+    grpc::CallbackServerContext* context, const v0::ComputeRequest* request,
+    v0::ComputeResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.Compute(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::ExecuteBatch(
+    grpc::CallbackServerContext* context,
+    const v0::ExecuteBatchRequest* request,
+    v0::ExecuteBatchResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.ExecuteBatch(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::Dispose(
+    grpc::CallbackServerContext* context, const v0::DisposeRequest* request,
+    v0::DisposeResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.Dispose(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::DisposeExecutor(
+    grpc::CallbackServerContext* context,
+    const v0::DisposeExecutorRequest* request,
+    v0::DisposeExecutorResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.DisposeExecutor(ctx, request, response);
+  });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::GetCachedValue(
+    grpc::CallbackServerContext* context,
+    const v0::GetCachedValueRequest* request,
+    v0::GetCachedValueResponse* response) {
+  const absl::Time deadline = absl::FromChrono(context->deadline());
+  return Run(context,
+             [this, deadline, request, response](grpc::ServerContext*) {
+               return service_.GetCachedValueUntil(deadline, request, response);
+             });
+}
+
+grpc::ServerUnaryReactor* CallbackExecutorService::SnapshotValue(
+    grpc::CallbackServerContext* context,
+    const v0::SnapshotValueRequest* request,
+    v0::SnapshotValueResponse* response) {
+  return Run(context, [this, request, response](grpc::ServerContext* ctx) {
+    return service_.SnapshotValue(ctx, request, response);
+  });
+}
+
+grpc::Status CallbackExecutorService::CreateValueStream(
+    grpc::ServerContext* context,
+    grpc::ServerReader<v0::CreateValueStreamRequest>* reader,
+    v0::CreateValueResponse* response) {
+  return service_.CreateValueFromStream(context, reader, response);
+}
+
+grpc::Status CallbackExecutorService::ComputeStream(
+    grpc::ServerContext* context, const v0::ComputeRequest* request,
+    grpc::ServerWriter<v0::ComputeStreamResponse>* writer) {
+  return service_.ComputeToStream(context, request, writer);
+}
+
+grpc::Status CallbackExecutorService::GetLocalityKeys(
+    grpc::ServerContext* context, const v0::GetLocalityKeysRequest* request,
+    v0::GetLocalityKeysResponse* response) {
+  return service_.GetLocalityKeys(context, request, response);
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,191 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CALLBACK_EXECUTOR_SERVICE_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CALLBACK_EXECUTOR_SERVICE_H_
+
+#include <cstdint>
+
+#include "google/protobuf/arena.h"
+#include "absl/status/status.h"
+#include "include/grpcpp/grpcpp.h"
+#include "include/grpcpp/support/message_allocator.h"
+#include "include/grpcpp/support/status.h"
+#include "include/grpcpp/support/sync_stream.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_service.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace internal {
+
+using ExecutorGroup = v0::ExecutorGroup;
+
+// The `ExecutorGroup` service, with its unary methods served through the gRPC
+// callback API and its streaming methods served synchronously.
+// clang-format off
+using UnaryCallbackExecutorGroupService =
+    ExecutorGroup::WithCallbackMethod_GetExecutor<
+    ExecutorGroup::WithCallbackMethod_CreateValue<
+    ExecutorGroup::WithCallbackMethod_CreateCall<
+    ExecutorGroup::WithCallbackMethod_CreateStruct<
+    ExecutorGroup::WithCallbackMethod_CreateSelection<
+    ExecutorGroup::WithCallbackMethod_Compute<
+    ExecutorGroup::WithCallbackMethod_ExecuteBatch<
+    ExecutorGroup::WithCallbackMethod_Dispose<
+    ExecutorGroup::WithCallbackMethod_DisposeExecutor<
+    ExecutorGroup::WithCallbackMethod_GetCachedValue<
+    ExecutorGroup::WithCallbackMethod_SnapshotValue<
+    ExecutorGroup::Service>>>>>>>>>>>;
+// clang-format on
+
+// Allocates the request and response of each call on an arena which lives as
+// long as the call, so that their deep values are allocated in a few blocks
+// and freed at once.
+template <typename Request, typename Response>
+class ArenaMessageAllocator : public grpc::MessageAllocator<Request, Response> {
+ public:
+  grpc::MessageHolder<Request, Response>* AllocateMessages() override {
+    return new ArenaMessageHolder();
+  }
+
+ private:
+  class ArenaMessageHolder : public grpc::MessageHolder<Request, Response> {
+   public:
+    ArenaMessageHolder() {
+      this->set_request(
+          google::protobuf::Arena::CreateMessage<Request>(&arena_));
+      this->set_response(
+          google::protobuf::Arena::CreateMessage<Response>(&arena_));
+    }
+
+    void Release() override { delete this; }
+
+   private:
+    google::protobuf::Arena arena_;
+  };
+};
+
+}  // namespace internal
+
+// Serves an `ExecutorService` with the gRPC callback API.
+//
+// The synchronous server dedicates a polling thread to each call in flight,
+// so that blocking calls such as `Compute` cap the throughput of the server
+// at its number of polling threads. This service instead returns from the
+// unary methods right away and runs their handlers on a pool of
+// `num_threads` threads, so that the polling threads are never blocked and
+// the pool alone bounds the calls in flight.
+//
+// Streaming methods are rare and long-lived, and are still served
+// synchronously.
+//
+// The messages of the methods which carry values are allocated on a per-call
+// arena.
+class CallbackExecutorService
+    : public internal::UnaryCallbackExecutorGroupService {
+ public:
+  CallbackExecutorService(
+      const ExecutorFactory& executor_factory, int32_t num_threads,
+      ExecutorServiceOptions options = ExecutorServiceOptions());
+  ~CallbackExecutorService() override = default;
+
+  // See `ExecutorService::WarmUp`.
+  absl::Status WarmUp(const CardinalityMap& cardinalities) {
+    return service_.WarmUp(cardinalities);
+  }
+
+  grpc::ServerUnaryReactor* GetExecutor(
+      grpc::CallbackServerContext* context,
+      const v0::GetExecutorRequest* request,
+      v0::GetExecutorResponse* response) override;
+  grpc::ServerUnaryReactor* CreateValue(
+      grpc::CallbackServerContext* context,
+      const v0::CreateValueRequest* request,
+      v0::CreateValueResponse* response) override;
+  grpc::ServerUnaryReactor* CreateCall(
+      grpc::CallbackServerContext* context,
+      const v0::CreateCallRequest* request,
+      v0::CreateCallResponse* response) override;
+  grpc::ServerUnaryReactor* CreateStruct(
+      grpc::CallbackServerContext* context,
+      const v0::CreateStructRequest* request,
+      v0::CreateStructResponse* response) override;
+  grpc::ServerUnaryReactor* CreateSelection(
+      grpc::CallbackServerContext* context,
+      const v0::CreateSelectionRequest* request,
+      v0::CreateSelectionResponse* response) override;
+  grpc::ServerUnaryReactor* Compute(grpc::CallbackServerContext* context,
+                                    const v0::ComputeRequest* request,
+                                    v0::ComputeResponse* response) override;
+  grpc::ServerUnaryReactor* ExecuteBatch(
+      grpc::CallbackServerContext* context,
+      const v0::ExecuteBatchRequest* request,
+      v0::ExecuteBatchResponse* response) override;
+  grpc::ServerUnaryReactor* Dispose(grpc::CallbackServerContext* context,
+                                    const v0::DisposeRequest* request,
+                                    v0::DisposeResponse* response) override;
+  grpc::ServerUnaryReactor* DisposeExecutor(
+      grpc::CallbackServerContext* context,
+      const v0::DisposeExecutorRequest* request,
+      v0::DisposeExecutorResponse* response) override;
+  grpc::ServerUnaryReactor* GetCachedValue(
+      grpc::CallbackServerContext* context,
+      const v0::GetCachedValueRequest* request,
+      v0::GetCachedValueResponse* response) override;
+  grpc::ServerUnaryReactor* SnapshotValue(
+      grpc::CallbackServerContext* context,
+      const v0::SnapshotValueRequest* request,
+      v0::SnapshotValueResponse* response) override;
+
+  grpc::Status CreateValueStream(
+      grpc::ServerContext* context,
+      grpc::ServerReader<v0::CreateValueStreamRequest>* reader,
+      v0::CreateValueResponse* response) override;
+  grpc::Status ComputeStream(
+      grpc::ServerContext* context, const v0::ComputeRequest* request,
+      grpc::ServerWriter<v0::ComputeStreamResponse>* writer) override;
+  // Served synchronously, since it is only called when stacks are built.
+  grpc::Status GetLocalityKeys(grpc::ServerContext* context,
+                               const v0::GetLocalityKeysRequest* request,
+                               v0::GetLocalityKeysResponse* response) override;
+
+ private:
+  // Runs `handler` on `pool_` and finishes the call with its status.
+  template <typename Handler>
+  grpc::ServerUnaryReactor* Run(grpc::CallbackServerContext* context,
+                                Handler handler);
+
+  // The allocators of the methods which copy values into or out of their
+  // messages. The responses of `Compute` and `ExecuteBatch` are left on the
+  // heap, since executors move the values they materialize into them, which
+  // would copy across arenas.
+  internal::ArenaMessageAllocator<v0::CreateValueRequest,
+                                  v0::CreateValueResponse>
+      create_value_allocator_;
+  internal::ArenaMessageAllocator<v0::GetCachedValueRequest,
+                                  v0::GetCachedValueResponse>
+      get_cached_value_allocator_;
+  ExecutorService service_;
+  // Destroyed first, so that the handlers it still runs can use `service_`.
+  ThreadPool pool_;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CALLBACK_EXECUTOR_SERVICE_H_
@@ -0,0 +1,124 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/callback_executor_service.h"
+
+#include <memory>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "include/grpcpp/grpcpp.h"
+#include "include/grpcpp/security/credentials.h"
+#include "include/grpcpp/security/server_credentials.h"
+#include "include/grpcpp/server_builder.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::tensorflow_federated::testing::EqualsProto;
+using ::tensorflow_federated::testing::TensorV;
+
+class CallbackExecutorServiceTest : public ::testing::Test {
+ public:
+  CallbackExecutorServiceTest()
+      : service_(
+            [this](const CardinalityMap&) -> std::shared_ptr<Executor> {
+              return executor_;
+            },
+            /*num_threads=*/2),
+        server_(grpc::ServerBuilder()
+                    .AddListeningPort(
+                        "localhost:0",
+                        grpc::experimental::LocalServerCredentials(LOCAL_TCP),
+                        &port_)
+                    .RegisterService(&service_)
+                    .BuildAndStart()),
+        stub_(v0::ExecutorGroup::NewStub(grpc::CreateChannel(
+            absl::StrCat("localhost:", port_),
+            grpc::experimental::LocalCredentials(LOCAL_TCP)))) {}
+
+  ~CallbackExecutorServiceTest() override {
+    server_->Shutdown();
+    server_->Wait();
+  }
+
+ protected:
+  v0::ExecutorId GetExecutor() {
+    v0::GetExecutorRequest request_pb;
+    v0::Cardinality* cardinality = request_pb.add_cardinalities();
+    cardinality->mutable_placement()->set_uri(kClientsUri.data(),
+                                              kClientsUri.size());
+    cardinality->set_cardinality(1);
+    v0::GetExecutorResponse response_pb;
+    grpc::ClientContext context;
+    grpc::Status status =
+        stub_->GetExecutor(&context, request_pb, &response_pb);
+    EXPECT_TRUE(status.ok()) << status.error_message();
+    return response_pb.executor();
+  }
+
+  std::shared_ptr<::testing::StrictMock<MockExecutor>> executor_ =
+      std::make_shared<::testing::StrictMock<MockExecutor>>();
+  CallbackExecutorService service_;
+  int port_ = 0;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<v0::ExecutorGroup::Stub> stub_;
+};
+
+TEST_F(CallbackExecutorServiceTest, CreatesAndComputesValue) {
+  v0::ExecutorId executor_pb = GetExecutor();
+  v0::Value value_pb = TensorV(1.0);
+  ValueId child_id = executor_->ExpectCreateValue(value_pb);
+  executor_->ExpectMaterialize(child_id, value_pb);
+
+  v0::CreateValueRequest create_request_pb;
+  *create_request_pb.mutable_executor() = executor_pb;
+  *create_request_pb.mutable_value() = value_pb;
+  v0::CreateValueResponse create_response_pb;
+  grpc::ClientContext create_context;
+  ASSERT_TRUE(stub_->CreateValue(&create_context, create_request_pb,
+                                 &create_response_pb)
+                  .ok());
+
+  v0::ComputeRequest compute_request_pb;
+  *compute_request_pb.mutable_executor() = executor_pb;
+  *compute_request_pb.mutable_value_ref() = create_response_pb.value_ref();
+  v0::ComputeResponse compute_response_pb;
+  grpc::ClientContext compute_context;
+  ASSERT_TRUE(stub_->Compute(&compute_context, compute_request_pb,
+                             &compute_response_pb)
+                  .ok());
+  EXPECT_THAT(compute_response_pb.value(), EqualsProto(value_pb));
+}
+
+TEST_F(CallbackExecutorServiceTest, ReturnsErrorsOfService) {
+  v0::CreateValueRequest request_pb;
+  *request_pb.mutable_value() = TensorV(1.0);
+  v0::CreateValueResponse response_pb;
+  grpc::ClientContext context;
+  grpc::Status status = stub_->CreateValue(&context, request_pb, &response_pb);
+  EXPECT_EQ(status.error_code(), grpc::StatusCode::FAILED_PRECONDITION);
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
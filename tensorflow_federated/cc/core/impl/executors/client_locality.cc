@@ -0,0 +1,118 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/client_locality.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+std::string DataUri(const v0::Value& value_pb) {
+  if (value_pb.has_computation() && value_pb.computation().has_data()) {
+    return value_pb.computation().data().uri();
+  }
+  if (value_pb.has_struct_()) {
+    for (const v0::Value_Struct_Element& element :
+         value_pb.struct_().element()) {
+      std::string uri = DataUri(element.value());
+      if (!uri.empty()) {
+        return uri;
+      }
+    }
+  }
+  return "";
+}
+
+std::vector<int32_t> AssignClientsByLocality(
+    absl::Span<const std::string> data_uris,
+    absl::Span<const int32_t> shard_sizes,
+    absl::Span<const std::vector<std::string>> shard_locality_keys) {
+  const int32_t num_shards = shard_sizes.size();
+  int64_t num_slots = 0;
+  for (int32_t size : shard_sizes) {
+    num_slots += size;
+  }
+  if (num_slots != static_cast<int64_t>(data_uris.size()) ||
+      shard_locality_keys.size() != shard_sizes.size()) {
+    return {};
+  }
+  std::vector<int32_t> room(shard_sizes.begin(), shard_sizes.end());
+  std::vector<int32_t> shard_of_client(data_uris.size(), -1);
+  bool any_local = false;
+  for (size_t client = 0; client < data_uris.size(); ++client) {
+    const std::string& uri = data_uris[client];
+    if (uri.empty()) {
+      continue;
+    }
+    int32_t best_shard = -1;
+    size_t best_key_size = 0;
+    for (int32_t shard = 0; shard < num_shards; ++shard) {
+      if (room[shard] == 0) {
+        continue;
+      }
+      for (const std::string& key : shard_locality_keys[shard]) {
+        if (!key.empty() && key.size() > best_key_size &&
+            absl::StartsWith(uri, key)) {
+          best_shard = shard;
+          best_key_size = key.size();
+        }
+      }
+    }
+    if (best_shard >= 0) {
+      shard_of_client[client] = best_shard;
+      room[best_shard] -= 1;
+      any_local = true;
+    }
+  }
+  if (!any_local) {
+    return {};
+  }
+  int32_t next_shard = 0;
+  for (int32_t& shard : shard_of_client) {
+    if (shard >= 0) {
+      continue;
+    }
+    while (room[next_shard] == 0) {
+      ++next_shard;
+    }
+    shard = next_shard;
+    room[next_shard] -= 1;
+  }
+  std::vector<int32_t> next_slot(num_shards, 0);
+  for (int32_t shard = 1; shard < num_shards; ++shard) {
+    next_slot[shard] = next_slot[shard - 1] + shard_sizes[shard - 1];
+  }
+  std::vector<int32_t> order(data_uris.size());
+  bool reordered = false;
+  for (size_t client = 0; client < data_uris.size(); ++client) {
+    int32_t slot = next_slot[shard_of_client[client]]++;
+    order[slot] = client;
+    reordered |= slot != static_cast<int32_t>(client);
+  }
+  if (!reordered) {
+    return {};
+  }
+  return order;
+}
+
+}  // namespace tensorflow_federated
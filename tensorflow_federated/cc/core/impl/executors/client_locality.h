@@ -0,0 +1,55 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CLIENT_LOCALITY_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CLIENT_LOCALITY_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+// Returns the URI of the first `v0::Data` reference in `value_pb`, searching
+// the elements of structs in order, or an empty string if there is none.
+std::string DataUri(const v0::Value& value_pb);
+
+// Assigns clients to the shards of a clients-placed value by the locality of
+// their data, e.g. to the children of a `ComposingExecutor` running on workers
+// which have cached some of the data.
+//
+// `data_uris[c]` is the data URI of client `c`, or empty if it has none. Shard
+// `s` holds `shard_sizes[s]` clients, and the data whose URI starts with one of
+// `shard_locality_keys[s]` is local to it. A client is placed in the shard
+// with the longest key matching its URI among those which have room left; the
+// remaining clients fill the remaining room in order. Clients keep their
+// relative order within each shard.
+//
+// Returns the order of the clients across the shards: element `i` is the
+// client placed in slot `i`, where the slots of shard `s` follow those of the
+// shards before it. Returns an empty vector if the order is unchanged, e.g.
+// since no data is local to any shard, or if the sizes of the shards do not
+// add up to the number of clients.
+std::vector<int32_t> AssignClientsByLocality(
+    absl::Span<const std::string> data_uris,
+    absl::Span<const int32_t> shard_sizes,
+    absl::Span<const std::vector<std::string>> shard_locality_keys);
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CLIENT_LOCALITY_H_
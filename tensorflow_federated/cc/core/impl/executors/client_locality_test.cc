@@ -0,0 +1,86 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/client_locality.h"
+
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+
+v0::Value DataValue(const std::string& uri) {
+  v0::Value value_pb;
+  value_pb.mutable_computation()->mutable_data()->set_uri(uri);
+  return value_pb;
+}
+
+TEST(ClientLocalityTest, FindsDataUriInStructs) {
+  v0::Value value_pb;
+  value_pb.mutable_struct_()->add_element()->mutable_value()->mutable_tensor();
+  *value_pb.mutable_struct_()->add_element()->mutable_value() =
+      DataValue("gs://a/0");
+  EXPECT_THAT(DataUri(value_pb), Eq("gs://a/0"));
+  EXPECT_THAT(DataUri(v0::Value()), IsEmpty());
+}
+
+TEST(ClientLocalityTest, PlacesClientsWithTheirData) {
+  // Both shards hold two clients; the data of clients 0 and 2 is local to the
+  // second shard.
+  std::vector<std::string> data_uris = {"gs://b/0", "gs://a/1", "gs://b/2",
+                                        "gs://a/3"};
+  std::vector<int32_t> shard_sizes = {2, 2};
+  std::vector<std::vector<std::string>> keys = {{"gs://a/"}, {"gs://b/"}};
+  EXPECT_THAT(AssignClientsByLocality(data_uris, shard_sizes, keys),
+              ElementsAre(1, 3, 0, 2));
+}
+
+TEST(ClientLocalityTest, PrefersLongestKeyAndFillsRemainingRoom) {
+  std::vector<std::string> data_uris = {"", "gs://a/x/1", "gs://a/x/2",
+                                        "gs://a/x/3"};
+  std::vector<int32_t> shard_sizes = {1, 3};
+  std::vector<std::vector<std::string>> keys = {{"gs://a/x/"}, {"gs://a/"}};
+  // Client 1 takes the only slot of the first shard, whose key is longer, so
+  // clients 2 and 3 are placed in the second shard along with client 0.
+  EXPECT_THAT(AssignClientsByLocality(data_uris, shard_sizes, keys),
+              ElementsAre(1, 0, 2, 3));
+}
+
+TEST(ClientLocalityTest, KeepsOrderWithoutLocalData) {
+  std::vector<std::string> data_uris = {"gs://b/0", "gs://b/1"};
+  std::vector<int32_t> shard_sizes = {1, 1};
+  std::vector<std::vector<std::string>> keys = {{"gs://a/"}, {}};
+  EXPECT_THAT(AssignClientsByLocality(data_uris, shard_sizes, keys),
+              IsEmpty());
+  // The order is kept if the shards do not hold all of the clients.
+  std::vector<int32_t> mismatched_shard_sizes = {1, 2};
+  keys = {{}, {"gs://b/"}};
+  EXPECT_THAT(AssignClientsByLocality(data_uris, mismatched_shard_sizes, keys),
+              IsEmpty());
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
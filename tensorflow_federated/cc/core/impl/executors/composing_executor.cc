@@ -15,10 +15,12 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/composing_executor.h"
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
-#include <future>  // NOLINT
+#include <list>
 #include <memory>
 #include <optional>
 #include <string>
@@ -30,20 +32,26 @@ limitations under the License
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/client_locality.h"
 #include "tensorflow_federated/cc/core/impl/executors/computations.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/federated_intrinsics.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
 #include "tensorflow_federated/cc/core/impl/executors/value_validation.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
@@ -54,7 +62,7 @@ namespace {
 
 class ExecutorValue;
 
-using ValueFuture = std::shared_future<absl::StatusOr<ExecutorValue>>;
+using ValueFuture = SharedFuture<ExecutorValue>;
 using Children = std::tuple<int32_t>;
 
 inline std::shared_ptr<OwnedValueId> ShareValueId(OwnedValueId&& id) {
@@ -177,6 +185,17 @@ using Unplaced = std::shared_ptr<UnplacedInner>;
 using Server = std::shared_ptr<OwnedValueId>;
 using Clients = std::shared_ptr<std::vector<std::shared_ptr<OwnedValueId>>>;
 using Structure = std::shared_ptr<std::vector<ExecutorValue>>;
+
+// Creates the value of a shard of a clients-placed value in a child executor,
+// which must serve as many clients as the child holding the shard.
+using ShardRecipe = std::function<absl::StatusOr<OwnedValueId>(Executor&)>;
+using ShardRecipes = std::shared_ptr<const std::vector<ShardRecipe>>;
+// The assignment of the clients of a clients-placed value to the slots of the
+// children: element `i` is the client in slot `i`, as returned by
+// `AssignClientsByLocality`, and an empty vector places the clients in order.
+// Null for values whose clients need not be told apart, e.g. all-equal ones,
+// which can be combined with values of any layout.
+using ClientLayout = std::shared_ptr<const std::vector<int32_t>>;
 struct TypedFederatedIntrinsic {
   // The Federated Intrinsic.
   FederatedIntrinsic federated_intrinsic;
@@ -220,6 +239,22 @@ class ExecutorValue {
   inline static ExecutorValue CreateClientsPlaced(Clients client_values) {
     return ExecutorValue(std::move(client_values), ValueType::CLIENTS);
   }
+  // Creates a clients-placed value whose shards can be re-created by
+  // `shard_recipes`, if not null, and whose clients are laid out in the
+  // children by `layout`.
+  inline static ExecutorValue CreateClientsPlaced(
+      Clients client_values, ShardRecipes shard_recipes,
+      ClientLayout layout = nullptr) {
+    ExecutorValue value(std::move(client_values), ValueType::CLIENTS);
+    value.shard_recipes_ = std::move(shard_recipes);
+    value.layout_ = std::move(layout);
+    return value;
+  }
+  // The recipes of the shards of a clients-placed value, or null if its shards
+  // cannot be re-created.
+  inline const ShardRecipes& shard_recipes() const { return shard_recipes_; }
+  // The layout of the clients of a clients-placed value.
+  inline const ClientLayout& layout() const { return layout_; }
   // Convenience constructor from an un-shared_ptr vector.
   inline static ExecutorValue CreateClientsPlaced(
       std::vector<std::shared_ptr<OwnedValueId>>&& client_values) {
@@ -354,6 +389,162 @@ class ExecutorValue {
   ExecutorValue() = delete;
   ValueVariant value_;
   ValueType type_;
+  ShardRecipes shard_recipes_;
+  ClientLayout layout_;
+};
+
+// The state of the materialization of the shards of a value, one per child of
+// a `ComposingExecutor`, shared with the threads running the attempts to
+// materialize them. Attempts which lose the race to a shard's result keep
+// running in the background, and are only given this state.
+struct ShardRace {
+  // Materializes the shard of `shard` in the child `child`: the shard's own
+  // child, or an idle child re-executing it.
+  using Attempt =
+      std::function<absl::StatusOr<v0::Value>(int32_t shard, int32_t child)>;
+  // Consumes the first successful result of `shard`.
+  using OnResult = std::function<absl::Status(int32_t shard, v0::Value)>;
+
+  ShardRace(int32_t num_shards, Attempt attempt, OnResult on_result)
+      : attempt(std::move(attempt)),
+        on_result(std::move(on_result)),
+        start(absl::Now()),
+        claimed(num_shards, false),
+        succeeded(num_shards, false),
+        re_executed(num_shards, false),
+        running_attempts(num_shards, 0),
+        busy_attempts(num_shards, 0) {}
+
+  const Attempt attempt;
+  const OnResult on_result;
+  const absl::Time start;
+
+  absl::Mutex mutex;
+  // Signalled whenever an attempt finishes.
+  absl::CondVar attempt_done;
+  // Whether the result of each shard was taken by an attempt.
+  std::vector<bool> claimed ABSL_GUARDED_BY(mutex);
+  // Whether each shard has been consumed successfully.
+  std::vector<bool> succeeded ABSL_GUARDED_BY(mutex);
+  // Whether each shard has been re-executed on another child.
+  std::vector<bool> re_executed ABSL_GUARDED_BY(mutex);
+  // The number of attempts running for each shard.
+  std::vector<int32_t> running_attempts ABSL_GUARDED_BY(mutex);
+  // The number of attempts running in each child.
+  std::vector<int32_t> busy_attempts ABSL_GUARDED_BY(mutex);
+  // The number of shards whose result has been consumed.
+  int32_t num_done ABSL_GUARDED_BY(mutex) = 0;
+  // The latency at which the percentile of shards given by the speculation
+  // options was done.
+  std::optional<absl::Duration> percentile_latency ABSL_GUARDED_BY(mutex);
+  absl::Status status ABSL_GUARDED_BY(mutex);
+};
+
+// A bounded cache of the all-equal clients-placed values of a
+// `ComposingExecutor`, keyed by the content hash of their proto, so that equal
+// values, e.g. a constant placed at clients every round, are created in the
+// children once and their child values are reused. The least recently used
+// values are evicted once the total serialized size of their protos exceeds
+// `capacity_bytes`, which bounds the memory each child holds for the cache.
+//
+// The broadcasts of server-placed values are also remembered, so that
+// broadcasting a server value again needs neither its proto nor its hash.
+//
+// This class is thread safe.
+class AllEqualCache {
+ public:
+  explicit AllEqualCache(int64_t capacity_bytes)
+      : capacity_bytes_(capacity_bytes) {}
+
+  // Returns the value cached under `content_hash`, if any.
+  std::optional<ExecutorValue> Lookup(std::string_view content_hash)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    return LookupLocked(content_hash);
+  }
+
+  // Caches `value`, whose proto is `size_bytes` large, under `content_hash`,
+  // unless it alone is larger than the capacity of the cache.
+  void Insert(std::string content_hash, ExecutorValue value, int64_t size_bytes)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    if (size_bytes > capacity_bytes_) {
+      return;
+    }
+    absl::MutexLock lock(&mutex_);
+    if (index_.contains(content_hash)) {
+      return;
+    }
+    while (size_bytes_ + size_bytes > capacity_bytes_) {
+      const Entry& evicted = entries_.back();
+      size_bytes_ -= evicted.size_bytes;
+      index_.erase(evicted.content_hash);
+      entries_.pop_back();
+    }
+    entries_.push_front(Entry{content_hash, std::move(value), size_bytes});
+    index_.emplace(std::move(content_hash), entries_.begin());
+    size_bytes_ += size_bytes;
+  }
+
+  // Returns the cached broadcast of `server_value`, if any.
+  std::optional<ExecutorValue> LookupBroadcast(const Server& server_value)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    auto it = broadcasts_.find(server_value->ref());
+    // The id may have been reused by another value since.
+    if (it == broadcasts_.end() ||
+        it->second.server_value.lock() != server_value) {
+      return std::nullopt;
+    }
+    return LookupLocked(it->second.content_hash);
+  }
+
+  // Remembers that the broadcast of `server_value` is cached under
+  // `content_hash`, as long as `server_value` is alive.
+  void InsertBroadcast(const Server& server_value, std::string content_hash)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    for (auto it = broadcasts_.begin(); it != broadcasts_.end();) {
+      if (it->second.server_value.expired()) {
+        broadcasts_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    broadcasts_.insert_or_assign(
+        server_value->ref(), Broadcast{server_value, std::move(content_hash)});
+  }
+
+ private:
+  struct Entry {
+    std::string content_hash;
+    ExecutorValue value;
+    int64_t size_bytes;
+  };
+  using EntryList = std::list<Entry>;
+  struct Broadcast {
+    std::weak_ptr<OwnedValueId> server_value;
+    std::string content_hash;
+  };
+
+  std::optional<ExecutorValue> LookupLocked(std::string_view content_hash)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto it = index_.find(content_hash);
+    if (it == index_.end()) {
+      return std::nullopt;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->value;
+  }
+
+  const int64_t capacity_bytes_;
+  absl::Mutex mutex_;
+  // Ordered from the most to the least recently used entry.
+  EntryList entries_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, EntryList::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t size_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The broadcasts of live server values, keyed by their id.
+  absl::flat_hash_map<ValueId, Broadcast> broadcasts_ ABSL_GUARDED_BY(mutex_);
 };
 
 class ComposingExecutor : public ExecutorBase<ValueFuture> {
@@ -361,16 +552,33 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
   explicit ComposingExecutor(std::shared_ptr<Executor> server,
                              std::vector<ComposingChild> children,
                              int32_t total_clients,
+                             ThreadPoolPolicy thread_pool_policy,
+                             ComposingSpeculationOptions speculation,
+                             std::shared_ptr<ExecutorRuntime> runtime,
+                             int64_t all_equal_cache_capacity_bytes,
                              int32_t threadpool_size = -1)
       : server_(std::move(server)),
         children_(std::move(children)),
         total_clients_(total_clients),
-        thread_pool_(
-            // Use a threadpool with CPU * 4 or the user specified
-            // maximum.
-            ((threadpool_size > 0) ? threadpool_size
-                                   : std::thread::hardware_concurrency() * 4),
-            ExecutorName()) {
+        speculation_(speculation),
+        runtime_(std::move(runtime)),
+        all_equal_cache_(all_equal_cache_capacity_bytes > 0
+                             ? std::make_unique<AllEqualCache>(
+                                   all_equal_cache_capacity_bytes)
+                             : nullptr),
+        assign_clients_by_locality_(std::any_of(
+            children_.begin(), children_.end(),
+            [](const ComposingChild& child) {
+              return !child.locality_keys().empty();
+            })) {
+    if (runtime_ != nullptr) {
+      return;
+    }
+    // Use a threadpool with CPU * 4 or the user specified maximum.
+    thread_pool_ = std::make_unique<ThreadPool>(
+        (threadpool_size > 0) ? threadpool_size
+                              : std::thread::hardware_concurrency() * 4,
+        ExecutorName(), thread_pool_policy);
     VLOG(2) << "thread pool size: "
             << ((threadpool_size > 0)
                     ? threadpool_size
@@ -390,7 +598,7 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
 
   absl::StatusOr<ValueFuture> CreateExecutorValue(
       const v0::Value& value_pb) final {
-    return ReadyFuture(TFF_TRY(ExecutorValue::FromProto(
+    return ValueFuture::Ready(TFF_TRY(ExecutorValue::FromProto(
         value_pb, *server_, total_clients_, [this](auto kind, const auto& v) {
           return CreateFederatedValue(kind, v);
         })));
@@ -398,13 +606,18 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
 
   absl::StatusOr<ValueFuture> CreateCall(
       ValueFuture function, std::optional<ValueFuture> argument) final {
-    return ThreadRun(
-        [function = std::move(function), argument = std::move(argument),
-         this]() -> absl::StatusOr<ExecutorValue> {
-          ExecutorValue fn = TFF_TRY(Wait(function));
+    std::vector<ValueFuture> inputs = {std::move(function)};
+    if (argument.has_value()) {
+      inputs.push_back(*std::move(argument));
+    }
+    return MapOnPool(
+        std::move(inputs),
+        [this, keepalive = KeepAlive()](std::vector<ExecutorValue>&& inputs)
+            -> absl::StatusOr<ExecutorValue> {
+          ExecutorValue& fn = inputs[0];
           std::optional<ExecutorValue> arg = std::nullopt;
-          if (argument.has_value()) {
-            arg = TFF_TRY(Wait(argument.value()));
+          if (inputs.size() > 1) {
+            arg = std::move(inputs[1]);
           }
 
           switch (fn.type()) {
@@ -440,7 +653,7 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
             }
           }
         },
-        &thread_pool_);
+        thread_pool());
   }
 
   absl::StatusOr<ValueFuture> CreateStruct(
@@ -451,8 +664,7 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
             -> absl::StatusOr<ExecutorValue> {
           return ExecutorValue::CreateStructure(
               std::make_shared<std::vector<ExecutorValue>>(std::move(members)));
-        },
-        &thread_pool_);
+        });
   }
 
   absl::StatusOr<ValueFuture> CreateSelection(ValueFuture value,
@@ -486,13 +698,12 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
               return value.structure()->at(index);
             }
           }
-        },
-        &thread_pool_);
+        });
   }
 
   absl::Status Materialize(ValueFuture value_fut, v0::Value* value_pb) final {
     ExecutorValue value = TFF_TRY(Wait(std::move(value_fut)));
-    ParallelTasks tasks(&thread_pool_);
+    ParallelTasks tasks(thread_pool());
     TFF_TRY(MaterializeValue(value, value_pb, tasks));
     TFF_TRY(tasks.WaitAll());
     return absl::OkStatus();
@@ -512,22 +723,44 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
             ShareValueId(std::move(value)));
       }
       case FederatedKind::CLIENTS: {
-        auto clients = NewClients();
+        const ClientLayout layout = LayoutForClients(federated);
+        // The shards are copied out of `federated` and sent to the children
+        // concurrently, so that creating a value of many clients is bound by
+        // the bandwidth to the children rather than sending shards in turn.
+        auto clients =
+            std::make_shared<std::vector<std::shared_ptr<OwnedValueId>>>(
+                children_.size());
+        std::vector<ShardRecipe> recipes(
+            speculation_.enabled ? children_.size() : 0);
+        ParallelTasks tasks(thread_pool());
         int32_t next_client_index = 0;
         for (int32_t i = 0; i < children_.size(); i++) {
-          auto child = children_[i];
-          v0::Value child_value;
-          v0::Value_Federated* child_value_fed =
-              child_value.mutable_federated();
-          *child_value_fed->mutable_type() = federated.type();
-          int32_t stop_index = next_client_index + child.num_clients();
-          for (; next_client_index < stop_index; next_client_index++) {
-            *child_value_fed->add_value() = federated.value(next_client_index);
-          }
-          auto child_id = TFF_TRY(child.executor()->CreateValue(child_value));
-          clients->emplace_back(ShareValueId(std::move(child_id)));
+          const int32_t start_index = next_client_index;
+          next_client_index += children_[i].num_clients();
+          TFF_TRY(tasks.add_task([this, &federated, &clients, &recipes,
+                                  &layout, i, start_index]() -> absl::Status {
+            const ComposingChild& child = children_[i];
+            v0::Value child_value;
+            v0::Value_Federated* child_value_fed =
+                child_value.mutable_federated();
+            *child_value_fed->mutable_type() = federated.type();
+            child_value_fed->mutable_value()->Reserve(child.num_clients());
+            for (int32_t j = start_index; j < start_index + child.num_clients();
+                 j++) {
+              *child_value_fed->add_value() =
+                  federated.value(ClientInSlot(layout, j));
+            }
+            auto child_id = TFF_TRY(child.executor()->CreateValue(child_value));
+            (*clients)[i] = ShareValueId(std::move(child_id));
+            if (speculation_.enabled) {
+              recipes[i] = ValueRecipe(std::move(child_value));
+            }
+            return absl::OkStatus();
+          }));
         }
-        return ExecutorValue::CreateClientsPlaced(std::move(clients));
+        TFF_TRY(tasks.WaitAll());
+        return ExecutorValue::CreateClientsPlaced(
+            std::move(clients), SharedRecipes(std::move(recipes)), layout);
       }
       case FederatedKind::CLIENTS_ALL_EQUAL: {
         v0::Value child_value;
@@ -537,6 +770,46 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
     }
   }
 
+  // Returns the layout in which to create the clients of `federated`. The
+  // clients are re-assigned by the locality of their data unless values of the
+  // current layout are alive, since those can only be combined with values of
+  // the same layout.
+  ClientLayout LayoutForClients(const v0::Value_Federated& federated) {
+    if (!assign_clients_by_locality_) {
+      return nullptr;
+    }
+    absl::MutexLock lock(&layout_mutex_);
+    if (layout_ != nullptr && layout_.use_count() > 1) {
+      return layout_;
+    }
+    std::vector<std::string> data_uris;
+    data_uris.reserve(federated.value_size());
+    bool has_data = false;
+    for (const v0::Value& client_value : federated.value()) {
+      data_uris.push_back(DataUri(client_value));
+      has_data |= !data_uris.back().empty();
+    }
+    if (layout_ != nullptr && !has_data) {
+      return layout_;
+    }
+    std::vector<int32_t> shard_sizes;
+    std::vector<std::vector<std::string>> locality_keys;
+    shard_sizes.reserve(children_.size());
+    locality_keys.reserve(children_.size());
+    for (const ComposingChild& child : children_) {
+      shard_sizes.push_back(child.num_clients());
+      locality_keys.push_back(child.locality_keys());
+    }
+    layout_ = std::make_shared<const std::vector<int32_t>>(
+        AssignClientsByLocality(data_uris, shard_sizes, locality_keys));
+    return layout_;
+  }
+
+  // Returns the client in `slot` of `layout`.
+  static int32_t ClientInSlot(const ClientLayout& layout, int32_t slot) {
+    return layout == nullptr || layout->empty() ? slot : (*layout)[slot];
+  }
+
   v0::Value NewAllEqual() const {
     v0::Value value;
     v0::Value_Federated* fed_value = value.mutable_federated();
@@ -549,14 +822,84 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
     return value;
   }
 
+  // Returns the clients-placed value of `all_equal_value`, reusing the child
+  // values of an equal value if it is cached.
   absl::StatusOr<ExecutorValue> AllEqualToAll(
       const v0::Value& all_equal_value) const {
+    if (all_equal_cache_ == nullptr) {
+      return CreateAllEqualInChildren(all_equal_value);
+    }
+    return CachedAllEqualToAll(all_equal_value,
+                               ValueContentHash(all_equal_value));
+  }
+
+  absl::StatusOr<ExecutorValue> CachedAllEqualToAll(
+      const v0::Value& all_equal_value, std::string content_hash) const {
+    std::optional<ExecutorValue> cached =
+        all_equal_cache_->Lookup(content_hash);
+    if (cached.has_value()) {
+      return *std::move(cached);
+    }
+    ExecutorValue value = TFF_TRY(CreateAllEqualInChildren(all_equal_value));
+    all_equal_cache_->Insert(std::move(content_hash), value,
+                             all_equal_value.ByteSizeLong());
+    return value;
+  }
+
+  absl::StatusOr<ExecutorValue> CreateAllEqualInChildren(
+      const v0::Value& all_equal_value) const {
     auto clients = NewClients();
     for (const auto& child : children_) {
       auto child_id = TFF_TRY(child.executor()->CreateValue(all_equal_value));
       clients->emplace_back(ShareValueId(std::move(child_id)));
     }
-    return ExecutorValue::CreateClientsPlaced(std::move(clients));
+    if (!speculation_.enabled) {
+      return ExecutorValue::CreateClientsPlaced(std::move(clients));
+    }
+    // All the shards share the same value.
+    return ExecutorValue::CreateClientsPlaced(
+        std::move(clients),
+        SharedRecipes(std::vector<ShardRecipe>(children_.size(),
+                                               ValueRecipe(all_equal_value))));
+  }
+
+  // Returns a recipe creating `value_pb` in a child.
+  static ShardRecipe ValueRecipe(v0::Value value_pb) {
+    return [value_pb = std::make_shared<const v0::Value>(std::move(value_pb))](
+               Executor& child) { return child.CreateValue(*value_pb); };
+  }
+
+  // Returns a recipe calling the intrinsic `intrinsic_pb` in a child, with the
+  // struct of `fn_pb` and the shard of `data_recipe` as argument, or with
+  // `fn_pb` as argument if `data_recipe` is null.
+  static ShardRecipe IntrinsicCallRecipe(
+      std::shared_ptr<const v0::Value> intrinsic_pb,
+      std::shared_ptr<const v0::Value> fn_pb, const ShardRecipe* data_recipe) {
+    std::optional<ShardRecipe> data;
+    if (data_recipe != nullptr) {
+      data = *data_recipe;
+    }
+    return [intrinsic_pb = std::move(intrinsic_pb), fn_pb = std::move(fn_pb),
+            data = std::move(data)](
+               Executor& child) -> absl::StatusOr<OwnedValueId> {
+      OwnedValueId intrinsic = TFF_TRY(child.CreateValue(*intrinsic_pb));
+      OwnedValueId fn = TFF_TRY(child.CreateValue(*fn_pb));
+      if (!data.has_value()) {
+        return child.CreateCall(intrinsic, fn);
+      }
+      OwnedValueId data_id = TFF_TRY((*data)(child));
+      OwnedValueId arg = TFF_TRY(child.CreateStruct({fn, data_id}));
+      return child.CreateCall(intrinsic, arg);
+    };
+  }
+
+  // Shares `recipes`, or returns null if there are none, e.g. since
+  // speculation is disabled.
+  static ShardRecipes SharedRecipes(std::vector<ShardRecipe> recipes) {
+    if (recipes.empty()) {
+      return nullptr;
+    }
+    return std::make_shared<const std::vector<ShardRecipe>>(std::move(recipes));
   }
 
   absl::StatusOr<ExecutorValue> CallIntrinsicValueAtClients(
@@ -608,7 +951,16 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
       auto res_id = TFF_TRY(child.executor()->CreateCall(eval_id, fn_id));
       clients->emplace_back(ShareValueId(std::move(res_id)));
     }
-    return ExecutorValue::CreateClientsPlaced(std::move(clients));
+    if (!speculation_.enabled) {
+      return ExecutorValue::CreateClientsPlaced(std::move(clients));
+    }
+    return ExecutorValue::CreateClientsPlaced(
+        std::move(clients),
+        SharedRecipes(std::vector<ShardRecipe>(
+            children_.size(),
+            IntrinsicCallRecipe(
+                std::make_shared<const v0::Value>(std::move(eval_at_clients)),
+                fn_to_eval, /*data_recipe=*/nullptr))));
   }
 
   absl::StatusOr<ExecutorValue> CallIntrinsicAggregate(
@@ -646,64 +998,130 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
     *aggregate.mutable_computation()->mutable_type()->mutable_function() =
         type_pb;
 
-    // Initiate the aggregation in each child.
-    std::vector<OwnedValueId> child_result_ids;
-    child_result_ids.reserve(children_.size());
-    for (int32_t i = 0; i < children_.size(); i++) {
-      const auto& child = children_[i].executor();
-      ValueId child_val = value.clients()->at(i)->ref();
+    // Initiates the aggregation of `child_val` in `child`. The protos are
+    // shared, since re-executed shards may aggregate after this call returns.
+    auto child_arg_pbs = std::make_shared<const std::vector<v0::Value>>(
+        std::vector<v0::Value>{std::move(zero_val), *accumulate_val,
+                               *merge_val, std::move(null_report_val)});
+    auto aggregate_pb = std::make_shared<const v0::Value>(std::move(aggregate));
+    auto aggregate_in_child = [child_arg_pbs, aggregate_pb](
+                                  Executor& child, ValueId child_val)
+        -> absl::StatusOr<OwnedValueId> {
       std::vector<OwnedValueId> arg_owners;
       std::vector<ValueId> arg_ids;
       arg_ids.emplace_back(child_val);
-      for (const v0::Value& arg_value :
-           {zero_val, *accumulate_val, *merge_val, null_report_val}) {
-        OwnedValueId child_id = TFF_TRY(child->CreateValue(arg_value));
+      for (const v0::Value& arg_value : *child_arg_pbs) {
+        OwnedValueId child_id = TFF_TRY(child.CreateValue(arg_value));
         arg_ids.emplace_back(child_id.ref());
         arg_owners.emplace_back(std::move(child_id));
       }
-      auto child_arg_id = TFF_TRY(child->CreateStruct(std::move(arg_ids)));
-      auto child_aggregate_id = TFF_TRY(child->CreateValue(aggregate));
-      auto child_result_id =
-          TFF_TRY(child->CreateCall(child_aggregate_id, child_arg_id));
-      child_result_ids.push_back(std::move(child_result_id));
+      auto child_arg_id = TFF_TRY(child.CreateStruct(std::move(arg_ids)));
+      auto child_aggregate_id = TFF_TRY(child.CreateValue(*aggregate_pb));
+      return child.CreateCall(child_aggregate_id, child_arg_id);
+    };
+
+    // Initiate the aggregation in each child.
+    auto child_result_ids = std::make_shared<std::vector<OwnedValueId>>();
+    child_result_ids->reserve(children_.size());
+    for (int32_t i = 0; i < children_.size(); i++) {
+      child_result_ids->push_back(TFF_TRY(aggregate_in_child(
+          *children_[i].executor(), value.clients()->at(i)->ref())));
     }
 
-    // Materialize and merge the results from each child executor.
+    // Materialize and merge the results from each child executor. The merges
+    // form a balanced tree: a result of height `h`, which merges `2^h` child
+    // results, is merged with another result of the same height as soon as
+    // both exist. Independent merges are thus created concurrently, and the
+    // depth of the merges is logarithmic in the number of children. The mutex
+    // is only held to take or store a result, never while creating a merge.
     absl::Mutex mutex;
-    std::optional<OwnedValueId> current ABSL_GUARDED_BY(mutex) = std::nullopt;
-
-    ParallelTasks materialize_tasks;
+    std::vector<std::optional<OwnedValueId>> results_by_height
+        ABSL_GUARDED_BY(mutex);
+    auto merge_result = [this, &merge_id, &mutex, &results_by_height](
+                            OwnedValueId result) -> absl::Status {
+      for (size_t height = 0;; ++height) {
+        std::optional<OwnedValueId> sibling;
+        {
+          absl::MutexLock lock(&mutex);
+          if (results_by_height.size() <= height) {
+            results_by_height.resize(height + 1);
+          }
+          if (!results_by_height[height].has_value()) {
+            results_by_height[height] = std::move(result);
+            return absl::OkStatus();
+          }
+          sibling = std::move(results_by_height[height]);
+          results_by_height[height].reset();
+        }
+        auto merge_arg =
+            TFF_TRY(server_->CreateStruct({sibling.value(), result}));
+        result = TFF_TRY(server_->CreateCall(merge_id->ref(), merge_arg));
+      }
+    };
 
-    for (int32_t i = 0; i < children_.size(); i++) {
-      TFF_TRY(materialize_tasks.add_task(
-          [this, &child = children_[i].executor(),
-           &child_result_id = child_result_ids[i], &merge_id, &current,
-           &mutex]() -> absl::Status {
-            v0::Value child_result =
-                TFF_TRY(child->Materialize(child_result_id));
-            if (!child_result.has_federated() ||
-                child_result.federated().type().placement().value().uri() !=
-                    kServerUri) {
-              return absl::InternalError(
-                  "Child executor returned non-server-placed value");
-            }
-            auto child_result_server_id = TFF_TRY(
-                server_->CreateValue(child_result.federated().value(0)));
-
-            absl::MutexLock lock(&mutex);
-            if (current.has_value()) {
-              auto merge_arg = TFF_TRY(server_->CreateStruct(
-                  {current.value(), child_result_server_id}));
-              current =
-                  TFF_TRY(server_->CreateCall(merge_id->ref(), merge_arg));
-            } else {
-              current = std::move(child_result_server_id);
+    auto merge_child_result = [this, &merge_result](
+                                  v0::Value child_result) -> absl::Status {
+      if (!child_result.has_federated() ||
+          child_result.federated().type().placement().value().uri() !=
+              kServerUri) {
+        return absl::InternalError(
+            "Child executor returned non-server-placed value");
+      }
+      auto child_result_server_id =
+          TFF_TRY(server_->CreateValue(child_result.federated().value(0)));
+      return merge_result(std::move(child_result_server_id));
+    };
+
+    if (speculation_.enabled) {
+      // Straggling shards are re-executed from their recipe, if any.
+      TFF_TRY(MaterializeShards(
+          [children = children_, child_result_ids,
+           recipes = value.shard_recipes(), aggregate_in_child](
+              int32_t shard, int32_t child) -> absl::StatusOr<v0::Value> {
+            Executor& executor = *children[child].executor();
+            if (shard == child) {
+              return executor.Materialize(child_result_ids->at(shard));
             }
-            return absl::OkStatus();
+            OwnedValueId child_val = TFF_TRY(recipes->at(shard)(executor));
+            OwnedValueId result =
+                TFF_TRY(aggregate_in_child(executor, child_val));
+            return executor.Materialize(result);
+          },
+          /*can_re_execute=*/value.shard_recipes() != nullptr,
+          [&merge_child_result](int32_t, v0::Value child_result) {
+            return merge_child_result(std::move(child_result));
           }));
+    } else {
+      ParallelTasks materialize_tasks;
+      for (int32_t i = 0; i < children_.size(); i++) {
+        TFF_TRY(materialize_tasks.add_task(
+            [&child = children_[i].executor(),
+             &child_result_id = child_result_ids->at(i),
+             &merge_child_result]() -> absl::Status {
+              return merge_child_result(
+                  TFF_TRY(child->Materialize(child_result_id)));
+            }));
+      }
+      TFF_TRY(materialize_tasks.WaitAll());
     }
 
-    TFF_TRY(materialize_tasks.WaitAll());
+    // Merge the roots of the remaining trees, from the smallest one.
+    std::optional<OwnedValueId> current;
+    {
+      absl::MutexLock lock(&mutex);
+      for (std::optional<OwnedValueId>& result : results_by_height) {
+        if (!result.has_value()) {
+          continue;
+        }
+        if (current.has_value()) {
+          auto merge_arg =
+              TFF_TRY(server_->CreateStruct({result.value(), current.value()}));
+          current = TFF_TRY(server_->CreateCall(merge_id->ref(), merge_arg));
+        } else {
+          current = std::move(result);
+        }
+      }
+    }
 
     auto result =
         TFF_TRY(server_->CreateCall(report_id->ref(), current.value()));
@@ -716,10 +1134,23 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
       return absl::InvalidArgumentError(
           "Attempted to broadcast a value not placed at server.");
     }
+    if (all_equal_cache_ != nullptr) {
+      std::optional<ExecutorValue> cached =
+          all_equal_cache_->LookupBroadcast(arg.server());
+      if (cached.has_value()) {
+        return *std::move(cached);
+      }
+    }
     v0::Value value = NewAllEqual();
     v0::Value* value_contents = value.mutable_federated()->add_value();
     TFF_TRY(server_->Materialize(arg.server()->ref(), value_contents));
-    return AllEqualToAll(value);
+    if (all_equal_cache_ == nullptr) {
+      return CreateAllEqualInChildren(value);
+    }
+    std::string content_hash = ValueContentHash(value);
+    ExecutorValue result = TFF_TRY(CachedAllEqualToAll(value, content_hash));
+    all_equal_cache_->InsertBroadcast(arg.server(), std::move(content_hash));
+    return result;
   }
 
   absl::StatusOr<ExecutorValue> CallIntrinsicMap(
@@ -748,7 +1179,21 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
         auto result = TFF_TRY(child->CreateCall(child_map, map_args));
         results->emplace_back(ShareValueId(std::move(result)));
       }
-      return ExecutorValue::CreateClientsPlaced(std::move(results));
+      const ShardRecipes& data_recipes = data.shard_recipes();
+      if (data_recipes == nullptr) {
+        return ExecutorValue::CreateClientsPlaced(
+            std::move(results), /*shard_recipes=*/nullptr, data.layout());
+      }
+      auto map_pb = std::make_shared<const v0::Value>(std::move(map_val));
+      auto fn_pb = std::make_shared<const v0::Value>(std::move(fn_val));
+      std::vector<ShardRecipe> recipes;
+      recipes.reserve(children_.size());
+      for (const ShardRecipe& data_recipe : *data_recipes) {
+        recipes.push_back(IntrinsicCallRecipe(map_pb, fn_pb, &data_recipe));
+      }
+      return ExecutorValue::CreateClientsPlaced(
+          std::move(results), SharedRecipes(std::move(recipes)),
+          data.layout());
     } else if (data.type() == ExecutorValue::ValueType::SERVER) {
       auto embedded_fn = TFF_TRY(fn.Embed(*server_));
       auto res = TFF_TRY(
@@ -811,7 +1256,10 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
           TFF_TRY(child->CreateCall(child_select_id, child_arg_id));
       child_result_ids.push_back(ShareValueId(std::move(child_result_id)));
     }
-    return ExecutorValue::CreateClientsPlaced(std::move(child_result_ids));
+    return ExecutorValue::CreateClientsPlaced(
+        std::make_shared<std::vector<std::shared_ptr<OwnedValueId>>>(
+            std::move(child_result_ids)),
+        /*shard_recipes=*/nullptr, keys.layout());
   }
 
   // Pushes `arg` containing structs of client-placed values into
@@ -846,9 +1294,40 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
     }
   }
 
+  // Returns the layout of the clients-placed values in `arg`, which must be
+  // laid out alike unless they have no layout.
+  static absl::StatusOr<ClientLayout> LayoutOfClients(
+      const ExecutorValue& arg) {
+    switch (arg.type()) {
+      case ExecutorValue::ValueType::CLIENTS: {
+        return arg.layout();
+      }
+      case ExecutorValue::ValueType::STRUCTURE: {
+        ClientLayout layout;
+        for (const auto& element : *arg.structure()) {
+          ClientLayout element_layout = TFF_TRY(LayoutOfClients(element));
+          if (element_layout == nullptr) {
+            continue;
+          }
+          if (layout != nullptr && layout != element_layout) {
+            return absl::InternalError(
+                "Cannot combine clients-placed values whose clients are "
+                "assigned to the children differently.");
+          }
+          layout = std::move(element_layout);
+        }
+        return layout;
+      }
+      default: {
+        return nullptr;
+      }
+    }
+  }
+
   absl::StatusOr<ExecutorValue> CallIntrinsicZipAtClients(
       ExecutorValue&& arg, const v0::FunctionType& type_pb) {
     auto traceme = Trace("CallIntrinsicZipAtClients");
+    ClientLayout layout = TFF_TRY(LayoutOfClients(arg));
     v0::Value zip_at_clients;
     zip_at_clients.mutable_computation()
         ->mutable_intrinsic()
@@ -867,7 +1346,8 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
       pairs->push_back(ShareValueId(
           TFF_TRY(child->CreateCall(zip, arg_struct_in_child->ref()))));
     }
-    return ExecutorValue::CreateClientsPlaced(std::move(pairs));
+    return ExecutorValue::CreateClientsPlaced(
+        std::move(pairs), /*shard_recipes=*/nullptr, std::move(layout));
   }
 
   // Pushes `arg` containing structs of server-placed values into the `server_`
@@ -946,46 +1426,167 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
   }
 
   // Creates tasks to materialize values into the addresses pointed to by
-  // `protos_out`.
-  absl::Status MaterializeChildClientValues(int32_t child_index,
-                                            ValueId child_id,
-                                            absl::Span<v0::Value*> protos_out,
-                                            ParallelTasks& tasks) const {
+  // `protos_out`, which are kept in `slot_protos` if it is not null.
+  absl::Status MaterializeChildClientValues(
+      int32_t child_index, ValueId child_id, absl::Span<v0::Value*> protos_out,
+      std::shared_ptr<const std::vector<v0::Value*>> slot_protos,
+      ParallelTasks& tasks) const {
     CHECK(protos_out.size() == children_[child_index].num_clients());
     return tasks.add_task([child = children_[child_index], child_id,
-                           protos_out]() -> absl::Status {
-      v0::Value child_value = TFF_TRY(child.executor()->Materialize(child_id));
-      if (!child_value.has_federated()) {
-        return absl::InternalError(
-            absl::StrCat("Composing child executor returned non-federated "
-                         "value of type ",
-                         child_value.value_case()));
+                           protos_out,
+                           slot_protos = std::move(slot_protos)]()
+                              -> absl::Status {
+      return UnpackChildClientValues(
+          child, TFF_TRY(child.executor()->Materialize(child_id)), protos_out);
+    });
+  }
+
+  // Moves the client values of `child_value`, materialized by `child`, into
+  // the addresses pointed to by `protos_out`.
+  static absl::Status UnpackChildClientValues(
+      const ComposingChild& child, v0::Value child_value,
+      absl::Span<v0::Value*> protos_out) {
+    if (!child_value.has_federated()) {
+      return absl::InternalError(
+          absl::StrCat("Composing child executor returned non-federated "
+                       "value of type ",
+                       child_value.value_case()));
+    }
+    if (child_value.federated().type().all_equal()) {
+      if (child_value.federated().value_size() != 1) {
+        return absl::InternalError(absl::StrCat(
+            "Composing child executor returned all-equal value of "
+            "length ",
+            child_value.federated().value_size(),
+            ", but all-equal values must have only one value."));
       }
-      if (child_value.federated().type().all_equal()) {
-        if (child_value.federated().value_size() != 1) {
-          return absl::InternalError(absl::StrCat(
-              "Composing child executor returned all-equal value of "
-              "length ",
-              child_value.federated().value_size(),
-              ", but all-equal values must have only one value."));
-        }
-        for (int32_t j = 0; j < child.num_clients(); j++) {
-          *(protos_out[j]) = child_value.federated().value(0);
-        }
-      } else {
-        if (child_value.federated().value_size() != child.num_clients()) {
-          return absl::InternalError(absl::StrCat(
-              "Composing child executor responsible for ", child.num_clients(),
-              " clients returned ", child_value.federated().value_size(),
-              " client values."));
-        }
-        for (int32_t j = 0; j < child.num_clients(); j++) {
-          *(protos_out[j]) =
-              std::move(*child_value.mutable_federated()->mutable_value(j));
+      for (int32_t j = 0; j < child.num_clients(); j++) {
+        *(protos_out[j]) = child_value.federated().value(0);
+      }
+    } else {
+      if (child_value.federated().value_size() != child.num_clients()) {
+        return absl::InternalError(absl::StrCat(
+            "Composing child executor responsible for ", child.num_clients(),
+            " clients returned ", child_value.federated().value_size(),
+            " client values."));
+      }
+      for (int32_t j = 0; j < child.num_clients(); j++) {
+        *(protos_out[j]) =
+            std::move(*child_value.mutable_federated()->mutable_value(j));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Materializes the shards of a value, one per child, with `attempt`, and
+  // passes the first successful result of each shard to `on_result`. If
+  // `can_re_execute` is true, straggling shards are re-executed on idle
+  // children as configured by `speculation_`.
+  absl::Status MaterializeShards(ShardRace::Attempt attempt,
+                                 bool can_re_execute,
+                                 ShardRace::OnResult on_result) const {
+    const int32_t num_shards = children_.size();
+    const int32_t percentile_shards = std::clamp(
+        static_cast<int32_t>(
+            std::ceil(speculation_.latency_percentile * num_shards)),
+        1, std::max(num_shards, 1));
+    auto race = std::make_shared<ShardRace>(num_shards, std::move(attempt),
+                                            std::move(on_result));
+    // Attempts wait for the children, so they run a level below the caller in
+    // a runtime. Otherwise they run on new threads, since losing attempts may
+    // keep running for long.
+    ThreadPool* attempt_pool = runtime_ != nullptr
+                                   ? runtime_->pool(ExecutorLane::kCoordination)
+                                   : nullptr;
+    absl::MutexLock lock(&race->mutex);
+    for (int32_t shard = 0; shard < num_shards; ++shard) {
+      StartShardAttempt(race, shard, /*child=*/shard, percentile_shards,
+                        attempt_pool);
+    }
+    while (race->num_done < num_shards) {
+      absl::Time deadline = absl::InfiniteFuture();
+      if (can_re_execute && race->percentile_latency.has_value()) {
+        absl::Time straggling_time =
+            race->start +
+            speculation_.latency_multiplier * *race->percentile_latency;
+        if (absl::Now() < straggling_time) {
+          deadline = straggling_time;
+        } else {
+          for (int32_t shard = 0; shard < num_shards; ++shard) {
+            if (race->claimed[shard] || race->re_executed[shard]) {
+              continue;
+            }
+            std::optional<int32_t> child = IdleChild(*race, shard);
+            if (child.has_value()) {
+              VLOG(1) << "Re-executing the shard of straggling child " << shard
+                      << " on child " << *child;
+              race->re_executed[shard] = true;
+              StartShardAttempt(race, shard, *child, percentile_shards,
+                                attempt_pool);
+            }
+          }
         }
       }
-      return absl::OkStatus();
-    });
+      race->attempt_done.WaitWithDeadline(&race->mutex, deadline);
+    }
+    return race->status;
+  }
+
+  // Returns a child which can re-execute `shard`: one which has produced its
+  // own result, is not running any attempt, and serves as many clients.
+  std::optional<int32_t> IdleChild(const ShardRace& race, int32_t shard) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(race.mutex) {
+    for (int32_t child = 0; child < children_.size(); ++child) {
+      if (child != shard && race.succeeded[child] &&
+          race.busy_attempts[child] == 0 &&
+          children_[child].num_clients() == children_[shard].num_clients()) {
+        return child;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Starts an attempt to materialize `shard` in `child` on `pool`, or on a new
+  // thread if `pool` is null.
+  static void StartShardAttempt(const std::shared_ptr<ShardRace>& race,
+                                int32_t shard, int32_t child,
+                                int32_t percentile_shards, ThreadPool* pool)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(race->mutex) {
+    race->running_attempts[shard] += 1;
+    race->busy_attempts[child] += 1;
+    ThreadRun(
+        [race, shard, child, percentile_shards]() {
+          absl::StatusOr<v0::Value> result = race->attempt(shard, child);
+          bool won = false;
+          {
+            absl::MutexLock lock(&race->mutex);
+            race->running_attempts[shard] -= 1;
+            race->busy_attempts[child] -= 1;
+            // A failed attempt only ends the shard if no other attempt can
+            // still succeed.
+            if (!race->claimed[shard] &&
+                (result.ok() || race->running_attempts[shard] == 0)) {
+              race->claimed[shard] = true;
+              won = true;
+            }
+            race->attempt_done.SignalAll();
+          }
+          if (!won) {
+            return;
+          }
+          absl::Status status = result.ok()
+                                    ? race->on_result(shard, *std::move(result))
+                                    : result.status();
+          absl::MutexLock lock(&race->mutex);
+          race->succeeded[shard] = status.ok();
+          race->status.Update(status);
+          race->num_done += 1;
+          if (race->num_done == percentile_shards) {
+            race->percentile_latency = absl::Now() - race->start;
+          }
+          race->attempt_done.SignalAll();
+        },
+        pool);
   }
 
   absl::Status MaterializeValue(const ExecutorValue& value, v0::Value* value_pb,
@@ -1013,12 +1614,55 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
         type_pb->mutable_placement()->mutable_value()->mutable_uri()->assign(
             kClientsUri.data(), kClientsUri.size());
         v0::Value** client_start = values_pb->mutable_data();
+        // The addresses of the clients in the slots of the children, if the
+        // clients are not laid out in order.
+        std::shared_ptr<std::vector<v0::Value*>> slot_protos;
+        if (value.layout() != nullptr && !value.layout()->empty()) {
+          slot_protos = std::make_shared<std::vector<v0::Value*>>();
+          slot_protos->reserve(total_clients_);
+          for (int32_t client : *value.layout()) {
+            slot_protos->push_back(client_start[client]);
+          }
+          client_start = slot_protos->data();
+        }
+        if (speculation_.enabled && value.shard_recipes() != nullptr) {
+          // Materialize the shards together, so that straggling shards can
+          // be re-executed.
+          std::vector<absl::Span<v0::Value*>> shard_protos;
+          shard_protos.reserve(children_.size());
+          for (const ComposingChild& child : children_) {
+            shard_protos.emplace_back(client_start, child.num_clients());
+            client_start += child.num_clients();
+          }
+          return tasks.add_task([this, value, slot_protos,
+                                 shard_protos = std::move(shard_protos)]() {
+            return MaterializeShards(
+                [children = children_, clients = value.clients(),
+                 recipes = value.shard_recipes()](
+                    int32_t shard,
+                    int32_t child) -> absl::StatusOr<v0::Value> {
+                  Executor& executor = *children[child].executor();
+                  if (shard == child) {
+                    return executor.Materialize(clients->at(shard)->ref());
+                  }
+                  OwnedValueId child_value =
+                      TFF_TRY(recipes->at(shard)(executor));
+                  return executor.Materialize(child_value);
+                },
+                /*can_re_execute=*/true,
+                [this, &shard_protos](int32_t shard, v0::Value child_value) {
+                  return UnpackChildClientValues(children_[shard],
+                                                 std::move(child_value),
+                                                 shard_protos[shard]);
+                });
+          });
+        }
         for (int32_t i = 0; i < children_.size(); i++) {
           absl::Span<v0::Value*> client_value_pointers(
               client_start, children_[i].num_clients());
           ValueId child_value_id = value.clients()->at(i)->ref();
-          TFF_TRY(MaterializeChildClientValues(i, child_value_id,
-                                               client_value_pointers, tasks));
+          TFF_TRY(MaterializeChildClientValues(
+              i, child_value_id, client_value_pointers, slot_protos, tasks));
           client_start += children_[i].num_clients();
         }
         return absl::OkStatus();
@@ -1062,25 +1706,58 @@ class ComposingExecutor : public ExecutorBase<ValueFuture> {
   std::shared_ptr<Executor> server_;
   std::vector<ComposingChild> children_;
   int32_t total_clients_;
+  const ComposingSpeculationOptions speculation_;
+  // If not null, provides the pools of this executor instead of
+  // `thread_pool_`.
+  const std::shared_ptr<ExecutorRuntime> runtime_;
+  // Null unless the cache of all-equal values is enabled.
+  const std::unique_ptr<AllEqualCache> all_equal_cache_;
+  // Whether some child has locality keys, so that the clients of values
+  // created from protos are assigned to the children by their data.
+  const bool assign_clients_by_locality_;
+  absl::Mutex layout_mutex_;
+  // The layout of the clients of the values created from protos, if the
+  // clients are assigned by locality.
+  ClientLayout layout_ ABSL_GUARDED_BY(layout_mutex_);
+
+  // Returns the pool to schedule work of this executor on.
+  ThreadPool* thread_pool() {
+    return runtime_ != nullptr ? runtime_->pool(ExecutorLane::kCoordination)
+                               : thread_pool_.get();
+  }
+
+  // Returns a reference to this executor for work scheduled on the pools of
+  // `runtime_`, which outlive the executor. Work scheduled on `thread_pool_`
+  // must not hold one: the last reference being dropped on a thread of
+  // `thread_pool_` would join that thread from itself.
+  std::shared_ptr<Executor> KeepAlive() {
+    return runtime_ != nullptr ? shared_from_this() : nullptr;
+  }
 
   // IMPORTANT: The thread_pool_ must be the member of the class. This way the
   // thread_pool_ will be the first destructed, which will wait prevent new
   // work from being scheduled (closing the pool) and waiting for inflight
   // threads to finish, which might hold `this` pointers to the executor and
   // otherwise could cause issues.
-  ThreadPool thread_pool_;
+  std::unique_ptr<ThreadPool> thread_pool_;
 };
 
 }  // namespace
 
 std::shared_ptr<Executor> CreateComposingExecutor(
-    std::shared_ptr<Executor> server, std::vector<ComposingChild> children) {
+    std::shared_ptr<Executor> server, std::vector<ComposingChild> children,
+    ThreadPoolPolicy thread_pool_policy,
+    ComposingSpeculationOptions speculation,
+    std::shared_ptr<ExecutorRuntime> runtime,
+    int64_t all_equal_cache_capacity_bytes) {
   int32_t total_clients = 0;
   for (const auto& child : children) {
     total_clients += child.num_clients();
   }
   return std::make_shared<ComposingExecutor>(
-      std::move(server), std::move(children), total_clients);
+      std::move(server), std::move(children), total_clients,
+      thread_pool_policy, speculation, std::move(runtime),
+      all_equal_cache_capacity_bytes);
 }
 
 }  // namespace tensorflow_federated
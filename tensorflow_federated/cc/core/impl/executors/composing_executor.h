@@ -18,39 +18,76 @@ limitations under the License
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/statusor.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 
 namespace tensorflow_federated {
 
 // An executor to be used as an intermediate aggregator for some subset of a
 // `ComposingExecutor`'s clients.
+//
+// The data whose `v0::Data` URI starts with one of `locality_keys` is local to
+// the child, e.g. cached by the worker running it.
 class ComposingChild {
  public:
   static absl::StatusOr<ComposingChild> Make(
-      std::shared_ptr<Executor> executor, const CardinalityMap& cardinalities) {
+      std::shared_ptr<Executor> executor, const CardinalityMap& cardinalities,
+      std::vector<std::string> locality_keys = {}) {
     uint32_t num_clients = TFF_TRY(NumClientsFromCardinalities(cardinalities));
-    return ComposingChild(std::move(executor), num_clients);
+    return ComposingChild(std::move(executor), num_clients,
+                          std::move(locality_keys));
   }
 
   const std::shared_ptr<Executor>& executor() const { return executor_; }
 
   uint32_t num_clients() const { return num_clients_; }
 
+  const std::vector<std::string>& locality_keys() const {
+    return locality_keys_;
+  }
+
  private:
   std::shared_ptr<::tensorflow_federated::Executor> executor_;
   uint32_t num_clients_;
+  std::vector<std::string> locality_keys_;
 
   ComposingChild(std::shared_ptr<::tensorflow_federated::Executor> executor,
-                 uint32_t num_clients)
-      : executor_(std::move(executor)), num_clients_(num_clients) {}
+                 uint32_t num_clients, std::vector<std::string> locality_keys)
+      : executor_(std::move(executor)),
+        num_clients_(num_clients),
+        locality_keys_(std::move(locality_keys)) {}
+};
+
+// Options for the speculative re-execution of the shards of straggling
+// children by a `ComposingExecutor`.
+//
+// A child straggles when it has not produced its result in a materialization
+// or `federated_aggregate` after `latency_multiplier` times the latency at
+// which the `latency_percentile` fraction of the children has produced theirs.
+// Its shard is then re-executed on an idle child, one which has produced its
+// own result and serves as many clients, and the first result is used.
+//
+// Only shards of client values created from protos, and of the results of
+// `federated_map` and `federated_eval_at_clients` over them, can be
+// re-executed. To re-create them, the executor keeps the protos of client
+// values while speculation is enabled.
+struct ComposingSpeculationOptions {
+  bool enabled = false;
+  double latency_percentile = 0.75;
+  double latency_multiplier = 1.5;
 };
 
+inline constexpr int64_t kDefaultAllEqualCacheCapacityBytes =
+    int64_t{1} << 28;
+
 // Returns an executor that splits handling of federated values and intrinsics
 // across multiple child executors.
 //
@@ -59,8 +96,40 @@ class ComposingChild {
 //
 // The `children` executors will be used for executing shards of federated
 // computations and must be able to resolve federated values and intrinsics.
+//
+// `thread_pool_policy` selects the scheduling policy of the thread pool used
+// to await and combine the results of `children`.
+//
+// `speculation` configures the re-execution of the shards of straggling
+// children, which is disabled by default.
+//
+// If `runtime` is not null, work is scheduled on its coordination lane instead
+// of a thread pool owned by the executor, and `thread_pool_policy` is unused.
+//
+// All-equal clients-placed values, e.g. the results of `federated_broadcast`,
+// are cached by the content hash of their proto, so that creating or
+// broadcasting an equal value again, in the same round or a later one, reuses
+// the values already created in the children rather than sending the value to
+// them again. The least recently used values are released once the serialized
+// size of the cached values exceeds `all_equal_cache_capacity_bytes`; each
+// child holds up to that many bytes for the cache. Non-positive capacities
+// disable the cache.
+//
+// If some of the `children` have locality keys, the clients of the values
+// created from protos are assigned to the children whose keys match the URIs
+// of the `v0::Data` of the clients when possible (see
+// `AssignClientsByLocality`), rather than in order, so that the children read
+// local data. The order of the clients is restored on materialization. Since
+// clients-placed values can only be combined if their clients are assigned
+// alike, the clients are only re-assigned while no clients-placed value of
+// the previous assignment is alive, e.g. at the start of a round.
 std::shared_ptr<Executor> CreateComposingExecutor(
-    std::shared_ptr<Executor> server, std::vector<ComposingChild> children);
+    std::shared_ptr<Executor> server, std::vector<ComposingChild> children,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    ComposingSpeculationOptions speculation = ComposingSpeculationOptions(),
+    std::shared_ptr<ExecutorRuntime> runtime = nullptr,
+    int64_t all_equal_cache_capacity_bytes =
+        kDefaultAllEqualCacheCapacityBytes);
 
 }  // namespace tensorflow_federated
 
@@ -0,0 +1,101 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/composing_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/noop_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::tensorflow_federated::testing::ClientsV;
+using ::tensorflow_federated::testing::StructV;
+using ::tensorflow_federated::testing::TensorV;
+using ::tensorflow_federated::testing::intrinsic::FederatedMapV;
+
+// Returns a composing executor over `num_children` children which split
+// `num_clients` clients evenly.
+std::shared_ptr<Executor> CreateComposingExecutorOverNoOps(
+    int32_t num_clients, int32_t num_children) {
+  std::vector<ComposingChild> children;
+  for (int32_t i = 0; i < num_children; ++i) {
+    int32_t child_clients =
+        num_clients / num_children + (i < num_clients % num_children ? 1 : 0);
+    children.push_back(
+        ComposingChild::Make(std::make_shared<NoOpExecutor>(),
+                             {{std::string(kClientsUri), child_clients}})
+            .value());
+  }
+  return CreateComposingExecutor(std::make_shared<NoOpExecutor>(),
+                                 std::move(children));
+}
+
+// Benchmarks creating and disposing of a value placed at `state.range(0)`
+// clients, which the executor splits across `state.range(1)` children.
+static void BM_CreateAndDisposeClientsValue(benchmark::State& state) {
+  const int32_t num_clients = state.range(0);
+  std::shared_ptr<Executor> executor =
+      CreateComposingExecutorOverNoOps(num_clients, state.range(1));
+  const v0::Value clients_pb =
+      ClientsV(std::vector<v0::Value>(num_clients, TensorV(1)));
+  int64_t items_processed = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(executor->CreateValue(clients_pb));
+    items_processed += num_clients;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK(BM_CreateAndDisposeClientsValue)
+    ->ArgNames({"clients", "children"})
+    ->ArgsProduct({{10, 1000, 100000}, {1, 8}});
+
+// Benchmarks the dispatch of `federated_map` to `state.range(0)` children,
+// whose calls return immediately.
+static void BM_FederatedMapAcrossChildren(benchmark::State& state) {
+  const int32_t num_children = state.range(0);
+  const int32_t num_clients = 8 * num_children;
+  std::shared_ptr<Executor> executor =
+      CreateComposingExecutorOverNoOps(num_clients, num_children);
+  std::vector<v0::Value> client_vals(num_clients, TensorV(1));
+  OwnedValueId map_id = executor->CreateValue(FederatedMapV()).value();
+  OwnedValueId arg_id =
+      executor->CreateValue(StructV({TensorV(2), ClientsV(client_vals)}))
+          .value();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(executor->CreateCall(map_id, arg_id));
+  }
+  state.SetItemsProcessed(state.iterations() * num_children);
+}
+
+BENCHMARK(BM_FederatedMapAcrossChildren)
+    ->ArgName("children")
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(128)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -19,18 +19,25 @@ limitations under the License
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
 #include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/computations.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor_test_base.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 #include "tensorflow_federated/cc/core/impl/executors/type_utils.h"
 #include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
@@ -158,6 +165,89 @@ TEST_F(ComposingExecutorTest, CreateMaterializeAtClients) {
   ExpectCreateMaterialize(ClientsV(values));
 }
 
+TEST_F(ComposingExecutorTest, CreateMaterializeAtClientsOnRuntime) {
+  std::vector<ComposingChild> composing_children;
+  for (uint32_t i = 0; i < mock_children_.size(); i++) {
+    TFF_ASSERT_OK_AND_ASSIGN(
+        auto child, ComposingChild::Make(mock_children_[i],
+                                         {{"clients", clients_per_child_[i]}}));
+    composing_children.push_back(child);
+  }
+  test_executor_ = CreateComposingExecutor(
+      mock_server_, std::move(composing_children),
+      ThreadPoolPolicy::kSingleQueue, ComposingSpeculationOptions(),
+      std::make_shared<ExecutorRuntime>());
+  std::vector<v0::Value> values;
+  for (uint32_t i = 0; i < mock_children_.size(); i++) {
+    std::vector<v0::Value> child_values;
+    for (uint32_t j = 0; j < clients_per_child_[i]; j++) {
+      child_values.push_back(TensorV(static_cast<int32_t>(values.size())));
+      values.push_back(child_values.back());
+    }
+    mock_children_[i]->ExpectCreateMaterialize(ClientsV(child_values));
+  }
+  ExpectCreateMaterialize(ClientsV(values));
+}
+
+TEST_F(ComposingExecutorTest, CreateMaterializeAtClientsByDataLocality) {
+  std::vector<std::vector<std::string>> locality_keys = {{"b/"}, {"a/"}};
+  std::vector<ComposingChild> composing_children;
+  for (uint32_t i = 0; i < locality_keys.size(); i++) {
+    TFF_ASSERT_OK_AND_ASSIGN(
+        auto child,
+        ComposingChild::Make(mock_children_[i + 1],
+                             {{"clients", clients_per_child_[i + 1]}},
+                             locality_keys[i]));
+    composing_children.push_back(child);
+  }
+  test_executor_ =
+      CreateComposingExecutor(mock_server_, std::move(composing_children));
+  std::vector<v0::Value> values;
+  for (const char* uri : {"a/0", "b/1", "a/2"}) {
+    v0::Value value_pb;
+    value_pb.mutable_computation()->mutable_data()->set_uri(uri);
+    values.push_back(value_pb);
+  }
+  // The client whose data is local to the first child is placed there, and
+  // the materialized value keeps the order of the clients.
+  mock_children_[1]->ExpectCreateMaterialize(ClientsV({values[1]}));
+  mock_children_[2]->ExpectCreateMaterialize(ClientsV({values[0], values[2]}));
+  ExpectCreateMaterialize(ClientsV(values));
+}
+
+TEST_F(ComposingExecutorTest, CreateValueAtClientsSendsShardsConcurrently) {
+  // Each child only creates its shard once all children were sent theirs.
+  absl::Mutex mutex;
+  absl::CondVar all_started;
+  size_t num_started = 0;
+  const absl::Time deadline = absl::Now() + absl::Seconds(10);
+  std::vector<v0::Value> values;
+  for (uint32_t i = 0; i < mock_children_.size(); i++) {
+    std::vector<v0::Value> child_values;
+    for (uint32_t j = 0; j < clients_per_child_[i]; j++) {
+      child_values.push_back(TensorV(static_cast<int32_t>(values.size())));
+      values.push_back(child_values.back());
+    }
+    auto child = mock_children_[i];
+    const v0::Value child_pb = ClientsV(child_values);
+    EXPECT_CALL(*child, CreateValue(testing::EqualsProto(child_pb)))
+        .WillOnce([&, child]() -> absl::StatusOr<OwnedValueId> {
+          absl::MutexLock lock(&mutex);
+          if (++num_started == mock_children_.size()) {
+            all_started.SignalAll();
+          }
+          while (num_started < mock_children_.size()) {
+            if (all_started.WaitWithDeadline(&mutex, deadline)) {
+              return absl::DeadlineExceededError("Shards were sent in turn.");
+            }
+          }
+          return OwnedValueId(child, 0);
+        });
+    EXPECT_CALL(*child, Dispose(0));
+  }
+  EXPECT_THAT(test_executor_->CreateValue(ClientsV(values)), IsOk());
+}
+
 TEST_F(ComposingExecutorTest, CreateValueFailsWrongNumberClients) {
   EXPECT_THAT(test_executor_->CreateValue(ClientsV({})),
               StatusIs(StatusCode::kInvalidArgument));
@@ -178,6 +268,26 @@ TEST_F(ComposingExecutorTest, CreateMaterializeAtClientsAllEqual) {
       id, ClientsV(std::vector<v0::Value>(total_clients_, tensor_pb)));
 }
 
+TEST_F(ComposingExecutorTest, CreateAllEqualValueTwiceReusesChildValues) {
+  v0::Value tensor_pb = TensorV(2);
+  v0::Value all_equal_value = ClientsV({tensor_pb}, true);
+  for (uint32_t i = 0; i < mock_children_.size(); i++) {
+    auto child = mock_children_[i];
+    auto id = child->ExpectCreateValue(all_equal_value);
+    child->ExpectMaterialize(
+        id, ClientsV(std::vector<v0::Value>(clients_per_child_[i], tensor_pb)),
+        ::testing::Exactly(2));
+  }
+  TFF_ASSERT_OK_AND_ASSIGN(auto first_id,
+                           test_executor_->CreateValue(all_equal_value));
+  TFF_ASSERT_OK_AND_ASSIGN(auto second_id,
+                           test_executor_->CreateValue(all_equal_value));
+  ExpectMaterialize(
+      first_id, ClientsV(std::vector<v0::Value>(total_clients_, tensor_pb)));
+  ExpectMaterialize(
+      second_id, ClientsV(std::vector<v0::Value>(total_clients_, tensor_pb)));
+}
+
 TEST_F(ComposingExecutorTest, CreateFederatedValueInsideStruct) {
   v0::Value fed_pb = ClientsV({TensorV(5)}, true);
   v0::Value struct_pb = StructV({fed_pb});
@@ -376,12 +486,17 @@ TEST_F(ComposingExecutorTest, CreateCallFederatedAggregate) {
   auto result_from_child_on_server = mock_server_->ExpectCreateValue(
       result_from_child.federated().value(0),
       ::testing::Exactly(mock_children_.size()));
-  size_t num_total_merges = mock_children_.size() - 1;
+  // The results are merged pairwise in a tree. Since the number of children
+  // is a power of two, each level of the tree halves the number of results.
+  ASSERT_EQ(mock_children_.size() & (mock_children_.size() - 1), 0);
   auto prev_merge_result = result_from_child_on_server;
-  for (uint32_t i = 0; i < num_total_merges; i++) {
+  for (size_t num_results = mock_children_.size(); num_results > 1;
+       num_results /= 2) {
     auto merge_arg = mock_server_->ExpectCreateStruct(
-        {prev_merge_result, result_from_child_on_server});
-    prev_merge_result = mock_server_->ExpectCreateCall(server_merge, merge_arg);
+        {prev_merge_result, prev_merge_result},
+        ::testing::Exactly(num_results / 2));
+    prev_merge_result = mock_server_->ExpectCreateCall(
+        server_merge, merge_arg, ::testing::Exactly(num_results / 2));
   }
   auto post_report =
       mock_server_->ExpectCreateCall(server_report, prev_merge_result);
@@ -444,6 +559,31 @@ TEST_F(ComposingExecutorTest, CreateCallFederatedBroadcast) {
                     ClientsV(std::vector<v0::Value>(total_clients_, tensor)));
 }
 
+TEST_F(ComposingExecutorTest, CreateCallFederatedBroadcastTwiceReusesValues) {
+  v0::Value tensor = TensorV(1);
+  // The server value is only materialized, and sent to the children, once.
+  mock_server_->ExpectCreateMaterialize(tensor);
+  for (uint32_t i = 0; i < mock_children_.size(); i++) {
+    auto child = mock_children_[i];
+    auto id = child->ExpectCreateValue(ClientsV({tensor}, true));
+    child->ExpectMaterialize(
+        id, ClientsV(std::vector<v0::Value>(clients_per_child_[i], tensor)),
+        ::testing::Exactly(2));
+  }
+  TFF_ASSERT_OK_AND_ASSIGN(auto server_id,
+                           test_executor_->CreateValue(ServerV(tensor)));
+  TFF_ASSERT_OK_AND_ASSIGN(auto broadcast_id,
+                           test_executor_->CreateValue(FederatedBroadcastV()));
+  TFF_ASSERT_OK_AND_ASSIGN(auto first_id,
+                           test_executor_->CreateCall(broadcast_id, server_id));
+  ExpectMaterialize(first_id,
+                    ClientsV(std::vector<v0::Value>(total_clients_, tensor)));
+  TFF_ASSERT_OK_AND_ASSIGN(auto second_id,
+                           test_executor_->CreateCall(broadcast_id, server_id));
+  ExpectMaterialize(second_id,
+                    ClientsV(std::vector<v0::Value>(total_clients_, tensor)));
+}
+
 TEST_F(ComposingExecutorTest,
        CreateCallFederatedBroadcastFailsOnNonServerPlacedValue) {
   v0::Value tensor = TensorV(1);
@@ -965,6 +1105,79 @@ TEST_F(ComposingExecutorTest, CreateCallFederatedZipUnplacedFails) {
               StatusIs(StatusCode::kInvalidArgument));
 }
 
+class ComposingExecutorSpeculationTest : public ExecutorTestBase {
+ public:
+  ComposingExecutorSpeculationTest() { Initialize(); }
+  ~ComposingExecutorSpeculationTest() override = default;
+
+  void Initialize() {
+    std::vector<ComposingChild> composing_children;
+    for (int32_t i = 0; i < 2; i++) {
+      auto exec = std::make_shared<::testing::StrictMock<MockExecutor>>();
+      TFF_ASSERT_OK_AND_ASSIGN(auto child,
+                               ComposingChild::Make(exec, {{"clients", 1}}));
+      composing_children.push_back(child);
+      mock_children_.push_back(std::move(exec));
+    }
+    ComposingSpeculationOptions speculation;
+    speculation.enabled = true;
+    speculation.latency_percentile = 0.5;
+    speculation.latency_multiplier = 1.0;
+    test_executor_ = CreateComposingExecutor(
+        std::make_shared<::testing::StrictMock<MockExecutor>>(),
+        std::move(composing_children), ThreadPoolPolicy::kSingleQueue,
+        speculation);
+  }
+
+ protected:
+  std::vector<std::shared_ptr<::testing::StrictMock<MockExecutor>>>
+      mock_children_;
+};
+
+TEST_F(ComposingExecutorSpeculationTest, ReExecutesStragglerOnIdleChild) {
+  v0::Value fast_pb = ClientsV({TensorV(1)});
+  v0::Value straggler_pb = ClientsV({TensorV(2)});
+  mock_children_[0]->ExpectCreateMaterialize(fast_pb);
+  // The straggler only returns once its shard was re-executed on the idle
+  // first child.
+  auto re_executed = std::make_shared<absl::Notification>();
+  ValueId straggler_id = mock_children_[1]->ExpectCreateValue(straggler_pb);
+  EXPECT_CALL(*mock_children_[1], Materialize(straggler_id, ::testing::_))
+      .WillOnce([re_executed, straggler_pb](ValueId, v0::Value* value_pb) {
+        re_executed->WaitForNotification();
+        *value_pb = straggler_pb;
+        return absl::OkStatus();
+      });
+  ValueId re_executed_id = mock_children_[0]->ExpectCreateValue(straggler_pb);
+  EXPECT_CALL(*mock_children_[0], Materialize(re_executed_id, ::testing::_))
+      .WillOnce([re_executed, straggler_pb](ValueId, v0::Value* value_pb) {
+        *value_pb = straggler_pb;
+        re_executed->Notify();
+        return absl::OkStatus();
+      });
+  ExpectCreateMaterialize(ClientsV({TensorV(1), TensorV(2)}));
+}
+
+TEST_F(ComposingExecutorSpeculationTest, FailingChildFailsMaterialize) {
+  v0::Value fast_pb = ClientsV({TensorV(1)});
+  v0::Value failing_pb = ClientsV({TensorV(2)});
+  mock_children_[0]->ExpectCreateMaterialize(fast_pb);
+  ValueId failing_id = mock_children_[1]->ExpectCreateValue(failing_pb);
+  EXPECT_CALL(*mock_children_[1], Materialize(failing_id, ::testing::_))
+      .WillOnce(::testing::Return(absl::UnavailableError("Worker is down")));
+  // The first child may re-execute the failing shard if it is idle before the
+  // failure.
+  EXPECT_CALL(*mock_children_[0],
+              CreateValue(testing::EqualsProto(failing_pb)))
+      .Times(::testing::AtMost(1))
+      .WillRepeatedly(::testing::Return(
+          absl::UnavailableError("Re-execution is not expected to succeed")));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto id, test_executor_->CreateValue(ClientsV({TensorV(1), TensorV(2)})));
+  EXPECT_THAT(test_executor_->Materialize(id),
+              StatusIs(StatusCode::kUnavailable));
+}
+
 }  // namespace
 
 }  // namespace tensorflow_federated
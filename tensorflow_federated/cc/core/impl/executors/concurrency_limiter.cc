@@ -0,0 +1,153 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/concurrency_limiter.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "absl/log/log.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// The factor the baseline grows by with every run not faster than it.
+constexpr double kBaselineDrift = 1.01;
+
+// Returns the resident set size of the process, or zero if it is unknown.
+int64_t ResidentSetBytes() {
+  std::ifstream statm("/proc/self/statm");
+  int64_t total_pages = 0;
+  int64_t resident_pages = 0;
+  if (!(statm >> total_pages >> resident_pages)) {
+    return 0;
+  }
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+int32_t InitialLimit(int32_t max_limit,
+                     const AdaptiveConcurrencyOptions& options) {
+  if (!options.enabled) {
+    return max_limit;
+  }
+  const int32_t initial_limit =
+      options.initial_limit > 0
+          ? options.initial_limit
+          : std::max<int32_t>(std::thread::hardware_concurrency(), 1);
+  return std::clamp(initial_limit, std::min(options.min_limit, max_limit),
+                    max_limit);
+}
+
+}  // namespace
+
+bool LatencyBaseline::Update(absl::Duration latency, double tolerance) {
+  const bool outlier = baseline_ != absl::InfiniteDuration() &&
+                       latency > baseline_ * tolerance;
+  baseline_ = baseline_ == absl::InfiniteDuration()
+                  ? latency
+                  : std::min(latency, baseline_ * kBaselineDrift);
+  return outlier;
+}
+
+ConcurrencyLimiter::ConcurrencyLimiter(int32_t max_limit,
+                                       AdaptiveConcurrencyOptions options)
+    : max_limit_(std::max<int32_t>(max_limit, 1)),
+      options_(std::move(options)),
+      limit_(InitialLimit(max_limit_, options_)) {}
+
+void ConcurrencyLimiter::Acquire() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &ConcurrencyLimiter::CanAdmit));
+  ++in_flight_;
+}
+
+void ConcurrencyLimiter::Release(absl::Duration latency,
+                                 LatencyBaseline& baseline) {
+  const bool memory_exceeded = options_.enabled && MemoryExceeded();
+  absl::MutexLock lock(&mutex_);
+  // The run was admitted while the limit was reached if no other run could
+  // have been.
+  const bool saturated = in_flight_ >= limit_;
+  --in_flight_;
+  if (!options_.enabled) {
+    return;
+  }
+  const bool slow = baseline.Update(latency, options_.latency_tolerance);
+  ++completed_since_decrease_;
+  if (slow || memory_exceeded) {
+    if (completed_since_decrease_ >= limit_) {
+      const int32_t min_limit = std::min(options_.min_limit, max_limit_);
+      limit_ = std::max<int32_t>(
+          min_limit, static_cast<int32_t>(
+                         std::floor(limit_ * options_.backoff_ratio)));
+      completed_since_decrease_ = 0;
+      increase_credit_ = 0.0;
+      VLOG(2) << "Decreased the concurrency limit to " << limit_
+              << (slow ? " on a slow run" : " on memory use");
+    }
+    return;
+  }
+  if (saturated && limit_ < max_limit_) {
+    increase_credit_ += 1.0 / limit_;
+    if (increase_credit_ >= 1.0) {
+      ++limit_;
+      increase_credit_ = 0.0;
+      VLOG(2) << "Increased the concurrency limit to " << limit_;
+    }
+  }
+}
+
+int32_t ConcurrencyLimiter::limit() {
+  absl::MutexLock lock(&mutex_);
+  return limit_;
+}
+
+bool ConcurrencyLimiter::MemoryExceeded() const {
+  if (options_.memory_limit_bytes <= 0) {
+    return false;
+  }
+  const int64_t usage_bytes = options_.memory_usage_bytes != nullptr
+                                  ? options_.memory_usage_bytes()
+                                  : ResidentSetBytes();
+  return usage_bytes > options_.memory_limit_bytes;
+}
+
+ConcurrencyPermit::ConcurrencyPermit(ConcurrencyLimiter* limiter,
+                                     LatencyBaseline& baseline)
+    : limiter_(limiter), baseline_(baseline) {
+  if (limiter_ != nullptr) {
+    limiter_->Acquire();
+  }
+  // The latency excludes the wait for admission.
+  start_ = absl::Now();
+}
+
+ConcurrencyPermit::~ConcurrencyPermit() {
+  if (limiter_ != nullptr) {
+    limiter_->Release(absl::Now() - start_, baseline_);
+  }
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,129 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CONCURRENCY_LIMITER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CONCURRENCY_LIMITER_H_
+
+#include <cstdint>
+#include <functional>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+
+struct AdaptiveConcurrencyOptions {
+  // Whether the number of concurrent runs adapts to their latency and memory
+  // use. If false, runs are only bounded by the static maximum.
+  bool enabled = false;
+  // The lowest limit, and the limit to start at, both at most the maximum of
+  // the limiter. A non-positive initial limit starts at one run per core.
+  int32_t min_limit = 1;
+  int32_t initial_limit = 0;
+  // A run taking longer than `latency_tolerance` times the baseline latency of
+  // its kind signals overload.
+  double latency_tolerance = 2.0;
+  // The factor the limit is multiplied by on overload.
+  double backoff_ratio = 0.5;
+  // If positive, memory use above this many bytes signals overload.
+  int64_t memory_limit_bytes = 0;
+  // Returns the memory in use, in bytes. If unset, the resident set size of
+  // the process.
+  std::function<int64_t()> memory_usage_bytes;
+};
+
+// The lowest recent latency of a kind of run, e.g. the calls of a computation,
+// which its later runs are compared to. The baseline drifts up slowly, so that
+// a single unusually fast run does not make all later runs look slow.
+//
+// Only updated by the `ConcurrencyLimiter` it is passed to.
+class LatencyBaseline {
+ public:
+  // Returns whether `latency` exceeds `tolerance` times the baseline, then
+  // updates the baseline with it. The first run is never an outlier.
+  bool Update(absl::Duration latency, double tolerance);
+
+ private:
+  absl::Duration baseline_ = absl::InfiniteDuration();
+};
+
+// Bounds the number of concurrent runs, e.g. of TensorFlow sessions, by a limit
+// adjusted with additive increase and multiplicative decrease (AIMD): the
+// limit grows by one run once a limit's worth of runs completed while it was
+// reached, and is multiplied by `options.backoff_ratio` whenever a run is
+// slower than its baseline or memory use is above its limit. After a decrease,
+// runs admitted under the old limit complete before the limit decreases again.
+//
+// This class is thread safe.
+class ConcurrencyLimiter {
+ public:
+  // Creates a limiter admitting at most `max_limit` concurrent runs. If
+  // `options.enabled` is false, the limit stays at `max_limit`.
+  ConcurrencyLimiter(int32_t max_limit, AdaptiveConcurrencyOptions options);
+
+  ConcurrencyLimiter(const ConcurrencyLimiter&) = delete;
+  ConcurrencyLimiter& operator=(const ConcurrencyLimiter&) = delete;
+
+  // Blocks until a run is admitted under the current limit. Runs admitted
+  // must not wait for other runs to be admitted.
+  void Acquire() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Ends a run admitted by `Acquire`, which took `latency`, and adjusts the
+  // limit by comparing it to `baseline`.
+  void Release(absl::Duration latency, LatencyBaseline& baseline)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the current limit.
+  int32_t limit() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  bool CanAdmit() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return in_flight_ < limit_;
+  }
+
+  // Returns whether the memory in use is above the limit of `options_`.
+  bool MemoryExceeded() const;
+
+  const int32_t max_limit_;
+  const AdaptiveConcurrencyOptions options_;
+  absl::Mutex mutex_;
+  int32_t limit_ ABSL_GUARDED_BY(mutex_);
+  int32_t in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The fractional increase accumulated towards the next increment.
+  double increase_credit_ ABSL_GUARDED_BY(mutex_) = 0.0;
+  // The number of runs completed since the last decrease.
+  int32_t completed_since_decrease_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Admits a run in `limiter`, if not null, for the lifetime of the permit, and
+// reports its latency to `baseline` when it ends.
+class ConcurrencyPermit {
+ public:
+  ConcurrencyPermit(ConcurrencyLimiter* limiter, LatencyBaseline& baseline);
+  ~ConcurrencyPermit();
+
+  ConcurrencyPermit(const ConcurrencyPermit&) = delete;
+  ConcurrencyPermit& operator=(const ConcurrencyPermit&) = delete;
+
+ private:
+  ConcurrencyLimiter* const limiter_;
+  LatencyBaseline& baseline_;
+  absl::Time start_;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_CONCURRENCY_LIMITER_H_
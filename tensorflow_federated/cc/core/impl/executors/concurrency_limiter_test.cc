@@ -0,0 +1,128 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/concurrency_limiter.h"
+
+#include <cstdint>
+#include <thread>  // NOLINT
+
+#include "googletest/include/gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+namespace {
+
+AdaptiveConcurrencyOptions Adaptive(int32_t initial_limit) {
+  AdaptiveConcurrencyOptions options;
+  options.enabled = true;
+  options.initial_limit = initial_limit;
+  return options;
+}
+
+// Admits and ends `num_runs` sequential runs each taking `latency`.
+void RunSequentially(ConcurrencyLimiter& limiter, LatencyBaseline& baseline,
+                     int32_t num_runs, absl::Duration latency) {
+  for (int32_t i = 0; i < num_runs; ++i) {
+    limiter.Acquire();
+    limiter.Release(latency, baseline);
+  }
+}
+
+TEST(ConcurrencyLimiterTest, BlocksRunsBeyondLimit) {
+  ConcurrencyLimiter limiter(/*max_limit=*/1, AdaptiveConcurrencyOptions());
+  LatencyBaseline baseline;
+  limiter.Acquire();
+  absl::Notification admitted;
+  std::thread waiter([&limiter, &admitted] {
+    limiter.Acquire();
+    admitted.Notify();
+  });
+  EXPECT_FALSE(admitted.WaitForNotificationWithTimeout(absl::Milliseconds(50)));
+  limiter.Release(absl::Milliseconds(1), baseline);
+  admitted.WaitForNotification();
+  waiter.join();
+  limiter.Release(absl::Milliseconds(1), baseline);
+}
+
+TEST(ConcurrencyLimiterTest, StaysAtMaximumUnlessEnabled) {
+  ConcurrencyLimiter limiter(/*max_limit=*/8, AdaptiveConcurrencyOptions());
+  LatencyBaseline baseline;
+  RunSequentially(limiter, baseline, 1, absl::Milliseconds(1));
+  RunSequentially(limiter, baseline, 16, absl::Seconds(1));
+  EXPECT_EQ(limiter.limit(), 8);
+}
+
+TEST(ConcurrencyLimiterTest, DecreasesLimitOnSlowRuns) {
+  ConcurrencyLimiter limiter(/*max_limit=*/8, Adaptive(/*initial_limit=*/8));
+  LatencyBaseline baseline;
+  RunSequentially(limiter, baseline, 8, absl::Milliseconds(1));
+  RunSequentially(limiter, baseline, 1, absl::Milliseconds(10));
+  EXPECT_EQ(limiter.limit(), 4);
+  // Runs admitted under the old limit do not decrease it again.
+  RunSequentially(limiter, baseline, 3, absl::Milliseconds(10));
+  EXPECT_EQ(limiter.limit(), 4);
+}
+
+TEST(ConcurrencyLimiterTest, DoesNotDecreaseBelowMinimum) {
+  AdaptiveConcurrencyOptions options = Adaptive(/*initial_limit=*/4);
+  options.min_limit = 3;
+  ConcurrencyLimiter limiter(/*max_limit=*/8, options);
+  LatencyBaseline baseline;
+  RunSequentially(limiter, baseline, 4, absl::Milliseconds(1));
+  for (int32_t i = 0; i < 4; ++i) {
+    RunSequentially(limiter, baseline, 4, absl::Milliseconds(100 << i));
+  }
+  EXPECT_EQ(limiter.limit(), 3);
+}
+
+TEST(ConcurrencyLimiterTest, DecreasesLimitAboveMemoryLimit) {
+  AdaptiveConcurrencyOptions options = Adaptive(/*initial_limit=*/2);
+  options.memory_limit_bytes = 100;
+  int64_t memory_usage_bytes = 50;
+  options.memory_usage_bytes = [&memory_usage_bytes] {
+    return memory_usage_bytes;
+  };
+  ConcurrencyLimiter limiter(/*max_limit=*/8, options);
+  LatencyBaseline baseline;
+  RunSequentially(limiter, baseline, 2, absl::Milliseconds(1));
+  EXPECT_EQ(limiter.limit(), 2);
+  memory_usage_bytes = 200;
+  RunSequentially(limiter, baseline, 1, absl::Milliseconds(1));
+  EXPECT_EQ(limiter.limit(), 1);
+}
+
+TEST(ConcurrencyLimiterTest, IncreasesLimitWhileReached) {
+  ConcurrencyLimiter limiter(/*max_limit=*/3, Adaptive(/*initial_limit=*/1));
+  LatencyBaseline baseline;
+  // A single run reaches a limit of one, and a limit's worth of runs
+  // increases it by one.
+  RunSequentially(limiter, baseline, 1, absl::Milliseconds(1));
+  EXPECT_EQ(limiter.limit(), 2);
+  // Sequential runs no longer reach the limit.
+  RunSequentially(limiter, baseline, 4, absl::Milliseconds(1));
+  EXPECT_EQ(limiter.limit(), 2);
+  for (int32_t i = 0; i < 4; ++i) {
+    limiter.Acquire();
+    limiter.Acquire();
+    limiter.Release(absl::Milliseconds(1), baseline);
+    limiter.Release(absl::Milliseconds(1), baseline);
+  }
+  EXPECT_EQ(limiter.limit(), 3);
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
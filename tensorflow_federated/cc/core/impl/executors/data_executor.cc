@@ -37,6 +37,24 @@ namespace {
 using SharedId = std::shared_ptr<const OwnedValueId>;
 using ValueFuture = std::shared_future<absl::StatusOr<SharedId>>;
 
+// Returns whether `value_pb` is a struct with a `Data` computation among its
+// elements, possibly nested in other structs.
+bool IsStructWithData(const v0::Value& value_pb) {
+  if (!value_pb.has_struct_()) {
+    return false;
+  }
+  for (const v0::Value::Struct::Element& element_pb :
+       value_pb.struct_().element()) {
+    const v0::Value& element_value_pb = element_pb.value();
+    if ((element_value_pb.has_computation() &&
+         element_value_pb.computation().has_data()) ||
+        IsStructWithData(element_value_pb)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 class DataExecutor : public ExecutorBase<ValueFuture> {
  public:
   DataExecutor(std::shared_ptr<Executor> child,
@@ -61,12 +79,23 @@ class DataExecutor : public ExecutorBase<ValueFuture> {
                         data_type = std::move(data_type),
                         this_keepalive =
                             shared_from_this()]() -> absl::StatusOr<SharedId> {
-        Trace("DataExecutor::DataBackend::ResolveToValue");
+        auto trace = Trace("DataExecutor::DataBackend::ResolveToValue");
         v0::Value resolved_value;
         TFF_TRY(data_backend_->ResolveToValue(data, data_type, resolved_value));
         OwnedValueId child_value = TFF_TRY(child_->CreateValue(resolved_value));
         return std::make_shared<OwnedValueId>(std::move(child_value));
       });
+    } else if (IsStructWithData(value_pb)) {
+      // Resolves the elements concurrently, each on its own thread if it
+      // references data, and creates the struct once they are resolved.
+      std::vector<ValueFuture> element_futures;
+      element_futures.reserve(value_pb.struct_().element_size());
+      for (const v0::Value::Struct::Element& element_pb :
+           value_pb.struct_().element()) {
+        element_futures.push_back(
+            TFF_TRY(CreateExecutorValue(element_pb.value())));
+      }
+      return CreateStruct(std::move(element_futures));
     } else {
       OwnedValueId child_value = TFF_TRY(child_->CreateValue(value_pb));
       return ReadyFuture(
@@ -25,8 +25,11 @@ namespace tensorflow_federated {
 
 // Returns an executor that resolves `Data` blocks using `data_backend`.
 //
-// Note that this executor does not transform values not at top-level, so it is
-// advisable to place this beneath a `ReferenceResolvingExecutor`.
+// `Data` blocks are resolved at the top-level of values, and within struct
+// values, whose elements are resolved concurrently. Other values are not
+// transformed, so it is advisable to place this beneath a
+// `ReferenceResolvingExecutor`. Wrapping `data_backend` in a
+// `CachingDataBackend` avoids resolving the same data repeatedly.
 std::shared_ptr<Executor> CreateDataExecutor(
     std::shared_ptr<Executor> child, std::shared_ptr<DataBackend> data_backend);
 
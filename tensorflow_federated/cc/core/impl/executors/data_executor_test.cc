@@ -74,6 +74,36 @@ TEST_F(DataExecutorTest, CreateValueResolvesData) {
   ExpectMaterialize(value_id, resolved_data_value);
 }
 
+TEST_F(DataExecutorTest, CreateValueResolvesDataInStruct) {
+  std::string uri = "some_data_uri";
+  v0::Type data_type;
+  data_type.mutable_tensor()->set_dtype(v0::DataType::DT_INT32);
+  v0::Value resolved_data_value = TensorV(22);
+  mock_data_backend_->ExpectResolveToValue(uri, data_type, resolved_data_value);
+  v0::Value tensor_value = TensorV(5);
+  v0::Value struct_value;
+  v0::Computation* unresolved_data_computation =
+      struct_value.mutable_struct_()
+          ->add_element()
+          ->mutable_value()
+          ->mutable_computation();
+  unresolved_data_computation->mutable_data()->set_uri(uri);
+  *unresolved_data_computation->mutable_type() = data_type;
+  *struct_value.mutable_struct_()->add_element()->mutable_value() =
+      tensor_value;
+  ValueId data_child_id =
+      mock_executor_child_->ExpectCreateValue(resolved_data_value);
+  ValueId tensor_child_id =
+      mock_executor_child_->ExpectCreateValue(tensor_value);
+  ValueId struct_child_id = mock_executor_child_->ExpectCreateStruct(
+      {data_child_id, tensor_child_id});
+  OwnedValueId struct_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(struct_value));
+  v0::Value result = TensorV("result");
+  mock_executor_child_->ExpectMaterialize(struct_child_id, result);
+  ExpectMaterialize(struct_id, result);
+}
+
 TEST_F(DataExecutorTest, CreateValueUnknownValuesDelegatesToChild) {
   v0::Value unknown_value = TensorV(5);
   mock_executor_child_->ExpectCreateMaterialize(unknown_value);
@@ -14,25 +14,108 @@ limitations under the License
 ==============================================================================*/
 #include "tensorflow_federated/cc/core/impl/executors/dataset_conversions.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow/core/util/batch_util.h"
+#include "tensorflow_federated/cc/core/impl/executors/dataset_from_tensor_structures.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
 
 namespace tensorflow_federated {
 
-absl::StatusOr<std::unique_ptr<tensorflow::data::standalone::Dataset>>
-SequenceValueToDataset(const v0::Value::Sequence& sequence_pb) {
-  if (!sequence_pb.has_serialized_graph_def()) {
-    return absl::UnimplementedError(
-        "Conversion from TFF Value to TF Dataset requires graphdef-based "
-        "serialization.");
+namespace {
+
+absl::StatusOr<std::vector<tensorflow::Tensor>> DeserializeColumns(
+    const v0::Value::Sequence::Columns& columns_pb) {
+  std::vector<tensorflow::Tensor> columns;
+  columns.reserve(columns_pb.tensor_size());
+  for (const v0::Value& tensor_pb : columns_pb.tensor()) {
+    tensorflow::Tensor column = TFF_TRY(DeserializeTensorValue(tensor_pb));
+    if (column.dims() == 0) {
+      return absl::InvalidArgumentError(
+          "Columns of a sequence must have a leading dimension, found a "
+          "scalar.");
+    }
+    if (!columns.empty() && column.dim_size(0) != columns[0].dim_size(0)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Columns of a sequence must have the same length, found lengths ",
+          columns[0].dim_size(0), " and ", column.dim_size(0), "."));
+    }
+    columns.push_back(std::move(column));
+  }
+  return columns;
+}
+
+// Returns the tensors at `index` of all `tensor_structures`, stacked along a
+// new leading dimension.
+absl::StatusOr<tensorflow::Tensor> StackColumn(
+    absl::Span<const std::vector<tensorflow::Tensor>> tensor_structures,
+    size_t index) {
+  const tensorflow::Tensor& first = tensor_structures[0][index];
+  tensorflow::TensorShape column_shape = first.shape();
+  column_shape.InsertDim(0, static_cast<int64_t>(tensor_structures.size()));
+  tensorflow::Tensor column(first.dtype(), column_shape);
+  for (size_t i = 0; i < tensor_structures.size(); i++) {
+    const tensorflow::Tensor& element = tensor_structures[i][index];
+    if (element.dtype() != first.dtype() || element.shape() != first.shape()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Expected the tensors at position ", index,
+          " of all structures to have the same dtype and shape, but found ",
+          first.DebugString(), " in structure 0 and ", element.DebugString(),
+          " in structure ", i, "."));
+    }
+    absl::Status status =
+        tensorflow::batch_util::CopyElementToSlice(element, &column, i);
+    if (!status.ok()) {
+      return absl::InternalError(absl::StrCat(
+          "Failed to stack sequence elements: ", status.message()));
+    }
+  }
+  return column;
+}
+
+// Returns the columns of the sequence of `tensor_structures`.
+absl::StatusOr<std::vector<tensorflow::Tensor>> StackColumns(
+    absl::Span<const std::vector<tensorflow::Tensor>> tensor_structures) {
+  if (tensor_structures.empty()) {
+    return absl::InvalidArgumentError(
+        "Cannot create the columns of a sequence from zero structures.");
+  }
+  const size_t num_columns = tensor_structures[0].size();
+  for (const std::vector<tensorflow::Tensor>& structure : tensor_structures) {
+    if (structure.size() != num_columns) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Cannot create the columns of a sequence from tensor structures of "
+          "different sizes ",
+          num_columns, " and ", structure.size(), "."));
+    }
+  }
+  std::vector<tensorflow::Tensor> columns;
+  columns.reserve(num_columns);
+  for (size_t i = 0; i < num_columns; i++) {
+    columns.push_back(TFF_TRY(StackColumn(tensor_structures, i)));
   }
+  return columns;
+}
+
+absl::StatusOr<std::unique_ptr<tensorflow::data::standalone::Dataset>>
+DatasetFromSerializedGraphDef(const std::string& serialized_graph_def) {
   tensorflow::GraphDef dataset_graph;
-  if (!dataset_graph.ParseFromString(sequence_pb.serialized_graph_def())) {
+  if (!dataset_graph.ParseFromString(serialized_graph_def)) {
     return absl::InternalError(
         "Error parsing Dataset GraphDef from TFF Value serialized GraphDef "
         "string.");
@@ -51,4 +134,75 @@ SequenceValueToDataset(const v0::Value::Sequence& sequence_pb) {
   return std::move(dataset);
 }
 
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<tensorflow::data::standalone::Dataset>>
+SequenceValueToDataset(const v0::Value::Sequence& sequence_pb) {
+  switch (sequence_pb.value_case()) {
+    case v0::Value::Sequence::kSerializedGraphDef:
+      return DatasetFromSerializedGraphDef(sequence_pb.serialized_graph_def());
+    case v0::Value::Sequence::kColumns: {
+      std::vector<tensorflow::Tensor> columns =
+          TFF_TRY(DeserializeColumns(sequence_pb.columns()));
+      tensorflow::Tensor graph_def_tensor =
+          TFF_TRY(DatasetFromColumns(columns));
+      const tensorflow::tstring& graph_def =
+          graph_def_tensor.flat<tensorflow::tstring>()(0);
+      return DatasetFromSerializedGraphDef(
+          std::string(graph_def.data(), graph_def.size()));
+    }
+    default:
+      return absl::UnimplementedError(
+          "Conversion from TFF Value to TF Dataset requires graphdef-based "
+          "or columnar serialization.");
+  }
+}
+
+absl::StatusOr<std::vector<tensorflow::Tensor>> SequenceValueToColumns(
+    const v0::Value::Sequence& sequence_pb) {
+  if (sequence_pb.has_columns()) {
+    return DeserializeColumns(sequence_pb.columns());
+  }
+  std::unique_ptr<tensorflow::data::standalone::Dataset> dataset =
+      TFF_TRY(SequenceValueToDataset(sequence_pb));
+  std::unique_ptr<tensorflow::data::standalone::Iterator> iterator;
+  absl::Status status = dataset->MakeIterator(&iterator);
+  if (!status.ok()) {
+    return absl::InternalError(absl::StrCat(
+        "Error creating iterator from dataset: ", status.message()));
+  }
+  std::vector<std::vector<tensorflow::Tensor>> elements;
+  while (true) {
+    std::vector<tensorflow::Tensor> element;
+    bool end_of_data = false;
+    status = iterator->GetNext(&element, &end_of_data);
+    if (!status.ok()) {
+      return absl::InternalError(absl::StrCat(
+          "Error pulling elements from dataset: ", status.message()));
+    }
+    if (end_of_data) {
+      break;
+    }
+    elements.push_back(std::move(element));
+  }
+  if (elements.empty()) {
+    return absl::UnimplementedError(
+        "Conversion of an empty sequence to columns is not supported.");
+  }
+  return StackColumns(elements);
+}
+
+absl::Status TensorStructuresToColumnarSequence(
+    absl::Span<const std::vector<tensorflow::Tensor>> tensor_structures,
+    v0::Value::Sequence* sequence_pb) {
+  std::vector<tensorflow::Tensor> columns =
+      TFF_TRY(StackColumns(tensor_structures));
+  v0::Value::Sequence::Columns* columns_pb = sequence_pb->mutable_columns();
+  columns_pb->Clear();
+  for (const tensorflow::Tensor& column : columns) {
+    TFF_TRY(SerializeTensorValue(column, columns_pb->add_tensor()));
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace tensorflow_federated
@@ -17,14 +17,33 @@ limitations under the License
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_DATASET_CONVERSIONS_H_
 
 #include <memory>
+#include <vector>
 
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
 
 namespace tensorflow_federated {
 absl::StatusOr<std::unique_ptr<tensorflow::data::standalone::Dataset>>
 SequenceValueToDataset(const v0::Value::Sequence& sequence_pb);
-}
+
+// Returns the columns of `sequence_pb`: one tensor per tensor of its flattened
+// elements, holding those tensors of all elements stacked along a new leading
+// dimension. Sequences serialized as datasets are iterated to build them.
+absl::StatusOr<std::vector<tensorflow::Tensor>> SequenceValueToColumns(
+    const v0::Value::Sequence& sequence_pb);
+
+// Serializes the sequence of `tensor_structures` to the columnar encoding of
+// `sequence_pb`. Leaves the element type of `sequence_pb` unchanged.
+//
+// Requirements: `tensor_structures` must be non-empty, and corresponding
+// tensors of all structures must have the same dtype and shape.
+absl::Status TensorStructuresToColumnarSequence(
+    absl::Span<const std::vector<tensorflow::Tensor>> tensor_structures,
+    v0::Value::Sequence* sequence_pb);
+}  // namespace tensorflow_federated
 
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_DATASET_CONVERSIONS_H_
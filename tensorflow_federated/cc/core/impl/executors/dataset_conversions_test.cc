@@ -25,8 +25,10 @@ limitations under the License
 #include "absl/status/status.h"
 #include "tensorflow/core/data/standalone.h"
 #include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/platform/tstring.h"
+#include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
 #include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
 #include "tensorflow_federated/cc/testing/protobuf_matchers.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
@@ -38,6 +40,9 @@ namespace {
 using ::absl::StatusCode;
 using ::tensorflow_federated::testing::EqualsProto;
 using ::tensorflow_federated::testing::SequenceV;
+using ::tensorflow_federated::testing::SequenceValueToList;
+using ::testing::HasSubstr;
+using ::testing::SizeIs;
 
 TEST(DatasetConversionsTest, TestDatasetCreationFromSequence) {
   v0::Value value_pb = SequenceV(0, 10, 1);
@@ -86,5 +91,57 @@ TEST(DatasetConversionsTest, TestIterationOverCreatedDataset) {
   EXPECT_EQ(values.size(), 10);
 }
 
+TEST(DatasetConversionsTest, TestColumnarSequenceConvertsToDataset) {
+  std::vector<std::vector<tensorflow::Tensor>> elements;
+  for (int64_t i = 0; i < 3; i++) {
+    elements.push_back({tensorflow::Tensor(i), tensorflow::Tensor(2.0f * i)});
+  }
+  v0::Value::Sequence sequence_pb;
+  TFF_ASSERT_OK(TensorStructuresToColumnarSequence(elements, &sequence_pb));
+  ASSERT_TRUE(sequence_pb.has_columns());
+  EXPECT_THAT(sequence_pb.columns().tensor(), SizeIs(2));
+  std::vector<std::vector<tensorflow::Tensor>> dataset_elements =
+      TFF_ASSERT_OK(SequenceValueToList(sequence_pb));
+  ASSERT_THAT(dataset_elements, SizeIs(3));
+  for (int64_t i = 0; i < 3; i++) {
+    ASSERT_THAT(dataset_elements[i], SizeIs(2));
+    EXPECT_EQ(dataset_elements[i][0].scalar<int64_t>()(), i);
+    EXPECT_EQ(dataset_elements[i][1].scalar<float>()(), 2.0f * i);
+  }
+}
+
+TEST(DatasetConversionsTest, TestSequenceValueToColumnsStacksDataset) {
+  v0::Value value_pb = SequenceV(0, 5, 1);
+  std::vector<tensorflow::Tensor> columns =
+      TFF_ASSERT_OK(SequenceValueToColumns(value_pb.sequence()));
+  ASSERT_THAT(columns, SizeIs(1));
+  ASSERT_EQ(columns[0].NumElements(), 5);
+  for (int64_t i = 0; i < 5; i++) {
+    EXPECT_EQ(columns[0].flat<int64_t>()(i), i);
+  }
+}
+
+TEST(DatasetConversionsTest, TestColumnarSequenceFailsOnMismatchedShapes) {
+  tensorflow::Tensor vector(tensorflow::DT_INT64, tensorflow::TensorShape({2}));
+  vector.flat<int64_t>().setZero();
+  v0::Value::Sequence sequence_pb;
+  EXPECT_THAT(TensorStructuresToColumnarSequence(
+                  {{tensorflow::Tensor(int64_t{1})}, {vector}}, &sequence_pb),
+              StatusIs(StatusCode::kInvalidArgument, HasSubstr("same dtype")));
+}
+
+TEST(DatasetConversionsTest, TestColumnsOfDifferentLengthsFail) {
+  v0::Value::Sequence sequence_pb;
+  TFF_ASSERT_OK(TensorStructuresToColumnarSequence(
+      {{tensorflow::Tensor(int64_t{1}), tensorflow::Tensor(int64_t{2})}},
+      &sequence_pb));
+  tensorflow::Tensor longer(tensorflow::DT_INT64, tensorflow::TensorShape({2}));
+  longer.flat<int64_t>().setZero();
+  TFF_ASSERT_OK(SerializeTensorValue(
+      longer, sequence_pb.mutable_columns()->mutable_tensor(1)));
+  EXPECT_THAT(SequenceValueToColumns(sequence_pb),
+              StatusIs(StatusCode::kInvalidArgument, HasSubstr("same length")));
+}
+
 }  // namespace
 }  // namespace tensorflow_federated
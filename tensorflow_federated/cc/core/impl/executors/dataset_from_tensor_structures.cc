@@ -51,6 +51,10 @@ std::string InputTensorName(size_t i, size_t element_index) {
   return absl::StrCat("structure_", i, "_element_", element_index);
 }
 
+std::string ColumnTensorName(size_t i) { return absl::StrCat("column_", i); }
+
+constexpr char kDatasetVariantTensorName[] = "dataset_variant";
+
 template <typename T>
 std::string MismatchedElementsMessage(std::string_view property,
                                       size_t element_index,
@@ -113,6 +117,65 @@ struct GraphWithOutput {
   std::string output_tensor_name;
 };
 
+// Adds a `TensorSliceDataset` over `inputs` to the graph of `scope`, followed
+// by its serialization with `DatasetToGraphV2`.
+//
+// Returns the graph and the name of the string tensor containing the serialized
+// dataset.
+absl::StatusOr<GraphWithOutput> SerializedTensorSliceDatasetGraph(
+    tf::Scope& scope, const std::vector<tf::NodeBuilder::NodeOut>& inputs,
+    const std::vector<tf::DataType>& element_dtypes,
+    const std::vector<tf::TensorShape>& element_shapes) {
+  tf::NodeBuilder ds_from_slice_builder("dataset", "TensorSliceDataset");
+  tf::data::Metadata metadata;
+  metadata.set_name("dataset");
+  ds_from_slice_builder.Attr("Toutput_types", element_dtypes)
+      .Attr("is_files", false)
+      .Attr("metadata", metadata.SerializeAsString())
+      .Attr("output_shapes", element_shapes)
+      .Input(inputs);
+  tf::Node* ds_from_slice;
+  scope.UpdateStatus(
+      ds_from_slice_builder.Finalize(scope.graph(), &ds_from_slice));
+  static constexpr std::string_view output_tensor_name = "serialized_dataset";
+  tf::NodeBuilder ds_to_graph_builder(output_tensor_name, "DatasetToGraphV2");
+  ds_to_graph_builder.Input(ds_from_slice, 0)
+      .Attr("external_state_policy", 0)
+      .Attr("strip_device_assignment", true)
+      .Device("/device:CPU:0");
+  scope.UpdateStatus(ds_to_graph_builder.Finalize(scope.graph(), nullptr));
+  tf::GraphDef graph_def;
+  absl::Status status = scope.ToGraphDef(&graph_def);
+  if (!status.ok()) {
+    return absl::InternalError(
+        absl::StrCat("Failure to create dataset graph: ", status.message()));
+  }
+  return GraphWithOutput{std::move(graph_def), std::string(output_tensor_name)};
+}
+
+// Creates a `tf::GraphDef` that serializes the dataset fed to the variant
+// placeholder named `kDatasetVariantTensorName` with `DatasetToGraphV2`.
+absl::StatusOr<GraphWithOutput> SerializeDatasetGraph() {
+  tf::Scope scope = tf::Scope::NewRootScope();
+  tf::ops::Placeholder placeholder(scope, tf::DT_VARIANT,
+                                   tf::ops::Placeholder::Shape({}));
+  placeholder.node()->set_name(kDatasetVariantTensorName);
+  static constexpr std::string_view output_tensor_name = "serialized_dataset";
+  tf::NodeBuilder ds_to_graph_builder(output_tensor_name, "DatasetToGraphV2");
+  ds_to_graph_builder.Input(placeholder.node(), 0)
+      .Attr("external_state_policy", 0)
+      .Attr("strip_device_assignment", true)
+      .Device("/device:CPU:0");
+  scope.UpdateStatus(ds_to_graph_builder.Finalize(scope.graph(), nullptr));
+  tf::GraphDef graph_def;
+  absl::Status status = scope.ToGraphDef(&graph_def);
+  if (!status.ok()) {
+    return absl::InternalError(absl::StrCat(
+        "Failure to create dataset serialization graph: ", status.message()));
+  }
+  return GraphWithOutput{std::move(graph_def), std::string(output_tensor_name)};
+}
+
 // Creates a `tf::GraphDef` that transforms an input list of structures of
 // tensors into a `tf.data.Dataset`.
 //
@@ -176,31 +239,75 @@ absl::StatusOr<GraphWithOutput> DatasetFromTensorStructuresGraph(
     stack.node()->set_name(absl::StrCat("stack_", element_index));
     ds_from_slice_inputs.push_back(tf::NodeBuilder::NodeOut(stack.node()));
   }
-  tf::NodeBuilder ds_from_slice_builder("dataset", "TensorSliceDataset");
-  tf::data::Metadata metadata;
-  metadata.set_name("dataset");
-  ds_from_slice_builder.Attr("Toutput_types", element_dtypes)
-      .Attr("is_files", false)
-      .Attr("metadata", metadata.SerializeAsString())
-      .Attr("output_shapes", element_shapes)
-      .Input(ds_from_slice_inputs);
-  tf::Node* ds_from_slice;
-  scope.UpdateStatus(
-      ds_from_slice_builder.Finalize(scope.graph(), &ds_from_slice));
-  static constexpr std::string_view output_tensor_name = "serialized_dataset";
-  tf::NodeBuilder ds_to_graph_builder(output_tensor_name, "DatasetToGraphV2");
-  ds_to_graph_builder.Input(ds_from_slice, 0)
-      .Attr("external_state_policy", 0)
-      .Attr("strip_device_assignment", true)
-      .Device("/device:CPU:0");
-  scope.UpdateStatus(ds_to_graph_builder.Finalize(scope.graph(), nullptr));
-  tf::GraphDef graph_def;
-  absl::Status status = scope.ToGraphDef(&graph_def);
+  return SerializedTensorSliceDatasetGraph(scope, ds_from_slice_inputs,
+                                           element_dtypes, element_shapes);
+}
+
+// Creates a `tf::GraphDef` that transforms a list of tensors into the
+// `tf.data.Dataset` of their slices along the leading dimension, with one
+// placeholder named by `ColumnTensorName` per tensor.
+absl::StatusOr<GraphWithOutput> DatasetFromColumnsGraph(
+    absl::Span<const tf::Tensor> columns) {
+  if (columns.empty()) {
+    return absl::InvalidArgumentError(
+        "Cannot create dataset from zero columns.");
+  }
+  tf::Scope scope = tf::Scope::NewRootScope();
+  std::vector<tf::DataType> element_dtypes;
+  element_dtypes.reserve(columns.size());
+  std::vector<tf::TensorShape> element_shapes;
+  element_shapes.reserve(columns.size());
+  std::vector<tf::NodeBuilder::NodeOut> ds_from_slice_inputs;
+  ds_from_slice_inputs.reserve(columns.size());
+  for (size_t i = 0; i < columns.size(); i++) {
+    const tf::Tensor& column = columns[i];
+    if (column.dims() == 0) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Cannot create dataset from scalar column ", i, "."));
+    }
+    if (column.dim_size(0) != columns[0].dim_size(0)) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Cannot create dataset from columns of different lengths ",
+          columns[0].dim_size(0), " and ", column.dim_size(0), "."));
+    }
+    tf::TensorShape element_shape = column.shape();
+    element_shape.RemoveDim(0);
+    element_dtypes.push_back(column.dtype());
+    element_shapes.push_back(element_shape);
+    tf::ops::Placeholder placeholder(
+        scope, column.dtype(), tf::ops::Placeholder::Shape(column.shape()));
+    placeholder.node()->set_name(ColumnTensorName(i));
+    ds_from_slice_inputs.push_back(
+        tf::NodeBuilder::NodeOut(placeholder.node()));
+  }
+  return SerializedTensorSliceDatasetGraph(scope, ds_from_slice_inputs,
+                                           element_dtypes, element_shapes);
+}
+
+// Runs the graph returned by one of the functions above, and returns its
+// serialized dataset.
+absl::StatusOr<tf::Tensor> RunDatasetGraph(
+    GraphWithOutput graph_and_output_tensor_name,
+    std::vector<std::pair<std::string, tf::Tensor>> inputs) {
+  SessionProvider session_provider(
+      std::move(graph_and_output_tensor_name.graph));
+  auto session = TFF_TRY(session_provider.BorrowSession());
+  std::vector<tf::Tensor> outputs;
+  absl::Status status = session->Run(
+      inputs, {std::move(graph_and_output_tensor_name.output_tensor_name)},
+      /*target_tensor_names=*/{}, &outputs);
   if (!status.ok()) {
     return absl::InternalError(
-        absl::StrCat("Failure to create dataset graph: ", status.message()));
+        absl::StrCat("Failed to run dataset creation computation: ",
+                     status.message()));
   }
-  return GraphWithOutput{std::move(graph_def), std::string(output_tensor_name)};
+  if (outputs.size() != 1) {
+    return absl::InternalError(
+        absl::StrCat("Expected dataset creation computation to return "
+                     "exactly one tensor, but found ",
+                     outputs.size(), " tensors."));
+  }
+  return std::move(outputs.back());
 }
 
 }  // namespace
@@ -209,9 +316,6 @@ absl::StatusOr<tf::Tensor> DatasetFromTensorStructures(
     TensorStructuresSpan tensor_structures) {
   GraphWithOutput graph_and_output_tensor_name =
       TFF_TRY(DatasetFromTensorStructuresGraph(tensor_structures));
-  tf::GraphDef& graph_def = graph_and_output_tensor_name.graph;
-  std::string& output_tensor_name =
-      graph_and_output_tensor_name.output_tensor_name;
   std::vector<std::pair<std::string, tf::Tensor>> inputs;
   for (size_t i = 0; i < tensor_structures.size(); i++) {
     absl::Span<const tf::Tensor> structure = tensor_structures[i];
@@ -221,23 +325,38 @@ absl::StatusOr<tf::Tensor> DatasetFromTensorStructures(
                                       structure[element_index]));
     }
   }
-  SessionProvider session_provider(std::move(graph_def));
-  auto session = TFF_TRY(session_provider.BorrowSession());
-  std::vector<tf::Tensor> outputs;
-  absl::Status status = session->Run(inputs, {std::move(output_tensor_name)},
-                                     /*target_tensor_names=*/{}, &outputs);
-  if (!status.ok()) {
-    return absl::InternalError(
-        absl::StrCat("Failed to run DatasetFromTensorStructures computation: ",
-                     status.message()));
+  return RunDatasetGraph(std::move(graph_and_output_tensor_name),
+                         std::move(inputs));
+}
+
+absl::StatusOr<tf::Tensor> DatasetFromColumns(
+    absl::Span<const tf::Tensor> columns) {
+  GraphWithOutput graph_and_output_tensor_name =
+      TFF_TRY(DatasetFromColumnsGraph(columns));
+  std::vector<std::pair<std::string, tf::Tensor>> inputs;
+  inputs.reserve(columns.size());
+  for (size_t i = 0; i < columns.size(); i++) {
+    inputs.push_back(std::make_pair(ColumnTensorName(i), columns[i]));
   }
-  if (outputs.size() != 1) {
-    return absl::InternalError(
-        absl::StrCat("Expected DatasetFromTensorStructures to return exactly "
-                     "one tensor, but found ",
-                     outputs.size(), " tensors."));
+  return RunDatasetGraph(std::move(graph_and_output_tensor_name),
+                         std::move(inputs));
+}
+
+absl::StatusOr<tf::Tensor> SerializeDataset(const tf::Tensor& dataset_variant) {
+  if (dataset_variant.dtype() != tf::DT_VARIANT ||
+      dataset_variant.dims() != 0) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected a scalar variant tensor holding a dataset, found tensor with "
+        "dtype ",
+        dataset_variant.dtype(), " and rank ", dataset_variant.dims(), "."));
   }
-  return std::move(outputs.back());
+  GraphWithOutput graph_and_output_tensor_name =
+      TFF_TRY(SerializeDatasetGraph());
+  std::vector<std::pair<std::string, tf::Tensor>> inputs;
+  inputs.push_back(
+      std::make_pair(std::string(kDatasetVariantTensorName), dataset_variant));
+  return RunDatasetGraph(std::move(graph_and_output_tensor_name),
+                         std::move(inputs));
 }
 
 }  // namespace tensorflow_federated
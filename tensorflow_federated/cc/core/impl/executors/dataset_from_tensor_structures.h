@@ -36,6 +36,21 @@ namespace tensorflow_federated {
 absl::StatusOr<tensorflow::Tensor> DatasetFromTensorStructures(
     absl::Span<const std::vector<tensorflow::Tensor>> tensor_structures);
 
+// Creates a TensorFlow dataset of the slices of `columns` along their leading
+// dimension, equivalent to `tf.data.Dataset.from_tensor_slices(columns)`, and
+// serializes it into a single string tensor.
+//
+// Requirements: `columns` must be non-empty, and all of its tensors must have
+// a leading dimension of the same size.
+absl::StatusOr<tensorflow::Tensor> DatasetFromColumns(
+    absl::Span<const tensorflow::Tensor> columns);
+
+// Serializes the dataset of `dataset_variant`, a scalar variant tensor as
+// produced by the dataset ops of a graph, into a single string tensor holding
+// its GraphDef, as the functions above return.
+absl::StatusOr<tensorflow::Tensor> SerializeDataset(
+    const tensorflow::Tensor& dataset_variant);
+
 }  // namespace tensorflow_federated
 
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_DATASET_FROM_TENSOR_STRUCTURES_H_
@@ -212,6 +212,14 @@ TEST(DatasetFromTensorStructuresTest, FailsOnMismatchedRanks) {
               StatusIs(StatusCode::kInvalidArgument, HasSubstr("rank")));
 }
 
+TEST(SerializeDatasetTest, FailsOnNonVariantTensor) {
+  tf::Tensor serialized_dataset = TFF_ASSERT_OK(DatasetFromTensorStructures({
+      {tf::Tensor(5)},
+  }));
+  EXPECT_THAT(SerializeDataset(serialized_dataset),
+              StatusIs(StatusCode::kInvalidArgument, HasSubstr("variant")));
+}
+
 }  // namespace
 
 }  // namespace tensorflow_federated
@@ -0,0 +1,99 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/dispose_queue.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/synchronization/mutex.h"
+#include "include/grpcpp/grpcpp.h"
+#include "include/grpcpp/support/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+DisposeQueue::DisposeQueue(
+    std::shared_ptr<v0::ExecutorGroup::StubInterface> stub,
+    v0::ExecutorId executor_pb, DisposeQueueOptions options)
+    : stub_(std::move(stub)),
+      executor_pb_(std::move(executor_pb)),
+      options_(options),
+      worker_([this] { Run(); }) {}
+
+DisposeQueue::~DisposeQueue() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  worker_.join();
+}
+
+void DisposeQueue::Add(v0::ValueRef value_ref) {
+  absl::MutexLock lock(&mutex_);
+  pending_.push_back(std::move(value_ref));
+}
+
+void DisposeQueue::Run() {
+  mutex_.Lock();
+  while (true) {
+    mutex_.Await(absl::Condition(this, &DisposeQueue::HasPendingOrStopping));
+    if (pending_.empty()) {
+      // Stopping, and every ref has been sent.
+      break;
+    }
+    // Give more refs a chance to join the batch, unless it is already full.
+    mutex_.AwaitWithTimeout(
+        absl::Condition(this, &DisposeQueue::IsBatchFullOrStopping),
+        options_.flush_interval);
+    std::vector<v0::ValueRef> value_refs = std::move(pending_);
+    pending_.clear();
+    mutex_.Unlock();
+    Dispose(std::move(value_refs));
+    mutex_.Lock();
+  }
+  mutex_.Unlock();
+}
+
+void DisposeQueue::Dispose(std::vector<v0::ValueRef> value_refs) {
+  for (size_t begin = 0; begin < value_refs.size();
+       begin += options_.max_batch_size) {
+    const size_t end =
+        std::min(begin + options_.max_batch_size, value_refs.size());
+    v0::DisposeRequest request;
+    v0::DisposeResponse response;
+    grpc::ClientContext context;
+    *request.mutable_executor() = executor_pb_;
+    for (size_t i = begin; i < end; ++i) {
+      *request.add_value_ref() = std::move(value_refs[i]);
+    }
+    grpc::Status dispose_status = stub_->Dispose(&context, request, &response);
+    if (!dispose_status.ok()) {
+      LOG(ERROR) << "Error disposing of " << request.value_ref_size()
+                 << " ExecutorValues, starting with ["
+                 << request.value_ref(0).id()
+                 << "]: " << grpc_to_absl(dispose_status);
+    }
+  }
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,93 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_DISPOSE_QUEUE_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_DISPOSE_QUEUE_H_
+
+#include <cstddef>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+struct DisposeQueueOptions {
+  // Maximum number of value refs sent in a single `DisposeRequest`. A batch is
+  // sent as soon as this many refs are pending.
+  size_t max_batch_size = 1000;
+  // Maximum time a value ref waits for more refs to join its batch.
+  absl::Duration flush_interval = absl::Milliseconds(50);
+};
+
+// Coalesces the disposal of the values of a remote executor into batched
+// `Dispose` requests.
+//
+// Value refs added to the queue are sent by a single background thread, once
+// `max_batch_size` refs are pending or `flush_interval` after the first
+// pending ref was added, whichever comes first. Refs still pending when the
+// queue is destroyed are sent before the destructor returns.
+//
+// The queue holds a reference to the stub, so that a stub whose deleter
+// disposes of the executor only does so after all values of the executor
+// have been disposed.
+//
+// This class is thread safe.
+class DisposeQueue {
+ public:
+  DisposeQueue(std::shared_ptr<v0::ExecutorGroup::StubInterface> stub,
+               v0::ExecutorId executor_pb,
+               DisposeQueueOptions options = DisposeQueueOptions());
+  ~DisposeQueue();
+
+  // DisposeQueue is neither copyable nor movable.
+  DisposeQueue(const DisposeQueue&) = delete;
+  DisposeQueue& operator=(const DisposeQueue&) = delete;
+
+  // Schedules the disposal of the value referred to by `value_ref`.
+  void Add(v0::ValueRef value_ref) ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  bool HasPendingOrStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !pending_.empty() || stopping_;
+  }
+  bool IsBatchFullOrStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return pending_.size() >= options_.max_batch_size || stopping_;
+  }
+
+  // Body of the background thread.
+  void Run() ABSL_LOCKS_EXCLUDED(mutex_);
+  // Sends `value_refs` in one or more `Dispose` requests.
+  void Dispose(std::vector<v0::ValueRef> value_refs);
+
+  const std::shared_ptr<v0::ExecutorGroup::StubInterface> stub_;
+  const v0::ExecutorId executor_pb_;
+  const DisposeQueueOptions options_;
+  absl::Mutex mutex_;
+  std::vector<v0::ValueRef> pending_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  // Declared last, so that the thread only starts once all other members are
+  // initialized.
+  std::thread worker_;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_DISPOSE_QUEUE_H_
@@ -0,0 +1,129 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/dispose_queue.h"
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/support/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_grpc.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::tensorflow_federated::testing::EqualsProto;
+
+constexpr char kExecutorId[] = "executor_id";
+
+v0::ValueRef ValueRef(std::string id) {
+  v0::ValueRef value_ref;
+  value_ref.set_id(std::move(id));
+  return value_ref;
+}
+
+v0::ExecutorId ExecutorId() {
+  v0::ExecutorId executor_pb;
+  executor_pb.set_id(kExecutorId);
+  return executor_pb;
+}
+
+v0::DisposeRequest DisposeRequest(std::initializer_list<std::string> ids) {
+  v0::DisposeRequest request;
+  *request.mutable_executor() = ExecutorId();
+  for (const std::string& id : ids) {
+    *request.add_value_ref() = ValueRef(id);
+  }
+  return request;
+}
+
+DisposeQueueOptions Options(size_t max_batch_size,
+                            absl::Duration flush_interval) {
+  DisposeQueueOptions options;
+  options.max_batch_size = max_batch_size;
+  options.flush_interval = flush_interval;
+  return options;
+}
+
+class DisposeQueueTest : public ::testing::Test {
+ protected:
+  DisposeQueueTest()
+      : mock_service_(mock_server_.service()), stub_(mock_server_.NewStub()) {}
+
+  MockGrpcExecutorServer mock_server_;
+  MockGrpcExecutorService* mock_service_;
+  std::shared_ptr<v0::ExecutorGroup::StubInterface> stub_;
+};
+
+TEST_F(DisposeQueueTest, FlushesPendingRefsInOneRequestOnDestruction) {
+  EXPECT_CALL(
+      *mock_service_,
+      Dispose(::testing::_, EqualsProto(DisposeRequest({"a", "b", "c"})),
+              ::testing::_))
+      .WillOnce(::testing::Return(grpc::Status::OK));
+  DisposeQueue queue(stub_, ExecutorId(), Options(10, absl::Hours(1)));
+  queue.Add(ValueRef("a"));
+  queue.Add(ValueRef("b"));
+  queue.Add(ValueRef("c"));
+}
+
+TEST_F(DisposeQueueTest, SplitsBatchesAtMaxBatchSize) {
+  ::testing::InSequence seq;
+  EXPECT_CALL(*mock_service_,
+              Dispose(::testing::_, EqualsProto(DisposeRequest({"a", "b"})),
+                      ::testing::_))
+      .WillOnce(::testing::Return(grpc::Status::OK));
+  EXPECT_CALL(*mock_service_,
+              Dispose(::testing::_, EqualsProto(DisposeRequest({"c"})),
+                      ::testing::_))
+      .WillOnce(::testing::Return(grpc::Status::OK));
+  DisposeQueue queue(stub_, ExecutorId(), Options(2, absl::Hours(1)));
+  queue.Add(ValueRef("a"));
+  queue.Add(ValueRef("b"));
+  queue.Add(ValueRef("c"));
+}
+
+TEST_F(DisposeQueueTest, FlushesAfterInterval) {
+  absl::Notification disposed;
+  EXPECT_CALL(*mock_service_,
+              Dispose(::testing::_, EqualsProto(DisposeRequest({"a"})),
+                      ::testing::_))
+      .WillOnce([&disposed] {
+        disposed.Notify();
+        return grpc::Status::OK;
+      });
+  DisposeQueue queue(stub_, ExecutorId(), Options(10, absl::Milliseconds(1)));
+  queue.Add(ValueRef("a"));
+  // The request is sent while the queue is still alive.
+  disposed.WaitForNotification();
+}
+
+TEST_F(DisposeQueueTest, DestroyedWithoutPendingRefs) {
+  EXPECT_CALL(*mock_service_, Dispose).Times(0);
+  DisposeQueue queue(stub_, ExecutorId());
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -19,8 +19,11 @@ limitations under the License
 #include <memory>
 #include <string>
 
+#include "absl/base/const_init.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
+#include "absl/synchronization/mutex.h"
 #include "tensorflow/c/eager/c_api.h"
 #include "tensorflow/c/eager/tfe_op_internal.h"
 #include "tensorflow/c/tf_status.h"
@@ -29,6 +32,25 @@ limitations under the License
 #include "tensorflow/dtensor/cc/tensor_layout.h"
 #include "tensorflow/dtensor/cc/tensor_with_layout.h"
 
+namespace {
+
+// The device info of the DTensor devices registered by
+// `TFE_DTENSOR_RegisterDTensorDevice`, by device name.
+ABSL_CONST_INIT absl::Mutex device_info_mutex(absl::kConstInit);
+
+absl::flat_hash_map<std::string, void*>& RegisteredDeviceInfo() {
+  static auto* const device_info = new absl::flat_hash_map<std::string, void*>;
+  return *device_info;
+}
+
+void* FindDeviceInfo(const char* device_name) {
+  absl::MutexLock lock(&device_info_mutex);
+  auto it = RegisteredDeviceInfo().find(device_name);
+  return it == RegisteredDeviceInfo().end() ? nullptr : it->second;
+}
+
+}  // namespace
+
 extern "C" {
 
 void* TFE_DTENSOR_RegisterDTensorDevice(TFE_Context* context,
@@ -57,6 +79,8 @@ void* TFE_DTENSOR_RegisterDTensorDevice(TFE_Context* context,
                                                   status);
   if (TF_GetCode(status) != TF_OK) return nullptr;
 
+  absl::MutexLock lock(&device_info_mutex);
+  RegisteredDeviceInfo()[dtensor_device_name] = device_info;
   return device_info;
 }
 
@@ -98,6 +122,25 @@ TFE_TensorHandle* TFE_DTENSOR_TensorToDTensor(
   return result;
 }
 
+TFE_TensorHandle* TFE_DTENSOR_ShardsToDTensor(
+    TFE_Context* context, TFE_TensorHandle** shards, int num_shards,
+    const tensorflow::TF_Layout* layout, const char* device_name,
+    TF_Status* status) {
+  void* device_info = FindDeviceInfo(device_name);
+  if (device_info == nullptr) {
+    TF_SetStatus(status, TF_FAILED_PRECONDITION,
+                 absl::StrCat("Sharded tensors can only be placed on DTensor "
+                              "devices registered with "
+                              "TFE_DTENSOR_RegisterDTensorDevice, found ",
+                              device_name)
+                     .c_str());
+    return nullptr;
+  }
+  return tensorflow::dtensor::Pack(context, num_shards, shards,
+                                   tensorflow::unwrap(layout)->ToString(),
+                                   device_info, status);
+}
+
 TFE_TensorHandle* TFE_DTENSOR_DTensorToTensor(TFE_Context* context,
                                               TFE_TensorHandle* dtensor_handle,
                                               const char* device_name,
@@ -43,6 +43,17 @@ TFE_TensorHandle* TFE_DTENSOR_TensorToDTensor(
     const tensorflow::TF_Layout* layout, const char* device_name,
     TF_Status* status);
 
+// Packs `shards`, one tensor for each local device of the mesh of `layout` in
+// the order of the devices of the mesh, into a DTensor with that layout. Each
+// shard is copied to its device directly, without materializing the global
+// tensor.
+// The DTensor device must have been registered with
+// TFE_DTENSOR_RegisterDTensorDevice.
+TFE_TensorHandle* TFE_DTENSOR_ShardsToDTensor(
+    TFE_Context* context, TFE_TensorHandle** shards, int num_shards,
+    const tensorflow::TF_Layout* layout, const char* device_name,
+    TF_Status* status);
+
 // Copies input DTensor to Tensor, by removing the sharding and
 // returns the global tensor value handle.
 TFE_TensorHandle* TFE_DTENSOR_DTensorToTensor(TFE_Context* context,
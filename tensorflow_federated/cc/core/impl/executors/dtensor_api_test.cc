@@ -165,6 +165,64 @@ TEST_F(DTensorAPITest, CheckTensorDTensorWithShardedLayout) {
   TFE_DeleteTensorHandle(converted_tensor_handle);
 }
 
+TEST_F(DTensorAPITest, CheckShardsToDTensor) {
+  TF_Status* status = TF_NewStatus();
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
+      TFE_NewContextOptions(), TFE_DeleteContextOptions);
+  std::unique_ptr<TFE_Context, decltype(&TFE_DeleteContext)> context(
+      TFE_NewContext(opts.get(), status), TFE_DeleteContext);
+  TFE_SetLogicalCpuDevices(context.get(), 2, "/job:localhost/replica:0/task:0",
+                           status);
+
+  TF_ASSERT_OK_AND_ASSIGN(auto mesh, tensorflow::dtensor::Mesh::ParseFromProto(
+                                         CreateMeshForTest()));
+  TFE_DTENSOR_RegisterDTensorDevice(context.get(), tensorflow::wrap(&mesh),
+                                    device_name_.c_str(), status);
+  ASSERT_EQ(TF_GetCode(status), TF_OK) << TF_Message(status);
+  TF_ASSERT_OK_AND_ASSIGN(auto layout, ShardedOnFirstDimLayout(1, mesh));
+
+  TFE_TensorHandle* shards[] = {
+      TFE_NewTensorHandle(
+          CreateIntTensor(tensorflow::TensorShape({2}), {1, 2}), status),
+      TFE_NewTensorHandle(
+          CreateIntTensor(tensorflow::TensorShape({2}), {3, 4}), status)};
+  TFE_TensorHandle* dtensor_handle = TFE_DTENSOR_ShardsToDTensor(
+      context.get(), shards, /*num_shards=*/2, tensorflow::wrap(&layout),
+      device_name_.c_str(), status);
+  ASSERT_EQ(TF_GetCode(status), TF_OK) << TF_Message(status);
+
+  tensorflow::ImmediateExecutionTensorHandle* dtensor =
+      tensorflow::unwrap(dtensor_handle);
+  EXPECT_THAT(dtensor->DebugString(),
+              AllOf(HasSubstr("dtype=DT_INT32"),
+                    HasSubstr("{\"CPU:0\": [1 2], \"CPU:1\": [3 4]}"),
+                    HasSubstr("sharding_specs:x")));
+
+  TF_DeleteStatus(status);
+  TFE_DeleteTensorHandle(shards[0]);
+  TFE_DeleteTensorHandle(shards[1]);
+  TFE_DeleteTensorHandle(dtensor_handle);
+}
+
+TEST_F(DTensorAPITest, CheckShardsToUnregisteredDeviceFails) {
+  TF_Status* status = TF_NewStatus();
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
+      TFE_NewContextOptions(), TFE_DeleteContextOptions);
+  std::unique_ptr<TFE_Context, decltype(&TFE_DeleteContext)> context(
+      TFE_NewContext(opts.get(), status), TFE_DeleteContext);
+  TF_ASSERT_OK_AND_ASSIGN(auto mesh, tensorflow::dtensor::Mesh::ParseFromProto(
+                                         CreateMeshForTest()));
+  TF_ASSERT_OK_AND_ASSIGN(auto layout, ShardedOnFirstDimLayout(1, mesh));
+
+  TFE_TensorHandle* dtensor_handle = TFE_DTENSOR_ShardsToDTensor(
+      context.get(), /*shards=*/nullptr, /*num_shards=*/0,
+      tensorflow::wrap(&layout),
+      "/job:localhost/replica:0/task:0/device:CUSTOM:7", status);
+  EXPECT_EQ(dtensor_handle, nullptr);
+  EXPECT_EQ(TF_GetCode(status), TF_FAILED_PRECONDITION);
+  TF_DeleteStatus(status);
+}
+
 TEST_F(DTensorAPITest, CheckCopyToMesh) {
   TF_Status* status = TF_NewStatus();
   std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
@@ -33,6 +33,7 @@ limitations under the License
 #include "absl/strings/str_split.h"
 #include "absl/types/span.h"
 #include "tensorflow/c/eager/c_api.h"
+#include "tensorflow/c/eager/c_api_experimental.h"
 #include "tensorflow/c/eager/tfe_tensorhandle_internal.h"
 #include "tensorflow/c/tf_status.h"
 #include "tensorflow/c/tf_tensor.h"
@@ -49,6 +50,23 @@ limitations under the License
 #include "tensorflow_federated/proto/v0/executor.pb.h"
 
 namespace tensorflow_federated {
+
+TFE_TensorHandle* DTensorConverter::ShardsToDTensor(
+    TFE_Context* context, TFE_TensorHandle** shards, int num_shards,
+    const tensorflow::TF_Layout* layout, const char* device_name,
+    TF_Status* status) {
+  return TFE_DTENSOR_ShardsToDTensor(context, shards, num_shards, layout,
+                                     device_name, status);
+}
+
+TFE_TensorHandle* DTensorConverter::Relayout(
+    TFE_Context* context, TFE_TensorHandle* dtensor_handle,
+    const tensorflow::TF_Layout* layout, const char* device_name,
+    TF_Status* status) {
+  return TFE_DTENSOR_Relayout(context, dtensor_handle, layout, device_name,
+                              status);
+}
+
 namespace {
 
 class DTensorConverterImpl : public DTensorConverter {
@@ -74,6 +92,60 @@ class DTensorConverterImpl : public DTensorConverter {
   };
 };
 
+// The layout a computation specifies for a tensor of its parameter.
+struct ParameterLayout {
+  tensorflow::dtensor::Layout layout;
+  // `layout.ToString()`, to compare with the layouts of bound DTensors.
+  std::string layout_string;
+};
+
+// The layouts of the tensors of a computation parameter in the flattened order
+// of its binding, or nullopt for tensors without a layout. These are computed
+// once per computation, so that binding an argument does not look up the
+// tensor names of the binding in the layout map on every call.
+using ParameterLayouts = std::vector<std::optional<ParameterLayout>>;
+
+// Appends the layouts of the tensors of `binding` in `layout_map` to
+// `parameter_layouts`, in flattened order.
+void AppendParameterLayouts(
+    const v0::TensorFlow::Binding& binding,
+    const std::map<std::string, tensorflow::dtensor::Layout>& layout_map,
+    ParameterLayouts& parameter_layouts) {
+  switch (binding.binding_case()) {
+    case v0::TensorFlow::Binding::kTensor: {
+      // Binding names have suffix ":N" in them, remove that to look up nodes.
+      auto it = layout_map.find(GetNodeName(binding.tensor().tensor_name()));
+      if (it == layout_map.end()) {
+        parameter_layouts.emplace_back(std::nullopt);
+      } else {
+        parameter_layouts.emplace_back(
+            ParameterLayout{it->second, it->second.ToString()});
+      }
+      return;
+    }
+    case v0::TensorFlow::Binding::kStruct: {
+      for (const auto& element : binding.struct_().element()) {
+        AppendParameterLayouts(element, layout_map, parameter_layouts);
+      }
+      return;
+    }
+    default:
+      return;
+  }
+}
+
+// Returns the layout of the tensor bound next, i.e. at flat index
+// `bindings.size()`, or nullptr if the computation specifies none.
+const ParameterLayout* NextParameterLayout(
+    const ParameterLayouts& parameter_layouts,
+    const std::vector<TFE_TensorHandle*>& bindings) {
+  if (bindings.size() >= parameter_layouts.size() ||
+      !parameter_layouts[bindings.size()].has_value()) {
+    return nullptr;
+  }
+  return &*parameter_layouts[bindings.size()];
+}
+
 class Value {
  public:
   // Method for materializing value as Value Proto.
@@ -92,10 +164,12 @@ class Value {
   // This is required to construct a flattened list of input arguments when
   // calling Computation.
   // TODO: b/256948367 - If parameter name has a layout provided in layout map,
-  // this method also converts input Tensor to DTensor with given layout.
+  // this method also converts input Tensor to DTensor with given layout. The
+  // layout of each tensor is looked up in `parameter_layouts` by its index in
+  // `bindings`.
   virtual absl::Status Bind(
       TFE_Context* context, const v0::TensorFlow::Binding& shape,
-      const std::map<std::string, tensorflow::dtensor::Layout>& layout_map,
+      const ParameterLayouts& parameter_layouts,
       std::vector<TFE_TensorHandle*>& bindings,
       std::optional<std::string> device_name,
       std::optional<const tensorflow::dtensor::Mesh> mesh) = 0;
@@ -111,15 +185,34 @@ using ExecutorValue = std::shared_ptr<Value>;
 absl::StatusOr<ExecutorValue> CreateValueAny(
     const v0::Value& value_pb,
     std::optional<tensorflow::dtensor::Mesh> mesh = std::nullopt,
-    DTensorConverter* converter = nullptr);
+    DTensorConverter* converter = nullptr, TFE_Context* context = nullptr,
+    std::optional<std::string> device_name = std::nullopt);
+
+// Returns the layout on `mesh` described by the comma-separated
+// `sharding_spec`.
+absl::StatusOr<tensorflow::dtensor::Layout> LayoutFromShardingSpec(
+    const std::string& sharding_spec, const tensorflow::dtensor::Mesh& mesh) {
+  std::vector<std::string> sharding_specs = absl::StrSplit(sharding_spec, ',');
+  auto layout_or = tensorflow::dtensor::Layout::GetLayout(sharding_specs, mesh);
+  if (!layout_or.ok()) {
+    return layout_or.status();
+  }
+  return layout_or.value();
+}
 
 class TensorValue : public Value {
  public:
-  explicit TensorValue(TFE_TensorHandle* handle, DTensorConverter* converter)
+  // If `layout` is set, `handle` is a DTensor with that layout, placed on the
+  // mesh when the value was created.
+  explicit TensorValue(
+      TFE_TensorHandle* handle, DTensorConverter* converter,
+      std::optional<tensorflow::dtensor::Layout> layout = std::nullopt)
       : value_(std::unique_ptr<TFE_TensorHandle,
                                decltype(&TFE_DeleteTensorHandle)>(
             handle, TFE_DeleteTensorHandle)),
-        converter_(converter) {}
+        converter_(converter),
+        layout_(std::move(layout)),
+        layout_string_(layout_.has_value() ? layout_->ToString() : "") {}
 
   static absl::StatusOr<ExecutorValue> CreateTensor(
       const v0::Value& value_pb, DTensorConverter* converter) {
@@ -130,6 +223,56 @@ class TensorValue : public Value {
         TFE_NewTensorHandle(tensor, status.get()), converter);
   }
 
+  // Places each shard of `value_pb` directly on its device of `mesh`, so that
+  // the global tensor is never materialized on the host nor replicated over
+  // the mesh.
+  static absl::StatusOr<ExecutorValue> CreateShardedTensor(
+      const v0::Value& value_pb, TFE_Context* context,
+      std::optional<std::string> device_name,
+      std::optional<tensorflow::dtensor::Mesh> mesh,
+      DTensorConverter* converter) {
+    if (!mesh.has_value() || !device_name.has_value()) {
+      return absl::InvalidArgumentError(
+          "Sharded tensors can only be created in a DTensorExecutor with a "
+          "mesh and a DTensor device.");
+    }
+    const v0::Value::ShardedTensor& sharded_pb = value_pb.sharded_tensor();
+    tensorflow::dtensor::Layout layout =
+        TFF_TRY(LayoutFromShardingSpec(sharded_pb.sharding_spec(), *mesh));
+    if (sharded_pb.shard_size() != mesh->local_devices().size()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Expected one shard for each of the ", mesh->local_devices().size(),
+          " local devices of the mesh, found ", sharded_pb.shard_size(),
+          " shards."));
+    }
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+        TF_NewStatus(), TF_DeleteStatus);
+    std::vector<
+        std::unique_ptr<TFE_TensorHandle, decltype(&TFE_DeleteTensorHandle)>>
+        shard_owners;
+    std::vector<TFE_TensorHandle*> shards;
+    shard_owners.reserve(sharded_pb.shard_size());
+    shards.reserve(sharded_pb.shard_size());
+    for (const v0::Value& shard_pb : sharded_pb.shard()) {
+      tensorflow::Tensor shard = TFF_TRY(DeserializeTensorValue(shard_pb));
+      shard_owners.emplace_back(TFE_NewTensorHandle(shard, status.get()),
+                                TFE_DeleteTensorHandle);
+      if (TF_GetCode(status.get()) != TF_OK) {
+        return absl::InternalError(absl::StrCat(
+            "Shard creation failed: ", TF_Message(status.get())));
+      }
+      shards.push_back(shard_owners.back().get());
+    }
+    TFE_TensorHandle* dtensor = converter->ShardsToDTensor(
+        context, shards.data(), shards.size(), tensorflow::wrap(&layout),
+        device_name->c_str(), status.get());
+    if (TF_GetCode(status.get()) != TF_OK) {
+      return absl::InternalError(absl::StrCat("dtensor creation failed.. ",
+                                              TF_Message(status.get())));
+    }
+    return std::make_shared<TensorValue>(dtensor, converter, std::move(layout));
+  }
+
   TF_Tensor* GetTensorValue(TFE_Context* context,
                             std::optional<std::string> device_name,
                             TF_Status* status) {
@@ -188,7 +331,7 @@ class TensorValue : public Value {
 
   absl::Status Bind(
       TFE_Context* context, const v0::TensorFlow::Binding& shape,
-      const std::map<std::string, tensorflow::dtensor::Layout>& layout_map,
+      const ParameterLayouts& parameter_layouts,
       std::vector<TFE_TensorHandle*>& bindings,
       std::optional<std::string> device_name,
       std::optional<const tensorflow::dtensor::Mesh> mesh) override {
@@ -196,14 +339,18 @@ class TensorValue : public Value {
       return absl::InvalidArgumentError(
           "Attempted to bind tensor value to non-tensor Binding.");
     }
+    if (layout_.has_value()) {
+      return BindDTensor(context, shape, parameter_layouts, bindings,
+                         device_name, mesh);
+    }
     if (mesh.has_value() && device_name.has_value()) {
       std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
           TF_NewStatus(), TF_DeleteStatus);
-      // Binding names have suffix ":N" in them, remove that to look up nodes.
-      auto it = layout_map.find(GetNodeName(shape.tensor().tensor_name()));
+      const ParameterLayout* parameter_layout =
+          NextParameterLayout(parameter_layouts, bindings);
       tensorflow::dtensor::Layout layout;
-      if (it != layout_map.end() && device_name.has_value()) {
-        layout = it->second;
+      if (parameter_layout != nullptr) {
+        layout = parameter_layout->layout;
       } else {
         // If layout map does not have sharding specified for the Tensor,
         // place the tensor on device with replicated layout.
@@ -234,15 +381,57 @@ class TensorValue : public Value {
   }
 
  private:
+  // Binds a value already placed on the mesh. The DTensor is bound as is if
+  // the computation does not specify another layout for it, and relayed out
+  // otherwise.
+  absl::Status BindDTensor(
+      TFE_Context* context, const v0::TensorFlow::Binding& shape,
+      const ParameterLayouts& parameter_layouts,
+      std::vector<TFE_TensorHandle*>& bindings,
+      std::optional<std::string> device_name,
+      std::optional<const tensorflow::dtensor::Mesh> mesh) {
+    if (!mesh.has_value() || !device_name.has_value()) {
+      return absl::InvalidArgumentError(
+          "Attempted to bind a sharded tensor without a mesh and a DTensor "
+          "device.");
+    }
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+        TF_NewStatus(), TF_DeleteStatus);
+    const ParameterLayout* parameter_layout =
+        NextParameterLayout(parameter_layouts, bindings);
+    TFE_TensorHandle* dtensor_value;
+    if (parameter_layout == nullptr ||
+        parameter_layout->layout_string == layout_string_) {
+      // Bindings are deleted after the call, so bind a handle of their own.
+      dtensor_value =
+          TFE_TensorHandleCopySharingTensor(value_.get(), status.get());
+    } else {
+      tensorflow::dtensor::Layout layout = parameter_layout->layout;
+      dtensor_value = converter_->Relayout(context, value_.get(),
+                                           tensorflow::wrap(&layout),
+                                           device_name->c_str(), status.get());
+    }
+    if (TF_GetCode(status.get()) != TF_OK) {
+      return absl::InternalError(absl::StrCat("dtensor binding failed.. ",
+                                              TF_Message(status.get())));
+    }
+    bindings.emplace_back(dtensor_value);
+    return absl::OkStatus();
+  }
+
   std::unique_ptr<TFE_TensorHandle, decltype(&TFE_DeleteTensorHandle)> value_;
   DTensorConverter* converter_ = nullptr;
+  const std::optional<tensorflow::dtensor::Layout> layout_;
+  // `layout_->ToString()`, or empty if the value has no layout.
+  const std::string layout_string_;
 };
 
 class StructValue : public Value {
  public:
   static absl::StatusOr<ExecutorValue> CreateStruct(
       const v0::Value& value_pb, std::optional<tensorflow::dtensor::Mesh> mesh,
-      DTensorConverter* converter) {
+      DTensorConverter* converter, TFE_Context* context,
+      std::optional<std::string> device_name) {
     if (!value_pb.has_struct_()) {
       return absl::InvalidArgumentError(
           "Creating StructValue from a non-struct value proto.");
@@ -250,7 +439,8 @@ class StructValue : public Value {
     std::vector<ExecutorValue> values;
     values.reserve(value_pb.struct_().element_size());
     for (const auto& element : value_pb.struct_().element()) {
-      auto value = TFF_TRY(CreateValueAny(element.value(), mesh, converter));
+      auto value = TFF_TRY(CreateValueAny(element.value(), mesh, converter,
+                                          context, device_name));
       values.push_back(value);
     }
     return std::make_shared<StructValue>(values);
@@ -288,7 +478,7 @@ class StructValue : public Value {
 
   absl::Status Bind(
       TFE_Context* context, const v0::TensorFlow::Binding& shape,
-      const std::map<std::string, tensorflow::dtensor::Layout>& layout_map,
+      const ParameterLayouts& parameter_layouts,
       std::vector<TFE_TensorHandle*>& bindings,
       std::optional<std::string> device_name,
       std::optional<const tensorflow::dtensor::Mesh> mesh) override {
@@ -303,8 +493,8 @@ class StructValue : public Value {
                        shape.struct_().element_size(), " fields."));
     }
     for (int i = 0; i < values_.size(); i++) {
-      TFF_TRY(values_[i]->Bind(context, shape.struct_().element(i), layout_map,
-                               bindings, device_name, mesh));
+      TFF_TRY(values_[i]->Bind(context, shape.struct_().element(i),
+                               parameter_layouts, bindings, device_name, mesh));
     }
     return absl::OkStatus();
   }
@@ -366,18 +556,12 @@ class ComputationValue : public Value {
                                         .tensorflow()
                                         .layout_map()
                                         .name_to_sharding_spec()) {
-          std::vector<std::string> sharding_specs =
-              absl::StrSplit(sharding.second, ',');
-          auto layout_or = tensorflow::dtensor::Layout::GetLayout(
-              sharding_specs, mesh.value());
-          if (!layout_or.ok()) {
-            return layout_or.status();
-          }
-          layout_map[sharding.first] = layout_or.value();
+          layout_map[sharding.first] =
+              TFF_TRY(LayoutFromShardingSpec(sharding.second, mesh.value()));
         }
       }
 
-      auto eager_comp = TFF_TRY(EagerComputation::FromProto(
+      auto eager_comp = TFF_TRY(EagerComputationCache::Default().GetOrCreate(
           value_pb.computation().tensorflow(), layout_map));
       return std::make_shared<ComputationValue>(
           eager_comp,
@@ -403,9 +587,12 @@ class ComputationValue : public Value {
       : computation_(computation),
         parameter_shape_(parameter_shape),
         output_shape_(output_shape),
-        layout_map_(std::move(layout_map)),
         mesh_(mesh),
-        converter_(converter) {}
+        converter_(converter) {
+    if (parameter_shape_.has_value() && !layout_map.empty()) {
+      AppendParameterLayouts(*parameter_shape_, layout_map, parameter_layouts_);
+    }
+  }
 
   absl::Status MaterializeValue(TFE_Context* context, v0::Value* value_pb,
                                 std::optional<std::string> device_name,
@@ -419,8 +606,9 @@ class ComputationValue : public Value {
       std::optional<std::string> device_name) override {
     std::vector<TFE_TensorHandle*> flattened_inputs;
     if (arg.has_value()) {
-      TFF_TRY(arg.value()->Bind(context, parameter_shape_.value(), layout_map_,
-                                flattened_inputs, device_name, mesh_));
+      TFF_TRY(arg.value()->Bind(context, parameter_shape_.value(),
+                                parameter_layouts_, flattened_inputs,
+                                device_name, mesh_));
     }
     auto outputs =
         TFF_TRY(computation_.Call(context, flattened_inputs, device_name));
@@ -445,7 +633,7 @@ class ComputationValue : public Value {
 
   absl::Status Bind(
       TFE_Context* context, const v0::TensorFlow::Binding& shape,
-      const std::map<std::string, tensorflow::dtensor::Layout>& layout_map,
+      const ParameterLayouts& parameter_layouts,
       std::vector<TFE_TensorHandle*>& bindings,
       std::optional<std::string> device_name,
       std::optional<const tensorflow::dtensor::Mesh> mesh) override {
@@ -463,21 +651,27 @@ class ComputationValue : public Value {
   EagerComputation computation_;
   std::optional<v0::TensorFlow::Binding> parameter_shape_;
   v0::TensorFlow::Binding output_shape_;
-  std::map<std::string, tensorflow::dtensor::Layout> layout_map_;
+  ParameterLayouts parameter_layouts_;
   std::optional<const tensorflow::dtensor::Mesh> mesh_;
   DTensorConverter* converter_ = nullptr;
 };
 
 absl::StatusOr<ExecutorValue> CreateValueAny(
     const v0::Value& value_pb, std::optional<tensorflow::dtensor::Mesh> mesh,
-    DTensorConverter* converter) {
+    DTensorConverter* converter, TFE_Context* context,
+    std::optional<std::string> device_name) {
   VLOG(2) << "Creating value: " << value_pb.Utf8DebugString();
   switch (value_pb.value_case()) {
     case v0::Value::kTensor: {
       return TensorValue::CreateTensor(value_pb, converter);
     }
+    case v0::Value::kShardedTensor: {
+      return TensorValue::CreateShardedTensor(value_pb, context, device_name,
+                                              mesh, converter);
+    }
     case v0::Value::kStruct: {
-      return StructValue::CreateStruct(value_pb, mesh, converter);
+      return StructValue::CreateStruct(value_pb, mesh, converter, context,
+                                       device_name);
     }
     case v0::Value::kComputation: {
       return ComputationValue::CreateComputation(value_pb, mesh, converter);
@@ -491,6 +685,35 @@ absl::StatusOr<ExecutorValue> CreateValueAny(
   }
 }
 
+// Runs the eager ops of the calling thread on `executor` while in scope, rather
+// than on the executor of the context. Does nothing if `executor` is null.
+class ScopedThreadExecutor {
+ public:
+  ScopedThreadExecutor(TFE_Context* context, TFE_Executor* executor)
+      : context_(context),
+        previous_(executor == nullptr
+                      ? nullptr
+                      : TFE_ContextGetExecutorForThread(context)) {
+    if (executor != nullptr) {
+      TFE_ContextSetExecutorForThread(context, executor);
+    }
+  }
+
+  ~ScopedThreadExecutor() {
+    if (previous_ != nullptr) {
+      TFE_ContextSetExecutorForThread(context_, previous_);
+      TFE_DeleteExecutor(previous_);
+    }
+  }
+
+  ScopedThreadExecutor(const ScopedThreadExecutor&) = delete;
+  ScopedThreadExecutor& operator=(const ScopedThreadExecutor&) = delete;
+
+ private:
+  TFE_Context* context_;
+  TFE_Executor* previous_;
+};
+
 using ValueFuture = std::shared_future<absl::StatusOr<ExecutorValue>>;
 
 class DTensorExecutor : public ExecutorBase<ValueFuture> {
@@ -499,11 +722,19 @@ class DTensorExecutor : public ExecutorBase<ValueFuture> {
                   std::optional<std::string> dtensor_device_name,
                   std::optional<tensorflow::dtensor::Mesh> mesh,
                   std::unique_ptr<DTensorConverter> converter,
-                  int32_t max_concurrent_computation_calls)
+                  int32_t max_concurrent_computation_calls,
+                  bool async_execution)
       : context_(std::move(context)),
         dtensor_device_name_(dtensor_device_name),
         mesh_(mesh),
         converter_(std::move(converter)),
+        async_executor_(
+            async_execution
+                ? TFE_NewExecutor(/*is_async=*/true,
+                                  /*enable_streaming_enqueue=*/true,
+                                  /*in_flight_nodes_limit=*/0)
+                : nullptr,
+            TFE_DeleteExecutor),
         thread_pool_(
             // Use a threadpool with CPU * 4 or the user specified
             // maximum.
@@ -524,7 +755,10 @@ class DTensorExecutor : public ExecutorBase<ValueFuture> {
     VLOG(2) << "Creating value: " << value_pb.Utf8DebugString();
     return ThreadRun(
         [value_pb, this]() -> absl::StatusOr<ExecutorValue> {
-          return CreateValueAny(value_pb, this->mesh_, this->converter_.get());
+          ScopedThreadExecutor thread_executor(context_,
+                                               async_executor_.get());
+          return CreateValueAny(value_pb, this->mesh_, this->converter_.get(),
+                                this->context_, this->dtensor_device_name_);
         },
         &thread_pool_);
   }
@@ -535,6 +769,8 @@ class DTensorExecutor : public ExecutorBase<ValueFuture> {
         [this, function = std::move(function),
          argument = std::move(argument)]() -> absl::StatusOr<ExecutorValue> {
           ExecutorValue fn = TFF_TRY(Wait(function));
+          ScopedThreadExecutor thread_executor(context_,
+                                               async_executor_.get());
           std::optional<ExecutorValue> arg = std::nullopt;
           if (argument.has_value()) {
             arg = TFF_TRY(Wait(argument.value()));
@@ -575,10 +811,15 @@ class DTensorExecutor : public ExecutorBase<ValueFuture> {
   absl::Status Materialize(ValueFuture value_fut, v0::Value* value_pb) final {
     ExecutorValue value = TFF_TRY(Wait(std::move(value_fut)));
     ParallelTasks tasks(&thread_pool_);
-    TFF_TRY(value->MaterializeValue(context_, value_pb, dtensor_device_name_,
-                                    tasks));
-    TFF_TRY(tasks.WaitAll());
-    return absl::OkStatus();
+    absl::Status status = value->MaterializeValue(
+        context_, value_pb, dtensor_device_name_, tasks);
+    status.Update(tasks.WaitAll());
+    if (!status.ok() && async_executor_ != nullptr) {
+      // The failure of an asynchronously run op fails every op enqueued after
+      // it until cleared. It was reported here, so later calls may run again.
+      TFE_ExecutorClearError(async_executor_.get());
+    }
+    return status;
   }
 
  private:
@@ -586,6 +827,9 @@ class DTensorExecutor : public ExecutorBase<ValueFuture> {
   std::optional<std::string> dtensor_device_name_;
   std::optional<tensorflow::dtensor::Mesh> mesh_;
   std::unique_ptr<DTensorConverter> converter_;
+  // The executor the ops of values and calls are enqueued on in async mode,
+  // or null. Deleting it waits for the ops still pending.
+  std::unique_ptr<TFE_Executor, decltype(&TFE_DeleteExecutor)> async_executor_;
   // ThreadPool should always be the last member so that in progress threads
   // with 'this' pointer are cleaned up before other members.
   ThreadPool thread_pool_;
@@ -597,11 +841,11 @@ std::shared_ptr<Executor> CreateDTensorExecutor(
     TFE_Context* context, std::optional<std::string> dtensor_device_name,
     std::optional<tensorflow::dtensor::Mesh> mesh,
     std::unique_ptr<DTensorConverter> dtensor_converter,
-    int32_t max_concurrent_computation_calls) {
+    int32_t max_concurrent_computation_calls, bool async_execution) {
   return std::make_shared<DTensorExecutor>(
       std::move(context), dtensor_device_name, mesh,
       dtensor_converter == nullptr ? std::make_unique<DTensorConverterImpl>()
                                    : std::move(dtensor_converter),
-      max_concurrent_computation_calls);
+      max_concurrent_computation_calls, async_execution);
 }
 }  // namespace tensorflow_federated
@@ -43,12 +43,35 @@ class DTensorConverter {
                                             TFE_TensorHandle* tensor_handle,
                                             const char* device_name,
                                             TF_Status* status) = 0;
+  // Wrapper for packing per-device shards into a DTensor. Uses
+  // TFE_DTENSOR_ShardsToDTensor unless overridden.
+  virtual TFE_TensorHandle* ShardsToDTensor(TFE_Context* context,
+                                            TFE_TensorHandle** shards,
+                                            int num_shards,
+                                            const tensorflow::TF_Layout* layout,
+                                            const char* device_name,
+                                            TF_Status* status);
+  // Wrapper for changing the layout of a DTensor. Uses TFE_DTENSOR_Relayout
+  // unless overridden.
+  virtual TFE_TensorHandle* Relayout(TFE_Context* context,
+                                     TFE_TensorHandle* dtensor_handle,
+                                     const tensorflow::TF_Layout* layout,
+                                     const char* device_name,
+                                     TF_Status* status);
 };
 
 // Returns an executor that will use provided device for tensorflow computation.
 // The device_name can be a registered DTensor device.
+// When a mesh and DTensor device are given, `sharded_tensor` values are
+// placed on the mesh shard by shard when they are created, and bound to
+// computations without being replicated first.
 // max_concurrent_computation_calls can be used to control maximum number
 // of active threads executing tensorflow functions.
+// With async_execution, the ops creating values and calling computations are
+// enqueued on an asynchronous executor of the context and run in order in the
+// background, so that successive calls and relayouts on the mesh are
+// pipelined. Calls then complete once enqueued, and errors of their execution
+// are returned by `Materialize`, which waits for the values it materializes.
 std::shared_ptr<Executor> CreateDTensorExecutor(
     TFE_Context* context, std::optional<std::string> dtensor_device_name,
     std::optional<tensorflow::dtensor::Mesh> mesh = std::nullopt,
@@ -57,7 +80,8 @@ std::shared_ptr<Executor> CreateDTensorExecutor(
                   // default when null.
                   //  Used only when mesh is
                   // specified.
-    int32_t max_concurrent_computation_calls = -1);
+    int32_t max_concurrent_computation_calls = -1,
+    bool async_execution = false);
 
 }  // namespace tensorflow_federated
 
@@ -326,6 +326,62 @@ TEST_F(DTensorExecutorTest, CallAddShardedLayout) {
                     ::testing::HasSubstr("sharding_specs:x")));
 }
 
+TEST_F(DTensorExecutorTest, CallAddWithShardedTensorInput) {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root.WithOpName("input_x"),
+                                 tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder y(root.WithOpName("input_y"),
+                                 tensorflow::DT_INT32);
+  tensorflow::ops::AddV2 out(root, x, y);
+  v0::Value fn =
+      ComputationV(StructB({TensorB(x), TensorB(y)}), TensorB(out), root);
+  (*fn.mutable_computation()
+        ->mutable_tensorflow()
+        ->mutable_layout_map()
+        ->mutable_name_to_sharding_spec())["input_x"] = MESH_DIM_X;
+
+  // The shards of x are placed on the mesh as is, rather than converted from
+  // the global tensor.
+  v0::Value sharded_x;
+  sharded_x.mutable_sharded_tensor()->set_sharding_spec(MESH_DIM_X);
+  *sharded_x.mutable_sharded_tensor()->add_shard() = TensorVFromIntList({1, 2});
+  *sharded_x.mutable_sharded_tensor()->add_shard() = TensorVFromIntList({3, 5});
+  v0::Value arg = StructV({sharded_x, TensorV(2)});
+  v0::Value expected = TensorVFromIntList({3, 4, 5, 7});
+  CheckCallEqualsProto(fn, arg, expected);
+
+  // Only the scalar input is converted.
+  ASSERT_EQ(dtensor_converter_->input_dtensors_.size(), 1);
+  ASSERT_EQ(dtensor_converter_->result_dtensors_.size(), 1);
+  EXPECT_THAT(dtensor_converter_->result_dtensors_[0],
+              ::testing::HasSubstr(
+                  absl::StrFormat("{\"%s:0\": [3 4], \"%s:1\": [5 7]}",
+                                  device_type_, device_type_)));
+}
+
+TEST_F(DTensorExecutorTest, ShardedTensorMaterializesGlobalTensor) {
+  v0::Value sharded_x;
+  sharded_x.mutable_sharded_tensor()->set_sharding_spec(MESH_DIM_X);
+  *sharded_x.mutable_sharded_tensor()->add_shard() = TensorVFromIntList({1, 2});
+  *sharded_x.mutable_sharded_tensor()->add_shard() = TensorVFromIntList({3, 4});
+  TFF_ASSERT_OK_AND_ASSIGN(OwnedValueId id,
+                           test_executor_->CreateValue(sharded_x));
+  TFF_ASSERT_OK_AND_ASSIGN(v0::Value output_pb,
+                           test_executor_->Materialize(id));
+  EXPECT_THAT(output_pb, EqualsProto(TensorVFromIntList({1, 2, 3, 4})));
+}
+
+TEST_F(DTensorExecutorTest, ShardedTensorWithWrongShardCountFails) {
+  v0::Value sharded_x;
+  sharded_x.mutable_sharded_tensor()->set_sharding_spec(MESH_DIM_X);
+  *sharded_x.mutable_sharded_tensor()->add_shard() = TensorVFromIntList({1, 2});
+  TFF_ASSERT_OK_AND_ASSIGN(OwnedValueId id,
+                           test_executor_->CreateValue(sharded_x));
+  EXPECT_THAT(test_executor_->Materialize(id),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       ::testing::HasSubstr("one shard for each")));
+}
+
 TEST_F(DTensorExecutorTest, CallAddReplicatedLayout) {
   tensorflow::Scope root = tensorflow::Scope::NewRootScope();
   tensorflow::ops::Placeholder x(root.WithOpName("input_x"),
@@ -402,6 +458,25 @@ TEST_F(DTensorExecutorTest, CallAddNoLayoutSpecified) {
                     ::testing::HasSubstr("sharding_specs:unsharded")));
 }
 
+TEST_F(DTensorExecutorTest, CallAddWithAsyncExecution) {
+  auto mesh = TFF_ASSERT_OK(tensorflow::dtensor::Mesh::ParseFromProto(mesh_));
+  test_executor_ = CreateDTensorExecutor(
+      context_, device_name_, mesh, /*dtensor_converter=*/nullptr,
+      /*max_concurrent_computation_calls=*/10, /*async_execution=*/true);
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root.WithOpName("input_x"),
+                                 tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder y(root.WithOpName("input_y"),
+                                 tensorflow::DT_INT32);
+  tensorflow::ops::AddV2 out(root, x, y);
+  v0::Value fn =
+      ComputationV(StructB({TensorB(x), TensorB(y)}), TensorB(out), root);
+
+  v0::Value arg = StructV({TensorVFromIntList({1, 2, 3, 5}), TensorV(2)});
+  v0::Value expected = TensorVFromIntList({3, 4, 5, 7});
+  CheckCallRepeatedlyEqualsProto(fn, arg, expected);
+}
+
 TEST_F(DTensorExecutorTest, CallNoArgOneOutWithInitialize) {
   tensorflow::Scope root = tensorflow::Scope::NewRootScope();
   tensorflow::TensorShape shape({4});
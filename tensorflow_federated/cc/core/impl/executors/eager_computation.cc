@@ -27,8 +27,9 @@ limitations under the License
 #include <vector>
 
 #include "google/protobuf/any.pb.h"
-#include "absl/base/attributes.h"
-#include "absl/base/const_init.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
@@ -52,6 +53,7 @@ limitations under the License
 #include "tensorflow/core/framework/resource_handle.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/dtensor/cc/tensor_layout.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
@@ -61,16 +63,6 @@ namespace tensorflow_federated {
 
 namespace {
 
-// A process level counter for suffixing name of tf_function created from
-// GraphDef. This ensures that each tf function registered is unique and does
-// not override an existing function def.
-ABSL_CONST_INIT static absl::Mutex function_counter_mutex(absl::kConstInit);
-int32_t GetNextFunctionId() {
-  absl::MutexLock function_id_lock(&function_counter_mutex);
-  static int32_t function_id = 0;
-  return function_id++;
-}
-
 absl::Status AddFunctionDef(const tensorflow::FunctionDef& function,
                             TFE_Context* context, TF_Status* status) {
   if (TFE_ContextHasFunction(context, function.signature().name().c_str())) {
@@ -85,19 +77,149 @@ absl::Status AddFunctionDef(const tensorflow::FunctionDef& function,
   return absl::OkStatus();
 }
 
-absl::Status RemoveFunctionDef(const tensorflow::FunctionDef& function,
+absl::Status RemoveFunctionDef(const std::string& function_name,
                                TFE_Context* context, TF_Status* status) {
-  if (TFE_ContextHasFunction(context, function.signature().name().c_str())) {
-    TFE_ContextRemoveFunction(context, function.signature().name().c_str(),
-                              status);
+  if (TFE_ContextHasFunction(context, function_name.c_str())) {
+    TFE_ContextRemoveFunction(context, function_name.c_str(), status);
     if (TF_GetCode(status) != TF_OK) {
       return absl::InternalError(absl::StrCat(
-          "FunctionDef could not be registered: ", TF_Message(status)));
+          "FunctionDef could not be removed: ", TF_Message(status)));
     }
   }
   return absl::OkStatus();
 }
 
+// Process level reference counts of the functions registered with each eager
+// context. Computations sharing a function register it with a context once,
+// and it is removed from the context when the last of them releases it.
+class FunctionRegistry {
+ public:
+  static FunctionRegistry& Global() {
+    static FunctionRegistry* registry = new FunctionRegistry();
+    return *registry;
+  }
+
+  // Registers `functions` with `context`, adding those which are not
+  // registered yet. Either all functions are registered or none are.
+  absl::Status Register(
+      TFE_Context* context,
+      absl::Span<const tensorflow::FunctionDef* const> functions) {
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+        TF_NewStatus(), TF_DeleteStatus);
+    absl::MutexLock lock(&mutex_);
+    for (size_t i = 0; i < functions.size(); ++i) {
+      const std::string& name = functions[i]->signature().name();
+      int64_t& refcount = refcounts_[{context, name}];
+      if (refcount == 0) {
+        absl::Status add_status =
+            AddFunctionDef(*functions[i], context, status.get());
+        if (!add_status.ok()) {
+          refcounts_.erase({context, name});
+          for (size_t j = 0; j < i; ++j) {
+            ReleaseLocked(context, functions[j]->signature().name());
+          }
+          return add_status;
+        }
+      }
+      ++refcount;
+    }
+    return absl::OkStatus();
+  }
+
+  // Releases functions previously registered with `context`, removing those
+  // which are no longer used.
+  void Release(TFE_Context* context, absl::Span<const std::string> names) {
+    absl::MutexLock lock(&mutex_);
+    for (const std::string& name : names) {
+      ReleaseLocked(context, name);
+    }
+  }
+
+ private:
+  void ReleaseLocked(TFE_Context* context, const std::string& name)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    auto it = refcounts_.find({context, name});
+    if (it == refcounts_.end() || --it->second > 0) {
+      return;
+    }
+    refcounts_.erase(it);
+    std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+        TF_NewStatus(), TF_DeleteStatus);
+    absl::Status remove_status = RemoveFunctionDef(name, context, status.get());
+    if (!remove_status.ok()) {
+      LOG(WARNING) << remove_status;
+    }
+  }
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::pair<TFE_Context*, std::string>, int64_t>
+      refcounts_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns a suffix for the names of the functions of a computation, derived
+// from a fingerprint of the computation. Computations with the same graph
+// share the names of their functions, while functions of different graphs
+// never collide even if the graphs use the same names.
+std::string FunctionNameSuffix(
+    const v0::TensorFlow& comp_pb,
+    const std::map<std::string, tensorflow::dtensor::Layout>& layout_map) {
+  std::string serialized;
+  {
+    google::protobuf::io::StringOutputStream stream(&serialized);
+    google::protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.SetSerializationDeterministic(true);
+    comp_pb.SerializeToCodedStream(&coded_stream);
+  }
+  for (const auto& [node_name, layout] : layout_map) {
+    absl::StrAppend(&serialized, node_name, "=", layout.ToString(), ";");
+  }
+  const tensorflow::Fprint128 fingerprint =
+      tensorflow::Fingerprint128(serialized);
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+void RenameFunctionsInAttr(
+    const absl::flat_hash_map<std::string, std::string>& new_names,
+    tensorflow::AttrValue& attr) {
+  auto rename = [&new_names](tensorflow::NameAttrList& func) {
+    auto it = new_names.find(func.name());
+    if (it != new_names.end()) {
+      func.set_name(it->second);
+    }
+    for (auto& attr : *func.mutable_attr()) {
+      RenameFunctionsInAttr(new_names, attr.second);
+    }
+  };
+  if (attr.has_func()) {
+    rename(*attr.mutable_func());
+  } else if (attr.has_list()) {
+    for (auto& func : *attr.mutable_list()->mutable_func()) {
+      rename(func);
+    }
+  }
+}
+
+// Renames `func_def` and the functions it calls according to `new_names`.
+void RenameFunctions(
+    const absl::flat_hash_map<std::string, std::string>& new_names,
+    tensorflow::FunctionDef& func_def) {
+  auto it = new_names.find(func_def.signature().name());
+  if (it != new_names.end()) {
+    func_def.mutable_signature()->set_name(it->second);
+  }
+  for (auto& node : *func_def.mutable_node_def()) {
+    // Functions may be called as ops of their own name.
+    auto op_it = new_names.find(node.op());
+    if (op_it != new_names.end()) {
+      node.set_op(op_it->second);
+    }
+    for (auto& attr : *node.mutable_attr()) {
+      RenameFunctionsInAttr(new_names, attr.second);
+    }
+  }
+}
+
 // Add a return node to graph for returning outputs. These would be converted to
 // ret and output_args fields when converting to FunctionDef.
 absl::Status AddReturnNodeToFunction(tensorflow::Graph* graph,
@@ -294,7 +416,8 @@ absl::StatusOr<tensorflow::FunctionDef> ConvertToFunctionDef(
     std::string init_op, const tensorflow::GraphDef& graphdef_pb,
     const v0::TensorFlow::Binding& input_binding,
     const v0::TensorFlow::Binding& output_binding,
-    std::map<std::string, tensorflow::dtensor::Layout> layout_map) {
+    std::map<std::string, tensorflow::dtensor::Layout> layout_map,
+    const std::string& function_name) {
   tensorflow::FunctionDef func_def;
   std::vector<bool> visited(graphdef_pb.node_size());
   std::deque<const tensorflow::Node*> queue;
@@ -373,8 +496,6 @@ absl::StatusOr<tensorflow::FunctionDef> ConvertToFunctionDef(
   // and output args.
   std::vector<std::string> output_names(output_bindings.begin(),
                                         output_bindings.end());
-  const std::string function_name =
-      absl::StrCat("tf_computation_function", GetNextFunctionId());
   status = tensorflow::GraphToFunctionDef(*graph.get(), function_name,
                                           output_names, &func_def);
   if (!status.ok()) {
@@ -465,27 +586,74 @@ absl::StatusOr<EagerComputation> EagerComputation::FromProto(
     return absl::InternalError("Could not unpack graphdef proto");
   }
 
-  tensorflow::FunctionDef main_func_def = TFF_TRY(
-      ConvertToFunctionDef(comp_pb.initialize_op(), graphdef_pb,
-                           comp_pb.parameter(), comp_pb.result(), layout_map));
+  const std::string name_suffix = FunctionNameSuffix(comp_pb, layout_map);
+  tensorflow::FunctionDef main_func_def = TFF_TRY(ConvertToFunctionDef(
+      comp_pb.initialize_op(), graphdef_pb, comp_pb.parameter(),
+      comp_pb.result(), layout_map,
+      absl::StrCat("tf_computation_function_", name_suffix)));
 
+  // Functions of the library are registered under names unique to this graph,
+  // since graphs may define different functions with the same name.
+  absl::flat_hash_map<std::string, std::string> new_names;
+  for (const auto& func_def : graphdef_pb.library().function()) {
+    new_names[func_def.signature().name()] =
+        absl::StrCat(func_def.signature().name(), "_", name_suffix);
+  }
   UpdateVarHandleOpNodesAsAnonymous(main_func_def);
+  RenameFunctions(new_names, main_func_def);
   // Register Function defs present in library, since these may be invoked from
   // nodes in graph def via StatefulPartitionedCall.
   std::vector<tensorflow::FunctionDef> function_defs_to_register;
   for (auto& func_def : *graphdef_pb.mutable_library()->mutable_function()) {
     UpdateVarHandleOpNodesAsAnonymous(func_def);
-    function_defs_to_register.push_back(func_def);
+    RenameFunctions(new_names, func_def);
+    function_defs_to_register.push_back(std::move(func_def));
   }
 
-  return EagerComputation(main_func_def, function_defs_to_register);
+  return EagerComputation(std::move(main_func_def),
+                          std::move(function_defs_to_register));
 }
 
+// The contexts the functions of a computation are registered with. Shared by
+// the copies of the computation, and releases the functions when the last of
+// them is destroyed.
+struct EagerComputation::Registrations {
+  ~Registrations() {
+    absl::MutexLock lock(&mutex);
+    for (TFE_Context* context : contexts) {
+      FunctionRegistry::Global().Release(context, function_names);
+    }
+  }
+
+  std::vector<std::string> function_names;
+  absl::Mutex mutex;
+  absl::flat_hash_set<TFE_Context*> contexts ABSL_GUARDED_BY(mutex);
+};
+
 EagerComputation::EagerComputation(
     tensorflow::FunctionDef main_function_def,
     std::vector<tensorflow::FunctionDef> function_defs_to_register)
-    : main_function_def_(main_function_def),
-      function_defs_to_register_(function_defs_to_register) {}
+    : main_function_def_(std::move(main_function_def)),
+      function_defs_to_register_(std::move(function_defs_to_register)),
+      registrations_(std::make_shared<Registrations>()) {
+  registrations_->function_names.push_back(
+      main_function_def_.signature().name());
+  for (const auto& func_def : function_defs_to_register_) {
+    registrations_->function_names.push_back(func_def.signature().name());
+  }
+}
+
+EagerComputation EagerComputation::Clone() const {
+  return EagerComputation(main_function_def_, function_defs_to_register_);
+}
+
+int64_t EagerComputation::size_bytes() const {
+  int64_t size_bytes = main_function_def_.ByteSizeLong();
+  for (const auto& func_def : function_defs_to_register_) {
+    size_bytes += func_def.ByteSizeLong();
+  }
+  return size_bytes;
+}
 
 absl::Status EagerComputation::ExecuteFunction(
     TFE_Context* context, std::string func_name,
@@ -531,36 +699,29 @@ absl::Status EagerComputation::ExecuteFunction(
 }
 
 absl::Status EagerComputation::RegisterFunctions(TFE_Context* context) {
-  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status_ptr(
-      TF_NewStatus(), TF_DeleteStatus);
-
-  TFF_TRY(AddFunctionDef(main_function_def_, context, status_ptr.get()));
-  for (const auto& func_def : function_defs_to_register_) {
-    TFF_TRY(AddFunctionDef(func_def, context, status_ptr.get()));
+  {
+    absl::ReaderMutexLock lock(&registrations_->mutex);
+    if (registrations_->contexts.contains(context)) {
+      return absl::OkStatus();
+    }
   }
-  return absl::OkStatus();
-}
-
-absl::Status EagerComputation::RemoveFunctions(TFE_Context* context) {
-  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status_ptr(
-      TF_NewStatus(), TF_DeleteStatus);
-
-  TFE_ContextRemoveFunction(
-      context, main_function_def_.signature().name().c_str(), status_ptr.get());
-
-  TFF_TRY(RemoveFunctionDef(main_function_def_, context, status_ptr.get()));
+  absl::MutexLock lock(&registrations_->mutex);
+  if (registrations_->contexts.contains(context)) {
+    return absl::OkStatus();
+  }
+  std::vector<const tensorflow::FunctionDef*> functions;
+  functions.push_back(&main_function_def_);
   for (const auto& func_def : function_defs_to_register_) {
-    TFF_TRY(RemoveFunctionDef(func_def, context, status_ptr.get()));
+    functions.push_back(&func_def);
   }
+  TFF_TRY(FunctionRegistry::Global().Register(context, functions));
+  registrations_->contexts.insert(context);
   return absl::OkStatus();
 }
 
 absl::StatusOr<std::vector<TFE_TensorHandle*>> EagerComputation::Call(
     TFE_Context* context, std::optional<std::vector<TFE_TensorHandle*>> args,
     std::optional<std::string> device_name) {
-  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status_ptr(
-      TF_NewStatus(), TF_DeleteStatus);
-
   TFF_TRY(RegisterFunctions(context));
 
   std::vector<TFE_TensorHandle*> outputs;
@@ -577,4 +738,54 @@ absl::StatusOr<std::vector<TFE_TensorHandle*>> EagerComputation::Call(
   return outputs;
 }
 
+EagerComputationCache& EagerComputationCache::Default() {
+  static EagerComputationCache* cache =
+      new EagerComputationCache(kDefaultEagerComputationCacheCapacityBytes);
+  return *cache;
+}
+
+absl::StatusOr<EagerComputation> EagerComputationCache::GetOrCreate(
+    const v0::TensorFlow& comp_pb,
+    const std::map<std::string, tensorflow::dtensor::Layout>& layout_map) {
+  std::string key = FunctionNameSuffix(comp_pb, layout_map);
+  {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      VLOG(2) << "Cache hit for eager computation: " << key;
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->computation->Clone();
+    }
+  }
+  VLOG(2) << "Cache MISS for eager computation: " << key;
+  // Concurrent misses of the same computation may each convert it. Only one of
+  // the conversions is cached, but the others are equivalent.
+  auto computation = std::make_shared<const EagerComputation>(
+      TFF_TRY(EagerComputation::FromProto(comp_pb, layout_map)));
+  const int64_t size_bytes = computation->size_bytes();
+  if (size_bytes > capacity_bytes_) {
+    return computation->Clone();
+  }
+  absl::MutexLock lock(&mutex_);
+  if (index_.contains(key)) {
+    return computation->Clone();
+  }
+  while (size_bytes_ + size_bytes > capacity_bytes_) {
+    const Entry& evicted = entries_.back();
+    VLOG(2) << "Evicting cached eager computation: " << evicted.key;
+    size_bytes_ -= evicted.size_bytes;
+    index_.erase(evicted.key);
+    entries_.pop_back();
+  }
+  entries_.push_front(Entry{key, computation, size_bytes});
+  index_.emplace(std::move(key), entries_.begin());
+  size_bytes_ += size_bytes;
+  return computation->Clone();
+}
+
+int64_t EagerComputationCache::size_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return size_bytes_;
+}
+
 }  // namespace tensorflow_federated
@@ -16,13 +16,19 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EAGER_COMPUTATION_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EAGER_COMPUTATION_H_
 
+#include <cstdint>
+#include <list>
 #include <map>
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "tensorflow/c/eager/c_api.h"
 #include "tensorflow/c/eager/tfe_tensorhandle_internal.h"
@@ -62,6 +68,10 @@ class EagerComputation {
       std::vector<tensorflow::FunctionDef> function_defs_to_register);
 
   // This method registers and executes TF `FunctionDef` owned by this object.
+  // Functions are registered with a context on the first call only, and are
+  // shared with other computations of the same graph. They are removed from
+  // the context once the last computation using them is destroyed, so
+  // contexts must outlive the computations called with them.
   //
   // Returns:
   //  - A vector of flattened output tensor handles on successful
@@ -75,22 +85,30 @@ class EagerComputation {
   // Invoking `Call` multiple times will execute the same FunctionDef
   // independently.
   //
+  // If the calling thread runs ops on an asynchronous executor of the context,
+  // the function is only enqueued: the returned handles become ready once it
+  // has run, and errors of its execution are returned when they are resolved.
+  //
   // Expected input to Call method is flattened list of input arguments, in the
   // iteration order of Parameter binding in `Computation` proto.
-  // TODO: b/260640553 - Allow register and call functions with same name but
-  // different graphs in a thread safe manner.
   absl::StatusOr<std::vector<TFE_TensorHandle*>> Call(
       TFE_Context* context, std::optional<std::vector<TFE_TensorHandle*>> args,
       std::optional<std::string> device_name = std::nullopt);
 
+  // Returns a computation of the same functions as this one, which registers
+  // them with contexts independently of it.
+  EagerComputation Clone() const;
+
+  // The serialized size of the functions of this computation.
+  int64_t size_bytes() const;
+
  private:
+  struct Registrations;
+
   // Registers the FunctionDefs owned by the class object with TF eager context
-  // provided in the input.
+  // provided in the input, unless they already are.
   absl::Status RegisterFunctions(TFE_Context* context);
 
-  // Removes FunctionDef from context.
-  absl::Status RemoveFunctions(TFE_Context* context);
-
   absl::Status ExecuteFunction(TFE_Context* context, std::string func_name,
                                std::optional<std::string> device_name,
                                absl::Span<TFE_TensorHandle*> args,
@@ -98,6 +116,63 @@ class EagerComputation {
 
   tensorflow::FunctionDef main_function_def_;
   std::vector<tensorflow::FunctionDef> function_defs_to_register_;
+  std::shared_ptr<Registrations> registrations_;
+};
+
+inline constexpr int64_t kDefaultEagerComputationCacheCapacityBytes =
+    int64_t{256} << 20;
+
+// A bounded cache of the computations converted by
+// `EagerComputation::FromProto`, so that identical computations, e.g. those
+// created by every executor of a process in every round, are only converted
+// and rewritten for their layouts once.
+//
+// Computations are cached by a fingerprint of their proto and of their layout
+// map. Layouts include the mesh they lay tensors out on, so computations for
+// different meshes are cached separately. The least recently used
+// computations are evicted once the total size of the cached computations
+// exceeds `capacity_bytes`.
+//
+// This class is thread safe.
+class EagerComputationCache {
+ public:
+  explicit EagerComputationCache(int64_t capacity_bytes)
+      : capacity_bytes_(capacity_bytes) {}
+
+  // The cache shared by the executors of the process.
+  static EagerComputationCache& Default();
+
+  EagerComputationCache(const EagerComputationCache&) = delete;
+  EagerComputationCache& operator=(const EagerComputationCache&) = delete;
+
+  // Returns a computation of `comp_pb` with `layout_map`, as returned by
+  // `EagerComputation::FromProto`, converting it only if it is not cached.
+  //
+  // The cache never calls its computations, and returns clones of them, so
+  // that cached computations hold no registrations with contexts which may
+  // be destroyed before them.
+  absl::StatusOr<EagerComputation> GetOrCreate(
+      const v0::TensorFlow& comp_pb,
+      const std::map<std::string, tensorflow::dtensor::Layout>& layout_map)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  int64_t size_bytes() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const EagerComputation> computation;
+    int64_t size_bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  const int64_t capacity_bytes_;
+  mutable absl::Mutex mutex_;
+  // Ordered from the most to the least recently used entry.
+  EntryList entries_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, EntryList::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t size_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
 };
 }  // namespace tensorflow_federated
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EAGER_COMPUTATION_H_
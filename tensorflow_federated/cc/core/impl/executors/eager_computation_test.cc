@@ -15,6 +15,7 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/eager_computation.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <map>
@@ -27,6 +28,7 @@ limitations under the License
 #include "googletest/include/gtest/gtest.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "tensorflow/c/eager/c_api.h"
@@ -501,6 +503,186 @@ TEST_F(EagerComputationTest, CallAddGraphDefWithFunctionDef) {
   TF_DeleteStatus(status);
 }
 
+// Returns a computation calling `function_def` from its library on two float
+// placeholders.
+v0::Computation FunctionCallComputation(
+    const tensorflow::FunctionDef& function_def) {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root, tensorflow::DT_FLOAT);
+  tensorflow::ops::Placeholder y(root, tensorflow::DT_FLOAT);
+  tensorflow::OutputList placeholders;
+  placeholders.push_back(x);
+  placeholders.push_back(y);
+  tensorflow::NameAttrList f_attr;
+  f_attr.set_name(function_def.signature().name());
+  tensorflow::ops::StatefulPartitionedCall call_op(
+      root, placeholders, {tensorflow::DT_FLOAT}, f_attr);
+  tensorflow::ops::Identity identity(root, call_op.operation.output(0));
+  return ComputationV(root, StructB({TensorB(x), TensorB(y)}),
+                      TensorB(identity), std::nullopt, {function_def});
+}
+
+// Calls `comp` with float arguments `x` and `y`, returning its single output.
+absl::StatusOr<float> CallWithFloats(EagerComputation& comp,
+                                     TFE_Context* context, float x, float y) {
+  std::unique_ptr<TF_Status, decltype(&TF_DeleteStatus)> status(
+      TF_NewStatus(), TF_DeleteStatus);
+  TF_Tensor* t_x = FloatTensor(x);
+  TF_Tensor* t_y = FloatTensor(y);
+  TFE_TensorHandle* th_x = TFE_NewTensorHandle(t_x, status.get());
+  CHECK_EQ(TF_GetCode(status.get()), TF_OK) << TF_Message(status.get());
+  TFE_TensorHandle* th_y = TFE_NewTensorHandle(t_y, status.get());
+  CHECK_EQ(TF_GetCode(status.get()), TF_OK) << TF_Message(status.get());
+  absl::StatusOr<std::vector<TFE_TensorHandle*>> result =
+      comp.Call(context, std::vector<TFE_TensorHandle*>({th_x, th_y}));
+  TF_DeleteTensor(t_x);
+  TFE_DeleteTensorHandle(th_x);
+  TF_DeleteTensor(t_y);
+  TFE_DeleteTensorHandle(th_y);
+  if (!result.ok()) {
+    return result.status();
+  }
+  CHECK_EQ(result->size(), 1);
+  TF_Tensor* result_tensor =
+      TFE_TensorHandleResolve((*result)[0], status.get());
+  CHECK_EQ(TF_GetCode(status.get()), TF_OK) << TF_Message(status.get());
+  float value = *reinterpret_cast<float*>(TF_TensorData(result_tensor));
+  TF_DeleteTensor(result_tensor);
+  TFE_DeleteTensorHandle((*result)[0]);
+  return value;
+}
+
+TEST_F(EagerComputationTest, CallRepeatedlyWithSameContext) {
+  TF_Status* status = TF_NewStatus();
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
+      TFE_NewContextOptions(), TFE_DeleteContextOptions);
+  std::unique_ptr<TFE_Context, decltype(&TFE_DeleteContext)> context(
+      TFE_NewContext(opts.get(), status), TFE_DeleteContext);
+  EXPECT_EQ(TF_GetCode(status), TF_OK) << TF_Message(status);
+
+  auto fn = FunctionCallComputation(AddFunctionDef());
+  TFF_ASSERT_OK_AND_ASSIGN(auto comp,
+                           EagerComputation::FromProto(fn.tensorflow()));
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_THAT(CallWithFloats(comp, context.get(), 5.0, i),
+                IsOkAndHolds(5.0 + i));
+  }
+
+  TF_DeleteStatus(status);
+}
+
+TEST_F(EagerComputationTest, CallAfterComputationOfSameGraphIsDestroyed) {
+  TF_Status* status = TF_NewStatus();
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
+      TFE_NewContextOptions(), TFE_DeleteContextOptions);
+  std::unique_ptr<TFE_Context, decltype(&TFE_DeleteContext)> context(
+      TFE_NewContext(opts.get(), status), TFE_DeleteContext);
+  EXPECT_EQ(TF_GetCode(status), TF_OK) << TF_Message(status);
+
+  auto fn = FunctionCallComputation(AddFunctionDef());
+  TFF_ASSERT_OK_AND_ASSIGN(auto comp,
+                           EagerComputation::FromProto(fn.tensorflow()));
+  {
+    // Both computations share the registration of the functions of the graph,
+    // which must outlive the first of them.
+    TFF_ASSERT_OK_AND_ASSIGN(auto other_comp,
+                             EagerComputation::FromProto(fn.tensorflow()));
+    EXPECT_THAT(CallWithFloats(other_comp, context.get(), 5.0, 2.0),
+                IsOkAndHolds(7.0));
+    EXPECT_THAT(CallWithFloats(comp, context.get(), 5.0, 2.0),
+                IsOkAndHolds(7.0));
+  }
+  EXPECT_THAT(CallWithFloats(comp, context.get(), 5.0, 3.0),
+              IsOkAndHolds(8.0));
+
+  TF_DeleteStatus(status);
+}
+
+TEST_F(EagerComputationTest, CallGraphsWithDifferentFunctionsOfSameName) {
+  TF_Status* status = TF_NewStatus();
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
+      TFE_NewContextOptions(), TFE_DeleteContextOptions);
+  std::unique_ptr<TFE_Context, decltype(&TFE_DeleteContext)> context(
+      TFE_NewContext(opts.get(), status), TFE_DeleteContext);
+  EXPECT_EQ(TF_GetCode(status), TF_OK) << TF_Message(status);
+
+  tensorflow::FunctionDef mul_function_def = AddFunctionDef();
+  mul_function_def.mutable_node_def(0)->set_op("Mul");
+  auto add_fn = FunctionCallComputation(AddFunctionDef());
+  auto mul_fn = FunctionCallComputation(mul_function_def);
+  TFF_ASSERT_OK_AND_ASSIGN(auto add_comp,
+                           EagerComputation::FromProto(add_fn.tensorflow()));
+  TFF_ASSERT_OK_AND_ASSIGN(auto mul_comp,
+                           EagerComputation::FromProto(mul_fn.tensorflow()));
+  EXPECT_THAT(CallWithFloats(add_comp, context.get(), 5.0, 2.0),
+              IsOkAndHolds(7.0));
+  EXPECT_THAT(CallWithFloats(mul_comp, context.get(), 5.0, 2.0),
+              IsOkAndHolds(10.0));
+
+  TF_DeleteStatus(status);
+}
+
+TEST_F(EagerComputationTest, CacheConvertsIdenticalComputationsOnce) {
+  TF_Status* status = TF_NewStatus();
+  std::unique_ptr<TFE_ContextOptions, decltype(&TFE_DeleteContextOptions)> opts(
+      TFE_NewContextOptions(), TFE_DeleteContextOptions);
+  std::unique_ptr<TFE_Context, decltype(&TFE_DeleteContext)> context(
+      TFE_NewContext(opts.get(), status), TFE_DeleteContext);
+  EXPECT_EQ(TF_GetCode(status), TF_OK) << TF_Message(status);
+
+  EagerComputationCache cache(int64_t{1} << 20);
+  auto fn = FunctionCallComputation(AddFunctionDef());
+  TFF_ASSERT_OK_AND_ASSIGN(auto comp, cache.GetOrCreate(fn.tensorflow(), {}));
+  const int64_t size_bytes = cache.size_bytes();
+  EXPECT_EQ(size_bytes, comp.size_bytes());
+  TFF_ASSERT_OK_AND_ASSIGN(auto other_comp,
+                           cache.GetOrCreate(fn.tensorflow(), {}));
+  EXPECT_EQ(cache.size_bytes(), size_bytes);
+  EXPECT_THAT(CallWithFloats(comp, context.get(), 5.0, 2.0),
+              IsOkAndHolds(7.0));
+  EXPECT_THAT(CallWithFloats(other_comp, context.get(), 5.0, 3.0),
+              IsOkAndHolds(8.0));
+
+  TF_DeleteStatus(status);
+}
+
+TEST_F(EagerComputationTest, CacheEvictsLeastRecentlyUsedComputation) {
+  tensorflow::FunctionDef mul_function_def = AddFunctionDef();
+  mul_function_def.mutable_node_def(0)->set_op("Mul");
+  auto add_fn = FunctionCallComputation(AddFunctionDef());
+  auto mul_fn = FunctionCallComputation(mul_function_def);
+  TFF_ASSERT_OK_AND_ASSIGN(auto add_comp,
+                           EagerComputation::FromProto(add_fn.tensorflow()));
+  TFF_ASSERT_OK_AND_ASSIGN(auto mul_comp,
+                           EagerComputation::FromProto(mul_fn.tensorflow()));
+
+  // The cache only has room for one of the computations.
+  EagerComputationCache cache(
+      std::max(add_comp.size_bytes(), mul_comp.size_bytes()));
+  TFF_ASSERT_OK(cache.GetOrCreate(add_fn.tensorflow(), {}));
+  EXPECT_EQ(cache.size_bytes(), add_comp.size_bytes());
+  TFF_ASSERT_OK(cache.GetOrCreate(mul_fn.tensorflow(), {}));
+  EXPECT_EQ(cache.size_bytes(), mul_comp.size_bytes());
+}
+
+TEST_F(EagerComputationTest, CacheDoesNotCacheComputationLargerThanCapacity) {
+  EagerComputationCache cache(/*capacity_bytes=*/1);
+  auto fn = FunctionCallComputation(AddFunctionDef());
+  TFF_ASSERT_OK(cache.GetOrCreate(fn.tensorflow(), {}));
+  EXPECT_EQ(cache.size_bytes(), 0);
+}
+
+TEST_F(EagerComputationTest, CacheDoesNotCacheInvalidComputation) {
+  v0::Computation comp_pb;
+  tensorflow::TensorProto tensor_pb;
+  comp_pb.mutable_tensorflow()->mutable_graph_def()->PackFrom(tensor_pb);
+
+  EagerComputationCache cache(int64_t{1} << 20);
+  EXPECT_THAT(cache.GetOrCreate(comp_pb.tensorflow(), {}),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(cache.size_bytes(), 0);
+}
+
 TEST_F(EagerComputationTest, InvalidComputationProto) {
   v0::Computation comp_pb;
   v0::TensorFlow* tensorflow_pb = comp_pb.mutable_tensorflow();
@@ -15,4 +15,106 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 
-namespace tensorflow_federated {}  // namespace tensorflow_federated
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+absl::StatusOr<OwnedValueId> Executor::TransferTo(Executor& target,
+                                                  const ValueId value) {
+  v0::Value value_pb;
+  TFF_TRY(Materialize(value, &value_pb));
+  return target.CreateValue(value_pb);
+}
+
+absl::StatusOr<std::vector<OwnedValueId>> Executor::CreateValueBatch(
+    absl::Span<const v0::Value* const> values_pb) {
+  std::vector<OwnedValueId> values;
+  values.reserve(values_pb.size());
+  for (const v0::Value* value_pb : values_pb) {
+    values.push_back(TFF_TRY(CreateValue(*value_pb)));
+  }
+  return values;
+}
+
+absl::StatusOr<std::vector<OwnedValueId>> Executor::CreateCallBatch(
+    const ValueId function, absl::Span<const ValueId> arguments) {
+  std::vector<OwnedValueId> values;
+  values.reserve(arguments.size());
+  for (const ValueId argument : arguments) {
+    values.push_back(TFF_TRY(CreateCall(function, argument)));
+  }
+  return values;
+}
+
+absl::StatusOr<std::vector<OwnedValueId>> Executor::CreateStructBatch(
+    absl::Span<const std::vector<ValueId>> members) {
+  std::vector<OwnedValueId> values;
+  values.reserve(members.size());
+  for (const std::vector<ValueId>& struct_members : members) {
+    values.push_back(TFF_TRY(CreateStruct(struct_members)));
+  }
+  return values;
+}
+
+absl::Status Executor::DisposeBatch(absl::Span<const ValueId> values) {
+  absl::Status status;
+  for (const ValueId value : values) {
+    status.Update(Dispose(value));
+  }
+  return status;
+}
+
+void OwnedValueId::ReleaseBatch(absl::Span<OwnedValueId> values) {
+  // Values are almost always owned by a single executor, so they are grouped
+  // by runs of the same executor rather than in a map.
+  std::vector<ValueId> batch;
+  std::shared_ptr<Executor> batch_executor;
+  auto dispose_batch = [&batch, &batch_executor]() {
+    if (batch_executor != nullptr && !batch.empty()) {
+      batch_executor->DisposeBatch(batch).IgnoreError();
+    }
+    batch.clear();
+  };
+  for (OwnedValueId& value : values) {
+    if (value.id_ == INVALID_ID) {
+      continue;
+    }
+    std::shared_ptr<Executor> executor = value.exec_.lock();
+    if (executor != batch_executor) {
+      dispose_batch();
+      batch_executor = std::move(executor);
+    }
+    batch.push_back(value.id_);
+    value.id_ = INVALID_ID;
+  }
+  dispose_batch();
+}
+
+std::shared_ptr<std::vector<std::shared_ptr<OwnedValueId>>>
+NewBatchReleasedValueIds(std::vector<std::shared_ptr<OwnedValueId>> values) {
+  return std::shared_ptr<std::vector<std::shared_ptr<OwnedValueId>>>(
+      new std::vector<std::shared_ptr<OwnedValueId>>(std::move(values)),
+      [](std::vector<std::shared_ptr<OwnedValueId>>* values) {
+        // Only this vector can reach the values it is the last owner of, so
+        // they can't be shared again while they are released.
+        std::vector<OwnedValueId> owned;
+        owned.reserve(values->size());
+        for (std::shared_ptr<OwnedValueId>& value : *values) {
+          if (value != nullptr && value.use_count() == 1) {
+            owned.push_back(std::move(*value));
+          }
+        }
+        OwnedValueId::ReleaseBatch(absl::MakeSpan(owned));
+        delete values;
+      });
+}
+
+}  // namespace tensorflow_federated
@@ -16,6 +16,9 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EXECUTOR_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EXECUTOR_H_
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 #include <memory>
@@ -23,9 +26,11 @@ limitations under the License
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <typeinfo>
 #include <utility>
 #include <vector>
 
+#include "absl/base/optimization.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
@@ -37,7 +42,11 @@ limitations under the License
 #include "absl/types/span.h"
 #include "absl/utility/utility.h"
 #include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/tracked_bytes.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_releaser.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_spiller.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
 
@@ -159,12 +168,49 @@ class Executor {
     return value_pb;
   }
 
+  // Embeds each of `values_pb`, returning their values in the same order.
+  //
+  // The batch variants of `CreateValue`, `CreateCall` and `CreateStruct` let
+  // composing executors create the values of all clients at once. By default
+  // they create each value on its own; executors override them to amortize
+  // the per-value cost, e.g. into a single request to a remote service. If
+  // any value of a batch can't be created, the whole batch fails.
+  virtual absl::StatusOr<std::vector<OwnedValueId>> CreateValueBatch(
+      absl::Span<const v0::Value* const> values_pb);
+
+  // Calls `function` once with each of `arguments`, returning the results in
+  // the same order.
+  virtual absl::StatusOr<std::vector<OwnedValueId>> CreateCallBatch(
+      const ValueId function, absl::Span<const ValueId> arguments);
+
+  // Creates a structure of each of `members`, returning the structures in the
+  // same order.
+  virtual absl::StatusOr<std::vector<OwnedValueId>> CreateStructBatch(
+      absl::Span<const std::vector<ValueId>> members);
+
+  // Returns `value` as a value of `target`, e.g. to hand a value over from one
+  // child of a composing executor to another.
+  //
+  // By default the value is materialized and created in `target`. Executors
+  // which hold their values in process override this to share them with
+  // executors of the same kind, without a round-trip through `v0::Value`.
+  //
+  // This method may block, as `Materialize` does.
+  virtual absl::StatusOr<OwnedValueId> TransferTo(Executor& target,
+                                                  const ValueId value);
+
   // Dispose of a value, releasing any associated resources.
   //
   // Users of this class should not typically access this function directly.
   // The `OwnedValueId`s returned will `Dispose` of themselves on destruction.
   virtual absl::Status Dispose(const ValueId value) = 0;
 
+  // Disposes of each of `values`, e.g. all the client values of a
+  // clients-placed value at once. By default each value is disposed of on its
+  // own. Values which can't be disposed of don't prevent the others from
+  // being disposed of; the first such error is returned.
+  virtual absl::Status DisposeBatch(absl::Span<const ValueId> values);
+
   virtual ~Executor() {}
 };
 
@@ -209,6 +255,10 @@ class OwnedValueId {
   }
   ~OwnedValueId() { release(); }
 
+  // Releases each of `values` as `release` does, disposing of the values of
+  // each executor with a single `DisposeBatch` call.
+  static void ReleaseBatch(absl::Span<OwnedValueId> values);
+
  private:
   std::weak_ptr<Executor> exec_;
   ValueId id_;
@@ -216,6 +266,39 @@ class OwnedValueId {
   static constexpr ValueId INVALID_ID = std::numeric_limits<ValueId>::max();
 };
 
+// Returns a shared vector of `values` which, once destroyed, releases the
+// values it was the last owner of with `OwnedValueId::ReleaseBatch`. Used for
+// the clients-placed values of federated executors, so that dropping a value
+// of many clients disposes of them at once.
+std::shared_ptr<std::vector<std::shared_ptr<OwnedValueId>>>
+NewBatchReleasedValueIds(
+    std::vector<std::shared_ptr<OwnedValueId>> values = {});
+
+// The scope of a traced executor method, as returned by `ExecutorBase::Trace`.
+// Records the method to the TensorFlow profiler and its latency to the
+// default `MetricsRegistry` until it is destroyed.
+class ExecutorTrace {
+ public:
+  // Creates a trace that records nothing.
+  ExecutorTrace() : timer_(nullptr) {}
+  ExecutorTrace(std::string_view path, bool profile,
+                LatencyHistogram* histogram)
+      : timer_(histogram) {
+    if (profile) {
+      // Safe to pass in a view here: `TraceMe` internally copies to an owned
+      // `std::string`.
+      traceme_.emplace(path);
+    }
+  }
+
+  ExecutorTrace(const ExecutorTrace&) = delete;
+  ExecutorTrace& operator=(const ExecutorTrace&) = delete;
+
+ private:
+  std::optional<tensorflow::profiler::TraceMe> traceme_;
+  ScopedLatencyTimer timer_;
+};
+
 // A base class to allow for easy implementation of `Executor`.
 // `Executor` implementations should typically inherit from
 // `ExecutorBase<executor-specific-value-implementation>`.
@@ -227,6 +310,21 @@ class OwnedValueId {
 // Note: `ExecutorValue`s must be copy-constructible. Typically, this template
 // parameter will be a `std::shared_ptr` or similar wrapper around a concrete
 // value class.
+//
+// While metrics are enabled, the values tracked by the executor are accounted
+// under its `ExecutorName()` (see `TrackedBytes`). A value is sized as the
+// `v0::Value` it was created from, a struct as the sum of its members and a
+// transferred value as its source; the results of calls and selections are
+// counted but not sized, as they may not have been computed yet.
+//
+// Executors which can serialize their values may call `EnableValueSpilling`
+// to keep the values they track within a memory budget: the least recently
+// used values over the budget are spilled to local disk, and read back by the
+// next operation which uses them.
+//
+// `DisposeBatch` untracks all of its values with one lock acquisition per
+// shard of the tracked values, and leaves destroying them to a
+// `ValueReleaser`, off the thread which disposed of them.
 template <class ExecutorValue>
 class ExecutorBase : public Executor,
                      public std::enable_shared_from_this<Executor> {
@@ -238,53 +336,289 @@ class ExecutorBase : public Executor,
                 "ExecutorBase<std::shared_ptr<MyExecutorValue>>`");
 
  private:
-  absl::Mutex mutex_;
-  ValueId next_value_id_ ABSL_GUARDED_BY(mutex_) = 0;
-  absl::flat_hash_map<ValueId, ExecutorValue> tracked_values_
-      ABSL_GUARDED_BY(mutex_);
-
-  // Tracks the provided value and returns the ID which refers to it.
-  absl::StatusOr<OwnedValueId> TrackValue(ExecutorValue value) {
-    absl::WriterMutexLock lock(&mutex_);
-    ValueId id = next_value_id_++;
-    tracked_values_.emplace(id, std::move(value));
+  // The number of independently locked shards of the tracked values.
+  // Consecutive IDs fall into different shards, so that concurrent operations
+  // on different values rarely contend for the same lock.
+  static constexpr size_t kNumValueShards = 16;
+  // The number of values whose size wasn't known which are sized again by
+  // each `MaybeSpill`.
+  static constexpr size_t kMaxSizedPerSpill = 16;
+
+  struct TrackedValue {
+    // Empty while the value is spilled.
+    std::optional<ExecutorValue> value;
+    // The bytes returned by `TrackedBytes::Tracked`.
+    int64_t bytes;
+  };
+
+  struct alignas(ABSL_CACHELINE_SIZE) ValueShard {
+    absl::Mutex mutex;
+    absl::flat_hash_map<ValueId, TrackedValue> values ABSL_GUARDED_BY(mutex);
+  };
+
+  // IDs are never reused, so a stale ID can't refer to a newer value.
+  std::atomic<ValueId> next_value_id_ = 0;
+  std::array<ValueShard, kNumValueShards> value_shards_;
+  TrackedBytes tracked_bytes_;
+  // Null unless spilling is enabled.
+  std::unique_ptr<ValueSpiller> spiller_;
+  ValueReleaser releaser_;
+
+  ValueShard& ShardOf(ValueId value_id) {
+    return value_shards_[value_id % kNumValueShards];
+  }
+
+  // Returns the approximate size of `value_pb` for `TrackValue`, without
+  // computing it while metrics are disabled.
+  static int64_t ApproximateBytes(const v0::Value& value_pb) {
+    return MetricsEnabled() ? static_cast<int64_t>(value_pb.ByteSizeLong())
+                            : 0;
+  }
+
+  // Tracks the provided value of approximately `bytes` bytes and returns the
+  // ID which refers to it.
+  absl::StatusOr<OwnedValueId> TrackValue(ExecutorValue value,
+                                          int64_t bytes = 0) {
+    ValueId id = next_value_id_.fetch_add(1, std::memory_order_relaxed);
+    bytes = tracked_bytes_.Tracked(ExecutorName(), id, bytes);
+    int64_t spillable_bytes =
+        spiller_ != nullptr ? SpillableBytes(value) : kNotSpillable;
+    ValueShard& shard = ShardOf(id);
+    {
+      absl::MutexLock lock(&shard.mutex);
+      shard.values.emplace(id, TrackedValue{std::move(value), bytes});
+    }
+    if (spiller_ != nullptr) {
+      RecordSpillable(id, spillable_bytes);
+      MaybeSpill();
+    }
     return absl::StatusOr<OwnedValueId>(absl::in_place_t(), shared_from_this(),
                                         id);
   }
 
-  // Returns a copy of the value previously stored with `TrackValue`.
-  absl::StatusOr<ExecutorValue> GetTracked(ValueId value_id) {
-    absl::ReaderMutexLock lock(&mutex_);
-    auto value_iter = tracked_values_.find(value_id);
-    if (value_iter == tracked_values_.end()) {
-      return absl::NotFoundError(
-          absl::StrCat(ExecutorName(), " value not found: ", value_id));
+  // Tracks the values of a batch, which must hold `batch_size` values, and
+  // returns the IDs which refer to them. `bytes` holds the approximate size of
+  // each value, or is empty if they aren't sized.
+  absl::StatusOr<std::vector<OwnedValueId>> TrackValues(
+      std::vector<ExecutorValue> values, size_t batch_size,
+      absl::Span<const int64_t> bytes = {}) {
+    if (values.size() != batch_size) {
+      return absl::InternalError(
+          absl::StrCat(ExecutorName(), " created ", values.size(),
+                       " values for a batch of ", batch_size));
+    }
+    std::vector<OwnedValueId> ids;
+    ids.reserve(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+      ids.push_back(TFF_TRY(
+          TrackValue(std::move(values[i]), bytes.empty() ? 0 : bytes[i])));
+    }
+    return ids;
+  }
+
+  // Returns a copy of the value previously stored with `TrackValue`. Values
+  // are handles such as `std::shared_ptr`s, so copying one only takes a
+  // reference to the underlying value. If `bytes` isn't null, adds the
+  // accounted size of the value to it. A spilled value is read back first.
+  absl::StatusOr<ExecutorValue> GetTracked(ValueId value_id,
+                                           int64_t* bytes = nullptr) {
+    ValueShard& shard = ShardOf(value_id);
+    {
+      absl::ReaderMutexLock lock(&shard.mutex);
+      auto value_iter = shard.values.find(value_id);
+      if (value_iter == shard.values.end()) {
+        return absl::NotFoundError(
+            absl::StrCat(ExecutorName(), " value not found: ", value_id));
+      }
+      if (bytes != nullptr && value_iter->second.bytes > 0) {
+        *bytes += value_iter->second.bytes;
+      }
+      if (value_iter->second.value.has_value()) {
+        if (spiller_ != nullptr) {
+          spiller_->Touch(value_id);
+        }
+        return *value_iter->second.value;
+      }
+    }
+    return FaultIn(value_id);
+  }
+
+  // Removes the untracked value `value_id` from the spiller, and its
+  // serialized form from disk if it is spilled.
+  void ForgetSpilled(ValueId value_id, const TrackedValue& value) {
+    spiller_->Remove(value_id);
+    if (!value.value.has_value()) {
+      spiller_->Delete(value_id);
+    }
+  }
+
+  // Records the value `value_id`, of which `SpillableBytes` returned
+  // `spillable_bytes`, with the spiller.
+  void RecordSpillable(ValueId value_id, int64_t spillable_bytes) {
+    if (spillable_bytes > 0) {
+      spiller_->AddResident(value_id, spillable_bytes);
+    } else if (spillable_bytes == 0) {
+      spiller_->AddUnsized(value_id);
+    }
+  }
+
+  // Sizes the values whose size wasn't known, and spills the least recently
+  // used values over the memory budget.
+  void MaybeSpill() {
+    for (ValueId value_id : spiller_->TakeUnsized(kMaxSizedPerSpill)) {
+      ValueShard& shard = ShardOf(value_id);
+      // The value is recorded under the lock, so that a concurrent `Dispose`
+      // removes it from the spiller after it is recorded.
+      absl::ReaderMutexLock lock(&shard.mutex);
+      auto value_iter = shard.values.find(value_id);
+      if (value_iter != shard.values.end() &&
+          value_iter->second.value.has_value()) {
+        RecordSpillable(value_id, SpillableBytes(*value_iter->second.value));
+      }
+    }
+    for (ValueId value_id : spiller_->TakeOverBudget()) {
+      absl::Status status = Spill(value_id);
+      if (!status.ok()) {
+        LOG(WARNING) << ExecutorName() << " keeps value " << value_id
+                     << " in memory: " << status;
+      }
+    }
+  }
+
+  // Writes the value `value_id` to disk and drops it from memory, unless it
+  // was disposed of meanwhile. The value is serialized without holding the
+  // lock of its shard, and is freed once the other references to it, e.g. of
+  // calls using it, are released.
+  absl::Status Spill(ValueId value_id) {
+    ValueShard& shard = ShardOf(value_id);
+    std::optional<ExecutorValue> value;
+    {
+      absl::ReaderMutexLock lock(&shard.mutex);
+      auto value_iter = shard.values.find(value_id);
+      if (value_iter == shard.values.end() ||
+          !value_iter->second.value.has_value()) {
+        return absl::OkStatus();
+      }
+      value = value_iter->second.value;
+    }
+    TFF_TRY(spiller_->Write(value_id, TFF_TRY(SerializeSpilled(*value))));
+    absl::MutexLock lock(&shard.mutex);
+    auto value_iter = shard.values.find(value_id);
+    if (value_iter == shard.values.end()) {
+      spiller_->Delete(value_id);
+      return absl::OkStatus();
+    }
+    value_iter->second.value.reset();
+    if (MetricsEnabled()) {
+      MetricsRegistry::Default()
+          .GetCounter(absl::StrCat(ExecutorName(), "/SpilledValues"))
+          ->Increment();
+    }
+    return absl::OkStatus();
+  }
+
+  // Reads the spilled value `value_id` back into memory and returns it.
+  absl::StatusOr<ExecutorValue> FaultIn(ValueId value_id) {
+    ValueShard& shard = ShardOf(value_id);
+    std::optional<ExecutorValue> value;
+    {
+      absl::MutexLock lock(&shard.mutex);
+      auto value_iter = shard.values.find(value_id);
+      if (value_iter == shard.values.end()) {
+        return absl::NotFoundError(
+            absl::StrCat(ExecutorName(), " value not found: ", value_id));
+      }
+      // Another thread may have read the value back meanwhile.
+      if (!value_iter->second.value.has_value()) {
+        value_iter->second.value =
+            TFF_TRY(DeserializeSpilled(TFF_TRY(spiller_->Read(value_id))));
+        spiller_->Delete(value_id);
+        RecordSpillable(value_id, SpillableBytes(*value_iter->second.value));
+        if (MetricsEnabled()) {
+          MetricsRegistry::Default()
+              .GetCounter(absl::StrCat(ExecutorName(), "/FaultedInValues"))
+              ->Increment();
+        }
+      }
+      value = value_iter->second.value;
     }
-    return value_iter->second;
+    MaybeSpill();
+    return *std::move(value);
   }
 
  protected:
-  // Logs the current method and records its trace to the TensorFlow profiler.
-  std::optional<tensorflow::profiler::TraceMe> Trace(const char* method_name) {
-    bool enabled = VLOG_IS_ON(1) || tensorflow::profiler::TraceMe::Active();
-    if (!enabled) {
-      return std::nullopt;
+  // Logs the current method, records its trace to the TensorFlow profiler and,
+  // if metrics are enabled, records its latency to the histogram named
+  // `ExecutorName()::method_name` in the default `MetricsRegistry`.
+  ExecutorTrace Trace(const char* method_name) {
+    bool profile = VLOG_IS_ON(1) || tensorflow::profiler::TraceMe::Active();
+    bool record = MetricsEnabled();
+    if (!profile && !record) {
+      return ExecutorTrace();
     }
     std::string path = absl::StrCat(ExecutorName(), "::", method_name);
-    std::string_view path_view(path);
-    VLOG(1) << path_view;
-    // Safe to pass in a view here: `TraceMe` internally copies to an owned
-    // `std::string`.
-    return std::make_optional<tensorflow::profiler::TraceMe>(path_view);
+    VLOG(1) << path;
+    return ExecutorTrace(
+        path, profile,
+        record ? MetricsRegistry::Default().GetLatencyHistogram(path)
+               : nullptr);
+  }
+
+  // Returned by `SpillableBytes` for values which can't be spilled.
+  static constexpr int64_t kNotSpillable = -1;
+
+  // Spills the least recently used values tracked by the executor to disk
+  // once the spillable values exceed `options.memory_budget_bytes`. Spilled
+  // values are serialized with `SerializeSpilled` and read back with
+  // `DeserializeSpilled`. Must be called before any value is tracked, e.g. by
+  // the constructor of the derived executor; does nothing if the budget isn't
+  // positive.
+  void EnableValueSpilling(ValueSpillOptions options) {
+    if (options.memory_budget_bytes > 0) {
+      spiller_ = std::make_unique<ValueSpiller>(std::move(options),
+                                                ExecutorName());
+    }
+  }
+
+  // Returns the approximate number of bytes spilling `value` would free, 0 if
+  // that isn't known yet, e.g. as the value isn't computed yet, or
+  // `kNotSpillable` if the value can't be spilled.
+  virtual int64_t SpillableBytes(const ExecutorValue& value) {
+    return kNotSpillable;
+  }
+  // Serializes `value`, for which `SpillableBytes` returned a size, to spill
+  // it to disk.
+  virtual absl::StatusOr<std::string> SerializeSpilled(
+      const ExecutorValue& value) {
+    return absl::UnimplementedError(
+        absl::StrCat(ExecutorName(), " does not spill values."));
+  }
+  // Returns the value serialized by `SerializeSpilled` as `data`.
+  virtual absl::StatusOr<ExecutorValue> DeserializeSpilled(
+      const std::string& data) {
+    return absl::UnimplementedError(
+        absl::StrCat(ExecutorName(), " does not spill values."));
   }
 
   // Clears all currently tracked values from the executor.
   // This method is intended to be used by child class destructors to ensure
-  // that the `ExecutorValue` references held by `tracked_values_` have been
+  // that the `ExecutorValue` references held by the executor have been
   // destroyed.
   void ClearTracked() {
-    absl::WriterMutexLock lock(&mutex_);
-    tracked_values_.clear();
+    for (ValueShard& shard : value_shards_) {
+      absl::flat_hash_map<ValueId, TrackedValue> values;
+      {
+        absl::MutexLock lock(&shard.mutex);
+        values.swap(shard.values);
+      }
+      for (const auto& [id, value] : values) {
+        tracked_bytes_.Untracked(id, value.bytes);
+        if (spiller_ != nullptr) {
+          ForgetSpilled(id, value);
+        }
+      }
+    }
+    releaser_.Flush();
   }
 
   // Returns the string name of the current executor.
@@ -299,12 +633,54 @@ class ExecutorBase : public Executor,
       ExecutorValue value, const uint32_t index) = 0;
   virtual absl::Status Materialize(ExecutorValue value,
                                    v0::Value* value_pb) = 0;
-  ~ExecutorBase() override {}
+
+  // The batch counterparts of the methods above, which return one value per
+  // element of the batch. By default they call those methods once per
+  // element.
+  virtual absl::StatusOr<std::vector<ExecutorValue>> CreateExecutorValueBatch(
+      absl::Span<const v0::Value* const> values_pb) {
+    std::vector<ExecutorValue> values;
+    values.reserve(values_pb.size());
+    for (const v0::Value* value_pb : values_pb) {
+      values.push_back(TFF_TRY(CreateExecutorValue(*value_pb)));
+    }
+    return values;
+  }
+  virtual absl::StatusOr<std::vector<ExecutorValue>> CreateCallBatch(
+      ExecutorValue function, std::vector<ExecutorValue> arguments) {
+    std::vector<ExecutorValue> values;
+    values.reserve(arguments.size());
+    for (ExecutorValue& argument : arguments) {
+      values.push_back(TFF_TRY(CreateCall(function, std::move(argument))));
+    }
+    return values;
+  }
+  virtual absl::StatusOr<std::vector<ExecutorValue>> CreateStructBatch(
+      std::vector<std::vector<ExecutorValue>> members) {
+    std::vector<ExecutorValue> values;
+    values.reserve(members.size());
+    for (std::vector<ExecutorValue>& struct_members : members) {
+      values.push_back(TFF_TRY(CreateStruct(std::move(struct_members))));
+    }
+    return values;
+  }
+
+  // Returns `value` as a value of `target`, another executor of the same type
+  // as this one, or `std::nullopt` if it can't be shared with `target`, in
+  // which case `TransferTo` materializes it and creates it in `target`.
+  virtual absl::StatusOr<std::optional<ExecutorValue>> TransferExecutorValue(
+      ExecutorValue value, ExecutorBase& target) {
+    return std::nullopt;
+  }
+  // Values which weren't cleared by the derived executor are destroyed with it
+  // anyway; clearing them here also removes them from the accounted bytes.
+  ~ExecutorBase() override { ClearTracked(); }
 
  public:
   absl::StatusOr<OwnedValueId> CreateValue(const v0::Value& value_pb) final {
     auto trace = Trace("CreateValue");
-    return TrackValue(TFF_TRY(CreateExecutorValue(value_pb)));
+    return TrackValue(TFF_TRY(CreateExecutorValue(value_pb)),
+                      ApproximateBytes(value_pb));
   }
 
   absl::StatusOr<OwnedValueId> CreateCall(
@@ -324,10 +700,11 @@ class ExecutorBase : public Executor,
       const absl::Span<const ValueId> members) final {
     auto trace = Trace("CreateStruct");
     std::vector<ExecutorValue> member_values;
+    int64_t bytes = 0;
     for (const ValueId member_id : members) {
-      member_values.emplace_back(TFF_TRY(GetTracked(member_id)));
+      member_values.emplace_back(TFF_TRY(GetTracked(member_id, &bytes)));
     }
-    return TrackValue(TFF_TRY(CreateStruct(std::move(member_values))));
+    return TrackValue(TFF_TRY(CreateStruct(std::move(member_values))), bytes);
   }
 
   absl::StatusOr<OwnedValueId> CreateSelection(const ValueId source,
@@ -337,22 +714,132 @@ class ExecutorBase : public Executor,
         TFF_TRY(CreateSelection(TFF_TRY(GetTracked(source)), index)));
   }
 
+  absl::StatusOr<std::vector<OwnedValueId>> CreateValueBatch(
+      absl::Span<const v0::Value* const> values_pb) final {
+    auto trace = Trace("CreateValueBatch");
+    std::vector<int64_t> bytes;
+    bytes.reserve(values_pb.size());
+    for (const v0::Value* value_pb : values_pb) {
+      bytes.push_back(ApproximateBytes(*value_pb));
+    }
+    return TrackValues(TFF_TRY(CreateExecutorValueBatch(values_pb)),
+                       values_pb.size(), bytes);
+  }
+
+  absl::StatusOr<std::vector<OwnedValueId>> CreateCallBatch(
+      const ValueId function, absl::Span<const ValueId> arguments) final {
+    auto trace = Trace("CreateCallBatch");
+    ExecutorValue function_val = TFF_TRY(GetTracked(function));
+    std::vector<ExecutorValue> argument_vals;
+    argument_vals.reserve(arguments.size());
+    for (const ValueId argument : arguments) {
+      argument_vals.push_back(TFF_TRY(GetTracked(argument)));
+    }
+    return TrackValues(TFF_TRY(CreateCallBatch(std::move(function_val),
+                                               std::move(argument_vals))),
+                       arguments.size());
+  }
+
+  absl::StatusOr<std::vector<OwnedValueId>> CreateStructBatch(
+      absl::Span<const std::vector<ValueId>> members) final {
+    auto trace = Trace("CreateStructBatch");
+    std::vector<std::vector<ExecutorValue>> member_vals(members.size());
+    std::vector<int64_t> bytes(members.size(), 0);
+    for (size_t i = 0; i < members.size(); ++i) {
+      member_vals[i].reserve(members[i].size());
+      for (const ValueId member_id : members[i]) {
+        member_vals[i].push_back(TFF_TRY(GetTracked(member_id, &bytes[i])));
+      }
+    }
+    return TrackValues(TFF_TRY(CreateStructBatch(std::move(member_vals))),
+                       members.size(), bytes);
+  }
+
   absl::Status Materialize(const ValueId value_id, v0::Value* value_pb) final {
     auto trace = Trace("Materialize");
     return Materialize(TFF_TRY(GetTracked(value_id)), value_pb);
   }
 
+  absl::StatusOr<OwnedValueId> TransferTo(Executor& target,
+                                          const ValueId value_id) final {
+    auto trace = Trace("TransferTo");
+    int64_t bytes = 0;
+    if (&target == this) {
+      ExecutorValue value = TFF_TRY(GetTracked(value_id, &bytes));
+      return TrackValue(std::move(value), bytes);
+    }
+    if (typeid(target) == typeid(*this)) {
+      auto& same_type_target = static_cast<ExecutorBase&>(target);
+      std::optional<ExecutorValue> value = TFF_TRY(TransferExecutorValue(
+          TFF_TRY(GetTracked(value_id, &bytes)), same_type_target));
+      if (value.has_value()) {
+        return same_type_target.TrackValue(*std::move(value), bytes);
+      }
+    }
+    return Executor::TransferTo(target, value_id);
+  }
+
   absl::Status Dispose(const ValueId value) final {
     auto trace = Trace("Dispose");
-    absl::WriterMutexLock lock(&mutex_);
-    auto value_iter = tracked_values_.find(value);
-    if (value_iter == tracked_values_.end()) {
+    ValueShard& shard = ShardOf(value);
+    // The value is destroyed once the lock is released, so that releasing what
+    // it holds doesn't block the other values of the shard.
+    typename absl::flat_hash_map<ValueId, TrackedValue>::node_type node;
+    {
+      absl::MutexLock lock(&shard.mutex);
+      node = shard.values.extract(value);
+    }
+    if (node.empty()) {
       return absl::NotFoundError(absl::StrCat(
           ExecutorName(), " value not found: ", value, ", cannot dispose."));
     }
-    tracked_values_.erase(value_iter);
+    tracked_bytes_.Untracked(value, node.mapped().bytes);
+    if (spiller_ != nullptr) {
+      ForgetSpilled(value, node.mapped());
+    }
     return absl::OkStatus();
   }
+
+  absl::Status DisposeBatch(absl::Span<const ValueId> values) final {
+    auto trace = Trace("DisposeBatch");
+    std::array<std::vector<ValueId>, kNumValueShards> shard_values;
+    for (const ValueId value : values) {
+      shard_values[value % kNumValueShards].push_back(value);
+    }
+    std::vector<typename absl::flat_hash_map<ValueId, TrackedValue>::node_type>
+        nodes;
+    nodes.reserve(values.size());
+    absl::Status status;
+    for (size_t i = 0; i < kNumValueShards; ++i) {
+      if (shard_values[i].empty()) {
+        continue;
+      }
+      ValueShard& shard = value_shards_[i];
+      absl::MutexLock lock(&shard.mutex);
+      for (const ValueId value : shard_values[i]) {
+        auto node = shard.values.extract(value);
+        if (node.empty()) {
+          if (status.ok()) {
+            status = absl::NotFoundError(
+                absl::StrCat(ExecutorName(), " value not found: ", value,
+                             ", cannot dispose."));
+          }
+          continue;
+        }
+        nodes.push_back(std::move(node));
+      }
+    }
+    for (const auto& node : nodes) {
+      tracked_bytes_.Untracked(node.key(), node.mapped().bytes);
+      if (spiller_ != nullptr) {
+        ForgetSpilled(node.key(), node.mapped());
+      }
+    }
+    if (!nodes.empty()) {
+      releaser_.Add([nodes = std::move(nodes)]() mutable { nodes.clear(); });
+    }
+    return status;
+  }
 };
 
 }  // namespace tensorflow_federated
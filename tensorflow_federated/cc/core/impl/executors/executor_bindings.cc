@@ -27,6 +27,9 @@ limitations under the License
 #include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "absl/log/log.h"
 #include "absl/status/status.h"
@@ -54,11 +57,15 @@ limitations under the License
 #include "tensorflow/python/lib/core/ndarray_tensor.h"
 #include "tensorflow/python/lib/core/ndarray_tensor_bridge.h"
 #include "tensorflow/python/lib/core/safe_pyobject_ptr.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/task_metrics.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/composing_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/dtensor_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/federating_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/grpc_compression.h"
 #include "tensorflow_federated/cc/core/impl/executors/reference_resolving_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/remote_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/sequence_executor.h"
@@ -66,6 +73,9 @@ limitations under the License
 #include "tensorflow_federated/cc/core/impl/executors/streaming_remote_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensorflow_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/cc/core/impl/executors/tracked_bytes.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_spiller.h"
 #include "tensorflow_federated/cc/core/impl/executors/xla_executor.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
@@ -107,6 +117,33 @@ TFE_Context* GetContextHandle(PyObject* py_context) {
   return ctx;
 }
 
+// Runs `fn` on a thread of the coordination lane of the default
+// `ExecutorRuntime`, and then calls the Python callable `done` with a function
+// which returns the result of `fn`, or raises its error status.
+//
+// This lets Python await executor calls without dedicating a Python thread to
+// each of them: `done` is expected to hand the function over to an event loop,
+// e.g. with `loop.call_soon_threadsafe`, see `executor_bindings.py`.
+//
+// Must be called with the GIL held. `done` is only used and destroyed with the
+// GIL held.
+template <typename Fn>
+void RunAsync(Fn fn, py::function done) {
+  ThreadRun(
+      [fn = std::move(fn), done = std::move(done)]() mutable {
+        auto result = std::make_shared<std::invoke_result_t<Fn>>(fn());
+        py::gil_scoped_acquire acquire;
+        py::function callback = std::move(done);
+        try {
+          callback(py::cpp_function(
+              [result]() mutable { return std::move(*result); }));
+        } catch (py::error_already_set& e) {
+          e.discard_as_unraisable("executor_bindings.RunAsync");
+        }
+      },
+      ExecutorRuntime::Default()->pool(ExecutorLane::kCoordination));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // The Python module defintion `executor_bindings`.
 //
@@ -128,6 +165,20 @@ PYBIND11_MODULE(executor_bindings, m) {
         });
   m.def("deserialize_tensor_value", &DeserializeTensorValue);
 
+  // Metrics of the executor stack, exported in the Prometheus text format.
+  m.def("set_metrics_enabled", &SetMetricsEnabled, py::arg("enabled"));
+  m.def("export_metrics",
+        []() { return MetricsRegistry::Default().ExportPrometheusText(); });
+  // The recent tasks of the thread pools, in the Chrome trace event format.
+  m.def("export_task_trace", &ExportTaskTraceJson);
+  // The bytes of the values tracked by each executor, per layer and per round.
+  m.def("set_tracked_bytes_debugging", &SetTrackedBytesDebugging,
+        py::arg("enabled"));
+  m.def("reset_tracked_bytes_high_water_marks",
+        &ResetTrackedBytesHighWaterMarks);
+  m.def("dump_largest_tracked_values", &DumpLargestTrackedValues,
+        py::arg("n") = 10);
+
   // Provide an `OwnedValueId` class to handle return values from the
   // `Executor` interface.
   //
@@ -149,6 +200,11 @@ PYBIND11_MODULE(executor_bindings, m) {
             "<ComposingChild with num clients: ", self.num_clients(), ">");
       });
 
+  // Thread pools shared by the executors of a stack, passed to the create_*
+  // methods below as an opaque object.
+  py::class_<ExecutorRuntime, std::shared_ptr<ExecutorRuntime>>(
+      m, "ExecutorRuntime");
+
   // Provide the `Executor` interface.
   //
   // A `dispose` method is purposely not exposed. Though `Executor::Dispose`
@@ -185,17 +241,121 @@ PYBIND11_MODULE(executor_bindings, m) {
             }
             return value_pb;
           },
-          py::call_guard<py::gil_scoped_release>());
+          py::call_guard<py::gil_scoped_release>())
+      // Materializes a tensor value directly as a NumPy array, which shares
+      // the buffer of the deserialized tensor for numeric types, rather than
+      // returning a `v0::Value` which Python parses again.
+      .def(
+          "materialize_tensor",
+          [](Executor& e,
+             const ValueId& value_id) -> absl::StatusOr<tensorflow::Tensor> {
+            v0::Value value_pb;
+            TFF_TRY(e.Materialize(value_id, &value_pb));
+            return DeserializeTensorValue(value_pb);
+          },
+          py::call_guard<py::gil_scoped_release>())
+      // Asynchronous variants of the methods above, which return immediately
+      // and report their result through a `done` callable, see `RunAsync`.
+      .def(
+          "create_value_async",
+          [](std::shared_ptr<Executor> self, v0::Value value_pb,
+             py::function done) {
+            RunAsync(
+                [self = std::move(self), value_pb = std::move(value_pb)]() {
+                  return self->CreateValue(value_pb);
+                },
+                std::move(done));
+          },
+          py::arg("value_pb"), py::arg("done"))
+      .def(
+          "create_call_async",
+          [](std::shared_ptr<Executor> self, ValueId function,
+             std::optional<ValueId> argument, py::function done) {
+            RunAsync(
+                [self = std::move(self), function, argument]() {
+                  return self->CreateCall(function, argument);
+                },
+                std::move(done));
+          },
+          py::arg("function"), py::arg("argument").none(true),
+          py::arg("done"))
+      .def(
+          "materialize_async",
+          [](std::shared_ptr<Executor> self, ValueId value_id,
+             py::function done) {
+            RunAsync(
+                [self = std::move(self),
+                 value_id]() -> absl::StatusOr<v0::Value> {
+                  v0::Value value_pb;
+                  TFF_TRY(self->Materialize(value_id, &value_pb));
+                  return value_pb;
+                },
+                std::move(done));
+          },
+          py::arg("value_id"), py::arg("done"))
+      .def(
+          "materialize_tensor_async",
+          [](std::shared_ptr<Executor> self, ValueId value_id,
+             py::function done) {
+            RunAsync(
+                [self = std::move(self),
+                 value_id]() -> absl::StatusOr<tensorflow::Tensor> {
+                  v0::Value value_pb;
+                  TFF_TRY(self->Materialize(value_id, &value_pb));
+                  return DeserializeTensorValue(value_pb);
+                },
+                std::move(done));
+          },
+          py::arg("value_id"), py::arg("done"));
+
+  m.def(
+      "create_executor_runtime",
+      [](int32_t num_io_threads, int32_t num_compute_threads,
+         int32_t num_coordination_threads) {
+        ExecutorRuntimeOptions options;
+        options.num_io_threads = num_io_threads;
+        options.num_compute_threads = num_compute_threads;
+        options.num_coordination_threads = num_coordination_threads;
+        return std::make_shared<ExecutorRuntime>(options);
+      },
+      py::arg("num_io_threads") = -1, py::arg("num_compute_threads") = -1,
+      py::arg("num_coordination_threads") = -1,
+      "Creates an ExecutorRuntime.");
 
   // Executor construction methods.
-  m.def("create_tensorflow_executor", &CreateTensorFlowExecutor,
-        py::arg("max_concurrent_computation_calls") = -1,
-        "Creates a TensorFlowExecutor.");
+  m.def(
+      "create_tensorflow_executor",
+      [](int32_t max_concurrent_computation_calls,
+         int64_t computation_cache_capacity_bytes,
+         int32_t min_sessions_per_computation,
+         int32_t max_sessions_per_computation, int32_t max_call_batch_size,
+         std::shared_ptr<ExecutorRuntime> runtime,
+         int64_t value_memory_budget_bytes, std::string value_spill_directory) {
+        SessionPoolOptions session_pool_options;
+        session_pool_options.min_sessions = min_sessions_per_computation;
+        session_pool_options.max_sessions = max_sessions_per_computation;
+        ValueSpillOptions value_spill_options;
+        value_spill_options.memory_budget_bytes = value_memory_budget_bytes;
+        value_spill_options.directory = std::move(value_spill_directory);
+        return CreateTensorFlowExecutor(
+            max_concurrent_computation_calls, computation_cache_capacity_bytes,
+            session_pool_options, max_call_batch_size, std::move(runtime),
+            AdaptiveConcurrencyOptions(), std::move(value_spill_options));
+      },
+      py::arg("max_concurrent_computation_calls") = -1,
+      py::arg("computation_cache_capacity_bytes") =
+          kDefaultComputationCacheCapacityBytes,
+      py::arg("min_sessions_per_computation") = 0,
+      py::arg("max_sessions_per_computation") = 0,
+      py::arg("max_call_batch_size") = 1, py::arg("runtime") = nullptr,
+      py::arg("value_memory_budget_bytes") = 0,
+      py::arg("value_spill_directory") = "",
+      "Creates a TensorFlowExecutor.");
   m.def(
       "create_dtensor_executor",
-      [](const std::string& device_name = "", std::string serialized_mesh = "",
-         int max_concurrent_computation_calls =
-             -1) -> absl::StatusOr<std::shared_ptr<Executor>> {
+      [](const std::string& device_name, std::string serialized_mesh,
+         int max_concurrent_computation_calls,
+         bool async_execution) -> absl::StatusOr<std::shared_ptr<Executor>> {
         PyObject* context = GetPyEagerContext();
         std::optional<tensorflow::dtensor::Mesh> mesh_opt = std::nullopt;
         if (!serialized_mesh.empty()) {
@@ -214,25 +374,71 @@ PYBIND11_MODULE(executor_bindings, m) {
             /*mesh=*/mesh_opt,
             /*dtensor_converter=*/nullptr,  // Use default converter.
             /*max_concurrent_computation_calls=*/
-            max_concurrent_computation_calls);
+            max_concurrent_computation_calls,
+            /*async_execution=*/async_execution);
         return executor;
       },
-      "Creates a DTensorExecutor.");
+      py::arg("device_name") = "", py::arg("serialized_mesh") = "",
+      py::arg("max_concurrent_computation_calls") = -1,
+      py::arg("async_execution") = false, "Creates a DTensorExecutor.");
   m.def("create_reference_resolving_executor",
         &CreateReferenceResolvingExecutor,
-        "Creates a ReferenceResolvingExecutor", py::arg("inner_executor"));
-  m.def("create_federating_executor", &CreateFederatingExecutor,
-        py::arg("inner_server_executor"), py::arg("inner_client_executor"),
-        py::arg("cardinalities"), "Creates a FederatingExecutor.");
+        "Creates a ReferenceResolvingExecutor", py::arg("inner_executor"),
+        py::arg("runtime") = nullptr);
+  m.def(
+      "create_federating_executor",
+      [](std::shared_ptr<Executor> inner_server_executor,
+         std::shared_ptr<Executor> inner_client_executor,
+         const CardinalityMap& cardinalities, uint32_t aggregate_fan_in,
+         int32_t max_concurrent_client_calls,
+         std::shared_ptr<ExecutorRuntime> runtime, bool stack_client_values) {
+        return CreateFederatingExecutor(
+            std::move(inner_server_executor), std::move(inner_client_executor),
+            cardinalities, aggregate_fan_in, max_concurrent_client_calls,
+            ThreadPoolPolicy::kSingleQueue, std::move(runtime),
+            stack_client_values);
+      },
+      py::arg("inner_server_executor"), py::arg("inner_client_executor"),
+      py::arg("cardinalities"), py::arg("aggregate_fan_in") = 0,
+      py::arg("max_concurrent_client_calls") = -1,
+      py::arg("runtime") = nullptr, py::arg("stack_client_values") = false,
+      "Creates a FederatingExecutor.");
   m.def("create_composing_child", &ComposingChild::Make, py::arg("executor"),
         py::arg("cardinalities"), "Creates a ComposingExecutor.");
-  m.def("create_composing_executor", &CreateComposingExecutor,
-        py::arg("server"), py::arg("children"), "Creates a ComposingExecutor.");
-  m.def("create_remote_executor",
-        py::overload_cast<std::shared_ptr<grpc::ChannelInterface>,
-                          const CardinalityMap&>(&CreateRemoteExecutor),
-        py::arg("channel"), py::arg("cardinalities"),
-        "Creates a RemoteExecutor.");
+  m.def(
+      "create_composing_executor",
+      [](std::shared_ptr<Executor> server, std::vector<ComposingChild> children,
+         bool speculate_stragglers, double straggler_latency_percentile,
+         double straggler_latency_multiplier,
+         std::shared_ptr<ExecutorRuntime> runtime,
+         int64_t all_equal_cache_capacity_bytes) {
+        ComposingSpeculationOptions speculation;
+        speculation.enabled = speculate_stragglers;
+        speculation.latency_percentile = straggler_latency_percentile;
+        speculation.latency_multiplier = straggler_latency_multiplier;
+        return CreateComposingExecutor(
+            std::move(server), std::move(children),
+            ThreadPoolPolicy::kSingleQueue, speculation, std::move(runtime),
+            all_equal_cache_capacity_bytes);
+      },
+      py::arg("server"), py::arg("children"),
+      py::arg("speculate_stragglers") = false,
+      py::arg("straggler_latency_percentile") = 0.75,
+      py::arg("straggler_latency_multiplier") = 1.5,
+      py::arg("runtime") = nullptr,
+      py::arg("all_equal_cache_capacity_bytes") =
+          kDefaultAllEqualCacheCapacityBytes,
+      "Creates a ComposingExecutor.");
+  m.def(
+      "create_remote_executor",
+      [](std::shared_ptr<grpc::ChannelInterface> channel,
+         const CardinalityMap& cardinalities,
+         std::shared_ptr<ExecutorRuntime> runtime) {
+        return CreateRemoteExecutor(std::move(channel), cardinalities,
+                                    std::move(runtime));
+      },
+      py::arg("channel"), py::arg("cardinalities"),
+      py::arg("runtime") = nullptr, "Creates a RemoteExecutor.");
   m.def(
       "create_streaming_remote_executor",
       py::overload_cast<std::shared_ptr<grpc::ChannelInterface>,
@@ -242,22 +448,33 @@ PYBIND11_MODULE(executor_bindings, m) {
   m.def("create_xla_executor", &CreateXLAExecutor,
         py::arg("platform_name") = "Host", "Creates an XlaExecutor.");
   m.def("create_sequence_executor", &CreateSequenceExecutor,
-        py::arg("target_executor"), "Creates a SequenceExecutor.");
+        py::arg("target_executor"), py::arg("parallel_reduce_batch_size") = 0,
+        py::arg("prefetch_depth") = 0, "Creates a SequenceExecutor.");
 
   py::class_<grpc::ChannelInterface, std::shared_ptr<grpc::ChannelInterface>>(
       m, "GRPCChannelInterface");
 
   m.def(
       "create_insecure_grpc_channel",
-      [](const std::string& target) -> std::shared_ptr<grpc::ChannelInterface> {
+      [](const std::string& target, const std::string& compression,
+         bool dedicated_connection)
+          -> absl::StatusOr<std::shared_ptr<grpc::ChannelInterface>> {
         auto channel_options = grpc::ChannelArguments();
+        if (dedicated_connection) {
+          // Channels to the same target otherwise share their connection.
+          channel_options.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+        }
         channel_options.SetMaxSendMessageSize(
             std::numeric_limits<int32_t>::max());
         channel_options.SetMaxReceiveMessageSize(
             std::numeric_limits<int32_t>::max());
+        channel_options.SetCompressionAlgorithm(
+            TFF_TRY(CompressionAlgorithmFromName(compression)));
         return grpc::CreateCustomChannel(
             target, grpc::InsecureChannelCredentials(), channel_options);
       },
+      py::arg("target"), py::arg("compression") = "none",
+      py::arg("dedicated_connection") = false,
       pybind11::return_value_policy::take_ownership);
 }
 
@@ -0,0 +1,90 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// Returns `num_threads`, or `threads_per_core` threads per core if it is less
+// than one.
+int32_t NumThreads(int32_t num_threads, int32_t threads_per_core) {
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  return std::max<int32_t>(std::thread::hardware_concurrency(), 1) *
+         threads_per_core;
+}
+
+}  // namespace
+
+ExecutorRuntime::ExecutorRuntime(ExecutorRuntimeOptions options)
+    : options_(options),
+      io_pool_(NumThreads(options.num_io_threads, 4), "executor-runtime-io",
+               options.policy),
+      compute_pool_(NumThreads(options.num_compute_threads, 1),
+                    "executor-runtime-compute", options.policy) {}
+
+std::shared_ptr<ExecutorRuntime> ExecutorRuntime::Default() {
+  // Never destroyed, so that threads of the runtime are not joined while the
+  // process exits.
+  static std::shared_ptr<ExecutorRuntime>* const runtime =
+      new std::shared_ptr<ExecutorRuntime>(std::make_shared<ExecutorRuntime>());
+  return *runtime;
+}
+
+ThreadPool* ExecutorRuntime::pool(ExecutorLane lane) {
+  switch (lane) {
+    case ExecutorLane::kIo:
+      return &io_pool_;
+    case ExecutorLane::kCompute:
+      return &compute_pool_;
+    case ExecutorLane::kCoordination:
+      break;
+  }
+  const ThreadPool* current = ThreadPool::Current();
+  absl::MutexLock lock(&coordination_mutex_);
+  int32_t depth = 0;
+  if (current != nullptr) {
+    for (int32_t i = 0; i < kMaxCoordinationDepth; ++i) {
+      if (coordination_pools_[i].get() == current) {
+        depth = i + 1;
+        break;
+      }
+    }
+  }
+  if (depth == kMaxCoordinationDepth) {
+    return nullptr;
+  }
+  std::unique_ptr<ThreadPool>& pool = coordination_pools_[depth];
+  if (pool == nullptr) {
+    pool = std::make_unique<ThreadPool>(
+        NumThreads(options_.num_coordination_threads, 4),
+        absl::StrCat("executor-runtime-coordination-", depth), options_.policy);
+  }
+  return pool.get();
+}
+
+}  // namespace tensorflow_federated
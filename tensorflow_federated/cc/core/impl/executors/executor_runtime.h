@@ -0,0 +1,95 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EXECUTOR_RUNTIME_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EXECUTOR_RUNTIME_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+
+namespace tensorflow_federated {
+
+// The lanes of an `ExecutorRuntime`. Each lane has its own threads, so that
+// work in one lane never waits for threads kept busy by another, e.g. RPCs are
+// not delayed behind long running computations.
+enum class ExecutorLane {
+  // Work which waits for remote services, e.g. for the inputs of an RPC.
+  kIo,
+  // Work which runs computations, and only waits for work of the same
+  // executor scheduled before it.
+  kCompute,
+  // Work which awaits and combines the results of child executors, e.g. of
+  // `ComposingExecutor` and `FederatingExecutor`.
+  kCoordination,
+};
+
+struct ExecutorRuntimeOptions {
+  // The number of threads of each lane. Values less than one select four
+  // threads per core for the I/O and coordination lanes, whose threads mostly
+  // wait, and one thread per core for the compute lane.
+  int32_t num_io_threads = -1;
+  int32_t num_compute_threads = -1;
+  int32_t num_coordination_threads = -1;
+  ThreadPoolPolicy policy = ThreadPoolPolicy::kSingleQueue;
+};
+
+// Thread pools shared by the executors of a stack, so that the number of
+// threads of a process is bounded by the runtime rather than growing with the
+// number of executors.
+//
+// Coordination work waits for the work of child executors, which may be
+// scheduled on the same lane after it. To keep `ThreadPool`'s guarantee that
+// tasks only wait for work scheduled before them, the coordination lane has a
+// pool per level of nesting: work scheduled from a thread of the pool of one
+// level runs in the pool of the next level. Nesting deeper than
+// `kMaxCoordinationDepth` levels runs on new threads.
+class ExecutorRuntime {
+ public:
+  static constexpr int32_t kMaxCoordinationDepth = 8;
+
+  explicit ExecutorRuntime(
+      ExecutorRuntimeOptions options = ExecutorRuntimeOptions());
+
+  // Restrict copying and moving, the pools are referenced by executors.
+  ExecutorRuntime(const ExecutorRuntime&) = delete;
+  ExecutorRuntime& operator=(const ExecutorRuntime&) = delete;
+
+  // Returns the runtime shared by the executors of the process which are not
+  // given another one. It is created with the default options on first use.
+  static std::shared_ptr<ExecutorRuntime> Default();
+
+  // Returns the pool to schedule work of `lane` on from the calling thread,
+  // or `nullptr` if the work must run on a new thread.
+  ThreadPool* pool(ExecutorLane lane);
+
+ private:
+  const ExecutorRuntimeOptions options_;
+  ThreadPool io_pool_;
+  ThreadPool compute_pool_;
+
+  absl::Mutex coordination_mutex_;
+  // The coordination pool of each level of nesting, created on first use.
+  std::array<std::unique_ptr<ThreadPool>, kMaxCoordinationDepth>
+      coordination_pools_ ABSL_GUARDED_BY(coordination_mutex_);
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EXECUTOR_RUNTIME_H_
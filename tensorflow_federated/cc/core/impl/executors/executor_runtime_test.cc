@@ -0,0 +1,102 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
+
+#include <cstdint>
+#include <future>  // NOLINT
+
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+
+namespace tensorflow_federated {
+namespace {
+
+// Returns the coordination pool for work scheduled from a thread of `pool`.
+ThreadPool* NestedCoordinationPool(ExecutorRuntime& runtime, ThreadPool* pool) {
+  return ThreadRun(
+             [&runtime]() {
+               return runtime.pool(ExecutorLane::kCoordination);
+             },
+             pool)
+      .get();
+}
+
+TEST(ExecutorRuntimeTest, LanesHaveSeparatePools) {
+  ExecutorRuntime runtime;
+  ThreadPool* io_pool = runtime.pool(ExecutorLane::kIo);
+  ThreadPool* compute_pool = runtime.pool(ExecutorLane::kCompute);
+  ThreadPool* coordination_pool = runtime.pool(ExecutorLane::kCoordination);
+  EXPECT_NE(io_pool, compute_pool);
+  EXPECT_NE(io_pool, coordination_pool);
+  EXPECT_NE(compute_pool, coordination_pool);
+  EXPECT_EQ(runtime.pool(ExecutorLane::kIo), io_pool);
+  EXPECT_EQ(runtime.pool(ExecutorLane::kCompute), compute_pool);
+  EXPECT_EQ(runtime.pool(ExecutorLane::kCoordination), coordination_pool);
+}
+
+TEST(ExecutorRuntimeTest, NestedCoordinationUsesNextPool) {
+  ExecutorRuntime runtime;
+  ThreadPool* outer_pool = runtime.pool(ExecutorLane::kCoordination);
+  ThreadPool* inner_pool = NestedCoordinationPool(runtime, outer_pool);
+  ASSERT_NE(inner_pool, nullptr);
+  EXPECT_NE(inner_pool, outer_pool);
+  EXPECT_EQ(NestedCoordinationPool(runtime, outer_pool), inner_pool);
+  // Other lanes do not nest.
+  EXPECT_EQ(NestedCoordinationPool(runtime, runtime.pool(ExecutorLane::kIo)),
+            outer_pool);
+}
+
+TEST(ExecutorRuntimeTest, NestingBeyondMaxDepthRunsOnNewThreads) {
+  ExecutorRuntime runtime;
+  ThreadPool* pool = runtime.pool(ExecutorLane::kCoordination);
+  for (int32_t depth = 1; depth < ExecutorRuntime::kMaxCoordinationDepth;
+       ++depth) {
+    pool = NestedCoordinationPool(runtime, pool);
+    ASSERT_NE(pool, nullptr) << "at depth " << depth;
+  }
+  EXPECT_EQ(NestedCoordinationPool(runtime, pool), nullptr);
+}
+
+TEST(ExecutorRuntimeTest, NestedCoordinationWorkDoesNotDeadlock) {
+  ExecutorRuntimeOptions options;
+  options.num_coordination_threads = 1;
+  ExecutorRuntime runtime(options);
+  // Each task waits for work it schedules on the coordination lane, which
+  // would deadlock a single shared thread.
+  std::shared_future<int32_t> result = ThreadRun(
+      [&runtime]() {
+        return ThreadRun(
+                   [&runtime]() {
+                     return ThreadRun([]() { return 3; },
+                                      runtime.pool(ExecutorLane::kCoordination))
+                                .get() +
+                            2;
+                   },
+                   runtime.pool(ExecutorLane::kCoordination))
+                   .get() +
+               1;
+      },
+      runtime.pool(ExecutorLane::kCoordination));
+  EXPECT_EQ(result.get(), 6);
+}
+
+TEST(ExecutorRuntimeTest, DefaultIsShared) {
+  EXPECT_NE(ExecutorRuntime::Default(), nullptr);
+  EXPECT_EQ(ExecutorRuntime::Default(), ExecutorRuntime::Default());
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -15,6 +15,9 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/executor_service.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
@@ -29,11 +32,19 @@ limitations under the License
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "include/grpcpp/client_context.h"
 #include "include/grpcpp/server_context.h"
 #include "include/grpcpp/support/status.h"
+#include "include/grpcpp/support/sync_stream.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/fair_request_queue.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_snapshots.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
 
@@ -73,6 +84,46 @@ grpc::Status RemoteValueToId(const v0::ValueRef& remote_value_ref,
                    remote_value_ref.id()));
 }
 
+grpc::Status BatchRefToId(const v0::ExecuteBatchRequest::Ref& batch_ref,
+                          const std::vector<OwnedValueId>& batch_results,
+                          ValueId& value_id_out) {
+  switch (batch_ref.ref_case()) {
+    case v0::ExecuteBatchRequest::Ref::kValueRef:
+      return RemoteValueToId(batch_ref.value_ref(), value_id_out);
+    case v0::ExecuteBatchRequest::Ref::kOperationIndex:
+      // Operations may only refer to the results of earlier operations.
+      if (batch_ref.operation_index() >= batch_results.size()) {
+        return grpc::Status(
+            grpc::StatusCode::INVALID_ARGUMENT,
+            absl::StrCat("Expected a reference to an earlier operation of the "
+                         "batch, found operation index ",
+                         batch_ref.operation_index()));
+      }
+      value_id_out = batch_results[batch_ref.operation_index()].ref();
+      return grpc::Status::OK;
+    default:
+      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                          "Expected a value ref or an operation index.");
+  }
+}
+
+// Returns DEADLINE_EXCEEDED if the `permit` of a `method_name` request was
+// not admitted before the deadline of the call.
+grpc::Status AdmissionStatus(std::string_view method_name,
+                             const FairRequestPermit& permit) {
+  if (permit.admitted()) {
+    return grpc::Status::OK;
+  }
+  return grpc::Status(
+      grpc::StatusCode::DEADLINE_EXCEEDED,
+      absl::StrCat("Error calling `", method_name,
+                   "`. The request was not admitted before its deadline."));
+}
+
+absl::Time CallDeadline(const grpc::ServerContext* context) {
+  return absl::FromChrono(context->deadline());
+}
+
 }  // namespace
 
 using ExecutorId = std::string;
@@ -105,7 +156,8 @@ ExecutorService::ExecutorResolver::ExecutorIDForRequirements(
         cardinalities_string, "/", service_id_, "/", executor_index_++);
     // Ensure keys_to_cardinalities_ key corresponds to an executor in
     // executors_.
-    keys_to_cardinalities_.emplace(executor_key, cardinalities_string);
+    keys_to_cardinalities_.emplace(
+        executor_key, ExecutorKeyEntry{cardinalities_string, *new_executor});
     // Initialize the refcount to one, and the ID to the one constructed above.
     ExecutorEntry entry({std::move(*new_executor), 1, executor_key});
     executors_.emplace(cardinalities_string, entry);
@@ -121,11 +173,11 @@ ExecutorService::ExecutorResolver::ExecutorIDForRequirements(
   }
 }
 
-absl::StatusOr<ExecutorService::ExecutorEntry>
-ExecutorService::ExecutorResolver::ExecutorForId(const ExecutorId& ex_id) {
-  absl::MutexLock lock(&executors_mutex_);
-  auto ex_cardinalities_it = keys_to_cardinalities_.find(ex_id);
-  if (ex_cardinalities_it == keys_to_cardinalities_.end()) {
+absl::StatusOr<std::shared_ptr<Executor>>
+ExecutorService::ExecutorResolver::ExecutorForId(std::string_view ex_id) {
+  absl::ReaderMutexLock lock(&executors_mutex_);
+  auto ex_key_it = keys_to_cardinalities_.find(ex_id);
+  if (ex_key_it == keys_to_cardinalities_.end()) {
     // A lack of executor in the expected slot is retryable, but clients must
     // ensure the service state is adjusted (e.g. with a GetExecutor call)
     // before retrying. Following
@@ -134,13 +186,7 @@ ExecutorService::ExecutorResolver::ExecutorForId(const ExecutorId& ex_id) {
     return absl::FailedPreconditionError(
         absl::StrCat("No executor found for ID: '", ex_id, "'."));
   }
-  auto ex_it = executors_.find(ex_cardinalities_it->second);
-  if (ex_it == executors_.end()) {
-    return absl::InternalError(absl::StrCat(
-        "No executor found for cardinalities string: ",
-        ex_cardinalities_it->second, ", referred to by executor id ", ex_id));
-  }
-  return ex_it->second;
+  return ex_key_it->second.executor;
 }
 
 absl::Status ExecutorService::ExecutorResolver::DisposeExecutor(
@@ -158,11 +204,12 @@ absl::Status ExecutorService::ExecutorResolver::DisposeExecutor(
     // client-side bug.
     return absl::OkStatus();
   }
-  auto ex_it = executors_.find(ex_cardinalities_it->second);
+  auto ex_it = executors_.find(ex_cardinalities_it->second.cardinalities);
   if (ex_it == executors_.end()) {
     return absl::InternalError(absl::StrCat(
         "No executor found for cardinalities string: ",
-        ex_cardinalities_it->second, ", referred to by executor id ", ex_id));
+        ex_cardinalities_it->second.cardinalities,
+        ", referred to by executor id ", ex_id));
   }
   ex_it->second.remote_refcount--;
   should_destroy = ex_it->second.remote_refcount == 0;
@@ -182,16 +229,24 @@ void ExecutorService::ExecutorResolver::DestroyExecutorImpl(
   VLOG(3) << "Destroying executor: " << id;
   auto ex_cardinalities = keys_to_cardinalities_.find(id);
   if (ex_cardinalities != keys_to_cardinalities_.end()) {
-    executors_.erase(ex_cardinalities->second);
+    executors_.erase(ex_cardinalities->second.cardinalities);
     keys_to_cardinalities_.erase(id);
   } else {
     VLOG(2) << "Attempted to double-destroy executor of key: " << id;
   }
 }
 
+absl::Status ExecutorService::WarmUp(const CardinalityMap& cardinalities) {
+  // The handle is never disposed, so that the executor is only destroyed if it
+  // fails.
+  return executor_resolver_.ExecutorIDForRequirements({cardinalities})
+      .status();
+}
+
 grpc::Status ExecutorService::GetExecutor(grpc::ServerContext* context,
                                           const v0::GetExecutorRequest* request,
                                           v0::GetExecutorResponse* response) {
+  auto timer = RecordLatency("ExecutorService::GetExecutor");
   CardinalityMap cardinalities;
   for (const auto& cardinality : request->cardinalities()) {
     cardinalities.insert(
@@ -210,15 +265,15 @@ grpc::Status ExecutorService::GetExecutor(grpc::ServerContext* context,
 grpc::Status ExecutorService::RequireExecutor(
     std::string_view method_name, const v0::ExecutorId& executor,
     std::shared_ptr<Executor>& executor_out) {
-  absl::StatusOr<ExecutorEntry> ex =
-      executor_resolver_.ExecutorForId({executor.id()});
+  absl::StatusOr<std::shared_ptr<Executor>> ex =
+      executor_resolver_.ExecutorForId(executor.id());
   if (!ex.ok()) {
     absl::Status status_to_return(
         ex.status().code(), absl::StrCat("Error calling `", method_name, "`. ",
                                          ex.status().message()));
     return absl_to_grpc(status_to_return);
   }
-  executor_out = ex.value().executor;
+  executor_out = *std::move(ex);
   return grpc::Status::OK;
 }
 
@@ -239,10 +294,36 @@ grpc::Status ExecutorService::HandleNotOK(const absl::Status& status,
 grpc::Status ExecutorService::CreateValue(grpc::ServerContext* context,
                                           const v0::CreateValueRequest* request,
                                           v0::CreateValueResponse* response) {
+  auto timer = RecordLatency("ExecutorService::CreateValue");
+  FairRequestPermit permit(&bulk_requests_, request->executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("CreateValue", permit));
   std::shared_ptr<Executor> executor;
   TFF_TRYLOG_GRPC(
       RequireExecutor("CreateValue", request->executor(), executor));
-  absl::StatusOr<OwnedValueId> id = executor->CreateValue(request->value());
+  absl::StatusOr<OwnedValueId> id;
+  if (!request->content_hash().empty() && !request->has_value()) {
+    std::shared_ptr<const v0::Value> cached_value =
+        value_cache_ == nullptr ? nullptr
+                                : LookupOrFetchValue(request->content_hash());
+    if (cached_value == nullptr && value_snapshots_ != nullptr) {
+      cached_value = ReadSnapshot(request->content_hash());
+    }
+    if (cached_value == nullptr) {
+      // Not an error of the executor: the client is expected to send the
+      // value along with its hash in that case.
+      return grpc::Status(grpc::StatusCode::NOT_FOUND,
+                          "No value is cached under the content hash.");
+    }
+    id = executor->CreateValue(*cached_value);
+  } else {
+    id = executor->CreateValue(request->value());
+    if (id.ok() && value_cache_ != nullptr &&
+        !request->content_hash().empty()) {
+      value_cache_->Insert(request->content_hash(),
+                           std::make_shared<v0::Value>(request->value()));
+    }
+  }
   if (!id.ok()) {
     return HandleNotOK(id.status(), request->executor());
   }
@@ -254,9 +335,77 @@ grpc::Status ExecutorService::CreateValue(grpc::ServerContext* context,
   return grpc::Status::OK;
 }
 
+grpc::Status ExecutorService::CreateValueStream(
+    grpc::ServerContext* context,
+    grpc::ServerReader<v0::CreateValueStreamRequest>* reader,
+    v0::CreateValueResponse* response) {
+  auto timer = RecordLatency("ExecutorService::CreateValueStream");
+  return CreateValueFromStream(context, reader, response);
+}
+
+grpc::Status ExecutorService::CreateValueFromStream(
+    grpc::ServerContext* context,
+    grpc::ServerReaderInterface<v0::CreateValueStreamRequest>* reader,
+    v0::CreateValueResponse* response) {
+  v0::CreateValueStreamRequest request;
+  if (!reader->Read(&request) || !request.has_header()) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                        "Expected the stream to start with a header.");
+  }
+  const v0::CreateValueStreamRequest::Header header =
+      std::move(*request.mutable_header());
+  // The chunks are only read once the request is admitted.
+  FairRequestPermit permit(&bulk_requests_, header.executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("CreateValueStream", permit));
+  std::shared_ptr<Executor> executor;
+  TFF_TRYLOG_GRPC(
+      RequireExecutor("CreateValueStream", header.executor(), executor));
+  // Reassemble the chunks directly into the content of the value, which is
+  // allocated once for the size announced by the header.
+  auto value_pb = std::make_shared<v0::Value>();
+  value_pb->mutable_tensor()->set_type_url(header.type_url());
+  std::string* content = value_pb->mutable_tensor()->mutable_value();
+  content->reserve(header.size());
+  while (reader->Read(&request)) {
+    if (!request.has_chunk()) {
+      return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                          "Expected only chunks after the header.");
+    }
+    if (request.chunk().size() > header.size() - content->size()) {
+      return grpc::Status(
+          grpc::StatusCode::INVALID_ARGUMENT,
+          absl::StrCat("Received more than the ", header.size(),
+                       " bytes announced by the header."));
+    }
+    content->append(request.chunk());
+  }
+  if (content->size() != header.size()) {
+    return grpc::Status(
+        grpc::StatusCode::INVALID_ARGUMENT,
+        absl::StrCat("Received ", content->size(), " of the ", header.size(),
+                     " bytes announced by the header."));
+  }
+  absl::StatusOr<OwnedValueId> id = executor->CreateValue(*value_pb);
+  if (!id.ok()) {
+    return HandleNotOK(id.status(), header.executor());
+  }
+  if (value_cache_ != nullptr && !header.content_hash().empty()) {
+    value_cache_->Insert(header.content_hash(), std::move(value_pb));
+  }
+  *response->mutable_value_ref() = IdToRemoteValue(id.value());
+  // We must prevent this destructor from running similarly to CreateValue.
+  id.value().forget();
+  return grpc::Status::OK;
+}
+
 grpc::Status ExecutorService::CreateCall(grpc::ServerContext* context,
                                          const v0::CreateCallRequest* request,
                                          v0::CreateCallResponse* response) {
+  auto timer = RecordLatency("ExecutorService::CreateCall");
+  FairRequestPermit permit(&control_requests_, request->executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("CreateCall", permit));
   std::shared_ptr<Executor> executor;
   TFF_TRYLOG_GRPC(RequireExecutor("CreateCall", request->executor(), executor));
   ValueId embedded_fn;
@@ -281,6 +430,10 @@ grpc::Status ExecutorService::CreateCall(grpc::ServerContext* context,
 grpc::Status ExecutorService::CreateStruct(
     grpc::ServerContext* context, const v0::CreateStructRequest* request,
     v0::CreateStructResponse* response) {
+  auto timer = RecordLatency("ExecutorService::CreateStruct");
+  FairRequestPermit permit(&control_requests_, request->executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("CreateStruct", permit));
   std::shared_ptr<Executor> executor;
   TFF_TRYLOG_GRPC(
       RequireExecutor("CreateStruct", request->executor(), executor));
@@ -305,6 +458,10 @@ grpc::Status ExecutorService::CreateStruct(
 grpc::Status ExecutorService::CreateSelection(
     grpc::ServerContext* context, const v0::CreateSelectionRequest* request,
     v0::CreateSelectionResponse* response) {
+  auto timer = RecordLatency("ExecutorService::CreateSelection");
+  FairRequestPermit permit(&control_requests_, request->executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("CreateSelection", permit));
   std::shared_ptr<Executor> executor;
   TFF_TRYLOG_GRPC(
       RequireExecutor("CreateSelection", request->executor(), executor));
@@ -324,6 +481,10 @@ grpc::Status ExecutorService::CreateSelection(
 grpc::Status ExecutorService::Compute(grpc::ServerContext* context,
                                       const v0::ComputeRequest* request,
                                       v0::ComputeResponse* response) {
+  auto timer = RecordLatency("ExecutorService::Compute");
+  FairRequestPermit permit(&bulk_requests_, request->executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("Compute", permit));
   std::shared_ptr<Executor> executor;
   TFF_TRYLOG_GRPC(RequireExecutor("Compute", request->executor(), executor));
   ValueId requested_value;
@@ -336,9 +497,145 @@ grpc::Status ExecutorService::Compute(grpc::ServerContext* context,
   return HandleNotOK(status, request->executor());
 }
 
+grpc::Status ExecutorService::ComputeStream(
+    grpc::ServerContext* context, const v0::ComputeRequest* request,
+    grpc::ServerWriter<v0::ComputeStreamResponse>* writer) {
+  auto timer = RecordLatency("ExecutorService::ComputeStream");
+  return ComputeToStream(context, request, writer);
+}
+
+grpc::Status ExecutorService::ComputeToStream(
+    grpc::ServerContext* context, const v0::ComputeRequest* request,
+    grpc::ServerWriterInterface<v0::ComputeStreamResponse>* writer) {
+  FairRequestPermit permit(&bulk_requests_, request->executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("ComputeStream", permit));
+  std::shared_ptr<Executor> executor;
+  TFF_TRYLOG_GRPC(
+      RequireExecutor("ComputeStream", request->executor(), executor));
+  ValueId requested_value;
+  TFF_TRYLOG_GRPC(RemoteValueToId(request->value_ref(), requested_value));
+  v0::ComputeStreamResponse response;
+  absl::Status status =
+      executor->Materialize(requested_value, response.mutable_value());
+  if (!status.ok()) {
+    return HandleNotOK(status, request->executor());
+  }
+  if (!response.value().has_tensor() ||
+      static_cast<int64_t>(response.value().tensor().value().size()) <=
+          options_.compute_chunk_size) {
+    writer->Write(response);
+    return grpc::Status::OK;
+  }
+  // Take the content out of the value so that each chunk is copied straight
+  // from it. `Write` blocks while the flow control window of the stream is
+  // full, so only a few chunks are buffered at once.
+  std::string content =
+      std::move(*response.mutable_value()->mutable_tensor()->mutable_value());
+  std::string type_url = std::move(
+      *response.mutable_value()->mutable_tensor()->mutable_type_url());
+  v0::ComputeStreamResponse::TensorHeader* header =
+      response.mutable_tensor_header();
+  header->set_type_url(std::move(type_url));
+  header->set_size(content.size());
+  bool stream_ok = writer->Write(response);
+  for (size_t offset = 0; stream_ok && offset < content.size();
+       offset += options_.compute_chunk_size) {
+    response.mutable_chunk()->assign(
+        content, offset,
+        std::min<size_t>(options_.compute_chunk_size,
+                         content.size() - offset));
+    stream_ok = writer->Write(response);
+  }
+  if (!stream_ok) {
+    return grpc::Status(grpc::StatusCode::CANCELLED,
+                        "The stream was closed before all chunks were sent.");
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status ExecutorService::ExecuteBatch(
+    grpc::ServerContext* context, const v0::ExecuteBatchRequest* request,
+    v0::ExecuteBatchResponse* response) {
+  auto timer = RecordLatency("ExecutorService::ExecuteBatch");
+  FairRequestPermit permit(&bulk_requests_, request->executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("ExecuteBatch", permit));
+  std::shared_ptr<Executor> executor;
+  TFF_TRYLOG_GRPC(
+      RequireExecutor("ExecuteBatch", request->executor(), executor));
+  // The values created so far are disposed of when `batch_results` goes out of
+  // scope, unless the whole batch succeeds.
+  std::vector<OwnedValueId> batch_results;
+  batch_results.reserve(request->operation_size());
+  for (const v0::ExecuteBatchRequest::Operation& operation :
+       request->operation()) {
+    absl::StatusOr<OwnedValueId> result;
+    switch (operation.operation_case()) {
+      case v0::ExecuteBatchRequest::Operation::kCreateValue: {
+        result = executor->CreateValue(operation.create_value().value());
+        break;
+      }
+      case v0::ExecuteBatchRequest::Operation::kCreateCall: {
+        const v0::ExecuteBatchRequest::CreateCall& create_call =
+            operation.create_call();
+        ValueId embedded_fn;
+        TFF_TRYLOG_GRPC(BatchRefToId(create_call.function_ref(), batch_results,
+                                     embedded_fn));
+        std::optional<ValueId> embedded_arg;
+        if (create_call.has_argument_ref()) {
+          embedded_arg = 0;
+          TFF_TRYLOG_GRPC(BatchRefToId(create_call.argument_ref(),
+                                       batch_results, embedded_arg.value()));
+        }
+        result = executor->CreateCall(embedded_fn, embedded_arg);
+        break;
+      }
+      case v0::ExecuteBatchRequest::Operation::kCreateStruct: {
+        std::vector<ValueId> requested_ids;
+        requested_ids.reserve(operation.create_struct().element_size());
+        for (const v0::ExecuteBatchRequest::CreateStruct::Element& elem :
+             operation.create_struct().element()) {
+          ValueId id;
+          TFF_TRYLOG_GRPC(BatchRefToId(elem.value_ref(), batch_results, id));
+          requested_ids.push_back(id);
+        }
+        result = executor->CreateStruct(requested_ids);
+        break;
+      }
+      case v0::ExecuteBatchRequest::Operation::kCreateSelection: {
+        const v0::ExecuteBatchRequest::CreateSelection& create_selection =
+            operation.create_selection();
+        ValueId selection_source;
+        TFF_TRYLOG_GRPC(BatchRefToId(create_selection.source_ref(),
+                                     batch_results, selection_source));
+        result = executor->CreateSelection(selection_source,
+                                           create_selection.index());
+        break;
+      }
+      default:
+        return grpc::Status(
+            grpc::StatusCode::INVALID_ARGUMENT,
+            absl::StrCat("Unknown operation at index ", batch_results.size(),
+                         " of the batch."));
+    }
+    if (!result.ok()) {
+      return HandleNotOK(result.status(), request->executor());
+    }
+    batch_results.push_back(std::move(result).value());
+  }
+  for (OwnedValueId& result : batch_results) {
+    *response->add_value_ref() = IdToRemoteValue(result.ref());
+    // We must prevent this destructor from running similarly to CreateValue.
+    result.forget();
+  }
+  return grpc::Status::OK;
+}
+
 grpc::Status ExecutorService::Dispose(grpc::ServerContext* context,
                                       const v0::DisposeRequest* request,
                                       v0::DisposeResponse* response) {
+  auto timer = RecordLatency("ExecutorService::Dispose");
   std::shared_ptr<Executor> executor;
   grpc::Status executor_status =
       RequireExecutor("Dispose", request->executor(), executor);
@@ -359,21 +656,144 @@ grpc::Status ExecutorService::Dispose(grpc::ServerContext* context,
     ValueId embedded_value;
     grpc::Status status = RemoteValueToId(disposed_value_ref, embedded_value);
     if (status.ok()) {
-      absl::Status absl_status = executor->Dispose(embedded_value);
-      if (!absl_status.ok()) {
-        LOG(ERROR) << absl_status.message();
-        return absl_to_grpc(absl_status);
-      }
+      embedded_ids_to_dispose.push_back(embedded_value);
     }
   }
+  absl::Status absl_status = executor->DisposeBatch(embedded_ids_to_dispose);
+  if (!absl_status.ok()) {
+    LOG(ERROR) << absl_status.message();
+    return absl_to_grpc(absl_status);
+  }
   return grpc::Status::OK;
 }
 
 grpc::Status ExecutorService::DisposeExecutor(
     grpc::ServerContext* context, const v0::DisposeExecutorRequest* request,
     v0::DisposeExecutorResponse* response) {
+  auto timer = RecordLatency("ExecutorService::DisposeExecutor");
   return absl_to_grpc(
       executor_resolver_.DisposeExecutor({request->executor().id()}));
 }
 
+grpc::Status ExecutorService::GetCachedValue(
+    grpc::ServerContext* context, const v0::GetCachedValueRequest* request,
+    v0::GetCachedValueResponse* response) {
+  return GetCachedValueUntil(absl::FromChrono(context->deadline()), request,
+                             response);
+}
+
+grpc::Status ExecutorService::GetCachedValueUntil(
+    absl::Time call_deadline, const v0::GetCachedValueRequest* request,
+    v0::GetCachedValueResponse* response) {
+  auto timer = RecordLatency("ExecutorService::GetCachedValue");
+  if (value_cache_ == nullptr) {
+    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                        "The value cache is disabled.");
+  }
+  const absl::Time deadline = std::min(
+      call_deadline, absl::Now() + options_.value_cache_peer_timeout);
+  std::shared_ptr<const v0::Value> cached_value =
+      value_cache_->LookupOrWait(request->content_hash(), deadline);
+  if (cached_value == nullptr) {
+    return grpc::Status(grpc::StatusCode::NOT_FOUND,
+                        "No value is cached under the content hash.");
+  }
+  *response->mutable_value() = *cached_value;
+  return grpc::Status::OK;
+}
+
+grpc::Status ExecutorService::GetLocalityKeys(
+    grpc::ServerContext* context, const v0::GetLocalityKeysRequest* request,
+    v0::GetLocalityKeysResponse* response) {
+  for (const std::string& key : options_.locality_keys) {
+    response->add_locality_keys(key);
+  }
+  return grpc::Status::OK;
+}
+
+grpc::Status ExecutorService::SnapshotValue(
+    grpc::ServerContext* context, const v0::SnapshotValueRequest* request,
+    v0::SnapshotValueResponse* response) {
+  auto timer = RecordLatency("ExecutorService::SnapshotValue");
+  if (value_snapshots_ == nullptr) {
+    return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION,
+                        "Value snapshots are disabled.");
+  }
+  FairRequestPermit permit(&bulk_requests_, request->executor().id(),
+                           CallDeadline(context));
+  TFF_TRYLOG_GRPC(AdmissionStatus("SnapshotValue", permit));
+  std::shared_ptr<Executor> executor;
+  TFF_TRYLOG_GRPC(
+      RequireExecutor("SnapshotValue", request->executor(), executor));
+  ValueId snapshotted_value;
+  TFF_TRYLOG_GRPC(RemoteValueToId(request->value_ref(), snapshotted_value));
+  auto value_pb = std::make_shared<v0::Value>();
+  absl::Status status =
+      executor->Materialize(snapshotted_value, value_pb.get());
+  if (!status.ok()) {
+    return HandleNotOK(status, request->executor());
+  }
+  absl::StatusOr<std::string> content_hash = value_snapshots_->Write(*value_pb);
+  if (!content_hash.ok()) {
+    LOG(ERROR) << content_hash.status();
+    return absl_to_grpc(content_hash.status());
+  }
+  // The value is likely to be created again on this service, e.g. if it is
+  // snapshotted between rounds, so it is cached like the values clients send.
+  if (value_cache_ != nullptr) {
+    value_cache_->Insert(*content_hash, std::move(value_pb));
+  }
+  response->set_content_hash(*std::move(content_hash));
+  return grpc::Status::OK;
+}
+
+std::shared_ptr<const v0::Value> ExecutorService::LookupOrFetchValue(
+    const std::string& content_hash) {
+  std::shared_ptr<const v0::Value> value_pb =
+      value_cache_->Lookup(content_hash);
+  if (value_pb != nullptr) {
+    return value_pb;
+  }
+  // Services which have this service as peer wait for the value, which is
+  // received from the peers of this service or else from the client, rather
+  // than asking their own clients for it.
+  const absl::Time expiry = absl::Now() + options_.value_cache_peer_timeout;
+  value_cache_->MarkPending(content_hash, expiry);
+  v0::GetCachedValueRequest request;
+  request.set_content_hash(content_hash);
+  for (const auto& peer : value_cache_peers_) {
+    v0::GetCachedValueResponse response;
+    grpc::ClientContext client_context;
+    client_context.set_deadline(absl::ToChronoTime(expiry));
+    grpc::Status status =
+        peer->GetCachedValue(&client_context, request, &response);
+    if (status.ok()) {
+      value_pb =
+          std::make_shared<v0::Value>(std::move(*response.mutable_value()));
+      value_cache_->Insert(content_hash, value_pb);
+      return value_pb;
+    }
+    VLOG(1) << "Peer did not return the cached value: "
+            << status.error_message();
+  }
+  return nullptr;
+}
+
+std::shared_ptr<const v0::Value> ExecutorService::ReadSnapshot(
+    const std::string& content_hash) {
+  absl::StatusOr<std::shared_ptr<const v0::Value>> value_pb =
+      value_snapshots_->Read(content_hash);
+  if (!value_pb.ok()) {
+    if (!absl::IsNotFound(value_pb.status())) {
+      LOG(WARNING) << "Could not read the snapshotted value: "
+                   << value_pb.status();
+    }
+    return nullptr;
+  }
+  if (value_cache_ != nullptr) {
+    value_cache_->Insert(content_hash, *value_pb);
+  }
+  return *std::move(value_pb);
+}
+
 }  // namespace tensorflow_federated
@@ -21,6 +21,7 @@ limitations under the License
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
@@ -28,11 +29,16 @@ limitations under the License
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "include/grpcpp/grpcpp.h"
 #include "include/grpcpp/support/status.h"
+#include "include/grpcpp/support/sync_stream.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/fair_request_queue.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_snapshots.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 #include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
@@ -42,6 +48,54 @@ namespace tensorflow_federated {
 using ExecutorFactory = std::function<absl::StatusOr<std::shared_ptr<Executor>>(
     const CardinalityMap&)>;
 
+struct ExecutorServiceOptions {
+  // `ComputeStream` sends tensors whose serialized content is larger than this
+  // many bytes in chunks of this many bytes.
+  int64_t compute_chunk_size = 1 << 20;  // 1 MiB
+  // If positive, values created with a `content_hash` are cached under it, up
+  // to this total number of bytes, so that clients can create them again by
+  // sending the hash alone. The cache must only be enabled for services whose
+  // clients are trusted, since the hash of a value is not verified.
+  int64_t value_cache_capacity_bytes = 0;
+  // Services whose value caches back the cache of this service: a value which
+  // a client only sends the hash of, and which this service has not cached, is
+  // fetched from the first of these peers which has it, or is receiving it,
+  // before the client is asked to send it. Each value is then sent by clients
+  // to one service, from which it spreads along the peers, e.g. along a tree
+  // of services whose peers are their parents.
+  //
+  // Peers wait for the values they are receiving, so the peer relation must
+  // not have cycles; the waits of a cycle last `value_cache_peer_timeout`.
+  std::vector<std::shared_ptr<grpc::ChannelInterface>> value_cache_peers;
+  // How long a value which is being received is waited for by peers.
+  absl::Duration value_cache_peer_timeout = absl::Seconds(10);
+  // Prefixes of the URIs of the `v0::Data` which is local to this service,
+  // e.g. cached by its worker, returned by `GetLocalityKeys`. Stacks which
+  // assign clients by locality place the clients whose data matches one of
+  // them on this service.
+  std::vector<std::string> locality_keys;
+  // If set, the directory in which `SnapshotValue` stores values, e.g. on
+  // storage shared with the services which replace this one if its worker
+  // fails. A value which a client only sends the hash of, and which is not
+  // cached, is read from the snapshots of this directory before the client is
+  // asked to send it, whether or not the value cache is enabled.
+  std::string value_snapshot_directory;
+  // Limits on the number of requests served concurrently in each lane. Bulk
+  // requests, which transfer values (`CreateValue`, `CreateValueStream`,
+  // `Compute`, `ComputeStream` and `ExecuteBatch`), and control requests
+  // (`CreateCall`, `CreateStruct` and `CreateSelection`) are admitted through
+  // lanes of their own, so that large transfers do not hold up the cheap
+  // requests which drive the computation. Within a lane, the requests waiting
+  // for their turn are admitted round robin across executor IDs, so that one
+  // client issuing many requests does not starve the others. Requests which
+  // are not admitted before the deadline of their call fail with
+  // DEADLINE_EXCEEDED. Non-positive limits, the default, admit all requests
+  // at once. `Dispose` and the requests managing executors and the value
+  // cache are always admitted.
+  int32_t max_concurrent_bulk_requests = 0;
+  int32_t max_concurrent_control_requests = 0;
+};
+
 // Service hosting TFF executor stacks via gRPC as defined in executor.proto.
 //
 // The `GetExecutor` method provides access to an `ExecutorId` which is used to
@@ -70,11 +124,34 @@ class ExecutorService : public v0::ExecutorGroup::Service {
   // configured with a `GetExecutor` request (which instantiates an
   // underlying concrete tensorflow_federated::Executor) before it can start
   // executing other requests.
-  explicit ExecutorService(const ExecutorFactory& executor_factory)
-      : executor_resolver_(executor_factory) {}
+  explicit ExecutorService(
+      const ExecutorFactory& executor_factory,
+      ExecutorServiceOptions options = ExecutorServiceOptions())
+      : options_(options),
+        bulk_requests_(options.max_concurrent_bulk_requests),
+        control_requests_(options.max_concurrent_control_requests),
+        value_cache_(options.value_cache_capacity_bytes > 0
+                         ? std::make_unique<ValueCache>(
+                               options.value_cache_capacity_bytes)
+                         : nullptr),
+        value_snapshots_(options.value_snapshot_directory.empty()
+                             ? nullptr
+                             : std::make_unique<ValueSnapshotStore>(
+                                   options.value_snapshot_directory)),
+        executor_resolver_(executor_factory) {
+    for (const auto& channel : options_.value_cache_peers) {
+      value_cache_peers_.push_back(v0::ExecutorGroup::NewStub(channel));
+    }
+  }
 
   ~ExecutorService() override {}
 
+  // Constructs the executor for `cardinalities` ahead of the first
+  // `GetExecutor` requesting it, e.g. before the service starts serving. The
+  // service holds a handle to the executor, so that it outlives the handles of
+  // clients and is reused across their `GetExecutor` calls.
+  absl::Status WarmUp(const CardinalityMap& cardinalities);
+
   // Configure the underlying executor stack to host a particular executor
   // configuration and return an identifier used to access the resulting
   // executor.
@@ -87,6 +164,18 @@ class ExecutorService : public v0::ExecutorGroup::Service {
                            const v0::CreateValueRequest* request,
                            v0::CreateValueResponse* response) override;
 
+  // Embed a tensor value in the underlying executor stack, reassembling its
+  // content from the chunks of the stream.
+  grpc::Status CreateValueStream(
+      grpc::ServerContext* context,
+      grpc::ServerReader<v0::CreateValueStreamRequest>* reader,
+      v0::CreateValueResponse* response) override;
+  // Same as `CreateValueStream`, reading the stream from any `reader`.
+  grpc::Status CreateValueFromStream(
+      grpc::ServerContext* context,
+      grpc::ServerReaderInterface<v0::CreateValueStreamRequest>* reader,
+      v0::CreateValueResponse* response);
+
   // Invoke an embedded function on an embedded argument.
   grpc::Status CreateCall(grpc::ServerContext* context,
                           const v0::CreateCallRequest* request,
@@ -108,6 +197,23 @@ class ExecutorService : public v0::ExecutorGroup::Service {
                        const v0::ComputeRequest* request,
                        v0::ComputeResponse* response) override;
 
+  // Materialize a value on the client like `Compute`, streaming tensors back in
+  // chunks.
+  grpc::Status ComputeStream(
+      grpc::ServerContext* context, const v0::ComputeRequest* request,
+      grpc::ServerWriter<v0::ComputeStreamResponse>* writer) override;
+  // Same as `ComputeStream`, writing the stream to any `writer`.
+  grpc::Status ComputeToStream(
+      grpc::ServerContext* context, const v0::ComputeRequest* request,
+      grpc::ServerWriterInterface<v0::ComputeStreamResponse>* writer);
+
+  // Run an ordered batch of `Create...` operations, which may refer to the
+  // results of earlier operations of the batch. Either all operations succeed,
+  // or none of their results remain embedded.
+  grpc::Status ExecuteBatch(grpc::ServerContext* context,
+                            const v0::ExecuteBatchRequest* request,
+                            v0::ExecuteBatchResponse* response) override;
+
   // Free the resources associated to the embedded values specified.
   grpc::Status Dispose(grpc::ServerContext* context,
                        const v0::DisposeRequest* request,
@@ -118,6 +224,27 @@ class ExecutorService : public v0::ExecutorGroup::Service {
                                const v0::DisposeExecutorRequest* request,
                                v0::DisposeExecutorResponse* response) override;
 
+  // Return a value of the value cache to a peer service, waiting for it if
+  // this service is receiving it.
+  grpc::Status GetCachedValue(grpc::ServerContext* context,
+                              const v0::GetCachedValueRequest* request,
+                              v0::GetCachedValueResponse* response) override;
+  // Same as `GetCachedValue`, for a call whose deadline is `call_deadline`.
+  grpc::Status GetCachedValueUntil(absl::Time call_deadline,
+                                   const v0::GetCachedValueRequest* request,
+                                   v0::GetCachedValueResponse* response);
+
+  // Return the locality keys the service was configured with.
+  grpc::Status GetLocalityKeys(grpc::ServerContext* context,
+                               const v0::GetLocalityKeysRequest* request,
+                               v0::GetLocalityKeysResponse* response) override;
+
+  // Compute a value and write it to the snapshot directory of the service,
+  // returning its content hash. Blocking, like `Compute`.
+  grpc::Status SnapshotValue(grpc::ServerContext* context,
+                             const v0::SnapshotValueRequest* request,
+                             v0::SnapshotValueResponse* response) override;
+
  private:
   // A cheaply-copyable struct used to track executors and pass handles to them
   // between the executor resolver and the service.
@@ -143,6 +270,18 @@ class ExecutorService : public v0::ExecutorGroup::Service {
   grpc::Status HandleNotOK(const absl::Status& status,
                            const v0::ExecutorId& executor_id);
 
+  // Returns the value cached under `content_hash` by this service, or else
+  // by one of its peers, or nullptr if none has it. Unless cached, the value
+  // is pending meanwhile, and remains so if it is not found, since the client
+  // then sends it.
+  std::shared_ptr<const v0::Value> LookupOrFetchValue(
+      const std::string& content_hash);
+
+  // Returns the value snapshotted under `content_hash`, caching it if the
+  // value cache is enabled, or nullptr if there is none.
+  std::shared_ptr<const v0::Value> ReadSnapshot(
+      const std::string& content_hash);
+
   using ExecutorId = std::string;
 
   struct ExecutorRequirements {
@@ -182,13 +321,14 @@ class ExecutorService : public v0::ExecutorGroup::Service {
     // executor associated to this ID.
     absl::Status DisposeExecutor(const ExecutorId&);
 
-    // Returns an executor for the given ID, or an absl Status if no executor
-    // can be found. Returns FailedPrecondition if the executor does not exist
-    // (since existence of the executor is a precondition for returning it), and
-    // InternalError if an implementation error has caused the maps held
-    // internally to be out of sync. This error indicates a bug in the
-    // implementation.
-    absl::StatusOr<ExecutorEntry> ExecutorForId(const ExecutorId&);
+    // Returns the executor for the given ID, or FailedPrecondition if the
+    // executor does not exist (since existence of the executor is a
+    // precondition for returning it).
+    //
+    // This is called by every request, and only takes a shared lock, so that
+    // concurrent requests do not wait on each other.
+    absl::StatusOr<std::shared_ptr<Executor>> ExecutorForId(
+        std::string_view executor_id) ABSL_LOCKS_EXCLUDED(executors_mutex_);
     // Returns an executor ID with the specified requirements. May construct a
     // new executor; only returns a no-OK status if this construction fails or
     // another internal error occurs.
@@ -205,10 +345,14 @@ class ExecutorService : public v0::ExecutorGroup::Service {
     absl::flat_hash_map<std::string, ExecutorEntry> executors_
         ABSL_GUARDED_BY(executors_mutex_);
     // This map is keyed by the executor ids returned to clients, and used to
-    // resolve executor IDs to concrete executor instances via the executors_
-    // map. Every entry in this map must correspond to a cardinalities key for
-    // an executor in the executors_ map.
-    absl::flat_hash_map<std::string, std::string> keys_to_cardinalities_
+    // resolve executor IDs to concrete executor instances in a single lookup.
+    // Every entry in this map must correspond to a cardinalities key for an
+    // executor in the executors_ map, and hold the same executor.
+    struct ExecutorKeyEntry {
+      std::string cardinalities;
+      std::shared_ptr<Executor> executor;
+    };
+    absl::flat_hash_map<std::string, ExecutorKeyEntry> keys_to_cardinalities_
         ABSL_GUARDED_BY(executors_mutex_);
 
     // Provide a unique identifier to each service, as well as each executor
@@ -222,6 +366,16 @@ class ExecutorService : public v0::ExecutorGroup::Service {
     int executor_index_ ABSL_GUARDED_BY(executors_mutex_) = 0;
   };
 
+  const ExecutorServiceOptions options_;
+  // The lanes through which bulk and control requests are admitted.
+  FairRequestQueue bulk_requests_;
+  FairRequestQueue control_requests_;
+  // Null unless the value cache is enabled.
+  const std::unique_ptr<ValueCache> value_cache_;
+  // Null unless snapshots are enabled.
+  const std::unique_ptr<ValueSnapshotStore> value_snapshots_;
+  std::vector<std::unique_ptr<v0::ExecutorGroup::StubInterface>>
+      value_cache_peers_;
   ExecutorResolver executor_resolver_;
 };
 }  // namespace tensorflow_federated
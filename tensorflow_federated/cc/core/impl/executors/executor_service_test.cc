@@ -15,11 +15,14 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/executor_service.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -27,13 +30,20 @@ limitations under the License
 #include "googletest/include/gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "include/grpcpp/grpcpp.h"
 #include "include/grpcpp/support/status.h"
+#include "include/grpcpp/support/sync_stream.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_grpc.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
 #include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
 #include "tensorflow_federated/cc/testing/protobuf_matchers.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
@@ -55,6 +65,53 @@ v0::GetExecutorRequest CreateGetExecutorRequest(int client_cardinalities) {
 
 absl::Status ReturnOk() { return absl::OkStatus(); }
 
+// Replays `requests` as the messages of a client stream.
+class FakeServerReader
+    : public grpc::ServerReaderInterface<v0::CreateValueStreamRequest> {
+ public:
+  explicit FakeServerReader(std::vector<v0::CreateValueStreamRequest> requests)
+      : requests_(std::move(requests)) {}
+
+  void SendInitialMetadata() override {}
+  bool NextMessageSize(uint32_t* sz) override {
+    if (next_ == requests_.size()) {
+      return false;
+    }
+    *sz = requests_[next_].ByteSizeLong();
+    return true;
+  }
+  bool Read(v0::CreateValueStreamRequest* msg) override {
+    if (next_ == requests_.size()) {
+      return false;
+    }
+    *msg = requests_[next_++];
+    return true;
+  }
+
+ private:
+  std::vector<v0::CreateValueStreamRequest> requests_;
+  size_t next_ = 0;
+};
+
+// Records the messages written to a server stream.
+class FakeServerWriter
+    : public grpc::ServerWriterInterface<v0::ComputeStreamResponse> {
+ public:
+  void SendInitialMetadata() override {}
+  bool Write(const v0::ComputeStreamResponse& msg,
+             grpc::WriteOptions options) override {
+    responses_.push_back(msg);
+    return true;
+  }
+
+  const std::vector<v0::ComputeStreamResponse>& responses() const {
+    return responses_;
+  }
+
+ private:
+  std::vector<v0::ComputeStreamResponse> responses_;
+};
+
 TEST(ExecutorServiceFailureTest, CreateValueWithoutExecutorFails) {
   auto executor_ptr = std::make_shared<::testing::StrictMock<MockExecutor>>();
   ExecutorService executor_service_(
@@ -73,6 +130,33 @@ TEST(ExecutorServiceFailureTest, CreateValueWithoutExecutorFails) {
                            "No executor found for ID: ''."));
 }
 
+TEST(ExecutorServiceWarmUpTest, GetExecutorReusesWarmedUpExecutor) {
+  auto executor_ptr = std::make_shared<::testing::StrictMock<MockExecutor>>();
+  int num_executors = 0;
+  ExecutorService executor_service([&](const CardinalityMap& cardinalities)
+                                       -> std::shared_ptr<Executor> {
+    ++num_executors;
+    return executor_ptr;
+  });
+  TFF_ASSERT_OK(executor_service.WarmUp({{kClients, 1}}));
+  EXPECT_EQ(num_executors, 1);
+
+  // The executor outlives the handles of clients.
+  for (int i = 0; i < 2; ++i) {
+    grpc::ServerContext server_context;
+    const v0::GetExecutorRequest request_pb = CreateGetExecutorRequest(1);
+    v0::GetExecutorResponse response_pb;
+    TFF_ASSERT_OK(grpc_to_absl(executor_service.GetExecutor(
+        &server_context, &request_pb, &response_pb)));
+    v0::DisposeExecutorRequest dispose_request_pb;
+    *dispose_request_pb.mutable_executor() = response_pb.executor();
+    v0::DisposeExecutorResponse dispose_response_pb;
+    TFF_ASSERT_OK(grpc_to_absl(executor_service.DisposeExecutor(
+        &server_context, &dispose_request_pb, &dispose_response_pb)));
+  }
+  EXPECT_EQ(num_executors, 1);
+}
+
 class ExecutorServiceTest : public ::testing::Test {
  public:
   ExecutorServiceTest()
@@ -85,6 +169,23 @@ class ExecutorServiceTest : public ::testing::Test {
     return OwnedValueId(executor_ptr_, id);
   }
 
+  // Returns another service, with `options`, over the same mock executor.
+  ExecutorService CreateService(ExecutorServiceOptions options) {
+    return ExecutorService(
+        [this](const CardinalityMap& cardinalities)
+            -> std::shared_ptr<Executor> { return executor_ptr_; },
+        options);
+  }
+
+  absl::StatusOr<v0::ExecutorId> GetExecutor(ExecutorService& service) {
+    const v0::GetExecutorRequest request_pb = CreateGetExecutorRequest(1);
+    v0::GetExecutorResponse response_pb;
+    grpc::ServerContext server_context;
+    TFF_TRY(grpc_to_absl(
+        service.GetExecutor(&server_context, &request_pb, &response_pb)));
+    return response_pb.executor();
+  }
+
  private:
   void SetUp() override {
     const v0::GetExecutorRequest request_pb = CreateGetExecutorRequest(1);
@@ -108,6 +209,26 @@ class ExecutorServiceTest : public ::testing::Test {
     return request_pb;
   }
 
+  // Splits the tensor content of `value_pb` into a stream of `num_chunks`
+  // chunks, announcing `announced_size` bytes in the header if set.
+  std::vector<v0::CreateValueStreamRequest> CreateValueStreamRequests(
+      const v0::Value& value_pb, int num_chunks,
+      std::optional<uint64_t> announced_size = std::nullopt) {
+    const std::string& content = value_pb.tensor().value();
+    std::vector<v0::CreateValueStreamRequest> requests(num_chunks + 1);
+    v0::CreateValueStreamRequest::Header* header =
+        requests[0].mutable_header();
+    *header->mutable_executor() = executor_pb_;
+    header->set_type_url(value_pb.tensor().type_url());
+    header->set_size(announced_size.value_or(content.size()));
+    const size_t chunk_size = (content.size() + num_chunks - 1) / num_chunks;
+    for (int i = 0; i < num_chunks; ++i) {
+      requests[i + 1].set_chunk(content.substr(
+          std::min(i * chunk_size, content.size()), chunk_size));
+    }
+    return requests;
+  }
+
   v0::DisposeRequest DisposeRequestForIds(absl::Span<const std::string> ids) {
     v0::DisposeRequest request_pb;
     *request_pb.mutable_executor() = executor_pb_;
@@ -311,6 +432,32 @@ TEST_F(ExecutorServiceTest, ComputeFailedPreconditionDestroysExecutor) {
                            "No executor found for ID"));
 }
 
+TEST_F(ExecutorServiceTest, ConcurrentRequestsResolveExecutor) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumRequestsPerThread = 100;
+  EXPECT_CALL(*executor_ptr_, CreateValue(::testing::_))
+      .Times(kNumThreads * kNumRequestsPerThread)
+      .WillRepeatedly([this] { return TestId(0); });
+
+  std::vector<std::thread> threads;
+  threads.reserve(kNumThreads);
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([this] {
+      auto request_pb = CreateValueFloatRequest(2.0f);
+      grpc::ServerContext server_context;
+      for (int j = 0; j < kNumRequestsPerThread; ++j) {
+        v0::CreateValueResponse response_pb;
+        EXPECT_TRUE(executor_service_
+                        .CreateValue(&server_context, &request_pb, &response_pb)
+                        .ok());
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
 TEST_F(ExecutorServiceTest, GetExecutorReturnsCardinalitySpecificIds) {
   grpc::ServerContext context;
 
@@ -709,4 +856,415 @@ TEST_F(ExecutorServiceTest, CreateNamedNonemptyStruct) {
               testing::EqualsProto("value_ref { id: '0' }"));
 }
 
+TEST_F(ExecutorServiceTest, ExecuteBatchRefersToEarlierOperations) {
+  v0::ExecuteBatchRequest batch_request;
+  *batch_request.mutable_executor() = executor_pb_;
+  *batch_request.add_operation()->mutable_create_value()->mutable_value() =
+      testing::TensorV(1.0f);
+  v0::ExecuteBatchRequest::CreateStruct* create_struct =
+      batch_request.add_operation()->mutable_create_struct();
+  create_struct->add_element()->mutable_value_ref()->set_operation_index(0);
+  create_struct->add_element()
+      ->mutable_value_ref()
+      ->mutable_value_ref()
+      ->set_id("5");
+  v0::ExecuteBatchRequest::CreateCall* create_call =
+      batch_request.add_operation()->mutable_create_call();
+  create_call->mutable_function_ref()->mutable_value_ref()->set_id("6");
+  create_call->mutable_argument_ref()->set_operation_index(1);
+  v0::ExecuteBatchRequest::CreateSelection* create_selection =
+      batch_request.add_operation()->mutable_create_selection();
+  create_selection->mutable_source_ref()->set_operation_index(2);
+  create_selection->set_index(1);
+  v0::ExecuteBatchResponse batch_response_pb;
+  grpc::ServerContext server_context;
+
+  ::testing::InSequence seq;
+  EXPECT_CALL(*executor_ptr_, CreateValue(::testing::_)).WillOnce([this] {
+    return TestId(0);
+  });
+  EXPECT_CALL(*executor_ptr_,
+              CreateStruct(::testing::Eq(std::vector<ValueId>{0, 5})))
+      .WillOnce([this] { return TestId(1); });
+  EXPECT_CALL(*executor_ptr_, CreateCall(6, ::testing::Optional(1)))
+      .WillOnce([this] { return TestId(2); });
+  EXPECT_CALL(*executor_ptr_, CreateSelection(2, 1)).WillOnce([this] {
+    return TestId(3);
+  });
+
+  TFF_ASSERT_OK(grpc_to_absl(executor_service_.ExecuteBatch(
+      &server_context, &batch_request, &batch_response_pb)));
+
+  EXPECT_THAT(batch_response_pb, testing::EqualsProto(R"pb(
+                value_ref { id: '0' }
+                value_ref { id: '1' }
+                value_ref { id: '2' }
+                value_ref { id: '3' }
+              )pb"));
+}
+
+TEST_F(ExecutorServiceTest, ExecuteBatchFailureDisposesOfEarlierResults) {
+  v0::ExecuteBatchRequest batch_request;
+  *batch_request.mutable_executor() = executor_pb_;
+  *batch_request.add_operation()->mutable_create_value()->mutable_value() =
+      testing::TensorV(1.0f);
+  batch_request.add_operation()
+      ->mutable_create_call()
+      ->mutable_function_ref()
+      ->set_operation_index(0);
+  v0::ExecuteBatchResponse batch_response_pb;
+  grpc::ServerContext server_context;
+
+  EXPECT_CALL(*executor_ptr_, CreateValue(::testing::_)).WillOnce([this] {
+    return TestId(0);
+  });
+  EXPECT_CALL(*executor_ptr_, CreateCall(0, ::testing::Eq(std::nullopt)))
+      .WillOnce([] { return absl::InvalidArgumentError("Not a function"); });
+  EXPECT_CALL(*executor_ptr_, Dispose(0)).WillOnce(ReturnOk);
+
+  ASSERT_THAT(executor_service_.ExecuteBatch(&server_context, &batch_request,
+                                             &batch_response_pb),
+              GrpcStatusIs(grpc::StatusCode::INVALID_ARGUMENT,
+                           "Not a function"));
+  EXPECT_EQ(batch_response_pb.value_ref_size(), 0);
+}
+
+TEST_F(ExecutorServiceTest, ExecuteBatchRejectsLaterOperationIndex) {
+  v0::ExecuteBatchRequest batch_request;
+  *batch_request.mutable_executor() = executor_pb_;
+  v0::ExecuteBatchRequest::CreateSelection* create_selection =
+      batch_request.add_operation()->mutable_create_selection();
+  create_selection->mutable_source_ref()->set_operation_index(0);
+  v0::ExecuteBatchResponse batch_response_pb;
+  grpc::ServerContext server_context;
+
+  ASSERT_THAT(executor_service_.ExecuteBatch(&server_context, &batch_request,
+                                             &batch_response_pb),
+              GrpcStatusIs(grpc::StatusCode::INVALID_ARGUMENT,
+                           "Expected a reference to an earlier operation"));
+}
+
+TEST_F(ExecutorServiceTest, CreateValueStreamReassemblesChunks) {
+  v0::Value value_pb = testing::TensorV(2.0f);
+  FakeServerReader reader(CreateValueStreamRequests(value_pb, 3));
+  v0::CreateValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  EXPECT_CALL(*executor_ptr_, CreateValue(testing::EqualsProto(value_pb)))
+      .WillOnce([this] { return TestId(0); });
+
+  TFF_ASSERT_OK(grpc_to_absl(executor_service_.CreateValueFromStream(
+      &server_context, &reader, &response_pb)));
+  EXPECT_THAT(response_pb, testing::EqualsProto("value_ref { id: '0' }"));
+}
+
+TEST_F(ExecutorServiceTest, CreateValueStreamWithoutHeaderFails) {
+  std::vector<v0::CreateValueStreamRequest> requests =
+      CreateValueStreamRequests(testing::TensorV(2.0f), 1);
+  requests.erase(requests.begin());
+  FakeServerReader reader(std::move(requests));
+  v0::CreateValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  ASSERT_THAT(executor_service_.CreateValueFromStream(&server_context, &reader,
+                                                      &response_pb),
+              GrpcStatusIs(grpc::StatusCode::INVALID_ARGUMENT,
+                           "Expected the stream to start with a header."));
+}
+
+TEST_F(ExecutorServiceTest, CreateValueStreamWithMissingChunksFails) {
+  v0::Value value_pb = testing::TensorV(2.0f);
+  FakeServerReader reader(CreateValueStreamRequests(
+      value_pb, 2, value_pb.tensor().value().size() + 1));
+  v0::CreateValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  ASSERT_THAT(executor_service_.CreateValueFromStream(&server_context, &reader,
+                                                      &response_pb),
+              GrpcStatusIs(grpc::StatusCode::INVALID_ARGUMENT, "Received"));
+}
+
+TEST_F(ExecutorServiceTest, ComputeStreamSendsSmallValueInOneMessage) {
+  v0::Value expected_value = testing::TensorV(3.0f);
+  v0::ComputeRequest compute_request_pb = ComputeRequestForId("0");
+  FakeServerWriter writer;
+  grpc::ServerContext server_context;
+
+  EXPECT_CALL(*executor_ptr_, Materialize(::testing::_, ::testing::_))
+      .WillOnce([&expected_value](ValueId id, v0::Value* val) {
+        *val = expected_value;
+        return absl::OkStatus();
+      });
+
+  TFF_ASSERT_OK(grpc_to_absl(executor_service_.ComputeToStream(
+      &server_context, &compute_request_pb, &writer)));
+  ASSERT_EQ(writer.responses().size(), 1);
+  EXPECT_THAT(writer.responses()[0].value(),
+              testing::EqualsProto(expected_value));
+}
+
+TEST_F(ExecutorServiceTest, ComputeStreamSendsLargeTensorInChunks) {
+  constexpr size_t kChunkSize = 4;
+  ExecutorServiceOptions options;
+  options.compute_chunk_size = kChunkSize;
+  ExecutorService chunking_service = CreateService(options);
+  v0::ExecutorId executor_pb = TFF_ASSERT_OK(GetExecutor(chunking_service));
+  v0::Value expected_value = testing::TensorV(3.0f);
+  const std::string& content = expected_value.tensor().value();
+  ASSERT_GT(content.size(), kChunkSize);
+  v0::ComputeRequest compute_request_pb;
+  *compute_request_pb.mutable_executor() = executor_pb;
+  compute_request_pb.mutable_value_ref()->set_id("0");
+  grpc::ServerContext server_context;
+  FakeServerWriter writer;
+
+  EXPECT_CALL(*executor_ptr_, Materialize(::testing::_, ::testing::_))
+      .WillOnce([&expected_value](ValueId id, v0::Value* val) {
+        *val = expected_value;
+        return absl::OkStatus();
+      });
+
+  TFF_ASSERT_OK(grpc_to_absl(chunking_service.ComputeToStream(
+      &server_context, &compute_request_pb, &writer)));
+  const std::vector<v0::ComputeStreamResponse>& responses = writer.responses();
+  const size_t num_chunks = (content.size() + kChunkSize - 1) / kChunkSize;
+  ASSERT_EQ(responses.size(), 1 + num_chunks);
+  EXPECT_EQ(responses[0].tensor_header().type_url(),
+            expected_value.tensor().type_url());
+  EXPECT_EQ(responses[0].tensor_header().size(), content.size());
+  std::string received_content;
+  for (size_t i = 1; i < responses.size(); ++i) {
+    received_content += responses[i].chunk();
+  }
+  EXPECT_EQ(received_content, content);
+}
+
+TEST_F(ExecutorServiceTest, CreateValueFromContentHashWithoutCacheFails) {
+  v0::CreateValueRequest request_pb;
+  *request_pb.mutable_executor() = executor_pb_;
+  request_pb.set_content_hash(ValueContentHash(testing::TensorV(2.0f)));
+  v0::CreateValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  EXPECT_THAT(
+      executor_service_.CreateValue(&server_context, &request_pb, &response_pb),
+      GrpcStatusIs(grpc::StatusCode::NOT_FOUND));
+}
+
+TEST_F(ExecutorServiceTest, CreateValueFromContentHashUsesCachedValue) {
+  ExecutorServiceOptions options;
+  options.value_cache_capacity_bytes = 1 << 20;
+  ExecutorService caching_service = CreateService(options);
+  v0::ExecutorId executor_pb = TFF_ASSERT_OK(GetExecutor(caching_service));
+  const v0::Value value_pb = testing::TensorV(2.0f);
+  v0::CreateValueRequest hash_request_pb;
+  *hash_request_pb.mutable_executor() = executor_pb;
+  hash_request_pb.set_content_hash(ValueContentHash(value_pb));
+  v0::CreateValueRequest value_request_pb = hash_request_pb;
+  *value_request_pb.mutable_value() = value_pb;
+  v0::CreateValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  EXPECT_CALL(*executor_ptr_, CreateValue(testing::EqualsProto(value_pb)))
+      .WillOnce([this] { return TestId(0); })
+      .WillOnce([this] { return TestId(1); });
+
+  // The first upload only sends the hash, which misses the cache.
+  EXPECT_THAT(caching_service.CreateValue(&server_context, &hash_request_pb,
+                                          &response_pb),
+              GrpcStatusIs(grpc::StatusCode::NOT_FOUND));
+  TFF_ASSERT_OK(grpc_to_absl(caching_service.CreateValue(
+      &server_context, &value_request_pb, &response_pb)));
+  EXPECT_THAT(response_pb, testing::EqualsProto("value_ref { id: '0' }"));
+  // Later uploads of the same value only send its hash.
+  TFF_ASSERT_OK(grpc_to_absl(caching_service.CreateValue(
+      &server_context, &hash_request_pb, &response_pb)));
+  EXPECT_THAT(response_pb, testing::EqualsProto("value_ref { id: '1' }"));
+}
+
+TEST_F(ExecutorServiceTest, CreateValueFromContentHashFetchesValueFromPeer) {
+  const v0::Value value_pb = testing::TensorV(2.0f);
+  MockGrpcExecutorServer peer;
+  ExecutorServiceOptions options;
+  options.value_cache_capacity_bytes = 1 << 20;
+  options.value_cache_peers.push_back(peer.NewChannel());
+  ExecutorService caching_service = CreateService(options);
+  v0::ExecutorId executor_pb = TFF_ASSERT_OK(GetExecutor(caching_service));
+  v0::CreateValueRequest hash_request_pb;
+  *hash_request_pb.mutable_executor() = executor_pb;
+  hash_request_pb.set_content_hash(ValueContentHash(value_pb));
+  v0::CreateValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  EXPECT_CALL(*peer.service(), GetCachedValue(::testing::_, ::testing::_,
+                                              ::testing::_))
+      .WillOnce([&value_pb](grpc::ServerContext*,
+                            const v0::GetCachedValueRequest* request,
+                            v0::GetCachedValueResponse* response) {
+        EXPECT_EQ(request->content_hash(), ValueContentHash(value_pb));
+        *response->mutable_value() = value_pb;
+        return grpc::Status::OK;
+      });
+  EXPECT_CALL(*executor_ptr_, CreateValue(testing::EqualsProto(value_pb)))
+      .WillOnce([this] { return TestId(0); })
+      .WillOnce([this] { return TestId(1); });
+
+  TFF_ASSERT_OK(grpc_to_absl(caching_service.CreateValue(
+      &server_context, &hash_request_pb, &response_pb)));
+  EXPECT_THAT(response_pb, testing::EqualsProto("value_ref { id: '0' }"));
+  // The fetched value is cached, the peer is only asked once.
+  TFF_ASSERT_OK(grpc_to_absl(caching_service.CreateValue(
+      &server_context, &hash_request_pb, &response_pb)));
+  EXPECT_THAT(response_pb, testing::EqualsProto("value_ref { id: '1' }"));
+}
+
+TEST_F(ExecutorServiceTest, GetCachedValueWaitsForValueSentByClient) {
+  ExecutorServiceOptions options;
+  options.value_cache_capacity_bytes = 1 << 20;
+  ExecutorService caching_service = CreateService(options);
+  v0::ExecutorId executor_pb = TFF_ASSERT_OK(GetExecutor(caching_service));
+  const v0::Value value_pb = testing::TensorV(2.0f);
+  v0::CreateValueRequest hash_request_pb;
+  *hash_request_pb.mutable_executor() = executor_pb;
+  hash_request_pb.set_content_hash(ValueContentHash(value_pb));
+  v0::CreateValueRequest value_request_pb = hash_request_pb;
+  *value_request_pb.mutable_value() = value_pb;
+  v0::GetCachedValueRequest get_request_pb;
+  get_request_pb.set_content_hash(ValueContentHash(value_pb));
+  v0::CreateValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  EXPECT_CALL(*executor_ptr_, CreateValue(testing::EqualsProto(value_pb)))
+      .WillOnce([this] { return TestId(0); });
+
+  // Unknown values are not waited for.
+  v0::GetCachedValueResponse get_response_pb;
+  EXPECT_THAT(caching_service.GetCachedValue(&server_context, &get_request_pb,
+                                             &get_response_pb),
+              GrpcStatusIs(grpc::StatusCode::NOT_FOUND));
+  // Once the hash missed the cache, the client is expected to send the value,
+  // which peers wait for.
+  EXPECT_THAT(caching_service.CreateValue(&server_context, &hash_request_pb,
+                                          &response_pb),
+              GrpcStatusIs(grpc::StatusCode::NOT_FOUND));
+  std::thread client([&caching_service, &value_request_pb] {
+    absl::SleepFor(absl::Milliseconds(10));
+    v0::CreateValueResponse response_pb;
+    grpc::ServerContext server_context;
+    EXPECT_TRUE(caching_service
+                    .CreateValue(&server_context, &value_request_pb,
+                                 &response_pb)
+                    .ok());
+  });
+  grpc::Status get_status = caching_service.GetCachedValue(
+      &server_context, &get_request_pb, &get_response_pb);
+  client.join();
+  TFF_ASSERT_OK(grpc_to_absl(get_status));
+  EXPECT_THAT(get_response_pb.value(), testing::EqualsProto(value_pb));
+}
+
+TEST_F(ExecutorServiceTest, SnapshotValueWithoutDirectoryFails) {
+  v0::SnapshotValueRequest request_pb;
+  *request_pb.mutable_executor() = executor_pb_;
+  request_pb.mutable_value_ref()->mutable_id()->assign("0");
+  v0::SnapshotValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  EXPECT_THAT(executor_service_.SnapshotValue(&server_context, &request_pb,
+                                              &response_pb),
+              GrpcStatusIs(grpc::StatusCode::FAILED_PRECONDITION));
+}
+
+TEST_F(ExecutorServiceTest, CreateValueFromContentHashRestoresSnapshot) {
+  const v0::Value value_pb = testing::TensorV(2.0f);
+  ExecutorServiceOptions options;
+  options.value_snapshot_directory =
+      ::testing::TempDir() + "/executor_service_snapshots";
+  ExecutorService failed_service = CreateService(options);
+  ExecutorService replacement_service = CreateService(options);
+  v0::ExecutorId failed_executor_pb =
+      TFF_ASSERT_OK(GetExecutor(failed_service));
+  v0::ExecutorId replacement_executor_pb =
+      TFF_ASSERT_OK(GetExecutor(replacement_service));
+  v0::SnapshotValueRequest snapshot_request_pb;
+  *snapshot_request_pb.mutable_executor() = failed_executor_pb;
+  snapshot_request_pb.mutable_value_ref()->mutable_id()->assign("0");
+  v0::SnapshotValueResponse snapshot_response_pb;
+  v0::CreateValueRequest hash_request_pb;
+  *hash_request_pb.mutable_executor() = replacement_executor_pb;
+  hash_request_pb.set_content_hash(ValueContentHash(value_pb));
+  v0::CreateValueResponse response_pb;
+  grpc::ServerContext server_context;
+
+  EXPECT_CALL(*executor_ptr_, Materialize(0, ::testing::_))
+      .WillOnce([&value_pb](ValueId id, v0::Value* val) {
+        *val = value_pb;
+        return absl::OkStatus();
+      });
+  EXPECT_CALL(*executor_ptr_, CreateValue(testing::EqualsProto(value_pb)))
+      .WillOnce([this] { return TestId(1); });
+
+  TFF_ASSERT_OK(grpc_to_absl(failed_service.SnapshotValue(
+      &server_context, &snapshot_request_pb, &snapshot_response_pb)));
+  EXPECT_EQ(snapshot_response_pb.content_hash(), ValueContentHash(value_pb));
+  // The replacement service reads the value from the snapshots, without the
+  // value cache or the client sending it.
+  TFF_ASSERT_OK(grpc_to_absl(replacement_service.CreateValue(
+      &server_context, &hash_request_pb, &response_pb)));
+  EXPECT_THAT(response_pb, testing::EqualsProto("value_ref { id: '1' }"));
+}
+
+TEST_F(ExecutorServiceTest, ControlRequestsAreNotHeldUpByBulkRequests) {
+  ExecutorServiceOptions options;
+  options.max_concurrent_bulk_requests = 1;
+  options.max_concurrent_control_requests = 1;
+  ExecutorService lane_service = CreateService(options);
+  v0::ExecutorId executor_pb = TFF_ASSERT_OK(GetExecutor(lane_service));
+  absl::Notification computing;
+  absl::Notification finish_compute;
+  EXPECT_CALL(*executor_ptr_, Materialize(::testing::_, ::testing::_))
+      .WillOnce([&](ValueId id, v0::Value* val) {
+        computing.Notify();
+        finish_compute.WaitForNotification();
+        return absl::OkStatus();
+      });
+  EXPECT_CALL(*executor_ptr_, CreateCall(0, ::testing::Eq(std::nullopt)))
+      .WillOnce([this] { return TestId(1); });
+
+  // The compute request holds the only slot of the bulk lane.
+  v0::ComputeRequest compute_request_pb = ComputeRequestForId("0");
+  *compute_request_pb.mutable_executor() = executor_pb;
+  std::thread compute([&] {
+    v0::ComputeResponse compute_response_pb;
+    grpc::ServerContext server_context;
+    TFF_EXPECT_OK(grpc_to_absl(lane_service.Compute(
+        &server_context, &compute_request_pb, &compute_response_pb)));
+  });
+  computing.WaitForNotification();
+
+  v0::CreateCallRequest call_request =
+      CreateCallRequestForIds("0", std::nullopt);
+  *call_request.mutable_executor() = executor_pb;
+  v0::CreateCallResponse create_call_response_pb;
+  grpc::ServerContext server_context;
+  TFF_EXPECT_OK(grpc_to_absl(lane_service.CreateCall(
+      &server_context, &call_request, &create_call_response_pb)));
+  finish_compute.Notify();
+  compute.join();
+}
+
+TEST_F(ExecutorServiceTest, GetLocalityKeysReturnsConfiguredKeys) {
+  ExecutorServiceOptions options;
+  options.locality_keys = {"gs://a/", "gs://b/0"};
+  ExecutorService local_service = CreateService(options);
+  v0::GetLocalityKeysRequest request_pb;
+  v0::GetLocalityKeysResponse response_pb;
+  grpc::ServerContext server_context;
+  TFF_ASSERT_OK(grpc_to_absl(local_service.GetLocalityKeys(
+      &server_context, &request_pb, &response_pb)));
+  EXPECT_THAT(response_pb, testing::EqualsProto(
+                               "locality_keys: 'gs://a/' "
+                               "locality_keys: 'gs://b/0'"));
+}
+
 }  // namespace tensorflow_federated
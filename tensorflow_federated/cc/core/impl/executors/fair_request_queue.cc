@@ -0,0 +1,94 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/fair_request_queue.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+
+bool FairRequestQueue::Acquire(std::string_view tenant, absl::Time deadline) {
+  absl::MutexLock lock(&mutex_);
+  if (max_concurrency_ <= 0 ||
+      (round_robin_.empty() && in_flight_ < max_concurrency_)) {
+    ++in_flight_;
+    return true;
+  }
+  Waiter waiter;
+  std::string tenant_key(tenant);
+  std::deque<Waiter*>& tenant_waiters = waiters_[tenant_key];
+  if (tenant_waiters.empty()) {
+    round_robin_.push_back(tenant_key);
+  }
+  tenant_waiters.push_back(&waiter);
+  ++num_waiting_;
+  if (!mutex_.AwaitWithDeadline(absl::Condition(&waiter.admitted), deadline)) {
+    RemoveWaiter(tenant_key, &waiter);
+    --num_waiting_;
+    return false;
+  }
+  return true;
+}
+
+void FairRequestQueue::Release() {
+  absl::MutexLock lock(&mutex_);
+  --in_flight_;
+  AdmitWaiting();
+}
+
+int64_t FairRequestQueue::num_waiting() const {
+  absl::MutexLock lock(&mutex_);
+  return num_waiting_;
+}
+
+void FairRequestQueue::AdmitWaiting() {
+  while (in_flight_ < max_concurrency_ && !round_robin_.empty()) {
+    std::string tenant = std::move(round_robin_.front());
+    round_robin_.pop_front();
+    auto iter = waiters_.find(tenant);
+    Waiter* waiter = iter->second.front();
+    iter->second.pop_front();
+    if (iter->second.empty()) {
+      waiters_.erase(iter);
+    } else {
+      round_robin_.push_back(std::move(tenant));
+    }
+    waiter->admitted = true;
+    --num_waiting_;
+    ++in_flight_;
+  }
+}
+
+void FairRequestQueue::RemoveWaiter(const std::string& tenant, Waiter* waiter) {
+  auto iter = waiters_.find(tenant);
+  std::deque<Waiter*>& tenant_waiters = iter->second;
+  tenant_waiters.erase(
+      std::find(tenant_waiters.begin(), tenant_waiters.end(), waiter));
+  if (tenant_waiters.empty()) {
+    waiters_.erase(iter);
+    round_robin_.erase(
+        std::find(round_robin_.begin(), round_robin_.end(), tenant));
+  }
+}
+
+}  // namespace tensorflow_federated
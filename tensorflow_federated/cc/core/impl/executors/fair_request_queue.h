@@ -0,0 +1,114 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_FAIR_REQUEST_QUEUE_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_FAIR_REQUEST_QUEUE_H_
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+
+// Bounds the number of concurrent requests of a lane, e.g. the requests of a
+// service which transfer values, and shares it fairly between the tenants
+// issuing them, e.g. the executors of the service: once the limit is reached,
+// waiting requests are admitted round robin across tenants, in order within
+// each tenant, so that a tenant issuing many requests delays the requests of
+// the others by at most one request each.
+//
+// This class is thread safe.
+class FairRequestQueue {
+ public:
+  // Creates a queue admitting at most `max_concurrency` concurrent requests.
+  // A non-positive `max_concurrency` admits all requests at once.
+  explicit FairRequestQueue(int32_t max_concurrency)
+      : max_concurrency_(max_concurrency) {}
+
+  FairRequestQueue(const FairRequestQueue&) = delete;
+  FairRequestQueue& operator=(const FairRequestQueue&) = delete;
+
+  // Blocks until a request of `tenant` is admitted, and returns true, or until
+  // `deadline`, and returns false. Admitted requests must be ended with
+  // `Release`.
+  bool Acquire(std::string_view tenant,
+               absl::Time deadline = absl::InfiniteFuture())
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Ends a request admitted by `Acquire`, and admits the next waiting one.
+  void Release() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the number of requests waiting to be admitted.
+  int64_t num_waiting() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Waiter {
+    bool admitted = false;
+  };
+
+  // Admits waiting requests while there is room for them.
+  void AdmitWaiting() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Removes `waiter`, which timed out, from the queue of `tenant`.
+  void RemoveWaiter(const std::string& tenant, Waiter* waiter)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int32_t max_concurrency_;
+  mutable absl::Mutex mutex_;
+  int32_t in_flight_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t num_waiting_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The waiting requests of each tenant, in order of arrival. Only tenants
+  // with waiting requests have an entry.
+  absl::flat_hash_map<std::string, std::deque<Waiter*>> waiters_
+      ABSL_GUARDED_BY(mutex_);
+  // The tenants with waiting requests, in the order in which they are next
+  // admitted one request each.
+  std::deque<std::string> round_robin_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Admits a request of `tenant` in `queue`, if not null, for the lifetime of
+// the permit.
+class FairRequestPermit {
+ public:
+  FairRequestPermit(FairRequestQueue* queue, std::string_view tenant,
+                    absl::Time deadline = absl::InfiniteFuture())
+      : queue_(queue),
+        admitted_(queue == nullptr || queue->Acquire(tenant, deadline)) {}
+  ~FairRequestPermit() {
+    if (queue_ != nullptr && admitted_) {
+      queue_->Release();
+    }
+  }
+
+  FairRequestPermit(const FairRequestPermit&) = delete;
+  FairRequestPermit& operator=(const FairRequestPermit&) = delete;
+
+  // Whether the request was admitted before its deadline.
+  bool admitted() const { return admitted_; }
+
+ private:
+  FairRequestQueue* const queue_;
+  const bool admitted_;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_FAIR_REQUEST_QUEUE_H_
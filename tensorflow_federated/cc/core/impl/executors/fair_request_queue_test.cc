@@ -0,0 +1,109 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/fair_request_queue.h"
+
+#include <cstdint>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::testing::ElementsAre;
+
+// Waits until `queue` has `num_waiting` requests waiting.
+void AwaitWaiting(const FairRequestQueue& queue, int64_t num_waiting) {
+  while (queue.num_waiting() != num_waiting) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+}
+
+TEST(FairRequestQueueTest, BlocksRequestsBeyondLimit) {
+  FairRequestQueue queue(/*max_concurrency=*/1);
+  ASSERT_TRUE(queue.Acquire("a"));
+  absl::Notification admitted;
+  std::thread waiter([&queue, &admitted] {
+    queue.Acquire("b");
+    admitted.Notify();
+  });
+  EXPECT_FALSE(admitted.WaitForNotificationWithTimeout(absl::Milliseconds(50)));
+  queue.Release();
+  admitted.WaitForNotification();
+  waiter.join();
+  queue.Release();
+}
+
+TEST(FairRequestQueueTest, AdmitsAllRequestsWithoutLimit) {
+  FairRequestQueue queue(/*max_concurrency=*/0);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(queue.Acquire("a"));
+  }
+  for (int i = 0; i < 100; ++i) {
+    queue.Release();
+  }
+}
+
+TEST(FairRequestQueueTest, AdmitsTenantsRoundRobin) {
+  FairRequestQueue queue(/*max_concurrency=*/1);
+  ASSERT_TRUE(queue.Acquire("busy"));
+  absl::Mutex mutex;
+  std::vector<std::string> admitted;
+  std::vector<std::thread> waiters;
+  // The busy tenant queues three requests before the quiet one queues its
+  // single request.
+  for (const char* tenant : {"busy", "busy", "busy", "quiet"}) {
+    int64_t num_waiting = waiters.size() + 1;
+    waiters.emplace_back([&, tenant] {
+      queue.Acquire(tenant);
+      {
+        absl::MutexLock lock(&mutex);
+        admitted.push_back(tenant);
+      }
+      queue.Release();
+    });
+    AwaitWaiting(queue, num_waiting);
+  }
+  queue.Release();
+  for (std::thread& waiter : waiters) {
+    waiter.join();
+  }
+  EXPECT_THAT(admitted, ElementsAre("busy", "quiet", "busy", "busy"));
+}
+
+TEST(FairRequestQueueTest, GivesUpAtDeadline) {
+  FairRequestQueue queue(/*max_concurrency=*/1);
+  ASSERT_TRUE(queue.Acquire("a"));
+  EXPECT_FALSE(queue.Acquire("b", absl::Now() + absl::Milliseconds(10)));
+  EXPECT_EQ(queue.num_waiting(), 0);
+  queue.Release();
+  {
+    FairRequestPermit permit(&queue, "b");
+    EXPECT_TRUE(permit.admitted());
+  }
+  FairRequestPermit permit(&queue, "c");
+  EXPECT_TRUE(permit.admitted());
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -15,8 +15,10 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/federating_executor.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -37,7 +39,9 @@ limitations under the License
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/federated_intrinsics.h"
+#include "tensorflow_federated/cc/core/impl/executors/stacked_values.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
@@ -173,11 +177,27 @@ using Unplaced = std::shared_ptr<UnplacedInner>;
 using Server = std::shared_ptr<OwnedValueId>;
 using Clients = std::shared_ptr<std::vector<std::shared_ptr<OwnedValueId>>>;
 using Structure = std::shared_ptr<std::vector<ExecutorValue>>;
-using ValueVariant =
-    std::variant<Unplaced, Server, Clients, Structure, enum FederatedIntrinsic>;
 
+// Inner (behind shared_ptr) representation of a client-placed value whose
+// values of all clients are stacked along a leading dimension in a single
+// value of the client child. The values of the individual clients are only
+// created in the client child, by unstacking the value, once they are needed.
+struct StackedClientsInner {
+  explicit StackedClientsInner(std::shared_ptr<OwnedValueId> stacked)
+      : stacked(std::move(stacked)) {}
+
+  const std::shared_ptr<OwnedValueId> stacked;
+  absl::Mutex mutex;
+  std::optional<absl::StatusOr<Clients>> unstacked ABSL_GUARDED_BY(mutex);
+};
+
+using StackedClients = std::shared_ptr<StackedClientsInner>;
+using ValueVariant = std::variant<Unplaced, Server, Clients, StackedClients,
+                                  Structure, enum FederatedIntrinsic>;
+
+// Clients values dispose of the values of their clients in a single batch.
 inline Clients NewClients(uint32_t num_clients) {
-  auto v = std::make_shared<std::vector<std::shared_ptr<OwnedValueId>>>();
+  auto v = NewBatchReleasedValueIds();
   v->reserve(num_clients);
   return v;
 }
@@ -209,8 +229,21 @@ class ExecutorValue {
   inline static ExecutorValue CreateClientsPlaced(
       std::vector<std::shared_ptr<OwnedValueId>>&& client_values) {
     return CreateClientsPlaced(
-        std::make_shared<std::vector<std::shared_ptr<OwnedValueId>>>(
-            std::move(client_values)));
+        NewBatchReleasedValueIds(std::move(client_values)));
+  }
+  inline static ExecutorValue CreateStackedClientsPlaced(
+      std::shared_ptr<OwnedValueId> stacked) {
+    return ExecutorValue(
+        std::make_shared<StackedClientsInner>(std::move(stacked)),
+        ValueType::CLIENTS);
+  }
+  // Whether a client-placed value is held by `stacked_clients()` rather than
+  // by `clients()`.
+  inline bool is_stacked() const {
+    return std::holds_alternative<StackedClients>(value_);
+  }
+  inline const StackedClients& stacked_clients() const {
+    return std::get<StackedClients>(value_);
   }
   inline const Structure& structure() const {
     return std::get<::tensorflow_federated::Structure>(value_);
@@ -266,10 +299,24 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
  public:
   explicit FederatingExecutor(std::shared_ptr<Executor> server_child,
                               std::shared_ptr<Executor> client_child,
-                              uint32_t num_clients)
+                              uint32_t num_clients, uint32_t aggregate_fan_in,
+                              int32_t max_concurrent_client_calls,
+                              ThreadPoolPolicy thread_pool_policy,
+                              std::shared_ptr<ExecutorRuntime> runtime,
+                              bool stack_client_values)
       : server_child_(server_child),
         client_child_(client_child),
-        num_clients_(num_clients) {}
+        num_clients_(num_clients),
+        aggregate_fan_in_(aggregate_fan_in),
+        stack_client_values_(stack_client_values) {
+    if (max_concurrent_client_calls > 1 && runtime != nullptr) {
+      client_dispatch_runtime_ = std::move(runtime);
+    } else if (max_concurrent_client_calls > 1) {
+      client_dispatch_pool_ = std::make_unique<ThreadPool>(
+          max_concurrent_client_calls, "federating-client-dispatch",
+          thread_pool_policy);
+    }
+  }
   ~FederatingExecutor() override {
     // We must make sure to delete all of our OwnedValueIds, releasing them from
     // the child executor as well, before deleting the child executor.
@@ -280,6 +327,25 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
   std::shared_ptr<Executor> server_child_;
   std::shared_ptr<Executor> client_child_;
   uint32_t num_clients_;
+  // The maximum number of clients accumulated serially, and partials merged
+  // together, by a single node of the `federated_aggregate` reduction tree.
+  // Values less than two disable the tree reduction.
+  uint32_t aggregate_fan_in_;
+  // Whether client-placed values which can be stacked are held as a single
+  // stacked value of `client_child_`, which `federated_map` calls the mapped
+  // function on once.
+  bool stack_client_values_;
+  // Pool used to issue per-client calls into `client_child_` concurrently. The
+  // number of threads bounds the number of calls in flight. If `nullptr`, calls
+  // are issued serially on the calling thread.
+  //
+  // Tasks scheduled on this pool only call into `client_child_` and never wait
+  // on other tasks in the pool, which keeps the pool free of deadlocks.
+  std::unique_ptr<ThreadPool> client_dispatch_pool_;
+  // If set, per-client calls are issued from the coordination lane of this
+  // runtime instead of `client_dispatch_pool_`, whose threads bound the calls
+  // in flight.
+  std::shared_ptr<ExecutorRuntime> client_dispatch_runtime_;
 
   std::string_view ExecutorName() final {
     static constexpr std::string_view kExecutorName = "FederatingExecutor";
@@ -301,6 +367,45 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
     return ::tensorflow_federated::NewClients(num_clients_);
   }
 
+  // Returns the values of a batch created in `client_child_`, in client order.
+  Clients ClientsFromBatch(std::vector<OwnedValueId> client_values) {
+    Clients values = NewClients();
+    for (OwnedValueId& value : client_values) {
+      values->emplace_back(ShareValueId(std::move(value)));
+    }
+    return values;
+  }
+
+  // Returns the values of the clients of the client-placed `value`. A stacked
+  // value is unstacked into the values of its clients on first use.
+  absl::StatusOr<Clients> ClientValues(const ExecutorValue& value) {
+    if (!value.is_stacked()) {
+      return value.clients();
+    }
+    StackedClientsInner& stacked = *value.stacked_clients();
+    absl::MutexLock lock(&stacked.mutex);
+    if (!stacked.unstacked.has_value()) {
+      stacked.unstacked = UnstackInClientChild(stacked.stacked->ref());
+    }
+    return *stacked.unstacked;
+  }
+
+  // Creates the values of the clients of the stacked value `stacked_id` in
+  // `client_child_`.
+  absl::StatusOr<Clients> UnstackInClientChild(ValueId stacked_id) {
+    auto traceme = Trace("UnstackClientValues");
+    v0::Value stacked_pb = TFF_TRY(client_child_->Materialize(stacked_id));
+    std::vector<v0::Value> client_values_pb =
+        TFF_TRY(UnstackValue(stacked_pb, num_clients_));
+    std::vector<const v0::Value*> values_pb;
+    values_pb.reserve(client_values_pb.size());
+    for (const v0::Value& value_pb : client_values_pb) {
+      values_pb.push_back(&value_pb);
+    }
+    return ClientsFromBatch(
+        TFF_TRY(client_child_->CreateValueBatch(values_pb)));
+  }
+
   absl::StatusOr<ExecutorValue> CreateFederatedValue(
       FederatedKind kind, const v0::Value_Federated& federated) {
     switch (kind) {
@@ -309,12 +414,21 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
             TFF_TRY(server_child_->CreateValue(federated.value(0)))));
       }
       case FederatedKind::CLIENTS: {
-        Clients values = NewClients();
+        std::vector<const v0::Value*> values_pb;
+        values_pb.reserve(federated.value_size());
         for (const auto& value_pb : federated.value()) {
-          values->emplace_back(
-              ShareValueId(TFF_TRY(client_child_->CreateValue(value_pb))));
+          values_pb.push_back(&value_pb);
         }
-        return ExecutorValue::CreateClientsPlaced(std::move(values));
+        if (stack_client_values_) {
+          std::optional<v0::Value> stacked_pb =
+              TFF_TRY(StackValues(values_pb));
+          if (stacked_pb.has_value()) {
+            return ExecutorValue::CreateStackedClientsPlaced(ShareValueId(
+                TFF_TRY(client_child_->CreateValue(*stacked_pb))));
+          }
+        }
+        return ExecutorValue::CreateClientsPlaced(ClientsFromBatch(
+            TFF_TRY(client_child_->CreateValueBatch(values_pb))));
       }
       case FederatedKind::CLIENTS_ALL_EQUAL: {
         return ClientsAllEqualValue(ShareValueId(
@@ -322,6 +436,33 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
       }
     }
   }
+  // Returns the unplaced `value` as a value of `client_child_`. A value which
+  // only exists in `server_child_`, e.g. the result of a call, is transferred
+  // from there; otherwise its proto is created in `client_child_`.
+  absl::StatusOr<std::shared_ptr<OwnedValueId>> UnplacedValueInClientChild(
+      const ExecutorValue& value) {
+    if (value.type() == ExecutorValue::ValueType::UNPLACED &&
+        !value.unplaced()->GetProto().has_value()) {
+      return Embed(value, client_child_);
+    }
+    v0::Value value_pb;
+    ParallelTasks tasks;
+    TFF_TRY(CreateMaterializeTasks(value, &value_pb, tasks));
+    TFF_TRY(tasks.WaitAll());
+    return ShareValueId(TFF_TRY(client_child_->CreateValue(value_pb)));
+  }
+
+  // Returns `server_val` as a value of `client_child_`. When both children are
+  // the same executor the value is shared as is, without copying it; otherwise
+  // it is transferred from `server_child_` to `client_child_`.
+  absl::StatusOr<std::shared_ptr<OwnedValueId>> ServerValueInClientChild(
+      const Server& server_val) {
+    if (server_child_ == client_child_) {
+      return server_val;
+    }
+    return ShareValueId(
+        TFF_TRY(server_child_->TransferTo(*client_child_, server_val->ref())));
+  }
   bool is_server_child(Executor* child) const {
     return child == server_child_.get();
   }
@@ -340,11 +481,17 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
           return TFF_TRY(value.unplaced()->Embedded(*child));
         } else {
           // In some cases Unplaced value could have only embedded value id on
-          // the server. E.g. when result of CreateCall.
-          // Use value.unplaced()->Proto to materialize value on server to
-          // create a new value on the passed child executer.
-          auto value_pb = TFF_TRY(value.unplaced()->Proto(*server_child_));
-          return ShareValueId(TFF_TRY(child->CreateValue(*value_pb)));
+          // the server. E.g. when result of CreateCall. Such values are
+          // transferred from the server child to the passed child executor.
+          std::optional<absl::StatusOr<std::shared_ptr<v0::Value>>> value_pb =
+              value.unplaced()->GetProto();
+          if (value_pb.has_value()) {
+            return ShareValueId(
+                TFF_TRY(child->CreateValue(*TFF_TRY(*value_pb))));
+          }
+          auto server_id = TFF_TRY(value.unplaced()->Embedded(*server_child_));
+          return ShareValueId(
+              TFF_TRY(server_child_->TransferTo(*child, server_id->ref())));
         }
       }
       case ExecutorValue::ValueType::INTRINSIC: {
@@ -467,27 +614,29 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
   }
 
   // Embeds `arg` containing structures of client-placed values into the
-  // `child_` executor. The resulting structure on `child_` will contain all
-  // values for the client corresponding to `client_index`.
-  absl::StatusOr<std::shared_ptr<OwnedValueId>> ZipStructIntoClient(
-      const ExecutorValue& arg, uint32_t client_index) {
+  // `client_child_` executor. The resulting structure of each client on
+  // `client_child_` will contain all values for that client. The structures
+  // of all clients at each level of nesting are created in a single batch.
+  absl::StatusOr<Clients> ZipStructIntoClients(const ExecutorValue& arg) {
     switch (arg.type()) {
       case ExecutorValue::ValueType::CLIENTS: {
-        return (*arg.clients())[client_index];
+        return ClientValues(arg);
       }
       case ExecutorValue::ValueType::STRUCTURE: {
-        std::vector<std::shared_ptr<OwnedValueId>> owned_element_ids;
-        owned_element_ids.reserve(arg.structure()->size());
+        std::vector<Clients> element_values;
+        element_values.reserve(arg.structure()->size());
         for (const auto& element : *arg.structure()) {
-          owned_element_ids.push_back(
-              TFF_TRY(ZipStructIntoClient(element, client_index)));
+          element_values.push_back(TFF_TRY(ZipStructIntoClients(element)));
         }
-        std::vector<ValueId> element_ids;
-        element_ids.reserve(arg.structure()->size());
-        for (const auto& owned_id : owned_element_ids) {
-          element_ids.push_back(owned_id->ref());
+        std::vector<std::vector<ValueId>> element_ids(num_clients_);
+        for (uint32_t i = 0; i < num_clients_; i++) {
+          element_ids[i].reserve(element_values.size());
+          for (const Clients& values : element_values) {
+            element_ids[i].push_back((*values)[i]->ref());
+          }
         }
-        return ShareValueId(TFF_TRY(client_child_->CreateStruct(element_ids)));
+        return ClientsFromBatch(
+            TFF_TRY(client_child_->CreateStructBatch(element_ids)));
       }
       default: {
         return absl::InvalidArgumentError(absl::StrCat(
@@ -526,41 +675,50 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
         TFF_TRY(CheckLenForUseAsArgument(arg, "federated_aggregate", 5));
         const auto& value = arg.structure()->at(0);
         const auto& zero = arg.structure()->at(1);
-        v0::Value zero_val;
-
-        ParallelTasks tasks;
-        TFF_TRY(CreateMaterializeTasks(zero, &zero_val, tasks));
-        TFF_TRY(tasks.WaitAll());
-
         const auto& accumulate = arg.structure()->at(2);
         auto accumulate_val_or = accumulate.unplaced()->GetProto();
         if (!accumulate_val_or.has_value()) {
           return absl::InvalidArgumentError(
               "Failed to get accumulate function.");
         }
-        // `merge` is unused (argument four).
         const auto& report = arg.structure()->at(4);
         auto report_child_id = TFF_TRY(Embed(report, server_child_));
         TFF_TRY(value.CheckArgumentType(ExecutorValue::ValueType::CLIENTS,
                                         "`federated_aggregate`'s `value`"));
-        std::optional<OwnedValueId> current_owner = std::nullopt;
-        auto zero_val_id_owner = TFF_TRY(client_child_->CreateValue(zero_val));
-        ValueId current = zero_val_id_owner.ref();
+        auto zero_val_id_owner = TFF_TRY(UnplacedValueInClientChild(zero));
         auto accumulate_child_id = TFF_TRY(
             client_child_->CreateValue(*(accumulate_val_or.value()->get())));
-        for (const auto& client_val_id : *value.clients()) {
-          auto acc_arg = TFF_TRY(
-              client_child_->CreateStruct({current, client_val_id->ref()}));
-          current_owner =
-              TFF_TRY(client_child_->CreateCall(accumulate_child_id, acc_arg));
-          current = current_owner.value().ref();
+        const Clients client_values = TFF_TRY(ClientValues(value));
+        absl::Span<const std::shared_ptr<OwnedValueId>> client_vals(
+            *client_values);
+        std::optional<OwnedValueId> result_owner = std::nullopt;
+        if (aggregate_fan_in_ < 2 || client_vals.size() <= aggregate_fan_in_) {
+          // `merge` is unused (argument four) when all clients are accumulated
+          // in a single chain.
+          result_owner = TFF_TRY(AccumulateClients(
+              zero_val_id_owner->ref(), accumulate_child_id, client_vals));
+        } else {
+          const auto& merge = arg.structure()->at(3);
+          auto merge_val_or = merge.unplaced()->GetProto();
+          if (!merge_val_or.has_value()) {
+            return absl::InvalidArgumentError("Failed to get merge function.");
+          }
+          auto merge_child_id = TFF_TRY(
+              client_child_->CreateValue(*(merge_val_or.value()->get())));
+          result_owner = TFF_TRY(TreeAggregateClients(
+              zero_val_id_owner->ref(), accumulate_child_id, merge_child_id,
+              client_vals));
+        }
+        ValueId current = result_owner.has_value() ? result_owner->ref()
+                                                   : zero_val_id_owner->ref();
+        std::optional<OwnedValueId> res_owner = std::nullopt;
+        if (server_child_ != client_child_) {
+          res_owner =
+              TFF_TRY(client_child_->TransferTo(*server_child_, current));
+          current = res_owner->ref();
         }
-        v0::Value result_val;
-        TFF_TRY(client_child_->Materialize(current, &result_val));
-
-        auto res = TFF_TRY(server_child_->CreateValue(result_val));
         auto result =
-            TFF_TRY(server_child_->CreateCall(report_child_id->ref(), res));
+            TFF_TRY(server_child_->CreateCall(report_child_id->ref(), current));
         return ExecutorValue::CreateServerPlaced(
             ShareValueId(std::move(result)));
       }
@@ -568,10 +726,8 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
         auto traceme = Trace("CallFederatedBroadcast");
         TFF_TRY(arg.CheckArgumentType(ExecutorValue::ValueType::SERVER,
                                       "`federated_broadcast`"));
-        v0::Value server_val;
-        TFF_TRY(server_child_->Materialize(arg.server()->ref(), &server_val));
         return ClientsAllEqualValue(
-            ShareValueId(TFF_TRY(client_child_->CreateValue(server_val))));
+            TFF_TRY(ServerValueInClientChild(arg.server())));
       }
       case FederatedIntrinsic::MAP: {
         auto traceme = Trace("CallFederatedMap");
@@ -594,14 +750,30 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
           }
           auto child_fn = TFF_TRY(
               client_child_->CreateValue(*(child_fn_val.value()->get())));
-          Clients results = NewClients();
-          for (int i = 0; i < num_clients_; i++) {
-            auto client_arg = data.clients()->at(i)->ref();
-            auto result =
-                TFF_TRY(client_child_->CreateCall(child_fn, client_arg));
-            results->emplace_back(ShareValueId(std::move(result)));
+          ValueId child_fn_id = child_fn.ref();
+          if (data.is_stacked()) {
+            // Functions mapped over stacked values are batch polymorphic, see
+            // `CreateFederatingExecutor`, so all clients are mapped at once.
+            return ExecutorValue::CreateStackedClientsPlaced(
+                ShareValueId(TFF_TRY(client_child_->CreateCall(
+                    child_fn_id, data.stacked_clients()->stacked->ref()))));
           }
-          return ExecutorValue::CreateClientsPlaced(std::move(results));
+          const Clients client_args = TFF_TRY(ClientValues(data));
+          if (!DispatchesConcurrently()) {
+            std::vector<ValueId> client_arg_ids;
+            client_arg_ids.reserve(client_args->size());
+            for (const auto& client_arg : *client_args) {
+              client_arg_ids.push_back(client_arg->ref());
+            }
+            return ExecutorValue::CreateClientsPlaced(ClientsFromBatch(TFF_TRY(
+                client_child_->CreateCallBatch(child_fn_id, client_arg_ids))));
+          }
+          return ExecutorValue::CreateClientsPlaced(TFF_TRY(DispatchToClients(
+              [this, child_fn_id,
+               &client_args](uint32_t i) -> absl::StatusOr<OwnedValueId> {
+                return client_child_->CreateCall(child_fn_id,
+                                                 client_args->at(i)->ref());
+              })));
         } else if (data.type() == ExecutorValue::ValueType::SERVER) {
           auto child_fn = TFF_TRY(Embed(fn, server_child_));
           auto res = TFF_TRY(
@@ -622,7 +794,7 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
         const auto& select_fn = arg.structure()->at(3);
         TFF_TRY(keys.CheckArgumentType(ExecutorValue::ValueType::CLIENTS,
                                        "`federated_select`'s `keys`"));
-        const Clients& keys_child_ids = keys.clients();
+        const Clients keys_child_ids = TFF_TRY(ClientValues(keys));
         TFF_TRY(
             server_val.CheckArgumentType(ExecutorValue::ValueType::SERVER,
                                          "`federated_select`'s `server_val`"));
@@ -637,11 +809,8 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
       }
       case FederatedIntrinsic::ZIP_AT_CLIENTS: {
         auto traceme = Trace("CallIntrinsicZipClients");
-        Clients results = NewClients();
-        for (uint32_t i = 0; i < num_clients_; i++) {
-          results->push_back(TFF_TRY(ZipStructIntoClient(arg, i)));
-        }
-        return ExecutorValue::CreateClientsPlaced(std::move(results));
+        return ExecutorValue::CreateClientsPlaced(
+            TFF_TRY(ZipStructIntoClients(arg)));
       }
       case FederatedIntrinsic::ZIP_AT_SERVER: {
         auto traceme = Trace("CallIntrinsicZipServer");
@@ -651,6 +820,110 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
     }
   }
 
+  // Invokes `client_fn` once for each client index, returning the resulting
+  // values in client order.
+  absl::StatusOr<Clients> DispatchToClients(
+      const std::function<absl::StatusOr<OwnedValueId>(uint32_t)>&
+          client_fn) {
+    std::vector<std::optional<OwnedValueId>> client_results(num_clients_);
+    TFF_TRY(DispatchIndexed(
+        num_clients_, [&client_fn, &client_results](size_t i) -> absl::Status {
+          client_results[i] = TFF_TRY(client_fn(i));
+          return absl::OkStatus();
+        }));
+    Clients results = NewClients();
+    for (auto& result : client_results) {
+      results->emplace_back(ShareValueId(std::move(result).value()));
+    }
+    return results;
+  }
+
+  // Whether per-client calls are issued concurrently from a pool, rather than
+  // serially, in which case they are batched into a single call of
+  // `client_child_` instead.
+  bool DispatchesConcurrently() const {
+    return client_dispatch_pool_ != nullptr ||
+           client_dispatch_runtime_ != nullptr;
+  }
+
+  // Invokes `fn` once for each index in `[0, count)`.
+  //
+  // If `client_dispatch_pool_` or `client_dispatch_runtime_` is set,
+  // invocations are scheduled on its pool so that at most as many calls as
+  // there are pool threads are in flight at once. Otherwise `fn` is invoked
+  // serially on the calling thread, stopping at the first error.
+  absl::Status DispatchIndexed(
+      size_t count, const std::function<absl::Status(size_t)>& fn) {
+    if (!DispatchesConcurrently()) {
+      for (size_t i = 0; i < count; i++) {
+        TFF_TRY(fn(i));
+      }
+      return absl::OkStatus();
+    }
+    ParallelTasks tasks(
+        client_dispatch_runtime_ != nullptr
+            ? client_dispatch_runtime_->pool(ExecutorLane::kCoordination)
+            : client_dispatch_pool_.get());
+    for (size_t i = 0; i < count; i++) {
+      TFF_TRY(tasks.add_task([&fn, i]() { return fn(i); }));
+    }
+    return tasks.WaitAll();
+  }
+
+  // Sequentially calls `accumulate` on `zero` and each of `client_vals` in
+  // `client_child_`. Returns `std::nullopt` if `client_vals` is empty, in which
+  // case the aggregate is `zero` itself.
+  absl::StatusOr<std::optional<OwnedValueId>> AccumulateClients(
+      ValueId zero, ValueId accumulate,
+      absl::Span<const std::shared_ptr<OwnedValueId>> client_vals) {
+    std::optional<OwnedValueId> current_owner = std::nullopt;
+    ValueId current = zero;
+    for (const auto& client_val_id : client_vals) {
+      auto acc_arg = TFF_TRY(
+          client_child_->CreateStruct({current, client_val_id->ref()}));
+      current_owner = TFF_TRY(client_child_->CreateCall(accumulate, acc_arg));
+      current = current_owner.value().ref();
+    }
+    return current_owner;
+  }
+
+  // Reduces `client_vals` in `client_child_` using a tree of depth
+  // logarithmic in the number of clients.
+  //
+  // Disjoint shards of at most `aggregate_fan_in_` clients are accumulated
+  // independently starting from `zero`, and the resulting partials are then
+  // repeatedly combined `aggregate_fan_in_` at a time using `merge` until a
+  // single value remains. Since the calls within a level do not depend on each
+  // other, `client_child_` is free to evaluate them concurrently.
+  absl::StatusOr<OwnedValueId> TreeAggregateClients(
+      ValueId zero, ValueId accumulate, ValueId merge,
+      absl::Span<const std::shared_ptr<OwnedValueId>> client_vals) {
+    const size_t fan_in = aggregate_fan_in_;
+    std::vector<OwnedValueId> partials;
+    partials.reserve((client_vals.size() + fan_in - 1) / fan_in);
+    for (size_t start = 0; start < client_vals.size(); start += fan_in) {
+      auto partial = TFF_TRY(AccumulateClients(
+          zero, accumulate, client_vals.subspan(start, fan_in)));
+      partials.push_back(std::move(partial).value());
+    }
+    while (partials.size() > 1) {
+      std::vector<OwnedValueId> merged;
+      merged.reserve((partials.size() + fan_in - 1) / fan_in);
+      for (size_t start = 0; start < partials.size(); start += fan_in) {
+        const size_t end = std::min(start + fan_in, partials.size());
+        OwnedValueId current = std::move(partials[start]);
+        for (size_t i = start + 1; i < end; ++i) {
+          auto merge_arg = TFF_TRY(
+              client_child_->CreateStruct({current.ref(), partials[i].ref()}));
+          current = TFF_TRY(client_child_->CreateCall(merge, merge_arg));
+        }
+        merged.push_back(std::move(current));
+      }
+      partials = std::move(merged);
+    }
+    return std::move(partials.front());
+  }
+
   // A container for information about the keys in a `federated_select` round.
   struct KeyData {
     // The values of every key in a `federated_select`.
@@ -661,75 +934,96 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
     std::vector<std::vector<int32_t>> for_clients;
   };
 
+  // Returns the datasets of the slices of `server_val` selected by each
+  // client's keys.
+  //
+  // The slice of each distinct key is computed once, concurrently with the
+  // others, and delivered to `client_child_` once, where every client's dataset
+  // is assembled from the shared slices.
   absl::StatusOr<ExecutorValue> CallFederatedSelect(
       const Clients& keys_child_ids, ValueId server_val_child_id,
       ValueId select_fn_child_id) {
     KeyData keys = TFF_TRY(MaterializeKeys(keys_child_ids));
-    absl::flat_hash_map<int32_t, OwnedValueId> slice_for_key;
-    slice_for_key.reserve(keys.all.size());
-    for (int32_t key : keys.all) {
-      slice_for_key.insert(
-          {key, TFF_TRY(SelectSliceForKey(key, server_val_child_id,
-                                          select_fn_child_id))});
+    std::vector<int32_t> distinct_keys(keys.all.begin(), keys.all.end());
+    std::vector<std::optional<OwnedValueId>> slices(distinct_keys.size());
+    TFF_TRY(DispatchIndexed(
+        distinct_keys.size(), [&](size_t i) -> absl::Status {
+          slices[i] = TFF_TRY(ClientSliceForKey(
+              distinct_keys[i], server_val_child_id, select_fn_child_id));
+          return absl::OkStatus();
+        }));
+    absl::flat_hash_map<int32_t, ValueId> slice_for_key;
+    slice_for_key.reserve(distinct_keys.size());
+    for (size_t i = 0; i < distinct_keys.size(); i++) {
+      slice_for_key.insert({distinct_keys[i], slices[i]->ref()});
     }
     v0::Value args_into_sequence_pb;
     args_into_sequence_pb.mutable_computation()->mutable_intrinsic()->set_uri(
         "args_into_sequence");
     OwnedValueId args_into_sequence_id =
-        TFF_TRY(server_child_->CreateValue(args_into_sequence_pb));
-    Clients client_datasets = NewClients();
-    for (const auto& keys_for_client : keys.for_clients) {
-      std::vector<ValueId> slice_ids_for_client;
-      slice_ids_for_client.reserve(keys_for_client.size());
-      for (int32_t key : keys_for_client) {
-        slice_ids_for_client.push_back(slice_for_key.at(key).ref());
-      }
-      OwnedValueId slices =
-          TFF_TRY(server_child_->CreateStruct(slice_ids_for_client));
-      OwnedValueId dataset =
-          TFF_TRY(server_child_->CreateCall(args_into_sequence_id, slices));
-      v0::Value dataset_pb;
-      TFF_TRY(server_child_->Materialize(dataset.ref(), &dataset_pb));
-      client_datasets->push_back(
-          ShareValueId(TFF_TRY(client_child_->CreateValue(dataset_pb))));
-    }
-    return ExecutorValue::CreateClientsPlaced(std::move(client_datasets));
+        TFF_TRY(client_child_->CreateValue(args_into_sequence_pb));
+    ValueId args_into_sequence_child_id = args_into_sequence_id.ref();
+    return ExecutorValue::CreateClientsPlaced(TFF_TRY(DispatchToClients(
+        [this, &keys, &slice_for_key, args_into_sequence_child_id](
+            uint32_t i) -> absl::StatusOr<OwnedValueId> {
+          std::vector<ValueId> slice_ids_for_client;
+          slice_ids_for_client.reserve(keys.for_clients[i].size());
+          for (int32_t key : keys.for_clients[i]) {
+            slice_ids_for_client.push_back(slice_for_key.at(key));
+          }
+          OwnedValueId slices_for_client =
+              TFF_TRY(client_child_->CreateStruct(slice_ids_for_client));
+          return client_child_->CreateCall(args_into_sequence_child_id,
+                                           slices_for_client);
+        })));
   }
 
+  // Materializes the keys of every client, concurrently across clients, and
+  // joins them into `KeyData::all` once all of them are available.
   absl::StatusOr<KeyData> MaterializeKeys(const Clients& keys_child_ids) {
     KeyData keys;
-    keys.for_clients.reserve(keys_child_ids->size());
-    for (const auto& keys_child_id : *keys_child_ids) {
-      // TODO: b/209504748 - Make federating_executor value a future so that
-      // these materialize calls don't block.
-      v0::Value keys_for_client_pb =
-          TFF_TRY(client_child_->Materialize(keys_child_id->ref()));
-      tensorflow::Tensor keys_for_client_tensor =
-          TFF_TRY(DeserializeTensorValue(keys_for_client_pb));
-      if (keys_for_client_tensor.dtype() != tensorflow::DT_INT32) {
-        return absl::InvalidArgumentError(
-            absl::StrCat("Expected int32_t key, found key of tensor dtype ",
-                         keys_for_client_tensor.dtype()));
-      }
-      if (keys_for_client_tensor.dims() != 1) {
-        return absl::InvalidArgumentError(absl::StrCat(
-            "Expected key tensor to be rank one, but found tensor of rank ",
-            keys_for_client_tensor.dims()));
-      }
-      int64_t num_keys = keys_for_client_tensor.NumElements();
-      std::vector<int32_t> keys_for_client;
-      keys_for_client.reserve(num_keys);
-      auto keys_for_client_eigen = keys_for_client_tensor.flat<int32_t>();
-      for (int64_t i = 0; i < num_keys; i++) {
-        int32_t key = keys_for_client_eigen(i);
-        keys_for_client.push_back(key);
-        keys.all.insert(key);
-      }
-      keys.for_clients.push_back(std::move(keys_for_client));
+    keys.for_clients.resize(keys_child_ids->size());
+    TFF_TRY(DispatchIndexed(
+        keys_child_ids->size(), [this, &keys_child_ids, &keys](size_t i) {
+          return MaterializeKeysForClient(keys_child_ids->at(i)->ref(),
+                                          keys.for_clients[i]);
+        }));
+    size_t num_keys = 0;
+    for (const auto& keys_for_client : keys.for_clients) {
+      num_keys += keys_for_client.size();
+    }
+    keys.all.reserve(num_keys);
+    for (const auto& keys_for_client : keys.for_clients) {
+      keys.all.insert(keys_for_client.begin(), keys_for_client.end());
     }
     return keys;
   }
 
+  absl::Status MaterializeKeysForClient(ValueId keys_child_id,
+                                        std::vector<int32_t>& keys_for_client) {
+    // TODO: b/209504748 - Make federating_executor value a future so that
+    // these materialize calls don't block.
+    v0::Value keys_for_client_pb =
+        TFF_TRY(client_child_->Materialize(keys_child_id));
+    tensorflow::Tensor keys_for_client_tensor =
+        TFF_TRY(DeserializeTensorValue(keys_for_client_pb));
+    if (keys_for_client_tensor.dtype() != tensorflow::DT_INT32) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Expected int32_t key, found key of tensor dtype ",
+                       keys_for_client_tensor.dtype()));
+    }
+    if (keys_for_client_tensor.dims() != 1) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Expected key tensor to be rank one, but found tensor of rank ",
+          keys_for_client_tensor.dims()));
+    }
+    auto keys_for_client_eigen = keys_for_client_tensor.flat<int32_t>();
+    keys_for_client.assign(
+        keys_for_client_eigen.data(),
+        keys_for_client_eigen.data() + keys_for_client_eigen.size());
+    return absl::OkStatus();
+  }
+
   absl::StatusOr<OwnedValueId> SelectSliceForKey(int32_t key,
                                                  ValueId server_val_child_id,
                                                  ValueId select_fn_child_id) {
@@ -741,6 +1035,20 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
     return TFF_TRY(server_child_->CreateCall(select_fn_child_id, arg_id));
   }
 
+  // Returns the slice of `key` in `client_child_`. Unless the server and client
+  // children are the same executor, the slice is transferred from the server
+  // child once, rather than once per client that selects it.
+  absl::StatusOr<OwnedValueId> ClientSliceForKey(int32_t key,
+                                                 ValueId server_val_child_id,
+                                                 ValueId select_fn_child_id) {
+    OwnedValueId slice = TFF_TRY(
+        SelectSliceForKey(key, server_val_child_id, select_fn_child_id));
+    if (server_child_ == client_child_) {
+      return slice;
+    }
+    return server_child_->TransferTo(*client_child_, slice.ref());
+  }
+
   absl::StatusOr<ExecutorValue> CreateStruct(
       std::vector<ExecutorValue> members) final {
     return ExecutorValue::CreateStructure(
@@ -794,6 +1102,23 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
         type_pb->set_all_equal(false);
         type_pb->mutable_placement()->mutable_value()->mutable_uri()->assign(
             kClientsUri.data(), kClientsUri.size());
+        if (value.is_stacked()) {
+          // The stacked value is materialized at once and unstacked here,
+          // rather than creating the values of its clients in the child.
+          return tasks.add_task([child = client_child_,
+                                 stacked = value.stacked_clients(),
+                                 num_clients = num_clients_,
+                                 federated_pb]() -> absl::Status {
+            v0::Value stacked_pb =
+                TFF_TRY(child->Materialize(stacked->stacked->ref()));
+            std::vector<v0::Value> client_values_pb =
+                TFF_TRY(UnstackValue(stacked_pb, num_clients));
+            for (v0::Value& client_value_pb : client_values_pb) {
+              *federated_pb->add_value() = std::move(client_value_pb);
+            }
+            return absl::OkStatus();
+          });
+        }
         for (const auto& client_value : *value.clients()) {
           TFF_TRY(CreateChildMaterializeTask(client_value->ref(),
                                              federated_pb->add_value(),
@@ -848,10 +1173,14 @@ class FederatingExecutor : public ExecutorBase<ExecutorValue> {
 absl::StatusOr<std::shared_ptr<Executor>> CreateFederatingExecutor(
     std::shared_ptr<Executor> server_child,
     std::shared_ptr<Executor> client_child,
-    const CardinalityMap& cardinalities) {
+    const CardinalityMap& cardinalities, uint32_t aggregate_fan_in,
+    int32_t max_concurrent_client_calls, ThreadPoolPolicy thread_pool_policy,
+    std::shared_ptr<ExecutorRuntime> runtime, bool stack_client_values) {
   int num_clients = TFF_TRY(NumClientsFromCardinalities(cardinalities));
   return std::make_shared<FederatingExecutor>(
-      std::move(server_child), std::move(client_child), num_clients);
+      std::move(server_child), std::move(client_child), num_clients,
+      aggregate_fan_in, max_concurrent_client_calls, thread_pool_policy,
+      std::move(runtime), stack_client_values);
 }
 
 }  // namespace tensorflow_federated
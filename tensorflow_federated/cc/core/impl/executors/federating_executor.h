@@ -16,19 +16,57 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_FEDERATING_EXECUTOR_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_FEDERATING_EXECUTOR_H_
 
+#include <cstdint>
 #include <memory>
 
 #include "absl/status/statusor.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 
 namespace tensorflow_federated {
 
 // Returns an executor that can resolve federated values and intrinsics.
+//
+// `aggregate_fan_in` controls how `federated_aggregate` reduces client values.
+// Values less than two indicate a single sequential chain of `accumulate`
+// calls over all clients. Otherwise, clients are split into shards of at most
+// `aggregate_fan_in` clients which are accumulated independently, and the
+// resulting partial aggregates are combined using `merge` in a tree where each
+// node combines at most `aggregate_fan_in` partials.
+//
+// `max_concurrent_client_calls` bounds the number of per-client calls into
+// `client_child` that `federated_map` issues concurrently from a thread pool
+// owned by the executor. Values less than two issue the calls of all clients
+// in a single `CreateCallBatch` call on the calling thread instead.
+// `thread_pool_policy` selects the scheduling policy of that thread pool.
+//
+// Client-placed values and the structures of `federated_zip_at_clients` are
+// always created in `client_child` in batches of all clients.
+//
+// If `runtime` is not null, the calls are issued from its coordination lane
+// instead of a thread pool owned by the executor. The lane then bounds the
+// calls in flight, and `thread_pool_policy` is unused.
+//
+// If `stack_client_values` is true, client-placed values whose clients all
+// hold tensors of the same dtype and shape, or structures of such tensors, are
+// created as a single value of `client_child` stacking the values of all
+// clients along a new leading dimension. `federated_map` then calls the mapped
+// function once on the stacked value rather than once per client, which is
+// only valid if all functions mapped over client values are batch polymorphic,
+// i.e. applying one to the stacked values yields the stacked results of
+// applying it to the value of each client, as elementwise functions do. Other
+// intrinsics, e.g. `federated_aggregate`, unstack the value into the values of
+// its clients once, and `Materialize` unstacks it locally.
 absl::StatusOr<std::shared_ptr<Executor>> CreateFederatingExecutor(
     std::shared_ptr<Executor> server_child,
     std::shared_ptr<Executor> client_child,
-    const CardinalityMap& cardinalities);
+    const CardinalityMap& cardinalities, uint32_t aggregate_fan_in = 0,
+    int32_t max_concurrent_client_calls = -1,
+    ThreadPoolPolicy thread_pool_policy = ThreadPoolPolicy::kSingleQueue,
+    std::shared_ptr<ExecutorRuntime> runtime = nullptr,
+    bool stack_client_values = false);
 
 }  // namespace tensorflow_federated
 
@@ -0,0 +1,130 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/federating_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/noop_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::tensorflow_federated::testing::ClientsV;
+using ::tensorflow_federated::testing::StructV;
+using ::tensorflow_federated::testing::TensorV;
+using ::tensorflow_federated::testing::intrinsic::FederatedMapV;
+
+// Simulated per-call dispatch cost of the client child, e.g. the latency of a
+// `CreateCall` RPC to a remote worker.
+constexpr absl::Duration kCreateCallLatency = absl::Microseconds(50);
+
+// Benchmarks `federated_map` over `state.range(0)` clients, using at most
+// `state.range(1)` concurrent client calls.
+static void BM_FederatedMapAtClients(benchmark::State& state) {
+  const int32_t num_clients = state.range(0);
+  const int32_t max_concurrent_client_calls = state.range(1);
+  auto child = std::make_shared<NoOpExecutor>(kCreateCallLatency);
+  std::shared_ptr<Executor> executor =
+      CreateFederatingExecutor(child, child,
+                               {{std::string(kClientsUri), num_clients}},
+                               /*aggregate_fan_in=*/0,
+                               max_concurrent_client_calls)
+          .value();
+  std::vector<v0::Value> client_vals(num_clients, TensorV(1));
+  OwnedValueId map_id = executor->CreateValue(FederatedMapV()).value();
+  OwnedValueId arg_id =
+      executor->CreateValue(StructV({TensorV(2), ClientsV(client_vals)}))
+          .value();
+  int64_t items_processed = 0;
+
+  // Benchmark time is only measured in the loop body.
+  for (auto s : state) {
+    benchmark::DoNotOptimize(executor->CreateCall(map_id, arg_id));
+    items_processed += num_clients;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK(BM_FederatedMapAtClients)
+    ->ArgNames({"clients", "concurrency"})
+    ->ArgsProduct({{16, 128, 1024}, {1, 4, 16}})
+    ->UseRealTime();
+
+// Benchmarks the dispatch overhead of `federated_map` over `state.range(0)`
+// clients, whose calls return immediately.
+static void BM_FederatedMapOfNoOpAtClients(benchmark::State& state) {
+  const int32_t num_clients = state.range(0);
+  auto child = std::make_shared<NoOpExecutor>();
+  std::shared_ptr<Executor> executor =
+      CreateFederatingExecutor(child, child,
+                               {{std::string(kClientsUri), num_clients}})
+          .value();
+  std::vector<v0::Value> client_vals(num_clients, TensorV(1));
+  OwnedValueId map_id = executor->CreateValue(FederatedMapV()).value();
+  OwnedValueId arg_id =
+      executor->CreateValue(StructV({TensorV(2), ClientsV(client_vals)}))
+          .value();
+  int64_t items_processed = 0;
+  for (auto s : state) {
+    benchmark::DoNotOptimize(executor->CreateCall(map_id, arg_id));
+    items_processed += num_clients;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK(BM_FederatedMapOfNoOpAtClients)
+    ->ArgName("clients")
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000)
+    ->UseRealTime();
+
+// Benchmarks creating and disposing of a value placed at `state.range(0)`
+// clients, i.e. the tracking of one child value per client.
+static void BM_CreateAndDisposeClientsValue(benchmark::State& state) {
+  const int32_t num_clients = state.range(0);
+  auto child = std::make_shared<NoOpExecutor>();
+  std::shared_ptr<Executor> executor =
+      CreateFederatingExecutor(child, child,
+                               {{std::string(kClientsUri), num_clients}})
+          .value();
+  const v0::Value clients_pb =
+      ClientsV(std::vector<v0::Value>(num_clients, TensorV(1)));
+  int64_t items_processed = 0;
+  for (auto s : state) {
+    // The value is disposed of at the end of each iteration.
+    benchmark::DoNotOptimize(executor->CreateValue(clients_pb));
+    items_processed += num_clients;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK(BM_CreateAndDisposeClientsValue)
+    ->ArgName("clients")
+    ->Arg(10)
+    ->Arg(1000)
+    ->Arg(100000);
+
+}  // namespace
+}  // namespace tensorflow_federated
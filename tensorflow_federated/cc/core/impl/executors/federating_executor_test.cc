@@ -15,6 +15,7 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/federating_executor.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -33,6 +34,7 @@ limitations under the License
 #include "tensorflow_federated/cc/core/impl/executors/executor_test_base.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 #include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
@@ -407,6 +409,109 @@ TEST_F(FederatingExecutorTest, CreateCallFederatedAggregate) {
   ExpectMaterialize(result_id, ServerV(child_result));
 }
 
+TEST_F(FederatingExecutorTest, CreateCallFederatedAggregateTree) {
+  constexpr uint32_t kFanIn = 4;
+  TFF_ASSERT_OK_AND_ASSIGN(
+      test_executor_, tensorflow_federated::CreateFederatingExecutor(
+                          mock_server_executor_, mock_client_executor_,
+                          {{"clients", NUM_CLIENTS}}, kFanIn));
+  std::vector<v0::Value> client_vals;
+  std::vector<ValueId> client_vals_child_ids;
+  for (int i = 0; i < NUM_CLIENTS; i++) {
+    client_vals.emplace_back(TensorV(i));
+    client_vals_child_ids.emplace_back(ExpectCreateInClientChild(TensorV(i)));
+  }
+  v0::Value value = ClientsV(client_vals);
+  v0::Value zero = TensorV("zero");
+  ValueId zero_child_id = ExpectCreateInClientChild(zero);
+  v0::Value accumulate = TensorV("accumulate");
+  ValueId accumulate_child_id = ExpectCreateInClientChild(accumulate);
+  v0::Value merge = TensorV("merge");
+  ValueId merge_child_id = ExpectCreateInClientChild(merge);
+  v0::Value report = TensorV("report");
+  ValueId report_child_id = ExpectCreateInServerChild(report);
+  v0::Value arg = StructV({value, zero, accumulate, merge, report});
+  TFF_ASSERT_OK_AND_ASSIGN(auto arg_id, test_executor_->CreateValue(arg));
+  TFF_ASSERT_OK_AND_ASSIGN(auto intrinsic_id,
+                           test_executor_->CreateValue(FederatedAggregateV()));
+  // Clients are accumulated in shards of `kFanIn`, each starting from `zero`.
+  std::vector<ValueId> partial_child_ids;
+  for (uint32_t start = 0; start < NUM_CLIENTS; start += kFanIn) {
+    const uint32_t end = std::min<uint32_t>(start + kFanIn, NUM_CLIENTS);
+    ValueId current_child_id = zero_child_id;
+    for (uint32_t i = start; i < end; i++) {
+      ValueId call_arg_child_id = ExpectCreateStructInClientChild(
+          {current_child_id, client_vals_child_ids[i]});
+      current_child_id =
+          ExpectCreateCallInClientChild(accumulate_child_id, call_arg_child_id);
+    }
+    partial_child_ids.push_back(current_child_id);
+  }
+  // The three partials fit in a single merge node.
+  ASSERT_EQ(partial_child_ids.size(), 3);
+  ValueId current_child_id = partial_child_ids[0];
+  for (size_t i = 1; i < partial_child_ids.size(); i++) {
+    ValueId merge_arg_child_id = ExpectCreateStructInClientChild(
+        {current_child_id, partial_child_ids[i]});
+    current_child_id =
+        ExpectCreateCallInClientChild(merge_child_id, merge_arg_child_id);
+  }
+  v0::Value client_child_result = TensorV("result_val");
+  ExpectMaterializeInClientChild(current_child_id, client_child_result);
+  ValueId result_in_server_id = ExpectCreateInServerChild(client_child_result);
+  ValueId result_child_id =
+      ExpectCreateCallInServerChild(report_child_id, result_in_server_id);
+  TFF_ASSERT_OK_AND_ASSIGN(auto result_id,
+                           test_executor_->CreateCall(intrinsic_id, arg_id));
+  v0::Value child_result = TensorV("result");
+  ExpectMaterializeInServerChild(result_child_id, child_result);
+  ExpectMaterialize(result_id, ServerV(child_result));
+}
+
+TEST_F(FederatingExecutorTest, CreateCallFederatedAggregateTreeFewClients) {
+  // With fewer clients than the fan-in, a single `accumulate` chain is used
+  // and `merge` is never embedded.
+  TFF_ASSERT_OK_AND_ASSIGN(
+      test_executor_, tensorflow_federated::CreateFederatingExecutor(
+                          mock_server_executor_, mock_client_executor_,
+                          {{"clients", NUM_CLIENTS}}, NUM_CLIENTS));
+  std::vector<v0::Value> client_vals;
+  std::vector<ValueId> client_vals_child_ids;
+  for (int i = 0; i < NUM_CLIENTS; i++) {
+    client_vals.emplace_back(TensorV(i));
+    client_vals_child_ids.emplace_back(ExpectCreateInClientChild(TensorV(i)));
+  }
+  v0::Value value = ClientsV(client_vals);
+  v0::Value zero = TensorV("zero");
+  ValueId zero_child_id = ExpectCreateInClientChild(zero);
+  v0::Value accumulate = TensorV("accumulate");
+  ValueId accumulate_child_id = ExpectCreateInClientChild(accumulate);
+  v0::Value merge = TensorV("merge");
+  v0::Value report = TensorV("report");
+  ValueId report_child_id = ExpectCreateInServerChild(report);
+  v0::Value arg = StructV({value, zero, accumulate, merge, report});
+  TFF_ASSERT_OK_AND_ASSIGN(auto arg_id, test_executor_->CreateValue(arg));
+  TFF_ASSERT_OK_AND_ASSIGN(auto intrinsic_id,
+                           test_executor_->CreateValue(FederatedAggregateV()));
+  ValueId current_child_id = zero_child_id;
+  for (auto client_val_child_id : client_vals_child_ids) {
+    ValueId call_arg_child_id = ExpectCreateStructInClientChild(
+        {current_child_id, client_val_child_id});
+    current_child_id =
+        ExpectCreateCallInClientChild(accumulate_child_id, call_arg_child_id);
+  }
+  v0::Value client_child_result = TensorV("result_val");
+  ExpectMaterializeInClientChild(current_child_id, client_child_result);
+  ValueId result_in_server_id = ExpectCreateInServerChild(client_child_result);
+  ValueId result_child_id =
+      ExpectCreateCallInServerChild(report_child_id, result_in_server_id);
+  TFF_ASSERT_OK_AND_ASSIGN(auto result_id,
+                           test_executor_->CreateCall(intrinsic_id, arg_id));
+  v0::Value child_result = TensorV("result");
+  ExpectMaterializeInServerChild(result_child_id, child_result);
+  ExpectMaterialize(result_id, ServerV(child_result));
+}
+
 TEST_F(FederatingExecutorTest, CreateCallFederatedBroadcast) {
   v0::Value tensor = TensorV(1);
   ValueId tensor_id = ExpectCreateInServerChild(tensor);
@@ -424,6 +529,27 @@ TEST_F(FederatingExecutorTest, CreateCallFederatedBroadcast) {
                     ClientsV(std::vector<v0::Value>(NUM_CLIENTS, tensor_out)));
 }
 
+TEST_F(FederatingExecutorTest, CreateCallFederatedBroadcastSharedChild) {
+  auto mock_executor = std::make_shared<::testing::StrictMock<MockExecutor>>();
+  TFF_ASSERT_OK_AND_ASSIGN(test_executor_,
+                           tensorflow_federated::CreateFederatingExecutor(
+                               mock_executor, mock_executor,
+                               {{"clients", NUM_CLIENTS}}));
+  v0::Value tensor = TensorV(1);
+  // The server value is shared with the clients, rather than materialized and
+  // created again.
+  ValueId tensor_id = mock_executor->ExpectCreateValue(tensor);
+  TFF_ASSERT_OK_AND_ASSIGN(auto server_id,
+                           test_executor_->CreateValue(ServerV(tensor)));
+  TFF_ASSERT_OK_AND_ASSIGN(auto broadcast_id,
+                           test_executor_->CreateValue(FederatedBroadcastV()));
+  TFF_ASSERT_OK_AND_ASSIGN(auto clients_id,
+                           test_executor_->CreateCall(broadcast_id, server_id));
+  mock_executor->ExpectMaterialize(tensor_id, tensor, ONCE_PER_CLIENT);
+  ExpectMaterialize(clients_id,
+                    ClientsV(std::vector<v0::Value>(NUM_CLIENTS, tensor)));
+}
+
 TEST_F(FederatingExecutorTest, CreateCallFederatedMapAtClients) {
   std::vector<v0::Value> client_vals;
   std::vector<ValueId> client_vals_child_ids;
@@ -452,6 +578,154 @@ TEST_F(FederatingExecutorTest, CreateCallFederatedMapAtClients) {
   ExpectMaterialize(result_id, value);
 }
 
+TEST_F(FederatingExecutorTest, CreateCallFederatedMapAtClientsConcurrently) {
+  TFF_ASSERT_OK_AND_ASSIGN(
+      test_executor_,
+      tensorflow_federated::CreateFederatingExecutor(
+          mock_server_executor_, mock_client_executor_,
+          {{"clients", NUM_CLIENTS}}, /*aggregate_fan_in=*/0,
+          /*max_concurrent_client_calls=*/4));
+  std::vector<v0::Value> client_vals;
+  std::vector<ValueId> client_vals_child_ids;
+  for (int i = 0; i < NUM_CLIENTS; i++) {
+    client_vals.emplace_back(TensorV(i));
+    client_vals_child_ids.emplace_back(ExpectCreateInClientChild(TensorV(i)));
+  }
+  v0::Value value = ClientsV(client_vals);
+  TFF_ASSERT_OK_AND_ASSIGN(auto input_id,
+                           test_executor_->CreateValue(ClientsV(client_vals)));
+  v0::Value function = TensorV(2);
+  auto fn_id = ExpectCreateInClientChild(function);
+  for (int i = 0; i < NUM_CLIENTS; i++) {
+    ValueId result_child_id =
+        ExpectCreateCallInClientChild(fn_id, client_vals_child_ids[i]);
+    ExpectMaterializeInClientChild(result_child_id, client_vals[i]);
+  }
+  TFF_ASSERT_OK_AND_ASSIGN(auto map_id,
+                           test_executor_->CreateValue(FederatedMapV()));
+  TFF_ASSERT_OK_AND_ASSIGN(auto fn_at_fed_exec_id,
+                           test_executor_->CreateValue(function));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto arg_id, test_executor_->CreateStruct({fn_at_fed_exec_id, input_id}));
+  TFF_ASSERT_OK_AND_ASSIGN(auto result_id,
+                           test_executor_->CreateCall(map_id, arg_id));
+  // Results must be returned in client order regardless of completion order.
+  ExpectMaterialize(result_id, value);
+}
+
+TEST_F(FederatingExecutorTest,
+       CreateCallFederatedMapAtClientsConcurrentlyPropagatesError) {
+  TFF_ASSERT_OK_AND_ASSIGN(
+      test_executor_,
+      tensorflow_federated::CreateFederatingExecutor(
+          mock_server_executor_, mock_client_executor_,
+          {{"clients", NUM_CLIENTS}}, /*aggregate_fan_in=*/0,
+          /*max_concurrent_client_calls=*/4));
+  std::vector<v0::Value> client_vals;
+  std::vector<ValueId> client_vals_child_ids;
+  for (int i = 0; i < NUM_CLIENTS; i++) {
+    client_vals.emplace_back(TensorV(i));
+    client_vals_child_ids.emplace_back(ExpectCreateInClientChild(TensorV(i)));
+  }
+  TFF_ASSERT_OK_AND_ASSIGN(auto input_id,
+                           test_executor_->CreateValue(ClientsV(client_vals)));
+  v0::Value function = TensorV(2);
+  auto fn_id = ExpectCreateInClientChild(function);
+  for (int i = 0; i < NUM_CLIENTS - 1; i++) {
+    ExpectCreateCallInClientChild(fn_id, client_vals_child_ids[i]);
+  }
+  EXPECT_CALL(*mock_client_executor_,
+              CreateCall(fn_id, std::optional<const ValueId>(
+                                    client_vals_child_ids[NUM_CLIENTS - 1])))
+      .WillOnce(::testing::Return(absl::InternalError("client call failed")));
+  TFF_ASSERT_OK_AND_ASSIGN(auto map_id,
+                           test_executor_->CreateValue(FederatedMapV()));
+  TFF_ASSERT_OK_AND_ASSIGN(auto fn_at_fed_exec_id,
+                           test_executor_->CreateValue(function));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto arg_id, test_executor_->CreateStruct({fn_at_fed_exec_id, input_id}));
+  EXPECT_THAT(test_executor_->CreateCall(map_id, arg_id),
+              StatusIs(StatusCode::kInternal, HasSubstr("client call failed")));
+}
+
+TEST_F(FederatingExecutorTest, CreateCallFederatedMapAtClientsStacked) {
+  TFF_ASSERT_OK_AND_ASSIGN(
+      test_executor_,
+      tensorflow_federated::CreateFederatingExecutor(
+          mock_server_executor_, mock_client_executor_,
+          {{"clients", NUM_CLIENTS}}, /*aggregate_fan_in=*/0,
+          /*max_concurrent_client_calls=*/-1, ThreadPoolPolicy::kSingleQueue,
+          /*runtime=*/nullptr, /*stack_client_values=*/true));
+  std::vector<v0::Value> client_vals;
+  std::vector<int32_t> stacked_vals;
+  std::vector<v0::Value> result_vals;
+  std::vector<int32_t> stacked_result_vals;
+  for (int i = 0; i < NUM_CLIENTS; i++) {
+    client_vals.emplace_back(TensorV(i));
+    stacked_vals.push_back(i);
+    result_vals.emplace_back(TensorV(2 * i));
+    stacked_result_vals.push_back(2 * i);
+  }
+  // The values of all clients are created, and mapped, in a single value of
+  // the client child.
+  ValueId stacked_child_id =
+      ExpectCreateInClientChild(TensorVFromIntList(stacked_vals));
+  TFF_ASSERT_OK_AND_ASSIGN(auto input_id,
+                           test_executor_->CreateValue(ClientsV(client_vals)));
+  v0::Value function = TensorV(2);
+  auto fn_id = ExpectCreateInClientChild(function);
+  ValueId result_child_id =
+      ExpectCreateCallInClientChild(fn_id, stacked_child_id);
+  ExpectMaterializeInClientChild(result_child_id,
+                                 TensorVFromIntList(stacked_result_vals));
+  TFF_ASSERT_OK_AND_ASSIGN(auto map_id,
+                           test_executor_->CreateValue(FederatedMapV()));
+  TFF_ASSERT_OK_AND_ASSIGN(auto fn_at_fed_exec_id,
+                           test_executor_->CreateValue(function));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto arg_id, test_executor_->CreateStruct({fn_at_fed_exec_id, input_id}));
+  TFF_ASSERT_OK_AND_ASSIGN(auto result_id,
+                           test_executor_->CreateCall(map_id, arg_id));
+  ExpectMaterialize(result_id, ClientsV(result_vals));
+}
+
+TEST_F(FederatingExecutorTest, CreateCallFederatedZipAtClientsUnstacksOnce) {
+  TFF_ASSERT_OK_AND_ASSIGN(
+      test_executor_,
+      tensorflow_federated::CreateFederatingExecutor(
+          mock_server_executor_, mock_client_executor_,
+          {{"clients", NUM_CLIENTS}}, /*aggregate_fan_in=*/0,
+          /*max_concurrent_client_calls=*/-1, ThreadPoolPolicy::kSingleQueue,
+          /*runtime=*/nullptr, /*stack_client_values=*/true));
+  std::vector<v0::Value> client_vals;
+  std::vector<int32_t> stacked_vals;
+  for (int i = 0; i < NUM_CLIENTS; i++) {
+    client_vals.emplace_back(TensorV(i));
+    stacked_vals.push_back(i);
+  }
+  v0::Value stacked = TensorVFromIntList(stacked_vals);
+  ValueId stacked_child_id = ExpectCreateInClientChild(stacked);
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto v_id, test_executor_->CreateValue(StructV({ClientsV(client_vals)})));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto zip_id, test_executor_->CreateValue(FederatedZipAtClientsV()));
+  // The stacked value is materialized once to create the values of its
+  // clients, which both zips use.
+  ExpectMaterializeInClientChild(stacked_child_id, stacked);
+  std::vector<v0::Value> result_vals;
+  for (int i = 0; i < NUM_CLIENTS; i++) {
+    ValueId client_child_id = ExpectCreateInClientChild(client_vals[i]);
+    ValueId struct_child_id = ExpectCreateStructInClientChild(
+        {client_child_id}, ::testing::Exactly(2));
+    result_vals.push_back(StructV({client_vals[i]}));
+    ExpectMaterializeInClientChild(struct_child_id, result_vals.back());
+  }
+  TFF_ASSERT_OK_AND_ASSIGN(auto result_id,
+                           test_executor_->CreateCall(zip_id, v_id));
+  TFF_ASSERT_OK(test_executor_->CreateCall(zip_id, v_id));
+  ExpectMaterialize(result_id, ClientsV(result_vals));
+}
+
 TEST_F(FederatingExecutorTest, CreateCallFederatedMapAllEqualAtClients) {
   std::vector<v0::Value> client_vals;
   std::vector<ValueId> client_vals_child_ids;
@@ -542,10 +816,9 @@ TEST_F(FederatingExecutorTest, CreateCallFederatedSelectUniqueKeyPerClient) {
   OwnedValueId server_value_id =
       TFF_ASSERT_OK(test_executor_->CreateValue(ServerV(server_value)));
   ValueId args_into_sequence_id =
-      ExpectCreateInServerChild(ArgsIntoSequenceV());
+      ExpectCreateInClientChild(ArgsIntoSequenceV());
   std::vector<v0::Value> keys_pbs;
   std::vector<v0::Value> dataset_pbs;
-  std::vector<ValueId> dataset_ids;
 
   ValueId select_fn_server_id = ExpectCreateInServerChild(TensorV("select_fn"));
   for (int32_t i = 0; i < NUM_CLIENTS; i++) {
@@ -557,15 +830,17 @@ TEST_F(FederatingExecutorTest, CreateCallFederatedSelectUniqueKeyPerClient) {
         ExpectCreateStructInServerChild({server_value_child_id, key_id});
     ValueId slice_id =
         ExpectCreateCallInServerChild(select_fn_server_id, select_fn_args_id);
-    ValueId slices_id = ExpectCreateStructInServerChild({slice_id});
+    // The slice is sent to the client child, where the dataset is created.
+    v0::Value slice_pb = TensorV(i * 10);
+    ExpectMaterializeInServerChild(slice_id, slice_pb);
+    ValueId client_slice_id = ExpectCreateInClientChild(slice_pb);
+    ValueId slices_id = ExpectCreateStructInClientChild({client_slice_id});
     ValueId dataset_id =
-        ExpectCreateCallInServerChild(args_into_sequence_id, slices_id);
+        ExpectCreateCallInClientChild(args_into_sequence_id, slices_id);
 
     v0::Value dataset_pb = SequenceV(i, i + 1, 1);
-    dataset_ids.push_back(dataset_id);
     dataset_pbs.push_back(dataset_pb);
-    ExpectMaterializeInServerChild(dataset_id, dataset_pb);
-    ExpectCreateMaterializeInClientChild(dataset_pb);
+    ExpectMaterializeInClientChild(dataset_id, dataset_pb);
   }
   OwnedValueId keys_id =
       TFF_ASSERT_OK(test_executor_->CreateValue(ClientsV(keys_pbs)));
@@ -588,31 +863,32 @@ TEST_F(FederatingExecutorTest, CreateCallFederatedSelectAllClientsSameKeys) {
   OwnedValueId server_value_id =
       TFF_ASSERT_OK(test_executor_->CreateValue(ServerV(server_value)));
   ValueId args_into_sequence_id =
-      ExpectCreateInServerChild(ArgsIntoSequenceV());
+      ExpectCreateInClientChild(ArgsIntoSequenceV());
   std::vector<int32_t> keys({1, 2, 3});
   v0::Value keys_pb = TensorVFromIntList(keys);
-  std::vector<ValueId> slice_child_ids;
-  // Every unique key should only have its slice created once (not once per
-  // client).
+  std::vector<ValueId> client_slice_ids;
+  // Every unique key should only have its slice created, and sent to the
+  // client child, once (not once per client).
   for (int32_t key : keys) {
     ValueId key_id = ExpectCreateInServerChild(TensorV(key));
     ValueId select_fn_args_id =
         ExpectCreateStructInServerChild({server_value_child_id, key_id});
     ValueId slice_id =
         ExpectCreateCallInServerChild(select_fn.child_id, select_fn_args_id);
-    slice_child_ids.push_back(slice_id);
+    v0::Value slice_pb = TensorV(key * 10);
+    ExpectMaterializeInServerChild(slice_id, slice_pb);
+    client_slice_ids.push_back(ExpectCreateInClientChild(slice_pb));
   }
   // However, each client should still create its own dataset from the slices:
   // we don't yet bother to optimize for the case where clients have the exact
   // same list of keys, as that should be less frequent in practice.
   ExpectCreateMaterializeInClientChild(keys_pb, ONCE_PER_CLIENT);
   ValueId slices_id =
-      ExpectCreateStructInServerChild(slice_child_ids, ONCE_PER_CLIENT);
-  ValueId dataset_id = ExpectCreateCallInServerChild(
+      ExpectCreateStructInClientChild(client_slice_ids, ONCE_PER_CLIENT);
+  ValueId dataset_id = ExpectCreateCallInClientChild(
       args_into_sequence_id, slices_id, ONCE_PER_CLIENT);
   v0::Value dataset_pb = SequenceV(0, 10, 2);
-  ExpectMaterializeInServerChild(dataset_id, dataset_pb, ONCE_PER_CLIENT);
-  ExpectCreateMaterializeInClientChild(dataset_pb, ONCE_PER_CLIENT);
+  ExpectMaterializeInClientChild(dataset_id, dataset_pb, ONCE_PER_CLIENT);
   std::vector<v0::Value> keys_pbs;
   keys_pbs.resize(NUM_CLIENTS, keys_pb);
   std::vector<v0::Value> dataset_pbs;
@@ -627,6 +903,101 @@ TEST_F(FederatingExecutorTest, CreateCallFederatedSelectAllClientsSameKeys) {
   ExpectMaterialize(result_id, ClientsV(dataset_pbs));
 }
 
+TEST_F(FederatingExecutorTest, CreateCallFederatedSelectConcurrently) {
+  TFF_ASSERT_OK_AND_ASSIGN(
+      test_executor_,
+      tensorflow_federated::CreateFederatingExecutor(
+          mock_server_executor_, mock_client_executor_,
+          {{"clients", NUM_CLIENTS}}, /*aggregate_fan_in=*/0,
+          /*max_concurrent_client_calls=*/4));
+  OwnedValueId select_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(FederatedSelectV()));
+  IdPair select_fn =
+      TFF_ASSERT_OK(CreatePassthroughValue(TensorV("select_fn")));
+  TFF_ASSERT_OK_AND_ASSIGN(auto max_key,
+                           test_executor_->CreateValue(TensorV("max_key")));
+  v0::Value server_value = TensorV("server_val");
+  ValueId server_value_child_id = ExpectCreateInServerChild(server_value);
+  OwnedValueId server_value_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(ServerV(server_value)));
+  ValueId args_into_sequence_id =
+      ExpectCreateInClientChild(ArgsIntoSequenceV());
+  // Keys materialized concurrently by different clients are deduplicated.
+  std::vector<int32_t> keys({1, 2});
+  std::vector<ValueId> client_slice_ids;
+  for (int32_t key : keys) {
+    ValueId key_id = ExpectCreateInServerChild(TensorV(key));
+    ValueId select_fn_args_id =
+        ExpectCreateStructInServerChild({server_value_child_id, key_id});
+    ValueId slice_id =
+        ExpectCreateCallInServerChild(select_fn.child_id, select_fn_args_id);
+    v0::Value slice_pb = TensorV(key * 10);
+    ExpectMaterializeInServerChild(slice_id, slice_pb);
+    client_slice_ids.push_back(ExpectCreateInClientChild(slice_pb));
+  }
+  v0::Value keys_pb = TensorVFromIntList(keys);
+  ExpectCreateMaterializeInClientChild(keys_pb, ONCE_PER_CLIENT);
+  ValueId slices_id =
+      ExpectCreateStructInClientChild(client_slice_ids, ONCE_PER_CLIENT);
+  ValueId dataset_id = ExpectCreateCallInClientChild(
+      args_into_sequence_id, slices_id, ONCE_PER_CLIENT);
+  v0::Value dataset_pb = SequenceV(0, 10, 2);
+  ExpectMaterializeInClientChild(dataset_id, dataset_pb, ONCE_PER_CLIENT);
+  OwnedValueId keys_id = TFF_ASSERT_OK(test_executor_->CreateValue(
+      ClientsV(std::vector<v0::Value>(NUM_CLIENTS, keys_pb))));
+  OwnedValueId select_args_id = TFF_ASSERT_OK(test_executor_->CreateStruct(
+      {keys_id, max_key, server_value_id, select_fn.id}));
+  OwnedValueId result_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(select_id, select_args_id));
+  ExpectMaterialize(result_id,
+                    ClientsV(std::vector<v0::Value>(NUM_CLIENTS, dataset_pb)));
+}
+
+TEST_F(FederatingExecutorTest,
+       CreateCallFederatedSelectSharedChildDoesNotTransferSlices) {
+  auto mock_executor = std::make_shared<::testing::StrictMock<MockExecutor>>();
+  TFF_ASSERT_OK_AND_ASSIGN(test_executor_,
+                           tensorflow_federated::CreateFederatingExecutor(
+                               mock_executor, mock_executor,
+                               {{"clients", NUM_CLIENTS}}));
+  OwnedValueId select_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(FederatedSelectV()));
+  ValueId select_fn_child_id =
+      mock_executor->ExpectCreateValue(TensorV("select_fn"));
+  OwnedValueId select_fn =
+      TFF_ASSERT_OK(test_executor_->CreateValue(TensorV("select_fn")));
+  OwnedValueId max_key =
+      TFF_ASSERT_OK(test_executor_->CreateValue(TensorV("max_key")));
+  v0::Value server_value = TensorV("server_val");
+  ValueId server_value_child_id =
+      mock_executor->ExpectCreateValue(server_value);
+  OwnedValueId server_value_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(ServerV(server_value)));
+  v0::Value keys_pb = TensorVFromIntList({1});
+  ValueId keys_child_id =
+      mock_executor->ExpectCreateValue(keys_pb, ONCE_PER_CLIENT);
+  mock_executor->ExpectMaterialize(keys_child_id, keys_pb, ONCE_PER_CLIENT);
+  ValueId key_id = mock_executor->ExpectCreateValue(TensorV(1));
+  ValueId select_fn_args_id =
+      mock_executor->ExpectCreateStruct({server_value_child_id, key_id});
+  // The slice is used in place, without being materialized.
+  ValueId slice_id =
+      mock_executor->ExpectCreateCall(select_fn_child_id, select_fn_args_id);
+  ValueId args_into_sequence_id =
+      mock_executor->ExpectCreateValue(ArgsIntoSequenceV());
+  ValueId slices_id =
+      mock_executor->ExpectCreateStruct({slice_id}, ONCE_PER_CLIENT);
+  mock_executor->ExpectCreateCall(args_into_sequence_id, slices_id,
+                                  ONCE_PER_CLIENT);
+  std::vector<v0::Value> keys_pbs;
+  keys_pbs.resize(NUM_CLIENTS, keys_pb);
+  OwnedValueId keys_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(ClientsV(keys_pbs)));
+  OwnedValueId select_args_id = TFF_ASSERT_OK(test_executor_->CreateStruct(
+      {keys_id, max_key, server_value_id, select_fn}));
+  TFF_ASSERT_OK(test_executor_->CreateCall(select_id, select_args_id));
+}
+
 TEST_F(FederatingExecutorTest, CreateCallFederatedSelectNonInt32KeysFails) {
   OwnedValueId select_id =
       TFF_ASSERT_OK(test_executor_->CreateValue(FederatedSelectV()));
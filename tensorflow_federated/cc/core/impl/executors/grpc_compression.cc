@@ -0,0 +1,41 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/grpc_compression.h"
+
+#include <string_view>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "include/grpc/compression.h"
+
+namespace tensorflow_federated {
+
+absl::StatusOr<grpc_compression_algorithm> CompressionAlgorithmFromName(
+    std::string_view name) {
+  if (name == "none") {
+    return GRPC_COMPRESS_NONE;
+  } else if (name == "deflate") {
+    return GRPC_COMPRESS_DEFLATE;
+  } else if (name == "gzip") {
+    return GRPC_COMPRESS_GZIP;
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unknown gRPC compression algorithm '", name,
+                   "', expected one of 'none', 'deflate' or 'gzip'."));
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,37 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_GRPC_COMPRESSION_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_GRPC_COMPRESSION_H_
+
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "include/grpc/compression.h"
+
+namespace tensorflow_federated {
+
+// Returns the gRPC message compression algorithm named `name`, one of "none",
+// "deflate" or "gzip".
+//
+// Setting the algorithm on a channel compresses the requests sent through it,
+// and setting it on a server compresses the responses to clients which
+// advertise support for it; gRPC peers accept all of them by default.
+absl::StatusOr<grpc_compression_algorithm> CompressionAlgorithmFromName(
+    std::string_view name);
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_GRPC_COMPRESSION_H_
@@ -0,0 +1,41 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/grpc_compression.h"
+
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "include/grpc/compression.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+namespace {
+
+TEST(CompressionAlgorithmFromNameTest, ReturnsKnownAlgorithms) {
+  EXPECT_THAT(CompressionAlgorithmFromName("none"),
+              IsOkAndHolds(GRPC_COMPRESS_NONE));
+  EXPECT_THAT(CompressionAlgorithmFromName("deflate"),
+              IsOkAndHolds(GRPC_COMPRESS_DEFLATE));
+  EXPECT_THAT(CompressionAlgorithmFromName("gzip"),
+              IsOkAndHolds(GRPC_COMPRESS_GZIP));
+}
+
+TEST(CompressionAlgorithmFromNameTest, FailsOnUnknownAlgorithm) {
+  EXPECT_THAT(CompressionAlgorithmFromName("zstd"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -0,0 +1,245 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/memoizing_executor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using SharedId = std::shared_ptr<const OwnedValueId>;
+
+// A value of the `MemoizingExecutor`.
+struct MemoizedValue {
+  // The value in the child.
+  SharedId child_value;
+  // The fingerprint of the content of the value, if it is known.
+  std::optional<std::string> key;
+  // Whether the value is a deterministic computation, whose calls are
+  // memoized.
+  bool deterministic = false;
+  // Whether the value is the result of a call of a deterministic computation
+  // which is not memoized yet, and should be once materialized.
+  bool memoize_on_materialize = false;
+};
+
+using ValuePtr = std::shared_ptr<const MemoizedValue>;
+
+// Returns a fingerprint of `key_parts`, so that the key of a value stays short
+// however deep the values it is derived from are nested.
+std::string Fingerprint(std::string_view key_parts) {
+  const tensorflow::Fprint128 fingerprint =
+      tensorflow::Fingerprint128(key_parts);
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+// Records a lookup of a memoized call to the default `MetricsRegistry`.
+void RecordLookup(bool hit) {
+  static Counter* const hits =
+      MetricsRegistry::Default().GetCounter("MemoizingExecutor::CallHits");
+  static Counter* const misses =
+      MetricsRegistry::Default().GetCounter("MemoizingExecutor::CallMisses");
+  if (MetricsEnabled()) {
+    (hit ? hits : misses)->Increment();
+  }
+}
+
+class MemoizingExecutor : public ExecutorBase<ValuePtr> {
+ public:
+  MemoizingExecutor(std::shared_ptr<Executor> child,
+                    MemoizingExecutorOptions options)
+      : child_(std::move(child)),
+        is_deterministic_(std::move(options.is_deterministic)),
+        results_(options.capacity_bytes) {}
+
+ protected:
+  std::string_view ExecutorName() final {
+    static constexpr std::string_view kExecutorName = "MemoizingExecutor";
+    return kExecutorName;
+  }
+
+  absl::StatusOr<ValuePtr> CreateExecutorValue(
+      const v0::Value& value_pb) final {
+    auto value = std::make_shared<MemoizedValue>();
+    value->child_value = std::make_shared<const OwnedValueId>(
+        TFF_TRY(child_->CreateValue(value_pb)));
+    value->key = ValueContentHash(value_pb);
+    value->deterministic = value_pb.has_computation() &&
+                           is_deterministic_ != nullptr &&
+                           is_deterministic_(value_pb.computation());
+    return value;
+  }
+
+  absl::StatusOr<ValuePtr> CreateCall(ValuePtr function,
+                                      std::optional<ValuePtr> argument) final {
+    std::optional<std::string> key;
+    if (function->key.has_value() &&
+        (!argument.has_value() || (*argument)->key.has_value())) {
+      key = Fingerprint(absl::StrCat(
+          "call:", *function->key, "(",
+          argument.has_value() ? *(*argument)->key : "", ")"));
+    }
+    if (!function->deterministic || !key.has_value()) {
+      auto value = std::make_shared<MemoizedValue>();
+      value->child_value = TFF_TRY(ChildCall(function, argument));
+      // The result of a non-deterministic call may differ from that of an
+      // identical one, so it has no content key.
+      return value;
+    }
+    auto value = std::make_shared<MemoizedValue>();
+    value->key = key;
+    SharedId live_value = LookupLiveCall(*key);
+    if (live_value != nullptr) {
+      RecordLookup(/*hit=*/true);
+      value->child_value = std::move(live_value);
+      return value;
+    }
+    std::shared_ptr<const v0::Value> result_pb = results_.Lookup(*key);
+    RecordLookup(/*hit=*/result_pb != nullptr);
+    if (result_pb != nullptr) {
+      value->child_value = std::make_shared<const OwnedValueId>(
+          TFF_TRY(child_->CreateValue(*result_pb)));
+    } else {
+      value->child_value = TFF_TRY(ChildCall(function, argument));
+      value->memoize_on_materialize = true;
+    }
+    InsertLiveCall(*key, value->child_value);
+    return value;
+  }
+
+  absl::StatusOr<ValuePtr> CreateStruct(std::vector<ValuePtr> members) final {
+    std::vector<ValueId> child_members;
+    child_members.reserve(members.size());
+    std::optional<std::string> key_parts = "struct:";
+    for (const ValuePtr& member : members) {
+      child_members.push_back(member->child_value->ref());
+      if (key_parts.has_value() && member->key.has_value()) {
+        absl::StrAppend(&*key_parts, *member->key, ",");
+      } else {
+        key_parts = std::nullopt;
+      }
+    }
+    auto value = std::make_shared<MemoizedValue>();
+    value->child_value = std::make_shared<const OwnedValueId>(
+        TFF_TRY(child_->CreateStruct(child_members)));
+    if (key_parts.has_value()) {
+      value->key = Fingerprint(*key_parts);
+    }
+    return value;
+  }
+
+  absl::StatusOr<ValuePtr> CreateSelection(ValuePtr source,
+                                           const uint32_t index) final {
+    auto value = std::make_shared<MemoizedValue>();
+    value->child_value = std::make_shared<const OwnedValueId>(
+        TFF_TRY(child_->CreateSelection(source->child_value->ref(), index)));
+    if (source->key.has_value()) {
+      value->key = Fingerprint(
+          absl::StrCat("selection:", *source->key, "[", index, "]"));
+    }
+    return value;
+  }
+
+  absl::Status Materialize(ValuePtr value, v0::Value* value_pb) final {
+    TFF_TRY(child_->Materialize(value->child_value->ref(), value_pb));
+    if (value->memoize_on_materialize) {
+      results_.Insert(*value->key,
+                      std::make_shared<const v0::Value>(*value_pb));
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::StatusOr<SharedId> ChildCall(const ValuePtr& function,
+                                     const std::optional<ValuePtr>& argument) {
+    std::optional<ValueId> child_argument;
+    if (argument.has_value()) {
+      child_argument = (*argument)->child_value->ref();
+    }
+    return std::make_shared<const OwnedValueId>(TFF_TRY(
+        child_->CreateCall(function->child_value->ref(), child_argument)));
+  }
+
+  // Returns the child value of a call under `key` which is still alive, or
+  // nullptr if there is none.
+  SharedId LookupLiveCall(const std::string& key) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    auto it = live_calls_.find(key);
+    if (it == live_calls_.end()) {
+      return nullptr;
+    }
+    return it->second.lock();
+  }
+
+  void InsertLiveCall(std::string key, const SharedId& child_value)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    live_calls_.insert_or_assign(std::move(key), child_value);
+    // Drop the calls which are no longer alive whenever the number of calls
+    // doubles, so that the map is bounded by twice the number of live calls.
+    if (live_calls_.size() >= 2 * live_calls_after_sweep_) {
+      absl::erase_if(live_calls_,
+                     [](const auto& entry) { return entry.second.expired(); });
+      live_calls_after_sweep_ = std::max<size_t>(live_calls_.size(), 1);
+    }
+  }
+
+  const std::shared_ptr<Executor> child_;
+  const std::function<bool(const v0::Computation&)> is_deterministic_;
+  // The materialized results of calls of deterministic computations, keyed by
+  // the fingerprint of the call.
+  ValueCache results_;
+  absl::Mutex mutex_;
+  // The child values of the calls of deterministic computations, keyed by the
+  // fingerprint of the call.
+  absl::flat_hash_map<std::string, std::weak_ptr<const OwnedValueId>>
+      live_calls_ ABSL_GUARDED_BY(mutex_);
+  size_t live_calls_after_sweep_ ABSL_GUARDED_BY(mutex_) = 1;
+};
+
+}  // namespace
+
+std::shared_ptr<Executor> CreateMemoizingExecutor(
+    std::shared_ptr<Executor> child, MemoizingExecutorOptions options) {
+  return std::make_shared<MemoizingExecutor>(std::move(child),
+                                             std::move(options));
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,64 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_MEMOIZING_EXECUTOR_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_MEMOIZING_EXECUTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+
+namespace tensorflow_federated {
+
+inline constexpr int64_t kDefaultMemoizedResultsCapacityBytes =
+    int64_t{256} << 20;
+
+struct MemoizingExecutorOptions {
+  // Returns whether the results of calls of `computation_pb` only depend on
+  // their arguments, e.g. since the computation initializes a model from a
+  // fixed seed or evaluates on a fixed dataset. Only calls of such
+  // computations are memoized. If unset, no calls are memoized.
+  std::function<bool(const v0::Computation& computation_pb)> is_deterministic;
+  // The maximum total serialized size of the memoized results.
+  int64_t capacity_bytes = kDefaultMemoizedResultsCapacityBytes;
+};
+
+// Returns an executor which forwards to `child`, and memoizes the results of
+// calls of deterministic computations on content-identical arguments.
+//
+// Values are identified by a fingerprint of their content: values created with
+// `CreateValue` by that of their proto, and structs, selections and call
+// results by those of the values they are derived from. A call of a
+// deterministic computation then:
+//
+// - shares the value of an identical call which is still alive in `child`,
+//   rather than calling the computation again.
+// - otherwise creates the result in `child` from the materialized result of an
+//   identical earlier call, e.g. in a previous round, if it is memoized.
+// - otherwise calls the computation in `child`. Its result is memoized once it
+//   is materialized, and the least recently used results are evicted once
+//   their total size exceeds `options.capacity_bytes`.
+//
+// Creating a value computes the fingerprint of its proto, which requires a
+// serialization of it.
+std::shared_ptr<Executor> CreateMemoizingExecutor(
+    std::shared_ptr<Executor> child, MemoizingExecutorOptions options);
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_MEMOIZING_EXECUTOR_H_
@@ -0,0 +1,196 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/memoizing_executor.h"
+
+#include <memory>
+#include <optional>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_test_base.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::tensorflow_federated::testing::IntrinsicV;
+using ::tensorflow_federated::testing::StructV;
+using ::tensorflow_federated::testing::TensorV;
+using ::testing::StrictMock;
+
+constexpr char kDeterministicUri[] = "deterministic_fn";
+
+class MemoizingExecutorTest : public ExecutorTestBase {
+ public:
+  MemoizingExecutorTest() {
+    MemoizingExecutorOptions options;
+    options.is_deterministic = [](const v0::Computation& computation_pb) {
+      return computation_pb.intrinsic().uri() == kDeterministicUri;
+    };
+    test_executor_ = CreateMemoizingExecutor(mock_executor_, options);
+  }
+
+  ~MemoizingExecutorTest() override = default;
+
+ protected:
+  std::shared_ptr<StrictMock<MockExecutor>> mock_executor_ =
+      std::make_shared<StrictMock<MockExecutor>>();
+};
+
+TEST_F(MemoizingExecutorTest, CreateValueDelegatesToChild) {
+  v0::Value value = TensorV(1);
+  mock_executor_->ExpectCreateMaterialize(value);
+  ExpectCreateMaterialize(value);
+}
+
+TEST_F(MemoizingExecutorTest, IdenticalLiveCallsShareChildValue) {
+  v0::Value fn = IntrinsicV(kDeterministicUri);
+  v0::Value arg = TensorV(1);
+  ValueId fn_child_id = mock_executor_->ExpectCreateValue(fn);
+  ValueId arg_child_id = mock_executor_->ExpectCreateValue(arg);
+  ValueId call_child_id =
+      mock_executor_->ExpectCreateCall(fn_child_id, arg_child_id);
+  v0::Value result = TensorV(2);
+  mock_executor_->ExpectMaterialize(call_child_id, result,
+                                    ::testing::Exactly(2));
+
+  OwnedValueId fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(fn));
+  OwnedValueId arg_id = TFF_ASSERT_OK(test_executor_->CreateValue(arg));
+  OwnedValueId call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+  OwnedValueId other_call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+  ExpectMaterialize(call_id, result);
+  ExpectMaterialize(other_call_id, result);
+}
+
+TEST_F(MemoizingExecutorTest, ReusesMaterializedResultOfDisposedCall) {
+  v0::Value fn = IntrinsicV(kDeterministicUri);
+  v0::Value arg = TensorV(1);
+  ValueId fn_child_id = mock_executor_->ExpectCreateValue(fn);
+  ValueId arg_child_id = mock_executor_->ExpectCreateValue(arg);
+  ValueId call_child_id =
+      mock_executor_->ExpectCreateCall(fn_child_id, arg_child_id);
+  v0::Value result = TensorV(2);
+  mock_executor_->ExpectMaterialize(call_child_id, result);
+  // The identical call of a later round creates the memoized result instead.
+  ValueId result_child_id = mock_executor_->ExpectCreateValue(result);
+  mock_executor_->ExpectMaterialize(result_child_id, result);
+
+  OwnedValueId fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(fn));
+  OwnedValueId arg_id = TFF_ASSERT_OK(test_executor_->CreateValue(arg));
+  {
+    OwnedValueId call_id =
+        TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+    ExpectMaterialize(call_id, result);
+  }
+  OwnedValueId call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+  ExpectMaterialize(call_id, result);
+}
+
+TEST_F(MemoizingExecutorTest, MemoizesCallsOnContentIdenticalStructs) {
+  v0::Value fn = IntrinsicV(kDeterministicUri);
+  v0::Value member = TensorV(1);
+  ValueId fn_child_id = mock_executor_->ExpectCreateValue(fn);
+  ValueId member_child_id =
+      mock_executor_->ExpectCreateValue(member, ::testing::Exactly(2));
+  ValueId struct_child_id = mock_executor_->ExpectCreateStruct(
+      {member_child_id}, ::testing::Exactly(2));
+  mock_executor_->ExpectCreateCall(fn_child_id, struct_child_id);
+
+  OwnedValueId fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(fn));
+  OwnedValueId member_id = TFF_ASSERT_OK(test_executor_->CreateValue(member));
+  OwnedValueId arg_id =
+      TFF_ASSERT_OK(test_executor_->CreateStruct({member_id}));
+  OwnedValueId other_member_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(member));
+  OwnedValueId other_arg_id =
+      TFF_ASSERT_OK(test_executor_->CreateStruct({other_member_id}));
+  OwnedValueId call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+  OwnedValueId other_call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, other_arg_id));
+}
+
+TEST_F(MemoizingExecutorTest, DoesNotMemoizeCallsOnDifferentArguments) {
+  v0::Value fn = IntrinsicV(kDeterministicUri);
+  ValueId fn_child_id = mock_executor_->ExpectCreateValue(fn);
+  ValueId arg_child_id = mock_executor_->ExpectCreateValue(TensorV(1));
+  ValueId other_arg_child_id = mock_executor_->ExpectCreateValue(TensorV(2));
+  mock_executor_->ExpectCreateCall(fn_child_id, arg_child_id);
+  mock_executor_->ExpectCreateCall(fn_child_id, other_arg_child_id);
+
+  OwnedValueId fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(fn));
+  OwnedValueId arg_id = TFF_ASSERT_OK(test_executor_->CreateValue(TensorV(1)));
+  OwnedValueId other_arg_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(TensorV(2)));
+  OwnedValueId call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+  OwnedValueId other_call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, other_arg_id));
+}
+
+TEST_F(MemoizingExecutorTest, DoesNotMemoizeCallsOfOtherComputations) {
+  v0::Value fn = IntrinsicV("other_fn");
+  v0::Value arg = TensorV(1);
+  ValueId fn_child_id = mock_executor_->ExpectCreateValue(fn);
+  ValueId arg_child_id = mock_executor_->ExpectCreateValue(arg);
+  ValueId call_child_id = mock_executor_->ExpectCreateCall(
+      fn_child_id, arg_child_id, ::testing::Exactly(2));
+  v0::Value result = TensorV(2);
+  mock_executor_->ExpectMaterialize(call_child_id, result,
+                                    ::testing::Exactly(2));
+
+  OwnedValueId fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(fn));
+  OwnedValueId arg_id = TFF_ASSERT_OK(test_executor_->CreateValue(arg));
+  for (int i = 0; i < 2; ++i) {
+    OwnedValueId call_id =
+        TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+    ExpectMaterialize(call_id, result);
+  }
+}
+
+TEST_F(MemoizingExecutorTest, DoesNotMemoizeResultsLargerThanCapacity) {
+  MemoizingExecutorOptions options;
+  options.is_deterministic = [](const v0::Computation&) { return true; };
+  options.capacity_bytes = 1;
+  test_executor_ = CreateMemoizingExecutor(mock_executor_, options);
+  v0::Value fn = IntrinsicV(kDeterministicUri);
+  ValueId fn_child_id = mock_executor_->ExpectCreateValue(fn);
+  ValueId call_child_id = mock_executor_->ExpectCreateCall(
+      fn_child_id, std::nullopt, ::testing::Exactly(2));
+  v0::Value result = StructV({TensorV(1), TensorV(2)});
+  mock_executor_->ExpectMaterialize(call_child_id, result,
+                                    ::testing::Exactly(2));
+
+  OwnedValueId fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(fn));
+  for (int i = 0; i < 2; ++i) {
+    OwnedValueId call_id =
+        TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, std::nullopt));
+    ExpectMaterialize(call_id, result);
+  }
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
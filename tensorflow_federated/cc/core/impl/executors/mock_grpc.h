@@ -24,6 +24,7 @@ limitations under the License
 #include "include/grpcpp/security/credentials.h"
 #include "include/grpcpp/security/server_credentials.h"
 #include "include/grpcpp/support/status.h"
+#include "include/grpcpp/support/sync_stream.h"
 #include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
 
@@ -31,12 +32,27 @@ namespace tensorflow_federated {
 
 class MockGrpcExecutorService : public v0::ExecutorGroup::Service {
  public:
+  // Like services which predate them, `ComputeStream` and `GetLocalityKeys`
+  // are unimplemented unless a test expects calls to them.
+  MockGrpcExecutorService() {
+    ON_CALL(*this, ComputeStream)
+        .WillByDefault(::testing::Return(
+            grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "")));
+    ON_CALL(*this, GetLocalityKeys)
+        .WillByDefault(::testing::Return(
+            grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "")));
+  }
+
   MOCK_METHOD(grpc::Status, GetExecutor,
               (grpc::ServerContext*, const v0::GetExecutorRequest*,
                v0::GetExecutorResponse*));
   MOCK_METHOD(grpc::Status, CreateValue,
               (grpc::ServerContext*, const v0::CreateValueRequest*,
                v0::CreateValueResponse*));
+  MOCK_METHOD(grpc::Status, CreateValueStream,
+              (grpc::ServerContext*,
+               grpc::ServerReader<v0::CreateValueStreamRequest>*,
+               v0::CreateValueResponse*));
   MOCK_METHOD(grpc::Status, CreateCall,
               (grpc::ServerContext*, const v0::CreateCallRequest*,
                v0::CreateCallResponse*));
@@ -49,12 +65,27 @@ class MockGrpcExecutorService : public v0::ExecutorGroup::Service {
   MOCK_METHOD(grpc::Status, Compute,
               (grpc::ServerContext*, const v0::ComputeRequest*,
                v0::ComputeResponse*));
+  MOCK_METHOD(grpc::Status, ComputeStream,
+              (grpc::ServerContext*, const v0::ComputeRequest*,
+               grpc::ServerWriter<v0::ComputeStreamResponse>*));
+  MOCK_METHOD(grpc::Status, ExecuteBatch,
+              (grpc::ServerContext*, const v0::ExecuteBatchRequest*,
+               v0::ExecuteBatchResponse*));
   MOCK_METHOD(grpc::Status, Dispose,
               (grpc::ServerContext*, const v0::DisposeRequest*,
                v0::DisposeResponse*));
   MOCK_METHOD(grpc::Status, DisposeExecutor,
               (grpc::ServerContext*, const v0::DisposeExecutorRequest*,
                v0::DisposeExecutorResponse*));
+  MOCK_METHOD(grpc::Status, GetCachedValue,
+              (grpc::ServerContext*, const v0::GetCachedValueRequest*,
+               v0::GetCachedValueResponse*));
+  MOCK_METHOD(grpc::Status, GetLocalityKeys,
+              (grpc::ServerContext*, const v0::GetLocalityKeysRequest*,
+               v0::GetLocalityKeysResponse*));
+  MOCK_METHOD(grpc::Status, SnapshotValue,
+              (grpc::ServerContext*, const v0::SnapshotValueRequest*,
+               v0::SnapshotValueResponse*));
 };
 
 // A minimal, self-contained, OSS-compatible mock GRPC Executor service.
@@ -79,10 +110,13 @@ class MockGrpcExecutorServer {
 
   MockGrpcExecutorService* service() { return &service_; }
 
+  std::shared_ptr<grpc::Channel> NewChannel() {
+    return grpc::CreateChannel(absl::StrCat("localhost:", port_),
+                               grpc::experimental::LocalCredentials(LOCAL_TCP));
+  }
+
   std::unique_ptr<v0::ExecutorGroup::Stub> NewStub() {
-    return v0::ExecutorGroup::NewStub(
-        grpc::CreateChannel(absl::StrCat("localhost:", port_),
-                            grpc::experimental::LocalCredentials(LOCAL_TCP)));
+    return v0::ExecutorGroup::NewStub(NewChannel());
   }
 
  private:
@@ -0,0 +1,81 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_NOOP_EXECUTOR_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_NOOP_EXECUTOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+// An executor which only hands out fresh IDs, and materializes every value as
+// an empty `v0::Value`. Benchmarks use it as the child of the executor under
+// test, so that they measure the work of that executor alone.
+//
+// Each `CreateCall` spends `call_latency`, e.g. to simulate the latency of a
+// `CreateCall` RPC to a remote worker.
+class NoOpExecutor : public Executor,
+                     public std::enable_shared_from_this<Executor> {
+ public:
+  explicit NoOpExecutor(absl::Duration call_latency = absl::ZeroDuration())
+      : call_latency_(call_latency) {}
+
+  absl::StatusOr<OwnedValueId> CreateValue(const v0::Value& value_pb) final {
+    return NewValue();
+  }
+  absl::StatusOr<OwnedValueId> CreateCall(
+      const ValueId function,
+      const std::optional<const ValueId> argument) final {
+    if (call_latency_ > absl::ZeroDuration()) {
+      absl::SleepFor(call_latency_);
+    }
+    return NewValue();
+  }
+  absl::StatusOr<OwnedValueId> CreateStruct(
+      const absl::Span<const ValueId> members) final {
+    return NewValue();
+  }
+  absl::StatusOr<OwnedValueId> CreateSelection(const ValueId source,
+                                               const uint32_t index) final {
+    return NewValue();
+  }
+  absl::Status Materialize(const ValueId value, v0::Value* value_pb) final {
+    return absl::OkStatus();
+  }
+  absl::Status Dispose(const ValueId value) final { return absl::OkStatus(); }
+
+ private:
+  OwnedValueId NewValue() {
+    return OwnedValueId(shared_from_this(), next_id_.fetch_add(1));
+  }
+
+  const absl::Duration call_latency_;
+  std::atomic<ValueId> next_id_ = 0;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_NOOP_EXECUTOR_H_
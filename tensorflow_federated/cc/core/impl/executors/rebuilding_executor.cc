@@ -0,0 +1,276 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/rebuilding_executor.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using SharedId = std::shared_ptr<const OwnedValueId>;
+
+// A value of the `RebuildingExecutor`, along with how to create it in a child.
+struct RebuildableValue {
+  enum class Kind { kValue, kCall, kStruct, kSelection };
+
+  Kind kind;
+  // The value of `kValue`s.
+  v0::Value value_pb;
+  // The function and optional argument of `kCall`s, the members of `kStruct`s
+  // and the source of `kSelection`s.
+  std::vector<std::shared_ptr<RebuildableValue>> operands;
+  // The index of `kSelection`s.
+  uint32_t index = 0;
+
+  // The value in the child of generation `generation`, if created there.
+  // Guarded by the mutex of the executor.
+  SharedId child_value;
+  uint64_t generation = 0;
+  // Whether the value was disposed. Disposed values are only kept to recreate
+  // the values which depend on them, and do not keep their child values.
+  // Guarded by the mutex of the executor.
+  bool disposed = false;
+};
+
+using ValuePtr = std::shared_ptr<RebuildableValue>;
+
+// A value tracked by the `RebuildingExecutor`, which marks it as disposed once
+// it is no longer tracked.
+class TrackedValue {
+ public:
+  TrackedValue(ValuePtr value, absl::Mutex* mutex)
+      : value_(std::move(value)), mutex_(mutex) {}
+
+  ~TrackedValue() {
+    absl::MutexLock lock(mutex_);
+    value_->disposed = true;
+    value_->child_value = nullptr;
+  }
+
+  const ValuePtr& value() const { return value_; }
+
+ private:
+  const ValuePtr value_;
+  absl::Mutex* const mutex_;
+};
+
+using TrackedPtr = std::shared_ptr<TrackedValue>;
+
+class RebuildingExecutor : public ExecutorBase<TrackedPtr> {
+ public:
+  RebuildingExecutor(
+      std::function<absl::StatusOr<std::shared_ptr<Executor>>()> create_child,
+      std::function<bool()> child_outdated,
+      int32_t max_rebuilds_per_materialize, std::shared_ptr<Executor> child)
+      : create_child_(std::move(create_child)),
+        child_outdated_(std::move(child_outdated)),
+        max_rebuilds_per_materialize_(max_rebuilds_per_materialize),
+        child_(std::move(child)) {}
+
+  ~RebuildingExecutor() override {
+    // Release the tracked values while `mutex_` is alive.
+    ClearTracked();
+  }
+
+ protected:
+  std::string_view ExecutorName() final {
+    static constexpr std::string_view kExecutorName = "RebuildingExecutor";
+    return kExecutorName;
+  }
+
+  absl::StatusOr<TrackedPtr> CreateExecutorValue(
+      const v0::Value& value_pb) final {
+    auto value = std::make_shared<RebuildableValue>();
+    value->kind = RebuildableValue::Kind::kValue;
+    value->value_pb = value_pb;
+    return Created(std::move(value));
+  }
+
+  absl::StatusOr<TrackedPtr> CreateCall(
+      TrackedPtr function, std::optional<TrackedPtr> argument) final {
+    auto value = std::make_shared<RebuildableValue>();
+    value->kind = RebuildableValue::Kind::kCall;
+    value->operands.push_back(function->value());
+    if (argument.has_value()) {
+      value->operands.push_back((*argument)->value());
+    }
+    return Created(std::move(value));
+  }
+
+  absl::StatusOr<TrackedPtr> CreateStruct(
+      std::vector<TrackedPtr> members) final {
+    auto value = std::make_shared<RebuildableValue>();
+    value->kind = RebuildableValue::Kind::kStruct;
+    value->operands.reserve(members.size());
+    for (const TrackedPtr& member : members) {
+      value->operands.push_back(member->value());
+    }
+    return Created(std::move(value));
+  }
+
+  absl::StatusOr<TrackedPtr> CreateSelection(TrackedPtr source,
+                                             const uint32_t index) final {
+    auto value = std::make_shared<RebuildableValue>();
+    value->kind = RebuildableValue::Kind::kSelection;
+    value->operands.push_back(source->value());
+    value->index = index;
+    return Created(std::move(value));
+  }
+
+  absl::Status Materialize(TrackedPtr tracked_value,
+                           v0::Value* value_pb) final {
+    for (int32_t rebuilds = 0;; ++rebuilds) {
+      std::shared_ptr<Executor> child;
+      SharedId child_value;
+      uint64_t generation;
+      {
+        absl::MutexLock lock(&mutex_);
+        if (child_outdated_()) {
+          TFF_TRY(RebuildChild());
+        }
+        child = child_;
+        generation = generation_;
+        child_value = TFF_TRY(Embed(tracked_value->value()));
+      }
+      absl::Status status = child->Materialize(child_value->ref(), value_pb);
+      if (status.ok() || !absl::IsUnavailable(status) ||
+          rebuilds >= max_rebuilds_per_materialize_) {
+        return status;
+      }
+      LOG(WARNING) << "Rebuilding the child executor after it failed to "
+                      "materialize a value: "
+                   << status;
+      absl::MutexLock lock(&mutex_);
+      // Another materialization may have rebuilt the child meanwhile.
+      if (generation_ == generation) {
+        TFF_TRY(RebuildChild());
+      }
+    }
+  }
+
+ private:
+  // Creates `value` in the current child, so that its computation starts
+  // right away. A child which is unavailable is left to be rebuilt by the
+  // next materialization.
+  absl::StatusOr<TrackedPtr> Created(ValuePtr value) {
+    absl::MutexLock lock(&mutex_);
+    absl::StatusOr<SharedId> child_value = Embed(value);
+    if (!child_value.ok() && !absl::IsUnavailable(child_value.status())) {
+      return child_value.status();
+    }
+    return std::make_shared<TrackedValue>(std::move(value), &mutex_);
+  }
+
+  // Returns `value` in the current child, creating it and the values it
+  // depends on if they were created in a replaced child. The child values of
+  // disposed values are not kept, so that they are released once the values
+  // which depend on them are created.
+  absl::StatusOr<SharedId> Embed(const ValuePtr& value)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    if (value->child_value != nullptr && value->generation == generation_) {
+      return value->child_value;
+    }
+    std::vector<SharedId> operands;
+    operands.reserve(value->operands.size());
+    for (const ValuePtr& operand : value->operands) {
+      operands.push_back(TFF_TRY(Embed(operand)));
+    }
+    std::optional<OwnedValueId> child_value;
+    switch (value->kind) {
+      case RebuildableValue::Kind::kValue: {
+        child_value = TFF_TRY(child_->CreateValue(value->value_pb));
+        break;
+      }
+      case RebuildableValue::Kind::kCall: {
+        std::optional<ValueId> argument;
+        if (operands.size() == 2) {
+          argument = operands[1]->ref();
+        }
+        child_value = TFF_TRY(child_->CreateCall(operands[0]->ref(), argument));
+        break;
+      }
+      case RebuildableValue::Kind::kStruct: {
+        std::vector<ValueId> members;
+        members.reserve(operands.size());
+        for (const SharedId& operand : operands) {
+          members.push_back(operand->ref());
+        }
+        child_value = TFF_TRY(child_->CreateStruct(members));
+        break;
+      }
+      case RebuildableValue::Kind::kSelection: {
+        child_value =
+            TFF_TRY(child_->CreateSelection(operands[0]->ref(), value->index));
+        break;
+      }
+    }
+    auto shared_child_value =
+        std::make_shared<const OwnedValueId>(std::move(*child_value));
+    if (!value->disposed) {
+      value->child_value = shared_child_value;
+      value->generation = generation_;
+    }
+    return shared_child_value;
+  }
+
+  // Replaces the child with a new one. The values of the replaced child are
+  // released as they are recreated, or when the values holding them are
+  // disposed.
+  absl::Status RebuildChild() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    child_ = TFF_TRY(create_child_());
+    generation_ += 1;
+    return absl::OkStatus();
+  }
+
+  const std::function<absl::StatusOr<std::shared_ptr<Executor>>()>
+      create_child_;
+  const std::function<bool()> child_outdated_;
+  const int32_t max_rebuilds_per_materialize_;
+
+  absl::Mutex mutex_;
+  std::shared_ptr<Executor> child_ ABSL_GUARDED_BY(mutex_);
+  uint64_t generation_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace
+
+absl::StatusOr<std::shared_ptr<Executor>> CreateRebuildingExecutor(
+    std::function<absl::StatusOr<std::shared_ptr<Executor>>()> create_child,
+    std::function<bool()> child_outdated,
+    int32_t max_rebuilds_per_materialize) {
+  std::shared_ptr<Executor> child = TFF_TRY(create_child());
+  return std::make_shared<RebuildingExecutor>(
+      std::move(create_child), std::move(child_outdated),
+      max_rebuilds_per_materialize, std::move(child));
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,53 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_REBUILDING_EXECUTOR_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_REBUILDING_EXECUTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+
+namespace tensorflow_federated {
+
+// Returns an executor which forwards to a child created by `create_child`, and
+// replaces the child with a new one when it fails or becomes outdated.
+//
+// Each value remembers how it was created, so that the values a materialized
+// value depends on can be recreated in the new child. The child is replaced:
+//
+// - before a value is materialized, if `child_outdated` returns true, e.g.
+//   since the set of workers behind the child has changed.
+// - after a value fails to materialize with an `UNAVAILABLE` error, e.g. since
+//   a remote worker went down, at most `max_rebuilds_per_materialize` times per
+//   materialization before the error is returned.
+//
+// Values created in a replaced child are recreated lazily, so computations are
+// called again in the new child when their results are materialized. The
+// computations run by the child must hence be free of side effects.
+//
+// Note: the `v0::Value`s passed to `CreateValue` are kept for the lifetime of
+// the values created from them, in order to recreate them.
+absl::StatusOr<std::shared_ptr<Executor>> CreateRebuildingExecutor(
+    std::function<absl::StatusOr<std::shared_ptr<Executor>>()> create_child,
+    std::function<bool()> child_outdated,
+    int32_t max_rebuilds_per_materialize = 3);
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_REBUILDING_EXECUTOR_H_
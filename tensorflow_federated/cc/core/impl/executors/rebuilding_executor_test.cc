@@ -0,0 +1,169 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/rebuilding_executor.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_test_base.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::tensorflow_federated::testing::TensorV;
+using ::testing::_;
+using ::testing::Return;
+using ::testing::StrictMock;
+
+class RebuildingExecutorTest : public ExecutorTestBase {
+ public:
+  RebuildingExecutorTest() {
+    test_executor_ =
+        CreateRebuildingExecutor(
+            [this]() -> absl::StatusOr<std::shared_ptr<Executor>> {
+              if (num_children_created_ >= children_.size()) {
+                return absl::UnavailableError("No more children.");
+              }
+              return children_[num_children_created_++];
+            },
+            [this]() { return child_outdated_; },
+            /*max_rebuilds_per_materialize=*/1)
+            .value();
+  }
+
+  ~RebuildingExecutorTest() override = default;
+
+ protected:
+  std::vector<std::shared_ptr<StrictMock<MockExecutor>>> children_ = {
+      std::make_shared<StrictMock<MockExecutor>>(),
+      std::make_shared<StrictMock<MockExecutor>>(),
+      std::make_shared<StrictMock<MockExecutor>>(),
+  };
+  size_t num_children_created_ = 0;
+  bool child_outdated_ = false;
+};
+
+TEST_F(RebuildingExecutorTest, CreateValueDelegatesToChild) {
+  v0::Value value = TensorV(1);
+  children_[0]->ExpectCreateMaterialize(value);
+  ExpectCreateMaterialize(value);
+  EXPECT_EQ(num_children_created_, 1);
+}
+
+TEST_F(RebuildingExecutorTest, CreateCallDelegatesToChild) {
+  v0::Value fn = TensorV("fn");
+  v0::Value arg = TensorV(1);
+  ValueId fn_child_id = children_[0]->ExpectCreateValue(fn);
+  ValueId arg_child_id = children_[0]->ExpectCreateValue(arg);
+  ValueId call_child_id =
+      children_[0]->ExpectCreateCall(fn_child_id, arg_child_id);
+  v0::Value result = TensorV(2);
+  children_[0]->ExpectMaterialize(call_child_id, result);
+
+  OwnedValueId fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(fn));
+  OwnedValueId arg_id = TFF_ASSERT_OK(test_executor_->CreateValue(arg));
+  OwnedValueId call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+  ExpectMaterialize(call_id, result);
+}
+
+TEST_F(RebuildingExecutorTest, RecreatesValuesAfterUnavailableChild) {
+  v0::Value fn = TensorV("fn");
+  v0::Value arg_member = TensorV(1);
+  ValueId fn_child_id = children_[0]->ExpectCreateValue(fn);
+  ValueId member_child_id = children_[0]->ExpectCreateValue(arg_member);
+  ValueId arg_child_id = children_[0]->ExpectCreateStruct({member_child_id});
+  ValueId call_child_id =
+      children_[0]->ExpectCreateCall(fn_child_id, arg_child_id);
+  ValueId selection_child_id =
+      children_[0]->ExpectCreateSelection(call_child_id, 0);
+  EXPECT_CALL(*children_[0], Materialize(selection_child_id, _))
+      .WillOnce(Return(absl::UnavailableError("Worker went down.")));
+
+  // The whole chain of values is recreated in the new child, including the
+  // values which were already disposed.
+  ValueId new_fn_child_id = children_[1]->ExpectCreateValue(fn);
+  ValueId new_member_child_id = children_[1]->ExpectCreateValue(arg_member);
+  ValueId new_arg_child_id =
+      children_[1]->ExpectCreateStruct({new_member_child_id});
+  ValueId new_call_child_id =
+      children_[1]->ExpectCreateCall(new_fn_child_id, new_arg_child_id);
+  ValueId new_selection_child_id =
+      children_[1]->ExpectCreateSelection(new_call_child_id, 0);
+  v0::Value result = TensorV(2);
+  children_[1]->ExpectMaterialize(new_selection_child_id, result);
+
+  OwnedValueId selection_id = [&]() {
+    OwnedValueId fn_id = test_executor_->CreateValue(fn).value();
+    OwnedValueId member_id = test_executor_->CreateValue(arg_member).value();
+    OwnedValueId arg_id = test_executor_->CreateStruct({member_id}).value();
+    OwnedValueId call_id = test_executor_->CreateCall(fn_id, arg_id).value();
+    return test_executor_->CreateSelection(call_id, 0).value();
+  }();
+  ExpectMaterialize(selection_id, result);
+  EXPECT_EQ(num_children_created_, 2);
+}
+
+TEST_F(RebuildingExecutorTest, RebuildsOutdatedChildBeforeMaterialize) {
+  v0::Value value = TensorV(1);
+  children_[0]->ExpectCreateValue(value);
+  OwnedValueId id = TFF_ASSERT_OK(test_executor_->CreateValue(value));
+
+  child_outdated_ = true;
+  children_[1]->ExpectCreateMaterialize(value);
+  ExpectMaterialize(id, value);
+  EXPECT_EQ(num_children_created_, 2);
+}
+
+TEST_F(RebuildingExecutorTest, ReturnsOtherErrorsWithoutRebuilding) {
+  v0::Value value = TensorV(1);
+  ValueId child_id = children_[0]->ExpectCreateValue(value);
+  EXPECT_CALL(*children_[0], Materialize(child_id, _))
+      .WillOnce(Return(absl::InvalidArgumentError("Bad value.")));
+  OwnedValueId id = TFF_ASSERT_OK(test_executor_->CreateValue(value));
+  EXPECT_THAT(test_executor_->Materialize(id),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_EQ(num_children_created_, 1);
+}
+
+TEST_F(RebuildingExecutorTest, ReturnsUnavailableAfterMaxRebuilds) {
+  v0::Value value = TensorV(1);
+  ValueId child_id = children_[0]->ExpectCreateValue(value);
+  EXPECT_CALL(*children_[0], Materialize(child_id, _))
+      .WillOnce(Return(absl::UnavailableError("Worker went down.")));
+  ValueId new_child_id = children_[1]->ExpectCreateValue(value);
+  EXPECT_CALL(*children_[1], Materialize(new_child_id, _))
+      .WillOnce(Return(absl::UnavailableError("Worker went down.")));
+  OwnedValueId id = TFF_ASSERT_OK(test_executor_->CreateValue(value));
+  EXPECT_THAT(test_executor_->Materialize(id),
+              StatusIs(absl::StatusCode::kUnavailable));
+  EXPECT_EQ(num_children_created_, 2);
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
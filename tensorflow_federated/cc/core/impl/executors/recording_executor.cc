@@ -0,0 +1,494 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/recording_executor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/io/zero_copy_stream_impl.h"
+#include "google/protobuf/util/delimited_message_util.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+#include "tensorflow_federated/proto/v0/executor_trace.pb.h"
+
+namespace tensorflow_federated {
+
+absl::StatusOr<std::shared_ptr<ExecutorTraceWriter>> ExecutorTraceWriter::Open(
+    const std::string& path) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Could not open an executor trace at ", path));
+  }
+  return std::shared_ptr<ExecutorTraceWriter>(
+      new ExecutorTraceWriter(std::move(file)));
+}
+
+absl::Status ExecutorTraceWriter::Write(const v0::ExecutorTraceEvent& event) {
+  absl::MutexLock lock(&mutex_);
+  if (!google::protobuf::util::SerializeDelimitedToOstream(event, &file_)) {
+    return absl::InternalError("Could not write to the executor trace");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ExecutorTraceWriter::Flush() {
+  absl::MutexLock lock(&mutex_);
+  if (!file_.flush()) {
+    return absl::InternalError("Could not flush the executor trace");
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::vector<v0::ExecutorTraceEvent>> ReadExecutorTrace(
+    const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Could not open the executor trace at ", path));
+  }
+  google::protobuf::io::IstreamInputStream input(&file);
+  std::vector<v0::ExecutorTraceEvent> events;
+  while (true) {
+    v0::ExecutorTraceEvent event;
+    bool clean_eof = false;
+    if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(
+            &event, &input, &clean_eof)) {
+      if (clean_eof) {
+        break;
+      }
+      return absl::InvalidArgumentError(
+          absl::StrCat("Could not read an event of the executor trace at ",
+                       path, " after ", events.size(), " events"));
+    }
+    events.push_back(std::move(event));
+  }
+  return events;
+}
+
+namespace {
+
+class RecordingExecutor : public Executor,
+                          public std::enable_shared_from_this<Executor> {
+ public:
+  RecordingExecutor(std::shared_ptr<Executor> target,
+                    std::shared_ptr<ExecutorTraceWriter> writer,
+                    bool record_payloads)
+      : target_(std::move(target)),
+        writer_(std::move(writer)),
+        record_payloads_(record_payloads) {}
+
+  absl::StatusOr<OwnedValueId> CreateValue(const v0::Value& value_pb) final {
+    absl::Time start = absl::Now();
+    absl::StatusOr<OwnedValueId> id = target_->CreateValue(value_pb);
+    v0::ExecutorTraceEvent event;
+    RecordCreateValue(value_pb, ResultOf(id), event.mutable_create_value());
+    Write(event, start, absl::Now(), id.status());
+    return Wrap(std::move(id));
+  }
+
+  absl::StatusOr<OwnedValueId> CreateCall(
+      const ValueId function,
+      const std::optional<const ValueId> argument) final {
+    absl::Time start = absl::Now();
+    absl::StatusOr<OwnedValueId> id = target_->CreateCall(function, argument);
+    v0::ExecutorTraceEvent event;
+    RecordCreateCall(function, argument, ResultOf(id),
+                     event.mutable_create_call());
+    Write(event, start, absl::Now(), id.status());
+    return Wrap(std::move(id));
+  }
+
+  absl::StatusOr<OwnedValueId> CreateStruct(
+      const absl::Span<const ValueId> members) final {
+    absl::Time start = absl::Now();
+    absl::StatusOr<OwnedValueId> id = target_->CreateStruct(members);
+    v0::ExecutorTraceEvent event;
+    RecordCreateStruct(members, ResultOf(id), event.mutable_create_struct());
+    Write(event, start, absl::Now(), id.status());
+    return Wrap(std::move(id));
+  }
+
+  absl::StatusOr<OwnedValueId> CreateSelection(const ValueId source,
+                                               const uint32_t index) final {
+    absl::Time start = absl::Now();
+    absl::StatusOr<OwnedValueId> id = target_->CreateSelection(source, index);
+    v0::ExecutorTraceEvent event;
+    v0::ExecutorTraceEvent::CreateSelection* create_selection =
+        event.mutable_create_selection();
+    create_selection->set_source_id(source);
+    create_selection->set_index(index);
+    if (id.ok()) {
+      create_selection->set_result_id(id->ref());
+    }
+    Write(event, start, absl::Now(), id.status());
+    return Wrap(std::move(id));
+  }
+
+  absl::Status Materialize(const ValueId value, v0::Value* value_pb) final {
+    absl::Time start = absl::Now();
+    absl::Status status = target_->Materialize(value, value_pb);
+    absl::Time end = absl::Now();
+    v0::ExecutorTraceEvent event;
+    v0::ExecutorTraceEvent::Materialize* materialize =
+        event.mutable_materialize();
+    materialize->set_value_id(value);
+    if (status.ok()) {
+      materialize->set_value_bytes(value_pb->ByteSizeLong());
+    }
+    Write(event, start, end, status);
+    return status;
+  }
+
+  absl::StatusOr<std::vector<OwnedValueId>> CreateValueBatch(
+      absl::Span<const v0::Value* const> values_pb) final {
+    absl::Time start = absl::Now();
+    absl::StatusOr<std::vector<OwnedValueId>> ids =
+        target_->CreateValueBatch(values_pb);
+    absl::Time end = absl::Now();
+    for (size_t i = 0; i < values_pb.size(); ++i) {
+      v0::ExecutorTraceEvent event;
+      RecordCreateValue(*values_pb[i], BatchElement(ids, i),
+                        event.mutable_create_value());
+      Write(event, start, end, ids.status());
+    }
+    return WrapBatch(std::move(ids));
+  }
+
+  absl::StatusOr<std::vector<OwnedValueId>> CreateCallBatch(
+      const ValueId function, absl::Span<const ValueId> arguments) final {
+    absl::Time start = absl::Now();
+    absl::StatusOr<std::vector<OwnedValueId>> ids =
+        target_->CreateCallBatch(function, arguments);
+    absl::Time end = absl::Now();
+    for (size_t i = 0; i < arguments.size(); ++i) {
+      v0::ExecutorTraceEvent event;
+      RecordCreateCall(function, arguments[i], BatchElement(ids, i),
+                       event.mutable_create_call());
+      Write(event, start, end, ids.status());
+    }
+    return WrapBatch(std::move(ids));
+  }
+
+  absl::StatusOr<std::vector<OwnedValueId>> CreateStructBatch(
+      absl::Span<const std::vector<ValueId>> members) final {
+    absl::Time start = absl::Now();
+    absl::StatusOr<std::vector<OwnedValueId>> ids =
+        target_->CreateStructBatch(members);
+    absl::Time end = absl::Now();
+    for (size_t i = 0; i < members.size(); ++i) {
+      v0::ExecutorTraceEvent event;
+      RecordCreateStruct(members[i], BatchElement(ids, i),
+                         event.mutable_create_struct());
+      Write(event, start, end, ids.status());
+    }
+    return WrapBatch(std::move(ids));
+  }
+
+  absl::Status Dispose(const ValueId value) final {
+    absl::Time start = absl::Now();
+    absl::Status status = target_->Dispose(value);
+    v0::ExecutorTraceEvent event;
+    event.mutable_dispose()->set_value_id(value);
+    Write(event, start, absl::Now(), status);
+    return status;
+  }
+
+ private:
+  // Returns the ID of the `index`th value of `ids`, if the batch succeeded.
+  static std::optional<ValueId> BatchElement(
+      const absl::StatusOr<std::vector<OwnedValueId>>& ids, size_t index) {
+    if (!ids.ok() || index >= ids->size()) {
+      return std::nullopt;
+    }
+    return (*ids)[index].ref();
+  }
+
+  void RecordCreateValue(const v0::Value& value_pb,
+                         std::optional<ValueId> result,
+                         v0::ExecutorTraceEvent::CreateValue* create_value) {
+    create_value->set_value_bytes(value_pb.ByteSizeLong());
+    if (record_payloads_) {
+      *create_value->mutable_value() = value_pb;
+    }
+    if (result.has_value()) {
+      create_value->set_result_id(*result);
+    }
+  }
+
+  static void RecordCreateCall(
+      ValueId function, std::optional<const ValueId> argument,
+      std::optional<ValueId> result,
+      v0::ExecutorTraceEvent::CreateCall* create_call) {
+    create_call->set_function_id(function);
+    if (argument.has_value()) {
+      create_call->set_has_argument(true);
+      create_call->set_argument_id(*argument);
+    }
+    if (result.has_value()) {
+      create_call->set_result_id(*result);
+    }
+  }
+
+  static void RecordCreateStruct(
+      absl::Span<const ValueId> members, std::optional<ValueId> result,
+      v0::ExecutorTraceEvent::CreateStruct* create_struct) {
+    create_struct->mutable_member_ids()->Add(members.begin(), members.end());
+    if (result.has_value()) {
+      create_struct->set_result_id(*result);
+    }
+  }
+
+  // Returns the ID of `id`, if the call succeeded.
+  static std::optional<ValueId> ResultOf(
+      const absl::StatusOr<OwnedValueId>& id) {
+    if (!id.ok()) {
+      return std::nullopt;
+    }
+    return id->ref();
+  }
+
+  // Completes `event` with the timing and status of its call, and writes it.
+  // Failures to write are logged rather than failing the call.
+  void Write(v0::ExecutorTraceEvent& event, absl::Time start, absl::Time end,
+             const absl::Status& status) {
+    event.set_start_micros(absl::ToInt64Microseconds(start - writer_->start()));
+    event.set_duration_micros(absl::ToInt64Microseconds(end - start));
+    event.set_status_code(static_cast<int32_t>(status.code()));
+    absl::Status written = writer_->Write(event);
+    if (!written.ok()) {
+      LOG_FIRST_N(WARNING, 1) << "Dropping executor trace events: " << written;
+    }
+  }
+
+  // Returns an ID of this executor for the value of `target_` with the ID
+  // `id`, so that its disposal is recorded.
+  absl::StatusOr<OwnedValueId> Wrap(absl::StatusOr<OwnedValueId> id) {
+    if (!id.ok()) {
+      return id.status();
+    }
+    ValueId value = id->ref();
+    id->forget();
+    return OwnedValueId(weak_from_this(), value);
+  }
+
+  absl::StatusOr<std::vector<OwnedValueId>> WrapBatch(
+      absl::StatusOr<std::vector<OwnedValueId>> ids) {
+    if (!ids.ok()) {
+      return ids.status();
+    }
+    std::vector<OwnedValueId> wrapped;
+    wrapped.reserve(ids->size());
+    for (OwnedValueId& id : *ids) {
+      wrapped.push_back(TFF_TRY(Wrap(std::move(id))));
+    }
+    return wrapped;
+  }
+
+  const std::shared_ptr<Executor> target_;
+  const std::shared_ptr<ExecutorTraceWriter> writer_;
+  const bool record_payloads_;
+};
+
+// Returns the `q`th quantile of `sorted`, which must not be empty.
+absl::Duration Quantile(const std::vector<absl::Duration>& sorted, double q) {
+  size_t index = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+}  // namespace
+
+std::shared_ptr<Executor> CreateRecordingExecutor(
+    std::shared_ptr<Executor> target,
+    std::shared_ptr<ExecutorTraceWriter> writer, bool record_payloads) {
+  return std::make_shared<RecordingExecutor>(std::move(target),
+                                             std::move(writer),
+                                             record_payloads);
+}
+
+std::string ExecutorTraceReplayStats::ToString() const {
+  std::string table = absl::StrFormat(
+      "%-16s %10s %14s %12s %12s %12s %12s\n", "method", "calls", "bytes",
+      "total_ms", "median_us", "p99_us", "max_us");
+  int64_t total_calls = 0;
+  int64_t total_bytes = 0;
+  for (const auto& [method, method_stats] : methods) {
+    absl::StrAppendFormat(
+        &table, "%-16s %10d %14d %12.3f %12.1f %12.1f %12.1f\n", method,
+        method_stats.calls, method_stats.bytes,
+        absl::ToDoubleMilliseconds(method_stats.total_latency),
+        absl::ToDoubleMicroseconds(method_stats.median_latency),
+        absl::ToDoubleMicroseconds(method_stats.p99_latency),
+        absl::ToDoubleMicroseconds(method_stats.max_latency));
+    total_calls += method_stats.calls;
+    total_bytes += method_stats.bytes;
+  }
+  double seconds = absl::ToDoubleSeconds(elapsed);
+  absl::StrAppendFormat(
+      &table, "%d calls in %.3f s: %.1f calls/s, %.1f MB/s, %d skipped\n",
+      total_calls, seconds, seconds > 0 ? total_calls / seconds : 0,
+      seconds > 0 ? total_bytes / seconds / 1e6 : 0, skipped_events);
+  return table;
+}
+
+absl::StatusOr<ExecutorTraceReplayStats> ReplayExecutorTrace(
+    Executor& executor, std::vector<v0::ExecutorTraceEvent> events,
+    const ExecutorTraceReplayOptions& options) {
+  // Events are written as the calls return, while a call could only use the
+  // values of calls which returned before it started.
+  std::stable_sort(events.begin(), events.end(),
+                   [](const v0::ExecutorTraceEvent& a,
+                      const v0::ExecutorTraceEvent& b) {
+                     return a.start_micros() < b.start_micros();
+                   });
+  absl::flat_hash_map<ValueId, OwnedValueId> values;
+  auto lookup = [&values](ValueId recorded_id) -> absl::StatusOr<ValueId> {
+    auto it = values.find(recorded_id);
+    if (it == values.end()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("The executor trace uses value ", recorded_id,
+                       " before creating it"));
+    }
+    return it->second.ref();
+  };
+  ExecutorTraceReplayStats stats;
+  absl::flat_hash_map<std::string, std::vector<absl::Duration>> latencies;
+  const absl::Time replay_start = absl::Now();
+  for (const v0::ExecutorTraceEvent& event : events) {
+    if (event.status_code() != static_cast<int32_t>(absl::StatusCode::kOk)) {
+      ++stats.skipped_events;
+      continue;
+    }
+    if (options.speed > 0) {
+      absl::SleepFor(replay_start +
+                     absl::Microseconds(event.start_micros()) / options.speed -
+                     absl::Now());
+    }
+    std::string method;
+    int64_t bytes = 0;
+    absl::Time start;
+    switch (event.call_case()) {
+      case v0::ExecutorTraceEvent::kCreateValue: {
+        const v0::ExecutorTraceEvent::CreateValue& create_value =
+            event.create_value();
+        if (!create_value.has_value()) {
+          return absl::InvalidArgumentError(
+              "The executor trace was recorded without payloads");
+        }
+        method = "CreateValue";
+        bytes = create_value.value_bytes();
+        start = absl::Now();
+        OwnedValueId id = TFF_TRY(executor.CreateValue(create_value.value()));
+        values.insert_or_assign(create_value.result_id(), std::move(id));
+        break;
+      }
+      case v0::ExecutorTraceEvent::kCreateCall: {
+        const v0::ExecutorTraceEvent::CreateCall& create_call =
+            event.create_call();
+        ValueId function = TFF_TRY(lookup(create_call.function_id()));
+        std::optional<ValueId> argument;
+        if (create_call.has_argument()) {
+          argument = TFF_TRY(lookup(create_call.argument_id()));
+        }
+        method = "CreateCall";
+        start = absl::Now();
+        OwnedValueId id = TFF_TRY(executor.CreateCall(function, argument));
+        values.insert_or_assign(create_call.result_id(), std::move(id));
+        break;
+      }
+      case v0::ExecutorTraceEvent::kCreateStruct: {
+        const v0::ExecutorTraceEvent::CreateStruct& create_struct =
+            event.create_struct();
+        std::vector<ValueId> members;
+        members.reserve(create_struct.member_ids_size());
+        for (ValueId member_id : create_struct.member_ids()) {
+          members.push_back(TFF_TRY(lookup(member_id)));
+        }
+        method = "CreateStruct";
+        start = absl::Now();
+        OwnedValueId id = TFF_TRY(executor.CreateStruct(members));
+        values.insert_or_assign(create_struct.result_id(), std::move(id));
+        break;
+      }
+      case v0::ExecutorTraceEvent::kCreateSelection: {
+        const v0::ExecutorTraceEvent::CreateSelection& create_selection =
+            event.create_selection();
+        ValueId source = TFF_TRY(lookup(create_selection.source_id()));
+        method = "CreateSelection";
+        start = absl::Now();
+        OwnedValueId id =
+            TFF_TRY(executor.CreateSelection(source, create_selection.index()));
+        values.insert_or_assign(create_selection.result_id(), std::move(id));
+        break;
+      }
+      case v0::ExecutorTraceEvent::kMaterialize: {
+        ValueId value = TFF_TRY(lookup(event.materialize().value_id()));
+        method = "Materialize";
+        start = absl::Now();
+        v0::Value value_pb;
+        TFF_TRY(executor.Materialize(value, &value_pb));
+        bytes = value_pb.ByteSizeLong();
+        break;
+      }
+      case v0::ExecutorTraceEvent::kDispose: {
+        TFF_TRY(lookup(event.dispose().value_id()));
+        method = "Dispose";
+        start = absl::Now();
+        values.erase(event.dispose().value_id());
+        break;
+      }
+      case v0::ExecutorTraceEvent::CALL_NOT_SET:
+        return absl::InvalidArgumentError(
+            "An event of the executor trace records no call");
+    }
+    absl::Duration latency = absl::Now() - start;
+    ReplayedMethodStats& method_stats = stats.methods[method];
+    ++method_stats.calls;
+    method_stats.bytes += bytes;
+    method_stats.total_latency += latency;
+    latencies[method].push_back(latency);
+  }
+  stats.elapsed = absl::Now() - replay_start;
+  for (auto& [method, method_latencies] : latencies) {
+    std::sort(method_latencies.begin(), method_latencies.end());
+    ReplayedMethodStats& method_stats = stats.methods[method];
+    method_stats.median_latency = Quantile(method_latencies, 0.5);
+    method_stats.p99_latency = Quantile(method_latencies, 0.99);
+    method_stats.max_latency = method_latencies.back();
+  }
+  return stats;
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,125 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_RECORDING_EXECUTOR_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_RECORDING_EXECUTOR_H_
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/proto/v0/executor_trace.pb.h"
+
+namespace tensorflow_federated {
+
+// Writes the events of an executor trace to a file. Thread-safe.
+class ExecutorTraceWriter {
+ public:
+  // Returns a writer of a new trace at `path`, whose events are timed relative
+  // to the time it is opened.
+  static absl::StatusOr<std::shared_ptr<ExecutorTraceWriter>> Open(
+      const std::string& path);
+
+  // Returns the time the trace was opened.
+  absl::Time start() const { return start_; }
+
+  // Appends `event` to the trace.
+  absl::Status Write(const v0::ExecutorTraceEvent& event);
+
+  // Flushes the events written so far to the file.
+  absl::Status Flush();
+
+ private:
+  explicit ExecutorTraceWriter(std::ofstream file)
+      : start_(absl::Now()), file_(std::move(file)) {}
+
+  const absl::Time start_;
+  absl::Mutex mutex_;
+  std::ofstream file_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Returns the events of the trace at `path`, in the order they were written.
+absl::StatusOr<std::vector<v0::ExecutorTraceEvent>> ReadExecutorTrace(
+    const std::string& path);
+
+// Returns an executor which forwards to `target`, and records each of its
+// calls of `CreateValue`, `CreateCall`, `CreateStruct`, `CreateSelection`,
+// `Materialize` and `Dispose` to `writer`, along with its latency and the
+// sizes of the values created and materialized.
+//
+// If `record_payloads` is true, the values created are recorded as well, so
+// that the trace can be replayed with `ReplayExecutorTrace`. Batches are
+// forwarded to `target` as batches, and recorded as one event per value.
+//
+// The IDs of the returned executor are those of `target`.
+std::shared_ptr<Executor> CreateRecordingExecutor(
+    std::shared_ptr<Executor> target,
+    std::shared_ptr<ExecutorTraceWriter> writer, bool record_payloads = false);
+
+struct ExecutorTraceReplayOptions {
+  // The speed of the replay relative to the recording. At a speed of 1, each
+  // call is issued at the offset from the start of the replay at which it was
+  // issued in the recording, or as soon as the previous call returned if that
+  // is later. At a speed of 0, the calls are issued as fast as possible.
+  double speed = 0;
+};
+
+// The latencies of the replayed calls of one method.
+struct ReplayedMethodStats {
+  int64_t calls = 0;
+  // The total size of the values created or materialized.
+  int64_t bytes = 0;
+  absl::Duration total_latency;
+  absl::Duration median_latency;
+  absl::Duration p99_latency;
+  absl::Duration max_latency;
+};
+
+struct ExecutorTraceReplayStats {
+  // The time from the start of the replay until the last call returned.
+  absl::Duration elapsed;
+  // The stats of the replayed calls, by method name.
+  std::map<std::string, ReplayedMethodStats> methods;
+  // The number of events skipped since the recorded call failed.
+  int64_t skipped_events = 0;
+
+  // Returns a table of the stats, with one row per method.
+  std::string ToString() const;
+};
+
+// Replays the calls of `events` on `executor`, in the order they started in
+// the recording, and returns the latencies of the replayed calls.
+//
+// The IDs of the recorded values are mapped to those of the values created in
+// `executor`, which are disposed of as in the recording, or on return if the
+// recording ended before they were. Calls which failed in the recording are
+// skipped. The trace must have been recorded with payloads.
+absl::StatusOr<ExecutorTraceReplayStats> ReplayExecutorTrace(
+    Executor& executor, std::vector<v0::ExecutorTraceEvent> events,
+    const ExecutorTraceReplayOptions& options = {});
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_RECORDING_EXECUTOR_H_
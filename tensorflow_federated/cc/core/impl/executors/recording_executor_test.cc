@@ -0,0 +1,235 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/recording_executor.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+#include "tensorflow_federated/proto/v0/executor_trace.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::tensorflow_federated::testing::EqualsProto;
+using ::tensorflow_federated::testing::StructV;
+using ::tensorflow_federated::testing::TensorV;
+using ::testing::Each;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::StrictMock;
+
+class RecordingExecutorTest : public ::testing::Test {
+ protected:
+  // Returns an executor recording to a new trace at `trace_path_`.
+  std::shared_ptr<Executor> CreateRecording(bool record_payloads) {
+    std::shared_ptr<ExecutorTraceWriter> writer =
+        ExecutorTraceWriter::Open(trace_path_).value();
+    return CreateRecordingExecutor(mock_executor_, writer, record_payloads);
+  }
+
+  const std::string trace_path_ = absl::StrCat(
+      ::testing::TempDir(), "/",
+      ::testing::UnitTest::GetInstance()->current_test_info()->name(),
+      ".trace");
+  std::shared_ptr<StrictMock<MockExecutor>> mock_executor_ =
+      std::make_shared<StrictMock<MockExecutor>>();
+};
+
+std::vector<v0::ExecutorTraceEvent::CallCase> CallsOf(
+    const std::vector<v0::ExecutorTraceEvent>& events) {
+  std::vector<v0::ExecutorTraceEvent::CallCase> calls;
+  for (const v0::ExecutorTraceEvent& event : events) {
+    calls.push_back(event.call_case());
+  }
+  return calls;
+}
+
+TEST_F(RecordingExecutorTest, RecordsCallsInOrder) {
+  v0::Value fn = TensorV(1);
+  v0::Value arg = TensorV(2);
+  v0::Value result = TensorV(3);
+  ValueId fn_child_id = mock_executor_->ExpectCreateValue(fn);
+  ValueId arg_child_id = mock_executor_->ExpectCreateValue(arg);
+  ValueId call_child_id =
+      mock_executor_->ExpectCreateCall(fn_child_id, arg_child_id);
+  ValueId struct_child_id =
+      mock_executor_->ExpectCreateStruct({call_child_id, arg_child_id});
+  ValueId selection_child_id =
+      mock_executor_->ExpectCreateSelection(struct_child_id, 0);
+  mock_executor_->ExpectMaterialize(selection_child_id, result);
+  {
+    std::shared_ptr<Executor> executor =
+        CreateRecording(/*record_payloads=*/true);
+    OwnedValueId fn_id = TFF_ASSERT_OK(executor->CreateValue(fn));
+    OwnedValueId arg_id = TFF_ASSERT_OK(executor->CreateValue(arg));
+    OwnedValueId call_id = TFF_ASSERT_OK(executor->CreateCall(fn_id, arg_id));
+    OwnedValueId struct_id =
+        TFF_ASSERT_OK(executor->CreateStruct({call_id, arg_id}));
+    OwnedValueId selection_id =
+        TFF_ASSERT_OK(executor->CreateSelection(struct_id, 0));
+    EXPECT_THAT(executor->Materialize(selection_id),
+                IsOkAndHolds(EqualsProto(result)));
+    selection_id.release();
+  }
+
+  std::vector<v0::ExecutorTraceEvent> events =
+      TFF_ASSERT_OK(ReadExecutorTrace(trace_path_));
+  // The calls, followed by the disposal of the five remaining values.
+  ASSERT_EQ(events.size(), 11);
+  std::vector<v0::ExecutorTraceEvent::CallCase> calls = CallsOf(events);
+  EXPECT_THAT(
+      std::vector<v0::ExecutorTraceEvent::CallCase>(calls.begin(),
+                                                    calls.begin() + 7),
+      ElementsAre(v0::ExecutorTraceEvent::kCreateValue,
+                  v0::ExecutorTraceEvent::kCreateValue,
+                  v0::ExecutorTraceEvent::kCreateCall,
+                  v0::ExecutorTraceEvent::kCreateStruct,
+                  v0::ExecutorTraceEvent::kCreateSelection,
+                  v0::ExecutorTraceEvent::kMaterialize,
+                  v0::ExecutorTraceEvent::kDispose));
+  EXPECT_THAT(std::vector<v0::ExecutorTraceEvent::CallCase>(
+                  calls.begin() + 7, calls.end()),
+              Each(v0::ExecutorTraceEvent::kDispose));
+  EXPECT_EQ(events[0].create_value().result_id(), fn_child_id);
+  EXPECT_EQ(events[0].create_value().value_bytes(), fn.ByteSizeLong());
+  EXPECT_THAT(events[0].create_value().value(), EqualsProto(fn));
+  EXPECT_EQ(events[2].create_call().function_id(), fn_child_id);
+  EXPECT_TRUE(events[2].create_call().has_argument());
+  EXPECT_EQ(events[2].create_call().argument_id(), arg_child_id);
+  EXPECT_EQ(events[2].create_call().result_id(), call_child_id);
+  EXPECT_THAT(events[3].create_struct().member_ids(),
+              ElementsAre(call_child_id, arg_child_id));
+  EXPECT_EQ(events[4].create_selection().source_id(), struct_child_id);
+  EXPECT_EQ(events[5].materialize().value_id(), selection_child_id);
+  EXPECT_EQ(events[5].materialize().value_bytes(), result.ByteSizeLong());
+  EXPECT_EQ(events[6].dispose().value_id(), selection_child_id);
+  for (const v0::ExecutorTraceEvent& event : events) {
+    EXPECT_EQ(event.status_code(), 0);
+    EXPECT_GE(event.start_micros(), 0);
+  }
+}
+
+TEST_F(RecordingExecutorTest, RecordsFailedCallsWithoutPayloads) {
+  v0::Value value = TensorV(1);
+  EXPECT_CALL(*mock_executor_, CreateValue(EqualsProto(value)))
+      .WillOnce(::testing::Return(absl::UnavailableError("No worker")));
+  {
+    std::shared_ptr<Executor> executor =
+        CreateRecording(/*record_payloads=*/false);
+    EXPECT_THAT(executor->CreateValue(value),
+                StatusIs(absl::StatusCode::kUnavailable));
+  }
+
+  std::vector<v0::ExecutorTraceEvent> events =
+      TFF_ASSERT_OK(ReadExecutorTrace(trace_path_));
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].status_code(),
+            static_cast<int>(absl::StatusCode::kUnavailable));
+  EXPECT_EQ(events[0].create_value().value_bytes(), value.ByteSizeLong());
+  EXPECT_FALSE(events[0].create_value().has_value());
+}
+
+TEST_F(RecordingExecutorTest, RecordsEachValueOfBatch) {
+  std::vector<v0::Value> values = {TensorV(1), TensorV(2)};
+  ValueId first_child_id = mock_executor_->ExpectCreateValue(values[0]);
+  ValueId second_child_id = mock_executor_->ExpectCreateValue(values[1]);
+  {
+    std::shared_ptr<Executor> executor =
+        CreateRecording(/*record_payloads=*/true);
+    std::vector<OwnedValueId> ids = TFF_ASSERT_OK(
+        executor->CreateValueBatch({&values[0], &values[1]}));
+  }
+
+  std::vector<v0::ExecutorTraceEvent> events =
+      TFF_ASSERT_OK(ReadExecutorTrace(trace_path_));
+  ASSERT_EQ(events.size(), 4);
+  EXPECT_EQ(events[0].create_value().result_id(), first_child_id);
+  EXPECT_EQ(events[1].create_value().result_id(), second_child_id);
+  EXPECT_EQ(events[0].start_micros(), events[1].start_micros());
+}
+
+TEST_F(RecordingExecutorTest, ReplaysTraceOnOtherExecutor) {
+  v0::Value fn = TensorV(1);
+  v0::Value arg = TensorV(2);
+  v0::Value result = TensorV(3);
+  ValueId fn_child_id = mock_executor_->ExpectCreateValue(fn);
+  ValueId arg_child_id = mock_executor_->ExpectCreateValue(arg);
+  ValueId call_child_id =
+      mock_executor_->ExpectCreateCall(fn_child_id, arg_child_id);
+  mock_executor_->ExpectMaterialize(call_child_id, result);
+  {
+    std::shared_ptr<Executor> executor =
+        CreateRecording(/*record_payloads=*/true);
+    OwnedValueId fn_id = TFF_ASSERT_OK(executor->CreateValue(fn));
+    OwnedValueId arg_id = TFF_ASSERT_OK(executor->CreateValue(arg));
+    OwnedValueId call_id = TFF_ASSERT_OK(executor->CreateCall(fn_id, arg_id));
+    TFF_ASSERT_OK(executor->Materialize(call_id));
+  }
+
+  auto replay_executor = std::make_shared<StrictMock<MockExecutor>>();
+  ValueId replay_fn_id = replay_executor->ExpectCreateValue(fn);
+  ValueId replay_arg_id = replay_executor->ExpectCreateValue(arg);
+  ValueId replay_call_id =
+      replay_executor->ExpectCreateCall(replay_fn_id, replay_arg_id);
+  replay_executor->ExpectMaterialize(replay_call_id, result);
+  ExecutorTraceReplayStats stats = TFF_ASSERT_OK(ReplayExecutorTrace(
+      *replay_executor, TFF_ASSERT_OK(ReadExecutorTrace(trace_path_))));
+  EXPECT_EQ(stats.methods["CreateValue"].calls, 2);
+  EXPECT_EQ(stats.methods["CreateValue"].bytes,
+            fn.ByteSizeLong() + arg.ByteSizeLong());
+  EXPECT_EQ(stats.methods["CreateCall"].calls, 1);
+  EXPECT_EQ(stats.methods["Materialize"].calls, 1);
+  EXPECT_EQ(stats.methods["Materialize"].bytes, result.ByteSizeLong());
+  EXPECT_EQ(stats.methods["Dispose"].calls, 3);
+  EXPECT_EQ(stats.skipped_events, 0);
+  EXPECT_THAT(stats.ToString(), HasSubstr("CreateCall"));
+}
+
+TEST_F(RecordingExecutorTest, ReplayFailsOnTraceWithoutPayloads) {
+  v0::Value value = TensorV(1);
+  mock_executor_->ExpectCreateValue(value);
+  {
+    std::shared_ptr<Executor> executor =
+        CreateRecording(/*record_payloads=*/false);
+    TFF_ASSERT_OK(executor->CreateValue(value));
+  }
+
+  auto replay_executor = std::make_shared<StrictMock<MockExecutor>>();
+  EXPECT_THAT(
+      ReplayExecutorTrace(*replay_executor,
+                          TFF_ASSERT_OK(ReadExecutorTrace(trace_path_))),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("payloads")));
+}
+
+TEST(ReadExecutorTraceTest, FailsOnMissingFile) {
+  EXPECT_THAT(ReadExecutorTrace(absl::StrCat(::testing::TempDir(),
+                                             "/missing.trace")),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -15,23 +15,30 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/reference_resolving_executor.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <future>  // NOLINT
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
-#include <tuple>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/synchronization/mutex.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
 
@@ -43,23 +50,113 @@ namespace {
 // Class Definitions
 ////////////////////////////////////////////////////////////////////////////////
 
+class CompiledComputation;
 class ExecutorValue;
+class Frame;
 class ReferenceResolvingExecutor;
-class Scope;
 
-// An object for holding references (names to values).
-using NamedValue = std::tuple<std::string, std::shared_ptr<ExecutorValue>>;
+// The location of the value bound to a reference: the number of frames
+// between the frame in which the reference is evaluated and the frame of the
+// binding, and the slot of the binding in that frame.
+struct ReferenceIndex {
+  int32_t depth;
+  int32_t slot;
+};
 
-// An object for tracking a lambda that was created in a specific scope.
+// A computation lowered to a tree of nodes, whose references have been
+// resolved to the location of their bindings.
+//
+// A computation is lowered once when it is created as a value, and the lambdas
+// it contains point into its tree, so calling a lambda many times, e.g. once
+// per client, evaluates the same nodes without walking the proto again or
+// searching the enclosing scopes by name.
 //
-// References within the lambda will be resolved using the attached scope.
+// Each block and each lambda call introduces a frame. The frame of a block has
+// one slot per local, in order, and the frame of a lambda has a single slot for
+// its parameter. References that aren't bound within the computation have no
+// index, and fail to resolve when evaluated.
+class CompiledComputation {
+ public:
+  struct Node {
+    enum Kind {
+      CHILD,
+      REFERENCE,
+      BLOCK,
+      LAMBDA,
+      CALL,
+      STRUCT,
+      SELECTION,
+      UNIMPLEMENTED
+    };
+
+    Kind kind;
+    // The lowered computation, only used for error messages and for lambdas
+    // forwarded to the child executor.
+    const v0::Computation* computation_pb;
+    // For CHILD nodes, the value to create in the child executor.
+    v0::Value child_value_pb;
+    // For REFERENCE nodes, the location of the binding, if it is bound within
+    // the computation. For LAMBDA nodes, the location of the binding shadowed
+    // by the parameter, relative to the frame enclosing the lambda, which the
+    // parameter resolves to when the lambda is called without an argument.
+    std::optional<ReferenceIndex> reference_index;
+    // The sub-computations: the locals then the result of a block, the result
+    // of a lambda, the function then the argument if any of a call, the
+    // elements of a struct, and the source of a selection.
+    std::vector<Node> children;
+    // For BLOCK nodes, the preceding locals which each local references,
+    // sorted.
+    std::vector<std::vector<int32_t>> local_dependencies;
+    // For BLOCK and STRUCT nodes, whether the children may be evaluated
+    // concurrently: some local doesn't depend on the local preceding it, or
+    // at least two elements call into the child executor.
+    bool concurrent = false;
+  };
+
+  explicit CompiledComputation(v0::Computation computation_pb);
+
+  CompiledComputation(const CompiledComputation&) = delete;
+  CompiledComputation& operator=(const CompiledComputation&) = delete;
+
+  const Node& root() const { return root_; }
+
+ private:
+  // The frame and slot of a binding visible at some point of the computation.
+  struct Binding {
+    int32_t frame;
+    int32_t slot;
+  };
+  struct LoweringState {
+    // The bindings visible at some point of the computation, with the
+    // innermost binding of each name last.
+    absl::flat_hash_map<std::string_view, std::vector<Binding>> bindings;
+    // Per frame, the dependencies of the block local being lowered, or
+    // nullptr if the frame isn't a block or its result is being lowered.
+    std::vector<std::vector<int32_t>*> frame_dependencies;
+  };
+
+  static Node Lower(const v0::Computation& computation_pb, int32_t num_frames,
+                    LoweringState& state);
+  // Records that the computation being lowered uses `binding`.
+  static void AddDependency(const Binding& binding, LoweringState& state);
+
+  const v0::Computation computation_pb_;
+  // Points into `computation_pb_`, so must be declared after it.
+  const Node root_;
+};
+
+// An object for tracking a lambda that was created in a specific frame.
+//
+// References within the lambda will be resolved using the attached frame.
 class ScopedLambda {
  public:
-  explicit ScopedLambda(v0::Lambda lambda_pb, std::shared_ptr<Scope> scope)
-      : lambda_pb_(std::move(lambda_pb)), scope_(std::move(scope)) {}
-  ScopedLambda(ScopedLambda&& other)
-      : lambda_pb_(std::move(other.lambda_pb_)),
-        scope_(std::move(other.scope_)) {}
+  explicit ScopedLambda(std::shared_ptr<const CompiledComputation> computation,
+                        const CompiledComputation::Node& lambda,
+                        std::shared_ptr<Frame> frame)
+      : computation_(std::move(computation)),
+        lambda_(&lambda),
+        frame_(std::move(frame)) {}
+  ScopedLambda(ScopedLambda&& other) = default;
 
   absl::StatusOr<std::shared_ptr<ExecutorValue>> Call(
       const ReferenceResolvingExecutor& rre,
@@ -67,54 +164,90 @@ class ScopedLambda {
 
   v0::Value as_value_pb() const {
     v0::Value value_pb;
-    *value_pb.mutable_computation()->mutable_lambda() = lambda_pb_;
+    *value_pb.mutable_computation()->mutable_lambda() =
+        lambda_->computation_pb->lambda();
     return value_pb;
   }
 
  private:
-  v0::Lambda lambda_pb_;
-  std::shared_ptr<Scope> scope_;
+  // Owns the lambda, which is one of its nodes.
+  std::shared_ptr<const CompiledComputation> computation_;
+  const CompiledComputation::Node* lambda_;
+  std::shared_ptr<Frame> frame_;
 };
 
-// An object for tracking computation evaluation scopes.
+// The values bound by a block or a lambda call during evaluation.
+//
+// Frames are nested following the nesting of blocks and lambdas in the
+// computation, and the outermost frame is an empty root frame. The values of
+// a frame live in a vector sized up front, so that a lambda created by a local
+// of a block can hold on to the frame of the block while the following locals
+// are bound.
 //
-// Scopes are nested, each containing a single reference. Resolution of a
-// reference start with the innermost nesting and works its way up to the
-// root scope, which is identified by `parent_ == nullopt`.
-class Scope {
+// Independent locals of a block may be bound concurrently. A local is only
+// evaluated once the locals it references are bound, so resolving a reference
+// never reads a slot that is being written, and doesn't lock.
+class Frame {
  public:
-  Scope() = default;
-  Scope(NamedValue binding, std::shared_ptr<Scope> parent)
-      : binding_(std::move(binding)), parent_(std::move(parent)) {}
-  Scope(Scope&& other)
-      : binding_(std::move(other.binding_)),
-        parent_(std::move(other.parent_)) {}
-
-  // Resolves a name by traversing a possibly nested scope.
-  //
-  // Returns the first executor value  whose name matches the `name` argument.
-  // Otherwise, returns a `NotFound` error if the `name` is not present in any
-  // ancestor scope.
+  // Creates the root frame.
+  Frame() = default;
+  // Creates the frame of a block, whose locals are bound as they are
+  // evaluated.
+  Frame(const v0::Block& block_pb, std::shared_ptr<Frame> parent)
+      : block_pb_(&block_pb),
+        values_(block_pb.local_size()),
+        parent_(std::move(parent)) {}
+  // Creates the frame of a call of a lambda, with the argument of the call if
+  // any.
+  Frame(const CompiledComputation::Node& lambda,
+        std::optional<std::shared_ptr<ExecutorValue>> arg,
+        std::shared_ptr<Frame> parent)
+      : lambda_(&lambda), parent_(std::move(parent)) {
+    values_.push_back(arg.has_value() ? std::move(arg.value()) : nullptr);
+  }
+
+  Frame(const Frame&) = delete;
+  Frame& operator=(const Frame&) = delete;
+
+  // Binds a value to the local at position `slot` of the block of this frame.
+  void Bind(int32_t slot, std::shared_ptr<ExecutorValue> value)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    values_[slot] = std::move(value);
+  }
+
+  // Returns the value at a resolved `index`, relative to this frame, of the
+  // reference to `name`.
   absl::StatusOr<std::shared_ptr<ExecutorValue>> Resolve(
-      std::string_view name) const;
+      const ReferenceIndex& index, std::string_view name) const;
 
-  // Returns a human readable string for debugging the current scope.
+  // Returns a human readable string for debugging the current frame, with one
+  // element per bound value.
   //
-  // Example of two nested scopes that have binding's with the same name, and
-  // a middle scope with no binding.
+  // Example of two nested frames that have bindings with the same name, below
+  // the root frame.
   //
-  //   [foo=V]->[]->[foo=V]
+  //   []->[foo=V]->[foo=V]
   //
-  // Parent scopes are on the left, nested child scopes on the right.
-  std::string DebugString() const;
+  // Parent frames are on the left, nested child frames on the right.
+  std::string DebugString() const ABSL_LOCKS_EXCLUDED(mutex_);
 
  private:
-  Scope(const Scope& scope) = delete;
+  std::string_view name(size_t slot) const {
+    return block_pb_ != nullptr
+               ? block_pb_->local(slot).name()
+               : lambda_->computation_pb->lambda().parameter_name();
+  }
 
-  std::optional<NamedValue> binding_;
-  // Pointer to enclosing scope. `nullopt` iff this is the root scope.
-  // If a value is present, it must not be `nullptr`.
-  std::optional<std::shared_ptr<Scope>> parent_;
+  // Exactly one of these is set, except in the root frame.
+  const v0::Block* block_pb_ = nullptr;
+  const CompiledComputation::Node* lambda_ = nullptr;
+  // Only held to write `values_`, and to read the slots that may not be bound
+  // yet, e.g. for error messages.
+  mutable absl::Mutex mutex_;
+  std::vector<std::shared_ptr<ExecutorValue>> values_;
+  // Pointer to the enclosing frame, `nullptr` iff this is the root frame.
+  std::shared_ptr<Frame> parent_;
 };
 
 // A value object for the ReferenceResolvingExecutor.
@@ -180,25 +313,31 @@ class ExecutorValue {
 //
 // Other computations, including Intrinsics and TensorFlow, and handled by child
 // executors.
+//
+// If the executor has a runtime, independent locals of a block and elements of
+// a struct are evaluated concurrently on its coordination lane, since their
+// evaluation mostly waits for the child executor.
 class ReferenceResolvingExecutor
     : public ExecutorBase<std::shared_ptr<ExecutorValue>> {
  public:
-  explicit ReferenceResolvingExecutor(std::shared_ptr<Executor> child)
-      : child_executor_(std::move(child)) {}
+  explicit ReferenceResolvingExecutor(std::shared_ptr<Executor> child,
+                                      std::shared_ptr<ExecutorRuntime> runtime)
+      : child_executor_(std::move(child)), runtime_(std::move(runtime)) {}
   ~ReferenceResolvingExecutor() override {
     // We must make sure to delete all of our `OwnedValueId`s, releasing them
     // from the child executor as well, before deleting the child executor.
     ClearTracked();
   }
 
-  // Evaluates a computation in the current scope.
+  // Evaluates a node of a lowered computation in the current frame.
   //
-  // Evaluating a computation may involve resolving references, calls, blocks,
-  // etc. The method delegates to other Evaluate*() methods, and the result
-  // depends on the type of computation being evaluated.
+  // Evaluating a node may involve resolving references, calls, blocks, etc.
+  // The method delegates to other Evaluate*() methods, and the result depends
+  // on the kind of node being evaluated.
   absl::StatusOr<std::shared_ptr<ExecutorValue>> Evaluate(
-      const v0::Computation& computation_pb,
-      const std::shared_ptr<Scope>& scope) const;
+      const CompiledComputation::Node& node,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& frame) const;
 
  protected:
   std::string_view ExecutorName() final {
@@ -228,8 +367,17 @@ class ReferenceResolvingExecutor
   absl::Status Materialize(std::shared_ptr<ExecutorValue> value,
                            v0::Value* value_pb) final;
 
+  // Transfers the child value of `value` between the child executors, unless
+  // it contains a lambda, which is evaluated by this executor itself.
+  absl::StatusOr<std::optional<std::shared_ptr<ExecutorValue>>>
+  TransferExecutorValue(std::shared_ptr<ExecutorValue> value,
+                        ExecutorBase& target) final;
+
  private:
   std::shared_ptr<Executor> child_executor_;
+  // Runs the concurrent evaluations, or `nullptr` to evaluate everything on
+  // the calling thread.
+  const std::shared_ptr<ExecutorRuntime> runtime_;
 
   // Converts an `ExecutorValue` into a child executor value.
   //
@@ -245,7 +393,23 @@ class ReferenceResolvingExecutor
   // `tensorflow_federated::v0::Block` message defined in
   // tensorflow_federated/proto/v0/computation.proto
   absl::StatusOr<std::shared_ptr<ExecutorValue>> EvaluateBlock(
-      const v0::Block& block_pb, const std::shared_ptr<Scope>& scope) const;
+      const CompiledComputation::Node& node,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& frame) const;
+
+  // Evaluates the local at position `slot` of a block and binds it in the
+  // frame of the block.
+  absl::Status EvaluateLocal(
+      const CompiledComputation::Node& node, int32_t slot,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& block_frame) const;
+
+  // Evaluates the locals of a block on the coordination lane of `runtime_`,
+  // each once the locals it depends on are bound.
+  absl::Status EvaluateLocalsConcurrently(
+      const CompiledComputation::Node& node,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& block_frame) const;
 
   // Evaluates a reference.
   //
@@ -253,8 +417,9 @@ class ReferenceResolvingExecutor
   // `tensorflow_federated::v0::Reference` message defined in
   // tensorflow_federated/proto/v0/computation.proto
   absl::StatusOr<std::shared_ptr<ExecutorValue>> EvaluateReference(
-      const v0::Reference& reference_pb,
-      const std::shared_ptr<Scope>& scope) const;
+      const CompiledComputation::Node& node,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& frame) const;
 
   // Evaluates a lambda.
   //
@@ -262,7 +427,9 @@ class ReferenceResolvingExecutor
   // `tensorflow_federated::v0::Lambda` message defined in
   // tensorflow_federated/proto/v0/computation.proto
   absl::StatusOr<std::shared_ptr<ExecutorValue>> EvaluateLambda(
-      const v0::Lambda& lambda_pb, const std::shared_ptr<Scope>& scope) const;
+      const CompiledComputation::Node& node,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& frame) const;
 
   // Evaluates a call.
   //
@@ -270,7 +437,9 @@ class ReferenceResolvingExecutor
   // `tensorflow_federated::v0::Call` message defined in
   // tensorflow_federated/proto/v0/computation.proto
   absl::StatusOr<std::shared_ptr<ExecutorValue>> EvaluateCall(
-      const v0::Call& call_pb, const std::shared_ptr<Scope>& scope) const;
+      const CompiledComputation::Node& node,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& frame) const;
 
   // Evaluates a struct.
   //
@@ -278,7 +447,9 @@ class ReferenceResolvingExecutor
   // `tensorflow_federated::v0::Struct` message defined in
   // tensorflow_federated/proto/v0/computation.proto
   absl::StatusOr<std::shared_ptr<ExecutorValue>> EvaluateStruct(
-      const v0::Struct& struct_pb, const std::shared_ptr<Scope>& scope) const;
+      const CompiledComputation::Node& node,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& frame) const;
 
   // Evaluates a selection.
   //
@@ -286,54 +457,190 @@ class ReferenceResolvingExecutor
   // `tensorflow_federated::v0::Selection` message defined in
   // tensorflow_federated/proto/v0/computation.proto
   absl::StatusOr<std::shared_ptr<ExecutorValue>> EvaluateSelection(
-      const v0::Selection& selection_pb,
-      const std::shared_ptr<Scope>& scope) const;
+      const CompiledComputation::Node& node,
+      const std::shared_ptr<const CompiledComputation>& computation,
+      const std::shared_ptr<Frame>& frame) const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
 // Method implementations
 ////////////////////////////////////////////////////////////////////////////////
 
+CompiledComputation::CompiledComputation(v0::Computation computation_pb)
+    : computation_pb_(std::move(computation_pb)), root_([this] {
+        LoweringState state;
+        return Lower(computation_pb_, /*num_frames=*/0, state);
+      }()) {}
+
+void CompiledComputation::AddDependency(const Binding& binding,
+                                        LoweringState& state) {
+  std::vector<int32_t>* dependencies = state.frame_dependencies[binding.frame];
+  if (dependencies != nullptr) {
+    dependencies->push_back(binding.slot);
+  }
+}
+
+CompiledComputation::Node CompiledComputation::Lower(
+    const v0::Computation& computation_pb, int32_t num_frames,
+    LoweringState& state) {
+  auto& bindings = state.bindings;
+  Node node{Node::UNIMPLEMENTED, &computation_pb};
+  switch (computation_pb.computation_case()) {
+    case v0::Computation::kTensorflow:
+    case v0::Computation::kIntrinsic:
+    case v0::Computation::kData:
+    case v0::Computation::kPlacement:
+    case v0::Computation::kLiteral:
+    case v0::Computation::kXla: {
+      // Note: we're copying the Computation proto here, possibly a TensorFlow
+      // graph which might have large constants. We don't always have a `Value`
+      // for each `Computation` proto (see `v0::Block::local`), but building
+      // it once here avoids copying the proto each time the node is
+      // evaluated.
+      node.kind = Node::CHILD;
+      *node.child_value_pb.mutable_computation() = computation_pb;
+      break;
+    }
+    case v0::Computation::kReference: {
+      node.kind = Node::REFERENCE;
+      auto it = bindings.find(computation_pb.reference().name());
+      if (it != bindings.end() && !it->second.empty()) {
+        const Binding& binding = it->second.back();
+        node.reference_index =
+            ReferenceIndex{num_frames - 1 - binding.frame, binding.slot};
+        AddDependency(binding, state);
+      }
+      break;
+    }
+    case v0::Computation::kBlock: {
+      node.kind = Node::BLOCK;
+      const v0::Block& block_pb = computation_pb.block();
+      node.children.reserve(block_pb.local_size() + 1);
+      node.local_dependencies.resize(block_pb.local_size());
+      state.frame_dependencies.push_back(nullptr);
+      // Each local is evaluated with the bindings of the preceding locals.
+      for (int32_t i = 0; i < block_pb.local_size(); ++i) {
+        std::vector<int32_t>& dependencies = node.local_dependencies[i];
+        state.frame_dependencies[num_frames] = &dependencies;
+        node.children.push_back(
+            Lower(block_pb.local(i).value(), num_frames + 1, state));
+        bindings[block_pb.local(i).name()].push_back(Binding{num_frames, i});
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(
+            std::unique(dependencies.begin(), dependencies.end()),
+            dependencies.end());
+        // Locals only depend on preceding locals, so a local which doesn't
+        // depend on the one just before it can run alongside it.
+        if (i > 0 && (dependencies.empty() || dependencies.back() != i - 1)) {
+          node.concurrent = true;
+        }
+      }
+      state.frame_dependencies[num_frames] = nullptr;
+      node.children.push_back(Lower(block_pb.result(), num_frames + 1, state));
+      state.frame_dependencies.pop_back();
+      for (const v0::Block::Local& local_pb : block_pb.local()) {
+        bindings[local_pb.name()].pop_back();
+      }
+      break;
+    }
+    case v0::Computation::kLambda: {
+      node.kind = Node::LAMBDA;
+      const v0::Lambda& lambda_pb = computation_pb.lambda();
+      std::vector<Binding>& parameter_bindings =
+          bindings[lambda_pb.parameter_name()];
+      if (!parameter_bindings.empty()) {
+        const Binding& shadowed = parameter_bindings.back();
+        node.reference_index =
+            ReferenceIndex{num_frames - 1 - shadowed.frame, shadowed.slot};
+        AddDependency(shadowed, state);
+      }
+      parameter_bindings.push_back(Binding{num_frames, 0});
+      state.frame_dependencies.push_back(nullptr);
+      node.children.push_back(Lower(lambda_pb.result(), num_frames + 1, state));
+      state.frame_dependencies.pop_back();
+      // The result may have added bindings, so the vector must be found again.
+      bindings[lambda_pb.parameter_name()].pop_back();
+      break;
+    }
+    case v0::Computation::kCall: {
+      node.kind = Node::CALL;
+      const v0::Call& call_pb = computation_pb.call();
+      node.children.push_back(Lower(call_pb.function(), num_frames, state));
+      if (call_pb.has_argument()) {
+        node.children.push_back(Lower(call_pb.argument(), num_frames, state));
+      }
+      break;
+    }
+    case v0::Computation::kStruct: {
+      node.kind = Node::STRUCT;
+      node.children.reserve(computation_pb.struct_().element_size());
+      int32_t num_child_calls = 0;
+      for (const v0::Struct::Element& element_pb :
+           computation_pb.struct_().element()) {
+        node.children.push_back(Lower(element_pb.value(), num_frames, state));
+        // References and lambdas are resolved without calling into the child
+        // executor, so aren't worth evaluating on another thread.
+        if (node.children.back().kind != Node::REFERENCE &&
+            node.children.back().kind != Node::LAMBDA) {
+          ++num_child_calls;
+        }
+      }
+      node.concurrent = num_child_calls > 1;
+      break;
+    }
+    case v0::Computation::kSelection: {
+      node.kind = Node::SELECTION;
+      node.children.push_back(
+          Lower(computation_pb.selection().source(), num_frames, state));
+      break;
+    }
+    default:
+      // Fails when evaluated.
+      break;
+  }
+  return node;
+}
+
 absl::StatusOr<std::shared_ptr<ExecutorValue>> ScopedLambda::Call(
     const ReferenceResolvingExecutor& rre,
     std::optional<std::shared_ptr<ExecutorValue>> arg) const {
-  if (arg.has_value()) {
-    NamedValue named_value =
-        std::make_tuple(lambda_pb_.parameter_name(), std::move(arg.value()));
-    auto new_scope = std::make_shared<Scope>(std::move(named_value), scope_);
-    return rre.Evaluate(lambda_pb_.result(), new_scope);
-  } else {
-    return rre.Evaluate(lambda_pb_.result(), scope_);
-  }
+  auto frame = std::make_shared<Frame>(*lambda_, std::move(arg), frame_);
+  return rre.Evaluate(lambda_->children[0], computation_, frame);
 }
 
-absl::StatusOr<std::shared_ptr<ExecutorValue>> Scope::Resolve(
-    std::string_view name) const {
-  if (binding_.has_value()) {
-    if (std::get<0>(*binding_) == name) {
-      return std::get<1>(*binding_);
+absl::StatusOr<std::shared_ptr<ExecutorValue>> Frame::Resolve(
+    const ReferenceIndex& index, std::string_view name) const {
+  const Frame* frame = this;
+  for (int32_t i = 0; i < index.depth; ++i) {
+    frame = frame->parent_.get();
+    if (frame == nullptr) {
+      return absl::InternalError(
+          absl::StrCat("Reference [", name, "] resolved past the root frame"));
     }
   }
-  if (parent_.has_value()) {
-    return parent_.value()->Resolve(name);
+  const std::shared_ptr<ExecutorValue>& value = frame->values_[index.slot];
+  if (value == nullptr && frame->lambda_ != nullptr) {
+    // The lambda was called without an argument, so its parameter resolves to
+    // the binding it shadows.
+    if (!frame->lambda_->reference_index.has_value()) {
+      return absl::NotFoundError(
+          absl::StrCat("Could not find reference [", name, "]"));
+    }
+    return frame->parent_->Resolve(*frame->lambda_->reference_index, name);
   }
-  return absl::NotFoundError(
-      absl::StrCat("Could not find reference [", name, "]"));
+  return value;
 }
 
-std::string Scope::DebugString() const {
-  std::string msg;
-  if (binding_.has_value()) {
-    msg = absl::StrCat("[", std::get<0>(*binding_), "=",
-                       std::get<1>(*binding_)->DebugString(), "]");
-  } else {
-    msg = "[]";
-  }
-  if (parent_.has_value()) {
-    return absl::StrCat(parent_.value()->DebugString(), "->", msg);
-  } else {
-    return msg;
+std::string Frame::DebugString() const {
+  std::string msg = parent_ != nullptr ? parent_->DebugString() : "[]";
+  absl::MutexLock lock(&mutex_);
+  for (size_t slot = 0; slot < values_.size(); ++slot) {
+    if (values_[slot] != nullptr) {
+      absl::StrAppend(&msg, "->[", name(slot), "=",
+                      values_[slot]->DebugString(), "]");
+    }
   }
+  return msg;
 }
 
 std::string ExecutorValue::DebugString() const {
@@ -367,7 +674,10 @@ ReferenceResolvingExecutor::CreateExecutorValue(const v0::Value& value_pb) {
       return std::make_shared<ExecutorValue>(std::move(elements));
     }
     case v0::Value::kComputation: {
-      return Evaluate(value_pb.computation(), std::make_shared<Scope>());
+      auto computation =
+          std::make_shared<const CompiledComputation>(value_pb.computation());
+      return Evaluate(computation->root(), computation,
+                      std::make_shared<Frame>());
     }
     default:
       return absl::UnimplementedError(absl::StrCat(
@@ -465,6 +775,39 @@ absl::Status ReferenceResolvingExecutor::Materialize(
   return child_executor_->Materialize(child_value_id, value_pb);
 }
 
+// Returns whether `value` is or contains a lambda.
+bool ContainsLambda(const ExecutorValue& value) {
+  switch (value.type()) {
+    case ExecutorValue::ValueType::LAMBDA: {
+      return true;
+    }
+    case ExecutorValue::ValueType::STRUCTURE: {
+      for (const auto& element : value.structure()) {
+        if (ContainsLambda(*element)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    default: {
+      return false;
+    }
+  }
+}
+
+absl::StatusOr<std::optional<std::shared_ptr<ExecutorValue>>>
+ReferenceResolvingExecutor::TransferExecutorValue(
+    std::shared_ptr<ExecutorValue> value, ExecutorBase& target) {
+  if (ContainsLambda(*value)) {
+    return std::nullopt;
+  }
+  auto& target_executor = static_cast<ReferenceResolvingExecutor&>(target);
+  std::optional<OwnedValueId> slot;
+  ValueId child_value_id = TFF_TRY(Embed(*value, &slot));
+  return std::make_shared<ExecutorValue>(TFF_TRY(child_executor_->TransferTo(
+      *target_executor.child_executor_, child_value_id)));
+}
+
 absl::StatusOr<ValueId> ReferenceResolvingExecutor::Embed(
     const ExecutorValue& value, std::optional<OwnedValueId>* slot) const {
   switch (value.type()) {
@@ -505,130 +848,198 @@ absl::StatusOr<ValueId> ReferenceResolvingExecutor::Embed(
 
 absl::StatusOr<std::shared_ptr<ExecutorValue>>
 ReferenceResolvingExecutor::Evaluate(
-    const v0::Computation& computation_pb,
-    const std::shared_ptr<Scope>& scope) const {
-  switch (computation_pb.computation_case()) {
-    case v0::Computation::kTensorflow:
-    case v0::Computation::kIntrinsic:
-    case v0::Computation::kData:
-    case v0::Computation::kPlacement:
-    case v0::Computation::kLiteral:
-    case v0::Computation::kXla: {
-      // Note: we're copying the Computation proto here, possibly a TensorFlow
-      // graph which might have large constants, possibly making it expensive.
-      // However, we've taken this approach because we don't always have a
-      // `Value` for each `Computation` proto (see `v0::Block::local`); this
-      // code is simpler and more homogenous. If profiling shows this is a
-      // hotspot we can optimize.
-      v0::Value child_value_pb;
-      *child_value_pb.mutable_computation() = computation_pb;
+    const CompiledComputation::Node& node,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& frame) const {
+  switch (node.kind) {
+    case CompiledComputation::Node::CHILD: {
       return std::make_shared<ExecutorValue>(
-          TFF_TRY(child_executor_->CreateValue(child_value_pb)));
+          TFF_TRY(child_executor_->CreateValue(node.child_value_pb)));
     }
-    case v0::Computation::kReference: {
-      return EvaluateReference(computation_pb.reference(), scope);
+    case CompiledComputation::Node::REFERENCE: {
+      return EvaluateReference(node, computation, frame);
     }
-    case v0::Computation::kBlock: {
-      return EvaluateBlock(computation_pb.block(), scope);
+    case CompiledComputation::Node::BLOCK: {
+      return EvaluateBlock(node, computation, frame);
     }
-    case v0::Computation::kLambda: {
-      return EvaluateLambda(computation_pb.lambda(), scope);
+    case CompiledComputation::Node::LAMBDA: {
+      return EvaluateLambda(node, computation, frame);
     }
-    case v0::Computation::kCall: {
-      return EvaluateCall(computation_pb.call(), scope);
+    case CompiledComputation::Node::CALL: {
+      return EvaluateCall(node, computation, frame);
     }
-    case v0::Computation::kStruct: {
-      return EvaluateStruct(computation_pb.struct_(), scope);
+    case CompiledComputation::Node::STRUCT: {
+      return EvaluateStruct(node, computation, frame);
     }
-    case v0::Computation::kSelection: {
-      return EvaluateSelection(computation_pb.selection(), scope);
+    case CompiledComputation::Node::SELECTION: {
+      return EvaluateSelection(node, computation, frame);
     }
-    default:
+    case CompiledComputation::Node::UNIMPLEMENTED: {
       return absl::UnimplementedError(
           absl::StrCat("Evaluate not implemented for computation type [",
-                       computation_pb.computation_case(), "]"));
+                       node.computation_pb->computation_case(), "]"));
+    }
   }
 }
 
 absl::StatusOr<std::shared_ptr<ExecutorValue>>
 ReferenceResolvingExecutor::EvaluateBlock(
-    const v0::Block& block_pb, const std::shared_ptr<Scope>& scope) const {
-  std::shared_ptr<Scope> current_scope = scope;
+    const CompiledComputation::Node& node,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& frame) const {
+  auto block_frame =
+      std::make_shared<Frame>(node.computation_pb->block(), frame);
+  if (runtime_ != nullptr && node.concurrent) {
+    TFF_TRY(EvaluateLocalsConcurrently(node, computation, block_frame));
+  } else {
+    for (size_t i = 0; i < node.local_dependencies.size(); ++i) {
+      TFF_TRY(EvaluateLocal(node, i, computation, block_frame));
+    }
+  }
+  return Evaluate(node.children.back(), computation, block_frame);
+}
+
+absl::Status ReferenceResolvingExecutor::EvaluateLocal(
+    const CompiledComputation::Node& node, int32_t slot,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& block_frame) const {
+  const v0::Block& block_pb = node.computation_pb->block();
   auto local_pb_formatter = [](std::string* out,
                                const v0::Block::Local& local_pb) {
     out->append(local_pb.name());
   };
-  for (int i = 0; i < block_pb.local_size(); ++i) {
-    const v0::Block::Local& local_pb = block_pb.local(i);
-    std::shared_ptr<ExecutorValue> value = TFF_TRY(
-        Evaluate(local_pb.value(), current_scope),
-        absl::StrCat(
-            "while evaluating local [", local_pb.name(), "] in block locals [",
-            absl::StrJoin(block_pb.local(), ",", local_pb_formatter), "]"));
-    current_scope = std::make_shared<Scope>(
-        std::make_tuple(local_pb.name(), std::move(value)),
-        std::move(current_scope));
+  std::shared_ptr<ExecutorValue> value = TFF_TRY(
+      Evaluate(node.children[slot], computation, block_frame),
+      absl::StrCat("while evaluating local [", block_pb.local(slot).name(),
+                   "] in block locals [",
+                   absl::StrJoin(block_pb.local(), ",", local_pb_formatter),
+                   "]"));
+  block_frame->Bind(slot, std::move(value));
+  return absl::OkStatus();
+}
+
+absl::Status ReferenceResolvingExecutor::EvaluateLocalsConcurrently(
+    const CompiledComputation::Node& node,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& block_frame) const {
+  // Locals are scheduled in order and only wait for the preceding locals they
+  // depend on, which keeps the `ThreadPool` requirement that work only waits
+  // for work scheduled before it.
+  std::vector<std::shared_future<absl::Status>> locals;
+  locals.reserve(node.local_dependencies.size());
+  for (size_t i = 0; i < node.local_dependencies.size(); ++i) {
+    std::vector<std::shared_future<absl::Status>> dependencies;
+    dependencies.reserve(node.local_dependencies[i].size());
+    for (int32_t dependency : node.local_dependencies[i]) {
+      dependencies.push_back(locals[dependency]);
+    }
+    locals.push_back(ThreadRun(
+        [this, &node, i, &computation, &block_frame,
+         dependencies = std::move(dependencies)]() -> absl::Status {
+          for (const std::shared_future<absl::Status>& dependency :
+               dependencies) {
+            TFF_TRY(dependency.get());
+          }
+          return EvaluateLocal(node, i, computation, block_frame);
+        },
+        runtime_->pool(ExecutorLane::kCoordination)));
+  }
+  // Waits for every local, even after a failure, as they reference the
+  // arguments of this method.
+  absl::Status status = absl::OkStatus();
+  for (const std::shared_future<absl::Status>& local : locals) {
+    status.Update(local.get());
   }
-  return Evaluate(block_pb.result(), current_scope);
+  return status;
 }
 
 absl::StatusOr<std::shared_ptr<ExecutorValue>>
 ReferenceResolvingExecutor::EvaluateReference(
-    const v0::Reference& reference_pb,
-    const std::shared_ptr<Scope>& scope) const {
+    const CompiledComputation::Node& node,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& frame) const {
+  const v0::Reference& reference_pb = node.computation_pb->reference();
+  if (!node.reference_index.has_value()) {
+    return absl::NotFoundError(absl::StrCat(
+        "Could not find reference [", reference_pb.name(),
+        "] while searching scope: ", frame->DebugString()));
+  }
   std::shared_ptr<ExecutorValue> resolved_value =
-      TFF_TRY(scope->Resolve(reference_pb.name()),
-              absl::StrCat("while searching scope: ", scope->DebugString()));
+      TFF_TRY(frame->Resolve(*node.reference_index, reference_pb.name()),
+              absl::StrCat("while searching scope: ", frame->DebugString()));
   if (resolved_value == nullptr) {
     return absl::InternalError(
         absl::StrCat("Resolved reference [", reference_pb.name(),
-                     "] was nullptr. Scope: ", scope->DebugString()));
+                     "] was nullptr. Scope: ", frame->DebugString()));
   }
   return resolved_value;
 }
 
 absl::StatusOr<std::shared_ptr<ExecutorValue>>
 ReferenceResolvingExecutor::EvaluateLambda(
-    const v0::Lambda& lambda_pb, const std::shared_ptr<Scope>& scope) const {
-  return std::make_shared<ExecutorValue>(ScopedLambda{lambda_pb, scope});
+    const CompiledComputation::Node& node,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& frame) const {
+  return std::make_shared<ExecutorValue>(
+      ScopedLambda{computation, node, frame});
 }
 
 absl::StatusOr<std::shared_ptr<ExecutorValue>>
 ReferenceResolvingExecutor::EvaluateCall(
-    const v0::Call& call_pb, const std::shared_ptr<Scope>& scope) const {
+    const CompiledComputation::Node& node,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& frame) const {
   std::shared_ptr<ExecutorValue> function =
-      TFF_TRY(Evaluate(call_pb.function(), scope));
+      TFF_TRY(Evaluate(node.children[0], computation, frame));
   std::optional<std::shared_ptr<ExecutorValue>> argument;
-  if (call_pb.has_argument()) {
-    argument = TFF_TRY(Evaluate(call_pb.argument(), scope));
+  if (node.children.size() > 1) {
+    argument = TFF_TRY(Evaluate(node.children[1], computation, frame));
   }
   return CreateCallInternal(std::move(function), std::move(argument));
 }
 
 absl::StatusOr<std::shared_ptr<ExecutorValue>>
 ReferenceResolvingExecutor::EvaluateStruct(
-    const v0::Struct& struct_pb, const std::shared_ptr<Scope>& scope) const {
+    const CompiledComputation::Node& node,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& frame) const {
   std::vector<std::shared_ptr<ExecutorValue>> elements;
-  elements.reserve(struct_pb.element_size());
-  for (const v0::Struct::Element& element_pb : struct_pb.element()) {
-    elements.emplace_back(TFF_TRY(Evaluate(element_pb.value(), scope)));
+  if (runtime_ != nullptr && node.concurrent) {
+    elements.resize(node.children.size());
+    ParallelTasks tasks(runtime_->pool(ExecutorLane::kCoordination));
+    for (size_t i = 0; i < node.children.size(); ++i) {
+      TFF_TRY(tasks.add_task([this, &node, i, &computation, &frame,
+                              &elements]() -> absl::Status {
+        elements[i] = TFF_TRY(Evaluate(node.children[i], computation, frame));
+        return absl::OkStatus();
+      }));
+    }
+    TFF_TRY(tasks.WaitAll());
+    return std::make_shared<ExecutorValue>(std::move(elements));
+  }
+  elements.reserve(node.children.size());
+  for (const CompiledComputation::Node& element : node.children) {
+    elements.emplace_back(TFF_TRY(Evaluate(element, computation, frame)));
   }
   return std::make_shared<ExecutorValue>(std::move(elements));
 }
 
 absl::StatusOr<std::shared_ptr<ExecutorValue>>
 ReferenceResolvingExecutor::EvaluateSelection(
-    const v0::Selection& selection_pb,
-    const std::shared_ptr<Scope>& scope) const {
+    const CompiledComputation::Node& node,
+    const std::shared_ptr<const CompiledComputation>& computation,
+    const std::shared_ptr<Frame>& frame) const {
   return CreateSelectionInternal(
-      TFF_TRY(Evaluate(selection_pb.source(), scope)), selection_pb.index());
+      TFF_TRY(Evaluate(node.children[0], computation, frame)),
+      node.computation_pb->selection().index());
 }
 
 }  // namespace
 
 std::shared_ptr<Executor> CreateReferenceResolvingExecutor(
-    std::shared_ptr<Executor> child) {
-  return std::make_shared<ReferenceResolvingExecutor>(std::move(child));
+    std::shared_ptr<Executor> child, std::shared_ptr<ExecutorRuntime> runtime) {
+  return std::make_shared<ReferenceResolvingExecutor>(std::move(child),
+                                                      std::move(runtime));
 }
 
 }  // namespace tensorflow_federated
@@ -19,13 +19,20 @@ limitations under the License
 #include <memory>
 
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 
 namespace tensorflow_federated {
 
 // Returns an executor that can resolve Lambdas and References, relying on
 // a child executor to complete the computation.
+//
+// If `runtime` is not null, locals of a block which don't depend on each
+// other, and elements of a struct, are evaluated concurrently on its
+// coordination lane, so that the calls they make into `child` can overlap.
+// Otherwise they are evaluated one at a time on the calling thread.
 std::shared_ptr<Executor> CreateReferenceResolvingExecutor(
-    std::shared_ptr<Executor> child);
+    std::shared_ptr<Executor> child,
+    std::shared_ptr<ExecutorRuntime> runtime = nullptr);
 
 }  // namespace tensorflow_federated
 
@@ -0,0 +1,109 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/noop_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/reference_resolving_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::tensorflow_federated::testing::BlockComputation;
+using ::tensorflow_federated::testing::ComputationV;
+using ::tensorflow_federated::testing::LambdaComputation;
+using ::tensorflow_federated::testing::ReferenceComputation;
+using ::tensorflow_federated::testing::TensorV;
+
+// Benchmarks creating and disposing of a value, which the executor embeds in
+// its child.
+static void BM_CreateAndDisposeValue(benchmark::State& state) {
+  std::shared_ptr<Executor> executor =
+      CreateReferenceResolvingExecutor(std::make_shared<NoOpExecutor>());
+  const v0::Value value_pb = TensorV(1.0f);
+  for (auto s : state) {
+    benchmark::DoNotOptimize(executor->CreateValue(value_pb));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_CreateAndDisposeValue);
+
+// Benchmarks calling `x -> let a_0 = x, a_1 = a_0, ... in a_n` with
+// `state.range(0)` locals, whose evaluation makes no call into the child.
+static void BM_CallLambdaOfBlock(benchmark::State& state) {
+  const int32_t num_locals = state.range(0);
+  std::vector<std::tuple<std::string, v0::Computation>> locals;
+  std::string previous = "x";
+  for (int32_t i = 0; i < num_locals; ++i) {
+    std::string name = absl::StrCat("a_", i);
+    locals.emplace_back(name, ReferenceComputation(previous));
+    previous = std::move(name);
+  }
+  std::shared_ptr<Executor> executor =
+      CreateReferenceResolvingExecutor(std::make_shared<NoOpExecutor>());
+  OwnedValueId fn_id =
+      executor
+          ->CreateValue(ComputationV(LambdaComputation(
+              "x", BlockComputation(locals, ReferenceComputation(previous)))))
+          .value();
+  OwnedValueId arg_id = executor->CreateValue(TensorV(1.0f)).value();
+  for (auto s : state) {
+    benchmark::DoNotOptimize(executor->CreateCall(fn_id, arg_id));
+  }
+  state.SetItemsProcessed(state.iterations() * num_locals);
+}
+
+BENCHMARK(BM_CallLambdaOfBlock)->ArgName("locals")->Arg(1)->Arg(16)->Arg(256);
+
+// Benchmarks creating a struct of `state.range(0)` members and selecting one
+// of them, which the executor tracks without calls into the child.
+static void BM_CreateStructAndSelection(benchmark::State& state) {
+  const int32_t num_members = state.range(0);
+  std::shared_ptr<Executor> executor =
+      CreateReferenceResolvingExecutor(std::make_shared<NoOpExecutor>());
+  std::vector<OwnedValueId> members;
+  std::vector<ValueId> member_ids;
+  for (int32_t i = 0; i < num_members; ++i) {
+    members.push_back(executor->CreateValue(TensorV(i)).value());
+    member_ids.push_back(members.back().ref());
+  }
+  for (auto s : state) {
+    OwnedValueId struct_id = executor->CreateStruct(member_ids).value();
+    benchmark::DoNotOptimize(
+        executor->CreateSelection(struct_id, num_members - 1));
+  }
+  state.SetItemsProcessed(state.iterations() * num_members);
+}
+
+BENCHMARK(BM_CreateStructAndSelection)
+    ->ArgName("members")
+    ->Arg(2)
+    ->Arg(64)
+    ->Arg(1024);
+
+}  // namespace
+}  // namespace tensorflow_federated
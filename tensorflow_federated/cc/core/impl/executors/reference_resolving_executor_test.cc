@@ -41,6 +41,8 @@ limitations under the License
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "tensorflow/cc/framework/scope.h"
 #include "tensorflow/cc/ops/array_ops.h"
@@ -50,6 +52,7 @@ limitations under the License
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor_test_base.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
@@ -542,6 +545,88 @@ TEST_F(ReferenceResolvingExecutorTest,
   EXPECT_THAT(test_executor_->Materialize(create_result.value()), IsOk());
 }
 
+TEST_F(ReferenceResolvingExecutorTest,
+       LambdaInBlockReferencesLocalBoundBeforeLambda) {
+  // Expect that the lambda resolves `test_ref` to the first local, which is
+  // the binding visible where the lambda is defined, and not to the third
+  // local that shadows it afterwards.
+  v0::Value block_value_pb = ComputationV(BlockComputation(
+      {{"test_ref", DataComputation("test_data_uri")},
+       {"test_fn",
+        LambdaComputation("test_arg", ReferenceComputation("test_ref"))},
+       {"test_ref", DataComputation("test_data_uri2")}},
+      ReferenceComputation("test_fn")));
+  const v0::Block& block_pb = block_value_pb.computation().block();
+  ValueId child_id = 3;
+  for (int i : {0, 2}) {
+    EXPECT_CALL(*mock_executor_, Dispose(child_id));
+    EXPECT_CALL(*mock_executor_,
+                CreateValue(::testing::Property(
+                    &v0::Value::computation,
+                    EqualsProto(block_pb.local(i).value()))))
+        .WillOnce([this, child_id]() {
+          return OwnedValueId(mock_executor_, child_id);
+        });
+    ++child_id;
+  }
+  auto create_result = test_executor_->CreateValue(block_value_pb);
+  EXPECT_THAT(create_result, IsOkAndHolds(HasValueId(0)));
+  v0::Value tensor_pb = TensorV(1.0);
+  mock_executor_->ExpectCreateValue(tensor_pb);
+  auto arg_result = test_executor_->CreateValue(tensor_pb);
+  EXPECT_THAT(arg_result, IsOkAndHolds(HasValueId(1)));
+  auto call_result = test_executor_->CreateCall(create_result.value().ref(),
+                                                arg_result.value().ref());
+  EXPECT_THAT(call_result, IsOkAndHolds(HasValueId(2)));
+  EXPECT_CALL(*mock_executor_, Materialize(3, _))
+      .WillOnce(Return(absl::OkStatus()));
+  EXPECT_THAT(test_executor_->Materialize(call_result.value()), IsOk());
+}
+
+TEST_F(ReferenceResolvingExecutorTest,
+       EvaluateBlockIndependentLocalsConcurrentlyWithRuntime) {
+  ExecutorRuntimeOptions options;
+  options.num_io_threads = 1;
+  options.num_compute_threads = 1;
+  options.num_coordination_threads = 2;
+  std::shared_ptr<Executor> executor = CreateReferenceResolvingExecutor(
+      mock_executor_, std::make_shared<ExecutorRuntime>(options));
+  v0::Value block_value_pb = ComputationV(BlockComputation(
+      {{"test_ref1", DataComputation("test_data_uri")},
+       {"test_ref2", DataComputation("test_data_uri2")},
+       {"test_ref3", StructComputation({ReferenceComputation("test_ref1"),
+                                        ReferenceComputation("test_ref2")})}},
+      ReferenceComputation("test_ref3")));
+  const v0::Block& block_pb = block_value_pb.computation().block();
+  // The first local only completes once the second one has started, which
+  // requires them to be evaluated concurrently.
+  absl::Notification second_local_started;
+  bool first_local_overlapped = false;
+  EXPECT_CALL(*mock_executor_,
+              CreateValue(::testing::Property(
+                  &v0::Value::computation,
+                  EqualsProto(block_pb.local(0).value()))))
+      .WillOnce([this, &second_local_started, &first_local_overlapped]() {
+        first_local_overlapped =
+            second_local_started.WaitForNotificationWithTimeout(
+                absl::Seconds(10));
+        return OwnedValueId(mock_executor_, 3);
+      });
+  EXPECT_CALL(*mock_executor_,
+              CreateValue(::testing::Property(
+                  &v0::Value::computation,
+                  EqualsProto(block_pb.local(1).value()))))
+      .WillOnce([this, &second_local_started]() {
+        second_local_started.Notify();
+        return OwnedValueId(mock_executor_, 4);
+      });
+  EXPECT_CALL(*mock_executor_, Dispose(3));
+  EXPECT_CALL(*mock_executor_, Dispose(4));
+  EXPECT_THAT(executor->CreateValue(block_value_pb),
+              IsOkAndHolds(HasValueId(0)));
+  EXPECT_TRUE(first_local_overlapped);
+}
+
 TEST_F(ReferenceResolvingExecutorTest, CreateValueComputationReferenceMissing) {
   v0::Value block_value_pb = ComputationV(BlockComputation(
       {{"test_ref", DataComputation("test_data_uri")},
@@ -907,6 +992,54 @@ TEST_F(ReferenceResolvingExecutorTest, MaterializeFailsOnChildFailure) {
               StatusIs(StatusCode::kInternal, HasSubstr("child test error")));
 }
 
+TEST_F(ReferenceResolvingExecutorTest, TransferToSameExecutorSharesValue) {
+  v0::Value value_pb = TensorV(1.0);
+  ValueId child_id = mock_executor_->ExpectCreateValue(value_pb);
+  OwnedValueId id = TFF_ASSERT_OK(test_executor_->CreateValue(value_pb));
+  OwnedValueId transferred_id =
+      TFF_ASSERT_OK(test_executor_->TransferTo(*test_executor_, id));
+  mock_executor_->ExpectMaterialize(child_id, value_pb);
+  ExpectMaterialize(transferred_id, value_pb);
+}
+
+TEST_F(ReferenceResolvingExecutorTest, TransferToForwardsToChildExecutors) {
+  auto other_mock_executor = std::make_shared<StrictMock<MockExecutor>>();
+  std::shared_ptr<Executor> other_executor =
+      CreateReferenceResolvingExecutor(other_mock_executor);
+  v0::Value value_pb = StructV({TensorV(1.0), TensorV(2.0)});
+  std::vector<ValueId> element_child_ids;
+  for (const auto& element_pb : value_pb.struct_().element()) {
+    element_child_ids.push_back(
+        mock_executor_->ExpectCreateValue(element_pb.value()));
+  }
+  OwnedValueId id = TFF_ASSERT_OK(test_executor_->CreateValue(value_pb));
+  // The mock child executors don't share values, so the struct is
+  // materialized from one and created in the other.
+  ValueId struct_child_id =
+      mock_executor_->ExpectCreateStruct(element_child_ids);
+  mock_executor_->ExpectMaterialize(struct_child_id, value_pb);
+  ValueId other_child_id = other_mock_executor->ExpectCreateValue(value_pb);
+  OwnedValueId transferred_id =
+      TFF_ASSERT_OK(test_executor_->TransferTo(*other_executor, id));
+  other_mock_executor->ExpectMaterialize(other_child_id, value_pb);
+  EXPECT_THAT(other_executor->Materialize(transferred_id),
+              IsOkAndHolds(EqualsProto(value_pb)));
+}
+
+TEST_F(ReferenceResolvingExecutorTest, TransferToRecreatesLambdas) {
+  auto other_mock_executor = std::make_shared<StrictMock<MockExecutor>>();
+  std::shared_ptr<Executor> other_executor =
+      CreateReferenceResolvingExecutor(other_mock_executor);
+  const v0::Value value_pb = ComputationV(
+      LambdaComputation("test_arg", ReferenceComputation("test_arg")));
+  OwnedValueId id = TFF_ASSERT_OK(test_executor_->CreateValue(value_pb));
+  // The lambda is materialized and evaluated by the other executor itself,
+  // rather than embedded in its child.
+  ValueId child_id = mock_executor_->ExpectCreateValue(value_pb);
+  mock_executor_->ExpectMaterialize(child_id, value_pb);
+  TFF_ASSERT_OK(test_executor_->TransferTo(*other_executor, id));
+}
+
 TEST_F(ReferenceResolvingExecutorTest, Dispose) {
   EXPECT_THAT(
       test_executor_->Dispose(0),
@@ -929,5 +1062,28 @@ TEST_F(ReferenceResolvingExecutorTest, DisposeForwardsToChildExecutor) {
   EXPECT_THAT(test_executor_->Dispose(0), IsOk());
 }
 
+TEST_F(ReferenceResolvingExecutorTest, DisposeBatchReleasesChildValues) {
+  const v0::Value value_pb = TensorV(1.0);
+  EXPECT_CALL(*mock_executor_, CreateValue(EqualsProto(value_pb)))
+      .WillOnce([this]() { return OwnedValueId(mock_executor_, 10); })
+      .WillOnce([this]() { return OwnedValueId(mock_executor_, 11); });
+  OwnedValueId first = TFF_ASSERT_OK(test_executor_->CreateValue(value_pb));
+  OwnedValueId second = TFF_ASSERT_OK(test_executor_->CreateValue(value_pb));
+  // The child values are released on a background thread.
+  absl::Notification disposed;
+  EXPECT_CALL(*mock_executor_, Dispose(10));
+  EXPECT_CALL(*mock_executor_, Dispose(11)).WillOnce([&disposed]() {
+    disposed.Notify();
+    return absl::OkStatus();
+  });
+  std::vector<OwnedValueId> values;
+  values.push_back(std::move(first));
+  values.push_back(std::move(second));
+  OwnedValueId::ReleaseBatch(absl::MakeSpan(values));
+  EXPECT_TRUE(disposed.WaitForNotificationWithTimeout(absl::Seconds(10)));
+  EXPECT_THAT(test_executor_->Dispose(0),
+              StatusIs(StatusCode::kNotFound, HasSubstr("value not found")));
+}
+
 }  // namespace
 }  // namespace tensorflow_federated
@@ -15,23 +15,34 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/remote_executor.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 #include <future>  // NOLINT
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "google/protobuf/arena.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "include/grpcpp/grpcpp.h"
 #include "include/grpcpp/support/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/async_grpc_call.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/dispose_queue.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
@@ -43,8 +54,8 @@ namespace tensorflow_federated {
 
 class ExecutorValue;
 
-using ValueFuture =
-    std::shared_future<absl::StatusOr<std::shared_ptr<ExecutorValue>>>;
+using ValueFuture = SharedFuture<std::shared_ptr<ExecutorValue>>;
+using ValuePromise = SharedPromise<std::shared_ptr<ExecutorValue>>;
 
 // A custom deleter for the `std::shared_ptr<v0::ExecutorGroup::StubInterface>`
 // which will call `DisposeExecutor` for the provided `executor_pb`, if any.
@@ -87,9 +98,17 @@ class StubDeleter {
 
 class RemoteExecutor : public ExecutorBase<ValueFuture> {
  public:
-  RemoteExecutor(std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
-                 const CardinalityMap& cardinalities)
-      : stub_(stub.release(), StubDeleter()), cardinalities_(cardinalities) {}
+  RemoteExecutor(
+      std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
+      std::vector<std::shared_ptr<v0::ExecutorGroup::StubInterface>> bulk_stubs,
+      const CardinalityMap& cardinalities,
+      std::shared_ptr<ExecutorRuntime> runtime,
+      RemoteSmallRequestOptions small_requests)
+      : stub_(stub.release(), StubDeleter()),
+        bulk_stubs_(std::move(bulk_stubs)),
+        cardinalities_(cardinalities),
+        runtime_(std::move(runtime)),
+        small_requests_(small_requests) {}
 
   ~RemoteExecutor() override = default;
 
@@ -112,39 +131,94 @@ class RemoteExecutor : public ExecutorBase<ValueFuture> {
 
   absl::Status Materialize(ValueFuture value, v0::Value* value_pb) final;
 
+  // Each batch is sent in a single `ExecuteBatch` request.
+  absl::StatusOr<std::vector<ValueFuture>> CreateExecutorValueBatch(
+      absl::Span<const v0::Value* const> values_pb) final;
+
+  absl::StatusOr<std::vector<ValueFuture>> CreateCallBatch(
+      ValueFuture function, std::vector<ValueFuture> arguments) final;
+
+  absl::StatusOr<std::vector<ValueFuture>> CreateStructBatch(
+      std::vector<std::vector<ValueFuture>> members) final;
+
  private:
   absl::Status EnsureInitialized();
+
+  // Calls `make_request` to fill a request once all of `inputs` are ready,
+  // then starts an asynchronous call of `method` with the request, and returns
+  // a future to the `ExecutorValue` for the value ref of its response. The
+  // request is allocated on an arena which lives until it is serialized, so
+  // that copying a deep value into it does not allocate each of its messages.
+  //
+  // No thread waits for `inputs`, nor for the call itself: the request is
+  // started by a continuation of `inputs`, and the future is set by the
+  // completion of the call.
+  template <typename Request, typename Response, typename MakeRequest>
+  ValueFuture StartValueCall(
+      std::vector<ValueFuture> inputs,
+      AsyncUnaryMethod<v0::ExecutorGroup::StubInterface, Request, Response>
+          method,
+      MakeRequest make_request);
+
+  // Like `StartValueCall`, but calls `ExecuteBatch` with a request which
+  // `make_request` fills with `batch_size` operations, and returns a future to
+  // the `ExecutorValue` of the result of each operation.
+  template <typename MakeRequest>
+  std::vector<ValueFuture> StartBatchCall(std::vector<ValueFuture> inputs,
+                                          size_t batch_size,
+                                          MakeRequest make_request);
+
+  // Calls `start` once all of `inputs` are ready: right away if they already
+  // are, otherwise as a continuation of the last of them, which usually runs
+  // on a gRPC polling thread. With `runtime_` set, the continuation schedules
+  // `start` on its I/O lane instead.
+  template <typename Start>
+  void StartWhenReady(std::vector<ValueFuture> inputs, Start start);
+
+  // Returns the next of `bulk_stubs_`, round robin, or `stub_` if there are
+  // none.
+  const std::shared_ptr<v0::ExecutorGroup::StubInterface>& BulkStub();
+
+  // Returns the stub to send `request` over: a bulk stub if it is a large
+  // `CreateValue` or `ExecuteBatch` request, and `stub_` otherwise.
+  template <typename Request>
+  const std::shared_ptr<v0::ExecutorGroup::StubInterface>& StubFor(
+      const Request& request);
+
+  // Returns the options of a hedged call of `Request`, if it is a small
+  // request with a deadline or hedging configured.
+  template <typename Request>
+  std::optional<HedgedCallOptions> HedgedOptionsFor() const;
+
   std::shared_ptr<v0::ExecutorGroup::StubInterface> stub_;
+  // The stubs of the bulk channels, which share the executor of `stub_`.
+  const std::vector<std::shared_ptr<v0::ExecutorGroup::StubInterface>>
+      bulk_stubs_;
+  std::atomic<size_t> next_bulk_stub_ = 0;
+  CompletionQueuePoller* const poller_ = &CompletionQueuePoller::Default();
   CardinalityMap cardinalities_;
+  const std::shared_ptr<ExecutorRuntime> runtime_;
+  const RemoteSmallRequestOptions small_requests_;
+  // The latencies of recent small requests, from which their hedging delay
+  // is derived.
+  const std::shared_ptr<CallLatencyTracker> small_request_latencies_ =
+      std::make_shared<CallLatencyTracker>();
   absl::Mutex mutex_;
   bool executor_pb_set_ ABSL_GUARDED_BY(mutex_) = false;
   v0::ExecutorId executor_pb_;
+  std::shared_ptr<DisposeQueue> dispose_queue_;
 };
 
 // A value tracked by the RemoteExecutor.
 class ExecutorValue {
  public:
-  ExecutorValue(v0::ValueRef value_ref, v0::ExecutorId executor_pb,
-                std::shared_ptr<v0::ExecutorGroup::StubInterface> stub)
+  ExecutorValue(v0::ValueRef value_ref,
+                std::shared_ptr<DisposeQueue> dispose_queue)
       : value_ref_(std::move(value_ref)),
-        executor_pb_(std::move(executor_pb)),
-        stub_(stub) {}
-  // Dispose implemented for now just on destructors, and stub is copied in.
-  ~ExecutorValue() {
-    ThreadRun([value_ref = value_ref_, executor_pb = executor_pb_,
-               stub = stub_] {
-      v0::DisposeRequest request;
-      v0::DisposeResponse response;
-      grpc::ClientContext context;
-      *request.mutable_executor() = std::move(executor_pb);
-      *request.add_value_ref() = value_ref;
-      grpc::Status dispose_status = stub->Dispose(&context, request, &response);
-      if (!dispose_status.ok()) {
-        LOG(ERROR) << "Error disposing of ExecutorValue [" << value_ref.id()
-                   << "]: " << grpc_to_absl(dispose_status);
-      }
-    });
-  }
+        dispose_queue_(std::move(dispose_queue)) {}
+  // Dispose implemented for now just on destructors. The request is batched
+  // with the disposal of other values of the same executor.
+  ~ExecutorValue() { dispose_queue_->Add(value_ref_); }
 
   const v0::ValueRef& Get() const { return value_ref_; }
   const v0::Type& Type() const { return type_pb_; }
@@ -152,8 +226,7 @@ class ExecutorValue {
  private:
   const v0::ValueRef value_ref_;
   const v0::Type type_pb_;
-  const v0::ExecutorId executor_pb_;
-  std::shared_ptr<v0::ExecutorGroup::StubInterface> stub_;
+  std::shared_ptr<DisposeQueue> dispose_queue_;
 };
 
 absl::Status RemoteExecutor::EnsureInitialized() {
@@ -180,101 +253,328 @@ absl::Status RemoteExecutor::EnsureInitialized() {
     // Tell the `StubDeleter` which executor it should delete when the stub is
     // no longer referenced.
     std::get_deleter<StubDeleter>(stub_)->SetExecutorId(executor_pb_);
+    // The queue holds a reference to the stub, so the executor is only
+    // disposed of once all of its values have been.
+    dispose_queue_ = std::make_shared<DisposeQueue>(stub_, executor_pb_);
   }
   return grpc_to_absl(result);
 }
 
+const std::shared_ptr<v0::ExecutorGroup::StubInterface>&
+RemoteExecutor::BulkStub() {
+  if (bulk_stubs_.empty()) {
+    return stub_;
+  }
+  return bulk_stubs_[next_bulk_stub_.fetch_add(1, std::memory_order_relaxed) %
+                     bulk_stubs_.size()];
+}
+
+template <typename Request>
+const std::shared_ptr<v0::ExecutorGroup::StubInterface>&
+RemoteExecutor::StubFor(const Request& request) {
+  // Only values are large enough to be worth striping, and sizing the other
+  // requests would be wasted work.
+  if constexpr (std::is_same_v<Request, v0::CreateValueRequest> ||
+                std::is_same_v<Request, v0::ExecuteBatchRequest>) {
+    if (!bulk_stubs_.empty() &&
+        request.ByteSizeLong() >= static_cast<size_t>(kMinBulkRequestBytes)) {
+      return BulkStub();
+    }
+  }
+  return stub_;
+}
+
+template <typename Request>
+std::optional<HedgedCallOptions> RemoteExecutor::HedgedOptionsFor() const {
+  if constexpr (std::is_same_v<Request, v0::CreateStructRequest> ||
+                std::is_same_v<Request, v0::CreateSelectionRequest>) {
+    if (small_requests_.hedge ||
+        small_requests_.deadline < absl::InfiniteDuration()) {
+      HedgedCallOptions options;
+      options.deadline = small_requests_.deadline;
+      if (small_requests_.hedge) {
+        options.hedge_delay = small_request_latencies_->Percentile(
+            small_requests_.hedge_latency_percentile);
+        options.latencies = small_request_latencies_;
+      }
+      return options;
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename Request, typename Response, typename MakeRequest>
+ValueFuture RemoteExecutor::StartValueCall(
+    std::vector<ValueFuture> inputs,
+    AsyncUnaryMethod<v0::ExecutorGroup::StubInterface, Request, Response>
+        method,
+    MakeRequest make_request) {
+  auto promise = std::make_shared<ValuePromise>();
+  ValueFuture result = promise->future();
+  auto start = [method, make_request = std::move(make_request), promise, this,
+                this_keepalive = shared_from_this()]() mutable {
+    google::protobuf::Arena arena;
+    Request* request = google::protobuf::Arena::CreateMessage<Request>(&arena);
+    absl::Status status = std::move(make_request)(request);
+    if (!status.ok()) {
+      promise->Set(status);
+      return;
+    }
+    auto on_done = [promise, dispose_queue = dispose_queue_](
+                       absl::StatusOr<Response> response) {
+      if (!response.ok()) {
+        promise->Set(response.status());
+        return;
+      }
+      promise->Set(std::make_shared<ExecutorValue>(
+          std::move(*response->mutable_value_ref()), dispose_queue));
+    };
+    std::optional<HedgedCallOptions> hedged_options =
+        HedgedOptionsFor<Request>();
+    if (!hedged_options.has_value()) {
+      StartAsyncUnaryCall(*poller_, StubFor(*request), method, *request,
+                          std::move(on_done));
+      return;
+    }
+    StartHedgedAsyncUnaryCall(
+        *poller_, StubFor(*request), method, *request,
+        *std::move(hedged_options), std::move(on_done),
+        [dispose_queue = dispose_queue_](Response response) {
+          dispose_queue->Add(std::move(*response.mutable_value_ref()));
+        });
+  };
+  StartWhenReady(std::move(inputs), std::move(start));
+  return result;
+}
+
+template <typename MakeRequest>
+std::vector<ValueFuture> RemoteExecutor::StartBatchCall(
+    std::vector<ValueFuture> inputs, size_t batch_size,
+    MakeRequest make_request) {
+  auto promises = std::make_shared<std::vector<ValuePromise>>(batch_size);
+  std::vector<ValueFuture> results;
+  results.reserve(batch_size);
+  for (const ValuePromise& promise : *promises) {
+    results.push_back(promise.future());
+  }
+  auto start = [make_request = std::move(make_request), promises, this,
+                this_keepalive = shared_from_this()]() mutable {
+    google::protobuf::Arena arena;
+    v0::ExecuteBatchRequest* request =
+        google::protobuf::Arena::CreateMessage<v0::ExecuteBatchRequest>(
+            &arena);
+    *request->mutable_executor() = executor_pb_;
+    absl::Status status = std::move(make_request)(request);
+    if (!status.ok()) {
+      for (ValuePromise& promise : *promises) {
+        promise.Set(status);
+      }
+      return;
+    }
+    StartAsyncUnaryCall(
+        *poller_, StubFor(*request),
+        &v0::ExecutorGroup::StubInterface::AsyncExecuteBatch, *request,
+        [promises, dispose_queue = dispose_queue_](
+            absl::StatusOr<v0::ExecuteBatchResponse> response) {
+          if (response.ok() &&
+              static_cast<size_t>(response->value_ref_size()) !=
+                  promises->size()) {
+            response = absl::InternalError(
+                absl::StrCat("Expected ", promises->size(),
+                             " value refs from ExecuteBatch, found ",
+                             response->value_ref_size()));
+          }
+          for (size_t i = 0; i < promises->size(); ++i) {
+            if (!response.ok()) {
+              (*promises)[i].Set(response.status());
+              continue;
+            }
+            (*promises)[i].Set(std::make_shared<ExecutorValue>(
+                std::move(*response->mutable_value_ref(i)), dispose_queue));
+          }
+        });
+  };
+  StartWhenReady(std::move(inputs), std::move(start));
+  return results;
+}
+
+template <typename Start>
+void RemoteExecutor::StartWhenReady(std::vector<ValueFuture> inputs,
+                                    Start start) {
+  bool inputs_ready = true;
+  for (const ValueFuture& input : inputs) {
+    if (input.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      inputs_ready = false;
+      break;
+    }
+  }
+  if (inputs_ready) {
+    start();
+    return;
+  }
+  ThreadPool* pool =
+      runtime_ != nullptr ? runtime_->pool(ExecutorLane::kIo) : nullptr;
+  WhenAll(std::move(inputs),
+          [start = std::move(start),
+           pool](std::vector<absl::StatusOr<std::shared_ptr<ExecutorValue>>>&&)
+              mutable {
+            if (pool == nullptr) {
+              start();
+              return;
+            }
+            // If the pool is closed, dropping `start` cancels its results.
+            pool->Schedule(std::move(start)).IgnoreError();
+          });
+}
+
 absl::StatusOr<ValueFuture> RemoteExecutor::CreateExecutorValue(
     const v0::Value& value_pb) {
   TFF_TRY(EnsureInitialized());
-  return ThreadRun([value_pb, this, this_keepalive = shared_from_this()]()
-                       -> absl::StatusOr<std::shared_ptr<ExecutorValue>> {
-    v0::CreateValueRequest request;
-    *request.mutable_executor() = executor_pb_;
-    *request.mutable_value() = value_pb;
-    v0::CreateValueResponse response;
-    grpc::ClientContext client_context;
-    grpc::Status status =
-        stub_->CreateValue(&client_context, request, &response);
-    TFF_TRY(grpc_to_absl(status));
-    return std::make_shared<ExecutorValue>(std::move(response.value_ref()),
-                                           executor_pb_, stub_);
-  });
+  // Without inputs to wait for, the request is made before `StartValueCall`
+  // returns, so `value_pb` need not be copied.
+  return StartValueCall(
+      {}, &v0::ExecutorGroup::StubInterface::AsyncCreateValue,
+      [&value_pb, this](v0::CreateValueRequest* request) -> absl::Status {
+        *request->mutable_executor() = executor_pb_;
+        *request->mutable_value() = value_pb;
+        return absl::OkStatus();
+      });
 }
 
 absl::StatusOr<ValueFuture> RemoteExecutor::CreateCall(
     ValueFuture function, std::optional<ValueFuture> argument) {
   TFF_TRY(EnsureInitialized());
-  return ThreadRun([function = std::move(function),
-                    argument = std::move(argument), executor_pb = executor_pb_,
-                    this, this_keepalive = shared_from_this()]()
-                       -> absl::StatusOr<std::shared_ptr<ExecutorValue>> {
-    v0::CreateCallRequest request;
-    v0::CreateCallResponse response;
-    grpc::ClientContext context;
-    std::shared_ptr<ExecutorValue> fn = TFF_TRY(Wait(function));
-
-    *request.mutable_executor() = executor_pb;
-    *request.mutable_function_ref() = fn->Get();
-    if (argument.has_value()) {
-      std::shared_ptr<ExecutorValue> arg_value =
-          TFF_TRY(Wait(argument.value()));
-      *request.mutable_argument_ref() = arg_value->Get();
-    }
-
-    grpc::Status status = this->stub_->CreateCall(&context, request, &response);
-    TFF_TRY(grpc_to_absl(status));
-    return std::make_shared<ExecutorValue>(std::move(response.value_ref()),
-                                           executor_pb, this->stub_);
-  });
+  std::vector<ValueFuture> inputs = {function};
+  if (argument.has_value()) {
+    inputs.push_back(*argument);
+  }
+  return StartValueCall(
+      std::move(inputs), &v0::ExecutorGroup::StubInterface::AsyncCreateCall,
+      [function = std::move(function), argument = std::move(argument),
+       this](v0::CreateCallRequest* request) -> absl::Status {
+        std::shared_ptr<ExecutorValue> fn = TFF_TRY(Wait(function));
+        *request->mutable_executor() = executor_pb_;
+        *request->mutable_function_ref() = fn->Get();
+        if (argument.has_value()) {
+          std::shared_ptr<ExecutorValue> arg_value =
+              TFF_TRY(Wait(argument.value()));
+          *request->mutable_argument_ref() = arg_value->Get();
+        }
+        return absl::OkStatus();
+      });
 }
 
 absl::StatusOr<ValueFuture> RemoteExecutor::CreateStruct(
     std::vector<ValueFuture> members) {
   TFF_TRY(EnsureInitialized());
-  return ThreadRun([futures = std::move(members), this,
-                    this_keepalive = shared_from_this()]()
-                       -> absl::StatusOr<std::shared_ptr<ExecutorValue>> {
-    v0::CreateStructRequest request;
-    *request.mutable_executor() = this->executor_pb_;
-    v0::CreateStructResponse response;
-    grpc::ClientContext context;
-    std::vector<std::shared_ptr<ExecutorValue>> values =
-        TFF_TRY(WaitAll(futures));
-    v0::Type result_type;
-    for (const std::shared_ptr<ExecutorValue>& element : values) {
-      v0::CreateStructRequest_Element struct_elem;
-      *struct_elem.mutable_value_ref() = element->Get();
-      request.mutable_element()->Add(std::move(struct_elem));
-    }
-    grpc::Status status =
-        this->stub_->CreateStruct(&context, request, &response);
-    TFF_TRY(grpc_to_absl(status));
-    auto result = std::make_shared<ExecutorValue>(
-        std::move(response.value_ref()), this->executor_pb_, this->stub_);
-    return result;
-  });
+  std::vector<ValueFuture> inputs = members;
+  return StartValueCall(
+      std::move(inputs), &v0::ExecutorGroup::StubInterface::AsyncCreateStruct,
+      [futures = std::move(members),
+       this](v0::CreateStructRequest* request) -> absl::Status {
+        *request->mutable_executor() = executor_pb_;
+        std::vector<std::shared_ptr<ExecutorValue>> values =
+            TFF_TRY(WaitAll(futures));
+        for (const std::shared_ptr<ExecutorValue>& element : values) {
+          *request->add_element()->mutable_value_ref() = element->Get();
+        }
+        return absl::OkStatus();
+      });
 }
 
 absl::StatusOr<ValueFuture> RemoteExecutor::CreateSelection(
     ValueFuture value, const uint32_t index) {
   TFF_TRY(EnsureInitialized());
-  return ThreadRun([source = std::move(value), index = index, this,
-                    this_keepalive = shared_from_this()]()
-                       -> absl::StatusOr<std::shared_ptr<ExecutorValue>> {
-    std::shared_ptr<ExecutorValue> source_value = TFF_TRY(Wait(source));
-    v0::CreateSelectionRequest request;
-    v0::CreateSelectionResponse response;
-    grpc::ClientContext context;
-    *request.mutable_executor() = this->executor_pb_;
-    *request.mutable_source_ref() = source_value->Get();
-    request.set_index(index);
-    grpc::Status status =
-        this->stub_->CreateSelection(&context, request, &response);
-    TFF_TRY(grpc_to_absl(status));
-    return std::make_shared<ExecutorValue>(std::move(response.value_ref()),
-                                           this->executor_pb_, this->stub_);
-  });
+  std::vector<ValueFuture> inputs = {value};
+  return StartValueCall(
+      std::move(inputs),
+      &v0::ExecutorGroup::StubInterface::AsyncCreateSelection,
+      [source = std::move(value), index,
+       this](v0::CreateSelectionRequest* request) -> absl::Status {
+        std::shared_ptr<ExecutorValue> source_value = TFF_TRY(Wait(source));
+        *request->mutable_executor() = executor_pb_;
+        *request->mutable_source_ref() = source_value->Get();
+        request->set_index(index);
+        return absl::OkStatus();
+      });
+}
+
+absl::StatusOr<std::vector<ValueFuture>>
+RemoteExecutor::CreateExecutorValueBatch(
+    absl::Span<const v0::Value* const> values_pb) {
+  if (values_pb.empty()) {
+    return std::vector<ValueFuture>();
+  }
+  TFF_TRY(EnsureInitialized());
+  // As in `CreateExecutorValue`, the request is made before `StartBatchCall`
+  // returns.
+  return StartBatchCall(
+      {}, values_pb.size(),
+      [values_pb](v0::ExecuteBatchRequest* request) -> absl::Status {
+        for (const v0::Value* value_pb : values_pb) {
+          *request->add_operation()->mutable_create_value()->mutable_value() =
+              *value_pb;
+        }
+        return absl::OkStatus();
+      });
+}
+
+absl::StatusOr<std::vector<ValueFuture>> RemoteExecutor::CreateCallBatch(
+    ValueFuture function, std::vector<ValueFuture> arguments) {
+  if (arguments.empty()) {
+    return std::vector<ValueFuture>();
+  }
+  TFF_TRY(EnsureInitialized());
+  std::vector<ValueFuture> inputs = arguments;
+  inputs.push_back(function);
+  const size_t batch_size = arguments.size();
+  return StartBatchCall(
+      std::move(inputs), batch_size,
+      [function = std::move(function), arguments = std::move(arguments)](
+          v0::ExecuteBatchRequest* request) -> absl::Status {
+        std::shared_ptr<ExecutorValue> fn = TFF_TRY(Wait(function));
+        std::vector<std::shared_ptr<ExecutorValue>> args =
+            TFF_TRY(WaitAll(arguments));
+        for (const std::shared_ptr<ExecutorValue>& arg : args) {
+          v0::ExecuteBatchRequest::CreateCall* create_call =
+              request->add_operation()->mutable_create_call();
+          *create_call->mutable_function_ref()->mutable_value_ref() =
+              fn->Get();
+          *create_call->mutable_argument_ref()->mutable_value_ref() =
+              arg->Get();
+        }
+        return absl::OkStatus();
+      });
+}
+
+absl::StatusOr<std::vector<ValueFuture>> RemoteExecutor::CreateStructBatch(
+    std::vector<std::vector<ValueFuture>> members) {
+  if (members.empty()) {
+    return std::vector<ValueFuture>();
+  }
+  TFF_TRY(EnsureInitialized());
+  std::vector<ValueFuture> inputs;
+  for (const std::vector<ValueFuture>& struct_members : members) {
+    inputs.insert(inputs.end(), struct_members.begin(), struct_members.end());
+  }
+  const size_t batch_size = members.size();
+  return StartBatchCall(
+      std::move(inputs), batch_size,
+      [members = std::move(members)](
+          v0::ExecuteBatchRequest* request) -> absl::Status {
+        for (const std::vector<ValueFuture>& struct_members : members) {
+          std::vector<std::shared_ptr<ExecutorValue>> values =
+              TFF_TRY(WaitAll(struct_members));
+          v0::ExecuteBatchRequest::CreateStruct* create_struct =
+              request->add_operation()->mutable_create_struct();
+          for (const std::shared_ptr<ExecutorValue>& element : values) {
+            *create_struct->add_element()
+                 ->mutable_value_ref()
+                 ->mutable_value_ref() = element->Get();
+          }
+        }
+        return absl::OkStatus();
+      });
 }
 
 absl::Status RemoteExecutor::Materialize(ValueFuture value,
@@ -284,25 +584,70 @@ absl::Status RemoteExecutor::Materialize(ValueFuture value,
   *request.mutable_executor() = executor_pb_;
   *request.mutable_value_ref() = value_ref->Get();
 
+  // The response is not allocated on an arena, so that its value is moved to
+  // `value_pb` rather than copied.
   v0::ComputeResponse compute_response;
   grpc::ClientContext client_context;
+  // Materialized values may be large, e.g. the model of a round.
   grpc::Status status =
-      stub_->Compute(&client_context, request, &compute_response);
+      BulkStub()->Compute(&client_context, request, &compute_response);
   *value_pb = std::move(*compute_response.mutable_value());
   return grpc_to_absl(status);
 }
 
 std::shared_ptr<Executor> CreateRemoteExecutor(
     std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
-    const CardinalityMap& cardinalities) {
-  return std::make_shared<RemoteExecutor>(std::move(stub), cardinalities);
+    const CardinalityMap& cardinalities,
+    std::shared_ptr<ExecutorRuntime> runtime,
+    RemoteSmallRequestOptions small_requests) {
+  return std::make_shared<RemoteExecutor>(
+      std::move(stub),
+      std::vector<std::shared_ptr<v0::ExecutorGroup::StubInterface>>(),
+      cardinalities, std::move(runtime), small_requests);
+}
+
+std::shared_ptr<Executor> CreateRemoteExecutor(
+    std::shared_ptr<grpc::ChannelInterface> channel,
+    const CardinalityMap& cardinalities,
+    std::shared_ptr<ExecutorRuntime> runtime,
+    RemoteSmallRequestOptions small_requests) {
+  return CreateRemoteExecutor(std::move(channel), {}, cardinalities,
+                              std::move(runtime), small_requests);
+}
+
+std::shared_ptr<Executor> CreateRemoteExecutor(
+    std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
+    std::vector<std::unique_ptr<v0::ExecutorGroup::StubInterface>> bulk_stubs,
+    const CardinalityMap& cardinalities,
+    std::shared_ptr<ExecutorRuntime> runtime,
+    RemoteSmallRequestOptions small_requests) {
+  std::vector<std::shared_ptr<v0::ExecutorGroup::StubInterface>> shared_stubs;
+  shared_stubs.reserve(bulk_stubs.size());
+  for (std::unique_ptr<v0::ExecutorGroup::StubInterface>& bulk_stub :
+       bulk_stubs) {
+    shared_stubs.push_back(std::move(bulk_stub));
+  }
+  return std::make_shared<RemoteExecutor>(
+      std::move(stub), std::move(shared_stubs), cardinalities,
+      std::move(runtime), small_requests);
 }
 
 std::shared_ptr<Executor> CreateRemoteExecutor(
     std::shared_ptr<grpc::ChannelInterface> channel,
-    const CardinalityMap& cardinalities) {
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& bulk_channels,
+    const CardinalityMap& cardinalities,
+    std::shared_ptr<ExecutorRuntime> runtime,
+    RemoteSmallRequestOptions small_requests) {
   std::unique_ptr<v0::ExecutorGroup::StubInterface> stub(
       v0::ExecutorGroup::NewStub(channel));
-  return std::make_shared<RemoteExecutor>(std::move(stub), cardinalities);
+  std::vector<std::unique_ptr<v0::ExecutorGroup::StubInterface>> bulk_stubs;
+  bulk_stubs.reserve(bulk_channels.size());
+  for (const std::shared_ptr<grpc::ChannelInterface>& bulk_channel :
+       bulk_channels) {
+    bulk_stubs.push_back(v0::ExecutorGroup::NewStub(bulk_channel));
+  }
+  return CreateRemoteExecutor(std::move(stub), std::move(bulk_stubs),
+                              cardinalities, std::move(runtime),
+                              small_requests);
 }
 }  // namespace tensorflow_federated
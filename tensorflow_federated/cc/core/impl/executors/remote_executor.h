@@ -16,22 +16,83 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_REMOTE_EXECUTOR_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_REMOTE_EXECUTOR_H_
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
+#include "absl/time/time.h"
 #include "include/grpcpp/grpcpp.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
 
 namespace tensorflow_federated {
 
+// Options of the small requests of a remote executor, the `CreateStruct` and
+// `CreateSelection` requests, which only refer to values the service already
+// holds. They are idempotent and quick to serve, so a late response is
+// usually held up by a slow worker or connection rather than by the work
+// itself, and holds up callers which wait for many values at once, such as
+// `ComposingExecutor`.
+struct RemoteSmallRequestOptions {
+  // The deadline of each small request, after which it fails with
+  // DEADLINE_EXCEEDED. Infinite by default.
+  absl::Duration deadline = absl::InfiniteDuration();
+  // Whether a small request which has not completed after the
+  // `hedge_latency_percentile` of the latencies of recent small requests is
+  // sent a second time. The first response is used, and the other request is
+  // cancelled, or the value it created disposed of.
+  bool hedge = false;
+  double hedge_latency_percentile = 0.95;
+};
+
 // Returns an executor which communicates with a remote executor service.
+//
+// Calls are asynchronous throughout: no thread waits for the inputs of a call
+// or for its response, so the number of calls in flight is not bounded by the
+// number of threads. If `runtime` is not null, the requests of calls whose
+// inputs were pending are started from its I/O lane rather than from the
+// thread which completed the inputs. `small_requests` sets the deadline and
+// hedging of the small requests; other requests, including all transfers of
+// values, are sent once and without a deadline.
+std::shared_ptr<Executor> CreateRemoteExecutor(
+    std::shared_ptr<grpc::ChannelInterface> channel,
+    const CardinalityMap& cardinalities,
+    std::shared_ptr<ExecutorRuntime> runtime = nullptr,
+    RemoteSmallRequestOptions small_requests = RemoteSmallRequestOptions());
+std::shared_ptr<Executor> CreateRemoteExecutor(
+    std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
+    const CardinalityMap& cardinalities,
+    std::shared_ptr<ExecutorRuntime> runtime = nullptr,
+    RemoteSmallRequestOptions small_requests = RemoteSmallRequestOptions());
+
+// `CreateValue` requests at least this large are sent over the bulk channels
+// of a remote executor, if it has any.
+inline constexpr int64_t kMinBulkRequestBytes = int64_t{1} << 20;
+
+// Returns an executor as above which sends large transfers over
+// `bulk_channels`, round robin, and all other requests over `channel`: values
+// of at least `kMinBulkRequestBytes` are created, and all values are
+// materialized, over the bulk channels, so that uploading or downloading a
+// model does not hold up the control requests which follow it, such as calls
+// and disposals, behind the flow control window of a single connection.
+//
+// The channels must address the same executor service, each over a connection
+// of its own, e.g. with `GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL` set. Without bulk
+// channels, the executor is the same as one created over `channel` alone.
 std::shared_ptr<Executor> CreateRemoteExecutor(
     std::shared_ptr<grpc::ChannelInterface> channel,
-    const CardinalityMap& cardinalities);
+    const std::vector<std::shared_ptr<grpc::ChannelInterface>>& bulk_channels,
+    const CardinalityMap& cardinalities,
+    std::shared_ptr<ExecutorRuntime> runtime = nullptr,
+    RemoteSmallRequestOptions small_requests = RemoteSmallRequestOptions());
 std::shared_ptr<Executor> CreateRemoteExecutor(
     std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
-    const CardinalityMap& cardinalities);
+    std::vector<std::unique_ptr<v0::ExecutorGroup::StubInterface>> bulk_stubs,
+    const CardinalityMap& cardinalities,
+    std::shared_ptr<ExecutorRuntime> runtime = nullptr,
+    RemoteSmallRequestOptions small_requests = RemoteSmallRequestOptions());
 }  // namespace tensorflow_federated
 
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_REMOTE_EXECUTOR_H_
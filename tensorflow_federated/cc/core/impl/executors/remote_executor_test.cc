@@ -35,6 +35,8 @@ limitations under the License
 #include "include/grpcpp/create_channel.h"
 #include "include/grpcpp/security/credentials.h"
 #include "include/grpcpp/support/status.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_grpc.h"
@@ -426,6 +428,76 @@ TEST_F(RemoteExecutorTest, CreateCallError) {
   WaitForDisposeExecutor(dispose_notification);
 }
 
+TEST_F(RemoteExecutorTest, CreateCallBatchSendsSingleExecuteBatch) {
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+  v0::Value tensor_two = testing::TensorV(2.0f);
+  v0::Value tensor_three = testing::TensorV(3.0f);
+
+  v0::Value materialized_value;
+  absl::Status materialize_status;
+  {
+    v0::ExecuteBatchRequest expected_values_request;
+    expected_values_request.mutable_executor()->set_id(kExecutorId);
+    for (const v0::Value& value : {tensor_two, tensor_three}) {
+      *expected_values_request.add_operation()
+           ->mutable_create_value()
+           ->mutable_value() = value;
+    }
+    v0::ExecuteBatchResponse values_response;
+    values_response.add_value_ref()->set_id("argument_ref_0");
+    values_response.add_value_ref()->set_id("argument_ref_1");
+    EXPECT_CALL(*mock_executor_service_,
+                ExecuteBatch(::testing::_, EqualsProto(expected_values_request),
+                             ::testing::_))
+        .WillOnce(::testing::DoAll(::testing::SetArgPointee<2>(values_response),
+                                   ::testing::Return(grpc::Status::OK)));
+    EXPECT_CALL(*mock_executor_service_,
+                CreateValue(::testing::_, ::testing::_, ::testing::_))
+        .WillOnce(
+            ReturnOkWithResponseId<v0::CreateValueResponse>("function_ref"));
+
+    OwnedValueId fn = TFF_ASSERT_OK(test_executor_->CreateValue(tensor_two));
+    std::vector<OwnedValueId> args = TFF_ASSERT_OK(
+        test_executor_->CreateValueBatch({&tensor_two, &tensor_three}));
+    ASSERT_EQ(args.size(), 2);
+
+    v0::ExecuteBatchRequest expected_calls_request;
+    expected_calls_request.mutable_executor()->set_id(kExecutorId);
+    for (const char* argument_ref : {"argument_ref_0", "argument_ref_1"}) {
+      v0::ExecuteBatchRequest::CreateCall* create_call =
+          expected_calls_request.add_operation()->mutable_create_call();
+      create_call->mutable_function_ref()->mutable_value_ref()->set_id(
+          "function_ref");
+      create_call->mutable_argument_ref()->mutable_value_ref()->set_id(
+          argument_ref);
+    }
+    v0::ExecuteBatchResponse calls_response;
+    calls_response.add_value_ref()->set_id("call_ref_0");
+    calls_response.add_value_ref()->set_id("call_ref_1");
+    EXPECT_CALL(*mock_executor_service_,
+                ExecuteBatch(::testing::_, EqualsProto(expected_calls_request),
+                             ::testing::_))
+        .WillOnce(::testing::DoAll(::testing::SetArgPointee<2>(calls_response),
+                                   ::testing::Return(grpc::Status::OK)));
+
+    std::vector<OwnedValueId> calls = TFF_ASSERT_OK(
+        test_executor_->CreateCallBatch(fn, {args[0].ref(), args[1].ref()}));
+    ASSERT_EQ(calls.size(), 2);
+
+    EXPECT_CALL(
+        *mock_executor_service_,
+        Compute(::testing::_, EqualsProto(ComputeRequestForId("call_ref_1")),
+                ::testing::_))
+        .WillOnce(ReturnOkWithComputeResponse(tensor_three));
+    materialize_status =
+        test_executor_->Materialize(calls[1], &materialized_value);
+  }
+  TFF_EXPECT_OK(materialize_status);
+  EXPECT_THAT(materialized_value, EqualsProto(tensor_three));
+  WaitForDisposeExecutor(dispose_notification);
+}
+
 TEST_F(RemoteExecutorTest, CreateStructWithTwoElements) {
   absl::Notification dispose_notification;
   ExpectGetAndDisposeExecutor(dispose_notification);
@@ -627,4 +699,47 @@ TEST_F(RemoteExecutorTest, CreateSelectionWithError) {
   WaitForDisposeExecutor(dispose_notification);
 }
 
+TEST_F(RemoteExecutorTest, SendsLargeTransfersOverBulkChannels) {
+  MockGrpcExecutorServer bulk_executor;
+  std::vector<std::unique_ptr<v0::ExecutorGroup::StubInterface>> bulk_stubs;
+  bulk_stubs.push_back(bulk_executor.NewStub());
+  CardinalityMap cardinalities = {{"server", 1}, {"clients", 1}};
+  test_executor_ = CreateRemoteExecutor(mock_executor_.NewStub(),
+                                        std::move(bulk_stubs), cardinalities);
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+
+  v0::Value small = testing::TensorV(2.0f);
+  v0::Value large = testing::TensorV(
+      tensorflow::DT_FLOAT, tensorflow::TensorShape({kMinBulkRequestBytes}));
+  v0::Value materialized_value;
+  {
+    EXPECT_CALL(*mock_executor_service_,
+                CreateValue(::testing::_,
+                            EqualsProto(CreateValueRequestForValue(small)),
+                            ::testing::_))
+        .WillOnce(ReturnOkWithResponseId<v0::CreateValueResponse>("small"));
+    EXPECT_CALL(*bulk_executor.service(),
+                CreateValue(::testing::_,
+                            EqualsProto(CreateValueRequestForValue(large)),
+                            ::testing::_))
+        .WillOnce(ReturnOkWithResponseId<v0::CreateValueResponse>("large"));
+    EXPECT_CALL(*bulk_executor.service(),
+                Compute(::testing::_, EqualsProto(ComputeRequestForId("small")),
+                        ::testing::_))
+        .WillOnce(ReturnOkWithComputeResponse(small));
+    // Disposals are control requests.
+    EXPECT_CALL(*mock_executor_service_,
+                Dispose(::testing::_, ::testing::_, ::testing::_))
+        .WillRepeatedly(::testing::Return(grpc::Status::OK));
+
+    OwnedValueId small_ref = TFF_ASSERT_OK(test_executor_->CreateValue(small));
+    OwnedValueId large_ref = TFF_ASSERT_OK(test_executor_->CreateValue(large));
+    // Materialized values may be large, whatever the size of their creation.
+    TFF_EXPECT_OK(test_executor_->Materialize(small_ref, &materialized_value));
+  }
+  EXPECT_THAT(materialized_value, EqualsProto(small));
+  WaitForDisposeExecutor(dispose_notification);
+}
+
 }  // namespace tensorflow_federated
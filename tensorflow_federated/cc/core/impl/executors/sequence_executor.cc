@@ -15,13 +15,16 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/sequence_executor.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <future>  // NOLINT
 #include <memory>
 #include <optional>
 #include <string_view>
+#include <thread>  // NOLINT
 #include <utility>
 #include <variant>
 #include <vector>
@@ -66,69 +69,36 @@ class SequenceIterator {
   virtual ~SequenceIterator() = default;
 };
 
-// Computes the number of tensors in a nested tensor type, returning an error
-// status if a type other than tensor or structure is encountered.
-absl::StatusOr<uint32_t> NumTensorsInType(const v0::Type& type) {
-  switch (type.type_case()) {
-    case v0::Type::kTensor: {
-      return 1;
-    }
-    case v0::Type::kStruct: {
-      uint32_t total_count = 0;
-      for (const auto& el_type : type.struct_().element()) {
-        total_count += TFF_TRY(NumTensorsInType(el_type.value()));
-      }
-      return total_count;
-    }
-    default:
-      return absl::UnimplementedError(
-          absl::StrCat("Encountered unexpected type while counting tensors: ",
-                       type.Utf8DebugString(),
-                       ". Only nested structures of tensors are supported."));
-  }
-}
-
+// Embeds the tensors of a value of a nested tensor type, following the
+// traversal `plan` of the type.
 absl::StatusOr<Embedded> EmbedTensorsAsType(
     const absl::Span<const tensorflow::Tensor> tensors,
-    Executor& target_executor, const v0::Type& type) {
-  switch (type.type_case()) {
-    case v0::Type::kTensor: {
-      if (tensors.size() != 1) {
-        return absl::InvalidArgumentError(absl::StrCat(
-            "Attempted to embed a vector of tensors of length ", tensors.size(),
-            " as a single tensor. This embedding is only supported for a "
-            "vector of length 1."));
-      }
-
-      v0::Value tensor_value;
-      TFF_TRY(SerializeTensorValue(tensors.at(0), &tensor_value));
-      return ShareValueId(TFF_TRY(target_executor.CreateValue(tensor_value)));
-    }
-    case v0::Type::kStruct: {
-      std::vector<uint32_t> traversal_order =
-          TFF_TRY(TFNestTraversalOrderFromStruct(type.struct_()));
-      uint32_t next_element_index = 0;
-      std::vector<Embedded> owned_elements;
-      std::vector<ValueId> unowned_elements;
-      for (const uint32_t idx : traversal_order) {
-        auto el_type = type.struct_().element().at(idx);
-        uint32_t num_tensors = TFF_TRY(NumTensorsInType(el_type.value()));
-        absl::Span<const tensorflow::Tensor> subsampled_tensors =
-            tensors.subspan(next_element_index, num_tensors);
-        Embedded owned_element = TFF_TRY(EmbedTensorsAsType(
-            subsampled_tensors, target_executor, el_type.value()));
-        owned_elements.emplace_back(owned_element);
-        unowned_elements.emplace_back(owned_element->ref());
-        next_element_index += num_tensors;
-      }
-      return ShareValueId(
-          TFF_TRY(target_executor.CreateStruct(unowned_elements)));
+    Executor& target_executor, const TensorTraversalPlan& plan) {
+  if (plan.is_tensor) {
+    if (tensors.size() != 1) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Attempted to embed a vector of tensors of length ", tensors.size(),
+          " as a single tensor. This embedding is only supported for a "
+          "vector of length 1."));
     }
-    default:
-      return absl::InvalidArgumentError(
-          absl::StrCat("Attempted to embed as type: ", type.Utf8DebugString(),
-                       ". Only nested structures of tensors are supported."));
+
+    v0::Value tensor_value;
+    TFF_TRY(SerializeTensorValue(tensors.at(0), &tensor_value));
+    return ShareValueId(TFF_TRY(target_executor.CreateValue(tensor_value)));
+  }
+  std::vector<Embedded> owned_elements;
+  std::vector<ValueId> unowned_elements;
+  owned_elements.reserve(plan.elements.size());
+  unowned_elements.reserve(plan.elements.size());
+  for (const TensorTraversalPlan& element_plan : plan.elements) {
+    absl::Span<const tensorflow::Tensor> subsampled_tensors =
+        tensors.subspan(element_plan.offset, element_plan.num_tensors);
+    Embedded owned_element = TFF_TRY(
+        EmbedTensorsAsType(subsampled_tensors, target_executor, element_plan));
+    owned_elements.emplace_back(owned_element);
+    unowned_elements.emplace_back(owned_element->ref());
   }
+  return ShareValueId(TFF_TRY(target_executor.CreateStruct(unowned_elements)));
 }
 
 class MappedIterator : public SequenceIterator {
@@ -161,8 +131,8 @@ class DatasetIterator : public SequenceIterator {
  public:
   explicit DatasetIterator(
       std::unique_ptr<tensorflow::data::standalone::Iterator> iter,
-      v0::Type element_type)
-      : ds_iterator_(std::move(iter)), element_type_(std::move(element_type)) {}
+      std::shared_ptr<const TensorTraversalPlan> element_plan)
+      : ds_iterator_(std::move(iter)), element_plan_(std::move(element_plan)) {}
 
   ~DatasetIterator() final = default;
 
@@ -179,13 +149,129 @@ class DatasetIterator : public SequenceIterator {
     if (end_of_data) {
       return std::nullopt;
     }
-    return TFF_TRY(EmbedTensorsAsType(output_tensors, target, element_type_));
+    return TFF_TRY(EmbedTensorsAsType(output_tensors, target, *element_plan_));
   }
 
  private:
   DatasetIterator() = delete;
   std::unique_ptr<tensorflow::data::standalone::Iterator> ds_iterator_;
-  v0::Type element_type_;
+  const std::shared_ptr<const TensorTraversalPlan> element_plan_;
+};
+
+// Iterates the elements of a sequence in columnar form by slicing its columns,
+// without building a dataset or parsing the elements one at a time.
+class ColumnsIterator : public SequenceIterator {
+ public:
+  explicit ColumnsIterator(
+      std::shared_ptr<const std::vector<tensorflow::Tensor>> columns,
+      std::shared_ptr<const TensorTraversalPlan> element_plan)
+      : columns_(std::move(columns)), element_plan_(std::move(element_plan)) {}
+
+  ~ColumnsIterator() final = default;
+
+  absl::StatusOr<std::optional<Embedded>> GetNextEmbedded(
+      Executor& target) final {
+    if (columns_->empty() || next_index_ >= columns_->front().dim_size(0)) {
+      return std::nullopt;
+    }
+    std::vector<tensorflow::Tensor> element;
+    element.reserve(columns_->size());
+    for (const tensorflow::Tensor& column : *columns_) {
+      element.push_back(column.SubSlice(next_index_));
+    }
+    ++next_index_;
+    return TFF_TRY(EmbedTensorsAsType(element, target, *element_plan_));
+  }
+
+ private:
+  ColumnsIterator() = delete;
+  const std::shared_ptr<const std::vector<tensorflow::Tensor>> columns_;
+  const std::shared_ptr<const TensorTraversalPlan> element_plan_;
+  int64_t next_index_ = 0;
+};
+
+// Pulls the elements of another iterator on a background thread into a buffer
+// of at most `depth` elements, so that fetching and embedding the elements of
+// a sequence overlaps with their consumption.
+class PrefetchingIterator : public SequenceIterator {
+ public:
+  explicit PrefetchingIterator(
+      std::unique_ptr<SequenceIterator> existing_iterator, int32_t depth)
+      : existing_iterator_(std::move(existing_iterator)), depth_(depth) {}
+
+  ~PrefetchingIterator() final {
+    {
+      absl::MutexLock lock(&mutex_);
+      cancelled_ = true;
+      space_available_.Signal();
+    }
+    if (prefetch_thread_.joinable()) {
+      prefetch_thread_.join();
+    }
+  }
+
+  // Prefetching starts on the first call, and embeds all elements in the
+  // `target` of that call.
+  absl::StatusOr<std::optional<Embedded>> GetNextEmbedded(
+      Executor& target) final {
+    absl::MutexLock lock(&mutex_);
+    if (!prefetch_thread_.joinable()) {
+      prefetch_thread_ = std::thread([this, &target] { Prefetch(target); });
+    }
+    while (buffer_.empty() && !done_) {
+      element_available_.Wait(&mutex_);
+    }
+    if (buffer_.empty()) {
+      // The end of the sequence or the error which stopped prefetching.
+      TFF_TRY(final_status_);
+      return std::nullopt;
+    }
+    Embedded element = std::move(buffer_.front());
+    buffer_.pop_front();
+    space_available_.Signal();
+    return element;
+  }
+
+ private:
+  PrefetchingIterator() = delete;
+
+  void Prefetch(Executor& target) {
+    while (true) {
+      {
+        absl::MutexLock lock(&mutex_);
+        while (!cancelled_ && buffer_.size() >= static_cast<size_t>(depth_)) {
+          space_available_.Wait(&mutex_);
+        }
+        if (cancelled_) {
+          return;
+        }
+      }
+      absl::StatusOr<std::optional<Embedded>> element =
+          existing_iterator_->GetNextEmbedded(target);
+      absl::MutexLock lock(&mutex_);
+      if (!element.ok() || !element->has_value()) {
+        final_status_ = element.status();
+        done_ = true;
+        element_available_.Signal();
+        return;
+      }
+      buffer_.push_back(std::move(element->value()));
+      element_available_.Signal();
+    }
+  }
+
+  std::unique_ptr<SequenceIterator> existing_iterator_;
+  const int32_t depth_;
+  absl::Mutex mutex_;
+  std::deque<Embedded> buffer_ ABSL_GUARDED_BY(mutex_);
+  // Whether `existing_iterator_` reached its end or failed with
+  // `final_status_`.
+  bool done_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status final_status_ ABSL_GUARDED_BY(mutex_);
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::CondVar element_available_;
+  absl::CondVar space_available_;
+  std::thread prefetch_thread_;
 };
 
 class SequenceIterator;
@@ -195,13 +281,29 @@ using IteratorFactory =
 
 using SequenceVariant = std::variant<v0::Value, IteratorFactory>;
 
+class Sequence;
+
+// The source and the mapping function of a sequence created by `sequence_map`.
+struct SequenceMapping {
+  std::shared_ptr<Sequence> source;
+  Embedded mapping_fn;
+};
+
 // Internal interface representing an iterable value embedded
 // in the sequence executor.
 class Sequence {
  public:
   enum class SequenceValueType { ITERATOR_FACTORY, VALUE_PROTO };
-  explicit Sequence(SequenceVariant&& value, std::shared_ptr<Executor> executor)
-      : value_(std::move(value)), executor_(executor) {}
+  // If `prefetch_depth` is positive, iterators over the sequence prefetch up
+  // to that many elements in the background. `mapping` is set if the sequence
+  // is the result of a `sequence_map`.
+  explicit Sequence(SequenceVariant&& value, std::shared_ptr<Executor> executor,
+                    int32_t prefetch_depth = 0,
+                    std::optional<SequenceMapping> mapping = std::nullopt)
+      : value_(std::move(value)),
+        executor_(executor),
+        prefetch_depth_(prefetch_depth),
+        mapping_(std::move(mapping)) {}
 
   inline SequenceValueType type() const {
     if (std::holds_alternative<v0::Value>(value_)) {
@@ -213,6 +315,10 @@ class Sequence {
 
   inline v0::Value& proto() { return std::get<v0::Value>(value_); }
 
+  inline const std::optional<SequenceMapping>& mapping() const {
+    return mapping_;
+  }
+
   absl::StatusOr<Embedded> Embed(Executor& target_executor) {
     if (type() != SequenceValueType::VALUE_PROTO) {
       return absl::InvalidArgumentError(
@@ -238,7 +344,30 @@ class Sequence {
   }
 
   absl::StatusOr<std::unique_ptr<SequenceIterator>> CreateIterator() {
-    if (type() == SequenceValueType::VALUE_PROTO) {
+    std::unique_ptr<SequenceIterator> iterator = TFF_TRY(CreateBaseIterator());
+    if (prefetch_depth_ > 0) {
+      return std::make_unique<PrefetchingIterator>(std::move(iterator),
+                                                   prefetch_depth_);
+    }
+    return iterator;
+  }
+
+ private:
+  absl::StatusOr<std::unique_ptr<SequenceIterator>> CreateBaseIterator() {
+    if (type() == SequenceValueType::VALUE_PROTO &&
+        proto().sequence().has_columns()) {
+      std::shared_ptr<const std::vector<tensorflow::Tensor>> columns;
+      {
+        absl::MutexLock lock(&dataset_mutex_);
+        if (columns_ == nullptr) {
+          columns_ = std::make_shared<const std::vector<tensorflow::Tensor>>(
+              TFF_TRY(SequenceValueToColumns(proto().sequence())));
+        }
+        columns = columns_;
+      }
+      return std::make_unique<ColumnsIterator>(std::move(columns),
+                                               TFF_TRY(ElementPlan()));
+    } else if (type() == SequenceValueType::VALUE_PROTO) {
       bool ds_is_set = false;
       {
         absl::ReaderMutexLock reader_lock(&dataset_mutex_);
@@ -262,14 +391,24 @@ class Sequence {
                          "executor. Message: ",
                          iter_status.message()));
       }
-      return std::make_unique<DatasetIterator>(
-          std::move(iter), proto().sequence().element_type());
+      return std::make_unique<DatasetIterator>(std::move(iter),
+                                               TFF_TRY(ElementPlan()));
     } else {
       return iterator_factory()();
     }
   }
 
- private:
+  // Returns the traversal plan of the element type of a sequence proto,
+  // computed once and shared by all iterators over the sequence.
+  absl::StatusOr<std::shared_ptr<const TensorTraversalPlan>> ElementPlan() {
+    absl::MutexLock lock(&dataset_mutex_);
+    if (element_plan_ == nullptr) {
+      element_plan_ = std::make_shared<const TensorTraversalPlan>(TFF_TRY(
+          TensorTraversalPlanFromType(proto().sequence().element_type())));
+    }
+    return element_plan_;
+  }
+
   inline IteratorFactory iterator_factory() {
     return std::get<IteratorFactory>(value_);
   }
@@ -277,10 +416,17 @@ class Sequence {
   absl::Mutex dataset_mutex_;
   std::optional<std::unique_ptr<tensorflow::data::standalone::Dataset>> ds_
       ABSL_GUARDED_BY(dataset_mutex_) = std::nullopt;
+  // The deserialized columns of a columnar sequence proto.
+  std::shared_ptr<const std::vector<tensorflow::Tensor>> columns_
+      ABSL_GUARDED_BY(dataset_mutex_);
+  std::shared_ptr<const TensorTraversalPlan> element_plan_
+      ABSL_GUARDED_BY(dataset_mutex_);
   std::shared_ptr<Executor> executor_;
   absl::Mutex embedded_mutex_;
   std::optional<Embedded> embedded_sequence_ ABSL_GUARDED_BY(embedded_mutex_) =
       std::nullopt;
+  const int32_t prefetch_depth_;
+  const std::optional<SequenceMapping> mapping_;
 };
 
 class SequenceExecutorValue;
@@ -382,8 +528,12 @@ using ValueFuture = std::shared_future<absl::StatusOr<SequenceExecutorValue>>;
 
 class SequenceExecutor : public ExecutorBase<ValueFuture> {
  public:
-  explicit SequenceExecutor(std::shared_ptr<Executor> target_executor)
-      : target_executor_(target_executor) {}
+  explicit SequenceExecutor(std::shared_ptr<Executor> target_executor,
+                            int32_t parallel_reduce_batch_size,
+                            int32_t prefetch_depth)
+      : target_executor_(target_executor),
+        parallel_reduce_batch_size_(parallel_reduce_batch_size),
+        prefetch_depth_(prefetch_depth) {}
   ~SequenceExecutor() override = default;
 
   std::string_view ExecutorName() final { return "SequenceExecutor"; }
@@ -397,7 +547,8 @@ class SequenceExecutor : public ExecutorBase<ValueFuture> {
         // response to a CreateCall, or construction of an iterable from this
         // sequence in the sequence executor itself.
         return ReadyFuture(SequenceExecutorValue::CreateSequence(
-            std::make_shared<Sequence>(value_pb, target_executor_)));
+            std::make_shared<Sequence>(value_pb, target_executor_,
+                                       prefetch_depth_)));
       }
       case v0::Value::kComputation: {
         if (value_pb.computation().has_intrinsic()) {
@@ -534,7 +685,40 @@ class SequenceExecutor : public ExecutorBase<ValueFuture> {
     }
   }
 
+  // Transfers values embedded in the target executor, and structures of them,
+  // between the target executors. Sequences are transferred lazily as protos,
+  // so that they remain sequences of `target`.
+  absl::StatusOr<std::optional<ValueFuture>> TransferExecutorValue(
+      ValueFuture value, ExecutorBase<ValueFuture>& target) final {
+    SequenceExecutorValue exec_value = TFF_TRY(Wait(value));
+    if (!IsEmbeddedOrStructOfEmbedded(exec_value)) {
+      return std::nullopt;
+    }
+    auto& target_executor = static_cast<SequenceExecutor&>(target);
+    Embedded embedded_value = TFF_TRY(Embed(exec_value));
+    return ReadyFuture(SequenceExecutorValue::CreateEmbedded(
+        ShareValueId(TFF_TRY(target_executor_->TransferTo(
+            *target_executor.target_executor_, embedded_value->ref())))));
+  }
+
  private:
+  static bool IsEmbeddedOrStructOfEmbedded(const SequenceExecutorValue& val) {
+    switch (val.type()) {
+      case SequenceExecutorValue::ValueType::EMBEDDED:
+        return true;
+      case SequenceExecutorValue::ValueType::STRUCT: {
+        for (const SequenceExecutorValue& elem : *val.struct_value()) {
+          if (!IsEmbeddedOrStructOfEmbedded(elem)) {
+            return false;
+          }
+        }
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
   absl::StatusOr<Embedded> Embed(SequenceExecutorValue val) {
     switch (val.type()) {
       case SequenceExecutorValue::ValueType::EMBEDDED:
@@ -583,14 +767,35 @@ class SequenceExecutor : public ExecutorBase<ValueFuture> {
     Embedded initial_value = zero_value.embedded();
     Embedded reduce_fn = fn_value.embedded();
 
+    if (parallel_reduce_batch_size_ > 0) {
+      std::unique_ptr<SequenceIterator> iterator =
+          TFF_TRY(sequence->CreateIterator());
+      return ParallelReduce(*iterator, std::move(initial_value), *reduce_fn);
+    }
+    // Fuse the mapping functions of a reduced `sequence_map` result into the
+    // reduction loop, rather than iterating through a chain of
+    // `MappedIterator`s which wrap every mapped element in a shared value.
+    std::vector<Embedded> mapping_fns;
+    while (sequence->mapping().has_value()) {
+      mapping_fns.push_back(sequence->mapping()->mapping_fn);
+      sequence = sequence->mapping()->source;
+    }
+    std::reverse(mapping_fns.begin(), mapping_fns.end());
     std::unique_ptr<SequenceIterator> iterator =
         TFF_TRY(sequence->CreateIterator());
     OwnedValueId accumulator = std::move(*initial_value);
     std::optional<Embedded> embedded_value =
         TFF_TRY(iterator->GetNextEmbedded(*target_executor_));
     while (embedded_value.has_value()) {
-      OwnedValueId arg_struct = TFF_TRY(target_executor_->CreateStruct(
-          {accumulator.ref(), embedded_value.value()->ref()}));
+      ValueId element = embedded_value.value()->ref();
+      std::optional<OwnedValueId> mapped_element;
+      for (const Embedded& mapping_fn : mapping_fns) {
+        mapped_element =
+            TFF_TRY(target_executor_->CreateCall(mapping_fn->ref(), element));
+        element = mapped_element->ref();
+      }
+      OwnedValueId arg_struct = TFF_TRY(
+          target_executor_->CreateStruct({accumulator.ref(), element}));
       accumulator =
           TFF_TRY(target_executor_->CreateCall(reduce_fn->ref(), arg_struct));
       embedded_value = TFF_TRY(iterator->GetNextEmbedded(*target_executor_));
@@ -598,6 +803,69 @@ class SequenceExecutor : public ExecutorBase<ValueFuture> {
     return ShareValueId(std::move(accumulator));
   }
 
+  // Reduces batches of `parallel_reduce_batch_size_` consecutive elements of
+  // `iterator`, each starting from `zero`. The target executor runs the calls
+  // of different batches concurrently, since they do not depend on each other.
+  // The partial results are then combined in order with `reduce_fn`.
+  absl::StatusOr<Embedded> ParallelReduce(SequenceIterator& iterator,
+                                          Embedded zero,
+                                          const OwnedValueId& reduce_fn) {
+    // Partial results of consecutive ranges of the sequence, with the number
+    // of batches in each range. Neighbouring ranges of the same number of
+    // batches are combined as soon as possible, so that the combinations form
+    // a balanced tree and at most a logarithmic number of partial results are
+    // alive.
+    std::vector<std::pair<Embedded, int64_t>> partial_results;
+    bool end_of_sequence = false;
+    while (!end_of_sequence) {
+      Embedded partial_result = zero;
+      int32_t num_elements = 0;
+      for (; num_elements < parallel_reduce_batch_size_; ++num_elements) {
+        std::optional<Embedded> element =
+            TFF_TRY(iterator.GetNextEmbedded(*target_executor_));
+        if (!element.has_value()) {
+          end_of_sequence = true;
+          break;
+        }
+        partial_result =
+            TFF_TRY(CallReduceFn(reduce_fn, *partial_result, **element));
+      }
+      if (num_elements == 0) {
+        break;
+      }
+      partial_results.emplace_back(std::move(partial_result), 1);
+      while (partial_results.size() >= 2 &&
+             partial_results[partial_results.size() - 2].second ==
+                 partial_results.back().second) {
+        std::pair<Embedded, int64_t> right = std::move(partial_results.back());
+        partial_results.pop_back();
+        std::pair<Embedded, int64_t>& left = partial_results.back();
+        left.first =
+            TFF_TRY(CallReduceFn(reduce_fn, *left.first, *right.first));
+        left.second += right.second;
+      }
+    }
+    if (partial_results.empty()) {
+      return zero;
+    }
+    Embedded result = partial_results.front().first;
+    for (size_t i = 1; i < partial_results.size(); ++i) {
+      result = TFF_TRY(
+          CallReduceFn(reduce_fn, *result, *partial_results[i].first));
+    }
+    return result;
+  }
+
+  // Returns the result of calling `reduce_fn` on `<accumulator, value>`.
+  absl::StatusOr<Embedded> CallReduceFn(const OwnedValueId& reduce_fn,
+                                        const OwnedValueId& accumulator,
+                                        const OwnedValueId& value) {
+    OwnedValueId arg_struct = TFF_TRY(
+        target_executor_->CreateStruct({accumulator.ref(), value.ref()}));
+    return ShareValueId(
+        TFF_TRY(target_executor_->CreateCall(reduce_fn.ref(), arg_struct)));
+  }
+
   absl::StatusOr<std::shared_ptr<Sequence>> MapSequence(
       SequenceExecutorValue arg) {
     TFF_TRY(CheckLenForUseAsArgument(arg, kSequenceMapUri, 2));
@@ -619,16 +887,24 @@ class SequenceExecutor : public ExecutorBase<ValueFuture> {
       return std::make_unique<MappedIterator>(std::move(iter), embedded_fn);
     };
 
-    return std::make_shared<Sequence>(std::move(iterator_fn), target_executor_);
+    SequenceMapping mapping;
+    mapping.source = sequence_value.sequence_value();
+    mapping.mapping_fn = fn_value.embedded();
+    return std::make_shared<Sequence>(std::move(iterator_fn), target_executor_,
+                                      prefetch_depth_, std::move(mapping));
   }
   std::shared_ptr<Executor> target_executor_;
+  const int32_t parallel_reduce_batch_size_;
+  const int32_t prefetch_depth_;
 };
 
 }  // namespace
 
 std::shared_ptr<Executor> CreateSequenceExecutor(
-    std::shared_ptr<Executor> target_executor) {
-  return std::make_unique<SequenceExecutor>(target_executor);
+    std::shared_ptr<Executor> target_executor,
+    int32_t parallel_reduce_batch_size, int32_t prefetch_depth) {
+  return std::make_unique<SequenceExecutor>(
+      target_executor, parallel_reduce_batch_size, prefetch_depth);
 }
 
 }  // namespace tensorflow_federated
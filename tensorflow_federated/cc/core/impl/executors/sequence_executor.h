@@ -16,6 +16,7 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_SEQUENCE_EXECUTOR_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_SEQUENCE_EXECUTOR_H_
 
+#include <cstdint>
 #include <memory>
 
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
@@ -23,8 +24,20 @@ limitations under the License
 namespace tensorflow_federated {
 
 // Returns an executor that can execute TFF's Sequence* intrinsics.
+//
+// If `parallel_reduce_batch_size` is positive, `sequence_reduce` reduces
+// batches of that many consecutive elements concurrently, each starting from
+// the zero of the reduction, and then combines the partial results with the
+// reduction function itself. This is only correct if all reductions run by
+// the executor are associative, have a zero which is an identity, and have an
+// accumulator of the same type as the elements, e.g. sums of the elements.
+//
+// If `prefetch_depth` is positive, iterating a sequence fetches and embeds up
+// to that many of its elements on a background thread ahead of their use. The
+// results of `sequence_map` prefetch their mapped elements the same way.
 std::shared_ptr<Executor> CreateSequenceExecutor(
-    std::shared_ptr<Executor> target_executor);
+    std::shared_ptr<Executor> target_executor,
+    int32_t parallel_reduce_batch_size = 0, int32_t prefetch_depth = 0);
 
 }  // namespace tensorflow_federated
 
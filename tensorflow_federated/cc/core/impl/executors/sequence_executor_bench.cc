@@ -0,0 +1,71 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/noop_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/sequence_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/sequence_intrinsics.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::tensorflow_federated::testing::IntrinsicV;
+using ::tensorflow_federated::testing::SequenceV;
+using ::tensorflow_federated::testing::TensorV;
+
+// Benchmarks `sequence_reduce` over a sequence of `state.range(0)` elements,
+// reducing batches of `state.range(1)` elements concurrently if positive. The
+// reduction calls return immediately, so that the iteration of the sequence
+// and the embedding of its elements dominate.
+static void BM_SequenceReduce(benchmark::State& state) {
+  const int64_t num_elements = state.range(0);
+  std::shared_ptr<Executor> executor = CreateSequenceExecutor(
+      std::make_shared<NoOpExecutor>(),
+      /*parallel_reduce_batch_size=*/state.range(1));
+  OwnedValueId reduce_id =
+      executor->CreateValue(IntrinsicV(kSequenceReduceUri)).value();
+  OwnedValueId sequence_id =
+      executor->CreateValue(SequenceV(0, num_elements, 1)).value();
+  OwnedValueId zero_id =
+      executor->CreateValue(TensorV(static_cast<int64_t>(0))).value();
+  OwnedValueId fn_id =
+      executor->CreateValue(IntrinsicV("some_passthru_intrinsic")).value();
+  OwnedValueId arg_id =
+      executor->CreateStruct({sequence_id, zero_id, fn_id}).value();
+  for (auto s : state) {
+    absl::StatusOr<OwnedValueId> result =
+        executor->CreateCall(reduce_id, arg_id);
+    CHECK(result.ok()) << result.status();
+    absl::StatusOr<v0::Value> result_pb = executor->Materialize(*result);
+    CHECK(result_pb.ok()) << result_pb.status();
+  }
+  state.SetItemsProcessed(state.iterations() * num_elements);
+}
+
+BENCHMARK(BM_SequenceReduce)
+    ->ArgNames({"elements", "batch"})
+    ->ArgsProduct({{10, 1000, 100000}, {0, 64}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace tensorflow_federated
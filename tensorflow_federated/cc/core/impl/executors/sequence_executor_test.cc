@@ -19,11 +19,14 @@ limitations under the License
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
 #include "absl/status/status.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/tstring.h"
+#include "tensorflow_federated/cc/core/impl/executors/dataset_conversions.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor_test_base.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_executor.h"
@@ -487,6 +490,122 @@ TEST_F(SequenceExecutorTest, CreateCreateCallTensorSequenceReduce) {
   ExpectMaterialize(call_id, expected_sum_result);
 }
 
+TEST_F(SequenceExecutorTest, CreateCallColumnarSequenceReduce) {
+  int dataset_len = 10;
+  v0::Value expected_sum_result = TensorV(45l);
+  std::vector<std::vector<tensorflow::Tensor>> elements;
+  for (int64_t i = 1; i < dataset_len; i++) {
+    elements.push_back({tensorflow::Tensor(i)});
+  }
+  v0::Value sequence_value_pb;
+  TFF_ASSERT_OK(TensorStructuresToColumnarSequence(
+      elements, sequence_value_pb.mutable_sequence()));
+  *sequence_value_pb.mutable_sequence()->mutable_element_type() =
+      MakeInt64ScalarType();
+  v0::Value zero = TensorV(static_cast<int64_t>(0));
+  v0::Value reduce_fn = IntrinsicV("some_passthru_intrinsic");
+
+  // The elements are sliced from the columns in the sequence executor, and
+  // embedded one at a time as for a serialized dataset.
+  auto embedded_accumulator_id = mock_executor_->ExpectCreateValue(zero);
+  auto embedded_reduce_fn_id = mock_executor_->ExpectCreateValue(reduce_fn);
+  for (int i = 1; i < dataset_len; i++) {
+    auto embedded_dataset_element =
+        mock_executor_->ExpectCreateValue(TensorV(static_cast<int64_t>(i)));
+    auto embedded_arg_struct = mock_executor_->ExpectCreateStruct(
+        {embedded_accumulator_id, embedded_dataset_element});
+    embedded_accumulator_id = mock_executor_->ExpectCreateCall(
+        embedded_reduce_fn_id, embedded_arg_struct);
+  }
+  mock_executor_->ExpectMaterialize(embedded_accumulator_id,
+                                    expected_sum_result);
+
+  auto sequence_reduce_id = TFF_ASSERT_OK(
+      test_executor_->CreateValue(IntrinsicV(kSequenceReduceUri)));
+  auto sequence_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(sequence_value_pb));
+  auto fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(reduce_fn));
+  auto zero_id = TFF_ASSERT_OK(test_executor_->CreateValue(zero));
+  auto struct_id = TFF_ASSERT_OK(
+      test_executor_->CreateStruct({sequence_id, zero_id, fn_id}));
+  auto call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(sequence_reduce_id, struct_id));
+  ExpectMaterialize(call_id, expected_sum_result);
+}
+
+TEST_F(SequenceExecutorTest, CreateCallTensorSequenceReduceInParallel) {
+  test_executor_ =
+      CreateSequenceExecutor(mock_executor_, /*parallel_reduce_batch_size=*/4);
+  int dataset_len = 10;
+  v0::Value expected_sum_result = TensorV(45l);
+  v0::Value sequence_value_pb = SequenceV(1, dataset_len, 1);
+  v0::Value zero = TensorV(static_cast<int64_t>(0));
+  v0::Value reduce_fn = IntrinsicV("some_passthru_intrinsic");
+
+  auto embedded_zero_id = mock_executor_->ExpectCreateValue(zero);
+  auto embedded_reduce_fn_id = mock_executor_->ExpectCreateValue(reduce_fn);
+  auto expect_reduce = [&](ValueId accumulator_id, ValueId value_id) {
+    auto embedded_arg_struct =
+        mock_executor_->ExpectCreateStruct({accumulator_id, value_id});
+    return mock_executor_->ExpectCreateCall(embedded_reduce_fn_id,
+                                            embedded_arg_struct);
+  };
+  // The nine elements are reduced in batches of four, four and one elements,
+  // each starting from zero.
+  std::vector<ValueId> partial_result_ids;
+  for (int i = 1; i < dataset_len; i++) {
+    if ((i - 1) % 4 == 0) {
+      partial_result_ids.push_back(embedded_zero_id);
+    }
+    auto embedded_dataset_element =
+        mock_executor_->ExpectCreateValue(TensorV(static_cast<int64_t>(i)));
+    partial_result_ids.back() =
+        expect_reduce(partial_result_ids.back(), embedded_dataset_element);
+  }
+  // The first two batches are combined as soon as the second one completes,
+  // and the third one is combined with them at the end of the sequence.
+  auto first_two_batches_id =
+      expect_reduce(partial_result_ids[0], partial_result_ids[1]);
+  auto result_id = expect_reduce(first_two_batches_id, partial_result_ids[2]);
+  mock_executor_->ExpectMaterialize(result_id, expected_sum_result);
+
+  auto sequence_reduce_id = TFF_ASSERT_OK(
+      test_executor_->CreateValue(IntrinsicV(kSequenceReduceUri)));
+  auto sequence_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(sequence_value_pb));
+  auto fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(reduce_fn));
+  auto zero_id = TFF_ASSERT_OK(test_executor_->CreateValue(zero));
+  auto struct_id = TFF_ASSERT_OK(
+      test_executor_->CreateStruct({sequence_id, zero_id, fn_id}));
+  auto call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(sequence_reduce_id, struct_id));
+  ExpectMaterialize(call_id, expected_sum_result);
+}
+
+TEST_F(SequenceExecutorTest, CreateCallEmptySequenceReduceInParallel) {
+  test_executor_ =
+      CreateSequenceExecutor(mock_executor_, /*parallel_reduce_batch_size=*/4);
+  v0::Value sequence_value_pb = SequenceV(0, 0, 1);
+  v0::Value zero = TensorV(static_cast<int64_t>(0));
+  v0::Value reduce_fn = IntrinsicV("some_passthru_intrinsic");
+
+  auto embedded_zero_id = mock_executor_->ExpectCreateValue(zero);
+  mock_executor_->ExpectCreateValue(reduce_fn);
+  mock_executor_->ExpectMaterialize(embedded_zero_id, zero);
+
+  auto sequence_reduce_id = TFF_ASSERT_OK(
+      test_executor_->CreateValue(IntrinsicV(kSequenceReduceUri)));
+  auto sequence_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(sequence_value_pb));
+  auto fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(reduce_fn));
+  auto zero_id = TFF_ASSERT_OK(test_executor_->CreateValue(zero));
+  auto struct_id = TFF_ASSERT_OK(
+      test_executor_->CreateStruct({sequence_id, zero_id, fn_id}));
+  auto call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(sequence_reduce_id, struct_id));
+  ExpectMaterialize(call_id, zero);
+}
+
 TEST_F(SequenceExecutorTest, EmbedMappedSequenceFails) {
   int dataset_len = 10;
   v0::Value sequence_value_pb = SequenceV(1, dataset_len, 1);
@@ -560,5 +679,149 @@ TEST_F(SequenceExecutorTest, CreateCreateCallTensorSequenceMapThenReduce) {
   ExpectMaterialize(reduce_call_id, expected_sum_result);
 }
 
+TEST_F(SequenceExecutorTest, CreateCreateCallTensorSequenceMapMapThenReduce) {
+  int dataset_len = 10;
+  v0::Value sequence_value_pb = SequenceV(1, dataset_len, 1);
+  v0::Value first_mapping_fn = IntrinsicV("some_first_mapping_fn");
+  v0::Value second_mapping_fn = IntrinsicV("some_second_mapping_fn");
+  v0::Value expected_sum_result = TensorV(45l);
+  v0::Value zero = TensorV(static_cast<int64_t>(0));
+  v0::Value reduce_fn = IntrinsicV("some_passthru_reduce_fn");
+
+  auto embedded_first_mapping_fn_id =
+      mock_executor_->ExpectCreateValue(first_mapping_fn);
+  auto embedded_second_mapping_fn_id =
+      mock_executor_->ExpectCreateValue(second_mapping_fn);
+  auto embedded_accumulator_id = mock_executor_->ExpectCreateValue(zero);
+  auto embedded_reduce_fn_id = mock_executor_->ExpectCreateValue(reduce_fn);
+  // The mapping functions are applied in order to each element, right before
+  // it is reduced.
+  for (int i = 1; i < dataset_len; i++) {
+    auto embedded_dataset_element =
+        mock_executor_->ExpectCreateValue(TensorV(static_cast<int64_t>(i)));
+    auto embedded_first_mapped = mock_executor_->ExpectCreateCall(
+        embedded_first_mapping_fn_id, embedded_dataset_element);
+    auto embedded_second_mapped = mock_executor_->ExpectCreateCall(
+        embedded_second_mapping_fn_id, embedded_first_mapped);
+    auto embedded_reduce_arg_struct = mock_executor_->ExpectCreateStruct(
+        {embedded_accumulator_id, embedded_second_mapped});
+    embedded_accumulator_id = mock_executor_->ExpectCreateCall(
+        embedded_reduce_fn_id, embedded_reduce_arg_struct);
+  }
+  mock_executor_->ExpectMaterialize(embedded_accumulator_id,
+                                    expected_sum_result);
+
+  auto sequence_map_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(IntrinsicV(kSequenceMapUri)));
+  auto sequence_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(sequence_value_pb));
+  auto first_mapping_fn_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(first_mapping_fn));
+  auto first_map_struct_id = TFF_ASSERT_OK(
+      test_executor_->CreateStruct({first_mapping_fn_id, sequence_id}));
+  auto first_map_call_id = TFF_ASSERT_OK(
+      test_executor_->CreateCall(sequence_map_id, first_map_struct_id));
+  auto second_mapping_fn_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(second_mapping_fn));
+  auto second_map_struct_id = TFF_ASSERT_OK(test_executor_->CreateStruct(
+      {second_mapping_fn_id, first_map_call_id}));
+  auto second_map_call_id = TFF_ASSERT_OK(
+      test_executor_->CreateCall(sequence_map_id, second_map_struct_id));
+  auto sequence_reduce_id = TFF_ASSERT_OK(
+      test_executor_->CreateValue(IntrinsicV(kSequenceReduceUri)));
+  auto reduce_fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(reduce_fn));
+  auto zero_id = TFF_ASSERT_OK(test_executor_->CreateValue(zero));
+  auto reduce_struct_id = TFF_ASSERT_OK(test_executor_->CreateStruct(
+      {second_map_call_id, zero_id, reduce_fn_id}));
+  auto reduce_call_id = TFF_ASSERT_OK(
+      test_executor_->CreateCall(sequence_reduce_id, reduce_struct_id));
+  ExpectMaterialize(reduce_call_id, expected_sum_result);
+}
+
+TEST_F(SequenceExecutorTest, CreateCallTensorSequenceReduceWithPrefetching) {
+  test_executor_ =
+      CreateSequenceExecutor(mock_executor_, /*parallel_reduce_batch_size=*/0,
+                             /*prefetch_depth=*/2);
+  int dataset_len = 10;
+  v0::Value expected_sum_result = TensorV(45l);
+  v0::Value sequence_value_pb = SequenceV(1, dataset_len, 1);
+  v0::Value zero = TensorV(static_cast<int64_t>(0));
+  v0::Value reduce_fn = IntrinsicV("some_passthru_intrinsic");
+
+  auto embedded_accumulator_id = mock_executor_->ExpectCreateValue(zero);
+  auto embedded_reduce_fn_id = mock_executor_->ExpectCreateValue(reduce_fn);
+
+  for (int i = 1; i < dataset_len; i++) {
+    auto embedded_dataset_element =
+        mock_executor_->ExpectCreateValue(TensorV(static_cast<int64_t>(i)));
+    auto embedded_arg_struct = mock_executor_->ExpectCreateStruct(
+        {embedded_accumulator_id, embedded_dataset_element});
+    embedded_accumulator_id = mock_executor_->ExpectCreateCall(
+        embedded_reduce_fn_id, embedded_arg_struct);
+  }
+  mock_executor_->ExpectMaterialize(embedded_accumulator_id,
+                                    expected_sum_result);
+
+  auto sequence_reduce_id = TFF_ASSERT_OK(
+      test_executor_->CreateValue(IntrinsicV(kSequenceReduceUri)));
+  auto sequence_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(sequence_value_pb));
+  auto fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(reduce_fn));
+  auto zero_id = TFF_ASSERT_OK(test_executor_->CreateValue(zero));
+  auto struct_id = TFF_ASSERT_OK(
+      test_executor_->CreateStruct({sequence_id, zero_id, fn_id}));
+  auto call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(sequence_reduce_id, struct_id));
+  ExpectMaterialize(call_id, expected_sum_result);
+}
+
+TEST_F(SequenceExecutorTest,
+       CreateCallTensorSequenceMapThenReduceWithPrefetching) {
+  test_executor_ =
+      CreateSequenceExecutor(mock_executor_, /*parallel_reduce_batch_size=*/0,
+                             /*prefetch_depth=*/2);
+  int dataset_len = 10;
+  v0::Value sequence_value_pb = SequenceV(1, dataset_len, 1);
+  v0::Value mapping_fn = IntrinsicV("some_passthru_mapping_fn");
+  v0::Value expected_sum_result = TensorV(45l);
+  v0::Value zero = TensorV(static_cast<int64_t>(0));
+  v0::Value reduce_fn = IntrinsicV("some_passthru_reduce_fn");
+
+  auto embedded_mapping_fn_id = mock_executor_->ExpectCreateValue(mapping_fn);
+  auto embedded_accumulator_id = mock_executor_->ExpectCreateValue(zero);
+  auto embedded_reduce_fn_id = mock_executor_->ExpectCreateValue(reduce_fn);
+  for (int i = 1; i < dataset_len; i++) {
+    auto embedded_dataset_element =
+        mock_executor_->ExpectCreateValue(TensorV(static_cast<int64_t>(i)));
+    auto embedded_mapped_fn = mock_executor_->ExpectCreateCall(
+        embedded_mapping_fn_id, embedded_dataset_element);
+    auto embedded_reduce_arg_struct = mock_executor_->ExpectCreateStruct(
+        {embedded_accumulator_id, embedded_mapped_fn});
+    embedded_accumulator_id = mock_executor_->ExpectCreateCall(
+        embedded_reduce_fn_id, embedded_reduce_arg_struct);
+  }
+  mock_executor_->ExpectMaterialize(embedded_accumulator_id,
+                                    expected_sum_result);
+
+  auto sequence_map_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(IntrinsicV(kSequenceMapUri)));
+  auto sequence_id =
+      TFF_ASSERT_OK(test_executor_->CreateValue(sequence_value_pb));
+  auto mapping_fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(mapping_fn));
+  auto map_struct_id =
+      TFF_ASSERT_OK(test_executor_->CreateStruct({mapping_fn_id, sequence_id}));
+  auto map_call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(sequence_map_id, map_struct_id));
+  auto sequence_reduce_id = TFF_ASSERT_OK(
+      test_executor_->CreateValue(IntrinsicV(kSequenceReduceUri)));
+  auto reduce_fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(reduce_fn));
+  auto zero_id = TFF_ASSERT_OK(test_executor_->CreateValue(zero));
+  auto reduce_struct_id = TFF_ASSERT_OK(
+      test_executor_->CreateStruct({map_call_id, zero_id, reduce_fn_id}));
+  auto reduce_call_id = TFF_ASSERT_OK(
+      test_executor_->CreateCall(sequence_reduce_id, reduce_struct_id));
+  ExpectMaterialize(reduce_call_id, expected_sum_result);
+}
+
 }  // namespace
 }  // namespace tensorflow_federated
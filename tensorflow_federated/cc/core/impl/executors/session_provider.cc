@@ -20,6 +20,7 @@ limitations under the License
 #include <memory>
 #include <string>
 #include <string_view>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -28,6 +29,7 @@ limitations under the License
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
@@ -40,12 +42,56 @@ limitations under the License
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/protobuf/config.pb.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/public/session_options.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 
 namespace tensorflow_federated {
 
+absl::Status SessionProvider::SessionWithResourceContainer::RunCallable(
+    const std::vector<std::pair<std::string, tensorflow::Tensor>>& inputs,
+    const std::vector<std::string>& output_tensor_names,
+    const std::vector<std::string>& target_tensor_names,
+    std::vector<tensorflow::Tensor>* outputs) {
+  // Tensor and op names never contain ',' nor ';'.
+  std::string signature;
+  for (const auto& [name, tensor] : inputs) {
+    absl::StrAppend(&signature, name, ",");
+  }
+  absl::StrAppend(&signature, ";", absl::StrJoin(output_tensor_names, ","),
+                  ";", absl::StrJoin(target_tensor_names, ","));
+  auto callable = callables_.find(signature);
+  if (callable == callables_.end()) {
+    if (callables_.size() >= kMaxCallables) {
+      return session_->Run(inputs, output_tensor_names, target_tensor_names,
+                           outputs);
+    }
+    tensorflow::CallableOptions callable_options;
+    for (const auto& [name, tensor] : inputs) {
+      callable_options.add_feed(name);
+    }
+    for (const std::string& name : output_tensor_names) {
+      callable_options.add_fetch(name);
+    }
+    for (const std::string& name : target_tensor_names) {
+      callable_options.add_target(name);
+    }
+    tensorflow::Session::CallableHandle handle;
+    TFF_TRY(session_->MakeCallable(callable_options, &handle));
+    callable = callables_.emplace(std::move(signature), handle).first;
+  }
+  std::vector<tensorflow::Tensor> feed_tensors;
+  feed_tensors.reserve(inputs.size());
+  for (const auto& [name, tensor] : inputs) {
+    feed_tensors.push_back(tensor);
+  }
+  std::vector<tensorflow::Tensor> unused_outputs;
+  return session_->RunCallable(callable->second, feed_tensors,
+                               outputs != nullptr ? outputs : &unused_outputs,
+                               /*run_metadata=*/nullptr);
+}
+
 // A process level counter for SessionProvider creation. This ensures
 // each session provider is creating unique containers for each session
 // created in the process. This is necessary because the TesnorFlow
@@ -87,6 +133,31 @@ const tensorflow::SessionOptions& get_session_options() {
   return *session_options;
 }
 
+// Returns the default session options, with the shared inter-op pool and the
+// intra-op pool size of `options` if it shares thread pools.
+tensorflow::SessionOptions GetSessionOptions(
+    const SessionPoolOptions& options) {
+  tensorflow::SessionOptions options_pb = get_session_options();
+  if (!options.share_thread_pools) {
+    return options_pb;
+  }
+  const int32_t num_cores = std::thread::hardware_concurrency();
+  const int32_t inter_op_threads =
+      options.inter_op_threads > 0 ? options.inter_op_threads : num_cores;
+  const int32_t intra_op_threads =
+      options.intra_op_threads > 0 ? options.intra_op_threads : num_cores;
+  // A pool with a global name is created once per process, and shared by all
+  // sessions naming it.
+  tensorflow::ThreadPoolOptionProto* pool_pb =
+      options_pb.config.add_session_inter_op_thread_pool();
+  pool_pb->set_num_threads(inter_op_threads);
+  pool_pb->set_global_name(
+      absl::StrCat("tff_shared_inter_op_", inter_op_threads));
+  options_pb.config.set_use_per_session_threads(false);
+  options_pb.config.set_intra_op_parallelism_threads(intra_op_threads);
+  return options_pb;
+}
+
 struct AcceleratorDevices {
   const int16_t num_gpus = 0;
   const int16_t num_tpus = 0;
@@ -226,8 +297,9 @@ tensorflow::GraphDef ReplaceContainers(
   return graph;
 }
 
-SessionProvider::SessionProvider(tensorflow::GraphDef&& graph)
-    : graph_(graph), function_id_(GetNextFunctionId()) {}
+SessionProvider::SessionProvider(tensorflow::GraphDef&& graph,
+                                 SessionPoolOptions options)
+    : graph_(graph), function_id_(GetNextFunctionId()), options_(options) {}
 
 absl::StatusOr<std::unique_ptr<tensorflow::Session>>
 SessionProvider::CreateSession(const int16_t session_id) {
@@ -236,7 +308,7 @@ SessionProvider::CreateSession(const int16_t session_id) {
   {
     tensorflow::Session* raw_session;
     absl::Status status =
-        tensorflow::NewSession(get_session_options(), &raw_session);
+        tensorflow::NewSession(GetSessionOptions(options_), &raw_session);
     if (!status.ok()) {
       return absl::InternalError(absl::StrCat(
           "Failed to create TensorFlow session: ", status.message()));
@@ -252,10 +324,17 @@ SessionProvider::CreateSession(const int16_t session_id) {
         "TPUs.");
   }
 
+  // Returns the device of the session among `num_devices` of a kind.
+  auto device_id_of = [&](int16_t num_devices) -> int16_t {
+    if (options_.device_index >= 0) {
+      return options_.device_index % num_devices;
+    }
+    return session_id % num_devices;
+  };
   if (devices.num_gpus > 0) {
-    // If we have GPUs, round robin the session by explicitly setting the
+    // If we have GPUs, pin the session to one of them by explicitly setting the
     // `device` attr of the GPU-capable kernels.
-    const int16_t device_id = session_id % devices.num_gpus;
+    const int16_t device_id = device_id_of(devices.num_gpus);
     const std::string& device =
         absl::StrCat("/device:", tensorflow::DEVICE_GPU, ":", device_id);
     VLOG(2) << "Pinning function [" << function_id_ << "] session ["
@@ -263,9 +342,9 @@ SessionProvider::CreateSession(const int16_t session_id) {
     SetDevice(device, &graph_def, tensorflow::DEVICE_GPU);
   }
   if (devices.num_tpus > 0) {
-    // If we have TPUs, round robin the session by explicitly setting the
+    // If we have TPUs, pin the session to one of them by explicitly setting the
     // `device` attr of the TPU-capable kernels.
-    const int16_t device_id = session_id % devices.num_tpus;
+    const int16_t device_id = device_id_of(devices.num_tpus);
     const std::string& device =
         absl::StrCat("/device:", tensorflow::DEVICE_TPU, ":", device_id);
     VLOG(2) << "Pinning function [" << function_id_ << "] session ["
@@ -285,11 +364,18 @@ SessionProvider::CreateSession(const int16_t session_id) {
   return std::move(session);
 }
 
+bool SessionProvider::CanTakeSession() const {
+  return !sessions_.empty() || options_.max_sessions <= 0 ||
+         num_sessions_ < options_.max_sessions;
+}
+
 absl::StatusOr<SessionProvider::SessionWithResourceContainer>
 SessionProvider::TakeSession() {
   int16_t session_id = 0;
   {
     absl::MutexLock lock(&mutex_);
+    // Block until a session is returned, if no more sessions may be created.
+    mutex_.Await(absl::Condition(this, &SessionProvider::CanTakeSession));
     if (!sessions_.empty()) {
       SessionProvider::SessionWithResourceContainer session(
           std::move(sessions_.back()));
@@ -299,11 +385,42 @@ SessionProvider::TakeSession() {
     // Build a container name based on the number of sessions created so that
     // each session gets its own container.
     session_id = session_creation_counter_++;
+    ++num_sessions_;
+  }
+  absl::StatusOr<std::unique_ptr<tensorflow::Session>> session =
+      CreateSession(session_id);
+  if (!session.ok()) {
+    absl::MutexLock lock(&mutex_);
+    --num_sessions_;
+    return session.status();
   }
-  std::unique_ptr<tensorflow::Session> session =
-      TFF_TRY(CreateSession(session_id));
   return SessionProvider::SessionWithResourceContainer{
-      std::move(session), function_id_, session_id};
+      std::move(session).value(), function_id_, session_id};
+}
+
+absl::Status SessionProvider::Prewarm() {
+  while (true) {
+    int16_t session_id = 0;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (num_sessions_ >= options_.min_sessions ||
+          (options_.max_sessions > 0 &&
+           num_sessions_ >= options_.max_sessions)) {
+        return absl::OkStatus();
+      }
+      session_id = session_creation_counter_++;
+      ++num_sessions_;
+    }
+    absl::StatusOr<std::unique_ptr<tensorflow::Session>> session =
+        CreateSession(session_id);
+    absl::MutexLock lock(&mutex_);
+    if (!session.ok()) {
+      --num_sessions_;
+      return session.status();
+    }
+    sessions_.emplace_back(std::move(session).value(), function_id_,
+                           session_id);
+  }
 }
 
 void SessionProvider::ReturnSession(
@@ -16,6 +16,7 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_SESSION_PROVIDER_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_SESSION_PROVIDER_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -23,12 +24,15 @@ limitations under the License
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 #include "tensorflow/core/common_runtime/device_mgr.h"
 #include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/protobuf/rewriter_config.pb.h"
 #include "tensorflow/core/public/session.h"
@@ -36,6 +40,33 @@ limitations under the License
 
 namespace tensorflow_federated {
 
+// Bounds of the pool of sessions a `SessionProvider` keeps for its graph, and
+// the accelerator device they run on.
+struct SessionPoolOptions {
+  // The number of sessions `SessionProvider::Prewarm` creates ahead of their
+  // first use.
+  int32_t min_sessions = 0;
+  // The maximum number of sessions the provider creates, non-positive values
+  // indicate no max. Once reached, `TakeSession` blocks until a session is
+  // returned.
+  int32_t max_sessions = 0;
+  // If non-negative, the index of the GPU or TPU, modulo the number of them,
+  // on which all sessions place their kernels. Otherwise sessions are spread
+  // round robin across the devices.
+  int32_t device_index = -1;
+  // If true, the sessions run their ops on process-wide inter-op and intra-op
+  // thread pools, shared with all other providers whose pools are shared, so
+  // that the number of TensorFlow threads does not grow with the number of
+  // sessions. Otherwise each session gets the default pools of TensorFlow.
+  bool share_thread_pools = false;
+  // The sizes of the shared pools, if `share_thread_pools` is set.
+  // Non-positive values size a pool by the number of cores. Pools of
+  // different sizes are distinct, while the intra-op pool is sized by the
+  // first session created in the process.
+  int32_t inter_op_threads = 0;
+  int32_t intra_op_threads = 0;
+};
+
 // This class acts as a function from graph -> session, caching previously-
 // created sessions for later use.
 //
@@ -50,7 +81,8 @@ namespace tensorflow_federated {
 // TensorFlowExecutor.
 class SessionProvider {
  public:
-  SessionProvider(tensorflow::GraphDef&& graph);
+  explicit SessionProvider(tensorflow::GraphDef&& graph,
+                           SessionPoolOptions options = SessionPoolOptions());
 
   class SessionWithResourceContainer {
    public:
@@ -79,10 +111,30 @@ class SessionProvider {
 
     tensorflow::Session* session_ptr() { return session_.get(); }
 
+    // Runs the session as `tensorflow::Session::Run` does, through a callable
+    // made the first time the session runs with the same feeds, fetches and
+    // targets, so that TensorFlow does not resolve their names and look up
+    // the executors of the signature on every run. `outputs` may be null if
+    // nothing is fetched.
+    absl::Status RunCallable(
+        const std::vector<std::pair<std::string, tensorflow::Tensor>>& inputs,
+        const std::vector<std::string>& output_tensor_names,
+        const std::vector<std::string>& target_tensor_names,
+        std::vector<tensorflow::Tensor>* outputs);
+
    private:
+    // Runs with signatures beyond this many fall back to `Session::Run`, so
+    // that e.g. fetching many different subsets of the outputs doesn't grow
+    // the callables of a session without bound.
+    static constexpr size_t kMaxCallables = 64;
+
     std::unique_ptr<tensorflow::Session> session_;
     const std::string container_name_;
     const tensorflow::DeviceMgr* device_mgr_;
+    // The callables made by `RunCallable`, keyed by their signature. They are
+    // released with the session.
+    absl::flat_hash_map<std::string, tensorflow::Session::CallableHandle>
+        callables_;
   };
 
   // An RAII container which returns the session to the provider on destruction.
@@ -105,6 +157,16 @@ class SessionProvider {
 
     tensorflow::Session* operator->() { return session_.session_ptr(); }
 
+    // See `SessionWithResourceContainer::RunCallable`.
+    absl::Status RunCallable(
+        const std::vector<std::pair<std::string, tensorflow::Tensor>>& inputs,
+        const std::vector<std::string>& output_tensor_names,
+        const std::vector<std::string>& target_tensor_names,
+        std::vector<tensorflow::Tensor>* outputs) {
+      return session_.RunCallable(inputs, output_tensor_names,
+                                  target_tensor_names, outputs);
+    }
+
    private:
     SessionWithResourceContainer session_;
     SessionProvider& provider_;
@@ -117,10 +179,20 @@ class SessionProvider {
   absl::StatusOr<SessionWithResourceContainer> TakeSession();
   void ReturnSession(SessionWithResourceContainer&& session);
 
+  // Creates sessions until the provider has `min_sessions` of them, or
+  // `max_sessions` if that is lower. Intended to be run asynchronously when a
+  // computation is created, so that its first calls do not each pay for
+  // building a session.
+  absl::Status Prewarm();
+
  private:
   absl::StatusOr<std::unique_ptr<tensorflow::Session>> CreateSession(
       const int16_t session_id);
 
+  // Returns whether `TakeSession` can take a pooled session or create one
+  // without exceeding `max_sessions`.
+  bool CanTakeSession() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   // Move-only.
   SessionProvider(SessionProvider&& other) = default;
   SessionProvider& operator=(SessionProvider&& other) = default;
@@ -140,6 +212,9 @@ class SessionProvider {
   //   multiple accelerators, sessions will be pinned to the
   //   `session_creation_counter_ % num_accelerators` device.
   int16_t session_creation_counter_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The number of sessions which are pooled, rented out, or being created.
+  int32_t num_sessions_ ABSL_GUARDED_BY(mutex_) = 0;
+  const SessionPoolOptions options_;
 };
 
 }  // namespace tensorflow_federated
@@ -15,20 +15,120 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/session_provider.h"
 
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
 #include "googletest/include/gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
 
 namespace tensorflow_federated {
 
 namespace {
 
+// Returns a graph computing `out = x + 1`.
+tensorflow::GraphDef AddOneGraph() {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root.WithOpName("x"), tensorflow::DT_FLOAT);
+  tensorflow::ops::AddV2 out(root.WithOpName("out"), x,
+                             tensorflow::ops::Const(root, 1.0f));
+  tensorflow::GraphDef graphdef_pb;
+  CHECK(root.ToGraphDef(&graphdef_pb).ok());
+  return graphdef_pb;
+}
+
 TEST(SessionProviderTest, TestStandaloneTakeSession) {
   tensorflow::GraphDef graphdef_pb;
   SessionProvider session_provider(std::move(graphdef_pb));
   TFF_ASSERT_OK(session_provider.TakeSession());
 }
 
+TEST(SessionProviderTest, RunCallableRunsRepeatedSignatures) {
+  SessionProvider session_provider(AddOneGraph());
+  auto session = TFF_ASSERT_OK(session_provider.BorrowSession());
+  for (float x : {1.0f, 2.0f}) {
+    std::vector<tensorflow::Tensor> outputs;
+    TFF_ASSERT_OK(session.RunCallable(
+        {{"x:0", tensorflow::test::AsScalar<float>(x)}}, {"out:0"},
+        /*target_tensor_names=*/{}, &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    tensorflow::test::ExpectTensorEqual<float>(
+        outputs[0], tensorflow::test::AsScalar<float>(x + 1.0f));
+  }
+  TFF_ASSERT_OK(session.RunCallable(
+      {{"x:0", tensorflow::test::AsScalar<float>(0.0f)}},
+      /*output_tensor_names=*/{}, /*target_tensor_names=*/{"out"},
+      /*outputs=*/nullptr));
+}
+
+TEST(SessionProviderTest, PrewarmCreatesMinSessions) {
+  tensorflow::GraphDef graphdef_pb;
+  SessionPoolOptions options;
+  options.min_sessions = 2;
+  options.max_sessions = 2;
+  SessionProvider session_provider(std::move(graphdef_pb), options);
+  TFF_ASSERT_OK(session_provider.Prewarm());
+  // Both prewarmed sessions can be taken without blocking on the max.
+  auto first = TFF_ASSERT_OK(session_provider.TakeSession());
+  auto second = TFF_ASSERT_OK(session_provider.TakeSession());
+  session_provider.ReturnSession(std::move(first));
+  session_provider.ReturnSession(std::move(second));
+}
+
+TEST(SessionProviderTest, PrewarmIsIdempotent) {
+  tensorflow::GraphDef graphdef_pb;
+  SessionPoolOptions options;
+  options.min_sessions = 1;
+  options.max_sessions = 1;
+  SessionProvider session_provider(std::move(graphdef_pb), options);
+  TFF_ASSERT_OK(session_provider.Prewarm());
+  TFF_ASSERT_OK(session_provider.Prewarm());
+  auto session = TFF_ASSERT_OK(session_provider.TakeSession());
+  session_provider.ReturnSession(std::move(session));
+}
+
+TEST(SessionProviderTest, CreatesSessionsOnSharedThreadPools) {
+  SessionPoolOptions options;
+  options.share_thread_pools = true;
+  options.inter_op_threads = 2;
+  SessionProvider session_provider(tensorflow::GraphDef(), options);
+  SessionProvider other_session_provider(tensorflow::GraphDef(), options);
+  auto session = TFF_ASSERT_OK(session_provider.TakeSession());
+  auto other_session = TFF_ASSERT_OK(other_session_provider.TakeSession());
+  session_provider.ReturnSession(std::move(session));
+  other_session_provider.ReturnSession(std::move(other_session));
+}
+
+TEST(SessionProviderTest, TakeSessionBlocksAtMaxSessions) {
+  tensorflow::GraphDef graphdef_pb;
+  SessionPoolOptions options;
+  options.max_sessions = 1;
+  SessionProvider session_provider(std::move(graphdef_pb), options);
+  auto first = TFF_ASSERT_OK(session_provider.TakeSession());
+  absl::Notification taken;
+  std::thread taker([&session_provider, &taken] {
+    auto second = session_provider.TakeSession();
+    TFF_EXPECT_OK(second.status());
+    taken.Notify();
+    if (second.ok()) {
+      session_provider.ReturnSession(std::move(second).value());
+    }
+  });
+  EXPECT_FALSE(taken.WaitForNotificationWithTimeout(absl::Milliseconds(100)));
+  session_provider.ReturnSession(std::move(first));
+  taken.WaitForNotification();
+  taker.join();
+}
+
 }  // namespace
 }  // namespace tensorflow_federated
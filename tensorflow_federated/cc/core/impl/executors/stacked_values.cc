@@ -0,0 +1,174 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+
+#include "tensorflow_federated/cc/core/impl/executors/stacked_values.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/util/batch_util.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// Returns the tensors of `values` stacked along a new leading dimension, or
+// `std::nullopt` unless they all have the same dtype and shape.
+absl::StatusOr<std::optional<v0::Value>> StackTensors(
+    absl::Span<const v0::Value* const> values) {
+  std::vector<tensorflow::Tensor> tensors;
+  tensors.reserve(values.size());
+  for (const v0::Value* value : values) {
+    if (!value->has_tensor()) {
+      return std::nullopt;
+    }
+    tensorflow::Tensor tensor = TFF_TRY(DeserializeTensorValue(*value));
+    if (!tensors.empty() && (tensor.dtype() != tensors[0].dtype() ||
+                             tensor.shape() != tensors[0].shape())) {
+      return std::nullopt;
+    }
+    tensors.push_back(std::move(tensor));
+  }
+  tensorflow::TensorShape stacked_shape = tensors[0].shape();
+  stacked_shape.InsertDim(0, static_cast<int64_t>(tensors.size()));
+  tensorflow::Tensor stacked(tensors[0].dtype(), stacked_shape);
+  for (int64_t i = 0; i < static_cast<int64_t>(tensors.size()); i++) {
+    absl::Status status =
+        tensorflow::batch_util::CopyElementToSlice(tensors[i], &stacked, i);
+    if (!status.ok()) {
+      return absl::InternalError(
+          absl::StrCat("Failed to stack values: ", status.message()));
+    }
+  }
+  v0::Value stacked_pb;
+  TFF_TRY(SerializeTensorValue(stacked, &stacked_pb));
+  return stacked_pb;
+}
+
+// Returns the structures of `values` stacked element by element, or
+// `std::nullopt` unless they all have the same element names and their
+// elements can be stacked.
+absl::StatusOr<std::optional<v0::Value>> StackStructures(
+    absl::Span<const v0::Value* const> values) {
+  const v0::Value_Struct& first = values[0]->struct_();
+  for (const v0::Value* value : values) {
+    if (!value->has_struct_() ||
+        value->struct_().element_size() != first.element_size()) {
+      return std::nullopt;
+    }
+  }
+  v0::Value stacked_pb;
+  v0::Value_Struct* stacked_struct_pb = stacked_pb.mutable_struct_();
+  std::vector<const v0::Value*> elements(values.size());
+  for (int i = 0; i < first.element_size(); i++) {
+    for (size_t j = 0; j < values.size(); j++) {
+      const v0::Value_Struct_Element& element = values[j]->struct_().element(i);
+      if (element.name() != first.element(i).name()) {
+        return std::nullopt;
+      }
+      elements[j] = &element.value();
+    }
+    std::optional<v0::Value> stacked_element = TFF_TRY(StackValues(elements));
+    if (!stacked_element.has_value()) {
+      return std::nullopt;
+    }
+    v0::Value_Struct_Element* element_pb = stacked_struct_pb->add_element();
+    element_pb->set_name(first.element(i).name());
+    *element_pb->mutable_value() = std::move(stacked_element).value();
+  }
+  return stacked_pb;
+}
+
+}  // namespace
+
+absl::StatusOr<std::optional<v0::Value>> StackValues(
+    absl::Span<const v0::Value* const> values) {
+  if (values.empty()) {
+    return std::nullopt;
+  }
+  switch (values[0]->value_case()) {
+    case v0::Value::kTensor:
+      return StackTensors(values);
+    case v0::Value::kStruct:
+      return StackStructures(values);
+    default:
+      return std::nullopt;
+  }
+}
+
+absl::StatusOr<std::vector<v0::Value>> UnstackValue(const v0::Value& stacked,
+                                                     uint32_t num_values) {
+  std::vector<v0::Value> values(num_values);
+  switch (stacked.value_case()) {
+    case v0::Value::kTensor: {
+      tensorflow::Tensor tensor = TFF_TRY(DeserializeTensorValue(stacked));
+      if (tensor.dims() == 0 || tensor.dim_size(0) != num_values) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("Expected a stacked tensor with a leading dimension "
+                         "of ",
+                         num_values, ", found ", tensor.DebugString()));
+      }
+      tensorflow::TensorShape element_shape = tensor.shape();
+      element_shape.RemoveDim(0);
+      for (uint32_t i = 0; i < num_values; i++) {
+        tensorflow::Tensor element(tensor.dtype(), element_shape);
+        absl::Status status =
+            tensorflow::batch_util::CopySliceToElement(tensor, &element, i);
+        if (!status.ok()) {
+          return absl::InternalError(
+              absl::StrCat("Failed to unstack value: ", status.message()));
+        }
+        TFF_TRY(SerializeTensorValue(element, &values[i]));
+      }
+      return values;
+    }
+    case v0::Value::kStruct: {
+      for (v0::Value& value : values) {
+        value.mutable_struct_();
+      }
+      for (const v0::Value_Struct_Element& element_pb :
+           stacked.struct_().element()) {
+        std::vector<v0::Value> elements =
+            TFF_TRY(UnstackValue(element_pb.value(), num_values));
+        for (uint32_t i = 0; i < num_values; i++) {
+          v0::Value_Struct_Element* element =
+              values[i].mutable_struct_()->add_element();
+          element->set_name(element_pb.name());
+          *element->mutable_value() = std::move(elements[i]);
+        }
+      }
+      return values;
+    }
+    default:
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Expected a stacked tensor or structure, found a value of kind ",
+          stacked.value_case()));
+  }
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,45 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_STACKED_VALUES_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_STACKED_VALUES_H_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+// Returns `values` stacked along a new leading dimension, in order, or
+// `std::nullopt` if they can't be stacked. Values can be stacked if they are
+// all tensors of the same dtype and shape, or structures with the same element
+// names whose elements can be stacked in turn.
+absl::StatusOr<std::optional<v0::Value>> StackValues(
+    absl::Span<const v0::Value* const> values);
+
+// Splits `stacked`, a tensor or structure of tensors with a leading dimension
+// of `num_values`, into `num_values` values. This is the inverse of
+// `StackValues`.
+absl::StatusOr<std::vector<v0::Value>> UnstackValue(const v0::Value& stacked,
+                                                     uint32_t num_values);
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_STACKED_VALUES_H_
@@ -0,0 +1,92 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+
+#include "tensorflow_federated/cc/core/impl/executors/stacked_values.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::absl::StatusCode;
+using ::tensorflow_federated::testing::EqualsProto;
+using ::tensorflow_federated::testing::StructV;
+using ::tensorflow_federated::testing::TensorV;
+using ::tensorflow_federated::testing::TensorVFromIntList;
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Optional;
+
+TEST(StackedValuesTest, StacksAndUnstacksTensors) {
+  std::vector<v0::Value> values = {TensorV(1), TensorV(2), TensorV(3)};
+  TFF_ASSERT_OK_AND_ASSIGN(
+      std::optional<v0::Value> stacked,
+      StackValues({&values[0], &values[1], &values[2]}));
+  EXPECT_THAT(stacked, Optional(EqualsProto(TensorVFromIntList({1, 2, 3}))));
+  EXPECT_THAT(UnstackValue(*stacked, 3),
+              IsOkAndHolds(ElementsAre(EqualsProto(values[0]),
+                                       EqualsProto(values[1]),
+                                       EqualsProto(values[2]))));
+}
+
+TEST(StackedValuesTest, StacksAndUnstacksStructures) {
+  std::vector<v0::Value> values = {StructV({TensorV(1), TensorV(1.0f)}),
+                                   StructV({TensorV(2), TensorV(2.0f)})};
+  TFF_ASSERT_OK_AND_ASSIGN(std::optional<v0::Value> stacked,
+                           StackValues({&values[0], &values[1]}));
+  ASSERT_TRUE(stacked.has_value());
+  EXPECT_THAT(stacked->struct_().element(0).value(),
+              EqualsProto(TensorVFromIntList({1, 2})));
+  EXPECT_THAT(UnstackValue(*stacked, 2),
+              IsOkAndHolds(ElementsAre(EqualsProto(values[0]),
+                                       EqualsProto(values[1]))));
+}
+
+TEST(StackedValuesTest, DoesNotStackMismatchedValues) {
+  std::vector<v0::Value> values = {TensorV(1), TensorV(1.0f),
+                                   TensorVFromIntList({1, 2}),
+                                   StructV({TensorV(1)})};
+  EXPECT_THAT(StackValues({&values[0], &values[1]}),
+              IsOkAndHolds(Eq(std::nullopt)));
+  EXPECT_THAT(StackValues({&values[0], &values[2]}),
+              IsOkAndHolds(Eq(std::nullopt)));
+  EXPECT_THAT(StackValues({&values[0], &values[3]}),
+              IsOkAndHolds(Eq(std::nullopt)));
+  EXPECT_THAT(StackValues({}), IsOkAndHolds(Eq(std::nullopt)));
+}
+
+TEST(StackedValuesTest, UnstackFailsOnMismatchedLeadingDimension) {
+  EXPECT_THAT(UnstackValue(TensorVFromIntList({1, 2}), 3),
+              StatusIs(StatusCode::kInvalidArgument));
+  EXPECT_THAT(UnstackValue(TensorV(1), 1),
+              StatusIs(StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
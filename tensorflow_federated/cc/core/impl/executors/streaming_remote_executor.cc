@@ -15,7 +15,11 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/streaming_remote_executor.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <climits>
+#include <cstddef>
 #include <cstdint>
 #include <future>  // NOLINT
 #include <list>
@@ -27,7 +31,10 @@ limitations under the License
 #include <utility>
 #include <vector>
 
+#include "google/protobuf/arena.h"
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -38,13 +45,16 @@ limitations under the License
 #include "absl/synchronization/mutex.h"
 #include "include/grpcpp/grpcpp.h"
 #include "include/grpcpp/support/status.h"
+#include "include/grpcpp/support/sync_stream.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/dispose_queue.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/federated_intrinsics.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_conversion.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
 #include "tensorflow_federated/cc/core/impl/executors/type_utils.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 #include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
@@ -55,6 +65,8 @@ class ExecutorValue;
 
 using ValueFuture =
     std::shared_future<absl::StatusOr<std::shared_ptr<ExecutorValue>>>;
+using ValuePromise =
+    std::promise<absl::StatusOr<std::shared_ptr<ExecutorValue>>>;
 
 // Create a structure by extracting all the values inside the federated values
 // of a structure.
@@ -331,8 +343,11 @@ class StreamingRemoteExecutor : public ExecutorBase<ValueFuture> {
  public:
   StreamingRemoteExecutor(
       std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
-      const CardinalityMap& cardinalities)
-      : stub_(stub.release(), StubDeleter()), cardinalities_(cardinalities) {}
+      const CardinalityMap& cardinalities,
+      StreamingRemoteExecutorOptions options)
+      : stub_(stub.release(), StubDeleter()),
+        cardinalities_(cardinalities),
+        options_(options) {}
 
   ~StreamingRemoteExecutor() override = default;
 
@@ -355,20 +370,70 @@ class StreamingRemoteExecutor : public ExecutorBase<ValueFuture> {
 
   absl::Status Materialize(ValueFuture value, v0::Value* value_pb) final;
   absl::Status MaterializeRPC(ValueFuture value, v0::Value* value_pb);
+  // Adds the elements of the struct `value` of type `type_pb` to `struct_pb`,
+  // and appends a selection of each of its leaves, or non-struct elements at
+  // any depth, to `leaves` along the element to materialize it into.
+  absl::Status SelectStructLeaves(
+      ValueFuture value, const v0::StructType& type_pb,
+      v0::Value::Struct* struct_pb,
+      std::vector<std::pair<ValueFuture, v0::Value*>>& leaves);
+  // Materializes each of `values` into its paired proto, with up to
+  // `options_.max_concurrent_materializations` concurrent requests.
+  absl::Status MaterializeConcurrently(
+      const std::vector<std::pair<ValueFuture, v0::Value*>>& values);
+
+  // Calls and structs are batched into a single `ExecuteBatch` request. Values
+  // are not, since their structures are streamed in requests of their own.
+  absl::StatusOr<std::vector<ValueFuture>> CreateCallBatch(
+      ValueFuture function, std::vector<ValueFuture> arguments) final;
+
+  absl::StatusOr<std::vector<ValueFuture>> CreateStructBatch(
+      std::vector<std::vector<ValueFuture>> members) final;
 
  private:
   absl::Status EnsureInitialized();
   std::shared_ptr<v0::ExecutorGroup::StubInterface> stub_;
   CardinalityMap cardinalities_;
+  const StreamingRemoteExecutorOptions options_;
+  // Set once the service is known not to implement `ComputeStream`.
+  std::atomic<bool> compute_stream_unimplemented_ = false;
   absl::Mutex mutex_;
   bool executor_pb_set_ ABSL_GUARDED_BY(mutex_) = false;
   v0::ExecutorId executor_pb_;
+  std::shared_ptr<DisposeQueue> dispose_queue_;
+  absl::Mutex generated_computations_mutex_;
+  // The remote values of the computations generated to stream federated
+  // structures, keyed by their kind and the type they are generated for, so
+  // that values of the same type share them. There are as many of them as
+  // there are federated struct types streamed, which are few.
+  absl::flat_hash_map<std::string, ValueFuture> generated_computations_
+      ABSL_GUARDED_BY(generated_computations_mutex_);
+
+  // Returns the remote value of the computation returned by `generate`, which
+  // is only called if no computation was created for `key` before, or its
+  // creation failed.
+  absl::StatusOr<ValueFuture> GeneratedComputation(
+      std::string key,
+      absl::FunctionRef<absl::StatusOr<v0::Value>()> generate)
+      ABSL_LOCKS_EXCLUDED(generated_computations_mutex_);
 
   absl::StatusOr<ValueFuture> CreateValueRPC(const v0::Value& value_pb);
+  absl::StatusOr<ValueFuture> CreateValueStreamRPC(const v0::Value& value_pb,
+                                                   v0::Type type_pb,
+                                                   std::string content_hash);
+  grpc::Status ComputeStreamRPC(const v0::ComputeRequest& request,
+                                v0::Value* value_pb);
   absl::StatusOr<ValueFuture> CreateExecutorValueStreaming(
       const v0::Value& value_pb);
   absl::StatusOr<ValueFuture> CreateExecutorFederatedValueStreaming(
       const v0::Value& value_pb);
+  // Calls `make_request` from another thread to fill an `ExecuteBatch`
+  // request with `batch_size` operations and return the types of their
+  // results, then makes the request. Returns a future to the result of each
+  // operation.
+  template <typename MakeRequest>
+  std::vector<ValueFuture> ExecuteBatchRPC(size_t batch_size,
+                                           MakeRequest make_request);
 };
 
 // A value tracked by the StreamingRemoteExecutor.
@@ -383,28 +448,13 @@ class StreamingRemoteExecutor : public ExecutorBase<ValueFuture> {
 class ExecutorValue {
  public:
   ExecutorValue(v0::ValueRef value_ref, v0::Type type_pb,
-                v0::ExecutorId executor_pb,
-                std::shared_ptr<v0::ExecutorGroup::StubInterface> stub)
+                std::shared_ptr<DisposeQueue> dispose_queue)
       : value_ref_(std::move(value_ref)),
         type_pb_(std::move(type_pb)),
-        executor_pb_(std::move(executor_pb)),
-        stub_(stub) {}
-  // Dispose implemented for now just on destructors, and stub is copied in.
-  ~ExecutorValue() {
-    ThreadRun([value_ref = value_ref_, executor_pb = executor_pb_,
-               stub = stub_] {
-      v0::DisposeRequest request;
-      v0::DisposeResponse response;
-      grpc::ClientContext context;
-      *request.mutable_executor() = std::move(executor_pb);
-      *request.add_value_ref() = value_ref;
-      grpc::Status dispose_status = stub->Dispose(&context, request, &response);
-      if (!dispose_status.ok()) {
-        LOG(ERROR) << "Error disposing of ExecutorValue [" << value_ref.id()
-                   << "]: " << grpc_to_absl(dispose_status);
-      }
-    });
-  }
+        dispose_queue_(std::move(dispose_queue)) {}
+  // Dispose implemented for now just on destructors. The request is batched
+  // with the disposal of other values of the same executor.
+  ~ExecutorValue() { dispose_queue_->Add(value_ref_); }
 
   const v0::ValueRef& Get() const { return value_ref_; }
   const v0::Type& Type() const { return type_pb_; }
@@ -412,8 +462,7 @@ class ExecutorValue {
  private:
   const v0::ValueRef value_ref_;
   const v0::Type type_pb_;
-  const v0::ExecutorId executor_pb_;
-  std::shared_ptr<v0::ExecutorGroup::StubInterface> stub_;
+  std::shared_ptr<DisposeQueue> dispose_queue_;
 };
 
 absl::Status StreamingRemoteExecutor::EnsureInitialized() {
@@ -440,6 +489,9 @@ absl::Status StreamingRemoteExecutor::EnsureInitialized() {
     // Tell the `StubDeleter` which executor it should delete when the stub is
     // no longer referenced.
     std::get_deleter<StubDeleter>(stub_)->SetExecutorId(executor_pb_);
+    // The queue holds a reference to the stub, so the executor is only
+    // disposed of once all of its values have been.
+    dispose_queue_ = std::make_shared<DisposeQueue>(stub_, executor_pb_);
   }
   return grpc_to_absl(result);
 }
@@ -489,12 +541,32 @@ StreamingRemoteExecutor::CreateExecutorFederatedValueStreaming(
   ValueFuture struct_value_ref = TFF_TRY(CreateStruct(std::move(elements)));
   // Now call a federated_zip intrinsics on the structure-of-federated-values to
   // promote it back to a federated-structure-of-values.
-  const v0::Value intrinsic_pb = TFF_TRY(CreateFederatedZipComputation(
-      parameter_type_pb, federated_pb.type(), placement_spec));
-  ValueFuture intrinsic_ref = TFF_TRY(CreateExecutorValue(intrinsic_pb));
+  ValueFuture intrinsic_ref = TFF_TRY(GeneratedComputation(
+      absl::StrCat("zip:", federated_pb.type().SerializeAsString()), [&]() {
+        return CreateFederatedZipComputation(
+            parameter_type_pb, federated_pb.type(), placement_spec);
+      }));
   return CreateCall(intrinsic_ref, struct_value_ref);
 }
 
+absl::StatusOr<ValueFuture> StreamingRemoteExecutor::GeneratedComputation(
+    std::string key, absl::FunctionRef<absl::StatusOr<v0::Value>()> generate) {
+  absl::MutexLock lock(&generated_computations_mutex_);
+  auto it = generated_computations_.find(key);
+  if (it != generated_computations_.end()) {
+    const ValueFuture& computation = it->second;
+    // Computations whose creation failed are created again.
+    if (computation.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready ||
+        computation.get().ok()) {
+      return computation;
+    }
+  }
+  ValueFuture computation = TFF_TRY(CreateExecutorValue(TFF_TRY(generate())));
+  generated_computations_.insert_or_assign(std::move(key), computation);
+  return computation;
+}
+
 absl::StatusOr<ValueFuture>
 StreamingRemoteExecutor::CreateExecutorValueStreaming(
     const v0::Value& value_pb) {
@@ -535,6 +607,34 @@ absl::StatusOr<ValueFuture> StreamingRemoteExecutor::CreateValueRPC(
   if (type_pb.has_function() || type_pb.ShortDebugString().empty()) {
     VLOG(5) << value_pb.Utf8DebugString();
   }
+  std::string content_hash;
+  if (options_.use_value_cache &&
+      static_cast<int64_t>(value_pb.ByteSizeLong()) >=
+          options_.min_cached_value_size) {
+    content_hash = ValueContentHash(value_pb);
+    v0::CreateValueRequest request;
+    *request.mutable_executor() = executor_pb_;
+    request.set_content_hash(content_hash);
+    v0::CreateValueResponse response;
+    grpc::ClientContext client_context;
+    grpc::Status status =
+        stub_->CreateValue(&client_context, request, &response);
+    if (status.ok()) {
+      return ReadyFuture(
+          std::make_shared<ExecutorValue>(std::move(response.value_ref()),
+                                          std::move(type_pb), dispose_queue_));
+    }
+    // The service does not have the value cached yet, send it in full.
+    if (status.error_code() != grpc::StatusCode::NOT_FOUND) {
+      return grpc_to_absl(status);
+    }
+  }
+  if (value_pb.has_tensor() &&
+      static_cast<int64_t>(value_pb.tensor().value().size()) >
+          options_.value_chunk_size) {
+    return CreateValueStreamRPC(value_pb, std::move(type_pb),
+                                std::move(content_hash));
+  }
   if (value_pb.ByteSizeLong() > INT_MAX) {
     if (type_pb.has_federated()) {
       LOG(ERROR) << "Federated type `" << type_pb.ShortDebugString()
@@ -545,16 +645,57 @@ absl::StatusOr<ValueFuture> StreamingRemoteExecutor::CreateValueRPC(
         "Message with type `", type_pb.ShortDebugString(),
         "` will fail to serialize for gRPC, size: ", value_pb.ByteSizeLong()));
   }
-  v0::CreateValueRequest request;
-  *request.mutable_executor() = executor_pb_;
-  *request.mutable_value() = value_pb;
+  // Copying a deep value into a request on an arena does not allocate each of
+  // its messages.
+  google::protobuf::Arena arena;
+  auto* request =
+      google::protobuf::Arena::CreateMessage<v0::CreateValueRequest>(&arena);
+  *request->mutable_executor() = executor_pb_;
+  *request->mutable_value() = value_pb;
+  request->set_content_hash(std::move(content_hash));
   v0::CreateValueResponse response;
   grpc::ClientContext client_context;
-  grpc::Status status = stub_->CreateValue(&client_context, request, &response);
+  grpc::Status status =
+      stub_->CreateValue(&client_context, *request, &response);
   TFF_TRY(grpc_to_absl(status));
   return ReadyFuture(
       std::make_shared<ExecutorValue>(std::move(response.value_ref()),
-                                      std::move(type_pb), executor_pb_, stub_));
+                                      std::move(type_pb), dispose_queue_));
+}
+
+absl::StatusOr<ValueFuture> StreamingRemoteExecutor::CreateValueStreamRPC(
+    const v0::Value& value_pb, v0::Type type_pb, std::string content_hash) {
+  const std::string& content = value_pb.tensor().value();
+  VLOG(5) << "CreateValueStreamRPC: [" << type_pb.ShortDebugString() << "], "
+          << content.size() << " bytes";
+  v0::CreateValueResponse response;
+  grpc::ClientContext client_context;
+  std::unique_ptr<grpc::ClientWriterInterface<v0::CreateValueStreamRequest>>
+      writer = stub_->CreateValueStream(&client_context, &response);
+  v0::CreateValueStreamRequest request;
+  v0::CreateValueStreamRequest::Header* header = request.mutable_header();
+  *header->mutable_executor() = executor_pb_;
+  header->set_type_url(value_pb.tensor().type_url());
+  header->set_size(content.size());
+  header->set_content_hash(std::move(content_hash));
+  // `Write` blocks while the flow control window of the stream is full, so
+  // only a few chunks are ever buffered, rather than a copy of the tensor.
+  bool stream_ok = writer->Write(request);
+  for (size_t offset = 0; stream_ok && offset < content.size();
+       offset += options_.value_chunk_size) {
+    request.mutable_chunk()->assign(
+        content, offset,
+        std::min<size_t>(options_.value_chunk_size, content.size() - offset));
+    stream_ok = writer->Write(request);
+  }
+  if (stream_ok) {
+    writer->WritesDone();
+  }
+  // If the stream was broken by the service, `Finish` returns the reason.
+  TFF_TRY(grpc_to_absl(writer->Finish()));
+  return ReadyFuture(
+      std::make_shared<ExecutorValue>(std::move(response.value_ref()),
+                                      std::move(type_pb), dispose_queue_));
 }
 
 absl::StatusOr<ValueFuture> StreamingRemoteExecutor::CreateCall(
@@ -581,7 +722,7 @@ absl::StatusOr<ValueFuture> StreamingRemoteExecutor::CreateCall(
     TFF_TRY(grpc_to_absl(status));
     return std::make_shared<ExecutorValue>(std::move(response.value_ref()),
                                            fn->Type().function().result(),
-                                           executor_pb, this->stub_);
+                                           this->dispose_queue_);
   });
 }
 
@@ -610,7 +751,7 @@ absl::StatusOr<ValueFuture> StreamingRemoteExecutor::CreateStruct(
     TFF_TRY(grpc_to_absl(status));
     auto result = std::make_shared<ExecutorValue>(
         std::move(response.value_ref()), std::move(result_type),
-        this->executor_pb_, this->stub_);
+        this->dispose_queue_);
     return result;
   });
 }
@@ -641,10 +782,120 @@ absl::StatusOr<ValueFuture> StreamingRemoteExecutor::CreateSelection(
     TFF_TRY(grpc_to_absl(status));
     return std::make_shared<ExecutorValue>(std::move(response.value_ref()),
                                            std::move(element_type_pb),
-                                           this->executor_pb_, this->stub_);
+                                           this->dispose_queue_);
   });
 }
 
+template <typename MakeRequest>
+std::vector<ValueFuture> StreamingRemoteExecutor::ExecuteBatchRPC(
+    size_t batch_size, MakeRequest make_request) {
+  auto promises = std::make_shared<std::vector<ValuePromise>>(batch_size);
+  std::vector<ValueFuture> results;
+  results.reserve(batch_size);
+  for (ValuePromise& promise : *promises) {
+    results.push_back(promise.get_future().share());
+  }
+  ThreadRun([make_request = std::move(make_request), promises, this,
+             this_keepalive = shared_from_this()]() mutable {
+    absl::StatusOr<std::vector<std::shared_ptr<ExecutorValue>>> values =
+        [&]() -> absl::StatusOr<std::vector<std::shared_ptr<ExecutorValue>>> {
+      v0::ExecuteBatchRequest request;
+      *request.mutable_executor() = this->executor_pb_;
+      std::vector<v0::Type> result_types =
+          TFF_TRY(std::move(make_request)(&request));
+      v0::ExecuteBatchResponse response;
+      grpc::ClientContext context;
+      grpc::Status status =
+          this->stub_->ExecuteBatch(&context, request, &response);
+      TFF_TRY(grpc_to_absl(status));
+      if (static_cast<size_t>(response.value_ref_size()) !=
+          result_types.size()) {
+        return absl::InternalError(
+            absl::StrCat("Expected ", result_types.size(),
+                         " value refs from ExecuteBatch, found ",
+                         response.value_ref_size()));
+      }
+      std::vector<std::shared_ptr<ExecutorValue>> values;
+      values.reserve(result_types.size());
+      for (size_t i = 0; i < result_types.size(); ++i) {
+        values.push_back(std::make_shared<ExecutorValue>(
+            std::move(*response.mutable_value_ref(i)),
+            std::move(result_types[i]), this->dispose_queue_));
+      }
+      return values;
+    }();
+    for (size_t i = 0; i < promises->size(); ++i) {
+      if (!values.ok()) {
+        (*promises)[i].set_value(values.status());
+        continue;
+      }
+      (*promises)[i].set_value(std::move((*values)[i]));
+    }
+  });
+  return results;
+}
+
+absl::StatusOr<std::vector<ValueFuture>>
+StreamingRemoteExecutor::CreateCallBatch(ValueFuture function,
+                                         std::vector<ValueFuture> arguments) {
+  if (arguments.empty()) {
+    return std::vector<ValueFuture>();
+  }
+  TFF_TRY(EnsureInitialized());
+  const size_t batch_size = arguments.size();
+  return ExecuteBatchRPC(
+      batch_size,
+      [function = std::move(function), arguments = std::move(arguments)](
+          v0::ExecuteBatchRequest* request)
+          -> absl::StatusOr<std::vector<v0::Type>> {
+        std::shared_ptr<ExecutorValue> fn = TFF_TRY(Wait(function));
+        std::vector<std::shared_ptr<ExecutorValue>> args =
+            TFF_TRY(WaitAll(arguments));
+        for (const std::shared_ptr<ExecutorValue>& arg : args) {
+          v0::ExecuteBatchRequest::CreateCall* create_call =
+              request->add_operation()->mutable_create_call();
+          *create_call->mutable_function_ref()->mutable_value_ref() =
+              fn->Get();
+          *create_call->mutable_argument_ref()->mutable_value_ref() =
+              arg->Get();
+        }
+        return std::vector<v0::Type>(args.size(),
+                                     fn->Type().function().result());
+      });
+}
+
+absl::StatusOr<std::vector<ValueFuture>>
+StreamingRemoteExecutor::CreateStructBatch(
+    std::vector<std::vector<ValueFuture>> members) {
+  if (members.empty()) {
+    return std::vector<ValueFuture>();
+  }
+  TFF_TRY(EnsureInitialized());
+  const size_t batch_size = members.size();
+  return ExecuteBatchRPC(
+      batch_size,
+      [members = std::move(members)](v0::ExecuteBatchRequest* request)
+          -> absl::StatusOr<std::vector<v0::Type>> {
+        std::vector<v0::Type> result_types;
+        result_types.reserve(members.size());
+        for (const std::vector<ValueFuture>& struct_members : members) {
+          std::vector<std::shared_ptr<ExecutorValue>> values =
+              TFF_TRY(WaitAll(struct_members));
+          v0::ExecuteBatchRequest::CreateStruct* create_struct =
+              request->add_operation()->mutable_create_struct();
+          v0::StructType* struct_type =
+              result_types.emplace_back().mutable_struct_();
+          for (const std::shared_ptr<ExecutorValue>& element : values) {
+            *create_struct->add_element()
+                 ->mutable_value_ref()
+                 ->mutable_value_ref() = element->Get();
+            *struct_type->add_element()->mutable_value() = element->Type();
+          }
+        }
+        return result_types;
+      });
+}
+
 absl::Status StreamingRemoteExecutor::Materialize(ValueFuture value,
                                                   v0::Value* value_pb) {
   std::shared_ptr<ExecutorValue> value_ref = TFF_TRY(Wait(value));
@@ -653,14 +904,12 @@ absl::Status StreamingRemoteExecutor::Materialize(ValueFuture value,
       return MaterializeRPC(value, value_pb);
     }
     case v0::Type::kStruct: {
-      const v0::StructType& struct_type_pb = value_ref->Type().struct_();
-      v0::Value::Struct* struct_value_pb = value_pb->mutable_struct_();
-      for (int32_t i = 0; i < struct_type_pb.element_size(); ++i) {
-        ValueFuture selection = TFF_TRY(CreateSelection(value, i));
-        TFF_TRY(Materialize(selection,
-                            struct_value_pb->add_element()->mutable_value()));
-      }
-      return absl::OkStatus();
+      // All the selections are created before any leaf is materialized, so
+      // that the leaves are materialized concurrently.
+      std::vector<std::pair<ValueFuture, v0::Value*>> leaves;
+      TFF_TRY(SelectStructLeaves(value, value_ref->Type().struct_(),
+                                 value_pb->mutable_struct_(), leaves));
+      return MaterializeConcurrently(leaves);
     }
     case v0::Type::kFederated: {
       const v0::Type& member_type_pb = value_ref->Type().federated().member();
@@ -706,9 +955,14 @@ absl::Status StreamingRemoteExecutor::Materialize(ValueFuture value,
       // Otherwise we need to stream the federated structure by creating
       // a selection for each element and materializing them individually which
       // creates a struct-of-federated-values.
-      ValueFuture selection_computation = TFF_TRY(
-          CreateExecutorValue(TFF_TRY(CreateSelectionFederatedStructComputation(
-              value_ref->Type().federated()))));
+      const v0::FederatedType& federated_type_pb =
+          value_ref->Type().federated();
+      ValueFuture selection_computation = TFF_TRY(GeneratedComputation(
+          absl::StrCat("select:", federated_type_pb.SerializeAsString()),
+          [&federated_type_pb]() {
+            return CreateSelectionFederatedStructComputation(
+                federated_type_pb);
+          }));
       v0::Value intermediate_value_pb;
       TFF_TRY(Materialize(TFF_TRY(CreateCall(selection_computation, value)),
                           &intermediate_value_pb));
@@ -737,6 +991,54 @@ absl::Status StreamingRemoteExecutor::Materialize(ValueFuture value,
   return MaterializeRPC(value, value_pb);
 }
 
+absl::Status StreamingRemoteExecutor::SelectStructLeaves(
+    ValueFuture value, const v0::StructType& type_pb,
+    v0::Value::Struct* struct_pb,
+    std::vector<std::pair<ValueFuture, v0::Value*>>& leaves) {
+  for (int32_t i = 0; i < type_pb.element_size(); ++i) {
+    ValueFuture selection = TFF_TRY(CreateSelection(value, i));
+    v0::Value* element_pb = struct_pb->add_element()->mutable_value();
+    const v0::Type& element_type_pb = type_pb.element(i).value();
+    if (element_type_pb.has_struct_()) {
+      TFF_TRY(SelectStructLeaves(std::move(selection),
+                                 element_type_pb.struct_(),
+                                 element_pb->mutable_struct_(), leaves));
+    } else {
+      leaves.emplace_back(std::move(selection), element_pb);
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status StreamingRemoteExecutor::MaterializeConcurrently(
+    const std::vector<std::pair<ValueFuture, v0::Value*>>& values) {
+  // Each task materializes the next value not taken by another task, until
+  // all are taken or one failed.
+  std::atomic<size_t> next_value = 0;
+  std::atomic<bool> failed = false;
+  const size_t num_tasks = std::min<size_t>(
+      values.size(),
+      std::max<int32_t>(options_.max_concurrent_materializations, 1));
+  ParallelTasks tasks;
+  for (size_t i = 0; i < num_tasks; ++i) {
+    TFF_TRY(tasks.add_task(
+        [this, &values, &next_value, &failed]() -> absl::Status {
+          for (size_t index = next_value++;
+               index < values.size() && !failed.load();
+               index = next_value++) {
+            absl::Status status =
+                Materialize(values[index].first, values[index].second);
+            if (!status.ok()) {
+              failed = true;
+              return status;
+            }
+          }
+          return absl::OkStatus();
+        }));
+  }
+  return tasks.WaitAll();
+}
+
 absl::Status StreamingRemoteExecutor::MaterializeRPC(ValueFuture value,
                                                      v0::Value* value_pb) {
   std::shared_ptr<ExecutorValue> value_ref = TFF_TRY(Wait(value));
@@ -745,6 +1047,16 @@ absl::Status StreamingRemoteExecutor::MaterializeRPC(ValueFuture value,
   v0::ComputeRequest request;
   *request.mutable_executor() = executor_pb_;
   *request.mutable_value_ref() = value_ref->Get();
+  if (!compute_stream_unimplemented_.load(std::memory_order_relaxed)) {
+    grpc::Status status = ComputeStreamRPC(request, value_pb);
+    // Services which predate `ComputeStream` do not implement it, and do not
+    // give a reason. Fall back to `Compute` for those.
+    if (status.error_code() != grpc::StatusCode::UNIMPLEMENTED ||
+        !status.error_message().empty()) {
+      return grpc_to_absl(status);
+    }
+    compute_stream_unimplemented_.store(true, std::memory_order_relaxed);
+  }
 
   v0::ComputeResponse compute_response;
   grpc::ClientContext client_context;
@@ -754,19 +1066,78 @@ absl::Status StreamingRemoteExecutor::MaterializeRPC(ValueFuture value,
   return grpc_to_absl(status);
 }
 
+grpc::Status StreamingRemoteExecutor::ComputeStreamRPC(
+    const v0::ComputeRequest& request, v0::Value* value_pb) {
+  grpc::ClientContext client_context;
+  std::unique_ptr<grpc::ClientReaderInterface<v0::ComputeStreamResponse>>
+      reader = stub_->ComputeStream(&client_context, request);
+  v0::ComputeStreamResponse response;
+  // Set by the `tensor_header`, the chunks are appended to it as they arrive.
+  std::string* content = nullptr;
+  uint64_t content_size = 0;
+  absl::Status stream_status = absl::OkStatus();
+  while (stream_status.ok() && reader->Read(&response)) {
+    switch (response.response_case()) {
+      case v0::ComputeStreamResponse::kValue:
+        *value_pb = std::move(*response.mutable_value());
+        break;
+      case v0::ComputeStreamResponse::kTensorHeader:
+        content_size = response.tensor_header().size();
+        value_pb->mutable_tensor()->set_type_url(
+            std::move(*response.mutable_tensor_header()->mutable_type_url()));
+        content = value_pb->mutable_tensor()->mutable_value();
+        content->clear();
+        content->reserve(content_size);
+        break;
+      case v0::ComputeStreamResponse::kChunk:
+        if (content == nullptr ||
+            response.chunk().size() > content_size - content->size()) {
+          stream_status = absl::InternalError(
+              "Received a chunk which does not belong to the computed tensor.");
+          break;
+        }
+        content->append(response.chunk());
+        break;
+      default:
+        stream_status = absl::InternalError(absl::StrCat(
+            "Unknown ComputeStreamResponse case: ",
+            static_cast<int>(response.response_case())));
+    }
+  }
+  if (!stream_status.ok()) {
+    // Stop the service from sending the rest of the stream.
+    client_context.TryCancel();
+    reader->Finish();
+    return absl_to_grpc(stream_status);
+  }
+  grpc::Status status = reader->Finish();
+  if (!status.ok()) {
+    return status;
+  }
+  if (content != nullptr && content->size() != content_size) {
+    return grpc::Status(
+        grpc::StatusCode::INTERNAL,
+        absl::StrCat("Received ", content->size(), " of the ", content_size,
+                     " bytes of the computed tensor."));
+  }
+  return grpc::Status::OK;
+}
+
 std::shared_ptr<Executor> CreateStreamingRemoteExecutor(
     std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
-    const CardinalityMap& cardinalities) {
+    const CardinalityMap& cardinalities,
+    StreamingRemoteExecutorOptions options) {
   return std::make_shared<StreamingRemoteExecutor>(std::move(stub),
-                                                   cardinalities);
+                                                   cardinalities, options);
 }
 
 std::shared_ptr<Executor> CreateStreamingRemoteExecutor(
     std::shared_ptr<grpc::ChannelInterface> channel,
-    const CardinalityMap& cardinalities) {
+    const CardinalityMap& cardinalities,
+    StreamingRemoteExecutorOptions options) {
   std::unique_ptr<v0::ExecutorGroup::StubInterface> stub(
       v0::ExecutorGroup::NewStub(channel));
   return std::make_shared<StreamingRemoteExecutor>(std::move(stub),
-                                                   cardinalities);
+                                                   cardinalities, options);
 }
 }  // namespace tensorflow_federated
@@ -16,6 +16,7 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_STREAMING_REMOTE_EXECUTOR_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_STREAMING_REMOTE_EXECUTOR_H_
 
+#include <cstdint>
 #include <memory>
 
 #include "include/grpcpp/grpcpp.h"
@@ -25,6 +26,24 @@ limitations under the License
 
 namespace tensorflow_federated {
 
+struct StreamingRemoteExecutorOptions {
+  // Tensors whose serialized content is larger than this many bytes are
+  // themselves streamed, in chunks of this many bytes, through a single
+  // `CreateValueStream` request.
+  int64_t value_chunk_size = 1 << 20;  // 1 MiB
+  // If set, values whose serialized size is at least `min_cached_value_size`
+  // bytes are first sent as their content hash alone, and only sent in full if
+  // the service does not have them cached already. Must only be set for
+  // services which support `CreateValueRequest.content_hash`: older services
+  // would create empty values instead.
+  bool use_value_cache = false;
+  int64_t min_cached_value_size = 1 << 16;  // 64 KiB
+  // The leaves of a structure are materialized by up to this many concurrent
+  // requests, so that materializing a structure of many tensors costs about a
+  // round-trip per this many leaves rather than one per leaf.
+  int32_t max_concurrent_materializations = 16;
+};
+
 // Returns an executor which communicates with a remote executor service.
 //
 // This executor differs from `RemoteExecutor` by "streaming" structures of
@@ -32,10 +51,12 @@ namespace tensorflow_federated {
 // buffers for very large Struct values with many intermediate sized tensors.
 std::shared_ptr<Executor> CreateStreamingRemoteExecutor(
     std::shared_ptr<grpc::ChannelInterface> channel,
-    const CardinalityMap& cardinalities);
+    const CardinalityMap& cardinalities,
+    StreamingRemoteExecutorOptions options = StreamingRemoteExecutorOptions());
 std::shared_ptr<Executor> CreateStreamingRemoteExecutor(
     std::unique_ptr<v0::ExecutorGroup::StubInterface> stub,
-    const CardinalityMap& cardinalities);
+    const CardinalityMap& cardinalities,
+    StreamingRemoteExecutorOptions options = StreamingRemoteExecutorOptions());
 }  // namespace tensorflow_federated
 
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_STREAMING_REMOTE_EXECUTOR_H_
@@ -15,6 +15,7 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/streaming_remote_executor.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -39,11 +40,13 @@ limitations under the License
 #include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "include/grpcpp/support/status.h"
+#include "include/grpcpp/support/sync_stream.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/federated_intrinsics.h"
 #include "tensorflow_federated/cc/core/impl/executors/mock_grpc.h"
 #include "tensorflow_federated/cc/core/impl/executors/type_utils.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
 #include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
 #include "tensorflow_federated/cc/testing/protobuf_matchers.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
@@ -254,6 +257,134 @@ TEST_F(StreamingRemoteExecutorTest, CreateValueTensor) {
   WaitForDisposeExecutor(dispose_notification);
 }
 
+TEST_F(StreamingRemoteExecutorTest, CreateValueLargeTensorStreamsChunks) {
+  constexpr size_t kChunkSize = 4;
+  std::unique_ptr<v0::ExecutorGroup::Stub> stub_ptr(mock_executor_.NewStub());
+  StreamingRemoteExecutorOptions options;
+  options.value_chunk_size = kChunkSize;
+  test_executor_ = CreateStreamingRemoteExecutor(std::move(stub_ptr),
+                                                 {{"clients", 1}}, options);
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+
+  v0::Value tensor_two = TensorV(2.0f);
+  const std::string& content = tensor_two.tensor().value();
+  ASSERT_GT(content.size(), kChunkSize);
+  std::vector<v0::CreateValueStreamRequest> requests;
+  {
+    EXPECT_CALL(*mock_executor_service_, CreateValueStream(_, _, _))
+        .WillOnce([&requests](
+                      grpc::ServerContext*,
+                      grpc::ServerReader<v0::CreateValueStreamRequest>* reader,
+                      v0::CreateValueResponse* response) {
+          v0::CreateValueStreamRequest request;
+          while (reader->Read(&request)) {
+            requests.push_back(request);
+          }
+          response->mutable_value_ref()->set_id("value_ref");
+          return grpc::Status::OK;
+        });
+    EXPECT_CALL(*mock_executor_service_, Dispose(_, _, _))
+        .WillOnce(::testing::Return(grpc::Status::OK));
+
+    TFF_ASSERT_OK(test_executor_->CreateValue(tensor_two));
+  }
+
+  ASSERT_FALSE(requests.empty());
+  EXPECT_EQ(requests[0].header().executor().id(), kExecutorId);
+  EXPECT_EQ(requests[0].header().type_url(), tensor_two.tensor().type_url());
+  EXPECT_EQ(requests[0].header().size(), content.size());
+  std::string received_content;
+  for (size_t i = 1; i < requests.size(); ++i) {
+    EXPECT_LE(requests[i].chunk().size(), kChunkSize);
+    received_content += requests[i].chunk();
+  }
+  EXPECT_EQ(received_content, content);
+  WaitForDisposeExecutor(dispose_notification);
+}
+
+TEST_F(StreamingRemoteExecutorTest, CreateValueSendsContentHashFirst) {
+  std::unique_ptr<v0::ExecutorGroup::Stub> stub_ptr(mock_executor_.NewStub());
+  StreamingRemoteExecutorOptions options;
+  options.use_value_cache = true;
+  options.min_cached_value_size = 0;
+  test_executor_ = CreateStreamingRemoteExecutor(std::move(stub_ptr),
+                                                 {{"clients", 1}}, options);
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+
+  v0::Value tensor_two = TensorV(2.0f);
+  v0::CreateValueRequest hash_request;
+  hash_request.mutable_executor()->set_id(kExecutorId);
+  hash_request.set_content_hash(ValueContentHash(tensor_two));
+  v0::CreateValueRequest value_request = hash_request;
+  *value_request.mutable_value() = tensor_two;
+  {
+    ::testing::InSequence sequence;
+    EXPECT_CALL(*mock_executor_service_,
+                CreateValue(_, EqualsProto(hash_request), _))
+        .WillOnce(::testing::Return(
+            grpc::Status(grpc::StatusCode::NOT_FOUND, "Not cached")));
+    EXPECT_CALL(*mock_executor_service_,
+                CreateValue(_, EqualsProto(value_request), _))
+        .WillOnce(ReturnOkWithResponseId<v0::CreateValueResponse>("first"));
+    EXPECT_CALL(*mock_executor_service_,
+                CreateValue(_, EqualsProto(hash_request), _))
+        .WillOnce(ReturnOkWithResponseId<v0::CreateValueResponse>("second"));
+  }
+  EXPECT_CALL(*mock_executor_service_, Dispose(_, _, _))
+      .WillRepeatedly(::testing::Return(grpc::Status::OK));
+
+  {
+    TFF_ASSERT_OK(test_executor_->CreateValue(tensor_two));
+    TFF_ASSERT_OK(test_executor_->CreateValue(tensor_two));
+  }
+  WaitForDisposeExecutor(dispose_notification);
+}
+
+TEST_F(StreamingRemoteExecutorTest, MaterializeReassemblesStreamedTensor) {
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+
+  v0::Value tensor_two = TensorV(2.0f);
+  v0::Value tensor_three = TensorV(3.0f);
+  v0::Value materialized_value;
+  {
+    EXPECT_CALL(
+        *mock_executor_service_,
+        CreateValue(_, EqualsProto(CreateValueRequestForValue(tensor_two)), _))
+        .WillOnce(ReturnOkWithResponseId<v0::CreateValueResponse>("value_ref"));
+    EXPECT_CALL(*mock_executor_service_,
+                ComputeStream(_, EqualsProto(ComputeRequestForId("value_ref")),
+                              _))
+        .WillOnce([&tensor_three](
+                      grpc::ServerContext*, const v0::ComputeRequest*,
+                      grpc::ServerWriter<v0::ComputeStreamResponse>* writer) {
+          const std::string& content = tensor_three.tensor().value();
+          v0::ComputeStreamResponse response;
+          response.mutable_tensor_header()->set_type_url(
+              tensor_three.tensor().type_url());
+          response.mutable_tensor_header()->set_size(content.size());
+          writer->Write(response);
+          for (size_t offset = 0; offset < content.size(); offset += 3) {
+            response.set_chunk(content.substr(offset, 3));
+            writer->Write(response);
+          }
+          return grpc::Status::OK;
+        });
+    EXPECT_CALL(*mock_executor_service_, Compute(_, _, _)).Times(0);
+    EXPECT_CALL(*mock_executor_service_, Dispose(_, _, _))
+        .WillOnce(::testing::Return(grpc::Status::OK));
+
+    OwnedValueId value_ref =
+        TFF_ASSERT_OK(test_executor_->CreateValue(tensor_two));
+    TFF_ASSERT_OK(test_executor_->Materialize(value_ref, &materialized_value));
+  }
+
+  EXPECT_THAT(materialized_value, EqualsProto(tensor_three));
+  WaitForDisposeExecutor(dispose_notification);
+}
+
 TEST_F(StreamingRemoteExecutorTest, CreateValueNestedStruct) {
   absl::Notification dispose_notification;
   ExpectGetAndDisposeExecutor(dispose_notification);
@@ -391,6 +522,76 @@ TEST_F(StreamingRemoteExecutorTest, CreateValueNestedStruct) {
   WaitForDisposeExecutor(dispose_notification);
 }
 
+TEST_F(StreamingRemoteExecutorTest, MaterializesStructLeavesConcurrently) {
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+  v0::Value tensor_two = TensorV(2.0f);
+  v0::Value tensor_three = TensorV(3.0f);
+  v0::Value struct_value = StructV({tensor_two, tensor_three});
+  v0::Value materialized_value;
+  absl::Status materialize_status;
+  {
+    EXPECT_CALL(
+        *mock_executor_service_,
+        CreateValue(_, EqualsProto(CreateValueRequestForValue(tensor_two)), _))
+        .WillOnce(ReturnOkWithResponseId<v0::CreateValueResponse>("elem0"));
+    EXPECT_CALL(
+        *mock_executor_service_,
+        CreateValue(_, EqualsProto(CreateValueRequestForValue(tensor_three)),
+                    _))
+        .WillOnce(ReturnOkWithResponseId<v0::CreateValueResponse>("elem1"));
+    EXPECT_CALL(
+        *mock_executor_service_,
+        CreateStruct(
+            _, EqualsProto(CreateStructRequestForValues({"elem0", "elem1"})),
+            _))
+        .WillOnce(
+            ReturnOkWithResponseId<v0::CreateStructResponse>("struct_ref"));
+    OwnedValueId struct_ref =
+        TFF_ASSERT_OK(test_executor_->CreateValue(struct_value));
+
+    for (int32_t i = 0; i < 2; ++i) {
+      v0::CreateSelectionRequest selection_request;
+      selection_request.mutable_executor()->set_id(kExecutorId);
+      selection_request.mutable_source_ref()->set_id("struct_ref");
+      selection_request.set_index(i);
+      EXPECT_CALL(*mock_executor_service_,
+                  CreateSelection(_, EqualsProto(selection_request), _))
+          .WillOnce(ReturnOkWithResponseId<v0::CreateSelectionResponse>(
+              absl::StrCat("selection", i)));
+    }
+    // Each leaf is only computed once the other one is requested too, which
+    // would time out if they were materialized one after another.
+    absl::Notification started[2];
+    auto compute_once_both_started = [&started](int32_t index,
+                                                const v0::Value& value_pb) {
+      return [&started, index, value_pb](grpc::ServerContext*,
+                                         const v0::ComputeRequest*,
+                                         v0::ComputeResponse* response) {
+        started[index].Notify();
+        if (!started[1 - index].WaitForNotificationWithTimeout(
+                absl::Seconds(10))) {
+          return grpc::Status(grpc::StatusCode::DEADLINE_EXCEEDED,
+                              "Leaves were computed sequentially");
+        }
+        *response = ComputeResponseForValue(value_pb);
+        return grpc::Status::OK;
+      };
+    };
+    EXPECT_CALL(*mock_executor_service_,
+                Compute(_, EqualsProto(ComputeRequestForId("selection0")), _))
+        .WillOnce(compute_once_both_started(0, tensor_two));
+    EXPECT_CALL(*mock_executor_service_,
+                Compute(_, EqualsProto(ComputeRequestForId("selection1")), _))
+        .WillOnce(compute_once_both_started(1, tensor_three));
+    materialize_status =
+        test_executor_->Materialize(struct_ref, &materialized_value);
+  }
+  TFF_EXPECT_OK(materialize_status);
+  EXPECT_THAT(materialized_value, EqualsProto(struct_value));
+  WaitForDisposeExecutor(dispose_notification);
+}
+
 TEST_F(StreamingRemoteExecutorTest, CreateValueWithError) {
   absl::Notification dispose_notification;
   ExpectGetAndDisposeExecutor(dispose_notification);
@@ -1161,6 +1362,98 @@ TEST_P(StreamingRemoteExecutorFederatedStructsTest, RoundTripFederatedStruct) {
   WaitForDisposeExecutor(dispose_notification);
 }
 
+TEST_P(StreamingRemoteExecutorFederatedStructsTest,
+       FederatedStructsOfSameTypeShareZipComputation) {
+  absl::Notification dispose_notification;
+  ExpectGetAndDisposeExecutor(dispose_notification);
+
+  const FederatedStructTestCase& test_case = GetParam();
+  // Constructs a <float32, float32>@P.
+  const v0::Value tensor_two = TensorV(2.0f);
+  const v0::Value tensor_three = TensorV(3.0f);
+  const v0::Value federated_struct_value =
+      test_case.FederatedV({StructV({tensor_two, tensor_three})});
+
+  {
+    EXPECT_CALL(*mock_executor_service_,
+                CreateValue(_,
+                            EqualsProto(CreateValueRequestForValue(
+                                test_case.FederatedV({tensor_two}))),
+                            _))
+        .Times(2)
+        .WillRepeatedly(ReturnOkWithResponseId<v0::CreateValueResponse>(
+            "federated_elem_0"));
+    EXPECT_CALL(*mock_executor_service_,
+                CreateValue(_,
+                            EqualsProto(CreateValueRequestForValue(
+                                test_case.FederatedV({tensor_three}))),
+                            _))
+        .Times(2)
+        .WillRepeatedly(ReturnOkWithResponseId<v0::CreateValueResponse>(
+            "federated_elem_1"));
+    EXPECT_CALL(*mock_executor_service_,
+                CreateStruct(_,
+                             EqualsProto(CreateStructRequestForValues(
+                                 {"federated_elem_0", "federated_elem_1"})),
+                             _))
+        .Times(2)
+        .WillRepeatedly(ReturnOkWithResponseId<v0::CreateStructResponse>(
+            "streamed_federated_struct"));
+
+    v0::FunctionType zip_at_placement_type_pb;
+    auto* param_struct_type =
+        zip_at_placement_type_pb.mutable_parameter()->mutable_struct_();
+    auto* result_federated_type =
+        zip_at_placement_type_pb.mutable_result()->mutable_federated();
+    result_federated_type->set_all_equal(test_case.all_equal);
+    result_federated_type->mutable_placement()->mutable_value()->set_uri(
+        std::string(test_case.placement_uri));
+    auto* result_struct_type =
+        result_federated_type->mutable_member()->mutable_struct_();
+    for (int32_t i = 0; i < 2; ++i) {
+      auto* param_federated_type = param_struct_type->add_element()
+                                       ->mutable_value()
+                                       ->mutable_federated();
+      param_federated_type->mutable_member()->mutable_tensor()->set_dtype(
+          v0::DataType::DT_FLOAT);
+      param_federated_type->set_all_equal(test_case.all_equal);
+      param_federated_type->mutable_placement()->mutable_value()->set_uri(
+          std::string(test_case.placement_uri));
+      result_struct_type->add_element()
+          ->mutable_value()
+          ->mutable_tensor()
+          ->set_dtype(v0::DataType::DT_FLOAT);
+    }
+    // The zip computation is only created for the first value.
+    EXPECT_CALL(
+        *mock_executor_service_,
+        CreateValue(
+            _,
+            EqualsProto(CreateValueRequestForValue(
+                test_case.FederatedZipIntrinsicV(zip_at_placement_type_pb))),
+            _))
+        .WillOnce(
+            ReturnOkWithResponseId<v0::CreateValueResponse>("federated_zip"));
+
+    v0::CreateCallRequest zip_call_request;
+    zip_call_request.mutable_executor()->set_id(kExecutorId);
+    zip_call_request.mutable_function_ref()->set_id("federated_zip");
+    zip_call_request.mutable_argument_ref()->set_id(
+        "streamed_federated_struct");
+    EXPECT_CALL(*mock_executor_service_,
+                CreateCall(_, EqualsProto(zip_call_request), _))
+        .Times(2)
+        .WillRepeatedly(ReturnOkWithResponseId<v0::CreateCallResponse>(
+            "zipped_federated_struct"));
+
+    OwnedValueId struct_ref =
+        TFF_ASSERT_OK(test_executor_->CreateValue(federated_struct_value));
+    OwnedValueId other_struct_ref =
+        TFF_ASSERT_OK(test_executor_->CreateValue(federated_struct_value));
+  }
+  WaitForDisposeExecutor(dispose_notification);
+}
+
 TEST_P(StreamingRemoteExecutorFederatedStructsTest,
        RoundTripFederatedNestedStruct) {
   absl::Notification dispose_notification;
@@ -0,0 +1,181 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/streaming_sequence.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/core/data/standalone.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow_federated/cc/core/impl/executors/dataset_conversions.h"
+#include "tensorflow_federated/cc/core/impl/executors/dataset_from_tensor_structures.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+class DatasetElementSource : public SequenceElementSource {
+ public:
+  DatasetElementSource(
+      std::unique_ptr<tensorflow::data::standalone::Dataset> dataset,
+      std::unique_ptr<tensorflow::data::standalone::Iterator> iterator)
+      : dataset_(std::move(dataset)), iterator_(std::move(iterator)) {}
+
+  absl::StatusOr<ElementChunk> ReadChunk(int32_t max_elements) final {
+    ElementChunk chunk;
+    while (!end_of_data_ && chunk.size() < static_cast<size_t>(max_elements)) {
+      std::vector<tensorflow::Tensor> element;
+      absl::Status status = iterator_->GetNext(&element, &end_of_data_);
+      if (!status.ok()) {
+        return absl::InternalError(absl::StrCat(
+            "error pulling elements from dataset: ", status.message()));
+      }
+      if (!end_of_data_) {
+        chunk.push_back(std::move(element));
+      }
+    }
+    return chunk;
+  }
+
+ private:
+  // The iterator reads from the dataset, which must outlive it.
+  std::unique_ptr<tensorflow::data::standalone::Dataset> dataset_;
+  std::unique_ptr<tensorflow::data::standalone::Iterator> iterator_;
+  bool end_of_data_ = false;
+};
+
+class TensorStructuresElementSource : public SequenceElementSource {
+ public:
+  explicit TensorStructuresElementSource(ElementChunk elements)
+      : elements_(std::move(elements)) {}
+
+  absl::StatusOr<ElementChunk> ReadChunk(int32_t max_elements) final {
+    size_t end = std::min(elements_.size(),
+                          next_index_ + static_cast<size_t>(max_elements));
+    ElementChunk chunk(std::make_move_iterator(elements_.begin() + next_index_),
+                       std::make_move_iterator(elements_.begin() + end));
+    next_index_ = end;
+    return chunk;
+  }
+
+ private:
+  ElementChunk elements_;
+  size_t next_index_ = 0;
+};
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<SequenceElementSource>>
+CreateDatasetElementSource(const v0::Value::Sequence& sequence_pb) {
+  std::unique_ptr<tensorflow::data::standalone::Dataset> dataset =
+      TFF_TRY(SequenceValueToDataset(sequence_pb));
+  std::unique_ptr<tensorflow::data::standalone::Iterator> iterator;
+  absl::Status status = dataset->MakeIterator(&iterator);
+  if (!status.ok()) {
+    return absl::InternalError(
+        absl::StrCat("Error creating iterator from dataset of streaming "
+                     "sequence. Message: ",
+                     status.message()));
+  }
+  return std::make_unique<DatasetElementSource>(std::move(dataset),
+                                                std::move(iterator));
+}
+
+std::unique_ptr<SequenceElementSource> CreateTensorStructuresElementSource(
+    ElementChunk elements) {
+  return std::make_unique<TensorStructuresElementSource>(std::move(elements));
+}
+
+StreamingSequence::StreamingSequence(
+    std::unique_ptr<SequenceElementSource> source,
+    StreamingSequenceOptions options)
+    : source_(std::move(source)), options_(options) {
+  read_thread_ = std::thread([this] { ReadChunks(); });
+}
+
+StreamingSequence::~StreamingSequence() {
+  {
+    absl::MutexLock lock(&mutex_);
+    cancelled_ = true;
+    space_available_.Signal();
+  }
+  read_thread_.join();
+}
+
+absl::StatusOr<ElementChunk> StreamingSequence::NextChunk() {
+  absl::MutexLock lock(&mutex_);
+  while (buffer_.empty() && !done_) {
+    chunk_available_.Wait(&mutex_);
+  }
+  if (buffer_.empty()) {
+    // The end of the sequence or the error which stopped reading it.
+    TFF_TRY(final_status_);
+    return ElementChunk();
+  }
+  ElementChunk chunk = std::move(buffer_.front());
+  buffer_.pop_front();
+  space_available_.Signal();
+  return chunk;
+}
+
+absl::StatusOr<std::optional<tensorflow::Tensor>>
+StreamingSequence::NextChunkAsDataset() {
+  ElementChunk chunk = TFF_TRY(NextChunk());
+  if (chunk.empty()) {
+    return std::nullopt;
+  }
+  return TFF_TRY(DatasetFromTensorStructures(chunk));
+}
+
+void StreamingSequence::ReadChunks() {
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      const size_t max_buffered_chunks = options_.max_buffered_chunks;
+      while (!cancelled_ && buffer_.size() >= max_buffered_chunks) {
+        space_available_.Wait(&mutex_);
+      }
+      if (cancelled_) {
+        return;
+      }
+    }
+    absl::StatusOr<ElementChunk> chunk =
+        source_->ReadChunk(options_.chunk_size);
+    absl::MutexLock lock(&mutex_);
+    if (!chunk.ok() || chunk->empty()) {
+      final_status_ = chunk.status();
+      done_ = true;
+      chunk_available_.Signal();
+      return;
+    }
+    buffer_.push_back(std::move(chunk).value());
+    chunk_available_.Signal();
+  }
+}
+
+}  // namespace tensorflow_federated
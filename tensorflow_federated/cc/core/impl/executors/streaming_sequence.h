@@ -0,0 +1,114 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_STREAMING_SEQUENCE_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_STREAMING_SEQUENCE_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+// A chunk of consecutive elements of a sequence, each element in the
+// flattened form of its tensors.
+using ElementChunk = std::vector<std::vector<tensorflow::Tensor>>;
+
+// A source of the elements of a sequence which produces them incrementally,
+// rather than as one dataset holding all of them.
+class SequenceElementSource {
+ public:
+  virtual ~SequenceElementSource() = default;
+
+  // Returns the next elements of the sequence, at most `max_elements` of them.
+  // Returns an empty chunk once the sequence is exhausted.
+  virtual absl::StatusOr<ElementChunk> ReadChunk(int32_t max_elements) = 0;
+};
+
+// Returns a source over the elements of the dataset serialized in
+// `sequence_pb`.
+absl::StatusOr<std::unique_ptr<SequenceElementSource>>
+CreateDatasetElementSource(const v0::Value::Sequence& sequence_pb);
+
+// Returns a source over `elements`.
+std::unique_ptr<SequenceElementSource> CreateTensorStructuresElementSource(
+    ElementChunk elements);
+
+struct StreamingSequenceOptions {
+  // The maximum number of elements transferred from the source at once.
+  int32_t chunk_size = 64;
+  // The maximum number of chunks read ahead of their consumption.
+  int32_t max_buffered_chunks = 2;
+};
+
+// A sequence whose elements are pulled from a `SequenceElementSource` in
+// chunks on a background thread, so that consumption can begin with the first
+// chunk while later ones are still being read.
+//
+// At most `max_buffered_chunks` chunks are buffered ahead of the consumer, so
+// the memory held by the sequence is bounded by the chunk size rather than by
+// the size of the whole sequence.
+//
+// The sequence can be consumed a single time, by one consumer at a time.
+class StreamingSequence {
+ public:
+  explicit StreamingSequence(std::unique_ptr<SequenceElementSource> source,
+                             StreamingSequenceOptions options = {});
+  ~StreamingSequence();
+
+  StreamingSequence(const StreamingSequence&) = delete;
+  StreamingSequence& operator=(const StreamingSequence&) = delete;
+
+  // Returns the next chunk of elements, or an empty chunk once the sequence is
+  // exhausted. An error reading the source is returned once the chunks read
+  // before it have been consumed.
+  absl::StatusOr<ElementChunk> NextChunk() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Returns the next chunk of elements as a serialized dataset which a
+  // TensorFlow computation can consume, in the form returned by
+  // `DatasetFromTensorStructures`. Returns std::nullopt once the sequence is
+  // exhausted.
+  absl::StatusOr<std::optional<tensorflow::Tensor>> NextChunkAsDataset()
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  void ReadChunks() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  const std::unique_ptr<SequenceElementSource> source_;
+  const StreamingSequenceOptions options_;
+  absl::Mutex mutex_;
+  std::deque<ElementChunk> buffer_ ABSL_GUARDED_BY(mutex_);
+  // Whether `source_` was exhausted or failed with `final_status_`.
+  bool done_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::Status final_status_ ABSL_GUARDED_BY(mutex_);
+  bool cancelled_ ABSL_GUARDED_BY(mutex_) = false;
+  absl::CondVar chunk_available_;
+  absl::CondVar space_available_;
+  std::thread read_thread_;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_STREAMING_SEQUENCE_H_
@@ -0,0 +1,158 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/streaming_sequence.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::absl::StatusCode;
+using ::tensorflow_federated::testing::SequenceV;
+using ::tensorflow_federated::testing::SequenceValueToList;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::SizeIs;
+
+// Returns the scalar `int64_t` elements of `chunk`.
+std::vector<int64_t> Int64Elements(const ElementChunk& chunk) {
+  std::vector<int64_t> elements;
+  for (const std::vector<tensorflow::Tensor>& element : chunk) {
+    EXPECT_THAT(element, SizeIs(1));
+    elements.push_back(element[0].scalar<int64_t>()());
+  }
+  return elements;
+}
+
+StreamingSequenceOptions Options(int32_t chunk_size,
+                                 int32_t max_buffered_chunks = 2) {
+  StreamingSequenceOptions options;
+  options.chunk_size = chunk_size;
+  options.max_buffered_chunks = max_buffered_chunks;
+  return options;
+}
+
+ElementChunk Int64Range(int64_t stop) {
+  ElementChunk elements;
+  for (int64_t i = 0; i < stop; ++i) {
+    elements.push_back({tensorflow::Tensor(i)});
+  }
+  return elements;
+}
+
+// A source which fails after producing `num_elements` elements.
+class FailingElementSource : public SequenceElementSource {
+ public:
+  explicit FailingElementSource(int64_t num_elements)
+      : source_(CreateTensorStructuresElementSource(Int64Range(num_elements))) {
+  }
+
+  absl::StatusOr<ElementChunk> ReadChunk(int32_t max_elements) final {
+    ElementChunk chunk = TFF_TRY(source_->ReadChunk(max_elements));
+    if (chunk.empty()) {
+      return absl::UnavailableError("Source disconnected");
+    }
+    return chunk;
+  }
+
+ private:
+  std::unique_ptr<SequenceElementSource> source_;
+};
+
+TEST(StreamingSequenceTest, ReadsDatasetInChunks) {
+  v0::Value value_pb = SequenceV(0, 5, 1);
+  std::unique_ptr<SequenceElementSource> source =
+      TFF_ASSERT_OK(CreateDatasetElementSource(value_pb.sequence()));
+  StreamingSequence sequence(std::move(source), Options(2));
+  EXPECT_THAT(Int64Elements(TFF_ASSERT_OK(sequence.NextChunk())),
+              ::testing::ElementsAre(0, 1));
+  EXPECT_THAT(Int64Elements(TFF_ASSERT_OK(sequence.NextChunk())),
+              ::testing::ElementsAre(2, 3));
+  EXPECT_THAT(Int64Elements(TFF_ASSERT_OK(sequence.NextChunk())),
+              ::testing::ElementsAre(4));
+  EXPECT_THAT(TFF_ASSERT_OK(sequence.NextChunk()), IsEmpty());
+  EXPECT_THAT(TFF_ASSERT_OK(sequence.NextChunk()), IsEmpty());
+}
+
+TEST(StreamingSequenceTest, ReadsEmptySource) {
+  StreamingSequence sequence(CreateTensorStructuresElementSource({}));
+  EXPECT_THAT(TFF_ASSERT_OK(sequence.NextChunk()), IsEmpty());
+  EXPECT_FALSE(TFF_ASSERT_OK(sequence.NextChunkAsDataset()).has_value());
+}
+
+TEST(StreamingSequenceTest, ReturnsChunksReadBeforeError) {
+  StreamingSequence sequence(std::make_unique<FailingElementSource>(3),
+                             Options(2));
+  EXPECT_THAT(Int64Elements(TFF_ASSERT_OK(sequence.NextChunk())),
+              ::testing::ElementsAre(0, 1));
+  EXPECT_THAT(Int64Elements(TFF_ASSERT_OK(sequence.NextChunk())),
+              ::testing::ElementsAre(2));
+  EXPECT_THAT(sequence.NextChunk(),
+              StatusIs(StatusCode::kUnavailable, HasSubstr("disconnected")));
+}
+
+TEST(StreamingSequenceTest, DestroysPartiallyConsumedSequence) {
+  StreamingSequence sequence(
+      CreateTensorStructuresElementSource(Int64Range(100)),
+      Options(/*chunk_size=*/1, /*max_buffered_chunks=*/1));
+  EXPECT_THAT(Int64Elements(TFF_ASSERT_OK(sequence.NextChunk())),
+              ::testing::ElementsAre(0));
+}
+
+TEST(StreamingSequenceTest, ReturnsChunksAsDatasets) {
+  StreamingSequence sequence(
+      CreateTensorStructuresElementSource(Int64Range(3)), Options(2));
+  std::vector<int64_t> elements;
+  while (true) {
+    std::optional<tensorflow::Tensor> dataset =
+        TFF_ASSERT_OK(sequence.NextChunkAsDataset());
+    if (!dataset.has_value()) {
+      break;
+    }
+    const tensorflow::tstring& graph_def =
+        dataset->flat<tensorflow::tstring>()(0);
+    v0::Value::Sequence sequence_pb;
+    *sequence_pb.mutable_serialized_graph_def() =
+        std::string(graph_def.data(), graph_def.size());
+    ElementChunk chunk = TFF_ASSERT_OK(SequenceValueToList(sequence_pb));
+    EXPECT_THAT(chunk, ::testing::Not(IsEmpty()));
+    for (int64_t element : Int64Elements(chunk)) {
+      elements.push_back(element);
+    }
+  }
+  EXPECT_THAT(elements, ::testing::ElementsAre(0, 1, 2));
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
@@ -26,6 +26,7 @@ limitations under the License
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 
 namespace tensorflow_federated {
@@ -73,6 +74,56 @@ inline absl::StatusOr<std::vector<uint32_t>> TFNestTraversalOrderFromStruct(
   return traversal_order;
 }
 
+// The tf.nest flattening of a nested structure of tensors, computed once per
+// type so that values of the type can be flattened and unflattened without
+// walking the type again.
+struct TensorTraversalPlan {
+  // The index of this value among the elements of its parent structure.
+  uint32_t index = 0;
+  // The offset of the first tensor of this value in the flat tensors of its
+  // parent structure.
+  uint32_t offset = 0;
+  // The number of tensors nested in this value.
+  uint32_t num_tensors = 0;
+  bool is_tensor = false;
+  // The plans of the elements of a structure, in traversal order.
+  std::vector<TensorTraversalPlan> elements;
+};
+
+// Computes the traversal plan of a nested structure of tensors, returning an
+// error status if a type other than tensor or structure is encountered.
+inline absl::StatusOr<TensorTraversalPlan> TensorTraversalPlanFromType(
+    const v0::Type& type) {
+  TensorTraversalPlan plan;
+  switch (type.type_case()) {
+    case v0::Type::kTensor: {
+      plan.num_tensors = 1;
+      plan.is_tensor = true;
+      return plan;
+    }
+    case v0::Type::kStruct: {
+      std::vector<uint32_t> traversal_order =
+          TFF_TRY(TFNestTraversalOrderFromStruct(type.struct_()));
+      plan.elements.reserve(traversal_order.size());
+      for (const uint32_t idx : traversal_order) {
+        TensorTraversalPlan element_plan = TFF_TRY(
+            TensorTraversalPlanFromType(type.struct_().element(idx).value()));
+        element_plan.index = idx;
+        element_plan.offset = plan.num_tensors;
+        plan.num_tensors += element_plan.num_tensors;
+        plan.elements.push_back(std::move(element_plan));
+      }
+      return plan;
+    }
+    default:
+      return absl::UnimplementedError(
+          absl::StrCat("Encountered unexpected type while planning the "
+                       "traversal of tensors: ",
+                       type.Utf8DebugString(),
+                       ". Only nested structures of tensors are supported."));
+  }
+}
+
 }  // namespace tensorflow_federated
 
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_STRUCT_TRAVERSAL_ORDER_H_
@@ -67,5 +67,40 @@ TEST(TFNestTraversalOrderFromStructTest, PartiallyNamedStructureErrs) {
       StatusIs(StatusCode::kInvalidArgument, HasSubstr("partially-named")));
 }
 
+TEST(TensorTraversalPlanFromTypeTest, PlansNestedStructureInKeySortedOrder) {
+  v0::Type tensor_type;
+  tensor_type.mutable_tensor()->set_dtype(v0::DataType::DT_FLOAT);
+  v0::Type struct_type;
+  v0::StructType::Element* b = struct_type.mutable_struct_()->add_element();
+  b->set_name("b");
+  *b->mutable_value()->mutable_struct_()->add_element()->mutable_value() =
+      tensor_type;
+  *b->mutable_value()->mutable_struct_()->add_element()->mutable_value() =
+      tensor_type;
+  v0::StructType::Element* a = struct_type.mutable_struct_()->add_element();
+  a->set_name("a");
+  *a->mutable_value() = tensor_type;
+  TFF_ASSERT_OK_AND_ASSIGN(TensorTraversalPlan plan,
+                           TensorTraversalPlanFromType(struct_type));
+  EXPECT_EQ(plan.num_tensors, 3);
+  ASSERT_EQ(plan.elements.size(), 2);
+  EXPECT_EQ(plan.elements[0].index, 1);
+  EXPECT_EQ(plan.elements[0].offset, 0);
+  EXPECT_TRUE(plan.elements[0].is_tensor);
+  EXPECT_EQ(plan.elements[1].index, 0);
+  EXPECT_EQ(plan.elements[1].offset, 1);
+  EXPECT_EQ(plan.elements[1].num_tensors, 2);
+  EXPECT_EQ(plan.elements[1].elements[1].offset, 1);
+}
+
+TEST(TensorTraversalPlanFromTypeTest, NonTensorTypeErrs) {
+  v0::Type struct_type;
+  struct_type.mutable_struct_()->add_element()->mutable_value()
+      ->mutable_sequence();
+  EXPECT_THAT(TensorTraversalPlanFromType(struct_type),
+              StatusIs(StatusCode::kUnimplemented,
+                       HasSubstr("Only nested structures of tensors")));
+}
+
 }  // namespace
 }  // namespace tensorflow_federated
@@ -15,29 +15,222 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
 
 namespace tensorflow_federated {
 
 namespace tf = ::tensorflow;
 
-absl::Status SerializeTensorValue(const tf::Tensor tensor,
-                                  v0::Value* value_pb) {
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+
+constexpr uint32_t kTensorContentTag = WireFormatLite::MakeTag(
+    tf::TensorProto::kTensorContentFieldNumber,
+    WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+
+// Returns whether the content of tensors of `dtype` can be sent as raw bytes in
+// the `tensor_content` field of their `TensorProto`.
+bool HasRawContent(tf::DataType dtype) {
+  return dtype != tf::DT_STRING && tf::DataTypeCanUseMemcpy(dtype);
+}
+
+// Splits the serialized `TensorProto` in `serialized` into the serialization
+// of all its fields but `tensor_content`, written to `header_out`, and the
+// bytes of `tensor_content`, which alias `serialized`.
+bool SplitTensorContent(absl::string_view serialized, std::string* header_out,
+                        absl::string_view* content_out, bool* has_content_out) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(serialized.data()), serialized.size());
+  google::protobuf::io::StringOutputStream header_stream(header_out);
+  google::protobuf::io::CodedOutputStream header_output(&header_stream);
+  *has_content_out = false;
+  while (uint32_t tag = input.ReadTag()) {
+    if (tag != kTensorContentTag) {
+      if (!WireFormatLite::SkipField(&input, tag, &header_output)) {
+        return false;
+      }
+      continue;
+    }
+    uint32_t size;
+    if (!input.ReadVarint32(&size)) {
+      return false;
+    }
+    const int offset = input.CurrentPosition();
+    if (!input.Skip(size)) {
+      return false;
+    }
+    *content_out = serialized.substr(offset, size);
+    *has_content_out = true;
+  }
+  return input.ConsumedEntireMessage();
+}
+
+// Record the sizes of serialized and deserialized tensors to the default
+// `MetricsRegistry`.
+void RecordSerializedBytes(const v0::Value& value_pb) {
+  static Counter* const counter = MetricsRegistry::Default().GetCounter(
+      "TensorSerialization::BytesSerialized");
+  if (MetricsEnabled()) {
+    counter->Increment(value_pb.tensor().value().size());
+  }
+}
+
+void RecordDeserializedBytes(const v0::Value& value_pb) {
+  static Counter* const counter = MetricsRegistry::Default().GetCounter(
+      "TensorSerialization::BytesDeserialized");
+  if (MetricsEnabled()) {
+    counter->Increment(value_pb.tensor().value().size());
+  }
+}
+
+void PackTensorValue(const tf::Tensor& tensor, v0::Value* value_pb) {
   tf::TensorProto tensor_proto;
   if (tensor.dtype() == tf::DT_STRING) {
     // For some reason, strings don't work with AsProtoTensorContent()?
     // >>> ValueError: cannot create an OBJECT array from memory buffer
     tensor.AsProtoField(&tensor_proto);
-  } else {
+    value_pb->mutable_tensor()->PackFrom(tensor_proto);
+    return;
+  }
+  if (!tf::DataTypeCanUseMemcpy(tensor.dtype())) {
     tensor.AsProtoTensorContent(&tensor_proto);
+    value_pb->mutable_tensor()->PackFrom(tensor_proto);
+    return;
   }
+  // Pack the `TensorProto` without its content, then append the
+  // `tensor_content` field straight from the tensor buffer, rather than
+  // copying it into the `TensorProto` first. The result is the same as
+  // packing the output of `AsProtoTensorContent`, since fields are serialized
+  // in the order of their numbers.
+  tensor_proto.set_dtype(tensor.dtype());
+  tensor.shape().AsProto(tensor_proto.mutable_tensor_shape());
   value_pb->mutable_tensor()->PackFrom(tensor_proto);
+  const absl::string_view content = tensor.tensor_data();
+  if (content.empty()) {
+    return;
+  }
+  std::string* serialized = value_pb->mutable_tensor()->mutable_value();
+  using ::google::protobuf::io::CodedOutputStream;
+  // The tag takes one byte, and the length at most ten.
+  uint8_t prefix[16];
+  uint8_t* prefix_end =
+      CodedOutputStream::WriteTagToArray(kTensorContentTag, prefix);
+  prefix_end =
+      CodedOutputStream::WriteVarint64ToArray(content.size(), prefix_end);
+  serialized->reserve(serialized->size() + (prefix_end - prefix) +
+                      content.size());
+  serialized->append(reinterpret_cast<const char*>(prefix),
+                     prefix_end - prefix);
+  serialized->append(content.data(), content.size());
+}
+
+// The tensors deserialized by `DeserializeSharedTensorValue`, keyed by the
+// fingerprint of their serialization.
+//
+// This class is thread safe.
+class SharedTensors {
+ public:
+  static SharedTensors& Default() {
+    static SharedTensors* const shared_tensors = new SharedTensors();
+    return *shared_tensors;
+  }
+
+  // Returns the tensor shared under `key`, or deserializes `value_pb` and
+  // shares it under `key` if there is none.
+  absl::StatusOr<tf::Tensor> LookupOrDeserialize(const std::string& key,
+                                                 const v0::Value& value_pb)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    {
+      absl::MutexLock lock(&mutex_);
+      auto it = tensors_.find(key);
+      if (it != tensors_.end()) {
+        RecordLookup(/*hit=*/true);
+        return it->second;
+      }
+    }
+    RecordLookup(/*hit=*/false);
+    // Deserialize without holding the lock. If another thread shared an
+    // identical tensor meanwhile, its tensor is returned instead.
+    tf::Tensor tensor = TFF_TRY(DeserializeTensorValue(value_pb));
+    absl::MutexLock lock(&mutex_);
+    auto [it, inserted] = tensors_.try_emplace(key, tensor);
+    if (inserted) {
+      size_bytes_ += tensor.TotalBytes();
+      MaybeRelease();
+    }
+    return it->second;
+  }
+
+ private:
+  SharedTensors() = default;
+
+  static void RecordLookup(bool hit) {
+    static Counter* const hits = MetricsRegistry::Default().GetCounter(
+        "TensorSerialization::SharedTensorHits");
+    static Counter* const misses = MetricsRegistry::Default().GetCounter(
+        "TensorSerialization::SharedTensorMisses");
+    if (MetricsEnabled()) {
+      (hit ? hits : misses)->Increment();
+    }
+  }
+
+  // Drops the tensors only referenced by this class whenever the tensors
+  // shared doubled in size, so that the memory held for tensors no longer in
+  // use is bounded by that of the tensors in use.
+  void MaybeRelease() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    if (size_bytes_ < 2 * size_bytes_after_release_) {
+      return;
+    }
+    for (auto it = tensors_.begin(); it != tensors_.end();) {
+      if (it->second.RefCountIsOne()) {
+        size_bytes_ -= it->second.TotalBytes();
+        tensors_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    size_bytes_after_release_ =
+        std::max<int64_t>(size_bytes_, kMinSharedTensorBytes);
+  }
+
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, tf::Tensor> tensors_ ABSL_GUARDED_BY(mutex_);
+  int64_t size_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  int64_t size_bytes_after_release_ ABSL_GUARDED_BY(mutex_) =
+      kMinSharedTensorBytes;
+};
+
+}  // namespace
+
+absl::Status SerializeTensorValue(const tf::Tensor tensor,
+                                  v0::Value* value_pb) {
+  PackTensorValue(tensor, value_pb);
+  RecordSerializedBytes(*value_pb);
   return absl::OkStatus();
 }
 
@@ -49,17 +242,56 @@ absl::StatusOr<tf::Tensor> DeserializeTensorValue(const v0::Value& value_pb) {
         "value_pb must have a `tensor` oneof field to be deserializable to a "
         "Tensor");
   }
+  RecordDeserializedBytes(value_pb);
+  // Parse everything but the raw `tensor_content`, which is copied once,
+  // straight into the buffer of the tensor, rather than into a `TensorProto`
+  // first. Any other encoding is parsed by `Tensor::FromProto`.
+  std::string header;
+  absl::string_view content;
+  bool has_content;
   tensorflow::TensorProto tensor_proto;
+  if (value_pb.tensor().Is<tf::TensorProto>() &&
+      SplitTensorContent(value_pb.tensor().value(), &header, &content,
+                         &has_content) &&
+      has_content && tensor_proto.ParseFromString(header) &&
+      HasRawContent(tensor_proto.dtype()) &&
+      tf::TensorShape::IsValid(tensor_proto.tensor_shape())) {
+    tensorflow::Tensor tensor(tensor_proto.dtype(),
+                              tf::TensorShape(tensor_proto.tensor_shape()));
+    if (tensor.TotalBytes() == content.size()) {
+      if (!content.empty()) {
+        std::memcpy(tensor.data(), content.data(), content.size());
+      }
+      return tensor;
+    }
+  }
+  tensor_proto.Clear();
   value_pb.tensor().UnpackTo(&tensor_proto);
   tensorflow::Tensor tensor;
-  if (!tensor.FromProto(tensor_proto)) {
-    LOG(ERROR) << "Failed to deserialize tensor value contents to tensor";
-    LOG(ERROR) << "Value proto: " << value_pb.ShortDebugString();
-    return absl::InvalidArgumentError(
-        "Seriailzed tensor Value proto could not be parsed into Tensor "
-        "object.");
+  if (tensor.FromProto(tensor_proto)) {
+    return tensor;
+  }
+  LOG(ERROR) << "Failed to deserialize tensor value contents to tensor";
+  LOG(ERROR) << "Value proto: " << value_pb.ShortDebugString();
+  return absl::InvalidArgumentError(
+      "Seriailzed tensor Value proto could not be parsed into Tensor "
+      "object.");
+}
+
+absl::StatusOr<tf::Tensor> DeserializeSharedTensorValue(
+    const v0::Value& value_pb) {
+  const std::string& serialized = value_pb.tensor().value();
+  if (!value_pb.has_tensor() || serialized.size() < kMinSharedTensorBytes) {
+    return DeserializeTensorValue(value_pb);
   }
-  return tensor;
+  const tf::Fprint128 fingerprint = tf::Fingerprint128(serialized);
+  // The type and size are part of the key, so that a fingerprint collision
+  // also needs values of the same kind and size.
+  const std::string key = absl::StrCat(
+      value_pb.tensor().type_url(), ":", serialized.size(), ":",
+      absl::Hex(fingerprint.high64, absl::kZeroPad16),
+      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+  return SharedTensors::Default().LookupOrDeserialize(key, value_pb);
 }
 
 }  // namespace tensorflow_federated
@@ -16,6 +16,8 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EXECUTOR_SERIALIZATION_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EXECUTOR_SERIALIZATION_H_
 
+#include <cstdint>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -31,6 +33,23 @@ absl::Status SerializeTensorValue(const tensorflow::Tensor tensor,
 absl::StatusOr<tensorflow::Tensor> DeserializeTensorValue(
     const v0::Value& value_pb);
 
+// Serialized tensors at least this large are shared by
+// `DeserializeSharedTensorValue`.
+inline constexpr int64_t kMinSharedTensorBytes = 4096;
+
+// Same as `DeserializeTensorValue`, but a tensor of at least
+// `kMinSharedTensorBytes` shares its buffer with the tensors deserialized
+// before from an identical value, across all callers in the process, while any
+// of them is alive. E.g. executors of different clients receiving the same
+// broadcast value hold a single copy of it. Identical values are detected by
+// fingerprint, which is not cryptographic.
+//
+// The buffer of a shared tensor must not be modified. Buffers no longer used
+// are released once the tensors deserialized since are as large as the
+// tensors still in use.
+absl::StatusOr<tensorflow::Tensor> DeserializeSharedTensorValue(
+    const v0::Value& value_pb);
+
 }  // namespace tensorflow_federated
 
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_EXECUTOR_SERIALIZATION_H_
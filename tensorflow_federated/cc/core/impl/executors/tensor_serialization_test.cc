@@ -0,0 +1,143 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
+
+#include <cstdint>
+#include <string>
+
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+TEST(TensorSerializationTest, SerializeMatchesTensorContentProto) {
+  tensorflow::Tensor tensor = tensorflow::test::AsTensor<float>(
+      {1.0, 2.0, 3.0, 4.0, 5.0, 6.0}, tensorflow::TensorShape({2, 3}));
+  v0::Value value_pb;
+  TFF_ASSERT_OK(SerializeTensorValue(tensor, &value_pb));
+
+  tensorflow::TensorProto tensor_proto;
+  tensor.AsProtoTensorContent(&tensor_proto);
+  v0::Value expected_value_pb;
+  expected_value_pb.mutable_tensor()->PackFrom(tensor_proto);
+  EXPECT_EQ(value_pb.tensor().type_url(),
+            expected_value_pb.tensor().type_url());
+  EXPECT_EQ(value_pb.tensor().value(), expected_value_pb.tensor().value());
+}
+
+TEST(TensorSerializationTest, RoundTripsNumericTensor) {
+  tensorflow::Tensor tensor = tensorflow::test::AsTensor<int32_t>(
+      {1, 2, 3, 4, 5, 6}, tensorflow::TensorShape({3, 2}));
+  v0::Value value_pb;
+  TFF_ASSERT_OK(SerializeTensorValue(tensor, &value_pb));
+  tensorflow::Tensor actual_tensor =
+      TFF_ASSERT_OK(DeserializeTensorValue(value_pb));
+  tensorflow::test::ExpectEqual(actual_tensor, tensor);
+}
+
+TEST(TensorSerializationTest, RoundTripsEmptyTensor) {
+  tensorflow::Tensor tensor(tensorflow::DT_FLOAT,
+                            tensorflow::TensorShape({0, 3}));
+  v0::Value value_pb;
+  TFF_ASSERT_OK(SerializeTensorValue(tensor, &value_pb));
+  tensorflow::Tensor actual_tensor =
+      TFF_ASSERT_OK(DeserializeTensorValue(value_pb));
+  tensorflow::test::ExpectEqual(actual_tensor, tensor);
+}
+
+TEST(TensorSerializationTest, RoundTripsStringTensor) {
+  tensorflow::Tensor tensor = tensorflow::test::AsTensor<tensorflow::tstring>(
+      {"a", "bc", "def"}, tensorflow::TensorShape({3}));
+  v0::Value value_pb;
+  TFF_ASSERT_OK(SerializeTensorValue(tensor, &value_pb));
+  tensorflow::Tensor actual_tensor =
+      TFF_ASSERT_OK(DeserializeTensorValue(value_pb));
+  tensorflow::test::ExpectEqual(actual_tensor, tensor);
+}
+
+TEST(TensorSerializationTest, DeserializesTensorProtoWithTypedFields) {
+  tensorflow::Tensor tensor = tensorflow::test::AsTensor<float>(
+      {1.0, 2.0, 3.0}, tensorflow::TensorShape({3}));
+  tensorflow::TensorProto tensor_proto;
+  tensor.AsProtoField(&tensor_proto);
+  v0::Value value_pb;
+  value_pb.mutable_tensor()->PackFrom(tensor_proto);
+  tensorflow::Tensor actual_tensor =
+      TFF_ASSERT_OK(DeserializeTensorValue(value_pb));
+  tensorflow::test::ExpectEqual(actual_tensor, tensor);
+}
+
+TEST(TensorSerializationTest, DeserializeFailsOnContentSizeMismatch) {
+  tensorflow::TensorProto tensor_proto;
+  tensor_proto.set_dtype(tensorflow::DT_INT32);
+  tensorflow::TensorShape({4}).AsProto(tensor_proto.mutable_tensor_shape());
+  tensor_proto.set_tensor_content(std::string(3, '\0'));
+  v0::Value value_pb;
+  value_pb.mutable_tensor()->PackFrom(tensor_proto);
+  EXPECT_THAT(DeserializeTensorValue(value_pb),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(TensorSerializationTest, DeserializeFailsOnNonTensorValue) {
+  v0::Value value_pb;
+  value_pb.mutable_struct_();
+  EXPECT_THAT(DeserializeTensorValue(value_pb),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(TensorSerializationTest, SharesBuffersOfLargeIdenticalTensors) {
+  tensorflow::Tensor tensor(tensorflow::DT_FLOAT,
+                            tensorflow::TensorShape({kMinSharedTensorBytes}));
+  tensor.flat<float>().setConstant(1.0);
+  v0::Value value_pb;
+  TFF_ASSERT_OK(SerializeTensorValue(tensor, &value_pb));
+  tensorflow::Tensor first =
+      TFF_ASSERT_OK(DeserializeSharedTensorValue(value_pb));
+  tensorflow::Tensor second =
+      TFF_ASSERT_OK(DeserializeSharedTensorValue(value_pb));
+  tensorflow::test::ExpectEqual(first, tensor);
+  EXPECT_TRUE(first.SharesBufferWith(second));
+
+  tensor.flat<float>().setConstant(2.0);
+  v0::Value other_value_pb;
+  TFF_ASSERT_OK(SerializeTensorValue(tensor, &other_value_pb));
+  tensorflow::Tensor other =
+      TFF_ASSERT_OK(DeserializeSharedTensorValue(other_value_pb));
+  tensorflow::test::ExpectEqual(other, tensor);
+  EXPECT_FALSE(other.SharesBufferWith(first));
+}
+
+TEST(TensorSerializationTest, DoesNotShareBuffersOfSmallTensors) {
+  v0::Value value_pb;
+  TFF_ASSERT_OK(
+      SerializeTensorValue(tensorflow::test::AsScalar<float>(1.0), &value_pb));
+  tensorflow::Tensor first =
+      TFF_ASSERT_OK(DeserializeSharedTensorValue(value_pb));
+  tensorflow::Tensor second =
+      TFF_ASSERT_OK(DeserializeSharedTensorValue(value_pb));
+  EXPECT_FALSE(first.SharesBufferWith(second));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
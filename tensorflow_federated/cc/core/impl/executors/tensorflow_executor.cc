@@ -16,20 +16,26 @@ limitations under the License
 #include "tensorflow_federated/cc/core/impl/executors/tensorflow_executor.h"
 
 #include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
-#include <future>  // NOLINT
+#include <list>
 #include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
+#include <future>  // NOLINT
 #include <thread>  // NOLINT
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "google/protobuf/any.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/log/log.h"
 #include "absl/meta/type_traits.h"
 #include "absl/status/status.h"
@@ -39,24 +45,33 @@ limitations under the License
 #include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/function.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
 #include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_def.pb.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow/core/platform/macros.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/public/session.h"
+#include "tensorflow_federated/cc/core/impl/executors/batched_session_runner.h"
+#include "tensorflow_federated/cc/core/impl/executors/concurrency_limiter.h"
+#include "tensorflow_federated/cc/core/impl/executors/dataset_conversions.h"
 #include "tensorflow_federated/cc/core/impl/executors/dataset_from_tensor_structures.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
 #include "tensorflow_federated/cc/core/impl/executors/session_provider.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensorflow_utils.h"
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_spiller.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
 #include "tensorflow_federated/proto/v0/executor.pb.h"
 
@@ -138,6 +153,48 @@ void AddDatasetToGraphOp(tensorflow::GraphDef& graphdef_pb,
       true);
 }
 
+// A sequence parameter binding to wrap in a `DatasetFromGraph` op.
+struct SequenceParameterRewrite {
+  // The name of the variant placeholder, which becomes the placeholder of the
+  // serialized GraphDef bytes.
+  std::string dataset_placeholder_node_name;
+  NamesForBindingRewrite graph_names;
+};
+
+// Appends the sequence bindings of `binding` to `rewrites`, and updates them to
+// bind the serialized GraphDef bytes to the placeholder that was originally
+// created for the variant tensor.
+void CollectSequenceParameters(
+    v0::TensorFlow::Binding& binding, std::string_view prefix,
+    std::vector<SequenceParameterRewrite>& rewrites) {
+  switch (binding.binding_case()) {
+    case v0::TensorFlow::Binding::kSequence: {
+      SequenceParameterRewrite rewrite;
+      rewrite.dataset_placeholder_node_name =
+          binding.sequence().variant_tensor_name();
+      rewrite.graph_names = GetVariantTensorNodeNameAndReplacement(
+          rewrite.dataset_placeholder_node_name, kDatasetFromGraphOp, prefix);
+      binding.mutable_sequence()->set_graph_def_tensor_name(
+          rewrite.dataset_placeholder_node_name);
+      rewrites.push_back(std::move(rewrite));
+      return;
+    }
+    case v0::TensorFlow::Binding::kStruct: {
+      for (int i = 0; i < binding.struct_().element_size(); ++i) {
+        auto& member = *binding.mutable_struct_()->mutable_element(i);
+        CollectSequenceParameters(member, absl::StrCat(prefix, "/", i),
+                                  rewrites);
+      }
+      return;
+    }
+    default: {
+      // Do nothing for non-Sequence values. This typically should be
+      // a Tensor value.
+      return;
+    }
+  }
+}
+
 // Given a GraphDef and a tensor binding, replace sequence bindings that use the
 // variant_tensor_name binding with a new binding that uses `DatasetFromGraph`
 // ops to deserialize a serialized GraphDef proto into the Dataset's variant
@@ -168,71 +225,61 @@ void AddDatasetToGraphOp(tensorflow::GraphDef& graphdef_pb,
 // This is used on parameter bindings of `v0::TensorFlow` computations. This is
 // the reverse of `AddSerializationOpsForResults`, which is used on the result
 // bindings of the function.
+//
+// Maps the name each rewritten binding feeds to the name of the variant tensor
+// output by its `DatasetFromGraph` op in `dataset_tensor_names`, so that
+// datasets which are already variant tensors can be fed past the op.
 absl::Status AddDeserializationOpsForParameters(
     tensorflow::GraphDef& graphdef_pb, v0::TensorFlow::Binding& binding,
-    std::string_view prefix = "root") {
-  switch (binding.binding_case()) {
-    case v0::TensorFlow::Binding::kSequence: {
-      // Get a copy of the name of the placeholder we're operating on. We're
-      // going to clear/reset the binding and  then rebuild the it but re-use
-      // the placeholder op.
-      const std::string dataset_placeholder_node_name =
-          binding.sequence().variant_tensor_name();
-      binding.mutable_sequence()->Clear();
-      auto graph_names = GetVariantTensorNodeNameAndReplacement(
-          dataset_placeholder_node_name, kDatasetFromGraphOp, prefix);
-      for (tensorflow::NodeDef& node_pb : *graphdef_pb.mutable_node()) {
-        // Change the placeholder op from variant to string, this will now
-        // be a placeholder for a serialized graphdef bytes.
-        if (node_pb.name() == graph_names.variant_node_name) {
-          if (node_pb.op() != kPlaceholderOp) {
-            return absl::InvalidArgumentError(absl::StrCat(
-                "Computation used a variant tensor binding for a sequence that "
-                "was not a Placeholder. Need to wrap this binding, but unknown "
-                "how to proceed with non-Placeholder nodes. Got op [",
-                node_pb.op(), "] from node [", node_pb.name(), "]"));
-          }
-          (*node_pb.mutable_attr())["dtype"].set_type(tensorflow::DT_STRING);
-          continue;
-        }
-        // Update any op that depended on the placeholder to depend on the new
-        // DatasetFromGraph op that we will add at the end.
-        std::transform(
-            node_pb.mutable_input()->begin(), node_pb.mutable_input()->end(),
-            node_pb.mutable_input()->begin(),
-            [&dataset_placeholder_node_name,
-             &graph_names](const std::string& input_name) -> std::string {
-              if (input_name == dataset_placeholder_node_name) {
-                return graph_names.graph_def_tensor_name;
-              } else if (input_name == graph_names.variant_node_name) {
-                return graph_names.graph_def_node_name;
-              } else {
-                return input_name;
-              }
-            });
+    absl::flat_hash_map<std::string, std::string>& dataset_tensor_names) {
+  std::vector<SequenceParameterRewrite> rewrites;
+  CollectSequenceParameters(binding, "root", rewrites);
+  if (rewrites.empty()) {
+    return absl::OkStatus();
+  }
+  // Rewrite all sequence bindings in a single pass over the graph, which is
+  // large compared to the number of bindings.
+  absl::flat_hash_set<std::string_view> variant_node_names;
+  absl::flat_hash_map<std::string_view, std::string_view> input_replacements;
+  for (const SequenceParameterRewrite& rewrite : rewrites) {
+    const NamesForBindingRewrite& graph_names = rewrite.graph_names;
+    variant_node_names.insert(graph_names.variant_node_name);
+    // Tensor names take precedence over node names if they are equal.
+    input_replacements.emplace(rewrite.dataset_placeholder_node_name,
+                               graph_names.graph_def_tensor_name);
+    input_replacements.emplace(graph_names.variant_node_name,
+                               graph_names.graph_def_node_name);
+  }
+  for (tensorflow::NodeDef& node_pb : *graphdef_pb.mutable_node()) {
+    // Change the placeholder op from variant to string, this will now
+    // be a placeholder for a serialized graphdef bytes.
+    if (variant_node_names.contains(node_pb.name())) {
+      if (node_pb.op() != kPlaceholderOp) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Computation used a variant tensor binding for a sequence that "
+            "was not a Placeholder. Need to wrap this binding, but unknown "
+            "how to proceed with non-Placeholder nodes. Got op [",
+            node_pb.op(), "] from node [", node_pb.name(), "]"));
       }
-      AddDatasetFromGraphOp(graphdef_pb, graph_names,
-                            dataset_placeholder_node_name);
-      // Update the binding to inform the new format, but continue to use the
-      // placeholder node that was originally created.
-      binding.mutable_sequence()->set_graph_def_tensor_name(
-          dataset_placeholder_node_name);
-      return absl::OkStatus();
+      (*node_pb.mutable_attr())["dtype"].set_type(tensorflow::DT_STRING);
+      continue;
     }
-    case v0::TensorFlow::Binding::kStruct: {
-      for (int i = 0; i < binding.struct_().element_size(); ++i) {
-        auto& member = *binding.mutable_struct_()->mutable_element(i);
-        TFF_TRY(AddDeserializationOpsForParameters(
-            graphdef_pb, member, absl::StrCat(prefix, "/", i)));
+    // Update any op that depended on the placeholder to depend on the new
+    // DatasetFromGraph op that we will add at the end.
+    for (std::string& input_name : *node_pb.mutable_input()) {
+      auto replacement = input_replacements.find(input_name);
+      if (replacement != input_replacements.end()) {
+        input_name = std::string(replacement->second);
       }
-      return absl::OkStatus();
-    }
-    default: {
-      // Do nothing for non-Sequence values. This typically should be
-      // a Tensor value.
-      return absl::OkStatus();
     }
   }
+  for (const SequenceParameterRewrite& rewrite : rewrites) {
+    AddDatasetFromGraphOp(graphdef_pb, rewrite.graph_names,
+                          rewrite.dataset_placeholder_node_name);
+    dataset_tensor_names.emplace(rewrite.dataset_placeholder_node_name,
+                                 rewrite.graph_names.graph_def_tensor_name);
+  }
+  return absl::OkStatus();
 }
 
 // Given a GraphDef and a tensor binding, replace sequences that use the
@@ -308,16 +355,51 @@ absl::Status AddSerializationOpsForResults(tensorflow::GraphDef& graphdef_pb,
   }
 }
 
-absl::Status AddDatasetSerializationToSequenceBindings(
-    tensorflow::GraphDef& graphdef_pb,
-    std::optional<v0::TensorFlow::Binding>& parameter_binding,
-    v0::TensorFlow::Binding& result_binding) {
-  if (parameter_binding != std::nullopt) {
-    TFF_TRY(AddDeserializationOpsForParameters(graphdef_pb,
-                                               parameter_binding.value()));
+// Returns whether none of the ops of `graphdef_pb`, including those of its
+// functions, are stateful, so that running parts of it separately yields the
+// same results as running it at once.
+bool IsStateless(const tensorflow::GraphDef& graphdef_pb) {
+  absl::flat_hash_set<std::string> function_names;
+  for (const tensorflow::FunctionDef& function_pb :
+       graphdef_pb.library().function()) {
+    function_names.insert(function_pb.signature().name());
   }
-  TFF_TRY(AddSerializationOpsForResults(graphdef_pb, result_binding));
-  return absl::OkStatus();
+  auto is_stateless = [&function_names](const tensorflow::NodeDef& node_pb) {
+    if (function_names.contains(node_pb.op())) {
+      return true;
+    }
+    const tensorflow::OpDef* op_def = nullptr;
+    return tensorflow::OpRegistry::Global()
+               ->LookUpOpDef(node_pb.op(), &op_def)
+               .ok() &&
+           !op_def->is_stateful();
+  };
+  for (const tensorflow::NodeDef& node_pb : graphdef_pb.node()) {
+    if (!is_stateless(node_pb)) {
+      return false;
+    }
+  }
+  for (const tensorflow::FunctionDef& function_pb :
+       graphdef_pb.library().function()) {
+    for (const tensorflow::NodeDef& node_pb : function_pb.node_def()) {
+      if (!is_stateless(node_pb)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Returns the number of tensors bound by `binding`.
+size_t NumTensors(const v0::TensorFlow::Binding& binding) {
+  if (!binding.has_struct_()) {
+    return 1;
+  }
+  size_t num_tensors = 0;
+  for (const v0::TensorFlow::Binding& element : binding.struct_().element()) {
+    num_tensors += NumTensors(element);
+  }
+  return num_tensors;
 }
 
 // A `Computation` is a TensorFlow function consisting of a graph to execute
@@ -325,7 +407,10 @@ absl::Status AddDatasetSerializationToSequenceBindings(
 class Computation {
  public:
   static absl::StatusOr<std::shared_ptr<Computation>> FromProto(
-      const v0::TensorFlow& comp_pb) {
+      const v0::TensorFlow& comp_pb,
+      SessionPoolOptions session_pool_options = SessionPoolOptions(),
+      int32_t max_call_batch_size = 1,
+      std::shared_ptr<ConcurrencyLimiter> limiter = nullptr) {
     tensorflow::GraphDef graphdef_pb;
     if (!comp_pb.graph_def().UnpackTo(&graphdef_pb)) {
       return absl::InternalError(ERR_LOG("Could not unpack graphdef proto"));
@@ -335,27 +420,113 @@ class Computation {
       parameter_shape = comp_pb.parameter();
     }
     v0::TensorFlow::Binding result_shape = comp_pb.result();
-    TFF_TRY(AddDatasetSerializationToSequenceBindings(
-        graphdef_pb, parameter_shape, result_shape));
+    absl::flat_hash_map<std::string, std::string> dataset_tensor_names;
+    if (parameter_shape.has_value()) {
+      TFF_TRY(AddDeserializationOpsForParameters(
+          graphdef_pb, *parameter_shape, dataset_tensor_names));
+    }
+    // The datasets returned by stateless graphs are not tied to the session
+    // which created them, so they are kept as variant tensors and fed as such
+    // to later calls, and only serialized once materialized. Otherwise, e.g.
+    // if they refer to resources cleared when the session is returned, or if
+    // calls may be batched, they are serialized by the graph.
+    const bool keeps_dataset_variants =
+        comp_pb.initialize_op().empty() &&
+        !(max_call_batch_size > 1 &&
+          BatchedSessionRunner::CanBatch(graphdef_pb)) &&
+        IsStateless(graphdef_pb);
+    if (!keeps_dataset_variants) {
+      TFF_TRY(AddSerializationOpsForResults(graphdef_pb, result_shape));
+    }
     std::vector<std::string> output_tensor_names;
     TFF_TRY(TensorNamesFromBinding(result_shape, &output_tensor_names));
+    const int64_t size_bytes = graphdef_pb.ByteSizeLong();
+    std::unique_ptr<BatchedSessionRunner> batched_runner;
+    if (max_call_batch_size > 1 && comp_pb.initialize_op().empty() &&
+        !output_tensor_names.empty() &&
+        BatchedSessionRunner::CanBatch(graphdef_pb)) {
+      batched_runner = std::make_unique<BatchedSessionRunner>(
+          graphdef_pb, output_tensor_names, max_call_batch_size);
+    }
+    const bool defers_calls = batched_runner == nullptr &&
+                              comp_pb.initialize_op().empty() &&
+                              comp_pb.result().has_struct_() &&
+                              !output_tensor_names.empty() &&
+                              IsStateless(graphdef_pb);
     return std::make_shared<Computation>(
         std::move(graphdef_pb), comp_pb.initialize_op(),
         std::move(parameter_shape), comp_pb.result(),
-        std::move(output_tensor_names));
+        std::move(output_tensor_names), std::move(dataset_tensor_names),
+        size_bytes, session_pool_options, std::move(batched_runner),
+        defers_calls, std::move(limiter));
   }
 
   absl::StatusOr<ExecutorValue> Call(std::optional<ExecutorValue> arg);
 
+  // Calls the computation with each of `args`, which must be batched, in as
+  // few session runs as the maximum batch size allows. Returns the result of
+  // each call, or the error of its argument.
+  std::vector<absl::StatusOr<ExecutorValue>> CallBatch(
+      std::vector<absl::StatusOr<ExecutorValue>> args);
+
+  // Whether concurrent calls are coalesced into batched session runs.
+  bool batches_calls() const { return batched_runner_ != nullptr; }
+
+  // Whether the session runs of calls are deferred until their results are
+  // needed, see `DeferredCall`. This requires a stateless graph with a struct
+  // result, so that parts of the result can be fetched by separate runs.
+  bool defers_calls() const { return defers_calls_; }
+
+  // Binds `arg` and returns a deferred call of the computation with it.
+  // Requires `defers_calls()`.
+  static absl::StatusOr<ExecutorValue> DeferCall(
+      const std::shared_ptr<Computation>& computation,
+      std::optional<ExecutorValue> arg);
+
+  // Runs the computation on `inputs`, fetching only the output tensors at
+  // `output_indices`, so that TensorFlow prunes the subgraphs computing the
+  // others.
+  absl::StatusOr<std::vector<tensorflow::Tensor>> RunFetches(
+      const std::vector<std::pair<std::string, tensorflow::Tensor>>& inputs,
+      absl::Span<const size_t> output_indices);
+
   Computation(tensorflow::GraphDef graph, std::string init_op,
               std::optional<v0::TensorFlow::Binding> parameter_shape,
               v0::TensorFlow::Binding output_shape,
-              std::vector<std::string> output_tensor_names)
-      : session_provider_(std::move(graph)),
+              std::vector<std::string> output_tensor_names,
+              absl::flat_hash_map<std::string, std::string>
+                  dataset_tensor_names,
+              int64_t size_bytes, SessionPoolOptions session_pool_options,
+              std::unique_ptr<BatchedSessionRunner> batched_runner,
+              bool defers_calls, std::shared_ptr<ConcurrencyLimiter> limiter)
+      : session_provider_(std::move(graph), session_pool_options),
         init_op_(std::move(init_op)),
         parameter_shape_(std::move(parameter_shape)),
         output_shape_(std::move(output_shape)),
-        output_tensor_names_(std::move(output_tensor_names)) {}
+        output_tensor_names_(std::move(output_tensor_names)),
+        dataset_tensor_names_(std::move(dataset_tensor_names)),
+        size_bytes_(size_bytes),
+        batched_runner_(std::move(batched_runner)),
+        defers_calls_(defers_calls),
+        limiter_(std::move(limiter)) {}
+
+  // The serialized size of the graph of this computation, used to bound the
+  // memory held by cached computations.
+  int64_t size_bytes() const { return size_bytes_; }
+
+  // Creates the minimum number of sessions of the pool ahead of their use.
+  absl::Status Prewarm() { return session_provider_.Prewarm(); }
+
+  // Creates the sessions of `Prewarm`, and at least the one the first call
+  // runs in, unless calls are batched into sessions of their own.
+  absl::Status WarmUp() {
+    TFF_TRY(Prewarm());
+    if (batched_runner_ == nullptr) {
+      // The borrowed session is returned to the pool right away.
+      TFF_TRY(session_provider_.BorrowSession());
+    }
+    return absl::OkStatus();
+  }
 
   std::string DebugString() const {
     return absl::StrCat("(",
@@ -366,6 +537,12 @@ class Computation {
   }
 
  private:
+  // Binds `arg` to the parameter of the computation, appending its tensors to
+  // `inputs`.
+  absl::Status BindArgument(
+      const std::optional<ExecutorValue>& arg,
+      std::vector<std::pair<std::string, tensorflow::Tensor>>* inputs);
+
   static absl::Status TensorNamesFromBinding(
       const v0::TensorFlow::Binding& binding,
       std::vector<std::string>* tensor_names) {
@@ -381,7 +558,12 @@ class Computation {
         return absl::OkStatus();
       }
       case v0::TensorFlow::Binding::kSequence: {
-        tensor_names->push_back(binding.sequence().graph_def_tensor_name());
+        const v0::TensorFlow::SequenceBinding& sequence = binding.sequence();
+        tensor_names->push_back(
+            sequence.binding_case() ==
+                    v0::TensorFlow::SequenceBinding::kVariantTensorName
+                ? sequence.variant_tensor_name()
+                : sequence.graph_def_tensor_name());
         return absl::OkStatus();
       }
       default: {
@@ -402,9 +584,116 @@ class Computation {
   std::optional<v0::TensorFlow::Binding> parameter_shape_;
   v0::TensorFlow::Binding output_shape_;
   std::vector<std::string> output_tensor_names_;
+  // Maps the names fed by the sequence parameters to the variant tensors
+  // output by their `DatasetFromGraph` ops, see `BindArgument`.
+  absl::flat_hash_map<std::string, std::string> dataset_tensor_names_;
+  int64_t size_bytes_;
+  // Coalesces concurrent calls into batched session runs, if call batching is
+  // enabled and the graph can be replicated.
+  std::unique_ptr<BatchedSessionRunner> batched_runner_;
+  const bool defers_calls_;
+  // If not null, bounds the concurrent session runs of the computations of the
+  // executor. Batched runs wait for each other to coalesce, and are not
+  // bounded.
+  const std::shared_ptr<ConcurrencyLimiter> limiter_;
+  // The latency of the session runs of this computation which are bounded by
+  // `limiter_`.
+  LatencyBaseline latency_baseline_;
 };
 
-// A tensor that holds sequence data.
+// A bounded cache of computations, which evicts the least recently used
+// computations once the total size of the cached computations exceeds
+// `capacity_bytes`. Evicted computations stay alive while values refer to
+// them.
+//
+// This class is thread safe.
+class ComputationCache {
+ public:
+  explicit ComputationCache(int64_t capacity_bytes)
+      : capacity_bytes_(capacity_bytes) {}
+
+  // Returns the computation cached under `key`, or nullptr if there is none.
+  std::shared_ptr<Computation> Lookup(std::string_view key)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->computation;
+  }
+
+  // Caches `computation` under `key`, unless it alone is larger than the
+  // capacity of the cache. Returns the computation cached under `key`, which
+  // is an earlier one if another thread inserted it first.
+  std::shared_ptr<Computation> Insert(std::string key,
+                                      std::shared_ptr<Computation> computation)
+      ABSL_LOCKS_EXCLUDED(mutex_) {
+    const int64_t size_bytes = computation->size_bytes();
+    if (size_bytes > capacity_bytes_) {
+      return computation;
+    }
+    absl::MutexLock lock(&mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return it->second->computation;
+    }
+    while (size_bytes_ + size_bytes > capacity_bytes_) {
+      const Entry& evicted = entries_.back();
+      VLOG(2) << "Evicting cached computation: " << evicted.key;
+      size_bytes_ -= evicted.size_bytes;
+      index_.erase(evicted.key);
+      entries_.pop_back();
+    }
+    entries_.push_front(Entry{key, computation, size_bytes});
+    index_.emplace(std::move(key), entries_.begin());
+    size_bytes_ += size_bytes;
+    return computation;
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<Computation> computation;
+    int64_t size_bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  const int64_t capacity_bytes_;
+  absl::Mutex mutex_;
+  // Ordered from the most to the least recently used entry.
+  EntryList entries_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, EntryList::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t size_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Returns the key under which `comp_pb` is cached: its compiler generated
+// cache key if it has one, otherwise a fingerprint of its graph and bindings.
+std::string ComputationCacheKey(const v0::TensorFlow& comp_pb) {
+  if (comp_pb.has_cache_key() && comp_pb.cache_key().id() != 0) {
+    return absl::StrCat("id:", comp_pb.cache_key().id());
+  }
+  std::string serialized;
+  {
+    google::protobuf::io::StringOutputStream stream(&serialized);
+    google::protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.SetSerializationDeterministic(true);
+    comp_pb.SerializeToCodedStream(&coded_stream);
+  }
+  const tensorflow::Fprint128 fingerprint =
+      tensorflow::Fingerprint128(serialized);
+  return absl::StrCat("fingerprint:",
+                      absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+// A tensor that holds sequence data: either a scalar string tensor holding the
+// serialized GraphDef of a dataset, or a scalar variant tensor holding the
+// dataset itself, as returned by the computations which keep their dataset
+// results in-process.
 class SequenceTensor {
  public:
   explicit SequenceTensor(tensorflow::Tensor&& tensor)
@@ -437,11 +726,70 @@ std::string_view IntrinsicToUri(Intrinsic intrinsic) {
   }
 }
 
+// The call of a computation whose session run is deferred until its result, or
+// a part of it, is needed: materialized, or passed to another call. Only the
+// output tensors of the parts needed by then, and of those selected before,
+// are fetched, so that TensorFlow prunes the subgraphs computing the others,
+// e.g. the metrics of a training step when only its model is used. Parts
+// needed later are fetched by another run, which yields the same results
+// since the computation is stateless.
+//
+// This class is thread safe.
+class DeferredCall {
+ public:
+  DeferredCall(std::shared_ptr<Computation> computation,
+               std::vector<std::pair<std::string, tensorflow::Tensor>> inputs,
+               size_t num_outputs)
+      : computation_(std::move(computation)),
+        inputs_(std::move(inputs)),
+        selected_(num_outputs, false),
+        outputs_(num_outputs) {}
+
+  // Marks the output tensors `[begin, end)` as selected, so that they are
+  // fetched by the next run.
+  void Select(size_t begin, size_t end) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    std::fill(selected_.begin() + begin, selected_.begin() + end, true);
+  }
+
+  // Returns the output tensors `[begin, end)`, running the computation to
+  // fetch those of them, and of the selected ones, which are not fetched yet.
+  absl::StatusOr<std::vector<tensorflow::Tensor>> Fetch(size_t begin,
+                                                        size_t end)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  const std::shared_ptr<Computation> computation_;
+  const std::vector<std::pair<std::string, tensorflow::Tensor>> inputs_;
+  absl::Mutex mutex_;
+  std::vector<bool> selected_ ABSL_GUARDED_BY(mutex_);
+  std::vector<std::optional<tensorflow::Tensor>> outputs_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// The output tensors `[begin, end)` of a `DeferredCall`, which make up the
+// value bound by `binding` in the result of the computation.
+struct DeferredOutputs {
+  std::shared_ptr<DeferredCall> call;
+  // Points into the result binding of the computation, which `call` keeps
+  // alive.
+  const v0::TensorFlow::Binding* binding;
+  size_t begin;
+  size_t end;
+};
+
 // Representation for values inside the TensorFlow Executor.
 class ExecutorValue {
  public:
   // Whether a given `ExecutorValue` is a structure or a single tensor.
-  enum class ValueType { TENSOR, STRUCT, COMPUTATION, SEQUENCE, INTRINSIC };
+  enum class ValueType {
+    TENSOR,
+    STRUCT,
+    COMPUTATION,
+    SEQUENCE,
+    INTRINSIC,
+    DEFERRED
+  };
 
   // Constructs an `ExecutorValue` from a `tensorflow::Tensor`.
   // NOTE: `tensorflow::Tensor` is internally refcounted, so copies of it are
@@ -463,6 +811,10 @@ class ExecutorValue {
   // TensorFlowExecutor.
   explicit ExecutorValue(Intrinsic intrinsic) : value_(intrinsic) {}
 
+  // Constructs an `ExecutorValue` for outputs of a call which is not run yet.
+  explicit ExecutorValue(DeferredOutputs deferred)
+      : value_(std::move(deferred)) {}
+
   // Copy constructor.
   //
   // Copies are shallow: we only have to bump the reference count for either
@@ -487,6 +839,8 @@ class ExecutorValue {
       return ValueType::SEQUENCE;
     } else if (std::holds_alternative<Intrinsic>(value_)) {
       return ValueType::INTRINSIC;
+    } else if (std::holds_alternative<DeferredOutputs>(value_)) {
+      return ValueType::DEFERRED;
     } else {
       return ValueType::STRUCT;
     }
@@ -514,6 +868,10 @@ class ExecutorValue {
 
   Intrinsic intrinsic() const { return std::get<Intrinsic>(value_); }
 
+  const DeferredOutputs& deferred() const {
+    return std::get<DeferredOutputs>(value_);
+  }
+
   absl::Status Bind(
       const v0::TensorFlow::Binding& shape,
       std::vector<std::pair<std::string, tensorflow::Tensor>>* bindings) const {
@@ -559,6 +917,10 @@ class ExecutorValue {
             " as argument to a TensorFlow computation. This is not "
             "supported."));
       }
+      case ValueType::DEFERRED: {
+        return absl::InternalError(
+            "Attempted to bind the result of a call which was not run.");
+      }
       default:
         return absl::InvalidArgumentError(
             absl::StrCat("Unable to bind unknown value type: ", type()));
@@ -642,6 +1004,9 @@ class ExecutorValue {
                           tensor().shape().DebugString(), "*");
     } else if (std::holds_alternative<Intrinsic>(value_)) {
       return absl::StrCat("Intrinsic(\"", IntrinsicToUri(intrinsic()), "\")");
+    } else if (std::holds_alternative<DeferredOutputs>(value_)) {
+      return absl::StrCat("Deferred(", deferred().binding->ShortDebugString(),
+                          ")");
     } else {
       auto element_formatter = [](std::string* out, const ExecutorValue& v) {
         absl::StrAppend(out, v.DebugString());
@@ -655,7 +1020,8 @@ class ExecutorValue {
   ExecutorValue() = delete;
 
   std::variant<tensorflow::Tensor, SequenceTensor, std::shared_ptr<Computation>,
-               std::shared_ptr<std::vector<ExecutorValue>>, Intrinsic>
+               std::shared_ptr<std::vector<ExecutorValue>>, Intrinsic,
+               DeferredOutputs>
       value_;
 
   static absl::Status BindKindMismatch(const std::string_view value_kind,
@@ -666,15 +1032,127 @@ class ExecutorValue {
   }
 };
 
-absl::StatusOr<ExecutorValue> Computation::Call(
-    std::optional<ExecutorValue> arg) {
-  // Skip everything if there are no outputs.
-  // If `output_tensor_names` is empty, TF raises an error, so we must bypass it
-  // entirely.
-  if (output_tensor_names_.empty()) {
-    return ExecutorValue::FromTensorsAndBindingStructure(output_shape_, {});
+absl::StatusOr<std::vector<tensorflow::Tensor>> Computation::RunFetches(
+    const std::vector<std::pair<std::string, tensorflow::Tensor>>& inputs,
+    absl::Span<const size_t> output_indices) {
+  std::vector<std::string> output_tensor_names;
+  output_tensor_names.reserve(output_indices.size());
+  for (size_t index : output_indices) {
+    output_tensor_names.push_back(output_tensor_names_[index]);
   }
   auto session = TFF_TRY(this->session_provider_.BorrowSession());
+  ConcurrencyPermit permit(limiter_.get(), latency_baseline_);
+  std::vector<tensorflow::Tensor> outputs;
+  absl::Status status =
+      session.RunCallable(inputs, output_tensor_names,
+                          /*target_tensor_names=*/{}, &outputs);
+  if (!status.ok()) {
+    return absl::InternalError(
+        ERR_LOG(absl::StrCat("Failed to run computation: ", status.message())));
+  }
+  return outputs;
+}
+
+absl::StatusOr<std::vector<tensorflow::Tensor>> DeferredCall::Fetch(
+    size_t begin, size_t end) {
+  absl::MutexLock lock(&mutex_);
+  std::vector<size_t> missing;
+  for (size_t i = 0; i < outputs_.size(); ++i) {
+    if (!outputs_[i].has_value() && (selected_[i] || (begin <= i && i < end))) {
+      missing.push_back(i);
+    }
+  }
+  if (!missing.empty()) {
+    std::vector<tensorflow::Tensor> fetched =
+        TFF_TRY(computation_->RunFetches(inputs_, missing));
+    for (size_t i = 0; i < missing.size(); ++i) {
+      outputs_[missing[i]] = std::move(fetched[i]);
+    }
+  }
+  std::vector<tensorflow::Tensor> tensors;
+  tensors.reserve(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    tensors.push_back(*outputs_[i]);
+  }
+  return tensors;
+}
+
+// Returns the outputs of `deferred` selected by `index`, or an error if they
+// are not a struct with such an element.
+absl::StatusOr<DeferredOutputs> SelectDeferred(const DeferredOutputs& deferred,
+                                               uint32_t index) {
+  if (!deferred.binding->has_struct_()) {
+    return absl::InvalidArgumentError(
+        ERR_LOG("Cannot create selection on non-struct value."));
+  }
+  const auto& elements = deferred.binding->struct_().element();
+  if (static_cast<uint32_t>(elements.size()) <= index) {
+    return absl::InvalidArgumentError(
+        ERR_LOG(absl::StrCat("Attempted to access index ", index, " of a ",
+                             elements.size(), "-length struct.")));
+  }
+  size_t begin = deferred.begin;
+  for (uint32_t i = 0; i < index; ++i) {
+    begin += NumTensors(elements[i]);
+  }
+  DeferredOutputs selected{deferred.call, &elements[index], begin,
+                           begin + NumTensors(elements[index])};
+  selected.call->Select(selected.begin, selected.end);
+  return selected;
+}
+
+// Returns whether `value` holds deferred outputs at any depth.
+bool HasDeferred(const ExecutorValue& value) {
+  if (value.type() == ExecutorValue::ValueType::DEFERRED) {
+    return true;
+  }
+  if (value.type() != ExecutorValue::ValueType::STRUCT) {
+    return false;
+  }
+  for (const ExecutorValue& element : value.elements()) {
+    if (HasDeferred(element)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns `value` with its deferred outputs, at any depth, fetched.
+absl::StatusOr<ExecutorValue> Resolved(const ExecutorValue& value) {
+  if (!HasDeferred(value)) {
+    return value;
+  }
+  if (value.type() == ExecutorValue::ValueType::DEFERRED) {
+    const DeferredOutputs& deferred = value.deferred();
+    std::vector<tensorflow::Tensor> tensors =
+        TFF_TRY(deferred.call->Fetch(deferred.begin, deferred.end));
+    absl::Span<tensorflow::Tensor> slice(tensors);
+    return ExecutorValue::FromTensorsAndBindingStructure(*deferred.binding,
+                                                         &slice);
+  }
+  auto elements = std::make_shared<std::vector<ExecutorValue>>();
+  elements->reserve(value.elements().size());
+  for (const ExecutorValue& element : value.elements()) {
+    elements->push_back(TFF_TRY(Resolved(element)));
+  }
+  return ExecutorValue(std::move(elements));
+}
+
+absl::StatusOr<ExecutorValue> Computation::DeferCall(
+    const std::shared_ptr<Computation>& computation,
+    std::optional<ExecutorValue> arg) {
+  std::vector<std::pair<std::string, tensorflow::Tensor>> inputs;
+  TFF_TRY(computation->BindArgument(arg, &inputs));
+  const size_t num_outputs = computation->output_tensor_names_.size();
+  return ExecutorValue(DeferredOutputs{
+      std::make_shared<DeferredCall>(computation, std::move(inputs),
+                                     num_outputs),
+      &computation->output_shape_, 0, num_outputs});
+}
+
+absl::Status Computation::BindArgument(
+    const std::optional<ExecutorValue>& arg,
+    std::vector<std::pair<std::string, tensorflow::Tensor>>* inputs) {
   if (arg.has_value() != parameter_shape_.has_value()) {
     auto actual = arg.has_value()
                       ? absl::StrCat("of type '", arg->DebugString(), "' was")
@@ -689,33 +1167,116 @@ absl::StatusOr<ExecutorValue> Computation::Call(
                      " provided to tensorflow computation, but an argument ",
                      expected, " expected."));
   }
+  if (!arg.has_value()) {
+    return absl::OkStatus();
+  }
+  const size_t begin = inputs->size();
+  TFF_TRY(arg.value().Bind(parameter_shape_.value(), inputs));
+  // Datasets which are variant tensors skip the deserialization of the graph
+  // by being fed to the outputs of `DatasetFromGraph` ops, unless the calls
+  // are batched, which replicates the graph under other names.
+  for (size_t i = begin; i < inputs->size(); ++i) {
+    auto& [name, tensor] = (*inputs)[i];
+    if (tensor.dtype() != tensorflow::DT_VARIANT) {
+      continue;
+    }
+    auto dataset_tensor_name = dataset_tensor_names_.find(name);
+    if (dataset_tensor_name == dataset_tensor_names_.end()) {
+      continue;
+    }
+    if (batched_runner_ != nullptr) {
+      tensor = TFF_TRY(SerializeDataset(tensor));
+    } else {
+      name = dataset_tensor_name->second;
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<ExecutorValue> Computation::Call(
+    std::optional<ExecutorValue> arg) {
+  // Skip everything if there are no outputs.
+  // If `output_tensor_names` is empty, TF raises an error, so we must bypass it
+  // entirely.
+  if (output_tensor_names_.empty()) {
+    return ExecutorValue::FromTensorsAndBindingStructure(output_shape_, {});
+  }
   std::vector<std::pair<std::string, tensorflow::Tensor>> inputs;
-  if (arg.has_value()) {
-    TFF_TRY(arg.value().Bind(parameter_shape_.value(), &inputs));
+  TFF_TRY(BindArgument(arg, &inputs));
+  if (batched_runner_ != nullptr) {
+    std::vector<tensorflow::Tensor> outputs =
+        TFF_TRY(batched_runner_->Run(std::move(inputs)));
+    absl::Span<tensorflow::Tensor> slice(outputs);
+    return ExecutorValue::FromTensorsAndBindingStructure(output_shape_, &slice);
   }
+  auto session = TFF_TRY(this->session_provider_.BorrowSession());
+  std::optional<ConcurrencyPermit> permit;
+  permit.emplace(limiter_.get(), latency_baseline_);
   if (!init_op_.empty()) {
-    absl::Status status = session->Run(inputs,
-                                       /*output_tensor_names=*/{},
-                                       /*target_tensor_names=*/{init_op_},
-                                       /*outputs=*/nullptr);
+    absl::Status status = session.RunCallable(
+        inputs,
+        /*output_tensor_names=*/{},
+        /*target_tensor_names=*/{init_op_},
+        /*outputs=*/nullptr);
     if (!status.ok()) {
       return absl::InternalError(ERR_LOG(absl::StrCat(
           "Failed to initialize the computation: ", status.message())));
     }
   }
   std::vector<tensorflow::Tensor> outputs;
-  absl::Status status = session->Run(inputs, output_tensor_names_,
-                                     /*target_tensor_names=*/{}, &outputs);
+  absl::Status status =
+      session.RunCallable(inputs, output_tensor_names_,
+                          /*target_tensor_names=*/{}, &outputs);
   if (!status.ok()) {
     return absl::InternalError(
         ERR_LOG(absl::StrCat("Failed to run computation: ", status.message())));
   }
-  // Return the session rental before computing the final ExecutorValue.
+  // Return the permit and the session rental before computing the final
+  // ExecutorValue.
+  permit.reset();
   session.ReturnRental();
   absl::Span<tensorflow::Tensor> slice(outputs);
   return ExecutorValue::FromTensorsAndBindingStructure(output_shape_, &slice);
 }
 
+std::vector<absl::StatusOr<ExecutorValue>> Computation::CallBatch(
+    std::vector<absl::StatusOr<ExecutorValue>> args) {
+  std::vector<absl::StatusOr<ExecutorValue>> results(
+      args.size(), absl::UnknownError("Call not run"));
+  // The indices of the calls whose arguments were bound, in the order of
+  // their runs.
+  std::vector<size_t> call_indices;
+  std::vector<std::vector<std::pair<std::string, tensorflow::Tensor>>> inputs;
+  for (size_t i = 0; i < args.size(); ++i) {
+    std::vector<std::pair<std::string, tensorflow::Tensor>> call_inputs;
+    absl::Status status = args[i].status();
+    if (status.ok()) {
+      absl::StatusOr<ExecutorValue> arg = Resolved(*args[i]);
+      status = arg.ok() ? BindArgument(*std::move(arg), &call_inputs)
+                        : arg.status();
+    }
+    if (!status.ok()) {
+      results[i] = status;
+      continue;
+    }
+    call_indices.push_back(i);
+    inputs.push_back(std::move(call_inputs));
+  }
+  std::vector<absl::StatusOr<std::vector<tensorflow::Tensor>>> outputs =
+      batched_runner_->RunAll(std::move(inputs));
+  for (size_t run = 0; run < outputs.size(); ++run) {
+    absl::StatusOr<ExecutorValue>& result = results[call_indices[run]];
+    if (!outputs[run].ok()) {
+      result = outputs[run].status();
+      continue;
+    }
+    absl::Span<tensorflow::Tensor> slice(*outputs[run]);
+    result =
+        ExecutorValue::FromTensorsAndBindingStructure(output_shape_, &slice);
+  }
+  return results;
+}
+
 absl::StatusOr<ExecutorValue> CallIntrinsic(Intrinsic intrinsic,
                                             std::optional<ExecutorValue> arg) {
   switch (intrinsic) {
@@ -751,10 +1312,41 @@ absl::StatusOr<ExecutorValue> CallIntrinsic(Intrinsic intrinsic,
   }
 }
 
-using ValueFuture = std::shared_future<absl::StatusOr<ExecutorValue>>;
+// Calls `fn`, a computation or intrinsic, with optional `arg`.
+absl::StatusOr<ExecutorValue> CallFunction(const ExecutorValue& fn,
+                                           std::optional<ExecutorValue> arg) {
+  if (arg.has_value()) {
+    arg = TFF_TRY(Resolved(*arg));
+  }
+  if (fn.type() == ExecutorValue::ValueType::COMPUTATION) {
+    if (fn.computation()->defers_calls()) {
+      return Computation::DeferCall(fn.computation(), std::move(arg));
+    }
+    return fn.computation()->Call(std::move(arg));
+  } else if (fn.type() == ExecutorValue::ValueType::INTRINSIC) {
+    return CallIntrinsic(fn.intrinsic(), std::move(arg));
+  } else {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Expected `function` argument to "
+                     "`TensorFlowExecutor::CreateCall` "
+                     "to be a computation or intrinsic, but found type ",
+                     fn.type()));
+  }
+}
 
-absl::Status MaterializeSequence(const tensorflow::Tensor& graph_def_tensor,
+// Structs and selections are built inline as continuations of the values they
+// are built from, so only value creations and calls are scheduled on the
+// executor's pool, and no work on the pool waits for other work.
+using ValueFuture = SharedFuture<ExecutorValue>;
+using ValuePromise = SharedPromise<ExecutorValue>;
+
+absl::Status MaterializeSequence(const tensorflow::Tensor& sequence_tensor,
                                  v0::Value::Sequence* sequence_value_pb) {
+  // Datasets kept in-process are only serialized once they leave the executor.
+  tensorflow::Tensor graph_def_tensor = sequence_tensor;
+  if (sequence_tensor.dtype() == tensorflow::DT_VARIANT) {
+    graph_def_tensor = TFF_TRY(SerializeDataset(sequence_tensor));
+  }
   if ((graph_def_tensor.dtype() != tensorflow::DT_STRING) ||
       graph_def_tensor.shape().dims() != 0) {
     return absl::InternalError(
@@ -773,28 +1365,94 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
  public:
   // Setting max_concurrent_computation_calls to a positive value limits the
   // concurrent invocations of session.run to that number. Zero or negative
-  // provides effectively unlimited concurrency.
-  explicit TensorFlowExecutor(int32_t max_concurrent_computation_calls)
-      : thread_pool_(
-            // Use a threadpool with CPU * 4 or the user specified
-            // maximum.
-            ((max_concurrent_computation_calls > 0)
-                 ? max_concurrent_computation_calls
-                 : std::thread::hardware_concurrency() * 4),
-            ExecutorName()) {
-    VLOG(2) << "thread pool size: "
-            << ((max_concurrent_computation_calls > 0)
-                    ? max_concurrent_computation_calls
-                    : std::thread::hardware_concurrency() * 4);
+  // provides effectively unlimited concurrency. If `runtime` is not null, its
+  // compute lane bounds the invocations instead. If `adaptive_concurrency` is
+  // enabled, the invocations are further bounded by a limit adapting to their
+  // latency and memory use. Tracked values are spilled to disk as configured
+  // by `value_spill_options`.
+  explicit TensorFlowExecutor(int32_t max_concurrent_computation_calls,
+                              int64_t computation_cache_capacity_bytes,
+                              SessionPoolOptions session_pool_options,
+                              int32_t max_call_batch_size,
+                              std::shared_ptr<ExecutorRuntime> runtime,
+                              AdaptiveConcurrencyOptions adaptive_concurrency,
+                              ValueSpillOptions value_spill_options)
+      : session_pool_options_(SizeSharedThreadPools(
+            session_pool_options, max_concurrent_computation_calls)),
+        max_call_batch_size_(max_call_batch_size),
+        computation_cache_(computation_cache_capacity_bytes),
+        runtime_(std::move(runtime)) {
+    // Use a threadpool with CPU * 4 or the user specified maximum.
+    const int32_t max_concurrency =
+        (max_concurrent_computation_calls > 0)
+            ? max_concurrent_computation_calls
+            : std::thread::hardware_concurrency() * 4;
+    if (adaptive_concurrency.enabled) {
+      limiter_ = std::make_shared<ConcurrencyLimiter>(
+          max_concurrency, std::move(adaptive_concurrency));
+    }
+    EnableValueSpilling(std::move(value_spill_options));
+    if (runtime_ != nullptr) {
+      return;
+    }
+    thread_pool_ =
+        std::make_unique<ThreadPool>(max_concurrency, ExecutorName());
+    VLOG(2) << "thread pool size: " << max_concurrency;
+  }
+
+  // Imports the TensorFlow computations of `computations_pb` into the cache
+  // and builds their sessions, blocking until they are ready.
+  absl::Status WarmUp(absl::Span<const v0::Computation> computations_pb) {
+    for (const v0::Computation& comp_pb : computations_pb) {
+      if (!comp_pb.has_tensorflow()) {
+        continue;
+      }
+      std::shared_ptr<Computation> computation =
+          TFF_TRY(CachedComputation(comp_pb.tensorflow()));
+      TFF_TRY(computation->WarmUp());
+    }
+    return absl::OkStatus();
   }
 
  private:
-  // A hash map of compiler generated TensorFlow function ids to already
-  // construction Computation objects.
-  absl::flat_hash_map<uint64_t, std::shared_ptr<Computation>> function_cache_
-      ABSL_GUARDED_BY(function_cache_mutex_);
-  absl::Mutex function_cache_mutex_;
-  ThreadPool thread_pool_;
+  // Sizes the shared inter-op pool of `options`, if it shares thread pools and
+  // does not size it, so that each of `max_concurrent_computation_calls`
+  // concurrent session runs has a thread to run its ops on.
+  static SessionPoolOptions SizeSharedThreadPools(
+      SessionPoolOptions options, int32_t max_concurrent_computation_calls) {
+    if (options.share_thread_pools && options.inter_op_threads <= 0) {
+      options.inter_op_threads =
+          std::max<int32_t>(max_concurrent_computation_calls,
+                            std::thread::hardware_concurrency());
+    }
+    return options;
+  }
+
+  // Already constructed Computation objects, keyed by their compiler generated
+  // ids or their fingerprint, so that computations sent again reuse their
+  // imported graphs and sessions.
+  const SessionPoolOptions session_pool_options_;
+  const int32_t max_call_batch_size_;
+  ComputationCache computation_cache_;
+  // If not null, provides the pool of this executor instead of
+  // `thread_pool_`.
+  const std::shared_ptr<ExecutorRuntime> runtime_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+  // If not null, adapts the number of concurrent session runs.
+  std::shared_ptr<ConcurrencyLimiter> limiter_;
+
+  // Returns the pool to schedule work of this executor on.
+  ThreadPool* thread_pool() {
+    return runtime_ != nullptr ? runtime_->pool(ExecutorLane::kCompute)
+                               : thread_pool_.get();
+  }
+
+  // Returns a reference to this executor for work scheduled on the pool of
+  // `runtime_`, which outlives the executor. Work scheduled on `thread_pool_`
+  // must not hold one, since the pool is joined by the destructor.
+  std::shared_ptr<Executor> KeepAlive() {
+    return runtime_ != nullptr ? shared_from_this() : nullptr;
+  }
 
   absl::StatusOr<ExecutorValue> CreateValueAny(const v0::Value& value_pb) {
     switch (value_pb.value_case()) {
@@ -812,44 +1470,46 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
     }
   }
 
+  // Returns the computation of `comp_pb` from the cache, importing it on a
+  // miss.
+  absl::StatusOr<std::shared_ptr<Computation>> CachedComputation(
+      const v0::TensorFlow& comp_pb) {
+    std::string key = ComputationCacheKey(comp_pb);
+    std::shared_ptr<Computation> computation = computation_cache_.Lookup(key);
+    if (computation != nullptr) {
+      VLOG(2) << "Cache hit for computation: " << key;
+      return computation;
+    }
+    VLOG(2) << "Cache MISS for computation: " << key;
+    std::shared_ptr<Computation> new_computation = TFF_TRY(
+        Computation::FromProto(comp_pb, session_pool_options_,
+                               max_call_batch_size_, limiter_));
+    // If another thread beat us to creating the computation, we end up
+    // throwing away ours here, which is fine because it is not run yet.
+    computation = computation_cache_.Insert(std::move(key), new_computation);
+    if (computation == new_computation &&
+        session_pool_options_.min_sessions > 0) {
+      // Build the sessions of the computation in the background, so that
+      // they are ready by the time it is called.
+      absl::Status status = thread_pool()->Schedule([computation] {
+        absl::Status status = computation->Prewarm();
+        if (!status.ok()) {
+          LOG(WARNING) << "Failed to prewarm sessions: " << status;
+        }
+      });
+      if (!status.ok()) {
+        LOG(WARNING) << "Failed to schedule prewarming sessions: " << status;
+      }
+    }
+    return computation;
+  }
+
   absl::StatusOr<ExecutorValue> CreateValueComputation(
       const v0::Computation& comp_pb) {
     switch (comp_pb.computation_case()) {
       case v0::Computation::kTensorflow: {
-        if (!comp_pb.tensorflow().has_cache_key() ||
-            comp_pb.tensorflow().cache_key().id() == 0) {
-          // No ID to use for caching, simply create a computation and skip
-          // cache logic.
-          LOG_FIRST_N(WARNING, 10)
-              << "Skipped caching computation, no cache_key:\n"
-              << comp_pb.type().Utf8DebugString();
-          return ExecutorValue(
-              TFF_TRY(Computation::FromProto(comp_pb.tensorflow())));
-        }
-        const uint64_t function_id = comp_pb.tensorflow().cache_key().id();
-        // Try the fast path first, reader locks are much cheaper.
-        {
-          absl::ReaderMutexLock reader_lock(&function_cache_mutex_);
-          auto cache_iter = function_cache_.find(function_id);
-          if (cache_iter != function_cache_.end()) {
-            VLOG(2) << "Cache hit for function id: " << function_id;
-            return ExecutorValue(cache_iter->second);
-          }
-        }
-        // Otherwise build the cached value and insert it into the cache.
-        VLOG(2) << "Cache MISS for function id: " << function_id;
-        std::shared_ptr<Computation> computation =
-            TFF_TRY(Computation::FromProto(comp_pb.tensorflow()));
-        {
-          absl::WriterMutexLock writer_lock(&function_cache_mutex_);
-          auto result = function_cache_.try_emplace(function_id, computation);
-          if (!result.second) {
-            // Another thread beat us to creating the cache value. We end up
-            // throwing away our value here, but this is fine because its cheap.
-            computation = result.first->second;
-          }
-        }
-        return ExecutorValue(computation);
+        return ExecutorValue(
+            TFF_TRY(CachedComputation(comp_pb.tensorflow())));
       }
       case v0::Computation::kLiteral: {
         const tensorflow::Tensor tensor =
@@ -871,7 +1531,9 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
   }
 
   absl::StatusOr<ExecutorValue> CreateValueTensor(const v0::Value& value_pb) {
-    return ExecutorValue(TFF_TRY(DeserializeTensorValue(value_pb)));
+    // Tensors are never modified in place, so large identical values, e.g.
+    // the broadcast values of all clients of a simulation, share a buffer.
+    return ExecutorValue(TFF_TRY(DeserializeSharedTensorValue(value_pb)));
   }
 
   absl::StatusOr<ExecutorValue> CreateValueStruct(
@@ -886,10 +1548,67 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
 
   absl::StatusOr<ExecutorValue> CreateValueSequence(
       const v0::Value::Sequence& sequence_pb) const {
+    if (sequence_pb.has_columns()) {
+      // Computations consume sequences as serialized datasets.
+      std::vector<tensorflow::Tensor> columns =
+          TFF_TRY(SequenceValueToColumns(sequence_pb));
+      return ExecutorValue(
+          SequenceTensor(TFF_TRY(DatasetFromColumns(columns))));
+    }
     return ExecutorValue(
         SequenceTensor(tensorflow::Tensor(sequence_pb.serialized_graph_def())));
   }
 
+  // Returns the bytes of the tensors of `value`, or `kNotSpillable` if it is
+  // not a structure of tensors which can be serialized.
+  static int64_t TensorBytes(const ExecutorValue& value) {
+    switch (value.type()) {
+      case ExecutorValue::ValueType::TENSOR: {
+        tensorflow::DataType dtype = value.tensor().dtype();
+        if (dtype == tensorflow::DT_VARIANT ||
+            dtype == tensorflow::DT_RESOURCE) {
+          return kNotSpillable;
+        }
+        return value.tensor().TotalBytes();
+      }
+      case ExecutorValue::ValueType::STRUCT: {
+        int64_t bytes = 0;
+        for (const ExecutorValue& element : value.elements()) {
+          int64_t element_bytes = TensorBytes(element);
+          if (element_bytes == kNotSpillable) {
+            return kNotSpillable;
+          }
+          bytes += element_bytes;
+        }
+        return bytes;
+      }
+      default:
+        return kNotSpillable;
+    }
+  }
+
+  // Serializes a structure of tensors for `SerializeSpilled`.
+  static absl::Status SerializeTensorStructure(const ExecutorValue& value,
+                                               v0::Value* value_pb) {
+    switch (value.type()) {
+      case ExecutorValue::ValueType::TENSOR: {
+        return SerializeTensorValue(value.tensor(), value_pb);
+      }
+      case ExecutorValue::ValueType::STRUCT: {
+        v0::Value::Struct* struct_pb = value_pb->mutable_struct_();
+        for (const ExecutorValue& element : value.elements()) {
+          TFF_TRY(SerializeTensorStructure(
+              element, struct_pb->add_element()->mutable_value()));
+        }
+        return absl::OkStatus();
+      }
+      default:
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Cannot spill values other than tensor structures, found ",
+            value.DebugString()));
+    }
+  }
+
   // NOTE: `value` reference must be valid until `tasks.WaitAll` is called.
   absl::Status MaterializeValue(const ExecutorValue& value, v0::Value* value_pb,
                                 ParallelTasks& tasks) {
@@ -922,6 +1641,10 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
         return absl::InvalidArgumentError(
             "Cannot materialize uncalled intrinsics");
       }
+      case ExecutorValue::ValueType::DEFERRED: {
+        return absl::InternalError(
+            "Cannot materialize the result of a call which was not run");
+      }
     }
   }
 
@@ -933,36 +1656,86 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
 
   absl::StatusOr<ValueFuture> CreateExecutorValue(
       const v0::Value& value_pb) final {
-    return ThreadRun(
-        [value_pb, this]() -> absl::StatusOr<ExecutorValue> {
+    return RunOnPool(
+        [value_pb, this,
+         keepalive = KeepAlive()]() -> absl::StatusOr<ExecutorValue> {
           return TFF_TRY(CreateValueAny(value_pb));
         },
-        &thread_pool_);
+        thread_pool());
   }
 
   absl::StatusOr<ValueFuture> CreateCall(
       ValueFuture function, std::optional<ValueFuture> argument) final {
-    return ThreadRun(
-        [function = std::move(function),
-         argument = std::move(argument)]() -> absl::StatusOr<ExecutorValue> {
-          ExecutorValue fn = TFF_TRY(Wait(function));
+    std::vector<ValueFuture> inputs = {std::move(function)};
+    if (argument.has_value()) {
+      inputs.push_back(*std::move(argument));
+    }
+    return MapOnPool(
+        std::move(inputs),
+        [](std::vector<ExecutorValue>&& inputs)
+            -> absl::StatusOr<ExecutorValue> {
           std::optional<ExecutorValue> arg = std::nullopt;
-          if (argument.has_value()) {
-            arg = TFF_TRY(Wait(argument.value()));
-          }
-          if (fn.type() == ExecutorValue::ValueType::COMPUTATION) {
-            return fn.computation()->Call(std::move(arg));
-          } else if (fn.type() == ExecutorValue::ValueType::INTRINSIC) {
-            return CallIntrinsic(fn.intrinsic(), std::move(arg));
-          } else {
-            return absl::InvalidArgumentError(absl::StrCat(
-                "Expected `function` argument to "
-                "`TensorFlowExecutor::CreateCall` "
-                "to be a computation or intrinsic, but found type ",
-                fn.type()));
+          if (inputs.size() > 1) {
+            arg = std::move(inputs[1]);
           }
+          return CallFunction(inputs[0], std::move(arg));
         },
-        &thread_pool_);
+        thread_pool());
+  }
+
+  // Calls of a computation whose calls are batched run together, in as few
+  // session runs as its maximum batch size allows. Other calls run on their
+  // own, as with `CreateCall`.
+  absl::StatusOr<std::vector<ValueFuture>> CreateCallBatch(
+      ValueFuture function, std::vector<ValueFuture> arguments) final {
+    auto promises = std::make_shared<std::vector<ValuePromise>>(
+        arguments.size());
+    std::vector<ValueFuture> results;
+    results.reserve(arguments.size());
+    for (const ValuePromise& promise : *promises) {
+      results.push_back(promise.future());
+    }
+    ThreadPool* pool = thread_pool();
+    function.Then([arguments = std::move(arguments), promises,
+                   pool](const absl::StatusOr<ExecutorValue>& fn) mutable {
+      if (!fn.ok()) {
+        for (ValuePromise& promise : *promises) {
+          promise.Set(fn.status());
+        }
+        return;
+      }
+      if (fn->type() == ExecutorValue::ValueType::COMPUTATION &&
+          fn->computation()->batches_calls()) {
+        WhenAll(std::move(arguments),
+                [fn = *fn, promises,
+                 pool](std::vector<absl::StatusOr<ExecutorValue>>&& args) {
+                  RunOnPool(
+                      [fn, args = std::move(args), promises]() mutable
+                          -> absl::StatusOr<std::monostate> {
+                        std::vector<absl::StatusOr<ExecutorValue>> values =
+                            fn.computation()->CallBatch(std::move(args));
+                        for (size_t i = 0; i < values.size(); ++i) {
+                          (*promises)[i].Set(std::move(values[i]));
+                        }
+                        return std::monostate();
+                      },
+                      pool);
+                });
+        return;
+      }
+      for (size_t i = 0; i < arguments.size(); ++i) {
+        MapOnPool(
+            std::vector<ValueFuture>({arguments[i]}),
+            [fn = *fn](std::vector<ExecutorValue>&& args) {
+              return CallFunction(fn, std::move(args[0]));
+            },
+            pool)
+            .Then([promises, i](const absl::StatusOr<ExecutorValue>& value) {
+              (*promises)[i].Set(value);
+            });
+      }
+    });
+    return results;
   }
   absl::StatusOr<ValueFuture> CreateStruct(
       std::vector<ValueFuture> elements) final {
@@ -972,8 +1745,7 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
             -> absl::StatusOr<ExecutorValue> {
           return ExecutorValue(std::make_shared<std::vector<ExecutorValue>>(
               std::move(elements)));
-        },
-        &thread_pool_);
+        });
   }
   absl::StatusOr<ValueFuture> CreateSelection(ValueFuture value,
                                               const uint32_t index) final {
@@ -982,6 +1754,11 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
         [index](std::vector<ExecutorValue>&& values)
             -> absl::StatusOr<ExecutorValue> {
           ExecutorValue& value = values[0];
+          if (value.type() == ExecutorValue::ValueType::DEFERRED) {
+            // Only narrows the outputs the deferred call will fetch.
+            return ExecutorValue(
+                TFF_TRY(SelectDeferred(value.deferred(), index)));
+          }
           if (value.type() != ExecutorValue::ValueType::STRUCT) {
             return absl::InvalidArgumentError(
                 ERR_LOG("Cannot create selection on non-struct value."));
@@ -992,23 +1769,86 @@ class TensorFlowExecutor : public ExecutorBase<ValueFuture> {
                              value.elements().size(), "-length struct.")));
           }
           return ExecutorValue(value.elements()[index]);
-        },
-        &thread_pool_);
+        });
   }
   absl::Status Materialize(ValueFuture value_fut, v0::Value* value_pb) final {
     ExecutorValue value = TFF_TRY(Wait(std::move(value_fut)));
-    ParallelTasks tasks(&thread_pool_);
+    if (HasDeferred(value)) {
+      // Deferred calls run on the pool, as other calls do.
+      value = TFF_TRY(Wait(RunOnPool(
+          [value = std::move(value)]() { return Resolved(value); },
+          thread_pool())));
+    }
+    ParallelTasks tasks(thread_pool());
     TFF_TRY(MaterializeValue(value, value_pb, tasks));
     TFF_TRY(tasks.WaitAll());
     return absl::OkStatus();
   }
+
+  // Only structures of tensors which are computed already are spilled; the
+  // results of calls which are not run yet, computations and sequences stay
+  // in memory. Spilled values are stored as serialized `v0::Value`s.
+  int64_t SpillableBytes(const ValueFuture& value_fut) final {
+    if (value_fut.wait_for(std::chrono::duration<uint8_t>::zero()) !=
+        std::future_status::ready) {
+      return 0;
+    }
+    const absl::StatusOr<ExecutorValue>& value = value_fut.get();
+    if (!value.ok()) {
+      return kNotSpillable;
+    }
+    int64_t bytes = TensorBytes(*value);
+    return bytes > 0 ? bytes : kNotSpillable;
+  }
+
+  absl::StatusOr<std::string> SerializeSpilled(
+      const ValueFuture& value_fut) final {
+    v0::Value value_pb;
+    TFF_TRY(SerializeTensorStructure(TFF_TRY(Wait(value_fut)), &value_pb));
+    return value_pb.SerializeAsString();
+  }
+
+  absl::StatusOr<ValueFuture> DeserializeSpilled(
+      const std::string& data) final {
+    v0::Value value_pb;
+    if (!value_pb.ParseFromString(data)) {
+      return absl::DataLossError("Could not parse a spilled value.");
+    }
+    return ValueFuture::Ready(CreateValueAny(value_pb));
+  }
+
+  // Values only hold refcounted tensors and computations, none of which belong
+  // to the executor which created them, so they are shared as is. The
+  // transfer doesn't wait for `value_fut` to be ready.
+  absl::StatusOr<std::optional<ValueFuture>> TransferExecutorValue(
+      ValueFuture value_fut, ExecutorBase<ValueFuture>& target) final {
+    return value_fut;
+  }
 };
 
 }  // namespace
 
 std::shared_ptr<Executor> CreateTensorFlowExecutor(
-    int32_t max_concurrent_computation_calls) {
-  return std::make_shared<TensorFlowExecutor>(max_concurrent_computation_calls);
+    int32_t max_concurrent_computation_calls,
+    int64_t computation_cache_capacity_bytes,
+    SessionPoolOptions session_pool_options, int32_t max_call_batch_size,
+    std::shared_ptr<ExecutorRuntime> runtime,
+    AdaptiveConcurrencyOptions adaptive_concurrency,
+    ValueSpillOptions value_spill_options) {
+  return std::make_shared<TensorFlowExecutor>(
+      max_concurrent_computation_calls, computation_cache_capacity_bytes,
+      session_pool_options, max_call_batch_size, std::move(runtime),
+      std::move(adaptive_concurrency), std::move(value_spill_options));
+}
+
+absl::Status WarmUpTensorFlowExecutor(
+    Executor& executor, absl::Span<const v0::Computation> computations_pb) {
+  auto* tensorflow_executor = dynamic_cast<TensorFlowExecutor*>(&executor);
+  if (tensorflow_executor == nullptr) {
+    return absl::InvalidArgumentError(
+        "Can only warm up executors created by `CreateTensorFlowExecutor`.");
+  }
+  return tensorflow_executor->WarmUp(computations_pb);
 }
 
 }  // namespace tensorflow_federated
@@ -19,16 +19,77 @@ limitations under the License
 #include <cstdint>
 #include <memory>
 
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "tensorflow_federated/cc/core/impl/executors/concurrency_limiter.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_runtime.h"
+#include "tensorflow_federated/cc/core/impl/executors/session_provider.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_spiller.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
 
 namespace tensorflow_federated {
 
+inline constexpr int64_t kDefaultComputationCacheCapacityBytes =
+    int64_t{1} << 30;
+
 // Returns an executor that can resolve TensorFlow computations and structures
 // of tensors. `max_concurrent_computation_calls` can be used to limit the
 // maximum number of TensorFlow sessions executing in parallel; non-positive
 // values indicate no max.
+//
+// Computations are cached across values, so that sending the same computation
+// again reuses its imported graph and sessions. The least recently used
+// computations are evicted once the serialized size of the cached graphs
+// exceeds `computation_cache_capacity_bytes`.
+//
+// `session_pool_options` bound the number of sessions each computation keeps;
+// sessions up to the minimum are built in the background as soon as a
+// computation is created. If they share thread pools, an unsized inter-op pool
+// has at least `max_concurrent_computation_calls` threads, so that each
+// concurrent session run can make progress, and at least one per core.
+//
+// If `max_call_batch_size` is greater than one, concurrent calls of the same
+// stateless computation are coalesced into batches of up to
+// `max_call_batch_size` calls, each run in a single session run. This trades
+// building a session per batch size for lower per-call overhead, and is
+// intended for computations called many times concurrently, e.g. per client
+// in simulation.
+//
+// If `runtime` is not null, computations run on its compute lane instead of a
+// thread pool owned by the executor, and `max_concurrent_computation_calls`
+// only bounds the adaptive limit below.
+//
+// If `adaptive_concurrency` is enabled, the number of concurrent session runs
+// is further bounded by a limit between `adaptive_concurrency.min_limit` and
+// `max_concurrent_computation_calls`, or four per core if that is not
+// positive. The limit grows while runs keep up with the lowest recent latency
+// of their computation, and backs off when they slow down or memory use
+// exceeds `adaptive_concurrency.memory_limit_bytes` (see
+// `ConcurrencyLimiter`). Batched calls are not bounded.
+//
+// If `value_spill_options.memory_budget_bytes` is positive, the least recently
+// used structures of tensors tracked by the executor, such as per-client model
+// copies in simulation, are spilled to local disk once the computed ones
+// exceed the budget, and read back when they are used again. This lets
+// simulations hold more values than fit in memory, at the cost of disk I/O.
 std::shared_ptr<Executor> CreateTensorFlowExecutor(
-    int32_t max_concurrent_computation_calls = -1);
+    int32_t max_concurrent_computation_calls = -1,
+    int64_t computation_cache_capacity_bytes =
+        kDefaultComputationCacheCapacityBytes,
+    SessionPoolOptions session_pool_options = SessionPoolOptions(),
+    int32_t max_call_batch_size = 1,
+    std::shared_ptr<ExecutorRuntime> runtime = nullptr,
+    AdaptiveConcurrencyOptions adaptive_concurrency =
+        AdaptiveConcurrencyOptions(),
+    ValueSpillOptions value_spill_options = ValueSpillOptions());
+
+// Imports the TensorFlow computations of `computations_pb` into the cache of
+// `executor`, which must be created by `CreateTensorFlowExecutor`, and builds a
+// session for each of them, so that their first calls cost as much as later
+// ones. Blocks until done; other computations are skipped.
+absl::Status WarmUpTensorFlowExecutor(
+    Executor& executor, absl::Span<const v0::Computation> computations_pb);
 
 }  // namespace tensorflow_federated
 
@@ -0,0 +1,149 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/log/check.h"
+#include "absl/status/statusor.h"
+#include "include/benchmark/benchmark.h"
+#include "tensorflow/cc/framework/ops.h"
+#include "tensorflow/cc/framework/scope.h"
+#include "tensorflow/cc/ops/array_ops.h"
+#include "tensorflow/cc/ops/const_op.h"
+#include "tensorflow/cc/ops/math_ops.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/tensorflow_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::tensorflow_federated::testing::SequenceV;
+using ::tensorflow_federated::testing::StructV;
+using ::tensorflow_federated::testing::TensorV;
+
+// Returns a computation of `<x, ds> -> x + 1 + ... + 1` which adds one
+// `num_additions` times. The sequence parameter `ds` is unused, but is bound
+// so that embedding the computation rewrites its graph.
+v0::Value ChainedAdditionsComputationV(int64_t num_additions) {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root.WithOpName("x"), tensorflow::DT_FLOAT);
+  tensorflow::ops::Placeholder ds(root.WithOpName("ds"),
+                                  tensorflow::DT_VARIANT);
+  tensorflow::Output sum = x;
+  for (int64_t i = 0; i < num_additions; ++i) {
+    sum = tensorflow::ops::AddV2(root, sum, tensorflow::ops::Const(root, 1.0f));
+  }
+  tensorflow::ops::Identity out(root.WithOpName("out"), sum);
+  tensorflow::GraphDef graphdef_pb;
+  CHECK(root.ToGraphDef(&graphdef_pb).ok());
+  v0::Value value_pb;
+  v0::TensorFlow* tensorflow_pb =
+      value_pb.mutable_computation()->mutable_tensorflow();
+  tensorflow_pb->mutable_graph_def()->PackFrom(graphdef_pb);
+  v0::TensorFlow::StructBinding* parameter_pb =
+      tensorflow_pb->mutable_parameter()->mutable_struct_();
+  parameter_pb->add_element()->mutable_tensor()->set_tensor_name("x:0");
+  parameter_pb->add_element()->mutable_sequence()->set_variant_tensor_name(
+      "ds:0");
+  tensorflow_pb->mutable_result()->mutable_tensor()->set_tensor_name("out:0");
+  return value_pb;
+}
+
+// Returns a computation of `x -> x`.
+v0::Value IdentityComputationV() {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root.WithOpName("x"), tensorflow::DT_FLOAT);
+  tensorflow::ops::Identity out(root.WithOpName("out"), x);
+  tensorflow::GraphDef graphdef_pb;
+  CHECK(root.ToGraphDef(&graphdef_pb).ok());
+  v0::Value value_pb;
+  v0::TensorFlow* tensorflow_pb =
+      value_pb.mutable_computation()->mutable_tensorflow();
+  tensorflow_pb->mutable_graph_def()->PackFrom(graphdef_pb);
+  tensorflow_pb->mutable_parameter()->mutable_tensor()->set_tensor_name("x:0");
+  tensorflow_pb->mutable_result()->mutable_tensor()->set_tensor_name("out:0");
+  return value_pb;
+}
+
+// Arguments are the number of additions in the computation, and whether the
+// executor caches computations. Without the cache, each iteration measures
+// embedding the computation and building its session before the call.
+void BM_EmbedAndCallComputation(benchmark::State& state) {
+  const v0::Value fn_pb = ChainedAdditionsComputationV(state.range(0));
+  const v0::Value arg_pb = StructV({TensorV(1.0f), SequenceV(0, 10, 1)});
+  std::shared_ptr<Executor> executor = CreateTensorFlowExecutor(
+      /*max_concurrent_computation_calls=*/-1,
+      /*computation_cache_capacity_bytes=*/state.range(1)
+          ? kDefaultComputationCacheCapacityBytes
+          : 0);
+  absl::StatusOr<OwnedValueId> arg = executor->CreateValue(arg_pb);
+  CHECK(arg.ok()) << arg.status();
+  for (auto s : state) {
+    absl::StatusOr<OwnedValueId> fn = executor->CreateValue(fn_pb);
+    CHECK(fn.ok()) << fn.status();
+    absl::StatusOr<OwnedValueId> result = executor->CreateCall(*fn, *arg);
+    CHECK(result.ok()) << result.status();
+    absl::StatusOr<v0::Value> result_pb = executor->Materialize(*result);
+    CHECK(result_pb.ok()) << result_pb.status();
+    benchmark::DoNotOptimize(result_pb);
+  }
+}
+
+BENCHMARK(BM_EmbedAndCallComputation)
+    ->ArgsProduct({{1 << 4, 1 << 10, 1 << 14}, {false, true}});
+
+// Benchmarks the dispatch overhead of calling an embedded computation which
+// does no work, and materializing its result.
+void BM_CallIdentityComputation(benchmark::State& state) {
+  std::shared_ptr<Executor> executor = CreateTensorFlowExecutor();
+  absl::StatusOr<OwnedValueId> fn =
+      executor->CreateValue(IdentityComputationV());
+  CHECK(fn.ok()) << fn.status();
+  absl::StatusOr<OwnedValueId> arg = executor->CreateValue(TensorV(1.0f));
+  CHECK(arg.ok()) << arg.status();
+  for (auto s : state) {
+    absl::StatusOr<OwnedValueId> result = executor->CreateCall(*fn, *arg);
+    CHECK(result.ok()) << result.status();
+    absl::StatusOr<v0::Value> result_pb = executor->Materialize(*result);
+    CHECK(result_pb.ok()) << result_pb.status();
+    benchmark::DoNotOptimize(result_pb);
+  }
+}
+
+BENCHMARK(BM_CallIdentityComputation);
+
+// Benchmarks creating and disposing of a tensor of `state.range(0)` floats.
+void BM_CreateAndDisposeTensor(benchmark::State& state) {
+  std::shared_ptr<Executor> executor = CreateTensorFlowExecutor();
+  const v0::Value value_pb = TensorV(
+      tensorflow::DT_FLOAT, tensorflow::TensorShape({state.range(0)}));
+  for (auto s : state) {
+    benchmark::DoNotOptimize(executor->CreateValue(value_pb));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          sizeof(float));
+}
+
+BENCHMARK(BM_CreateAndDisposeTensor)->Arg(1)->Arg(1 << 10)->Arg(1 << 20);
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -17,6 +17,7 @@ limitations under the License
 
 #include <cstdint>
 #include <future>  // NOLINT
+#include <limits>
 #include <memory>
 #include <optional>
 #include <string>
@@ -45,12 +46,14 @@ limitations under the License
 #include "tensorflow/core/graph/graph.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/tstring.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
 #include "tensorflow_federated/cc/core/impl/executors/array_shape_test_utils.h"
 #include "tensorflow_federated/cc/core/impl/executors/array_test_utils.h"
 #include "tensorflow_federated/cc/core/impl/executors/dtensor_executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensorflow_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_spiller.h"
 #include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
 #include "tensorflow_federated/cc/testing/protobuf_matchers.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
@@ -326,6 +329,41 @@ TYPED_TEST(TensorFlowBasedExecutorsTest, CallReduceOnSequence) {
                              TensorV(expected_sum));
 }
 
+TYPED_TEST(TensorFlowBasedExecutorsTest, CallReduceOnSequenceResult) {
+  if (this->Type() == kDTensorExecutor) {
+    GTEST_SKIP() << "Sequences not supported in DTensor Executor yet";
+  }
+  // A stateless computation returning its sequence argument, whose result is
+  // passed to the reduce in-process.
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder dataset(root, tensorflow::DT_VARIANT);
+  tensorflow::ops::Identity identity(root, dataset);
+  v0::Value identity_fn =
+      ComputationV(SequenceB(dataset), SequenceB(identity), root);
+  TFF_ASSERT_OK_AND_ASSIGN(auto identity_id,
+                           this->test_executor_->CreateValue(identity_fn));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto reduce_id,
+      this->test_executor_->CreateValue(CreateDatasetReduceComputationV()));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto sequence_id,
+      this->test_executor_->CreateValue(SequenceV(0, 10, 2)));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto result_id,
+      this->test_executor_->CreateCall(identity_id, sequence_id));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      auto sum_id, this->test_executor_->CreateCall(reduce_id, result_id));
+  TFF_ASSERT_OK_AND_ASSIGN(auto sum_pb,
+                           this->test_executor_->Materialize(sum_id));
+  EXPECT_THAT(sum_pb, EqualsProto(TensorV(int64_t{0 + 2 + 4 + 6 + 8})));
+  // The result is serialized once materialized.
+  TFF_ASSERT_OK_AND_ASSIGN(auto result_pb,
+                           this->test_executor_->Materialize(result_id));
+  tensorflow::GraphDef result_graph_def;
+  EXPECT_TRUE(result_graph_def.ParseFromString(
+      result_pb.sequence().serialized_graph_def()));
+}
+
 TYPED_TEST(TensorFlowBasedExecutorsTest, RoundTripEmptyStruct) {
   v0::Value input_pb;
   input_pb.mutable_struct_();
@@ -655,5 +693,239 @@ TEST_F(TensorFlowExecutorTest, CreateValueComputationLiteralReturnsResult) {
   CheckMaterializeEqual(embedded_fn, expected_pb);
 }
 
+// Returns the result of calling `fn` on `arg` in `executor`.
+absl::StatusOr<v0::Value> CallAndMaterialize(Executor& executor,
+                                             const v0::Value& fn,
+                                             const v0::Value& arg) {
+  OwnedValueId fn_id = TFF_TRY(executor.CreateValue(fn));
+  OwnedValueId arg_id = TFF_TRY(executor.CreateValue(arg));
+  OwnedValueId result_id = TFF_TRY(executor.CreateCall(fn_id, arg_id));
+  return executor.Materialize(result_id);
+}
+
+TEST_F(TensorFlowExecutorTest, CallsCachedComputationsWithoutComputationId) {
+  tensorflow::Scope add_root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder add_x(add_root, tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder add_y(add_root, tensorflow::DT_INT32);
+  tensorflow::ops::AddV2 add_out(add_root, add_x, add_y);
+  v0::Value add_fn = ComputationV(StructB({TensorB(add_x), TensorB(add_y)}),
+                                  TensorB(add_out), add_root);
+  tensorflow::Scope mul_root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder mul_x(mul_root, tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder mul_y(mul_root, tensorflow::DT_INT32);
+  tensorflow::ops::Mul mul_out(mul_root, mul_x, mul_y);
+  v0::Value mul_fn = ComputationV(StructB({TensorB(mul_x), TensorB(mul_y)}),
+                                  TensorB(mul_out), mul_root);
+  v0::Value arg = StructV({TensorV(2), TensorV(3)});
+
+  // Sending the same computations again as new values hits the cache, which
+  // must still tell the different computations apart.
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_THAT(CallAndMaterialize(*test_executor_, add_fn, arg),
+                IsOkAndHolds(EqualsProto(TensorV(5))));
+    EXPECT_THAT(CallAndMaterialize(*test_executor_, mul_fn, arg),
+                IsOkAndHolds(EqualsProto(TensorV(6))));
+  }
+}
+
+TEST_F(TensorFlowExecutorTest, CallsComputationsLargerThanCache) {
+  std::shared_ptr<Executor> executor = CreateTensorFlowExecutor(
+      /*max_concurrent_computation_calls=*/10,
+      /*computation_cache_capacity_bytes=*/0);
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root, tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder y(root, tensorflow::DT_INT32);
+  tensorflow::ops::AddV2 out(root, x, y);
+  v0::Value fn =
+      ComputationV(StructB({TensorB(x), TensorB(y)}), TensorB(out), root);
+  fn.mutable_computation()->mutable_tensorflow()->mutable_cache_key()->set_id(
+      1);
+  v0::Value arg = StructV({TensorV(1), TensorV(2)});
+
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_THAT(CallAndMaterialize(*executor, fn, arg),
+                IsOkAndHolds(EqualsProto(TensorV(3))));
+  }
+}
+
+TEST_F(TensorFlowExecutorTest, FetchesOnlySelectedOutputsOfCalls) {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root, tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder y(root, tensorflow::DT_DOUBLE);
+  tensorflow::ops::Identity x_out(root, x);
+  // Fails on the NaN argument below, unless pruned from the session run.
+  tensorflow::ops::CheckNumerics y_out(root, y, "y is not finite");
+  v0::Value fn = ComputationV(StructB({TensorB(x), TensorB(y)}),
+                              StructB({TensorB(x_out), TensorB(y_out)}), root);
+  v0::Value arg =
+      StructV({TensorV(1), TensorV(std::numeric_limits<double>::quiet_NaN())});
+  OwnedValueId fn_id = TFF_ASSERT_OK(test_executor_->CreateValue(fn));
+  OwnedValueId arg_id = TFF_ASSERT_OK(test_executor_->CreateValue(arg));
+  OwnedValueId call_id =
+      TFF_ASSERT_OK(test_executor_->CreateCall(fn_id, arg_id));
+  OwnedValueId x_id =
+      TFF_ASSERT_OK(test_executor_->CreateSelection(call_id, 0));
+  CheckMaterializeEqual(x_id, TensorV(1));
+  v0::Value output_pb;
+  EXPECT_THAT(test_executor_->Materialize(call_id, &output_pb),
+              StatusIs(StatusCode::kInternal, HasSubstr("not finite")));
+}
+
+TEST_F(TensorFlowExecutorTest, BatchesConcurrentCalls) {
+  std::shared_ptr<Executor> executor = CreateTensorFlowExecutor(
+      /*max_concurrent_computation_calls=*/10,
+      kDefaultComputationCacheCapacityBytes, SessionPoolOptions(),
+      /*max_call_batch_size=*/4);
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root, tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder y(root, tensorflow::DT_INT32);
+  tensorflow::ops::AddV2 out(root, x, y);
+  v0::Value fn =
+      ComputationV(StructB({TensorB(x), TensorB(y)}), TensorB(out), root);
+  OwnedValueId fn_id = TFF_ASSERT_OK(executor->CreateValue(fn));
+
+  constexpr int kNumCalls = 16;
+  std::vector<OwnedValueId> result_ids;
+  for (int i = 0; i < kNumCalls; ++i) {
+    OwnedValueId arg_id = TFF_ASSERT_OK(
+        executor->CreateValue(StructV({TensorV(i), TensorV(1)})));
+    result_ids.push_back(TFF_ASSERT_OK(executor->CreateCall(fn_id, arg_id)));
+  }
+  for (int i = 0; i < kNumCalls; ++i) {
+    EXPECT_THAT(executor->Materialize(result_ids[i]),
+                IsOkAndHolds(EqualsProto(TensorV(i + 1))));
+  }
+}
+
+TEST_F(TensorFlowExecutorTest, CallsUnderAdaptiveConcurrencyLimit) {
+  AdaptiveConcurrencyOptions adaptive_concurrency;
+  adaptive_concurrency.enabled = true;
+  adaptive_concurrency.initial_limit = 1;
+  std::shared_ptr<Executor> executor = CreateTensorFlowExecutor(
+      /*max_concurrent_computation_calls=*/4,
+      kDefaultComputationCacheCapacityBytes, SessionPoolOptions(),
+      /*max_call_batch_size=*/1, /*runtime=*/nullptr, adaptive_concurrency);
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root, tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder y(root, tensorflow::DT_INT32);
+  tensorflow::ops::AddV2 out(root, x, y);
+  v0::Value fn =
+      ComputationV(StructB({TensorB(x), TensorB(y)}), TensorB(out), root);
+  OwnedValueId fn_id = TFF_ASSERT_OK(executor->CreateValue(fn));
+
+  constexpr int kNumCalls = 16;
+  std::vector<OwnedValueId> result_ids;
+  for (int i = 0; i < kNumCalls; ++i) {
+    OwnedValueId arg_id = TFF_ASSERT_OK(
+        executor->CreateValue(StructV({TensorV(i), TensorV(1)})));
+    result_ids.push_back(TFF_ASSERT_OK(executor->CreateCall(fn_id, arg_id)));
+  }
+  for (int i = 0; i < kNumCalls; ++i) {
+    EXPECT_THAT(executor->Materialize(result_ids[i]),
+                IsOkAndHolds(EqualsProto(TensorV(i + 1))));
+  }
+}
+
+TEST_F(TensorFlowExecutorTest, SpillsValuesOverMemoryBudget) {
+  ValueSpillOptions value_spill_options;
+  value_spill_options.memory_budget_bytes = 1;
+  value_spill_options.directory = ::testing::TempDir();
+  std::shared_ptr<Executor> executor = CreateTensorFlowExecutor(
+      /*max_concurrent_computation_calls=*/10,
+      kDefaultComputationCacheCapacityBytes, SessionPoolOptions(),
+      /*max_call_batch_size=*/1, /*runtime=*/nullptr,
+      AdaptiveConcurrencyOptions(), value_spill_options);
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root, tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder y(root, tensorflow::DT_INT32);
+  tensorflow::ops::AddV2 out(root, x, y);
+  v0::Value fn =
+      ComputationV(StructB({TensorB(x), TensorB(y)}), TensorB(out), root);
+  SetMetricsEnabled(true);
+  Counter* spilled = MetricsRegistry::Default().GetCounter(
+      "TensorFlowExecutor/SpilledValues");
+  int64_t spilled_before = spilled->value();
+  OwnedValueId fn_id = TFF_ASSERT_OK(executor->CreateValue(fn));
+
+  // No argument fits in the budget, so once they are computed they are
+  // spilled by the next value tracked and read back by their calls.
+  constexpr int kNumCalls = 8;
+  std::vector<OwnedValueId> arg_ids;
+  for (int i = 0; i < kNumCalls; ++i) {
+    v0::Value arg = StructV({TensorV(i), TensorV(1)});
+    arg_ids.push_back(TFF_ASSERT_OK(executor->CreateValue(arg)));
+    EXPECT_THAT(executor->Materialize(arg_ids[i]),
+                IsOkAndHolds(EqualsProto(arg)));
+  }
+  std::vector<OwnedValueId> result_ids;
+  for (int i = 0; i < kNumCalls; ++i) {
+    result_ids.push_back(
+        TFF_ASSERT_OK(executor->CreateCall(fn_id, arg_ids[i])));
+  }
+  for (int i = 0; i < kNumCalls; ++i) {
+    EXPECT_THAT(executor->Materialize(result_ids[i]),
+                IsOkAndHolds(EqualsProto(TensorV(i + 1))));
+  }
+  EXPECT_THAT(spilled->value() - spilled_before, ::testing::Gt(0));
+  SetMetricsEnabled(false);
+}
+
+TEST_F(TensorFlowExecutorTest, CreateCallBatchCallsComputation) {
+  for (int32_t max_call_batch_size : {1, 4}) {
+    std::shared_ptr<Executor> executor = CreateTensorFlowExecutor(
+        /*max_concurrent_computation_calls=*/10,
+        kDefaultComputationCacheCapacityBytes, SessionPoolOptions(),
+        max_call_batch_size);
+    tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+    tensorflow::ops::Placeholder x(root, tensorflow::DT_INT32);
+    tensorflow::ops::Placeholder y(root, tensorflow::DT_INT32);
+    tensorflow::ops::AddV2 out(root, x, y);
+    v0::Value fn =
+        ComputationV(StructB({TensorB(x), TensorB(y)}), TensorB(out), root);
+    OwnedValueId fn_id = TFF_ASSERT_OK(executor->CreateValue(fn));
+
+    constexpr int kNumCalls = 6;
+    std::vector<v0::Value> args;
+    for (int i = 0; i < kNumCalls; ++i) {
+      args.push_back(StructV({TensorV(i), TensorV(1)}));
+    }
+    std::vector<const v0::Value*> arg_pbs;
+    for (const v0::Value& arg : args) {
+      arg_pbs.push_back(&arg);
+    }
+    std::vector<OwnedValueId> arg_ids =
+        TFF_ASSERT_OK(executor->CreateValueBatch(arg_pbs));
+    std::vector<ValueId> arg_refs;
+    for (const OwnedValueId& arg_id : arg_ids) {
+      arg_refs.push_back(arg_id.ref());
+    }
+    std::vector<OwnedValueId> result_ids =
+        TFF_ASSERT_OK(executor->CreateCallBatch(fn_id, arg_refs));
+    ASSERT_EQ(result_ids.size(), kNumCalls);
+    for (int i = 0; i < kNumCalls; ++i) {
+      EXPECT_THAT(executor->Materialize(result_ids[i]),
+                  IsOkAndHolds(EqualsProto(TensorV(i + 1))));
+    }
+  }
+}
+
+TEST_F(TensorFlowExecutorTest, CallsWarmedUpComputations) {
+  tensorflow::Scope root = tensorflow::Scope::NewRootScope();
+  tensorflow::ops::Placeholder x(root, tensorflow::DT_INT32);
+  tensorflow::ops::Placeholder y(root, tensorflow::DT_INT32);
+  tensorflow::ops::AddV2 out(root, x, y);
+  v0::Value fn =
+      ComputationV(StructB({TensorB(x), TensorB(y)}), TensorB(out), root);
+  // Computations which are not TensorFlow computations are skipped.
+  v0::Computation intrinsic_pb;
+  intrinsic_pb.mutable_intrinsic()->set_uri("federated_sum");
+  TFF_ASSERT_OK(WarmUpTensorFlowExecutor(*test_executor_,
+                                         {fn.computation(), intrinsic_pb}));
+
+  EXPECT_THAT(CallAndMaterialize(*test_executor_, fn,
+                                 StructV({TensorV(1), TensorV(2)})),
+              IsOkAndHolds(EqualsProto(TensorV(3))));
+}
+
 }  // namespace
 }  // namespace tensorflow_federated
@@ -18,12 +18,14 @@ limitations under the License
 #include <algorithm>
 #include <complex>
 #include <cstdint>
+#include <cstring>
 #include <string>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "third_party/eigen3/Eigen/Core"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/graph.pb.h"
@@ -63,45 +65,110 @@ tensorflow::PartialTensorShape PartialTensorShapeFromArrayShape(
   }
 }
 
+// Returns an error unless `num_values` values fill `num_elements` elements of
+// `values_per_element` values each.
+static absl::Status CheckNumValues(int64_t num_values, int64_t num_elements,
+                                   int64_t values_per_element = 1) {
+  if (num_values != num_elements * values_per_element) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected ", num_elements * values_per_element,
+        " values for an array of ", num_elements, " elements, found ",
+        num_values, "."));
+  }
+  return absl::OkStatus();
+}
+
 template <typename T>
-static void CopyFromRepeatedField(const google::protobuf::RepeatedField<T>& src,
-                                  T* dest) {
-  std::copy(src.begin(), src.end(), dest);
+static absl::Span<T> TensorData(tensorflow::Tensor& tensor) {
+  auto flat = tensor.flat<T>();
+  return absl::MakeSpan(flat.data(), flat.size());
+}
+
+template <typename T>
+static absl::Status CopyFromRepeatedField(
+    const google::protobuf::RepeatedField<T>& src, absl::Span<T> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size()));
+  if (!dest.empty()) {
+    std::memcpy(dest.data(), src.data(), dest.size() * sizeof(T));
+  }
+  return absl::OkStatus();
 }
 
 // Overload for different SrcType and DestType.
 template <typename SrcType, typename DestType>
-static void CopyFromRepeatedField(const google::protobuf::RepeatedField<SrcType>& src,
-                                  DestType* dest) {
+static absl::Status CopyFromRepeatedField(
+    const google::protobuf::RepeatedField<SrcType>& src,
+    absl::Span<DestType> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size()));
   std::transform(
-      src.begin(), src.end(), dest,
+      src.begin(), src.end(), dest.begin(),
       [](const SrcType& x) -> DestType { return static_cast<DestType>(x); });
+  return absl::OkStatus();
 }
 
 // Overload for Eigen::half.
-static void CopyFromRepeatedField(const google::protobuf::RepeatedField<int32_t>& src,
-                                  Eigen::half* dest) {
+static absl::Status CopyFromRepeatedField(
+    const google::protobuf::RepeatedField<int32_t>& src,
+    absl::Span<Eigen::half> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size()));
   // Values of dtype np.float16 are packed to and unpacked from a protobuf
   // field of type int32 using the following logic in order to maintain
   // compatibility with how other external environments (e.g. TensorFlow, Jax)
   // represent values of np.float16.
-  std::transform(src.begin(), src.end(), dest, [](int x) -> Eigen::half {
-    return Eigen::numext::bit_cast<Eigen::half>(static_cast<uint16_t>(x));
-  });
+  std::transform(src.begin(), src.end(), dest.begin(),
+                 [](int x) -> Eigen::half {
+                   return Eigen::numext::bit_cast<Eigen::half>(
+                       static_cast<uint16_t>(x));
+                 });
+  return absl::OkStatus();
 }
 
 // Overload for complex.
 template <typename T>
-static void CopyFromRepeatedField(const google::protobuf::RepeatedField<T>& src,
-                                  std::complex<T>* dest) {
-  std::copy(src.begin(), src.end(), reinterpret_cast<T*>(dest));
+static absl::Status CopyFromRepeatedField(
+    const google::protobuf::RepeatedField<T>& src,
+    absl::Span<std::complex<T>> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size(), /*values_per_element=*/2));
+  if (!dest.empty()) {
+    std::memcpy(dest.data(), src.data(),
+                dest.size() * sizeof(std::complex<T>));
+  }
+  return absl::OkStatus();
 }
 
 // Overload for string.
-static void CopyFromRepeatedField(
+static absl::Status CopyFromRepeatedField(
     const google::protobuf::RepeatedPtrField<std::string>& src,
-    tensorflow::tstring* dest) {
-  std::copy(src.begin(), src.end(), dest);
+    absl::Span<tensorflow::tstring> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size()));
+  std::copy(src.begin(), src.end(), dest.begin());
+  return absl::OkStatus();
+}
+
+// Creates a tensorflow::Tensor from the raw `content` of a v0::Array.
+static absl::StatusOr<tensorflow::Tensor> TensorFromArrayContent(
+    const v0::Array& array_pb) {
+  // The values of `v0::DataType` match the values of `tensorflow::DataType`.
+  const tensorflow::DataType dtype =
+      static_cast<tensorflow::DataType>(array_pb.dtype());
+  if (dtype == tensorflow::DT_STRING ||
+      !tensorflow::DataTypeCanUseMemcpy(dtype)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Arrays of DataType ", array_pb.dtype(), " can not have `content`."));
+  }
+  tensorflow::Tensor tensor(
+      dtype, TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
+  const std::string& content = array_pb.content();
+  if (content.size() != tensor.TotalBytes()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected ", tensor.TotalBytes(), " bytes of `content` for an array ",
+        "of shape ", tensor.shape().DebugString(), ", found ", content.size(),
+        "."));
+  }
+  if (!content.empty()) {
+    std::memcpy(tensor.data(), content.data(), content.size());
+  }
+  return tensor;
 }
 
 absl::StatusOr<tensorflow::Tensor> TensorFromArray(const v0::Array& array_pb) {
@@ -110,122 +177,125 @@ absl::StatusOr<tensorflow::Tensor> TensorFromArray(const v0::Array& array_pb) {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<bool>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.bool_list().value(),
-                            tensor.flat<bool>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.bool_list().value(),
+                                    TensorData<bool>(tensor)));
       return tensor;
     }
     case v0::Array::kInt8List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<int8_t>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.int8_list().value(),
-                            tensor.flat<int8_t>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.int8_list().value(),
+                                    TensorData<int8_t>(tensor)));
       return tensor;
     }
     case v0::Array::kInt16List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<int16_t>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.int16_list().value(),
-                            tensor.flat<int16_t>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.int16_list().value(),
+                                    TensorData<int16_t>(tensor)));
       return tensor;
     }
     case v0::Array::kInt32List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<int32_t>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.int32_list().value(),
-                            tensor.flat<int32_t>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.int32_list().value(),
+                                    TensorData<int32_t>(tensor)));
       return tensor;
     }
     case v0::Array::kInt64List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<int64_t>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.int64_list().value(),
-                            tensor.flat<int64_t>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.int64_list().value(),
+                                    TensorData<int64_t>(tensor)));
       return tensor;
     }
     case v0::Array::kUint8List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<uint8_t>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.uint8_list().value(),
-                            tensor.flat<uint8_t>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.uint8_list().value(),
+                                    TensorData<uint8_t>(tensor)));
       return tensor;
     }
     case v0::Array::kUint16List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<uint16_t>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.uint16_list().value(),
-                            tensor.flat<uint16_t>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.uint16_list().value(),
+                                    TensorData<uint16_t>(tensor)));
       return tensor;
     }
     case v0::Array::kUint32List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<uint32_t>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.uint32_list().value(),
-                            tensor.flat<uint32_t>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.uint32_list().value(),
+                                    TensorData<uint32_t>(tensor)));
       return tensor;
     }
     case v0::Array::kUint64List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<uint64_t>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.uint64_list().value(),
-                            tensor.flat<uint64_t>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.uint64_list().value(),
+                                    TensorData<uint64_t>(tensor)));
       return tensor;
     }
     case v0::Array::kFloat16List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<Eigen::half>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.float16_list().value(),
-                            tensor.flat<Eigen::half>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.float16_list().value(),
+                                    TensorData<Eigen::half>(tensor)));
       return tensor;
     }
     case v0::Array::kFloat32List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<float>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.float32_list().value(),
-                            tensor.flat<float>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.float32_list().value(),
+                                    TensorData<float>(tensor)));
       return tensor;
     }
     case v0::Array::kFloat64List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<double>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.float64_list().value(),
-                            tensor.flat<double>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.float64_list().value(),
+                                    TensorData<double>(tensor)));
       return tensor;
     }
     case v0::Array::kComplex64List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<tensorflow::complex64>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.complex64_list().value(),
-                            tensor.flat<tensorflow::complex64>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.complex64_list().value(),
+                                    TensorData<tensorflow::complex64>(tensor)));
       return tensor;
     }
     case v0::Array::kComplex128List: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<tensorflow::complex128>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.complex128_list().value(),
-                            tensor.flat<tensorflow::complex128>().data());
+      TFF_TRY(
+          CopyFromRepeatedField(array_pb.complex128_list().value(),
+                                TensorData<tensorflow::complex128>(tensor)));
       return tensor;
     }
     case v0::Array::kStringList: {
       tensorflow::Tensor tensor(
           tensorflow::DataTypeToEnum<tensorflow::tstring>::value,
           TFF_TRY(TensorShapeFromArrayShape(array_pb.shape())));
-      CopyFromRepeatedField(array_pb.string_list().value(),
-                            tensor.flat<tensorflow::tstring>().data());
+      TFF_TRY(CopyFromRepeatedField(array_pb.string_list().value(),
+                                    TensorData<tensorflow::tstring>(tensor)));
       return tensor;
     }
+    case v0::Array::kContent:
+      return TensorFromArrayContent(array_pb);
     default:
       return absl::UnimplementedError(
           absl::StrCat("Unexpected DataType found:", array_pb.kind_case()));
@@ -265,5 +265,53 @@ INSTANTIATE_TEST_SUITE_P(
       return info.param.test_name;
     });
 
+TEST(TensorFromArrayTest, TestReturnsTensor_content) {
+  const float values[] = {1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  v0::Array array_pb;
+  array_pb.set_dtype(v0::DataType::DT_FLOAT);
+  *array_pb.mutable_shape() = testing::CreateArrayShape({3, 2});
+  array_pb.set_content(reinterpret_cast<const char*>(values), sizeof(values));
+
+  const tensorflow::Tensor& actual_tensor =
+      TFF_ASSERT_OK(TensorFromArray(array_pb));
+
+  tensorflow::test::ExpectEqual(
+      actual_tensor,
+      tensorflow::test::AsTensor<float>({1.0, 2.0, 3.0, 4.0, 5.0, 6.0},
+                                        tensorflow::TensorShape({3, 2})));
+}
+
+TEST(TensorFromArrayTest, TestFails_content_size_mismatch) {
+  const float values[] = {1.0, 2.0, 3.0};
+  v0::Array array_pb;
+  array_pb.set_dtype(v0::DataType::DT_FLOAT);
+  *array_pb.mutable_shape() = testing::CreateArrayShape({3, 2});
+  array_pb.set_content(reinterpret_cast<const char*>(values), sizeof(values));
+
+  const absl::StatusOr<tensorflow::Tensor>& result = TensorFromArray(array_pb);
+
+  EXPECT_EQ(result.status().code(), absl::StatusCode::kInvalidArgument);
+}
+
+TEST(TensorFromArrayTest, TestFails_string_content) {
+  v0::Array array_pb;
+  array_pb.set_dtype(v0::DataType::DT_STRING);
+  *array_pb.mutable_shape() = testing::CreateArrayShape({});
+  array_pb.set_content("a");
+
+  const absl::StatusOr<tensorflow::Tensor>& result = TensorFromArray(array_pb);
+
+  EXPECT_EQ(result.status().code(), absl::StatusCode::kInvalidArgument);
+}
+
+TEST(TensorFromArrayTest, TestFails_value_count_mismatch) {
+  const v0::Array& array_pb = TFF_ASSERT_OK(testing::CreateArray(
+      v0::DataType::DT_INT32, testing::CreateArrayShape({2, 3}), {1, 2, 3}));
+
+  const absl::StatusOr<tensorflow::Tensor>& result = TensorFromArray(array_pb);
+
+  EXPECT_EQ(result.status().code(), absl::StatusCode::kInvalidArgument);
+}
+
 }  // namespace
 }  // namespace tensorflow_federated
@@ -15,8 +15,11 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string_view>
 #include <thread>  // NOLINT
 #include <utility>
@@ -24,30 +27,35 @@ limitations under the License
 #include "absl/base/thread_annotations.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
 
 namespace tensorflow_federated {
 
-ThreadPool::ThreadPool(int32_t num_threads, std::string_view name)
-    : pool_name_(name) {
+namespace {
+
+// The pool and queue owned by the current thread, if it is a pool thread.
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue_index = 0;
+
+}  // namespace
+
+ThreadPool::ThreadPool(int32_t num_threads, std::string_view name,
+                       ThreadPoolPolicy policy)
+    : pool_name_(name), metrics_(absl::StrCat("ThreadPool/", pool_name_)) {
   if (num_threads < 1) {
     LOG(QFATAL) << "num_threads must be positive";
   }
+  const int32_t num_queues =
+      policy == ThreadPoolPolicy::kWorkStealing ? num_threads : 1;
+  work_queues_.reserve(num_queues);
+  for (int32_t i = 0; i < num_queues; ++i) {
+    work_queues_.push_back(std::make_unique<WorkQueue>());
+  }
   absl::MutexLock lock(&pool_mutex_);
   for (int32_t i = 0; i < num_threads; ++i) {
-    threads_.emplace_back([this]() {
-      while (true) {
-        pool_mutex_.LockWhen(
-            absl::Condition(this, &ThreadPool::has_work_or_closed));
-        if (work_queue_.empty() && closed_) {
-          pool_mutex_.Unlock();
-          return;
-        }
-        const std::function<void()> f = std::move(work_queue_.front());
-        work_queue_.pop_front();
-        pool_mutex_.Unlock();
-        f();
-      }
+    threads_.emplace_back([this, queue_index = i % num_queues]() {
+      RunWorker(queue_index);
     });
   }
 }
@@ -59,23 +67,105 @@ ThreadPool::~ThreadPool() {
   }
 }
 
-absl::Status ThreadPool::Schedule(std::function<void()> task) {
-  absl::MutexLock lock(&pool_mutex_);
-  if (closed_) {
+void ThreadPool::RunWorker(size_t queue_index) {
+  current_pool = this;
+  current_queue_index = queue_index;
+  while (true) {
+    if (RunNextTask(queue_index)) {
+      continue;
+    }
+    // No work was found. Sleep until more is scheduled or the pool closes.
+    // `sleeping_threads_` is incremented before re-checking for work so that
+    // `Schedule` either observes this thread sleeping and wakes it, or this
+    // thread observes the newly pending task.
+    sleeping_threads_.fetch_add(1);
+    bool done = false;
+    {
+      absl::MutexLock lock(&pool_mutex_);
+      while (!has_work_or_closed()) {
+        work_available_.Wait(&pool_mutex_);
+      }
+      done = closed_.load() && pending_tasks_.load() == 0;
+    }
+    sleeping_threads_.fetch_sub(1);
+    if (done) {
+      return;
+    }
+  }
+}
+
+bool ThreadPool::PopTask(size_t queue_index, QueuedTask& task) {
+  WorkQueue& queue = *work_queues_[queue_index];
+  if (queue.size.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  absl::MutexLock lock(&queue.mutex);
+  if (queue.tasks.empty()) {
+    return false;
+  }
+  task = std::move(queue.tasks.front());
+  queue.tasks.pop_front();
+  queue.size.store(queue.tasks.size(), std::memory_order_relaxed);
+  return true;
+}
+
+bool ThreadPool::RunNextTask(size_t queue_index) {
+  QueuedTask task;
+  // NOTE: work must only be stolen when the thread's own queue is empty, and
+  // must always be taken from the front of a queue; `ThreadRun`'s DAG-safety
+  // relies on both.
+  bool found = PopTask(queue_index, task);
+  for (size_t i = 1; !found && i < work_queues_.size(); ++i) {
+    found = PopTask((queue_index + i) % work_queues_.size(), task);
+  }
+  if (!found) {
+    return false;
+  }
+  pending_tasks_.fetch_sub(1);
+  const int64_t started_nanos = metrics_.TaskStarted(task.queued_nanos);
+  std::move(task.task)();
+  metrics_.TaskFinished(task.queued_nanos, started_nanos);
+  return true;
+}
+
+absl::Status ThreadPool::Schedule(ThreadPoolTask task) {
+  // The task is counted before checking `closed_` so that threads cannot exit
+  // between the check below and the task being queued.
+  pending_tasks_.fetch_add(1);
+  if (closed_.load()) {
+    pending_tasks_.fetch_sub(1);
     return absl::FailedPreconditionError(
         "Called Schedule() on a ThreadPool that is closed.");
   }
-  work_queue_.push_back(std::move(task));
+  const size_t queue_index =
+      current_pool == this
+          ? current_queue_index
+          : next_queue_.fetch_add(1, std::memory_order_relaxed) %
+                work_queues_.size();
+  const int64_t queued_nanos = metrics_.TaskQueued();
+  {
+    WorkQueue& queue = *work_queues_[queue_index];
+    absl::MutexLock lock(&queue.mutex);
+    queue.tasks.push_back({std::move(task), queued_nanos});
+    queue.size.store(queue.tasks.size(), std::memory_order_relaxed);
+  }
+  if (sleeping_threads_.load() > 0) {
+    absl::MutexLock lock(&pool_mutex_);
+    work_available_.Signal();
+  }
   return absl::OkStatus();
 }
 
 bool ThreadPool::has_work_or_closed() ABSL_SHARED_LOCKS_REQUIRED(pool_mutex_) {
-  return !work_queue_.empty() || closed_;
+  return pending_tasks_.load() > 0 || closed_.load();
 }
 
+const ThreadPool* ThreadPool::Current() { return current_pool; }
+
 void ThreadPool::Close() {
   absl::MutexLock lock(&pool_mutex_);
-  closed_ = true;
+  closed_.store(true);
+  work_available_.SignalAll();
 }
 
 bool ParallelTasksInner_::AllDone_() ABSL_SHARED_LOCKS_REQUIRED(mutex_) {
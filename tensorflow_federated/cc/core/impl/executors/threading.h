@@ -16,7 +16,9 @@ limitations under the License
 #ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_THREADING_H_
 #define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_THREADING_H_
 
+#include <atomic>
 #include <chrono>  // NOLINT
+#include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <functional>
@@ -27,28 +29,60 @@ limitations under the License
 #include <thread>  // NOLINT
 #include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 #include "absl/utility/utility.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/task_metrics.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 
 namespace tensorflow_federated {
 
-// A simple thread pool with a single FIFO work-queue.
+// Scheduling policies supported by `ThreadPool`.
+enum class ThreadPoolPolicy {
+  // All threads share a single FIFO work-queue.
+  kSingleQueue,
+  // Each thread owns a FIFO work-queue. Work scheduled from a pool thread is
+  // added to that thread's queue, other work is distributed round-robin. Idle
+  // threads steal the oldest work from the queues of other threads. This
+  // avoids the single lock on the shared queue becoming a point of contention
+  // when many threads schedule many small tasks.
+  kWorkStealing,
+};
+
+// A unit of work run by `ThreadPool`. Tasks are move-only and run at most once;
+// small callables are stored inline, so wrapping one does not heap-allocate.
+using ThreadPoolTask = absl::AnyInvocable<void() &&>;
+
+// A simple thread pool with FIFO work-queues.
+//
+// The pool records how long its tasks wait and run, its queue depth and its
+// active threads as "ThreadPool/<name>/..." metrics of the default
+// `MetricsRegistry` while metrics are enabled; see `TaskMetrics`.
 //
 // This thread pool is safe for tasks that for DAGs of dependencies, as it
 // guarantees that work added to the pool will be run threads in the order added
 // to the pool. The pool is _NOT_ safe from other forms of synchronization and
 // communication, and callers are responsible ensuring threads do not deadlock
 // in such cases.
+//
+// With `ThreadPoolPolicy::kWorkStealing` the order is only guaranteed per
+// queue, but the DAG-safety guarantee is preserved: a thread only steals when
+// its own queue is empty and always steals the oldest work of the victim
+// queue, so every running task was added to the pool before any work still
+// waiting in the queue of the thread running it. A chain of running tasks
+// each waiting on queued work added before it therefore cannot form a cycle.
 class ThreadPool {
  public:
-  ThreadPool(int32_t num_threads, std::string_view name);
+  ThreadPool(int32_t num_threads, std::string_view name,
+             ThreadPoolPolicy policy = ThreadPoolPolicy::kSingleQueue);
   ~ThreadPool();
 
   // Restrict copying and moving.
@@ -60,9 +94,9 @@ class ThreadPool {
   // Adds a task to the work queue to be picked up for a thread in pool when it
   // is free. Will return FailedPrecondition error if the pool is closed (e.g.
   // being destructed).
-  absl::Status Schedule(std::function<void()> task);
+  absl::Status Schedule(ThreadPoolTask task);
 
-  // Returns true iff the work_queue_ has items to process, or the ThreadPool
+  // Returns true iff the work queues have items to process, or the ThreadPool
   // is closed. Intended to be used in a `absl::Condition`.
   bool has_work_or_closed() ABSL_SHARED_LOCKS_REQUIRED(pool_mutex_);
 
@@ -70,12 +104,53 @@ class ThreadPool {
   // `Schedule` invocations will return FailedPrecondition errors.
   void Close();
 
+  // Returns the pool owning the calling thread, or `nullptr` if the calling
+  // thread does not belong to a pool.
+  static const ThreadPool* Current();
+
  private:
+  struct QueuedTask {
+    ThreadPoolTask task;
+    // The time the task was queued, see `TaskMetrics::TaskQueued`.
+    int64_t queued_nanos;
+  };
+
+  struct WorkQueue {
+    absl::Mutex mutex;
+    std::deque<QueuedTask> tasks ABSL_GUARDED_BY(mutex);
+    // Mirrors `tasks.size()` so that empty queues can be skipped without
+    // acquiring `mutex`.
+    std::atomic<size_t> size = 0;
+  };
+
+  // Runs tasks on the calling pool thread until the pool is closed and all
+  // scheduled work has been run.
+  void RunWorker(size_t queue_index);
+
+  // Removes the oldest task from the queue at `queue_index` into `task`.
+  // Returns false if the queue is empty.
+  bool PopTask(size_t queue_index, QueuedTask& task);
+
+  // Runs the oldest task of the queue at `queue_index`, or if that queue is
+  // empty, steals the oldest task of another queue. Returns false if no task
+  // was found.
+  bool RunNextTask(size_t queue_index);
+
   const std::string pool_name_;
+  TaskMetrics metrics_;
+  std::vector<std::unique_ptr<WorkQueue>> work_queues_;
+  // Number of tasks which have been accepted by `Schedule` but not yet removed
+  // from a work queue.
+  std::atomic<int64_t> pending_tasks_ = 0;
+  // Number of threads blocked on `pool_mutex_` waiting for work.
+  std::atomic<int32_t> sleeping_threads_ = 0;
+  // Used to distribute work scheduled from outside the pool across queues.
+  std::atomic<uint64_t> next_queue_ = 0;
+  std::atomic<bool> closed_ = false;
+  // Sleeping threads wait on `work_available_` for `has_work_or_closed`.
   absl::Mutex pool_mutex_;
-  bool closed_ ABSL_GUARDED_BY(pool_mutex_) = false;
+  absl::CondVar work_available_;
   std::vector<std::thread> threads_ ABSL_GUARDED_BY(pool_mutex_);
-  std::deque<std::function<void()>> work_queue_ ABSL_GUARDED_BY(pool_mutex_);
 };
 
 // Runs the provided provided no-arg function on another thread, returning a
@@ -95,17 +170,13 @@ template <typename Func,
           typename ReturnValue = typename std::result_of_t<Func()>>
 std::shared_future<ReturnValue> ThreadRun(Func lambda,
                                           ThreadPool* thread_pool = nullptr) {
-  using TaskT = std::packaged_task<ReturnValue()>;
-  TaskT task(std::move(lambda));
+  // The packaged task keeps `lambda` and its result in a single shared state,
+  // and is itself small enough to be stored inline in a `ThreadPoolTask`, so
+  // this is the only allocation made per call.
+  std::packaged_task<ReturnValue()> task(std::move(lambda));
   auto future_ptr = std::shared_future<ReturnValue>(task.get_future());
   if (thread_pool != nullptr) {
-    // Attempting to directly move the task results in a compiler error,
-    // possibly when trying to construct the `std::function<void()>` which may
-    // be trying to make a _copy_ of the lambda capture values which are not
-    // always copy constructable (especially in the case of ExecutorValue).
-    // Wrapping in a `shared_ptr` makes this possible.
-    thread_pool->Schedule(
-        [t = std::make_shared<TaskT>(std::move(task))]() { (*t)(); });
+    thread_pool->Schedule(std::move(task));
   } else {
     std::thread th(std::move(task));
     th.detach();
@@ -230,6 +301,271 @@ absl::StatusOr<ValueFuture> Map(std::vector<ValueFuture>&& futures, Func lambda,
       thread_pool);
 }
 
+template <typename T>
+class SharedFuture;
+template <typename T>
+class SharedPromise;
+
+template <typename T>
+class SharedFutureInner_ {
+ private:
+  friend class SharedFuture<T>;
+  friend class SharedPromise<T>;
+  absl::Mutex mutex_;
+  bool ready_ ABSL_GUARDED_BY(mutex_) = false;
+  // Only written before `ready_` is set, and only read after.
+  absl::StatusOr<T> result_;
+  std::vector<absl::AnyInvocable<void(const absl::StatusOr<T>&) &&>>
+      continuations_ ABSL_GUARDED_BY(mutex_);
+};
+
+// A copyable handle to an `absl::StatusOr<T>` which is set once by a
+// `SharedPromise<T>`, like a `std::shared_future`, to which continuations can
+// be attached with `Then`.
+//
+// This offers the `wait`, `wait_for` and `get` methods of `std::shared_future`,
+// so that `Wait` and `AllReady` accept either kind of future.
+template <typename T>
+class SharedFuture {
+ public:
+  // Returns a future which already holds `result`.
+  static SharedFuture Ready(absl::StatusOr<T> result) {
+    SharedPromise<T> promise;
+    SharedFuture future = promise.future();
+    promise.Set(std::move(result));
+    return future;
+  }
+
+  void wait() const {
+    absl::MutexLock lock(&inner_->mutex_);
+    inner_->mutex_.Await(absl::Condition(&inner_->ready_));
+  }
+
+  template <typename Rep, typename Period>
+  std::future_status wait_for(
+      const std::chrono::duration<Rep, Period>& timeout) const {
+    const auto timeout_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(timeout);
+    absl::MutexLock lock(&inner_->mutex_);
+    return inner_->mutex_.AwaitWithTimeout(absl::Condition(&inner_->ready_),
+                                           absl::FromChrono(timeout_ns))
+               ? std::future_status::ready
+               : std::future_status::timeout;
+  }
+
+  // Waits for the result and returns it.
+  const absl::StatusOr<T>& get() const {
+    wait();
+    return inner_->result_;
+  }
+
+  // Runs `continuation` on the result once it is set: on the thread which sets
+  // it, or right away on the calling thread if it is set already.
+  // Continuations should therefore be cheap, e.g. only schedule further work.
+  void Then(absl::AnyInvocable<void(const absl::StatusOr<T>&) &&> continuation)
+      const {
+    {
+      absl::MutexLock lock(&inner_->mutex_);
+      if (!inner_->ready_) {
+        inner_->continuations_.push_back(std::move(continuation));
+        return;
+      }
+    }
+    std::move(continuation)(inner_->result_);
+  }
+
+ private:
+  friend class SharedPromise<T>;
+  explicit SharedFuture(std::shared_ptr<SharedFutureInner_<T>> inner)
+      : inner_(std::move(inner)) {}
+
+  std::shared_ptr<SharedFutureInner_<T>> inner_;
+};
+
+// The producer side of a `SharedFuture<T>`. A promise which is destroyed
+// before it is set sets its future to a `CANCELLED` error, e.g. if the task
+// which held it was dropped by a closed `ThreadPool`.
+template <typename T>
+class SharedPromise {
+ public:
+  SharedPromise() : inner_(std::make_shared<SharedFutureInner_<T>>()) {}
+  SharedPromise(SharedPromise&& other) = default;
+  SharedPromise& operator=(SharedPromise&& other) = delete;
+  SharedPromise(const SharedPromise&) = delete;
+  SharedPromise& operator=(const SharedPromise&) = delete;
+
+  ~SharedPromise() {
+    if (inner_ != nullptr && !set_) {
+      Set(absl::CancelledError("The result of the future was abandoned."));
+    }
+  }
+
+  SharedFuture<T> future() const { return SharedFuture<T>(inner_); }
+
+  // Sets the result of the future and runs its continuations on the calling
+  // thread. Must be called at most once.
+  void Set(absl::StatusOr<T> result) {
+    set_ = true;
+    std::vector<absl::AnyInvocable<void(const absl::StatusOr<T>&) &&>>
+        continuations;
+    {
+      absl::MutexLock lock(&inner_->mutex_);
+      inner_->result_ = std::move(result);
+      inner_->ready_ = true;
+      continuations.swap(inner_->continuations_);
+    }
+    for (auto& continuation : continuations) {
+      std::move(continuation)(inner_->result_);
+    }
+  }
+
+ private:
+  std::shared_ptr<SharedFutureInner_<T>> inner_;
+  bool set_ = false;
+};
+
+// Like `GetAll` above, for `SharedFuture`s.
+template <typename T>
+std::vector<T> GetAll(
+    const absl::Span<const SharedFuture<T>> successfully_completed_futures) {
+  std::vector<T> out;
+  out.reserve(successfully_completed_futures.size());
+  for (const SharedFuture<T>& future : successfully_completed_futures) {
+    out.emplace_back(future.get().value());
+  }
+  return out;
+}
+
+// Like `WaitAll` above, for `SharedFuture`s.
+template <typename T>
+absl::StatusOr<std::vector<T>> WaitAll(
+    const absl::Span<const SharedFuture<T>> futures) {
+  for (const SharedFuture<T>& future : futures) {
+    TFF_TRY(future.get().status());
+  }
+  return GetAll(futures);
+}
+
+// Calls `callback` with the results of all of `futures` once they are all
+// set, on the thread which sets the last of them. No thread waits for them
+// meanwhile.
+template <typename T, typename Callback>
+void WhenAll(std::vector<SharedFuture<T>> futures, Callback callback) {
+  struct Join {
+    std::vector<SharedFuture<T>> futures;
+    std::atomic<size_t> remaining;
+    Callback callback;
+  };
+  if (futures.empty()) {
+    std::move(callback)(std::vector<absl::StatusOr<T>>());
+    return;
+  }
+  const size_t num_futures = futures.size();
+  auto join = std::shared_ptr<Join>(
+      new Join{std::move(futures), {num_futures}, std::move(callback)});
+  for (size_t i = 0; i < num_futures; ++i) {
+    join->futures[i].Then([join](const absl::StatusOr<T>&) {
+      if (join->remaining.fetch_sub(1) != 1) {
+        return;
+      }
+      std::vector<absl::StatusOr<T>> results;
+      results.reserve(join->futures.size());
+      for (const SharedFuture<T>& future : join->futures) {
+        results.push_back(future.get());
+      }
+      std::move(join->callback)(std::move(results));
+    });
+  }
+}
+
+// Returns the values of `results`, or the first of their errors.
+template <typename T>
+absl::StatusOr<std::vector<T>> AllValues(
+    std::vector<absl::StatusOr<T>>&& results) {
+  std::vector<T> values;
+  values.reserve(results.size());
+  for (absl::StatusOr<T>& result : results) {
+    values.push_back(TFF_TRY(std::move(result)));
+  }
+  return values;
+}
+
+// Like `Map` above, but for `SharedFuture`s: `lambda` runs as a continuation
+// of `futures`, inline on the thread which completes the last of them, rather
+// than on a thread waiting for them. This suits cheap operations, such as
+// building structures out of the results of other operations.
+template <typename Func, typename T,
+          typename Result = typename std::invoke_result_t<
+              Func, std::vector<T>&&>::value_type>
+absl::StatusOr<SharedFuture<Result>> Map(std::vector<SharedFuture<T>>&& futures,
+                                         Func lambda) {
+  TFF_TRY(AllReady(futures));
+  SharedPromise<Result> promise;
+  SharedFuture<Result> result = promise.future();
+  WhenAll(std::move(futures),
+          [promise = std::move(promise), lambda = std::move(lambda)](
+              std::vector<absl::StatusOr<T>>&& results) mutable {
+            absl::StatusOr<std::vector<T>> values =
+                AllValues(std::move(results));
+            if (!values.ok()) {
+              promise.Set(values.status());
+              return;
+            }
+            promise.Set(lambda(*std::move(values)));
+          });
+  return result;
+}
+
+// Schedules `lambda` on `thread_pool` once all of `futures` are ready, and
+// returns a future to its result. If `thread_pool` is `nullptr`, `lambda` runs
+// on a new thread instead. Unlike `ThreadRun`, no thread is held waiting for
+// `futures` in the meantime, so the work scheduled on the pool never blocks on
+// other work.
+template <typename Func, typename T,
+          typename Result = typename std::invoke_result_t<
+              Func, std::vector<T>&&>::value_type>
+SharedFuture<Result> MapOnPool(std::vector<SharedFuture<T>> futures,
+                               Func lambda, ThreadPool* thread_pool) {
+  SharedPromise<Result> promise;
+  SharedFuture<Result> result = promise.future();
+  WhenAll(std::move(futures),
+          [promise = std::move(promise), lambda = std::move(lambda),
+           thread_pool](std::vector<absl::StatusOr<T>>&& results) mutable {
+            absl::StatusOr<std::vector<T>> values =
+                AllValues(std::move(results));
+            if (!values.ok()) {
+              promise.Set(values.status());
+              return;
+            }
+            ThreadPoolTask task = [promise = std::move(promise),
+                                   lambda = std::move(lambda),
+                                   values = *std::move(values)]() mutable {
+              promise.Set(lambda(std::move(values)));
+            };
+            if (thread_pool != nullptr) {
+              // If the pool is closed, the task and its promise are dropped,
+              // which cancels the result.
+              thread_pool->Schedule(std::move(task)).IgnoreError();
+            } else {
+              std::thread(std::move(task)).detach();
+            }
+          });
+  return result;
+}
+
+// Runs `lambda` on `thread_pool`, or on a new thread if it is `nullptr`, and
+// returns a future to its result. `lambda` returns an `absl::StatusOr`.
+template <typename Func, typename Result = typename std::invoke_result_t<
+                             Func>::value_type>
+SharedFuture<Result> RunOnPool(Func lambda, ThreadPool* thread_pool) {
+  return MapOnPool(
+      std::vector<SharedFuture<std::monostate>>(),
+      [lambda = std::move(lambda)](std::vector<std::monostate>&&) mutable {
+        return lambda();
+      },
+      thread_pool);
+}
+
 class ParallelTasksInner_ {
  private:
   friend class ParallelTasks;
@@ -0,0 +1,78 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "include/benchmark/benchmark.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+
+namespace tensorflow_federated {
+namespace {
+
+constexpr int32_t kNumThreads = 64;
+constexpr int32_t kTasksPerProducer = 20000;
+
+// Benchmarks the lock contention of a large pool with `state.range(0)`
+// policy, onto which `state.range(1)` producer threads schedule many tiny
+// tasks.
+static void BM_ScheduleTinyTasksContended(benchmark::State& state) {
+  const auto policy = static_cast<ThreadPoolPolicy>(state.range(0));
+  const int32_t num_producers = state.range(1);
+  const int64_t num_tasks = int64_t{num_producers} * kTasksPerProducer;
+  ThreadPool pool(kNumThreads, /*name=*/"bench", policy);
+  int64_t items_processed = 0;
+
+  // Benchmark time is only measured in the loop body.
+  for (auto s : state) {
+    std::atomic<int64_t> counter(0);
+    absl::Notification done;
+    std::vector<std::thread> producers;
+    producers.reserve(num_producers);
+    for (int32_t p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&pool, &counter, &done, num_tasks]() {
+        for (int32_t i = 0; i < kTasksPerProducer; ++i) {
+          benchmark::DoNotOptimize(
+              pool.Schedule([&counter, &done, num_tasks]() {
+                if (counter.fetch_add(1, std::memory_order_relaxed) + 1 ==
+                    num_tasks) {
+                  done.Notify();
+                }
+              }));
+        }
+      });
+    }
+    for (std::thread& producer : producers) {
+      producer.join();
+    }
+    done.WaitForNotification();
+    items_processed += num_tasks;
+  }
+  state.SetItemsProcessed(items_processed);
+}
+
+BENCHMARK(BM_ScheduleTinyTasksContended)
+    ->ArgNames({"policy", "producers"})
+    ->ArgsProduct({{static_cast<int64_t>(ThreadPoolPolicy::kSingleQueue),
+                    static_cast<int64_t>(ThreadPoolPolicy::kWorkStealing)},
+                   {1, 8}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -15,19 +15,31 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdint>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "googlemock/include/gmock/gmock.h"
 #include "googletest/include/gtest/gtest.h"
 #include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/synchronization/notification.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/testing/status_matchers.h"
 
 namespace tensorflow_federated {
@@ -116,6 +128,152 @@ TEST_F(ThreadPoolTest, ShuttingDownPoolErrorsOnSchedule) {
                        testing::HasSubstr("closed")));
 }
 
+TEST_F(ThreadPoolTest, RunsMoveOnlyTask) {
+  ThreadPool pool(/*num_threads=*/1, /*name=*/"test");
+  absl::Notification done;
+  int32_t result = 0;
+  auto value = std::make_unique<int32_t>(42);
+  TFF_ASSERT_OK(
+      pool.Schedule([value = std::move(value), &result, &done]() mutable {
+        result = *value;
+        done.Notify();
+      }));
+  done.WaitForNotification();
+  EXPECT_EQ(result, 42);
+}
+
+TEST_F(ThreadPoolTest, ThreadRunWithMoveOnlyCapture) {
+  ThreadPool pool(/*num_threads=*/2, /*name=*/"test");
+  auto value = std::make_unique<int32_t>(7);
+  std::shared_future<int32_t> future = ThreadRun(
+      [value = std::move(value)]() { return *value * 6; }, &pool);
+  EXPECT_EQ(future.get(), 42);
+}
+
+class ThreadPoolPolicyTest
+    : public ::testing::TestWithParam<ThreadPoolPolicy> {};
+
+TEST_P(ThreadPoolPolicyTest, MultipleThreads) {
+  constexpr int32_t NUM_WORK = 100;
+  ThreadPool pool(/*num_threads=*/10, /*name=*/"test", GetParam());
+  absl::Mutex results_mutex;
+  std::vector<int32_t> results ABSL_GUARDED_BY(results_mutex), expected_results;
+  results.reserve(NUM_WORK);
+  expected_results.reserve(NUM_WORK);
+  absl::BlockingCounter blocking_counter(NUM_WORK);
+  for (int i = 0; i < NUM_WORK; ++i) {
+    expected_results.push_back(i);
+    TFF_ASSERT_OK(
+        pool.Schedule([&results, &results_mutex, &blocking_counter, i]() {
+          {
+            absl::MutexLock lock(&results_mutex);
+            results.push_back(i);
+          }
+          blocking_counter.DecrementCount();
+        }));
+  }
+  blocking_counter.Wait();
+  ASSERT_THAT(results, testing::UnorderedElementsAreArray(expected_results));
+}
+
+TEST_P(ThreadPoolPolicyTest, DagOfFuturesCompletes) {
+  constexpr int32_t NUM_LAYERS = 20;
+  constexpr int32_t LAYER_WIDTH = 8;
+  ThreadPool pool(/*num_threads=*/2, /*name=*/"test", GetParam());
+  std::vector<std::shared_future<int32_t>> previous_layer;
+  for (int32_t i = 0; i < LAYER_WIDTH; ++i) {
+    previous_layer.push_back(ThreadRun([]() { return 1; }, &pool));
+  }
+  for (int32_t layer = 1; layer < NUM_LAYERS; ++layer) {
+    std::vector<std::shared_future<int32_t>> current_layer;
+    for (int32_t i = 0; i < LAYER_WIDTH; ++i) {
+      current_layer.push_back(ThreadRun(
+          [inputs = previous_layer]() {
+            int32_t sum = 0;
+            for (const auto& input : inputs) {
+              sum = std::max(sum, input.get());
+            }
+            return sum + 1;
+          },
+          &pool));
+    }
+    previous_layer = std::move(current_layer);
+  }
+  for (const auto& output : previous_layer) {
+    EXPECT_EQ(output.get(), NUM_LAYERS);
+  }
+}
+
+TEST_P(ThreadPoolPolicyTest, RecordsTaskMetrics) {
+  constexpr int32_t NUM_WORK = 100;
+  const std::string name =
+      absl::StrCat("metrics_test_", static_cast<int>(GetParam()));
+  SetMetricsEnabled(true);
+  {
+    ThreadPool pool(/*num_threads=*/4, name, GetParam());
+    for (int i = 0; i < NUM_WORK; ++i) {
+      TFF_ASSERT_OK(pool.Schedule([]() {}));
+    }
+    // Destroying the pool waits for all of its tasks to finish.
+  }
+  SetMetricsEnabled(false);
+  MetricsRegistry& registry = MetricsRegistry::Default();
+  const std::string prefix = absl::StrCat("ThreadPool/", name);
+  EXPECT_EQ(
+      registry.GetLatencyHistogram(absl::StrCat(prefix, "/QueueWait"))->count(),
+      NUM_WORK);
+  EXPECT_EQ(registry.GetLatencyHistogram(absl::StrCat(prefix, "/Run"))->count(),
+            NUM_WORK);
+  EXPECT_EQ(registry.GetGauge(absl::StrCat(prefix, "/QueueDepth"))->value(), 0);
+  EXPECT_EQ(registry.GetGauge(absl::StrCat(prefix, "/ActiveThreads"))->value(),
+            0);
+}
+
+TEST_P(ThreadPoolPolicyTest, ShuttingDownPoolErrorsOnSchedule) {
+  ThreadPool pool(/*num_threads=*/4, /*name=*/"test", GetParam());
+  pool.Close();
+  ASSERT_THAT(pool.Schedule([]() {}),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       testing::HasSubstr("closed")));
+}
+
+// Many producer threads schedule tasks concurrently; all of them run. The
+// throughput under contention is measured by threading_bench.
+TEST_P(ThreadPoolPolicyTest, ConcurrentProducersRunAllTasks) {
+  constexpr int32_t NUM_PRODUCERS = 4;
+  constexpr int32_t TASKS_PER_PRODUCER = 250;
+  constexpr int64_t NUM_TASKS = NUM_PRODUCERS * TASKS_PER_PRODUCER;
+  ThreadPool pool(/*num_threads=*/8, /*name=*/"test", GetParam());
+  std::atomic<int64_t> counter(0);
+  absl::Notification done;
+  ParallelTasks producers;
+  for (int32_t p = 0; p < NUM_PRODUCERS; ++p) {
+    TFF_ASSERT_OK(producers.add_task([&pool, &counter, &done]() {
+      for (int32_t i = 0; i < TASKS_PER_PRODUCER; ++i) {
+        TFF_TRY(pool.Schedule([&counter, &done]() {
+          if (counter.fetch_add(1, std::memory_order_relaxed) + 1 ==
+              NUM_TASKS) {
+            done.Notify();
+          }
+        }));
+      }
+      return absl::OkStatus();
+    }));
+  }
+  TFF_ASSERT_OK(producers.WaitAll());
+  done.WaitForNotification();
+  EXPECT_EQ(counter.load(), NUM_TASKS);
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ThreadPoolPolicies, ThreadPoolPolicyTest,
+    ::testing::Values(ThreadPoolPolicy::kSingleQueue,
+                      ThreadPoolPolicy::kWorkStealing),
+    [](const ::testing::TestParamInfo<ThreadPoolPolicy>& info) {
+      return info.param == ThreadPoolPolicy::kSingleQueue ? "SingleQueue"
+                                                          : "WorkStealing";
+    });
+
 class ParallelTasksTest : public ::testing::Test {};
 
 TEST_F(ParallelTasksTest, EmptyIsOk) {
@@ -181,6 +339,89 @@ TEST_F(ParallelTasksTest, WithThreadPool) {
   EXPECT_EQ(counter.load(), NUM_THREADS * 2);
 }
 
+class SharedFutureTest : public ::testing::Test {};
+
+TEST_F(SharedFutureTest, ThenRunsOnceSet) {
+  SharedPromise<int32_t> promise;
+  SharedFuture<int32_t> future = promise.future();
+  int32_t result = 0;
+  future.Then([&result](const absl::StatusOr<int32_t>& value) {
+    result = value.value();
+  });
+  EXPECT_EQ(result, 0);
+  promise.Set(1);
+  EXPECT_EQ(result, 1);
+  EXPECT_EQ(future.get().value(), 1);
+}
+
+TEST_F(SharedFutureTest, ThenRunsInlineWhenReady) {
+  SharedFuture<int32_t> future = SharedFuture<int32_t>::Ready(1);
+  int32_t result = 0;
+  future.Then([&result](const absl::StatusOr<int32_t>& value) {
+    result = value.value();
+  });
+  EXPECT_EQ(result, 1);
+}
+
+TEST_F(SharedFutureTest, DestroyedPromiseCancelsFuture) {
+  std::optional<SharedFuture<int32_t>> future;
+  {
+    SharedPromise<int32_t> promise;
+    future = promise.future();
+    EXPECT_EQ(future->wait_for(std::chrono::seconds(0)),
+              std::future_status::timeout);
+  }
+  EXPECT_EQ(future->wait_for(std::chrono::seconds(0)),
+            std::future_status::ready);
+  EXPECT_THAT(future->get(), StatusIs(StatusCode::kCancelled));
+}
+
+TEST_F(SharedFutureTest, MapRunsOnThreadCompletingLastInput) {
+  SharedPromise<int32_t> promise;
+  std::vector<SharedFuture<int32_t>> futures = {
+      SharedFuture<int32_t>::Ready(1), promise.future()};
+  SharedFuture<int32_t> sum = TFF_ASSERT_OK(Map(
+      std::move(futures),
+      [](std::vector<int32_t>&& values) -> absl::StatusOr<int32_t> {
+        return values[0] + values[1];
+      }));
+  EXPECT_EQ(sum.wait_for(std::chrono::seconds(0)),
+            std::future_status::timeout);
+  promise.Set(2);
+  // The sum was computed inline by `Set`.
+  EXPECT_EQ(sum.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+  EXPECT_EQ(sum.get().value(), 3);
+}
+
+TEST_F(SharedFutureTest, MapReturnsErrorOfInput) {
+  SharedPromise<int32_t> promise;
+  std::vector<SharedFuture<int32_t>> futures = {promise.future()};
+  SharedFuture<int32_t> result = TFF_ASSERT_OK(
+      Map(std::move(futures),
+          [](std::vector<int32_t>&& values) -> absl::StatusOr<int32_t> {
+            return values[0];
+          }));
+  promise.Set(absl::UnimplementedError(""));
+  EXPECT_THAT(result.get(), StatusIs(StatusCode::kUnimplemented));
+}
+
+TEST_F(SharedFutureTest, MapOnPoolDoesNotBlockPoolThreads) {
+  ThreadPool pool(/*num_threads=*/1, /*name=*/"test");
+  SharedPromise<int32_t> promise;
+  SharedFuture<int32_t> first = MapOnPool(
+      std::vector<SharedFuture<int32_t>>{promise.future()},
+      [](std::vector<int32_t>&& values) -> absl::StatusOr<int32_t> {
+        return values[0] + 1;
+      },
+      &pool);
+  // With the only pool thread waiting for `promise`, this would never run.
+  SharedFuture<int32_t> second =
+      RunOnPool([]() -> absl::StatusOr<int32_t> { return 10; }, &pool);
+  EXPECT_EQ(second.get().value(), 10);
+  promise.Set(1);
+  EXPECT_EQ(first.get().value(), 2);
+}
+
 }  // namespace
 
 }  // namespace tensorflow_federated
@@ -0,0 +1,193 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/tracked_bytes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/call_once.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+std::atomic<bool> debugging_enabled = false;
+
+// The live TrackedBytes, for the functions acting on all executors.
+struct LiveTrackedBytes {
+  absl::Mutex mutex;
+  std::set<TrackedBytes*> tracked_bytes ABSL_GUARDED_BY(mutex);
+};
+
+LiveTrackedBytes& GetLiveTrackedBytes() {
+  static LiveTrackedBytes* live = new LiveTrackedBytes();
+  return *live;
+}
+
+void SetToMax(std::atomic<int64_t>& value, int64_t candidate) {
+  int64_t current = value.load(std::memory_order_relaxed);
+  while (current < candidate &&
+         !value.compare_exchange_weak(current, candidate,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+}  // namespace
+
+TrackedBytes::TrackedBytes() {
+  LiveTrackedBytes& live = GetLiveTrackedBytes();
+  absl::MutexLock lock(&live.mutex);
+  live.tracked_bytes.insert(this);
+}
+
+TrackedBytes::~TrackedBytes() {
+  LiveTrackedBytes& live = GetLiveTrackedBytes();
+  absl::MutexLock lock(&live.mutex);
+  live.tracked_bytes.erase(this);
+}
+
+int64_t TrackedBytes::Tracked(std::string_view layer, uint64_t id,
+                              int64_t bytes) {
+  if (!MetricsEnabled()) {
+    return kNotRecorded;
+  }
+  absl::call_once(init_once_, [this, layer]() {
+    layer_ = std::string(layer);
+    MetricsRegistry& registry = MetricsRegistry::Default();
+    values_gauge_ = registry.GetGauge(absl::StrCat(layer_, "/TrackedValues"));
+    bytes_gauge_ = registry.GetGauge(absl::StrCat(layer_, "/TrackedBytes"));
+    high_water_gauge_ =
+        registry.GetGauge(absl::StrCat(layer_, "/TrackedBytesHighWater"));
+    initialized_.store(true, std::memory_order_release);
+  });
+  values_.fetch_add(1, std::memory_order_relaxed);
+  SetToMax(high_water_bytes_,
+           bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+  values_gauge_->Add(1);
+  high_water_gauge_->SetToMax(bytes_gauge_->Add(bytes));
+  if (TrackedBytesDebugging()) {
+    absl::MutexLock lock(&debug_mutex_);
+    debug_values_[id] = bytes;
+    has_debug_values_.store(true, std::memory_order_relaxed);
+  }
+  return bytes;
+}
+
+void TrackedBytes::Untracked(uint64_t id, int64_t bytes) {
+  if (bytes == kNotRecorded) {
+    return;
+  }
+  values_.fetch_sub(1, std::memory_order_relaxed);
+  bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+  values_gauge_->Add(-1);
+  bytes_gauge_->Add(-bytes);
+  if (has_debug_values_.load(std::memory_order_relaxed)) {
+    absl::MutexLock lock(&debug_mutex_);
+    debug_values_.erase(id);
+  }
+}
+
+std::string TrackedBytes::layer() const {
+  if (!initialized_.load(std::memory_order_acquire)) {
+    return "";
+  }
+  return layer_;
+}
+
+std::vector<std::pair<uint64_t, int64_t>> TrackedBytes::LargestValues(
+    size_t n) const {
+  std::vector<std::pair<uint64_t, int64_t>> values;
+  {
+    absl::MutexLock lock(&debug_mutex_);
+    values.assign(debug_values_.begin(), debug_values_.end());
+  }
+  auto larger = [](const std::pair<uint64_t, int64_t>& a,
+                   const std::pair<uint64_t, int64_t>& b) {
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+  };
+  n = std::min(n, values.size());
+  std::partial_sort(values.begin(), values.begin() + n, values.end(), larger);
+  values.resize(n);
+  return values;
+}
+
+void TrackedBytes::ResetHighWater() {
+  high_water_bytes_.store(bytes(), std::memory_order_relaxed);
+  if (initialized_.load(std::memory_order_acquire)) {
+    high_water_gauge_->Set(bytes_gauge_->value());
+  }
+}
+
+void TrackedBytes::ClearDebugValues() {
+  absl::MutexLock lock(&debug_mutex_);
+  debug_values_.clear();
+  has_debug_values_.store(false, std::memory_order_relaxed);
+}
+
+void SetTrackedBytesDebugging(bool enabled) {
+  debugging_enabled.store(enabled, std::memory_order_relaxed);
+  if (!enabled) {
+    LiveTrackedBytes& live = GetLiveTrackedBytes();
+    absl::MutexLock lock(&live.mutex);
+    for (TrackedBytes* tracked_bytes : live.tracked_bytes) {
+      tracked_bytes->ClearDebugValues();
+    }
+  }
+}
+
+bool TrackedBytesDebugging() {
+  return debugging_enabled.load(std::memory_order_relaxed);
+}
+
+void ResetTrackedBytesHighWaterMarks() {
+  LiveTrackedBytes& live = GetLiveTrackedBytes();
+  absl::MutexLock lock(&live.mutex);
+  for (TrackedBytes* tracked_bytes : live.tracked_bytes) {
+    tracked_bytes->ResetHighWater();
+  }
+}
+
+std::string DumpLargestTrackedValues(size_t n) {
+  LiveTrackedBytes& live = GetLiveTrackedBytes();
+  absl::MutexLock lock(&live.mutex);
+  std::string dump;
+  for (const TrackedBytes* tracked_bytes : live.tracked_bytes) {
+    std::string layer = tracked_bytes->layer();
+    if (layer.empty()) {
+      continue;
+    }
+    absl::StrAppend(&dump, layer, ": ", tracked_bytes->values(), " values, ",
+                    tracked_bytes->bytes(), " bytes, high water ",
+                    tracked_bytes->high_water_bytes(), " bytes\n");
+    for (const auto& [id, bytes] : tracked_bytes->LargestValues(n)) {
+      absl::StrAppend(&dump, "  value ", id, ": ", bytes, " bytes\n");
+    }
+  }
+  return dump;
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,132 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_TRACKED_BYTES_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_TRACKED_BYTES_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/call_once.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+
+namespace tensorflow_federated {
+
+// Accounts the approximate number of bytes of the values tracked by an
+// executor, so that leaked `OwnedValueId`s and the memory pinned by each layer
+// of an executor stack can be found.
+//
+// While metrics are enabled (see `SetMetricsEnabled`), the values tracked by
+// the executors of a layer named `layer` are recorded in the gauges of the
+// default `MetricsRegistry`:
+//
+//   - "<layer>/TrackedValues": the number of values tracked.
+//   - "<layer>/TrackedBytes": their approximate size in bytes.
+//   - "<layer>/TrackedBytesHighWater": the highest size since the last call
+//     to `ResetTrackedBytesHighWaterMarks`, e.g. at the start of a round.
+//
+// Executors of the same layer share the gauges. A value tracked while metrics
+// are disabled is not accounted, even once it is untracked.
+//
+// This class is thread safe.
+class TrackedBytes {
+ public:
+  // The bytes of a value which isn't accounted.
+  static constexpr int64_t kNotRecorded = -1;
+
+  TrackedBytes();
+  ~TrackedBytes();
+
+  TrackedBytes(const TrackedBytes&) = delete;
+  TrackedBytes& operator=(const TrackedBytes&) = delete;
+
+  // Records that the executor tracks the value `id` of approximately `bytes`
+  // bytes, as a layer named `layer`, which must be the same for all values.
+  // Returns the bytes to pass to `Untracked`, or `kNotRecorded` if metrics are
+  // disabled.
+  int64_t Tracked(std::string_view layer, uint64_t id, int64_t bytes);
+
+  // Records that the executor no longer tracks the value `id`, for which
+  // `Tracked` returned `bytes`.
+  void Untracked(uint64_t id, int64_t bytes);
+
+  // The number and size of the values accounted in this executor, and the
+  // highest size since the last reset.
+  int64_t values() const { return values_.load(std::memory_order_relaxed); }
+  int64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+  int64_t high_water_bytes() const {
+    return high_water_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the name of the layer, which is empty until a value is tracked.
+  std::string layer() const;
+
+  // Returns the IDs and sizes of the `n` largest values tracked while
+  // debugging is enabled (see `SetTrackedBytesDebugging`), largest first.
+  std::vector<std::pair<uint64_t, int64_t>> LargestValues(size_t n) const;
+
+  // Resets the high-water mark of this executor, and of its layer, to the
+  // current size.
+  void ResetHighWater();
+
+  // Forgets the values recorded for debugging.
+  void ClearDebugValues();
+
+ private:
+  absl::once_flag init_once_;
+  // Set once the layer and gauges below are.
+  std::atomic<bool> initialized_ = false;
+  std::string layer_;
+  Gauge* values_gauge_ = nullptr;
+  Gauge* bytes_gauge_ = nullptr;
+  Gauge* high_water_gauge_ = nullptr;
+
+  std::atomic<int64_t> values_ = 0;
+  std::atomic<int64_t> bytes_ = 0;
+  std::atomic<int64_t> high_water_bytes_ = 0;
+
+  // Whether `debug_values_` may be non-empty.
+  std::atomic<bool> has_debug_values_ = false;
+  mutable absl::Mutex debug_mutex_;
+  absl::flat_hash_map<uint64_t, int64_t> debug_values_
+      ABSL_GUARDED_BY(debug_mutex_);
+};
+
+// Sets whether executors record the size of each value they track, in addition
+// to their totals, for `DumpLargestTrackedValues`. Disabling debugging forgets
+// the recorded values. Disabled by default.
+void SetTrackedBytesDebugging(bool enabled);
+bool TrackedBytesDebugging();
+
+// Resets the high-water marks of all executors to their current sizes, so
+// that the marks cover e.g. a single round of a computation.
+void ResetTrackedBytesHighWaterMarks();
+
+// Returns a human-readable summary of the values tracked by all live
+// executors, with the `n` largest values of each executor if debugging is
+// enabled.
+std::string DumpLargestTrackedValues(size_t n);
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_TRACKED_BYTES_H_
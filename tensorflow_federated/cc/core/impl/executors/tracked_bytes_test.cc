@@ -0,0 +1,117 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/tracked_bytes.h"
+
+#include <cstdint>
+#include <string>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::testing::Pair;
+
+class TrackedBytesTest : public ::testing::Test {
+ protected:
+  TrackedBytesTest() { SetMetricsEnabled(true); }
+  ~TrackedBytesTest() override {
+    SetTrackedBytesDebugging(false);
+    SetMetricsEnabled(false);
+  }
+
+  static int64_t GaugeValue(const std::string& name) {
+    return MetricsRegistry::Default().GetGauge(name)->value();
+  }
+};
+
+TEST_F(TrackedBytesTest, AccountsTrackedValues) {
+  TrackedBytes tracked_bytes;
+  int64_t first = tracked_bytes.Tracked("Accounts", 0, 10);
+  int64_t second = tracked_bytes.Tracked("Accounts", 1, 20);
+  EXPECT_THAT(tracked_bytes.layer(), Eq("Accounts"));
+  EXPECT_THAT(tracked_bytes.values(), Eq(2));
+  EXPECT_THAT(tracked_bytes.bytes(), Eq(30));
+  EXPECT_THAT(GaugeValue("Accounts/TrackedValues"), Eq(2));
+  EXPECT_THAT(GaugeValue("Accounts/TrackedBytes"), Eq(30));
+
+  tracked_bytes.Untracked(0, first);
+  EXPECT_THAT(tracked_bytes.values(), Eq(1));
+  EXPECT_THAT(tracked_bytes.bytes(), Eq(20));
+  EXPECT_THAT(tracked_bytes.high_water_bytes(), Eq(30));
+  EXPECT_THAT(GaugeValue("Accounts/TrackedBytes"), Eq(20));
+  EXPECT_THAT(GaugeValue("Accounts/TrackedBytesHighWater"), Eq(30));
+  tracked_bytes.Untracked(1, second);
+}
+
+TEST_F(TrackedBytesTest, DoesNotAccountWhileMetricsDisabled) {
+  TrackedBytes tracked_bytes;
+  SetMetricsEnabled(false);
+  int64_t bytes = tracked_bytes.Tracked("Disabled", 0, 10);
+  EXPECT_THAT(bytes, Eq(TrackedBytes::kNotRecorded));
+  SetMetricsEnabled(true);
+  tracked_bytes.Untracked(0, bytes);
+  EXPECT_THAT(tracked_bytes.values(), Eq(0));
+  EXPECT_THAT(tracked_bytes.bytes(), Eq(0));
+  EXPECT_THAT(tracked_bytes.layer(), IsEmpty());
+}
+
+TEST_F(TrackedBytesTest, ResetsHighWaterMarks) {
+  TrackedBytes tracked_bytes;
+  int64_t first = tracked_bytes.Tracked("Reset", 0, 100);
+  int64_t second = tracked_bytes.Tracked("Reset", 1, 5);
+  tracked_bytes.Untracked(0, first);
+  EXPECT_THAT(GaugeValue("Reset/TrackedBytesHighWater"), Eq(105));
+
+  ResetTrackedBytesHighWaterMarks();
+  EXPECT_THAT(tracked_bytes.high_water_bytes(), Eq(5));
+  EXPECT_THAT(GaugeValue("Reset/TrackedBytesHighWater"), Eq(5));
+  tracked_bytes.Untracked(1, second);
+}
+
+TEST_F(TrackedBytesTest, DumpsLargestValuesWhileDebugging) {
+  TrackedBytes tracked_bytes;
+  int64_t untracked = tracked_bytes.Tracked("Debug", 0, 1000);
+  SetTrackedBytesDebugging(true);
+  tracked_bytes.Tracked("Debug", 1, 10);
+  tracked_bytes.Tracked("Debug", 2, 30);
+  tracked_bytes.Tracked("Debug", 3, 20);
+  EXPECT_THAT(tracked_bytes.LargestValues(2),
+              ElementsAre(Pair(2, 30), Pair(3, 20)));
+
+  std::string dump = DumpLargestTrackedValues(1);
+  EXPECT_THAT(dump, HasSubstr("Debug: 4 values, 1060 bytes"));
+  EXPECT_THAT(dump, HasSubstr("value 2: 30 bytes"));
+  EXPECT_THAT(dump, Not(HasSubstr("value 3:")));
+
+  tracked_bytes.Untracked(2, 30);
+  EXPECT_THAT(tracked_bytes.LargestValues(1), ElementsAre(Pair(3, 20)));
+  SetTrackedBytesDebugging(false);
+  EXPECT_THAT(tracked_bytes.LargestValues(1), IsEmpty());
+  tracked_bytes.Untracked(0, untracked);
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
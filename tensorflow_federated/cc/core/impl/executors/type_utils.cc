@@ -15,10 +15,16 @@ limitations under the License
 
 #include "tensorflow_federated/cc/core/impl/executors/type_utils.h"
 
+#include <cstdint>
+#include <string>
+
 #include "google/protobuf/any.pb.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
@@ -27,23 +33,63 @@ limitations under the License
 
 namespace tensorflow_federated {
 
+namespace {
+
+using ::google::protobuf::internal::WireFormatLite;
+
+constexpr uint32_t kDtypeTag =
+    WireFormatLite::MakeTag(tensorflow::TensorProto::kDtypeFieldNumber,
+                            WireFormatLite::WIRETYPE_VARINT);
+constexpr uint32_t kTensorShapeTag =
+    WireFormatLite::MakeTag(tensorflow::TensorProto::kTensorShapeFieldNumber,
+                            WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+
+// Reads the dtype and shape of the `TensorProto` serialized in `serialized`
+// into `tensor_type_pb`. The content of the tensor, which dominates its size,
+// is skipped rather than parsed and copied.
+bool ReadTensorType(absl::string_view serialized,
+                    v0::TensorType* tensor_type_pb) {
+  google::protobuf::io::CodedInputStream input(
+      reinterpret_cast<const uint8_t*>(serialized.data()), serialized.size());
+  uint32_t dtype = 0;
+  tensorflow::TensorShapeProto shape_pb;
+  while (uint32_t tag = input.ReadTag()) {
+    if (tag == kDtypeTag) {
+      if (!input.ReadVarint32(&dtype)) {
+        return false;
+      }
+    } else if (tag == kTensorShapeTag) {
+      uint32_t size;
+      std::string shape_bytes;
+      if (!input.ReadVarint32(&size) || !input.ReadString(&shape_bytes, size) ||
+          !shape_pb.MergeFromString(shape_bytes)) {
+        return false;
+      }
+    } else if (!WireFormatLite::SkipField(&input, tag)) {
+      return false;
+    }
+  }
+  if (!input.ConsumedEntireMessage()) {
+    return false;
+  }
+  tensor_type_pb->set_dtype(static_cast<v0::DataType>(dtype));
+  for (const tensorflow::TensorShapeProto::Dim& dim : shape_pb.dim()) {
+    tensor_type_pb->add_dims(dim.size());
+  }
+  return true;
+}
+
+}  // namespace
+
 absl::StatusOr<v0::Type> InferTypeFromValue(const v0::Value& value_pb) {
   v0::Type value_type_pb;
   switch (value_pb.value_case()) {
     case v0::Value::kTensor: {
-      // Ideally we won't deserialize the TensorProto here... but not clear how
-      // else to get the data we desire. We don't unpack the entire tensor
-      // content only the metadata.
-      tensorflow::TensorProto tensor_pb;
-      if (!value_pb.tensor().UnpackTo(&tensor_pb)) {
+      if (!value_pb.tensor().Is<tensorflow::TensorProto>() ||
+          !ReadTensorType(value_pb.tensor().value(),
+                          value_type_pb.mutable_tensor())) {
         return absl::InternalError("Failed to unpack Any to TensorProto");
       }
-      v0::TensorType* tensor_type_pb = value_type_pb.mutable_tensor();
-      tensor_type_pb->set_dtype(static_cast<v0::DataType>(tensor_pb.dtype()));
-      for (const tensorflow::TensorShapeProto::Dim& dim :
-           tensor_pb.tensor_shape().dim()) {
-        tensor_type_pb->add_dims(dim.size());
-      }
       break;
     }
     case v0::Value::kStruct: {
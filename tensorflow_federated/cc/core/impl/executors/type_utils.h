@@ -22,6 +22,9 @@ limitations under the License
 
 namespace tensorflow_federated {
 
+// Returns the type of `value_pb`. Only the metadata of tensors is read, and
+// federated values take the type they declare, so that the cost of inference
+// does not grow with the content of tensors or the number of clients.
 absl::StatusOr<v0::Type> InferTypeFromValue(const v0::Value& value_pb);
 
 }  // namespace tensorflow_federated
@@ -0,0 +1,79 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/type_utils.h"
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::tensorflow_federated::testing::EqualsProto;
+using ::tensorflow_federated::testing::StructV;
+using ::tensorflow_federated::testing::TensorV;
+
+TEST(InferTypeFromValueTest, InfersTensorType) {
+  v0::Value value_pb = TensorV(tensorflow::Tensor(
+      tensorflow::DT_FLOAT, tensorflow::TensorShape({2, 3})));
+  v0::Type expected_pb;
+  expected_pb.mutable_tensor()->set_dtype(v0::DataType::DT_FLOAT);
+  expected_pb.mutable_tensor()->add_dims(2);
+  expected_pb.mutable_tensor()->add_dims(3);
+  EXPECT_THAT(InferTypeFromValue(value_pb),
+              IsOkAndHolds(EqualsProto(expected_pb)));
+}
+
+TEST(InferTypeFromValueTest, InfersStringTensorType) {
+  v0::Value value_pb = TensorV(tensorflow::tstring("a"));
+  v0::Type expected_pb;
+  expected_pb.mutable_tensor()->set_dtype(v0::DataType::DT_STRING);
+  EXPECT_THAT(InferTypeFromValue(value_pb),
+              IsOkAndHolds(EqualsProto(expected_pb)));
+}
+
+TEST(InferTypeFromValueTest, InfersStructType) {
+  v0::Value value_pb = StructV({TensorV(1), TensorV(2.0f)});
+  v0::Type expected_pb;
+  v0::StructType* struct_pb = expected_pb.mutable_struct_();
+  struct_pb->add_element()->mutable_value()->mutable_tensor()->set_dtype(
+      v0::DataType::DT_INT32);
+  struct_pb->add_element()->mutable_value()->mutable_tensor()->set_dtype(
+      v0::DataType::DT_FLOAT);
+  EXPECT_THAT(InferTypeFromValue(value_pb),
+              IsOkAndHolds(EqualsProto(expected_pb)));
+}
+
+TEST(InferTypeFromValueTest, FailsOnMalformedTensor) {
+  v0::Value value_pb = TensorV(1);
+  value_pb.mutable_tensor()->set_value("\xff");
+  EXPECT_THAT(InferTypeFromValue(value_pb),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
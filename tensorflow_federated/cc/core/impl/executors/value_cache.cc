@@ -0,0 +1,132 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+std::string ValueContentHash(const v0::Value& value_pb) {
+  std::string serialized;
+  {
+    google::protobuf::io::StringOutputStream stream(&serialized);
+    google::protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.SetSerializationDeterministic(true);
+    value_pb.SerializeToCodedStream(&coded_stream);
+  }
+  const tensorflow::Fprint128 fingerprint =
+      tensorflow::Fingerprint128(serialized);
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16));
+}
+
+std::shared_ptr<const v0::Value> ValueCache::Lookup(
+    std::string_view content_hash) {
+  absl::MutexLock lock(&mutex_);
+  return LookupLocked(content_hash);
+}
+
+std::shared_ptr<const v0::Value> ValueCache::LookupOrWait(
+    std::string_view content_hash, absl::Time deadline) {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    std::shared_ptr<const v0::Value> value_pb = LookupLocked(content_hash);
+    if (value_pb != nullptr) {
+      return value_pb;
+    }
+    auto pending = pending_.find(content_hash);
+    if (pending == pending_.end()) {
+      return nullptr;
+    }
+    const absl::Time now = absl::Now();
+    if (pending->second <= now) {
+      pending_.erase(pending);
+      return nullptr;
+    }
+    if (deadline <= now) {
+      return nullptr;
+    }
+    pending_inserted_.WaitWithDeadline(&mutex_,
+                                       std::min(deadline, pending->second));
+  }
+}
+
+void ValueCache::MarkPending(std::string content_hash, absl::Time expiry) {
+  absl::MutexLock lock(&mutex_);
+  if (index_.contains(content_hash)) {
+    return;
+  }
+  // Drop the marks of values which were never received.
+  const absl::Time now = absl::Now();
+  for (auto it = pending_.begin(); it != pending_.end();) {
+    if (it->second <= now) {
+      pending_.erase(it++);
+    } else {
+      ++it;
+    }
+  }
+  absl::Time& pending_expiry = pending_[std::move(content_hash)];
+  pending_expiry = std::max(pending_expiry, expiry);
+}
+
+std::shared_ptr<const v0::Value> ValueCache::LookupLocked(
+    std::string_view content_hash) {
+  auto it = index_.find(content_hash);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->value_pb;
+}
+
+void ValueCache::Insert(std::string content_hash,
+                        std::shared_ptr<const v0::Value> value_pb) {
+  const int64_t size_bytes = value_pb->ByteSizeLong();
+  absl::MutexLock lock(&mutex_);
+  if (pending_.erase(content_hash) > 0) {
+    pending_inserted_.SignalAll();
+  }
+  if (size_bytes > capacity_bytes_) {
+    return;
+  }
+  if (index_.contains(content_hash)) {
+    return;
+  }
+  while (size_bytes_ + size_bytes > capacity_bytes_) {
+    const Entry& evicted = entries_.back();
+    size_bytes_ -= evicted.size_bytes;
+    index_.erase(evicted.content_hash);
+    entries_.pop_back();
+  }
+  entries_.push_front(Entry{content_hash, std::move(value_pb), size_bytes});
+  index_.emplace(std::move(content_hash), entries_.begin());
+  size_bytes_ += size_bytes;
+}
+
+}  // namespace tensorflow_federated
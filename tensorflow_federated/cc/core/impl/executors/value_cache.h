@@ -0,0 +1,110 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_CACHE_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+// Returns the content hash under which `value_pb` is sent to, and cached by,
+// an `ExecutorService`: the hex digits of a 128-bit fingerprint of its
+// deterministic serialization.
+//
+// The fingerprint is not cryptographic, so a value cache must only be shared
+// by trusted clients.
+std::string ValueContentHash(const v0::Value& value_pb);
+
+// A bounded cache of values keyed by their content hash, which evicts the
+// least recently used values once the total serialized size of the cached
+// values exceeds `capacity_bytes`.
+//
+// This class is thread safe.
+class ValueCache {
+ public:
+  explicit ValueCache(int64_t capacity_bytes)
+      : capacity_bytes_(capacity_bytes) {}
+
+  // ValueCache is neither copyable nor movable.
+  ValueCache(const ValueCache&) = delete;
+  ValueCache& operator=(const ValueCache&) = delete;
+
+  // Returns the value cached under `content_hash`, or nullptr if there is
+  // none.
+  std::shared_ptr<const v0::Value> Lookup(std::string_view content_hash)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Same as `Lookup`, but if the value is pending, waits until it is inserted,
+  // its pending mark expires, or `deadline`.
+  std::shared_ptr<const v0::Value> LookupOrWait(std::string_view content_hash,
+                                                absl::Time deadline)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Marks the value under `content_hash` as pending until `expiry`, i.e. as
+  // being received by the owner of the cache, which inserts it once received.
+  void MarkPending(std::string content_hash, absl::Time expiry)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Caches `value_pb` under `content_hash`, unless it alone is larger than the
+  // capacity of the cache. The hash is not verified. In either case, the value
+  // is no longer pending.
+  void Insert(std::string content_hash,
+              std::shared_ptr<const v0::Value> value_pb)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  int64_t size_bytes() const ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    return size_bytes_;
+  }
+
+ private:
+  struct Entry {
+    std::string content_hash;
+    std::shared_ptr<const v0::Value> value_pb;
+    int64_t size_bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  std::shared_ptr<const v0::Value> LookupLocked(std::string_view content_hash)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const int64_t capacity_bytes_;
+  mutable absl::Mutex mutex_;
+  // Ordered from the most to the least recently used entry.
+  EntryList entries_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<std::string, EntryList::iterator> index_
+      ABSL_GUARDED_BY(mutex_);
+  int64_t size_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The expiry of the mark of each pending value.
+  absl::flat_hash_map<std::string, absl::Time> pending_ ABSL_GUARDED_BY(mutex_);
+  // Signalled whenever a pending value is inserted.
+  absl::CondVar pending_inserted_;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_CACHE_H_
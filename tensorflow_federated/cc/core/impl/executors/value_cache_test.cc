@@ -0,0 +1,120 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::testing::IsNull;
+using ::testing::Pointee;
+using testing::EqualsProto;
+
+TEST(ValueContentHashTest, EqualValuesHaveEqualHashes) {
+  EXPECT_EQ(ValueContentHash(testing::TensorV(1.0f)),
+            ValueContentHash(testing::TensorV(1.0f)));
+  EXPECT_NE(ValueContentHash(testing::TensorV(1.0f)),
+            ValueContentHash(testing::TensorV(2.0f)));
+}
+
+TEST(ValueCacheTest, LookupReturnsInsertedValue) {
+  ValueCache cache(/*capacity_bytes=*/1 << 20);
+  const v0::Value value_pb = testing::TensorV(1.0f);
+  const std::string content_hash = ValueContentHash(value_pb);
+
+  EXPECT_THAT(cache.Lookup(content_hash), IsNull());
+  cache.Insert(content_hash, std::make_shared<v0::Value>(value_pb));
+  EXPECT_THAT(cache.Lookup(content_hash), Pointee(EqualsProto(value_pb)));
+  EXPECT_EQ(cache.size_bytes(), value_pb.ByteSizeLong());
+}
+
+TEST(ValueCacheTest, EvictsLeastRecentlyUsedValue) {
+  const v0::Value first = testing::TensorV(1.0f);
+  const v0::Value second = testing::TensorV(2.0f);
+  const v0::Value third = testing::TensorV(3.0f);
+  ValueCache cache(/*capacity_bytes=*/first.ByteSizeLong() +
+                   second.ByteSizeLong());
+
+  cache.Insert(ValueContentHash(first), std::make_shared<v0::Value>(first));
+  cache.Insert(ValueContentHash(second), std::make_shared<v0::Value>(second));
+  // Using `first` makes `second` the least recently used value.
+  EXPECT_THAT(cache.Lookup(ValueContentHash(first)),
+              Pointee(EqualsProto(first)));
+  cache.Insert(ValueContentHash(third), std::make_shared<v0::Value>(third));
+
+  EXPECT_THAT(cache.Lookup(ValueContentHash(first)),
+              Pointee(EqualsProto(first)));
+  EXPECT_THAT(cache.Lookup(ValueContentHash(second)), IsNull());
+  EXPECT_THAT(cache.Lookup(ValueContentHash(third)),
+              Pointee(EqualsProto(third)));
+}
+
+TEST(ValueCacheTest, DoesNotInsertValueLargerThanCapacity) {
+  const v0::Value value_pb = testing::TensorV(1.0f);
+  ValueCache cache(/*capacity_bytes=*/value_pb.ByteSizeLong() - 1);
+
+  cache.Insert(ValueContentHash(value_pb),
+               std::make_shared<v0::Value>(value_pb));
+  EXPECT_THAT(cache.Lookup(ValueContentHash(value_pb)), IsNull());
+  EXPECT_EQ(cache.size_bytes(), 0);
+}
+
+TEST(ValueCacheTest, LookupOrWaitWaitsForPendingValue) {
+  ValueCache cache(/*capacity_bytes=*/1 << 20);
+  const v0::Value value_pb = testing::TensorV(1.0f);
+  const std::string content_hash = ValueContentHash(value_pb);
+
+  cache.MarkPending(content_hash, absl::InfiniteFuture());
+  std::thread inserter([&cache, &content_hash, &value_pb] {
+    absl::SleepFor(absl::Milliseconds(10));
+    cache.Insert(content_hash, std::make_shared<v0::Value>(value_pb));
+  });
+  EXPECT_THAT(cache.LookupOrWait(content_hash, absl::InfiniteFuture()),
+              Pointee(EqualsProto(value_pb)));
+  inserter.join();
+}
+
+TEST(ValueCacheTest, LookupOrWaitDoesNotWaitForUnknownValue) {
+  ValueCache cache(/*capacity_bytes=*/1 << 20);
+
+  EXPECT_THAT(cache.LookupOrWait(ValueContentHash(testing::TensorV(1.0f)),
+                                 absl::InfiniteFuture()),
+              IsNull());
+}
+
+TEST(ValueCacheTest, LookupOrWaitStopsWaitingOnceMarkExpires) {
+  ValueCache cache(/*capacity_bytes=*/1 << 20);
+  const std::string content_hash = ValueContentHash(testing::TensorV(1.0f));
+
+  cache.MarkPending(content_hash, absl::Now() + absl::Milliseconds(10));
+  EXPECT_THAT(cache.LookupOrWait(content_hash, absl::InfiniteFuture()),
+              IsNull());
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
@@ -0,0 +1,81 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/value_releaser.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// The background thread shared by all releasers. Never destroyed, as values
+// may be disposed of during static destruction.
+ThreadPool& ReleaseThread() {
+  static ThreadPool* const pool = new ThreadPool(1, "ValueReleaser");
+  return *pool;
+}
+
+}  // namespace
+
+ValueReleaser::ValueReleaser() : state_(std::make_shared<State>()) {}
+
+ValueReleaser::~ValueReleaser() { Flush(); }
+
+void ValueReleaser::Add(Release release) {
+  {
+    absl::MutexLock lock(&state_->mutex);
+    state_->pending.push_back(std::move(release));
+    if (state_->scheduled) {
+      return;
+    }
+    state_->scheduled = true;
+  }
+  absl::Status status =
+      ReleaseThread().Schedule([state = state_]() { Drain(*state); });
+  if (!status.ok()) {
+    Drain(*state_);
+  }
+}
+
+void ValueReleaser::Flush() {
+  Drain(*state_);
+  // A release taken by the background thread may still be running.
+  absl::MutexLock lock(&state_->mutex);
+  state_->mutex.Await(absl::Condition(state_.get(), &State::NoneRunning));
+}
+
+void ValueReleaser::Drain(State& state) {
+  absl::MutexLock lock(&state.mutex);
+  while (!state.pending.empty()) {
+    Release release = std::move(state.pending.front());
+    state.pending.pop_front();
+    ++state.running;
+    state.mutex.Unlock();
+    std::move(release)();
+    // Destroy what the release captured before locking again.
+    release = nullptr;
+    state.mutex.Lock();
+    --state.running;
+  }
+  state.scheduled = false;
+}
+
+}  // namespace tensorflow_federated
@@ -0,0 +1,80 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_RELEASER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_RELEASER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/synchronization/mutex.h"
+
+namespace tensorflow_federated {
+
+// Releases the values disposed of by an executor on a background thread
+// shared by all executors, so that freeing what the values hold, e.g. large
+// tensors, doesn't stall the thread which disposed of them.
+//
+// The releases of each releaser run in the order they were added. `Flush`
+// runs the pending ones on the calling thread instead of waiting for the
+// background thread, so that flushing from a release of another releaser
+// can't deadlock.
+//
+// This class is thread safe.
+class ValueReleaser {
+ public:
+  using Release = absl::AnyInvocable<void() &&>;
+
+  ValueReleaser();
+  // Flushes the pending releases.
+  ~ValueReleaser();
+
+  ValueReleaser(const ValueReleaser&) = delete;
+  ValueReleaser& operator=(const ValueReleaser&) = delete;
+
+  // Schedules `release` to run on the background thread.
+  void Add(Release release);
+
+  // Returns once all releases added before the call have run.
+  void Flush();
+
+ private:
+  // Shared with the tasks of the background thread, which may outlive the
+  // releaser.
+  struct State {
+    absl::Mutex mutex;
+    std::deque<Release> pending ABSL_GUARDED_BY(mutex);
+    // The number of releases taken out of `pending` which haven't run yet.
+    int64_t running ABSL_GUARDED_BY(mutex) = 0;
+    // Whether a task draining `pending` is scheduled on the background thread.
+    bool scheduled ABSL_GUARDED_BY(mutex) = false;
+
+    bool NoneRunning() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+      return running == 0;
+    }
+  };
+
+  // Runs the pending releases of `state` until there are none left.
+  static void Drain(State& state) ABSL_LOCKS_EXCLUDED(state.mutex);
+
+  const std::shared_ptr<State> state_;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_RELEASER_H_
@@ -0,0 +1,59 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/value_releaser.h"
+
+#include <memory>
+#include <vector>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/synchronization/mutex.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(ValueReleaserTest, RunsReleasesInOrderBeforeFlushReturns) {
+  ValueReleaser releaser;
+  absl::Mutex mutex;
+  std::vector<int> released;
+  for (int i = 0; i < 3; ++i) {
+    releaser.Add([&mutex, &released, i]() {
+      absl::MutexLock lock(&mutex);
+      released.push_back(i);
+    });
+  }
+  releaser.Flush();
+  absl::MutexLock lock(&mutex);
+  EXPECT_THAT(released, ElementsAre(0, 1, 2));
+}
+
+TEST(ValueReleaserTest, FlushesFromReleaseOfAnotherReleaser) {
+  auto inner = std::make_unique<ValueReleaser>();
+  bool released = false;
+  inner->Add([&released]() { released = true; });
+  ValueReleaser outer;
+  // Destroying `inner` on the background thread flushes it there.
+  outer.Add([inner = std::move(inner)]() mutable { inner.reset(); });
+  outer.Flush();
+  EXPECT_TRUE(released);
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
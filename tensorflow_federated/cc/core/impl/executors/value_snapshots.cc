@@ -0,0 +1,131 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+
+#include "tensorflow_federated/cc/core/impl/executors/value_snapshots.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+ValueSnapshotStore::ValueSnapshotStore(std::string directory)
+    : directory_(std::move(directory)) {}
+
+absl::StatusOr<std::string> ValueSnapshotStore::PathOf(
+    std::string_view content_hash) const {
+  // Hashes name files, so only the hex digits `ValueContentHash` produces are
+  // accepted.
+  if (content_hash.empty()) {
+    return absl::InvalidArgumentError("Expected a non-empty content hash.");
+  }
+  for (char c : content_hash) {
+    if (!absl::ascii_isxdigit(static_cast<unsigned char>(c))) {
+      return absl::InvalidArgumentError(
+          "Expected the content hash to consist of hex digits.");
+    }
+  }
+  return (std::filesystem::path(directory_) / content_hash).string();
+}
+
+absl::StatusOr<std::string> ValueSnapshotStore::Write(
+    const v0::Value& value_pb) {
+  std::string content_hash = ValueContentHash(value_pb);
+  absl::StatusOr<std::string> path = PathOf(content_hash);
+  if (!path.ok()) {
+    return path.status();
+  }
+  std::error_code error;
+  if (std::filesystem::exists(*path, error)) {
+    return content_hash;
+  }
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    return absl::InternalError(absl::StrCat("Could not create ", directory_,
+                                            " to snapshot values to: ",
+                                            error.message()));
+  }
+  // Workers sharing the directory may snapshot the same value at once, so the
+  // temporary file is unique to this process and write.
+  static std::atomic<int64_t> next_write = 0;
+  const std::string temp_path =
+      absl::StrCat(*path, ".tmp_", getpid(), "_",
+                   next_write.fetch_add(1, std::memory_order_relaxed));
+  std::string data;
+  if (!value_pb.SerializeToString(&data)) {
+    return absl::InternalError("Could not serialize the value to snapshot.");
+  }
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file || !file.write(data.data(), data.size()) || !file.flush()) {
+      file.close();
+      std::filesystem::remove(temp_path, error);
+      return absl::InternalError(
+          absl::StrCat("Could not write the snapshot to ", temp_path));
+    }
+  }
+  std::filesystem::rename(temp_path, *path, error);
+  if (error) {
+    std::error_code unused;
+    std::filesystem::remove(temp_path, unused);
+    return absl::InternalError(absl::StrCat("Could not move the snapshot to ",
+                                            *path, ": ", error.message()));
+  }
+  return content_hash;
+}
+
+absl::StatusOr<std::shared_ptr<const v0::Value>> ValueSnapshotStore::Read(
+    std::string_view content_hash) const {
+  absl::StatusOr<std::string> path = PathOf(content_hash);
+  if (!path.ok()) {
+    return path.status();
+  }
+  std::ifstream file(*path, std::ios::binary);
+  if (!file) {
+    return absl::NotFoundError(
+        absl::StrCat("No value is snapshotted at ", *path));
+  }
+  std::string data((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  if (file.bad()) {
+    return absl::InternalError(
+        absl::StrCat("Could not read the snapshot at ", *path));
+  }
+  auto value_pb = std::make_shared<v0::Value>();
+  if (!value_pb->ParseFromString(data)) {
+    return absl::InternalError(
+        absl::StrCat("Could not parse the snapshot at ", *path));
+  }
+  return value_pb;
+}
+
+}  // namespace tensorflow_federated
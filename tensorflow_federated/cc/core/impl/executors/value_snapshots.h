@@ -0,0 +1,64 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_SNAPSHOTS_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_SNAPSHOTS_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "absl/status/statusor.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+
+// Stores snapshots of the values of an executor, e.g. broadcast models and
+// client datasets, in a directory which outlives the worker, such as one on
+// storage shared by the workers of a stack. A worker which replaces a failed
+// one then reads the values back by their content hash, rather than clients
+// sending them again.
+//
+// Each value is written to a file named after its content hash, as computed
+// by `ValueContentHash`, holding its serialized form. Files are written under
+// a temporary name and then renamed, so that readers never see partial
+// snapshots, and values which are already stored are not written again.
+//
+// This class is thread safe.
+class ValueSnapshotStore {
+ public:
+  explicit ValueSnapshotStore(std::string directory);
+
+  ValueSnapshotStore(const ValueSnapshotStore&) = delete;
+  ValueSnapshotStore& operator=(const ValueSnapshotStore&) = delete;
+
+  // Writes a snapshot of `value_pb`, and returns its content hash.
+  absl::StatusOr<std::string> Write(const v0::Value& value_pb);
+
+  // Reads the value whose snapshot was stored under `content_hash`, or fails
+  // with NOT_FOUND if there is none.
+  absl::StatusOr<std::shared_ptr<const v0::Value>> Read(
+      std::string_view content_hash) const;
+
+ private:
+  absl::StatusOr<std::string> PathOf(std::string_view content_hash) const;
+
+  const std::string directory_;
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_SNAPSHOTS_H_
@@ -0,0 +1,82 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+
+#include "tensorflow_federated/cc/core/impl/executors/value_snapshots.h"
+
+#include <string>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_cache.h"
+#include "tensorflow_federated/cc/core/impl/executors/value_test_utils.h"
+#include "tensorflow_federated/cc/testing/protobuf_matchers.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+namespace tensorflow_federated {
+namespace {
+
+using ::testing::Eq;
+using ::testing::Pointee;
+using testing::EqualsProto;
+
+std::string TestDirectory(const std::string& name) {
+  return ::testing::TempDir() + "/" + name;
+}
+
+TEST(ValueSnapshotStoreTest, ReadsBackWrittenValues) {
+  ValueSnapshotStore store(TestDirectory("reads_back"));
+  const v0::Value value_pb = testing::TensorV(1.0f);
+  EXPECT_THAT(store.Write(value_pb), IsOkAndHolds(ValueContentHash(value_pb)));
+  EXPECT_THAT(store.Read(ValueContentHash(value_pb)),
+              IsOkAndHolds(Pointee(EqualsProto(value_pb))));
+}
+
+TEST(ValueSnapshotStoreTest, ReadsValuesWrittenByOtherStores) {
+  const v0::Value value_pb = testing::TensorV(1.0f);
+  {
+    ValueSnapshotStore failed_store(TestDirectory("shared"));
+    EXPECT_THAT(failed_store.Write(value_pb), IsOk());
+  }
+  ValueSnapshotStore replacement_store(TestDirectory("shared"));
+  EXPECT_THAT(replacement_store.Read(ValueContentHash(value_pb)),
+              IsOkAndHolds(Pointee(EqualsProto(value_pb))));
+}
+
+TEST(ValueSnapshotStoreTest, WritesValuesAgain) {
+  ValueSnapshotStore store(TestDirectory("writes_again"));
+  const v0::Value value_pb = testing::TensorV(1.0f);
+  ASSERT_THAT(store.Write(value_pb), IsOk());
+  EXPECT_THAT(store.Write(value_pb),
+              IsOkAndHolds(Eq(ValueContentHash(value_pb))));
+}
+
+TEST(ValueSnapshotStoreTest, ReadFailsForMissingValues) {
+  ValueSnapshotStore store(TestDirectory("missing"));
+  EXPECT_THAT(store.Read(ValueContentHash(testing::TensorV(1.0f))),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+TEST(ValueSnapshotStoreTest, ReadFailsForHashesWhichAreNotHex) {
+  ValueSnapshotStore store(TestDirectory("not_hex"));
+  EXPECT_THAT(store.Read("../secret"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(store.Read(""), StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace tensorflow_federated
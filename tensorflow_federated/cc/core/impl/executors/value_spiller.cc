@@ -0,0 +1,176 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/value_spiller.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>  // NOLINT
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <system_error>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+// Returns a directory under `parent` which no other spiller uses.
+std::string UniqueDirectory(const std::string& parent, std::string_view name) {
+  static std::atomic<int64_t> next_spiller = 0;
+  std::error_code error;
+  std::string base = parent;
+  if (base.empty()) {
+    base = std::filesystem::temp_directory_path(error).string();
+  }
+  return (std::filesystem::path(base) /
+          absl::StrCat("tff_spill_", name, "_", getpid(), "_",
+                       next_spiller.fetch_add(1, std::memory_order_relaxed)))
+      .string();
+}
+
+}  // namespace
+
+ValueSpiller::ValueSpiller(ValueSpillOptions options, std::string_view name)
+    : memory_budget_bytes_(options.memory_budget_bytes),
+      directory_(UniqueDirectory(options.directory, name)) {}
+
+ValueSpiller::~ValueSpiller() {
+  std::error_code error;
+  std::filesystem::remove_all(directory_, error);
+  if (error) {
+    LOG(WARNING) << "Could not remove the spilled values in " << directory_
+                 << ": " << error.message();
+  }
+}
+
+void ValueSpiller::AddUnsized(uint64_t id) {
+  absl::MutexLock lock(&mutex_);
+  unsized_.push_back(id);
+}
+
+std::vector<uint64_t> ValueSpiller::TakeUnsized(size_t n) {
+  absl::MutexLock lock(&mutex_);
+  n = std::min(n, unsized_.size());
+  std::vector<uint64_t> ids(unsized_.begin(), unsized_.begin() + n);
+  unsized_.erase(unsized_.begin(), unsized_.begin() + n);
+  return ids;
+}
+
+void ValueSpiller::AddResident(uint64_t id, int64_t bytes) {
+  absl::MutexLock lock(&mutex_);
+  auto [iter, inserted] = resident_.try_emplace(id);
+  if (!inserted) {
+    resident_bytes_ -= iter->second->second;
+    lru_.erase(iter->second);
+  }
+  iter->second = lru_.emplace(lru_.end(), id, bytes);
+  resident_bytes_ += bytes;
+}
+
+void ValueSpiller::Touch(uint64_t id) {
+  absl::MutexLock lock(&mutex_);
+  auto iter = resident_.find(id);
+  if (iter != resident_.end()) {
+    lru_.splice(lru_.end(), lru_, iter->second);
+  }
+}
+
+void ValueSpiller::Remove(uint64_t id) {
+  absl::MutexLock lock(&mutex_);
+  auto iter = resident_.find(id);
+  if (iter != resident_.end()) {
+    resident_bytes_ -= iter->second->second;
+    lru_.erase(iter->second);
+    resident_.erase(iter);
+  }
+}
+
+std::vector<uint64_t> ValueSpiller::TakeOverBudget() {
+  absl::MutexLock lock(&mutex_);
+  std::vector<uint64_t> ids;
+  while (resident_bytes_ > memory_budget_bytes_ && !lru_.empty()) {
+    auto [id, bytes] = lru_.front();
+    lru_.pop_front();
+    resident_.erase(id);
+    resident_bytes_ -= bytes;
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+int64_t ValueSpiller::resident_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return resident_bytes_;
+}
+
+std::string ValueSpiller::PathOf(uint64_t id) const {
+  return (std::filesystem::path(directory_) / absl::StrCat(id)).string();
+}
+
+absl::Status ValueSpiller::Write(uint64_t id, std::string_view data) {
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    return absl::InternalError(absl::StrCat("Could not create ", directory_,
+                                            " to spill values to: ",
+                                            error.message()));
+  }
+  std::string path = PathOf(id);
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file || !file.write(data.data(), data.size()) || !file.flush()) {
+    file.close();
+    std::filesystem::remove(path, error);
+    return absl::InternalError(
+        absl::StrCat("Could not spill value ", id, " to ", path));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<std::string> ValueSpiller::Read(uint64_t id) const {
+  std::string path = PathOf(id);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return absl::InternalError(
+        absl::StrCat("Could not open the spilled value ", id, " at ", path));
+  }
+  std::string data((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  if (file.bad()) {
+    return absl::InternalError(
+        absl::StrCat("Could not read the spilled value ", id, " at ", path));
+  }
+  return data;
+}
+
+void ValueSpiller::Delete(uint64_t id) {
+  std::error_code error;
+  std::filesystem::remove(PathOf(id), error);
+}
+
+}  // namespace tensorflow_federated
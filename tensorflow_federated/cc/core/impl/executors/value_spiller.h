@@ -0,0 +1,120 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#ifndef THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_SPILLER_H_
+#define THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_SPILLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+
+namespace tensorflow_federated {
+
+// Options for spilling the values tracked by an executor to local disk.
+struct ValueSpillOptions {
+  // The number of bytes of spillable values the executor keeps in memory.
+  // Once exceeded, the least recently used values are spilled until it is
+  // met again. Non-positive values disable spilling.
+  int64_t memory_budget_bytes = 0;
+  // The directory under which spilled values are written. If empty, the
+  // system temporary directory is used.
+  std::string directory;
+};
+
+// Keeps the values tracked by an executor within a memory budget, by picking
+// the least recently used ones to spill to local disk and storing their
+// serialized form until they are needed again. `ExecutorBase` owns a spiller
+// if spilling is enabled; the values themselves stay with the executor.
+//
+// Values whose size is not known yet, e.g. the results of calls which have not
+// completed, are kept in a queue until they can be sized.
+//
+// Spilled values are written to a directory of their own, which is created
+// with the first spilled value and removed with the spiller.
+//
+// This class is thread safe.
+class ValueSpiller {
+ public:
+  // `name` names the directory of the spilled values, e.g. after the
+  // executor.
+  ValueSpiller(ValueSpillOptions options, std::string_view name);
+  ~ValueSpiller();
+
+  ValueSpiller(const ValueSpiller&) = delete;
+  ValueSpiller& operator=(const ValueSpiller&) = delete;
+
+  // Records that the value `id` may be spilled once its size is known.
+  void AddUnsized(uint64_t id) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Removes and returns up to `n` of the values recorded by `AddUnsized`,
+  // oldest first, to be sized and recorded again.
+  std::vector<uint64_t> TakeUnsized(size_t n) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Records that the value `id` holds `bytes` in memory and was just used.
+  void AddResident(uint64_t id, int64_t bytes) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Records that the value `id`, if resident, was just used.
+  void Touch(uint64_t id) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Forgets the value `id` if it is resident, e.g. once it is untracked.
+  void Remove(uint64_t id) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Removes and returns the least recently used resident values which must be
+  // spilled for the others to fit in the budget.
+  std::vector<uint64_t> TakeOverBudget() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // The number of bytes of the resident values.
+  int64_t resident_bytes() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Writes the serialized value `id` to disk.
+  absl::Status Write(uint64_t id, std::string_view data);
+
+  // Reads the serialized value `id` written by `Write`.
+  absl::StatusOr<std::string> Read(uint64_t id) const;
+
+  // Deletes the serialized value `id` from disk, if any.
+  void Delete(uint64_t id);
+
+ private:
+  // The IDs and bytes of resident values, least recently used first.
+  using LruList = std::list<std::pair<uint64_t, int64_t>>;
+
+  std::string PathOf(uint64_t id) const;
+
+  const int64_t memory_budget_bytes_;
+  const std::string directory_;
+
+  mutable absl::Mutex mutex_;
+  int64_t resident_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  LruList lru_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<uint64_t, LruList::iterator> resident_
+      ABSL_GUARDED_BY(mutex_);
+  std::deque<uint64_t> unsized_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace tensorflow_federated
+
+#endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_CORE_IMPL_EXECUTORS_VALUE_SPILLER_H_
@@ -0,0 +1,82 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+#include "tensorflow_federated/cc/core/impl/executors/value_spiller.h"
+
+#include <cstdint>
+#include <string>
+
+#include "googlemock/include/gmock/gmock.h"
+#include "googletest/include/gtest/gtest.h"
+#include "absl/status/status.h"
+#include "tensorflow_federated/cc/testing/status_matchers.h"
+
+namespace tensorflow_federated {
+
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::IsEmpty;
+
+ValueSpillOptions TestOptions(int64_t memory_budget_bytes) {
+  ValueSpillOptions options;
+  options.memory_budget_bytes = memory_budget_bytes;
+  options.directory = ::testing::TempDir();
+  return options;
+}
+
+TEST(ValueSpillerTest, TakesLeastRecentlyUsedValuesOverBudget) {
+  ValueSpiller spiller(TestOptions(/*memory_budget_bytes=*/25), "test");
+  spiller.AddResident(0, 10);
+  spiller.AddResident(1, 10);
+  spiller.AddResident(2, 10);
+  spiller.Touch(0);
+  EXPECT_THAT(spiller.resident_bytes(), Eq(30));
+  EXPECT_THAT(spiller.TakeOverBudget(), ElementsAre(1));
+  EXPECT_THAT(spiller.resident_bytes(), Eq(20));
+  EXPECT_THAT(spiller.TakeOverBudget(), IsEmpty());
+}
+
+TEST(ValueSpillerTest, ForgetsRemovedValues) {
+  ValueSpiller spiller(TestOptions(/*memory_budget_bytes=*/5), "test");
+  spiller.AddResident(0, 10);
+  spiller.AddResident(1, 10);
+  spiller.Remove(0);
+  EXPECT_THAT(spiller.TakeOverBudget(), ElementsAre(1));
+  EXPECT_THAT(spiller.resident_bytes(), Eq(0));
+}
+
+TEST(ValueSpillerTest, TakesUnsizedValuesOldestFirst) {
+  ValueSpiller spiller(TestOptions(/*memory_budget_bytes=*/5), "test");
+  spiller.AddUnsized(0);
+  spiller.AddUnsized(1);
+  spiller.AddUnsized(2);
+  EXPECT_THAT(spiller.TakeUnsized(2), ElementsAre(0, 1));
+  EXPECT_THAT(spiller.TakeUnsized(2), ElementsAre(2));
+  EXPECT_THAT(spiller.TakeOverBudget(), IsEmpty());
+}
+
+TEST(ValueSpillerTest, ReadsBackWrittenValues) {
+  ValueSpiller spiller(TestOptions(/*memory_budget_bytes=*/5), "test");
+  EXPECT_THAT(spiller.Write(0, std::string("a\0b", 3)), IsOk());
+  EXPECT_THAT(spiller.Read(0), IsOkAndHolds(std::string("a\0b", 3)));
+  spiller.Delete(0);
+  EXPECT_THAT(spiller.Read(0), StatusIs(absl::StatusCode::kInternal));
+}
+
+}  // namespace
+
+}  // namespace tensorflow_federated
@@ -19,6 +19,7 @@ limitations under the License
 #include <future>  // NOLINT
 #include <memory>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <type_traits>
 #include <utility>
@@ -26,20 +27,25 @@ limitations under the License
 #include <vector>
 
 #include "google/protobuf/any.pb.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "tensorflow/compiler/tf2xla/literal_util.h"
 #include "tensorflow/compiler/tf2xla/type_util.h"
 #include "tensorflow/compiler/xla/client/client.h"
 #include "tensorflow/compiler/xla/client/client_library.h"
 #include "tensorflow/compiler/xla/client/global_data.h"
+#include "tensorflow/compiler/xla/client/xla_builder.h"
 #include "tensorflow/compiler/xla/client/xla_computation.h"
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/service/hlo.pb.h"
 #include "tensorflow/compiler/xla/shape.h"
+#include "tensorflow/compiler/xla/shape_util.h"
 #include "tensorflow/compiler/xla/stream_executor/platform.h"
 #include "tensorflow/compiler/xla/xla.pb.h"
 #include "tensorflow/compiler/xla/xla_data.pb.h"
@@ -48,12 +54,14 @@ limitations under the License
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/tensor_shape.pb.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/platform/fingerprint.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensor_serialization.h"
 #include "tensorflow_federated/cc/core/impl/executors/threading.h"
 #include "tensorflow_federated/cc/core/impl/executors/xla_utils.h"
 #include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
 
 // clang-format off
 // In TF 2.17 MultiPlatformManager was renamed to PlatformManager. Remove
@@ -80,13 +88,67 @@ class ServiceTensor {
   xla::PrimitiveType dtype() const { return dtype_; }
   xla::GlobalData* global_data() const { return data_.get(); }
 
+  // Transfers the tensor from the XLA service to the host and serializes it
+  // into `value_pb`. The data in the service is immutable, so the serialized
+  // value is kept and later materializations of the same tensor do not
+  // transfer it again.
+  absl::Status Materialize(xla::Client* client, v0::Value* value_pb) {
+    absl::MutexLock lock(&mutex_);
+    if (!host_value_.has_value()) {
+      absl::StatusOr<xla::Literal> result_literal = client->Transfer(*data_);
+      if (!result_literal.ok()) {
+        return absl::InternalError(absl::StrCat(
+            "Error transferring tensor from XLA service to host. Message: ",
+            result_literal.status().message()));
+      }
+      TFF_TRY(SetHostValueLocked(*result_literal));
+    }
+    *value_pb = *host_value_;
+    return absl::OkStatus();
+  }
+
+  // Whether the tensor was transferred to the host before.
+  bool has_host_value() {
+    absl::MutexLock lock(&mutex_);
+    return host_value_.has_value();
+  }
+
+  // Keeps `literal`, the tensor transferred to the host by other means (e.g.
+  // as an element of a tuple), as the host value of later materializations.
+  absl::Status SetHostValue(const xla::Literal& literal) {
+    absl::MutexLock lock(&mutex_);
+    if (!host_value_.has_value()) {
+      TFF_TRY(SetHostValueLocked(literal));
+    }
+    return absl::OkStatus();
+  }
+
  private:
+  absl::Status SetHostValueLocked(const xla::Literal& literal)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    tensorflow::Tensor tensor_out;
+    absl::Status tensor_conversion = tensorflow::LiteralToHostTensor(
+        literal, TFF_TRY(tensorflow::EncodePrimitiveTypeAsDataType(dtype_)),
+        &tensor_out);
+    if (!tensor_conversion.ok()) {
+      return absl::InternalError(
+          absl::StrCat("Error converting XLA literal to tensor. Message: ",
+                       tensor_conversion.message()));
+    }
+    v0::Value host_value;
+    TFF_TRY(SerializeTensorValue(tensor_out, &host_value));
+    host_value_ = std::move(host_value);
+    return absl::OkStatus();
+  }
+
   // XLA computations can be called with GlobalData* arguments, returning
   // GlobalData unique_ptrs. GlobalData represents an allocation of data in the
   // associated XLA service, so operating GlobalData-to-GlobalData in this way
   // minimizes transfers.
   std::unique_ptr<xla::GlobalData> data_;
   const xla::PrimitiveType dtype_;
+  absl::Mutex mutex_;
+  std::optional<v0::Value> host_value_ ABSL_GUARDED_BY(mutex_);
   // Since we hold a unique pointer internally, ServiceTensor is uncopyable
   // and non-copy-constructable.
   ServiceTensor(const ServiceTensor&) = delete;
@@ -96,35 +158,153 @@ class ServiceTensor {
 // Represents a computation embedded in the XLA client. Responsible for carrying
 // enough information to invoke the computation and ensure results can be
 // materialized at the appropriate time.
+//
+// The flattening of the parameter and result along their bindings is computed
+// once, when the computation is embedded, and reused by every call.
 class Computation {
  public:
   Computation(xla::ExecutionHandle&& compiled_computation,
               v0::Xla::Binding arg_binding, v0::Xla::Binding result_binding,
-              v0::Type computation_type)
+              v0::Type computation_type, int num_arg_elements,
+              std::vector<xla::PrimitiveType> flat_result_types)
       : xla_computation_(std::move(compiled_computation)),
         arg_binding_(std::move(arg_binding)),
         result_binding_(std::move(result_binding)),
-        computation_type_(std::move(computation_type)) {}
+        computation_type_(std::move(computation_type)),
+        num_arg_elements_(num_arg_elements),
+        flat_result_types_(std::move(flat_result_types)) {}
 
   const xla::ExecutionHandle& xla_computation() { return xla_computation_; }
   const v0::Xla::Binding& arg_binding() { return arg_binding_; }
   const v0::Xla::Binding& result_binding() { return result_binding_; }
   const v0::Type& type() { return computation_type_; }
+  // The number of flat tensors the parameter binding specifies.
+  int num_arg_elements() { return num_arg_elements_; }
+  // The element types of the flat tensors the result binding specifies, in
+  // the order of the tuple the computation returns.
+  const std::vector<xla::PrimitiveType>& flat_result_types() {
+    return flat_result_types_;
+  }
 
  private:
   Computation() = delete;
   // A handle to a compiled computation embedded in the XLA service.
-  // Assuming that this computation has been previously compiled in the
-  // service allows us to avoid worrying about caching computations the way
-  // we need to in the TensorFlow executor. If we decide to open up the
-  // TFF-JAX Python API to support unknown shapes and ranks in parameter
-  // tensors, this assumption will need to be relaxed for these cases.
-  // One option might involve preserving the proto and recompiling on the
-  // fly, adding to an internal cache of v0::Type to xla::ExecutionHandles.
+  // Computations are compiled for their argument shapes when they are
+  // embedded, and handles are shared through `CompiledComputationCache`. If we
+  // decide to open up the TFF-JAX Python API to support unknown shapes and
+  // ranks in parameter tensors, computations will need to be compiled when
+  // called instead, using the shapes of the arguments in the cache key.
   const xla::ExecutionHandle xla_computation_;
   const v0::Xla::Binding arg_binding_;
   const v0::Xla::Binding result_binding_;
   const v0::Type computation_type_;
+  const int num_arg_elements_;
+  const std::vector<xla::PrimitiveType> flat_result_types_;
+};
+
+// A process wide cache of the computations compiled by XLA executors, keyed by
+// the client (and so platform) they are compiled with, a fingerprint of the
+// serialized HLO module, and the argument shapes. The same computation is
+// commonly embedded again across rounds and executors, and would otherwise be
+// recompiled each time.
+//
+// The XLA service never unloads compiled executables, so the cache only holds
+// onto their handles and does not evict entries.
+class CompiledComputationCache {
+ public:
+  static CompiledComputationCache& Global() {
+    static CompiledComputationCache* cache = new CompiledComputationCache();
+    return *cache;
+  }
+
+  // Returns the handle to `serialized_hlo_module` compiled with `client` for
+  // `arg_shapes`, compiling it unless it has been compiled before.
+  absl::StatusOr<xla::ExecutionHandle> GetOrCompile(
+      xla::Client* client, const std::string& serialized_hlo_module,
+      absl::Span<const xla::Shape> arg_shapes) {
+    const tensorflow::Fprint128 fingerprint =
+        tensorflow::Fingerprint128(serialized_hlo_module);
+    std::string key =
+        absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                     absl::Hex(fingerprint.low64, absl::kZeroPad16));
+    for (const xla::Shape& shape : arg_shapes) {
+      absl::StrAppend(&key, ";", xla::ShapeUtil::HumanStringWithLayout(shape));
+    }
+    {
+      absl::ReaderMutexLock lock(&mutex_);
+      auto it = handles_.find({client, key});
+      if (it != handles_.end()) {
+        VLOG(2) << "Cache hit for XLA computation: " << key;
+        return it->second;
+      }
+    }
+    VLOG(2) << "Cache MISS for XLA computation: " << key;
+    xla::HloModuleProto hlo_proto;
+    if (!hlo_proto.ParseFromString(serialized_hlo_module)) {
+      return absl::InvalidArgumentError("Could not parse HLO module proto.");
+    }
+    xla::XlaComputation xla_comp(std::move(hlo_proto));
+    absl::StatusOr<xla::ExecutionHandle> handle =
+        client->Compile(xla_comp, arg_shapes);
+    if (!handle.ok()) {
+      return absl::InternalError(
+          absl::StrCat("Failed to compile XLA computation. Message: ",
+                       handle.status().message()));
+    }
+    absl::MutexLock lock(&mutex_);
+    // If another thread compiled the same computation concurrently, keep the
+    // handle it inserted first.
+    return handles_.try_emplace({client, std::move(key)}, *std::move(handle))
+        .first->second;
+  }
+
+  // Returns the handle to a computation gathering its parameters of
+  // `arg_shapes` into a single tuple, compiled with `client` unless it has
+  // been compiled before.
+  absl::StatusOr<xla::ExecutionHandle> GetOrCompileTuple(
+      xla::Client* client, absl::Span<const xla::Shape> arg_shapes) {
+    std::string key = "tuple";
+    for (const xla::Shape& shape : arg_shapes) {
+      absl::StrAppend(&key, ";", xla::ShapeUtil::HumanStringWithLayout(shape));
+    }
+    {
+      absl::ReaderMutexLock lock(&mutex_);
+      auto it = handles_.find({client, key});
+      if (it != handles_.end()) {
+        return it->second;
+      }
+    }
+    xla::XlaBuilder builder("tff_gather_tuple");
+    std::vector<xla::XlaOp> parameters;
+    parameters.reserve(arg_shapes.size());
+    for (int i = 0; i < arg_shapes.size(); ++i) {
+      parameters.push_back(
+          xla::Parameter(&builder, i, arg_shapes[i], absl::StrCat("arg", i)));
+    }
+    xla::Tuple(&builder, parameters);
+    absl::StatusOr<xla::XlaComputation> xla_comp = builder.Build();
+    if (!xla_comp.ok()) {
+      return absl::InternalError(
+          absl::StrCat("Failed to build XLA tuple computation. Message: ",
+                       xla_comp.status().message()));
+    }
+    absl::StatusOr<xla::ExecutionHandle> handle =
+        client->Compile(*xla_comp, arg_shapes);
+    if (!handle.ok()) {
+      return absl::InternalError(
+          absl::StrCat("Failed to compile XLA tuple computation. Message: ",
+                       handle.status().message()));
+    }
+    absl::MutexLock lock(&mutex_);
+    return handles_.try_emplace({client, std::move(key)}, *std::move(handle))
+        .first->second;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::pair<xla::Client*, std::string>,
+                      xla::ExecutionHandle>
+      handles_ ABSL_GUARDED_BY(mutex_);
 };
 
 // Representation for values embedded in the XLA executor. Generally, this class
@@ -360,6 +540,47 @@ absl::StatusOr<XLAExecutorValue> PackageFlatValuesAsBinding(
   }
 }
 
+// A tensor deserialized on the host, along with a literal borrowing its buffer
+// for transfer to the XLA service.
+struct HostTensor {
+  tensorflow::Tensor tensor;
+  xla::BorrowingLiteral literal;
+  xla::PrimitiveType element_type;
+};
+
+absl::Status HostTensorFromValue(const v0::Value& value_pb,
+                                 HostTensor& host_tensor) {
+  host_tensor.tensor = TFF_TRY(DeserializeTensorValue(value_pb));
+  absl::Status to_literal_status = tensorflow::HostTensorToBorrowingLiteral(
+      host_tensor.tensor, &host_tensor.literal);
+  if (!to_literal_status.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Failed to convert v0::Value proto to XLA literal. Message: ",
+        to_literal_status.message()));
+  }
+  absl::Status status = tensorflow::DataTypeToPrimitiveType(
+      host_tensor.tensor.dtype(), &host_tensor.element_type);
+  if (!status.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Failure to convert tensorflow::DataType to XLA primitive: ",
+        status.message()));
+  }
+  return absl::OkStatus();
+}
+
+// Appends the tensors nested in `struct_pb` to `tensor_pbs`, in depth-first
+// order.
+void CollectNestedTensors(const v0::Value::Struct& struct_pb,
+                          std::vector<const v0::Value*>& tensor_pbs) {
+  for (const auto& el : struct_pb.element()) {
+    if (el.value().has_tensor()) {
+      tensor_pbs.push_back(&el.value());
+    } else if (el.value().has_struct_()) {
+      CollectNestedTensors(el.value().struct_(), tensor_pbs);
+    }
+  }
+}
+
 using ValueFuture = std::shared_future<absl::StatusOr<XLAExecutorValue>>;
 
 class XLAExecutor : public ExecutorBase<ValueFuture> {
@@ -428,14 +649,8 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
 
   absl::Status Materialize(ValueFuture value, v0::Value* value_pb) final {
     XLAExecutorValue executor_value = TFF_TRY(Wait(value));
-    // TODO: b/337049385 - Use of ParallelTasks here is known to potentially
-    // segfault when under heavy load and large structures in the `value` future
-    // because of thread exhaustion. See how the TensorFlowExecutor limits the
-    // number of parallel threads for potential ideas.
-    ParallelTasks tasks;
-    TFF_TRY(MaterializeXLAValue(executor_value, value_pb, tasks));
-    TFF_TRY(tasks.WaitAll());
-    return absl::OkStatus();
+    TFF_TRY(TransferToHost(executor_value));
+    return MaterializeXLAValue(executor_value, value_pb);
   }
 
  private:
@@ -445,31 +660,64 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
 
   absl::StatusOr<XLAExecutorValue> CreateValueTensor(
       const v0::Value& value_pb) {
-    tensorflow::Tensor t = TFF_TRY(DeserializeTensorValue(value_pb));
-    xla::BorrowingLiteral tensor_literal;
-    absl::Status to_literal_status =
-        tensorflow::HostTensorToBorrowingLiteral(t, &tensor_literal);
-    if (!to_literal_status.ok()) {
-      return absl::InvalidArgumentError(absl::StrCat(
-          "Failed to convert v0::Value proto to XLA literal. Message: ",
-          to_literal_status.message()));
-    }
+    HostTensor host_tensor;
+    TFF_TRY(HostTensorFromValue(value_pb, host_tensor));
     absl::StatusOr<std::unique_ptr<xla::GlobalData>> data_in_server =
-        xla_client_->TransferToServer(tensor_literal);
+        xla_client_->TransferToServer(host_tensor.literal);
     if (!data_in_server.ok()) {
       return absl::InvalidArgumentError(absl::StrCat(
           "Failed to transfer XLA literal to local server. Message: ",
-          to_literal_status.message()));
+          data_in_server.status().message()));
+    }
+    return XLAExecutorValue(std::move(*data_in_server),
+                            host_tensor.element_type);
+  }
+
+  // Transfers the tensors of `tensor_pbs` to the XLA service as a single tuple,
+  // whose elements are then split in the service, rather than transferring
+  // each tensor on its own.
+  absl::StatusOr<std::vector<XLAExecutorValue>> CreateValueTensors(
+      absl::Span<const v0::Value* const> tensor_pbs) {
+    std::vector<XLAExecutorValue> values;
+    values.reserve(tensor_pbs.size());
+    if (tensor_pbs.size() == 1) {
+      values.push_back(TFF_TRY(CreateValueTensor(*tensor_pbs[0])));
+      return values;
+    }
+    // The literals borrow the buffers of the tensors, so neither may move
+    // until the transfer is done.
+    std::vector<HostTensor> host_tensors(tensor_pbs.size());
+    std::vector<const char*> buffers;
+    std::vector<xla::Shape> shapes;
+    buffers.reserve(tensor_pbs.size());
+    shapes.reserve(tensor_pbs.size());
+    for (int i = 0; i < tensor_pbs.size(); ++i) {
+      TFF_TRY(HostTensorFromValue(*tensor_pbs[i], host_tensors[i]));
+      buffers.push_back(
+          static_cast<const char*>(host_tensors[i].literal.untyped_data()));
+      shapes.push_back(host_tensors[i].literal.shape());
     }
-    xla::PrimitiveType element_type;
-    absl::Status status =
-        tensorflow::DataTypeToPrimitiveType(t.dtype(), &element_type);
-    if (!status.ok()) {
+    xla::BorrowingLiteral tuple_literal(buffers,
+                                        xla::ShapeUtil::MakeTupleShape(shapes));
+    absl::StatusOr<std::unique_ptr<xla::GlobalData>> tuple_in_server =
+        xla_client_->TransferToServer(tuple_literal);
+    if (!tuple_in_server.ok()) {
       return absl::InvalidArgumentError(absl::StrCat(
-          "Failure to convert tensorflow::DataType to XLA primitive: ",
-          status.message()));
+          "Failed to transfer XLA literal to local server. Message: ",
+          tuple_in_server.status().message()));
+    }
+    absl::StatusOr<std::vector<std::unique_ptr<xla::GlobalData>>>
+        data_in_server = xla_client_->DeconstructTuple(**tuple_in_server);
+    if (!data_in_server.ok()) {
+      return absl::InternalError(absl::StrCat(
+          "Error destructuring tuple in XLA executor. Message: ",
+          data_in_server.status().message()));
     }
-    return XLAExecutorValue(std::move(*data_in_server), element_type);
+    for (int i = 0; i < tensor_pbs.size(); ++i) {
+      values.emplace_back(std::move((*data_in_server)[i]),
+                          host_tensors[i].element_type);
+    }
+    return values;
   }
 
   absl::StatusOr<XLAExecutorValue> CreateValueComputation(
@@ -482,9 +730,12 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
                            "encountered in XLA executor. Type: ",
                            comp_pb.type().Utf8DebugString()));
         }
-        xla::HloModuleProto hlo_proto;
-        comp_pb.xla().hlo_module().UnpackTo(&hlo_proto);
-        xla::XlaComputation xla_comp(std::move(hlo_proto));
+        if (!comp_pb.xla().hlo_module().Is<xla::HloModuleProto>()) {
+          return absl::InvalidArgumentError(absl::StrCat(
+              "Unsupported type in XLA computation: ",
+              comp_pb.xla().hlo_module().type_url(),
+              ". Only HloModuleProto is supported."));
+        }
         // Compute the vector of flat arg shapes; these will be needed to
         // compile the computation.
         v0::Xla::Binding arg_binding = comp_pb.xla().parameter();
@@ -496,21 +747,33 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
           TFF_TRY(ComputeFlatShapesFromType(
               comp_pb.type().function().parameter(), arg_binding, &arg_shapes));
         }
-        // Compile the computation, resulting in caching the executable in
-        // the XLA service.
-        absl::StatusOr<xla::ExecutionHandle> computation_handle =
-            xla_client_->Compile(xla_comp, arg_shapes);
-        if (!computation_handle.ok()) {
-          return absl::InternalError(
-              absl::StrCat("Failed to compile XLA computation. Message: ",
-                           computation_handle.status().message()));
+        // Compile the computation ahead of its calls, resulting in caching the
+        // executable in the XLA service. Computations compiled before for the
+        // same shapes reuse their executable.
+        xla::ExecutionHandle computation_handle =
+            TFF_TRY(CompiledComputationCache::Global().GetOrCompile(
+                xla_client_, comp_pb.xla().hlo_module().value(), arg_shapes));
+        // Compute the element types of the flat results once, so that calls
+        // need not walk the result type and binding again.
+        v0::Xla::Binding result_binding = comp_pb.xla().result();
+        std::vector<v0::TensorType> flat_result_tensor_types(
+            ComputeNumElementsFromBinding(result_binding));
+        if (result_binding.has_tensor() || result_binding.has_struct_()) {
+          TFF_TRY(FlattenTypeToTensors(comp_pb.type().function().result(),
+                                       result_binding,
+                                       &flat_result_tensor_types));
+        }
+        std::vector<xla::PrimitiveType> flat_result_types;
+        flat_result_types.reserve(flat_result_tensor_types.size());
+        for (const v0::TensorType& tensor_type : flat_result_tensor_types) {
+          flat_result_types.push_back(
+              TFF_TRY(PrimitiveTypeFromDataType(tensor_type.dtype())));
         }
         // Finally, construct the representation of this computation in the
         // XLA executor.
-        v0::Xla::Binding result_binding = comp_pb.xla().result();
         return XLAExecutorValue(std::make_shared<Computation>(
-            std::move(*computation_handle), arg_binding, result_binding,
-            comp_pb.type()));
+            std::move(computation_handle), arg_binding, result_binding,
+            comp_pb.type(), num_arg_elements, std::move(flat_result_types)));
       }
       case v0::Computation::kLiteral: {
         absl::StatusOr<std::unique_ptr<xla::GlobalData>> data =
@@ -534,12 +797,36 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
     }
   }
 
+  // Creates a struct value, transferring all the tensors nested in it to the
+  // XLA service at once.
   absl::StatusOr<XLAExecutorValue> CreateValueStruct(
       const v0::Value::Struct& struct_pb) {
+    std::vector<const v0::Value*> tensor_pbs;
+    CollectNestedTensors(struct_pb, tensor_pbs);
+    std::vector<XLAExecutorValue> tensor_values;
+    if (!tensor_pbs.empty()) {
+      tensor_values = TFF_TRY(CreateValueTensors(tensor_pbs));
+    }
+    int next_tensor = 0;
+    return PackageStructWithTensors(struct_pb, tensor_values, next_tensor);
+  }
+
+  // Creates a struct value of the structure of `struct_pb`, whose tensors are
+  // taken in order from `tensor_values` starting at `next_tensor`.
+  absl::StatusOr<XLAExecutorValue> PackageStructWithTensors(
+      const v0::Value::Struct& struct_pb,
+      const std::vector<XLAExecutorValue>& tensor_values, int& next_tensor) {
     std::vector<XLAExecutorValue> values;
     values.reserve(struct_pb.element_size());
     for (const auto& el : struct_pb.element()) {
-      values.emplace_back(TFF_TRY(CreateValueAny(el.value())));
+      if (el.value().has_tensor()) {
+        values.push_back(tensor_values[next_tensor++]);
+      } else if (el.value().has_struct_()) {
+        values.emplace_back(TFF_TRY(PackageStructWithTensors(
+            el.value().struct_(), tensor_values, next_tensor)));
+      } else {
+        values.emplace_back(TFF_TRY(CreateValueAny(el.value())));
+      }
     }
     return XLAExecutorValue(values);
   }
@@ -560,45 +847,88 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
     }
   }
 
-  // NOTE: Just like in TF executor, `value` reference must remain valid until
-  // `tasks.WaitAll` returns. Additionally, here the captured `this` pointer
-  // must also remain valid.
+  // Collects the tensors nested in `executor_value` which have not been
+  // transferred to the host yet.
+  static void CollectUntransferredTensors(
+      const XLAExecutorValue& executor_value,
+      std::vector<std::shared_ptr<ServiceTensor>>& tensors) {
+    switch (executor_value.type()) {
+      case XLAExecutorValue::ValueType::TENSOR:
+        if (!executor_value.tensor()->has_host_value()) {
+          tensors.push_back(executor_value.tensor());
+        }
+        return;
+      case XLAExecutorValue::ValueType::STRUCT:
+        for (const auto& el : executor_value.structure()) {
+          CollectUntransferredTensors(el, tensors);
+        }
+        return;
+      default:
+        return;
+    }
+  }
+
+  // Transfers the tensors nested in `executor_value` to the host at once, by
+  // gathering them into a tuple in the XLA service and transferring the tuple,
+  // rather than transferring each tensor on its own. The host values are kept
+  // by the tensors, which are then materialized without further transfers.
+  absl::Status TransferToHost(const XLAExecutorValue& executor_value) {
+    std::vector<std::shared_ptr<ServiceTensor>> tensors;
+    CollectUntransferredTensors(executor_value, tensors);
+    if (tensors.size() < 2) {
+      // A single tensor is transferred as it is materialized.
+      return absl::OkStatus();
+    }
+    std::vector<xla::Shape> shapes;
+    std::vector<xla::GlobalData*> args;
+    shapes.reserve(tensors.size());
+    args.reserve(tensors.size());
+    for (const std::shared_ptr<ServiceTensor>& tensor : tensors) {
+      absl::StatusOr<xla::Shape> shape =
+          xla_client_->GetShape(*tensor->global_data());
+      if (!shape.ok()) {
+        return absl::InternalError(
+            absl::StrCat("Error getting the shape of XLA tensor. Message: ",
+                         shape.status().message()));
+      }
+      shapes.push_back(*std::move(shape));
+      args.push_back(tensor->global_data());
+    }
+    xla::ExecutionHandle gather_tuple = TFF_TRY(
+        CompiledComputationCache::Global().GetOrCompileTuple(xla_client_,
+                                                             shapes));
+    absl::StatusOr<std::unique_ptr<xla::GlobalData>> tuple_in_server =
+        xla_client_->Execute(gather_tuple, args);
+    if (!tuple_in_server.ok()) {
+      return absl::InternalError(
+          absl::StrCat("Error gathering XLA tensors into a tuple. Message: ",
+                       tuple_in_server.status().message()));
+    }
+    absl::StatusOr<xla::Literal> tuple_literal =
+        xla_client_->Transfer(**tuple_in_server);
+    if (!tuple_literal.ok()) {
+      return absl::InternalError(absl::StrCat(
+          "Error transferring tensor from XLA service to host. Message: ",
+          tuple_literal.status().message()));
+    }
+    std::vector<xla::Literal> literals = tuple_literal->DecomposeTuple();
+    for (int i = 0; i < tensors.size(); ++i) {
+      TFF_TRY(tensors[i]->SetHostValue(literals[i]));
+    }
+    return absl::OkStatus();
+  }
+
   absl::Status MaterializeXLAValue(const XLAExecutorValue& executor_value,
-                                   v0::Value* value_pb, ParallelTasks& tasks) {
+                                   v0::Value* value_pb) {
     switch (executor_value.type()) {
       case XLAExecutorValue::ValueType::TENSOR: {
-        // We add tensor materialization and serialization to the ParallelTasks
-        // instance we are passed down, and avoid blocking here.
-        return tasks.add_task([&executor_value, value_pb, this]() {
-          std::shared_ptr<ServiceTensor> tensor_in_service =
-              executor_value.tensor();
-          absl::StatusOr<xla::Literal> result_literal =
-              xla_client_->Transfer(*(tensor_in_service->global_data()));
-          if (!result_literal.ok()) {
-            return absl::InternalError(absl::StrCat(
-                "Error transferring tensor from XLA service to host. Message: ",
-                result_literal.status().message()));
-          }
-          tensorflow::Tensor tensor_out;
-          absl::Status tensor_conversion = tensorflow::LiteralToHostTensor(
-              *result_literal,
-              TFF_TRY(tensorflow::EncodePrimitiveTypeAsDataType(
-                  tensor_in_service->dtype())),
-              &tensor_out);
-          if (!tensor_conversion.ok()) {
-            return absl::InternalError(absl::StrCat(
-                "Error converting XLA literal to tensor. Message: ",
-                tensor_conversion.message()));
-          }
-          TFF_TRY(SerializeTensorValue(tensor_out, value_pb));
-          return absl::OkStatus();
-        });
+        return executor_value.tensor()->Materialize(xla_client_, value_pb);
       }
       case XLAExecutorValue::ValueType::STRUCT: {
         v0::Value::Struct* mutable_struct = value_pb->mutable_struct_();
         for (const auto& el : executor_value.structure()) {
           TFF_TRY(MaterializeXLAValue(
-              el, mutable_struct->add_element()->mutable_value(), tasks));
+              el, mutable_struct->add_element()->mutable_value()));
         }
         return absl::OkStatus();
       }
@@ -612,9 +942,7 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
 
   absl::StatusOr<XLAExecutorValue> CallComputation(
       std::shared_ptr<Computation> fn, std::optional<XLAExecutorValue> arg) {
-    int num_parameter_elements =
-        ComputeNumElementsFromBinding(fn->arg_binding());
-    std::vector<xla::GlobalData*> arg_vector(num_parameter_elements);
+    std::vector<xla::GlobalData*> arg_vector(fn->num_arg_elements());
     if (arg.has_value()) {
       TFF_TRY(
           FlattenValuesIntoBinding(fn->arg_binding(), arg.value(), arg_vector));
@@ -644,10 +972,8 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
                            "output, instead output was a tuple with",
                            maybe_global_data_vector->size(), " elements."));
         }
-        return XLAExecutorValue(
-            std::move(maybe_global_data_vector.value()[0]),
-            TFF_TRY(PrimitiveTypeFromDataType(
-                fn->type().function().result().tensor().dtype())));
+        return XLAExecutorValue(std::move(maybe_global_data_vector.value()[0]),
+                                fn->flat_result_types()[0]);
       }
       case v0::Xla::Binding::kStruct: {
         absl::StatusOr<std::vector<std::unique_ptr<xla::GlobalData>>>
@@ -657,24 +983,24 @@ class XLAExecutor : public ExecutorBase<ValueFuture> {
               "Error destructuring tuple in XLA executor. Message: ",
               global_data_vector.status().message()));
         }
-        // We begin by constructing a vector of tensor-backed XLAExecutorValues.
-        // For this purpose, we must compute the datatypes of the GlobalData
-        // elements (XLA will need them to materialize values from the XLA
-        // client), from the combination of the return type of the function and
-        // the result binding.
+        // We begin by constructing a vector of tensor-backed XLAExecutorValues,
+        // using the datatypes of the GlobalData elements computed when the
+        // computation was embedded (XLA will need them to materialize values
+        // from the XLA client).
+        const std::vector<xla::PrimitiveType>& flat_result_types =
+            fn->flat_result_types();
+        if (global_data_vector->size() < flat_result_types.size()) {
+          return absl::InternalError(absl::StrCat(
+              "Expected a tuple of ", flat_result_types.size(),
+              " tensors as the result of the XLA computation, instead output "
+              "was a tuple with ",
+              global_data_vector->size(), " elements."));
+        }
         std::vector<XLAExecutorValue> flat_value_vector;
-        int result_elements = ComputeNumElementsFromBinding(result_binding);
-        // Preallocate the flat types tensor as required to assign directly to
-        // its elements.
-        std::vector<v0::TensorType> flat_tensor_types(result_elements);
-        TFF_TRY(FlattenTypeToTensors(fn->type().function().result(),
-                                     result_binding, &flat_tensor_types));
-        flat_value_vector.reserve(flat_tensor_types.size());
-        for (int i = 0; i < flat_tensor_types.size(); i++) {
+        flat_value_vector.reserve(flat_result_types.size());
+        for (int i = 0; i < flat_result_types.size(); i++) {
           flat_value_vector.emplace_back(XLAExecutorValue(
-              std::move((*global_data_vector)[i]),
-              TFF_TRY(
-                  PrimitiveTypeFromDataType(flat_tensor_types[i].dtype()))));
+              std::move((*global_data_vector)[i]), flat_result_types[i]));
         }
         // We repackage the flat result as an XLAExecutorValue of the same
         // structure as the result binding. This structure should additionally
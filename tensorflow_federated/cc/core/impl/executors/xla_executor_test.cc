@@ -244,6 +244,28 @@ TEST_F(XLAExecutorTest, RoundTripStructOfNestedTensors) {
   CheckRoundTrip(input_pb);
 }
 
+TEST_F(XLAExecutorTest, RoundTripStructOfManyMixedTensors) {
+  std::vector<v0::Value> elements;
+  for (int i = 0; i < 100; ++i) {
+    elements.push_back(StructV(
+        {TensorV(i), TensorV(static_cast<float>(i)),
+         TensorV(tensorflow::DT_FLOAT, tensorflow::TensorShape({2, 3}))}));
+  }
+  elements.push_back(StructV({}));
+  v0::Value input_pb = StructV(elements);
+  CheckRoundTrip(input_pb);
+}
+
+TEST_F(XLAExecutorTest, RoundTripStructWithNestedStringTensorFails) {
+  v0::Value input_pb =
+      StructV({TensorV(1), StructV({TensorV(2.0f), TensorV("a_string")})});
+  CheckRoundTripFails(
+      input_pb,
+      StatusIs(
+          absl::StatusCode::kInvalidArgument,
+          HasSubstr("Unsupported type in DataTypeToPrimitiveType: 'string'")));
+}
+
 TEST_F(XLAExecutorTest, RoundTripStringTensorFails) {
   // String tensors are unsupported in XLA; see
   // https://github.com/tensorflow/tensorflow/issues/19140, and the enumeration
@@ -464,6 +486,73 @@ TEST_F(XLAExecutorTest, CreateAndMaterializeNoArgCallSingleTensor) {
   CheckMaterializeEqual(called_fn, expected_result);
 }
 
+TEST_F(XLAExecutorTest, CreateAndMaterializeSameComputationInTwoExecutors) {
+  xla::XlaBuilder builder("return_three");
+  xla::XlaOp constant = xla::ConstantR0<float>(&builder, 3.0);
+  xla::Tuple(&builder, {constant});
+  tensorflow::StatusOr<xla::XlaComputation> xla_computation = builder.Build();
+  ASSERT_TRUE(xla_computation.ok());
+  auto tensor_type = TensorT(v0::DataType::DT_FLOAT);
+  v0::Value computation = ComputationV(
+      std::nullopt, std::get<0>(TFF_ASSERT_OK(BindingFromType(tensor_type, 0))),
+      std::move(*xla_computation), NoArgFunctionT(tensor_type));
+  // The second executor reuses the executable compiled by the first one.
+  std::shared_ptr<Executor> other_executor = TFF_ASSERT_OK(
+      CreateXLAExecutor(absl::GetFlag(FLAGS_tff_xla_executor_test_platform)));
+
+  for (const auto& executor : {test_executor_, other_executor}) {
+    TFF_ASSERT_OK_AND_ASSIGN(OwnedValueId embedded_fn,
+                             executor->CreateValue(computation));
+    TFF_ASSERT_OK_AND_ASSIGN(
+        OwnedValueId called_fn,
+        executor->CreateCall(embedded_fn.ref(), std::nullopt));
+    v0::Value output_pb;
+    TFF_ASSERT_OK(executor->Materialize(called_fn, &output_pb));
+    EXPECT_THAT(output_pb, EqualsProto(TensorV(3.0f)));
+  }
+}
+
+TEST_F(XLAExecutorTest, MaterializeCallResultTwice) {
+  xla::XlaBuilder builder("return_four");
+  xla::XlaOp constant = xla::ConstantR0<float>(&builder, 4.0);
+  xla::Tuple(&builder, {constant});
+  tensorflow::StatusOr<xla::XlaComputation> xla_computation = builder.Build();
+  ASSERT_TRUE(xla_computation.ok());
+  auto tensor_type = TensorT(v0::DataType::DT_FLOAT);
+  v0::Value computation = ComputationV(
+      std::nullopt, std::get<0>(TFF_ASSERT_OK(BindingFromType(tensor_type, 0))),
+      std::move(*xla_computation), NoArgFunctionT(tensor_type));
+
+  TFF_ASSERT_OK_AND_ASSIGN(OwnedValueId embedded_fn,
+                           test_executor_->CreateValue(computation));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      OwnedValueId called_fn,
+      test_executor_->CreateCall(embedded_fn.ref(), std::nullopt));
+  TFF_ASSERT_OK_AND_ASSIGN(OwnedValueId struct_id,
+                           test_executor_->CreateStruct({called_fn.ref()}));
+  // The second materialization reuses the host copy of the first one.
+  CheckMaterializeEqual(called_fn, TensorV(4.0f));
+  CheckMaterializeEqual(called_fn, TensorV(4.0f));
+  CheckMaterializeEqual(struct_id, StructV({TensorV(4.0f)}));
+}
+
+TEST_F(XLAExecutorTest, MaterializeStructWithPartlyMaterializedTensors) {
+  TFF_ASSERT_OK_AND_ASSIGN(OwnedValueId first,
+                           test_executor_->CreateValue(TensorV(1.0f)));
+  TFF_ASSERT_OK_AND_ASSIGN(OwnedValueId second,
+                           test_executor_->CreateValue(TensorV(2)));
+  TFF_ASSERT_OK_AND_ASSIGN(OwnedValueId third,
+                           test_executor_->CreateValue(TensorV(3.0f)));
+  TFF_ASSERT_OK_AND_ASSIGN(
+      OwnedValueId struct_id,
+      test_executor_->CreateStruct({first.ref(), second.ref(), third.ref()}));
+  CheckMaterializeEqual(second, TensorV(2));
+  // The tensors not materialized yet are transferred to the host together.
+  CheckMaterializeEqual(
+      struct_id, StructV({TensorV(1.0f), TensorV(2), TensorV(3.0f)}));
+  CheckMaterializeEqual(third, TensorV(3.0f));
+}
+
 TEST_F(XLAExecutorTest, CreateAndMaterializeNoArgCallTensorStructure) {
   xla::XlaBuilder builder("return_two_tensors");
   auto float_one = xla::ConstantR0<float>(&builder, 1.0);
@@ -18,10 +18,13 @@ limitations under the License
 #include <algorithm>
 #include <complex>
 #include <cstdint>
+#include <cstring>
+#include <string>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tensorflow/compiler/xla/literal.h"
 #include "tensorflow/compiler/xla/shape.h"
 #include "tensorflow/compiler/xla/shape_util.h"
@@ -91,38 +94,87 @@ absl::StatusOr<xla::Shape> ShapeFromArrayShape(v0::DataType data_type,
       TFF_TRY(PrimitiveTypeFromDataType(data_type)), shape_pb.dim());
 }
 
+// Returns an error unless `num_values` values fill `num_elements` elements of
+// `values_per_element` values each.
+static absl::Status CheckNumValues(int64_t num_values, int64_t num_elements,
+                                   int64_t values_per_element = 1) {
+  if (num_values != num_elements * values_per_element) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected ", num_elements * values_per_element,
+        " values for an array of ", num_elements, " elements, found ",
+        num_values, "."));
+  }
+  return absl::OkStatus();
+}
+
 template <typename T>
-static void CopyFromRepeatedField(const google::protobuf::RepeatedField<T>& src,
-                                  T* dest) {
-  std::copy(src.begin(), src.end(), dest);
+static absl::Status CopyFromRepeatedField(
+    const google::protobuf::RepeatedField<T>& src, absl::Span<T> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size()));
+  if (!dest.empty()) {
+    std::memcpy(dest.data(), src.data(), dest.size() * sizeof(T));
+  }
+  return absl::OkStatus();
 }
 
 // Overload for different SrcType and DestType.
 template <typename SrcType, typename DestType>
-static void CopyFromRepeatedField(const google::protobuf::RepeatedField<SrcType>& src,
-                                  DestType* dest) {
+static absl::Status CopyFromRepeatedField(
+    const google::protobuf::RepeatedField<SrcType>& src,
+    absl::Span<DestType> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size()));
   std::transform(
-      src.begin(), src.end(), dest,
+      src.begin(), src.end(), dest.begin(),
       [](const SrcType& x) -> DestType { return static_cast<DestType>(x); });
+  return absl::OkStatus();
 }
 
 // Overload for Eigen::half.
-static void CopyFromRepeatedField(const google::protobuf::RepeatedField<int32_t>& src,
-                                  Eigen::half* dest) {
+static absl::Status CopyFromRepeatedField(
+    const google::protobuf::RepeatedField<int32_t>& src,
+    absl::Span<Eigen::half> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size()));
   // Values of dtype np.float16 are packed to and unpacked from a protobuf
   // field of type int32 using the following logic in order to maintain
   // compatibility with how other external environments (e.g. TensorFlow, Jax)
   // represent values of np.float16.
-  std::transform(src.begin(), src.end(), dest, [](int x) -> Eigen::half {
-    return Eigen::numext::bit_cast<Eigen::half>(static_cast<uint16_t>(x));
-  });
+  std::transform(src.begin(), src.end(), dest.begin(),
+                 [](int x) -> Eigen::half {
+                   return Eigen::numext::bit_cast<Eigen::half>(
+                       static_cast<uint16_t>(x));
+                 });
+  return absl::OkStatus();
 }
 
 // Overload for complex.
 template <typename T>
-static void CopyFromRepeatedField(const google::protobuf::RepeatedField<T>& src,
-                                  std::complex<T>* dest) {
-  std::copy(src.begin(), src.end(), reinterpret_cast<T*>(dest));
+static absl::Status CopyFromRepeatedField(
+    const google::protobuf::RepeatedField<T>& src,
+    absl::Span<std::complex<T>> dest) {
+  TFF_TRY(CheckNumValues(src.size(), dest.size(), /*values_per_element=*/2));
+  if (!dest.empty()) {
+    std::memcpy(dest.data(), src.data(),
+                dest.size() * sizeof(std::complex<T>));
+  }
+  return absl::OkStatus();
+}
+
+// Creates a xla::Literal from the raw `content` of a v0::Array.
+static absl::StatusOr<xla::Literal> LiteralFromArrayContent(
+    const v0::Array& array_pb) {
+  xla::Literal literal(
+      TFF_TRY(ShapeFromArrayShape(array_pb.dtype(), array_pb.shape())));
+  const std::string& content = array_pb.content();
+  if (content.size() != literal.size_bytes()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Expected ", literal.size_bytes(), " bytes of `content` for an array ",
+        "of shape ", literal.shape().ToString(), ", found ", content.size(),
+        "."));
+  }
+  if (!content.empty()) {
+    std::memcpy(literal.untyped_data(), content.data(), content.size());
+  }
+  return literal;
 }
 
 absl::StatusOr<xla::Literal> LiteralFromArray(const v0::Array& array_pb) {
@@ -130,101 +182,103 @@ absl::StatusOr<xla::Literal> LiteralFromArray(const v0::Array& array_pb) {
     case v0::Array::kBoolList: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_BOOL, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.bool_list().value(),
-                            literal.data<bool>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.bool_list().value(),
+                                    literal.data<bool>()));
       return literal;
     }
     case v0::Array::kInt8List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_INT8, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.int8_list().value(),
-                            literal.data<int8_t>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.int8_list().value(),
+                                    literal.data<int8_t>()));
       return literal;
     }
     case v0::Array::kInt16List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_INT16, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.int16_list().value(),
-                            literal.data<int16_t>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.int16_list().value(),
+                                    literal.data<int16_t>()));
       return literal;
     }
     case v0::Array::kInt32List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_INT32, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.int32_list().value(),
-                            literal.data<int32_t>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.int32_list().value(),
+                                    literal.data<int32_t>()));
       return literal;
     }
     case v0::Array::kInt64List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_INT64, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.int64_list().value(),
-                            literal.data<int64_t>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.int64_list().value(),
+                                    literal.data<int64_t>()));
       return literal;
     }
     case v0::Array::kUint8List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_UINT8, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.uint8_list().value(),
-                            literal.data<uint8_t>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.uint8_list().value(),
+                                    literal.data<uint8_t>()));
       return literal;
     }
     case v0::Array::kUint16List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_UINT16, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.uint16_list().value(),
-                            literal.data<uint16_t>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.uint16_list().value(),
+                                    literal.data<uint16_t>()));
       return literal;
     }
     case v0::Array::kUint32List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_UINT32, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.uint32_list().value(),
-                            literal.data<uint32_t>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.uint32_list().value(),
+                                    literal.data<uint32_t>()));
       return literal;
     }
     case v0::Array::kUint64List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_UINT64, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.uint64_list().value(),
-                            literal.data<uint64_t>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.uint64_list().value(),
+                                    literal.data<uint64_t>()));
       return literal;
     }
     case v0::Array::kFloat16List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_HALF, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.float16_list().value(),
-                            literal.data<xla::half>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.float16_list().value(),
+                                    literal.data<xla::half>()));
       return literal;
     }
     case v0::Array::kFloat32List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_FLOAT, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.float32_list().value(),
-                            literal.data<float>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.float32_list().value(),
+                                    literal.data<float>()));
       return literal;
     }
     case v0::Array::kFloat64List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_DOUBLE, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.float64_list().value(),
-                            literal.data<double>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.float64_list().value(),
+                                    literal.data<double>()));
       return literal;
     }
     case v0::Array::kComplex64List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_COMPLEX64, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.complex64_list().value(),
-                            literal.data<xla::complex64>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.complex64_list().value(),
+                                    literal.data<xla::complex64>()));
       return literal;
     }
     case v0::Array::kComplex128List: {
       xla::Literal literal(TFF_TRY(
           ShapeFromArrayShape(v0::DataType::DT_COMPLEX128, array_pb.shape())));
-      CopyFromRepeatedField(array_pb.complex128_list().value(),
-                            literal.data<xla::complex128>().begin());
+      TFF_TRY(CopyFromRepeatedField(array_pb.complex128_list().value(),
+                                    literal.data<xla::complex128>()));
       return literal;
     }
+    case v0::Array::kContent:
+      return LiteralFromArrayContent(array_pb);
     default:
       return absl::UnimplementedError(
           absl::StrCat("Unexpected DataType found:", array_pb.kind_case()));
@@ -300,6 +300,42 @@ TEST(LiteralFromArrayTest, TestReturnsLiteral_array) {
   EXPECT_EQ(actual_literal, expected_literal);
 }
 
+TEST(LiteralFromArrayTest, TestReturnsLiteral_content) {
+  const int32_t values[] = {1, 2, 3, 4, 5, 6};
+  v0::Array array_pb;
+  array_pb.set_dtype(v0::DataType::DT_INT32);
+  *array_pb.mutable_shape() = testing::CreateArrayShape({2, 3});
+  array_pb.set_content(reinterpret_cast<const char*>(values), sizeof(values));
+
+  const xla::Literal& actual_literal =
+      TFF_ASSERT_OK(LiteralFromArray(array_pb));
+
+  xla::Literal expected_literal =
+      xla::LiteralUtil::CreateR2<int32_t>({{1, 2, 3}, {4, 5, 6}});
+  EXPECT_EQ(actual_literal, expected_literal);
+}
+
+TEST(LiteralFromArrayTest, TestFails_content_size_mismatch) {
+  const int32_t values[] = {1, 2, 3};
+  v0::Array array_pb;
+  array_pb.set_dtype(v0::DataType::DT_INT32);
+  *array_pb.mutable_shape() = testing::CreateArrayShape({2, 3});
+  array_pb.set_content(reinterpret_cast<const char*>(values), sizeof(values));
+
+  const absl::StatusOr<xla::Literal>& result = LiteralFromArray(array_pb);
+
+  EXPECT_EQ(result.status().code(), absl::StatusCode::kInvalidArgument);
+}
+
+TEST(LiteralFromArrayTest, TestFails_value_count_mismatch) {
+  const v0::Array& array_pb = TFF_ASSERT_OK(testing::CreateArray(
+      v0::DataType::DT_INT32, testing::CreateArrayShape({2, 3}), {1, 2, 3}));
+
+  const absl::StatusOr<xla::Literal>& result = LiteralFromArray(array_pb);
+
+  EXPECT_EQ(result.status().code(), absl::StatusCode::kInvalidArgument);
+}
+
 TEST(LiteralFromArrayTest, TestFails_string) {
   const v0::Array& array_pb = TFF_ASSERT_OK(testing::CreateArray(
       v0::DataType::DT_STRING, testing::CreateArrayShape({}), {"a"}));
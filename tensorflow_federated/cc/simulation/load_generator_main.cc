@@ -0,0 +1,516 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+// Generates load on an `ExecutorService`, e.g. a worker started by
+// `worker_binary`, to measure the RPCs and bytes per second it sustains.
+//
+// Each of --concurrent_clients clients opens a connection of its own, gets an
+// executor, and issues a random mix of `CreateValue`, `CreateCall` and
+// `Compute` requests on synthetic float tensors until --duration_seconds
+// elapse. Every --report_interval_seconds, the binary prints the rate, bytes
+// and latency quantiles of each method, and the CPU use and resident memory of
+// the server if --server_pid is set. The resident memory over a long run shows
+// whether the server leaks the values or executors which the clients dispose
+// of.
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "include/grpc/grpc.h"
+#include "include/grpcpp/create_channel.h"
+#include "include/grpcpp/grpcpp.h"
+#include "include/grpcpp/security/credentials.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow_federated/cc/core/impl/aggregation/base/metrics.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
+#include "tensorflow_federated/proto/v0/executor.grpc.pb.h"
+#include "tensorflow_federated/proto/v0/executor.pb.h"
+
+ABSL_FLAG(std::string, target, "localhost:10000",
+          "Address of the executor service to load.");
+ABSL_FLAG(int32_t, concurrent_clients, 8,
+          "The number of clients issuing requests concurrently, each over a "
+          "connection of its own.");
+ABSL_FLAG(int32_t, duration_seconds, 60, "How long to generate load for.");
+ABSL_FLAG(int32_t, report_interval_seconds, 5,
+          "The interval at which to print the stats of the last interval.");
+ABSL_FLAG(std::string, mix, "create_value=4,create_call=2,compute=1",
+          "Comma separated method=weight pairs, the relative frequencies of "
+          "the requests of each method.");
+ABSL_FLAG(std::vector<std::string>, tensor_bytes, {"1024"},
+          "Comma separated sizes in bytes of the tensors created, each chosen "
+          "with equal probability.");
+ABSL_FLAG(int32_t, max_live_values, 64,
+          "The number of values each client keeps alive. Beyond it, the "
+          "oldest value is disposed of.");
+ABSL_FLAG(int32_t, num_clients, 1,
+          "The number of clients of the executors the load generator gets.");
+ABSL_FLAG(int32_t, server_pid, 0,
+          "If positive, the process ID of the server on the same host, whose "
+          "CPU use and resident memory are reported.");
+ABSL_FLAG(int32_t, grpc_max_message_length_megabytes, 10000,
+          "Max gRPC message length in megabytes");
+
+namespace tff = ::tensorflow_federated;
+
+namespace {
+
+enum Method { kCreateValue, kCreateCall, kCompute, kDispose, kNumMethods };
+
+constexpr std::array<absl::string_view, kNumMethods> kMethodNames = {
+    "create_value", "create_call", "compute", "dispose"};
+
+// The stats of the requests of one method, shared by all clients.
+struct MethodStats {
+  tff::LatencyHistogram latencies;
+  tff::Counter bytes;
+  tff::Counter errors;
+};
+
+// A snapshot of `MethodStats`, to report the difference between two of them.
+struct MethodSnapshot {
+  std::array<int64_t, tff::LatencyHistogram::kNumBuckets> buckets = {};
+  int64_t count = 0;
+  int64_t bytes = 0;
+  int64_t errors = 0;
+};
+
+MethodSnapshot Snapshot(const MethodStats& stats) {
+  MethodSnapshot snapshot;
+  snapshot.buckets = stats.latencies.bucket_counts();
+  snapshot.count = stats.latencies.count();
+  snapshot.bytes = stats.bytes.value();
+  snapshot.errors = stats.errors.value();
+  return snapshot;
+}
+
+// Returns the upper bound of the bucket holding the `q`th quantile of the
+// latencies recorded between `start` and `end`.
+absl::Duration Quantile(const MethodSnapshot& start, const MethodSnapshot& end,
+                        double q) {
+  const int64_t count = end.count - start.count;
+  int64_t cumulative = 0;
+  for (int i = 0; i < tff::LatencyHistogram::kNumBuckets; ++i) {
+    cumulative += end.buckets[i] - start.buckets[i];
+    if (cumulative > 0 && cumulative >= q * count) {
+      return tff::LatencyHistogram::BucketUpperBound(i);
+    }
+  }
+  return absl::ZeroDuration();
+}
+
+// The CPU time and resident memory of a process, read from /proc.
+struct ProcessUsage {
+  absl::Duration cpu;
+  int64_t resident_bytes = 0;
+};
+
+std::optional<ProcessUsage> ReadProcessUsage(int pid) {
+  std::ifstream stat(absl::StrCat("/proc/", pid, "/stat"));
+  std::string line;
+  if (!std::getline(stat, line)) {
+    return std::nullopt;
+  }
+  // The command name in parentheses may contain spaces; the fields after it
+  // are space separated, with utime and stime as the 12th and 13th.
+  size_t command_end = line.rfind(')');
+  if (command_end == std::string::npos) {
+    return std::nullopt;
+  }
+  std::vector<absl::string_view> fields =
+      absl::StrSplit(absl::string_view(line).substr(command_end + 2), ' ');
+  int64_t utime_ticks = 0;
+  int64_t stime_ticks = 0;
+  if (fields.size() < 13 || !absl::SimpleAtoi(fields[11], &utime_ticks) ||
+      !absl::SimpleAtoi(fields[12], &stime_ticks)) {
+    return std::nullopt;
+  }
+  std::ifstream statm(absl::StrCat("/proc/", pid, "/statm"));
+  int64_t size_pages = 0;
+  int64_t resident_pages = 0;
+  if (!(statm >> size_pages >> resident_pages)) {
+    return std::nullopt;
+  }
+  ProcessUsage usage;
+  usage.cpu =
+      absl::Seconds(static_cast<double>(utime_ticks + stime_ticks) /
+                    sysconf(_SC_CLK_TCK));
+  usage.resident_bytes = resident_pages * sysconf(_SC_PAGESIZE);
+  return usage;
+}
+
+absl::StatusOr<std::array<int32_t, kNumMethods>> MixFromFlag() {
+  std::array<int32_t, kNumMethods> weights = {};
+  for (absl::string_view pair :
+       absl::StrSplit(absl::GetFlag(FLAGS_mix), ',', absl::SkipEmpty())) {
+    std::vector<absl::string_view> method_and_weight =
+        absl::StrSplit(pair, '=');
+    auto method =
+        std::find(kMethodNames.begin(), kMethodNames.begin() + kDispose,
+                  method_and_weight[0]);
+    int32_t weight = 0;
+    if (method_and_weight.size() != 2 ||
+        method == kMethodNames.begin() + kDispose ||
+        !absl::SimpleAtoi(method_and_weight[1], &weight) || weight < 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid entry of --mix: ", pair));
+    }
+    weights[method - kMethodNames.begin()] = weight;
+  }
+  if (weights[kCreateValue] == 0) {
+    return absl::InvalidArgumentError(
+        "--mix must create values, which the other methods use");
+  }
+  return weights;
+}
+
+// Returns a float tensor of `num_bytes` bytes.
+tff::v0::Value TensorValue(int64_t num_bytes) {
+  const int64_t num_elements = num_bytes / sizeof(float);
+  tensorflow::TensorProto tensor_pb;
+  tensor_pb.set_dtype(tensorflow::DT_FLOAT);
+  tensor_pb.mutable_tensor_shape()->add_dim()->set_size(num_elements);
+  tensor_pb.set_tensor_content(std::string(num_elements * sizeof(float), 0));
+  tff::v0::Value value_pb;
+  value_pb.mutable_tensor()->PackFrom(tensor_pb);
+  return value_pb;
+}
+
+// Returns a TensorFlow computation of `x -> x` on float tensors.
+tff::v0::Value IdentityComputation() {
+  tensorflow::GraphDef graph_pb;
+  tensorflow::NodeDef* x = graph_pb.add_node();
+  x->set_name("x");
+  x->set_op("Placeholder");
+  (*x->mutable_attr())["dtype"].set_type(tensorflow::DT_FLOAT);
+  tensorflow::NodeDef* out = graph_pb.add_node();
+  out->set_name("out");
+  out->set_op("Identity");
+  out->add_input("x");
+  (*out->mutable_attr())["T"].set_type(tensorflow::DT_FLOAT);
+  tff::v0::Value value_pb;
+  tff::v0::TensorFlow* tensorflow_pb =
+      value_pb.mutable_computation()->mutable_tensorflow();
+  tensorflow_pb->mutable_graph_def()->PackFrom(graph_pb);
+  tensorflow_pb->mutable_parameter()->mutable_tensor()->set_tensor_name("x:0");
+  tensorflow_pb->mutable_result()->mutable_tensor()->set_tensor_name("out:0");
+  return value_pb;
+}
+
+// A client issuing requests in a loop until `deadline`.
+class LoadClient {
+ public:
+  LoadClient(std::shared_ptr<grpc::Channel> channel,
+             std::array<MethodStats, kNumMethods>& stats, uint32_t seed)
+      : stub_(tff::v0::ExecutorGroup::NewStub(std::move(channel))),
+        stats_(stats),
+        rng_(seed) {}
+
+  void Run(absl::Time deadline, const std::array<int32_t, kNumMethods>& mix,
+           const std::vector<int64_t>& tensor_bytes, size_t max_live_values) {
+    tff::v0::GetExecutorRequest get_executor;
+    tff::v0::Cardinality* cardinality = get_executor.add_cardinalities();
+    cardinality->mutable_placement()->set_uri(std::string(tff::kClientsUri));
+    cardinality->set_cardinality(absl::GetFlag(FLAGS_num_clients));
+    tff::v0::GetExecutorResponse executor_pb;
+    grpc::ClientContext get_executor_context;
+    grpc::Status status = stub_->GetExecutor(&get_executor_context,
+                                             get_executor, &executor_pb);
+    if (!status.ok()) {
+      LOG(ERROR) << "Could not get an executor: " << status.error_message();
+      return;
+    }
+    executor_ = executor_pb.executor();
+    std::optional<tff::v0::ValueRef> fn = CreateValue(IdentityComputation());
+    if (!fn.has_value()) {
+      return;
+    }
+    std::vector<tff::v0::Value> tensors;
+    for (int64_t num_bytes : tensor_bytes) {
+      tensors.push_back(TensorValue(num_bytes));
+    }
+    std::discrete_distribution<int> methods(mix.begin(),
+                                            mix.begin() + kDispose);
+    while (absl::Now() < deadline) {
+      Method method = static_cast<Method>(methods(rng_));
+      if (method == kCreateValue || live_.empty()) {
+        std::uniform_int_distribution<size_t> tensor(0, tensors.size() - 1);
+        std::optional<tff::v0::ValueRef> value =
+            CreateValue(tensors[tensor(rng_)]);
+        if (value.has_value()) {
+          live_.push_back(*std::move(value));
+        }
+      } else if (method == kCreateCall) {
+        std::optional<tff::v0::ValueRef> value = CreateCall(*fn, RandomLive());
+        if (value.has_value()) {
+          live_.push_back(*std::move(value));
+        }
+      } else {
+        Compute(RandomLive());
+      }
+      if (live_.size() > max_live_values) {
+        Dispose({live_.front()});
+        live_.pop_front();
+      }
+    }
+    std::vector<tff::v0::ValueRef> remaining(live_.begin(), live_.end());
+    remaining.push_back(*fn);
+    Dispose(remaining);
+    tff::v0::DisposeExecutorRequest dispose_executor;
+    *dispose_executor.mutable_executor() = executor_;
+    tff::v0::DisposeExecutorResponse dispose_executor_response;
+    grpc::ClientContext dispose_executor_context;
+    stub_->DisposeExecutor(&dispose_executor_context, dispose_executor,
+                           &dispose_executor_response)
+        .ok();
+  }
+
+ private:
+  const tff::v0::ValueRef& RandomLive() {
+    std::uniform_int_distribution<size_t> index(0, live_.size() - 1);
+    return live_[index(rng_)];
+  }
+
+  // Records the outcome of a request of `method` which started at `start`.
+  void Record(Method method, absl::Time start, const grpc::Status& status,
+              int64_t bytes) {
+    MethodStats& stats = stats_[method];
+    stats.latencies.Record(absl::Now() - start);
+    if (status.ok()) {
+      stats.bytes.Increment(bytes);
+    } else {
+      stats.errors.Increment();
+      LOG_FIRST_N(WARNING, 10) << kMethodNames[method]
+                               << " failed: " << status.error_message();
+    }
+  }
+
+  std::optional<tff::v0::ValueRef> CreateValue(const tff::v0::Value& value) {
+    tff::v0::CreateValueRequest request;
+    *request.mutable_executor() = executor_;
+    *request.mutable_value() = value;
+    tff::v0::CreateValueResponse response;
+    grpc::ClientContext context;
+    absl::Time start = absl::Now();
+    grpc::Status status = stub_->CreateValue(&context, request, &response);
+    Record(kCreateValue, start, status, request.ByteSizeLong());
+    if (!status.ok()) {
+      return std::nullopt;
+    }
+    return response.value_ref();
+  }
+
+  std::optional<tff::v0::ValueRef> CreateCall(const tff::v0::ValueRef& fn,
+                                              const tff::v0::ValueRef& arg) {
+    tff::v0::CreateCallRequest request;
+    *request.mutable_executor() = executor_;
+    *request.mutable_function_ref() = fn;
+    *request.mutable_argument_ref() = arg;
+    tff::v0::CreateCallResponse response;
+    grpc::ClientContext context;
+    absl::Time start = absl::Now();
+    grpc::Status status = stub_->CreateCall(&context, request, &response);
+    Record(kCreateCall, start, status, 0);
+    if (!status.ok()) {
+      return std::nullopt;
+    }
+    return response.value_ref();
+  }
+
+  void Compute(const tff::v0::ValueRef& value) {
+    tff::v0::ComputeRequest request;
+    *request.mutable_executor() = executor_;
+    *request.mutable_value_ref() = value;
+    tff::v0::ComputeResponse response;
+    grpc::ClientContext context;
+    absl::Time start = absl::Now();
+    grpc::Status status = stub_->Compute(&context, request, &response);
+    Record(kCompute, start, status, response.ByteSizeLong());
+  }
+
+  void Dispose(const std::vector<tff::v0::ValueRef>& values) {
+    tff::v0::DisposeRequest request;
+    *request.mutable_executor() = executor_;
+    request.mutable_value_ref()->Add(values.begin(), values.end());
+    tff::v0::DisposeResponse response;
+    grpc::ClientContext context;
+    absl::Time start = absl::Now();
+    grpc::Status status = stub_->Dispose(&context, request, &response);
+    Record(kDispose, start, status, 0);
+  }
+
+  const std::unique_ptr<tff::v0::ExecutorGroup::Stub> stub_;
+  std::array<MethodStats, kNumMethods>& stats_;
+  std::mt19937 rng_;
+  tff::v0::ExecutorId executor_;
+  std::deque<tff::v0::ValueRef> live_;
+};
+
+// Prints the stats of the interval between `start` and `end`.
+void Report(absl::Duration elapsed, absl::Duration interval,
+            const std::array<MethodSnapshot, kNumMethods>& start,
+            const std::array<MethodSnapshot, kNumMethods>& end,
+            const std::optional<ProcessUsage>& start_usage,
+            const std::optional<ProcessUsage>& end_usage) {
+  const double seconds = absl::ToDoubleSeconds(interval);
+  std::string report =
+      absl::StrFormat("[%.0fs]", absl::ToDoubleSeconds(elapsed));
+  for (int method = 0; method < kNumMethods; ++method) {
+    const int64_t count = end[method].count - start[method].count;
+    if (count == 0) {
+      continue;
+    }
+    absl::StrAppendFormat(
+        &report, " %s: %.1f rps %.2f MB/s p50<=%.0fus p99<=%.0fus %d errors;",
+        kMethodNames[method], count / seconds,
+        (end[method].bytes - start[method].bytes) / seconds / 1e6,
+        absl::ToDoubleMicroseconds(Quantile(start[method], end[method], 0.5)),
+        absl::ToDoubleMicroseconds(Quantile(start[method], end[method], 0.99)),
+        end[method].errors - start[method].errors);
+  }
+  if (start_usage.has_value() && end_usage.has_value()) {
+    absl::StrAppendFormat(
+        &report, " server: %.0f%% cpu %.1f MB rss",
+        100 * absl::ToDoubleSeconds(end_usage->cpu - start_usage->cpu) /
+            seconds,
+        end_usage->resident_bytes / 1e6);
+  }
+  std::cout << report << std::endl;
+}
+
+absl::Status GenerateLoad() {
+  const std::array<int32_t, kNumMethods> mix = TFF_TRY(MixFromFlag());
+  std::vector<int64_t> tensor_bytes;
+  for (const std::string& bytes : absl::GetFlag(FLAGS_tensor_bytes)) {
+    int64_t num_bytes = 0;
+    if (!absl::SimpleAtoi(bytes, &num_bytes) || num_bytes < 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid tensor size: ", bytes));
+    }
+    tensor_bytes.push_back(num_bytes);
+  }
+  if (tensor_bytes.empty()) {
+    return absl::InvalidArgumentError("--tensor_bytes must not be empty");
+  }
+  const int max_message_bytes =
+      absl::GetFlag(FLAGS_grpc_max_message_length_megabytes) * 1024 * 1024;
+  grpc::ChannelArguments channel_options;
+  channel_options.SetMaxSendMessageSize(max_message_bytes);
+  channel_options.SetMaxReceiveMessageSize(max_message_bytes);
+  // Gives each client a connection of its own, as separate hosts would have.
+  channel_options.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+
+  std::array<MethodStats, kNumMethods> stats;
+  const absl::Time start = absl::Now();
+  const absl::Time deadline =
+      start + absl::Seconds(absl::GetFlag(FLAGS_duration_seconds));
+  std::vector<std::thread> clients;
+  for (int32_t i = 0; i < absl::GetFlag(FLAGS_concurrent_clients); ++i) {
+    clients.emplace_back([&, i] {
+      LoadClient client(
+          grpc::CreateCustomChannel(absl::GetFlag(FLAGS_target),
+                                    grpc::InsecureChannelCredentials(),
+                                    channel_options),
+          stats, /*seed=*/i);
+      client.Run(deadline, mix, tensor_bytes,
+                 absl::GetFlag(FLAGS_max_live_values));
+    });
+  }
+
+  const int32_t server_pid = absl::GetFlag(FLAGS_server_pid);
+  auto read_usage = [server_pid]() -> std::optional<ProcessUsage> {
+    if (server_pid <= 0) {
+      return std::nullopt;
+    }
+    return ReadProcessUsage(server_pid);
+  };
+  auto snapshot_all = [&stats] {
+    std::array<MethodSnapshot, kNumMethods> snapshots;
+    for (int method = 0; method < kNumMethods; ++method) {
+      snapshots[method] = Snapshot(stats[method]);
+    }
+    return snapshots;
+  };
+  const absl::Duration interval =
+      absl::Seconds(absl::GetFlag(FLAGS_report_interval_seconds));
+  std::array<MethodSnapshot, kNumMethods> interval_start = snapshot_all();
+  std::optional<ProcessUsage> interval_start_usage = read_usage();
+  absl::Time interval_start_time = start;
+  while (absl::Now() < deadline) {
+    absl::SleepFor(std::min(interval, deadline - absl::Now()));
+    absl::Time now = absl::Now();
+    std::array<MethodSnapshot, kNumMethods> interval_end = snapshot_all();
+    std::optional<ProcessUsage> interval_end_usage = read_usage();
+    Report(now - start, now - interval_start_time, interval_start,
+           interval_end, interval_start_usage, interval_end_usage);
+    interval_start = interval_end;
+    interval_start_usage = interval_end_usage;
+    interval_start_time = now;
+  }
+  for (std::thread& client : clients) {
+    client.join();
+  }
+  std::cout << "Total:" << std::endl;
+  Report(absl::Now() - start, absl::Now() - start,
+         std::array<MethodSnapshot, kNumMethods>(), snapshot_all(),
+         std::nullopt, read_usage());
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::ParseCommandLine(argc, argv);
+  absl::Status status = GenerateLoad();
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  return 0;
+}
@@ -19,18 +19,32 @@ limitations under the License
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/log/log.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "include/grpc/compression.h"
+#include "include/grpc/grpc.h"
+#include "include/grpcpp/create_channel.h"
+#include "include/grpcpp/resource_quota.h"
+#include "include/grpcpp/security/credentials.h"
 #include "include/grpcpp/security/server_credentials.h"
 #include "include/grpcpp/server.h"
 #include "include/grpcpp/server_builder.h"
 #include "tensorflow_federated/cc/core/impl/executor_stacks/local_stacks.h"
+#include "tensorflow_federated/cc/core/impl/executor_stacks/remote_stacks.h"
+#include "tensorflow_federated/cc/core/impl/executors/callback_executor_service.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/concurrency_limiter.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor_service.h"
+#include "tensorflow_federated/cc/core/impl/executors/session_provider.h"
 #include "tensorflow_federated/cc/core/impl/executors/tensorflow_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
 
 constexpr int MegabytesToBytes(int megabytes) {
   return megabytes * 1024 * 1024;
@@ -40,18 +54,119 @@ namespace tensorflow_federated {
 
 namespace tff = ::tensorflow_federated;
 
+namespace {
+
+// Returns channels to the workers at `addresses`, accepting messages as large
+// as the server does. If `dedicated_connections` is true, each channel has a
+// connection of its own, rather than sharing the connection of the other
+// channels to the same worker.
+std::vector<std::shared_ptr<grpc::ChannelInterface>> CreatePeerChannels(
+    const std::vector<std::string>& addresses,
+    int grpc_max_message_length_megabytes,
+    grpc_compression_algorithm grpc_compression,
+    bool dedicated_connections = false) {
+  grpc::ChannelArguments channel_options;
+  if (dedicated_connections) {
+    channel_options.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+  }
+  channel_options.SetMaxSendMessageSize(
+      MegabytesToBytes(grpc_max_message_length_megabytes));
+  channel_options.SetMaxReceiveMessageSize(
+      MegabytesToBytes(grpc_max_message_length_megabytes));
+  channel_options.SetCompressionAlgorithm(grpc_compression);
+  std::vector<std::shared_ptr<grpc::ChannelInterface>> channels;
+  channels.reserve(addresses.size());
+  for (const std::string& address : addresses) {
+    channels.push_back(grpc::CreateCustomChannel(
+        address, grpc::InsecureChannelCredentials(), channel_options));
+  }
+  return channels;
+}
+
+// Applies the runtime options of `options` which are set to `server_builder`.
+void ApplyServerOptions(const GrpcServerOptions& options,
+                        grpc::ServerBuilder& server_builder) {
+  using SyncServerOption = grpc::ServerBuilder::SyncServerOption;
+  if (options.num_completion_queues > 0) {
+    server_builder.SetSyncServerOption(SyncServerOption::NUM_CQS,
+                                       options.num_completion_queues);
+  }
+  if (options.min_polling_threads > 0) {
+    server_builder.SetSyncServerOption(SyncServerOption::MIN_POLLERS,
+                                       options.min_polling_threads);
+  }
+  if (options.max_polling_threads > 0) {
+    server_builder.SetSyncServerOption(SyncServerOption::MAX_POLLERS,
+                                       options.max_polling_threads);
+  }
+  if (options.resource_quota_bytes > 0 || options.max_threads > 0) {
+    grpc::ResourceQuota quota("tff_executor_service");
+    if (options.resource_quota_bytes > 0) {
+      quota.Resize(options.resource_quota_bytes);
+    }
+    if (options.max_threads > 0) {
+      quota.SetMaxThreads(options.max_threads);
+    }
+    server_builder.SetResourceQuota(quota);
+  }
+  if (options.keepalive_time_ms > 0) {
+    server_builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIME_MS,
+                                      options.keepalive_time_ms);
+  }
+  if (options.keepalive_timeout_ms > 0) {
+    server_builder.AddChannelArgument(GRPC_ARG_KEEPALIVE_TIMEOUT_MS,
+                                      options.keepalive_timeout_ms);
+  }
+}
+
+// Builds the executors of `cardinalities` in `service` before it serves.
+template <typename Service>
+absl::Status WarmUpService(Service& service,
+                           const std::vector<CardinalityMap>& cardinalities) {
+  for (const CardinalityMap& cardinality_map : cardinalities) {
+    absl::Status status = service.WarmUp(cardinality_map);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
 void RunServer(std::function<absl::StatusOr<std::shared_ptr<Executor>>(
                    const CardinalityMap&)>
                    executor_fn,
                int port, std::shared_ptr<grpc::ServerCredentials> credentials,
-               int grpc_max_message_length_megabytes) {
+               int grpc_max_message_length_megabytes,
+               grpc_compression_algorithm grpc_compression,
+               ExecutorServiceOptions service_options,
+               const GrpcServerOptions& server_options,
+               const std::vector<CardinalityMap>& warm_up_cardinalities) {
   std::string server_address = absl::StrCat("[::]:", port);
 
   grpc::ServerBuilder server_builder;
   server_builder.AddListeningPort(server_address, credentials);
+  ApplyServerOptions(server_options, server_builder);
 
-  std::unique_ptr<tff::ExecutorService> executor_service;
-  executor_service = std::make_unique<tff::ExecutorService>(executor_fn);
+  std::unique_ptr<grpc::Service> executor_service;
+  absl::Status warm_up_status;
+  if (server_options.use_callback_service) {
+    auto callback_service = std::make_unique<tff::CallbackExecutorService>(
+        executor_fn, server_options.callback_threads,
+        std::move(service_options));
+    warm_up_status = WarmUpService(*callback_service, warm_up_cardinalities);
+    executor_service = std::move(callback_service);
+  } else {
+    auto sync_service = std::make_unique<tff::ExecutorService>(
+        executor_fn, std::move(service_options));
+    warm_up_status = WarmUpService(*sync_service, warm_up_cardinalities);
+    executor_service = std::move(sync_service);
+  }
+  if (!warm_up_status.ok()) {
+    LOG(ERROR) << "TFF ExecutorService failed to warm up: " << warm_up_status;
+    return;
+  }
   server_builder.RegisterService(executor_service.get());
 
   // These server builder methods take their arguments in bytes.
@@ -61,6 +176,7 @@ void RunServer(std::function<absl::StatusOr<std::shared_ptr<Executor>>(
   server_builder.SetMaxReceiveMessageSize(grpc_message_length_bytes);
   server_builder.SetMaxSendMessageSize(grpc_message_length_bytes);
   server_builder.SetMaxMessageSize(grpc_message_length_bytes);
+  server_builder.SetDefaultCompressionAlgorithm(grpc_compression);
 
   std::unique_ptr<grpc::Server> server(server_builder.BuildAndStart());
   if (server == nullptr) {
@@ -74,19 +190,91 @@ void RunServer(std::function<absl::StatusOr<std::shared_ptr<Executor>>(
 
 void RunWorker(int port, std::shared_ptr<grpc::ServerCredentials> credentials,
                int grpc_max_message_length_megabytes,
-               int32_t max_concurrent_computation_calls) {
+               int32_t max_concurrent_computation_calls,
+               grpc_compression_algorithm grpc_compression,
+               int64_t value_cache_capacity_bytes,
+               const std::vector<std::string>& value_cache_peer_addresses,
+               const GrpcServerOptions& server_options,
+               const WorkerWarmUpOptions& warm_up,
+               const AdaptiveConcurrencyOptions& adaptive_concurrency,
+               const std::vector<std::string>& locality_keys,
+               const std::string& value_snapshot_directory) {
+  // The executor stacks of all cardinalities share one TensorFlow executor, so
+  // that its cached computations and sessions survive the number of clients
+  // changing across rounds, and only the federating layers are rebuilt.
+  std::shared_ptr<Executor> tf_executor = CreateTensorFlowExecutor(
+      max_concurrent_computation_calls, kDefaultComputationCacheCapacityBytes,
+      SessionPoolOptions(), /*max_call_batch_size=*/1, /*runtime=*/nullptr,
+      adaptive_concurrency);
+  absl::Status warm_up_status =
+      WarmUpTensorFlowExecutor(*tf_executor, warm_up.computations);
+  if (!warm_up_status.ok()) {
+    LOG(ERROR) << "TFF ExecutorService failed to warm up: " << warm_up_status;
+    return;
+  }
   auto create_tf_executor_fn =
-      [max_concurrent_computation_calls](
-          int32_t unused) -> std::shared_ptr<Executor> {
-    return CreateTensorFlowExecutor(max_concurrent_computation_calls);
+      [tf_executor](int32_t unused) -> std::shared_ptr<Executor> {
+    return tf_executor;
   };
   auto create_local_executor_fn =
       [create_tf_executor_fn](const CardinalityMap& cardinality_map)
       -> absl::StatusOr<std::shared_ptr<Executor>> {
     return CreateLocalExecutor(cardinality_map, create_tf_executor_fn);
   };
+  ExecutorServiceOptions service_options;
+  service_options.value_cache_capacity_bytes = value_cache_capacity_bytes;
+  service_options.locality_keys = locality_keys;
+  service_options.value_snapshot_directory = value_snapshot_directory;
+  if (value_cache_capacity_bytes > 0) {
+    service_options.value_cache_peers =
+        CreatePeerChannels(value_cache_peer_addresses,
+                           grpc_max_message_length_megabytes, grpc_compression);
+  }
   RunServer(create_local_executor_fn, port, credentials,
-            grpc_max_message_length_megabytes);
+            grpc_max_message_length_megabytes, grpc_compression,
+            std::move(service_options), server_options, warm_up.cardinalities);
+}
+
+void RunAggregatorWorker(
+    int port, std::shared_ptr<grpc::ServerCredentials> credentials,
+    int grpc_max_message_length_megabytes,
+    const std::vector<std::string>& peer_worker_addresses,
+    grpc_compression_algorithm grpc_compression,
+    const GrpcServerOptions& server_options, int32_t bulk_channels_per_peer,
+    bool assign_clients_by_locality,
+    const std::vector<std::string>& locality_keys) {
+  std::vector<std::shared_ptr<grpc::ChannelInterface>> peer_channels =
+      CreatePeerChannels(peer_worker_addresses,
+                         grpc_max_message_length_megabytes, grpc_compression);
+  std::vector<std::vector<std::shared_ptr<grpc::ChannelInterface>>>
+      bulk_channels;
+  if (bulk_channels_per_peer > 0) {
+    bulk_channels.resize(peer_channels.size());
+    for (int32_t i = 0; i < bulk_channels_per_peer; ++i) {
+      std::vector<std::shared_ptr<grpc::ChannelInterface>> channels =
+          CreatePeerChannels(peer_worker_addresses,
+                             grpc_max_message_length_megabytes,
+                             grpc_compression, /*dedicated_connections=*/true);
+      for (size_t peer = 0; peer < channels.size(); ++peer) {
+        bulk_channels[peer].push_back(std::move(channels[peer]));
+      }
+    }
+  }
+  auto create_remote_executor_fn =
+      [peer_channels = std::move(peer_channels),
+       bulk_channels = std::move(bulk_channels), assign_clients_by_locality](
+          const CardinalityMap& cardinality_map)
+      -> absl::StatusOr<std::shared_ptr<Executor>> {
+    return CreateRemoteExecutorStack(
+        peer_channels, cardinality_map, ThreadPoolPolicy::kSingleQueue,
+        /*max_fan_out=*/0, /*balance_clients_by_throughput=*/false,
+        bulk_channels, assign_clients_by_locality);
+  };
+  ExecutorServiceOptions service_options;
+  service_options.locality_keys = locality_keys;
+  RunServer(create_remote_executor_fn, port, credentials,
+            grpc_max_message_length_megabytes, grpc_compression,
+            std::move(service_options), server_options);
 }
 
 }  // namespace tensorflow_federated
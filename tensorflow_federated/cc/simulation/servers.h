@@ -19,29 +19,137 @@ limitations under the License
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/status/statusor.h"
+#include "include/grpc/compression.h"
 #include "include/grpcpp/grpcpp.h"
 #include "include/grpcpp/security/server_credentials.h"
 #include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/concurrency_limiter.h"
 #include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor_service.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
 
 namespace tensorflow_federated {
 
+// Options of the gRPC server runtime which serves the executor service.
+// Non-positive values keep the defaults of gRPC.
+struct GrpcServerOptions {
+  // The number of completion queues, and the minimum and maximum number of
+  // threads polling each of them for the synchronous service.
+  int num_completion_queues = 0;
+  int min_polling_threads = 0;
+  int max_polling_threads = 0;
+  // The memory and threads the server may use across all calls. Calls beyond
+  // the quota are rejected with RESOURCE_EXHAUSTED rather than queued.
+  int64_t resource_quota_bytes = 0;
+  int max_threads = 0;
+  // The interval of keepalive pings on idle connections, and how long to wait
+  // for their acknowledgement before closing the connection.
+  int keepalive_time_ms = 0;
+  int keepalive_timeout_ms = 0;
+  // Whether to serve the unary methods with the callback API, handing them to
+  // a pool of `callback_threads` threads rather than to the polling threads.
+  bool use_callback_service = false;
+  int32_t callback_threads = 16;
+};
+
+// What a worker prepares before it starts serving, so that the first round
+// of a computation is as fast as later rounds.
+struct WorkerWarmUpOptions {
+  // The cardinalities of the executors built before the worker starts serving.
+  // They are kept for the lifetime of the worker and reused by the clients
+  // requesting them.
+  std::vector<CardinalityMap> cardinalities;
+  // The TensorFlow computations imported, with a session built for each, into
+  // the TensorFlow executor of the worker.
+  std::vector<v0::Computation> computations;
+};
+
 // Runs TFF ExecutorService backed by executors returned by the given
 // executor_fn, listening on port. This function blocks, and will only
 // return on error or shutdown.
+//
+// Responses are compressed with `grpc_compression` for clients which accept
+// it. The server runtime is configured with `server_options`. The executors
+// of `warm_up_cardinalities` are built before the server starts (see
+// `ExecutorService::WarmUp`).
 void RunServer(std::function<absl::StatusOr<std::shared_ptr<Executor>>(
                    const CardinalityMap&)>
                    executor_fn,
                int port, std::shared_ptr<grpc::ServerCredentials> credentials,
-               int grpc_max_message_length_megabytes);
+               int grpc_max_message_length_megabytes,
+               grpc_compression_algorithm grpc_compression = GRPC_COMPRESS_NONE,
+               ExecutorServiceOptions service_options =
+                   ExecutorServiceOptions(),
+               const GrpcServerOptions& server_options = {},
+               const std::vector<CardinalityMap>& warm_up_cardinalities = {});
 
 // Runs a specialized version of RunServer above; the running executor service
 // will execute federated computations on the local machine.
+//
+// The executors built for different cardinalities share a single TensorFlow
+// executor, and with it the computations and sessions it caches.
+//
+// If `value_cache_capacity_bytes` is positive, the service caches the values
+// clients send along their content hash, and fetches the values it does not
+// have from the workers at `value_cache_peer_addresses` (see
+// `ExecutorServiceOptions::value_cache_peers`).
+//
+// The worker prepares the executors and computations of `warm_up` before it
+// starts serving.
+//
+// If `adaptive_concurrency` is enabled, the number of concurrent computation
+// calls adapts to their latency and memory use, up to
+// `max_concurrent_computation_calls` (see `CreateTensorFlowExecutor`).
+//
+// The worker advertises `locality_keys`, the prefixes of the URIs of the data
+// local to it, to the stacks which assign clients by locality (see
+// `ExecutorServiceOptions::locality_keys`).
+//
+// If `value_snapshot_directory` is set, values can be snapshotted to it and
+// restored from it by their hash, e.g. by a worker replacing this one (see
+// `ExecutorServiceOptions::value_snapshot_directory`).
 void RunWorker(int port, std::shared_ptr<grpc::ServerCredentials> credentials,
                int grpc_max_message_length_megabytes,
-               int32_t max_concurrent_computation_calls = -1);
+               int32_t max_concurrent_computation_calls = -1,
+               grpc_compression_algorithm grpc_compression = GRPC_COMPRESS_NONE,
+               int64_t value_cache_capacity_bytes = 0,
+               const std::vector<std::string>& value_cache_peer_addresses = {},
+               const GrpcServerOptions& server_options = {},
+               const WorkerWarmUpOptions& warm_up = {},
+               const AdaptiveConcurrencyOptions& adaptive_concurrency = {},
+               const std::vector<std::string>& locality_keys = {},
+               const std::string& value_snapshot_directory = "");
+
+// Runs a specialized version of RunServer above; the running executor service
+// composes the executor services of the workers at `peer_worker_addresses`,
+// forming an intermediate tier between the driver and these workers.
+//
+// The clients of a computation are split across the peer workers, whose
+// partial aggregates are pulled to and merged on this worker, so that only
+// the merged value is sent to the driver. A driver addressing such aggregator
+// workers, rather than all workers, thus receives one value per aggregator.
+//
+// If `bulk_channels_per_peer` is positive, this worker opens that many further
+// connections to each peer, across which the large values sent to and
+// received from the peer are striped.
+//
+// If `assign_clients_by_locality` is true, the clients are assigned to the
+// peers which have their data when possible (see `CreateRemoteExecutorStack`),
+// and the worker advertises `locality_keys` like `RunWorker` does, e.g. the
+// keys of its peers.
+void RunAggregatorWorker(
+    int port, std::shared_ptr<grpc::ServerCredentials> credentials,
+    int grpc_max_message_length_megabytes,
+    const std::vector<std::string>& peer_worker_addresses,
+    grpc_compression_algorithm grpc_compression = GRPC_COMPRESS_NONE,
+    const GrpcServerOptions& server_options = {},
+    int32_t bulk_channels_per_peer = 0,
+    bool assign_clients_by_locality = false,
+    const std::vector<std::string>& locality_keys = {});
 
 }  // namespace tensorflow_federated
 #endif  // THIRD_PARTY_TENSORFLOW_FEDERATED_CC_SIMULATION_SERVERS_H_
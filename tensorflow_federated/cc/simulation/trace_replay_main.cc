@@ -0,0 +1,112 @@
+/* Copyright 2024, The TensorFlow Federated Authors.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+     http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License
+==============================================================================*/
+
+// Replays an executor trace recorded with `CreateRecordingExecutor` on a local
+// executor stack or on a stack over remote workers, and prints the latencies
+// of the replayed calls, e.g. to compare the throughput of stack
+// configurations on the same workload.
+
+#include <stdint.h>
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "include/grpcpp/channel.h"
+#include "include/grpcpp/create_channel.h"
+#include "include/grpcpp/security/credentials.h"
+#include "include/grpcpp/support/channel_arguments.h"
+#include "tensorflow_federated/cc/core/impl/executor_stacks/local_stacks.h"
+#include "tensorflow_federated/cc/core/impl/executor_stacks/remote_stacks.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/recording_executor.h"
+#include "tensorflow_federated/cc/core/impl/executors/status_macros.h"
+#include "tensorflow_federated/cc/core/impl/executors/threading.h"
+#include "tensorflow_federated/proto/v0/executor_trace.pb.h"
+
+ABSL_FLAG(std::string, trace, "", "Path of the executor trace to replay.");
+ABSL_FLAG(double, speed, 0,
+          "The speed of the replay relative to the recording, e.g. 1 to issue "
+          "the calls at their recorded times. Non-positive values issue the "
+          "calls as fast as possible.");
+ABSL_FLAG(std::vector<std::string>, workers, {},
+          "Comma separated addresses of the workers to replay the trace on. "
+          "If unset, the trace is replayed on a local executor stack.");
+ABSL_FLAG(int32_t, num_clients, 1,
+          "The number of clients of the stack, as in the recording.");
+ABSL_FLAG(int32_t, max_fan_out, 0,
+          "If positive, the maximum number of workers composed by one "
+          "composing executor of the remote stack.");
+ABSL_FLAG(int32_t, grpc_max_message_length_megabytes, 10000,
+          "Max gRPC message length in megabytes");
+
+namespace tff = ::tensorflow_federated;
+
+namespace {
+
+absl::StatusOr<std::shared_ptr<tff::Executor>> CreateStack() {
+  tff::CardinalityMap cardinalities = {
+      {std::string(tff::kClientsUri), absl::GetFlag(FLAGS_num_clients)}};
+  const std::vector<std::string> workers = absl::GetFlag(FLAGS_workers);
+  if (workers.empty()) {
+    return tff::CreateLocalExecutor(cardinalities);
+  }
+  const int max_message_bytes =
+      absl::GetFlag(FLAGS_grpc_max_message_length_megabytes) * 1024 * 1024;
+  grpc::ChannelArguments channel_options;
+  channel_options.SetMaxSendMessageSize(max_message_bytes);
+  channel_options.SetMaxReceiveMessageSize(max_message_bytes);
+  std::vector<std::shared_ptr<grpc::ChannelInterface>> channels;
+  channels.reserve(workers.size());
+  for (const std::string& worker : workers) {
+    channels.push_back(grpc::CreateCustomChannel(
+        worker, grpc::InsecureChannelCredentials(), channel_options));
+  }
+  return tff::CreateRemoteExecutorStack(
+      channels, cardinalities, tff::ThreadPoolPolicy::kSingleQueue,
+      absl::GetFlag(FLAGS_max_fan_out));
+}
+
+absl::Status Replay() {
+  std::vector<tff::v0::ExecutorTraceEvent> events =
+      TFF_TRY(tff::ReadExecutorTrace(absl::GetFlag(FLAGS_trace)));
+  std::shared_ptr<tff::Executor> executor = TFF_TRY(CreateStack());
+  tff::ExecutorTraceReplayOptions options;
+  options.speed = absl::GetFlag(FLAGS_speed);
+  tff::ExecutorTraceReplayStats stats =
+      TFF_TRY(tff::ReplayExecutorTrace(*executor, std::move(events), options));
+  std::cout << stats.ToString();
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  absl::ParseCommandLine(argc, argv);
+  absl::Status status = Replay();
+  if (!status.ok()) {
+    LOG(ERROR) << status;
+    return 1;
+  }
+  return 0;
+}
@@ -14,12 +14,28 @@ limitations under the License
 ==============================================================================*/
 
 #include <stdint.h>
+
+#include <fstream>
+#include <ios>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "include/grpc/compression.h"
 #include "include/grpcpp/security/server_credentials.h"
+#include "tensorflow_federated/cc/core/impl/executors/cardinalities.h"
+#include "tensorflow_federated/cc/core/impl/executors/concurrency_limiter.h"
+#include "tensorflow_federated/cc/core/impl/executors/grpc_compression.h"
 #include "tensorflow_federated/cc/simulation/servers.h"
+#include "tensorflow_federated/proto/v0/computation.pb.h"
 
 ABSL_FLAG(int32_t, port, 10000, "Port to run the executor service on");
 ABSL_FLAG(int32_t, grpc_max_message_length_megabytes, 10000,
@@ -32,15 +48,184 @@ ABSL_FLAG(int32_t, max_concurrent_computation_calls, -1,
           "helpful for users running into OOMs when using GPUs. Non-positive"
           " values result in no limiting.");
 
+ABSL_FLAG(bool, adaptive_concurrency, false,
+          "Whether the number of parallel computation calls adapts to their "
+          "latency and memory use, up to --max_concurrent_computation_calls.");
+ABSL_FLAG(int32_t, adaptive_concurrency_min_calls, 1,
+          "The lowest number of parallel computation calls with "
+          "--adaptive_concurrency.");
+ABSL_FLAG(int32_t, adaptive_concurrency_memory_limit_megabytes, 0,
+          "If positive, the resident memory of the worker above which "
+          "--adaptive_concurrency reduces the number of parallel calls.");
+
+ABSL_FLAG(std::string, grpc_compression, "none",
+          "The compression of the responses sent to clients which accept it,"
+          " one of 'none', 'deflate' or 'gzip'.");
+
+ABSL_FLAG(std::vector<std::string>, peer_workers, {},
+          "Comma separated addresses of peer workers. If set, this worker "
+          "distributes the clients of computations across its peers and "
+          "merges their partial aggregates, instead of running the "
+          "computations itself.");
+
+ABSL_FLAG(int32_t, bulk_channels_per_peer, 0,
+          "The number of further connections to each of --peer_workers, across "
+          "which large values are striped, so that they do not delay the "
+          "control requests to the peer.");
+
+ABSL_FLAG(int32_t, value_cache_megabytes, 0,
+          "If positive, the worker caches up to this many megabytes of the "
+          "values which clients send along their content hash, so that "
+          "clients can later send the hash alone.");
+
+ABSL_FLAG(std::vector<std::string>, value_cache_peers, {},
+          "Comma separated addresses of peer workers with a value cache, from "
+          "which this worker fetches the values it has not cached before "
+          "asking clients for them, e.g. the parent of this worker in a tree "
+          "of workers. The peers of the workers must not form cycles. "
+          "Requires --value_cache_megabytes.");
+
+ABSL_FLAG(std::string, value_snapshot_directory, "",
+          "If set, a directory, e.g. on storage shared by the workers, in "
+          "which clients can snapshot values. Values which clients send the "
+          "content hash of are restored from it, e.g. by a worker replacing "
+          "a failed one, before clients are asked to send them again.");
+
+ABSL_FLAG(std::vector<std::string>, locality_keys, {},
+          "Comma separated prefixes of the URIs of the data which is local to "
+          "this worker, e.g. the shards it has cached. Stacks which assign "
+          "clients by locality place the clients whose data starts with one "
+          "of them on this worker.");
+
+ABSL_FLAG(bool, assign_clients_by_locality, false,
+          "With --peer_workers, whether to assign the clients to the peers "
+          "whose --locality_keys match their data when possible.");
+
+ABSL_FLAG(int32_t, grpc_completion_queues, 0,
+          "If positive, the number of completion queues of the server.");
+ABSL_FLAG(int32_t, grpc_min_polling_threads, 0,
+          "If positive, the minimum number of threads polling each completion "
+          "queue.");
+ABSL_FLAG(int32_t, grpc_max_polling_threads, 0,
+          "If positive, the maximum number of threads polling each completion "
+          "queue.");
+ABSL_FLAG(int32_t, grpc_resource_quota_megabytes, 0,
+          "If positive, the memory the server may use across all calls, "
+          "beyond which calls are rejected with RESOURCE_EXHAUSTED.");
+ABSL_FLAG(int32_t, grpc_max_threads, 0,
+          "If positive, the maximum number of threads of the server.");
+ABSL_FLAG(int32_t, grpc_keepalive_time_ms, 0,
+          "If positive, the interval of keepalive pings on idle connections.");
+ABSL_FLAG(int32_t, grpc_keepalive_timeout_ms, 0,
+          "If positive, how long to wait for the acknowledgement of a "
+          "keepalive ping before closing the connection.");
+ABSL_FLAG(bool, grpc_callback_service, false,
+          "Whether to serve the unary methods with the gRPC callback API, on "
+          "a pool of --grpc_callback_threads threads.");
+ABSL_FLAG(int32_t, grpc_callback_threads, 16,
+          "The number of threads serving the unary methods with "
+          "--grpc_callback_service.");
+
+ABSL_FLAG(std::vector<std::string>, warm_up_clients, {},
+          "Comma separated numbers of clients, for each of which the worker "
+          "builds an executor before it starts serving, so that the first "
+          "round does not pay for building it.");
+
+ABSL_FLAG(std::vector<std::string>, warm_up_computations, {},
+          "Comma separated paths of files holding serialized `Computation` "
+          "protos, whose TensorFlow computations the worker imports, and "
+          "builds a session for, before it starts serving.");
+
 // TODO: b/234160632 - Add option for secure server connections here.
 
 namespace tff = ::tensorflow_federated;
 
+namespace {
+
+// Returns the warm-up options of the `--warm_up_*` flags.
+absl::StatusOr<tff::WorkerWarmUpOptions> WarmUpOptionsFromFlags() {
+  tff::WorkerWarmUpOptions warm_up;
+  for (const std::string& clients : absl::GetFlag(FLAGS_warm_up_clients)) {
+    int num_clients = 0;
+    if (!absl::SimpleAtoi(clients, &num_clients) || num_clients < 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Invalid number of clients to warm up: ", clients));
+    }
+    warm_up.cardinalities.push_back(
+        {{std::string(tff::kClientsUri), num_clients}});
+  }
+  for (const std::string& path : absl::GetFlag(FLAGS_warm_up_computations)) {
+    std::ifstream file(path, std::ios::binary);
+    tff::v0::Computation computation_pb;
+    if (!file || !computation_pb.ParseFromIstream(&file)) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Could not read a computation from ", path));
+    }
+    warm_up.computations.push_back(std::move(computation_pb));
+  }
+  return warm_up;
+}
+
+}  // namespace
+
 int main(int argc, char* argv[]) {
   absl::ParseCommandLine(argc, argv);
+  absl::StatusOr<grpc_compression_algorithm> grpc_compression =
+      tff::CompressionAlgorithmFromName(absl::GetFlag(FLAGS_grpc_compression));
+  if (!grpc_compression.ok()) {
+    LOG(ERROR) << grpc_compression.status();
+    return 1;
+  }
+  absl::StatusOr<tff::WorkerWarmUpOptions> warm_up = WarmUpOptionsFromFlags();
+  if (!warm_up.ok()) {
+    LOG(ERROR) << warm_up.status();
+    return 1;
+  }
   std::shared_ptr<grpc::ServerCredentials> credentials =
       grpc::InsecureServerCredentials();
-  tff::RunWorker(absl::GetFlag(FLAGS_port), credentials,
-                 absl::GetFlag(FLAGS_grpc_max_message_length_megabytes),
-                 absl::GetFlag(FLAGS_max_concurrent_computation_calls));
+  tff::GrpcServerOptions server_options;
+  server_options.num_completion_queues =
+      absl::GetFlag(FLAGS_grpc_completion_queues);
+  server_options.min_polling_threads =
+      absl::GetFlag(FLAGS_grpc_min_polling_threads);
+  server_options.max_polling_threads =
+      absl::GetFlag(FLAGS_grpc_max_polling_threads);
+  server_options.resource_quota_bytes =
+      int64_t{absl::GetFlag(FLAGS_grpc_resource_quota_megabytes)} * 1024 *
+      1024;
+  server_options.max_threads = absl::GetFlag(FLAGS_grpc_max_threads);
+  server_options.keepalive_time_ms =
+      absl::GetFlag(FLAGS_grpc_keepalive_time_ms);
+  server_options.keepalive_timeout_ms =
+      absl::GetFlag(FLAGS_grpc_keepalive_timeout_ms);
+  server_options.use_callback_service =
+      absl::GetFlag(FLAGS_grpc_callback_service);
+  server_options.callback_threads = absl::GetFlag(FLAGS_grpc_callback_threads);
+  const std::vector<std::string> peer_workers =
+      absl::GetFlag(FLAGS_peer_workers);
+  if (!peer_workers.empty()) {
+    tff::RunAggregatorWorker(
+        absl::GetFlag(FLAGS_port), credentials,
+        absl::GetFlag(FLAGS_grpc_max_message_length_megabytes), peer_workers,
+        *grpc_compression, server_options,
+        absl::GetFlag(FLAGS_bulk_channels_per_peer),
+        absl::GetFlag(FLAGS_assign_clients_by_locality),
+        absl::GetFlag(FLAGS_locality_keys));
+    return 0;
+  }
+  tff::AdaptiveConcurrencyOptions adaptive_concurrency;
+  adaptive_concurrency.enabled = absl::GetFlag(FLAGS_adaptive_concurrency);
+  adaptive_concurrency.min_limit =
+      absl::GetFlag(FLAGS_adaptive_concurrency_min_calls);
+  const int64_t memory_limit_megabytes =
+      absl::GetFlag(FLAGS_adaptive_concurrency_memory_limit_megabytes);
+  adaptive_concurrency.memory_limit_bytes = memory_limit_megabytes * 1024 * 1024;
+  tff::RunWorker(
+      absl::GetFlag(FLAGS_port), credentials,
+      absl::GetFlag(FLAGS_grpc_max_message_length_megabytes),
+      absl::GetFlag(FLAGS_max_concurrent_computation_calls), *grpc_compression,
+      int64_t{absl::GetFlag(FLAGS_value_cache_megabytes)} * 1024 * 1024,
+      absl::GetFlag(FLAGS_value_cache_peers), server_options, *warm_up,
+      adaptive_concurrency, absl::GetFlag(FLAGS_locality_keys),
+      absl::GetFlag(FLAGS_value_snapshot_directory));
 }
@@ -42,6 +42,18 @@ def from_proto(array_pb: array_pb2.Array) -> Array:
   dtype = dtype_utils.from_proto(array_pb.dtype)
   shape = array_shape.from_proto(array_pb.shape)
 
+  if array_pb.WhichOneof('kind') == 'content':
+    if dtype is np.str_:
+      raise ValueError(
+          f'Expected an array with `content` to not have dtype {dtype}.'
+      )
+    value = np.frombuffer(array_pb.content, dtype)
+    if not array_shape.is_shape_scalar(shape):
+      return value.reshape(shape).copy()
+    else:
+      (value,) = value
+      return value
+
   if dtype is np.bool_:
     value = array_pb.bool_list.value
   elif dtype is np.int8:
@@ -172,6 +172,26 @@ class ArrayTest(parameterized.TestCase):
           ),
           np.array([[1, 2, 3], [4, 5, 6]]),
       ),
+      (
+          'content_scalar',
+          array_pb2.Array(
+              dtype=data_type_pb2.DataType.DT_FLOAT,
+              shape=array_pb2.ArrayShape(dim=[]),
+              content=np.float32(1.0).tobytes(),
+          ),
+          np.float32(1.0),
+      ),
+      (
+          'content_array',
+          array_pb2.Array(
+              dtype=data_type_pb2.DataType.DT_INT32,
+              shape=array_pb2.ArrayShape(dim=[2, 3]),
+              content=np.array(
+                  [[1, 2, 3], [4, 5, 6]], dtype=np.int32
+              ).tobytes(),
+          ),
+          np.array([[1, 2, 3], [4, 5, 6]], dtype=np.int32),
+      ),
   )
   def test_from_proto_returns_value(self, proto, expected_value):
     actual_value = array.from_proto(proto)
@@ -198,6 +218,22 @@ class ArrayTest(parameterized.TestCase):
               complex128_list=array_pb2.Array.DoubleList(value=[1.0]),
           ),
       ),
+      (
+          'content_string',
+          array_pb2.Array(
+              dtype=data_type_pb2.DataType.DT_STRING,
+              shape=array_pb2.ArrayShape(dim=[]),
+              content=b'a',
+          ),
+      ),
+      (
+          'content_wrong_size',
+          array_pb2.Array(
+              dtype=data_type_pb2.DataType.DT_INT32,
+              shape=array_pb2.ArrayShape(dim=[2]),
+              content=b'abc',
+          ),
+      ),
   )
   def test_from_proto_raises_value_error_with_wrong_value(self, proto):
     with self.assertRaises(ValueError):
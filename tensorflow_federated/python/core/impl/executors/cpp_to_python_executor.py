@@ -13,7 +13,6 @@
 # limitations under the License.
 """Implementation of Python executor interface backed by a C++ executor."""
 
-import asyncio
 from collections.abc import Sequence
 import concurrent
 from typing import NoReturn, Optional
@@ -25,6 +24,7 @@ from tensorflow_federated.python.core.impl.executors import executor_bindings
 from tensorflow_federated.python.core.impl.executors import executor_value_base
 from tensorflow_federated.python.core.impl.executors import executors_errors
 from tensorflow_federated.python.core.impl.executors import value_serialization
+from tensorflow_federated.python.core.impl.types import array_shape
 from tensorflow_federated.python.core.impl.types import computation_types
 
 
@@ -68,17 +68,27 @@ class CppToPythonExecutorValue(executor_value_base.ExecutorValue):
   @tracing.trace
   async def compute(self) -> object:
     """Pulls protocol buffer out of C++ into Python, and deserializes."""
-    running_loop = asyncio.get_running_loop()
-
-    def _materialize():
+    # The C++ call runs on a thread of the executor runtime, so awaiting it
+    # doesn't hold a thread of `futures_executor`.
+    if isinstance(self._type_signature, computation_types.TensorType):
+      # Tensors are converted to NumPy arrays in C++, sharing the buffer of the
+      # C++ tensor rather than going through a serialized `executor_pb2.Value`.
       try:
-        return self._cpp_executor.materialize(self._owned_value_id.ref)
+        value = await executor_bindings.materialize_tensor_async(
+            self._cpp_executor, self._owned_value_id.ref
+        )
       except Exception as e:  # pylint: disable=broad-except
         _handle_error(e)
-
-    result_pb = await running_loop.run_in_executor(
-        self._futures_executor, _materialize
-    )
+      if array_shape.is_shape_scalar(self._type_signature.shape):
+        # Unwrap the scalar array as just a primitive numeric.
+        value = value.dtype.type(value)
+      return value
+    try:
+      result_pb = await executor_bindings.materialize_async(
+          self._cpp_executor, self._owned_value_id.ref
+      )
+    except Exception as e:  # pylint: disable=broad-except
+      _handle_error(e)
     deserialized_value, _ = value_serialization.deserialize_value(
         result_pb, self._type_signature
     )
@@ -136,10 +136,9 @@ class CcToPythonExecutorTest(
   async def test_compute(self):
     owned_id = unittest.mock.create_autospec(executor_bindings.OwnedValueId)
     owned_id.ref = 1
-    serialized_two, _ = value_serialization.serialize_value(
-        2, computation_types.to_type(np.int32)
+    self._mock_executor.materialize_tensor_async.side_effect = (
+        lambda value_id, done: done(lambda: np.array(2, np.int32))
     )
-    self._mock_executor.materialize.return_value = serialized_two
     type_signature = computation_types.to_type(np.int32)
     executor_value = cpp_to_python_executor.CppToPythonExecutorValue(
         owned_id,
@@ -150,8 +149,55 @@ class CcToPythonExecutorTest(
 
     computed_value = await executor_value.compute()
 
-    self._mock_executor.materialize.assert_called_with(1)
+    self._mock_executor.materialize_tensor_async.assert_called_with(
+        1, unittest.mock.ANY
+    )
     self.assertEqual(computed_value, 2)
+    self.assertIsInstance(computed_value, np.int32)
+
+  async def test_compute_struct(self):
+    owned_id = unittest.mock.create_autospec(executor_bindings.OwnedValueId)
+    owned_id.ref = 1
+    type_signature = computation_types.to_type([np.int32, np.float32])
+    serialized_struct, _ = value_serialization.serialize_value(
+        structure.Struct.unnamed(1, 2.0), type_signature
+    )
+    self._mock_executor.materialize_async.side_effect = (
+        lambda value_id, done: done(lambda: serialized_struct)
+    )
+    executor_value = cpp_to_python_executor.CppToPythonExecutorValue(
+        owned_id,
+        type_signature,
+        self._mock_executor,
+        concurrent.futures.ThreadPoolExecutor(),
+    )
+
+    computed_value = await executor_value.compute()
+
+    self._mock_executor.materialize_async.assert_called_with(
+        1, unittest.mock.ANY
+    )
+    self.assertEqual(computed_value, structure.Struct.unnamed(1, 2.0))
+
+  async def test_compute_raises_error(self):
+    owned_id = unittest.mock.create_autospec(executor_bindings.OwnedValueId)
+    owned_id.ref = 1
+
+    def _raise():
+      raise ValueError('materialize failed')
+
+    self._mock_executor.materialize_tensor_async.side_effect = (
+        lambda value_id, done: done(_raise)
+    )
+    executor_value = cpp_to_python_executor.CppToPythonExecutorValue(
+        owned_id,
+        computation_types.to_type(np.int32),
+        self._mock_executor,
+        concurrent.futures.ThreadPoolExecutor(),
+    )
+
+    with self.assertRaisesRegex(ValueError, 'materialize failed'):
+      await executor_value.compute()
 
 
 if __name__ == '__main__':
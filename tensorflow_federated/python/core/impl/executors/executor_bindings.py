@@ -13,7 +13,9 @@
 # limitations under the License.
 """Python interface to C++ Executor implementations."""
 
-from collections.abc import Mapping
+import asyncio
+from collections.abc import Callable, Mapping
+from typing import Optional
 
 # Required to load TF Python extension.
 import tensorflow as tf  # pylint: disable=unused-import
@@ -26,10 +28,72 @@ from tensorflow_federated.python.core.impl.types import placements
 serialize_tensor_value = executor_bindings.serialize_tensor_value
 deserialize_tensor_value = executor_bindings.deserialize_tensor_value
 
+# Metrics methods.
+set_metrics_enabled = executor_bindings.set_metrics_enabled
+export_metrics = executor_bindings.export_metrics
+
 # Import classes.
 OwnedValueId = executor_bindings.OwnedValueId
 Executor = executor_bindings.Executor
 
+
+
+async def _await_async_call(start_fn: Callable[..., None], *args) -> object:
+  """Awaits a `*_async` method of `Executor` called as `start_fn(*args, done)`.
+
+  The C++ method runs on a thread of the executor runtime and calls `done` with
+  a function returning its result, which is then resolved on the running event
+  loop. No Python thread is held while the call is in flight.
+
+  Args:
+    start_fn: A bound `*_async` method of an `Executor`.
+    *args: The arguments of the method, other than `done`.
+
+  Returns:
+    The result of the method.
+  """
+  loop = asyncio.get_running_loop()
+  future = loop.create_future()
+
+  def _resolve(get_result):
+    if future.cancelled():
+      return
+    try:
+      future.set_result(get_result())
+    except Exception as e:  # pylint: disable=broad-except
+      future.set_exception(e)
+
+  def _done(get_result):
+    loop.call_soon_threadsafe(_resolve, get_result)
+
+  start_fn(*args, _done)
+  return await future
+
+
+async def create_value_async(executor: Executor, value_pb) -> OwnedValueId:
+  """Awaitable variant of `executor.create_value(value_pb)`."""
+  return await _await_async_call(executor.create_value_async, value_pb)
+
+
+async def create_call_async(
+    executor: Executor, function: int, argument: Optional[int] = None
+) -> OwnedValueId:
+  """Awaitable variant of `executor.create_call(function, argument)`."""
+  return await _await_async_call(
+      executor.create_call_async, function, argument
+  )
+
+
+async def materialize_async(executor: Executor, value_id: int):
+  """Awaitable variant of `executor.materialize(value_id)`."""
+  return await _await_async_call(executor.materialize_async, value_id)
+
+
+async def materialize_tensor_async(executor: Executor, value_id: int):
+  """Awaitable variant of `executor.materialize_tensor(value_id)`."""
+  return await _await_async_call(executor.materialize_tensor_async, value_id)
+
+
 # Import executor constructors.
 create_reference_resolving_executor = (
     executor_bindings.create_reference_resolving_executor
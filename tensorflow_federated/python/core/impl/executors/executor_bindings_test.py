@@ -73,6 +73,24 @@ class SerializeTensorTest(parameterized.TestCase):
     self.assertEqual(deserialized_value, input_value)
 
 
+class MetricsBindingsTest(absltest.TestCase):
+
+  def test_export_metrics_counts_serialized_bytes(self):
+    executor_bindings.set_metrics_enabled(True)
+    try:
+      executor_bindings.serialize_tensor_value(
+          tf.convert_to_tensor([1, 2, 3], np.int32)
+      )
+    finally:
+      executor_bindings.set_metrics_enabled(False)
+    metrics = executor_bindings.export_metrics()
+    self.assertIn('# TYPE tff_counter_total counter\n', metrics)
+    self.assertIn(
+        'tff_counter_total{name="TensorSerialization::BytesSerialized"}',
+        metrics,
+    )
+
+
 class ReferenceResolvingExecutorBindingsTest(absltest.TestCase):
 
   def test_construction(self):
@@ -141,6 +159,26 @@ class RemoteExecutorBindingsTest(absltest.TestCase):
     except Exception:  # pylint: disable=broad-except
       self.fail('Raised `Exception` unexpectedly.')
 
+  def test_construction_with_compressed_insecure_channel(self):
+    channel = executor_bindings.create_insecure_grpc_channel(
+        'localhost:{}'.format(portpicker.pick_unused_port()),
+        compression='gzip',
+    )
+    try:
+      executor_bindings.create_remote_executor(
+          channel,
+          cardinalities={placements.CLIENTS: 10},
+      )
+    except Exception:  # pylint: disable=broad-except
+      self.fail('Raised `Exception` unexpectedly.')
+
+  def test_create_insecure_channel_raises_with_unknown_compression(self):
+    with self.assertRaises(Exception):
+      executor_bindings.create_insecure_grpc_channel(
+          'localhost:{}'.format(portpicker.pick_unused_port()),
+          compression='unknown',
+      )
+
 
 if __name__ == '__main__':
   absltest.main()